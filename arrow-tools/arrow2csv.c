@@ -13,11 +13,19 @@
 #include <ctype.h>
 #include <getopt.h>
 #include <netinet/in.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <unistd.h>
 #include "arrow_ipc.h"
 #include "float2.h"
 
+#ifndef Min
+#define Min(x,y)			((x) < (y) ? (x) : (y))
+#endif
+#ifndef Max
+#define Max(x,y)			((x) > (y) ? (x) : (y))
+#endif
+
 /* columns to dump */
 #define ARROW_PRINT_DATUM_ARGS	\
 	struct arrowColumn *column, \
@@ -49,7 +57,7 @@ static const char  *output_filename = NULL;
 static FILE		   *output_filp = NULL;
 static bool			print_header = false;
 static char			csv_delimiter = ',';
-static char			current_context = 'n';
+static __thread char current_context = 'n';
 static int64_t		num_skip_rows = -1;			/* --offset */
 static int64_t		num_dump_rows = -1;			/* --limit */
 static const char  *create_table_name = NULL;	/* --create-table */
@@ -66,6 +74,8 @@ usage(void)
 		  "  --header       dump column names as csv header\n"
 		  "  --offset NUM   skip first NUM rows\n"
 		  "  --limit NUM    dump only NUM rows\n"
+		  "  -j|--parallel=N number of worker threads to convert record batches\n"
+		  "                 (default: number of CPUs, up to 32)\n"
 		  "\n"
 		  "  --create-table=TABLE_NAME  dump with CREATE TABLE statement\n"
 		  "  --tablespace=TABLESPACE    specify tablespace of the table, if any\n"
@@ -143,12 +153,289 @@ quote_ident(const char *ident)
 	return ident;
 }
 
+/*
+ * printBuffer - per-thread output buffer
+ *
+ * Record batches are converted into the printBuffer of the worker thread,
+ * then written out to the output file in order by the main thread.
+ */
+typedef struct
+{
+	char	   *data;
+	size_t		usage;
+	size_t		length;
+} printBuffer;
+
+static __thread printBuffer *print_buf = NULL;
+
+static void
+__enlargePrintBuffer(size_t required)
+{
+	size_t		length = Max(print_buf->length, 65536);
+
+	while (length < print_buf->usage + required)
+		length *= 2;
+	if (length != print_buf->length)
+	{
+		print_buf->data = repalloc(print_buf->data, length);
+		print_buf->length = length;
+	}
+}
+
+static inline char *
+printBufferReserve(size_t sz)
+{
+	if (print_buf->usage + sz > print_buf->length)
+		__enlargePrintBuffer(sz);
+	return print_buf->data + print_buf->usage;
+}
+
+static inline void
+printBufferWrite(const void *addr, size_t sz)
+{
+	char   *pos = printBufferReserve(sz);
+
+	memcpy(pos, addr, sz);
+	print_buf->usage += sz;
+}
+
+static inline void
+printBufferPutc(int c)
+{
+	char   *pos = printBufferReserve(1);
+
+	*pos = c;
+	print_buf->usage++;
+}
+
+static inline void
+printBufferPuts(const char *str)
+{
+	printBufferWrite(str, strlen(str));
+}
+
+static void
+printBufferPrintf(const char *fmt, ...)
+{
+	for (;;)
+	{
+		size_t		avail = print_buf->length - print_buf->usage;
+		va_list		ap;
+		int			nbytes;
+
+		va_start(ap, fmt);
+		nbytes = vsnprintf(print_buf->data + print_buf->usage, avail, fmt, ap);
+		va_end(ap);
+		if (nbytes < 0)
+			Elog("failed on vsnprintf: %m");
+		if (nbytes < avail)
+		{
+			print_buf->usage += nbytes;
+			break;
+		}
+		__enlargePrintBuffer(nbytes + 1);
+	}
+}
+
+/*
+ * fast formatters for integer and date/time values
+ */
+static inline char *
+__put_uint64(char *pos, uint64_t value)
+{
+	char		temp[24];
+	char	   *tail = temp + sizeof(temp);
+	size_t		len;
+
+	do {
+		*--tail = '0' + (value % 10);
+		value /= 10;
+	} while (value != 0);
+	len = temp + sizeof(temp) - tail;
+	memcpy(pos, tail, len);
+	return pos + len;
+}
+
+static inline void
+printBufferInt64(int64_t value)
+{
+	char   *pos = printBufferReserve(24);
+	char   *tail = pos;
+
+	if (value < 0)
+	{
+		*tail++ = '-';
+		tail = __put_uint64(tail, -(uint64_t)value);
+	}
+	else
+		tail = __put_uint64(tail, value);
+	print_buf->usage += (tail - pos);
+}
+
+static inline void
+printBufferUInt64(uint64_t value)
+{
+	char   *pos = printBufferReserve(24);
+
+	print_buf->usage += (__put_uint64(pos, value) - pos);
+}
+
+/* put zero-padded digits; value must be less than 10^width */
+static inline char *
+__put_digits(char *pos, uint32_t value, int width)
+{
+	int		i;
+
+	for (i=width-1; i >= 0; i--)
+	{
+		pos[i] = '0' + (value % 10);
+		value /= 10;
+	}
+	return pos + width;
+}
+
+static inline char *
+__put_quote(char *pos, const char *quote)
+{
+	while (*quote)
+		*pos++ = *quote++;
+	return pos;
+}
+
+/*
+ * __gmtime_fast - gmtime_r() with no locks and no timezone handling
+ *
+ * It uses the civil-from-days algorithm, and caches the last date because
+ * timestamps of the adjacent rows are usually in the same day.
+ */
+static __thread int64_t	__gmtime_last_days = INT64_MIN;
+static __thread struct tm __gmtime_last_tm;
+
+static inline void
+__gmtime_fast(int64_t t, struct tm *tm)
+{
+	int64_t		days = t / 86400;
+	int64_t		secs = t % 86400;
+
+	if (secs < 0)
+	{
+		days--;
+		secs += 86400;
+	}
+	if (days != __gmtime_last_days)
+	{
+		int64_t		z = days + 719468;
+		int64_t		era = (z >= 0 ? z : z - 146096) / 146097;
+		int64_t		doe = z - era * 146097;
+		int64_t		yoe = (doe - doe/1460 + doe/36524 - doe/146096) / 365;
+		int64_t		doy = doe - (365*yoe + yoe/4 - yoe/100);
+		int64_t		mp = (5*doy + 2) / 153;
+		int64_t		mday = doy - (153*mp + 2) / 5 + 1;
+		int64_t		mon = (mp < 10 ? mp + 3 : mp - 9);
+		int64_t		year = yoe + era * 400 + (mon <= 2 ? 1 : 0);
+
+		memset(&__gmtime_last_tm, 0, sizeof(struct tm));
+		__gmtime_last_tm.tm_year = year - 1900;
+		__gmtime_last_tm.tm_mon  = mon - 1;
+		__gmtime_last_tm.tm_mday = mday;
+		__gmtime_last_days = days;
+	}
+	memcpy(tm, &__gmtime_last_tm, sizeof(struct tm));
+	tm->tm_hour = secs / 3600;
+	tm->tm_min  = (secs / 60) % 60;
+	tm->tm_sec  = secs % 60;
+}
+
+/*
+ * printBufferDateTime - print "YYYY-MM-DD[ HH:MI:SS[.frac]]"
+ */
+static inline void
+printBufferDateTime(const char *quote, const struct tm *tm, bool with_time,
+					uint32_t frac, int frac_width)
+{
+	int		year = tm->tm_year + 1900;
+	char   *pos;
+	char   *tail;
+
+	if (year < 0 || year > 9999 || tm->tm_mon < 0 || tm->tm_mon > 11)
+	{
+		/* unusual date; print it in the slow path */
+		printBufferPrintf("%s%04d-%02d-%02d", quote,
+						  year, tm->tm_mon + 1, tm->tm_mday);
+		if (with_time)
+			printBufferPrintf(" %02d:%02d:%02d",
+							  tm->tm_hour, tm->tm_min, tm->tm_sec);
+		if (frac_width > 0)
+			printBufferPrintf(".%0*u", frac_width, frac);
+		printBufferPuts(quote);
+		return;
+	}
+	pos = tail = printBufferReserve(64);
+	tail = __put_quote(tail, quote);
+	tail = __put_digits(tail, year, 4);
+	*tail++ = '-';
+	tail = __put_digits(tail, tm->tm_mon + 1, 2);
+	*tail++ = '-';
+	tail = __put_digits(tail, tm->tm_mday, 2);
+	if (with_time)
+	{
+		*tail++ = ' ';
+		tail = __put_digits(tail, tm->tm_hour, 2);
+		*tail++ = ':';
+		tail = __put_digits(tail, tm->tm_min, 2);
+		*tail++ = ':';
+		tail = __put_digits(tail, tm->tm_sec, 2);
+	}
+	if (frac_width > 0)
+	{
+		*tail++ = '.';
+		tail = __put_digits(tail, frac, frac_width);
+	}
+	tail = __put_quote(tail, quote);
+	print_buf->usage += (tail - pos);
+}
+
+/*
+ * printBufferTime - print "HH:MI:SS[.frac]"
+ */
+static inline void
+printBufferTime(const char *quote, uint32_t hour, uint32_t min, uint32_t sec,
+				uint32_t frac, int frac_width)
+{
+	char   *pos;
+	char   *tail;
+
+	if (hour > 99)
+	{
+		/* unusual time; print it in the slow path */
+		printBufferPrintf("%s%02u:%02u:%02u", quote, hour, min, sec);
+		if (frac_width > 0)
+			printBufferPrintf(".%0*u", frac_width, frac);
+		printBufferPuts(quote);
+		return;
+	}
+	pos = tail = printBufferReserve(48);
+	tail = __put_quote(tail, quote);
+	tail = __put_digits(tail, hour, 2);
+	*tail++ = ':';
+	tail = __put_digits(tail, min, 2);
+	*tail++ = ':';
+	tail = __put_digits(tail, sec, 2);
+	if (frac_width > 0)
+	{
+		*tail++ = '.';
+		tail = __put_digits(tail, frac, frac_width);
+	}
+	tail = __put_quote(tail, quote);
+	print_buf->usage += (tail - pos);
+}
+
 static void
 printNullDatum(void)
 {
 	/* print "null" only if List elements */
 	if (current_context == 'e')
-		fprintf(output_filp, "null");
+		printBufferWrite("null", 4);
 }
 
 static void
@@ -252,7 +539,7 @@ static bool
 print_arrow_int8(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(int8_t);
-	fprintf(output_filp, "%d", (int)datum);
+	printBufferInt64(datum);
 	return true;
 }
 
@@ -260,7 +547,7 @@ static bool
 print_arrow_uint8(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint8_t);
-	fprintf(output_filp, "%u", (unsigned int)datum);
+	printBufferUInt64(datum);
 	return true;
 }
 
@@ -268,7 +555,7 @@ static bool
 print_arrow_int16(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(int16_t);
-	fprintf(output_filp, "%d", (int)datum);
+	printBufferInt64(datum);
 	return true;
 }
 
@@ -276,7 +563,7 @@ static bool
 print_arrow_uint16(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint16_t);
-	fprintf(output_filp, "%u", (unsigned int)datum);
+	printBufferUInt64(datum);
 	return true;
 }
 
@@ -284,7 +571,7 @@ static bool
 print_arrow_int32(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(int32_t);
-	fprintf(output_filp, "%d", datum);
+	printBufferInt64(datum);
 	return true;
 }
 
@@ -292,7 +579,7 @@ static bool
 print_arrow_uint32(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint32_t);
-	fprintf(output_filp, "%u", datum);
+	printBufferUInt64(datum);
 	return true;
 }
 
@@ -300,7 +587,7 @@ static bool
 print_arrow_int64(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(int64_t);
-	fprintf(output_filp, "%ld", datum);
+	printBufferInt64(datum);
 	return true;
 }
 
@@ -308,7 +595,7 @@ static bool
 print_arrow_uint64(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint64_t);
-	fprintf(output_filp, "%lu", datum);
+	printBufferUInt64(datum);
 	return true;
 }
 
@@ -316,7 +603,7 @@ static bool
 print_arrow_float2(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint16_t);
-	fprintf(output_filp, "%f", fp16_to_fp64(datum));
+	printBufferPrintf("%f", fp16_to_fp64(datum));
 	return true;
 }
 
@@ -324,7 +611,7 @@ static bool
 print_arrow_float4(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(float);
-	fprintf(output_filp, "%f", (double)datum);
+	printBufferPrintf("%f", (double)datum);
 	return true;
 }
 
@@ -332,7 +619,7 @@ static bool
 print_arrow_float8(ARROW_PRINT_DATUM_ARGS)
 {
 	ARROW_PRINT_DATUM_SETUP_INLINE(double);
-	fprintf(output_filp, "%f", datum);
+	printBufferPrintf("%f", datum);
 	return true;
 }
 
@@ -341,16 +628,29 @@ __print_arrow_utf8_common(const char *addr, size_t sz, const char *quote)
 {
 	size_t	i;
 
-	fprintf(output_filp, "%s", quote);
-	for (i=0; i < sz; i++)
+	printBufferPuts(quote);
+	if (*quote == '\0')
+		printBufferWrite(addr, sz);
+	else
 	{
-		int		c = (unsigned char)addr[i];
+		/* escape double-quotes within the quoted string */
+		while (sz > 0)
+		{
+			const char *pos = memchr(addr, '"', sz);
 
-		if (c == '"')
-			fputc('"', output_filp);
-		fputc(c, output_filp);
+			if (!pos)
+			{
+				printBufferWrite(addr, sz);
+				break;
+			}
+			i = (pos - addr) + 1;
+			printBufferWrite(addr, i);
+			printBufferPutc('"');
+			addr += i;
+			sz -= i;
+		}
 	}
-	fprintf(output_filp, "%s", quote);
+	printBufferPuts(quote);
 	return true;
 }
 
@@ -384,15 +684,19 @@ __print_arrow_binary_common(const char *addr, size_t sz, const char *quote)
 	static const char hextbl[] = "0123456789abcdef";
 	size_t	i;
 
-	fprintf(output_filp, "%s\\x", quote);
+	char   *pos;
+
+	printBufferPrintf("%s\\x", quote);
+	pos = printBufferReserve(2 * sz);
 	for (i=0; i < sz; i++)
 	{
 		int		c = (unsigned char)addr[i];
 
-		fputc(hextbl[(c >> 4) & 0x0f], output_filp);
-		fputc(hextbl[(c & 0x0f)], output_filp);
+		*pos++ = hextbl[(c >> 4) & 0x0f];
+		*pos++ = hextbl[(c & 0x0f)];
 	}
-	fprintf(output_filp, "%s", quote);
+	print_buf->usage += 2 * sz;
+	printBufferPuts(quote);
 	return true;
 }
 
@@ -431,9 +735,9 @@ print_arrow_bool(ARROW_PRINT_DATUM_ARGS)
 		return false;
 
 	if ((bitmap[k] & mask) != 0)
-		fprintf(output_filp, "true");
+		printBufferWrite("true", 4);
 	else
-		fprintf(output_filp, "false");
+		printBufferWrite("false", 5);
 	return true;
 }
 
@@ -456,12 +760,12 @@ print_arrow_decimal128(ARROW_PRINT_DATUM_ARGS)
 	/* zero handling */
 	if (datum == 0)
 	{
-		fputc('0', output_filp);
+		printBufferPutc('0');
 		if (scale > 0)
 		{
-			fputc('.', output_filp);
+			printBufferPutc('.');
 			while (scale-- > 0)
-				fputc('0', output_filp);
+				printBufferPutc('0');
 		}
 		return true;
 	}
@@ -508,49 +812,31 @@ print_arrow_decimal128(ARROW_PRINT_DATUM_ARGS)
 
 	if (negative)
 		*--pos = '-';
-	fprintf(output_filp, "%s", pos);
+	printBufferPuts(pos);
 	return true;
 }
 
 static bool
 print_arrow_date_day(ARROW_PRINT_DATUM_ARGS)
 {
-	time_t		t;
 	struct tm	tm;
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint32_t);
 	/* to seconds from the epoch */
-	t = (time_t)datum * 86400LL;
-	gmtime_r(&t, &tm);
-	fprintf(output_filp, "%s%04d-%02d-%02d%s",
-			quote,
-			tm.tm_year + 1900,
-			tm.tm_mon + 1,
-			tm.tm_mday,
-			quote);
+	__gmtime_fast((int64_t)datum * 86400LL, &tm);
+	printBufferDateTime(quote, &tm, false, 0, 0);
 	return true;
 }
 
 static bool
 print_arrow_date_ms(ARROW_PRINT_DATUM_ARGS)
 {
-	time_t		t;
 	struct tm	tm;
 	uint32_t	msec;
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint64_t);
 
 	msec = datum % 1000;
-	t = datum / 1000;
-	gmtime_r(&t, &tm);
-	fprintf(output_filp, "%s%04d-%02d-%02d %02d:%02d:%02d.%03d%s",
-			quote,
-			tm.tm_year + 1900,
-			tm.tm_mon + 1,
-			tm.tm_mday,
-			tm.tm_hour,
-			tm.tm_min,
-			tm.tm_sec,
-			msec,
-			quote);
+	__gmtime_fast((int64_t)(datum / 1000), &tm);
+	printBufferDateTime(quote, &tm, true, msec, 3);
 	return true;
 }
 
@@ -564,10 +850,7 @@ print_arrow_time_sec(ARROW_PRINT_DATUM_ARGS)
 	datum /= 60;
 	min = datum % 60;
 	datum /= 60;
-	fprintf(output_filp, "%s%02u:%02u:%02u%s",
-			quote,
-			datum, min, sec,
-			quote);
+	printBufferTime(quote, datum, min, sec, 0, 0);
 	return true;
 }
 
@@ -583,10 +866,7 @@ print_arrow_time_ms(ARROW_PRINT_DATUM_ARGS)
 	datum /= 60;
 	min = datum % 60;
 	datum /= 60;
-	fprintf(output_filp, "%s%02u:%02u:%02u.%03u%s",
-			quote,
-			datum, min, sec, ms,
-			quote);
+	printBufferTime(quote, datum, min, sec, ms, 3);
 	return true;
 }
 
@@ -602,10 +882,7 @@ print_arrow_time_us(ARROW_PRINT_DATUM_ARGS)
 	datum /= 60;
 	min = datum % 60;
 	datum /= 60;
-	fprintf(output_filp, "%s%02d:%02d:%02d.%06d%s",
-			quote,
-			(uint32_t)datum, min, sec, us,
-			quote);
+	printBufferTime(quote, (uint32_t)datum, min, sec, us, 6);
 	return true;
 }
 
@@ -621,13 +898,15 @@ print_arrow_time_ns(ARROW_PRINT_DATUM_ARGS)
 	datum /= 60;
 	min = datum % 60;
 	datum /= 60;
-	fprintf(output_filp, "%s%02d:%02d:%02d.%09d%s",
-			quote,
-			(uint32_t)datum, min, sec, ns,
-			quote);
+	printBufferTime(quote, (uint32_t)datum, min, sec, ns, 9);
 	return true;
 }
 
+/*
+ * NOTE: setenv("TZ") is not thread-safe, so main() assigns the timezone
+ * prior to launch of the worker threads if all the timestamp columns have
+ * an identical timezone. Elsewhere, only a single thread converts the rows.
+ */
 static bool
 __assign_timestamp_timezone(ArrowTypeTimestamp *timestamp)
 {
@@ -639,120 +918,62 @@ __assign_timestamp_timezone(ArrowTypeTimestamp *timestamp)
 	{
 		if (setenv("TZ", timestamp->timezone, 1) != 0)
 			Elog("failed on setenv('TZ'): %m");
-        current_tz_name = timestamp->timezone;
+		tzset();
+		current_tz_name = timestamp->timezone;
 	}
 	return true;
 }
 
-static bool
-print_arrow_timestamp_sec(ARROW_PRINT_DATUM_ARGS)
+static inline void
+__print_arrow_timestamp_common(arrowColumn *column, const char *quote,
+							   uint64_t datum, uint32_t frac, int frac_width)
 {
-	time_t		t;
 	struct tm	tm;
-	ARROW_PRINT_DATUM_SETUP_INLINE(uint64_t);
+	time_t		t = (time_t)datum;
 
-	t = (time_t)datum;
 	if (!__assign_timestamp_timezone(&column->arrow_type.Timestamp))
-		gmtime_r(&t, &tm);
+		__gmtime_fast(t, &tm);
 	else
 		localtime_r(&t, &tm);
-	fprintf(output_filp,
-			"%s%04d-%02d-%02d %02d:%02d:%02d%s",
-			quote,
-			tm.tm_year + 1900,
-			tm.tm_mon + 1,
-			tm.tm_mday,
-			tm.tm_hour,
-			tm.tm_min,
-			tm.tm_sec,
-			quote);
+	printBufferDateTime(quote, &tm, true, frac, frac_width);
+}
+
+static bool
+print_arrow_timestamp_sec(ARROW_PRINT_DATUM_ARGS)
+{
+	ARROW_PRINT_DATUM_SETUP_INLINE(uint64_t);
+
+	__print_arrow_timestamp_common(column, quote, datum, 0, 0);
 	return true;
 }
 
 static bool
 print_arrow_timestamp_ms(ARROW_PRINT_DATUM_ARGS)
 {
-	time_t		t;
-	struct tm	tm;
-	uint32_t	ms;
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint64_t);
 
-	ms = datum % 1000;
-	datum /= 1000;
-	t = (time_t)datum;
-	if (!__assign_timestamp_timezone(&column->arrow_type.Timestamp))
-		gmtime_r(&t, &tm);
-	else
-		localtime_r(&t, &tm);
-	fprintf(output_filp,
-			"%s%04d-%02d-%02d %02d:%02d:%02d.%03u%s",
-			quote,
-			tm.tm_year + 1900,
-			tm.tm_mon + 1,
-			tm.tm_mday,
-			tm.tm_hour,
-			tm.tm_min,
-			tm.tm_sec,
-			ms,
-			quote);
+	__print_arrow_timestamp_common(column, quote, datum / 1000,
+								   datum % 1000, 3);
 	return true;
 }
 
 static bool
 print_arrow_timestamp_us(ARROW_PRINT_DATUM_ARGS)
 {
-	time_t		t;
-	struct tm	tm;
-	uint32_t	us;
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint64_t);
 
-	us = datum % 1000000;
-	datum /= 1000000;
-	t = (time_t)datum;
-	if (!__assign_timestamp_timezone(&column->arrow_type.Timestamp))
-		gmtime_r(&t, &tm);
-	else
-		localtime_r(&t, &tm);
-	fprintf(output_filp,
-			"%s%04d-%02d-%02d %02d:%02d:%02d.%06u%s",
-			quote,
-			tm.tm_year + 1900,
-			tm.tm_mon + 1,
-			tm.tm_mday,
-			tm.tm_hour,
-			tm.tm_min,
-			tm.tm_sec,
-			us,
-			quote);
+	__print_arrow_timestamp_common(column, quote, datum / 1000000,
+								   datum % 1000000, 6);
 	return true;
 }
 
 static bool
 print_arrow_timestamp_ns(ARROW_PRINT_DATUM_ARGS)
 {
-	time_t		t;
-	struct tm	tm;
-	uint32_t	ns;
 	ARROW_PRINT_DATUM_SETUP_INLINE(uint64_t);
 
-	ns = datum % 1000000000;
-	datum /= 1000000000;
-	t = (time_t)datum;
-	if (!__assign_timestamp_timezone(&column->arrow_type.Timestamp))
-		gmtime_r(&t, &tm);
-	else
-		localtime_r(&t, &tm);
-	fprintf(output_filp,
-			"%s%04d-%02d-%02d %02d:%02d:%02d.%09u%s",
-			quote,
-			tm.tm_year + 1900,
-			tm.tm_mon + 1,
-			tm.tm_mday,
-			tm.tm_hour,
-			tm.tm_min,
-			tm.tm_sec,
-			ns,
-			quote);
+	__print_arrow_timestamp_common(column, quote, datum / 1000000000,
+								   datum % 1000000000, 9);
 	return true;
 }
 
@@ -770,20 +991,20 @@ print_arrow_interval_ym(ARROW_PRINT_DATUM_ARGS)
 	}
 	year = datum / 12;
 	mon = datum % 12;
-	fprintf(output_filp, "%s", quote);
+	printBufferPrintf("%s", quote);
 	if (year != 0 && mon != 0)
-		fprintf(output_filp, "%d %s %d %s",
+		printBufferPrintf("%d %s %d %s",
 				year, (year > 1 ? "years" : "year"),
 				mon, (mon > 1 ? "months" : "month"));
 	else if (year != 0)
-		fprintf(output_filp, "%d %s",
+		printBufferPrintf("%d %s",
 				year, (year > 1 ? "years" : "year"));
 	else
-		fprintf(output_filp, "%d %s",
+		printBufferPrintf("%d %s",
 				mon, (mon > 1 ? "months" : "month"));
 	if (negative)
-		fprintf(output_filp, " ago");
-	fprintf(output_filp, "%s", quote);
+		printBufferPrintf(" ago");
+	printBufferPrintf("%s", quote);
 	return true;
 }
 
@@ -809,24 +1030,24 @@ print_arrow_interval_dt(ARROW_PRINT_DATUM_ARGS)
 	min = datum % 60;
 	datum /= 60;
 	hour = datum;
-	fprintf(output_filp, "%s", quote);
+	printBufferPrintf("%s", quote);
 	if (days != 0)
 	{
 		if (hour != 0 || min != 0 || sec != 0)
-			fprintf(output_filp, "%d %s %02d:%02d:%02d",
+			printBufferPrintf("%d %s %02d:%02d:%02d",
 					days, (days > 1 ? "days" : "day"),
 					hour, min, sec);
 	}
 	else
 	{
-		fprintf(output_filp, "%02d:%02d:%02d",
+		printBufferPrintf("%02d:%02d:%02d",
 				hour, min, sec);
 	}
 	if (msec != 0)
-		fprintf(output_filp, ".%03d", msec);
+		printBufferPrintf(".%03d", msec);
 	if (negative)
-		fprintf(output_filp, " ago");
-	fprintf(output_filp, "%s", quote);
+		printBufferPrintf(" ago");
+	printBufferPrintf("%s", quote);
 	return true;
 }
 
@@ -836,16 +1057,16 @@ print_arrow_fixedsizebinary(ARROW_PRINT_DATUM_ARGS)
 	int32_t		i, width = column->arrow_type.FixedSizeBinary.byteWidth;
 	ARROW_PRINT_DATUM_SETUP_FIXEDSIZEBINARY(width);
 
-	fprintf(output_filp, "%s\\x", quote);
+	printBufferPrintf("%s\\x", quote);
 	for (i=0; i < width; i++)
 	{
 		static const char *hextbl = "0123456789abcdef";
 		int		c = addr[i];
 
-		fputc(hextbl[(c >> 4) & 0x0f], output_filp);
-		fputc(hextbl[(c & 0x0f)], output_filp);
+		printBufferPutc(hextbl[(c >> 4) & 0x0f]);
+		printBufferPutc(hextbl[(c & 0x0f)]);
 	}
-	fprintf(output_filp, "%s", quote);
+	printBufferPrintf("%s", quote);
 	return true;
 }
 
@@ -855,7 +1076,7 @@ print_arrow_macaddr(ARROW_PRINT_DATUM_ARGS)
 	int32_t		width = column->arrow_type.FixedSizeBinary.byteWidth;
 	ARROW_PRINT_DATUM_SETUP_FIXEDSIZEBINARY(width);
 	assert(width == 6);
-	fprintf(output_filp,
+	printBufferPrintf(
 			"%s%02x:%02x:%02x:%02x:%02x:%02x%s",
 			quote,
 			(unsigned char)addr[0],
@@ -874,7 +1095,7 @@ print_arrow_inet4(ARROW_PRINT_DATUM_ARGS)
 	int32_t		width = column->arrow_type.FixedSizeBinary.byteWidth;
 	ARROW_PRINT_DATUM_SETUP_FIXEDSIZEBINARY(width);
     assert(width == 4);
-	fprintf(output_filp,
+	printBufferPrintf(
 			"%s%u.%u.%u.%u%s",
 			quote,
 			(unsigned char)addr[0],
@@ -921,7 +1142,7 @@ print_arrow_inet6(ARROW_PRINT_DATUM_ARGS)
 	}
 
 	/* print out IPv6 */
-	fprintf(output_filp, "%s", quote);
+	printBufferPrintf("%s", quote);
 	for (i=0; i < 8; i++)
 	{
 		if (zero_base >= 0 &&
@@ -929,28 +1150,28 @@ print_arrow_inet6(ARROW_PRINT_DATUM_ARGS)
 			i <  zero_base + zero_len)
 		{
 			if (i == zero_base)
-				fputc(':', output_filp);
+				printBufferPutc(':');
 			continue;
 		}
 		if (i > 0)
-			fputc(':', output_filp);
+			printBufferPutc(':');
 		/* Is this address an encapsulated IPv4? */
 		if (i == 6 && zero_base == 0 && ((zero_len == 6) ||
 										 (zero_len == 7 && words[7] != 0x0001) ||
 										 (zero_len == 5 && words[5] == 0xffff)))
 		{
-			fprintf(output_filp, "%u.%u.%u.%u",
+			printBufferPrintf("%u.%u.%u.%u",
 					(unsigned char)addr[12],
 					(unsigned char)addr[13],
 					(unsigned char)addr[14],
 					(unsigned char)addr[15]);
 			break;
 		}
-		fprintf(output_filp, "%x", words[i]);
+		printBufferPrintf("%x", words[i]);
 	}
 	if (zero_base >= 0 && zero_base + zero_len == 8)
-		fputc(':', output_filp);
-	fprintf(output_filp, "%s", quote);
+		printBufferPutc(':');
+	printBufferPrintf("%s", quote);
 	return true;
 }
 
@@ -975,16 +1196,16 @@ print_arrow_list(ARROW_PRINT_DATUM_ARGS)
 	child = &column->children[0];
 	__buffers = buffers + (child->buffer_index -
 						   column->buffer_index);
-	fprintf(output_filp, "%s[", quote);
+	printBufferPrintf("%s[", quote);
 	current_context = 'e';
 	for (i=head; i < tail; i++)
 	{
 		if (i > head)
-			fprintf(output_filp, ",");
+			printBufferPrintf(",");
 		printArrowDatum(child, __buffers, rb_chunk, i, "");
 	}
 	current_context = saved_context;
-	fprintf(output_filp, "%s]", quote);
+	printBufferPrintf("%s]", quote);
 	return true;
 }
 
@@ -994,7 +1215,7 @@ print_arrow_struct(ARROW_PRINT_DATUM_ARGS)
 	char		saved_context = current_context;
 	int			j;
 
-	fprintf(output_filp, "%s(", quote);
+	printBufferPrintf("%s(", quote);
 	current_context = 'e';
 	for (j=0; j < column->num_children; j++)
 	{
@@ -1002,11 +1223,11 @@ print_arrow_struct(ARROW_PRINT_DATUM_ARGS)
 		ArrowBuffer *__buffers = buffers + (child->buffer_index -
 											column->buffer_index);
 		if (j > 0)
-			fprintf(output_filp, "%c", csv_delimiter);
+			printBufferPrintf("%c", csv_delimiter);
 		printArrowDatum(child, __buffers, rb_chunk, index, "");
 	}
 	current_context = saved_context;
-	fprintf(output_filp, "%s)", quote);
+	printBufferPrintf("%s)", quote);
 	return true;
 }
 
@@ -1383,23 +1604,12 @@ printCreateTable(void)
 }
 
 static void
-printRecordBatch(ArrowRecordBatch *rbatch, const char *rb_chunk)
+printRecordBatch(ArrowRecordBatch *rbatch, const char *rb_chunk,
+				 int64_t start, int64_t nrows)
 {
 	int64_t		i, j;
 
-	/* consider --offset */
-	if (num_skip_rows < 0)
-		i = 0;
-	else
-	{
-		i = num_skip_rows;
-		if (num_skip_rows > rbatch->length)
-			num_skip_rows -= rbatch->length;
-		else
-			num_skip_rows = 0;
-	}
-
-	while (i < rbatch->length && num_dump_rows != 0)
+	for (i=start; i < start + nrows; i++)
 	{
 		for (j=0; j < arrow_num_columns; j++)
 		{
@@ -1407,7 +1617,7 @@ printRecordBatch(ArrowRecordBatch *rbatch, const char *rb_chunk)
 			ArrowBuffer	   *buffers;
 
 			if (j > 0)
-				fprintf(output_filp, "%c", csv_delimiter);
+				printBufferPutc(csv_delimiter);
 			if (j >= rbatch->_num_nodes)
 				printNullDatum();
 			else if (i >= rbatch->nodes[j].length)
@@ -1420,21 +1630,209 @@ printRecordBatch(ArrowRecordBatch *rbatch, const char *rb_chunk)
 				printArrowDatum(column, buffers, rb_chunk, i, "\"");
 			}
 		}
-		fprintf(output_filp, "\r\n");
-		i++;
-		if (num_dump_rows > 0)
-			num_dump_rows--;
+		printBufferWrite("\r\n", 2);
+	}
+}
+
+/*
+ * printTask - a range of rows in a record batch to be converted
+ */
+typedef struct
+{
+	ArrowRecordBatch *rbatch;
+	const char *rb_chunk;
+	int64_t		start;
+	int64_t		nrows;
+	printBuffer	buf;
+	bool		done;
+} printTask;
+
+#define PRINT_TASK_NROWS		100000
+
+static printTask   *print_tasks = NULL;
+static int			num_print_tasks = 0;
+static int			next_print_task = 0;		/* next task to convert */
+static int			num_written_tasks = 0;		/* tasks already written */
+static int			print_tasks_window = 0;
+static pthread_mutex_t print_tasks_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  print_tasks_cond = PTHREAD_COND_INITIALIZER;
+
+static void
+addPrintTask(ArrowRecordBatch *rbatch, const char *rb_chunk,
+			 int64_t start, int64_t nrows)
+{
+	static int	num_print_tasks_max = 0;
+	printTask  *task;
+	size_t		body_sz = 0;
+	size_t		length;
+	int			j;
+
+	if (num_print_tasks >= num_print_tasks_max)
+	{
+		num_print_tasks_max = Max(2 * num_print_tasks_max, 256);
+		print_tasks = repalloc(print_tasks, sizeof(printTask) *
+							   num_print_tasks_max);
+	}
+	task = &print_tasks[num_print_tasks++];
+	memset(task, 0, sizeof(printTask));
+	task->rbatch = rbatch;
+	task->rb_chunk = rb_chunk;
+	task->start = start;
+	task->nrows = nrows;
+	/*
+	 * Pre-size the output buffer; text form is usually less than twice of
+	 * the binary form, plus the delimiters.
+	 */
+	for (j=0; j < rbatch->_num_buffers; j++)
+		body_sz += rbatch->buffers[j].length;
+	length = (2 * body_sz / Max(rbatch->length, 1) +
+			  2 * arrow_num_columns + 2) * nrows;
+	task->buf.length = Min(Max(length, 65536), (1UL << 30));
+}
+
+static void
+setupPrintTasks(ArrowFileInfo *af_info, const char *mmap_head)
+{
+	int		i;
+
+	for (i=0; i < af_info->footer._num_recordBatches; i++)
+	{
+		ArrowBlock *block = &af_info->footer.recordBatches[i];
+		const char *rb_chunk = (mmap_head + block->offset + block->metaDataLength);
+		ArrowRecordBatch *rbatch = &af_info->recordBatches[i].body.recordBatch;
+		int64_t		start = 0;
+		int64_t		nrows = rbatch->length;
+
+		/* consider --offset */
+		if (num_skip_rows > 0)
+		{
+			int64_t		nskips = Min(num_skip_rows, nrows);
+
+			start += nskips;
+			nrows -= nskips;
+			num_skip_rows -= nskips;
+		}
+		/* consider --limit */
+		if (num_dump_rows >= 0)
+		{
+			nrows = Min(nrows, num_dump_rows);
+			num_dump_rows -= nrows;
+		}
+		while (nrows > 0)
+		{
+			int64_t		n = Min(nrows, PRINT_TASK_NROWS);
+
+			addPrintTask(rbatch, rb_chunk, start, n);
+			start += n;
+			nrows -= n;
+		}
 	}
 }
 
 static void
-dumpArrowFile(ArrowFileInfo *af_info, int fdesc)
+execPrintTask(printTask *task)
+{
+	print_buf = &task->buf;
+	print_buf->data = palloc(print_buf->length);
+	printRecordBatch(task->rbatch,
+					 task->rb_chunk,
+					 task->start,
+					 task->nrows);
+	print_buf = NULL;
+}
+
+static void *
+printWorkerMain(void *__priv)
+{
+	for (;;)
+	{
+		printTask  *task;
+
+		pthread_mutex_lock(&print_tasks_mutex);
+		/* do not run ahead too much, not to consume the memory */
+		while (next_print_task < num_print_tasks &&
+			   next_print_task >= num_written_tasks + print_tasks_window)
+			pthread_cond_wait(&print_tasks_cond, &print_tasks_mutex);
+		if (next_print_task >= num_print_tasks)
+		{
+			pthread_mutex_unlock(&print_tasks_mutex);
+			break;
+		}
+		task = &print_tasks[next_print_task++];
+		pthread_mutex_unlock(&print_tasks_mutex);
+
+		execPrintTask(task);
+
+		pthread_mutex_lock(&print_tasks_mutex);
+		task->done = true;
+		pthread_cond_broadcast(&print_tasks_cond);
+		pthread_mutex_unlock(&print_tasks_mutex);
+	}
+	return NULL;
+}
+
+static void
+writePrintTask(printTask *task)
+{
+	if (task->buf.usage > 0 &&
+		fwrite(task->buf.data, task->buf.usage, 1, output_filp) != 1)
+		Elog("failed on fwrite: %m");
+	pfree(task->buf.data);
+	task->buf.data = NULL;
+}
+
+static void
+dumpArrowRecordBatches(int num_threads)
+{
+	pthread_t  *workers;
+	int			i;
+
+	if (num_threads <= 1 || num_print_tasks <= 1)
+	{
+		for (i=0; i < num_print_tasks; i++)
+		{
+			execPrintTask(&print_tasks[i]);
+			writePrintTask(&print_tasks[i]);
+		}
+		return;
+	}
+	/* launch worker threads */
+	print_tasks_window = 2 * num_threads;
+	workers = alloca(sizeof(pthread_t) * num_threads);
+	for (i=0; i < num_threads; i++)
+	{
+		if ((errno = pthread_create(&workers[i], NULL,
+									printWorkerMain, NULL)) != 0)
+			Elog("failed on pthread_create: %m");
+	}
+	/* write out the results in order */
+	for (i=0; i < num_print_tasks; i++)
+	{
+		printTask  *task = &print_tasks[i];
+
+		pthread_mutex_lock(&print_tasks_mutex);
+		while (!task->done)
+			pthread_cond_wait(&print_tasks_cond, &print_tasks_mutex);
+		pthread_mutex_unlock(&print_tasks_mutex);
+
+		writePrintTask(task);
+
+		pthread_mutex_lock(&print_tasks_mutex);
+		num_written_tasks++;
+		pthread_cond_broadcast(&print_tasks_cond);
+		pthread_mutex_unlock(&print_tasks_mutex);
+	}
+	for (i=0; i < num_threads; i++)
+		pthread_join(workers[i], NULL);
+}
+
+static const char *
+mmapArrowFile(ArrowFileInfo *af_info, int fdesc)
 {
 	static long	__PAGE_SIZE = -1;
 	size_t		file_sz = af_info->stat_buf.st_size;
 	size_t		mmap_sz;
 	char	   *mmap_head;
-	int			i;
 
 	if (__PAGE_SIZE < 0)
 		__PAGE_SIZE = sysconf(_SC_PAGESIZE);
@@ -1442,15 +1840,36 @@ dumpArrowFile(ArrowFileInfo *af_info, int fdesc)
 	mmap_head = mmap(NULL, mmap_sz, PROT_READ, MAP_SHARED, fdesc, 0);
 	if (mmap_head == MAP_FAILED)
 		Elog("failed on mmap: %m");
-	for (i=0; i < af_info->footer._num_recordBatches; i++)
+	/* record batches are read sequentially */
+	posix_madvise(mmap_head, mmap_sz, POSIX_MADV_SEQUENTIAL);
+	return mmap_head;
+}
+
+/*
+ * checkTimestampTimezone - it returns false if timestamp columns have
+ * multiple distinct timezones; setenv("TZ") is not thread-safe.
+ */
+static bool
+checkTimestampTimezone(arrowColumn *column, ArrowTypeTimestamp **p_ts)
+{
+	int		j;
+
+	if (column->arrow_type.node.tag == ArrowNodeTag__Timestamp &&
+		column->arrow_type.Timestamp.timezone)
 	{
-		ArrowBlock *block = &af_info->footer.recordBatches[i];
-		char	   *rb_chunk = (mmap_head + block->offset + block->metaDataLength);
-		ArrowRecordBatch *rbatch = &af_info->recordBatches[i].body.recordBatch;
+		ArrowTypeTimestamp *ts = &column->arrow_type.Timestamp;
 
-		printRecordBatch(rbatch, rb_chunk);
+		if (!*p_ts)
+			*p_ts = ts;
+		else if (strcmp((*p_ts)->timezone, ts->timezone) != 0)
+			return false;
 	}
-	munmap(mmap_head, mmap_sz);
+	for (j=0; j < column->num_children; j++)
+	{
+		if (!checkTimestampTimezone(&column->children[j], p_ts))
+			return false;
+	}
+	return true;
 }
 
 int
@@ -1461,6 +1880,7 @@ main(int argc, char * const argv[])
 		{"header",       no_argument,       NULL, 1002},
 		{"offset",       required_argument, NULL, 1004},
 		{"limit",        required_argument, NULL, 1005},
+		{"parallel",     required_argument, NULL, 'j'},
 		/* CREATE TABLE & COPY FROM */
 		{"create-table", required_argument, NULL, 1200},
 		{"tablespace",   required_argument, NULL, 1201},
@@ -1469,9 +1889,11 @@ main(int argc, char * const argv[])
 		{"help",         no_argument,       NULL, 9999},
 		{NULL, 0, NULL, 0},
 	};
+	ArrowTypeTimestamp *tz_timestamp = NULL;
+	int		num_threads = -1;
 	int		i, j, c;
 
-	while ((c = getopt_long(argc, argv, "o:h", long_options, NULL)) >= 0)
+	while ((c = getopt_long(argc, argv, "o:j:h", long_options, NULL)) >= 0)
 	{
 		switch (c)
 		{
@@ -1499,6 +1921,13 @@ main(int argc, char * const argv[])
 				if (num_dump_rows < 0)
 					Elog("--limit=%s is not a numeric value", optarg);
 				break;
+			case 'j':	/* --parallel */
+				if (num_threads >= 0)
+					Elog("-j|--parallel was specified twice");
+				num_threads = atoi(optarg);
+				if (num_threads < 1)
+					Elog("-j|--parallel=%s is not a valid number", optarg);
+				break;
 			case 1200:	/* --create-table */
 				if (create_table_name)
 					Elog("--create-table was specified twice");
@@ -1621,7 +2050,25 @@ main(int argc, char * const argv[])
 	}
 	/* Dump Arrpw files */
 	for (i=0; i < arrow_num_files; i++)
-		dumpArrowFile(&arrow_files[i], arrow_fdescs[i]);
+	{
+		const char *mmap_head = mmapArrowFile(&arrow_files[i],
+											  arrow_fdescs[i]);
+		setupPrintTasks(&arrow_files[i], mmap_head);
+	}
+	if (num_threads < 0)
+		num_threads = Min(Max(sysconf(_SC_NPROCESSORS_ONLN), 1), 32);
+	for (j=0; j < arrow_num_columns; j++)
+	{
+		if (!checkTimestampTimezone(&arrow_columns[j], &tz_timestamp))
+		{
+			num_threads = 1;
+			break;
+		}
+	}
+	if (num_threads > 1 && tz_timestamp)
+		__assign_timestamp_timezone(tz_timestamp);
+	fflush(output_filp);
+	dumpArrowRecordBatches(num_threads);
 	if (create_table_name && num_dump_rows != 0)
 		fprintf(output_filp, "\\.\r\n");
 	return 0;
@@ -0,0 +1,1510 @@
+/*
+ * arrowcompact.c
+ *
+ * A tool to merge Apache Arrow files with many small record batches into
+ * a file with larger record batches, optionally re-ordered by the sort keys
+ * or Z-order curve, to make the embedded min/max statistics effective.
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include <ctype.h>
+#include <getopt.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "arrow_ipc.h"
+#include "float2.h"
+
+#ifndef Min
+#define Min(x,y)			((x) < (y) ? (x) : (y))
+#endif
+#ifndef Max
+#define Max(x,y)			((x) > (y) ? (x) : (y))
+#endif
+
+/*
+ * compactColumn - properties of the source column
+ */
+#define VCLASS__BOOL			'b'
+#define VCLASS__INT				'i'		/* signed integer */
+#define VCLASS__UINT			'u'		/* unsigned integer */
+#define VCLASS__FLOAT16			'h'
+#define VCLASS__FLOAT32			'f'
+#define VCLASS__FLOAT64			'd'
+#define VCLASS__INT128			'n'		/* decimal */
+#define VCLASS__BINARY			'x'		/* fixed-length binary */
+#define VCLASS__VARLENA			'v'		/* 32bit offset + extra */
+#define VCLASS__LARGE_VARLENA	'V'		/* 64bit offset + extra */
+
+typedef struct
+{
+	ArrowField *field;			/* field definition of the first file */
+	int			field_index;	/* index of the field node */
+	int			buffer_index;	/* index of the nullmap buffer */
+	char		vclass;			/* one of VCLASS__* */
+	int			unitsz;			/* width of the fixed-length value */
+	/* range of the ordered keys, if --zorder */
+	uint64_t	zorder_min;
+	uint64_t	zorder_max;
+} compactColumn;
+
+/*
+ * compactBatch - a record batch of the source files
+ */
+typedef struct
+{
+	const char	   *filename;
+	const char	   *rb_chunk;	/* head of the record batch body */
+	ArrowRecordBatch *rbatch;
+} compactBatch;
+
+/*
+ * compactRow - reference to a row on the source record batch
+ */
+typedef struct
+{
+	uint64_t	zkey;			/* Z-order key, if --zorder */
+	uint32_t	rb_id;			/* index of compact_batches[] */
+	uint32_t	row_id;			/* row index in the record batch */
+} compactRow;
+
+/* command options */
+static const char  *output_filename = NULL;
+static size_t		batch_segment_sz = 0;
+static char		   *sort_key_columns = NULL;
+static char		   *zorder_key_columns = NULL;
+static char		   *stat_embedded_columns = NULL;
+static bool			stat_embedded_default = true;
+static char		   *bloom_filter_columns = NULL;
+static char		   *compression_spec = NULL;
+static int			shows_progress = 0;
+
+/* static variables */
+static ArrowFileInfo *arrow_files = NULL;
+static int			arrow_num_files = 0;
+static compactColumn *compact_columns = NULL;
+static int			compact_num_columns = 0;
+static int			compact_num_buffers = 0;
+static compactBatch *compact_batches = NULL;
+static int			compact_num_batches = 0;
+static compactRow  *compact_rows = NULL;
+static uint64_t		compact_num_rows = 0;
+static compactColumn **compact_keys = NULL;
+static int			compact_num_keys = 0;
+
+static const char	__bool_values[2] = {0, 1};
+
+/*
+ * __trim
+ */
+static inline char *
+__trim(char *token)
+{
+	char   *tail = token + strlen(token) - 1;
+
+	while (*token == ' ' || *token == '\t')
+		token++;
+	while (tail >= token && (*tail == ' ' || *tail == '\t'))
+		*tail-- = '\0';
+	return token;
+}
+
+/*
+ * lookupCompactColumn
+ */
+static compactColumn *
+lookupCompactColumn(const char *name, const char *optname)
+{
+	int		j;
+
+	for (j=0; j < compact_num_columns; j++)
+	{
+		compactColumn *cc = &compact_columns[j];
+
+		if (strcmp(cc->field->name, name) == 0)
+			return cc;
+	}
+	Elog("field name [%s], specified by %s option, was not found",
+		 name, optname);
+	return NULL;
+}
+
+/*
+ * setupCompactColumn
+ */
+static int
+setupCompactColumn(compactColumn *cc, ArrowField *field,
+				   int field_index, int buffer_index)
+{
+	ArrowType  *t = &field->type;
+
+	if (field->dictionary)
+		Elog("field [%s] is dictionary-encoded; not supported",
+			 field->name);
+	memset(cc, 0, sizeof(compactColumn));
+	cc->field = field;
+	cc->field_index = field_index;
+	cc->buffer_index = buffer_index;
+	switch (t->node.tag)
+	{
+		case ArrowNodeTag__Bool:
+			cc->vclass = VCLASS__BOOL;
+			cc->unitsz = 1;
+			return 2;
+		case ArrowNodeTag__Int:
+			cc->vclass = (t->Int.is_signed ? VCLASS__INT : VCLASS__UINT);
+			cc->unitsz = t->Int.bitWidth / 8;
+			if (cc->unitsz != 1 && cc->unitsz != 2 &&
+				cc->unitsz != 4 && cc->unitsz != 8)
+				break;
+			return 2;
+		case ArrowNodeTag__FloatingPoint:
+			switch (t->FloatingPoint.precision)
+			{
+				case ArrowPrecision__Half:
+					cc->vclass = VCLASS__FLOAT16;
+					cc->unitsz = sizeof(uint16_t);
+					return 2;
+				case ArrowPrecision__Single:
+					cc->vclass = VCLASS__FLOAT32;
+					cc->unitsz = sizeof(float);
+					return 2;
+				case ArrowPrecision__Double:
+					cc->vclass = VCLASS__FLOAT64;
+					cc->unitsz = sizeof(double);
+					return 2;
+				default:
+					break;
+			}
+			break;
+		case ArrowNodeTag__Decimal:
+			if (t->Decimal.bitWidth != 128)
+				break;
+			cc->vclass = VCLASS__INT128;
+			cc->unitsz = sizeof(int128_t);
+			return 2;
+		case ArrowNodeTag__Date:
+			cc->vclass = VCLASS__INT;
+			cc->unitsz = (t->Date.unit == ArrowDateUnit__Day ? 4 : 8);
+			return 2;
+		case ArrowNodeTag__Time:
+			cc->vclass = VCLASS__INT;
+			cc->unitsz = t->Time.bitWidth / 8;
+			if (cc->unitsz != 4 && cc->unitsz != 8)
+				break;
+			return 2;
+		case ArrowNodeTag__Timestamp:
+			cc->vclass = VCLASS__INT;
+			cc->unitsz = sizeof(int64_t);
+			return 2;
+		case ArrowNodeTag__Interval:
+			cc->vclass = VCLASS__BINARY;
+			switch (t->Interval.unit)
+			{
+				case ArrowIntervalUnit__Year_Month:
+					cc->unitsz = sizeof(int32_t);
+					break;
+				case ArrowIntervalUnit__Day_Time:
+					cc->unitsz = 2 * sizeof(int32_t);
+					break;
+				default:
+					cc->unitsz = 2 * sizeof(int32_t) + sizeof(int64_t);
+					break;
+			}
+			return 2;
+		case ArrowNodeTag__FixedSizeBinary:
+			cc->vclass = VCLASS__BINARY;
+			cc->unitsz = t->FixedSizeBinary.byteWidth;
+			return 2;
+		case ArrowNodeTag__Utf8:
+		case ArrowNodeTag__Binary:
+			cc->vclass = VCLASS__VARLENA;
+			cc->unitsz = sizeof(uint32_t);
+			return 3;
+		case ArrowNodeTag__LargeUtf8:
+		case ArrowNodeTag__LargeBinary:
+			cc->vclass = VCLASS__LARGE_VARLENA;
+			cc->unitsz = sizeof(uint64_t);
+			return 3;
+		default:
+			break;
+	}
+	Elog("field [%s; %s] is not supported by arrowcompact",
+		 field->name, arrowNodeName(&t->node));
+	return -1;
+}
+
+/*
+ * __fetchColumnValue - returns the address of the value, or NULL if NULL
+ */
+static inline const char *
+__fetchColumnValue(const compactColumn *cc,
+				   const compactBatch *cb,
+				   uint32_t row_id,
+				   uint32_t *p_length)
+{
+	ArrowFieldNode *fnode = &cb->rbatch->nodes[cc->field_index];
+	ArrowBuffer	   *buffers = &cb->rbatch->buffers[cc->buffer_index];
+	const char	   *values = cb->rb_chunk + buffers[1].offset;
+
+	if (fnode->null_count > 0 && buffers[0].length > 0)
+	{
+		const uint8_t *nullmap = (const uint8_t *)(cb->rb_chunk + buffers[0].offset);
+
+		if ((nullmap[row_id >> 3] & (1 << (row_id & 7))) == 0)
+			return NULL;
+	}
+
+	switch (cc->vclass)
+	{
+		case VCLASS__BOOL:
+			*p_length = 1;
+			if ((((const uint8_t *)values)[row_id >> 3] & (1 << (row_id & 7))) != 0)
+				return &__bool_values[1];
+			return &__bool_values[0];
+
+		case VCLASS__VARLENA:
+			{
+				const uint32_t *offset = (const uint32_t *)values;
+
+				*p_length = offset[row_id+1] - offset[row_id];
+				return cb->rb_chunk + buffers[2].offset + offset[row_id];
+			}
+		case VCLASS__LARGE_VARLENA:
+			{
+				const uint64_t *offset = (const uint64_t *)values;
+
+				*p_length = offset[row_id+1] - offset[row_id];
+				return cb->rb_chunk + buffers[2].offset + offset[row_id];
+			}
+		default:
+			*p_length = cc->unitsz;
+			return values + (size_t)cc->unitsz * (size_t)row_id;
+	}
+}
+
+/*
+ * __compareColumnValue
+ */
+#define __COMPARE_FIXED(TYPE)						\
+	do {											\
+		TYPE	x, y;								\
+													\
+		memcpy(&x, a, sizeof(TYPE));				\
+		memcpy(&y, b, sizeof(TYPE));				\
+		return (x < y ? -1 : (x > y ? 1 : 0));		\
+	} while(0)
+
+#define __COMPARE_FLOAT(X,Y)						\
+	do {											\
+		if (isnan(X))								\
+			return (isnan(Y) ? 0 : 1);				\
+		else if (isnan(Y))							\
+			return -1;								\
+		return ((X) < (Y) ? -1 : ((X) > (Y) ? 1 : 0));	\
+	} while(0)
+
+static int
+__compareColumnValue(const compactColumn *cc,
+					 const char *a, uint32_t a_len,
+					 const char *b, uint32_t b_len)
+{
+	switch (cc->vclass)
+	{
+		case VCLASS__BOOL:
+			return (int)*a - (int)*b;
+		case VCLASS__INT:
+			switch (cc->unitsz)
+			{
+				case 1: __COMPARE_FIXED(int8_t);
+				case 2: __COMPARE_FIXED(int16_t);
+				case 4: __COMPARE_FIXED(int32_t);
+				default: __COMPARE_FIXED(int64_t);
+			}
+			break;
+		case VCLASS__UINT:
+			switch (cc->unitsz)
+			{
+				case 1: __COMPARE_FIXED(uint8_t);
+				case 2: __COMPARE_FIXED(uint16_t);
+				case 4: __COMPARE_FIXED(uint32_t);
+				default: __COMPARE_FIXED(uint64_t);
+			}
+			break;
+		case VCLASS__FLOAT16:
+			{
+				half_t	x, y;
+				float	fx, fy;
+
+				memcpy(&x, a, sizeof(half_t));
+				memcpy(&y, b, sizeof(half_t));
+				fx = fp16_to_fp32(x);
+				fy = fp16_to_fp32(y);
+				__COMPARE_FLOAT(fx, fy);
+			}
+			break;
+		case VCLASS__FLOAT32:
+			{
+				float	x, y;
+
+				memcpy(&x, a, sizeof(float));
+				memcpy(&y, b, sizeof(float));
+				__COMPARE_FLOAT(x, y);
+			}
+			break;
+		case VCLASS__FLOAT64:
+			{
+				double	x, y;
+
+				memcpy(&x, a, sizeof(double));
+				memcpy(&y, b, sizeof(double));
+				__COMPARE_FLOAT(x, y);
+			}
+			break;
+		case VCLASS__INT128:
+			__COMPARE_FIXED(int128_t);
+			break;
+		default:
+			{
+				int		rv = memcmp(a, b, Min(a_len, b_len));
+
+				if (rv != 0)
+					return rv;
+				return (a_len < b_len ? -1 : (a_len > b_len ? 1 : 0));
+			}
+	}
+	return 0;
+}
+#undef __COMPARE_FIXED
+#undef __COMPARE_FLOAT
+
+/*
+ * __zorderOrderedKey - maps the value to uint64 with keeping its order
+ */
+static uint64_t
+__zorderOrderedKey(const compactColumn *cc, const char *addr, uint32_t len)
+{
+	uint64_t	key = 0;
+
+	switch (cc->vclass)
+	{
+		case VCLASS__BOOL:
+			return (uint64_t)*addr;
+		case VCLASS__INT:
+			{
+				int64_t		ival;
+
+				switch (cc->unitsz)
+				{
+					case 1:  ival = *((const int8_t *)addr); break;
+					case 2:  ival = *((const int16_t *)addr); break;
+					case 4:  ival = *((const int32_t *)addr); break;
+					default: memcpy(&ival, addr, sizeof(int64_t)); break;
+				}
+				return (uint64_t)ival ^ (1UL << 63);
+			}
+		case VCLASS__UINT:
+			memcpy(&key, addr, cc->unitsz);
+			return key;
+		case VCLASS__FLOAT16:
+		case VCLASS__FLOAT32:
+			{
+				float		fval;
+				uint32_t	bits;
+
+				if (cc->vclass == VCLASS__FLOAT16)
+				{
+					half_t	hval;
+
+					memcpy(&hval, addr, sizeof(half_t));
+					fval = fp16_to_fp32(hval);
+				}
+				else
+					memcpy(&fval, addr, sizeof(float));
+				memcpy(&bits, &fval, sizeof(uint32_t));
+				if ((bits & 0x80000000U) != 0)
+					bits = ~bits;
+				else
+					bits |= 0x80000000U;
+				return (uint64_t)bits;
+			}
+		case VCLASS__FLOAT64:
+			memcpy(&key, addr, sizeof(uint64_t));
+			if ((key & (1UL << 63)) != 0)
+				key = ~key;
+			else
+				key |= (1UL << 63);
+			return key;
+		case VCLASS__INT128:
+			{
+				int128_t	ival;
+
+				memcpy(&ival, addr, sizeof(int128_t));
+				if (ival > (int128_t)INT64_MAX)
+					ival = INT64_MAX;
+				else if (ival < (int128_t)INT64_MIN)
+					ival = INT64_MIN;
+				return (uint64_t)((int64_t)ival) ^ (1UL << 63);
+			}
+		default:
+			{
+				/* big-endian prefix of the binary keeps memcmp() order */
+				const uint8_t *pos = (const uint8_t *)addr;
+				int		i;
+
+				for (i=0; i < sizeof(uint64_t); i++)
+				{
+					key <<= 8;
+					if (i < len)
+						key |= pos[i];
+				}
+				return key;
+			}
+	}
+}
+
+/*
+ * buildCompactRows - setup the compactRow array, then sort it if needed
+ */
+static int
+__compareCompactRowBySortKeys(const void *__a, const void *__b)
+{
+	const compactRow *a = __a;
+	const compactRow *b = __b;
+	int		k, rv;
+
+	for (k=0; k < compact_num_keys; k++)
+	{
+		const compactColumn *cc = compact_keys[k];
+		const char *a_addr, *b_addr;
+		uint32_t	a_len = 0, b_len = 0;
+
+		a_addr = __fetchColumnValue(cc, &compact_batches[a->rb_id], a->row_id, &a_len);
+		b_addr = __fetchColumnValue(cc, &compact_batches[b->rb_id], b->row_id, &b_len);
+		/* NULLs are sorted last */
+		if (!a_addr || !b_addr)
+		{
+			if (a_addr)
+				return -1;
+			if (b_addr)
+				return 1;
+			continue;
+		}
+		rv = __compareColumnValue(cc, a_addr, a_len, b_addr, b_len);
+		if (rv != 0)
+			return rv;
+	}
+	/* keeps the original order for the equivalent rows */
+	if (a->rb_id != b->rb_id)
+		return (a->rb_id < b->rb_id ? -1 : 1);
+	if (a->row_id != b->row_id)
+		return (a->row_id < b->row_id ? -1 : 1);
+	return 0;
+}
+
+static int
+__compareCompactRowByZOrder(const void *__a, const void *__b)
+{
+	const compactRow *a = __a;
+	const compactRow *b = __b;
+
+	if (a->zkey != b->zkey)
+		return (a->zkey < b->zkey ? -1 : 1);
+	if (a->rb_id != b->rb_id)
+		return (a->rb_id < b->rb_id ? -1 : 1);
+	if (a->row_id != b->row_id)
+		return (a->row_id < b->row_id ? -1 : 1);
+	return 0;
+}
+
+static void
+__buildCompactRowsZOrder(void)
+{
+	int			nbits = 64 / compact_num_keys;
+	uint64_t	mask = (nbits >= 64 ? ~0UL : (1UL << nbits) - 1);
+	uint64_t	i;
+	int			k, b;
+
+	/* 1st pass - range of the ordered keys */
+	for (k=0; k < compact_num_keys; k++)
+	{
+		compact_keys[k]->zorder_min = ~0UL;
+		compact_keys[k]->zorder_max = 0;
+	}
+	for (i=0; i < compact_num_rows; i++)
+	{
+		compactRow *row = &compact_rows[i];
+
+		for (k=0; k < compact_num_keys; k++)
+		{
+			compactColumn *cc = compact_keys[k];
+			const char *addr;
+			uint32_t	len;
+			uint64_t	key;
+
+			addr = __fetchColumnValue(cc, &compact_batches[row->rb_id],
+									  row->row_id, &len);
+			if (!addr)
+				continue;
+			key = __zorderOrderedKey(cc, addr, len);
+			cc->zorder_min = Min(cc->zorder_min, key);
+			cc->zorder_max = Max(cc->zorder_max, key);
+		}
+	}
+	/* 2nd pass - interleave the normalized keys into the Z-order key */
+	for (i=0; i < compact_num_rows; i++)
+	{
+		compactRow *row = &compact_rows[i];
+		uint64_t	scaled[64];
+		uint64_t	zkey = 0;
+
+		for (k=0; k < compact_num_keys; k++)
+		{
+			compactColumn *cc = compact_keys[k];
+			const char *addr;
+			uint32_t	len;
+			uint64_t	key;
+
+			addr = __fetchColumnValue(cc, &compact_batches[row->rb_id],
+									  row->row_id, &len);
+			if (!addr)
+				scaled[k] = mask;		/* NULLs are located last */
+			else if (cc->zorder_max <= cc->zorder_min)
+				scaled[k] = 0;
+			else
+			{
+				key = __zorderOrderedKey(cc, addr, len) - cc->zorder_min;
+				scaled[k] = (uint64_t)(((uint128_t)key * (uint128_t)mask) /
+									   (uint128_t)(cc->zorder_max -
+												   cc->zorder_min));
+			}
+		}
+		for (b=nbits-1; b >= 0; b--)
+		{
+			for (k=0; k < compact_num_keys; k++)
+				zkey = (zkey << 1) | ((scaled[k] >> b) & 1);
+		}
+		row->zkey = zkey;
+	}
+	qsort(compact_rows, compact_num_rows, sizeof(compactRow),
+		  __compareCompactRowByZOrder);
+}
+
+static void
+buildCompactRows(void)
+{
+	uint64_t	nrows = 0;
+	int			i;
+
+	for (i=0; i < compact_num_batches; i++)
+		nrows += compact_batches[i].rbatch->length;
+	compact_rows = palloc(sizeof(compactRow) * Max(nrows, 1));
+	for (i=0; i < compact_num_batches; i++)
+	{
+		int64_t		j, length = compact_batches[i].rbatch->length;
+
+		for (j=0; j < length; j++)
+		{
+			compactRow *row = &compact_rows[compact_num_rows++];
+
+			row->zkey = 0;
+			row->rb_id = i;
+			row->row_id = j;
+		}
+	}
+	assert(compact_num_rows == nrows);
+
+	if (compact_num_keys == 0)
+		return;		/* keep the original order */
+	if (zorder_key_columns)
+		__buildCompactRowsZOrder();
+	else
+		qsort(compact_rows, compact_num_rows, sizeof(compactRow),
+			  __compareCompactRowBySortKeys);
+}
+
+/*
+ * setupCompactKeys - parse --sort-by or --zorder option
+ */
+static void
+setupCompactKeys(void)
+{
+	const char *optname;
+	char	   *buffer;
+	char	   *name, *pos;
+
+	if (sort_key_columns)
+	{
+		optname = "--sort-by";
+		buffer = alloca(strlen(sort_key_columns) + 1);
+		strcpy(buffer, sort_key_columns);
+	}
+	else if (zorder_key_columns)
+	{
+		optname = "--zorder";
+		buffer = alloca(strlen(zorder_key_columns) + 1);
+		strcpy(buffer, zorder_key_columns);
+	}
+	else
+		return;
+
+	compact_keys = palloc0(sizeof(compactColumn *) * compact_num_columns);
+	for (name = strtok_r(buffer, ",", &pos);
+		 name != NULL;
+		 name = strtok_r(NULL, ",", &pos))
+	{
+		compactColumn *cc = lookupCompactColumn(__trim(name), optname);
+		int		k;
+
+		for (k=0; k < compact_num_keys; k++)
+		{
+			if (compact_keys[k] == cc)
+				Elog("field [%s] appeared twice in %s option",
+					 cc->field->name, optname);
+		}
+		compact_keys[compact_num_keys++] = cc;
+	}
+	if (compact_num_keys == 0)
+		Elog("no columns are given by %s option", optname);
+	if (zorder_key_columns && compact_num_keys > 16)
+		Elog("too many columns (%d) are given by --zorder option",
+			 compact_num_keys);
+}
+
+/*
+ * write_XXX_stat
+ */
+static int
+write_int8_stat(SQLfield *attr, char *buf, size_t len,
+				const SQLstat__datum *datum)
+{
+	return snprintf(buf, len, "%d", (int32_t)datum->i8);
+}
+
+static int
+write_int16_stat(SQLfield *attr, char *buf, size_t len,
+				 const SQLstat__datum *datum)
+{
+	return snprintf(buf, len, "%d", (int32_t)datum->i16);
+}
+
+static int
+write_int32_stat(SQLfield *attr, char *buf, size_t len,
+				 const SQLstat__datum *datum)
+{
+	return snprintf(buf, len, "%d", datum->i32);
+}
+
+static int
+write_int64_stat(SQLfield *attr, char *buf, size_t len,
+				 const SQLstat__datum *datum)
+{
+	return snprintf(buf, len, "%ld", datum->i64);
+}
+
+static int
+write_uint8_stat(SQLfield *attr, char *buf, size_t len,
+				 const SQLstat__datum *datum)
+{
+	return snprintf(buf, len, "%u", (uint32_t)datum->u8);
+}
+
+static int
+write_uint16_stat(SQLfield *attr, char *buf, size_t len,
+				  const SQLstat__datum *datum)
+{
+	return snprintf(buf, len, "%u", (uint32_t)datum->u16);
+}
+
+static int
+write_uint32_stat(SQLfield *attr, char *buf, size_t len,
+				  const SQLstat__datum *datum)
+{
+	return snprintf(buf, len, "%u", (uint32_t)datum->u32);
+}
+
+static int
+write_uint64_stat(SQLfield *attr, char *buf, size_t len,
+				  const SQLstat__datum *datum)
+{
+	return snprintf(buf, len, "%lu", (uint64_t)datum->u64);
+}
+
+static int
+write_float16_stat(SQLfield *attr, char *buf, size_t len,
+				   const SQLstat__datum *datum)
+{
+	return snprintf(buf, len, "%u", (uint32_t)datum->u16);
+}
+
+static int
+write_int128_stat(SQLfield *attr, char *buf, size_t len,
+				  const SQLstat__datum *datum)
+{
+	int128_t	ival = datum->i128;
+	uint128_t	uval;
+	char		temp[64];
+	char	   *pos = temp + sizeof(temp) - 1;
+
+	uval = (ival < 0 ? -((uint128_t)ival) : (uint128_t)ival);
+	*pos = '\0';
+	do {
+		*--pos = ('0' + (int)(uval % 10));
+		uval /= 10;
+	} while (uval != 0);
+
+	return snprintf(buf, len, "%s%s", (ival < 0 ? "-" : ""), pos);
+}
+
+static void
+__assignWriteStatHandler(SQLfield *column, const compactColumn *cc)
+{
+	switch (cc->vclass)
+	{
+		case VCLASS__INT:
+		case VCLASS__FLOAT32:
+		case VCLASS__FLOAT64:
+			/* floating point values are written as bit-patterns */
+			switch (cc->unitsz)
+			{
+				case 1:  column->write_stat = write_int8_stat;  break;
+				case 2:  column->write_stat = write_int16_stat; break;
+				case 4:  column->write_stat = write_int32_stat; break;
+				default: column->write_stat = write_int64_stat; break;
+			}
+			break;
+		case VCLASS__UINT:
+			switch (cc->unitsz)
+			{
+				case 1:  column->write_stat = write_uint8_stat;  break;
+				case 2:  column->write_stat = write_uint16_stat; break;
+				case 4:  column->write_stat = write_uint32_stat; break;
+				default: column->write_stat = write_uint64_stat; break;
+			}
+			break;
+		case VCLASS__FLOAT16:
+			column->write_stat = write_float16_stat;
+			break;
+		case VCLASS__INT128:
+			column->write_stat = write_int128_stat;
+			break;
+		default:
+			column->write_stat = NULL;	/* not supported */
+			break;
+	}
+}
+
+/*
+ * __fieldHasCustomMetadata
+ */
+static bool
+__fieldHasCustomMetadata(const ArrowField *field, const char *key)
+{
+	int		k;
+
+	for (k=0; k < field->_num_custom_metadata; k++)
+	{
+		if (strcmp(field->custom_metadata[k].key, key) == 0)
+			return true;
+	}
+	return false;
+}
+
+/*
+ * setupOutputTable
+ */
+static SQLtable *
+setupOutputTable(void)
+{
+	static const char *regenerated_keys[] = {
+		"min_values", "max_values",
+		"zone_min_values", "zone_max_values", "zone_nrows",
+		"bloom_nhashes", "bloom_filters", NULL
+	};
+	ArrowSchema *schema = &arrow_files[0].footer.schema;
+	SQLtable   *table;
+	int			j, k;
+
+	table = palloc0(offsetof(SQLtable, columns[compact_num_columns]));
+	table->filename = output_filename;
+	table->fdesc = -1;
+	table->segment_sz = batch_segment_sz;
+	table->nfields = compact_num_columns;
+	table->numFieldNodes = compact_num_columns;
+	table->numBuffers = compact_num_buffers;
+	table->customMetadata = schema->custom_metadata;
+	table->numCustomMetadata = schema->_num_custom_metadata;
+
+	for (j=0; j < compact_num_columns; j++)
+	{
+		compactColumn *cc = &compact_columns[j];
+		ArrowField *field = cc->field;
+		SQLfield   *column = &table->columns[j];
+
+		column->field_name = pstrdup(field->name);
+		column->arrow_type = field->type;
+		__assignWriteStatHandler(column, cc);
+		/* copy the custom metadata, except for the ones regenerated */
+		if (field->_num_custom_metadata > 0)
+		{
+			column->customMetadata = palloc0(sizeof(ArrowKeyValue) *
+											 field->_num_custom_metadata);
+			for (k=0; k < field->_num_custom_metadata; k++)
+			{
+				ArrowKeyValue *kv = &field->custom_metadata[k];
+				int		i;
+
+				for (i=0; regenerated_keys[i] != NULL; i++)
+				{
+					if (strcmp(kv->key, regenerated_keys[i]) == 0)
+						break;
+				}
+				if (regenerated_keys[i] == NULL)
+					column->customMetadata[column->numCustomMetadata++] = *kv;
+			}
+		}
+	}
+	return table;
+}
+
+/*
+ * enable_embedded_stats
+ */
+static bool
+__enable_field_stats(SQLfield *field)
+{
+	field->stat_enabled = (field->write_stat != NULL);
+	memset(&field->stat_datum, 0, sizeof(SQLstat));
+	field->stat_list = NULL;
+	field->zone_list = NULL;
+
+	return field->stat_enabled;
+}
+
+static void
+enable_embedded_stats(SQLtable *table)
+{
+	char	   *buffer;
+	char	   *name, *pos;
+	int			j, k;
+
+	if (!stat_embedded_columns)
+	{
+		if (!stat_embedded_default)
+			return;
+		/*
+		 * By the default, min/max statistics are embedded on the columns
+		 * that had statistics in the source, and on the sort keys.
+		 */
+		for (j=0; j < table->nfields; j++)
+		{
+			compactColumn *cc = &compact_columns[j];
+			bool	enabled = __fieldHasCustomMetadata(cc->field, "min_values");
+
+			for (k=0; !enabled && k < compact_num_keys; k++)
+			{
+				if (compact_keys[k] == cc)
+					enabled = true;
+			}
+			if (enabled && __enable_field_stats(&table->columns[j]))
+				table->has_statistics = true;
+		}
+		return;
+	}
+
+	/* special case - all available columns? */
+	if (strcmp(stat_embedded_columns, "*") == 0)
+	{
+		for (j=0; j < table->nfields; j++)
+		{
+			if (__enable_field_stats(&table->columns[j]))
+				table->has_statistics = true;
+		}
+		return;
+	}
+
+	/* elsewhere, enables stat for each column specified */
+	buffer = alloca(strlen(stat_embedded_columns) + 1);
+	strcpy(buffer, stat_embedded_columns);
+	for (name = strtok_r(buffer, ",", &pos);
+		 name != NULL;
+		 name = strtok_r(NULL, ",", &pos))
+	{
+		compactColumn *cc = lookupCompactColumn(__trim(name), "--stat");
+		SQLfield   *field = &table->columns[cc - compact_columns];
+
+		if (!__enable_field_stats(field))
+			Elog("field [%s; %s] does not support min/max statistics",
+				 field->field_name, arrowNodeName(&field->arrow_type.node));
+		table->has_statistics = true;
+	}
+}
+
+/*
+ * enable_bloom_filters
+ */
+static bool
+__enable_field_bloom(SQLfield *field)
+{
+	switch (field->arrow_type.node.tag)
+	{
+		case ArrowNodeTag__Int:
+		case ArrowNodeTag__Date:
+		case ArrowNodeTag__Time:
+		case ArrowNodeTag__Timestamp:
+		case ArrowNodeTag__FixedSizeBinary:
+		case ArrowNodeTag__Utf8:
+		case ArrowNodeTag__Binary:
+		case ArrowNodeTag__LargeUtf8:
+		case ArrowNodeTag__LargeBinary:
+			field->bloom_enabled = true;
+			field->bloom_list = NULL;
+			return true;
+		default:
+			break;
+	}
+	return false;
+}
+
+static void
+enable_bloom_filters(SQLtable *table)
+{
+	char	   *buffer;
+	char	   *name, *pos;
+	int			j;
+
+	if (!bloom_filter_columns)
+	{
+		/* By the default, keep bloom filters of the source */
+		for (j=0; j < table->nfields; j++)
+		{
+			if (__fieldHasCustomMetadata(compact_columns[j].field,
+										 "bloom_filters"))
+				__enable_field_bloom(&table->columns[j]);
+		}
+		return;
+	}
+	buffer = alloca(strlen(bloom_filter_columns) + 1);
+	strcpy(buffer, bloom_filter_columns);
+	for (name = strtok_r(buffer, ",", &pos);
+		 name != NULL;
+		 name = strtok_r(NULL, ",", &pos))
+	{
+		compactColumn *cc = lookupCompactColumn(__trim(name), "--bloom");
+		SQLfield   *field = &table->columns[cc - compact_columns];
+
+		if (!__enable_field_bloom(field))
+			Elog("field [%s; %s] does not support bloom filter",
+				 field->field_name, arrowNodeName(&field->arrow_type.node));
+	}
+}
+
+/*
+ * __appendColumnValue - moves a source value to the output column
+ */
+static void
+__updateFieldStat(SQLfield *column, const compactColumn *cc, const char *addr)
+{
+	SQLstat	   *st = &column->stat_datum;
+
+	if (!st->is_valid)
+	{
+		memcpy(&st->min, addr, cc->unitsz);
+		memcpy(&st->max, addr, cc->unitsz);
+		st->is_valid = true;
+	}
+	else
+	{
+		if (__compareColumnValue(cc, addr, cc->unitsz,
+								 (const char *)&st->min, cc->unitsz) < 0)
+			memcpy(&st->min, addr, cc->unitsz);
+		if (__compareColumnValue(cc, addr, cc->unitsz,
+								 (const char *)&st->max, cc->unitsz) > 0)
+			memcpy(&st->max, addr, cc->unitsz);
+	}
+}
+
+static size_t
+__appendColumnValue(SQLfield *column, const compactColumn *cc,
+					const compactBatch *cb, uint32_t row_id)
+{
+	size_t		row_index = column->nitems++;
+	const char *addr;
+	uint32_t	len;
+
+	addr = __fetchColumnValue(cc, cb, row_id, &len);
+	if (!addr)
+	{
+		column->nullcount++;
+		sql_buffer_clrbit(&column->nullmap, row_index);
+	}
+	else
+		sql_buffer_setbit(&column->nullmap, row_index);
+
+	switch (cc->vclass)
+	{
+		case VCLASS__BOOL:
+			if (addr && *addr)
+				sql_buffer_setbit(&column->values, row_index);
+			else
+				sql_buffer_clrbit(&column->values, row_index);
+			return __buffer_usage_inline_type(column);
+
+		case VCLASS__VARLENA:
+			{
+				uint32_t	offset;
+
+				if (row_index == 0)
+					sql_buffer_append_zero(&column->values, sizeof(uint32_t));
+				if (addr)
+					sql_buffer_append(&column->extra, addr, len);
+				offset = column->extra.usage;
+				sql_buffer_append(&column->values, &offset, sizeof(uint32_t));
+			}
+			return __buffer_usage_varlena_type(column);
+
+		case VCLASS__LARGE_VARLENA:
+			{
+				uint64_t	offset;
+
+				if (row_index == 0)
+					sql_buffer_append_zero(&column->values, sizeof(uint64_t));
+				if (addr)
+					sql_buffer_append(&column->extra, addr, len);
+				offset = column->extra.usage;
+				sql_buffer_append(&column->values, &offset, sizeof(uint64_t));
+			}
+			return __buffer_usage_varlena_type(column);
+
+		default:
+			if (!addr)
+				sql_buffer_append_zero(&column->values, cc->unitsz);
+			else
+			{
+				sql_buffer_append(&column->values, addr, cc->unitsz);
+				if (column->stat_enabled)
+					__updateFieldStat(column, cc, addr);
+			}
+			return __buffer_usage_inline_type(column);
+	}
+}
+
+/*
+ * writeCompactRecordBatches
+ */
+static void
+__writeCompactRecordBatch(SQLtable *table)
+{
+	ArrowBlock	block;
+	int			rb_index;
+
+	rb_index = writeArrowRecordBatch(table, &block);
+	if (shows_progress)
+		printf("%s: record batch %d written (offset=%ld, length=%ld, nrows=%zu)\n",
+			   table->filename, rb_index,
+			   block.offset, block.metaDataLength + block.bodyLength,
+			   table->nitems);
+	sql_table_clear(table);
+}
+
+static void
+writeCompactRecordBatches(SQLtable *table)
+{
+	uint64_t	i;
+	int			j;
+
+	for (i=0; i < compact_num_rows; i++)
+	{
+		compactRow *row = &compact_rows[i];
+		compactBatch *cb = &compact_batches[row->rb_id];
+		size_t		usage = 0;
+
+		for (j=0; j < table->nfields; j++)
+			usage += __appendColumnValue(&table->columns[j],
+										 &compact_columns[j],
+										 cb, row->row_id);
+		table->nitems++;
+		table->usage = usage;
+		if (table->usage >= table->segment_sz || table->nitems >= INT_MAX)
+			__writeCompactRecordBatch(table);
+	}
+	if (table->nitems > 0)
+		__writeCompactRecordBatch(table);
+}
+
+/*
+ * setupCompactBatches - checks the source files, then setup compactBatch
+ */
+static const char *
+mmapArrowFile(ArrowFileInfo *af_info, int fdesc)
+{
+	static long	__PAGE_SIZE = -1;
+	size_t		file_sz = af_info->stat_buf.st_size;
+	size_t		mmap_sz;
+	char	   *mmap_head;
+
+	if (__PAGE_SIZE < 0)
+		__PAGE_SIZE = sysconf(_SC_PAGESIZE);
+	mmap_sz = (file_sz + __PAGE_SIZE - 1) & ~(__PAGE_SIZE - 1);
+	mmap_head = mmap(NULL, mmap_sz, PROT_READ, MAP_SHARED, fdesc, 0);
+	if (mmap_head == MAP_FAILED)
+		Elog("failed on mmap: %m");
+	return mmap_head;
+}
+
+static void
+setupCompactBatches(ArrowFileInfo *af_info, int fdesc)
+{
+	const char *mmap_head = mmapArrowFile(af_info, fdesc);
+	int			i, nitems = af_info->footer._num_recordBatches;
+
+	compact_batches = repalloc(compact_batches, sizeof(compactBatch) *
+							   (compact_num_batches + nitems + 1));
+	for (i=0; i < nitems; i++)
+	{
+		ArrowBlock *block = &af_info->footer.recordBatches[i];
+		ArrowRecordBatch *rbatch = &af_info->recordBatches[i].body.recordBatch;
+		compactBatch *cb;
+
+		if (rbatch->compression)
+			Elog("record batch %d of '%s' is compressed; not supported",
+				 i, af_info->filename);
+		if (rbatch->_num_nodes != compact_num_columns ||
+			rbatch->_num_buffers != compact_num_buffers)
+			Elog("record batch %d of '%s' has unexpected number of field-nodes (%d) or buffers (%d)",
+				 i, af_info->filename,
+				 rbatch->_num_nodes, rbatch->_num_buffers);
+		if (rbatch->length == 0)
+			continue;
+		if (rbatch->length > UINT_MAX)
+			Elog("record batch %d of '%s' is too large (nrows=%ld)",
+				 i, af_info->filename, rbatch->length);
+		cb = &compact_batches[compact_num_batches++];
+		cb->filename = af_info->filename;
+		cb->rb_chunk = mmap_head + block->offset + block->metaDataLength;
+		cb->rbatch = rbatch;
+	}
+}
+
+static void
+usage(void)
+{
+	fputs("Usage:\n"
+		  "  arrowcompact [OPTION] -o FILENAME <file1> [<file2> ...]\n\n"
+		  "General options:\n"
+		  "  -o, --output=FILENAME result file in Apache Arrow format\n"
+		  "                       (must not be one of the source files)\n"
+		  "      --sort-by=COLUMNS sorts the rows by the COLUMNS in ascending\n"
+		  "                       order, NULLs last.\n"
+		  "      --zorder=COLUMNS sorts the rows by the Z-order curve of the\n"
+		  "                       COLUMNS, for multi-column range filters.\n"
+		  "      (--sort-by and --zorder are exclusive. If neither of them\n"
+		  "       are given, the rows are kept in the original order.)\n"
+		  "  -S, --stat[=COLUMNS] embeds min/max statistics for each record batch\n"
+		  "                       COLUMNS is a comma-separated list of the target\n"
+		  "                       columns if partially enabled.\n"
+		  "                       (default: columns with statistics in the source\n"
+		  "                        files, and the sort keys)\n"
+		  "      --no-stat        does not embed min/max statistics\n"
+		  "      --bloom=COLUMNS  embeds bloom filters for each record batch\n"
+		  "                       COLUMNS is a comma-separated list of the target\n"
+		  "                       columns for equality lookup.\n"
+		  "                       (default: columns with bloom filters in the\n"
+		  "                        source files)\n"
+		  "      --compress=CODEC[:LEVEL] compress record batches using CODEC\n"
+		  "                       (lz4 or zstd) with compression LEVEL.\n"
+		  "\n"
+		  "Arrow format options:\n"
+		  "  -s, --segment-size=SIZE size of record batch for each\n"
+		  "                       (default: 256MB)\n"
+		  "\n"
+		  "Other options:\n"
+		  "      --progress       shows progress of the job\n"
+		  "      --help           shows this message\n"
+		  "\n"
+		  "Report bugs to <pgstrom@heterodb.com>.\n",
+		  stderr);
+	exit(1);
+}
+
+static void
+parse_options(int argc, char * const argv[])
+{
+	static struct option long_options[] = {
+		{"output",       required_argument, NULL, 'o'},
+		{"segment-size", required_argument, NULL, 's'},
+		{"sort-by",      required_argument, NULL, 1000},
+		{"zorder",       required_argument, NULL, 1001},
+		{"stat",         optional_argument, NULL, 'S'},
+		{"no-stat",      no_argument,       NULL, 1002},
+		{"bloom",        required_argument, NULL, 1003},
+		{"compress",     required_argument, NULL, 1004},
+		{"progress",     no_argument,       NULL, 1005},
+		{"help",         no_argument,       NULL, 9999},
+		{NULL, 0, NULL, 0},
+	};
+	int			c;
+
+	while ((c = getopt_long(argc, argv, "o:s:S::",
+							long_options, NULL)) >= 0)
+	{
+		switch (c)
+		{
+			case 'o':
+				if (output_filename)
+					Elog("-o option was supplied twice");
+				output_filename = optarg;
+				break;
+
+			case 's':
+				if (batch_segment_sz != 0)
+					Elog("-s option was supplied twice");
+				else
+				{
+					char   *end;
+					long	sz = strtoul(optarg, &end, 10);
+
+					if (sz == 0)
+						Elog("not a valid segment size: %s", optarg);
+					else if (*end == '\0')
+						batch_segment_sz = sz;
+					else if (strcasecmp(end, "k") == 0 ||
+							 strcasecmp(end, "kb") == 0)
+						batch_segment_sz = (sz << 10);
+					else if (strcasecmp(end, "m") == 0 ||
+							 strcasecmp(end, "mb") == 0)
+						batch_segment_sz = (sz << 20);
+					else if (strcasecmp(end, "g") == 0 ||
+							 strcasecmp(end, "gb") == 0)
+						batch_segment_sz = (sz << 30);
+					else
+						Elog("not a valid segment size: %s", optarg);
+				}
+				break;
+
+			case 1000:		/* --sort-by */
+				if (sort_key_columns)
+					Elog("--sort-by option was supplied twice");
+				if (zorder_key_columns)
+					Elog("--sort-by and --zorder are exclusive");
+				sort_key_columns = optarg;
+				break;
+
+			case 1001:		/* --zorder */
+				if (zorder_key_columns)
+					Elog("--zorder option was supplied twice");
+				if (sort_key_columns)
+					Elog("--sort-by and --zorder are exclusive");
+				zorder_key_columns = optarg;
+				break;
+
+			case 'S':		/* --stat */
+				if (stat_embedded_columns)
+					Elog("--stat option was supplied twice");
+				if (!stat_embedded_default)
+					Elog("--stat and --no-stat are exclusive");
+				if (optarg)
+					stat_embedded_columns = optarg;
+				else
+					stat_embedded_columns = "*";
+				break;
+
+			case 1002:		/* --no-stat */
+				if (stat_embedded_columns)
+					Elog("--stat and --no-stat are exclusive");
+				stat_embedded_default = false;
+				break;
+
+			case 1003:		/* --bloom */
+				if (bloom_filter_columns)
+					Elog("--bloom option was supplied twice");
+				bloom_filter_columns = optarg;
+				break;
+
+			case 1004:		/* --compress */
+				if (compression_spec)
+					Elog("--compress option was supplied twice");
+				compression_spec = optarg;
+				break;
+
+			case 1005:		/* --progress */
+				shows_progress = 1;
+				break;
+
+			case 9999:		/* --help */
+			default:
+				usage();
+				break;
+		}
+	}
+	if (!output_filename)
+		Elog("-o, --output=FILENAME option is required");
+	if (optind >= argc)
+		Elog("no input arrow files given");
+	if (batch_segment_sz == 0)
+		batch_segment_sz = (1UL << 28);		/* 256MB in default */
+}
+
+int
+main(int argc, char * const argv[])
+{
+	struct stat	stat_buf;
+	bool		output_exists;
+	SQLtable   *table;
+	int			i, j, fdesc;
+
+	parse_options(argc, argv);
+	output_exists = (stat(output_filename, &stat_buf) == 0);
+
+	/* open the source files */
+	arrow_num_files = argc - optind;
+	arrow_files = palloc0(sizeof(ArrowFileInfo) * arrow_num_files);
+	for (i=0; i < arrow_num_files; i++)
+	{
+		const char *filename = argv[optind + i];
+		ArrowFileInfo *af_info = &arrow_files[i];
+
+		fdesc = open(filename, O_RDONLY);
+		if (fdesc < 0)
+			Elog("failed on open('%s'): %m", filename);
+		readArrowFileDesc(fdesc, af_info);
+		af_info->filename = filename;
+		if (af_info->stream_length > 0)
+			Elog("'%s' is Arrow IPC stream; only Arrow files are supported",
+				 filename);
+		if (output_exists &&
+			af_info->stat_buf.st_dev == stat_buf.st_dev &&
+			af_info->stat_buf.st_ino == stat_buf.st_ino)
+			Elog("output file '%s' is identical to the source file '%s'",
+				 output_filename, filename);
+		if (af_info->footer._num_dictionaries > 0)
+			Elog("'%s' has dictionary batches; not supported", filename);
+
+		if (i == 0)
+		{
+			ArrowSchema *schema = &af_info->footer.schema;
+
+			compact_num_columns = schema->_num_fields;
+			compact_columns = palloc0(sizeof(compactColumn) *
+									  Max(compact_num_columns, 1));
+			for (j=0; j < compact_num_columns; j++)
+			{
+				compact_num_buffers += setupCompactColumn(&compact_columns[j],
+														  &schema->fields[j],
+														  j, compact_num_buffers);
+			}
+		}
+		else
+		{
+			/* check schema compatibility, if multiple source files */
+			ArrowFileInfo  *a = &arrow_files[0];
+			ArrowFileInfo  *b = &arrow_files[i];
+
+			if (a->footer.schema._num_fields != b->footer.schema._num_fields)
+				Elog("Arrow file '%s' and '%s' has different number of the fields",
+					 a->filename,
+					 b->filename);
+			for (j=0; j < a->footer.schema._num_fields; j++)
+			{
+				if (!arrowFieldTypeIsEqual(&a->footer.schema.fields[j],
+										   &b->footer.schema.fields[j]))
+					Elog("Arrow file '%s' and '%s' has incompatible column",
+						 a->filename,
+						 b->filename);
+
+				if (strcmp(a->footer.schema.fields[j].name,
+						   b->footer.schema.fields[j].name) != 0)
+					fprintf(stderr, "warning: column name '%s' in '%s' is not identical '%s' of '%s'\n",
+							a->footer.schema.fields[j].name,
+							a->filename,
+							b->footer.schema.fields[j].name,
+							b->filename);
+			}
+		}
+		setupCompactBatches(af_info, fdesc);
+	}
+	setupCompactKeys();
+	buildCompactRows();
+
+	/* setup and open the output file */
+	table = setupOutputTable();
+	enable_embedded_stats(table);
+	enable_bloom_filters(table);
+	if (compression_spec)
+		setupArrowBodyCompression(table, compression_spec,
+								  Max(sysconf(_SC_NPROCESSORS_ONLN), 1));
+	fdesc = open(output_filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fdesc < 0)
+		Elog("failed on open('%s'): %m", output_filename);
+	table->fdesc = fdesc;
+	/* write out header stuff */
+	arrowFileWrite(table, "ARROW1\0\0", 8);
+	writeArrowSchema(table);
+	/* write out record batches */
+	writeCompactRecordBatches(table);
+	/* write out footer stuff */
+	writeArrowFooter(table);
+	if (shows_progress)
+		printf("%s: %lu rows in %d record batches from %d files were compacted to %d record batches\n",
+			   output_filename, compact_num_rows,
+			   compact_num_batches, arrow_num_files,
+			   table->numRecordBatches);
+	close(fdesc);
+
+	return 0;
+}
+
+/*
+ * memory allocation handlers
+ */
+void *
+palloc(size_t sz)
+{
+	void   *ptr = malloc(sz);
+
+	if (!ptr)
+		Elog("out of memory");
+	return ptr;
+}
+
+void *
+palloc0(size_t sz)
+{
+	void   *ptr = malloc(sz);
+
+	if (!ptr)
+		Elog("out of memory");
+	memset(ptr, 0, sz);
+	return ptr;
+}
+
+char *
+pstrdup(const char *str)
+{
+	char   *ptr = strdup(str);
+
+	if (!ptr)
+		Elog("out of memory");
+	return ptr;
+}
+
+void *
+repalloc(void *old, size_t sz)
+{
+	char   *ptr = realloc(old, sz);
+
+	if (!ptr)
+		Elog("out of memory");
+	return ptr;
+}
+
+void
+pfree(void *ptr)
+{
+	free(ptr);
+}
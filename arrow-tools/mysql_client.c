@@ -1243,6 +1243,53 @@ sqldb_fetch_results(void *sqldb_state, SQLtable *table)
 	return true;
 }
 
+/*
+ * sqldb_fetch_key_range - min/max of the integer key for --split-key
+ */
+bool
+sqldb_fetch_key_range(void *sqldb_state,
+					  const char *table_name,
+					  const char *key_name,
+					  int64_t *p_key_min,
+					  int64_t *p_key_max)
+{
+	MYSTATE	   *mystate = (MYSTATE *)sqldb_state;
+	MYSQL	   *conn = mystate->conn;
+	MYSQL_RES  *res;
+	MYSQL_ROW	row;
+	char	   *query;
+	char	   *end;
+	bool		retval = false;
+
+	query = alloca(strlen(table_name) + 2 * strlen(key_name) + 100);
+	sprintf(query, "SELECT MIN(%s), MAX(%s) FROM %s",
+			key_name, key_name, table_name);
+	if (mysql_query(conn, query) != 0)
+		Elog("failed on mysql_query('%s'): %s",
+			 query, mysql_error(conn));
+	res = mysql_store_result(conn);
+	if (!res)
+		Elog("failed on mysql_store_result: %s", mysql_error(conn));
+	if (mysql_num_fields(res) != 2 ||
+		mysql_num_rows(res) != 1)
+		Elog("unexpected query result for '%s'", query);
+	row = mysql_fetch_row(res);
+	if (row[0] && row[1])
+	{
+		errno = 0;
+		*p_key_min = strtoll(row[0], &end, 10);
+		if (*end != '\0' || errno != 0)
+			Elog("--split-key must be an integer column: %s", key_name);
+		*p_key_max = strtoll(row[1], &end, 10);
+		if (*end != '\0' || errno != 0)
+			Elog("--split-key must be an integer column: %s", key_name);
+		retval = true;
+	}
+	mysql_free_result(res);
+
+	return retval;
+}
+
 void
 sqldb_close_connection(void *sqldb_state)
 {
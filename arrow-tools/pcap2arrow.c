@@ -66,7 +66,10 @@ static bool				enable_direct_io = false;
 static bool				no_payload = false;
 static bool				composite_options = false;
 static int				print_stat_interval = -1;
+static int				async_write_depth = 0;
 static bool				enable_interface_id = false;	/* for PCAP-NG */
+static char			   *bloom_filter_columns = NULL;
+static char			   *compression_spec = NULL;
 static __thread uint32_t *current_interface_id = NULL;	/* for PCAP-NG */
 
 /*
@@ -95,6 +98,33 @@ static bool			   *arrow_workers_completed;
 static SQLtable		  **arrow_chunks_array;			/* chunk buffer per-thread */
 static sem_t			pcap_worker_sem;
 
+/*
+ * chunkQueue - single-producer / single-consumer queue of chunks
+ *
+ * The 'sem' counts the number of queued chunks, so the consumer is blocked
+ * only when the queue is empty. Both of head and tail are updated only by
+ * one side, thus no lock is needed.
+ */
+#define CHUNK_QUEUE_SIZE		16
+#define ASYNC_WRITE_DEPTH_MAX	(CHUNK_QUEUE_SIZE - 1)
+typedef struct
+{
+	SQLtable   *items[CHUNK_QUEUE_SIZE];
+	uint32_t	head;		/* updated by the consumer */
+	uint32_t	tail;		/* updated by the producer */
+	sem_t		sem;
+} chunkQueue;
+
+/* asynchronous writer for each capture thread (--async-write) */
+typedef struct
+{
+	pthread_t	thread;
+	long		worker_id;
+	chunkQueue	pending;	/* capture thread -> writer thread */
+	chunkQueue	freed;		/* writer thread -> capture thread */
+} arrowAsyncWriter;
+static arrowAsyncWriter *arrow_async_writers = NULL;
+
 /* static variable for PF-RING capture mode */
 static pfring		  **pfring_desc_array = NULL;
 static uint64_t			pfring_desc_selector = 0;
@@ -1380,6 +1410,8 @@ handlePacketPayload(SQLtable *chunk, const u_char *buf, size_t sz)
 	chunk->usage += usage;
 }
 
+static void		arrowPcapEnableBloomFilters(SQLtable *table);
+
 /*
  * arrowOpenOutputFile
  */
@@ -1489,6 +1521,7 @@ retry:
 	outfd->table.fdesc = fdesc;
 	outfd->table.filename = pstrdup(path);
 	arrowPcapSchemaInit(&outfd->table);
+	arrowPcapEnableBloomFilters(&outfd->table);
 
 	/* Write Header */
 	arrowFileWrite(&outfd->table, "ARROW1\0\0", 8);
@@ -1507,6 +1540,41 @@ retry:
 	return outfd;
 }
 
+/*
+ * arrowPcapEnableBloomFilters
+ */
+static void
+arrowPcapEnableBloomFilters(SQLtable *table)
+{
+	char	   *buffer;
+	char	   *name, *pos;
+
+	if (!bloom_filter_columns)
+		return;
+	buffer = alloca(strlen(bloom_filter_columns) + 1);
+	strcpy(buffer, bloom_filter_columns);
+	for (name = strtok_r(buffer, ",", &pos);
+		 name != NULL;
+		 name = strtok_r(NULL, ",", &pos))
+	{
+		bool	found = false;
+
+		for (int j=0; j < table->nfields; j++)
+		{
+			SQLfield   *field = &table->columns[j];
+
+			if (strcmp(field->field_name, name) == 0)
+			{
+				field->bloom_enabled = true;
+				found = true;
+			}
+		}
+		if (!found)
+			Elog("field name [%s], specified by --bloom option, was not found",
+				 name);
+	}
+}
+
 /*
  * arrowCloseOutputFile
  */
@@ -1678,6 +1746,13 @@ arrowChunkWriteOut(SQLtable *chunk)
 		length = sizeof(ArrowBlock) * (outfd->table.numRecordBatches + 1);
 		outfd->table.recordBatches = repalloc(outfd->table.recordBatches, length);
 	}
+	for (int j=0; j < outfd->table.nfields; j++)
+	{
+		if (outfd->table.columns[j].bloom_enabled)
+			saveArrowRecordBatchBloom(&outfd->table.columns[j],
+									  &chunk->columns[j],
+									  outfd->table.numRecordBatches);
+	}
 	outfd->table.recordBatches[outfd->table.numRecordBatches++] = block;
 
 	Assert(outfd->refcnt > 0);
@@ -1836,6 +1911,122 @@ arrowMergeChunkWriteOut(SQLtable *dchunk, SQLtable *schunk)
 	}
 }
 
+/*
+ * chunkQueuePush / chunkQueuePop
+ */
+static void
+chunkQueuePush(chunkQueue *queue, SQLtable *chunk)
+{
+	uint32_t	tail = queue->tail;
+
+	Assert(tail - __atomic_load_n(&queue->head,
+								  __ATOMIC_ACQUIRE) < CHUNK_QUEUE_SIZE);
+	queue->items[tail % CHUNK_QUEUE_SIZE] = chunk;
+	__atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+	if (sem_post(&queue->sem) != 0)
+		Elog("failed on sem_post: %m");
+}
+
+static SQLtable *
+chunkQueuePop(chunkQueue *queue)
+{
+	uint32_t	head = queue->head;
+	SQLtable   *chunk;
+
+	while (sem_wait(&queue->sem) != 0)
+	{
+		if (errno != EINTR)
+			Elog("failed on sem_wait: %m");
+	}
+	Assert(head != __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE));
+	chunk = queue->items[head % CHUNK_QUEUE_SIZE];
+	__atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+
+	return chunk;
+}
+
+/*
+ * arrowChunkAlloc
+ */
+static SQLtable *
+arrowChunkAlloc(void)
+{
+	SQLtable   *chunk;
+
+	chunk = palloc0(offsetof(SQLtable,
+							 columns[PCAP_SCHEMA_MAX_NFIELDS]));
+	arrowPcapSchemaInit(chunk);
+	chunk->fdesc = -1;
+	if (compression_spec)
+		setupArrowBodyCompression(chunk, compression_spec,
+								  NCPUS / num_threads);
+	return chunk;
+}
+
+/*
+ * async_writer_main
+ */
+static void *
+async_writer_main(void *__arg)
+{
+	arrowAsyncWriter *aw = __arg;
+	SQLtable   *chunk;
+
+	worker_id = aw->worker_id;
+	while ((chunk = chunkQueuePop(&aw->pending)) != NULL)
+	{
+		arrowChunkWriteOut(chunk);
+		sql_table_clear(chunk);
+		chunkQueuePush(&aw->freed, chunk);
+	}
+	return NULL;
+}
+
+/*
+ * arrowChunkHandOff
+ *
+ * It writes out the filled chunk, then returns the chunk to be filled next.
+ * If --async-write, the filled chunk is handed to the writer thread, and
+ * the capture thread continues with a spare chunk; it is blocked only when
+ * all the spare chunks are under the write.
+ */
+static SQLtable *
+arrowChunkHandOff(SQLtable *chunk)
+{
+	arrowAsyncWriter *aw;
+
+	if (!arrow_async_writers)
+	{
+		arrowChunkWriteOut(chunk);
+		sql_table_clear(chunk);
+		return chunk;
+	}
+	aw = &arrow_async_writers[worker_id];
+	chunkQueuePush(&aw->pending, chunk);
+	chunk = chunkQueuePop(&aw->freed);
+	arrow_chunks_array[worker_id] = chunk;
+
+	return chunk;
+}
+
+/*
+ * arrowAsyncWriterShutdown
+ *
+ * It waits for completion of the pending chunks by the writer thread.
+ */
+static void
+arrowAsyncWriterShutdown(void)
+{
+	arrowAsyncWriter *aw;
+
+	if (!arrow_async_writers)
+		return;
+	aw = &arrow_async_writers[worker_id];
+	chunkQueuePush(&aw->pending, NULL);
+	if ((errno = pthread_join(aw->thread, NULL)) != 0)
+		Elog("failed on pthread_join: %m");
+}
+
 /*
  * __execCaptureOnePacket
  */
@@ -2069,8 +2260,9 @@ pfring_worker_main(void *__arg)
             Elog("failed on sem_post: %m");
 
 		if (status > 0)
-			arrowChunkWriteOut(chunk);
+			chunk = arrowChunkHandOff(chunk);
 	}
+	arrowAsyncWriterShutdown();
 	return final_merge_pending_chunks(chunk);
 }
 
@@ -2835,6 +3027,10 @@ usage(int status)
 		  "       opens multiple output files simultaneously (default: 1)\n"
 		  "     --chunk-size=SIZE : size of record batch (default: 128MB)\n"
 		  "     --direct-io : enables O_DIRECT for write-i/o\n"
+		  "     --async-write=N_CHUNKS\n"
+		  "       hands off the filled chunks to the writer threads, then\n"
+		  "       captures packets on N_CHUNKS spare chunks per capture\n"
+		  "       thread during the write (default: 0, valid only capturing mode)\n"
 		  "  -l|--limit=LIMIT : (default: no limit)\n"
 		  "  -p|--protocol=PROTO\n"
 		  "       PROTO is a comma separated string contains\n"
@@ -2850,6 +3046,11 @@ usage(int status)
 		  "       (default: none; valid only capturing mode)\n"
 		  "  -s|--stat=INTERVAL\n"
 		  "       enables to print statistics per INTERVAL\n"
+		  "     --bloom=COLUMNS\n"
+		  "       embeds bloom filters of the comma separated columns\n"
+		  "       for each record batch (e.g: src_addr,dst_addr)\n"
+		  "     --compress=CODEC[:LEVEL]\n"
+		  "       compress record batches using CODEC (lz4 or zstd)\n"
 		  "  -t|--threads=N_THREADS\n"
 		  "     --pcap-threads=N_THREADS\n"
 		  "  -h|--help    : shows this message\n"
@@ -2880,6 +3081,9 @@ parse_options(int argc, char *argv[])
 		{"parallel-write", required_argument, NULL, 1005},
 		{"composite-options", no_argument,    NULL, 1006},
 		{"interface-id",   no_argument,       NULL, 1007},
+		{"bloom",          required_argument, NULL, 1008},
+		{"compress",       required_argument, NULL, 1009},
+		{"async-write",    required_argument, NULL, 1010},
 		{"help",           no_argument,       NULL, 'h'},
 		{NULL, 0, NULL, 0}
 	};
@@ -3020,6 +3224,26 @@ parse_options(int argc, char *argv[])
 				enable_interface_id = true;
 				break;
 
+			case 1008:	/* --bloom */
+				if (bloom_filter_columns)
+					Elog("--bloom was specified twice");
+				bloom_filter_columns = optarg;
+				break;
+
+			case 1009:	/* --compress */
+				if (compression_spec)
+					Elog("--compress was specified twice");
+				compression_spec = optarg;
+				break;
+
+			case 1010:	/* --async-write */
+				async_write_depth = strtol(optarg, &pos, 10);
+				if (*pos != '\0' ||
+					async_write_depth < 0 ||
+					async_write_depth > ASYNC_WRITE_DEPTH_MAX)
+					Elog("invalid --async-write argument: %s", optarg);
+				break;
+
 			default:
 				usage(code == 'h' ? 0 : 1);
 				break;
@@ -3035,6 +3259,9 @@ parse_options(int argc, char *argv[])
 	{
 		int		i, nfiles = argc - optind;
 
+		if (async_write_depth > 0)
+			Elog("--async-write is valid only capturing mode");
+
 		pcap_file_desc_array = palloc0(sizeof(pcapFileDesc) * nfiles);
 		for (i=0; i < nfiles; i++)
 		{
@@ -3314,15 +3541,7 @@ int main(int argc, char *argv[])
 	/* chunk-buffer pre-allocation */
 	arrow_chunks_array = palloc0(sizeof(SQLtable *) * num_threads);
 	for (i=0; i < num_threads; i++)
-	{
-		SQLtable   *chunk;
-
-		chunk = palloc0(offsetof(SQLtable,
-								 columns[PCAP_SCHEMA_MAX_NFIELDS]));
-		arrowPcapSchemaInit(chunk);
-		chunk->fdesc = -1;
-		arrow_chunks_array[i] = chunk;
-	}
+		arrow_chunks_array[i] = arrowChunkAlloc();
 
 	if (input_devname)
 		init_pfring_input();
@@ -3350,6 +3569,26 @@ int main(int argc, char *argv[])
 	pthreadCondInit(&arrow_workers_cond);
 	arrow_workers_completed = palloc0(sizeof(bool) * num_threads);
 
+	/* launch asynchronous writer threads, if any */
+	if (async_write_depth > 0)
+	{
+		arrow_async_writers = palloc0(sizeof(arrowAsyncWriter) * num_threads);
+		for (i=0; i < num_threads; i++)
+		{
+			arrowAsyncWriter *aw = &arrow_async_writers[i];
+
+			aw->worker_id = i;
+			if (sem_init(&aw->pending.sem, 0, 0) != 0 ||
+				sem_init(&aw->freed.sem, 0, 0) != 0)
+				Elog("failed on sem_init: %m");
+			for (int k=0; k < async_write_depth; k++)
+				chunkQueuePush(&aw->freed, arrowChunkAlloc());
+			rv = pthread_create(&aw->thread, NULL, async_writer_main, aw);
+			if (rv != 0)
+				Elog("failed on pthread_create: %s", strerror(rv));
+		}
+	}
+
 	workers = alloca(sizeof(pthread_t) * num_threads);
 	for (i=0; i < num_threads; i++)
 	{
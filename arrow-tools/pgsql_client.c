@@ -12,6 +12,14 @@
 #include <libpq-fe.h>
 
 #define CURSOR_NAME		"curr_pg2arrow"
+#define CDC_CURSOR_NAME	"curr_pg2arrow_cdc"
+/* configurations by command line options */
+bool		pgsql_copy_binary_mode = false;
+uint32_t	pgsql_fetch_chunk_size = 500000;
+char	   *pgsql_cdc_slot_name = NULL;
+char	   *pgsql_cdc_publication = NULL;
+const char *pgsql_cdc_table_name = NULL;
+uint64_t	pgsql_cdc_lsn = 0;
 static char	   *server_timezone = NULL;
 
 static void		pgsql_setup_composite_type(PGconn *conn,
@@ -50,6 +58,36 @@ typedef struct
 	PGresult   *res;
 	uint32_t	nitems;
 	uint32_t	index;
+	char		fetch_command[80];
+	/* prefetch of the next chunk by the background thread */
+	pthread_t	prefetch_thread;
+	bool		prefetch_active;
+	bool		prefetch_done;
+	PGresult   *prefetch_res;
+	pthread_mutex_t prefetch_mutex;
+	pthread_cond_t	prefetch_cond;
+	/* if --copy is given */
+	bool		copy_mode;
+	bool		copy_header;	/* file header is already consumed */
+	bool		copy_done;
+	char	   *copy_buf;		/* current CopyData message */
+	int			copy_len;
+	int			copy_pos;
+	/* if --cdc-slot is given */
+	PGconn	   *cdc_repl;		/* replication connection (initial export) */
+	bool		cdc_mode;		/* fetch inserted rows from the slot */
+	bool		cdc_done;
+	bool		cdc_skip_xact;	/* transaction already exported */
+	Oid			cdc_relid;
+	uint64_t	cdc_start_lsn;
+	uint64_t	cdc_nignored;	/* UPDATE/DELETE/TRUNCATE on the relation */
+	char		cdc_fetch_command[80];
+	PGresult   *cdc_res;
+	uint32_t	cdc_nitems;
+	uint32_t	cdc_index;
+	const char *cdc_buf;		/* current pgoutput message */
+	int			cdc_len;
+	int			cdc_pos;
 	/* if --nestloop is given */
 	uint32_t	n_depth;
 	PGSTATE_NL	nestloop[1];
@@ -84,7 +122,8 @@ pgsql_server_connect(const char *sqldb_hostname,
                      const char *sqldb_port_num,
                      const char *sqldb_username,
                      const char *sqldb_password,
-                     const char *sqldb_database)
+                     const char *sqldb_database,
+					 bool replication)
 {
 	PGconn	   *conn;
 	const char *keys[20];
@@ -125,6 +164,12 @@ pgsql_server_connect(const char *sqldb_hostname,
 	keys[index] = "application_name";
 	values[index] = "pg2arrow";
 	index++;
+	if (replication)
+	{
+		keys[index] = "replication";
+		values[index] = "database";
+		index++;
+	}
 	/* terminal */
 	keys[index] = NULL;
 	values[index] = NULL;
@@ -323,27 +368,109 @@ pgsql_move_nestloop_next(PGSTATE *pgstate, int depth, uint32_t *rows_index)
 	return -1;
 }
 
+/*
+ * pgsql_prefetch_main
+ *
+ * It runs the next FETCH command on the background, while the caller thread
+ * is converting the previous chunk into Arrow format, so the server-side
+ * query execution and network transfer are overlapped with the encoding
+ * and write of record batches. Error handling is the caller's job.
+ */
+static void *
+pgsql_prefetch_main(void *__pgstate)
+{
+	PGSTATE	   *pgstate = __pgstate;
+	PGresult   *res;
+	bool		done;
+
+	do {
+		res = PQexecParams(pgstate->conn,
+						   pgstate->fetch_command,
+						   0, NULL, NULL, NULL, NULL,
+						   1);	/* results in binary mode */
+		done = (PQresultStatus(res) != PGRES_TUPLES_OK ||
+				PQntuples(res) == 0);
+
+		pthread_mutex_lock(&pgstate->prefetch_mutex);
+		while (pgstate->prefetch_res != NULL)
+			pthread_cond_wait(&pgstate->prefetch_cond,
+							  &pgstate->prefetch_mutex);
+		pgstate->prefetch_res = res;
+		pgstate->prefetch_done = done;
+		pthread_cond_broadcast(&pgstate->prefetch_cond);
+		pthread_mutex_unlock(&pgstate->prefetch_mutex);
+	} while (!done);
+
+	return NULL;
+}
+
+/*
+ * pgsql_fetch_next_chunk
+ */
+static PGresult *
+pgsql_fetch_next_chunk(PGSTATE *pgstate)
+{
+	PGresult   *res;
+
+	/*
+	 * --nestloop runs sub-commands on the same connection for each row,
+	 * so we cannot run FETCH command on the background concurrently.
+	 */
+	if (pgstate->n_depth > 0)
+		return PQexecParams(pgstate->conn,
+							pgstate->fetch_command,
+							0, NULL, NULL, NULL, NULL,
+							1);	/* results in binary mode */
+	if (!pgstate->prefetch_active)
+	{
+		pthread_mutex_init(&pgstate->prefetch_mutex, NULL);
+		pthread_cond_init(&pgstate->prefetch_cond, NULL);
+		pgstate->prefetch_res = NULL;
+		pgstate->prefetch_done = false;
+		if ((errno = pthread_create(&pgstate->prefetch_thread,
+									NULL,
+									pgsql_prefetch_main,
+									pgstate)) != 0)
+			Elog("failed on pthread_create: %m");
+		pgstate->prefetch_active = true;
+	}
+	pthread_mutex_lock(&pgstate->prefetch_mutex);
+	if (pgstate->prefetch_done && pgstate->prefetch_res == NULL)
+	{
+		/* the prefetch thread already reached to the end */
+		pthread_mutex_unlock(&pgstate->prefetch_mutex);
+		return PQexecParams(pgstate->conn,
+							pgstate->fetch_command,
+							0, NULL, NULL, NULL, NULL,
+							1);	/* results in binary mode */
+	}
+	while (pgstate->prefetch_res == NULL)
+		pthread_cond_wait(&pgstate->prefetch_cond,
+						  &pgstate->prefetch_mutex);
+	res = pgstate->prefetch_res;
+	pgstate->prefetch_res = NULL;
+	pthread_cond_broadcast(&pgstate->prefetch_cond);
+	pthread_mutex_unlock(&pgstate->prefetch_mutex);
+
+	return res;
+}
+
 /*
  * pgsql_move_next
  */
 static bool
 pgsql_move_next(PGSTATE *pgstate, uint32_t *rows_index)
 {
-	PGconn	   *conn = pgstate->conn;
 	PGresult   *res;
 
 	for (;;)
 	{
 		if (pgstate->index >= pgstate->nitems)
 		{
-			const char *query = "FETCH FORWARD 500000 FROM " CURSOR_NAME;
-
 			if (pgstate->res)
 				PQclear(pgstate->res);
 
-			res = PQexecParams(conn, query,
-							   0, NULL, NULL, NULL, NULL,
-							   1);	/* results in binary mode */
+			res = pgsql_fetch_next_chunk(pgstate);
 			if (PQresultStatus(res) != PGRES_TUPLES_OK)
 				Elog("SQL execution failed: %s",
 					 PQresultErrorMessage(res));
@@ -936,7 +1063,8 @@ sqldb_server_connect(const char *sqldb_hostname,
 								sqldb_port_num,
 								sqldb_username,
 								sqldb_password,
-								sqldb_database);
+								sqldb_database,
+								false);
 	/*
 	 * preset user's config option
 	 */
@@ -980,6 +1108,10 @@ sqldb_server_connect(const char *sqldb_hostname,
 	pgstate = palloc0(offsetof(PGSTATE, nestloop[n_depth]));
 	pgstate->conn = conn;
 	pgstate->res  = NULL;
+	snprintf(pgstate->fetch_command, sizeof(pgstate->fetch_command),
+			 "FETCH FORWARD %u FROM " CURSOR_NAME,
+			 pgsql_fetch_chunk_size);
+	pgstate->copy_mode = pgsql_copy_binary_mode;
 	pgstate->n_depth = n_depth;
 	for (nlopt = sqldb_nestloop_list, i=0; nlopt; nlopt = nlopt->next, i++)
 	{
@@ -997,6 +1129,117 @@ sqldb_server_connect(const char *sqldb_hostname,
 	return pgstate;
 }
 
+/*
+ * pgsql_cdc_create_slot
+ *
+ * It creates a logical replication slot with pgoutput plugin, and returns
+ * the snapshot exported by the slot. The initial export on this snapshot
+ * contains all the transactions committed prior to the consistent point
+ * of the slot, and the slot shall decode the rest of transactions.
+ */
+static char *
+pgsql_cdc_create_slot(PGSTATE *pgstate)
+{
+	PGconn	   *conn = pgstate->conn;
+	PGconn	   *repl;
+	PGresult   *res;
+	char	   *ident;
+	char	   *query;
+	char	   *snapshot;
+	uint32_t	hi, lo;
+
+	repl = pgsql_server_connect(PQhost(conn),
+								PQport(conn),
+								PQuser(conn),
+								PQpass(conn),
+								PQdb(conn),
+								true);
+	ident = PQescapeIdentifier(repl, pgsql_cdc_slot_name,
+							   strlen(pgsql_cdc_slot_name));
+	if (!ident)
+		Elog("failed on PQescapeIdentifier: %s", PQerrorMessage(repl));
+	query = alloca(strlen(ident) + 100);
+	sprintf(query, "CREATE_REPLICATION_SLOT %s LOGICAL pgoutput EXPORT_SNAPSHOT",
+			ident);
+	PQfreemem(ident);
+	res = PQexec(repl, query);
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		Elog("unable to create logical replication slot '%s': %s",
+			 pgsql_cdc_slot_name, PQresultErrorMessage(res));
+	if (PQntuples(res) != 1 || PQnfields(res) < 3)
+		Elog("unexpected result for CREATE_REPLICATION_SLOT");
+	if (sscanf(PQgetvalue(res, 0, 1), "%X/%X", &hi, &lo) != 2)
+		Elog("unexpected consistent point of the slot: %s",
+			 PQgetvalue(res, 0, 1));
+	pgsql_cdc_lsn = ((uint64_t)hi << 32) | (uint64_t)lo;
+	snapshot = pstrdup(PQgetvalue(res, 0, 2));
+	PQclear(res);
+	/*
+	 * the exported snapshot is valid until the next command on the
+	 * replication connection, so keep it until the end of the export.
+	 */
+	pgstate->cdc_repl = repl;
+
+	return snapshot;
+}
+
+/*
+ * pgsql_cdc_begin_changes
+ *
+ * It declares a cursor to fetch the pgoutput messages from the slot in the
+ * binary format. Note that it only peeks the changes, and the slot shall be
+ * advanced at pgsql_cdc_advance_slot() after the footer is written.
+ */
+static void
+pgsql_cdc_begin_changes(PGSTATE *pgstate)
+{
+	PGconn	   *conn = pgstate->conn;
+	PGresult   *res;
+	char	   *slot;
+	char	   *pub;
+	char	   *query;
+
+	res = PQexecParams(conn,
+					   "SELECT $1::regclass::oid",
+					   1, NULL, &pgsql_cdc_table_name, NULL, NULL,
+					   0);
+	if (PQresultStatus(res) != PGRES_TUPLES_OK ||
+		PQntuples(res) != 1 ||
+		PQgetisnull(res, 0, 0))
+		Elog("unable to lookup relation '%s': %s",
+			 pgsql_cdc_table_name, PQresultErrorMessage(res));
+	pgstate->cdc_relid = atol(PQgetvalue(res, 0, 0));
+	PQclear(res);
+
+	slot = PQescapeLiteral(conn, pgsql_cdc_slot_name,
+						   strlen(pgsql_cdc_slot_name));
+	pub = PQescapeLiteral(conn, pgsql_cdc_publication,
+						  strlen(pgsql_cdc_publication));
+	if (!slot || !pub)
+		Elog("failed on PQescapeLiteral: %s", PQerrorMessage(conn));
+	query = alloca(strlen(slot) + strlen(pub) + 400);
+	sprintf(query,
+			"DECLARE " CDC_CURSOR_NAME " BINARY CURSOR FOR "
+			"SELECT data FROM pg_catalog.pg_logical_slot_peek_binary_changes("
+			"%s, NULL, NULL, "
+			"'proto_version', '1', "
+			"'publication_names', %s, "
+			"'binary', 'true')", slot, pub);
+	PQfreemem(slot);
+	PQfreemem(pub);
+	res = PQexec(conn, query);
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		Elog("unable to declare a cursor on the slot '%s': %s",
+			 pgsql_cdc_slot_name, PQresultErrorMessage(res));
+	PQclear(res);
+
+	snprintf(pgstate->cdc_fetch_command, sizeof(pgstate->cdc_fetch_command),
+			 "FETCH FORWARD %u FROM " CDC_CURSOR_NAME,
+			 pgsql_fetch_chunk_size);
+	pgstate->cdc_mode = true;
+	pgstate->cdc_start_lsn = pgsql_cdc_lsn;
+}
+
 /*
  * sqldb_begin_query
  */
@@ -1012,6 +1255,13 @@ sqldb_begin_query(void *sqldb_state,
 	PGresult   *res;
 	char	   *query;
 
+	/*
+	 * --cdc-slot without --append creates a new logical replication slot,
+	 * then the initial export runs on the snapshot exported by the slot.
+	 */
+	if (pgsql_cdc_slot_name && !af_info && !snapshot_identifier)
+		snapshot_identifier = pgsql_cdc_create_slot(pgstate);
+
 	/* begin read-only transaction */
 	res = PQexec(conn, "BEGIN READ ONLY");
 	if (PQresultStatus(res) != PGRES_COMMAND_OK)
@@ -1070,11 +1320,440 @@ sqldb_begin_query(void *sqldb_state,
 	pgstate->index  = 0;
 	assert(pgstate->nitems == 0);
 
+	/*
+	 * --copy mode; the cursor above is used only to fetch the schema
+	 * definition, then the results are sent by COPY BINARY under the same
+	 * transaction snapshot.
+	 */
+	if (pgstate->copy_mode)
+	{
+		PGresult   *__res;
+
+		sprintf(query, "COPY (%s) TO STDOUT (FORMAT binary)",
+				sqldb_command);
+		__res = PQexec(conn, query);
+		if (PQresultStatus(__res) != PGRES_COPY_OUT)
+			Elog("unable to run COPY TO STDOUT: %s",
+				 PQresultErrorMessage(__res));
+		PQclear(__res);
+	}
+	/*
+	 * --cdc-slot with --append; the cursor above is used only to fetch the
+	 * schema definition, then the inserted rows are fetched from the slot.
+	 */
+	if (pgsql_cdc_slot_name && af_info)
+		pgsql_cdc_begin_changes(pgstate);
+
 	return pgsql_create_buffer(pgstate,
 							   af_info,
 							   dictionary_list);
 }
 
+/*
+ * pgsql_copy_read_bytes
+ */
+static const char *
+pgsql_copy_read_bytes(PGSTATE *pgstate, int sz)
+{
+	const char *pos;
+
+	if (pgstate->copy_pos + sz > pgstate->copy_len)
+		Elog("COPY BINARY stream is broken (pos=%d, len=%d, sz=%d)",
+			 pgstate->copy_pos, pgstate->copy_len, sz);
+	pos = pgstate->copy_buf + pgstate->copy_pos;
+	pgstate->copy_pos += sz;
+
+	return pos;
+}
+
+static inline int16_t
+pgsql_copy_read_int16(PGSTATE *pgstate)
+{
+	uint16_t	ival;
+
+	memcpy(&ival, pgsql_copy_read_bytes(pgstate, sizeof(uint16_t)),
+		   sizeof(uint16_t));
+	return (int16_t)be16toh(ival);
+}
+
+static inline int32_t
+pgsql_copy_read_int32(PGSTATE *pgstate)
+{
+	uint32_t	ival;
+
+	memcpy(&ival, pgsql_copy_read_bytes(pgstate, sizeof(uint32_t)),
+		   sizeof(uint32_t));
+	return (int32_t)be32toh(ival);
+}
+
+/*
+ * pgsql_copy_next_message
+ */
+static bool
+pgsql_copy_next_message(PGSTATE *pgstate)
+{
+	static const char BinarySignature[11] = "PGCOPY\n\377\r\n\0";
+	PGresult   *res;
+	char	   *buf;
+	int			len;
+
+	if (pgstate->copy_buf)
+		PQfreemem(pgstate->copy_buf);
+	pgstate->copy_buf = NULL;
+	pgstate->copy_len = 0;
+	pgstate->copy_pos = 0;
+
+	len = PQgetCopyData(pgstate->conn, &buf, 0);
+	if (len == -2)
+		Elog("failed on PQgetCopyData: %s", PQerrorMessage(pgstate->conn));
+	if (len < 0)
+	{
+		/* end of the COPY; check the final status */
+		res = PQgetResult(pgstate->conn);
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+			Elog("COPY TO STDOUT failed: %s", PQresultErrorMessage(res));
+		PQclear(res);
+		while ((res = PQgetResult(pgstate->conn)) != NULL)
+			PQclear(res);
+		pgstate->copy_done = true;
+		return false;
+	}
+	pgstate->copy_buf = buf;
+	pgstate->copy_len = len;
+	/* the first message is prefixed by the file header */
+	if (!pgstate->copy_header)
+	{
+		int32_t		extlen;
+
+		if (memcmp(pgsql_copy_read_bytes(pgstate, sizeof(BinarySignature)),
+				   BinarySignature, sizeof(BinarySignature)) != 0)
+			Elog("COPY BINARY stream has unknown signature");
+		(void)pgsql_copy_read_int32(pgstate);	/* flags */
+		extlen = pgsql_copy_read_int32(pgstate);
+		if (extlen < 0)
+			Elog("COPY BINARY stream has corrupted header");
+		pgsql_copy_read_bytes(pgstate, extlen);
+		pgstate->copy_header = true;
+	}
+	return true;
+}
+
+/*
+ * pgsql_copy_fetch_results
+ *
+ * It parses the tuples in COPY BINARY stream; every field is already in
+ * the binary send/recv format, as results of the binary cursor.
+ */
+static bool
+pgsql_copy_fetch_results(PGSTATE *pgstate, SQLtable *table)
+{
+	size_t		usage = 0;
+	int			i, nfields;
+
+	if (pgstate->copy_done)
+		return false;
+	while (pgstate->copy_pos >= pgstate->copy_len)
+	{
+		if (!pgsql_copy_next_message(pgstate))
+			return false;
+	}
+	nfields = pgsql_copy_read_int16(pgstate);
+	if (nfields < 0)
+	{
+		/* file trailer; consume the remaining messages */
+		while (pgsql_copy_next_message(pgstate))
+			;
+		return false;
+	}
+	if (nfields != table->nfields)
+		Elog("COPY BINARY stream has unexpected number of fields (%d of %d)",
+			 nfields, table->nfields);
+	for (i=0; i < nfields; i++)
+	{
+		SQLfield   *column = &table->columns[i];
+		const char *addr = NULL;
+		int32_t		sz;
+
+		sz = pgsql_copy_read_int32(pgstate);
+		if (sz < 0)
+			sz = 0;		/* NULL */
+		else
+			addr = pgsql_copy_read_bytes(pgstate, sz);
+		usage += sql_field_put_value(column, addr, sz);
+	}
+	table->usage = usage;
+	table->nitems++;
+
+	return true;
+}
+
+/*
+ * pgsql_cdc_read_xxx - readers of the pgoutput message
+ */
+static const char *
+pgsql_cdc_read_bytes(PGSTATE *pgstate, int sz)
+{
+	const char *pos;
+
+	if (sz < 0 || pgstate->cdc_pos + sz > pgstate->cdc_len)
+		Elog("pgoutput message is broken (pos=%d, len=%d, sz=%d)",
+			 pgstate->cdc_pos, pgstate->cdc_len, sz);
+	pos = pgstate->cdc_buf + pgstate->cdc_pos;
+	pgstate->cdc_pos += sz;
+
+	return pos;
+}
+
+static inline char
+pgsql_cdc_read_char(PGSTATE *pgstate)
+{
+	return *pgsql_cdc_read_bytes(pgstate, sizeof(char));
+}
+
+static inline int16_t
+pgsql_cdc_read_int16(PGSTATE *pgstate)
+{
+	uint16_t	ival;
+
+	memcpy(&ival, pgsql_cdc_read_bytes(pgstate, sizeof(uint16_t)),
+		   sizeof(uint16_t));
+	return (int16_t)be16toh(ival);
+}
+
+static inline int32_t
+pgsql_cdc_read_int32(PGSTATE *pgstate)
+{
+	uint32_t	ival;
+
+	memcpy(&ival, pgsql_cdc_read_bytes(pgstate, sizeof(uint32_t)),
+		   sizeof(uint32_t));
+	return (int32_t)be32toh(ival);
+}
+
+static inline uint64_t
+pgsql_cdc_read_uint64(PGSTATE *pgstate)
+{
+	uint64_t	ival;
+
+	memcpy(&ival, pgsql_cdc_read_bytes(pgstate, sizeof(uint64_t)),
+		   sizeof(uint64_t));
+	return be64toh(ival);
+}
+
+static const char *
+pgsql_cdc_read_string(PGSTATE *pgstate)
+{
+	const char *str = pgstate->cdc_buf + pgstate->cdc_pos;
+	size_t		len = strnlen(str, pgstate->cdc_len - pgstate->cdc_pos);
+
+	/* NUL-terminated */
+	pgsql_cdc_read_bytes(pgstate, len + 1);
+	return str;
+}
+
+/*
+ * pgsql_cdc_next_message
+ */
+static bool
+pgsql_cdc_next_message(PGSTATE *pgstate)
+{
+	PGresult   *res;
+
+	while (pgstate->cdc_index >= pgstate->cdc_nitems)
+	{
+		if (pgstate->cdc_res)
+			PQclear(pgstate->cdc_res);
+		pgstate->cdc_res = NULL;
+		if (pgstate->cdc_done)
+			return false;
+
+		res = PQexecParams(pgstate->conn,
+						   pgstate->cdc_fetch_command,
+						   0, NULL, NULL, NULL, NULL,
+						   1);	/* results in binary mode */
+		if (PQresultStatus(res) != PGRES_TUPLES_OK)
+			Elog("failed on fetch the changes from the slot '%s': %s",
+				 pgsql_cdc_slot_name, PQresultErrorMessage(res));
+		pgstate->cdc_res = res;
+		pgstate->cdc_nitems = PQntuples(res);
+		pgstate->cdc_index = 0;
+		if (pgstate->cdc_nitems == 0)
+			pgstate->cdc_done = true;
+	}
+	pgstate->cdc_buf = PQgetvalue(pgstate->cdc_res, pgstate->cdc_index, 0);
+	pgstate->cdc_len = PQgetlength(pgstate->cdc_res, pgstate->cdc_index, 0);
+	pgstate->cdc_pos = 0;
+	pgstate->cdc_index++;
+
+	return true;
+}
+
+/*
+ * pgsql_cdc_fetch_results
+ *
+ * It parses the pgoutput messages (protocol version 1), then picks up the
+ * Insert messages on the target relation. Every field is in the binary
+ * send/recv format, as results of the binary cursor.
+ * Transactions committed prior to the LSN of the last export are skipped,
+ * and pgsql_cdc_lsn is updated to the end of the last transaction.
+ */
+static bool
+pgsql_cdc_fetch_results(PGSTATE *pgstate, SQLtable *table)
+{
+	while (pgsql_cdc_next_message(pgstate))
+	{
+		char		kind = pgsql_cdc_read_char(pgstate);
+		uint64_t	lsn;
+		Oid			relid;
+		size_t		usage = 0;
+		int			i, nfields;
+
+		switch (kind)
+		{
+			case 'B':	/* Begin */
+				lsn = pgsql_cdc_read_uint64(pgstate);	/* final_lsn */
+				pgstate->cdc_skip_xact = (lsn < pgstate->cdc_start_lsn);
+				break;
+
+			case 'C':	/* Commit */
+				(void)pgsql_cdc_read_char(pgstate);		/* flags */
+				(void)pgsql_cdc_read_uint64(pgstate);	/* commit_lsn */
+				lsn = pgsql_cdc_read_uint64(pgstate);	/* end_lsn */
+				if (!pgstate->cdc_skip_xact && lsn > pgsql_cdc_lsn)
+					pgsql_cdc_lsn = lsn;
+				break;
+
+			case 'R':	/* Relation */
+				relid = pgsql_cdc_read_int32(pgstate);
+				if (relid != pgstate->cdc_relid)
+					break;
+				(void)pgsql_cdc_read_string(pgstate);	/* nspname */
+				(void)pgsql_cdc_read_string(pgstate);	/* relname */
+				(void)pgsql_cdc_read_char(pgstate);		/* replident */
+				nfields = pgsql_cdc_read_int16(pgstate);
+				if (nfields != table->nfields)
+					Elog("relation '%s' has %d columns in the publication '%s', but %d columns are expected",
+						 pgsql_cdc_table_name, nfields,
+						 pgsql_cdc_publication, table->nfields);
+				for (i=0; i < nfields; i++)
+				{
+					SQLfield   *column = &table->columns[i];
+					const char *attname;
+
+					(void)pgsql_cdc_read_char(pgstate);		/* flags */
+					attname = pgsql_cdc_read_string(pgstate);
+					if (strcmp(attname, column->field_name) != 0)
+						Elog("column '%s' in the publication '%s' is not compatible to '%s'",
+							 attname, pgsql_cdc_publication,
+							 column->field_name);
+					(void)pgsql_cdc_read_int32(pgstate);	/* atttypid */
+					(void)pgsql_cdc_read_int32(pgstate);	/* atttypmod */
+				}
+				break;
+
+			case 'I':	/* Insert */
+				relid = pgsql_cdc_read_int32(pgstate);
+				if (relid != pgstate->cdc_relid || pgstate->cdc_skip_xact)
+					break;
+				if (pgsql_cdc_read_char(pgstate) != 'N')
+					Elog("pgoutput Insert message has unexpected tuple");
+				nfields = pgsql_cdc_read_int16(pgstate);
+				if (nfields != table->nfields)
+					Elog("pgoutput Insert message has unexpected number of fields (%d of %d)",
+						 nfields, table->nfields);
+				for (i=0; i < nfields; i++)
+				{
+					SQLfield   *column = &table->columns[i];
+					const char *addr = NULL;
+					int32_t		sz = 0;
+
+					switch (pgsql_cdc_read_char(pgstate))
+					{
+						case 'n':	/* NULL */
+							break;
+						case 'b':	/* binary */
+							sz = pgsql_cdc_read_int32(pgstate);
+							addr = pgsql_cdc_read_bytes(pgstate, sz);
+							break;
+						case 't':	/* text */
+							Elog("column '%s' was sent in text format; its data type has no binary send function",
+								 column->field_name);
+						default:
+							Elog("pgoutput Insert message has unknown field kind");
+					}
+					usage += sql_field_put_value(column, addr, sz);
+				}
+				table->usage = usage;
+				table->nitems++;
+				return true;
+
+			case 'U':	/* Update */
+			case 'D':	/* Delete */
+				relid = pgsql_cdc_read_int32(pgstate);
+				if (relid == pgstate->cdc_relid && !pgstate->cdc_skip_xact)
+					pgstate->cdc_nignored++;
+				break;
+
+			case 'T':	/* Truncate */
+				nfields = pgsql_cdc_read_int32(pgstate);	/* nrelids */
+				(void)pgsql_cdc_read_char(pgstate);			/* flags */
+				for (i=0; i < nfields; i++)
+				{
+					relid = pgsql_cdc_read_int32(pgstate);
+					if (relid == pgstate->cdc_relid && !pgstate->cdc_skip_xact)
+						pgstate->cdc_nignored++;
+				}
+				break;
+
+			default:
+				/* Origin, Type, Message and so on */
+				break;
+		}
+	}
+	return false;
+}
+
+/*
+ * pgsql_cdc_advance_slot
+ *
+ * It advances the slot to the end of the exported transactions, after the
+ * footer is written. Even if it would fail, the LSN in the custom metadata
+ * prevents duplication of the rows on the next export.
+ */
+static void
+pgsql_cdc_advance_slot(PGSTATE *pgstate)
+{
+	PGresult   *res;
+	const char *values[2];
+	char		lsn[40];
+
+	if (pgstate->cdc_nignored > 0)
+		fprintf(stderr,
+				"NOTICE: %lu UPDATE/DELETE/TRUNCATE on '%s' were not exported by --cdc-slot\n",
+				pgstate->cdc_nignored, pgsql_cdc_table_name);
+	if (pgsql_cdc_lsn <= pgstate->cdc_start_lsn)
+		return;
+	/* logical decoding context should not be held on the transaction */
+	res = PQexec(pgstate->conn, "COMMIT");
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		Elog("failed on COMMIT: %s", PQresultErrorMessage(res));
+	PQclear(res);
+
+	sprintf(lsn, "%X/%X",
+			(uint32_t)(pgsql_cdc_lsn >> 32),
+			(uint32_t)(pgsql_cdc_lsn & 0xffffffffU));
+	values[0] = pgsql_cdc_slot_name;
+	values[1] = lsn;
+	res = PQexecParams(pgstate->conn,
+					   "SELECT pg_catalog.pg_replication_slot_advance($1, $2::pg_lsn)",
+					   2, NULL, values, NULL, NULL,
+					   0);
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		Elog("unable to advance the slot '%s' to %s: %s",
+			 pgsql_cdc_slot_name, lsn, PQresultErrorMessage(res));
+	PQclear(res);
+}
+
 /*
  * sqldb_fetch_results
  */
@@ -1089,6 +1768,11 @@ sqldb_fetch_results(void *sqldb_state, SQLtable *table)
 	int			i, j, ncols;
 	size_t		usage = 0;
 
+	if (pgstate->copy_mode)
+		return pgsql_copy_fetch_results(pgstate, table);
+	if (pgstate->cdc_mode)
+		return pgsql_cdc_fetch_results(pgstate, table);
+
 	rows_index = alloca(sizeof(uint32_t) * (pgstate->n_depth + 1));
 	if (!pgsql_move_next(pgstate, rows_index))
 		return false;		/* end of the scan */
@@ -1135,6 +1819,46 @@ sqldb_fetch_results(void *sqldb_state, SQLtable *table)
 	return true;
 }
 
+/*
+ * sqldb_fetch_key_range - min/max of the integer key for --split-key
+ */
+bool
+sqldb_fetch_key_range(void *sqldb_state,
+					  const char *table_name,
+					  const char *key_name,
+					  int64_t *p_key_min,
+					  int64_t *p_key_max)
+{
+	PGSTATE	   *pgstate = sqldb_state;
+	PGconn	   *conn = pgstate->conn;
+	PGresult   *res;
+	char	   *query;
+	char	   *end;
+	bool		retval = false;
+
+	query = alloca(strlen(table_name) + 2 * strlen(key_name) + 100);
+	sprintf(query, "SELECT MIN(%s)::bigint, MAX(%s)::bigint FROM %s",
+			key_name, key_name, table_name);
+	res = PQexec(conn, query);
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		Elog("failed on '%s': %s", query, PQresultErrorMessage(res));
+	if (PQntuples(res) != 1 || PQnfields(res) != 2)
+		Elog("unexpected query result for '%s'", query);
+	if (!PQgetisnull(res, 0, 0) && !PQgetisnull(res, 0, 1))
+	{
+		*p_key_min = strtoll(PQgetvalue(res, 0, 0), &end, 10);
+		if (*end != '\0')
+			Elog("--split-key must be an integer column: %s", key_name);
+		*p_key_max = strtoll(PQgetvalue(res, 0, 1), &end, 10);
+		if (*end != '\0')
+			Elog("--split-key must be an integer column: %s", key_name);
+		retval = true;
+	}
+	PQclear(res);
+
+	return retval;
+}
+
 void
 sqldb_close_connection(void *sqldb_state)
 {
@@ -1143,6 +1867,23 @@ sqldb_close_connection(void *sqldb_state)
 	PGresult   *res;
 	int			i;
 
+	/* COPY must be completed prior to CLOSE */
+	if (pgstate->copy_mode)
+	{
+		while (!pgstate->copy_done)
+			pgsql_copy_next_message(pgstate);
+	}
+	/* the prefetch thread must be already terminated at end of the scan */
+	if (pgstate->prefetch_active)
+	{
+		if ((errno = pthread_join(pgstate->prefetch_thread, NULL)) != 0)
+			Elog("failed on pthread_join: %m");
+		if (pgstate->prefetch_res)
+			PQclear(pgstate->prefetch_res);
+		pthread_mutex_destroy(&pgstate->prefetch_mutex);
+		pthread_cond_destroy(&pgstate->prefetch_cond);
+		pgstate->prefetch_active = false;
+	}
 	if (pgstate->res)
 		PQclear(pgstate->res);
 	for (i=0; i < pgstate->n_depth; i++)
@@ -1158,6 +1899,20 @@ sqldb_close_connection(void *sqldb_state)
 		Elog("failed on close cursor '%s': %s", CURSOR_NAME,
 			 PQresultErrorMessage(res));
 	PQclear(res);
+	/* close the cursor on the slot, then advance the slot */
+	if (pgstate->cdc_mode)
+	{
+		if (pgstate->cdc_res)
+			PQclear(pgstate->cdc_res);
+		res = PQexec(conn, "CLOSE " CDC_CURSOR_NAME);
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+			Elog("failed on close cursor '%s': %s", CDC_CURSOR_NAME,
+				 PQresultErrorMessage(res));
+		PQclear(res);
+		pgsql_cdc_advance_slot(pgstate);
+	}
+	if (pgstate->cdc_repl)
+		PQfinish(pgstate->cdc_repl);
 	/* close the connection */
 	PQfinish(conn);
 }
@@ -30,8 +30,12 @@ static char	   *sqldb_password = NULL;
 static char	   *sqldb_database = NULL;
 static char	   *dump_arrow_filename = NULL;
 static char	   *stat_embedded_columns = NULL;
+static char	   *bloom_filter_columns = NULL;
+static char	   *compression_spec = NULL;
 static int		num_worker_threads = 0;
 static char	   *parallel_dist_keys = NULL;
+static char	   *split_key_name = NULL;
+static char	   *split_table_name = NULL;
 static int		shows_progress = 0;
 static userConfigOption *sqldb_session_configs = NULL;
 static nestLoopOption *sqldb_nestloop_options = NULL;
@@ -46,6 +50,15 @@ static pthread_t	   *worker_threads;
 static SQLtable		  **worker_tables;
 static const char	  **worker_dist_keys = NULL;
 static pthread_mutex_t	main_table_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* per-stage statistics for --progress */
+typedef struct
+{
+	double		fetch_sec;		/* fetch and encode of the results */
+	double		write_sec;		/* write out of the record batches */
+	size_t		write_bytes;
+	size_t		nitems;
+} workerStageStats;
+static workerStageStats *worker_stats;
 
 /*
  * __trim
@@ -372,6 +385,43 @@ dumpArrowFile(const char *filename)
 	return 0;
 }
 
+#ifdef __PG2ARROW__
+/*
+ * setup_cdc_start_lsn
+ *
+ * It restores the LSN of the last export by --cdc-slot from the custom
+ * metadata of the file to be appended.
+ */
+static void
+setup_cdc_start_lsn(ArrowFileInfo *af_info)
+{
+	ArrowSchema *schema = &af_info->footer.schema;
+	const char *cdc_slot = NULL;
+	const char *cdc_lsn = NULL;
+	uint32_t	hi, lo;
+
+	for (int i=0; i < schema->_num_custom_metadata; i++)
+	{
+		ArrowKeyValue *kv = &schema->custom_metadata[i];
+
+		if (!kv->key || !kv->value)
+			continue;
+		if (strcmp(kv->key, "cdc_slot") == 0)
+			cdc_slot = kv->value;
+		else if (strcmp(kv->key, "cdc_lsn") == 0)
+			cdc_lsn = kv->value;
+	}
+	if (!cdc_slot || !cdc_lsn)
+		Elog("'%s' was not exported with --cdc-slot", append_filename);
+	if (strcmp(cdc_slot, pgsql_cdc_slot_name) != 0)
+		Elog("'%s' was exported with the slot '%s', not '%s'",
+			 append_filename, cdc_slot, pgsql_cdc_slot_name);
+	if (sscanf(cdc_lsn, "%X/%X", &hi, &lo) != 2)
+		Elog("'%s' has corrupted cdc_lsn [%s]", append_filename, cdc_lsn);
+	pgsql_cdc_lsn = ((uint64_t)hi << 32) | (uint64_t)lo;
+}
+#endif	/* __PG2ARROW__ */
+
 static char *
 read_sql_command_from_file(const char *filename)
 {
@@ -483,6 +533,7 @@ __enable_field_stats(SQLfield *field)
 	field->stat_enabled = retval;
 	memset(&field->stat_datum, 0, sizeof(SQLstat));
 	field->stat_list = NULL;
+	field->zone_list = NULL;
 
 	if (field->element)
 	{
@@ -553,6 +604,75 @@ enable_embedded_stats(SQLtable *table)
 	}
 }
 
+static void
+enable_bloom_filters(SQLtable *table)
+{
+	char	   *buffer;
+	char	   *name, *pos;
+	int			j;
+
+	if (!bloom_filter_columns)
+		return;
+	buffer = alloca(strlen(bloom_filter_columns) + 1);
+	strcpy(buffer, bloom_filter_columns);
+	for (name = strtok_r(buffer, ",", &pos);
+		 name != NULL;
+		 name = strtok_r(NULL, ",", &pos))
+	{
+		bool	found = false;
+
+		name = __trim(name);
+		for (j=0; j < table->nfields; j++)
+		{
+			SQLfield   *field = &table->columns[j];
+
+			if (strcmp(field->field_name, name) == 0)
+			{
+				switch (field->arrow_type.node.tag)
+				{
+					case ArrowNodeTag__Int:
+					case ArrowNodeTag__Date:
+					case ArrowNodeTag__Time:
+					case ArrowNodeTag__Timestamp:
+					case ArrowNodeTag__FixedSizeBinary:
+					case ArrowNodeTag__Utf8:
+					case ArrowNodeTag__Binary:
+					case ArrowNodeTag__LargeUtf8:
+					case ArrowNodeTag__LargeBinary:
+						field->bloom_enabled = true;
+						field->bloom_list = NULL;
+						found = true;
+						break;
+					default:
+						Elog("field [%s; %s] does not support bloom filter",
+							 name, field->arrow_type.node.tagName);
+				}
+			}
+		}
+		if (!found)
+			Elog("field name [%s], specified by --bloom option, was not found",
+				 name);
+	}
+}
+
+/*
+ * enable_body_compression
+ */
+static void
+enable_body_compression(SQLtable *table)
+{
+	long		ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int			nworkers;
+
+	if (!compression_spec)
+		return;
+	/* CPUs are shared by the worker threads */
+	nworkers = ncpus / num_worker_threads;
+	if (nworkers < 1)
+		nworkers = 1;
+	setupArrowBodyCompression(table, compression_spec, nworkers);
+}
+
 static void
 usage(void)
 {
@@ -577,9 +697,22 @@ usage(void)
 		  "                        PARALLEL_KEYS.\n"
 		  "      (-n and -k are exclusive, either of them can be give if parallel dump.\n"
 		  "       It is user's responsibility to avoid data duplication.)\n"
+		  "      --split-key=COLUMN splits the table given by -t into N_WORKERS\n"
+		  "                       ranges of the integer COLUMN (usually, primary\n"
+		  "                       key) according to its min/max. It requires -n.\n"
 #ifdef __PG2ARROW__
 		  "      --inner-join=SUB_COMMAND\n"
 		  "      --outer-join=SUB_COMMAND\n"
+		  "      --copy           fetch results by COPY BINARY\n"
+		  "                       (exclusive with --inner-join/--outer-join)\n"
+		  "      --fetch-size=NROWS number of rows per FETCH of the cursor\n"
+		  "                       (default: 500000)\n"
+		  "      --cdc-slot=SLOT  exports rows inserted since the last export\n"
+		  "                       by the logical replication SLOT (pgoutput).\n"
+		  "                       It creates SLOT on -o, or fetches the rows\n"
+		  "                       inserted to the table given by -t on --append.\n"
+		  "      --cdc-publication=PUBLICATION publication of the table for\n"
+		  "                       --cdc-slot\n"
 #endif
 		  "  -o, --output=FILENAME result file in Apache Arrow format\n"
 		  "      --append=FILENAME result Apache Arrow file to be appended\n"
@@ -588,6 +721,11 @@ usage(void)
 		  "  -S, --stat[=COLUMNS] embeds min/max statistics for each record batch\n"
 		  "                       COLUMNS is a comma-separated list of the target\n"
 		  "                       columns if partially enabled.\n"
+		  "      --bloom=COLUMNS  embeds bloom filters for each record batch\n"
+		  "                       COLUMNS is a comma-separated list of the target\n"
+		  "                       columns for equality lookup.\n"
+		  "      --compress=CODEC[:LEVEL] compress record batches using CODEC\n"
+		  "                       (lz4 or zstd) with compression LEVEL.\n"
 		  "\n"
 		  "Arrow format options:\n"
 		  "  -s, --segment-size=SIZE size of record batch for each\n"
@@ -641,8 +779,17 @@ parse_options(int argc, char * const argv[])
 		{"inner-join",   required_argument, NULL, 1004},
 		{"outer-join",   required_argument, NULL, 1005},
 		{"stat",         optional_argument, NULL, 'S'},
+		{"bloom",        required_argument, NULL, 1006},
+		{"compress",     required_argument, NULL, 1009},
+#ifdef __PG2ARROW__
+		{"copy",         no_argument,       NULL, 1007},
+		{"fetch-size",   required_argument, NULL, 1008},
+		{"cdc-slot",     required_argument, NULL, 1011},
+		{"cdc-publication", required_argument, NULL, 1012},
+#endif /* __PG2ARROW__ */
 		{"num-workers",  required_argument, NULL, 'n'},
 		{"parallel-keys",required_argument, NULL, 'k'},
+		{"split-key",    required_argument, NULL, 1010},
 		{"help",         no_argument,       NULL, 9999},
 		{NULL, 0, NULL, 0},
 	};
@@ -692,6 +839,7 @@ parse_options(int argc, char * const argv[])
 				if (!sqldb_command)
 					Elog("out of memory");
 				sprintf(sqldb_command, "SELECT * FROM %s", optarg);
+				split_table_name = optarg;
 				meet_table = true;
 				break;
 
@@ -762,6 +910,12 @@ parse_options(int argc, char * const argv[])
 					parallel_dist_keys = pstrdup(optarg);
 				break;
 
+			case 1010:		/* --split-key */
+				if (split_key_name)
+					Elog("--split-key option was supplied twice");
+				split_key_name = __trim(optarg);
+				break;
+
 			case 'h':
 				if (sqldb_hostname)
 					Elog("-h option was supplied twice");
@@ -846,6 +1000,31 @@ parse_options(int argc, char * const argv[])
 					last_nest_loop = nlopt;
 				}
 				break;
+			case 1007:		/* --copy */
+				if (pgsql_copy_binary_mode)
+					Elog("--copy option was supplied twice");
+				pgsql_copy_binary_mode = true;
+				break;
+			case 1008:		/* --fetch-size */
+				{
+					char   *end;
+					long	nrows = strtol(optarg, &end, 10);
+
+					if (*end != '\0' || nrows <= 0 || nrows > INT_MAX)
+						Elog("invalid --fetch-size: %s", optarg);
+					pgsql_fetch_chunk_size = nrows;
+				}
+				break;
+			case 1011:		/* --cdc-slot */
+				if (pgsql_cdc_slot_name)
+					Elog("--cdc-slot option was supplied twice");
+				pgsql_cdc_slot_name = optarg;
+				break;
+			case 1012:		/* --cdc-publication */
+				if (pgsql_cdc_publication)
+					Elog("--cdc-publication option was supplied twice");
+				pgsql_cdc_publication = optarg;
+				break;
 #endif	/* __PG2ARROW__ */
 			case 'S':		/* --stat */
 				{
@@ -857,6 +1036,16 @@ parse_options(int argc, char * const argv[])
 						stat_embedded_columns = "*";
 				}
 				break;
+			case 1006:		/* --bloom */
+				if (bloom_filter_columns)
+					Elog("--bloom option was supplied twice");
+				bloom_filter_columns = optarg;
+				break;
+			case 1009:		/* --compress */
+				if (compression_spec)
+					Elog("--compress option was supplied twice");
+				compression_spec = optarg;
+				break;
 			case 9999:		/* --help */
 			default:
 				usage();
@@ -896,11 +1085,43 @@ parse_options(int argc, char * const argv[])
 	}
 	if (!sqldb_command)
 		Elog("Neither -c nor -t options are supplied");
+#ifdef __PG2ARROW__
+	if (pgsql_copy_binary_mode && sqldb_nestloop_options)
+		Elog("--copy option is exclusive with --inner-join and --outer-join");
+	if (pgsql_cdc_slot_name)
+	{
+		if (!meet_table)
+			Elog("--cdc-slot requires -t option");
+		if (!pgsql_cdc_publication)
+			Elog("--cdc-slot requires --cdc-publication option");
+		if (num_worker_threads > 1 || parallel_dist_keys || split_key_name)
+			Elog("--cdc-slot is exclusive with -n, -k and --split-key");
+		if (pgsql_copy_binary_mode || sqldb_nestloop_options)
+			Elog("--cdc-slot is exclusive with --copy, --inner-join and --outer-join");
+		pgsql_cdc_table_name = split_table_name;
+	}
+	else if (pgsql_cdc_publication)
+		Elog("--cdc-publication requires --cdc-slot option");
+#endif	/* __PG2ARROW__ */
 
 	/*
 	 * The 'sqldb_command' must contains $(WORKER_ID) and $(N_WORKERS).
 	 */
-	if (parallel_dist_keys)
+	if (split_key_name)
+	{
+		char   *temp;
+
+		if (!meet_table)
+			Elog("--split-key requires -t option");
+		if (parallel_dist_keys || num_worker_threads < 2)
+			Elog("--split-key requires -n option with 2 or more workers");
+		/* worker_dist_keys shall be set up by setup_split_key_ranges() */
+		temp = palloc(strlen(split_table_name) + 100);
+		sprintf(temp, "SELECT * FROM %s WHERE $(PARALLEL_KEY)",
+				split_table_name);
+		sqldb_command = temp;
+	}
+	else if (parallel_dist_keys)
 	{
 		char   *temp = pstrdup(parallel_dist_keys);
 		char   *tok, *pos;
@@ -1027,6 +1248,55 @@ sqldb_command_apply_worker_id(const char *command, int worker_id)
 	return buf;
 }
 
+/*
+ * setup_split_key_ranges
+ *
+ * It assigns the equally divided range of the --split-key to each worker.
+ * The first and the last range have no lower / upper bound, so it never
+ * misses rows even if the table gets updated during the dump.
+ */
+static void
+setup_split_key_ranges(void *sqldb_conn)
+{
+	int64_t		key_min;
+	int64_t		key_max;
+	uint64_t	width;
+	size_t		len = 2 * strlen(split_key_name) + 100;
+	char	   *temp = alloca(len);
+
+	worker_dist_keys = palloc0(sizeof(const char *) * num_worker_threads);
+	if (!sqldb_fetch_key_range(sqldb_conn,
+							   split_table_name,
+							   split_key_name,
+							   &key_min,
+							   &key_max))
+	{
+		/* empty table; only worker:0 runs the scan */
+		worker_dist_keys[0] = "true";
+		for (int i=1; i < num_worker_threads; i++)
+			worker_dist_keys[i] = "false";
+		return;
+	}
+	width = ((uint64_t)key_max - (uint64_t)key_min) / num_worker_threads + 1;
+	for (int i=0; i < num_worker_threads; i++)
+	{
+		int64_t		lower = (int64_t)((uint64_t)key_min + width * i);
+		int64_t		upper = (int64_t)((uint64_t)key_min + width * (i+1));
+
+		if (i == 0)
+			snprintf(temp, len, "%s < %ld",
+					 split_key_name, (long)upper);
+		else if (i == num_worker_threads - 1)
+			snprintf(temp, len, "%s >= %ld",
+					 split_key_name, (long)lower);
+		else
+			snprintf(temp, len, "%s >= %ld AND %s < %ld",
+					 split_key_name, (long)lower,
+					 split_key_name, (long)upper);
+		worker_dist_keys[i] = pstrdup(temp);
+	}
+}
+
 /*
  * sql_table_merge_one_row
  */
@@ -1081,6 +1351,46 @@ shows_record_batch_progress(const ArrowBlock *block,
 		   namebuf);
 }
 
+/*
+ * __stage_clock
+ */
+static inline double
+__stage_clock(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+/*
+ * __write_record_batch_by_worker
+ */
+static void
+__write_record_batch_by_worker(SQLtable *main_table,
+							   SQLtable *data_table,
+							   uint32_t worker_id)
+{
+	workerStageStats *stats = &worker_stats[worker_id];
+	ArrowBlock	__block;
+	int			__rb_index;
+	double		tv1 = __stage_clock();
+
+	__rb_index = writeArrowRecordBatchMT(main_table,
+										 data_table,
+										 &main_table_mutex,
+										 &__block);
+	stats->write_sec += (__stage_clock() - tv1);
+	stats->write_bytes += __block.metaDataLength + __block.bodyLength;
+	stats->nitems += data_table->nitems;
+	if (shows_progress)
+		shows_record_batch_progress(&__block,
+									__rb_index,
+									data_table->nitems,
+									worker_id);
+	sql_table_clear(data_table);
+}
+
 /*
  * execute_sql2arrow
  */
@@ -1089,26 +1399,24 @@ sql2arrow_common(void *sqldb_conn, uint32_t worker_id)
 {
 	SQLtable   *main_table = worker_tables[0];
 	SQLtable   *data_table = worker_tables[worker_id];
-	ArrowBlock	__block;
-	int			__rb_index;
+	workerStageStats *stats = &worker_stats[worker_id];
+	double		tv1 = __stage_clock();
+	double		write_sec = stats->write_sec;
 
-	/* fetch results and write record batches */
+	/*
+	 * fetch results and write record batches
+	 *
+	 * NOTE: sqldb_fetch_results() may prefetch the next chunk of the results
+	 * on the background, so the fetch from the server is overlapped with
+	 * the encoding and write of the record batches.
+	 */
 	while (sqldb_fetch_results(sqldb_conn, data_table))
 	{
 		if (data_table->usage >= batch_segment_sz)
-		{
-			__rb_index = writeArrowRecordBatchMT(main_table,
-												 data_table,
-												 &main_table_mutex,
-												 &__block);
-			if (shows_progress)
-				shows_record_batch_progress(&__block,
-											__rb_index,
-											data_table->nitems,
-											worker_id);
-			sql_table_clear(data_table);
-		}
+			__write_record_batch_by_worker(main_table, data_table, worker_id);
 	}
+	stats->fetch_sec += (__stage_clock() - tv1) - (stats->write_sec - write_sec);
+
 	/* wait and merge results */
 	for (uint32_t k=1; (worker_id & k) == 0; k <<= 1)
 	{
@@ -1127,18 +1435,7 @@ sql2arrow_common(void *sqldb_conn, uint32_t worker_id)
 			mergeArrowChunkOneRow(data_table, buddy_table, i);
 			/* write out buffer */
 			if (data_table->usage >= batch_segment_sz)
-			{
-				__rb_index = writeArrowRecordBatchMT(main_table,
-													 data_table,
-													 &main_table_mutex,
-													 &__block);
-				if (shows_progress)
-					shows_record_batch_progress(&__block,
-												__rb_index,
-												data_table->nitems,
-												worker_id);
-				sql_table_clear(data_table);
-			}
+				__write_record_batch_by_worker(main_table, data_table, worker_id);
 		}
 		if (shows_progress && buddy_table->nitems > 0)
 			printf("worker:%u merged pending results by worker:%u\n",
@@ -1146,6 +1443,27 @@ sql2arrow_common(void *sqldb_conn, uint32_t worker_id)
 	}
 }
 
+/*
+ * shows_stage_statistics
+ */
+static void
+shows_stage_statistics(void)
+{
+	for (int i=0; i < num_worker_threads; i++)
+	{
+		workerStageStats *stats = &worker_stats[i];
+
+		printf("worker:%d fetch+encode: %.2fs, write: %.2fs (%.2fMB/s), nitems=%zu\n",
+			   i,
+			   stats->fetch_sec,
+			   stats->write_sec,
+			   stats->write_sec > 0.0
+			   ? ((double)stats->write_bytes /
+				  (double)(1UL<<20)) / stats->write_sec : 0.0,
+			   stats->nitems);
+	}
+}
+
 /*
  * worker_main
  */
@@ -1188,8 +1506,10 @@ worker_main(void *__worker_id)
 	if (!data_table)
 		Elog("Empty results by the query: %s", worker_command);
 	data_table->segment_sz = batch_segment_sz;
-	/* enables embedded min/max statistics, if any */
+	/* enables embedded min/max statistics and bloom filters, if any */
 	enable_embedded_stats(data_table);
+	enable_bloom_filters(data_table);
+	enable_body_compression(data_table);
 	/* check compatibility */
 	if (!IsSQLtableCompatible(main_table, data_table))
 		Elog("Schema definition by the query in worker:%lu is not compatible: %s",
@@ -1219,6 +1539,7 @@ int main(int argc, char * const argv[])
 	ArrowKeyValue  *kv;
 	SQLdictionary  *sql_dict_list = NULL;
 	time_t			tv1 = time(NULL);
+	char			cdc_lsn_buf[40] __attribute__((unused));
 
 	parse_options(argc, argv);
 
@@ -1230,6 +1551,7 @@ int main(int argc, char * const argv[])
 	assert(num_worker_threads > 0);
 	worker_threads = palloc0(sizeof(pthread_t)  * num_worker_threads);
 	worker_tables  = palloc0(sizeof(SQLtable *) * num_worker_threads);
+	worker_stats   = palloc0(sizeof(workerStageStats) * num_worker_threads);
 	for (uintptr_t i = 1; i < num_worker_threads; i++)
 	{
 		if ((errno = pthread_create(&worker_threads[i],
@@ -1253,8 +1575,18 @@ int main(int argc, char * const argv[])
 		if (append_fdesc < 0)
 			Elog("failed on open('%s'): %m", append_filename);
 		readArrowFileDesc(append_fdesc, &af_info);
+		if (af_info.stream_length > 0)
+			Elog("unable to append to '%s'; Arrow IPC stream or incomplete file",
+				 append_filename);
 		sql_dict_list = loadArrowDictionaryBatches(append_fdesc, &af_info);
+#ifdef __PG2ARROW__
+		if (pgsql_cdc_slot_name)
+			setup_cdc_start_lsn(&af_info);
+#endif	/* __PG2ARROW__ */
 	}
+	/* assign the key range for each worker, if --split-key */
+	if (split_key_name)
+		setup_split_key_ranges(sqldb_conn);
 	/* begin SQL command execution */
 	main_command = sqldb_command_apply_worker_id(sqldb_command, 0);
 	if (shows_progress)
@@ -1266,18 +1598,39 @@ int main(int argc, char * const argv[])
 	if (!table)
 		Elog("Empty results by the query: %s", sqldb_command);
 	table->segment_sz = batch_segment_sz;
-	/* enables embedded min/max statistics, if any */
+	/* enables embedded min/max statistics and bloom filters, if any */
 	enable_embedded_stats(table);
+	enable_bloom_filters(table);
+	enable_body_compression(table);
 
 	/* save the SQL command as custom metadata */
-	kv = palloc0(sizeof(ArrowKeyValue));
-	initArrowNode(kv, KeyValue);
-	kv->key = "sql_command";
-	kv->_key_len = 11;
-	kv->value = sqldb_command;
-	kv->_value_len = strlen(sqldb_command);
+	kv = palloc0(sizeof(ArrowKeyValue) * 3);
+	initArrowNode(&kv[0], KeyValue);
+	kv[0].key = "sql_command";
+	kv[0]._key_len = 11;
+	kv[0].value = sqldb_command;
+	kv[0]._value_len = strlen(sqldb_command);
 	table->customMetadata = kv;
 	table->numCustomMetadata = 1;
+#ifdef __PG2ARROW__
+	/* ...and the slot and LSN of the last export, if --cdc-slot */
+	if (pgsql_cdc_slot_name)
+	{
+		initArrowNode(&kv[1], KeyValue);
+		kv[1].key = "cdc_slot";
+		kv[1]._key_len = 8;
+		kv[1].value = pgsql_cdc_slot_name;
+		kv[1]._value_len = strlen(pgsql_cdc_slot_name);
+		initArrowNode(&kv[2], KeyValue);
+		kv[2].key = "cdc_lsn";
+		kv[2]._key_len = 7;
+		kv[2].value = cdc_lsn_buf;
+		kv[2]._value_len = sprintf(cdc_lsn_buf, "%X/%X",
+								   (uint32_t)(pgsql_cdc_lsn >> 32),
+								   (uint32_t)(pgsql_cdc_lsn & 0xffffffffU));
+		table->numCustomMetadata = 3;
+	}
+#endif	/* __PG2ARROW__ */
 
 	/* open & setup result file */
 	if (!append_filename)
@@ -1311,6 +1664,20 @@ int main(int argc, char * const argv[])
 										0);
 		sql_table_clear(table);
 	}
+#ifdef __PG2ARROW__
+	/* LSN of the end of the exported transactions */
+	if (pgsql_cdc_slot_name)
+	{
+		if (shows_progress)
+			printf("CDC: slot=%s lsn=%s -> %X/%X\n",
+				   pgsql_cdc_slot_name, cdc_lsn_buf,
+				   (uint32_t)(pgsql_cdc_lsn >> 32),
+				   (uint32_t)(pgsql_cdc_lsn & 0xffffffffU));
+		kv[2]._value_len = sprintf(cdc_lsn_buf, "%X/%X",
+								   (uint32_t)(pgsql_cdc_lsn >> 32),
+								   (uint32_t)(pgsql_cdc_lsn & 0xffffffffU));
+	}
+#endif	/* __PG2ARROW__ */
 	/* write out footer portion */
 	writeArrowFooter(table);
 
@@ -1322,6 +1689,8 @@ int main(int argc, char * const argv[])
 	{
 		time_t	elapsed = (time(NULL) - tv1);
 
+		shows_stage_statistics();
+
 		if (elapsed > 2 * 86400)	/* > 2days */
 			printf("Total elapsed time: %ld days %02ld:%02ld:%02ld\n",
 				   elapsed / 86400,
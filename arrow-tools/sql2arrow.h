@@ -41,6 +41,21 @@ sqldb_fetch_results(void *sqldb_state, SQLtable *table);
 extern void
 sqldb_close_connection(void *sqldb_state);
 
+extern bool
+sqldb_fetch_key_range(void *sqldb_state,
+					  const char *table_name,
+					  const char *key_name,
+					  int64_t *p_key_min,
+					  int64_t *p_key_max);
+
+/* pgsql_client.c specific configurations */
+extern bool		pgsql_copy_binary_mode;
+extern uint32_t	pgsql_fetch_chunk_size;
+extern char	   *pgsql_cdc_slot_name;
+extern char	   *pgsql_cdc_publication;
+extern const char *pgsql_cdc_table_name;
+extern uint64_t	pgsql_cdc_lsn;
+
 /* misc functions */
 extern void	   *palloc(size_t sz);
 extern void	   *palloc0(size_t sz);
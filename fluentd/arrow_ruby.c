@@ -10,8 +10,10 @@
  * it under the terms of the PostgreSQL License.
  */
 #include <ruby.h>
+#include <ruby/encoding.h>
 #include <ctype.h>
 #include <libgen.h>
+#include <math.h>
 #include <sys/file.h>
 #include "float2.h"
 #define Elog(fmt,...)							\
@@ -577,6 +579,15 @@ __ruby_fetch_timestamp_value(VALUE datum,
 
 	if (datum == Qnil)
 		return false;	/* NULL */
+	/* Is it Time? (fast path for the values by writeMsgpack) */
+	if (CLASS_OF(datum) == rb_cTime)
+	{
+		struct timespec	ts = rb_time_timespec(datum);
+
+		*p_sec = ts.tv_sec;
+		*p_nsec = ts.tv_nsec;
+		return true;
+	}
 try_again:
 	/* Is it Fluent::EventTime? */
 	cname = rb_class2name(CLASS_OF(datum));
@@ -857,6 +868,7 @@ static size_t
 put_ruby_utf8_value(SQLfield *column, const char *addr, int sz)
 {
 	static VALUE utf8_encoding = Qnil;
+	static int	utf8_encindex = -1;
 	VALUE		datum = (VALUE)addr;
 	size_t		row_index = column->nitems++;
 
@@ -871,8 +883,6 @@ put_ruby_utf8_value(SQLfield *column, const char *addr, int sz)
 	}
 	else
 	{
-		VALUE		encoding;
-
 		if (TYPE(datum) != T_STRING)
 			datum = rb_funcall(datum, rb_intern("to_s"), 0);
 		if (utf8_encoding == Qnil)
@@ -880,10 +890,10 @@ put_ruby_utf8_value(SQLfield *column, const char *addr, int sz)
 			VALUE	klass = rb_path2class("Encoding");
 
 			utf8_encoding = rb_const_get(klass, rb_intern("UTF_8"));
+			utf8_encindex = rb_utf8_encindex();
 		}
 		/* force to convert UTF-8 string, if needed */
-		encoding = rb_funcall(datum, rb_intern("encoding"), 0);
-		if (encoding != utf8_encoding)
+		if (rb_enc_get_index(datum) != utf8_encindex)
 			datum = rb_funcall(datum, rb_intern("encode"), 1, utf8_encoding);
 
 		sql_buffer_setbit(&column->nullmap, row_index);
@@ -1569,6 +1579,8 @@ __arrowFileWriteParseParams(VALUE self,
 	VALUE		ts_column = Qnil;
 	VALUE		tag_column = Qnil;
 	long		f_threshold = 10000;
+	long		t_threshold = 0;
+	bool		ts_column_stats = true;
 	int			i, count;
 
 	if (CLASS_OF(__params) == rb_cHash)
@@ -1592,6 +1604,21 @@ __arrowFileWriteParseParams(VALUE self,
 			if (f_threshold < 16 || f_threshold > 1048576)
 				Elog("filesize_threshold must be [16...1048576]");
 		}
+
+		datum = rb_funcall(__params, rb_intern("fetch"), 2,
+						   rb_str_new_cstr("filetime_threshold"), Qnil);
+		if (datum != Qnil)
+		{
+			datum = rb_funcall(datum, rb_intern("to_i"), 0);
+			t_threshold = NUM2LONG(datum);
+			if (t_threshold < 0)
+				Elog("filetime_threshold must not be negative");
+		}
+
+		datum = rb_funcall(__params, rb_intern("fetch"), 2,
+						   rb_str_new_cstr("ts_column_stats"), Qnil);
+		if (datum != Qnil)
+			ts_column_stats = RTEST(datum);
 	}
 	else if (__params != Qnil)
 		Elog("ArrowFileWrite: parameters must be Hash");
@@ -1614,6 +1641,10 @@ __arrowFileWriteParseParams(VALUE self,
 		{
 			rb_funcall(field, rb_intern("store"), 2,
 					   rb_str_new_cstr("ts_column"), Qtrue);
+			/* min/max statistics make the file prunable by timestamp */
+			if (ts_column_stats)
+				rb_funcall(field, rb_intern("store"), 2,
+						   rb_str_new_cstr("stat_enabled"), Qtrue);
 		}
 		else if (tag_column != Qnil &&
 				 rb_funcall(fname, rb_intern("=="), 1, tag_column) == Qtrue)
@@ -1624,6 +1655,9 @@ __arrowFileWriteParseParams(VALUE self,
 	}
 	rb_ivar_set(self, rb_intern("filesize_threshold"),
 				LONG2NUM(f_threshold << 20));
+	rb_ivar_set(self, rb_intern("filetime_threshold"),
+				LONG2NUM(t_threshold));
+	rb_ivar_set(self, rb_intern("file_opened_at"), Qnil);
 }
 
 static VALUE
@@ -1726,6 +1760,8 @@ arrowFileOpenFile(VALUE self, SQLtable *table)
 {
 	VALUE		pathname = rb_ivar_get(self, rb_intern("pathname"));
 	VALUE		threshold = rb_ivar_get(self, rb_intern("filesize_threshold"));
+	long		t_threshold = NUM2LONG(rb_ivar_get(self, rb_intern("filetime_threshold")));
+	VALUE		opened_at;
 	const char *str;
 	char	   *buf = alloca(2000);
 	uint32_t	bufsz = 2000;
@@ -1810,12 +1846,23 @@ arrowFileOpenFile(VALUE self, SQLtable *table)
 			Elog("failed on flock('%s'): %m", buf);
 		if (fstat(fdesc, &stat_buf) != 0)
 			Elog("failed on fstat('%s'): %m", buf);
+		/* time when the current file was opened at first */
+		opened_at = rb_ivar_get(self, rb_intern("file_opened_at"));
+		if (stat_buf.st_size == 0 || opened_at == Qnil)
+		{
+			opened_at = LONG2NUM(__time);
+			rb_ivar_set(self, rb_intern("file_opened_at"), opened_at);
+		}
 		/* check threshold */
-		if (stat_buf.st_size < NUM2LONG(threshold))
+		if (stat_buf.st_size < NUM2LONG(threshold) &&
+			(t_threshold == 0 ||
+			 stat_buf.st_size == 0 ||
+			 __time - NUM2LONG(opened_at) < t_threshold))
 			return (stat_buf.st_size == 0);		/* true, if new file */
 		/* file rotation, then retry */
 		__arrowFileSwitchFile(table, &stat_buf);
 		arrowFileCloseFile(table);
+		rb_ivar_set(self, rb_intern("file_opened_at"), Qnil);
 	}
 }
 
@@ -2002,6 +2049,7 @@ typedef struct
 	VALUE		self;
 	VALUE		chunk;
 	SQLtable   *table;
+	bool		is_msgpack;		/* chunk is a String in msgpack */
 } WriteChunkArgs;
 
 static SQLtable *
@@ -2136,28 +2184,401 @@ __arrowFileWriteRow(RB_BLOCK_CALL_FUNC_ARGLIST(__yield, __private))
 	return Qtrue;
 }
 
+/* ----------------------------------------------------------------
+ *
+ * Routines to decode msgpack chunks (for writeMsgpack)
+ *
+ * The fluentd buffer chunk is a sequence of [tag, time, record] in msgpack.
+ * It is decoded in C, and only the values of the schema columns are passed
+ * to the put_value handlers; no Hash objects are built for the records.
+ *
+ * ----------------------------------------------------------------
+ */
+typedef struct
+{
+	const unsigned char *pos;
+	const unsigned char *end;
+} mpackCursor;
+
+#define MPACK_EXT_EVENT_TIME	0
+
+static inline const unsigned char *
+__mpack_fetch_bytes(mpackCursor *cur, size_t sz)
+{
+	const unsigned char *pos = cur->pos;
+
+	if (sz > cur->end - pos)
+		Elog("msgpack chunk is truncated");
+	cur->pos += sz;
+	return pos;
+}
+
+static inline uint64_t
+__mpack_fetch_uint(mpackCursor *cur, int sz)
+{
+	const unsigned char *pos = __mpack_fetch_bytes(cur, sz);
+	uint64_t	value = 0;
+
+	for (int i=0; i < sz; i++)
+		value = (value << 8) | pos[i];
+	return value;
+}
+
+/*
+ * __mpack_fetch_header
+ *
+ * It fetches the header of the next object, and returns its format byte.
+ * *p_len is the length of str/bin/ext, or number of array/map items.
+ */
+static int
+__mpack_fetch_header(mpackCursor *cur, uint64_t *p_len)
+{
+	int		c = *__mpack_fetch_bytes(cur, 1);
+
+	*p_len = 0;
+	if (c <= 0x7f || c >= 0xe0)
+		return c;						/* positive/negative fixint */
+	if (c >= 0x80 && c <= 0x8f)
+	{
+		*p_len = (c & 0x0f);			/* fixmap */
+		return 0x80;
+	}
+	if (c >= 0x90 && c <= 0x9f)
+	{
+		*p_len = (c & 0x0f);			/* fixarray */
+		return 0x90;
+	}
+	if (c >= 0xa0 && c <= 0xbf)
+	{
+		*p_len = (c & 0x1f);			/* fixstr */
+		return 0xa0;
+	}
+	switch (c)
+	{
+		case 0xc4:	/* bin8 */
+		case 0xd9:	/* str8 */
+			*p_len = __mpack_fetch_uint(cur, 1);
+			break;
+		case 0xc5:	/* bin16 */
+		case 0xda:	/* str16 */
+		case 0xdc:	/* array16 */
+		case 0xde:	/* map16 */
+			*p_len = __mpack_fetch_uint(cur, 2);
+			break;
+		case 0xc6:	/* bin32 */
+		case 0xdb:	/* str32 */
+		case 0xdd:	/* array32 */
+		case 0xdf:	/* map32 */
+			*p_len = __mpack_fetch_uint(cur, 4);
+			break;
+		case 0xc7:	/* ext8 */
+			*p_len = __mpack_fetch_uint(cur, 1);
+			break;
+		case 0xc8:	/* ext16 */
+			*p_len = __mpack_fetch_uint(cur, 2);
+			break;
+		case 0xc9:	/* ext32 */
+			*p_len = __mpack_fetch_uint(cur, 4);
+			break;
+		case 0xd4:	/* fixext1 */
+			*p_len = 1;
+			break;
+		case 0xd5:	/* fixext2 */
+			*p_len = 2;
+			break;
+		case 0xd6:	/* fixext4 */
+			*p_len = 4;
+			break;
+		case 0xd7:	/* fixext8 */
+			*p_len = 8;
+			break;
+		case 0xd8:	/* fixext16 */
+			*p_len = 16;
+			break;
+		case 0xc1:
+			Elog("msgpack chunk contains the never-used format code");
+		default:
+			break;
+	}
+	return c;
+}
+
+/*
+ * __mpack_skip_object
+ */
+static void
+__mpack_skip_object(mpackCursor *cur)
+{
+	uint64_t	len, i;
+	int			c = __mpack_fetch_header(cur, &len);
+
+	switch (c)
+	{
+		case 0x80: case 0xde: case 0xdf:	/* map */
+			for (i=0; i < 2 * len; i++)
+				__mpack_skip_object(cur);
+			break;
+		case 0x90: case 0xdc: case 0xdd:	/* array */
+			for (i=0; i < len; i++)
+				__mpack_skip_object(cur);
+			break;
+		case 0xa0: case 0xd9: case 0xda: case 0xdb:	/* str */
+		case 0xc4: case 0xc5: case 0xc6:			/* bin */
+			__mpack_fetch_bytes(cur, len);
+			break;
+		case 0xc7: case 0xc8: case 0xc9:			/* ext */
+		case 0xd4: case 0xd5: case 0xd6: case 0xd7: case 0xd8:
+			__mpack_fetch_bytes(cur, len + 1);
+			break;
+		case 0xca: case 0xcc: case 0xd0:
+			__mpack_fetch_bytes(cur, c == 0xca ? 4 : 1);
+			break;
+		case 0xcb: case 0xcf: case 0xd3:
+			__mpack_fetch_bytes(cur, 8);
+			break;
+		case 0xcd: case 0xd1:
+			__mpack_fetch_bytes(cur, 2);
+			break;
+		case 0xce: case 0xd2:
+			__mpack_fetch_bytes(cur, 4);
+			break;
+		default:
+			break;		/* fixint, nil, bool */
+	}
+}
+
+/*
+ * __mpack_fetch_value
+ *
+ * It decodes the next object to Ruby VALUE for the put_value handlers.
+ * Strings are copied to the 'scratch' buffer for each column, to avoid
+ * allocation of Ruby objects per value. Array, Map and unknown ext types
+ * are rarely used in the schema columns, so they are unpacked by the
+ * MessagePack module.
+ */
+static VALUE
+__mpack_fetch_value(mpackCursor *cur, VALUE scratch)
+{
+	const unsigned char *head = cur->pos;
+	const unsigned char *ptr;
+	uint64_t	len;
+	uint64_t	ival;
+	int			c = __mpack_fetch_header(cur, &len);
+
+	if (c <= 0x7f)
+		return INT2FIX(c);
+	if (c >= 0xe0)
+		return INT2FIX((int8_t)c);
+	switch (c)
+	{
+		case 0xc0:
+			return Qnil;
+		case 0xc2:
+			return Qfalse;
+		case 0xc3:
+			return Qtrue;
+		case 0xa0: case 0xd9: case 0xda: case 0xdb:	/* str */
+		case 0xc4: case 0xc5: case 0xc6:			/* bin */
+			ptr = __mpack_fetch_bytes(cur, len);
+			rb_str_resize(scratch, len);
+			memcpy(RSTRING_PTR(scratch), ptr, len);
+			return scratch;
+		case 0xca:	/* float32 */
+			{
+				union {
+					uint32_t	ival;
+					float		fval;
+				} u;
+				u.ival = __mpack_fetch_uint(cur, 4);
+				return DBL2NUM((double)u.fval);
+			}
+		case 0xcb:	/* float64 */
+			{
+				union {
+					uint64_t	ival;
+					double		fval;
+				} u;
+				u.ival = __mpack_fetch_uint(cur, 8);
+				return DBL2NUM(u.fval);
+			}
+		case 0xcc:	/* uint8 */
+			return INT2FIX(__mpack_fetch_uint(cur, 1));
+		case 0xcd:	/* uint16 */
+			return INT2FIX(__mpack_fetch_uint(cur, 2));
+		case 0xce:	/* uint32 */
+			return ULONG2NUM(__mpack_fetch_uint(cur, 4));
+		case 0xcf:	/* uint64 */
+			return ULL2NUM(__mpack_fetch_uint(cur, 8));
+		case 0xd0:	/* int8 */
+			return INT2FIX((int8_t)__mpack_fetch_uint(cur, 1));
+		case 0xd1:	/* int16 */
+			return INT2FIX((int16_t)__mpack_fetch_uint(cur, 2));
+		case 0xd2:	/* int32 */
+			return LONG2NUM((int32_t)__mpack_fetch_uint(cur, 4));
+		case 0xd3:	/* int64 */
+			ival = __mpack_fetch_uint(cur, 8);
+			return LL2NUM((int64_t)ival);
+		case 0xd7:	/* fixext8 */
+		case 0xc7:	/* ext8 */
+			if (len == 8 && *cur->pos == MPACK_EXT_EVENT_TIME)
+			{
+				uint64_t	sec, nsec;
+
+				__mpack_fetch_bytes(cur, 1);
+				sec  = __mpack_fetch_uint(cur, 4);
+				nsec = __mpack_fetch_uint(cur, 4);
+				return rb_time_nano_new(sec, nsec);
+			}
+			break;
+		default:
+			break;
+	}
+	/* elsewhere, unpack the object by the MessagePack module */
+	cur->pos = head;
+	__mpack_skip_object(cur);
+	return rb_funcall(rb_path2class("MessagePack"), rb_intern("unpack"), 1,
+					  rb_str_new((const char *)head, cur->pos - head));
+}
+
+/*
+ * __mpack_fetch_time
+ *
+ * It decodes the event time; EventTime ext type, Integer or Float
+ */
+static VALUE
+__mpack_fetch_time(mpackCursor *cur, VALUE scratch)
+{
+	VALUE	datum = __mpack_fetch_value(cur, scratch);
+
+	if (RB_FLOAT_TYPE_P(datum))
+	{
+		double	fval = NUM2DBL(datum);
+		double	sec = floor(fval);
+
+		datum = rb_time_nano_new((time_t)sec,
+								 (long)((fval - sec) * 1000000000.0));
+	}
+	return datum;
+}
+
+static VALUE
+__arrowFileWriteMsgpack(WriteChunkArgs *args)
+{
+	SQLtable   *table = args->table;
+	VALUE		data = args->chunk;
+	VALUE	   *values = alloca(sizeof(VALUE) * table->nfields);
+	VALUE	   *scratch = alloca(sizeof(VALUE) * (table->nfields + 2));
+	size_t	   *namelen = alloca(sizeof(size_t) * table->nfields);
+	mpackCursor	cur;
+	int			j;
+
+	StringValue(data);
+	cur.pos = (const unsigned char *)RSTRING_PTR(data);
+	cur.end = cur.pos + RSTRING_LEN(data);
+	for (j=0; j < table->nfields + 2; j++)
+	{
+		scratch[j] = rb_str_buf_new(64);
+		rb_enc_associate_index(scratch[j], rb_utf8_encindex());
+		if (j < table->nfields)
+			namelen[j] = strlen(table->columns[j].field_name);
+	}
+
+	while (cur.pos < cur.end)
+	{
+		VALUE		tag;
+		VALUE		ts;
+		uint64_t	len, i;
+		int			c;
+
+		/* [tag, time, record] */
+		c = __mpack_fetch_header(&cur, &len);
+		if ((c != 0x90 && c != 0xdc && c != 0xdd) || len != 3)
+			Elog("msgpack chunk must be a sequence of [tag, time, record]");
+		tag = __mpack_fetch_value(&cur, scratch[table->nfields]);
+		ts = __mpack_fetch_time(&cur, scratch[table->nfields + 1]);
+
+		for (j=0; j < table->nfields; j++)
+		{
+			SQLfield   *column = &table->columns[j];
+
+			if (column->sql_type.fluent.ts_column)
+				values[j] = ts;
+			else if (column->sql_type.fluent.tag_column)
+				values[j] = tag;
+			else
+				values[j] = Qnil;
+		}
+		c = __mpack_fetch_header(&cur, &len);
+		if (c != 0x80 && c != 0xde && c != 0xdf)
+			Elog("record of the msgpack chunk must be map");
+		for (i=0; i < len; i++)
+		{
+			const unsigned char *head = cur.pos;
+			const unsigned char *key = NULL;
+			uint64_t	keylen;
+
+			c = __mpack_fetch_header(&cur, &keylen);
+			if (c == 0xa0 || c == 0xd9 || c == 0xda || c == 0xdb)
+				key = __mpack_fetch_bytes(&cur, keylen);
+			else
+			{
+				/* not a string key; never match to the columns */
+				cur.pos = head;
+				__mpack_skip_object(&cur);
+			}
+			for (j=0; key && j < table->nfields; j++)
+			{
+				SQLfield   *column = &table->columns[j];
+
+				if (!column->sql_type.fluent.ts_column &&
+					!column->sql_type.fluent.tag_column &&
+					namelen[j] == keylen &&
+					memcmp(column->field_name, key, keylen) == 0)
+					break;
+			}
+			if (key && j < table->nfields)
+				values[j] = __mpack_fetch_value(&cur, scratch[j]);
+			else
+				__mpack_skip_object(&cur);
+		}
+		for (j=0; j < table->nfields; j++)
+		{
+			SQLfield   *column = &table->columns[j];
+
+			column->put_value(column, (const char *)values[j], -1);
+		}
+		table->nitems++;
+	}
+	RB_GC_GUARD(data);
+	return Qtrue;
+}
+
 static VALUE
 __arrowFileWriteChunk(VALUE __args)
 {
 	WriteChunkArgs *args = (WriteChunkArgs *)__args;
 	SQLtable   *table;
+	ArrowBlock	block;
 
 	/* setup SQLtable buffer */
 	args->table = table = __arrowFileCreateTable(args->self);
 	/* iterate chunk to fill up the buffer */
-	rb_block_call(args->chunk,
-				  rb_intern("each"),
-				  0,
-				  NULL,
-				  __arrowFileWriteRow,
-				  __args);
+	if (args->is_msgpack)
+		__arrowFileWriteMsgpack(args);
+	else
+		rb_block_call(args->chunk,
+					  rb_intern("each"),
+					  0,
+					  NULL,
+					  __arrowFileWriteRow,
+					  __args);
 	/* open the destination file */
 	if (arrowFileOpenFile(args->self, args->table))
 		arrowFileSetupNewFile(args->table);
 	else
 		arrowFileSetupAppend(args->table);
 	/* write out a new record-batch */
-	writeArrowRecordBatch(table);
+	writeArrowRecordBatch(table, &block);
 	/* write out a new footer */
 	writeArrowFooter(table);
 	/* close the file, and unlock */
@@ -2167,8 +2588,9 @@ __arrowFileWriteChunk(VALUE __args)
 }
 
 static VALUE
-rb_ArrowFileWrite__writeChunk(VALUE self,
-							  VALUE chunk)
+__arrowFileWriteCommon(VALUE self,
+					   VALUE chunk,
+					   bool is_msgpack)
 {
 	WriteChunkArgs args;
 	VALUE		retval;
@@ -2177,6 +2599,7 @@ rb_ArrowFileWrite__writeChunk(VALUE self,
 	memset(&args, 0, sizeof(WriteChunkArgs));
 	args.self  = self;
 	args.chunk = chunk;
+	args.is_msgpack = is_msgpack;
 
 	retval = rb_protect(__arrowFileWriteChunk, (VALUE)&args, &status);
 	if (status != 0)
@@ -2195,6 +2618,24 @@ rb_ArrowFileWrite__writeChunk(VALUE self,
 	return retval;
 }
 
+static VALUE
+rb_ArrowFileWrite__writeChunk(VALUE self,
+							  VALUE chunk)
+{
+	return __arrowFileWriteCommon(self, chunk, false);
+}
+
+/*
+ * writeMsgpack - writes out the fluentd buffer chunk in msgpack format
+ * (sequence of [tag, time, record]) without decoding in Ruby.
+ */
+static VALUE
+rb_ArrowFileWrite__writeMsgpack(VALUE self,
+								VALUE data)
+{
+	return __arrowFileWriteCommon(self, data, true);
+}
+
 void
 Init_arrow_file_write(void)
 {
@@ -2203,4 +2644,5 @@ Init_arrow_file_write(void)
 	klass = rb_define_class("ArrowFileWrite",  rb_cObject);
 	rb_define_method(klass, "initialize", rb_ArrowFileWrite__initialize, 3);
 	rb_define_method(klass, "writeChunk", rb_ArrowFileWrite__writeChunk, 1);
+	rb_define_method(klass, "writeMsgpack", rb_ArrowFileWrite__writeMsgpack, 1);
 }
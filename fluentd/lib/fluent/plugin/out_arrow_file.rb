@@ -14,6 +14,10 @@ module Fluent
       config_param :ts_column, :string, default: NIL
       config_param :tag_column, :string, default: NIL
       config_param :filesize_threshold, :integer, default: 10000
+      desc "Rotate the arrow file after this seconds (0 means no time rotation)"
+      config_param :filetime_threshold, :integer, default: 0
+      desc "Embed min/max statistics of the ts_column for each record batch"
+      config_param :ts_column_stats, :bool, default: true
 
       config_section :buffer do
         config_set_default :@type, 'memory'
@@ -34,7 +38,7 @@ module Fluent
         compat_parameters_convert(conf, :buffer, :inject, default_chunk_key: "time")
         super
 
-        @af=ArrowFileWrite.new(@path,@schema_defs,{"ts_column" => @ts_column,"tag_column" => @tag_column,"filesize_threshold" => @filesize_threshold})
+        @af=ArrowFileWrite.new(@path,@schema_defs,{"ts_column" => @ts_column,"tag_column" => @tag_column,"filesize_threshold" => @filesize_threshold,"filetime_threshold" => @filetime_threshold,"ts_column_stats" => @ts_column_stats})
       end
 
       def format(tag,time,record)
@@ -47,7 +51,8 @@ module Fluent
       end
 
       def write(chunk)
-        @af.writeChunk(chunk)
+        # the chunk is decoded by the extension, not by Ruby
+        @af.writeMsgpack(chunk.read)
       end
     end
   end
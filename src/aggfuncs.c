@@ -48,6 +48,11 @@ PG_FUNCTION_INFO_V1(pgstrom_fsum_final_fp64_as_numeric);
 PG_FUNCTION_INFO_V1(pgstrom_favg_final_int);
 PG_FUNCTION_INFO_V1(pgstrom_favg_final_fp);
 PG_FUNCTION_INFO_V1(pgstrom_favg_final_num);
+PG_FUNCTION_INFO_V1(pgstrom_partial_sum_numeric);
+PG_FUNCTION_INFO_V1(pgstrom_partial_sum_int128);
+PG_FUNCTION_INFO_V1(pgstrom_fsum_trans_numeric);
+PG_FUNCTION_INFO_V1(pgstrom_fsum_final_numeric);
+PG_FUNCTION_INFO_V1(pgstrom_favg_final_numeric);
 
 PG_FUNCTION_INFO_V1(pgstrom_partial_variance);
 PG_FUNCTION_INFO_V1(pgstrom_stddev_trans);
@@ -75,6 +80,11 @@ PG_FUNCTION_INFO_V1(pgstrom_regr_sxx_final);
 PG_FUNCTION_INFO_V1(pgstrom_regr_sxy_final);
 PG_FUNCTION_INFO_V1(pgstrom_regr_syy_final);
 
+PG_FUNCTION_INFO_V1(pgstrom_partial_percentile);
+PG_FUNCTION_INFO_V1(pgstrom_percentile_sketch_accum);
+PG_FUNCTION_INFO_V1(pgstrom_percentile_sketch_trans);
+PG_FUNCTION_INFO_V1(pgstrom_percentile_approx);
+
 /*
  * float8 validator
  */
@@ -487,6 +497,191 @@ pgstrom_favg_final_num(PG_FUNCTION_ARGS)
 	PG_RETURN_DATUM(DirectFunctionCall2(numeric_div, sum, n));
 }
 
+/*
+ * SUM(X),AVG(X) of fixed-point numeric
+ */
+#define FIXED_NUMERIC_MAX	((int128_t)(~((unsigned __int128)0) >> 1))
+#define FIXED_NUMERIC_MIN	(-FIXED_NUMERIC_MAX - 1)
+
+static int128_t
+__fixed_numeric_rescale(int128_t ival, int scale, int new_scale)
+{
+	while (scale < new_scale)
+	{
+		if (ival > FIXED_NUMERIC_MAX / 10 || ival < FIXED_NUMERIC_MIN / 10)
+			ereport(ERROR,
+					(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+					 errmsg("numeric value out of range")));
+		ival *= 10;
+		scale++;
+	}
+	return ival;
+}
+
+static Datum
+__fixed_numeric_to_numeric(int128_t ival, int scale)
+{
+	char		buf[80];
+	char	   *pos = buf + sizeof(buf);
+	bool		negative = (ival < 0);
+	unsigned __int128 uval = (negative
+							  ? -((unsigned __int128)ival)
+							  : ((unsigned __int128)ival));
+	int			ndigits = 0;
+
+	*--pos = '\0';
+	do {
+		if (ndigits++ == scale && scale > 0)
+			*--pos = '.';
+		*--pos = '0' + (int)(uval % 10);
+		uval /= 10;
+	} while (uval != 0 || ndigits <= scale);
+	if (negative)
+		*--pos = '-';
+	return DirectFunctionCall3(numeric_in,
+							   CStringGetDatum(pos),
+							   ObjectIdGetDatum(InvalidOid),
+							   Int32GetDatum(-1));
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_partial_sum_numeric(PG_FUNCTION_ARGS)
+{
+	kagg_state__psum_numeric_packed *r;
+	char	   *str;
+	int128_t	ival = 0;
+	int			scale = 0;
+	bool		negative = false;
+	bool		fraction = false;
+
+	r = palloc0(sizeof(kagg_state__psum_numeric_packed));
+	SET_VARSIZE(r, sizeof(kagg_state__psum_numeric_packed));
+	str = DatumGetCString(DirectFunctionCall1(numeric_out,
+											  PG_GETARG_DATUM(0)));
+	if (strcmp(str, "NaN") == 0)
+	{
+		r->nnans = 1;
+		PG_RETURN_POINTER(r);
+	}
+	for (char *pos = str; *pos != '\0'; pos++)
+	{
+		if (*pos == '-')
+			negative = true;
+		else if (*pos == '.')
+			fraction = true;
+		else if (isdigit(*pos))
+		{
+			ival = __fixed_numeric_rescale(ival, 0, 1) + (*pos - '0');
+			if (fraction)
+				scale++;
+		}
+		else
+			elog(ERROR, "unexpected numeric format: %s", str);
+	}
+	r->nitems = 1;
+	r->scale = scale;
+	__kagg_psum_numeric_set_sum(r, negative ? -ival : ival);
+
+	PG_RETURN_POINTER(r);
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_partial_sum_int128(PG_FUNCTION_ARGS)
+{
+	kagg_state__psum_numeric_packed *r;
+
+	r = palloc0(sizeof(kagg_state__psum_numeric_packed));
+	SET_VARSIZE(r, sizeof(kagg_state__psum_numeric_packed));
+	r->nitems = 1;
+	r->scale = 0;
+	__kagg_psum_numeric_set_sum(r, (int128_t)PG_GETARG_INT64(0));
+
+	PG_RETURN_POINTER(r);
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_fsum_trans_numeric(PG_FUNCTION_ARGS)
+{
+	kagg_state__psum_numeric_packed *state;
+	kagg_state__psum_numeric_packed *arg;
+	MemoryContext	aggcxt;
+
+	if (!AggCheckCallContext(fcinfo, &aggcxt))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+	if (PG_ARGISNULL(0))
+	{
+		if (PG_ARGISNULL(1))
+			PG_RETURN_NULL();
+		arg = (kagg_state__psum_numeric_packed *)PG_GETARG_BYTEA_P(1);
+		state = MemoryContextAlloc(aggcxt, sizeof(*state));
+		memcpy(state, arg, sizeof(*state));
+	}
+	else
+	{
+		state = (kagg_state__psum_numeric_packed *)PG_GETARG_BYTEA_P(0);
+		if (!PG_ARGISNULL(1))
+		{
+			int128_t	x, y;
+			int			scale;
+
+			arg = (kagg_state__psum_numeric_packed *)PG_GETARG_BYTEA_P(1);
+			/* partial results may have different scale */
+			scale = Max(state->scale, arg->scale);
+			x = __fixed_numeric_rescale(__kagg_psum_numeric_get_sum(state),
+										state->scale, scale);
+			y = __fixed_numeric_rescale(__kagg_psum_numeric_get_sum(arg),
+										arg->scale, scale);
+			if ((y > 0 && x > FIXED_NUMERIC_MAX - y) ||
+				(y < 0 && x < FIXED_NUMERIC_MIN - y))
+				ereport(ERROR,
+						(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+						 errmsg("numeric value out of range")));
+			state->nitems += arg->nitems;
+			state->nnans  += arg->nnans;
+			state->scale   = scale;
+			__kagg_psum_numeric_set_sum(state, x + y);
+		}
+	}
+	PG_RETURN_POINTER(state);
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_fsum_final_numeric(PG_FUNCTION_ARGS)
+{
+	kagg_state__psum_numeric_packed *state;
+
+	state = (kagg_state__psum_numeric_packed *)PG_GETARG_BYTEA_P(0);
+	if (state->nitems == 0 && state->nnans == 0)
+		PG_RETURN_NULL();
+	if (state->nnans > 0)
+		PG_RETURN_DATUM(DirectFunctionCall3(numeric_in,
+											CStringGetDatum("NaN"),
+											ObjectIdGetDatum(InvalidOid),
+											Int32GetDatum(-1)));
+	PG_RETURN_DATUM(__fixed_numeric_to_numeric(__kagg_psum_numeric_get_sum(state),
+											   state->scale));
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_favg_final_numeric(PG_FUNCTION_ARGS)
+{
+	kagg_state__psum_numeric_packed *state;
+	Datum	n, sum;
+
+	state = (kagg_state__psum_numeric_packed *)PG_GETARG_BYTEA_P(0);
+	if (state->nitems == 0 && state->nnans == 0)
+		PG_RETURN_NULL();
+	if (state->nnans > 0)
+		PG_RETURN_DATUM(DirectFunctionCall3(numeric_in,
+											CStringGetDatum("NaN"),
+											ObjectIdGetDatum(InvalidOid),
+											Int32GetDatum(-1)));
+	n = DirectFunctionCall1(int8_numeric, Int64GetDatum(state->nitems));
+	sum = __fixed_numeric_to_numeric(__kagg_psum_numeric_get_sum(state),
+									 state->scale);
+	PG_RETURN_DATUM(DirectFunctionCall2(numeric_div, sum, n));
+}
+
 /*
  * STDDEV/VARIANCE
  */
@@ -828,6 +1023,177 @@ pgstrom_regr_syy_final(PG_FUNCTION_ARGS)
 	PG_RETURN_NULL();
 }
 
+/*
+ * PERCENTILE_SKETCH(X) / PERCENTILE_APPROX(SKETCH, FRACTION)
+ */
+static void
+__percentile_sketch_init(kagg_state__pctile_packed *state)
+{
+	memset(state, 0, sizeof(kagg_state__pctile_packed));
+	state->min_value = DBL_MAX;
+	state->max_value = -DBL_MAX;
+	SET_VARSIZE(state, sizeof(kagg_state__pctile_packed));
+}
+
+static void
+__percentile_sketch_update(kagg_state__pctile_packed *state, float8 fval)
+{
+	int		index = __kagg_pctile_bucket_index(fval);
+
+	state->nitems++;
+	state->min_value = Min(state->min_value, fval);
+	state->max_value = Max(state->max_value, fval);
+	if (index < 0)
+		state->nzeros++;
+	else if (fval < 0.0)
+		state->negative[index]++;
+	else
+		state->positive[index]++;
+}
+
+static kagg_state__pctile_packed *
+__percentile_sketch_fetch_arg(FunctionCallInfo fcinfo, int argno)
+{
+	bytea	   *arg = PG_GETARG_BYTEA_P(argno);
+
+	if (VARSIZE(arg) != sizeof(kagg_state__pctile_packed))
+		elog(ERROR, "percentile sketch looks corrupted");
+	return (kagg_state__pctile_packed *)arg;
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_partial_percentile(PG_FUNCTION_ARGS)
+{
+	kagg_state__pctile_packed *r = palloc(sizeof(kagg_state__pctile_packed));
+
+	__percentile_sketch_init(r);
+	__percentile_sketch_update(r, PG_GETARG_FLOAT8(0));
+
+	PG_RETURN_POINTER(r);
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_percentile_sketch_accum(PG_FUNCTION_ARGS)
+{
+	kagg_state__pctile_packed *state;
+	MemoryContext	aggcxt;
+
+	if (!AggCheckCallContext(fcinfo, &aggcxt))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+	if (PG_ARGISNULL(0))
+	{
+		state = MemoryContextAlloc(aggcxt, sizeof(kagg_state__pctile_packed));
+		__percentile_sketch_init(state);
+	}
+	else
+	{
+		state = (kagg_state__pctile_packed *)PG_GETARG_BYTEA_P(0);
+	}
+	if (!PG_ARGISNULL(1))
+		__percentile_sketch_update(state, PG_GETARG_FLOAT8(1));
+	PG_RETURN_POINTER(state);
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_percentile_sketch_trans(PG_FUNCTION_ARGS)
+{
+	kagg_state__pctile_packed *state;
+	kagg_state__pctile_packed *arg;
+	MemoryContext	aggcxt;
+
+	if (!AggCheckCallContext(fcinfo, &aggcxt))
+		elog(ERROR, "aggregate function called in non-aggregate context");
+	if (PG_ARGISNULL(0))
+	{
+		if (PG_ARGISNULL(1))
+			PG_RETURN_NULL();
+		arg = __percentile_sketch_fetch_arg(fcinfo, 1);
+		state = MemoryContextAlloc(aggcxt, sizeof(*state));
+		memcpy(state, arg, sizeof(*state));
+	}
+	else
+	{
+		state = (kagg_state__pctile_packed *)PG_GETARG_BYTEA_P(0);
+		if (!PG_ARGISNULL(1))
+		{
+			arg = __percentile_sketch_fetch_arg(fcinfo, 1);
+			if (arg->nitems > 0)
+			{
+				state->nitems += arg->nitems;
+				state->min_value = Min(state->min_value, arg->min_value);
+				state->max_value = Max(state->max_value, arg->max_value);
+				state->nzeros += arg->nzeros;
+				for (int k=0; k < KAGG_PCTILE_NBUCKETS; k++)
+				{
+					state->negative[k] += arg->negative[k];
+					state->positive[k] += arg->positive[k];
+				}
+			}
+		}
+	}
+	PG_RETURN_POINTER(state);
+}
+
+PUBLIC_FUNCTION(Datum)
+pgstrom_percentile_approx(PG_FUNCTION_ARGS)
+{
+	kagg_state__pctile_packed *state = __percentile_sketch_fetch_arg(fcinfo, 0);
+	float8		fraction = PG_GETARG_FLOAT8(1);
+	float8		fval;
+	uint64		rank;
+	uint64		count = 0;
+
+	if (fraction < 0.0 || fraction > 1.0 || isnan(fraction))
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("percentile value %g is not between 0 and 1",
+						fraction)));
+	if (state->nitems == 0)
+		PG_RETURN_NULL();
+	/* exact values for the edge */
+	if (fraction == 0.0)
+		PG_RETURN_FLOAT8(state->min_value);
+	if (fraction == 1.0)
+		PG_RETURN_FLOAT8(state->max_value);
+
+	rank = (uint64)ceil(fraction * (float8)state->nitems);
+	if (rank < 1)
+		rank = 1;
+	/* negative values, from the larger absolute value */
+	for (int k=KAGG_PCTILE_NBUCKETS-1; k >= 0; k--)
+	{
+		count += state->negative[k];
+		if (count >= rank)
+		{
+			fval = -__kagg_pctile_bucket_value(k);
+			goto found;
+		}
+	}
+	/* zero (or very small) values */
+	count += state->nzeros;
+	if (count >= rank)
+	{
+		fval = 0.0;
+		goto found;
+	}
+	/* positive values */
+	for (int k=0; k < KAGG_PCTILE_NBUCKETS; k++)
+	{
+		count += state->positive[k];
+		if (count >= rank)
+		{
+			fval = __kagg_pctile_bucket_value(k);
+			goto found;
+		}
+	}
+	fval = state->max_value;
+found:
+	/* estimation must be in the range of min/max values */
+	fval = Max(fval, state->min_value);
+	fval = Min(fval, state->max_value);
+	PG_RETURN_FLOAT8(fval);
+}
+
 #if 0
 /*
  * ----------------------------------------------------------------
@@ -595,6 +595,10 @@ typedef struct
 	ArrowFooter		footer;
 	ArrowMessage   *dictionaries;	/* array of ArrowDictionaryBatch */
 	ArrowMessage   *recordBatches;	/* array of ArrowRecordBatch */
+	bool			is_parquet;		/* true, if built from Apache Parquet;
+									 * buffers may not be aligned */
+	size_t			stream_length;	/* valid length of the IPC stream, or 0
+									 * if Arrow file with footer */
 } ArrowFileInfo;
 
 #endif		/* !__CUDACC__ */
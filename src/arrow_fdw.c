@@ -13,6 +13,12 @@
 #include "arrow_defs.h"
 #include "arrow_ipc.h"
 #include "xpu_numeric.h"
+#ifdef HAVE_LIBLZ4
+#include <lz4frame.h>
+#endif
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
 
 /*
  * min/max statistics datum
@@ -47,6 +53,14 @@ typedef struct RecordBatchFieldState
 	size_t		values_length;
 	off_t		extra_offset;
 	size_t		extra_length;
+	/*
+	 * (only dictionary-encoded columns)
+	 * values/extra buffers describe the dictionary, then dict_index buffer
+	 * maps the rows to the dictionary entries.
+	 */
+	int			dict_index_sz;		/* width of the index, or 0 */
+	off_t		dict_index_offset;
+	size_t		dict_index_length;
 	MinMaxStatDatum stat_datum;
 	/* sub-fields if any */
 	int			num_children;
@@ -60,22 +74,47 @@ typedef struct RecordBatchState
 	off_t		rb_offset;	/* offset from the head */
 	size_t		rb_length;	/* length of the entire RecordBatch */
 	int64		rb_nitems;	/* number of items */
+	int			rb_codec;	/* ArrowCompressionType, or -1 if none */
+	int			zone_index;	/* index of the zone in the record-batch, or -1 */
+	List	   *zone_states;	/* list of RecordBatchState per zone, if any */
 	/* per column information */
 	int			nfields;
 	RecordBatchFieldState fields[FLEXIBLE_ARRAY_MEMBER];
 } RecordBatchState;
 
+/*
+ * arrowBloomFilter - bloom filter of a field per record-batch
+ */
+typedef struct
+{
+	uint32_t	nbits;		/* width of the bitmap; power of 2 */
+	uint32_t	nhashes;	/* number of hash functions */
+	uint8_t		bitmap[FLEXIBLE_ARRAY_MEMBER];
+} arrowBloomFilter;
+
 typedef struct ArrowFileState
 {
 	const char *filename;
 	const char *dpu_path;	/* relative pathname, if DPU */
 	struct stat	stat_buf;
+	size_t		stream_length;	/* valid length of IPC stream, or 0 */
 	List	   *rb_list;	/* list of RecordBatchState */
+	/* bloom filters, if loaded */
+	int			bloom_nfields;
+	arrowBloomFilter **bloom_filters;	/* [rb_index * bloom_nfields + j] */
 } ArrowFileState;
 
 /*
  * ArrowFdwState - executor state to run apache arrow
  */
+typedef struct
+{
+	AttrNumber		anum;			/* attribute number */
+	Oid				keytype;		/* type of the keys */
+	int				nkeys;			/* number of keys (IN-list) */
+	Datum			keys[FLEXIBLE_ARRAY_MEMBER];
+} arrowBloomHint;
+
 typedef struct
 {
 	Bitmapset	   *stat_attrs;
@@ -84,11 +123,33 @@ typedef struct
 	List		   *eval_quals;
 	ExprState	   *eval_state;
 	ExprContext	   *econtext;
+	List		   *bloom_hints;	/* list of arrowBloomHint */
 } arrowStatsHint;
 
+/*
+ * arrowVecQual - simple comparison of a fixed-length column and a constant,
+ * evaluated for each record-batch by vectorized loops.
+ */
+typedef struct
+{
+	Expr		   *expr;			/* original qualifier (for EXPLAIN) */
+	int				attidx;			/* index of colmeta[] */
+	int				strategy;		/* BT*StrategyNumber, or 0 for '<>' */
+	bool			is_float;		/* true, if FloatingPoint */
+	int64_t			ival;			/* constant of Int */
+	float8			fval;			/* constant of FloatingPoint */
+} arrowVecQual;
+
 struct ArrowFdwState
 {
 	Bitmapset		   *referenced;		/* referenced columns */
+	Bitmapset		   *late_referenced;	/* columns for late-materialization */
+	uint32_t			late_nskip;		/* record-batches skipped by the above */
+	List			   *vec_quals;		/* list of arrowVecQual */
+	uint8_t			   *vec_mask;		/* buffer for the row mask */
+	uint32_t		   *vec_sel;		/* selection vector of curr_kds */
+	uint32_t			vec_nrooms;		/* capacity of the above buffers */
+	uint64_t			vec_nfiltered;	/* rows removed by vectorized filter */
 	arrowStatsHint	   *stats_hint;		/* min/max statistics, if any */
 	pg_atomic_uint32   *rbatch_index;
 	pg_atomic_uint32	__rbatch_index_local;	/* if single process */
@@ -100,7 +161,13 @@ struct ArrowFdwState
 	File				curr_filp;		/* current arrow file to read */
 	kern_data_store	   *curr_kds;		/* current chunk to read */
 	uint32_t			curr_index;		/* current index on the chunk */
+	uint32_t			curr_nitems;	/* number of rows (or vec_sel) to read */
 	List			   *af_states_list;	/* list of ArrowFileState */
+	RecordBatchState   *zone_merged;	/* buffer to merge contiguous zones */
+	/* runtime statistics for the cost calibration (only CPU scan) */
+	TimestampTz			calib_start_ts;
+	uint64_t			calib_nbytes;
+	uint64_t			calib_ntuples;
 	uint32_t			rb_nitems;		/* number of record-batches */
 	RecordBatchState   *rb_states[FLEXIBLE_ARRAY_MEMBER]; /* flatten RecordBatchState */
 };
@@ -138,6 +205,9 @@ struct arrowMetadataFieldCache
 	size_t		values_length;
 	off_t		extra_offset;
 	size_t		extra_length;
+	int			dict_index_sz;
+	off_t		dict_index_offset;
+	size_t		dict_index_length;
 	MinMaxStatDatum stat_datum;
 	/* sub-fields if any */
 	int			num_children;
@@ -157,6 +227,9 @@ struct arrowMetadataCache
 	off_t		rb_offset;	/* offset from the head */
 	size_t		rb_length;	/* length of the entire RecordBatch */
 	int64		rb_nitems;	/* number of items */
+	int			rb_codec;	/* ArrowCompressionType, or -1 if none */
+	int			zone_index;	/* index of the zone, or -1 if record-batch */
+	size_t		stream_length;	/* valid length of IPC stream, or 0 */
 	/* per column information */
 	int			nfields;
 	dlist_head	fields;		/* list of arrowMetadataFieldCache */
@@ -172,10 +245,18 @@ typedef struct
 	LWLock		mutex;
 	slock_t		lru_lock;		/* protect lru related stuff */
 	dlist_head	lru_list;
+	uint32_t	num_files;		/* number of files in lru_list */
+	uint32_t	num_blocks;		/* number of arrowMetadataCacheBlock */
 	dlist_head	free_blocks;	/* list of arrowMetadataCacheBlock */
 	dlist_head	free_mcaches;	/* list of arrowMetadataCache */
 	dlist_head	free_fcaches;	/* list of arrowMetadataFieldCache */
-	dlist_head	hash_slots[ARROW_METADATA_HASH_NSLOTS];
+	/* statistics */
+	pg_atomic_uint64 cache_hits;
+	pg_atomic_uint64 cache_misses;
+	pg_atomic_uint64 cache_evictions;
+	pg_atomic_uint64 cache_failures;	/* no space even after eviction */
+	uint32_t	nslots;
+	dlist_head	hash_slots[FLEXIBLE_ARRAY_MEMBER];
 } arrowMetadataCacheHead;
 
 /*
@@ -187,7 +268,14 @@ static shmem_startup_hook_type shmem_startup_next = NULL;
 static arrowMetadataCacheHead *arrow_metadata_cache = NULL;
 static bool					arrow_fdw_enabled;	/* GUC */
 static bool					arrow_fdw_stats_hint_enabled;	/* GUC */
+static bool					arrow_fdw_late_materialization;	/* GUC */
+static bool					arrow_fdw_vectorized_filter;	/* GUC */
 static int					arrow_metadata_cache_size_kb;	/* GUC */
+static int					arrow_record_batch_size_kb;		/* GUC */
+
+static bool		readArrowFile(const char *filename,
+								  ArrowFileInfo *af_info,
+								  bool missing_ok);
 
 /* ----------------------------------------------------------------
  *
@@ -376,6 +464,12 @@ __releaseMetadataCache(arrowMetadataCache *mcache)
 	}
 }
 
+/*
+ * __reclaimMetadataCache
+ *
+ * It evicts the least recently used file. Caller must hold exclusive lock
+ * on the arrow_metadata_cache->mutex, so nobody references the entry.
+ */
 static bool
 __reclaimMetadataCache(void)
 {
@@ -384,25 +478,19 @@ __reclaimMetadataCache(void)
 	{
 		arrowMetadataCache *mcache;
 		dlist_node	   *dnode;
-		struct timeval	curr_tv;
-		int64_t			elapsed;
 
-		gettimeofday(&curr_tv, NULL);
 		dnode = dlist_tail_node(&arrow_metadata_cache->lru_list);
 		mcache = dlist_container(arrowMetadataCache, lru_chain, dnode);
-		elapsed = ((curr_tv.tv_sec - mcache->lru_tv.tv_sec) * 1000000 +
-				   (curr_tv.tv_usec - mcache->lru_tv.tv_usec));
-		if (elapsed > 30000000UL)	/* > 30s */
-		{
-			dlist_delete(&mcache->lru_chain);
-			memset(&mcache->lru_chain, 0, sizeof(dlist_node));
-			SpinLockRelease(&arrow_metadata_cache->lru_lock);
-			dlist_delete(&mcache->chain);
-			memset(&mcache->chain, 0, sizeof(dlist_node));
-
-			__releaseMetadataCache(mcache);
-			return true;
-		}
+		dlist_delete(&mcache->lru_chain);
+		memset(&mcache->lru_chain, 0, sizeof(dlist_node));
+		arrow_metadata_cache->num_files--;
+		SpinLockRelease(&arrow_metadata_cache->lru_lock);
+		dlist_delete(&mcache->chain);
+		memset(&mcache->chain, 0, sizeof(dlist_node));
+
+		__releaseMetadataCache(mcache);
+		pg_atomic_fetch_add_u64(&arrow_metadata_cache->cache_evictions, 1);
+		return true;
 	}
 	SpinLockRelease(&arrow_metadata_cache->lru_lock);
 	return false;
@@ -508,7 +596,48 @@ arrowMetadataHashIndex(struct stat *stat_buf)
 	hkey.st_dev = stat_buf->st_dev;
 	hkey.st_ino = stat_buf->st_ino;
 	hash = hash_bytes((unsigned char *)&hkey, sizeof(hkey));
-	return hash % ARROW_METADATA_HASH_NSLOTS;
+	return hash % arrow_metadata_cache->nslots;
+}
+
+/*
+ * __touchArrowMetadataCache
+ *
+ * It moves the entry to the head of LRU list. Entries touched within the
+ * last second are not moved, to avoid contention on the lru_lock when
+ * many (parallel) backends reference the same files.
+ */
+static inline void
+__touchArrowMetadataCache(arrowMetadataCache *mcache)
+{
+	struct timeval	curr_tv;
+
+	gettimeofday(&curr_tv, NULL);
+	if (curr_tv.tv_sec == mcache->lru_tv.tv_sec)
+		return;
+	SpinLockAcquire(&arrow_metadata_cache->lru_lock);
+	mcache->lru_tv = curr_tv;
+	dlist_move_head(&arrow_metadata_cache->lru_list,
+					&mcache->lru_chain);
+	SpinLockRelease(&arrow_metadata_cache->lru_lock);
+}
+
+/*
+ * __removeArrowMetadataCacheNoLock
+ *
+ * caller must hold exclusive lock on the arrow_metadata_cache->mutex.
+ */
+static void
+__removeArrowMetadataCacheNoLock(arrowMetadataCache *mcache)
+{
+	SpinLockAcquire(&arrow_metadata_cache->lru_lock);
+	dlist_delete(&mcache->lru_chain);
+	memset(&mcache->lru_chain, 0, sizeof(dlist_node));
+	arrow_metadata_cache->num_files--;
+	SpinLockRelease(&arrow_metadata_cache->lru_lock);
+	dlist_delete(&mcache->chain);
+	memset(&mcache->chain, 0, sizeof(dlist_node));
+
+	__releaseMetadataCache(mcache);
 }
 
 static arrowMetadataCache *
@@ -534,11 +663,17 @@ lookupArrowMetadataCache(struct stat *stat_buf, bool has_exclusive)
 				 stat_buf->st_mtim.tv_nsec <= mcache->stat_buf.st_mtim.tv_nsec))
 			{
 				/* ok, found */
-				SpinLockAcquire(&arrow_metadata_cache->lru_lock);
-				gettimeofday(&mcache->lru_tv, NULL);
-				dlist_move_head(&arrow_metadata_cache->lru_list,
-								&mcache->lru_chain);
-				SpinLockRelease(&arrow_metadata_cache->lru_lock);
+				__touchArrowMetadataCache(mcache);
+				return mcache;
+			}
+			else if (mcache->stream_length > 0 &&
+					 stat_buf->st_size >= mcache->stat_buf.st_size)
+			{
+				/*
+				 * IPC stream file is growing; the cached record-batches
+				 * are still valid, and caller appends the new ones.
+				 */
+				__touchArrowMetadataCache(mcache);
 				return mcache;
 			}
 			else if (has_exclusive)
@@ -547,14 +682,7 @@ lookupArrowMetadataCache(struct stat *stat_buf, bool has_exclusive)
 				 * Unfortunatelly, metadata cache is already invalid.
 				 * If caller has exclusive lock, we release it.
 				 */
-				SpinLockAcquire(&arrow_metadata_cache->lru_lock);
-				dlist_delete(&mcache->lru_chain);
-				memset(&mcache->lru_chain, 0, sizeof(dlist_node));
-				SpinLockRelease(&arrow_metadata_cache->lru_lock);
-				dlist_delete(&mcache->chain);
-				memset(&mcache->chain, 0, sizeof(dlist_node));
-
-				__releaseMetadataCache(mcache);
+				__removeArrowMetadataCacheNoLock(mcache);
 			}
 		}
 	}
@@ -573,6 +701,8 @@ typedef struct arrowFieldStatsBinary
 {
 	uint32	nrooms;		/* number of record-batches */
 	MinMaxStatDatum *stat_values;
+	int64	zone_nrows;	/* number of rows per zone, if zone-map */
+	MinMaxStatDatum **zone_values;	/* zone-map per record-batch, or NULL */
 	int		nfields;	/* if List/Struct data type */
 	struct arrowFieldStatsBinary *subfields;
 } arrowFieldStatsBinary;
@@ -595,6 +725,15 @@ __releaseArrowFieldStatsBinary(arrowFieldStatsBinary *bstats)
 	}
 	if (bstats->stat_values)
 		pfree(bstats->stat_values);
+	if (bstats->zone_values)
+	{
+		for (int i=0; i < bstats->nrooms; i++)
+		{
+			if (bstats->zone_values[i])
+				pfree(bstats->zone_values[i]);
+		}
+		pfree(bstats->zone_values);
+	}
 }
 
 static void
@@ -636,9 +775,9 @@ __atoi128(const char *tok, bool *p_isnull)
 	return ival;
 }
 
-static bool
-__parseArrowFieldStatsBinary(arrowFieldStatsBinary *bstats,
-							 ArrowField *field,
+static MinMaxStatDatum *
+__parseArrowFieldStatsBinary(ArrowField *field,
+							 uint32_t nrooms,
 							 const char *min_tokens,
 							 const char *max_tokens)
 {
@@ -655,10 +794,10 @@ __parseArrowFieldStatsBinary(arrowFieldStatsBinary *bstats,
 	strcpy(min_buffer, min_tokens);
 	strcpy(max_buffer, max_tokens);
 
-	stat_values = palloc0(sizeof(MinMaxStatDatum) * bstats->nrooms);
+	stat_values = palloc0(sizeof(MinMaxStatDatum) * nrooms);
 	for (tok1 = strtok_r(min_buffer, ",", &pos1),
 		 tok2 = strtok_r(max_buffer, ",", &pos2), index = 0;
-		 tok1 != NULL && tok2 != NULL && index < bstats->nrooms;
+		 tok1 != NULL && tok2 != NULL && index < nrooms;
 		 tok1 = strtok_r(NULL, ",", &pos1),
 		 tok2 = strtok_r(NULL, ",", &pos2), index++)
 	{
@@ -763,14 +902,79 @@ __parseArrowFieldStatsBinary(arrowFieldStatsBinary *bstats,
 		}
 	}
 	/* sanity checks */
-	if (!tok1 && !tok2 && index == bstats->nrooms)
-	{
-		bstats->stat_values = stat_values;
-		return true;
-	}
+	if (!tok1 && !tok2 && index == nrooms)
+		return stat_values;
 bailout:
 	pfree(stat_values);
-	return false;
+	return NULL;
+}
+
+/*
+ * __parseArrowFieldZoneStats
+ *
+ * zone-map statistics are comma separated min/max values for each zone,
+ * and record-batches are separated by semicolon. Record-batches that have
+ * unexpected number of zones are ignored.
+ */
+static bool
+__parseArrowFieldZoneStats(arrowFieldStatsBinary *bstats,
+						   ArrowField *field,
+						   ArrowFileInfo *af_info,
+						   const char *zone_nrows,
+						   const char *min_tokens,
+						   const char *max_tokens)
+{
+	char	   *min_buffer;
+	char	   *max_buffer;
+	char	   *tok1, *pos1;
+	char	   *tok2, *pos2;
+	char	   *end;
+	bool		found = false;
+
+	bstats->zone_nrows = strtol(zone_nrows, &end, 10);
+	if (*end != '\0' || bstats->zone_nrows <= 0 ||
+		bstats->zone_nrows % 64 != 0)
+		return false;	/* zone must be aligned to 64bit of nullmap */
+	min_buffer = alloca(strlen(min_tokens) + 1);
+	max_buffer = alloca(strlen(max_tokens) + 1);
+	strcpy(min_buffer, min_tokens);
+	strcpy(max_buffer, max_tokens);
+
+	bstats->zone_values = palloc0(sizeof(MinMaxStatDatum *) * bstats->nrooms);
+	for (int i=0; i < bstats->nrooms; i++)
+	{
+		ArrowRecordBatch *rbatch = &af_info->recordBatches[i].body.recordBatch;
+		int64_t		nzones = ((rbatch->length + bstats->zone_nrows - 1) /
+							  bstats->zone_nrows);
+
+		/* NOTE: strtok_r() skips empty tokens, so we split them by hand */
+		if (!min_buffer || !max_buffer)
+			break;
+		tok1 = min_buffer;
+		tok2 = max_buffer;
+		pos1 = strchr(min_buffer, ';');
+		pos2 = strchr(max_buffer, ';');
+		if (pos1)
+			*pos1++ = '\0';
+		if (pos2)
+			*pos2++ = '\0';
+		min_buffer = pos1;
+		max_buffer = pos2;
+
+		if (nzones > 1 && *tok1 != '\0' && *tok2 != '\0')
+		{
+			bstats->zone_values[i] = __parseArrowFieldStatsBinary(field, nzones,
+																  tok1, tok2);
+			if (bstats->zone_values[i])
+				found = true;
+		}
+	}
+	if (!found)
+	{
+		pfree(bstats->zone_values);
+		bstats->zone_values = NULL;
+	}
+	return found;
 }
 
 static bool
@@ -796,12 +1000,12 @@ __buildArrowFieldStatsBinary(arrowFieldStatsBinary *bstats,
 	bstats->nrooms = numRecordBatches;
 	if (min_tokens && max_tokens)
 	{
-		if (__parseArrowFieldStatsBinary(bstats, field,
-										 min_tokens,
-										 max_tokens))
-		{
+		bstats->stat_values = __parseArrowFieldStatsBinary(field,
+														   bstats->nrooms,
+														   min_tokens,
+														   max_tokens);
+		if (bstats->stat_values)
 			retval = true;
-		}
 	}
 
 	if (field->_num_children > 0)
@@ -819,9 +1023,36 @@ __buildArrowFieldStatsBinary(arrowFieldStatsBinary *bstats,
 	return retval;
 }
 
+static void
+__buildArrowFieldZoneStats(arrowFieldStatsBinary *bstats,
+						   ArrowField *field,
+						   ArrowFileInfo *af_info)
+{
+	const char *zone_nrows = NULL;
+	const char *min_tokens = NULL;
+	const char *max_tokens = NULL;
+
+	for (int k=0; k < field->_num_custom_metadata; k++)
+	{
+		ArrowKeyValue *kv = &field->custom_metadata[k];
+
+		if (strcmp(kv->key, "zone_nrows") == 0)
+			zone_nrows = kv->value;
+		else if (strcmp(kv->key, "zone_min_values") == 0)
+			min_tokens = kv->value;
+		else if (strcmp(kv->key, "zone_max_values") == 0)
+			max_tokens = kv->value;
+	}
+	if (zone_nrows && min_tokens && max_tokens &&
+		field->_num_children == 0)
+		__parseArrowFieldZoneStats(bstats, field, af_info,
+								   zone_nrows, min_tokens, max_tokens);
+}
+
 static arrowStatsBinary *
-buildArrowStatsBinary(const ArrowFooter *footer, Bitmapset **p_stat_attrs)
+buildArrowStatsBinary(ArrowFileInfo *af_info, Bitmapset **p_stat_attrs)
 {
+	const ArrowFooter *footer = &af_info->footer;
 	arrowStatsBinary *arrow_bstats;
 	int		nfields = footer->schema._num_fields;
 	bool	found = false;
@@ -838,6 +1069,9 @@ buildArrowStatsBinary(const ArrowFooter *footer, Bitmapset **p_stat_attrs)
 		{
 			if (p_stat_attrs)
 				*p_stat_attrs = bms_add_member(*p_stat_attrs, j+1);
+			__buildArrowFieldZoneStats(&arrow_bstats->fields[j],
+									   &footer->schema.fields[j],
+									   af_info);
 			found = true;
 		}
 	}
@@ -891,6 +1125,134 @@ applyArrowStatsBinary(RecordBatchState *rb_state, arrowStatsBinary *arrow_bstats
 	}
 }
 
+/*
+ * applyArrowZoneStats
+ *
+ * It builds sub-RecordBatchState for each zone of the record-batch, if
+ * zone-map statistics are available. Each zone references only a part of
+ * the buffers, so min/max statistics allows to skip a part of record-batch.
+ */
+static bool
+__sliceRecordBatchFieldState(RecordBatchFieldState *dst,
+							 const RecordBatchFieldState *src,
+							 int64 base, int64 nitems)
+{
+	size_t		unitsz = src->attopts.unitsz;
+	off_t		off;
+
+	memcpy(dst, src, sizeof(RecordBatchFieldState));
+	dst->nitems = nitems;
+	if (src->nullmap_length > 0)
+	{
+		off = base / BITS_PER_BYTE;
+		if (off >= src->nullmap_length)
+			return false;
+		dst->nullmap_offset = src->nullmap_offset + off;
+		dst->nullmap_length = Min(BITMAPLEN(nitems), src->nullmap_length - off);
+	}
+	switch (src->attopts.tag)
+	{
+		case ArrowType__Bool:
+			off = base / BITS_PER_BYTE;
+			unitsz = BITMAPLEN(nitems);
+			break;
+		case ArrowType__Int:
+		case ArrowType__FloatingPoint:
+		case ArrowType__Decimal:
+		case ArrowType__Date:
+		case ArrowType__Time:
+		case ArrowType__Timestamp:
+		case ArrowType__Interval:
+		case ArrowType__FixedSizeBinary:
+			off = base * unitsz;
+			unitsz = nitems * unitsz;
+			break;
+		case ArrowType__Utf8:
+		case ArrowType__LargeUtf8:
+		case ArrowType__Binary:
+		case ArrowType__LargeBinary:
+			/* offsets are sliced, but extra buffer is shared */
+			off = base * unitsz;
+			unitsz = (nitems + 1) * unitsz;
+			break;
+		default:
+			return false;
+	}
+	if (off >= src->values_length)
+		return false;
+	dst->values_offset = src->values_offset + off;
+	dst->values_length = Min(unitsz, src->values_length - off);
+
+	return true;
+}
+
+static void
+applyArrowZoneStats(RecordBatchState *rb_state, arrowStatsBinary *arrow_bstats)
+{
+	int			rb_index = rb_state->rb_index;
+	int64		zone_nrows = 0;
+	int64		nzones;
+	List	   *zone_states = NIL;
+
+	if (rb_state->rb_codec >= 0)
+		return;		/* compressed record-batch cannot be sliced */
+	for (int j=0; j < rb_state->nfields; j++)
+	{
+		arrowFieldStatsBinary *bstats = &arrow_bstats->fields[j];
+
+		if (rb_state->fields[j].num_children > 0 ||
+			rb_state->fields[j].dict_index_sz > 0)
+			return;		/* nested / dictionary types are not supported */
+		if (bstats->zone_values && bstats->zone_values[rb_index])
+		{
+			if (zone_nrows == 0)
+				zone_nrows = bstats->zone_nrows;
+			else if (zone_nrows != bstats->zone_nrows)
+				return;		/* inconsistent zone-map */
+		}
+	}
+	if (zone_nrows == 0)
+		return;
+	nzones = (rb_state->rb_nitems + zone_nrows - 1) / zone_nrows;
+	Assert(nzones > 1);
+	for (int k=0; k < nzones; k++)
+	{
+		RecordBatchState *zone;
+		int64		base = k * zone_nrows;
+		int64		nitems = Min(zone_nrows, rb_state->rb_nitems - base);
+
+		zone = palloc0(offsetof(RecordBatchState, fields[rb_state->nfields]));
+		zone->af_state   = rb_state->af_state;
+		zone->rb_index   = rb_index;
+		zone->rb_offset  = rb_state->rb_offset;
+		zone->rb_length  = (rb_state->rb_length * nitems) / rb_state->rb_nitems;
+		zone->rb_nitems  = nitems;
+		zone->rb_codec   = rb_state->rb_codec;
+		zone->zone_index = k;
+		zone->nfields    = rb_state->nfields;
+		for (int j=0; j < rb_state->nfields; j++)
+		{
+			RecordBatchFieldState *rb_field = &zone->fields[j];
+			arrowFieldStatsBinary *bstats = &arrow_bstats->fields[j];
+
+			if (!__sliceRecordBatchFieldState(rb_field,
+											  &rb_state->fields[j],
+											  base, nitems))
+			{
+				list_free_deep(zone_states);
+				pfree(zone);
+				return;
+			}
+			if (bstats->zone_values && bstats->zone_values[rb_index])
+				memcpy(&rb_field->stat_datum,
+					   &bstats->zone_values[rb_index][k],
+					   sizeof(MinMaxStatDatum));
+		}
+		zone_states = lappend(zone_states, zone);
+	}
+	rb_state->zone_states = zone_states;
+}
+
 /*
  * execInitArrowStatsHint / execCheckArrowStatsHint / execEndArrowStatsHint
  *
@@ -1050,99 +1412,539 @@ __buildArrowStatsOper(arrowStatsHint *as_hint,
 	return true;
 }
 
-static arrowStatsHint *
-execInitArrowStatsHint(ScanState *ss, List *outer_quals, Bitmapset *stat_attrs)
+/*
+ * Bloom filter support
+ *
+ * Equality and IN-list qualifiers, like (VAR = CONST) or (VAR IN (CONST,...)),
+ * are checked against the bloom filters embedded by pcap2arrow/pg2arrow with
+ * --bloom option. They are loaded from the arrow file on demand, because
+ * the metadata cache has no room for the variable length bitmap.
+ */
+static bool
+__buildArrowBloomHint(arrowStatsHint *as_hint, ScanState *ss, Expr *expr)
 {
-	Relation		relation = ss->ss_currentRelation;
-	TupleDesc		tupdesc = RelationGetDescr(relation);
-	arrowStatsHint *as_hint;
-	ExprContext	   *econtext;
-	Expr		   *eval_expr;
-	ListCell	   *lc;
-
-	outer_quals = fixup_scanstate_expressions(ss, outer_quals);
-	as_hint = palloc0(sizeof(arrowStatsHint));
-	as_hint->stat_attrs = stat_attrs;
-	foreach (lc, outer_quals)
+	Scan	   *scan = (Scan *)ss->ps.plan;
+	Var		   *var;
+	Const	   *con;
+	Oid			opno;
+	Oid			collid;
+	TypeCacheEntry *tcache;
+	arrowBloomHint *bhint;
+	bool		is_array = false;
+
+	if (IsA(expr, OpExpr))
 	{
-		OpExpr *op = lfirst(lc);
+		OpExpr	   *op = (OpExpr *)expr;
 
-		if (IsA(op, OpExpr) && list_length(op->args) == 2 &&
-			(__buildArrowStatsOper(as_hint, ss, op, false) ||
-			 __buildArrowStatsOper(as_hint, ss, op, true)))
+		if (list_length(op->args) != 2)
+			return false;
+		var = linitial(op->args);
+		con = lsecond(op->args);
+		if (IsA(var, Const) && IsA(con, Var))
 		{
-			as_hint->orig_quals = lappend(as_hint->orig_quals, op);
+			var = lsecond(op->args);
+			con = linitial(op->args);
 		}
+		opno = op->opno;
+		collid = op->inputcollid;
+	}
+	else if (IsA(expr, ScalarArrayOpExpr))
+	{
+		ScalarArrayOpExpr *sa_op = (ScalarArrayOpExpr *)expr;
+
+		if (!sa_op->useOr || list_length(sa_op->args) != 2)
+			return false;
+		var = linitial(sa_op->args);
+		con = lsecond(sa_op->args);
+		opno = sa_op->opno;
+		collid = sa_op->inputcollid;
+		is_array = true;
 	}
-	if (as_hint->eval_quals == NIL)
-		return NULL;
-	if (list_length(as_hint->eval_quals) == 1)
-		eval_expr = linitial(as_hint->eval_quals);
 	else
-		eval_expr = make_orclause(as_hint->eval_quals);
+		return false;
 
-	econtext = CreateExprContext(ss->ps.state);
-	econtext->ecxt_innertuple = MakeSingleTupleTableSlot(tupdesc, &TTSOpsVirtual);
-	econtext->ecxt_outertuple = MakeSingleTupleTableSlot(tupdesc, &TTSOpsVirtual);
+	if (!IsA(var, Var) || !IsA(con, Const) || con->constisnull)
+		return false;
+	if (var->varnosyn != scan->scanrelid)
+		return false;
+	/* must be the equality operator of the type itself */
+	tcache = lookup_type_cache(var->vartype, TYPECACHE_EQ_OPR);
+	if (opno != tcache->eq_opr)
+		return false;
+	if (OidIsValid(collid) && !get_collation_isdeterministic(collid))
+		return false;
+	if (!is_array)
+	{
+		if (con->consttype != var->vartype)
+			return false;
+		bhint = palloc0(offsetof(arrowBloomHint, keys[1]));
+		bhint->keys[bhint->nkeys++] = con->constvalue;
+	}
+	else
+	{
+		ArrayType  *array = DatumGetArrayTypeP(con->constvalue);
+		int16		typlen;
+		bool		typbyval;
+		char		typalign;
+		Datum	   *elems;
+		bool	   *nulls;
+		int			nelems;
+
+		if (ARR_ELEMTYPE(array) != var->vartype)
+			return false;
+		get_typlenbyvalalign(var->vartype, &typlen, &typbyval, &typalign);
+		deconstruct_array(array, var->vartype,
+						  typlen, typbyval, typalign,
+						  &elems, &nulls, &nelems);
+		bhint = palloc0(offsetof(arrowBloomHint, keys[nelems]));
+		for (int i=0; i < nelems; i++)
+		{
+			if (!nulls[i])
+				bhint->keys[bhint->nkeys++] = elems[i];
+		}
+	}
+	bhint->anum = var->varattnosyn;
+	bhint->keytype = var->vartype;
+	as_hint->bloom_hints = lappend(as_hint->bloom_hints, bhint);
 
-	as_hint->eval_state = ExecInitExpr(eval_expr, &ss->ps);
-	as_hint->econtext = econtext;
+	return true;
+}
 
-	return as_hint;
+static int
+__hexCharToInt(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
 }
 
-static bool
-execCheckArrowStatsHint(arrowStatsHint *stats_hint,
-						RecordBatchState *rb_state)
+static arrowBloomFilter *
+__parseArrowBloomFilter(const char *tok, size_t len, uint32_t nhashes)
 {
-	ExprContext	   *econtext = stats_hint->econtext;
-	TupleTableSlot *min_values = econtext->ecxt_innertuple;
-	TupleTableSlot *max_values = econtext->ecxt_outertuple;
-	int				anum;
-	Datum			datum;
-	bool			isnull;
+	arrowBloomFilter *bloom;
+	uint32_t	nbits = len * 4;
 
-	/* load the min/max statistics */
-	ExecStoreAllNullTuple(min_values);
-	ExecStoreAllNullTuple(max_values);
-	for (anum = bms_next_member(stats_hint->load_attrs, -1);
-		 anum >= 0;
-		 anum = bms_next_member(stats_hint->load_attrs, anum))
+	if (len == 0 || (nbits & (nbits - 1)) != 0 || nbits < 64)
+		return NULL;
+	bloom = palloc(offsetof(arrowBloomFilter, bitmap[len / 2]));
+	bloom->nbits = nbits;
+	bloom->nhashes = nhashes;
+	for (size_t i=0; i < len; i += 2)
 	{
-		RecordBatchFieldState *rb_field = &rb_state->fields[anum-1];
+		int		hi = __hexCharToInt(tok[i]);
+		int		lo = __hexCharToInt(tok[i+1]);
 
-		Assert(anum > 0 && anum <= rb_state->nfields);
-		if (!rb_field->stat_datum.isnull)
+		if (hi < 0 || lo < 0)
 		{
-			min_values->tts_isnull[anum-1] = false;
-			max_values->tts_isnull[anum-1] = false;
-			if (rb_field->atttypid == NUMERICOID)
-			{
-				min_values->tts_values[anum-1]
-					= PointerGetDatum(&rb_field->stat_datum.min.numeric);
-				max_values->tts_values[anum-1]
-					= PointerGetDatum(&rb_field->stat_datum.max.numeric);
-			}
-			else
-			{
-				min_values->tts_values[anum-1] = rb_field->stat_datum.min.datum;
-				max_values->tts_values[anum-1] = rb_field->stat_datum.max.datum;
-			}
+			pfree(bloom);
+			return NULL;
 		}
+		bloom->bitmap[i/2] = (hi << 4) | lo;
 	}
-	datum = ExecEvalExprSwitchContext(stats_hint->eval_state, econtext, &isnull);
-//	elog(INFO, "file [%s] rb_index=%u datum=%lu isnull=%d",
-//		 FilePathName(rb_state->fdesc), rb_state->rb_index, datum, (int)isnull);
-	if (!isnull && DatumGetBool(datum))
-		return true;	/* ok, skip this record-batch */
-	return false;
+	return bloom;
 }
 
-static void
-execEndArrowStatsHint(arrowStatsHint *stats_hint)
+static bool
+loadArrowBloomFilters(ArrowFileState *af_state, Bitmapset *bloom_attrs)
 {
-	ExprContext	   *econtext = stats_hint->econtext;
-
+	MemoryContext	curr_memcxt = CurrentMemoryContext;
+	MemoryContext	temp_memcxt;
+	ArrowFileInfo	af_info;
+	arrowBloomFilter **bloom_filters = NULL;
+	int				nfields;
+	int				nrooms;
+	int				anum;
+	bool			found = false;
+
+	temp_memcxt = AllocSetContextCreate(curr_memcxt,
+										"arrow bloom filter",
+										ALLOCSET_DEFAULT_SIZES);
+	MemoryContextSwitchTo(temp_memcxt);
+	if (!readArrowFile(af_state->filename, &af_info, true) ||
+		af_info.stat_buf.st_ino   != af_state->stat_buf.st_ino ||
+		af_info.stat_buf.st_size  != af_state->stat_buf.st_size ||
+		af_info.stat_buf.st_mtime != af_state->stat_buf.st_mtime)
+		goto out;		/* file has gone or modified? */
+
+	nfields = af_info.footer.schema._num_fields;
+	nrooms  = af_info.footer._num_recordBatches;
+	for (anum = bms_next_member(bloom_attrs, -1);
+		 anum >= 0;
+		 anum = bms_next_member(bloom_attrs, anum))
+	{
+		ArrowField *field;
+		const char *tokens = NULL;
+		uint32_t	nhashes = 0;
+
+		if (anum < 1 || anum > nfields)
+			continue;
+		field = &af_info.footer.schema.fields[anum-1];
+		for (int k=0; k < field->_num_custom_metadata; k++)
+		{
+			ArrowKeyValue *kv = &field->custom_metadata[k];
+
+			if (strcmp(kv->key, "bloom_nhashes") == 0)
+				nhashes = atoi(kv->value);
+			else if (strcmp(kv->key, "bloom_filters") == 0)
+				tokens = kv->value;
+		}
+		if (!tokens || nhashes == 0)
+			continue;
+		for (int i=0; i < nrooms && tokens; i++)
+		{
+			const char *pos = strchr(tokens, ',');
+			size_t		len = (pos ? pos - tokens : strlen(tokens));
+
+			if (len > 0)
+			{
+				arrowBloomFilter *bloom;
+
+				MemoryContextSwitchTo(curr_memcxt);
+				if (!bloom_filters)
+					bloom_filters = palloc0(sizeof(arrowBloomFilter *) *
+											nrooms * nfields);
+				bloom = __parseArrowBloomFilter(tokens, len, nhashes);
+				if (bloom)
+				{
+					bloom_filters[i * nfields + anum - 1] = bloom;
+					found = true;
+				}
+				MemoryContextSwitchTo(temp_memcxt);
+			}
+			tokens = (pos ? pos + 1 : NULL);
+		}
+	}
+	if (found)
+	{
+		af_state->bloom_nfields = nfields;
+		af_state->bloom_filters = bloom_filters;
+	}
+out:
+	MemoryContextSwitchTo(curr_memcxt);
+	MemoryContextDelete(temp_memcxt);
+
+	return found;
+}
+
+/*
+ * __arrowBloomKeyBytes
+ *
+ * It returns the raw bytes of the key on the Arrow representation,
+ * or -1 if unable to convert.
+ */
+static int
+__arrowBloomKeyBytes(RecordBatchFieldState *rb_field,
+					 Oid keytype, Datum datum,
+					 char *buf, const char **p_addr)
+{
+	const ArrowTypeOptions *attopts = &rb_field->attopts;
+	int64_t		ival;
+
+	*p_addr = buf;
+	switch (attopts->tag)
+	{
+		case ArrowType__Int:
+			if (keytype == INT2OID)
+				ival = DatumGetInt16(datum);
+			else if (keytype == INT4OID)
+				ival = DatumGetInt32(datum);
+			else if (keytype == INT8OID)
+				ival = DatumGetInt64(datum);
+			else
+				return -1;
+			break;
+
+		case ArrowType__Date:
+			if (keytype != DATEOID)
+				return -1;
+			ival = (DatumGetDateADT(datum) +
+					(POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE));
+			if (attopts->date.unit == ArrowDateUnit__MilliSecond)
+				ival *= (SECS_PER_DAY * 1000L);
+			else if (attopts->date.unit != ArrowDateUnit__Day)
+				return -1;
+			break;
+
+		case ArrowType__Time:
+		case ArrowType__Timestamp:
+			if (attopts->tag == ArrowType__Time && keytype == TIMEOID)
+				ival = DatumGetTimeADT(datum);
+			else if (attopts->tag == ArrowType__Timestamp &&
+					 (keytype == TIMESTAMPOID || keytype == TIMESTAMPTZOID))
+				ival = (DatumGetTimestamp(datum) +
+						(POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE) * USECS_PER_DAY);
+			else
+				return -1;
+			switch (attopts->tag == ArrowType__Time
+					? attopts->time.unit
+					: attopts->timestamp.unit)
+			{
+				case ArrowTimeUnit__Second:
+					if (ival % 1000000L != 0)
+						return -1;
+					ival /= 1000000L;
+					break;
+				case ArrowTimeUnit__MilliSecond:
+					if (ival % 1000L != 0)
+						return -1;
+					ival /= 1000L;
+					break;
+				case ArrowTimeUnit__MicroSecond:
+					break;
+				case ArrowTimeUnit__NanoSecond:
+					ival *= 1000L;
+					break;
+				default:
+					return -1;
+			}
+			break;
+
+		case ArrowType__Utf8:
+		case ArrowType__LargeUtf8:
+		case ArrowType__Binary:
+		case ArrowType__LargeBinary:
+			if (keytype == TEXTOID ||
+				keytype == VARCHAROID ||
+				keytype == BYTEAOID)
+			{
+				struct varlena *vl = PG_DETOAST_DATUM_PACKED(datum);
+
+				*p_addr = VARDATA_ANY(vl);
+				return VARSIZE_ANY_EXHDR(vl);
+			}
+			return -1;
+
+		case ArrowType__FixedSizeBinary:
+			if (keytype == INETOID)
+			{
+				inet   *ip = DatumGetInetPP(datum);
+
+				if (ip_bits(ip) != ip_addrsize(ip) * BITS_PER_BYTE ||
+					ip_addrsize(ip) != attopts->unitsz)
+					return -1;
+				*p_addr = (const char *)ip_addr(ip);
+				return ip_addrsize(ip);
+			}
+			else if (keytype == MACADDROID && attopts->unitsz == sizeof(macaddr))
+			{
+				*p_addr = DatumGetPointer(datum);
+				return sizeof(macaddr);
+			}
+			return -1;
+
+		default:
+			return -1;
+	}
+	/* fixed-length integer values */
+	switch (attopts->unitsz)
+	{
+		case sizeof(int8_t):
+			*((int8_t *)buf) = ival;
+			break;
+		case sizeof(int16_t):
+			*((int16_t *)buf) = ival;
+			break;
+		case sizeof(int32_t):
+			*((int32_t *)buf) = ival;
+			break;
+		case sizeof(int64_t):
+			*((int64_t *)buf) = ival;
+			break;
+		default:
+			return -1;
+	}
+	return attopts->unitsz;
+}
+
+static bool
+__execCheckArrowBloomHint(arrowStatsHint *stats_hint,
+						  RecordBatchState *rb_state)
+{
+	ArrowFileState *af_state = rb_state->af_state;
+	ListCell   *lc;
+
+	if (!af_state->bloom_filters)
+		return false;
+	foreach (lc, stats_hint->bloom_hints)
+	{
+		arrowBloomHint *bhint = lfirst(lc);
+		arrowBloomFilter *bloom;
+		RecordBatchFieldState *rb_field;
+		bool		maybe_found = false;
+
+		if (bhint->anum < 1 || bhint->anum > af_state->bloom_nfields)
+			continue;
+		bloom = af_state->bloom_filters[rb_state->rb_index *
+										af_state->bloom_nfields +
+										bhint->anum - 1];
+		if (!bloom)
+			continue;
+		rb_field = &rb_state->fields[bhint->anum - 1];
+		for (int i=0; i < bhint->nkeys && !maybe_found; i++)
+		{
+			char		buf[sizeof(int64_t)];
+			const char *addr;
+			int			len;
+			uint64_t	hash;
+
+			len = __arrowBloomKeyBytes(rb_field, bhint->keytype,
+									   bhint->keys[i], buf, &addr);
+			if (len < 0)
+			{
+				maybe_found = true;		/* unable to check */
+				break;
+			}
+			hash = arrowBloomHash(addr, len);
+			maybe_found = true;
+			for (int k=0; k < bloom->nhashes; k++)
+			{
+				uint32_t	bit = arrowBloomBitIndex(hash, k, bloom->nbits);
+
+				if ((bloom->bitmap[bit >> 3] & (1 << (bit & 7))) == 0)
+				{
+					maybe_found = false;
+					break;
+				}
+			}
+		}
+		if (!maybe_found)
+			return true;	/* ok, no keys in this record-batch */
+	}
+	return false;
+}
+
+static arrowStatsHint *
+execInitArrowStatsHint(ScanState *ss, List *outer_quals, Bitmapset *stat_attrs,
+					   List *af_states_list)
+{
+	Relation		relation = ss->ss_currentRelation;
+	TupleDesc		tupdesc = RelationGetDescr(relation);
+	arrowStatsHint *as_hint;
+	ExprContext	   *econtext;
+	Expr		   *eval_expr;
+	List		   *bloom_quals = NIL;
+	ListCell	   *lc;
+
+	outer_quals = fixup_scanstate_expressions(ss, outer_quals);
+	as_hint = palloc0(sizeof(arrowStatsHint));
+	as_hint->stat_attrs = stat_attrs;
+	foreach (lc, outer_quals)
+	{
+		OpExpr *op = lfirst(lc);
+
+		if (IsA(op, OpExpr) && list_length(op->args) == 2 &&
+			(__buildArrowStatsOper(as_hint, ss, op, false) ||
+			 __buildArrowStatsOper(as_hint, ss, op, true)))
+		{
+			as_hint->orig_quals = lappend(as_hint->orig_quals, op);
+		}
+		if (__buildArrowBloomHint(as_hint, ss, (Expr *)op))
+			bloom_quals = list_append_unique_ptr(bloom_quals, op);
+	}
+	/* load the bloom filters, if any */
+	if (as_hint->bloom_hints != NIL)
+	{
+		Bitmapset  *bloom_attrs = NULL;
+		bool		found = false;
+
+		foreach (lc, as_hint->bloom_hints)
+		{
+			arrowBloomHint *bhint = lfirst(lc);
+
+			bloom_attrs = bms_add_member(bloom_attrs, bhint->anum);
+		}
+		foreach (lc, af_states_list)
+		{
+			if (loadArrowBloomFilters(lfirst(lc), bloom_attrs))
+				found = true;
+		}
+		if (found)
+			as_hint->orig_quals = list_concat_unique_ptr(as_hint->orig_quals,
+														 bloom_quals);
+		else
+			as_hint->bloom_hints = NIL;
+	}
+	if (as_hint->eval_quals == NIL && as_hint->bloom_hints == NIL)
+		return NULL;
+
+	econtext = CreateExprContext(ss->ps.state);
+	econtext->ecxt_innertuple = MakeSingleTupleTableSlot(tupdesc, &TTSOpsVirtual);
+	econtext->ecxt_outertuple = MakeSingleTupleTableSlot(tupdesc, &TTSOpsVirtual);
+	if (as_hint->eval_quals != NIL)
+	{
+		if (list_length(as_hint->eval_quals) == 1)
+			eval_expr = linitial(as_hint->eval_quals);
+		else
+			eval_expr = make_orclause(as_hint->eval_quals);
+		as_hint->eval_state = ExecInitExpr(eval_expr, &ss->ps);
+	}
+	as_hint->econtext = econtext;
+
+	return as_hint;
+}
+
+static bool
+execCheckArrowStatsHint(arrowStatsHint *stats_hint,
+						RecordBatchState *rb_state)
+{
+	ExprContext	   *econtext = stats_hint->econtext;
+	TupleTableSlot *min_values = econtext->ecxt_innertuple;
+	TupleTableSlot *max_values = econtext->ecxt_outertuple;
+	int				anum;
+	Datum			datum;
+	bool			isnull;
+
+	/* check the bloom filters first, if any */
+	if (stats_hint->bloom_hints != NIL &&
+		__execCheckArrowBloomHint(stats_hint, rb_state))
+		return true;
+	if (!stats_hint->eval_state)
+		return false;
+	/* load the min/max statistics */
+	ExecStoreAllNullTuple(min_values);
+	ExecStoreAllNullTuple(max_values);
+	for (anum = bms_next_member(stats_hint->load_attrs, -1);
+		 anum >= 0;
+		 anum = bms_next_member(stats_hint->load_attrs, anum))
+	{
+		RecordBatchFieldState *rb_field = &rb_state->fields[anum-1];
+
+		Assert(anum > 0 && anum <= rb_state->nfields);
+		if (!rb_field->stat_datum.isnull)
+		{
+			min_values->tts_isnull[anum-1] = false;
+			max_values->tts_isnull[anum-1] = false;
+			if (rb_field->atttypid == NUMERICOID)
+			{
+				min_values->tts_values[anum-1]
+					= PointerGetDatum(&rb_field->stat_datum.min.numeric);
+				max_values->tts_values[anum-1]
+					= PointerGetDatum(&rb_field->stat_datum.max.numeric);
+			}
+			else
+			{
+				min_values->tts_values[anum-1] = rb_field->stat_datum.min.datum;
+				max_values->tts_values[anum-1] = rb_field->stat_datum.max.datum;
+			}
+		}
+	}
+	datum = ExecEvalExprSwitchContext(stats_hint->eval_state, econtext, &isnull);
+//	elog(INFO, "file [%s] rb_index=%u datum=%lu isnull=%d",
+//		 FilePathName(rb_state->fdesc), rb_state->rb_index, datum, (int)isnull);
+	if (!isnull && DatumGetBool(datum))
+		return true;	/* ok, skip this record-batch */
+	return false;
+}
+
+static void
+execEndArrowStatsHint(arrowStatsHint *stats_hint)
+{
+	ExprContext	   *econtext = stats_hint->econtext;
+
 	ExecDropSingleTupleTableSlot(econtext->ecxt_innertuple);
 	ExecDropSingleTupleTableSlot(econtext->ecxt_outertuple);
 	econtext->ecxt_innertuple = NULL;
@@ -1174,6 +1976,9 @@ __buildRecordBatchFieldStateByCache(RecordBatchFieldState *rb_field,
 	rb_field->values_length  = fcache->values_length;
 	rb_field->extra_offset   = fcache->extra_offset;
 	rb_field->extra_length   = fcache->extra_length;
+	rb_field->dict_index_sz  = fcache->dict_index_sz;
+	rb_field->dict_index_offset = fcache->dict_index_offset;
+	rb_field->dict_index_length = fcache->dict_index_length;
 	memcpy(&rb_field->stat_datum,
 		   &fcache->stat_datum, sizeof(MinMaxStatDatum));
 	if (fcache->num_children > 0)
@@ -1204,10 +2009,12 @@ __buildArrowFileStateByCache(const char *filename,
 							 Bitmapset **p_stat_attrs)
 {
 	ArrowFileState	   *af_state;
+	RecordBatchState   *rb_leader = NULL;
 
 	af_state = palloc0(sizeof(ArrowFileState));
 	af_state->filename = pstrdup(filename);
 	memcpy(&af_state->stat_buf, &mcache->stat_buf, sizeof(struct stat));
+	af_state->stream_length = mcache->stream_length;
 
 	while (mcache)
 	{
@@ -1222,6 +2029,8 @@ __buildArrowFileStateByCache(const char *filename,
 		rb_state->rb_offset = mcache->rb_offset;
 		rb_state->rb_length = mcache->rb_length;
 		rb_state->rb_nitems = mcache->rb_nitems;
+		rb_state->rb_codec  = mcache->rb_codec;
+		rb_state->zone_index = mcache->zone_index;
 		rb_state->nfields   = mcache->nfields;
 		dlist_foreach(iter, &mcache->fields)
 		{
@@ -1233,8 +2042,16 @@ __buildArrowFileStateByCache(const char *filename,
 			__buildRecordBatchFieldStateByCache(&rb_state->fields[j++], fcache);
 		}
 		Assert(j == rb_state->nfields);
-		af_state->rb_list = lappend(af_state->rb_list, rb_state);
-
+		if (rb_state->zone_index < 0)
+		{
+			af_state->rb_list = lappend(af_state->rb_list, rb_state);
+			rb_leader = rb_state;
+		}
+		else
+		{
+			Assert(rb_leader != NULL && rb_leader->rb_index == rb_state->rb_index);
+			rb_leader->zone_states = lappend(rb_leader->zone_states, rb_state);
+		}
 		mcache = mcache->next;
 	}
 	return af_state;
@@ -1249,6 +2066,10 @@ typedef struct
 	ArrowBuffer	   *buffer_tail;
 	ArrowFieldNode *fnode_curr;
 	ArrowFieldNode *fnode_tail;
+	bool			compressed;	/* buffers are compressed individually */
+	bool			unaligned;	/* buffers may not be aligned (Parquet) */
+	ArrowFileInfo  *af_info;	/* for DictionaryBatch lookup */
+	off_t			rb_offset;	/* offset of the RecordBatch body */
 } setupRecordBatchContext;
 
 static Oid
@@ -1548,16 +2369,28 @@ __arrowFieldTypeToPGType(const ArrowField *field,
 
 		case ArrowNodeTag__List:
 		case ArrowNodeTag__LargeList:
+		case ArrowNodeTag__Map:
 			if (field->_num_children != 1)
 				elog(ERROR, "Bug? List of arrow type is corrupted");
 			else
 			{
 				Oid			__type_oid = InvalidOid;
 
-				attopts.tag = ArrowType__List;
-				attopts.unitsz = (t->node.tag == ArrowNodeTag__List
-								  ? sizeof(uint32_t)
-								  : sizeof(uint64_t));
+				/*
+				 * Arrow::Map has identical layout to Arrow::List of the
+				 * Struct (key, value), so it is mapped to an array of
+				 * the composite type.
+				 */
+				if (t->node.tag == ArrowNodeTag__LargeList)
+				{
+					attopts.tag = ArrowType__LargeList;
+					attopts.unitsz = sizeof(uint64_t);
+				}
+				else
+				{
+					attopts.tag = ArrowType__List;
+					attopts.unitsz = sizeof(uint32_t);
+				}
 				__arrowFieldTypeToPGType(&field->children[0],
 										 &__type_oid,
 										 NULL,
@@ -1603,6 +2436,108 @@ __arrowFieldTypeToPGType(const ArrowField *field,
 		memcpy(p_attopts, &attopts, sizeof(ArrowTypeOptions));
 }
 
+/*
+ * __buildRecordBatchDictFieldState
+ *
+ * Dictionary-encoded column has only nullmap and index buffers in the
+ * RecordBatch. Its values/extra buffers are assigned to the DictionaryBatch,
+ * so GPU kernel can reference the dictionary entry without materialization.
+ */
+static void
+__buildRecordBatchDictFieldState(setupRecordBatchContext *con,
+								 RecordBatchFieldState *rb_field,
+								 ArrowField *field)
+{
+	ArrowDictionaryEncoding *dict = field->dictionary;
+	ArrowFileInfo  *af_info = con->af_info;
+	ArrowRecordBatch *dbatch = NULL;
+	ArrowBlock	   *dblock = NULL;
+	ArrowBuffer	   *buffer_curr;
+	off_t			dict_base;
+	int				index_sz;
+
+	switch (field->type.node.tag)
+	{
+		case ArrowNodeTag__Utf8:
+		case ArrowNodeTag__LargeUtf8:
+		case ArrowNodeTag__Binary:
+		case ArrowNodeTag__LargeBinary:
+			break;
+		default:
+			elog(ERROR, "arrow_fdw: dictionary-encoded %s is not supported",
+				 arrowNodeName(&field->type.node));
+	}
+	if (con->compressed)
+		elog(ERROR, "arrow_fdw: dictionary-encoded column in compressed RecordBatch is not supported");
+	if (dict->indexType.bitWidth != 8  && dict->indexType.bitWidth != 16 &&
+		dict->indexType.bitWidth != 32 && dict->indexType.bitWidth != 64)
+		elog(ERROR, "arrow_fdw: unsupported dictionary index width (%d)",
+			 dict->indexType.bitWidth);
+	index_sz = dict->indexType.bitWidth / BITS_PER_BYTE;
+	/* lookup the DictionaryBatch */
+	for (int i=0; af_info && i < af_info->footer._num_dictionaries; i++)
+	{
+		ArrowDictionaryBatch *__dbatch = &af_info->dictionaries[i].body.dictionaryBatch;
+
+		if (__dbatch->id == dict->id)
+		{
+			if (__dbatch->isDelta || dbatch != NULL)
+				elog(ERROR, "arrow_fdw: delta or replacement of DictionaryBatch is not supported");
+			dbatch = &__dbatch->data;
+			dblock = &af_info->footer.dictionaries[i];
+		}
+	}
+	if (!dbatch)
+		elog(ERROR, "arrow_fdw: DictionaryBatch (id=%ld) was not found",
+			 dict->id);
+	if (dbatch->compression)
+		elog(ERROR, "arrow_fdw: compressed DictionaryBatch is not supported");
+	if (dbatch->_num_nodes != 1 || dbatch->_num_buffers != 3)
+		elog(ERROR, "arrow_fdw: DictionaryBatch (id=%ld) may be corrupted",
+			 dict->id);
+	if (dbatch->nodes[0].null_count > 0)
+		elog(ERROR, "arrow_fdw: DictionaryBatch (id=%ld) with NULL entries is not supported",
+			 dict->id);
+	/* values/extra buffer (relative to the RecordBatch) */
+	dict_base = dblock->offset + dblock->metaDataLength - con->rb_offset;
+	rb_field->values_offset = dict_base + dbatch->buffers[1].offset;
+	rb_field->values_length = dbatch->buffers[1].length;
+	rb_field->extra_offset  = dict_base + dbatch->buffers[2].offset;
+	rb_field->extra_length  = dbatch->buffers[2].length;
+	if (rb_field->values_length < (rb_field->attopts.unitsz *
+								   (dbatch->nodes[0].length + 1)))
+		elog(ERROR, "dictionary array is smaller than expected");
+	if (rb_field->values_offset != MAXALIGN(rb_field->values_offset) ||
+		rb_field->extra_offset  != MAXALIGN(rb_field->extra_offset))
+		elog(ERROR, "dictionary array is not aligned well");
+
+	/* setup nullmap buffer */
+	buffer_curr = con->buffer_curr++;
+	if (buffer_curr >= con->buffer_tail)
+		elog(ERROR, "RecordBatch has less buffers than expected");
+	if (rb_field->null_count > 0)
+	{
+		rb_field->nullmap_offset = buffer_curr->offset;
+		rb_field->nullmap_length = buffer_curr->length;
+		if (rb_field->nullmap_length < BITMAPLEN(rb_field->nitems))
+			elog(ERROR, "nullmap length is smaller than expected");
+		if (rb_field->nullmap_offset != MAXALIGN(rb_field->nullmap_offset))
+			elog(ERROR, "nullmap is not aligned well");
+	}
+	/* setup index buffer */
+	buffer_curr = con->buffer_curr++;
+	if (buffer_curr >= con->buffer_tail)
+		elog(ERROR, "RecordBatch has less buffers than expected");
+	rb_field->dict_index_sz     = index_sz;
+	rb_field->dict_index_offset = buffer_curr->offset;
+	rb_field->dict_index_length = buffer_curr->length;
+	if (rb_field->dict_index_length < index_sz * rb_field->nitems)
+		elog(ERROR, "dictionary index array is smaller than expected");
+	if (!con->unaligned &&
+		rb_field->dict_index_offset != MAXALIGN(rb_field->dict_index_offset))
+		elog(ERROR, "dictionary index array is not aligned well");
+}
+
 static void
 __buildRecordBatchFieldState(setupRecordBatchContext *con,
 							 RecordBatchFieldState *rb_field,
@@ -1625,6 +2560,13 @@ __buildRecordBatchFieldState(setupRecordBatchContext *con,
 							 &rb_field->atttypid,
 							 &rb_field->atttypmod,
 							 &rb_field->attopts);
+	if (field->dictionary)
+	{
+		if (depth > 0)
+			elog(ERROR, "dictionary-encoded sub-field is not supported");
+		__buildRecordBatchDictFieldState(con, rb_field, field);
+		return;
+	}
 	/* assign buffers */
 	switch (field->type.node.tag)
 	{
@@ -1651,15 +2593,12 @@ __buildRecordBatchFieldState(setupRecordBatchContext *con,
 			break;
 
 		case ArrowNodeTag__List:
-        case ArrowNodeTag__LargeList:
-			if (depth > 0)
-				elog(ERROR, "nested array type is not supported");
+		case ArrowNodeTag__LargeList:
+		case ArrowNodeTag__Map:
 			least_values_length = rb_field->attopts.unitsz * (rb_field->nitems + 1);
 			break;
 
 		case ArrowNodeTag__Struct:
-			if (depth > 0)
-				elog(ERROR, "nested composite type is not supported");
 			/* no values and extra buffer, only nullmap */
 			break;
 		default:
@@ -1674,7 +2613,8 @@ __buildRecordBatchFieldState(setupRecordBatchContext *con,
 	{
 		rb_field->nullmap_offset = buffer_curr->offset;
 		rb_field->nullmap_length = buffer_curr->length;
-		if (rb_field->nullmap_length < BITMAPLEN(rb_field->nitems))
+		if (!con->compressed &&
+			rb_field->nullmap_length < BITMAPLEN(rb_field->nitems))
 			elog(ERROR, "nullmap length is smaller than expected");
 		if (rb_field->nullmap_offset != MAXALIGN(rb_field->nullmap_offset))
 			elog(ERROR, "nullmap is not aligned well");
@@ -1688,9 +2628,11 @@ __buildRecordBatchFieldState(setupRecordBatchContext *con,
 			elog(ERROR, "RecordBatch has less buffers than expected");
 		rb_field->values_offset = buffer_curr->offset;
 		rb_field->values_length = buffer_curr->length;
-		if (rb_field->values_length < least_values_length)
+		if (!con->compressed &&
+			rb_field->values_length < least_values_length)
 			elog(ERROR, "values array is smaller than expected");
-		if (rb_field->values_offset != MAXALIGN(rb_field->values_offset))
+		if (!con->unaligned &&
+			rb_field->values_offset != MAXALIGN(rb_field->values_offset))
 			elog(ERROR, "values array is not aligned well");
 	}
 
@@ -1725,27 +2667,45 @@ __buildRecordBatchFieldState(setupRecordBatchContext *con,
 
 static RecordBatchState *
 __buildRecordBatchStateOne(ArrowSchema *schema,
+						   ArrowFileInfo *af_info,
 						   ArrowFileState *af_state,
 						   int rb_index,
 						   ArrowBlock *block,
-						   ArrowRecordBatch *rbatch)
+						   ArrowRecordBatch *rbatch,
+						   bool unaligned)
 {
 	setupRecordBatchContext con;
 	RecordBatchState *rb_state;
 	int			nfields = schema->_num_fields;
 
-	if (rbatch->compression)
-		elog(ERROR, "arrow_fdw: right now, compressed record-batche is not supported");
-
 	rb_state = palloc0(offsetof(RecordBatchState, fields[nfields]));
 	rb_state->af_state = af_state;
 	rb_state->rb_index = rb_index;
 	rb_state->rb_offset = block->offset + block->metaDataLength;
 	rb_state->rb_length = block->bodyLength;
 	rb_state->rb_nitems = rbatch->length;
+	rb_state->rb_codec  = -1;
+	rb_state->zone_index = -1;
 	rb_state->nfields   = nfields;
 
 	memset(&con, 0, sizeof(setupRecordBatchContext));
+	if (rbatch->compression)
+	{
+		ArrowBodyCompression *compress = rbatch->compression;
+
+		if (compress->method != ArrowBodyCompressionMethod__BUFFER)
+			elog(ERROR, "arrow_fdw: unknown body compression method (%d)",
+				 (int)compress->method);
+		if (compress->codec != ArrowCompressionType__LZ4_FRAME &&
+			compress->codec != ArrowCompressionType__ZSTD)
+			elog(ERROR, "arrow_fdw: unknown body compression codec (%d)",
+				 (int)compress->codec);
+		rb_state->rb_codec = compress->codec;
+		con.compressed = true;
+	}
+	con.unaligned = unaligned;
+	con.af_info = af_info;
+	con.rb_offset = rb_state->rb_offset;
 	con.buffer_curr = rbatch->buffers;
 	con.buffer_tail = rbatch->buffers + rbatch->_num_buffers;
 	con.fnode_curr  = rbatch->nodes;
@@ -1779,11 +2739,11 @@ readArrowFile(const char *filename, ArrowFileInfo *af_info, bool missing_ok)
 				(errcode_for_file_access(),
 				 errmsg("could not open file \"%s\": %m", filename)));
 	}
-	readArrowFileDesc(FileGetRawDesc(filp), af_info);
+	if (isParquetFileDesc(FileGetRawDesc(filp)))
+		readParquetFileDesc(FileGetRawDesc(filp), af_info);
+	else
+		readArrowFileDesc(FileGetRawDesc(filp), af_info);
 	FileClose(filp);
-	if (af_info->dictionaries != NULL)
-		elog(ERROR, "DictionaryBatch is not supported at '%s'", filename);
-	Assert(af_info->footer._num_dictionaries == 0);
 	return true;
 }
 
@@ -1808,8 +2768,9 @@ __buildArrowFileStateByFile(const char *filename, Bitmapset **p_stat_attrs)
 	af_state = palloc0(sizeof(ArrowFileInfo));
 	af_state->filename = pstrdup(filename);
 	memcpy(&af_state->stat_buf, &af_info.stat_buf, sizeof(struct stat));
+	af_state->stream_length = af_info.stream_length;
 
-	arrow_bstats = buildArrowStatsBinary(&af_info.footer, p_stat_attrs);
+	arrow_bstats = buildArrowStatsBinary(&af_info, p_stat_attrs);
 	for (int i=0; i < af_info.footer._num_recordBatches; i++)
 	{
 		ArrowBlock	     *block  = &af_info.footer.recordBatches[i];
@@ -1817,9 +2778,14 @@ __buildArrowFileStateByFile(const char *filename, Bitmapset **p_stat_attrs)
 		RecordBatchState *rb_state;
 
 		rb_state = __buildRecordBatchStateOne(&af_info.footer.schema,
-											  af_state, i, block, rbatch);
+											  &af_info,
+											  af_state, i, block, rbatch,
+											  af_info.is_parquet);
 		if (arrow_bstats)
+		{
 			applyArrowStatsBinary(rb_state, arrow_bstats);
+			applyArrowZoneStats(rb_state, arrow_bstats);
+		}
 		af_state->rb_list = lappend(af_state->rb_list, rb_state);
 	}
 	releaseArrowStatsBinary(arrow_bstats);
@@ -1827,6 +2793,71 @@ __buildArrowFileStateByFile(const char *filename, Bitmapset **p_stat_attrs)
 	return af_state;
 }
 
+/*
+ * __appendArrowFileStateByStream
+ *
+ * It appends the record-batches newly written to the IPC stream file after
+ * the ArrowFileState was built. It returns false if the file is no longer
+ * a growing stream (e.g, footer is written), then caller must rebuild the
+ * ArrowFileState from the raw file.
+ */
+static bool
+__appendArrowFileStateByStream(ArrowFileState *af_state)
+{
+	ArrowFileInfo af_info;
+	File		filp;
+	int			rb_base = list_length(af_state->rb_list);
+	int			skip = 0;
+
+	Assert(af_state->stream_length > 0);
+	filp = PathNameOpenFile(af_state->filename, O_RDONLY | PG_BINARY);
+	if (filp < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", af_state->filename)));
+	readArrowStreamFileDesc(FileGetRawDesc(filp), &af_info,
+							af_state->stream_length);
+	if (af_info.stream_length > 0)
+	{
+		/*
+		 * DictionaryBatch messages prior to the resume position are
+		 * not visible, so we have to read the stream from the head.
+		 */
+		for (int j=0; j < af_info.footer.schema._num_fields; j++)
+		{
+			if (af_info.footer.schema.fields[j].dictionary)
+			{
+				readArrowStreamFileDesc(FileGetRawDesc(filp), &af_info, 0);
+				skip = rb_base;
+				break;
+			}
+		}
+	}
+	FileClose(filp);
+	if (af_info.stream_length == 0 ||
+		af_info.footer.schema._num_fields !=
+		((RecordBatchState *)linitial(af_state->rb_list))->nfields)
+		return false;
+
+	for (int i=skip; i < af_info.footer._num_recordBatches; i++)
+	{
+		ArrowBlock	     *block  = &af_info.footer.recordBatches[i];
+		ArrowRecordBatch *rbatch = &af_info.recordBatches[i].body.recordBatch;
+		RecordBatchState *rb_state;
+
+		rb_state = __buildRecordBatchStateOne(&af_info.footer.schema,
+											  &af_info,
+											  af_state,
+											  rb_base + (i - skip),
+											  block, rbatch, false);
+		af_state->rb_list = lappend(af_state->rb_list, rb_state);
+	}
+	memcpy(&af_state->stat_buf, &af_info.stat_buf, sizeof(struct stat));
+	af_state->stream_length = af_info.stream_length;
+
+	return true;
+}
+
 
 static arrowMetadataFieldCache *
 __buildArrowMetadataFieldCache(RecordBatchFieldState *rb_field)
@@ -1847,6 +2878,9 @@ __buildArrowMetadataFieldCache(RecordBatchFieldState *rb_field)
 	fcache->values_length = rb_field->values_length;
 	fcache->extra_offset = rb_field->extra_offset;
 	fcache->extra_length = rb_field->extra_length;
+	fcache->dict_index_sz = rb_field->dict_index_sz;
+	fcache->dict_index_offset = rb_field->dict_index_offset;
+	fcache->dict_index_length = rb_field->dict_index_length;
 	memcpy(&fcache->stat_datum,
 		   &rb_field->stat_datum, sizeof(MinMaxStatDatum));
 	fcache->num_children = rb_field->num_children;
@@ -1872,6 +2906,41 @@ __buildArrowMetadataFieldCache(RecordBatchFieldState *rb_field)
  * it builds arrowMetadataCache entries according to the supplied
  * ArrowFileState
  */
+static arrowMetadataCache *
+__buildArrowMetadataCacheOne(ArrowFileState *af_state,
+							 RecordBatchState *rb_state)
+{
+	arrowMetadataCache *mcache;
+
+	mcache = __allocMetadataCache();
+	if (!mcache)
+		return NULL;
+	memcpy(&mcache->stat_buf,
+		   &af_state->stat_buf, sizeof(struct stat));
+	mcache->rb_index  = rb_state->rb_index;
+	mcache->rb_offset = rb_state->rb_offset;
+	mcache->rb_length = rb_state->rb_length;
+	mcache->rb_nitems = rb_state->rb_nitems;
+	mcache->rb_codec  = rb_state->rb_codec;
+	mcache->zone_index = rb_state->zone_index;
+	mcache->stream_length = af_state->stream_length;
+	mcache->nfields   = rb_state->nfields;
+	dlist_init(&mcache->fields);
+	for (int j=0; j < rb_state->nfields; j++)
+	{
+		arrowMetadataFieldCache *fcache;
+
+		fcache = __buildArrowMetadataFieldCache(&rb_state->fields[j]);
+		if (!fcache)
+		{
+			__releaseMetadataCache(mcache);
+			return NULL;
+		}
+		dlist_push_tail(&mcache->fields, &fcache->chain);
+	}
+	return mcache;
+}
+
 static void
 __buildArrowMetadataCacheNoLock(ArrowFileState *af_state)
 {
@@ -1879,44 +2948,40 @@ __buildArrowMetadataCacheNoLock(ArrowFileState *af_state)
 	arrowMetadataCache *mcache_prev = NULL;
 	arrowMetadataCache *mcache;
 	uint32_t	hindex;
-	ListCell   *lc;
+	ListCell   *lc1, *lc2;
 
-	foreach (lc, af_state->rb_list)
+	foreach (lc1, af_state->rb_list)
 	{
-		RecordBatchState *rb_state = lfirst(lc);
+		RecordBatchState *rb_state = lfirst(lc1);
 
-		mcache = __allocMetadataCache();
+		mcache = __buildArrowMetadataCacheOne(af_state, rb_state);
 		if (!mcache)
 		{
 			__releaseMetadataCache(mcache_head);
+			pg_atomic_fetch_add_u64(&arrow_metadata_cache->cache_failures, 1);
 			return;
 		}
-		memcpy(&mcache->stat_buf,
-			   &af_state->stat_buf, sizeof(struct stat));
-		mcache->rb_index  = rb_state->rb_index;
-		mcache->rb_offset = rb_state->rb_offset;
-		mcache->rb_length = rb_state->rb_length;
-		mcache->rb_nitems = rb_state->rb_nitems;
-		mcache->nfields   = rb_state->nfields;
-		dlist_init(&mcache->fields);
 		if (!mcache_head)
 			mcache_head = mcache;
 		else
 			mcache_prev->next = mcache;
+		mcache_prev = mcache;
 
-		for (int j=0; j < rb_state->nfields; j++)
+		/* zones of the record-batch follow its leader */
+		foreach (lc2, rb_state->zone_states)
 		{
-			arrowMetadataFieldCache *fcache;
+			RecordBatchState *zone = lfirst(lc2);
 
-			fcache = __buildArrowMetadataFieldCache(&rb_state->fields[j]);
-			if (!fcache)
+			mcache = __buildArrowMetadataCacheOne(af_state, zone);
+			if (!mcache)
 			{
 				__releaseMetadataCache(mcache_head);
+				pg_atomic_fetch_add_u64(&arrow_metadata_cache->cache_failures, 1);
 				return;
 			}
-			dlist_push_tail(&mcache->fields, &fcache->chain);
+			mcache_prev->next = mcache;
+			mcache_prev = mcache;
 		}
-		mcache_prev = mcache;
 	}
 	/* chain to the list */
 	hindex = arrowMetadataHashIndex(&af_state->stat_buf);
@@ -1925,9 +2990,75 @@ __buildArrowMetadataCacheNoLock(ArrowFileState *af_state)
 	SpinLockAcquire(&arrow_metadata_cache->lru_lock);
 	gettimeofday(&mcache_head->lru_tv, NULL);
 	dlist_push_head(&arrow_metadata_cache->lru_list, &mcache_head->lru_chain);
+	arrow_metadata_cache->num_files++;
 	SpinLockRelease(&arrow_metadata_cache->lru_lock);
 }
 
+/*
+ * __appendArrowMetadataCacheNoLock
+ *
+ * It appends the metadata-cache entries of the record-batches newly
+ * loaded from the growing IPC stream, next to the cached ones.
+ */
+static void
+__appendArrowMetadataCacheNoLock(ArrowFileState *af_state,
+								 size_t old_stream_length,
+								 int old_nitems)
+{
+	arrowMetadataCache *mcache_head = NULL;
+	arrowMetadataCache *mcache_prev = NULL;
+	arrowMetadataCache *mcache;
+	uint32_t	hindex;
+	dlist_iter	iter;
+	ListCell   *lc;
+
+	/*
+	 * MEMO: __allocMetadataCache() may reclaim the LRU entries, so we
+	 * lookup the leader entry after the allocation of the new ones.
+	 */
+	for_each_from(lc, af_state->rb_list, old_nitems)
+	{
+		RecordBatchState *rb_state = lfirst(lc);
+
+		mcache = __buildArrowMetadataCacheOne(af_state, rb_state);
+		if (!mcache)
+		{
+			__releaseMetadataCache(mcache_head);
+			return;
+		}
+		if (!mcache_head)
+			mcache_head = mcache;
+		else
+			mcache_prev->next = mcache;
+		mcache_prev = mcache;
+	}
+	if (!mcache_head)
+		return;
+
+	hindex = arrowMetadataHashIndex(&af_state->stat_buf);
+	dlist_foreach(iter, &arrow_metadata_cache->hash_slots[hindex])
+	{
+		mcache = dlist_container(arrowMetadataCache, chain, iter.cur);
+
+		if (mcache->stat_buf.st_dev == af_state->stat_buf.st_dev &&
+			mcache->stat_buf.st_ino == af_state->stat_buf.st_ino)
+		{
+			arrowMetadataCache *mcache_tail = mcache;
+
+			if (mcache->stream_length != old_stream_length)
+				break;		/* already updated by others */
+			while (mcache_tail->next)
+				mcache_tail = mcache_tail->next;
+			mcache_tail->next = mcache_head;
+			memcpy(&mcache->stat_buf,
+				   &af_state->stat_buf, sizeof(struct stat));
+			mcache->stream_length = af_state->stream_length;
+			return;
+		}
+	}
+	__releaseMetadataCache(mcache_head);
+}
+
 static ArrowFileState *
 BuildArrowFileState(Relation frel, const char *filename, Bitmapset **p_stat_attrs)
 {
@@ -1938,18 +3069,62 @@ BuildArrowFileState(Relation frel, const char *filename, Bitmapset **p_stat_attr
 	TupleDesc		tupdesc;
 
 	if (stat(filename, &stat_buf) != 0)
+	{
+		/* writable foreign table does not have the file until INSERT */
+		if (errno == ENOENT)
+			return NULL;
 		elog(ERROR, "failed on stat('%s'): %m", filename);
+	}
+	if (stat_buf.st_size == 0)
+		return NULL;	/* empty file has no RecordBatch */
 	LWLockAcquire(&arrow_metadata_cache->mutex, LW_SHARED);
 	mcache = lookupArrowMetadataCache(&stat_buf, false);
 	if (mcache)
 	{
 		/* found a valid metadata-cache */
+		pg_atomic_fetch_add_u64(&arrow_metadata_cache->cache_hits, 1);
 		af_state = __buildArrowFileStateByCache(filename, mcache,
 												p_stat_attrs);
+		if (af_state->stream_length > 0 &&
+			(stat_buf.st_size != af_state->stat_buf.st_size ||
+			 stat_buf.st_mtim.tv_sec != af_state->stat_buf.st_mtim.tv_sec ||
+			 stat_buf.st_mtim.tv_nsec != af_state->stat_buf.st_mtim.tv_nsec))
+		{
+			/* IPC stream file is growing, so pick up the new record-batches */
+			size_t		old_stream_length = af_state->stream_length;
+			int			old_nitems = list_length(af_state->rb_list);
+
+			LWLockRelease(&arrow_metadata_cache->mutex);
+
+			if (__appendArrowFileStateByStream(af_state))
+			{
+				LWLockAcquire(&arrow_metadata_cache->mutex, LW_EXCLUSIVE);
+				__appendArrowMetadataCacheNoLock(af_state,
+												 old_stream_length,
+												 old_nitems);
+			}
+			else
+			{
+				/* no longer IPC stream; e.g, footer is written */
+				af_state = __buildArrowFileStateByFile(filename, p_stat_attrs);
+				if (!af_state)
+					return NULL;
+				LWLockAcquire(&arrow_metadata_cache->mutex, LW_EXCLUSIVE);
+				mcache = lookupArrowMetadataCache(&af_state->stat_buf, true);
+				if (mcache && mcache->stream_length > 0)
+				{
+					__removeArrowMetadataCacheNoLock(mcache);
+					mcache = NULL;
+				}
+				if (!mcache)
+					__buildArrowMetadataCacheNoLock(af_state);
+			}
+		}
 	}
 	else
 	{
 		LWLockRelease(&arrow_metadata_cache->mutex);
+		pg_atomic_fetch_add_u64(&arrow_metadata_cache->cache_misses, 1);
 
 		/* here is no valid metadata-cache, so build it from the raw file */
 		af_state = __buildArrowFileStateByFile(filename, p_stat_attrs);
@@ -2089,7 +3264,16 @@ GetOptimalDpuForArrowFdw(PlannerInfo *root, RelOptInfo *baserel)
 		{
 			ArrowFileState *af_state = lfirst(lc);
 			const DpuStorageEntry *__ds_entry;
+			ListCell   *cell;
+
+			/* DPU cannot decompress the record-batches */
+			foreach (cell, af_state->rb_list)
+			{
+				RecordBatchState *rb_state = lfirst(cell);
 
+				if (rb_state->rb_codec >= 0)
+					return NULL;
+			}
 			__ds_entry = GetOptimalDpuForFile(af_state->filename, NULL);
 			if (lc == list_head(af_list))
 				ds_entry = __ds_entry;
@@ -2097,9 +3281,88 @@ GetOptimalDpuForArrowFdw(PlannerInfo *root, RelOptInfo *baserel)
 				ds_entry = NULL;
 		}
 	}
+	/* no DPU plan, if all the replicas are unavailable right now */
+	if (ds_entry && !DpuStorageEntryIsAvailable(ds_entry))
+		return NULL;
 	return ds_entry;
 }
 
+/*
+ * __arrowFdwExtractDirFiles
+ *
+ * It pulls up the files in the 'dir' option. Sub-directories named with
+ * the Hive-style 'key=value' form are also walked recursively, then their
+ * path components are used to prune files by the scan qualifiers.
+ */
+static List *
+__arrowFdwExtractDirFiles(List *filesList,
+						  const char *dir_path,
+						  const char *dir_suffix)
+{
+	struct dirent *dentry;
+	struct stat	stat_buf;
+	DIR	   *dir;
+	char   *temp;
+
+	dir = AllocateDir(dir_path);
+	while ((dentry = ReadDir(dir, dir_path)) != NULL)
+	{
+		if (strcmp(dentry->d_name, ".") == 0 ||
+			strcmp(dentry->d_name, "..") == 0)
+			continue;
+		temp = psprintf("%s/%s", dir_path, dentry->d_name);
+		if (stat(temp, &stat_buf) == 0 && S_ISDIR(stat_buf.st_mode))
+		{
+			const char *pos = strchr(dentry->d_name, '=');
+
+			if (pos && pos != dentry->d_name)
+				filesList = __arrowFdwExtractDirFiles(filesList,
+													  temp,
+													  dir_suffix);
+			pfree(temp);
+			continue;
+		}
+		if (dir_suffix)
+		{
+			char   *pos = strrchr(dentry->d_name, '.');
+
+			if (!pos || strcmp(pos+1, dir_suffix) != 0)
+			{
+				pfree(temp);
+				continue;
+			}
+		}
+		if (access(temp, R_OK) != 0)
+		{
+			elog(DEBUG1, "arrow_fdw: unable to read '%s', so skipped", temp);
+			pfree(temp);
+			continue;
+		}
+		filesList = lappend(filesList, makeString(temp));
+	}
+	FreeDir(dir);
+
+	return filesList;
+}
+
+/*
+ * arrowFdwOptionIsWritable
+ */
+static bool
+arrowFdwOptionIsWritable(List *options_list)
+{
+	ListCell   *lc;
+
+	foreach (lc, options_list)
+	{
+		DefElem	   *defel = lfirst(lc);
+
+		if (strcmp(defel->defname, "writable") == 0)
+			return defGetBoolean(defel);
+	}
+	return false;
+}
+
 /*
  * arrowFdwExtractFilesList
  */
@@ -2113,6 +3376,8 @@ arrowFdwExtractFilesList(List *options_list,
 	char	   *dir_path = NULL;
 	char	   *dir_suffix = NULL;
 	int			parallel_nworkers = -1;
+	bool		writable = arrowFdwOptionIsWritable(options_list);
+	bool		has_files = false;
 
 	foreach (lc, options_list)
 	{
@@ -2123,7 +3388,7 @@ arrowFdwExtractFilesList(List *options_list,
 		{
 			char   *temp = strVal(defel->arg);
 
-			if (access(temp, R_OK) != 0)
+			if (access(temp, R_OK) != 0 && (!writable || errno != ENOENT))
 				elog(ERROR, "arrow_fdw: unable to access '%s': %m", temp);
 			filesList = lappend(filesList, makeString(pstrdup(temp)));
 		}
@@ -2144,6 +3409,7 @@ arrowFdwExtractFilesList(List *options_list,
 				filesList = lappend(filesList, makeString(pstrdup(tok)));
 			}
 			pfree(temp);
+			has_files = true;
 		}
 		else if (strcmp(defel->defname, "dir") == 0)
 		{
@@ -2161,45 +3427,138 @@ arrowFdwExtractFilesList(List *options_list,
 				elog(ERROR, "'parallel_workers' appeared twice");
 			parallel_nworkers = atoi(strVal(defel->arg));
 		}
-		else
+		else if (strcmp(defel->defname, "writable") != 0)
 			elog(ERROR, "arrow: unknown option (%s)", defel->defname);
 	}
 	if (dir_suffix && !dir_path)
 		elog(ERROR, "arrow: cannot use 'suffix' option without 'dir'");
+	if (writable && (dir_path || has_files || list_length(filesList) != 1))
+		elog(ERROR, "arrow: 'writable' option requires exactly one 'file'");
 
 	if (dir_path)
+		filesList = __arrowFdwExtractDirFiles(filesList, dir_path, dir_suffix);
+
+	if (p_parallel_nworkers)
+		*p_parallel_nworkers = parallel_nworkers;
+	return filesList;
+}
+
+/*
+ * __arrowFdwPartitionValueIsMatched
+ *
+ * It checks whether a partition value (taken from 'key=value' component of
+ * the file path) can satisfy the supplied qualifier, or not.
+ */
+#define ARROW_HIVE_DEFAULT_PARTITION	"__HIVE_DEFAULT_PARTITION__"
+
+static bool
+__arrowFdwPartitionValueIsMatched(Relation frel, Index relid,
+								  const char *key, const char *value,
+								  OpExpr *op)
+{
+	TupleDesc	tupdesc = RelationGetDescr(frel);
+	Var		   *var;
+	Const	   *con;
+	Oid			opfuncid;
+	Oid			type_input;
+	Oid			type_ioparam;
+	bool		var_is_left;
+	Datum		datum;
+	Form_pg_attribute attr;
+
+	if (!IsA(op, OpExpr) || list_length(op->args) != 2)
+		return true;
+	if (IsA(linitial(op->args), Var) && IsA(lsecond(op->args), Const))
+	{
+		var = linitial(op->args);
+		con = lsecond(op->args);
+		var_is_left = true;
+	}
+	else if (IsA(linitial(op->args), Const) && IsA(lsecond(op->args), Var))
 	{
-		struct dirent *dentry;
-		DIR	   *dir;
-		char   *temp;
+		con = linitial(op->args);
+		var = lsecond(op->args);
+		var_is_left = false;
+	}
+	else
+		return true;
+	if (var->varnosyn != relid ||
+		var->varattnosyn <= 0 ||
+		var->varattnosyn > tupdesc->natts)
+		return true;
+	attr = TupleDescAttr(tupdesc, var->varattnosyn - 1);
+	if (attr->attisdropped ||
+		strcmp(NameStr(attr->attname), key) != 0 ||
+		attr->atttypid != var->vartype)
+		return true;
+	opfuncid = get_opcode(op->opno);
+	if (!OidIsValid(opfuncid) ||
+		func_volatile(opfuncid) != PROVOLATILE_IMMUTABLE ||
+		!func_strict(opfuncid))
+		return true;
+	/* strict operator never returns true on NULL */
+	if (con->constisnull || strcmp(value, ARROW_HIVE_DEFAULT_PARTITION) == 0)
+		return false;
+	getTypeInputInfo(attr->atttypid, &type_input, &type_ioparam);
+	datum = OidInputFunctionCall(type_input, (char *)value,
+								 type_ioparam, attr->atttypmod);
+	if (var_is_left)
+		datum = OidFunctionCall2Coll(opfuncid, op->inputcollid,
+									 datum, con->constvalue);
+	else
+		datum = OidFunctionCall2Coll(opfuncid, op->inputcollid,
+									 con->constvalue, datum);
+	return DatumGetBool(datum);
+}
 
-		dir = AllocateDir(dir_path);
-		while ((dentry = ReadDir(dir, dir_path)) != NULL)
-		{
-			if (strcmp(dentry->d_name, ".") == 0 ||
-				strcmp(dentry->d_name, "..") == 0)
-				continue;
-			if (dir_suffix)
-			{
-				char   *pos = strrchr(dentry->d_name, '.');
+/*
+ * arrowFdwPartitionFileIsPruned
+ *
+ * It returns true, if the file path contains 'key=value' components
+ * that contradict with the scan qualifiers on the column named 'key'.
+ * Only simple 'VAR <OPER> CONST' form by immutable operators are used.
+ */
+static bool
+arrowFdwPartitionFileIsPruned(Relation frel, Index relid,
+							  const char *fname, List *quals)
+{
+	char	   *path;
+	char	   *tok;
+	char	   *saveptr;
+	char	   *pos;
+	bool		pruned = false;
 
-				if (!pos || strcmp(pos+1, dir_suffix) != 0)
-					continue;
-			}
-			temp = psprintf("%s/%s", dir_path, dentry->d_name);
-			if (access(temp, R_OK) != 0)
+	if (quals == NIL || !strchr(fname, '='))
+		return false;
+	path = pstrdup(fname);
+	pos = strrchr(path, '/');
+	if (pos)
+		*pos = '\0';		/* only directory components */
+	for (tok = strtok_r(path, "/", &saveptr);
+		 tok != NULL && !pruned;
+		 tok = strtok_r(NULL, "/", &saveptr))
+	{
+		ListCell   *lc;
+
+		pos = strchr(tok, '=');
+		if (!pos || pos == tok)
+			continue;
+		*pos++ = '\0';
+		foreach (lc, quals)
+		{
+			if (!__arrowFdwPartitionValueIsMatched(frel, relid,
+												   tok, pos, lfirst(lc)))
 			{
-				elog(DEBUG1, "arrow_fdw: unable to read '%s', so skipped", temp);
-				continue;
+				elog(DEBUG2, "arrow_fdw: file '%s' is pruned by partition key '%s'",
+					 fname, tok);
+				pruned = true;
+				break;
 			}
-			filesList = lappend(filesList, makeString(temp));
 		}
-		FreeDir(dir);
 	}
+	pfree(path);
 
-	if (p_parallel_nworkers)
-		*p_parallel_nworkers = parallel_nworkers;
-	return filesList;
+	return pruned;
 }
 
 /* ----------------------------------------------------------------
@@ -2342,6 +3701,15 @@ arrowFdwSetupIOvectorField(arrowFdwSetupIOContext *con,
 							 &cmeta->extra_length);
 		//elog(INFO, "D%d att[%d] extra=%lu,%lu m_offset=%lu f_offset=%lu", con->depth, index, rb_field->extra_offset, rb_field->extra_length, con->m_offset, con->f_offset);
 	}
+	if (rb_field->dict_index_length > 0)
+	{
+		__setupIOvectorField(con,
+							 rb_field->dict_index_sz,
+							 rb_field->dict_index_offset,
+							 rb_field->dict_index_length,
+							 &cmeta->dict_index_offset,
+							 &cmeta->dict_index_length);
+	}
 
 	/* nested sub-fields if composite types */
 	if (cmeta->atttypkind == TYPE_KIND__ARRAY ||
@@ -2377,7 +3745,7 @@ arrowFdwSetupIOvector(RecordBatchState *rb_state,
 		   kds->ncols <= kds->nr_colmeta &&
 		   kds->ncols == rb_state->nfields);
 	con = alloca(offsetof(arrowFdwSetupIOContext,
-						  ioc[3 * kds->nr_colmeta]));
+						  ioc[4 * kds->nr_colmeta]));
 	con->rb_offset = rb_state->rb_offset;
 	con->f_offset  = ~0UL;	/* invalid offset */
 	con->m_offset  = 0;
@@ -2458,6 +3826,7 @@ __arrowKdsAssignAttrOptions(kern_data_store *kds,
 {
 	memcpy(&cmeta->attopts,
 		   &rb_field->attopts, sizeof(ArrowTypeOptions));
+	cmeta->dict_index_sz = rb_field->dict_index_sz;
 	if (cmeta->atttypkind == TYPE_KIND__ARRAY)
 	{
 		Assert(cmeta->idx_subattrs >= kds->ncols &&
@@ -2482,17 +3851,15 @@ __arrowKdsAssignAttrOptions(kern_data_store *kds,
 	}
 }
 
-static strom_io_vector *
-arrowFdwLoadRecordBatch(Relation relation,
-						Bitmapset *referenced,
-						RecordBatchState *rb_state,
-						StringInfo chunk_buffer)
+static kern_data_store *
+__arrowFdwSetupKdsHead(Relation relation,
+					   RecordBatchState *rb_state,
+					   StringInfo chunk_buffer)
 {
 	TupleDesc	tupdesc = RelationGetDescr(relation);
 	size_t		head_sz = estimate_kern_data_store(tupdesc);
 	kern_data_store *kds;
 
-	/* setup KDS and I/O-vector */
 	enlargeStringInfo(chunk_buffer, head_sz);
 	kds = (kern_data_store *)(chunk_buffer->data +
 							  chunk_buffer->len);
@@ -2506,27 +3873,334 @@ arrowFdwLoadRecordBatch(Relation relation,
 									&rb_state->fields[j]);
 	chunk_buffer->len += head_sz;
 
-	return arrowFdwSetupIOvector(rb_state, referenced, kds);
+	return kds;
 }
 
-static kern_data_store *
-arrowFdwFillupRecordBatch(Relation relation,
-						  Bitmapset *referenced,
-						  RecordBatchState *rb_state,
-						  StringInfo chunk_buffer)
+static strom_io_vector *
+arrowFdwLoadRecordBatch(Relation relation,
+						Bitmapset *referenced,
+						RecordBatchState *rb_state,
+						StringInfo chunk_buffer)
 {
-	ArrowFileState	*af_state = rb_state->af_state;
-	kern_data_store	*kds;
-	strom_io_vector	*iovec;
-	char	   *base;
-	File		filp;
+	kern_data_store *kds;
 
-	resetStringInfo(chunk_buffer);
-	iovec = arrowFdwLoadRecordBatch(relation,
-									referenced,
-									rb_state,
-									chunk_buffer);
-	kds = (kern_data_store *)chunk_buffer->data;
+	Assert(rb_state->rb_codec < 0);
+	/* setup KDS and I/O-vector */
+	kds = __arrowFdwSetupKdsHead(relation, rb_state, chunk_buffer);
+
+	return arrowFdwSetupIOvector(rb_state, referenced, kds);
+}
+
+/*
+ * arrowFdwDecompressRecordBatch
+ *
+ * It reads the individually compressed buffers of the record-batch, then
+ * setup KDS (ARROW format) with the decompressed buffers next to the header.
+ * Because the decompressed image is built on the host memory, GPU-Direct
+ * SQL is not available for this kind of record-batches.
+ */
+typedef struct
+{
+	File		filp;
+	const char *filename;
+	off_t		rb_offset;
+	int			rb_codec;
+	StringInfo	chunk_buffer;
+	size_t		kds_offset;		/* offset of the KDS in the chunk_buffer */
+	StringInfoData temp;		/* buffer to read the compressed data */
+} arrowFdwDecompressContext;
+
+#define DECOMP_KDS(con)											\
+	((kern_data_store *)((con)->chunk_buffer->data + (con)->kds_offset))
+
+static void
+__arrowFdwReadFileChunk(File filp, const char *filename,
+						char *dest, size_t len, off_t f_pos)
+{
+	ssize_t		sz;
+
+	while (len > 0)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		sz = FileRead(filp, dest, len, f_pos,
+					  WAIT_EVENT_REORDER_BUFFER_READ);
+		if (sz > 0)
+		{
+			Assert(sz <= len);
+			dest  += sz;
+			f_pos += sz;
+			len   -= sz;
+		}
+		else if (sz == 0)
+			elog(ERROR, "arrow_fdw: unexpected EOF at '%s' (pos=%lu, len=%lu)",
+				 filename, f_pos, len);
+		else if (errno != EINTR)
+			elog(ERROR, "failed on FileRead('%s', pos=%lu, len=%lu): %m",
+				 filename, f_pos, len);
+	}
+}
+
+static void
+__arrowFdwDecompressLZ4(arrowFdwDecompressContext *con,
+						char *dest, size_t dest_len,
+						const char *src, size_t src_len)
+{
+#ifdef HAVE_LIBLZ4
+	LZ4F_dctx  *dctx;
+	LZ4F_errorCode_t rc;
+	size_t		dest_pos = 0;
+	size_t		src_pos = 0;
+
+	rc = LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION);
+	if (LZ4F_isError(rc))
+		elog(ERROR, "failed on LZ4F_createDecompressionContext: %s",
+			 LZ4F_getErrorName(rc));
+	while (src_pos < src_len && dest_pos < dest_len)
+	{
+		size_t	dest_sz = dest_len - dest_pos;
+		size_t	src_sz  = src_len - src_pos;
+
+		rc = LZ4F_decompress(dctx,
+							 dest + dest_pos, &dest_sz,
+							 src + src_pos, &src_sz, NULL);
+		if (LZ4F_isError(rc))
+		{
+			LZ4F_freeDecompressionContext(dctx);
+			elog(ERROR, "arrow_fdw: failed on LZ4 decompression at '%s': %s",
+				 con->filename, LZ4F_getErrorName(rc));
+		}
+		dest_pos += dest_sz;
+		src_pos  += src_sz;
+		if (rc == 0 || (dest_sz == 0 && src_sz == 0))
+			break;
+	}
+	LZ4F_freeDecompressionContext(dctx);
+	if (dest_pos != dest_len)
+		elog(ERROR, "arrow_fdw: LZ4 decompressed buffer at '%s' has wrong length (%zu of %zu)",
+			 con->filename, dest_pos, dest_len);
+#else
+	elog(ERROR, "arrow_fdw: PG-Strom was built without LZ4 support");
+#endif
+}
+
+static void
+__arrowFdwDecompressZSTD(arrowFdwDecompressContext *con,
+						 char *dest, size_t dest_len,
+						 const char *src, size_t src_len)
+{
+#ifdef HAVE_LIBZSTD
+	size_t		rc;
+
+	rc = ZSTD_decompress(dest, dest_len, src, src_len);
+	if (ZSTD_isError(rc))
+		elog(ERROR, "arrow_fdw: failed on ZSTD decompression at '%s': %s",
+			 con->filename, ZSTD_getErrorName(rc));
+	if (rc != dest_len)
+		elog(ERROR, "arrow_fdw: ZSTD decompressed buffer at '%s' has wrong length (%zu of %zu)",
+			 con->filename, rc, dest_len);
+#else
+	elog(ERROR, "arrow_fdw: PG-Strom was built without ZSTD support");
+#endif
+}
+
+static void
+__decompressArrowBuffer(arrowFdwDecompressContext *con,
+						uint32_t align,
+						off_t buffer_offset,
+						size_t buffer_length,
+						uint32_t *p_cmeta_offset,
+						uint32_t *p_cmeta_length)
+{
+	StringInfo	chunk_buffer = con->chunk_buffer;
+	int64_t		raw_length;
+	char	   *src;
+	char	   *dest;
+	size_t		src_length;
+	size_t		dest_offset;
+	size_t		dest_length;
+
+	if (buffer_length == 0)
+	{
+		*p_cmeta_offset = 0;
+		*p_cmeta_length = 0;
+		return;
+	}
+	if (buffer_length < sizeof(int64_t))
+		elog(ERROR, "arrow_fdw: compressed buffer at '%s' is too short (%zu bytes)",
+			 con->filename, buffer_length);
+	resetStringInfo(&con->temp);
+	enlargeStringInfo(&con->temp, buffer_length);
+	__arrowFdwReadFileChunk(con->filp, con->filename,
+							con->temp.data, buffer_length,
+							con->rb_offset + buffer_offset);
+	/*
+	 * The first 64bit of the buffer is the uncompressed length;
+	 * -1 means the buffer body is stored without compression.
+	 */
+	memcpy(&raw_length, con->temp.data, sizeof(int64_t));
+	src = con->temp.data + sizeof(int64_t);
+	src_length = buffer_length - sizeof(int64_t);
+	dest_length = (raw_length < 0 ? src_length : raw_length);
+
+	dest_offset = TYPEALIGN(Max(align, MAXIMUM_ALIGNOF),
+							chunk_buffer->len - con->kds_offset);
+	enlargeStringInfo(chunk_buffer, (con->kds_offset +
+									 dest_offset +
+									 MAXALIGN(dest_length) -
+									 chunk_buffer->len));
+	/* zero-clear the padding */
+	memset(chunk_buffer->data + chunk_buffer->len, 0,
+		   con->kds_offset + dest_offset - chunk_buffer->len);
+	dest = chunk_buffer->data + con->kds_offset + dest_offset;
+	if (raw_length < 0)
+		memcpy(dest, src, dest_length);
+	else if (con->rb_codec == ArrowCompressionType__LZ4_FRAME)
+		__arrowFdwDecompressLZ4(con, dest, dest_length, src, src_length);
+	else if (con->rb_codec == ArrowCompressionType__ZSTD)
+		__arrowFdwDecompressZSTD(con, dest, dest_length, src, src_length);
+	else
+		elog(ERROR, "arrow_fdw: unknown body compression codec (%d)",
+			 con->rb_codec);
+	memset(dest + dest_length, 0, MAXALIGN(dest_length) - dest_length);
+	chunk_buffer->len = con->kds_offset + dest_offset + MAXALIGN(dest_length);
+
+	*p_cmeta_offset = __kds_packed(dest_offset);
+	*p_cmeta_length = __kds_packed(MAXALIGN(dest_length));
+}
+
+static void
+__decompressArrowField(arrowFdwDecompressContext *con,
+					   RecordBatchFieldState *rb_field,
+					   int cmeta_index)
+{
+	kern_colmeta *cmeta;
+	uint32_t	offset;
+	uint32_t	length;
+
+	/*
+	 * NOTE: chunk_buffer may be expanded on the decompression, so cmeta
+	 * must be re-computed for each buffer.
+	 * Some writers put a (compressed) validity bitmap even if the field has
+	 * no NULLs, so we skip it here; it is all-valid anyway.
+	 */
+	if (rb_field->null_count > 0 &&
+		rb_field->nullmap_length > 0)
+	{
+		__decompressArrowBuffer(con,
+								sizeof(int64_t),
+								rb_field->nullmap_offset,
+								rb_field->nullmap_length,
+								&offset, &length);
+		cmeta = &DECOMP_KDS(con)->colmeta[cmeta_index];
+		cmeta->nullmap_offset = offset;
+		cmeta->nullmap_length = length;
+	}
+	if (rb_field->values_length > 0)
+	{
+		__decompressArrowBuffer(con,
+								rb_field->attopts.align,
+								rb_field->values_offset,
+								rb_field->values_length,
+								&offset, &length);
+		cmeta = &DECOMP_KDS(con)->colmeta[cmeta_index];
+		cmeta->values_offset = offset;
+		cmeta->values_length = length;
+	}
+	if (rb_field->extra_length > 0)
+	{
+		__decompressArrowBuffer(con,
+								sizeof(int64_t),
+								rb_field->extra_offset,
+								rb_field->extra_length,
+								&offset, &length);
+		cmeta = &DECOMP_KDS(con)->colmeta[cmeta_index];
+		cmeta->extra_offset = offset;
+		cmeta->extra_length = length;
+	}
+
+	/* nested sub-fields if composite types */
+	cmeta = &DECOMP_KDS(con)->colmeta[cmeta_index];
+	if (cmeta->atttypkind == TYPE_KIND__ARRAY ||
+		cmeta->atttypkind == TYPE_KIND__COMPOSITE)
+	{
+		int		idx_subattrs = cmeta->idx_subattrs;
+		int		num_subattrs = cmeta->num_subattrs;
+
+		Assert(rb_field->num_children == num_subattrs);
+		for (int j=0; j < num_subattrs; j++)
+			__decompressArrowField(con, &rb_field->children[j],
+								   idx_subattrs + j);
+	}
+}
+
+static kern_data_store *
+arrowFdwDecompressRecordBatch(Relation relation,
+							  Bitmapset *referenced,
+							  RecordBatchState *rb_state,
+							  StringInfo chunk_buffer)
+{
+	ArrowFileState *af_state = rb_state->af_state;
+	arrowFdwDecompressContext con;
+	kern_data_store *kds;
+
+	Assert(rb_state->rb_codec >= 0);
+	memset(&con, 0, sizeof(arrowFdwDecompressContext));
+	con.filename   = af_state->filename;
+	con.rb_offset  = rb_state->rb_offset;
+	con.rb_codec   = rb_state->rb_codec;
+	con.chunk_buffer = chunk_buffer;
+	con.kds_offset = chunk_buffer->len;
+	initStringInfo(&con.temp);
+
+	kds = __arrowFdwSetupKdsHead(relation, rb_state, chunk_buffer);
+	con.filp = PathNameOpenFile(af_state->filename, O_RDONLY | PG_BINARY);
+	if (con.filp < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", af_state->filename)));
+	for (int j=0; j < kds->ncols; j++)
+	{
+		int		attidx = j + 1 - FirstLowInvalidHeapAttributeNumber;
+
+		if (bms_is_member(attidx, referenced) ||
+			bms_is_member(-FirstLowInvalidHeapAttributeNumber, referenced))
+			__decompressArrowField(&con, &rb_state->fields[j], j);
+		else
+			DECOMP_KDS(&con)->colmeta[j].atttypkind = TYPE_KIND__NULL;
+	}
+	FileClose(con.filp);
+	pfree(con.temp.data);
+
+	kds = DECOMP_KDS(&con);
+	kds->length = chunk_buffer->len - con.kds_offset;
+
+	return kds;
+}
+
+static kern_data_store *
+arrowFdwFillupRecordBatch(Relation relation,
+						  Bitmapset *referenced,
+						  RecordBatchState *rb_state,
+						  StringInfo chunk_buffer)
+{
+	ArrowFileState	*af_state = rb_state->af_state;
+	kern_data_store	*kds;
+	strom_io_vector	*iovec;
+	char	   *base;
+	File		filp;
+
+	resetStringInfo(chunk_buffer);
+	if (rb_state->rb_codec >= 0)
+		return arrowFdwDecompressRecordBatch(relation,
+											 referenced,
+											 rb_state,
+											 chunk_buffer);
+	iovec = arrowFdwLoadRecordBatch(relation,
+									referenced,
+									rb_state,
+									chunk_buffer);
+	kds = (kern_data_store *)chunk_buffer->data;
 	enlargeStringInfo(chunk_buffer, kds->length);
 	kds = (kern_data_store *)chunk_buffer->data;
 	filp = PathNameOpenFile(af_state->filename, O_RDONLY | PG_BINARY);
@@ -2604,6 +4278,7 @@ ArrowGetForeignRelSize(PlannerInfo *root,
 	ForeignTable   *ft = GetForeignTable(foreigntableid);
 	Relation		frel = table_open(foreigntableid, NoLock);
 	List		   *filesList;
+	List		   *quals;
 	List		   *results = NIL;
 	Bitmapset	   *referenced = NULL;
 	ListCell	   *lc1, *lc2;
@@ -2622,11 +4297,14 @@ ArrowGetForeignRelSize(PlannerInfo *root,
 
 	/* read arrow-file metadta */
 	filesList = arrowFdwExtractFilesList(ft->options, &parallel_nworkers);
+	quals = extract_actual_clauses(baserel->baserestrictinfo, false);
 	foreach (lc1, filesList)
 	{
 		ArrowFileState *af_state;
 		char	   *fname = strVal(lfirst(lc1));
 
+		if (arrowFdwPartitionFileIsPruned(frel, baserel->relid, fname, quals))
+			continue;
 		af_state = BuildArrowFileState(frel, fname, NULL);
 		if (!af_state)
 			continue;
@@ -2712,6 +4390,9 @@ cost_arrow_fdw_seqscan(Path *path,
 	get_tablespace_page_costs(baserel->reltablespace,
 							  NULL,
 							  &spc_seq_page_cost);
+	/* calibrated by the runtime statistics of CPU scan, if any */
+	pgstromCostCalibLookup(0, baserel->reltablespace,
+						   NULL, &spc_seq_page_cost, NULL);
 	disk_run_cost = spc_seq_page_cost * baserel->pages;
 
 	/* CPU costs */
@@ -3216,7 +4897,10 @@ pg_array_arrow_ref(kern_data_store *kds,
 			}
 			if (__usage > usage)
 				memset((char *)res + usage, 0, __usage - usage);
-			memcpy((char *)res + __usage, &datum, smeta->attlen);
+			if (smeta->attbyval)
+				store_att_byval((char *)res + __usage, datum, smeta->attlen);
+			else
+				memcpy((char *)res + __usage, DatumGetPointer(datum), smeta->attlen);
 			usage = __usage + smeta->attlen;
 		}
 		else if (smeta->attlen == -1)
@@ -3264,6 +4948,13 @@ pg_datum_arrow_ref(kern_data_store *kds,
 		isnull = true;
 		goto out;
 	}
+	if (cmeta->dict_index_sz > 0)
+	{
+		/* dictionary-encoded column */
+		index = KDS_ARROW_DICT_INDEX(kds, cmeta, index);
+		if (index == UINT_MAX)
+			elog(ERROR, "Bug? dictionary index is out of range");
+	}
 
 	switch (cmeta->attopts.tag)
 	{
@@ -3423,6 +5114,364 @@ kds_arrow_fetch_tuple(TupleTableSlot *slot,
 	return true;
 }
 
+/* ----------------------------------------------------------------
+ *
+ * Vectorized filter on the CPU
+ *
+ * Simple comparisons between a fixed-length Int/FloatingPoint column and
+ * a constant are evaluated on the values array of the record-batch using
+ * tight loops, so that the compiler can vectorize them, then the rows
+ * survived are picked up by the selection vector. It prunes rows prior to
+ * forming tuples, however, it never replaces the scan qualifiers; the rows
+ * survived are evaluated by ExecQual again, so it need to be conservative.
+ *
+ * ----------------------------------------------------------------
+ */
+static char
+__arrowVecQualTypeKind(Oid type_oid)
+{
+	switch (type_oid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+			return 'i';
+		case FLOAT4OID:
+		case FLOAT8OID:
+			return 'f';
+		default:
+			break;
+	}
+	return 0;
+}
+
+static arrowVecQual *
+__buildArrowVecQual(Expr *expr, Index scanrelid, TupleDesc tupdesc)
+{
+	OpExpr	   *op = (OpExpr *)expr;
+	Var		   *var;
+	Const	   *con;
+	Oid			opno;
+	Oid			opclass;
+	Oid			opfamily;
+	int			strategy;
+	char		kind;
+	arrowVecQual *vqual;
+
+	if (!IsA(expr, OpExpr) || list_length(op->args) != 2)
+		return NULL;
+	opno = op->opno;
+	var = linitial(op->args);
+	con = lsecond(op->args);
+	if (IsA(var, Const) && IsA(con, Var))
+	{
+		/* CONST <op> VAR shall be VAR <commutator> CONST */
+		var = lsecond(op->args);
+		con = linitial(op->args);
+		opno = get_commutator(opno);
+		if (!OidIsValid(opno))
+			return NULL;
+	}
+	if (!IsA(var, Var) || !IsA(con, Const) ||
+		var->varno != scanrelid ||
+		var->varattno <= 0 ||
+		var->varattno > tupdesc->natts ||
+		con->constisnull)
+		return NULL;
+	kind = __arrowVecQualTypeKind(var->vartype);
+	if (kind == 0 || kind != __arrowVecQualTypeKind(con->consttype))
+		return NULL;
+	/* only built-in btree operators (incl. cross-types) are supported */
+	opclass = GetDefaultOpClass(var->vartype, BTREE_AM_OID);
+	if (!OidIsValid(opclass))
+		return NULL;
+	opfamily = get_opclass_family(opclass);
+	strategy = get_op_opfamily_strategy(opno, opfamily);
+	if (strategy == 0)
+	{
+		Oid		negator = get_negator(opno);
+
+		if (!OidIsValid(negator) ||
+			get_op_opfamily_strategy(negator, opfamily) != BTEqualStrategyNumber)
+			return NULL;
+	}
+	vqual = palloc0(sizeof(arrowVecQual));
+	vqual->expr     = expr;
+	vqual->attidx   = var->varattno - 1;
+	vqual->strategy = strategy;
+	vqual->is_float = (kind == 'f');
+	switch (con->consttype)
+	{
+		case INT2OID:
+			vqual->ival = DatumGetInt16(con->constvalue);
+			break;
+		case INT4OID:
+			vqual->ival = DatumGetInt32(con->constvalue);
+			break;
+		case INT8OID:
+			vqual->ival = DatumGetInt64(con->constvalue);
+			break;
+		case FLOAT4OID:
+			vqual->fval = DatumGetFloat4(con->constvalue);
+			break;
+		case FLOAT8OID:
+			vqual->fval = DatumGetFloat8(con->constvalue);
+			break;
+	}
+	/* NaN follows the PostgreSQL semantics, not IEEE754 */
+	if (vqual->is_float && isnan(vqual->fval))
+	{
+		pfree(vqual);
+		return NULL;
+	}
+	return vqual;
+}
+
+static List *
+buildArrowVecQuals(ScanState *ss, List *quals)
+{
+	Index		scanrelid = ((Scan *)ss->ps.plan)->scanrelid;
+	TupleDesc	tupdesc = RelationGetDescr(ss->ss_currentRelation);
+	List	   *vec_quals = NIL;
+	ListCell   *lc;
+
+	foreach (lc, quals)
+	{
+		arrowVecQual *vqual = __buildArrowVecQual(lfirst(lc), scanrelid, tupdesc);
+
+		if (vqual)
+			vec_quals = lappend(vec_quals, vqual);
+	}
+	return vec_quals;
+}
+
+#define __ARROW_VECQUAL_LOOP(TYPE,EXPR)							\
+	do {														\
+		const TYPE *pg_restrict __values = (const TYPE *)values;	\
+																\
+		for (uint32_t i=0; i < nitems; i++)						\
+		{														\
+			TYPE	v = __values[i];							\
+																\
+			mask[i] &= (EXPR);									\
+		}														\
+	} while(0)
+
+#define __ARROW_VECQUAL_INT(TYPE)										\
+	do {																\
+		TYPE	c = (TYPE)cval;											\
+																		\
+		switch (vqual->strategy)										\
+		{																\
+			case BTLessStrategyNumber:									\
+				__ARROW_VECQUAL_LOOP(TYPE, v <  c);						\
+				break;													\
+			case BTLessEqualStrategyNumber:								\
+				__ARROW_VECQUAL_LOOP(TYPE, v <= c);						\
+				break;													\
+			case BTEqualStrategyNumber:									\
+				__ARROW_VECQUAL_LOOP(TYPE, v == c);						\
+				break;													\
+			case BTGreaterEqualStrategyNumber:							\
+				__ARROW_VECQUAL_LOOP(TYPE, v >= c);						\
+				break;													\
+			case BTGreaterStrategyNumber:								\
+				__ARROW_VECQUAL_LOOP(TYPE, v >  c);						\
+				break;													\
+			default:	/* '<>' */										\
+				__ARROW_VECQUAL_LOOP(TYPE, v != c);						\
+				break;													\
+		}																\
+	} while(0)
+
+/*
+ * NaN is larger than any other values in PostgreSQL, unlike IEEE754.
+ * The negated comparisons keep NaN in the selection, then ExecQual
+ * evaluates them by the PostgreSQL semantics.
+ */
+#define __ARROW_VECQUAL_FLOAT(TYPE,CTYPE)								\
+	do {																\
+		CTYPE	c = (CTYPE)vqual->fval;									\
+																		\
+		switch (vqual->strategy)										\
+		{																\
+			case BTLessStrategyNumber:									\
+				__ARROW_VECQUAL_LOOP(TYPE, !(v >= c));					\
+				break;													\
+			case BTLessEqualStrategyNumber:								\
+				__ARROW_VECQUAL_LOOP(TYPE, !(v >  c));					\
+				break;													\
+			case BTEqualStrategyNumber:									\
+				__ARROW_VECQUAL_LOOP(TYPE, !(v < c || v > c));			\
+				break;													\
+			case BTGreaterEqualStrategyNumber:							\
+				__ARROW_VECQUAL_LOOP(TYPE, !(v <  c));					\
+				break;													\
+			case BTGreaterStrategyNumber:								\
+				__ARROW_VECQUAL_LOOP(TYPE, !(v <= c));					\
+				break;													\
+			default:	/* '<>' */										\
+				__ARROW_VECQUAL_LOOP(TYPE, v != c);						\
+				break;													\
+		}																\
+	} while(0)
+
+/*
+ * __arrowVecQualIntRange
+ *
+ * It checks whether the integer constant is in the range of the column
+ * type. Elsewhere, the result is identical for all the not-null values;
+ * it returns 1 if all true, or -1 if all false.
+ */
+static int
+__arrowVecQualIntRange(arrowVecQual *vqual, int64_t lower, int64_t upper)
+{
+	if (vqual->ival > upper)
+	{
+		switch (vqual->strategy)
+		{
+			case BTLessStrategyNumber:
+			case BTLessEqualStrategyNumber:
+			case 0:		/* '<>' */
+				return 1;
+			default:
+				return -1;
+		}
+	}
+	if (vqual->ival < lower)
+	{
+		switch (vqual->strategy)
+		{
+			case BTGreaterStrategyNumber:
+			case BTGreaterEqualStrategyNumber:
+			case 0:		/* '<>' */
+				return 1;
+			default:
+				return -1;
+		}
+	}
+	return 0;
+}
+
+static void
+__execArrowVecQual(arrowVecQual *vqual,
+				   kern_data_store *kds,
+				   uint8_t *pg_restrict mask)
+{
+	kern_colmeta *cmeta = &kds->colmeta[vqual->attidx];
+	uint32_t	nitems = kds->nitems;
+	const char *values;
+
+	/* not loaded, or unexpected layout; no rows are filtered */
+	if (cmeta->values_offset == 0 ||
+		cmeta->dict_index_sz > 0 ||
+		cmeta->attopts.unitsz <= 0 ||
+		(size_t)cmeta->attopts.unitsz * nitems > __kds_unpack(cmeta->values_length))
+		return;
+	values = (const char *)kds + __kds_unpack(cmeta->values_offset);
+
+	if (cmeta->attopts.tag == ArrowType__Int && !vqual->is_float)
+	{
+		int64_t		cval = vqual->ival;
+		int			range;
+
+		switch (cmeta->attopts.unitsz)
+		{
+			case sizeof(int16_t):
+				range = __arrowVecQualIntRange(vqual, PG_INT16_MIN, PG_INT16_MAX);
+				if (range == 0)
+					__ARROW_VECQUAL_INT(int16_t);
+				break;
+			case sizeof(int32_t):
+				range = __arrowVecQualIntRange(vqual, PG_INT32_MIN, PG_INT32_MAX);
+				if (range == 0)
+					__ARROW_VECQUAL_INT(int32_t);
+				break;
+			case sizeof(int64_t):
+				range = 0;
+				__ARROW_VECQUAL_INT(int64_t);
+				break;
+			default:
+				return;
+		}
+		if (range < 0)
+		{
+			memset(mask, 0, sizeof(uint8_t) * nitems);
+			return;
+		}
+	}
+	else if (cmeta->attopts.tag == ArrowType__FloatingPoint && vqual->is_float)
+	{
+		switch (cmeta->attopts.floating_point.precision)
+		{
+			case ArrowPrecision__Single:
+				/* float48 operators compare the values in float8 */
+				if ((float8)((float4)vqual->fval) == vqual->fval)
+					__ARROW_VECQUAL_FLOAT(float4, float4);
+				else
+					__ARROW_VECQUAL_FLOAT(float4, float8);
+				break;
+			case ArrowPrecision__Double:
+				__ARROW_VECQUAL_FLOAT(float8, float8);
+				break;
+			default:
+				return;
+		}
+	}
+	else
+		return;
+
+	/* NULL never satisfies the strict operators */
+	if (cmeta->nullmap_offset != 0)
+	{
+		const uint8_t *nullmap = (const uint8_t *)kds + __kds_unpack(cmeta->nullmap_offset);
+
+		if (__kds_unpack(cmeta->nullmap_length) >= (nitems + 7) / 8)
+		{
+			for (uint32_t i=0; i < nitems; i++)
+				mask[i] &= ((nullmap[i>>3] >> (i & 7)) & 1);
+		}
+	}
+}
+
+/*
+ * execArrowVecQuals
+ *
+ * It evaluates the vectorized filter on the record-batch, then builds the
+ * selection vector. It returns the number of rows survived.
+ */
+static uint32_t
+execArrowVecQuals(ArrowFdwState *arrow_state, kern_data_store *kds)
+{
+	uint32_t	nitems = kds->nitems;
+	uint32_t	nsel = 0;
+	ListCell   *lc;
+
+	if (nitems > arrow_state->vec_nrooms)
+	{
+		MemoryContext memcxt = GetMemoryChunkContext(arrow_state);
+		uint32_t	nrooms = Max(nitems, 2 * arrow_state->vec_nrooms);
+
+		if (arrow_state->vec_mask)
+			pfree(arrow_state->vec_mask);
+		if (arrow_state->vec_sel)
+			pfree(arrow_state->vec_sel);
+		arrow_state->vec_mask = MemoryContextAlloc(memcxt, sizeof(uint8_t) * nrooms);
+		arrow_state->vec_sel  = MemoryContextAlloc(memcxt, sizeof(uint32_t) * nrooms);
+		arrow_state->vec_nrooms = nrooms;
+	}
+	memset(arrow_state->vec_mask, 1, sizeof(uint8_t) * nitems);
+	foreach (lc, arrow_state->vec_quals)
+		__execArrowVecQual(lfirst(lc), kds, arrow_state->vec_mask);
+	for (uint32_t i=0; i < nitems; i++)
+	{
+		arrow_state->vec_sel[nsel] = i;
+		nsel += arrow_state->vec_mask[i];
+	}
+	arrow_state->vec_nfiltered += (nitems - nsel);
+	return nsel;
+}
+
 /* ----------------------------------------------------------------
  *
  * Executor callbacks
@@ -3453,6 +5502,7 @@ __arrowFdwExecInit(ScanState *ss,
 	uint32_t		rb_nrooms = 0;
 	uint32_t		rb_nitems = 0;
 	ArrowFdwState *arrow_state;
+	arrowStatsHint *stats_hint = NULL;
 	ListCell	   *lc1, *lc2;
 
 	Assert(RelationIsArrowFdw(frel));
@@ -3477,10 +5527,12 @@ __arrowFdwExecInit(ScanState *ss,
 		char	   *fname = strVal(lfirst(lc1));
 		ArrowFileState *af_state;
 
+		if (arrowFdwPartitionFileIsPruned(frel, ((Scan *)ss->ps.plan)->scanrelid,
+										  fname, outer_quals))
+			continue;
 		af_state = BuildArrowFileState(frel, fname, &stat_attrs);
 		if (af_state)
 		{
-			rb_nrooms += list_length(af_state->rb_list);
 			if (p_optimal_gpus)
 			{
 				const Bitmapset  *__optimal_gpus = GetOptimalGpuForFile(fname);
@@ -3507,11 +5559,32 @@ __arrowFdwExecInit(ScanState *ss,
 		}
 	}
 
-	/* setup ArrowFdwState */
+	/*
+	 * setup ArrowFdwState
+	 *
+	 * If min/max statistics are available, record-batches are expanded
+	 * to the zones, if any, to skip a part of record-batches.
+	 */
+	if (arrow_fdw_stats_hint_enabled)
+		stats_hint = execInitArrowStatsHint(ss, outer_quals, stat_attrs,
+											af_states_list);
+	foreach (lc1, af_states_list)
+	{
+		ArrowFileState *af_state = lfirst(lc1);
+
+		foreach (lc2, af_state->rb_list)
+		{
+			RecordBatchState *rb_state = lfirst(lc2);
+
+			if (stats_hint && rb_state->zone_states != NIL)
+				rb_nrooms += list_length(rb_state->zone_states);
+			else
+				rb_nrooms++;
+		}
+	}
 	arrow_state = palloc0(offsetof(ArrowFdwState, rb_states[rb_nrooms]));
 	arrow_state->referenced = referenced;
-	if (arrow_fdw_stats_hint_enabled)
-		arrow_state->stats_hint = execInitArrowStatsHint(ss, outer_quals, stat_attrs);
+	arrow_state->stats_hint = stats_hint;
 	arrow_state->rbatch_index = &arrow_state->__rbatch_index_local;
 	arrow_state->rbatch_nload = &arrow_state->__rbatch_nload_local;
 	arrow_state->rbatch_nskip = &arrow_state->__rbatch_nskip_local;
@@ -3528,7 +5601,15 @@ __arrowFdwExecInit(ScanState *ss,
 		{
 			RecordBatchState *rb_state = lfirst(lc2);
 
-			arrow_state->rb_states[rb_nitems++] = rb_state;
+			if (stats_hint && rb_state->zone_states != NIL)
+			{
+				ListCell   *lc3;
+
+				foreach (lc3, rb_state->zone_states)
+					arrow_state->rb_states[rb_nitems++] = lfirst(lc3);
+			}
+			else
+				arrow_state->rb_states[rb_nitems++] = rb_state;
 		}
 	}
 	Assert(rb_nrooms == rb_nitems);
@@ -3574,6 +5655,7 @@ static void
 ArrowBeginForeignScan(ForeignScanState *node, int eflags)
 {
 	ForeignScan	   *fscan = (ForeignScan *)node->ss.ps.plan;
+	ArrowFdwState  *arrow_state;
 	Bitmapset	   *referenced = NULL;
 	ListCell	   *lc;
 
@@ -3583,20 +5665,119 @@ ArrowBeginForeignScan(ForeignScanState *node, int eflags)
 
 		referenced = bms_add_member(referenced, k);
 	}
-	node->fdw_state = __arrowFdwExecInit(&node->ss,
-										 fscan->scan.plan.qual,
-										 referenced,
-										 NULL,	/* no GPU */
-										 NULL);	/* no DPU */
+	arrow_state = __arrowFdwExecInit(&node->ss,
+									 fscan->scan.plan.qual,
+									 referenced,
+									 NULL,	/* no GPU */
+									 NULL);	/* no DPU */
+	/*
+	 * Late materialization; if scan qualifiers reference a part of the
+	 * columns, the record-batch is loaded with only these columns first,
+	 * then the rest of columns are loaded only if any rows survived.
+	 */
+	if (arrow_fdw_late_materialization &&
+		fscan->scan.plan.qual != NIL &&
+		!contain_volatile_functions((Node *)fscan->scan.plan.qual))
+	{
+		Bitmapset  *late_referenced = NULL;
+
+		pull_varattnos((Node *)fscan->scan.plan.qual,
+					   fscan->scan.scanrelid,
+					   &late_referenced);
+		if (!bms_is_member(-FirstLowInvalidHeapAttributeNumber,
+						   late_referenced) &&
+			bms_is_subset(late_referenced, referenced) &&
+			!bms_equal(late_referenced, referenced))
+			arrow_state->late_referenced = late_referenced;
+	}
+	/* Vectorized filter for simple comparisons, if any */
+	if (arrow_fdw_vectorized_filter)
+		arrow_state->vec_quals = buildArrowVecQuals(&node->ss,
+													fscan->scan.plan.qual);
+	arrow_state->calib_start_ts = GetCurrentTimestamp();
+	node->fdw_state = arrow_state;
 }
 
 /*
  * ExecArrowScanChunk
  */
-static inline RecordBatchState *
-__arrowFdwNextRecordBatch(ArrowFdwState *arrow_state)
-{
-	RecordBatchState *rb_state;
+
+/*
+ * __arrowFdwNextZones
+ *
+ * It tries to acquire the following zones of the same record-batch, then
+ * merges them into a contiguous row-range, to avoid tiny i/o chunks.
+ */
+static RecordBatchState *
+__arrowFdwNextZones(ArrowFdwState *arrow_state,
+					uint32_t rb_index, RecordBatchState *head)
+{
+	RecordBatchState *tail = head;
+	RecordBatchState *merged;
+	uint32_t	nzones = 1;
+	int64		nitems = head->rb_nitems;
+	size_t		length = head->rb_length;
+
+	for (;;)
+	{
+		uint32_t	next = rb_index + nzones;
+		RecordBatchState *curr;
+
+		if (next >= arrow_state->rb_nitems)
+			break;
+		curr = arrow_state->rb_states[next];
+		if (curr->af_state   != head->af_state ||
+			curr->rb_index   != head->rb_index ||
+			curr->zone_index != tail->zone_index + 1)
+			break;
+		if (execCheckArrowStatsHint(arrow_state->stats_hint, curr))
+			break;
+		if (!pg_atomic_compare_exchange_u32(arrow_state->rbatch_index,
+											&next, next + 1))
+			break;		/* someone already took the zone */
+		pg_atomic_fetch_add_u32(arrow_state->rbatch_nload, 1);
+		nitems += curr->rb_nitems;
+		length += curr->rb_length;
+		tail = curr;
+		nzones++;
+	}
+	if (nzones == 1)
+		return head;
+
+	if (!arrow_state->zone_merged)
+		arrow_state->zone_merged =
+			MemoryContextAlloc(GetMemoryChunkContext(arrow_state),
+							   offsetof(RecordBatchState,
+										fields[head->nfields]));
+	merged = arrow_state->zone_merged;
+	memcpy(merged, head, offsetof(RecordBatchState, fields[head->nfields]));
+	merged->rb_nitems = nitems;
+	merged->rb_length = length;
+	for (int j=0; j < head->nfields; j++)
+	{
+		RecordBatchFieldState *m_field = &merged->fields[j];
+		RecordBatchFieldState *t_field = &tail->fields[j];
+
+		/* zones are flat, and sliced from the same buffers */
+		Assert(m_field->num_children == 0);
+		m_field->nitems = nitems;
+		if (m_field->nullmap_length > 0)
+			m_field->nullmap_length = (t_field->nullmap_offset +
+									   t_field->nullmap_length -
+									   m_field->nullmap_offset);
+		if (m_field->values_length > 0)
+			m_field->values_length = (t_field->values_offset +
+									  t_field->values_length -
+									  m_field->values_offset);
+		m_field->stat_datum.isnull = true;
+	}
+	return merged;
+}
+
+static inline RecordBatchState *
+__arrowFdwNextRecordBatch(ArrowFdwState *arrow_state)
+{
+	RecordBatchState *rb_state;
 	uint32_t	rb_index;
 
 retry:
@@ -3612,6 +5793,8 @@ retry:
 			goto retry;
 		}
 		pg_atomic_fetch_add_u32(arrow_state->rbatch_nload, 1);
+		if (rb_state->zone_index >= 0)
+			rb_state = __arrowFdwNextZones(arrow_state, rb_index, rb_state);
 	}
 	return rb_state;
 }
@@ -3647,11 +5830,31 @@ pgstromScanChunkArrowFdw(pgstromTaskState *pts,
 						   pts->xcmd_buf.data,
 						   pts->xcmd_buf.len);
 	/* kds_src + iovec */
-	kds_src_offset = chunk_buffer->len;
-	iovec = arrowFdwLoadRecordBatch(pts->css.ss.ss_currentRelation,
-									arrow_state->referenced,
-									rb_state,
-									chunk_buffer);
+	if (rb_state->rb_codec < 0)
+	{
+		kds_src_offset = chunk_buffer->len;
+		iovec = arrowFdwLoadRecordBatch(pts->css.ss.ss_currentRelation,
+										arrow_state->referenced,
+										rb_state,
+										chunk_buffer);
+	}
+	else
+	{
+		/*
+		 * compressed record-batch shall be decompressed on the host side,
+		 * then delivered to the GPU service as inline KDS (no i/o chunks).
+		 */
+		if (pts->ds_entry)
+			elog(ERROR, "arrow_fdw: compressed record-batch is not supported on DPU");
+		while (chunk_buffer->len != MAXALIGN(chunk_buffer->len))
+			appendStringInfoChar(chunk_buffer, '\0');
+		kds_src_offset = chunk_buffer->len;
+		arrowFdwDecompressRecordBatch(pts->css.ss.ss_currentRelation,
+									  arrow_state->referenced,
+									  rb_state,
+									  chunk_buffer);
+		iovec = palloc0(offsetof(strom_io_vector, ioc));
+	}
 	kds_src_iovec = __appendBinaryStringInfo(chunk_buffer,
 											 iovec,
 											 offsetof(strom_io_vector,
@@ -3678,6 +5881,53 @@ pgstromScanChunkArrowFdw(pgstromTaskState *pts,
 	return xcmd;
 }
 
+/*
+ * __arrowFdwLateMaterializationCheck
+ *
+ * It evaluates the scan qualifiers on the record-batch that contains only
+ * the columns referenced by the qualifiers, and returns true immediately
+ * once a row is survived.
+ */
+static bool
+__arrowFdwLateMaterializationCheck(ForeignScanState *node,
+								   RecordBatchState *rb_state)
+{
+	ArrowFdwState  *arrow_state = node->fdw_state;
+	TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
+	ExprContext	   *econtext = node->ss.ps.ps_ExprContext;
+	kern_data_store *kds;
+	uint32_t		nitems;
+	bool			survived = false;
+
+	kds = arrowFdwFillupRecordBatch(node->ss.ss_currentRelation,
+									arrow_state->late_referenced,
+									rb_state,
+									&arrow_state->chunk_buffer);
+	nitems = kds->nitems;
+	if (arrow_state->vec_quals != NIL)
+	{
+		nitems = execArrowVecQuals(arrow_state, kds);
+		/* the rows survived are counted again on the later load */
+		arrow_state->vec_nfiltered -= (kds->nitems - nitems);
+	}
+	for (uint32_t i=0; i < nitems && !survived; i++)
+	{
+		uint32_t	index = (arrow_state->vec_quals != NIL
+							 ? arrow_state->vec_sel[i] : i);
+
+		kds_arrow_fetch_tuple(slot, kds, index, arrow_state->late_referenced);
+		ResetExprContext(econtext);
+		econtext->ecxt_scantuple = slot;
+		if (ExecQual(node->ss.ps.qual, econtext))
+			survived = true;
+	}
+	ResetExprContext(econtext);
+	ExecClearTuple(slot);
+	if (!survived)
+		arrow_state->late_nskip++;
+	return survived;
+}
+
 /*
  * ArrowIterateForeignScan
  */
@@ -3687,28 +5937,45 @@ ArrowIterateForeignScan(ForeignScanState *node)
 	ArrowFdwState *arrow_state = node->fdw_state;
 	TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
 	kern_data_store *kds;
+	uint32_t		index;
 
 	while ((kds = arrow_state->curr_kds) == NULL ||
-		   arrow_state->curr_index >= kds->nitems)
+		   arrow_state->curr_index >= arrow_state->curr_nitems)
 	{
 		RecordBatchState *rb_state;
 
 		arrow_state->curr_index = 0;
+		arrow_state->curr_nitems = 0;
 		arrow_state->curr_kds = NULL;
 		rb_state = __arrowFdwNextRecordBatch(arrow_state);
 		if (!rb_state)
 			return NULL;
+		if (arrow_state->late_referenced &&
+			!__arrowFdwLateMaterializationCheck(node, rb_state))
+			continue;
 		arrow_state->curr_kds
 			= arrowFdwFillupRecordBatch(node->ss.ss_currentRelation,
 										arrow_state->referenced,
 										rb_state,
 										&arrow_state->chunk_buffer);
+		arrow_state->calib_nbytes += arrow_state->curr_kds->length;
+		if (arrow_state->vec_quals != NIL)
+			arrow_state->curr_nitems = execArrowVecQuals(arrow_state,
+														 arrow_state->curr_kds);
+		else
+			arrow_state->curr_nitems = arrow_state->curr_kds->nitems;
 	}
-	Assert(kds && arrow_state->curr_index < kds->nitems);
-	if (kds_arrow_fetch_tuple(slot, kds,
-							  arrow_state->curr_index++,
+	Assert(kds && arrow_state->curr_index < arrow_state->curr_nitems);
+	if (arrow_state->vec_quals != NIL)
+		index = arrow_state->vec_sel[arrow_state->curr_index++];
+	else
+		index = arrow_state->curr_index++;
+	if (kds_arrow_fetch_tuple(slot, kds, index,
 							  arrow_state->referenced))
+	{
+		arrow_state->calib_ntuples++;
 		return slot;
+	}
 	return NULL;
 }
 
@@ -3723,6 +5990,7 @@ pgstromArrowFdwExecReset(ArrowFdwState *arrow_state)
 		pfree(arrow_state->curr_kds);
 	arrow_state->curr_kds = NULL;
 	arrow_state->curr_index = 0;
+	arrow_state->curr_nitems = 0;
 }
 
 static void
@@ -3746,7 +6014,17 @@ pgstromArrowFdwExecEnd(ArrowFdwState *arrow_state)
 static void
 ArrowEndForeignScan(ForeignScanState *node)
 {
-	pgstromArrowFdwExecEnd(node->fdw_state);
+	ArrowFdwState  *arrow_state = node->fdw_state;
+	Relation		relation = node->ss.ss_currentRelation;
+	TimestampTz		ts_end = GetCurrentTimestamp();
+
+	/* CPU scan is recorded with devkind = 0 */
+	pgstromCostCalibRecord(0, RelationGetForm(relation)->reltablespace,
+						   0.0,
+						   (double)(ts_end - arrow_state->calib_start_ts),
+						   (double)arrow_state->calib_nbytes / (double)BLCKSZ,
+						   (double)arrow_state->calib_ntuples);
+	pgstromArrowFdwExecEnd(arrow_state);
 }
 
 /*
@@ -3903,6 +6181,50 @@ pgstromArrowFdwExplain(ArrowFdwState *arrow_state,
 							 pg_atomic_read_u32(arrow_state->rbatch_nskip));
 		ExplainPropertyText("Stats-Hint", buf.data, es);
 	}
+	/* shows late-materialization, if any */
+	if (arrow_state->late_referenced)
+	{
+		resetStringInfo(&buf);
+		for (k = bms_next_member(arrow_state->late_referenced, -1);
+			 k >= 0;
+			 k = bms_next_member(arrow_state->late_referenced, k))
+		{
+			j = k + FirstLowInvalidHeapAttributeNumber;
+
+			if (j > 0)
+			{
+				Form_pg_attribute attr = TupleDescAttr(tupdesc, j-1);
+				const char	   *attname = NameStr(attr->attname);
+
+				if (buf.len > 0)
+					appendStringInfoString(&buf, ", ");
+				appendStringInfoString(&buf, quote_identifier(attname));
+			}
+		}
+		if (es->analyze)
+			appendStringInfo(&buf, "  [skipped: %u]", arrow_state->late_nskip);
+		ExplainPropertyText("Late-Materialization", buf.data, es);
+	}
+	/* shows vectorized filter, if any */
+	if (arrow_state->vec_quals != NIL)
+	{
+		resetStringInfo(&buf);
+		foreach (lc1, arrow_state->vec_quals)
+		{
+			arrowVecQual *vqual = lfirst(lc1);
+			char   *temp;
+
+			temp = deparse_expression((Node *)vqual->expr, dcontext,
+									  es->verbose, false);
+			if (buf.len > 0)
+				appendStringInfoString(&buf, ", ");
+			appendStringInfoString(&buf, temp);
+			pfree(temp);
+		}
+		if (es->analyze)
+			appendStringInfo(&buf, "  [filtered: %lu]", arrow_state->vec_nfiltered);
+		ExplainPropertyText("Vectorized-Filter", buf.data, es);
+	}
 
 	/* shows files on behalf of the foreign table */
 	chunk_sz = alloca(sizeof(size_t) * tupdesc->natts);
@@ -4454,6 +6776,965 @@ pgstrom_arrow_fdw_import_file(PG_FUNCTION_ARGS)
 	PG_RETURN_VOID();
 }
 
+/* ----------------------------------------------------------------
+ *
+ * INSERT support of Arrow_Fdw
+ *
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * arrowWriteFile
+ *
+ * An arrow file being written by the current transaction. It is locked
+ * exclusively until the end of the transaction, and keeps the footer image
+ * at the beginning of each (sub-)transaction as undo log, to revert the
+ * file on abort. New RecordBatches overwrite the footer, then the new
+ * footer is written at the tail again, like 'pg2arrow --append'.
+ */
+typedef struct
+{
+	SubTransactionId subid;
+	off_t		footer_offset;
+	size_t		footer_length;
+	char		footer_backup[FLEXIBLE_ARRAY_MEMBER];
+} arrowWriteUndoLog;
+
+typedef struct
+{
+	dlist_node	chain;
+	char	   *filename;
+	int			fdesc;
+	List	   *undo_logs;		/* list of arrowWriteUndoLog, newer first */
+} arrowWriteFile;
+
+typedef struct
+{
+	arrowWriteFile *wfile;
+	MemoryContext memcxt;		/* buffer of the pending RecordBatch */
+	MemoryContext tmpcxt;		/* per-row working memory */
+	Datum	   *values;			/* detoasted values of the row */
+	bool		has_footer;		/* file already had the footer */
+	uint64_t	nrows;			/* number of rows written */
+	SQLtable   *table;
+} arrowWriteState;
+
+#define ARROW_FDW_INSERT_BATCH_SIZE		1000
+
+static dlist_head	arrow_write_files_list = DLIST_STATIC_INIT(arrow_write_files_list);
+
+/*
+ * __arrowWriteFooterOffset
+ */
+static off_t
+__arrowWriteFooterOffset(arrowWriteFile *wfile, size_t file_sz)
+{
+	char		buffer[sizeof(int32_t) + 6];	/* strlen("ARROW1") */
+	size_t		length;
+
+	if (file_sz < sizeof(buffer) ||
+		__preadFile(wfile->fdesc, buffer, sizeof(buffer),
+					file_sz - sizeof(buffer)) != sizeof(buffer))
+		elog(ERROR, "arrow_fdw: failed to read the footer of '%s'",
+			 wfile->filename);
+	if (memcmp(buffer + sizeof(int32_t), "ARROW1", 6) != 0)
+		elog(ERROR, "arrow_fdw: '%s' is not an Apache Arrow file with footer",
+			 wfile->filename);
+	length = sizeof(buffer) + *((uint32_t *)buffer);
+	if (length > file_sz)
+		elog(ERROR, "arrow_fdw: footer of '%s' is corrupted", wfile->filename);
+	return file_sz - length;
+}
+
+/*
+ * __arrowWriteOpenFile
+ */
+static arrowWriteFile *
+__arrowWriteOpenFile(const char *filename)
+{
+	arrowWriteFile *wfile;
+	dlist_iter	iter;
+
+	dlist_foreach(iter, &arrow_write_files_list)
+	{
+		wfile = dlist_container(arrowWriteFile, chain, iter.cur);
+		if (strcmp(wfile->filename, filename) == 0)
+			return wfile;
+	}
+	wfile = MemoryContextAllocZero(TopMemoryContext, sizeof(arrowWriteFile));
+	wfile->filename = MemoryContextStrdup(TopMemoryContext, filename);
+	wfile->fdesc = open(filename, O_RDWR | O_CREAT | PG_BINARY,
+						pg_file_create_mode);
+	if (wfile->fdesc < 0)
+	{
+		int		errno_saved = errno;
+
+		pfree(wfile->filename);
+		pfree(wfile);
+		errno = errno_saved;
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", filename)));
+	}
+	/* closed at the end of transaction, even if flock(2) is interrupted */
+	dlist_push_tail(&arrow_write_files_list, &wfile->chain);
+
+	/* concurrent writers of the same file are serialized */
+	while (flock(wfile->fdesc, LOCK_EX | LOCK_NB) != 0)
+	{
+		if (errno != EWOULDBLOCK && errno != EINTR)
+			elog(ERROR, "failed on flock('%s'): %m", filename);
+		CHECK_FOR_INTERRUPTS();
+		pg_usleep(10000L);		/* 10ms */
+	}
+	return wfile;
+}
+
+/*
+ * __arrowWriteSaveUndoLog
+ */
+static void
+__arrowWriteSaveUndoLog(arrowWriteFile *wfile)
+{
+	SubTransactionId subid = GetCurrentSubTransactionId();
+	arrowWriteUndoLog *undo;
+	struct stat	stat_buf;
+	off_t		offset = 0;
+	size_t		length = 0;
+	MemoryContext oldcxt;
+
+	if (wfile->undo_logs != NIL)
+	{
+		undo = linitial(wfile->undo_logs);
+		if (undo->subid == subid)
+			return;		/* already saved */
+	}
+	if (fstat(wfile->fdesc, &stat_buf) != 0)
+		elog(ERROR, "failed on fstat('%s'): %m", wfile->filename);
+	if (stat_buf.st_size > 0)
+	{
+		offset = __arrowWriteFooterOffset(wfile, stat_buf.st_size);
+		length = stat_buf.st_size - offset;
+	}
+	undo = MemoryContextAlloc(TopMemoryContext,
+							  offsetof(arrowWriteUndoLog,
+									   footer_backup[length]));
+	undo->subid = subid;
+	undo->footer_offset = offset;
+	undo->footer_length = length;
+	if (length > 0 &&
+		__preadFile(wfile->fdesc, undo->footer_backup,
+					length, offset) != length)
+	{
+		pfree(undo);
+		elog(ERROR, "failed on pread('%s'): %m", wfile->filename);
+	}
+	oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+	wfile->undo_logs = lcons(undo, wfile->undo_logs);
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * __arrowWriteApplyUndoLog
+ *
+ * It is called on (sub-)transaction abort, so never raise an error here.
+ */
+static void
+__arrowWriteApplyUndoLog(arrowWriteFile *wfile, arrowWriteUndoLog *undo)
+{
+	if (__pwriteFile(wfile->fdesc,
+					 undo->footer_backup,
+					 undo->footer_length,
+					 undo->footer_offset) != undo->footer_length ||
+		ftruncate(wfile->fdesc, (undo->footer_offset +
+								 undo->footer_length)) != 0)
+		elog(WARNING, "arrow_fdw: failed to revert '%s': %m",
+			 wfile->filename);
+}
+
+/*
+ * __arrowWriteSetupField
+ */
+static void
+__arrowWriteSetupField(SQLtable *table,
+					   SQLfield *column,
+					   const char *field_name,
+					   Oid type_oid,
+					   int32 typmod,
+					   ArrowField *arrow_field)
+{
+	HeapTuple	htup;
+	Form_pg_type typ;
+	Oid			ext_oid;
+	const char *nspname;
+	const char *extname = NULL;
+	const char *tz_name = NULL;
+	Oid			typelem;
+
+	/* keep the field name of the existing file */
+	if (arrow_field && arrow_field->name)
+		field_name = arrow_field->name;
+	type_oid = getBaseTypeAndTypmod(type_oid, &typmod);
+	htup = SearchSysCache1(TYPEOID, ObjectIdGetDatum(type_oid));
+	if (!HeapTupleIsValid(htup))
+		elog(ERROR, "cache lookup failed for type %u", type_oid);
+	typ = (Form_pg_type) GETSTRUCT(htup);
+	if (typ->typtype == TYPTYPE_ENUM)
+		elog(ERROR, "arrow_fdw: INSERT on enum type column '%s' is not supported",
+			 field_name);
+	nspname = get_namespace_name(typ->typnamespace);
+	ext_oid = getExtensionOfObject(TypeRelationId, type_oid);
+	if (OidIsValid(ext_oid))
+		extname = get_extension_name(ext_oid);
+	if (type_oid == TIMESTAMPTZOID)
+		tz_name = pg_get_timezone_name(session_timezone);
+	typelem = (typ->typlen == -1 ? typ->typelem : InvalidOid);
+
+	table->numFieldNodes++;
+	table->numBuffers += assignArrowTypePgSQL(column,
+											  field_name,
+											  type_oid,
+											  typmod,
+											  NameStr(typ->typname),
+											  nspname,
+											  typ->typlen,
+											  typ->typbyval,
+											  typ->typtype,
+											  typ->typalign,
+											  typ->typrelid,
+											  typelem,
+											  tz_name,
+											  extname,
+											  nspname,
+											  arrow_field);
+	if (OidIsValid(typ->typrelid))
+	{
+		TupleDesc	tupdesc = lookup_rowtype_tupdesc(type_oid, -1);
+
+		if (arrow_field && arrow_field->_num_children != tupdesc->natts)
+			elog(ERROR, "arrow_fdw: unexpected number of sub-fields in '%s'",
+				 field_name);
+		column->nfields = tupdesc->natts;
+		column->subfields = palloc0(sizeof(SQLfield) * tupdesc->natts);
+		for (int j=0; j < tupdesc->natts; j++)
+		{
+			Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+			SQLfield   *sub = &column->subfields[j];
+
+			if (attr->attisdropped)
+				elog(ERROR, "arrow_fdw: composite type of '%s' has dropped columns",
+					 field_name);
+			__arrowWriteSetupField(table, sub,
+								   NameStr(attr->attname),
+								   attr->atttypid,
+								   attr->atttypmod,
+								   arrow_field ? &arrow_field->children[j] : NULL);
+			if (!sub->sql_type.pgsql.typbyval &&
+				sub->sql_type.pgsql.typlen != -1)
+				elog(ERROR, "arrow_fdw: sub-field '%s' of '%s' has unsupported type",
+					 sub->field_name, field_name);
+		}
+		ReleaseTupleDesc(tupdesc);
+	}
+	else if (OidIsValid(typelem))
+	{
+		SQLfield   *elem = palloc0(sizeof(SQLfield));
+
+		if (arrow_field && arrow_field->_num_children != 1)
+			elog(ERROR, "arrow_fdw: unexpected number of child fields in '%s'",
+				 field_name);
+		__arrowWriteSetupField(table, elem,
+							   format_type_be(typelem),
+							   typelem,
+							   typmod,
+							   arrow_field ? &arrow_field->children[0] : NULL);
+		if (!elem->sql_type.pgsql.typbyval &&
+			elem->sql_type.pgsql.typlen != -1)
+			elog(ERROR, "arrow_fdw: array element of '%s' has unsupported type",
+				 field_name);
+		column->element = elem;
+	}
+	ReleaseSysCache(htup);
+}
+
+/*
+ * __arrowBeginForeignInsert
+ */
+static arrowWriteState *
+__arrowBeginForeignInsert(Relation frel, EState *estate)
+{
+	ForeignTable   *ft = GetForeignTable(RelationGetRelid(frel));
+	TupleDesc		tupdesc = RelationGetDescr(frel);
+	List		   *filesList;
+	const char	   *filename;
+	arrowWriteState *wstate;
+	arrowWriteFile *wfile;
+	ArrowFileInfo	af_info;
+	SQLtable	   *table;
+	struct stat		stat_buf;
+	MemoryContext	oldcxt;
+
+	if (!arrowFdwOptionIsWritable(ft->options))
+		elog(ERROR, "arrow_fdw: foreign table '%s' is not writable",
+			 RelationGetRelationName(frel));
+	if (!has_privs_of_role(GetUserId(), ROLE_PG_WRITE_SERVER_FILES))
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("permission denied to write arrow file"),
+				 errhint("Only roles with privileges of the \"%s\" role may INSERT into arrow_fdw foreign tables.",
+						 "pg_write_server_files")));
+	filesList = arrowFdwExtractFilesList(ft->options, NULL);
+	Assert(list_length(filesList) == 1);
+	filename = strVal(linitial(filesList));
+
+	wstate = palloc0(sizeof(arrowWriteState));
+	wstate->memcxt = AllocSetContextCreate(estate->es_query_cxt,
+										   "arrow_fdw write buffer",
+										   ALLOCSET_DEFAULT_SIZES);
+	wstate->tmpcxt = AllocSetContextCreate(estate->es_query_cxt,
+										   "arrow_fdw per-row context",
+										   ALLOCSET_SMALL_SIZES);
+	wstate->values = palloc0(sizeof(Datum) * tupdesc->natts);
+
+	wfile = __arrowWriteOpenFile(filename);
+	__arrowWriteSaveUndoLog(wfile);
+	if (fstat(wfile->fdesc, &stat_buf) != 0)
+		elog(ERROR, "failed on fstat('%s'): %m", filename);
+
+	oldcxt = MemoryContextSwitchTo(wstate->memcxt);
+	table = palloc0(offsetof(SQLtable, columns[tupdesc->natts]));
+	table->filename = wfile->filename;
+	table->fdesc = wfile->fdesc;
+	table->segment_sz = (size_t)arrow_record_batch_size_kb << 10;
+	table->nfields = tupdesc->natts;
+	if (stat_buf.st_size > 0)
+	{
+		ArrowSchema *schema;
+
+		readArrowFileDesc(wfile->fdesc, &af_info);
+		schema = &af_info.footer.schema;
+		if (af_info.stream_length > 0 ||
+			schema->_num_fields != tupdesc->natts)
+			elog(ERROR, "arrow_fdw: foreign table '%s' is not compatible to '%s'",
+				 RelationGetRelationName(frel), filename);
+		for (int j=0; j < tupdesc->natts; j++)
+		{
+			Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+
+			if (attr->attisdropped)
+				elog(ERROR, "arrow_fdw: foreign table '%s' has dropped columns",
+					 RelationGetRelationName(frel));
+			__arrowWriteSetupField(table, &table->columns[j],
+								   NameStr(attr->attname),
+								   attr->atttypid,
+								   attr->atttypmod,
+								   &schema->fields[j]);
+		}
+		table->customMetadata = schema->custom_metadata;
+		table->numCustomMetadata = schema->_num_custom_metadata;
+		/* restore the blocks already in the file */
+		table->numDictionaries = af_info.footer._num_dictionaries;
+		table->dictionaries = palloc0(sizeof(ArrowBlock) *
+									  (table->numDictionaries + 1));
+		memcpy(table->dictionaries,
+			   af_info.footer.dictionaries,
+			   sizeof(ArrowBlock) * table->numDictionaries);
+		table->numRecordBatches = af_info.footer._num_recordBatches;
+		table->recordBatches = palloc0(sizeof(ArrowBlock) *
+									   (table->numRecordBatches + 1));
+		memcpy(table->recordBatches,
+			   af_info.footer.recordBatches,
+			   sizeof(ArrowBlock) * table->numRecordBatches);
+		/* new RecordBatches overwrite the current footer */
+		table->f_pos = __arrowWriteFooterOffset(wfile, stat_buf.st_size);
+		wstate->has_footer = true;
+	}
+	else
+	{
+		for (int j=0; j < tupdesc->natts; j++)
+		{
+			Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+
+			if (attr->attisdropped)
+				elog(ERROR, "arrow_fdw: foreign table '%s' has dropped columns",
+					 RelationGetRelationName(frel));
+			__arrowWriteSetupField(table, &table->columns[j],
+								   NameStr(attr->attname),
+								   attr->atttypid,
+								   attr->atttypmod,
+								   NULL);
+		}
+		/* empty file, so write out the header and schema */
+		arrowFileWrite(table, "ARROW1\0\0", 8);
+		writeArrowSchema(table);
+	}
+	MemoryContextSwitchTo(oldcxt);
+
+	wstate->wfile = wfile;
+	wstate->table = table;
+	return wstate;
+}
+
+/*
+ * __arrowWritePutDatum
+ */
+static size_t
+__arrowWritePutDatum(SQLfield *column, Datum datum, bool isnull)
+{
+	SQLtype__pgsql *pgtype = &column->sql_type.pgsql;
+
+	if (isnull)
+		return sql_field_put_value(column, NULL, 0);
+	if (pgtype->typbyval)
+	{
+		switch (pgtype->typlen)
+		{
+			case sizeof(int8_t):
+				{
+					int8_t	ival = DatumGetChar(datum);
+					return sql_field_put_value(column, (char *)&ival,
+											   sizeof(int8_t));
+				}
+			case sizeof(int16_t):
+				{
+					int16_t	ival = DatumGetInt16(datum);
+					return sql_field_put_value(column, (char *)&ival,
+											   sizeof(int16_t));
+				}
+			case sizeof(int32_t):
+				{
+					int32_t	ival = DatumGetInt32(datum);
+					return sql_field_put_value(column, (char *)&ival,
+											   sizeof(int32_t));
+				}
+			case sizeof(int64_t):
+				return sql_field_put_value(column, (char *)&datum,
+										   sizeof(int64_t));
+			default:
+				elog(ERROR, "unexpected typlen (%d) of '%s'",
+					 pgtype->typlen, column->field_name);
+		}
+	}
+	else if (pgtype->typlen > 0)
+	{
+		return sql_field_put_value(column, DatumGetPointer(datum),
+								   pgtype->typlen);
+	}
+	else if (pgtype->typlen == -1)
+	{
+		/* caller already detoasted the datum with 4B header */
+		struct varlena *vl = (struct varlena *)DatumGetPointer(datum);
+
+		return sql_field_put_value(column, VARDATA(vl),
+								   VARSIZE(vl) - VARHDRSZ);
+	}
+	elog(ERROR, "unexpected typlen (%d) of '%s'",
+		 pgtype->typlen, column->field_name);
+}
+
+/*
+ * __arrowWriteOneRow
+ */
+static void
+__arrowWriteOneRow(arrowWriteState *wstate, TupleTableSlot *slot)
+{
+	SQLtable	   *table = wstate->table;
+	MemoryContext	oldcxt;
+	size_t			usage = 0;
+
+	slot_getallattrs(slot);
+	oldcxt = MemoryContextSwitchTo(wstate->tmpcxt);
+	for (int j=0; j < table->nfields; j++)
+	{
+		SQLfield   *column = &table->columns[j];
+
+		if (!slot->tts_isnull[j] && column->sql_type.pgsql.typlen == -1)
+		{
+			struct varlena *vl = PG_DETOAST_DATUM(slot->tts_values[j]);
+
+			wstate->values[j] = PointerGetDatum(vl);
+		}
+		else
+			wstate->values[j] = slot->tts_values[j];
+	}
+	MemoryContextSwitchTo(wstate->memcxt);
+	for (int j=0; j < table->nfields; j++)
+	{
+		usage += __arrowWritePutDatum(&table->columns[j],
+									  wstate->values[j],
+									  slot->tts_isnull[j]);
+	}
+	table->usage = usage;
+	table->nitems++;
+	wstate->nrows++;
+	/* write out the RecordBatch, if buffer exceeds the threshold */
+	if (table->usage >= table->segment_sz)
+	{
+		writeArrowRecordBatch(table, NULL);
+		sql_table_clear(table);
+	}
+	MemoryContextSwitchTo(oldcxt);
+	MemoryContextReset(wstate->tmpcxt);
+}
+
+/*
+ * __arrowEndForeignInsert
+ */
+static void
+__arrowEndForeignInsert(arrowWriteState *wstate)
+{
+	SQLtable	   *table = wstate->table;
+	MemoryContext	oldcxt;
+
+	/* footer is not changed, if no rows were written */
+	if (wstate->nrows > 0 || !wstate->has_footer)
+	{
+		oldcxt = MemoryContextSwitchTo(wstate->memcxt);
+		if (table->nitems > 0)
+		{
+			writeArrowRecordBatch(table, NULL);
+			sql_table_clear(table);
+		}
+		writeArrowFooter(table);
+		if (ftruncate(table->fdesc, table->f_pos) != 0)
+			elog(ERROR, "failed on ftruncate('%s'): %m", table->filename);
+		MemoryContextSwitchTo(oldcxt);
+	}
+	MemoryContextDelete(wstate->tmpcxt);
+	MemoryContextDelete(wstate->memcxt);
+}
+
+/*
+ * __arrowExportBeginWrite
+ *
+ * It creates a new arrow file for pgstrom.arrow_export(); the file must not
+ * exist or be empty. Like INSERT, the file is truncated on abort by the
+ * undo log.
+ */
+static arrowWriteState *
+__arrowExportBeginWrite(const char *filename, TupleDesc tupdesc, EState *estate)
+{
+	arrowWriteState *wstate;
+	arrowWriteFile *wfile;
+	SQLtable	   *table;
+	struct stat		stat_buf;
+	MemoryContext	oldcxt;
+
+	wstate = palloc0(sizeof(arrowWriteState));
+	wstate->memcxt = AllocSetContextCreate(estate->es_query_cxt,
+										   "arrow_export write buffer",
+										   ALLOCSET_DEFAULT_SIZES);
+	wstate->tmpcxt = AllocSetContextCreate(estate->es_query_cxt,
+										   "arrow_export per-row context",
+										   ALLOCSET_SMALL_SIZES);
+	wstate->values = palloc0(sizeof(Datum) * tupdesc->natts);
+
+	wfile = __arrowWriteOpenFile(filename);
+	if (fstat(wfile->fdesc, &stat_buf) != 0)
+		elog(ERROR, "failed on fstat('%s'): %m", filename);
+	if (stat_buf.st_size > 0)
+		elog(ERROR, "arrow_export: file '%s' already exists", filename);
+	__arrowWriteSaveUndoLog(wfile);
+
+	oldcxt = MemoryContextSwitchTo(wstate->memcxt);
+	table = palloc0(offsetof(SQLtable, columns[tupdesc->natts]));
+	table->filename = wfile->filename;
+	table->fdesc = wfile->fdesc;
+	table->segment_sz = (size_t)arrow_record_batch_size_kb << 10;
+	table->nfields = tupdesc->natts;
+	for (int j=0; j < tupdesc->natts; j++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+
+		__arrowWriteSetupField(table, &table->columns[j],
+							   NameStr(attr->attname),
+							   attr->atttypid,
+							   attr->atttypmod,
+							   NULL);
+	}
+	arrowFileWrite(table, "ARROW1\0\0", 8);
+	writeArrowSchema(table);
+	MemoryContextSwitchTo(oldcxt);
+
+	wstate->wfile = wfile;
+	wstate->table = table;
+	return wstate;
+}
+
+/*
+ * __arrowExportColumnVectors
+ *
+ * It encodes the column vectors of the KDS_FORMAT_COLUMN results onto the
+ * RecordBatch buffer, without forming tuples.
+ */
+static void
+__arrowExportColumnVectors(arrowWriteState *wstate,
+						   kern_data_store *kds,
+						   int64_t base, int64_t nitems)
+{
+	SQLtable	   *table = wstate->table;
+	MemoryContext	oldcxt;
+
+	Assert(kds->format == KDS_FORMAT_COLUMN && kds->ncols == table->nfields);
+	oldcxt = MemoryContextSwitchTo(wstate->memcxt);
+	for (int64_t index = base; index < base + nitems; index++)
+	{
+		size_t		usage = 0;
+
+		for (int j=0; j < kds->ncols; j++)
+		{
+			kern_colmeta *cmeta = &kds->colmeta[j];
+			SQLfield   *column = &table->columns[j];
+			bits8	   *nullmap;
+			char	   *addr;
+
+			nullmap = (bits8 *)((char *)kds + __kds_unpack(cmeta->nullmap_offset));
+			if ((nullmap[index>>3] & (1<<(index & 7))) == 0)
+			{
+				usage += sql_field_put_value(column, NULL, 0);
+			}
+			else if (cmeta->attlen < 0)
+			{
+				struct varlena *vl = (struct varlena *)
+					KDS_COLUMN_VARLENA_ADDR(kds, cmeta, index);
+
+				if (VARATT_IS_EXTERNAL(vl) || VARATT_IS_COMPRESSED(vl))
+				{
+					MemoryContextSwitchTo(wstate->tmpcxt);
+					vl = pg_detoast_datum(vl);
+					MemoryContextSwitchTo(wstate->memcxt);
+				}
+				usage += sql_field_put_value(column, VARDATA_ANY(vl),
+											 VARSIZE_ANY_EXHDR(vl));
+			}
+			else
+			{
+				addr = ((char *)kds + __kds_unpack(cmeta->values_offset) +
+						TYPEALIGN(cmeta->attalign, cmeta->attlen) * index);
+				usage += __arrowWritePutDatum(column,
+											  fetch_att(addr,
+														cmeta->attbyval,
+														cmeta->attlen),
+											  false);
+			}
+		}
+		table->usage = usage;
+		table->nitems++;
+		wstate->nrows++;
+		/* write out the RecordBatch, if buffer exceeds the threshold */
+		if (table->usage >= table->segment_sz)
+		{
+			writeArrowRecordBatch(table, NULL);
+			sql_table_clear(table);
+		}
+		MemoryContextReset(wstate->tmpcxt);
+	}
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * pgstrom_arrow_export
+ *
+ * It runs the SELECT query and writes out the results to a new Apache Arrow
+ * file, then returns the number of rows written. If the top plan node is
+ * GpuScan/GpuJoin that returns the results in KDS_FORMAT_COLUMN (columnar
+ * projection), its column vectors are encoded to the RecordBatch as is,
+ * without forming tuples on the backend.
+ */
+PG_FUNCTION_INFO_V1(pgstrom_arrow_export);
+PUBLIC_FUNCTION(Datum)
+pgstrom_arrow_export(PG_FUNCTION_ARGS)
+{
+	char	   *query = text_to_cstring(PG_GETARG_TEXT_PP(0));
+	char	   *filename = text_to_cstring(PG_GETARG_TEXT_PP(1));
+	List	   *raw_list;
+	List	   *qlist;
+	Query	   *qry;
+	PlannedStmt *pstmt;
+	QueryDesc  *qdesc;
+	PlanState  *ps;
+	arrowWriteState *wstate;
+	int64		nrows;
+
+	if (!has_privs_of_role(GetUserId(), ROLE_PG_WRITE_SERVER_FILES))
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("permission denied to write arrow file"),
+				 errhint("Only roles with privileges of the \"%s\" role may export arrow files.",
+						 "pg_write_server_files")));
+	if (!is_absolute_path(filename))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_NAME),
+				 errmsg("relative path not allowed for arrow_export")));
+
+	raw_list = pg_parse_query(query);
+	if (list_length(raw_list) != 1)
+		elog(ERROR, "arrow_export: only a single query is allowed");
+	qlist = pg_analyze_and_rewrite_fixedparams(linitial(raw_list), query,
+											   NULL, 0, NULL);
+	if (list_length(qlist) != 1 ||
+		(qry = linitial(qlist))->commandType != CMD_SELECT ||
+		qry->utilityStmt != NULL ||
+		qry->rowMarks != NIL)
+		elog(ERROR, "arrow_export: only SELECT is allowed");
+	pstmt = pg_plan_query(qry, query, CURSOR_OPT_PARALLEL_OK, NULL);
+
+	qdesc = CreateQueryDesc(pstmt, query,
+							GetActiveSnapshot(),
+							InvalidSnapshot,
+							None_Receiver,
+							NULL, NULL, 0);
+	ExecutorStart(qdesc, 0);
+	wstate = __arrowExportBeginWrite(filename, qdesc->tupDesc, qdesc->estate);
+
+	ps = qdesc->planstate;
+	if (pstmt->parallelModeNeeded)
+		EnterParallelMode();
+	for (;;)
+	{
+		kern_data_store *kds;
+		TupleTableSlot *slot;
+		int64_t		index;
+		int64_t		nitems;
+
+		CHECK_FOR_INTERRUPTS();
+		kds = pgstromExecTaskNextBatch(ps, &index, &nitems);
+		if (kds)
+		{
+			__arrowExportColumnVectors(wstate, kds, index, nitems);
+			continue;
+		}
+		slot = ExecProcNode(ps);
+		if (TupIsNull(slot))
+			break;
+		__arrowWriteOneRow(wstate, slot);
+	}
+	ExecShutdownNode(ps);
+	if (pstmt->parallelModeNeeded)
+		ExitParallelMode();
+	nrows = wstate->nrows;
+	__arrowEndForeignInsert(wstate);
+
+	ExecutorFinish(qdesc);
+	ExecutorEnd(qdesc);
+	FreeQueryDesc(qdesc);
+
+	PG_RETURN_INT64(nrows);
+}
+
+/*
+ * ArrowIsForeignRelUpdatable
+ */
+static int
+ArrowIsForeignRelUpdatable(Relation frel)
+{
+	ForeignTable   *ft = GetForeignTable(RelationGetRelid(frel));
+
+	if (arrowFdwOptionIsWritable(ft->options))
+		return (1 << CMD_INSERT);
+	return 0;
+}
+
+/*
+ * ArrowPlanForeignModify
+ */
+static List *
+ArrowPlanForeignModify(PlannerInfo *root,
+					   ModifyTable *plan,
+					   Index resultRelation,
+					   int subplan_index)
+{
+	if (plan->operation != CMD_INSERT)
+		elog(ERROR, "arrow_fdw: only INSERT is supported");
+	if (plan->onConflictAction != ONCONFLICT_NONE)
+		elog(ERROR, "arrow_fdw: INSERT with ON CONFLICT clause is not supported");
+	return NIL;
+}
+
+/*
+ * ArrowBeginForeignModify
+ */
+static void
+ArrowBeginForeignModify(ModifyTableState *mtstate,
+						ResultRelInfo *rrinfo,
+						List *fdw_private,
+						int subplan_index,
+						int eflags)
+{
+	if ((eflags & EXEC_FLAG_EXPLAIN_ONLY) != 0)
+		return;
+	rrinfo->ri_FdwState = __arrowBeginForeignInsert(rrinfo->ri_RelationDesc,
+													mtstate->ps.state);
+}
+
+/*
+ * ArrowExecForeignInsert
+ */
+static TupleTableSlot *
+ArrowExecForeignInsert(EState *estate,
+					   ResultRelInfo *rrinfo,
+					   TupleTableSlot *slot,
+					   TupleTableSlot *planSlot)
+{
+	__arrowWriteOneRow(rrinfo->ri_FdwState, slot);
+	return slot;
+}
+
+/*
+ * ArrowExecForeignBatchInsert
+ */
+static TupleTableSlot **
+ArrowExecForeignBatchInsert(EState *estate,
+							ResultRelInfo *rrinfo,
+							TupleTableSlot **slots,
+							TupleTableSlot **planSlots,
+							int *numSlots)
+{
+	for (int i=0; i < *numSlots; i++)
+		__arrowWriteOneRow(rrinfo->ri_FdwState, slots[i]);
+	return slots;
+}
+
+/*
+ * ArrowGetForeignModifyBatchSize
+ */
+static int
+ArrowGetForeignModifyBatchSize(ResultRelInfo *rrinfo)
+{
+	/* RETURNING, row triggers and WCO need rows one by one */
+	if (rrinfo->ri_projectReturning != NULL ||
+		rrinfo->ri_WithCheckOptions != NIL ||
+		(rrinfo->ri_TrigDesc &&
+		 (rrinfo->ri_TrigDesc->trig_insert_before_row ||
+		  rrinfo->ri_TrigDesc->trig_insert_after_row)))
+		return 1;
+	return ARROW_FDW_INSERT_BATCH_SIZE;
+}
+
+/*
+ * ArrowEndForeignModify
+ */
+static void
+ArrowEndForeignModify(EState *estate, ResultRelInfo *rrinfo)
+{
+	if (rrinfo->ri_FdwState)
+		__arrowEndForeignInsert(rrinfo->ri_FdwState);
+}
+
+/*
+ * ArrowBeginForeignInsert
+ */
+static void
+ArrowBeginForeignInsert(ModifyTableState *mtstate,
+						ResultRelInfo *rrinfo)
+{
+	rrinfo->ri_FdwState = __arrowBeginForeignInsert(rrinfo->ri_RelationDesc,
+													mtstate->ps.state);
+}
+
+/*
+ * ArrowEndForeignInsert
+ */
+static void
+ArrowEndForeignInsert(EState *estate, ResultRelInfo *rrinfo)
+{
+	if (rrinfo->ri_FdwState)
+		__arrowEndForeignInsert(rrinfo->ri_FdwState);
+}
+
+/*
+ * arrowFdwXactCallback
+ */
+static void
+arrowFdwXactCallback(XactEvent event, void *arg)
+{
+	dlist_mutable_iter iter;
+
+	if (dlist_is_empty(&arrow_write_files_list))
+		return;
+	if (event == XACT_EVENT_PRE_PREPARE)
+		elog(ERROR, "arrow_fdw: cannot PREPARE a transaction that has written arrow files");
+	if (event == XACT_EVENT_PRE_COMMIT)
+	{
+		dlist_foreach_modify(iter, &arrow_write_files_list)
+		{
+			arrowWriteFile *wfile = dlist_container(arrowWriteFile,
+													 chain, iter.cur);
+			if (pg_fsync(wfile->fdesc) != 0)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not fsync file \"%s\": %m",
+								wfile->filename)));
+		}
+		return;
+	}
+	if (event != XACT_EVENT_COMMIT && event != XACT_EVENT_ABORT)
+		return;
+
+	dlist_foreach_modify(iter, &arrow_write_files_list)
+	{
+		arrowWriteFile *wfile = dlist_container(arrowWriteFile,
+												 chain, iter.cur);
+		/* revert to the state at the beginning of the transaction */
+		if (event == XACT_EVENT_ABORT && wfile->undo_logs != NIL)
+			__arrowWriteApplyUndoLog(wfile, llast(wfile->undo_logs));
+		dlist_delete(&wfile->chain);
+		close(wfile->fdesc);	/* also releases flock */
+		list_free_deep(wfile->undo_logs);
+		pfree(wfile->filename);
+		pfree(wfile);
+	}
+}
+
+/*
+ * arrowFdwSubXactCallback
+ */
+static void
+arrowFdwSubXactCallback(SubXactEvent event,
+						SubTransactionId mySubid,
+						SubTransactionId parentSubid,
+						void *arg)
+{
+	dlist_iter	iter;
+
+	if (event != SUBXACT_EVENT_COMMIT_SUB &&
+		event != SUBXACT_EVENT_ABORT_SUB)
+		return;
+	dlist_foreach(iter, &arrow_write_files_list)
+	{
+		arrowWriteFile *wfile = dlist_container(arrowWriteFile,
+												 chain, iter.cur);
+		arrowWriteUndoLog *undo = NULL;
+		ListCell   *lc;
+
+		if (event == SUBXACT_EVENT_COMMIT_SUB)
+		{
+			/* undo logs are inherited to the parent */
+			foreach (lc, wfile->undo_logs)
+			{
+				undo = lfirst(lc);
+				if (undo->subid == mySubid)
+					undo->subid = parentSubid;
+			}
+			continue;
+		}
+		/* undo logs of the sub-transaction are at the head, newer first */
+		while (wfile->undo_logs != NIL &&
+			   ((arrowWriteUndoLog *)linitial(wfile->undo_logs))->subid == mySubid)
+		{
+			if (undo)
+				pfree(undo);
+			undo = linitial(wfile->undo_logs);
+			wfile->undo_logs = list_delete_first(wfile->undo_logs);
+		}
+		if (undo)
+		{
+			__arrowWriteApplyUndoLog(wfile, undo);
+			pfree(undo);
+		}
+	}
+}
+
 /*
  * handler of Arrow_Fdw
  */
@@ -4477,13 +7758,20 @@ pgstrom_arrow_fdw_validator(PG_FUNCTION_ARGS)
 	if (catalog == ForeignTableRelationId)
 	{
 		List	   *filesList = arrowFdwExtractFilesList(options, NULL);
+		bool		writable = arrowFdwOptionIsWritable(options);
 		ListCell   *lc;
 
 		foreach (lc, filesList)
 		{
 			const char *fname = strVal(lfirst(lc));
 			ArrowFileInfo af_info;
+			struct stat	stat_buf;
 
+			/* empty file shall be initialized on the first INSERT */
+			if (writable &&
+				stat(fname, &stat_buf) == 0 &&
+				stat_buf.st_size == 0)
+				continue;
 			readArrowFile(fname, &af_info, true);
 		}
 	}
@@ -4582,6 +7870,111 @@ pgstrom_arrow_fdw_precheck_schema(PG_FUNCTION_ARGS)
 	PG_RETURN_NULL();
 }
 
+/*
+ * pgstrom_arrow_fdw_metadata_cache_info
+ */
+PG_FUNCTION_INFO_V1(pgstrom_arrow_fdw_metadata_cache_info);
+PUBLIC_FUNCTION(Datum)
+pgstrom_arrow_fdw_metadata_cache_info(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[7];
+	bool		isnull[7];
+	HeapTuple	tuple;
+	dlist_iter	iter;
+	uint32_t	num_files;
+	uint32_t	num_free_blocks = 0;
+
+	tupdesc = CreateTemplateTupleDesc(7);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "cache_hits",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 2, "cache_misses",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 3, "cache_evictions",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 4, "cache_failures",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 5, "num_files",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 6, "total_size",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 7, "used_size",
+					   INT8OID, -1, 0);
+	tupdesc = BlessTupleDesc(tupdesc);
+
+	LWLockAcquire(&arrow_metadata_cache->mutex, LW_SHARED);
+	SpinLockAcquire(&arrow_metadata_cache->lru_lock);
+	num_files = arrow_metadata_cache->num_files;
+	SpinLockRelease(&arrow_metadata_cache->lru_lock);
+	dlist_foreach(iter, &arrow_metadata_cache->free_blocks)
+		num_free_blocks++;
+	LWLockRelease(&arrow_metadata_cache->mutex);
+
+	memset(isnull, 0, sizeof(isnull));
+	values[0] = Int64GetDatum(pg_atomic_read_u64(&arrow_metadata_cache->cache_hits));
+	values[1] = Int64GetDatum(pg_atomic_read_u64(&arrow_metadata_cache->cache_misses));
+	values[2] = Int64GetDatum(pg_atomic_read_u64(&arrow_metadata_cache->cache_evictions));
+	values[3] = Int64GetDatum(pg_atomic_read_u64(&arrow_metadata_cache->cache_failures));
+	values[4] = Int64GetDatum(num_files);
+	values[5] = Int64GetDatum((int64)arrow_metadata_cache->num_blocks *
+							  ARROW_METADATA_BLOCKSZ);
+	values[6] = Int64GetDatum((int64)(arrow_metadata_cache->num_blocks -
+									  num_free_blocks) * ARROW_METADATA_BLOCKSZ);
+	tuple = heap_form_tuple(tupdesc, values, isnull);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(tuple));
+}
+
+/*
+ * pgstrom_arrow_fdw_prewarm_metadata
+ *
+ * It loads the metadata of the files of the foreign table onto the shared
+ * metadata cache, prior to the query (and its parallel workers).
+ */
+PG_FUNCTION_INFO_V1(pgstrom_arrow_fdw_prewarm_metadata);
+PUBLIC_FUNCTION(Datum)
+pgstrom_arrow_fdw_prewarm_metadata(PG_FUNCTION_ARGS)
+{
+	Oid			frelid = PG_GETARG_OID(0);
+	Relation	frel;
+	ForeignTable *ft;
+	List	   *filesList;
+	ListCell   *lc;
+	int32		nfiles = 0;
+
+	frel = table_open(frelid, AccessShareLock);
+	if (!RelationIsArrowFdw(frel))
+		elog(ERROR, "relation '%s' is not a foreign table with arrow_fdw",
+			 RelationGetRelationName(frel));
+	ft = GetForeignTable(frelid);
+	filesList = arrowFdwExtractFilesList(ft->options, NULL);
+	foreach (lc, filesList)
+	{
+		const char *fname = strVal(lfirst(lc));
+
+		if (BuildArrowFileState(frel, fname, NULL) != NULL)
+			nfiles++;
+		CHECK_FOR_INTERRUPTS();
+	}
+	table_close(frel, AccessShareLock);
+
+	PG_RETURN_INT32(nfiles);
+}
+
+/*
+ * __arrowMetadataHashNSlots
+ *
+ * Number of hash slots grows according to the cache size; roughly, one slot
+ * per 8kB of the metadata cache.
+ */
+static uint32_t
+__arrowMetadataHashNSlots(void)
+{
+	size_t	nslots = ((size_t)arrow_metadata_cache_size_kb >> 3);
+
+	return Max(nslots, ARROW_METADATA_HASH_NSLOTS);
+}
+
 /*
  * pgstrom_request_arrow_fdw
  */
@@ -4594,7 +7987,8 @@ pgstrom_request_arrow_fdw(void)
 		shmem_request_next();
 	sz = TYPEALIGN(ARROW_METADATA_BLOCKSZ,
 				   (size_t)arrow_metadata_cache_size_kb << 10);
-	RequestAddinShmemSpace(MAXALIGN(sizeof(arrowMetadataCacheHead)) + sz);
+	RequestAddinShmemSpace(MAXALIGN(offsetof(arrowMetadataCacheHead,
+											 hash_slots[__arrowMetadataHashNSlots()])) + sz);
 }
 
 /*
@@ -4606,29 +8000,39 @@ pgstrom_startup_arrow_fdw(void)
 	bool	found;
 	size_t	sz;
 	char   *buffer;
+	uint32_t nslots;
 	int		i, n;
 
 	if (shmem_startup_next)
 		(*shmem_startup_next)();
 
+	nslots = __arrowMetadataHashNSlots();
 	arrow_metadata_cache = ShmemInitStruct("arrowMetadataCache(head)",
-										   MAXALIGN(sizeof(arrowMetadataCacheHead)),
+										   MAXALIGN(offsetof(arrowMetadataCacheHead,
+															 hash_slots[nslots])),
 										   &found);
 	Assert(!found);
 	
 	LWLockInitialize(&arrow_metadata_cache->mutex, LWLockNewTrancheId());
 	SpinLockInit(&arrow_metadata_cache->lru_lock);
 	dlist_init(&arrow_metadata_cache->lru_list);
+	arrow_metadata_cache->num_files = 0;
 	dlist_init(&arrow_metadata_cache->free_blocks);
 	dlist_init(&arrow_metadata_cache->free_mcaches);
 	dlist_init(&arrow_metadata_cache->free_fcaches);
-	for (i=0; i < ARROW_METADATA_HASH_NSLOTS; i++)
+	pg_atomic_init_u64(&arrow_metadata_cache->cache_hits, 0);
+	pg_atomic_init_u64(&arrow_metadata_cache->cache_misses, 0);
+	pg_atomic_init_u64(&arrow_metadata_cache->cache_evictions, 0);
+	pg_atomic_init_u64(&arrow_metadata_cache->cache_failures, 0);
+	arrow_metadata_cache->nslots = nslots;
+	for (i=0; i < nslots; i++)
 		dlist_init(&arrow_metadata_cache->hash_slots[i]);
 
 	/* slab allocator */
 	sz = TYPEALIGN(ARROW_METADATA_BLOCKSZ,
 				   (size_t)arrow_metadata_cache_size_kb << 10);
 	n = sz / ARROW_METADATA_BLOCKSZ;
+	arrow_metadata_cache->num_blocks = n;
 	buffer = ShmemInitStruct("arrowMetadataCache(body)", sz, &found);
 	Assert(!found);
 	for (i=0; i < n; i++)
@@ -4673,6 +8077,16 @@ pgstrom_init_arrow_fdw(void)
 	r->ShutdownForeignScan			= ArrowShutdownForeignScan;
 	/* IMPORT FOREIGN SCHEMA support */
 	r->ImportForeignSchema			= ArrowImportForeignSchema;
+	/* INSERT support */
+	r->IsForeignRelUpdatable		= ArrowIsForeignRelUpdatable;
+	r->PlanForeignModify			= ArrowPlanForeignModify;
+	r->BeginForeignModify			= ArrowBeginForeignModify;
+	r->ExecForeignInsert			= ArrowExecForeignInsert;
+	r->ExecForeignBatchInsert		= ArrowExecForeignBatchInsert;
+	r->GetForeignModifyBatchSize	= ArrowGetForeignModifyBatchSize;
+	r->EndForeignModify				= ArrowEndForeignModify;
+	r->BeginForeignInsert			= ArrowBeginForeignInsert;
+	r->EndForeignInsert				= ArrowEndForeignInsert;
 
 	/*
 	 * Turn on/off arrow_fdw
@@ -4696,6 +8110,28 @@ pgstrom_init_arrow_fdw(void)
 							 PGC_USERSET,
                              GUC_NOT_IN_SAMPLE,
                              NULL, NULL, NULL);
+	/*
+	 * Turn on/off late materialization
+	 */
+	DefineCustomBoolVariable("arrow_fdw.late_materialization",
+							 "Enables late materialization of non-qualifier columns",
+							 NULL,
+							 &arrow_fdw_late_materialization,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/*
+	 * Turn on/off vectorized filter on the CPU
+	 */
+	DefineCustomBoolVariable("arrow_fdw.vectorized_filter",
+							 "Enables vectorized evaluation of simple comparisons on record-batches",
+							 NULL,
+							 &arrow_fdw_vectorized_filter,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	/*
 	 * Configurations for arrow_fdw metadata cache
 	 */
@@ -4709,6 +8145,22 @@ pgstrom_init_arrow_fdw(void)
 							PGC_POSTMASTER,
 							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
 							NULL, NULL, NULL);
+	/*
+	 * Threshold of the RecordBatch size on INSERT
+	 */
+	DefineCustomIntVariable("arrow_fdw.record_batch_size",
+							"Threshold of the RecordBatch size written by INSERT",
+							NULL,
+							&arrow_record_batch_size_kb,
+							256 * 1024,		/* 256MB */
+							1024,			/* 1MB */
+							1024 * 1024,	/* 1GB */
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
+	/* transaction callbacks for INSERT */
+	RegisterXactCallback(arrowFdwXactCallback, NULL);
+	RegisterSubXactCallback(arrowFdwSubXactCallback, NULL);
 	/* shared memory size */
 	shmem_request_next = shmem_request_hook;
 	shmem_request_hook = pgstrom_request_arrow_fdw;
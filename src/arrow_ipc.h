@@ -69,6 +69,8 @@ typedef struct SQLtable			SQLtable;
 typedef struct SQLfield			SQLfield;
 typedef struct SQLdictionary	SQLdictionary;
 typedef struct SQLstat			SQLstat;
+typedef struct SQLzoneStat		SQLzoneStat;
+typedef struct SQLbloom			SQLbloom;
 typedef union  SQLstat__datum	SQLstat__datum;
 typedef union  SQLtype			SQLtype;
 typedef struct SQLtype__pgsql	SQLtype__pgsql;
@@ -136,6 +138,62 @@ struct SQLstat
 	SQLstat__datum	max;
 };
 
+/*
+ * Zone-map statistics; min/max values for each ARROW_ZONE_NROWS rows
+ * inside of a record-batch, to skip a part of the record-batch.
+ */
+#define ARROW_ZONE_NROWS		65536
+
+struct SQLzoneStat
+{
+	SQLzoneStat	   *next;
+	int				rb_index;	/* record-batch index */
+	int				nzones;		/* number of zones in the record-batch */
+	SQLstat		   *zones;		/* array of SQLstat for each zone */
+};
+
+/*
+ * Bloom filter per record-batch, for equality lookup of the values.
+ * The hash value of the raw (on-Arrow) bytes picks up ARROW_BLOOM_NHASHES
+ * bits using double hashing; nbits is always power of 2.
+ */
+#define ARROW_BLOOM_NHASHES			4
+#define ARROW_BLOOM_BITS_PER_ITEM	8
+#define ARROW_BLOOM_MIN_NBITS		(1U << 10)
+#define ARROW_BLOOM_MAX_NBITS		(1U << 23)
+
+struct SQLbloom
+{
+	SQLbloom	   *next;
+	int				rb_index;	/* record-batch index */
+	uint32_t		nbits;		/* width of the bitmap */
+	uint64_t	   *bitmap;
+};
+
+static inline uint64_t
+arrowBloomHash(const void *addr, size_t len)
+{
+	const unsigned char *pos = (const unsigned char *)addr;
+	uint64_t	hash = 14695981039346656037UL;	/* FNV-1a */
+
+	for (size_t i=0; i < len; i++)
+	{
+		hash ^= pos[i];
+		hash *= 1099511628211UL;
+	}
+	/* final mix (murmur3) */
+	hash ^= (hash >> 33);
+	hash *= 0xff51afd7ed558ccdUL;
+	hash ^= (hash >> 33);
+	hash *= 0xc4ceb9fe1a85ec53UL;
+	hash ^= (hash >> 33);
+	return hash;
+}
+
+#define arrowBloomBitIndex(HASH,K,NBITS)							\
+	(((uint32_t)(HASH) + (K) * ((uint32_t)((HASH) >> 32) | 1U)) &	\
+	 ((NBITS) - 1))
+
 struct SQLfield
 {
 	char	   *field_name;		/* name of the column, element or sub-field */
@@ -162,6 +220,10 @@ struct SQLfield
 	bool		stat_enabled;
 	SQLstat		stat_datum;
 	SQLstat	   *stat_list;
+	SQLzoneStat *zone_list;		/* zone-map statistics, if any */
+	/* bloom filter (optional) */
+	bool		bloom_enabled;
+	SQLbloom   *bloom_list;
 	/* custom metadata(optional) */
 	ArrowKeyValue *customMetadata;
 	int			numCustomMetadata;
@@ -206,6 +268,12 @@ struct SQLtable
 	size_t		nitems;			/* number of items */
 	int			nfields;		/* number of attributes */
 	bool		has_statistics;	/* one or more columns enable min/max statistics */
+	/* body compression of the record batches, if any */
+	bool		compressed;
+	ArrowCompressionType compress_codec;
+	int			compress_level;
+	int			compress_nworkers;
+	SQLbuffer  *__cbufs;		/* for internal use of body compression */
 	SQLfield columns[FLEXIBLE_ARRAY_MEMBER];
 };
 
@@ -251,6 +319,12 @@ extern int		writeArrowRecordBatchMT(SQLtable *main_table,
 extern void		writeArrowFooter(SQLtable *table);
 
 extern size_t	setupArrowRecordBatchIOV(SQLtable *table);
+extern void		setupArrowBodyCompression(SQLtable *table,
+										  const char *compress_spec,
+										  int nworkers);
+extern void		saveArrowRecordBatchBloom(SQLfield *main_field,
+										  SQLfield *data_field,
+										  int rb_index);
 
 /* arrow_nodes.c */
 extern void		__initArrowNode(ArrowNode *node, ArrowNodeTag tag);
@@ -259,9 +333,15 @@ extern void		__initArrowNode(ArrowNode *node, ArrowNodeTag tag);
 extern char	   *dumpArrowNode(ArrowNode *node);
 extern void		copyArrowNode(ArrowNode *dest, const ArrowNode *src);
 extern void		readArrowFileDesc(int fdesc, ArrowFileInfo *af_info);
+extern void		readArrowStreamFileDesc(int fdesc, ArrowFileInfo *af_info,
+										size_t resume_offset);
 extern bool		arrowFieldTypeIsEqual(ArrowField *a, ArrowField *b);
 extern const char *arrowNodeName(ArrowNode *node);
 
+/* parquet_nodes.c */
+extern bool		isParquetFileDesc(int fdesc);
+extern void		readParquetFileDesc(int fdesc, ArrowFileInfo *af_info);
+
 /* arrow_pgsql.c */
 extern int		assignArrowTypePgSQL(SQLfield *column,
 									 const char *field_name,
@@ -1034,9 +1034,17 @@ __arrowFieldTypeIsEqual(ArrowField *a, ArrowField *b, int depth)
 			break;
 		case ArrowNodeTag__Utf8:
 		case ArrowNodeTag__Binary:
+		case ArrowNodeTag__LargeUtf8:
+		case ArrowNodeTag__LargeBinary:
 		case ArrowNodeTag__Bool:
 			break;
 
+		case ArrowNodeTag__FixedSizeBinary:
+			if (a->type.FixedSizeBinary.byteWidth !=
+				b->type.FixedSizeBinary.byteWidth)
+				return false;
+			break;
+
 		case ArrowNodeTag__Decimal:
 			if (a->type.Decimal.precision != b->type.Decimal.precision ||
 				a->type.Decimal.scale     != b->type.Decimal.scale ||
@@ -1056,9 +1064,15 @@ __arrowFieldTypeIsEqual(ArrowField *a, ArrowField *b, int depth)
 			break;
 
 		case ArrowNodeTag__Timestamp:
-			if (a->type.Timestamp.unit != b->type.Timestamp.unit ||
-				a->type.Timestamp.timezone != NULL ||
-				b->type.Timestamp.timezone != NULL)
+			if (a->type.Timestamp.unit != b->type.Timestamp.unit)
+				return false;
+			if (a->type.Timestamp.timezone && b->type.Timestamp.timezone)
+			{
+				if (strcmp(a->type.Timestamp.timezone,
+						   b->type.Timestamp.timezone) != 0)
+					return false;
+			}
+			else if (a->type.Timestamp.timezone || b->type.Timestamp.timezone)
 				return false;
 			break;
 
@@ -1068,8 +1082,6 @@ __arrowFieldTypeIsEqual(ArrowField *a, ArrowField *b, int depth)
 			break;
 
 		case ArrowNodeTag__Struct:
-			if (depth > 0)
-				Elog("arrow: nested composite types are not supported");
 			if (a->_num_children != b->_num_children)
 				return false;
 			for (j=0; j < a->_num_children; j++)
@@ -1082,8 +1094,8 @@ __arrowFieldTypeIsEqual(ArrowField *a, ArrowField *b, int depth)
 			break;
 
 		case ArrowNodeTag__List:
-			if (depth > 0)
-				Elog("arrow_fdw: nested array types are not supported");
+		case ArrowNodeTag__LargeList:
+		case ArrowNodeTag__Map:
 			if (a->_num_children != 1 || b->_num_children != 1)
 				Elog("Bug? List of arrow type is corrupted.");
 			if (!__arrowFieldTypeIsEqual(&a->children[0],
@@ -1169,6 +1181,7 @@ __initArrowNode(ArrowNode *node, ArrowNodeTag tag)
 		CASE_ARROW_NODE(Field);
 		CASE_ARROW_NODE(FieldNode);
 		CASE_ARROW_NODE(Buffer);
+		CASE_ARROW_NODE(BodyCompression);
 		CASE_ARROW_NODE(Schema);
 		CASE_ARROW_NODE(RecordBatch);
 		CASE_ARROW_NODE(DictionaryBatch);
@@ -1959,6 +1972,206 @@ readArrowFooter(ArrowFooter *node, const char *pos)
 	}
 #endif
 
+/*
+ * __arrowFileIsStream
+ *
+ * It checks whether the file is Arrow IPC stream format, or Arrow file
+ * that is still being written (thus, no footer yet).
+ */
+static bool
+__arrowFileIsStream(const char *mmap_head, size_t file_sz)
+{
+	if (file_sz >= ARROW_FILE_HEAD_SIGNATURE_SZ &&
+		memcmp(mmap_head,
+			   ARROW_FILE_HEAD_SIGNATURE,
+			   ARROW_FILE_HEAD_SIGNATURE_SZ) == 0)
+	{
+		/* the file has no tail signature yet */
+		return (file_sz < (ARROW_FILE_HEAD_SIGNATURE_SZ +
+						   ARROW_FILE_TAIL_SIGNATURE_SZ) ||
+				memcmp(mmap_head + file_sz - ARROW_FILE_TAIL_SIGNATURE_SZ,
+					   ARROW_FILE_TAIL_SIGNATURE,
+					   ARROW_FILE_TAIL_SIGNATURE_SZ) != 0);
+	}
+	/* IPC stream begins with the continuation token */
+	return (file_sz >= 2 * sizeof(int32_t) &&
+			*((const uint32_t *)mmap_head) == 0xffffffffU);
+}
+
+/*
+ * __readArrowStreamMessage
+ *
+ * It reads one encapsulated message at the @offset, then returns the offset
+ * of the next message, or 0 if end-of-stream or incomplete message.
+ */
+static size_t
+__readArrowStreamMessage(const char *mmap_head, size_t file_sz,
+						 size_t offset, ArrowMessage *m, ArrowBlock *b)
+{
+	const int32_t  *ival = (const int32_t *)(mmap_head + offset);
+	int32_t			metaLength;
+	int32_t			prefixLength;
+	const int32_t  *headOffset;
+
+	if (offset + 2 * sizeof(int32_t) > file_sz)
+		return 0;
+	if (*ival == (int32_t)0xffffffff)
+	{
+		metaLength = ival[1];
+		prefixLength = 2 * sizeof(int32_t);
+	}
+	else
+	{
+		/* Older format prior to Arrow v0.15 */
+		metaLength = ival[0];
+		prefixLength = sizeof(int32_t);
+	}
+	if (metaLength <= 0 ||
+		offset + prefixLength + metaLength > file_sz)
+		return 0;		/* end-of-stream, or incomplete */
+	headOffset = (const int32_t *)(mmap_head + offset + prefixLength);
+	readArrowMessage(m, (const char *)headOffset + *headOffset);
+	if (offset + prefixLength + metaLength + m->bodyLength > file_sz)
+		return 0;		/* body is not written yet */
+
+	memset(b, 0, sizeof(ArrowBlock));
+	INIT_ARROW_NODE(b, Block);
+	b->offset         = offset;
+	b->metaDataLength = prefixLength + metaLength;
+	b->bodyLength     = m->bodyLength;
+
+	return offset + prefixLength + metaLength + m->bodyLength;
+}
+
+/*
+ * readArrowStreamFileDesc
+ *
+ * It reads Arrow IPC stream, or Arrow file without footer, then builds
+ * the virtual footer from the messages. If @resume_offset is positive,
+ * it skips the messages prior to the offset, except for the schema.
+ * The @stream_length of ArrowFileInfo is the end of the last complete
+ * message, to be resumed on the next call.
+ */
+void
+readArrowStreamFileDesc(int fdesc, ArrowFileInfo *af_info,
+						size_t resume_offset)
+{
+	static long		__PAGE_SIZE = 0;
+	size_t			file_sz;
+	size_t			mmap_sz;
+	char		   *mmap_head = NULL;
+
+	memset(af_info, 0, sizeof(ArrowFileInfo));
+	if (fstat(fdesc, &af_info->stat_buf) != 0)
+		Elog("failed on fstat: %m");
+	file_sz = af_info->stat_buf.st_size;
+	if (file_sz == 0)
+		Elog("Apache Arrow stream is empty");
+	if (__PAGE_SIZE == 0)
+		__PAGE_SIZE = sysconf(_SC_PAGESIZE);
+	mmap_sz = ((file_sz + __PAGE_SIZE - 1) & ~(__PAGE_SIZE - 1));
+	mmap_head = mmap(NULL, mmap_sz, PROT_READ, MAP_SHARED, fdesc, 0);
+	if (mmap_head == MAP_FAILED)
+		Elog("failed on mmap: %m");
+
+	PG_TRY();
+	{
+		ArrowMessage	message;
+		ArrowBlock		block;
+		size_t			offset = 0;
+		size_t			next;
+		int				nrooms_rbatches = 0;
+		int				nrooms_dicts = 0;
+
+		if (file_sz >= ARROW_FILE_HEAD_SIGNATURE_SZ &&
+			memcmp(mmap_head,
+				   ARROW_FILE_HEAD_SIGNATURE,
+				   ARROW_FILE_HEAD_SIGNATURE_SZ) == 0)
+			offset = ARROW_FILE_HEAD_SIGNATURE_SZ;
+		/* the first message must be Schema */
+		next = __readArrowStreamMessage(mmap_head, file_sz, offset,
+										&message, &block);
+		if (next == 0 || message.body.node.tag != ArrowNodeTag__Schema)
+			Elog("Apache Arrow stream has no Schema message");
+		af_info->footer.version = message.version;
+		memcpy(&af_info->footer.schema,
+			   &message.body.schema, sizeof(ArrowSchema));
+		offset = (resume_offset > next ? resume_offset : next);
+		af_info->stream_length = offset;
+		/* DictionaryBatch and RecordBatch */
+		while ((next = __readArrowStreamMessage(mmap_head, file_sz, offset,
+												&message, &block)) != 0)
+		{
+			if (message.body.node.tag == ArrowNodeTag__RecordBatch)
+			{
+				ArrowFooter *footer = &af_info->footer;
+				int		k = footer->_num_recordBatches++;
+
+				if (k >= nrooms_rbatches)
+				{
+					nrooms_rbatches = 2 * nrooms_rbatches + 20;
+					if (!footer->recordBatches)
+					{
+						footer->recordBatches =
+							palloc(sizeof(ArrowBlock) * nrooms_rbatches);
+						af_info->recordBatches =
+							palloc(sizeof(ArrowMessage) * nrooms_rbatches);
+					}
+					else
+					{
+						footer->recordBatches =
+							repalloc(footer->recordBatches,
+									 sizeof(ArrowBlock) * nrooms_rbatches);
+						af_info->recordBatches =
+							repalloc(af_info->recordBatches,
+									 sizeof(ArrowMessage) * nrooms_rbatches);
+					}
+				}
+				memcpy(&footer->recordBatches[k], &block, sizeof(ArrowBlock));
+				memcpy(&af_info->recordBatches[k], &message, sizeof(ArrowMessage));
+			}
+			else if (message.body.node.tag == ArrowNodeTag__DictionaryBatch)
+			{
+				ArrowFooter *footer = &af_info->footer;
+				int		k = footer->_num_dictionaries++;
+
+				if (k >= nrooms_dicts)
+				{
+					nrooms_dicts = 2 * nrooms_dicts + 4;
+					if (!footer->dictionaries)
+					{
+						footer->dictionaries =
+							palloc(sizeof(ArrowBlock) * nrooms_dicts);
+						af_info->dictionaries =
+							palloc(sizeof(ArrowMessage) * nrooms_dicts);
+					}
+					else
+					{
+						footer->dictionaries =
+							repalloc(footer->dictionaries,
+									 sizeof(ArrowBlock) * nrooms_dicts);
+						af_info->dictionaries =
+							repalloc(af_info->dictionaries,
+									 sizeof(ArrowMessage) * nrooms_dicts);
+					}
+				}
+				memcpy(&footer->dictionaries[k], &block, sizeof(ArrowBlock));
+				memcpy(&af_info->dictionaries[k], &message, sizeof(ArrowMessage));
+			}
+			else
+				Elog("Apache Arrow stream has unexpected message (%s)",
+					 message.body.node.tagName);
+			offset = next;
+			af_info->stream_length = offset;
+		}
+	}
+	PG_FINALLY();
+	{
+		munmap(mmap_head, mmap_sz);
+	}
+	PG_END_TRY();
+}
+
 void
 readArrowFileDesc(int fdesc, ArrowFileInfo *af_info)
 {
@@ -1983,6 +2196,14 @@ readArrowFileDesc(int fdesc, ArrowFileInfo *af_info)
 		Elog("failed on mmap: %m");
 	mmap_tail = mmap_head + file_sz - ARROW_FILE_TAIL_SIGNATURE_SZ;
 
+	/* IPC stream, or Arrow file still being written? */
+	if (__arrowFileIsStream(mmap_head, file_sz))
+	{
+		munmap(mmap_head, mmap_sz);
+		readArrowStreamFileDesc(fdesc, af_info, 0);
+		return;
+	}
+
 	/* check signature */
 	PG_TRY();
 	{
@@ -15,6 +15,12 @@
 #include <limits.h>
 #include <pthread.h>
 #include "arrow_ipc.h"
+#ifdef HAVE_LIBLZ4
+#include <lz4frame.h>
+#endif
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
 
 /* alignment macros, if not */
 #ifndef SHORTALIGN
@@ -1287,12 +1293,202 @@ __setupArrowFieldStat(ArrowKeyValue *customMetadata,
 	}
 }
 
+/*
+ * __setupArrowFieldZoneStat
+ *
+ * zone-map statistics are written as comma separated min/max values for each
+ * zone, and record-batches are separated by semicolon. Record-batches without
+ * zone-map statistics have an empty entry.
+ */
+static int
+__setupArrowFieldZoneStat(ArrowKeyValue *customMetadata,
+						  SQLfield *column, int numRecordBatches)
+{
+	static const char *zone_names[] = {"zone_min_values","zone_max_values"};
+	SQLzoneStat **zone_values;
+	SQLzoneStat *curr;
+	ArrowKeyValue *kv;
+	char		temp[64];
+	int			i, k, z;
+
+	if (!column->zone_list)
+		return 0;
+	zone_values = alloca(sizeof(SQLzoneStat *) * numRecordBatches);
+	memset(zone_values, 0, sizeof(SQLzoneStat *) * numRecordBatches);
+	for (curr = column->zone_list; curr; curr = curr->next)
+	{
+		int		rb_index = curr->rb_index;
+
+		if (rb_index < 0 || rb_index >= numRecordBatches)
+			Elog("zone-map stat info at [%s] is out of range (%d of %d)",
+				 column->field_name, rb_index, numRecordBatches);
+		if (zone_values[rb_index])
+			Elog("duplicate zone-map stat info at [%s] rb_index=%d",
+				 column->field_name, rb_index);
+		zone_values[rb_index] = curr;
+	}
+	/* number of rows per zone */
+	kv = &customMetadata[0];
+	snprintf(temp, sizeof(temp), "%d", ARROW_ZONE_NROWS);
+	initArrowNode(kv, KeyValue);
+	kv->key = pstrdup("zone_nrows");
+	kv->_key_len = strlen(kv->key);
+	kv->value = pstrdup(temp);
+	kv->_value_len = strlen(kv->value);
+	/* build zone-map min/max array */
+	for (k=0; k < 2; k++)
+	{
+		int		len = 1024;
+		int		off = 0;
+		char   *buf = palloc(len);
+
+		kv = &customMetadata[k+1];
+		for (i=0; i < numRecordBatches; i++)
+		{
+			SQLzoneStat *zone = zone_values[i];
+
+			if (off + 100 >= len)
+			{
+				len += len;
+				buf = repalloc(buf, len);
+			}
+			if (i > 0)
+				buf[off++] = ';';
+			if (!zone)
+				continue;
+			for (z=0; z < zone->nzones; z++)
+			{
+				SQLstat	   *zstat = &zone->zones[z];
+
+				if (off + 100 >= len)
+				{
+					len += len;
+					buf = repalloc(buf, len);
+				}
+				if (z > 0)
+					buf[off++] = ',';
+				if (!zstat->is_valid)
+				{
+					off += snprintf(buf+off, len-off, "null");
+					continue;
+				}
+				for (;;)
+				{
+					int		nbytes;
+
+					nbytes = column->write_stat(column, buf+off, len-off,
+												k == 0 ? &zstat->min : &zstat->max);
+					if (nbytes < 0)
+						Elog("failed on write %s statistics of %s (rb_index=%d)",
+							 zone_names[k], column->field_name, i);
+					if (off + nbytes < len)
+					{
+						off += nbytes;
+						break;
+					}
+					len += len;
+					buf = repalloc(buf, len);
+				}
+			}
+		}
+		buf[off] = '\0';
+		initArrowNode(kv, KeyValue);
+		kv->key = pstrdup(zone_names[k]);
+		kv->_key_len = strlen(kv->key);
+		kv->value = buf;
+		kv->_value_len = off;
+	}
+	return 3;
+}
+
+/*
+ * __setupArrowFieldBloom
+ *
+ * bloom filters are written as comma separated hex-strings for each
+ * record-batch. Record-batches without bloom filter have an empty entry.
+ */
+static int
+__setupArrowFieldBloom(ArrowKeyValue *customMetadata,
+					   SQLfield *column, int numRecordBatches)
+{
+	static const char hextbl[] = "0123456789abcdef";
+	SQLbloom  **blooms;
+	SQLbloom   *curr;
+	ArrowKeyValue *kv;
+	size_t		len = 1024;
+	size_t		off = 0;
+	char	   *buf;
+	char		temp[64];
+
+	if (!column->bloom_list)
+		return 0;
+	blooms = alloca(sizeof(SQLbloom *) * numRecordBatches);
+	memset(blooms, 0, sizeof(SQLbloom *) * numRecordBatches);
+	for (curr = column->bloom_list; curr; curr = curr->next)
+	{
+		int		rb_index = curr->rb_index;
+
+		if (rb_index < 0 || rb_index >= numRecordBatches)
+			Elog("bloom filter at [%s] is out of range (%d of %d)",
+				 column->field_name, rb_index, numRecordBatches);
+		if (blooms[rb_index])
+			Elog("duplicate bloom filter at [%s] rb_index=%d",
+				 column->field_name, rb_index);
+		blooms[rb_index] = curr;
+		len += curr->nbits / 4 + 1;
+	}
+	/* number of hash functions */
+	kv = &customMetadata[0];
+	snprintf(temp, sizeof(temp), "%d", ARROW_BLOOM_NHASHES);
+	initArrowNode(kv, KeyValue);
+	kv->key = pstrdup("bloom_nhashes");
+	kv->_key_len = strlen(kv->key);
+	kv->value = pstrdup(temp);
+	kv->_value_len = strlen(kv->value);
+	/* build bloom filters as hex-string */
+	buf = palloc(len + numRecordBatches);
+	for (int i=0; i < numRecordBatches; i++)
+	{
+		if (i > 0)
+			buf[off++] = ',';
+		curr = blooms[i];
+		if (!curr)
+			continue;
+		for (uint32_t k=0; k < curr->nbits / 8; k++)
+		{
+			uint8_t		c = ((uint8_t *)curr->bitmap)[k];
+
+			buf[off++] = hextbl[c >> 4];
+			buf[off++] = hextbl[c & 0x0f];
+		}
+	}
+	buf[off] = '\0';
+	kv = &customMetadata[1];
+	initArrowNode(kv, KeyValue);
+	kv->key = pstrdup("bloom_filters");
+	kv->_key_len = strlen(kv->key);
+	kv->value = buf;
+	kv->_value_len = off;
+
+	return 2;
+}
+
 static void
 setupArrowField(ArrowField *field, SQLtable *table, SQLfield *column)
 {
 	ArrowKeyValue *customMetadata = column->customMetadata;
 	int			numCustomMetadata = column->numCustomMetadata;
 
+	/*
+	 * setupArrowField() is called for both of the Schema and the Footer,
+	 * so column->customMetadata must not be expanded by repalloc() below.
+	 */
+	if (numCustomMetadata > 0 && (column->stat_enabled || column->bloom_list))
+	{
+		customMetadata = palloc(sizeof(ArrowKeyValue) * numCustomMetadata);
+		memcpy(customMetadata, column->customMetadata,
+			   sizeof(ArrowKeyValue) * numCustomMetadata);
+	}
 	initArrowNode(field, Field);
 	field->name = column->field_name;
 	field->_name_len = strlen(column->field_name);
@@ -1334,6 +1530,30 @@ setupArrowField(ArrowField *field, SQLtable *table, SQLfield *column)
 		__setupArrowFieldStat(customMetadata + numCustomMetadata,
 							  column, table->numRecordBatches);
 		numCustomMetadata += 2;
+		/* zone-map statistics, if any */
+		if (column->zone_list)
+		{
+			sz = sizeof(ArrowKeyValue) * (numCustomMetadata + 3);
+			customMetadata = repalloc(customMetadata, sz);
+			numCustomMetadata += __setupArrowFieldZoneStat(customMetadata +
+														   numCustomMetadata,
+														   column,
+														   table->numRecordBatches);
+		}
+	}
+	/* bloom filter, if any */
+	if (column->bloom_list)
+	{
+		size_t		sz = sizeof(ArrowKeyValue) * (numCustomMetadata + 2);
+
+		if (!customMetadata)
+			customMetadata = palloc0(sz);
+		else
+			customMetadata = repalloc(customMetadata, sz);
+		numCustomMetadata += __setupArrowFieldBloom(customMetadata +
+													numCustomMetadata,
+													column,
+													table->numRecordBatches);
 	}
 	/* custom metadata, if any */
 	field->_num_custom_metadata = numCustomMetadata;
@@ -1691,11 +1911,312 @@ setupArrowBufferIOV(SQLtable *table, SQLfield *column)
 	return consumed;
 }
 
+/*
+ * Body compression support
+ *
+ * Each buffer is compressed individually (BodyCompressionMethod::BUFFER),
+ * and prefixed by its uncompressed length in int64. If compression does not
+ * make the buffer smaller, it is stored as is with -1 in the prefix.
+ */
+static bool
+__sqlFieldHasEnumDict(SQLfield *column)
+{
+	if (column->enumdict)
+		return true;
+	if (column->element && __sqlFieldHasEnumDict(column->element))
+		return true;
+	for (int j=0; j < column->nfields && column->subfields; j++)
+	{
+		if (__sqlFieldHasEnumDict(&column->subfields[j]))
+			return true;
+	}
+	return false;
+}
+
+void
+setupArrowBodyCompression(SQLtable *table,
+						  const char *compress_spec,
+						  int nworkers)
+{
+	char	   *temp = alloca(strlen(compress_spec) + 1);
+	char	   *pos;
+	int			level = 0;
+
+	/*
+	 * Arrow_Fdw does not support dictionary-encoded columns in compressed
+	 * record batches, so we don't write such files.
+	 */
+	for (int j=0; j < table->nfields; j++)
+	{
+		if (__sqlFieldHasEnumDict(&table->columns[j]))
+			Elog("body compression is not supported for the dictionary-encoded column '%s'",
+				 table->columns[j].field_name);
+	}
+
+	strcpy(temp, compress_spec);
+	pos = strchr(temp, ':');
+	if (pos)
+	{
+		char   *end;
+
+		*pos++ = '\0';
+		level = strtol(pos, &end, 10);
+		if (*end != '\0')
+			Elog("invalid compression level: %s", compress_spec);
+	}
+	if (strcasecmp(temp, "lz4") == 0)
+	{
+#ifndef HAVE_LIBLZ4
+		Elog("LZ4 compression is not supported in this build");
+#endif
+		table->compress_codec = ArrowCompressionType__LZ4_FRAME;
+	}
+	else if (strcasecmp(temp, "zstd") == 0)
+	{
+#ifndef HAVE_LIBZSTD
+		Elog("ZSTD compression is not supported in this build");
+#endif
+		table->compress_codec = ArrowCompressionType__ZSTD;
+	}
+	else
+		Elog("unknown compression codec: %s", compress_spec);
+	table->compressed = true;
+	table->compress_level = level;
+	table->compress_nworkers = (nworkers > 0 ? nworkers : 1);
+}
+
+static int
+__collectArrowBuffers(SQLfield *column, SQLbuffer **vec)
+{
+	int			j, count = 0;
+
+	if (column->enumdict)
+	{
+		/* Enum data types */
+		vec[count++] = (column->nullcount > 0 ? &column->nullmap : NULL);
+		vec[count++] = &column->values;
+	}
+	else if (column->element)
+	{
+		/* Array data types */
+		vec[count++] = (column->nullcount > 0 ? &column->nullmap : NULL);
+		vec[count++] = &column->values;
+		count += __collectArrowBuffers(column->element, vec + count);
+	}
+	else if (column->subfields)
+	{
+		/* Composite data types */
+		vec[count++] = (column->nullcount > 0 ? &column->nullmap : NULL);
+		for (j=0; j < column->nfields; j++)
+			count += __collectArrowBuffers(&column->subfields[j], vec + count);
+	}
+	else
+	{
+		switch (column->arrow_type.node.tag)
+		{
+			/* inline type */
+			case ArrowNodeTag__Int:
+			case ArrowNodeTag__FloatingPoint:
+			case ArrowNodeTag__Bool:
+			case ArrowNodeTag__Decimal:
+			case ArrowNodeTag__Date:
+			case ArrowNodeTag__Time:
+			case ArrowNodeTag__Timestamp:
+			case ArrowNodeTag__Interval:
+			case ArrowNodeTag__FixedSizeBinary:
+				vec[count++] = (column->nullcount > 0 ? &column->nullmap : NULL);
+				vec[count++] = &column->values;
+				break;
+
+			/* variable length type */
+			case ArrowNodeTag__Utf8:
+			case ArrowNodeTag__Binary:
+			case ArrowNodeTag__LargeUtf8:
+			case ArrowNodeTag__LargeBinary:
+				vec[count++] = (column->nullcount > 0 ? &column->nullmap : NULL);
+				vec[count++] = &column->values;
+				vec[count++] = &column->extra;
+				break;
+
+			default:
+				Elog("Bug? Arrow Type %s is not supported right now",
+					 arrowNodeName(&column->arrow_type.node));
+				break;
+		}
+	}
+	return count;
+}
+
+typedef struct
+{
+	SQLtable   *table;
+	SQLbuffer **src_bufs;
+	uint32_t	next_index;		/* atomic counter */
+	const char *errmsg;
+} arrowCompressContext;
+
+static const char *
+__compressArrowBufferOne(SQLtable *table, SQLbuffer *src, SQLbuffer *dst)
+{
+	int64_t		raw_length = src->usage;
+	char	   *dest = dst->data + sizeof(int64_t);
+	size_t		dest_length __attribute__((unused)) = dst->length - sizeof(int64_t);
+	size_t		sz = 0;
+
+	if (table->compress_codec == ArrowCompressionType__LZ4_FRAME)
+	{
+#ifdef HAVE_LIBLZ4
+		LZ4F_preferences_t prefs;
+
+		memset(&prefs, 0, sizeof(LZ4F_preferences_t));
+		prefs.compressionLevel = table->compress_level;
+		prefs.frameInfo.contentSize = src->usage;
+		sz = LZ4F_compressFrame(dest, dest_length,
+								src->data, src->usage, &prefs);
+		if (LZ4F_isError(sz))
+			return LZ4F_getErrorName(sz);
+#endif
+	}
+	else if (table->compress_codec == ArrowCompressionType__ZSTD)
+	{
+#ifdef HAVE_LIBZSTD
+		sz = ZSTD_compress(dest, dest_length,
+						   src->data, src->usage,
+						   table->compress_level);
+		if (ZSTD_isError(sz))
+			return ZSTD_getErrorName(sz);
+#endif
+	}
+	if (sz == 0 || sz >= src->usage)
+	{
+		/* store the buffer without compression */
+		raw_length = -1;
+		memcpy(dest, src->data, src->usage);
+		sz = src->usage;
+	}
+	memcpy(dst->data, &raw_length, sizeof(int64_t));
+	dst->usage = sizeof(int64_t) + sz;
+
+	return NULL;
+}
+
+static void *
+__compressArrowBufferWorker(void *__context)
+{
+	arrowCompressContext *con = __context;
+	SQLtable   *table = con->table;
+	uint32_t	index;
+
+	while ((index = __atomic_fetch_add(&con->next_index, 1,
+									   __ATOMIC_SEQ_CST)) < table->numBuffers)
+	{
+		SQLbuffer  *src = con->src_bufs[index];
+		SQLbuffer  *dst = &table->__cbufs[index];
+		const char *errmsg;
+
+		if (!src || src->usage == 0)
+			continue;
+		errmsg = __compressArrowBufferOne(table, src, dst);
+		if (errmsg)
+			con->errmsg = errmsg;
+	}
+	return NULL;
+}
+
+static size_t
+__compressArrowRecordBatchBuffers(SQLtable *table, ArrowBuffer *buffers)
+{
+	arrowCompressContext con;
+	SQLbuffer **src_bufs;
+	pthread_t  *workers;
+	int			i, j, nworkers;
+	size_t		offset = 0;
+
+	src_bufs = alloca(sizeof(SQLbuffer *) * table->numBuffers);
+	for (i=0, j=0; i < table->nfields; i++)
+		j += __collectArrowBuffers(&table->columns[i], &src_bufs[j]);
+	assert(j == table->numBuffers);
+
+	/* destination buffers must be allocated by the caller thread */
+	if (!table->__cbufs)
+		table->__cbufs = palloc0(sizeof(SQLbuffer) * table->numBuffers);
+	for (j=0; j < table->numBuffers; j++)
+	{
+		SQLbuffer  *src = src_bufs[j];
+		SQLbuffer  *dst = &table->__cbufs[j];
+		size_t		required = 0;
+
+		dst->usage = 0;
+		if (!src || src->usage == 0)
+			continue;
+#ifdef HAVE_LIBLZ4
+		if (table->compress_codec == ArrowCompressionType__LZ4_FRAME)
+			required = LZ4F_compressFrameBound(src->usage, NULL);
+#endif
+#ifdef HAVE_LIBZSTD
+		if (table->compress_codec == ArrowCompressionType__ZSTD)
+			required = ZSTD_compressBound(src->usage);
+#endif
+		if (required < src->usage)
+			required = src->usage;
+		/* int64 prefix and padding by sql_buffer_append_iov */
+		required = ARROWALIGN(sizeof(int64_t) + required);
+		if (dst->length < required)
+		{
+			if (!dst->data)
+				dst->data = palloc(required);
+			else
+				dst->data = repalloc(dst->data, required);
+			dst->length = required;
+		}
+	}
+
+	/* run compression by multiple threads */
+	memset(&con, 0, sizeof(arrowCompressContext));
+	con.table = table;
+	con.src_bufs = src_bufs;
+	nworkers = (table->compress_nworkers < table->numBuffers
+				? table->compress_nworkers : table->numBuffers);
+	if (nworkers <= 1)
+		__compressArrowBufferWorker(&con);
+	else
+	{
+		workers = alloca(sizeof(pthread_t) * nworkers);
+		for (i=0; i < nworkers; i++)
+		{
+			if ((errno = pthread_create(&workers[i], NULL,
+										__compressArrowBufferWorker,
+										&con)) != 0)
+				Elog("failed on pthread_create: %m");
+		}
+		for (i=0; i < nworkers; i++)
+		{
+			if ((errno = pthread_join(workers[i], NULL)) != 0)
+				Elog("failed on pthread_join: %m");
+		}
+	}
+	if (con.errmsg)
+		Elog("failed on body compression: %s", con.errmsg);
+
+	/* fill up [buffers] vector; length is not aligned for decompression */
+	for (j=0; j < table->numBuffers; j++)
+	{
+		SQLbuffer  *dst = &table->__cbufs[j];
+
+		initArrowNode(&buffers[j], Buffer);
+		buffers[j].offset = offset;
+		buffers[j].length = dst->usage;
+		offset += ARROWALIGN(dst->usage);
+	}
+	return offset;
+}
+
 size_t
 setupArrowRecordBatchIOV(SQLtable *table)
 {
 	ArrowMessage	message;
 	ArrowRecordBatch *rbatch;
+	ArrowBodyCompression compression;
 	ArrowFieldNode *nodes;
 	ArrowBuffer	   *buffers;
 	int				i, j;
@@ -1716,12 +2237,17 @@ setupArrowRecordBatchIOV(SQLtable *table)
 
 	/* fill up [buffers] vector */
 	buffers = alloca(sizeof(ArrowBuffer) * table->numBuffers);
-	for (i=0, j=0; i < table->nfields; i++)
+	if (table->compressed)
+		bodyLength = __compressArrowRecordBatchBuffers(table, buffers);
+	else
 	{
-		j += setupArrowBuffer(&buffers[j], &table->columns[i],
-							  &bodyLength);
+		for (i=0, j=0; i < table->nfields; i++)
+		{
+			j += setupArrowBuffer(&buffers[j], &table->columns[i],
+								  &bodyLength);
+		}
+		assert(j == table->numBuffers);
 	}
-	assert(j == table->numBuffers);
 
 	/* setup Message of Schema */
 	initArrowNode(&message, Message);
@@ -1735,10 +2261,28 @@ setupArrowRecordBatchIOV(SQLtable *table)
 	rbatch->_num_nodes = table->numFieldNodes;
 	rbatch->buffers = buffers;
 	rbatch->_num_buffers = table->numBuffers;
+	if (table->compressed)
+	{
+		initArrowNode(&compression, BodyCompression);
+		compression.codec = table->compress_codec;
+		compression.method = ArrowBodyCompressionMethod__BUFFER;
+		rbatch->compression = &compression;
+	}
 	/* serialization */
 	consumed = setupFlatBufferMessageIOV(table, &message);
-	for (j=0; j < table->nfields; j++)
-		consumed += setupArrowBufferIOV(table, &table->columns[j]);
+	if (table->compressed)
+	{
+		for (j=0; j < table->numBuffers; j++)
+		{
+			if (table->__cbufs[j].usage > 0)
+				consumed += sql_buffer_append_iov(table, &table->__cbufs[j]);
+		}
+	}
+	else
+	{
+		for (j=0; j < table->nfields; j++)
+			consumed += setupArrowBufferIOV(table, &table->columns[j]);
+	}
 	return consumed;
 }
 
@@ -1760,6 +2304,232 @@ __saveArrowRecordBatchStats(SQLfield *main_field,
 	}
 }
 
+/*
+ * __saveArrowRecordBatchZoneStats
+ *
+ * It builds min/max statistics for each ARROW_ZONE_NROWS rows of the fixed-
+ * length values (zone-map), to allow readers to skip a part of record-batch.
+ */
+#define __ZONE_STAT_UPDATE(TYPE,FIELD)									\
+	do {																\
+		const TYPE *values = (const TYPE *)field->values.data;			\
+																		\
+		for (long i=base; i < tail; i++)								\
+		{																\
+			if (field->nullcount > 0 &&									\
+				(field->nullmap.data[i>>3] & (1<<(i&7))) == 0)			\
+				continue;												\
+			if (!zstat->is_valid)										\
+			{															\
+				zstat->min.FIELD = values[i];							\
+				zstat->max.FIELD = values[i];							\
+				zstat->is_valid = true;									\
+			}															\
+			else														\
+			{															\
+				if (zstat->min.FIELD > values[i])						\
+					zstat->min.FIELD = values[i];						\
+				if (zstat->max.FIELD < values[i])						\
+					zstat->max.FIELD = values[i];						\
+			}															\
+		}																\
+	} while(0)
+
+static bool
+__buildArrowZoneStatOne(SQLfield *field, SQLstat *zstat, long base, long tail)
+{
+	ArrowType  *t = &field->arrow_type;
+	int			width;
+
+	switch (t->node.tag)
+	{
+		case ArrowNodeTag__Int:
+			width = t->Int.bitWidth;
+			if (width == 8 && t->Int.is_signed)
+				__ZONE_STAT_UPDATE(int8_t, i8);
+			else if (width == 8)
+				__ZONE_STAT_UPDATE(uint8_t, u8);
+			else if (width == 16 && t->Int.is_signed)
+				__ZONE_STAT_UPDATE(int16_t, i16);
+			else if (width == 16)
+				__ZONE_STAT_UPDATE(uint16_t, u16);
+			else if (width == 32 && t->Int.is_signed)
+				__ZONE_STAT_UPDATE(int32_t, i32);
+			else if (width == 32)
+				__ZONE_STAT_UPDATE(uint32_t, u32);
+			else if (width == 64 && t->Int.is_signed)
+				__ZONE_STAT_UPDATE(int64_t, i64);
+			else if (width == 64)
+				__ZONE_STAT_UPDATE(uint64_t, u64);
+			else
+				return false;
+			break;
+		case ArrowNodeTag__FloatingPoint:
+			if (t->FloatingPoint.precision == ArrowPrecision__Single)
+				__ZONE_STAT_UPDATE(float, f32);
+			else if (t->FloatingPoint.precision == ArrowPrecision__Double)
+				__ZONE_STAT_UPDATE(double, f64);
+			else
+				return false;
+			break;
+		case ArrowNodeTag__Date:
+			if (t->Date.unit == ArrowDateUnit__Day)
+				__ZONE_STAT_UPDATE(int32_t, i32);
+			else if (t->Date.unit == ArrowDateUnit__MilliSecond)
+				__ZONE_STAT_UPDATE(int64_t, i64);
+			else
+				return false;
+			break;
+		case ArrowNodeTag__Time:
+			if (t->Time.bitWidth == 32)
+				__ZONE_STAT_UPDATE(int32_t, i32);
+			else if (t->Time.bitWidth == 64)
+				__ZONE_STAT_UPDATE(int64_t, i64);
+			else
+				return false;
+			break;
+		case ArrowNodeTag__Timestamp:
+			__ZONE_STAT_UPDATE(int64_t, i64);
+			break;
+		default:
+			return false;
+	}
+	return true;
+}
+#undef __ZONE_STAT_UPDATE
+
+static void
+__saveArrowRecordBatchZoneStats(SQLfield *main_field,
+								SQLfield *data_field, int rb_index)
+{
+	SQLzoneStat *zone;
+	long		nitems = data_field->nitems;
+	int			nzones = (nitems + ARROW_ZONE_NROWS - 1) / ARROW_ZONE_NROWS;
+
+	if (nzones < 2)
+		return;		/* no need to split the record-batch */
+	zone = palloc0(sizeof(SQLzoneStat));
+	zone->rb_index = rb_index;
+	zone->nzones = nzones;
+	zone->zones = palloc0(sizeof(SQLstat) * nzones);
+	for (int k=0; k < nzones; k++)
+	{
+		long	base = (long)k * ARROW_ZONE_NROWS;
+		long	tail = base + ARROW_ZONE_NROWS;
+
+		if (tail > nitems)
+			tail = nitems;
+
+		zone->zones[k].rb_index = rb_index;
+		if (!__buildArrowZoneStatOne(data_field, &zone->zones[k], base, tail))
+		{
+			/* not a supported data type */
+			pfree(zone->zones);
+			pfree(zone);
+			return;
+		}
+	}
+	zone->next = main_field->zone_list;
+	main_field->zone_list = zone;
+}
+
+/*
+ * saveArrowRecordBatchBloom
+ *
+ * It builds a bloom filter of the values in the record-batch, using the
+ * raw bytes of Arrow's representation.
+ */
+void
+saveArrowRecordBatchBloom(SQLfield *main_field,
+						  SQLfield *data_field, int rb_index)
+{
+	SQLfield   *field = data_field;
+	ArrowType  *t = &field->arrow_type;
+	SQLbloom   *bloom;
+	uint32_t	nbits = ARROW_BLOOM_MIN_NBITS;
+	int			unitsz = 0;
+	bool		is_varlena = false;
+
+	switch (t->node.tag)
+	{
+		case ArrowNodeTag__Int:
+			unitsz = t->Int.bitWidth / 8;
+			break;
+		case ArrowNodeTag__Date:
+			unitsz = (t->Date.unit == ArrowDateUnit__Day ? 4 : 8);
+			break;
+		case ArrowNodeTag__Time:
+			unitsz = t->Time.bitWidth / 8;
+			break;
+		case ArrowNodeTag__Timestamp:
+			unitsz = 8;
+			break;
+		case ArrowNodeTag__FixedSizeBinary:
+			unitsz = t->FixedSizeBinary.byteWidth;
+			break;
+		case ArrowNodeTag__Utf8:
+		case ArrowNodeTag__Binary:
+			unitsz = sizeof(uint32_t);
+			is_varlena = true;
+			break;
+		case ArrowNodeTag__LargeUtf8:
+		case ArrowNodeTag__LargeBinary:
+			unitsz = sizeof(uint64_t);
+			is_varlena = true;
+			break;
+		default:
+			return;		/* not supported */
+	}
+	if (field->nitems == 0 || field->nitems <= field->nullcount)
+		return;
+	while (nbits < ARROW_BLOOM_MAX_NBITS &&
+		   nbits < (field->nitems - field->nullcount) * ARROW_BLOOM_BITS_PER_ITEM)
+		nbits <<= 1;
+
+	bloom = palloc0(sizeof(SQLbloom));
+	bloom->rb_index = rb_index;
+	bloom->nbits = nbits;
+	bloom->bitmap = palloc0(nbits / 8);
+	for (long i=0; i < field->nitems; i++)
+	{
+		const char *addr;
+		size_t		len;
+		uint64_t	hash;
+
+		if (field->nullcount > 0 &&
+			(field->nullmap.data[i>>3] & (1<<(i&7))) == 0)
+			continue;
+		if (!is_varlena)
+		{
+			addr = field->values.data + unitsz * i;
+			len  = unitsz;
+		}
+		else if (unitsz == sizeof(uint32_t))
+		{
+			const uint32_t *offset = (const uint32_t *)field->values.data;
+
+			addr = field->extra.data + offset[i];
+			len  = offset[i+1] - offset[i];
+		}
+		else
+		{
+			const uint64_t *offset = (const uint64_t *)field->values.data;
+
+			addr = field->extra.data + offset[i];
+			len  = offset[i+1] - offset[i];
+		}
+		hash = arrowBloomHash(addr, len);
+		for (int k=0; k < ARROW_BLOOM_NHASHES; k++)
+		{
+			uint32_t	bit = arrowBloomBitIndex(hash, k, nbits);
+
+			bloom->bitmap[bit >> 6] |= (1UL << (bit & 63));
+		}
+	}
+	bloom->next = main_field->bloom_list;
+	main_field->bloom_list = bloom;
+}
+
 int
 writeArrowRecordBatch(SQLtable *table, ArrowBlock *p_arrow_block)
 {
@@ -1786,10 +2556,20 @@ writeArrowRecordBatch(SQLtable *table, ArrowBlock *p_arrow_block)
 		for (j=0; j < table->nfields; j++)
 		{
 			if (table->columns[j].stat_enabled)
+			{
+				__saveArrowRecordBatchZoneStats(&table->columns[j],
+												&table->columns[j], rb_index);
 				__saveArrowRecordBatchStats(&table->columns[j],
 											&table->columns[j], rb_index);
+			}
 		}
 	}
+	for (j=0; j < table->nfields; j++)
+	{
+		if (table->columns[j].bloom_enabled)
+			saveArrowRecordBatchBloom(&table->columns[j],
+									  &table->columns[j], rb_index);
+	}
 	if (p_arrow_block)
 		memcpy(p_arrow_block, &block, sizeof(ArrowBlock));
 	return rb_index;
@@ -1838,10 +2618,20 @@ writeArrowRecordBatchMT(SQLtable *main_table,
 		for (int j=0; j < data_table->nfields; j++)
 		{
 			if (main_table->columns[j].stat_enabled)
+			{
+				__saveArrowRecordBatchZoneStats(&main_table->columns[j],
+												&data_table->columns[j], rb_index);
 				__saveArrowRecordBatchStats(&main_table->columns[j],
 											&data_table->columns[j], rb_index);
+			}
 		}
 	}
+	for (int j=0; j < main_table->nfields; j++)
+	{
+		if (main_table->columns[j].bloom_enabled)
+			saveArrowRecordBatchBloom(&main_table->columns[j],
+									  &data_table->columns[j], rb_index);
+	}
 	if ((errno = pthread_mutex_unlock(main_table_mutex)) != 0)
 		Elog("failed on pthread_mutex_unlock: %m");
 
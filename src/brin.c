@@ -10,6 +10,7 @@
  * it under the terms of the PostgreSQL License.
  */
 #include "pg_strom.h"
+#include "access/brin_pageops.h"
 #include "access/brin_revmap.h"
 #include "executor/nodeIndexscan.h"
 
@@ -407,6 +408,96 @@ pgstromTryFindBrinIndex(PlannerInfo *root,
 	return indexOpt;
 }
 
+/*
+ * pgstromBrinIndexAddDynamicFilter
+ *
+ * It appends (VAR >= $min AND VAR <= $max) to the BRIN-index conditions,
+ * where $min and $max are PARAM_EXEC set by the inner preloading of GpuJoin.
+ * If no BRIN-index is chosen yet, the one on the outer key is used.
+ */
+bool
+pgstromBrinIndexAddDynamicFilter(PlannerInfo *root,
+								 pgstromPlanInfo *pp_info,
+								 Var *var,
+								 Param *param_min,
+								 Param *param_max)
+{
+	RelOptInfo *baserel;
+	ListCell   *lc;
+
+	if (!pgstrom_enable_brin ||
+		pp_info->scan_relid >= root->simple_rel_array_size)
+		return false;
+	baserel = root->simple_rel_array[pp_info->scan_relid];
+	if (!baserel)
+		return false;
+	foreach (lc, baserel->indexlist)
+	{
+		IndexOptInfo *index = (IndexOptInfo *) lfirst(lc);
+
+		if (index->relam != BRIN_AM_OID)
+			continue;
+		if (OidIsValid(pp_info->brin_index_oid)
+			? index->indexoid != pp_info->brin_index_oid
+			: (index->indpred != NIL && !index->predOK))
+			continue;
+		for (int icol=0; icol < index->nkeycolumns; icol++)
+		{
+			Oid		opfamily = index->opfamily[icol];
+			Oid		ge_op;
+			Oid		le_op;
+			Var	   *ivar;
+			Expr   *expr;
+
+			if (index->indexkeys[icol] != var->varattno)
+				continue;
+			/* only minmax operator classes have the inequality operators */
+			ge_op = get_opfamily_member(opfamily, var->vartype, var->vartype,
+										BTGreaterEqualStrategyNumber);
+			le_op = get_opfamily_member(opfamily, var->vartype, var->vartype,
+										BTLessEqualStrategyNumber);
+			if (!OidIsValid(ge_op) || !OidIsValid(le_op))
+				continue;
+			ivar = makeVar(INDEX_VAR,
+						   icol + 1,
+						   var->vartype,
+						   var->vartypmod,
+						   var->varcollid,
+						   0);
+			/* index conditions */
+			expr = make_opclause(ge_op, BOOLOID, false,
+								 (Expr *)copyObject(ivar),
+								 (Expr *)copyObject(param_min),
+								 InvalidOid, var->varcollid);
+			set_opfuncid((OpExpr *)expr);
+			pp_info->brin_index_conds = lappend(pp_info->brin_index_conds, expr);
+			expr = make_opclause(le_op, BOOLOID, false,
+								 (Expr *)ivar,
+								 (Expr *)copyObject(param_max),
+								 InvalidOid, var->varcollid);
+			set_opfuncid((OpExpr *)expr);
+			pp_info->brin_index_conds = lappend(pp_info->brin_index_conds, expr);
+			/* original qualifiers for EXPLAIN */
+			expr = make_opclause(ge_op, BOOLOID, false,
+								 (Expr *)copyObject(var),
+								 (Expr *)copyObject(param_min),
+								 InvalidOid, var->varcollid);
+			set_opfuncid((OpExpr *)expr);
+			pp_info->brin_index_quals = lappend(pp_info->brin_index_quals, expr);
+			expr = make_opclause(le_op, BOOLOID, false,
+								 (Expr *)copyObject(var),
+								 (Expr *)copyObject(param_max),
+								 InvalidOid, var->varcollid);
+			set_opfuncid((OpExpr *)expr);
+			pp_info->brin_index_quals = lappend(pp_info->brin_index_quals, expr);
+
+			pp_info->brin_index_oid = index->indexoid;
+			return true;
+		}
+	}
+	return false;
+}
+
 /*
  * cost_brin_bitmap_build
  */
@@ -446,14 +537,23 @@ cost_brin_bitmap_build(PlannerInfo *root,
 }
 
 
+/*
+ * BrinIndexResults
+ *
+ * All the processes (leader and parallel workers) evaluate the BRIN
+ * summary of the block ranges cooperatively, by BRIN_BUILD_BATCH_SZ
+ * ranges per fetch of @build_next, then set @matches[] of the ranges.
+ * The scan begins once @build_done reaches the number of block ranges.
+ */
+#define BRIN_BUILD_BATCH_SZ		256
+
 typedef struct
 {
-	volatile int	build_status;
-	slock_t			lock;	/* once 'build_status' is set, no need to take
-							 * this lock again. */
-	pg_atomic_uint32 index;
-	uint32_t		nitems;
-	BlockNumber		chunks[FLEXIBLE_ARRAY_MEMBER];
+	volatile int	build_status;	/* -1, if any process failed */
+	pg_atomic_uint32 build_next;	/* next block-range to be evaluated */
+	pg_atomic_uint32 build_done;	/* number of evaluated block-ranges */
+	pg_atomic_uint32 index;			/* next block-range to be scanned */
+	bool			matches[FLEXIBLE_ARRAY_MEMBER];
 } BrinIndexResults;
 
 struct BrinIndexState
@@ -554,22 +654,19 @@ pgstromBrinIndexExecReset(pgstromTaskState *pts)
 	BrinIndexState *br_state = pts->br_state;
 	BrinIndexResults *br_results = br_state->brinResults;
 
-	if (br_state->NumRuntimeKeys != 0)
-	{
-		ExprContext	*econtext = br_state->RuntimeExprContext;
-
-		ResetExprContext(econtext);
-		ExecIndexEvalRuntimeKeys(econtext,
-								 br_state->RuntimeKeys,
-								 br_state->NumRuntimeKeys);
-	}
+	/*
+	 * The runtime keys are evaluated on the next call of __BrinIndexGetResults,
+	 * because PARAM_EXEC of the dynamic filter is not set up until the inner
+	 * preloading of GpuJoin.
+	 */
 	br_state->RuntimeKeysIsReady = false;
 
 	br_state->curr_chunk_id = 0;
 	br_state->curr_block_id = UINT_MAX;
 
 	br_results->build_status = 0;
-	br_results->nitems   = 0;
+	pg_atomic_init_u32(&br_results->build_next, 0);
+	pg_atomic_init_u32(&br_results->build_done, 0);
 	pg_atomic_init_u32(&br_results->index, 0);
 }
 
@@ -647,6 +744,10 @@ __BrinIndexExecBuildResults(pgstromTaskState *pts)
 	int			   *nnullkeys;
 	int				j, keyno;
 	uint32_t		chunk_id;
+	uint32_t		chunk_base;
+	uint32_t		chunk_tail;
+	uint32_t		nfetched = 0;
+	uint32_t		nskipped = 0;
 
 	/*
 	 * Make room for the consistent support procedures of indexed columns.  We
@@ -722,12 +823,12 @@ __BrinIndexExecBuildResults(pgstromTaskState *pts)
 	oldcxt = MemoryContextSwitchTo(per_range_cxt);
 
 	/*
-	 * Now scan the revmap.  We start by querying for heap page 0,
-	 * incrementing by the number of pages per range; this gives us a full
-	 * view of the table.
+	 * Now scan the revmap.  Unlike bringetbitmap(), we fetch a batch of the
+	 * block ranges at once, then evaluate them, until all the ranges are
+	 * taken by this or concurrent processes.
 	 */
-	br_results->nitems = 0;
-	for (chunk_id = 0; chunk_id < br_state->nchunks; chunk_id++)
+	chunk_base = chunk_tail = chunk_id = 0;
+	for (;;)
 	{
 		BrinTuple  *__btup;
 		BrinTuple  *btup = NULL;
@@ -736,6 +837,19 @@ __BrinIndexExecBuildResults(pgstromTaskState *pts)
 		Size		size;
 		bool		addrange = true;
 
+		if (chunk_id >= chunk_tail)
+		{
+			if (chunk_tail > chunk_base)
+				pg_atomic_fetch_add_u32(&br_results->build_done,
+										chunk_tail - chunk_base);
+			chunk_base = pg_atomic_fetch_add_u32(&br_results->build_next,
+												 BRIN_BUILD_BATCH_SZ);
+			if (chunk_base >= br_state->nchunks)
+				break;
+			chunk_tail = Min(chunk_base + BRIN_BUILD_BATCH_SZ,
+							 br_state->nchunks);
+			chunk_id = chunk_base;
+		}
 		CHECK_FOR_INTERRUPTS();
 
 		MemoryContextResetAndDeleteChildren(per_range_cxt);
@@ -855,24 +969,20 @@ __BrinIndexExecBuildResults(pgstromTaskState *pts)
 			}
 		}
 	skip:
+		br_results->matches[chunk_id++] = addrange;
 		if (addrange)
-		{
-			int		idx = br_results->nitems++;
-
-			br_results->chunks[idx] = chunk_id;
-		}
+			nfetched++;
+		else
+			nskipped++;
 	}
 	/* update statistics */
-	pg_atomic_fetch_add_u32(&ps_state->brin_index_fetched, br_results->nitems);
-	pg_atomic_fetch_add_u32(&ps_state->brin_index_skipped,
-							br_state->nchunks - br_results->nitems);
+	pg_atomic_fetch_add_u32(&ps_state->brin_index_fetched, nfetched);
+	pg_atomic_fetch_add_u32(&ps_state->brin_index_skipped, nskipped);
 	MemoryContextSwitchTo(oldcxt);
 	MemoryContextDelete(per_range_cxt);
 
 	if (buffer != InvalidBuffer)
 		ReleaseBuffer(buffer);
-	pg_memory_barrier();
-	br_results->build_status = 1;
 }
 
 static inline BrinIndexResults *
@@ -891,28 +1001,37 @@ __BrinIndexGetResults(pgstromTaskState *pts)
 
 	if (br_state->NumRuntimeKeys != 0 &&
 		!br_state->RuntimeKeysIsReady)
-		pgstromBrinIndexExecReset(pts);
+	{
+		ExprContext	*econtext = br_state->RuntimeExprContext;
+
+		ResetExprContext(econtext);
+		ExecIndexEvalRuntimeKeys(econtext,
+								 br_state->RuntimeKeys,
+								 br_state->NumRuntimeKeys);
+		br_state->RuntimeKeysIsReady = true;
+	}
 
 	br_results = br_state->brinResults;
-	if (br_results->build_status <= 0)
+	if (pg_atomic_read_u32(&br_results->build_done) < br_state->nchunks)
 	{
-		SpinLockAcquire(&br_results->lock);
 		PG_TRY();
 		{
-			if (br_results->build_status == 0)
-				__BrinIndexExecBuildResults(pts);
-			else if (br_results->build_status < 0)
-				elog(ERROR, "failed on __BrinIndexExecBuildResults by other workers");
+			__BrinIndexExecBuildResults(pts);
 		}
 		PG_CATCH();
 		{
 			br_results->build_status = -1;
-			SpinLockRelease(&br_results->lock);
 			PG_RE_THROW();
 		}
 		PG_END_TRY();
-		Assert(br_results->build_status > 0);
-		SpinLockRelease(&br_results->lock);
+		/* wait for the block-ranges evaluated by the concurrent workers */
+		while (pg_atomic_read_u32(&br_results->build_done) < br_state->nchunks)
+		{
+			if (br_results->build_status < 0)
+				elog(ERROR, "failed on __BrinIndexExecBuildResults by other workers");
+			CHECK_FOR_INTERRUPTS();
+			pg_usleep(1000L);	/* 1ms */
+		}
 	}
 	return br_results;
 }
@@ -927,10 +1046,12 @@ pgstromBrinIndexNextBlock(pgstromTaskState *pts)
 
 	if (br_state->curr_block_id >= br_state->pagesPerRange)
 	{
-		index = pg_atomic_fetch_add_u32(&br_results->index, 1);
-		if (index >= br_results->nitems)
-			return NULL;
-		br_state->curr_chunk_id = br_results->chunks[index];
+		do {
+			index = pg_atomic_fetch_add_u32(&br_results->index, 1);
+			if (index >= br_state->nchunks)
+				return NULL;
+		} while (!br_results->matches[index]);
+		br_state->curr_chunk_id = index;
 		br_state->curr_block_id = 0;
 	}
 	blockno = (br_state->curr_chunk_id * br_state->pagesPerRange +
@@ -951,12 +1072,15 @@ pgstromBrinIndexNextChunk(pgstromTaskState *pts)
 	BrinIndexResults *br_results = __BrinIndexGetResults(pts);
 	uint32_t		index;
 
-	index = pg_atomic_fetch_add_u32(&br_results->index, 1);
-	if (index < br_results->nitems)
+	do {
+		index = pg_atomic_fetch_add_u32(&br_results->index, 1);
+	} while (index < br_state->nchunks && !br_results->matches[index]);
+
+	if (index < br_state->nchunks)
 	{
 		BlockNumber	pagesPerRange = br_state->pagesPerRange;
 
-		pts->curr_block_num  = br_results->chunks[index] * pagesPerRange;
+		pts->curr_block_num  = index * pagesPerRange;
 		pts->curr_block_tail = pts->curr_block_num + pagesPerRange;
 		if (pts->curr_block_num >= br_state->nblocks)
 			return false;
@@ -985,7 +1109,7 @@ pgstromBrinIndexEstimateDSM(pgstromTaskState *pts)
 {
 	BrinIndexState *br_state = pts->br_state;
 
-	return MAXALIGN(offsetof(BrinIndexResults, chunks[br_state->nchunks]));
+	return MAXALIGN(offsetof(BrinIndexResults, matches[br_state->nchunks]));
 }
 
 Size
@@ -996,7 +1120,7 @@ pgstromBrinIndexInitDSM(pgstromTaskState *pts, char *dsm_addr)
 	Size		dsm_len = 0;
 
 	dsm_len = MAXALIGN(offsetof(BrinIndexResults,
-								chunks[br_state->nchunks]));
+								matches[br_state->nchunks]));
 	if (dsm_addr)
 		br_results = (BrinIndexResults *)dsm_addr;
 	else
@@ -1005,8 +1129,10 @@ pgstromBrinIndexInitDSM(pgstromTaskState *pts, char *dsm_addr)
 
 		br_results = MemoryContextAlloc(estate->es_query_cxt, dsm_len);
 	}
-	memset(br_results, 0, offsetof(BrinIndexResults, chunks));
-	SpinLockInit(&br_results->lock);
+	memset(br_results, 0, offsetof(BrinIndexResults, matches));
+	pg_atomic_init_u32(&br_results->build_next, 0);
+	pg_atomic_init_u32(&br_results->build_done, 0);
+	pg_atomic_init_u32(&br_results->index, 0);
 
 	br_state->brinResults = br_results;
 
@@ -1020,7 +1146,7 @@ pgstromBrinIndexAttachDSM(pgstromTaskState *pts, char *dsm_addr)
 
 	br_state->brinResults = (BrinIndexResults *)dsm_addr;
 	return MAXALIGN(offsetof(BrinIndexResults,
-							 chunks[br_state->nchunks]));
+							 matches[br_state->nchunks]));
 }
 
 void
@@ -1075,6 +1201,205 @@ pgstromBrinIndexExplain(pgstromTaskState *pts,
 	pfree(buf.data);
 }
 
+/*
+ * pgstrom_tid_block_number - block number of the tid (also on the device)
+ */
+PG_FUNCTION_INFO_V1(pgstrom_tid_block_number);
+PUBLIC_FUNCTION(Datum)
+pgstrom_tid_block_number(PG_FUNCTION_ARGS)
+{
+	ItemPointer	ip = (ItemPointer) PG_GETARG_POINTER(0);
+
+	PG_RETURN_INT64(ItemPointerGetBlockNumberNoCheck(ip));
+}
+
+/*
+ * pgstrom_brin_summarize_gpu
+ *
+ * It summarizes the unsummarized page ranges of the BRIN index (minmax
+ * opclasses only) by the GROUP BY query on the block range, to be processed
+ * by GpuPreAgg at storage speed. Only the ranges that consist of all-visible
+ * pages are summarized here, because the summary must cover the tuples that
+ * are invisible to this snapshot but visible to someone. The rest of ranges
+ * are summarized by brin_summarize_new_values() on CPU.
+ * The heap is locked in ShareLock during the GPU summarization, so no
+ * concurrent insertion needs the placeholder tuple.
+ */
+PG_FUNCTION_INFO_V1(pgstrom_brin_summarize_gpu);
+PUBLIC_FUNCTION(Datum)
+pgstrom_brin_summarize_gpu(PG_FUNCTION_ARGS)
+{
+	Oid			index_oid = PG_GETARG_OID(0);
+	Oid			heap_oid;
+	Relation	heap_rel;
+	Relation	index_rel;
+	BrinDesc   *bdesc;
+	BrinRevmap *revmap;
+	BlockNumber	pagesPerRange;
+	BlockNumber	nblocks;
+	Buffer		vmbuffer = InvalidBuffer;
+	Buffer		buffer = InvalidBuffer;
+	Buffer		ibuffer = InvalidBuffer;
+	BrinMemTuple *dtup;
+	SPIPlanPtr	plan;
+	Portal		portal;
+	StringInfoData buf;
+	char	   *relname;
+	int			natts;
+	int32		nsummarized = 0;
+
+	heap_oid = IndexGetRelation(index_oid, false);
+	heap_rel = table_open(heap_oid, ShareLock);
+	index_rel = index_open(index_oid, ShareUpdateExclusiveLock);
+	if (index_rel->rd_rel->relam != BRIN_AM_OID)
+		elog(ERROR, "\"%s\" is not a BRIN index",
+			 RelationGetRelationName(index_rel));
+#if PG_VERSION_NUM < 160000
+	if (!pg_class_ownercheck(index_oid, GetUserId()))
+#else
+	if (!object_ownercheck(RelationRelationId, index_oid, GetUserId()))
+#endif
+		aclcheck_error(ACLCHECK_NOT_OWNER, OBJECT_INDEX,
+					   RelationGetRelationName(index_rel));
+	if (IsolationUsesXactSnapshot())
+		elog(ERROR, "pgstrom.brin_summarize_gpu() must run in READ COMMITTED");
+	if (RelationGetIndexExpressions(index_rel) != NIL ||
+		RelationGetIndexPredicate(index_rel) != NIL)
+		elog(ERROR, "BRIN index \"%s\" has expressions or predicate",
+			 RelationGetRelationName(index_rel));
+	natts = RelationGetNumberOfAttributes(index_rel);
+	for (int j=1; j <= natts; j++)
+	{
+		if (index_getprocid(index_rel, j, BRIN_PROCNUM_OPCINFO) != F_BRIN_MINMAX_OPCINFO)
+			elog(ERROR, "BRIN index \"%s\" has non-minmax operator class",
+				 RelationGetRelationName(index_rel));
+	}
+	relname = quote_qualified_identifier(get_namespace_name(RelationGetNamespace(heap_rel)),
+										 RelationGetRelationName(heap_rel));
+	bdesc = brin_build_desc(index_rel);
+	revmap = brinRevmapInitialize(index_rel, &pagesPerRange, NULL);
+	nblocks = RelationGetNumberOfBlocks(heap_rel);
+
+	/* min/max/nulls of the columns for each block range */
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "SELECT pgstrom.tid_block_number(ctid) / %u, count(*)",
+					 pagesPerRange);
+	for (int j=0; j < natts; j++)
+	{
+		AttrNumber	anum = index_rel->rd_index->indkey.values[j];
+		const char *attname = quote_identifier(get_attname(heap_oid, anum, false));
+
+		appendStringInfo(&buf, ", count(%s), min(%s), max(%s)",
+						 attname, attname, attname);
+	}
+	appendStringInfo(&buf, " FROM ONLY %s GROUP BY 1", relname);
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "failed on SPI_connect");
+	plan = SPI_prepare(buf.data, 0, NULL);
+	if (!plan)
+		elog(ERROR, "failed on SPI_prepare: %s", buf.data);
+	portal = SPI_cursor_open(NULL, plan, NULL, NULL, false);
+	dtup = brin_new_memtuple(bdesc);
+	for (;;)
+	{
+		SPI_cursor_fetch(portal, true, 10000);
+		if (SPI_processed == 0)
+			break;
+		for (uint64 i=0; i < SPI_processed; i++)
+		{
+			HeapTuple	tuple = SPI_tuptable->vals[i];
+			TupleDesc	tupdesc = SPI_tuptable->tupdesc;
+			BlockNumber	heapBlk;
+			BrinTuple  *btup;
+			OffsetNumber off;
+			Size		size;
+			Datum		datum;
+			bool		isnull;
+			int64		nrows;
+			bool		all_visible = true;
+			MemoryContext oldcxt;
+
+			CHECK_FOR_INTERRUPTS();
+			datum = SPI_getbinval(tuple, tupdesc, 1, &isnull);
+			Assert(!isnull);
+			heapBlk = DatumGetInt64(datum) * pagesPerRange;
+			/* skip the ranges already summarized */
+			btup = brinGetTupleForHeapBlock(revmap, heapBlk, &buffer, &off,
+											&size, BUFFER_LOCK_SHARE, NULL);
+			if (btup)
+			{
+				LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
+				continue;
+			}
+			for (BlockNumber k=0; k < pagesPerRange && heapBlk + k < nblocks; k++)
+			{
+				if ((visibilitymap_get_status(heap_rel, heapBlk + k,
+											  &vmbuffer) & VISIBILITYMAP_ALL_VISIBLE) == 0)
+				{
+					all_visible = false;
+					break;
+				}
+			}
+			if (!all_visible)
+				continue;
+
+			dtup = brin_memtuple_initialize(dtup, bdesc);
+			oldcxt = MemoryContextSwitchTo(dtup->bt_context);
+			nrows = DatumGetInt64(SPI_getbinval(tuple, tupdesc, 2, &isnull));
+			for (int j=0; j < natts; j++)
+			{
+				BrinValues *bval = &dtup->bt_columns[j];
+				Form_pg_attribute attr = TupleDescAttr(bdesc->bd_tupdesc, j);
+				int64		nvalues;
+
+				nvalues = DatumGetInt64(SPI_getbinval(tuple, tupdesc,
+													  3 * j + 3, &isnull));
+				bval->bv_hasnulls = (nvalues < nrows);
+				bval->bv_allnulls = (nvalues == 0);
+				if (nvalues > 0)
+				{
+					datum = SPI_getbinval(tuple, tupdesc, 3 * j + 4, &isnull);
+					bval->bv_values[0] = datumCopy(datum, attr->attbyval,
+												   attr->attlen);
+					datum = SPI_getbinval(tuple, tupdesc, 3 * j + 5, &isnull);
+					bval->bv_values[1] = datumCopy(datum, attr->attbyval,
+												   attr->attlen);
+				}
+			}
+#if PG_VERSION_NUM >= 160000
+			dtup->bt_empty_range = false;
+#endif
+			btup = brin_form_tuple(bdesc, heapBlk, dtup, &size);
+			MemoryContextSwitchTo(oldcxt);
+			brin_doinsert(index_rel, pagesPerRange, revmap, &ibuffer,
+						  heapBlk, btup, size);
+			nsummarized++;
+		}
+		SPI_freetuptable(SPI_tuptable);
+	}
+	SPI_cursor_close(portal);
+	SPI_freeplan(plan);
+	SPI_finish();
+
+	if (BufferIsValid(vmbuffer))
+		ReleaseBuffer(vmbuffer);
+	if (BufferIsValid(buffer))
+		ReleaseBuffer(buffer);
+	if (BufferIsValid(ibuffer))
+		ReleaseBuffer(ibuffer);
+	brinRevmapTerminate(revmap);
+	brin_free_desc(bdesc);
+	index_close(index_rel, NoLock);
+	table_close(heap_rel, NoLock);
+	pfree(buf.data);
+
+	/* the rest of ranges by CPU */
+	nsummarized += DatumGetInt32(DirectFunctionCall1(brin_summarize_new_values,
+													 ObjectIdGetDatum(index_oid)));
+	PG_RETURN_INT32(nsummarized);
+}
+
 void
 pgstrom_init_brin(void)
 {
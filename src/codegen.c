@@ -20,6 +20,8 @@ static List	   *devtype_info_slot[DEVTYPE_INFO_NSLOTS];
 static List	   *devfunc_info_slot[DEVFUNC_INFO_NSLOTS];
 static HTAB	   *devtype_rev_htable = NULL;		/* lookup by TypeOpCode */
 static HTAB	   *devfunc_rev_htable = NULL;		/* lookup by FuncOpCode */
+static int		pgstrom_saop_hash_threshold;	/* GUC */
+static bool	pgstrom_enable_codegen_cse;		/* GUC */
 
 /* -------- static declarations -------- */
 #define TYPE_OPCODE(NAME,EXTENSION,FLAGS)								\
@@ -48,18 +50,26 @@ static struct {
 	{NULL, NULL, TypeOpCode__Invalid, 0, NULL, 0, 0}
 };
 
-static struct {
+typedef struct {
 	const char *type_name;
 	const char *type_extension;
 	const char *base_name;
 	const char *base_extension;
-} devtype_alias_catalog[] = {
+} devtype_alias_entry;
+
+static devtype_alias_entry devtype_alias_catalog[] = {
 #define TYPE_ALIAS(NAME,EXTENSION,BASE,BASE_EXTENSION)	\
 	{#NAME, EXTENSION, #BASE, BASE_EXTENSION},
 #include "xpu_opcodes.h"
 	{NULL,NULL,NULL,NULL}
 };
 
+/* device types/functions registered by extensions */
+static devtype_alias_entry *devtype_user_alias_catalog = NULL;
+static int		devtype_user_alias_nitems = 0;
+static pgstromUserDevFunc *devfunc_user_catalog = NULL;
+static int		devfunc_user_nitems = 0;
+
 static void	__appendKernExpMagicAndLength(StringInfo buf, int head_pos);
 static int	codegen_expression_walker(codegen_context *context,
 									  StringInfo buf,
@@ -357,11 +367,36 @@ found:
 	return type_oid;
 }
 
+static bool
+__devtype_match_alias(devtype_alias_entry *alias,
+					  TypeCacheEntry *tcache,
+					  const char *type_name,
+					  const char *ext_name)
+{
+	if (strcmp(type_name, alias->type_name) != 0)
+		return false;
+	if (alias->type_extension != NULL)
+	{
+		if (!ext_name || strcmp(ext_name, alias->type_extension) != 0)
+			return false;
+	}
+	else
+	{
+		Oid		namespace_oid = get_type_namespace(tcache->type_id);
+
+		if (namespace_oid != PG_CATALOG_NAMESPACE)
+			return false;
+	}
+	return true;
+}
+
 static TypeCacheEntry *
 __devtype_resolve_alias(TypeCacheEntry *tcache)
 {
+	devtype_alias_entry *alias = NULL;
 	const char	   *type_name;
 	const char	   *ext_name;
+	Oid				__type_oid;
 
 	/* check alias list */
 	type_name = get_type_name(tcache->type_id, false);
@@ -369,35 +404,30 @@ __devtype_resolve_alias(TypeCacheEntry *tcache)
 											tcache->type_id);
 	for (int i=0; devtype_alias_catalog[i].type_name != NULL; i++)
 	{
-		Oid			__type_oid;
-		const char *__type_name = devtype_alias_catalog[i].type_name;
-		const char *__ext_name = devtype_alias_catalog[i].type_extension;
-
-		if (strcmp(type_name, __type_name) != 0)
-			continue;
-		if (__ext_name != NULL)
-		{
-			if (!ext_name || strcmp(ext_name, __ext_name) != 0)
-				continue;
-		}
-		else
+		if (__devtype_match_alias(&devtype_alias_catalog[i],
+								  tcache, type_name, ext_name))
 		{
-			Oid		namespace_oid = get_type_namespace(tcache->type_id);
-
-			if (namespace_oid != PG_CATALOG_NAMESPACE)
-				continue;
+			alias = &devtype_alias_catalog[i];
+			break;
 		}
-		/* Hmm... it looks this type is alias of the base */
-		__type_oid = get_typeoid_by_name(devtype_alias_catalog[i].base_name,
-										 devtype_alias_catalog[i].base_extension);
-		if (!OidIsValid(__type_oid))
-			return NULL;
-		tcache = lookup_type_cache(__type_oid,
-								   TYPECACHE_EQ_OPR |
-								   TYPECACHE_CMP_PROC);
-		return __devtype_resolve_alias(tcache);
 	}
-	return tcache;
+	for (int i=0; !alias && i < devtype_user_alias_nitems; i++)
+	{
+		if (__devtype_match_alias(&devtype_user_alias_catalog[i],
+								  tcache, type_name, ext_name))
+			alias = &devtype_user_alias_catalog[i];
+	}
+	if (!alias)
+		return tcache;
+	/* Hmm... it looks this type is alias of the base */
+	__type_oid = get_typeoid_by_name(alias->base_name,
+									 alias->base_extension);
+	if (!OidIsValid(__type_oid))
+		return NULL;
+	tcache = lookup_type_cache(__type_oid,
+							   TYPECACHE_EQ_OPR |
+							   TYPECACHE_CMP_PROC);
+	return __devtype_resolve_alias(tcache);
 }
 
 devtype_info *
@@ -787,6 +817,18 @@ devtype_macaddr_hash(bool isnull, Datum value)
 	return 0;
 }
 
+static uint32_t
+devtype_tid_hash(bool isnull, Datum value)
+{
+	if (!isnull)
+	{
+		ItemPointer	ip = (ItemPointer) DatumGetPointer(value);
+
+		return hash_any((unsigned char *)ip, sizeof(ItemPointerData));
+	}
+	return 0;
+}
+
 static uint32_t
 devtype_inet_hash(bool isnull, Datum value)
 {
@@ -908,6 +950,14 @@ devtype_cube_hash(bool isnull, Datum value)
 	return hash_any((unsigned char *)VARDATA_ANY(value), VARSIZE_ANY_EXHDR(value));
 }
 
+static uint32_t
+devtype_vector_hash(bool isnull, Datum value)
+{
+	if (isnull)
+		return 0;
+	return hash_any((unsigned char *)VARDATA_ANY(value), VARSIZE_ANY_EXHDR(value));
+}
+
 /*
  * Built-in device functions/operators
  */
@@ -927,6 +977,91 @@ static struct {
 	{NULL,NULL,0,FuncOpCode__Invalid,0,NULL}
 };
 
+/*
+ * __devfunc_match_args
+ *
+ * It checks whether the argument types of the catalog entry ("TYPE/TYPE")
+ * matches to the actual arguments.
+ */
+static bool
+__devfunc_match_args(StringInfo buf, const char *func_args,
+					 int func_nargs, Oid *func_argtypes,
+					 devtype_info **dtype_argtypes)
+{
+	char	   *tok, *saveptr;
+	int			j, sz;
+
+	resetStringInfo(buf);
+	appendStringInfoString(buf, func_args);
+	for (tok = strtok_r(buf->data, "/", &saveptr), j=0;
+		 tok != NULL && j < func_nargs;
+		 tok = strtok_r(NULL, "/", &saveptr), j++)
+	{
+		devtype_info *dtype = dtype_argtypes[j];
+
+		tok = __trim(tok);
+		sz = strlen(tok);
+		if (sz > 4 &&
+			tok[0] == '_' && tok[1] == '_' &&
+			tok[sz-1] == '_' && tok[sz-2] == '_')
+		{
+			/* __TYPE__ means variable length argument! */
+			tok[sz-1] = '\0';
+			if (strcmp(tok+2, dtype->type_name) != 0)
+				break;
+			/* must be the last argument set */
+			tok = strtok_r(NULL, "/", &saveptr);
+			if (tok)
+				break;
+			/* check whether the following arguments are identical */
+			while (j < func_nargs)
+			{
+				if (dtype->type_oid != func_argtypes[j])
+					break;
+				j++;
+			}
+		}
+		else
+		{
+			if (strcmp(tok, dtype->type_name) != 0)
+				break;
+		}
+	}
+	return (!tok && j == func_nargs);
+}
+
+static devfunc_info *
+__devfunc_build_entry(FuncOpCode func_code,
+					  uint32_t func_flags,
+					  int func_cost,
+					  const char *fextension,
+					  const char *fname,
+					  Oid func_oid,
+					  devtype_info *dtype_rettype,
+					  int func_nargs,
+					  devtype_info **dtype_argtypes)
+{
+	MemoryContext oldcxt = MemoryContextSwitchTo(devinfo_memcxt);
+	devfunc_info *dfunc;
+
+	dfunc = palloc0(offsetof(devfunc_info,
+							 func_argtypes[func_nargs]));
+	dfunc->func_code = func_code;
+	if (fextension)
+		dfunc->func_extension = pstrdup(fextension);
+	dfunc->func_name = pstrdup(fname);
+	dfunc->func_oid = func_oid;
+	dfunc->func_rettype = dtype_rettype;
+	dfunc->func_flags = func_flags;
+	dfunc->func_cost = func_cost;
+	dfunc->func_nargs = func_nargs;
+	memcpy(dfunc->func_argtypes, dtype_argtypes,
+		   sizeof(devtype_info *) * func_nargs);
+	MemoryContextSwitchTo(oldcxt);
+
+	return dfunc;
+}
+
 static devfunc_info *
 pgstrom_devfunc_build(Oid func_oid, int func_nargs, Oid *func_argtypes)
 {
@@ -938,8 +1073,7 @@ pgstrom_devfunc_build(Oid func_oid, int func_nargs, Oid *func_argtypes)
 	devfunc_info   *dfunc = NULL;
 	devtype_info   *dtype_rettype;
 	devtype_info  **dtype_argtypes;
-	MemoryContext	oldcxt;
-	int				i, j, sz;
+	int				i, j;
 
 	initStringInfo(&buf);
 	fname = get_func_name(func_oid);
@@ -966,7 +1100,6 @@ pgstrom_devfunc_build(Oid func_oid, int func_nargs, Oid *func_argtypes)
 	{
 		const char *__extension = devfunc_catalog[i].func_extension;
 		const char *__name = devfunc_catalog[i].func_name;
-		char	   *tok, *saveptr;
 
 		if (fextension != NULL
 			? (__extension == NULL || strcmp(fextension, __extension) != 0)
@@ -975,61 +1108,39 @@ pgstrom_devfunc_build(Oid func_oid, int func_nargs, Oid *func_argtypes)
 		if (strcmp(fname, __name) != 0)
 			continue;
 
-		resetStringInfo(&buf);
-		appendStringInfoString(&buf, devfunc_catalog[i].func_args);
-		for (tok = strtok_r(buf.data, "/", &saveptr), j=0;
-			 tok != NULL && j < func_nargs;
-			 tok = strtok_r(NULL, "/", &saveptr), j++)
+		/* Ok, found an entry */
+		if (__devfunc_match_args(&buf, devfunc_catalog[i].func_args,
+								 func_nargs, func_argtypes,
+								 dtype_argtypes))
 		{
-			devtype_info *dtype = dtype_argtypes[j];
-
-			tok = __trim(tok);
-			sz = strlen(tok);
-			if (sz > 4 &&
-				tok[0] == '_' && tok[1] == '_' &&
-				tok[sz-1] == '_' && tok[sz-2] == '_')
-			{
-				/* __TYPE__ means variable length argument! */
-				tok[sz-1] = '\0';
-				if (strcmp(tok+2, dtype->type_name) != 0)
-					break;
-				/* must be the last argument set */
-				tok = strtok_r(NULL, "/", &saveptr);
-				if (tok)
-					break;
-				/* check whether the following arguments are identical */
-				while (j < func_nargs)
-				{
-					if (dtype->type_oid != func_argtypes[j])
-						break;
-					j++;
-				}
-			}
-			else
-			{
-				if (strcmp(tok, dtype->type_name) != 0)
-					break;
-			}
+			dfunc = __devfunc_build_entry(devfunc_catalog[i].func_code,
+										  devfunc_catalog[i].func_flags,
+										  devfunc_catalog[i].func_cost,
+										  fextension, fname, func_oid,
+										  dtype_rettype,
+										  func_nargs, dtype_argtypes);
+			goto bailout;
 		}
+	}
 
-		/* Ok, found an entry */
-		if (!tok && j == func_nargs)
+	/* elsewhere, device functions registered by extensions */
+	for (i=0; fextension != NULL && i < devfunc_user_nitems; i++)
+	{
+		pgstromUserDevFunc *ufunc = &devfunc_user_catalog[i];
+
+		if (strcmp(fextension, ufunc->func_extension) != 0 ||
+			strcmp(fname, ufunc->func_name) != 0)
+			continue;
+		if (__devfunc_match_args(&buf, ufunc->func_args,
+								 func_nargs, func_argtypes,
+								 dtype_argtypes))
 		{
-			oldcxt = MemoryContextSwitchTo(devinfo_memcxt);
-			dfunc = palloc0(offsetof(devfunc_info,
-									 func_argtypes[func_nargs]));
-			dfunc->func_code = devfunc_catalog[i].func_code;
-			if (fextension)
-				dfunc->func_extension = pstrdup(fextension);
-			dfunc->func_name = pstrdup(fname);
-			dfunc->func_oid = func_oid;
-			dfunc->func_rettype = dtype_rettype;
-			dfunc->func_flags = devfunc_catalog[i].func_flags;
-			dfunc->func_cost = devfunc_catalog[i].func_cost;
-			dfunc->func_nargs = func_nargs;
-			memcpy(dfunc->func_argtypes, dtype_argtypes,
-				   sizeof(devtype_info *) * func_nargs);
-			MemoryContextSwitchTo(oldcxt);
+			dfunc = __devfunc_build_entry(ufunc->func_code,
+										  ufunc->func_flags,
+										  ufunc->func_cost,
+										  fextension, fname, func_oid,
+										  dtype_rettype,
+										  func_nargs, dtype_argtypes);
 			break;
 		}
 	}
@@ -1044,6 +1155,219 @@ typedef struct {
 	Oid		func_argtypes[1];
 } devfunc_cache_signature;
 
+/*
+ * pgstrom_register_device_function
+ *
+ * It allows extensions to supply their own device functions. The CUDA
+ * source shall define a __device__ variable of xpu_function_t (named by
+ * the cuda_symbol) that points the device function; it is compiled and
+ * linked to the GPU module at the startup of GPU-Service.
+ */
+FuncOpCode
+pgstrom_register_device_function(const pgstromUserDevFunc *ufunc)
+{
+	MemoryContext oldcxt;
+	pgstromUserDevFunc *entry;
+	char	   *signature;
+	FuncOpCode	func_code;
+
+	if (!process_shared_preload_libraries_in_progress)
+		elog(ERROR, "device function must be registered at shared_preload_libraries");
+	if (!ufunc->func_extension || !ufunc->func_name || !ufunc->func_args)
+		elog(ERROR, "device function must have extension, name and arguments");
+	if ((ufunc->func_flags & DEVKIND__NVIDIA_GPU) != 0 &&
+		(!ufunc->cuda_source || !ufunc->cuda_symbol))
+		elog(ERROR, "device function '%s' has no CUDA source or symbol",
+			 ufunc->func_name);
+	if (ufunc->cuda_source && !is_absolute_path(ufunc->cuda_source))
+		elog(ERROR, "CUDA source of device function '%s' must be absolute path",
+			 ufunc->func_name);
+	if ((ufunc->func_flags & DEVKIND__ANY) == 0)
+		elog(ERROR, "device function '%s' is not available on any devices",
+			 ufunc->func_name);
+
+	oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+	signature = psprintf("%s.%s(%s)",
+						 ufunc->func_extension,
+						 ufunc->func_name,
+						 ufunc->func_args);
+	func_code = xpu_user_function_opcode(signature);
+	for (int i=0; i < devfunc_user_nitems; i++)
+	{
+		if (devfunc_user_catalog[i].func_code == func_code)
+			elog(ERROR, "device function '%s' conflicts to '%s'",
+				 signature, devfunc_user_catalog[i].func_signature);
+	}
+	if (!devfunc_user_catalog)
+		devfunc_user_catalog = palloc(sizeof(pgstromUserDevFunc));
+	else
+		devfunc_user_catalog = repalloc(devfunc_user_catalog,
+										sizeof(pgstromUserDevFunc) *
+										(devfunc_user_nitems + 1));
+	entry = &devfunc_user_catalog[devfunc_user_nitems++];
+	entry->func_extension = pstrdup(ufunc->func_extension);
+	entry->func_name = pstrdup(ufunc->func_name);
+	entry->func_args = pstrdup(ufunc->func_args);
+	entry->func_flags = ufunc->func_flags;
+	entry->func_cost = ufunc->func_cost;
+	entry->cuda_source = (ufunc->cuda_source ? pstrdup(ufunc->cuda_source) : NULL);
+	entry->cuda_symbol = (ufunc->cuda_symbol ? pstrdup(ufunc->cuda_symbol) : NULL);
+	entry->func_signature = signature;
+	entry->func_code = func_code;
+	MemoryContextSwitchTo(oldcxt);
+
+	elog(LOG, "pg_strom: device function '%s' was registered (opcode: 0x%08x)",
+		 signature, (uint32_t)func_code);
+	return func_code;
+}
+
+/*
+ * pgstrom_register_device_type_alias
+ *
+ * It allows extensions to declare their data types have identical binary
+ * representation to the existing device type; e.g, a fixed-length type
+ * stored as int8.
+ */
+void
+pgstrom_register_device_type_alias(const char *type_extension,
+								   const char *type_name,
+								   const char *base_extension,
+								   const char *base_name)
+{
+	MemoryContext oldcxt;
+	devtype_alias_entry *entry;
+
+	if (!process_shared_preload_libraries_in_progress)
+		elog(ERROR, "device type must be registered at shared_preload_libraries");
+	if (!type_extension || !type_name || !base_name)
+		elog(ERROR, "device type alias must have extension, name and base type");
+
+	oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+	if (!devtype_user_alias_catalog)
+		devtype_user_alias_catalog = palloc(sizeof(devtype_alias_entry));
+	else
+		devtype_user_alias_catalog = repalloc(devtype_user_alias_catalog,
+											  sizeof(devtype_alias_entry) *
+											  (devtype_user_alias_nitems + 1));
+	entry = &devtype_user_alias_catalog[devtype_user_alias_nitems++];
+	entry->type_name = pstrdup(type_name);
+	entry->type_extension = pstrdup(type_extension);
+	entry->base_name = pstrdup(base_name);
+	entry->base_extension = (base_extension ? pstrdup(base_extension) : NULL);
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * pgstrom_user_devfunc_catalog
+ */
+const pgstromUserDevFunc *
+pgstrom_user_devfunc_catalog(int *p_nitems)
+{
+	*p_nitems = devfunc_user_nitems;
+	return devfunc_user_catalog;
+}
+
+/*
+ * __collation_libc_locale
+ *
+ * It returns the LC_COLLATE or LC_CTYPE locale name of the collation, if
+ * it is provided by libc. Elsewhere, NULL shall be returned.
+ */
+static char *
+__collation_libc_locale(Oid collid, bool is_ctype)
+{
+	HeapTuple	tup;
+	char		provider;
+	char	   *locale = NULL;
+	Datum		datum;
+	bool		isnull;
+
+	if (collid == DEFAULT_COLLATION_OID)
+	{
+		tup = SearchSysCache1(DATABASEOID, ObjectIdGetDatum(MyDatabaseId));
+		if (!HeapTupleIsValid(tup))
+			elog(ERROR, "cache lookup failed for database %u", MyDatabaseId);
+		provider = ((Form_pg_database) GETSTRUCT(tup))->datlocprovider;
+		datum = SysCacheGetAttr(DATABASEOID, tup,
+								is_ctype
+								? Anum_pg_database_datctype
+								: Anum_pg_database_datcollate, &isnull);
+	}
+	else
+	{
+		tup = SearchSysCache1(COLLOID, ObjectIdGetDatum(collid));
+		if (!HeapTupleIsValid(tup))
+			elog(ERROR, "cache lookup failed for collation %u", collid);
+		provider = ((Form_pg_collation) GETSTRUCT(tup))->collprovider;
+		datum = SysCacheGetAttr(COLLOID, tup,
+								is_ctype
+								? Anum_pg_collation_collctype
+								: Anum_pg_collation_collcollate, &isnull);
+	}
+	if (provider == COLLPROVIDER_LIBC && !isnull)
+		locale = TextDatumGetCString(datum);
+	ReleaseSysCache(tup);
+
+	return locale;
+}
+
+/*
+ * __collation_is_bytewise
+ *
+ * The device compares text-like values by memcmp(), so locale aware
+ * functions are available only when the collation orders strings in
+ * byte-order. In addition to "C" and "POSIX", the libc's "C.UTF-8" sorts
+ * strings by the code-point, thus it is equivalent to the byte-order on
+ * the UTF-8 database.
+ */
+static bool
+__collation_is_bytewise(Oid collid)
+{
+	char	   *locale;
+	bool		retval = false;
+
+	if (lc_collate_is_c(collid))
+		return true;
+	if (GetDatabaseEncoding() != PG_UTF8)
+		return false;
+	locale = __collation_libc_locale(collid, false);
+	if (locale)
+	{
+		if (pg_strcasecmp(locale, "C.UTF-8") == 0 ||
+			pg_strcasecmp(locale, "C.utf8") == 0)
+			retval = true;
+		pfree(locale);
+	}
+	return retval;
+}
+
+/*
+ * __collation_ctype_is_unicode
+ *
+ * lower()/upper() under the libc locales on the UTF-8 database follow
+ * towlower()/towupper(); the device implements its simple case mapping.
+ * Turkish and Azerbaijani locales have the special mapping of 'I', so
+ * they are not supported.
+ */
+static bool
+__collation_ctype_is_unicode(Oid collid)
+{
+	char	   *locale;
+	bool		retval = false;
+
+	if (GetDatabaseEncoding() != PG_UTF8)
+		return false;
+	locale = __collation_libc_locale(collid, true);
+	if (locale)
+	{
+		if (pg_strncasecmp(locale, "tr", 2) != 0 &&
+			pg_strncasecmp(locale, "az", 2) != 0)
+			retval = true;
+		pfree(locale);
+	}
+	return retval;
+}
+
 static devfunc_info *
 __pgstrom_devfunc_lookup(Oid func_oid,
 						 int func_nargs,
@@ -1124,7 +1448,15 @@ found:
 		(dfunc->func_flags & DEVFUNC__LOCALE_AWARE) != 0)
 	{
 		/* see texteq, bpchareq */
-		if (!lc_collate_is_c(func_collid))
+		if (!__collation_is_bytewise(func_collid))
+			return NULL;	/* not supported */
+	}
+	if (OidIsValid(func_collid) &&
+		(dfunc->func_flags & DEVFUNC__LOCALE_CTYPE) != 0)
+	{
+		/* see lower, upper */
+		if (!lc_ctype_is_c(func_collid) &&
+			!__collation_ctype_is_unicode(func_collid))
 			return NULL;	/* not supported */
 	}
 	return dfunc;
@@ -1218,6 +1550,17 @@ devfunc_get_name_by_opcode(FuncOpCode func_code, bool *p_device_only)
 				goto found;
 			}
 		}
+
+		for (int i=0; i < devfunc_user_nitems; i++)
+		{
+			if (devfunc_user_catalog[i].func_code == func_code)
+			{
+				entry->is_valid    = true;
+				entry->device_only = false;
+				entry->dfunc_name  = devfunc_user_catalog[i].func_name;
+				goto found;
+			}
+		}
 		entry->is_valid   = false;
 		entry->dfunc_name = NULL;
 	}
@@ -1611,6 +1954,8 @@ found:
  */
 #define __Elog(fmt,...)													\
 	do {																\
+		if (offload_advisor_enabled)									\
+			__offload_advisor_record(context, fmt, ##__VA_ARGS__);		\
 		ereport(context->elevel,										\
 				(errcode(ERRCODE_INTERNAL_ERROR),						\
 				 errmsg("(%s:%d) " fmt,	__FUNCTION__, __LINE__,			\
@@ -1620,6 +1965,77 @@ found:
 		return -1;														\
 	} while(0)
 
+/*
+ * GPU offload advisor
+ *
+ * While pgstrom.explain_offload() plans the supplied query, __Elog() above
+ * also records the reason why the expression is not executable on the
+ * device, instead of the DEBUG2 message that nobody reads.
+ */
+typedef struct
+{
+	uint32_t	devkind;
+	char	   *reason;
+	int			count;
+} offloadAdvisorItem;
+
+static bool			offload_advisor_enabled = false;
+static List		   *offload_advisor_items = NIL;
+static MemoryContext offload_advisor_memcxt = NULL;
+
+static void	__offload_advisor_record(codegen_context *context,
+									 const char *fmt, ...) pg_attribute_printf(2,3);
+static void
+__offload_advisor_record(codegen_context *context, const char *fmt, ...)
+{
+	MemoryContext oldcxt = MemoryContextSwitchTo(offload_advisor_memcxt);
+	uint32_t	devkind = (context->xpu_task_flags & DEVKIND__ANY);
+	offloadAdvisorItem *item;
+	StringInfoData buf;
+	char	   *pos;
+	ListCell   *lc;
+
+	initStringInfo(&buf);
+	for (;;)
+	{
+		va_list		va_args;
+		int			needed;
+
+		va_start(va_args, fmt);
+		needed = appendStringInfoVA(&buf, fmt, va_args);
+		va_end(va_args);
+		if (needed == 0)
+			break;
+		enlargeStringInfo(&buf, needed);
+	}
+	/* node dump is too verbose to aggregate, so keep the node tag only */
+	pos = strchr(buf.data, '{');
+	if (pos)
+	{
+		pos += strcspn(pos, " }");
+		*pos++ = '}';
+		*pos = '\0';
+	}
+	foreach (lc, offload_advisor_items)
+	{
+		item = lfirst(lc);
+		if (item->devkind == devkind &&
+			strcmp(item->reason, buf.data) == 0)
+		{
+			item->count++;
+			pfree(buf.data);
+			goto out;
+		}
+	}
+	item = palloc0(sizeof(offloadAdvisorItem));
+	item->devkind = devkind;
+	item->reason = buf.data;
+	item->count = 1;
+	offload_advisor_items = lappend(offload_advisor_items, item);
+out:
+	MemoryContextSwitchTo(oldcxt);
+}
+
 codegen_context *
 create_codegen_context(PlannerInfo *root,
 					   CustomPath *cpath,
@@ -1638,6 +2054,7 @@ create_codegen_context(PlannerInfo *root,
 	context->kvecs_ndims = pp_info->num_rels + 1;
 	context->kvecs_usage = 0;
 	context->scan_relid = pp_info->scan_relid;
+	context->gcache_vcols = pp_info->gpu_cache_vcols;
 	context->num_rels = pp_info->num_rels;
 	Assert(pp_info->num_rels == list_length(cpath->custom_paths));
 	foreach (lc, cpath->custom_paths)
@@ -1765,18 +2182,12 @@ codegen_param_expression(codegen_context *context,
 	return 0;
 }
 
-static int
-codegen_var_expression(codegen_context *context,
-					   StringInfo buf,
-					   int curr_depth,
-					   Var *var)
+static void
+__codegen_kvar_reference(codegen_context *context,
+						 StringInfo buf,
+						 int curr_depth,
+						 codegen_kvar_defitem *kvdef)
 {
-	codegen_kvar_defitem *kvdef;
-
-	kvdef = lookup_input_varnode_defitem(context,
-										 var,
-										 curr_depth,
-										 false);
 	if (buf)
 	{
 		kern_expression kexp;
@@ -1802,49 +2213,1623 @@ codegen_var_expression(codegen_context *context,
 		pos = __appendBinaryStringInfo(buf, &kexp, SizeOfKernExprVar);
 		__appendKernExpMagicAndLength(buf, pos);
 	}
-	return 0;
 }
 
 static int
-__codegen_func_expression(codegen_context *context,
-						  StringInfo buf,
-						  int curr_depth,
-						  Oid func_oid,
-						  List *func_args,
-						  Oid func_collid)
+codegen_var_expression(codegen_context *context,
+					   StringInfo buf,
+					   int curr_depth,
+					   Var *var)
 {
-	devfunc_info   *dfunc;
-	devtype_info   *dtype;
-	kern_expression	kexp;
-	int				pos = -1;
-	ListCell	   *lc;
-
-	dfunc = pgstrom_devfunc_lookup(func_oid, func_args, func_collid);
-	if (!dfunc ||
-		(dfunc->func_flags & context->xpu_task_flags & DEVKIND__ANY) == 0)
-		__Elog("function %s is not supported on the target device",
-			   format_procedure(func_oid));
-	dtype = dfunc->func_rettype;
-	context->device_cost += dfunc->func_cost;
+	codegen_kvar_defitem *kvdef;
 
-	memset(&kexp, 0, sizeof(kexp));
-	kexp.exptype = dtype->type_code;
-	kexp.expflags = context->kexp_flags;
-	kexp.opcode = dfunc->func_code;
-	kexp.nr_args = list_length(func_args);
-	kexp.args_offset = SizeOfKernExpr(0);
-	if (buf)
-		pos = __appendBinaryStringInfo(buf, &kexp, SizeOfKernExpr(0));
-	foreach (lc, func_args)
-	{
-		Expr   *arg = lfirst(lc);
+	kvdef = lookup_input_varnode_defitem(context,
+										 var,
+										 curr_depth,
+										 false);
+	__codegen_kvar_reference(context, buf, curr_depth, kvdef);
+	return 0;
+}
 
-		if (codegen_expression_walker(context, buf, curr_depth, arg) < 0)
+/* ----------------------------------------------------------------
+ *
+ * DFA compiler for regular expression and LIKE pattern
+ *
+ * If pattern of the regular expression (or LIKE with many '%') is
+ * a constant, we compile it to a byte-level DFA transition table on
+ * the host side, then xPU runs a simple table-driven matcher without
+ * backtrack or recursion.
+ * It supports a subset of the ARE syntax; literals, '.', bracket
+ * expressions of the single-byte characters, grouping, alternation,
+ * quantifiers and anchors at the head/tail of the pattern. Any other
+ * patterns are not compiled, and they run on the CPU as usual.
+ *
+ * ----------------------------------------------------------------
+ */
+#define REGEX_NFA_MAX_NSTATES		4000
+#define REGEX_DFA_MAX_NSTATES		255
+#define REGEX_MAX_REPEAT			32
+
+typedef struct
+{
+	int			next1;		/* epsilon or byte transition, -1 if none */
+	int			next2;		/* epsilon transition, -1 if none */
+	bool		has_bytes;	/* next1 is byte transition */
+	bits8		bytes[32];
+} regexNfaState;
+
+typedef struct
+{
+	int			head;
+	int			tail;
+} regexNfaFrag;
+
+typedef struct
+{
+	const char *pattern;
+	int			length;
+	int			pos;
+	bool		icase;		/* case insensitive (ASCII only) */
+	bool		utf8;		/* UTF-8 database encoding */
+	bool		has_toplevel_alt;
+	int			nstates;
+	regexNfaState states[REGEX_NFA_MAX_NSTATES];
+} regexNfaContext;
+
+#define __regexBytesSet(bytes,c)	((bytes)[(uint8_t)(c) >> 3] |= (1 << ((uint8_t)(c) & 7)))
+#define __regexBytesTest(bytes,c)	(((bytes)[(uint8_t)(c) >> 3] & (1 << ((uint8_t)(c) & 7))) != 0)
+
+static int
+__regexNfaNewState(regexNfaContext *ctx)
+{
+	regexNfaState *nfa;
+
+	if (ctx->nstates >= REGEX_NFA_MAX_NSTATES)
+		return -1;
+	nfa = &ctx->states[ctx->nstates];
+	memset(nfa, 0, sizeof(regexNfaState));
+	nfa->next1 = -1;
+	nfa->next2 = -1;
+	return ctx->nstates++;
+}
+
+static bool
+__regexNfaFragEmpty(regexNfaContext *ctx, regexNfaFrag *frag)
+{
+	int		s = __regexNfaNewState(ctx);
+
+	if (s < 0)
+		return false;
+	frag->head = frag->tail = s;
+	return true;
+}
+
+static bool
+__regexNfaFragBytes(regexNfaContext *ctx, const bits8 *bytes,
+					regexNfaFrag *frag)
+{
+	int		s = __regexNfaNewState(ctx);
+	int		e = __regexNfaNewState(ctx);
+
+	if (s < 0 || e < 0)
+		return false;
+	ctx->states[s].has_bytes = true;
+	ctx->states[s].next1 = e;
+	memcpy(ctx->states[s].bytes, bytes, 32);
+	frag->head = s;
+	frag->tail = e;
+	return true;
+}
+
+static bool
+__regexNfaFragByteRange(regexNfaContext *ctx, int lo, int hi,
+						regexNfaFrag *frag)
+{
+	bits8	bytes[32];
+
+	memset(bytes, 0, sizeof(bytes));
+	for (int c=lo; c <= hi; c++)
+		__regexBytesSet(bytes, c);
+	return __regexNfaFragBytes(ctx, bytes, frag);
+}
+
+static void
+__regexNfaConcat(regexNfaContext *ctx, regexNfaFrag *a, regexNfaFrag *b)
+{
+	Assert(ctx->states[a->tail].next1 < 0);
+	ctx->states[a->tail].next1 = b->head;
+	a->tail = b->tail;
+}
+
+static bool
+__regexNfaAlt(regexNfaContext *ctx, regexNfaFrag *a, regexNfaFrag *b)
+{
+	int		s = __regexNfaNewState(ctx);
+	int		e = __regexNfaNewState(ctx);
+
+	if (s < 0 || e < 0)
+		return false;
+	ctx->states[s].next1 = a->head;
+	ctx->states[s].next2 = b->head;
+	ctx->states[a->tail].next1 = e;
+	ctx->states[b->tail].next1 = e;
+	a->head = s;
+	a->tail = e;
+	return true;
+}
+
+static bool
+__regexNfaStar(regexNfaContext *ctx, regexNfaFrag *a)
+{
+	int		s = __regexNfaNewState(ctx);
+	int		e = __regexNfaNewState(ctx);
+
+	if (s < 0 || e < 0)
+		return false;
+	ctx->states[s].next1 = a->head;
+	ctx->states[s].next2 = e;
+	ctx->states[a->tail].next1 = a->head;
+	ctx->states[a->tail].next2 = e;
+	a->head = s;
+	a->tail = e;
+	return true;
+}
+
+static bool
+__regexNfaPlus(regexNfaContext *ctx, regexNfaFrag *a)
+{
+	int		e = __regexNfaNewState(ctx);
+
+	if (e < 0)
+		return false;
+	ctx->states[a->tail].next1 = a->head;
+	ctx->states[a->tail].next2 = e;
+	a->tail = e;
+	return true;
+}
+
+static bool
+__regexNfaQuest(regexNfaContext *ctx, regexNfaFrag *a)
+{
+	int		s = __regexNfaNewState(ctx);
+	int		e = __regexNfaNewState(ctx);
+
+	if (s < 0 || e < 0)
+		return false;
+	ctx->states[s].next1 = a->head;
+	ctx->states[s].next2 = e;
+	ctx->states[a->tail].next1 = e;
+	a->head = s;
+	a->tail = e;
+	return true;
+}
+
+/*
+ * __regexNfaAnyChar - a fragment that matches any character, except for
+ * the single-byte characters in the 'excludes' (if any).
+ */
+static bool
+__regexNfaAnyChar(regexNfaContext *ctx, const bits8 *excludes,
+				  regexNfaFrag *frag)
+{
+	bits8		bytes[32];
+	regexNfaFrag f, c;
+
+	memset(bytes, 0, sizeof(bytes));
+	for (int i = 1; i < (ctx->utf8 ? 0x80 : 0x100); i++)
+	{
+		if (!excludes || !__regexBytesTest(excludes, i))
+			__regexBytesSet(bytes, i);
+	}
+	if (!__regexNfaFragBytes(ctx, bytes, frag))
+		return false;
+	if (ctx->utf8)
+	{
+		/* [\xC2-\xDF][\x80-\xBF] */
+		if (!__regexNfaFragByteRange(ctx, 0xc2, 0xdf, &f) ||
+			!__regexNfaFragByteRange(ctx, 0x80, 0xbf, &c))
+			return false;
+		__regexNfaConcat(ctx, &f, &c);
+		if (!__regexNfaAlt(ctx, frag, &f))
+			return false;
+		/* [\xE0-\xEF][\x80-\xBF]{2} */
+		if (!__regexNfaFragByteRange(ctx, 0xe0, 0xef, &f))
+			return false;
+		for (int k=0; k < 2; k++)
+		{
+			if (!__regexNfaFragByteRange(ctx, 0x80, 0xbf, &c))
+				return false;
+			__regexNfaConcat(ctx, &f, &c);
+		}
+		if (!__regexNfaAlt(ctx, frag, &f))
+			return false;
+		/* [\xF0-\xF4][\x80-\xBF]{3} */
+		if (!__regexNfaFragByteRange(ctx, 0xf0, 0xf4, &f))
+			return false;
+		for (int k=0; k < 3; k++)
+		{
+			if (!__regexNfaFragByteRange(ctx, 0x80, 0xbf, &c))
+				return false;
+			__regexNfaConcat(ctx, &f, &c);
+		}
+		if (!__regexNfaAlt(ctx, frag, &f))
+			return false;
+	}
+	return true;
+}
+
+/*
+ * __regexNfaLiteral - a fragment that matches the character at 'str'
+ */
+static bool
+__regexNfaLiteral(regexNfaContext *ctx, const char *str, int len,
+				  regexNfaFrag *frag)
+{
+	for (int i=0; i < len; i++)
+	{
+		bits8	bytes[32];
+		int		c = (uint8_t)str[i];
+		regexNfaFrag f;
+
+		if (c >= 0x80 && ctx->icase)
+			return false;	/* non-ASCII case folding is not supported */
+		memset(bytes, 0, sizeof(bytes));
+		__regexBytesSet(bytes, c);
+		if (ctx->icase && isalpha(c))
+		{
+			__regexBytesSet(bytes, pg_ascii_tolower(c));
+			__regexBytesSet(bytes, pg_ascii_toupper(c));
+		}
+		if (i == 0)
+		{
+			if (!__regexNfaFragBytes(ctx, bytes, frag))
+				return false;
+		}
+		else
+		{
+			if (!__regexNfaFragBytes(ctx, bytes, &f))
+				return false;
+			__regexNfaConcat(ctx, frag, &f);
+		}
+	}
+	return (len > 0);
+}
+
+/*
+ * __regexParseBracket - [...] expression
+ */
+static bool
+__regexParseBracket(regexNfaContext *ctx, regexNfaFrag *frag)
+{
+	const char *pattern = ctx->pattern;
+	bits8		bytes[32];
+	bool		negative = false;
+	bool		is_first = true;
+
+	Assert(pattern[ctx->pos] == '[');
+	ctx->pos++;
+	memset(bytes, 0, sizeof(bytes));
+	if (ctx->pos < ctx->length && pattern[ctx->pos] == '^')
+	{
+		negative = true;
+		ctx->pos++;
+	}
+	for (;;)
+	{
+		int		lo, hi;
+
+		if (ctx->pos >= ctx->length)
+			return false;
+		lo = (uint8_t)pattern[ctx->pos];
+		if (lo == ']' && !is_first)
+		{
+			ctx->pos++;
+			break;
+		}
+		is_first = false;
+		if (lo == '[' && ctx->pos + 1 < ctx->length &&
+			(pattern[ctx->pos+1] == ':' ||
+			 pattern[ctx->pos+1] == '.' ||
+			 pattern[ctx->pos+1] == '='))
+			return false;	/* character classes are not supported */
+		if (lo == '\\')
+		{
+			if (++ctx->pos >= ctx->length)
+				return false;
+			lo = (uint8_t)pattern[ctx->pos];
+			if (isalnum(lo))
+				return false;	/* class-shorthand escapes */
+		}
+		if (lo == 0 || (ctx->utf8 && lo >= 0x80))
+			return false;	/* multibyte characters in bracket */
+		ctx->pos++;
+		hi = lo;
+		if (ctx->pos + 1 < ctx->length &&
+			pattern[ctx->pos] == '-' &&
+			pattern[ctx->pos+1] != ']')
+		{
+			hi = (uint8_t)pattern[ctx->pos+1];
+			if (hi == '\\' || hi == '[' ||
+				hi == 0 || (ctx->utf8 && hi >= 0x80) || hi < lo)
+				return false;
+			ctx->pos += 2;
+		}
+		for (int c=lo; c <= hi; c++)
+		{
+			if (c >= 0x80 && ctx->icase)
+				return false;
+			__regexBytesSet(bytes, c);
+			if (ctx->icase && isalpha(c))
+			{
+				__regexBytesSet(bytes, pg_ascii_tolower(c));
+				__regexBytesSet(bytes, pg_ascii_toupper(c));
+			}
+		}
+	}
+	if (negative)
+		return __regexNfaAnyChar(ctx, bytes, frag);
+	return __regexNfaFragBytes(ctx, bytes, frag);
+}
+
+static bool __regexParseRegex(regexNfaContext *ctx, int depth,
+							  regexNfaFrag *frag);
+
+/*
+ * __regexParseAtom
+ */
+static bool
+__regexParseAtom(regexNfaContext *ctx, int depth, regexNfaFrag *frag)
+{
+	const char *pattern = ctx->pattern;
+	int			c = (uint8_t)pattern[ctx->pos];
+	int			len;
+
+	switch (c)
+	{
+		case '(':
+			ctx->pos++;
+			if (ctx->pos < ctx->length && pattern[ctx->pos] == '?')
+			{
+				/* only non-capturing group (?:...) is supported */
+				if (ctx->pos + 1 >= ctx->length || pattern[ctx->pos+1] != ':')
+					return false;
+				ctx->pos += 2;
+			}
+			if (!__regexParseRegex(ctx, depth+1, frag))
+				return false;
+			if (ctx->pos >= ctx->length || pattern[ctx->pos] != ')')
+				return false;
+			ctx->pos++;
+			return true;
+		case '.':
+			ctx->pos++;
+			return __regexNfaAnyChar(ctx, NULL, frag);
+		case '[':
+			return __regexParseBracket(ctx, frag);
+		case '\\':
+			if (++ctx->pos >= ctx->length)
+				return false;
+			c = (uint8_t)pattern[ctx->pos];
+			if (isalnum(c))
+				return false;	/* back-reference or class escapes */
+			break;
+		case '*':
+		case '+':
+		case '?':
+		case '{':
+		case '}':
+		case '^':
+		case '$':
+		case ')':
+			return false;
+		default:
+			break;
+	}
+	len = pg_mblen(pattern + ctx->pos);
+	if (ctx->pos + len > ctx->length)
+		return false;
+	if (!__regexNfaLiteral(ctx, pattern + ctx->pos, len, frag))
+		return false;
+	ctx->pos += len;
+	return true;
+}
+
+/*
+ * __regexParseBound - {m}, {m,} or {m,n}
+ */
+static bool
+__regexParseBound(regexNfaContext *ctx, int *p_min, int *p_max)
+{
+	const char *pattern = ctx->pattern;
+	int			m = 0, n;
+
+	Assert(pattern[ctx->pos] == '{');
+	ctx->pos++;
+	if (ctx->pos >= ctx->length || !isdigit(pattern[ctx->pos]))
+		return false;
+	while (ctx->pos < ctx->length && isdigit(pattern[ctx->pos]))
+	{
+		m = 10 * m + (pattern[ctx->pos++] - '0');
+		if (m > REGEX_MAX_REPEAT)
+			return false;
+	}
+	n = m;
+	if (ctx->pos < ctx->length && pattern[ctx->pos] == ',')
+	{
+		ctx->pos++;
+		if (ctx->pos < ctx->length && isdigit(pattern[ctx->pos]))
+		{
+			n = 0;
+			while (ctx->pos < ctx->length && isdigit(pattern[ctx->pos]))
+			{
+				n = 10 * n + (pattern[ctx->pos++] - '0');
+				if (n > REGEX_MAX_REPEAT)
+					return false;
+			}
+			if (n < m)
+				return false;
+		}
+		else
+			n = -1;		/* unbounded */
+	}
+	if (ctx->pos >= ctx->length || pattern[ctx->pos] != '}' || n == 0)
+		return false;
+	ctx->pos++;
+	*p_min = m;
+	*p_max = n;
+	return true;
+}
+
+/*
+ * __regexParsePiece - atom with quantifier, if any
+ */
+static bool
+__regexParsePiece(regexNfaContext *ctx, int depth, regexNfaFrag *frag)
+{
+	const char *pattern = ctx->pattern;
+	int			atom_pos = ctx->pos;
+	int			m, n;
+	regexNfaFrag f;
+
+	if (!__regexParseAtom(ctx, depth, frag))
+		return false;
+	if (ctx->pos >= ctx->length)
+		return true;
+	switch (pattern[ctx->pos])
+	{
+		case '*':
+			ctx->pos++;
+			if (!__regexNfaStar(ctx, frag))
+				return false;
+			break;
+		case '+':
+			ctx->pos++;
+			if (!__regexNfaPlus(ctx, frag))
+				return false;
+			break;
+		case '?':
+			ctx->pos++;
+			if (!__regexNfaQuest(ctx, frag))
+				return false;
+			break;
+		case '{':
+			if (!__regexParseBound(ctx, &m, &n))
+				return false;
+			else
+			{
+				int		tail_pos = ctx->pos;
+				int		count = (m > 0 ? m : 1);
+
+				/* the atom is re-parsed to make its copies */
+				for (int k=1; k < count + (n < 0 ? 1 : n - count); k++)
+				{
+					ctx->pos = atom_pos;
+					if (!__regexParseAtom(ctx, depth, &f))
+						return false;
+					if (k >= m)
+					{
+						if (!(n < 0
+							  ? __regexNfaStar(ctx, &f)
+							  : __regexNfaQuest(ctx, &f)))
+							return false;
+					}
+					__regexNfaConcat(ctx, frag, &f);
+				}
+				if (m == 0)
+				{
+					/* the first copy is also optional */
+					if (!__regexNfaQuest(ctx, frag))
+						return false;
+				}
+				ctx->pos = tail_pos;
+			}
+			break;
+		default:
+			return true;
+	}
+	/* non-greedy quantifiers make no difference for boolean match */
+	if (ctx->pos < ctx->length && pattern[ctx->pos] == '?')
+		ctx->pos++;
+	/* multiple quantifiers are not allowed */
+	if (ctx->pos < ctx->length && strchr("*+?{", pattern[ctx->pos]) != NULL)
+		return false;
+	return true;
+}
+
+/*
+ * __regexParseRegex - branch ('|' branch)*
+ */
+static bool
+__regexParseRegex(regexNfaContext *ctx, int depth, regexNfaFrag *frag)
+{
+	const char *pattern = ctx->pattern;
+	bool		is_first = true;
+
+	for (;;)
+	{
+		regexNfaFrag branch, f;
+
+		if (!__regexNfaFragEmpty(ctx, &branch))
+			return false;
+		while (ctx->pos < ctx->length &&
+			   pattern[ctx->pos] != '|' &&
+			   pattern[ctx->pos] != ')')
+		{
+			if (!__regexParsePiece(ctx, depth, &f))
+				return false;
+			__regexNfaConcat(ctx, &branch, &f);
+		}
+		if (is_first)
+			*frag = branch;
+		else if (!__regexNfaAlt(ctx, frag, &branch))
+			return false;
+		is_first = false;
+		if (ctx->pos >= ctx->length || pattern[ctx->pos] != '|')
+			break;
+		if (depth == 0)
+			ctx->has_toplevel_alt = true;
+		ctx->pos++;
+	}
+	return true;
+}
+
+/*
+ * __regexNfaClosure - epsilon closure of the NFA states
+ */
+static Bitmapset *
+__regexNfaClosure(regexNfaContext *ctx, Bitmapset *nfa_set, int *stack)
+{
+	int		depth = 0;
+	int		k = -1;
+
+	while ((k = bms_next_member(nfa_set, k)) >= 0)
+		stack[depth++] = k;
+	while (depth > 0)
+	{
+		regexNfaState *nfa = &ctx->states[stack[--depth]];
+
+		if (nfa->has_bytes)
+			continue;
+		if (nfa->next1 >= 0 && !bms_is_member(nfa->next1, nfa_set))
+		{
+			nfa_set = bms_add_member(nfa_set, nfa->next1);
+			stack[depth++] = nfa->next1;
+		}
+		if (nfa->next2 >= 0 && !bms_is_member(nfa->next2, nfa_set))
+		{
+			nfa_set = bms_add_member(nfa_set, nfa->next2);
+			stack[depth++] = nfa->next2;
+		}
+	}
+	return nfa_set;
+}
+
+/*
+ * __regexBuildDfa - subset construction of the DFA
+ */
+static bytea *
+__regexBuildDfa(regexNfaContext *ctx, regexNfaFrag *frag, bool negate)
+{
+	uint8_t		class_map[256];
+	int			class_repr[256];
+	int			nclasses = 1;
+	Bitmapset  *dfa_sets[REGEX_DFA_MAX_NSTATES];
+	uint8_t	   *dfa_trans;
+	int			ndfa_states;
+	int		   *stack;
+	bytea	   *result;
+	kern_regex_dfa *dfa;
+
+	/* split bytes into the equivalent classes */
+	memset(class_map, 0, sizeof(class_map));
+	for (int i=0; i < ctx->nstates; i++)
+	{
+		regexNfaState *nfa = &ctx->states[i];
+		int			new_class[256][2];
+		int			__nclasses = 0;
+
+		if (!nfa->has_bytes)
+			continue;
+		memset(new_class, -1, sizeof(int) * 2 * nclasses);
+		for (int c=0; c < 256; c++)
+		{
+			int		k = __regexBytesTest(nfa->bytes, c) ? 1 : 0;
+			int	   *p = &new_class[class_map[c]][k];
+
+			if (*p < 0)
+			{
+				if (__nclasses >= 255)
+					return NULL;
+				*p = __nclasses++;
+			}
+			class_map[c] = *p;
+		}
+		nclasses = __nclasses;
+	}
+	for (int c=255; c >= 0; c--)
+		class_repr[class_map[c]] = c;
+
+	/* state-0 is the dead state */
+	stack = palloc(sizeof(int) * ctx->nstates);
+	dfa_trans = palloc0(REGEX_DFA_MAX_NSTATES * nclasses);
+	dfa_sets[0] = NULL;
+	dfa_sets[1] = __regexNfaClosure(ctx, bms_make_singleton(frag->head), stack);
+	ndfa_states = 2;
+	for (int i=1; i < ndfa_states; i++)
+	{
+		for (int cls=0; cls < nclasses; cls++)
+		{
+			Bitmapset  *next = NULL;
+			int			c = class_repr[cls];
+			int			k = -1;
+			int			j;
+
+			while ((k = bms_next_member(dfa_sets[i], k)) >= 0)
+			{
+				regexNfaState *nfa = &ctx->states[k];
+
+				if (nfa->has_bytes && __regexBytesTest(nfa->bytes, c))
+					next = bms_add_member(next, nfa->next1);
+			}
+			next = __regexNfaClosure(ctx, next, stack);
+			for (j=0; j < ndfa_states; j++)
+			{
+				if (bms_equal(dfa_sets[j], next))
+					break;
+			}
+			if (j == ndfa_states)
+			{
+				if (ndfa_states >= REGEX_DFA_MAX_NSTATES)
+					return NULL;	/* too complicated */
+				dfa_sets[ndfa_states++] = next;
+			}
+			else
+				bms_free(next);
+			dfa_trans[i * nclasses + cls] = j;
+		}
+	}
+
+	/* build kern_regex_dfa */
+	result = palloc0(VARHDRSZ + KERN_REGEX_DFA_LENGTH(ndfa_states, nclasses));
+	SET_VARSIZE(result, VARHDRSZ + KERN_REGEX_DFA_LENGTH(ndfa_states, nclasses));
+	dfa = (kern_regex_dfa *)VARDATA(result);
+	dfa->nstates = ndfa_states;
+	dfa->nclasses = nclasses;
+	dfa->start = 1;
+	dfa->flags = (negate ? KERN_REGEX_DFA__NEGATE : 0);
+	memcpy(dfa->class_map, class_map, sizeof(class_map));
+	memcpy(dfa->data, dfa_trans, ndfa_states * nclasses);
+	for (int i=0; i < ndfa_states; i++)
+	{
+		uint8_t	   *sflags = dfa->data + ndfa_states * nclasses;
+		bool		is_final = true;
+
+		if (bms_is_member(frag->tail, dfa_sets[i]))
+			sflags[i] |= KERN_REGEX_DFA_STATE__ACCEPT;
+		for (int cls=0; cls < nclasses; cls++)
+		{
+			if (dfa_trans[i * nclasses + cls] != i)
+				is_final = false;
+		}
+		if (is_final)
+			sflags[i] |= KERN_REGEX_DFA_STATE__FINAL;
+	}
+	return result;
+}
+
+/*
+ * __codegen_check_textlike - check whether it is text [NOT] [I]LIKE text
+ */
+static bool
+__codegen_check_textlike(Oid func_oid, List *func_args, Oid func_collid,
+						 bool *p_icase, bool *p_negate)
+{
+	devfunc_info *dfunc;
+
+	if (list_length(func_args) != 2 ||
+		exprType(linitial(func_args)) != TEXTOID)
+		return false;
+	dfunc = pgstrom_devfunc_lookup(func_oid, func_args, func_collid);
+	if (!dfunc)
+		return false;
+	switch (dfunc->func_code)
+	{
+		case FuncOpCode__like:
+		case FuncOpCode__textlike:
+			*p_icase = false;
+			*p_negate = false;
+			return true;
+		case FuncOpCode__notlike:
+		case FuncOpCode__textnlike:
+			*p_icase = false;
+			*p_negate = true;
+			return true;
+		case FuncOpCode__texticlike:
+			*p_icase = true;
+			*p_negate = false;
+			return true;
+		case FuncOpCode__texticnlike:
+			*p_icase = true;
+			*p_negate = true;
+			return true;
+		default:
+			break;
+	}
+	return false;
+}
+
+/*
+ * __codegen_build_textlike_needle
+ *
+ * It returns a Const of the needle if the expression is text [NOT] LIKE
+ * '%literal%', then xPU runs substring search instead of the generic
+ * LIKE matcher.
+ */
+static Const *
+__codegen_build_textlike_needle(Oid func_oid, List *func_args, Oid func_collid)
+{
+	Const	   *con;
+	const char *pattern;
+	int			len;
+	bool		icase;
+	bool		negate;
+	StringInfoData buf;
+	kern_like_needle *needle;
+	int			nlen;
+
+	if (!__codegen_check_textlike(func_oid, func_args, func_collid,
+								  &icase, &negate) || icase)
+		return NULL;
+	con = lsecond(func_args);
+	if (!IsA(con, Const) || con->constisnull || con->consttype != TEXTOID)
+		return NULL;
+	if (!OidIsValid(func_collid) ||
+		!get_collation_isdeterministic(func_collid))
+		return NULL;
+	/* byte-level search is safe only on the self-synchronized encodings */
+	if (GetDatabaseEncoding() != PG_UTF8 &&
+		pg_database_encoding_max_length() != 1)
+		return NULL;
+	pattern = TextDatumGetCString(con->constvalue);
+	len = strlen(pattern);
+	if (len < 2 || pattern[0] != '%' || pattern[len-1] != '%')
+		return NULL;
+
+	initStringInfo(&buf);
+	buf.len = VARHDRSZ + offsetof(kern_like_needle, needle);
+	enlargeStringInfo(&buf, 0);
+	for (int i=1; i < len-1; i++)
+	{
+		int		c = pattern[i];
+
+		if (c == '%' || c == '_')
+			return NULL;	/* not a simple literal */
+		if (c == '\')
+		{
+			/* the last '%' must not be escaped */
+			if (++i >= len-1)
+				return NULL;
+			c = pattern[i];
+		}
+		appendStringInfoChar(&buf, c);
+	}
+	SET_VARSIZE(buf.data, buf.len);
+	needle = (kern_like_needle *)VARDATA(buf.data);
+	nlen = buf.len - (VARHDRSZ + offsetof(kern_like_needle, needle));
+	memset(needle, 0, offsetof(kern_like_needle, needle));
+	needle->flags = (negate ? KERN_LIKE_NEEDLE__NEGATE : 0);
+	/* bad-character shift table of Boyer-Moore-Horspool */
+	for (int c=0; c < 256; c++)
+		needle->shift[c] = Min(Max(nlen, 1), 255);
+	for (int i=0; i < nlen-1; i++)
+		needle->shift[(uint8_t)needle->needle[i]] = Min(nlen-1-i, 255);
+
+	return makeConst(BYTEAOID, -1, InvalidOid, -1,
+					 PointerGetDatum(buf.data), false, false);
+}
+
+/*
+ * __codegen_build_textdfa
+ *
+ * It returns a Const of the DFA if the expression is regular-expression
+ * or LIKE with constant pattern, and it is compilable.
+ */
+static Const *
+__codegen_build_textdfa(Oid func_oid, List *func_args, Oid func_collid)
+{
+	regexNfaContext *ctx;
+	regexNfaFrag frag;
+	regexNfaFrag f;
+	Const	   *con;
+	bytea	   *dfa;
+	bool		is_regex = false;
+	bool		icase = false;
+	bool		negate = false;
+	bool		anchored_head = true;
+	bool		anchored_tail = true;
+
+	if (list_length(func_args) != 2 ||
+		exprType(linitial(func_args)) != TEXTOID)
+		return NULL;
+	switch (func_oid)
+	{
+		case F_TEXTREGEXEQ:
+#ifdef F_REGEXP_LIKE_TEXT_TEXT
+		case F_REGEXP_LIKE_TEXT_TEXT:
+#endif
+			is_regex = true;
+			break;
+		case F_TEXTREGEXNE:
+			is_regex = negate = true;
+			break;
+		case F_TEXTICREGEXEQ:
+			is_regex = icase = true;
+			break;
+		case F_TEXTICREGEXNE:
+			is_regex = icase = negate = true;
+			break;
+		default:
+			if (!__codegen_check_textlike(func_oid, func_args, func_collid,
+										  &icase, &negate))
+				return NULL;
+			break;
+	}
+	con = lsecond(func_args);
+	if (!IsA(con, Const) || con->constisnull || con->consttype != TEXTOID)
+		return NULL;
+	if (!OidIsValid(func_collid) ||
+		!get_collation_isdeterministic(func_collid))
+		return NULL;
+	if (GetDatabaseEncoding() != PG_UTF8 &&
+		pg_database_encoding_max_length() != 1)
+		return NULL;
+
+	ctx = palloc0(sizeof(regexNfaContext));
+	ctx->pattern = TextDatumGetCString(con->constvalue);
+	ctx->length  = strlen(ctx->pattern);
+	ctx->icase   = icase;
+	ctx->utf8    = (GetDatabaseEncoding() == PG_UTF8);
+	if (is_regex)
+	{
+		if (strncmp(ctx->pattern, "***", 3) == 0)
+			return NULL;	/* director prefix */
+		if (ctx->length > 0 && ctx->pattern[0] == '^')
+			ctx->pos++;
+		else
+			anchored_head = false;
+		if (ctx->length > ctx->pos && ctx->pattern[ctx->length-1] == '$')
+		{
+			int		nbackslashes = 0;
+
+			for (int i=ctx->length-2; i >= ctx->pos && ctx->pattern[i] == '\\'; i--)
+				nbackslashes++;
+			if (nbackslashes % 2 == 0)
+				ctx->length--;
+			else
+				anchored_tail = false;
+		}
+		else
+			anchored_tail = false;
+		if (!__regexParseRegex(ctx, 0, &frag) ||
+			ctx->pos != ctx->length ||
+			(ctx->has_toplevel_alt && (anchored_head || anchored_tail)))
+			return NULL;
+	}
+	else
+	{
+		const char *pattern = ctx->pattern;
+		int			nwildcards = 0;
+
+		/* LIKE with a few '%' is sufficient with the simple matcher */
+		for (int i=0; i < ctx->length; i++)
+		{
+			if (pattern[i] == '%')
+				nwildcards++;
+		}
+		if (nwildcards < 2)
+			return NULL;
+
+		if (!__regexNfaFragEmpty(ctx, &frag))
+			return NULL;
+		while (ctx->pos < ctx->length)
+		{
+			int		c = (uint8_t)pattern[ctx->pos];
+			int		len;
+
+			if (c == '%')
+			{
+				while (ctx->pos < ctx->length && pattern[ctx->pos] == '%')
+					ctx->pos++;
+				if (!__regexNfaAnyChar(ctx, NULL, &f) ||
+					!__regexNfaStar(ctx, &f))
+					return NULL;
+			}
+			else if (c == '_')
+			{
+				ctx->pos++;
+				if (!__regexNfaAnyChar(ctx, NULL, &f))
+					return NULL;
+			}
+			else
+			{
+				if (c == '\\' && ++ctx->pos >= ctx->length)
+					return NULL;	/* invalid escape in LIKE pattern */
+				len = pg_mblen(pattern + ctx->pos);
+				if (ctx->pos + len > ctx->length ||
+					!__regexNfaLiteral(ctx, pattern + ctx->pos, len, &f))
+					return NULL;
+				ctx->pos += len;
+			}
+			__regexNfaConcat(ctx, &frag, &f);
+		}
+	}
+	/* unanchored head/tail matches any bytes */
+	if (!anchored_head)
+	{
+		if (!__regexNfaFragByteRange(ctx, 0x01, 0xff, &f) ||
+			!__regexNfaStar(ctx, &f))
+			return NULL;
+		__regexNfaConcat(ctx, &f, &frag);
+		frag = f;
+	}
+	if (!anchored_tail)
+	{
+		if (!__regexNfaFragByteRange(ctx, 0x01, 0xff, &f) ||
+			!__regexNfaStar(ctx, &f))
+			return NULL;
+		__regexNfaConcat(ctx, &frag, &f);
+	}
+	dfa = __regexBuildDfa(ctx, &frag, negate);
+	if (!dfa)
+		return NULL;
+	return makeConst(BYTEAOID, -1, InvalidOid, -1,
+					 PointerGetDatum(dfa), false, false);
+}
+
+/*
+ * JSONPath compiler
+ *
+ * It compiles a subset of JSONPath (lax mode) into kern_jsonpath_program,
+ * then xPU evaluates jsonb_path_exists / jsonb_path_match on the device.
+ * Unsupported items (methods, arithmetic, variables, like_regex, .** and
+ * so on) make the expression run on the CPU.
+ */
+typedef struct
+{
+	kern_jsonpath_step *steps;
+	int			nsteps;
+	StringInfoData consts;
+} jsonpathCompileContext;
+
+static int
+__jsonpathAppendStep(jsonpathCompileContext *jpc, int32 op)
+{
+	kern_jsonpath_step *step;
+
+	if (jpc->nsteps >= KERN_JSONPATH_MAX_STEPS)
+		return -1;
+	step = &jpc->steps[jpc->nsteps];
+	memset(step, 0, sizeof(kern_jsonpath_step));
+	step->op = op;
+	step->next = -1;
+	step->arg1 = -1;
+	step->arg2 = -1;
+	return jpc->nsteps++;
+}
+
+static int	__jsonpathCompilePredicate(jsonpathCompileContext *jpc,
+									   JsonPathItem *v);
+
+static int
+__jsonpathCompileChain(jsonpathCompileContext *jpc,
+					   JsonPathItem *v, int terminal)
+{
+	JsonPathItem next;
+	int			next_id = terminal;
+	int			step_id;
+	int			arg = -1;
+	int32		op;
+
+	if (jspGetNext(v, &next))
+	{
+		next_id = __jsonpathCompileChain(jpc, &next, terminal);
+		if (next_id < 0)
+			return -1;
+	}
+	switch (v->type)
+	{
+		case jpiRoot:
+			op = KERN_JSONPATH_OP__ROOT;
+			break;
+		case jpiCurrent:
+			op = KERN_JSONPATH_OP__CURRENT;
+			break;
+		case jpiKey:
+			op = KERN_JSONPATH_OP__KEY;
+			break;
+		case jpiAnyKey:
+			op = KERN_JSONPATH_OP__ANY_KEY;
+			break;
+		case jpiAnyArray:
+			op = KERN_JSONPATH_OP__ANY_ARRAY;
+			break;
+		case jpiIndexArray:
+			{
+				JsonPathItem from;
+				JsonPathItem to;
+				char	   *str;
+				char	   *end;
+				long		ival;
+
+				/* only a single, non-negative integer literal */
+				if (v->content.array.nelems != 1 ||
+					jspGetArraySubscript(v, &from, &to, 0) ||
+					from.type != jpiNumeric)
+					return -1;
+				str = DatumGetCString(DirectFunctionCall1(numeric_out,
+											NumericGetDatum(jspGetNumeric(&from))));
+				errno = 0;
+				ival = strtol(str, &end, 10);
+				if (*end != '\0' || errno != 0 || ival < 0 || ival > INT_MAX)
+					return -1;
+				arg = ival;
+			}
+			op = KERN_JSONPATH_OP__INDEX_ARRAY;
+			break;
+		case jpiFilter:
+			{
+				JsonPathItem pred;
+
+				jspGetArg(v, &pred);
+				arg = __jsonpathCompilePredicate(jpc, &pred);
+				if (arg < 0)
+					return -1;
+			}
+			op = KERN_JSONPATH_OP__FILTER;
+			break;
+		default:
+			return -1;
+	}
+	step_id = __jsonpathAppendStep(jpc, op);
+	if (step_id < 0)
+		return -1;
+	jpc->steps[step_id].next = next_id;
+	jpc->steps[step_id].arg1 = arg;
+	if (v->type == jpiKey)
+	{
+		char	   *key;
+		int32		keylen;
+
+		key = jspGetString(v, &keylen);
+		jpc->steps[step_id].const_type = KERN_JSONPATH_CONST__STRING;
+		jpc->steps[step_id].const_offset = jpc->consts.len;
+		jpc->steps[step_id].const_len = keylen;
+		appendBinaryStringInfo(&jpc->consts, key, keylen);
+	}
+	return step_id;
+}
+
+static int
+__jsonpathCompileCompare(jsonpathCompileContext *jpc, JsonPathItem *v)
+{
+	JsonPathItem larg;
+	JsonPathItem rarg;
+	JsonPathItem *path;
+	JsonPathItem *cval;
+	kern_jsonpath_step *step;
+	int			step_id;
+	int32		cmp_op;
+
+	jspGetLeftArg(v, &larg);
+	jspGetRightArg(v, &rarg);
+	if ((larg.type == jpiRoot || larg.type == jpiCurrent) &&
+		(rarg.type == jpiNull || rarg.type == jpiString ||
+		 rarg.type == jpiNumeric || rarg.type == jpiBool) &&
+		!jspHasNext(&rarg))
+	{
+		path = &larg;
+		cval = &rarg;
+		switch (v->type)
+		{
+			case jpiEqual:			cmp_op = KERN_JSONPATH_CMP__EQ; break;
+			case jpiNotEqual:		cmp_op = KERN_JSONPATH_CMP__NE; break;
+			case jpiLess:			cmp_op = KERN_JSONPATH_CMP__LT; break;
+			case jpiLessOrEqual:	cmp_op = KERN_JSONPATH_CMP__LE; break;
+			case jpiGreater:		cmp_op = KERN_JSONPATH_CMP__GT; break;
+			case jpiGreaterOrEqual:	cmp_op = KERN_JSONPATH_CMP__GE; break;
+			default:
+				return -1;
+		}
+	}
+	else if ((rarg.type == jpiRoot || rarg.type == jpiCurrent) &&
+			 (larg.type == jpiNull || larg.type == jpiString ||
+			  larg.type == jpiNumeric || larg.type == jpiBool) &&
+			 !jspHasNext(&larg))
+	{
+		/* swap the operands, then flip the operator */
+		path = &rarg;
+		cval = &larg;
+		switch (v->type)
+		{
+			case jpiEqual:			cmp_op = KERN_JSONPATH_CMP__EQ; break;
+			case jpiNotEqual:		cmp_op = KERN_JSONPATH_CMP__NE; break;
+			case jpiLess:			cmp_op = KERN_JSONPATH_CMP__GT; break;
+			case jpiLessOrEqual:	cmp_op = KERN_JSONPATH_CMP__GE; break;
+			case jpiGreater:		cmp_op = KERN_JSONPATH_CMP__LT; break;
+			case jpiGreaterOrEqual:	cmp_op = KERN_JSONPATH_CMP__LE; break;
+			default:
+				return -1;
+		}
+	}
+	else
+		return -1;
+
+	/* string ordering is binary comparison only if UTF-8 */
+	if (cval->type == jpiString &&
+		cmp_op != KERN_JSONPATH_CMP__EQ &&
+		cmp_op != KERN_JSONPATH_CMP__NE &&
+		GetDatabaseEncoding() != PG_UTF8)
+		return -1;
+
+	step_id = __jsonpathAppendStep(jpc, KERN_JSONPATH_OP__END_COMPARE);
+	if (step_id < 0)
+		return -1;
+	step = &jpc->steps[step_id];
+	step->cmp_op = cmp_op;
+	switch (cval->type)
+	{
+		case jpiNull:
+			step->const_type = KERN_JSONPATH_CONST__NULL;
+			break;
+		case jpiBool:
+			step->const_type = (jspGetBool(cval)
+								? KERN_JSONPATH_CONST__BOOL_TRUE
+								: KERN_JSONPATH_CONST__BOOL_FALSE);
+			break;
+		case jpiString:
+			{
+				char   *str;
+				int32	len;
+
+				str = jspGetString(cval, &len);
+				step->const_type = KERN_JSONPATH_CONST__STRING;
+				step->const_offset = jpc->consts.len;
+				step->const_len = len;
+				appendBinaryStringInfo(&jpc->consts, str, len);
+			}
+			break;
+		case jpiNumeric:
+			{
+				Numeric	num = jspGetNumeric(cval);
+
+				/* numeric varlena must be aligned */
+				while (jpc->consts.len != INTALIGN(jpc->consts.len))
+					appendStringInfoChar(&jpc->consts, '\0');
+				step->const_type = KERN_JSONPATH_CONST__NUMERIC;
+				step->const_offset = jpc->consts.len;
+				step->const_len = VARSIZE(num);
+				appendBinaryStringInfo(&jpc->consts, (char *)num, VARSIZE(num));
+			}
+			break;
+		default:
+			return -1;
+	}
+	return __jsonpathCompileChain(jpc, path, step_id);
+}
+
+static int
+__jsonpathCompilePredicate(jsonpathCompileContext *jpc, JsonPathItem *v)
+{
+	JsonPathItem arg;
+	int			step_id;
+	int			lid, rid;
+
+	if (jspHasNext(v))
+		return -1;
+	switch (v->type)
+	{
+		case jpiAnd:
+		case jpiOr:
+			jspGetLeftArg(v, &arg);
+			lid = __jsonpathCompilePredicate(jpc, &arg);
+			if (lid < 0)
+				return -1;
+			jspGetRightArg(v, &arg);
+			rid = __jsonpathCompilePredicate(jpc, &arg);
+			if (rid < 0)
+				return -1;
+			step_id = __jsonpathAppendStep(jpc, (v->type == jpiAnd
+												 ? KERN_JSONPATH_OP__AND
+												 : KERN_JSONPATH_OP__OR));
+			if (step_id < 0)
+				return -1;
+			jpc->steps[step_id].arg1 = lid;
+			jpc->steps[step_id].arg2 = rid;
+			return step_id;
+
+		case jpiNot:
+		case jpiIsUnknown:
+			jspGetArg(v, &arg);
+			lid = __jsonpathCompilePredicate(jpc, &arg);
+			if (lid < 0)
+				return -1;
+			step_id = __jsonpathAppendStep(jpc, (v->type == jpiNot
+												 ? KERN_JSONPATH_OP__NOT
+												 : KERN_JSONPATH_OP__IS_UNKNOWN));
+			if (step_id < 0)
+				return -1;
+			jpc->steps[step_id].arg1 = lid;
+			return step_id;
+
+		case jpiExists:
+			jspGetArg(v, &arg);
+			step_id = __jsonpathAppendStep(jpc, KERN_JSONPATH_OP__END_EXISTS);
+			if (step_id < 0)
+				return -1;
+			return __jsonpathCompileChain(jpc, &arg, step_id);
+
+		case jpiEqual:
+		case jpiNotEqual:
+		case jpiLess:
+		case jpiGreater:
+		case jpiLessOrEqual:
+		case jpiGreaterOrEqual:
+			return __jsonpathCompileCompare(jpc, v);
+
+		default:
+			break;
+	}
+	return -1;
+}
+
+/*
+ * __codegen_build_jsonpath
+ *
+ * It returns a Const of the compiled JSONPath program if the expression
+ * is jsonb_path_exists / jsonb_path_match (or @? / @@ operators) with
+ * constant JSONPath.
+ */
+static Const *
+__codegen_build_jsonpath(Oid func_oid, List *func_args, bool *p_is_match)
+{
+	jsonpathCompileContext jpc;
+	JsonPath   *jsp;
+	JsonPathItem v;
+	Const	   *con;
+	StringInfoData buf;
+	kern_jsonpath_program *prog;
+	int			entry;
+
+	switch (func_oid)
+	{
+		case F_JSONB_PATH_EXISTS:
+		case F_JSONB_PATH_MATCH:
+			/* vars must be an object (never referenced), and silent a Const */
+			if (list_length(func_args) != 4)
+				return NULL;
+			con = lthird(func_args);
+			if (!IsA(con, Const) || con->constisnull ||
+				!JB_ROOT_IS_OBJECT(DatumGetJsonbP(con->constvalue)))
+				return NULL;
+			con = lfourth(func_args);
+			if (!IsA(con, Const) || con->constisnull)
+				return NULL;
+			break;
+		case F_JSONB_PATH_EXISTS_OPR:
+		case F_JSONB_PATH_MATCH_OPR:
+			if (list_length(func_args) != 2)
+				return NULL;
+			break;
+		default:
+			return NULL;
+	}
+	*p_is_match = (func_oid == F_JSONB_PATH_MATCH ||
+				   func_oid == F_JSONB_PATH_MATCH_OPR);
+	if (exprType(linitial(func_args)) != JSONBOID)
+		return NULL;
+	con = lsecond(func_args);
+	if (!IsA(con, Const) || con->constisnull || con->consttype != JSONPATHOID)
+		return NULL;
+	jsp = DatumGetJsonPathP(con->constvalue);
+	if ((jsp->header & JSONPATH_LAX) == 0)
+		return NULL;	/* strict mode is not supported */
+
+	memset(&jpc, 0, sizeof(jsonpathCompileContext));
+	jpc.steps = palloc0(sizeof(kern_jsonpath_step) * KERN_JSONPATH_MAX_STEPS);
+	initStringInfo(&jpc.consts);
+	jspInit(&v, jsp);
+	if (*p_is_match)
+		entry = __jsonpathCompilePredicate(&jpc, &v);
+	else if (v.type != jpiRoot)
+		return NULL;
+	else
+	{
+		int		terminal = __jsonpathAppendStep(&jpc, KERN_JSONPATH_OP__END_EXISTS);
+
+		if (terminal < 0)
+			return NULL;
+		entry = __jsonpathCompileChain(&jpc, &v, terminal);
+	}
+	if (entry < 0)
+		return NULL;
+
+	initStringInfo(&buf);
+	buf.len = VARHDRSZ + offsetof(kern_jsonpath_program, steps);
+	enlargeStringInfo(&buf, 0);
+	appendBinaryStringInfo(&buf, (char *)jpc.steps,
+						   sizeof(kern_jsonpath_step) * jpc.nsteps);
+	appendBinaryStringInfo(&buf, jpc.consts.data, jpc.consts.len);
+	SET_VARSIZE(buf.data, buf.len);
+	prog = (kern_jsonpath_program *)VARDATA(buf.data);
+	prog->nsteps = jpc.nsteps;
+	prog->entry = entry;
+
+	return makeConst(BYTEAOID, -1, InvalidOid, -1,
+					 PointerGetDatum(buf.data), false, false);
+}
+
+/*
+ * lookup_gcache_vcol_defitem
+ *
+ * It looks up the virtual column of GpuCache that holds pre-computed
+ * (jsonb->>KEY) of the scan relation, then returns kvar-defitem to load
+ * the virtual column, or NULL if not found.
+ */
+static codegen_kvar_defitem *
+lookup_gcache_vcol_defitem(codegen_context *context,
+						   int curr_depth,
+						   Oid func_oid,
+						   List *func_args,
+						   Oid func_collid)
+{
+	codegen_kvar_defitem *kvdef;
+	Var		   *var;
+	Const	   *con;
+	char	   *key;
+	int			resno = -1;
+	ListCell   *lc;
+
+	if (context->gcache_vcols == NIL ||
+		func_oid != F_JSONB_OBJECT_FIELD_TEXT ||
+		list_length(func_args) != 2)
+		return NULL;
+	var = linitial(func_args);
+	con = lsecond(func_args);
+	if (!IsA(var, Var) ||
+		var->varno != context->scan_relid ||
+		var->varattno <= 0 ||
+		!IsA(con, Const) ||
+		con->consttype != TEXTOID ||
+		con->constisnull)
+		return NULL;
+	key = TextDatumGetCString(con->constvalue);
+	foreach (lc, context->gcache_vcols)
+	{
+		List   *vcol = lfirst(lc);
+
+		if (intVal(linitial(vcol)) == var->varattno &&
+			strcmp(strVal(lsecond(vcol)), key) == 0)
+		{
+			resno = intVal(lthird(vcol));
+			break;
+		}
+	}
+	pfree(key);
+	if (resno < 0)
+		return NULL;
+
+	foreach (lc, context->kvars_deflist)
+	{
+		kvdef = lfirst(lc);
+
+		if (kvdef->kv_depth == 0 &&
+			kvdef->kv_resno == resno)
+		{
+			kvdef->kv_maxref = Max(kvdef->kv_maxref, curr_depth);
+			return kvdef;
+		}
+	}
+	/* attach new one */
+	kvdef = palloc0(sizeof(codegen_kvar_defitem));
+	if (!__assign_codegen_kvar_defitem_type_params(TEXTOID,
+												   &kvdef->kv_type_code,
+												   &kvdef->kv_typbyval,
+												   &kvdef->kv_typalign,
+												   &kvdef->kv_typlen,
+												   &kvdef->kv_xdatum_sizeof,
+												   &kvdef->kv_kvec_sizeof,
+												   false))
+		return NULL;
+	kvdef->kv_slot_id     = list_length(context->kvars_deflist);
+	kvdef->kv_depth       = 0;
+	kvdef->kv_resno       = resno;
+	kvdef->kv_maxref      = curr_depth;
+	kvdef->kv_offset      = context->kvecs_usage;
+	kvdef->kv_type_oid    = TEXTOID;
+	/*
+	 * NOTE: kv_expr must not match any expression in the target-list,
+	 * because CPU-fallback cannot reference the virtual column.
+	 */
+	kvdef->kv_expr = (Expr *)
+		makeRelabelType((Expr *)makeFuncExpr(func_oid,
+											 TEXTOID,
+											 copyObject(func_args),
+											 InvalidOid,
+											 func_collid,
+											 COERCE_EXPLICIT_CALL),
+						TEXTOID, -1, func_collid,
+						COERCE_IMPLICIT_CAST);
+	__assign_codegen_kvar_defitem_subfields(kvdef);
+	context->kvecs_usage += KVEC_ALIGN(kvdef->kv_kvec_sizeof);
+	context->kvars_deflist = lappend(context->kvars_deflist, kvdef);
+
+	return kvdef;
+}
+
+static int
+__codegen_devfunc_expression(codegen_context *context,
+							 StringInfo buf,
+							 int curr_depth,
+							 Oid func_oid,
+							 List *func_args,
+							 Oid func_collid)
+{
+	devfunc_info   *dfunc;
+	devtype_info   *dtype;
+	kern_expression	kexp;
+	int				pos = -1;
+	ListCell	   *lc;
+
+	dfunc = pgstrom_devfunc_lookup(func_oid, func_args, func_collid);
+	if (!dfunc ||
+		(dfunc->func_flags & context->xpu_task_flags & DEVKIND__ANY) == 0)
+		__Elog("function %s is not supported on the target device",
+			   format_procedure(func_oid));
+	dtype = dfunc->func_rettype;
+	context->device_cost += dfunc->func_cost;
+
+	memset(&kexp, 0, sizeof(kexp));
+	kexp.exptype = dtype->type_code;
+	kexp.expflags = context->kexp_flags;
+	kexp.opcode = dfunc->func_code;
+	if ((dfunc->func_flags & DEVFUNC__LOCALE_CTYPE) != 0 &&
+		OidIsValid(func_collid) && !lc_ctype_is_c(func_collid))
+	{
+		/* replaced by the version with Unicode case mapping */
+		if (kexp.opcode == FuncOpCode__lower)
+			kexp.opcode = FuncOpCode__lower_unicode;
+		else if (kexp.opcode == FuncOpCode__upper)
+			kexp.opcode = FuncOpCode__upper_unicode;
+		else
+			__Elog("unexpected locale dependent function: %s",
+				   format_procedure(func_oid));
+	}
+	kexp.nr_args = list_length(func_args);
+	kexp.args_offset = SizeOfKernExpr(0);
+	if (buf)
+		pos = __appendBinaryStringInfo(buf, &kexp, SizeOfKernExpr(0));
+	foreach (lc, func_args)
+	{
+		Expr   *arg = lfirst(lc);
+
+		if (codegen_expression_walker(context, buf, curr_depth, arg) < 0)
+			return -1;
+	}
+	if (buf)
+		__appendKernExpMagicAndLength(buf, pos);
+	return 0;
+}
+
+static int
+__codegen_func_expression(codegen_context *context,
+						  StringInfo buf,
+						  int curr_depth,
+						  Oid func_oid,
+						  List *func_args,
+						  Oid func_collid)
+{
+	codegen_kvar_defitem *vcol_kvdef;
+	kern_expression	kexp;
+	int				pos = -1;
+	Const		   *pattern;
+	FuncOpCode		pattern_opcode = FuncOpCode__Invalid;
+
+	/*
+	 * (jsonb->>KEY) is pre-computed on the virtual column of GpuCache.
+	 * The kernel can pick up either of the virtual column or the original
+	 * expression, according to the outer relation actually scanned.
+	 */
+	vcol_kvdef = lookup_gcache_vcol_defitem(context,
+											curr_depth,
+											func_oid,
+											func_args,
+											func_collid);
+	if (vcol_kvdef)
+	{
+		memset(&kexp, 0, sizeof(kexp));
+		kexp.exptype = TypeOpCode__text;
+		kexp.expflags = context->kexp_flags;
+		kexp.opcode = FuncOpCode__jsonb_vcol_field_text;
+		kexp.nr_args = 2;
+		kexp.args_offset = SizeOfKernExpr(0);
+		if (buf)
+			pos = __appendBinaryStringInfo(buf, &kexp, SizeOfKernExpr(0));
+		__codegen_kvar_reference(context, buf, curr_depth, vcol_kvdef);
+		if (__codegen_devfunc_expression(context, buf, curr_depth,
+										 func_oid,
+										 func_args,
+										 func_collid) < 0)
+			return -1;
+		if (buf)
+			__appendKernExpMagicAndLength(buf, pos);
+		return 0;
+	}
+
+	/*
+	 * LIKE '%literal%' by substring search, regular expression and LIKE
+	 * with constant pattern by DFA, or JSONPath by compiled program
+	 */
+	pattern = __codegen_build_textlike_needle(func_oid, func_args, func_collid);
+	if (pattern)
+		pattern_opcode = FuncOpCode__textlike_substr;
+	else if ((pattern = __codegen_build_textdfa(func_oid,
+												func_args,
+												func_collid)) != NULL)
+		pattern_opcode = FuncOpCode__textregex_dfa;
+	else
+	{
+		bool	is_match;
+
+		pattern = __codegen_build_jsonpath(func_oid, func_args, &is_match);
+		if (pattern)
+			pattern_opcode = (is_match
+							  ? FuncOpCode__jsonb_path_match_prog
+							  : FuncOpCode__jsonb_path_exists_prog);
+	}
+	if (pattern)
+	{
+		context->device_cost += 100;
+		memset(&kexp, 0, sizeof(kexp));
+		kexp.exptype = TypeOpCode__bool;
+		kexp.expflags = context->kexp_flags;
+		kexp.opcode = pattern_opcode;
+		kexp.nr_args = 2;
+		kexp.args_offset = SizeOfKernExpr(0);
+		if (buf)
+			pos = __appendBinaryStringInfo(buf, &kexp, SizeOfKernExpr(0));
+		if (codegen_expression_walker(context, buf, curr_depth,
+									  linitial(func_args)) < 0 ||
+			codegen_expression_walker(context, buf, curr_depth,
+									  (Expr *)pattern) < 0)
 			return -1;
+		if (buf)
+			__appendKernExpMagicAndLength(buf, pos);
+		return 0;
 	}
-	if (buf)
-		__appendKernExpMagicAndLength(buf, pos);
-	return 0;
+	return __codegen_devfunc_expression(context, buf, curr_depth,
+										func_oid,
+										func_args,
+										func_collid);
 }
 
 static int
@@ -1897,6 +3882,94 @@ codegen_distinct_expression(codegen_context *context,
 	return 0;
 }
 
+/*
+ * codegen_reorder_quals
+ *
+ * AND/OR stops evaluation of the arguments once the result gets determined,
+ * so it is worth to evaluate the cheap and decisive arguments first.
+ * Like order_qual_clauses(), it sorts the arguments by the estimated cost,
+ * but also takes the selectivity into account; the rank is cost / (1 - sel)
+ * for AND, and cost / sel for OR. Arguments with the same rank keep the
+ * original order.
+ */
+typedef struct
+{
+	Expr	   *expr;
+	double		rank;
+	int			index;
+} codegen_qual_rank;
+
+static int
+__codegen_qual_rank_comp(const void *__a, const void *__b)
+{
+	const codegen_qual_rank *a = __a;
+	const codegen_qual_rank *b = __b;
+
+	if (a->rank < b->rank)
+		return -1;
+	if (a->rank > b->rank)
+		return 1;
+	return (a->index - b->index);
+}
+
+static List *
+codegen_reorder_quals(codegen_context *context, List *quals, bool is_and)
+{
+	PlannerInfo *root = context->root;
+	codegen_qual_rank *items;
+	List	   *result = NIL;
+	ListCell   *lc;
+	bool		reordered = false;
+	int			i, nitems = list_length(quals);
+
+	if (!root || nitems < 2)
+		return quals;
+	items = palloc(sizeof(codegen_qual_rank) * nitems);
+	i = 0;
+	foreach (lc, quals)
+	{
+		Expr	   *qual = lfirst(lc);
+		QualCost	qcost;
+		Relids		relids;
+		int			relid;
+		Selectivity	sel = 0.5;	/* unknown */
+		double		cost;
+
+		cost_qual_eval_node(&qcost, (Node *)qual, root);
+		cost = Max(qcost.per_tuple, 1.0e-6);
+		/*
+		 * NOTE: clause_selectivity() with no SpecialJoinInfo is only safe
+		 * for the clauses that reference a particular base relation.
+		 */
+		relids = pull_varnos(root, (Node *)qual);
+		if (bms_get_singleton_member(relids, &relid) &&
+			relid < root->simple_rel_array_size &&
+			root->simple_rel_array[relid] != NULL)
+			sel = clause_selectivity(root, (Node *)qual, 0, JOIN_INNER, NULL);
+		sel = Min(Max(sel, 1.0e-6), 1.0 - 1.0e-6);
+
+		items[i].expr  = qual;
+		items[i].rank  = (is_and ? cost / (1.0 - sel) : cost / sel);
+		items[i].index = i;
+		i++;
+	}
+	qsort(items, nitems, sizeof(codegen_qual_rank),
+		  __codegen_qual_rank_comp);
+	for (i=0; i < nitems; i++)
+	{
+		if (items[i].index != i)
+			reordered = true;
+		result = lappend(result, items[i].expr);
+	}
+	pfree(items);
+	if (!reordered)
+	{
+		list_free(result);
+		return quals;
+	}
+	return result;
+}
+
 static int
 codegen_bool_expression(codegen_context *context,
 						StringInfo buf, int curr_depth,
@@ -1906,6 +3979,21 @@ codegen_bool_expression(codegen_context *context,
 	int				pos = -1;
 	ListCell	   *lc;
 
+	/* cheap and decisive arguments first */
+	if (buf && b->boolop != NOT_EXPR)
+	{
+		List	   *args = codegen_reorder_quals(context, b->args,
+												 b->boolop == AND_EXPR);
+		if (args != b->args)
+		{
+			BoolExpr   *__b = (BoolExpr *)makeBoolExpr(b->boolop, args,
+													   b->location);
+			/* CSE shall see the first argument in the new order */
+			if (context->cse_parent == (Expr *)b)
+				context->cse_parent = (Expr *)__b;
+			b = __b;
+		}
+	}
 	memset(&kexp, 0, sizeof(kexp));
 	switch (b->boolop)
 	{
@@ -2434,6 +4522,134 @@ codegen_casewhen_expression(codegen_context *context,
 	return 0;
 }
 
+/*
+ * __codegen_saop_hashset
+ *
+ * It builds kern_saop_hashset of the constant array elements. Hash values
+ * are computed by the host version of the device hash function, like the
+ * inner buffer of GpuHashJoin. It returns the position on the buffer.
+ */
+static int
+__codegen_saop_hashset(StringInfo buf, devtype_info *dtype_e,
+					   ArrayType *array)
+{
+	kern_saop_hashset *hset;
+	kern_saop_hitem *hitems;
+	Datum	   *values;
+	bool	   *nulls;
+	int			nelems;
+	uint32_t	nitems = 0;
+	uint32_t	nslots;
+	size_t		items_offset;
+	size_t		offset;
+	int			head;
+
+	deconstruct_array(array,
+					  dtype_e->type_oid,
+					  dtype_e->type_length,
+					  dtype_e->type_byval,
+					  dtype_e->type_align,
+					  &values, &nulls, &nelems);
+	for (int i=0; i < nelems; i++)
+	{
+		if (!nulls[i])
+			nitems++;
+	}
+	nslots = Max(nitems + nitems / 2, 1);
+	items_offset = MAXALIGN(offsetof(kern_saop_hashset, slots[nslots]));
+	offset = items_offset + MAXALIGN(sizeof(kern_saop_hitem) * nitems);
+	for (int i=0; i < nelems; i++)
+	{
+		if (nulls[i])
+			continue;
+		if (dtype_e->type_length > 0)
+			offset += MAXALIGN(dtype_e->type_length);
+		else
+			offset += MAXALIGN(VARSIZE_ANY(DatumGetPointer(values[i])));
+	}
+	if (offset >= UINT_MAX)
+		elog(ERROR, "ScalarArrayOp hash-set is too large (%zu bytes)", offset);
+
+	head = __appendZeroStringInfo(buf, offset);
+	hset = (kern_saop_hashset *)(buf->data + head);
+	hset->nslots = nslots;
+	hset->items_offset = items_offset;
+	hitems = (kern_saop_hitem *)((char *)hset + items_offset);
+	offset = items_offset + MAXALIGN(sizeof(kern_saop_hitem) * nitems);
+	for (int i=0; i < nelems; i++)
+	{
+		kern_saop_hitem *hitem;
+		char	   *addr = (char *)hset + offset;
+		uint32_t	hindex;
+
+		if (nulls[i])
+		{
+			hset->has_nulls = true;
+			continue;
+		}
+		hitem = &hitems[hset->nitems++];
+		hitem->hash = dtype_e->type_hashfunc(false, values[i]);
+		hitem->offset = offset;
+		hindex = hitem->hash % nslots;
+		hitem->next = hset->slots[hindex];
+		hset->slots[hindex] = hset->nitems;
+
+		if (dtype_e->type_byval)
+		{
+			store_att_byval(addr, values[i], dtype_e->type_length);
+			offset += MAXALIGN(dtype_e->type_length);
+		}
+		else if (dtype_e->type_length > 0)
+		{
+			memcpy(addr, DatumGetPointer(values[i]), dtype_e->type_length);
+			offset += MAXALIGN(dtype_e->type_length);
+		}
+		else
+		{
+			size_t	sz = VARSIZE_ANY(DatumGetPointer(values[i]));
+
+			memcpy(addr, DatumGetPointer(values[i]), sz);
+			offset += MAXALIGN(sz);
+		}
+	}
+	Assert(hset->nitems == nitems);
+	pfree(values);
+	pfree(nulls);
+
+	return head;
+}
+
+/*
+ * __codegen_saop_hashable
+ *
+ * 'SCALAR = ANY(constant array)' with many elements is evaluated by the
+ * hash set, instead of the linear walk on the array for each row.
+ */
+static bool
+__codegen_saop_hashable(ScalarArrayOpExpr *sa_op, Oid opno,
+						Expr *expr_a,
+						devtype_info *dtype_s,
+						devtype_info *dtype_e)
+{
+	Const	   *con = (Const *)expr_a;
+	ArrayType  *array;
+
+	if (pgstrom_saop_hash_threshold <= 0 ||
+		!sa_op->useOr ||
+		!IsA(con, Const) ||
+		con->constisnull ||
+		dtype_s->type_code != dtype_e->type_code ||
+		!dtype_e->type_hashfunc ||
+		dtype_e->type_length < -1 ||
+		!op_hashjoinable(opno, dtype_s->type_oid) ||
+		(OidIsValid(sa_op->inputcollid) &&
+		 !get_collation_isdeterministic(sa_op->inputcollid)))
+		return false;
+	array = DatumGetArrayTypeP(con->constvalue);
+	return (ArrayGetNItems(ARR_NDIM(array),
+						   ARR_DIMS(array)) >= pgstrom_saop_hash_threshold);
+}
+
 /*
  * codegen_scalar_array_op_expression
  */
@@ -2447,8 +4663,10 @@ codegen_scalar_array_op_expression(codegen_context *context,
 	devfunc_info   *dfunc;
 	Oid				type_oid;
 	Oid				func_oid;
+	Oid				opno = sa_op->opno;
 	Oid				argtypes[2];
 	int				pos = -1, __pos = -1;
+	bool			use_hash;
 	codegen_kvar_defitem *kvdef;
 	kern_expression	kexp;
 
@@ -2488,6 +4706,7 @@ codegen_scalar_array_op_expression(codegen_context *context,
 		dtype_s = dtype_temp;
 		opcode = get_commutator(sa_op->opno);
 		func_oid = get_opcode(opcode);
+		opno = opcode;
 	}
 	else
 	{
@@ -2507,6 +4726,7 @@ codegen_scalar_array_op_expression(codegen_context *context,
 		dfunc->func_nargs != 2)
 		__Elog("function %s is not a binary boolean function",
 			   format_procedure(func_oid));
+	use_hash = __codegen_saop_hashable(sa_op, opno, expr_a, dtype_s, dtype_e);
 	/* allocation of kvar-slot for the temporary element variables */
 	kvdef = palloc0(sizeof(codegen_kvar_defitem));
 	kvdef->kv_slot_id = list_length(context->kvars_deflist);
@@ -2530,7 +4750,9 @@ codegen_scalar_array_op_expression(codegen_context *context,
 		memset(&kexp, 0, sizeof(kexp));
 		kexp.exptype     = TypeOpCode__bool;
 		kexp.expflags    = context->kexp_flags;
-		kexp.opcode      = (sa_op->useOr
+		kexp.opcode      = (use_hash
+							? FuncOpCode__ScalarArrayOpHash
+							: sa_op->useOr
 							? FuncOpCode__ScalarArrayOpAny
 							: FuncOpCode__ScalarArrayOpAll);
 		kexp.nr_args     = 2;
@@ -2538,8 +4760,12 @@ codegen_scalar_array_op_expression(codegen_context *context,
 		kexp.u.saop.elem_slot_id = kvdef->kv_slot_id;
 		pos = __appendBinaryStringInfo(buf, &kexp, kexp.args_offset);
 	}
-	/* 1st arg - array-expression to be walked on */
-	if (codegen_expression_walker(context, buf, curr_depth, expr_a) < 0)
+	/*
+	 * 1st arg - array-expression to be walked on, or the scalar-expression
+	 * to probe the hash set.
+	 */
+	if (codegen_expression_walker(context, buf, curr_depth,
+								  use_hash ? expr_s : expr_a) < 0)
 		return -1;
 	/* 2nd arg - comparator function */
 	if (buf)
@@ -2570,12 +4796,394 @@ codegen_scalar_array_op_expression(codegen_context *context,
 		elem_pos = __appendBinaryStringInfo(buf, &kexp, SizeOfKernExprVar);
 		__appendKernExpMagicAndLength(buf, elem_pos);
 	}
-	/* terminate the epression */
-	if (buf)
+	/* terminate the epression */
+	if (buf)
+	{
+		__appendKernExpMagicAndLength(buf, __pos);
+		if (use_hash)
+		{
+			Const  *con = (Const *)expr_a;
+			int		hset_pos;
+
+			hset_pos = __codegen_saop_hashset(buf, dtype_e,
+											  DatumGetArrayTypeP(con->constvalue));
+			((kern_expression *)(buf->data + pos))->u.saop.hset_offset
+				= hset_pos - pos;
+		}
+		__appendKernExpMagicAndLength(buf, pos);
+	}
+	return 0;
+}
+
+/*
+ * __codegen_alloc_source_kvar_defitem
+ *
+ * It allocates a temporary kvar-slot of the source composite/array type
+ * for FieldSelect and SubscriptingRef. The slot itself is never loaded,
+ * but its sub-field descriptors are used by the device code to extract
+ * the attribute or element.
+ */
+static codegen_kvar_defitem *
+__codegen_alloc_source_kvar_defitem(codegen_context *context,
+									int curr_depth,
+									devtype_info *dtype)
+{
+	codegen_kvar_defitem *kvdef;
+
+	kvdef = palloc0(sizeof(codegen_kvar_defitem));
+	kvdef->kv_slot_id = list_length(context->kvars_deflist);
+	kvdef->kv_depth = -1;
+	kvdef->kv_resno = InvalidAttrNumber;
+	kvdef->kv_maxref = curr_depth;
+	kvdef->kv_offset = -1;
+	kvdef->kv_type_oid = dtype->type_oid;
+	kvdef->kv_type_code = dtype->type_code;
+	kvdef->kv_typbyval = dtype->type_byval;
+	kvdef->kv_typalign = dtype->type_align;
+	kvdef->kv_typlen = dtype->type_length;
+	kvdef->kv_expr = (Expr *)makeNullConst(dtype->type_oid, -1, InvalidOid);
+	__assign_codegen_kvar_defitem_subfields(kvdef);
+	context->kvars_deflist = lappend(context->kvars_deflist, kvdef);
+
+	return kvdef;
+}
+
+/*
+ * codegen_fieldselect_expression
+ */
+static int
+codegen_fieldselect_expression(codegen_context *context,
+							   StringInfo buf, int curr_depth,
+							   FieldSelect *fselect)
+{
+	devtype_info   *dtype_c, *dtype_f;
+	codegen_kvar_defitem *kvdef;
+	kern_expression	kexp;
+	Oid				type_oid;
+	int				pos = -1;
+
+	type_oid = exprType((Node *)fselect->arg);
+	dtype_c = pgstrom_devtype_lookup(type_oid);
+	if (!dtype_c || dtype_c->type_code != TypeOpCode__composite)
+		__Elog("composite type %s is not device supported",
+			   format_type_be(type_oid));
+	if (fselect->fieldnum < 1 ||
+		fselect->fieldnum > dtype_c->comp_nfields)
+		__Elog("FieldSelect refers out of range attribute (%d) of %s",
+			   (int)fselect->fieldnum, format_type_be(type_oid));
+	dtype_f = pgstrom_devtype_lookup(fselect->resulttype);
+	if (!dtype_f)
+		__Elog("type %s is not device supported",
+			   format_type_be(fselect->resulttype));
+	kvdef = __codegen_alloc_source_kvar_defitem(context, curr_depth, dtype_c);
+	if (buf)
+	{
+		memset(&kexp, 0, sizeof(kexp));
+		kexp.exptype = dtype_f->type_code;
+		kexp.expflags = context->kexp_flags;
+		kexp.opcode = FuncOpCode__FieldSelectExpr;
+		kexp.nr_args = 1;
+		kexp.args_offset = offsetof(kern_expression, u.fsel.data);
+		kexp.u.fsel.src_slot_id = kvdef->kv_slot_id;
+		kexp.u.fsel.fieldnum = fselect->fieldnum;
+		pos = __appendBinaryStringInfo(buf, &kexp, kexp.args_offset);
+	}
+	if (codegen_expression_walker(context, buf, curr_depth, fselect->arg) < 0)
+		return -1;
+	if (buf)
+		__appendKernExpMagicAndLength(buf, pos);
+	return 0;
+}
+
+/*
+ * codegen_subscripting_expression
+ *
+ * Only element fetch of the array by a single subscript is supported.
+ */
+static int
+codegen_subscripting_expression(codegen_context *context,
+								StringInfo buf, int curr_depth,
+								SubscriptingRef *sref)
+{
+	devtype_info   *dtype_a;
+	Expr		   *index;
+	codegen_kvar_defitem *kvdef;
+	kern_expression	kexp;
+	int				pos = -1;
+
+	if (sref->refassgnexpr)
+		__Elog("SubscriptingRef for assignment is not supported");
+	if (sref->reflowerindexpr != NIL ||
+		list_length(sref->refupperindexpr) != 1)
+		__Elog("only single subscript of the array is supported");
+	dtype_a = pgstrom_devtype_lookup(sref->refcontainertype);
+	if (!dtype_a || dtype_a->type_code != TypeOpCode__array)
+		__Elog("type %s is not a device supported array",
+			   format_type_be(sref->refcontainertype));
+	if (dtype_a->type_element->type_oid != sref->refrestype)
+		__Elog("SubscriptingRef returns unexpected type: %s",
+			   format_type_be(sref->refrestype));
+	index = linitial(sref->refupperindexpr);
+	if (exprType((Node *)index) != INT4OID)
+		__Elog("array subscript must be int4");
+	kvdef = __codegen_alloc_source_kvar_defitem(context, curr_depth, dtype_a);
+	if (buf)
+	{
+		memset(&kexp, 0, sizeof(kexp));
+		kexp.exptype = dtype_a->type_element->type_code;
+		kexp.expflags = context->kexp_flags;
+		kexp.opcode = FuncOpCode__ArraySubscriptExpr;
+		kexp.nr_args = 2;
+		kexp.args_offset = offsetof(kern_expression, u.fsel.data);
+		kexp.u.fsel.src_slot_id = kvdef->kv_slot_id;
+		pos = __appendBinaryStringInfo(buf, &kexp, kexp.args_offset);
+	}
+	if (codegen_expression_walker(context, buf, curr_depth, sref->refexpr) < 0)
+		return -1;
+	if (codegen_expression_walker(context, buf, curr_depth, index) < 0)
+		return -1;
+	if (buf)
+		__appendKernExpMagicAndLength(buf, pos);
+	return 0;
+}
+
+/*
+ * Common sub-expression elimination
+ *
+ * When an identical sub-expression appears twice or more in a kernel
+ * expression tree, the first occurrence is wrapped by SaveExpr to keep
+ * the result on a temporary kvar-slot, then the later occurrences just
+ * reference the slot using VarExpr.
+ * Some expressions (AND/OR, CASE, COALESCE and ScalarArrayOp) may skip
+ * evaluation of their arguments except for the first one, so a slot
+ * saved under these arguments is valid only within the argument.
+ */
+typedef struct
+{
+	Expr	   *cse_expr;		/* the common sub-expression */
+	int			cse_nrefs;		/* number of occurrences */
+	int			cse_slot_id;	/* kvar-slot, or -1 if not assigned yet */
+	int			cse_level;		/* conditional level where it is saved,
+								 * or -1 if not saved yet */
+	int			cse_pos;		/* position of SaveExpr in the buffer */
+} codegen_cse_item;
+
+static bool
+__codegen_cse_has_casetest(Node *node, void *__priv)
+{
+	if (!node)
+		return false;
+	if (IsA(node, CaseTestExpr))
+		return true;
+	return expression_tree_walker(node, __codegen_cse_has_casetest, __priv);
+}
+
+static bool
+__codegen_cse_collect_walker(Node *node, List **p_items)
+{
+	if (!node)
+		return false;
+	if ((IsA(node, FuncExpr) ||
+		 IsA(node, OpExpr) ||
+		 IsA(node, CoerceViaIO)) &&
+		!contain_volatile_functions(node) &&
+		!__codegen_cse_has_casetest(node, NULL))
+	{
+		codegen_cse_item *cse;
+		ListCell   *lc;
+
+		foreach (lc, *p_items)
+		{
+			cse = lfirst(lc);
+			if (equal(node, cse->cse_expr))
+			{
+				/* sub-expressions shall be eliminated together */
+				cse->cse_nrefs++;
+				return false;
+			}
+		}
+		cse = palloc0(sizeof(codegen_cse_item));
+		cse->cse_expr = (Expr *)node;
+		cse->cse_nrefs = 1;
+		cse->cse_slot_id = -1;
+		cse->cse_level = -1;
+		*p_items = lappend(*p_items, cse);
+	}
+	return expression_tree_walker(node, __codegen_cse_collect_walker, p_items);
+}
+
+static void
+codegen_cse_begin(codegen_context *context, List *exprs)
+{
+	List	   *items = NIL;
+	ListCell   *lc;
+
+	context->cse_items = NIL;
+	context->cse_level = 0;
+	context->cse_parent = NULL;
+	if (!pgstrom_enable_codegen_cse)
+		return;
+	foreach (lc, exprs)
+		__codegen_cse_collect_walker(lfirst(lc), &items);
+	foreach (lc, items)
+	{
+		codegen_cse_item *cse = lfirst(lc);
+
+		if (cse->cse_nrefs > 1)
+			context->cse_items = lappend(context->cse_items, cse);
+	}
+	list_free(items);
+}
+
+static void
+codegen_cse_end(codegen_context *context)
+{
+	list_free_deep(context->cse_items);
+	context->cse_items = NIL;
+	context->cse_level = 0;
+	context->cse_parent = NULL;
+}
+
+/*
+ * codegen_cse_revert - invalidates the saved slots, when the caller
+ * reverts the buffer to the 'pos'.
+ */
+static void
+codegen_cse_revert(codegen_context *context, int pos)
+{
+	ListCell   *lc;
+
+	foreach (lc, context->cse_items)
+	{
+		codegen_cse_item *cse = lfirst(lc);
+
+		if (cse->cse_level >= 0 && cse->cse_pos >= pos)
+			cse->cse_level = -1;
+	}
+}
+
+/*
+ * __codegen_cse_is_conditional - checks whether the 'expr' may not be
+ * evaluated, even if its 'parent' expression is evaluated.
+ */
+static bool
+__codegen_cse_is_conditional(Expr *parent, Expr *expr)
+{
+	if (!parent)
+		return false;
+	switch (nodeTag(parent))
+	{
+		case T_BoolExpr:
+			return (linitial(((BoolExpr *)parent)->args) != expr);
+		case T_CoalesceExpr:
+			return (linitial(((CoalesceExpr *)parent)->args) != expr);
+		case T_CaseExpr:
+			{
+				CaseExpr   *caseexpr = (CaseExpr *)parent;
+
+				if (caseexpr->arg)
+					return (caseexpr->arg != expr);
+				return (((CaseWhen *)linitial(caseexpr->args))->expr != expr);
+			}
+		case T_ScalarArrayOpExpr:
+			return (lsecond(((ScalarArrayOpExpr *)parent)->args) != expr);
+		default:
+			break;
+	}
+	return false;
+}
+
+static int	__codegen_expression_walker(codegen_context *context,
+										StringInfo buf, int curr_depth,
+										Expr *expr);
+
+static int
+__codegen_cse_expression(codegen_context *context,
+						 StringInfo buf, int curr_depth,
+						 Expr *expr)
+{
+	codegen_cse_item *cse = NULL;
+	codegen_kvar_defitem *kvdef;
+	kern_expression kexp;
+	ListCell   *lc;
+	int			pos;
+
+	foreach (lc, context->cse_items)
+	{
+		codegen_cse_item *__cse = lfirst(lc);
+
+		if (__cse->cse_slot_id >= -1 &&
+			equal(expr, __cse->cse_expr))
+		{
+			cse = __cse;
+			break;
+		}
+	}
+	if (!cse)
+		return __codegen_expression_walker(context, buf, curr_depth, expr);
+
+	if (cse->cse_level >= 0)
+	{
+		/* reference to the result already saved */
+		kvdef = list_nth(context->kvars_deflist, cse->cse_slot_id);
+		memset(&kexp, 0, sizeof(kexp));
+		kexp.exptype  = kvdef->kv_type_code;
+		kexp.expflags = context->kexp_flags;
+		kexp.opcode   = FuncOpCode__VarExpr;
+		kexp.u.v.var_slot_id = kvdef->kv_slot_id;
+		kexp.u.v.var_offset = -1;
+		pos = __appendBinaryStringInfo(buf, &kexp, SizeOfKernExprVar);
+		__appendKernExpMagicAndLength(buf, pos);
+		return 0;
+	}
+
+	if (cse->cse_slot_id < 0)
 	{
-		__appendKernExpMagicAndLength(buf, __pos);
-		__appendKernExpMagicAndLength(buf, pos);
+		/* allocation of kvar-slot for the temporary result */
+		kvdef = palloc0(sizeof(codegen_kvar_defitem));
+		kvdef->kv_slot_id   = list_length(context->kvars_deflist);
+		kvdef->kv_depth     = -1;
+		kvdef->kv_resno     = InvalidAttrNumber;
+		kvdef->kv_maxref    = curr_depth;
+		kvdef->kv_offset    = -1;
+		kvdef->kv_type_oid  = exprType((Node *)expr);
+		if (!__assign_codegen_kvar_defitem_type_params(kvdef->kv_type_oid,
+													   &kvdef->kv_type_code,
+													   &kvdef->kv_typbyval,
+													   &kvdef->kv_typalign,
+													   &kvdef->kv_typlen,
+													   &kvdef->kv_xdatum_sizeof,
+													   NULL,
+													   false))
+		{
+			/* not eligible for elimination */
+			pfree(kvdef);
+			cse->cse_slot_id = -2;
+			return __codegen_expression_walker(context, buf, curr_depth, expr);
+		}
+		kvdef->kv_expr      = expr;
+		__assign_codegen_kvar_defitem_subfields(kvdef);
+		context->kvars_deflist = lappend(context->kvars_deflist, kvdef);
+		cse->cse_slot_id = kvdef->kv_slot_id;
 	}
+	else
+		kvdef = list_nth(context->kvars_deflist, cse->cse_slot_id);
+
+	memset(&kexp, 0, sizeof(kexp));
+	kexp.exptype  = kvdef->kv_type_code;
+	kexp.expflags = context->kexp_flags;
+	kexp.opcode   = FuncOpCode__SaveExpr;
+	kexp.nr_args  = 1;
+	kexp.args_offset = MAXALIGN(offsetof(kern_expression,
+										 u.save.data));
+	kexp.u.save.sv_slot_id = kvdef->kv_slot_id;
+	pos = __appendBinaryStringInfo(buf, &kexp, kexp.args_offset);
+	if (__codegen_expression_walker(context, buf, curr_depth, expr) < 0)
+		return -1;
+	__appendKernExpMagicAndLength(buf, pos);
+	/* later occurrences can reference the slot */
+	cse->cse_level = context->cse_level;
+	cse->cse_pos = pos;
 	return 0;
 }
 
@@ -2583,6 +5191,43 @@ static int
 codegen_expression_walker(codegen_context *context,
 						  StringInfo buf, int curr_depth,
 						  Expr *expr)
+{
+	Expr	   *saved_parent;
+	bool		conditional;
+	int			retval;
+	ListCell   *lc;
+
+	if (!expr)
+		return 0;
+	if (!buf || context->cse_items == NIL)
+		return __codegen_expression_walker(context, buf, curr_depth, expr);
+
+	saved_parent = context->cse_parent;
+	conditional = __codegen_cse_is_conditional(saved_parent, expr);
+	if (conditional)
+		context->cse_level++;
+	context->cse_parent = expr;
+	retval = __codegen_cse_expression(context, buf, curr_depth, expr);
+	context->cse_parent = saved_parent;
+	if (conditional)
+	{
+		/* slots saved under the conditional argument are no longer valid */
+		foreach (lc, context->cse_items)
+		{
+			codegen_cse_item *cse = lfirst(lc);
+
+			if (cse->cse_level >= context->cse_level)
+				cse->cse_level = -1;
+		}
+		context->cse_level--;
+	}
+	return retval;
+}
+
+static int
+__codegen_expression_walker(codegen_context *context,
+							StringInfo buf, int curr_depth,
+							Expr *expr)
 {
 	if (!expr)
 		return 0;
@@ -2637,6 +5282,12 @@ codegen_expression_walker(codegen_context *context,
 		case T_ScalarArrayOpExpr:
 			return codegen_scalar_array_op_expression(context, buf, curr_depth,
 													  (ScalarArrayOpExpr *)expr);
+		case T_FieldSelect:
+			return codegen_fieldselect_expression(context, buf, curr_depth,
+												  (FieldSelect *)expr);
+		case T_SubscriptingRef:
+			return codegen_subscripting_expression(context, buf, curr_depth,
+												   (SubscriptingRef *)expr);
 		case T_CoerceToDomain:
 		default:
 			__Elog("not a supported expression type: %s", nodeToString(expr));
@@ -2661,30 +5312,80 @@ kern_varload_desc_comp(const void *__a, const void *__b)
 	return 0;
 }
 
+/*
+ * __codegen_loadvars_is_proj_only
+ *
+ * It checks whether the kvar at depth==0 is never referenced by the scan
+ * quals, so its load can be deferred until the row passes the scan quals.
+ * Only simple Var-references are deferred; other kvars (like virtual
+ * columns of GpuCache) are always loaded prior to the scan quals.
+ */
+static bool
+__codegen_loadvars_is_proj_only(codegen_context *context,
+								codegen_kvar_defitem *kvdef,
+								Bitmapset *qual_attrs)
+{
+	Var	   *var = (Var *)kvdef->kv_expr;
+
+	if (!var || !IsA(var, Var) ||
+		var->varno != context->scan_relid ||
+		var->varattno != kvdef->kv_resno)
+		return false;
+	return !bms_is_member(kvdef->kv_resno - FirstLowInvalidHeapAttributeNumber,
+						  qual_attrs);
+}
+
 static kern_expression *
-__codegen_build_loadvars_one(codegen_context *context, int depth)
+__codegen_build_loadvars_one(codegen_context *context, int depth,
+							 List *scan_quals)
 {
 	kern_expression *kexp;
 	StringInfoData buf;
 	int			nrooms = list_length(context->kvars_deflist);
 	int			nitems = 0;
+	int			proj_nitems = 0;
+	Bitmapset  *qual_attrs = NULL;
+	bool		lazy_load = false;
 	ListCell   *lc;
 
+	/*
+	 * Columns only referenced by the later steps are loaded after the scan
+	 * quals, unless the scan quals have whole-row reference.
+	 */
+	if (depth == 0 && scan_quals != NIL)
+	{
+		pull_varattnos((Node *)scan_quals, context->scan_relid, &qual_attrs);
+		lazy_load = !bms_is_member(InvalidAttrNumber -
+								   FirstLowInvalidHeapAttributeNumber,
+								   qual_attrs);
+	}
 	kexp = alloca(offsetof(kern_expression, u.load.desc[nrooms+1]));
 	memset(kexp, 0, offsetof(kern_expression, u.load.desc));
-	foreach (lc, context->kvars_deflist)
+	for (int loop=0; loop < 2; loop++)
 	{
-		codegen_kvar_defitem *kvdef = lfirst(lc);
-
-		if (kvdef->kv_depth == depth)
+		foreach (lc, context->kvars_deflist)
 		{
-			kern_varload_desc  *vl_desc = &kexp->u.load.desc[nitems++];
+			codegen_kvar_defitem *kvdef = lfirst(lc);
+			bool		proj_only;
+
+			if (kvdef->kv_depth != depth)
+				continue;
+			proj_only = (lazy_load &&
+						 __codegen_loadvars_is_proj_only(context, kvdef,
+														 qual_attrs));
+			if (proj_only == (loop > 0))
+			{
+				kern_varload_desc  *vl_desc = &kexp->u.load.desc[nitems++];
 
-			memset(vl_desc, 0, sizeof(kern_varload_desc));
-			vl_desc->vl_resno     = kvdef->kv_resno;
-			vl_desc->vl_slot_id   = kvdef->kv_slot_id;
+				memset(vl_desc, 0, sizeof(kern_varload_desc));
+				vl_desc->vl_resno     = kvdef->kv_resno;
+				vl_desc->vl_slot_id   = kvdef->kv_slot_id;
+				if (loop > 0)
+					proj_nitems++;
+			}
 		}
 	}
+	bms_free(qual_attrs);
 	if (nitems == 0)
 		return NULL;
 	kexp->exptype  = TypeOpCode__int4;
@@ -2694,8 +5395,14 @@ __codegen_build_loadvars_one(codegen_context *context, int depth)
 										  u.load.desc[nitems]));
 	kexp->u.load.depth = depth;
 	kexp->u.load.nitems = nitems;
+	kexp->u.load.proj_nitems = proj_nitems;
+	/* both groups must be sorted by resno individually */
 	qsort(kexp->u.load.desc,
-		  nitems,
+		  nitems - proj_nitems,
+		  sizeof(kern_varload_desc),
+		  kern_varload_desc_comp);
+	qsort(kexp->u.load.desc + (nitems - proj_nitems),
+		  proj_nitems,
 		  sizeof(kern_varload_desc),
 		  kern_varload_desc_comp);
 	initStringInfo(&buf);
@@ -2727,7 +5434,8 @@ codegen_build_packed_kvars_load(codegen_context *context, pgstromPlanInfo *pp_in
 	buf.len = sz;
 	for (int depth=0; depth <= context->kvecs_ndims; depth++)
 	{
-		karg = __codegen_build_loadvars_one(context, depth);
+		karg = __codegen_build_loadvars_one(context, depth,
+											pp_info->scan_quals);
 		if (karg)
 		{
 			kexp->u.pack.offset[depth]
@@ -2778,7 +5486,8 @@ __codegen_build_movevars_one(codegen_context *context, int depth, int gist_depth
 		if ((kvdef->kv_depth >= 0 &&
 			 kvdef->kv_depth <= depth &&
 			 kvdef->kv_maxref > depth) ||
-			(kvdef->kv_depth == gist_depth &&
+			(gist_depth >= 0 &&
+			 kvdef->kv_depth == gist_depth &&
 			 kvdef->kv_maxref == depth+1))
 		{
 			kern_varmove_desc  *vm_desc = &kexp->u.move.desc[nitems++];
@@ -2892,12 +5601,14 @@ codegen_build_scan_quals(codegen_context *context, List *dev_quals)
 
 	initStringInfo(&buf);
 	context->curr_depth = 0;
+	codegen_cse_begin(context, list_make1(expr));
 	if (codegen_expression_walker(context, &buf, 0, expr) == 0)
 	{
 		xpucode = palloc(VARHDRSZ+buf.len);
 		memcpy(xpucode->vl_dat, buf.data, buf.len);
 		SET_VARSIZE(xpucode, VARHDRSZ+buf.len);
 	}
+	codegen_cse_end(context);
 	pfree(buf.data);
 	context->curr_depth = saved_depth;
 
@@ -2924,6 +5635,7 @@ try_inject_projection_expression(codegen_context *context,
 		if (kvdef->kv_slot_id == proj_slot_id)
 		{
 			buf->len = pos;
+			codegen_cse_revert(context, pos);
 			goto bailout;
 		}
 	}
@@ -2944,6 +5656,7 @@ codegen_build_projection(codegen_context *context)
 	bool		meet_resjunk = false;
 	int			nattrs = 0;
 	int			sz;
+	List	   *proj_exprs = NIL;
 	ListCell   *lc;
 
 	/* count nattrs */
@@ -2959,7 +5672,10 @@ codegen_build_projection(codegen_context *context)
 		else if (meet_resjunk)
 			elog(ERROR, "Bug? a valid TLE after junk TLEs");
 		else
+		{
+			proj_exprs = lappend(proj_exprs, tle->expr);
 			nattrs++;
+		}
 	}
 	sz = MAXALIGN(offsetof(kern_expression, u.proj.slot_id[nattrs]));
 	kexp = alloca(sz);
@@ -2967,6 +5683,7 @@ codegen_build_projection(codegen_context *context)
 
 	initStringInfo(&buf);
 	buf.len = sz;
+	codegen_cse_begin(context, proj_exprs);
 	foreach (lc, context->tlist_dev)
 	{
 		TargetEntry	*tle = lfirst(lc);
@@ -2980,6 +5697,7 @@ codegen_build_projection(codegen_context *context)
 												 tle->expr);
 		kexp->u.proj.slot_id[kexp->u.proj.nattrs++] = kvdef->kv_slot_id;
 	}
+	codegen_cse_end(context);
 	Assert(nattrs == kexp->u.proj.nattrs);
 	kexp->exptype = TypeOpCode__int4;
 	kexp->expflags = context->kexp_flags;
@@ -3024,6 +5742,9 @@ __codegen_build_joinquals(codegen_context *context,
 	kexp.args_offset = SizeOfKernExpr(0);
 	__appendBinaryStringInfo(&buf, &kexp, SizeOfKernExpr(0));
 
+	join_quals = codegen_reorder_quals(context, join_quals, true);
+	other_quals = codegen_reorder_quals(context, other_quals, true);
+	codegen_cse_begin(context, list_concat_copy(join_quals, other_quals));
 	foreach (lc, join_quals)
 	{
 		Expr   *qual = lfirst(lc);
@@ -3046,6 +5767,7 @@ __codegen_build_joinquals(codegen_context *context,
 			return NULL;
 	}
 	context->kexp_flags = kexp_flags__saved;
+	codegen_cse_end(context);
 	__appendKernExpMagicAndLength(&buf, 0);
 
 	return (kern_expression *)buf.data;
@@ -3208,6 +5930,177 @@ codegen_build_packed_hashkeys(codegen_context *context,
 	return (bytea *)result;
 }
 
+/*
+ * codegen_build_packed_rangekeys
+ *
+ * It builds RangeKeys expressions for the depths of range-join; arguments
+ * are the outer expressions of the lower and/or upper bounds of the inner
+ * key, to be evaluated at the depth.
+ */
+bytea *
+codegen_build_packed_rangekeys(codegen_context *context,
+							   pgstromPlanInfo *pp_info)
+{
+	kern_expression *kexp;
+	StringInfoData buf;
+	int			nrels = pp_info->num_rels;
+	size_t		sz;
+	char	   *result = NULL;
+
+	sz = MAXALIGN(offsetof(kern_expression, u.pack.offset[nrels+1]));
+	kexp = alloca(sz);
+	memset(kexp, 0, sz);
+	kexp->exptype = TypeOpCode__int4;
+	kexp->expflags = context->kexp_flags;
+	kexp->opcode  = FuncOpCode__Packed;
+	kexp->args_offset = sz;
+	kexp->u.pack.npacked = nrels + 1;
+
+	initStringInfo(&buf);
+	buf.len = sz;
+	for (int depth=1; depth <= nrels; depth++)
+	{
+		pgstromPlanInnerInfo *pp_inner = &pp_info->inners[depth-1];
+		devtype_info *dtype;
+		kern_expression	karg;
+		StringInfoData	temp;
+		size_t		karg_sz = MAXALIGN(offsetof(kern_expression, u.range.data));
+
+		if (!pp_inner->range_inner_key)
+			continue;
+		dtype = pgstrom_devtype_lookup(exprType((Node *)pp_inner->range_inner_key));
+		if (!dtype)
+			elog(ERROR, "failed on lookup device type of %s",
+				 nodeToString(pp_inner->range_inner_key));
+		memset(&karg, 0, sizeof(kern_expression));
+		karg.exptype = dtype->type_code;
+		karg.expflags = context->kexp_flags;
+		karg.opcode = FuncOpCode__RangeKeys;
+		karg.args_offset = karg_sz;
+		initStringInfo(&temp);
+		temp.len = karg_sz;
+		if (pp_inner->range_outer_lower)
+		{
+			codegen_expression_walker(context, &temp, depth,
+									  pp_inner->range_outer_lower);
+			karg.u.range.has_lower = true;
+			karg.nr_args++;
+		}
+		if (pp_inner->range_outer_upper)
+		{
+			codegen_expression_walker(context, &temp, depth,
+									  pp_inner->range_outer_upper);
+			karg.u.range.has_upper = true;
+			karg.nr_args++;
+		}
+		memcpy(temp.data, &karg, karg_sz);
+		__appendKernExpMagicAndLength(&temp, 0);
+
+		kexp->u.pack.offset[depth]
+			= __appendBinaryStringInfo(&buf, temp.data, temp.len);
+		kexp->nr_args++;
+		pfree(temp.data);
+	}
+
+	if (kexp->nr_args > 0)
+	{
+		memcpy(buf.data, kexp, sz);
+		__appendKernExpMagicAndLength(&buf, 0);
+		result = palloc(VARHDRSZ + buf.len);
+		memcpy(result + VARHDRSZ, buf.data, buf.len);
+		SET_VARSIZE(result, VARHDRSZ + buf.len);
+	}
+	pfree(buf.data);
+
+	return (bytea *)result;
+}
+
+/*
+ * codegen_build_bloom_filters
+ *
+ * It appends BloomFilter expressions of the supplied depths to the scan
+ * quals. The outer hash-value is evaluated at the depth-0, so the outer
+ * rows that never match the inner hash table are dropped prior to the
+ * MoveVars and the further JOIN.
+ */
+void
+codegen_build_bloom_filters(codegen_context *context,
+							pgstromPlanInfo *pp_info,
+							List *bloom_depths)
+{
+	kern_expression	kexp;
+	StringInfoData buf;
+	bytea	   *xpucode;
+	int			nr_args = 0;
+	ListCell   *lc;
+
+	if (bloom_depths == NIL)
+		return;
+	initStringInfo(&buf);
+	memset(&kexp, 0, sizeof(kexp));
+	kexp.exptype = TypeOpCode__bool;
+	kexp.expflags = context->kexp_flags;
+	kexp.opcode = FuncOpCode__BoolExpr_And;
+	kexp.args_offset = SizeOfKernExpr(0);
+	__appendBinaryStringInfo(&buf, &kexp, SizeOfKernExpr(0));
+	if (pp_info->kexp_scan_quals)
+	{
+		__appendBinaryStringInfo(&buf,
+								 VARDATA(pp_info->kexp_scan_quals),
+								 VARSIZE(pp_info->kexp_scan_quals) - VARHDRSZ);
+		nr_args++;
+	}
+	foreach (lc, bloom_depths)
+	{
+		int			depth = lfirst_int(lc);
+		pgstromPlanInnerInfo *pp_inner = &pp_info->inners[depth-1];
+		kern_expression *karg;
+		size_t		sz = MAXALIGN(offsetof(kern_expression, u.bloom.data));
+		int			pos;
+
+		karg = __codegen_build_hash_value(context,
+										  pp_inner->hash_outer_keys, 0);
+		if (!karg)
+			continue;
+		memset(&kexp, 0, sizeof(kexp));
+		kexp.exptype = TypeOpCode__bool;
+		kexp.expflags = context->kexp_flags;
+		kexp.opcode = FuncOpCode__BloomFilter;
+		kexp.nr_args = 1;
+		kexp.args_offset = sz;
+		kexp.u.bloom.depth = depth;
+		pos = __appendBinaryStringInfo(&buf, &kexp, sz);
+		__appendBinaryStringInfo(&buf, karg, karg->len);
+		__appendKernExpMagicAndLength(&buf, pos);
+		pfree(karg);
+		nr_args++;
+	}
+
+	if (nr_args == 0)
+	{
+		pfree(buf.data);
+		return;
+	}
+	else if (nr_args == 1)
+	{
+		/* BoolExpr(AND) is not necessary for a single qualifier */
+		memmove(buf.data, buf.data + SizeOfKernExpr(0),
+				buf.len - SizeOfKernExpr(0));
+		buf.len -= SizeOfKernExpr(0);
+	}
+	else
+	{
+		((kern_expression *)buf.data)->nr_args = nr_args;
+		__appendKernExpMagicAndLength(&buf, 0);
+	}
+	xpucode = palloc(VARHDRSZ + buf.len);
+	memcpy(VARDATA(xpucode), buf.data, buf.len);
+	SET_VARSIZE(xpucode, VARHDRSZ + buf.len);
+	pfree(buf.data);
+
+	pp_info->kexp_scan_quals = xpucode;
+}
+
 /*
  * codegen_build_packed_gistevals
  */
@@ -3218,6 +6111,7 @@ __codegen_build_one_gistquals(codegen_context *context,
 							  Oid	gist_func_oid,
 							  Oid	gist_index_oid,
 							  int	gist_index_col,
+							  Oid	gist_key_type,
 							  Expr *gist_func_arg)
 {
 	codegen_kvar_defitem *kvdef;
@@ -3233,8 +6127,7 @@ __codegen_build_one_gistquals(codegen_context *context,
 	uint32_t		htup_offset;
 
 	/* device GiST evaluation operator */
-	argtypes[0] = get_atttype(gist_index_oid,
-							  gist_index_col);
+	argtypes[0] = gist_key_type;
 	argtypes[1] = exprType((Node *)gist_func_arg);
 	dfunc = __pgstrom_devfunc_lookup(gist_func_oid,
 									 2, argtypes,
@@ -3388,6 +6281,7 @@ codegen_build_packed_gistevals(codegen_context *context,
 											pp_inner->gist_func_oid,
 											pp_inner->gist_index_oid,
 											pp_inner->gist_index_col,
+											pp_inner->gist_key_type,
 											gist_func_arg);
 		kexp->u.pack.offset[i+1] = off;
 		kexp->nr_args++;
@@ -3518,7 +6412,8 @@ codegen_build_groupby_keyload(codegen_context *context,
 		kern_expression	*kexp;
 		char	   *xpucode = NULL;
 
-		kexp = __codegen_build_loadvars_one(context, SPECIAL_DEPTH__PREAGG_FINAL);
+		kexp = __codegen_build_loadvars_one(context, SPECIAL_DEPTH__PREAGG_FINAL,
+											NIL);
 		if (kexp)
 		{
 			xpucode = palloc(VARHDRSZ + kexp->len);
@@ -3723,6 +6618,14 @@ __codegen_build_groupby_actions(codegen_context *context,
 
 			Assert(IsA(func, FuncExpr) && list_length(func->args) <= 2);
 			desc->action = action;
+			if (action == KAGG_ACTION__PSUM_NUMERIC ||
+				action == KAGG_ACTION__PAVG_NUMERIC)
+			{
+				int32	typmod = exprTypmod(linitial(func->args));
+
+				Assert(typmod >= (int32) VARHDRSZ);
+				desc->arg_scale = ((typmod - VARHDRSZ) & 0xffff);
+			}
 			foreach (cell, func->args)
 			{
 				Expr   *fn_arg = lfirst(cell);
@@ -3776,6 +6679,114 @@ codegen_build_groupby_actions(codegen_context *context,
 	__codegen_build_groupby_actions(context, pp_info);
 }
 
+/*
+ * xpu_expression_cache
+ *
+ * The planner repeats the same device-executable checks many times; for
+ * each xPU kind, for single/parallel paths, and for every child relation
+ * of the partitioned tables, even though the translated expressions of
+ * the children are identical except for the varno of the scan relation.
+ * So, we remember the result of pgstrom_xpu_expression() during a planner
+ * invocation, using the expression tree with normalized scan-relid as key.
+ */
+static HTAB	   *xpu_expression_htable = NULL;
+
+typedef struct
+{
+	uint32_t	xpu_task_flags;
+	char	   *expr_key;
+	bool		device_ok;
+	int			devcost;
+} xpuExpressionCacheEntry;
+
+static uint32
+xpu_expression_cache_hash(const void *key, Size keysize)
+{
+	const xpuExpressionCacheEntry *entry = key;
+
+	return (hash_bytes((const unsigned char *)&entry->xpu_task_flags,
+					   sizeof(uint32_t)) ^
+			hash_bytes((const unsigned char *)entry->expr_key,
+					   strlen(entry->expr_key)));
+}
+
+static int
+xpu_expression_cache_match(const void *key1, const void *key2, Size keysize)
+{
+	const xpuExpressionCacheEntry *entry1 = key1;
+	const xpuExpressionCacheEntry *entry2 = key2;
+
+	return (entry1->xpu_task_flags == entry2->xpu_task_flags &&
+			strcmp(entry1->expr_key, entry2->expr_key) == 0 ? 0 : -1);
+}
+
+/*
+ * pgstrom_begin_xpu_expression_cache / pgstrom_end_xpu_expression_cache
+ *
+ * The planner hook set up the cache on the beginning of planning, and
+ * releases it on the end. The previous one is saved for the nested
+ * planner invocations.
+ */
+HTAB *
+pgstrom_begin_xpu_expression_cache(void)
+{
+	HTAB	   *saved_htable = xpu_expression_htable;
+	HASHCTL		hctl;
+
+	memset(&hctl, 0, sizeof(HASHCTL));
+	hctl.hcxt = CurrentMemoryContext;
+	hctl.keysize = offsetof(xpuExpressionCacheEntry,
+							expr_key) + sizeof(char *);
+	hctl.entrysize = sizeof(xpuExpressionCacheEntry);
+	hctl.hash = xpu_expression_cache_hash;
+	hctl.match = xpu_expression_cache_match;
+	xpu_expression_htable = hash_create("PG-Strom xPU Expression Cache",
+										1024L,
+										&hctl,
+										HASH_ELEM |
+										HASH_FUNCTION |
+										HASH_COMPARE |
+										HASH_CONTEXT);
+	return saved_htable;
+}
+
+void
+pgstrom_end_xpu_expression_cache(HTAB *saved_htable)
+{
+	hash_destroy(xpu_expression_htable);
+	xpu_expression_htable = saved_htable;
+}
+
+static xpuExpressionCacheEntry *
+__lookup_xpu_expression_cache(Expr *expr,
+							  uint32_t xpu_task_flags,
+							  Index scan_relid,
+							  bool *p_found)
+{
+	xpuExpressionCacheEntry  hkey;
+	xpuExpressionCacheEntry *entry;
+
+	/* varno of the scan relation is normalized to share the result */
+	expr = copyObject(expr);
+	if (scan_relid > 0)
+		ChangeVarNodes((Node *)expr, scan_relid, 0, 0);
+	memset(&hkey, 0, sizeof(xpuExpressionCacheEntry));
+	hkey.xpu_task_flags = (xpu_task_flags & DEVKIND__ANY);
+	hkey.expr_key = nodeToString(expr);
+	entry = (xpuExpressionCacheEntry *)
+		hash_search(xpu_expression_htable,
+					&hkey,
+					HASH_ENTER,
+					p_found);
+	if (!*p_found)
+		entry->expr_key = MemoryContextStrdup(GetMemoryChunkContext(xpu_expression_htable),
+											  hkey.expr_key);
+	pfree(hkey.expr_key);
+	pfree(expr);
+
+	return entry;
+}
+
 /*
  * pgstrom_xpu_expression
  *
@@ -3789,6 +6800,7 @@ pgstrom_xpu_expression(Expr *expr,
 					   int *p_devcost)
 {
 	codegen_context *context;
+	xpuExpressionCacheEntry *entry = NULL;
 	int			num_rels = list_length(inner_target_list);
 	int			sz = offsetof(codegen_context, pd[num_rels+2]);
 	int			depth;
@@ -3796,6 +6808,33 @@ pgstrom_xpu_expression(Expr *expr,
 
 	Assert((xpu_task_flags & DEVKIND__ANY) == DEVKIND__NVIDIA_GPU ||
 		   (xpu_task_flags & DEVKIND__ANY) == DEVKIND__NVIDIA_DPU);
+	if (!expr || IsA(expr, List))
+		return false;
+	/*
+	 * Vars of the inner relations are resolved according to the inner
+	 * target-list, so only the expressions that reference the scan relation
+	 * are cached. Also, the offload advisor wants all the reasons of
+	 * the rejected expressions, so we don't use the cache at that time.
+	 */
+	if (xpu_expression_htable &&
+		inner_target_list == NIL &&
+		!offload_advisor_enabled)
+	{
+		bool		found;
+
+		entry = __lookup_xpu_expression_cache(expr,
+											  xpu_task_flags,
+											  scan_relid,
+											  &found);
+		if (found)
+		{
+			if (entry->device_ok && p_devcost)
+				*p_devcost = entry->devcost;
+			return entry->device_ok;
+		}
+		entry->device_ok = false;
+		entry->devcost = 0;
+	}
 	context = alloca(sz);
 	memset(context, 0, sz);
 	context->elevel = DEBUG2;
@@ -3806,15 +6845,138 @@ pgstrom_xpu_expression(Expr *expr,
 	depth = 1;
 	foreach (lc, inner_target_list)
 		context->pd[depth++].inner_target = (PathTarget *)lfirst(lc);
-	if (!expr || IsA(expr, List))
-		return false;
 	if (codegen_expression_walker(context, NULL, -1, expr) < 0)
 		return false;
+	if (entry)
+	{
+		entry->device_ok = true;
+		entry->devcost = context->device_cost;
+	}
 	if (p_devcost)
 		*p_devcost = context->device_cost;
 	return true;
 }
 
+/*
+ * __offload_advisor_hint - suggestion for the reason
+ */
+static const char *
+__offload_advisor_hint(const char *reason)
+{
+	if (strncmp(reason, "function ", 9) == 0)
+		return "rewrite by the device supported functions or operators; "
+			"text comparison on the device needs COLLATE \"C\", and "
+			"arguments may need explicit casts to the supported types";
+	if (strncmp(reason, "type ", 5) == 0 ||
+		strncmp(reason, "device type ", 12) == 0 ||
+		strncmp(reason, "Coalesce with type ", 19) == 0 ||
+		strncmp(reason, "Least/Greatest with type ", 25) == 0)
+		return "cast the value to a device supported type "
+			"(e.g, int2/int4/int8, float4/float8, numeric, text)";
+	if (strncmp(reason, "Not a supported CoerceViaIO", 27) == 0)
+		return "avoid the cast via text representation; "
+			"use a direct cast between the data types";
+	if (strncmp(reason, "Only PARAM_EXTERN", 17) == 0)
+		return "replace the sub-query by a join, or by the constant value";
+	if (strncmp(reason, "not a supported expression type", 31) == 0)
+		return "the expression node is not supported on the device; "
+			"move it to the outer query if possible";
+	return NULL;
+}
+
+/*
+ * pgstrom_explain_offload - SQL function to report the reasons why the
+ * expressions of the query were not pushed down to the device.
+ */
+PG_FUNCTION_INFO_V1(pgstrom_explain_offload);
+PUBLIC_FUNCTION(Datum)
+pgstrom_explain_offload(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *fncxt;
+	List	   *items;
+	Datum		values[4];
+	bool		isnull[4];
+	HeapTuple	tuple;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		char	   *query = text_to_cstring(PG_GETARG_TEXT_PP(0));
+		MemoryContext oldcxt;
+		TupleDesc	tupdesc;
+		List	   *raw_list;
+		ListCell   *lc1, *lc2;
+
+		fncxt = SRF_FIRSTCALL_INIT();
+		oldcxt = MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
+
+		tupdesc = CreateTemplateTupleDesc(4);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "devkind",
+						   TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "reason",
+						   TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 3, "count",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 4, "hint",
+						   TEXTOID, -1, 0);
+		fncxt->tuple_desc = BlessTupleDesc(tupdesc);
+		MemoryContextSwitchTo(oldcxt);
+
+		/* plan the query, but not execute */
+		offload_advisor_items = NIL;
+		offload_advisor_memcxt = fncxt->multi_call_memory_ctx;
+		offload_advisor_enabled = true;
+		PG_TRY();
+		{
+			raw_list = pg_parse_query(query);
+			foreach (lc1, raw_list)
+			{
+				RawStmt	   *rstmt = lfirst(lc1);
+				List	   *qlist;
+
+				qlist = pg_analyze_and_rewrite_fixedparams(rstmt, query,
+														   NULL, 0, NULL);
+				foreach (lc2, qlist)
+				{
+					Query  *qry = lfirst(lc2);
+
+					if (qry->commandType == CMD_UTILITY)
+						continue;
+					pg_plan_query(qry, query, CURSOR_OPT_PARALLEL_OK, NULL);
+				}
+			}
+		}
+		PG_FINALLY();
+		{
+			offload_advisor_enabled = false;
+			offload_advisor_memcxt = NULL;
+		}
+		PG_END_TRY();
+		fncxt->user_fctx = offload_advisor_items;
+		offload_advisor_items = NIL;
+	}
+	fncxt = SRF_PERCALL_SETUP();
+	items = fncxt->user_fctx;
+	if (fncxt->call_cntr < list_length(items))
+	{
+		offloadAdvisorItem *item = list_nth(items, fncxt->call_cntr);
+		const char *hint = __offload_advisor_hint(item->reason);
+
+		memset(isnull, 0, sizeof(isnull));
+		values[0] = CStringGetTextDatum(item->devkind == DEVKIND__NVIDIA_GPU
+										? "GPU" : "DPU");
+		values[1] = CStringGetTextDatum(item->reason);
+		values[2] = Int32GetDatum(item->count);
+		if (hint)
+			values[3] = CStringGetTextDatum(hint);
+		else
+			isnull[3] = true;
+
+		tuple = heap_form_tuple(fncxt->tuple_desc, values, isnull);
+		SRF_RETURN_NEXT(fncxt, HeapTupleGetDatum(tuple));
+	}
+	SRF_RETURN_DONE(fncxt);
+}
+
 /*
  * estimate_cuda_stack_size
  */
@@ -3979,16 +7141,22 @@ __xpucode_loadvars_cstring(StringInfo buf,
 						   List *dcontext)
 {
 	int		nitems = kexp->u.load.nitems;
+	kern_varload_desc *vl_array;
 
 	Assert(kexp->nr_args == 0);
 
+	/* desc[] may be split into two groups, so display items in resno order */
+	vl_array = alloca(sizeof(kern_varload_desc) * (nitems + 1));
+	memcpy(vl_array, kexp->u.load.desc, sizeof(kern_varload_desc) * nitems);
+	qsort(vl_array, nitems, sizeof(kern_varload_desc), kern_varload_desc_comp);
+
 	appendStringInfo(buf, "{LoadVars(depth=%d): ", kexp->u.load.depth);
 	appendStringInfo(buf, "kvars=");
 	if (kexp->u.load.nitems > 0)
 		appendStringInfoChar(buf, '[');
 	for (int i=0; i < nitems; i++)
 	{
-		const kern_varload_desc *vl_desc = &kexp->u.load.desc[i];
+		const kern_varload_desc *vl_desc = &vl_array[i];
 		const codegen_kvar_defitem *kvdef;
 		const char	   *dname;
 		const char	   *label;
@@ -4162,6 +7330,32 @@ __xpucode_aggfuncs_cstring(StringInfo buf,
 								 __get_expression_cstring(css, dcontext,
 														  desc->arg0_slot_id));
 				break;
+			case KAGG_ACTION__PSUM_NUMERIC:
+				appendStringInfo(buf, "psum::numeric[slot=%d, scale=%d, expr='%s']",
+								 desc->arg0_slot_id,
+								 desc->arg_scale,
+								 __get_expression_cstring(css, dcontext,
+														  desc->arg0_slot_id));
+				break;
+			case KAGG_ACTION__PAVG_NUMERIC:
+				appendStringInfo(buf, "pavg::numeric[slot=%d, scale=%d, expr='%s']",
+								 desc->arg0_slot_id,
+								 desc->arg_scale,
+								 __get_expression_cstring(css, dcontext,
+														  desc->arg0_slot_id));
+				break;
+			case KAGG_ACTION__PSUM_INT128:
+				appendStringInfo(buf, "psum::int128[slot=%d, expr='%s']",
+								 desc->arg0_slot_id,
+								 __get_expression_cstring(css, dcontext,
+														  desc->arg0_slot_id));
+				break;
+			case KAGG_ACTION__PAVG_INT128:
+				appendStringInfo(buf, "pavg::int128[slot=%d, expr='%s']",
+								 desc->arg0_slot_id,
+								 __get_expression_cstring(css, dcontext,
+														  desc->arg0_slot_id));
+				break;
 			case KAGG_ACTION__PAVG_INT:
 				appendStringInfo(buf, "pavg::int[slot=%d, expr='%s']",
 								 desc->arg0_slot_id,
@@ -4189,6 +7383,12 @@ __xpucode_aggfuncs_cstring(StringInfo buf,
 								 __get_expression_cstring(css, dcontext,
 														  desc->arg1_slot_id));
 				break;
+			case KAGG_ACTION__PCTILE_FP:
+				appendStringInfo(buf, "pctile::fp[slot=%d, expr='%s']",
+								 desc->arg0_slot_id,
+								 __get_expression_cstring(css, dcontext,
+														  desc->arg0_slot_id));
+				break;
 			default:
 				appendStringInfo(buf, "unknown[slot0=%d, expr0='%s', slot1=%d, expr1='%s']",
 								 desc->arg0_slot_id,
@@ -4252,6 +7452,18 @@ __xpucode_to_cstring(StringInfo buf,
 		case FuncOpCode__HashValue:
 			appendStringInfo(buf, "{HashValue");
 			break;
+		case FuncOpCode__RangeKeys:
+			dname = devtype_get_name_by_opcode(kexp->exptype);
+			appendStringInfo(buf, "{RangeKeys(%s): bounds=%s%s%s",
+							 dname,
+							 kexp->u.range.has_lower ? "lower" : "",
+							 kexp->u.range.has_lower &&
+							 kexp->u.range.has_upper ? "," : "",
+							 kexp->u.range.has_upper ? "upper" : "");
+			break;
+		case FuncOpCode__BloomFilter:
+			appendStringInfo(buf, "{BloomFilter: depth=%d", kexp->u.bloom.depth);
+			break;
 		case FuncOpCode__JoinQuals:
 			appendStringInfo(buf, "{JoinQuals: ");
 			for (i=0, karg=KEXP_FIRST_ARG(kexp);
@@ -4401,6 +7613,40 @@ __xpucode_to_cstring(StringInfo buf,
 			appendStringInfoChar(buf, '>');
 			break;
 
+		case FuncOpCode__ScalarArrayOpHash:
+			{
+				const kern_saop_hashset *hset = (const kern_saop_hashset *)
+					((const char *)kexp + kexp->u.saop.hset_offset);
+
+				Assert(kexp->nr_args == 2);
+				appendStringInfo(buf, "{ScalarArrayOpHash: elem=<slot=%d",
+								 kexp->u.saop.elem_slot_id);
+				kvdef = __lookup_kvar_defitem_by_slot_id(css, kexp->u.saop.elem_slot_id);
+				if (kvdef)
+					appendStringInfo(buf, ", type='%s'",
+									 devtype_get_name_by_opcode(kvdef->kv_type_code));
+				appendStringInfo(buf, ">, nitems=%u%s",
+								 hset->nitems,
+								 hset->has_nulls ? ", has_nulls" : "");
+			}
+			break;
+
+		case FuncOpCode__FieldSelectExpr:
+		case FuncOpCode__ArraySubscriptExpr:
+			appendStringInfo(buf, "{%s(%s): src=<slot=%d",
+							 kexp->opcode == FuncOpCode__FieldSelectExpr
+							 ? "FieldSelect" : "ArraySubscript",
+							 devtype_get_name_by_opcode(kexp->exptype),
+							 kexp->u.fsel.src_slot_id);
+			kvdef = __lookup_kvar_defitem_by_slot_id(css, kexp->u.fsel.src_slot_id);
+			if (kvdef)
+				appendStringInfo(buf, ", type='%s'",
+								 format_type_be(kvdef->kv_type_oid));
+			appendStringInfoChar(buf, '>');
+			if (kexp->opcode == FuncOpCode__FieldSelectExpr)
+				appendStringInfo(buf, ", fieldnum=%d", kexp->u.fsel.fieldnum);
+			break;
+
 		default:
 			dname = devfunc_get_name_by_opcode(kexp->opcode, &device_only);
 			if (!dname)
@@ -4673,4 +7919,24 @@ pgstrom_init_codegen(void)
 	pgstrom_devcache_invalidator(0, 0, 0);
 	CacheRegisterSyscacheCallback(TYPEOID, pgstrom_devcache_invalidator, 0);
 	CacheRegisterSyscacheCallback(PROCOID, pgstrom_devcache_invalidator, 0);
+	/* pg_strom.enable_codegen_cse */
+	DefineCustomBoolVariable("pg_strom.enable_codegen_cse",
+							 "Enables common sub-expression elimination on the device code",
+							 NULL,
+							 &pgstrom_enable_codegen_cse,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* pg_strom.scalar_array_op_hash_threshold */
+	DefineCustomIntVariable("pg_strom.scalar_array_op_hash_threshold",
+							"Min number of constant array elements to evaluate '= ANY(...)' by hash set (0 = disabled)",
+							NULL,
+							&pgstrom_saop_hash_threshold,
+							64,
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
 }
@@ -0,0 +1,258 @@
+/*
+ * cost_calib.c
+ *
+ * Routines to calibrate the cost model by the runtime statistics
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include "pg_strom.h"
+
+/*
+ * costCalibEntry
+ *
+ * It keeps the runtime statistics of the executed scans for each pair of
+ * the device kind (0 for CPU) and the tablespace. The run time is fit to
+ * (page_usec * npages + tuple_usec * ntuples) using the least-squares
+ * method on the exponentially decayed sums, so recent executions have
+ * more weight than older ones.
+ */
+typedef struct
+{
+	uint32_t	devkind;		/* DEVKIND__NVIDIA_GPU/DPU, or 0 for CPU */
+	Oid			spcid;			/* tablespace oid, or 0 for the default */
+} costCalibKey;
+
+typedef struct
+{
+	costCalibKey key;
+	uint64_t	nsamples;
+	double		setup_usec;		/* moving average of the setup time */
+	double		s_pp;			/* sum of npages * npages */
+	double		s_pt;			/* sum of npages * ntuples */
+	double		s_tt;			/* sum of ntuples * ntuples */
+	double		s_pr;			/* sum of npages * run_usec */
+	double		s_tr;			/* sum of ntuples * run_usec */
+} costCalibEntry;
+
+typedef struct
+{
+	LWLock		lock;
+	HTAB	   *hash;
+} costCalibSharedHead;
+
+#define COST_CALIB_DECAY			0.95
+#define COST_CALIB_MIN_SAMPLES		5
+
+static costCalibSharedHead *cost_calib_head = NULL;
+static int		pgstrom_cost_calib_max_entries;		/* GUC */
+static double	pgstrom_cost_calib_unit_usec;		/* GUC */
+static shmem_request_hook_type shmem_request_next = NULL;
+static shmem_startup_hook_type shmem_startup_next = NULL;
+
+/*
+ * pgstromCostCalibRecord
+ *
+ * It records a runtime sample of the scan; setup_usec is the time to open
+ * the session, and run_usec is the time to process npages and ntuples.
+ */
+void
+pgstromCostCalibRecord(uint32_t devkind, Oid spcid,
+					   double setup_usec, double run_usec,
+					   double npages, double ntuples)
+{
+	costCalibKey	key;
+	costCalibEntry *entry;
+	bool			found;
+
+	if (!cost_calib_head || run_usec <= 0.0 || npages + ntuples <= 0.0)
+		return;
+	memset(&key, 0, sizeof(costCalibKey));
+	key.devkind = devkind;
+	key.spcid = spcid;
+
+	LWLockAcquire(&cost_calib_head->lock, LW_EXCLUSIVE);
+	entry = hash_search(cost_calib_head->hash,
+						&key,
+						HASH_ENTER_NULL,
+						&found);
+	if (entry)
+	{
+		if (!found)
+		{
+			memset(&entry->nsamples, 0,
+				   sizeof(costCalibEntry) - offsetof(costCalibEntry, nsamples));
+			entry->setup_usec = setup_usec;
+		}
+		else
+		{
+			entry->setup_usec = (COST_CALIB_DECAY * entry->setup_usec +
+								 (1.0 - COST_CALIB_DECAY) * setup_usec);
+			entry->s_pp *= COST_CALIB_DECAY;
+			entry->s_pt *= COST_CALIB_DECAY;
+			entry->s_tt *= COST_CALIB_DECAY;
+			entry->s_pr *= COST_CALIB_DECAY;
+			entry->s_tr *= COST_CALIB_DECAY;
+		}
+		entry->s_pp += npages * npages;
+		entry->s_pt += npages * ntuples;
+		entry->s_tt += ntuples * ntuples;
+		entry->s_pr += npages * run_usec;
+		entry->s_tr += ntuples * run_usec;
+		entry->nsamples++;
+	}
+	LWLockRelease(&cost_calib_head->lock);
+}
+
+/*
+ * pgstromCostCalibLookup
+ *
+ * It overwrites the cost parameters by the calibrated ones, if enough
+ * samples are recorded for the pair of devkind and tablespace. Caller
+ * sets up the default (GUC) values; NULL is allowed for the parameters
+ * not in use.
+ */
+void
+pgstromCostCalibLookup(uint32_t devkind, Oid spcid,
+					   Cost *p_setup_cost,
+					   Cost *p_page_cost,
+					   Cost *p_tuple_cost)
+{
+	costCalibKey	key;
+	costCalibEntry *entry;
+	costCalibEntry	temp;
+	double			det;
+	double			page_usec;
+	double			tuple_usec;
+
+	if (!cost_calib_head)
+		return;
+	memset(&key, 0, sizeof(costCalibKey));
+	key.devkind = devkind;
+	key.spcid = spcid;
+
+	LWLockAcquire(&cost_calib_head->lock, LW_SHARED);
+	entry = hash_search(cost_calib_head->hash,
+						&key,
+						HASH_FIND,
+						NULL);
+	if (entry)
+		memcpy(&temp, entry, sizeof(costCalibEntry));
+	LWLockRelease(&cost_calib_head->lock);
+
+	if (!entry || temp.nsamples < COST_CALIB_MIN_SAMPLES)
+		return;
+	if (p_setup_cost)
+		*p_setup_cost = temp.setup_usec / pgstrom_cost_calib_unit_usec;
+
+	/*
+	 * Solve the normal equations of the least-squares;
+	 * if samples are (almost) collinear, per-page and per-tuple time
+	 * are not separable, so keep the default values.
+	 */
+	det = temp.s_pp * temp.s_tt - temp.s_pt * temp.s_pt;
+	if (det <= 1.0e-6 * temp.s_pp * temp.s_tt)
+		return;
+	page_usec  = (temp.s_pr * temp.s_tt - temp.s_tr * temp.s_pt) / det;
+	tuple_usec = (temp.s_tr * temp.s_pp - temp.s_pr * temp.s_pt) / det;
+	if (page_usec < 0.0 || tuple_usec < 0.0)
+		return;
+	if (p_page_cost)
+		*p_page_cost = page_usec / pgstrom_cost_calib_unit_usec;
+	if (p_tuple_cost)
+		*p_tuple_cost = tuple_usec / pgstrom_cost_calib_unit_usec;
+}
+
+/*
+ * pgstromCostCalibSpcId - tablespace of the scan relation
+ */
+Oid
+pgstromCostCalibSpcId(PlannerInfo *root, Index scan_relid)
+{
+	if (scan_relid > 0 &&
+		scan_relid < root->simple_rel_array_size &&
+		root->simple_rel_array[scan_relid] != NULL)
+		return root->simple_rel_array[scan_relid]->reltablespace;
+	return InvalidOid;
+}
+
+/*
+ * pgstrom_request_cost_calib
+ */
+static void
+pgstrom_request_cost_calib(void)
+{
+	if (shmem_request_next)
+		shmem_request_next();
+	RequestAddinShmemSpace(MAXALIGN(sizeof(costCalibSharedHead)) +
+						   hash_estimate_size(pgstrom_cost_calib_max_entries,
+											  sizeof(costCalibEntry)));
+}
+
+/*
+ * pgstrom_startup_cost_calib
+ */
+static void
+pgstrom_startup_cost_calib(void)
+{
+	HASHCTL		hctl;
+	bool		found;
+
+	if (shmem_startup_next)
+		(*shmem_startup_next)();
+
+	cost_calib_head = ShmemInitStruct("pgstromCostCalib(head)",
+									  MAXALIGN(sizeof(costCalibSharedHead)),
+									  &found);
+	Assert(!found);
+	LWLockInitialize(&cost_calib_head->lock, LWLockNewTrancheId());
+
+	memset(&hctl, 0, sizeof(HASHCTL));
+	hctl.keysize = sizeof(costCalibKey);
+	hctl.entrysize = sizeof(costCalibEntry);
+	cost_calib_head->hash = ShmemInitHash("pgstromCostCalib(hash)",
+										  pgstrom_cost_calib_max_entries,
+										  pgstrom_cost_calib_max_entries,
+										  &hctl,
+										  HASH_ELEM | HASH_BLOBS);
+}
+
+/*
+ * pgstrom_init_cost_calib
+ */
+void
+pgstrom_init_cost_calib(void)
+{
+	/* pg_strom.cost_calib_max_entries */
+	DefineCustomIntVariable("pg_strom.cost_calib_max_entries",
+							"Max number of cost calibration entries on the shared memory",
+							"Cost calibration is disabled, if 0",
+							&pgstrom_cost_calib_max_entries,
+							0,
+							0,
+							INT_MAX / 2,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	/* pg_strom.cost_calib_unit_usec */
+	DefineCustomRealVariable("pg_strom.cost_calib_unit_usec",
+							 "Microseconds equivalent to the cost unit 1.0",
+							 NULL,
+							 &pgstrom_cost_calib_unit_usec,
+							 10.0,
+							 0.001,
+							 DBL_MAX,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	if (pgstrom_cost_calib_max_entries > 0)
+	{
+		shmem_request_next = shmem_request_hook;
+		shmem_request_hook = pgstrom_request_cost_calib;
+		shmem_startup_next = shmem_startup_hook;
+		shmem_startup_hook = pgstrom_startup_cost_calib;
+	}
+}
@@ -107,6 +107,7 @@ typedef struct
 /*
  * Definitions related to GpuScan/GpuJoin/GpuPreAgg
  */
+#define GPUTASK_MAX_DST_SEGMENTS	8
 typedef struct {
 	kern_errorbuf	kerror;
 	uint32_t		grid_sz;
@@ -117,11 +118,24 @@ typedef struct {
 	uint32_t		extra_sz;
 	//uint32_t		kvars_ndims;	//deprecated
 	uint32_t		n_rels;			/* >0, if JOIN is involved */
+	uint32_t		right_outer_depth; /* >0, if emission of the unmatched
+										* inner rows of RIGHT OUTER JOIN */
 	uint32_t		groupby_prepfn_bufsz;
 	uint32_t		groupby_prepfn_nbufs;
 	/* suspend/resume support */
 	bool			resume_context;
 	uint32_t		suspend_count;
+	/* host-mapped flag to abort the task, or NULL */
+	volatile uint32_t *abort_flag;
+	/*
+	 * spare segments of the destination buffer; the kernel switches to
+	 * the next segment when kds_dst is full, prior to suspend.
+	 */
+	uint32_t		kds_dst_nsegments;
+	uint32_t		kds_dst_curr_seg;	/* 0 means kds_dst itself */
+	kern_data_store *kds_dst_segments[GPUTASK_MAX_DST_SEGMENTS];
+	/* row-granular CPU fallback (KDS_FORMAT_ROW), if any */
+	kern_data_store *kds_fallback;
 	/* kernel statistics */
 	uint32_t		nitems_raw;		/* nitems in the raw data chunk */
 	uint32_t		nitems_in;		/* nitems after the scan_quals */
@@ -176,6 +190,28 @@ INIT_KERN_GPUTASK_SUBFIELDS(kern_gputask *kgtask,
 }
 #endif
 
+/*
+ * kern_window_buffer - working buffer of GPU window functions
+ *
+ * All the rows of the result chunks kept in the per-query buffer are
+ * referenced by tuples[], then order[] is sorted by the PARTITION BY +
+ * ORDER BY keys. nrooms is the power of 2 no less than nrows for bitonic
+ * sorting; order[] larger than nrows are dummy rows.
+ */
+typedef struct
+{
+	uint32_t		nrows;
+	uint32_t		nrooms;
+	const kern_data_store *kds_head;	/* colmeta reference */
+	kern_tupitem  **tuples;		/* [nrows] */
+	uint32_t	   *order;		/* [nrooms] */
+	uint64_t	   *keys;		/* [nrows * nkeys] normalized keys */
+	uint32_t	   *key_nulls;	/* [nrows] bitmap of NULL keys */
+	uint32_t	   *peer_head;	/* [nrows] first position of the peer rows */
+	uint64_t	   *values;		/* [nrows * nfuncs] results (int64/fp64) */
+	bool		   *isnull;		/* [nrows * nfuncs] */
+} kern_window_buffer;
+
 /*
  * Declarations related to generic device executor routines
  */
@@ -201,6 +237,17 @@ EXTERN_FUNCTION(float8_t)
 pgstrom_local_min_fp64(float8_t my_value);
 EXTERN_FUNCTION(float8_t)
 pgstrom_local_max_fp64(float8_t my_value);
+EXTERN_FUNCTION(int64_t)
+pgstrom_local_sum_int64(int64_t my_value);
+EXTERN_FUNCTION(float8_t)
+pgstrom_local_sum_fp64(float8_t my_value);
+
+EXTERN_FUNCTION(const char *)
+__gpusort_fetch_attr(const kern_data_store *kds,
+					 const kern_tupitem *tupitem,
+					 int resno);
+EXTERN_FUNCTION(uint64_t)
+__gpusort_normalized_value(char kind, int attlen, const char *addr);
 
 EXTERN_FUNCTION(int)
 execGpuScanLoadSource(kern_context *kcxt,
@@ -210,7 +257,8 @@ execGpuScanLoadSource(kern_context *kcxt,
 					  const kern_expression *kexp_load_vars,
 					  const kern_expression *kexp_scan_quals,
 					  const kern_expression *kexp_move_vars,
-					  char     *dst_kvecs_buffer);
+					  char     *dst_kvecs_buffer,
+					  kern_data_store *kds_fallback);
 EXTERN_FUNCTION(int)
 execGpuJoinProjection(kern_context *kcxt,
 					  kern_warp_context *wp,
@@ -12,6 +12,124 @@
  */
 #include "cuda_common.h"
 
+/*
+ * __execGpuJoinRangeJoinIndex
+ *
+ * It returns the next position of the inner rows sorted by the range key,
+ * or kds_heap->nitems if no more rows can satisfy the range clauses.
+ * The lower bound is binary-searched at the first call for the outer row,
+ * then the inner rows are picked up until the key goes beyond the upper
+ * bound. Join quals are evaluated on the picked up rows as usual.
+ */
+STATIC_FUNCTION(uint32_t)
+__execGpuJoinRangeJoinIndex(kern_context *kcxt,
+							int depth,
+							const kern_data_store *kds_heap,
+							const kern_range_index *range,
+							uint32_t &l_state)
+{
+	const kern_expression *kexp = SESSION_KEXP_RANGE_KEYS(kcxt->session, depth);
+	const kern_expression *karg;
+	xpu_int8_t	datum;		/* large enough for int2/int4/int8/date/timestamp */
+	int64_t		ival;
+	uint32_t	index;
+
+	assert(kexp != NULL);
+	karg = KEXP_FIRST_ARG(kexp);
+	if (kexp->u.range.has_lower)
+	{
+		if (l_state == 0)
+		{
+			if (!EXEC_KERN_EXPRESSION(kcxt, karg, &datum) ||
+				!__rangejoin_fetch_xdatum_as_int64(&ival, (xpu_datum_t *)&datum))
+				goto no_more_rows;		/* error or NULL bound */
+			index = KERN_RANGE_INDEX_LOWER_BOUND(range, ival);
+		}
+		else
+		{
+			index = l_state;
+		}
+		karg = KEXP_NEXT_ARG(karg);
+	}
+	else
+	{
+		index = l_state;
+	}
+	if (index >= range->nitems)
+		goto no_more_rows;
+	if (kexp->u.range.has_upper)
+	{
+		if (!EXEC_KERN_EXPRESSION(kcxt, karg, &datum) ||
+			!__rangejoin_fetch_xdatum_as_int64(&ival, (xpu_datum_t *)&datum) ||
+			range->keys[index] > ival)
+			goto no_more_rows;
+	}
+	l_state = index + 1;
+	return index;
+
+no_more_rows:
+	l_state = kds_heap->nitems;
+	return kds_heap->nitems;
+}
+
+/*
+ * __execGpuJoinInetJoinIndex
+ *
+ * It returns the next position of the inner rows sorted by the network
+ * prefix, or kds_heap->nitems if no more prefixes can contain the outer
+ * network. The most specific candidate is binary-searched at the first
+ * call for the outer row, then the enclosing prefixes are picked up by
+ * the parent links. Join quals are evaluated on the picked up rows as usual.
+ */
+STATIC_FUNCTION(uint32_t)
+__execGpuJoinInetJoinIndex(kern_context *kcxt,
+						   int depth,
+						   const kern_data_store *kds_heap,
+						   const kern_inet_index *inet_index,
+						   uint32_t &l_state)
+{
+	const kern_expression *kexp = SESSION_KEXP_RANGE_KEYS(kcxt->session, depth);
+	const kern_inet_index_item *item;
+	xpu_inet_t	datum;
+	uint64_t	addr[2];
+	uint32_t	index;
+
+	assert(kexp != NULL && kexp->u.range.has_lower);
+	if (l_state == 0)
+	{
+		if (!EXEC_KERN_EXPRESSION(kcxt, KEXP_FIRST_ARG(kexp), &datum) ||
+			XPU_DATUM_ISNULL(&datum))
+			goto no_more_rows;		/* error or NULL outer network */
+		__inetjoin_fetch_address(addr, &datum.value);
+		index = KERN_INET_INDEX_UPPER_BOUND(inet_index,
+											datum.value.family, addr);
+		/* walk up to the first prefix that contains the outer network */
+		for (index = (index > 0 ? index - 1 : UINT_MAX);
+			 index != UINT_MAX;
+			 index = inet_index->items[index].parent)
+		{
+			assert(index < inet_index->nitems);
+			if (__inetjoin_item_contains(&inet_index->items[index],
+										 &datum.value, addr))
+				break;
+		}
+	}
+	else
+	{
+		/* ancestors of the containing prefix always contain the network */
+		index = l_state - 1;
+	}
+	if (index >= inet_index->nitems)
+		goto no_more_rows;
+	item = &inet_index->items[index];
+	l_state = (item->parent == UINT_MAX ? kds_heap->nitems : item->parent + 1);
+	return index;
+
+no_more_rows:
+	l_state = kds_heap->nitems;
+	return kds_heap->nitems;
+}
+
 /*
  * GPU Nested-Loop
  */
@@ -27,13 +145,21 @@ execGpuJoinNestLoop(kern_context *kcxt,
 {
 	const kern_expression *kexp;
 	kern_data_store *kds_heap = KERN_MULTIRELS_INNER_KDS(kmrels, depth-1);
+	kern_range_index *range = KERN_MULTIRELS_RANGE_INDEX(kmrels, depth-1);
+	kern_inet_index *inet_index = KERN_MULTIRELS_INET_INDEX(kmrels, depth-1);
 	bool	   *oj_map = KERN_MULTIRELS_OUTER_JOIN_MAP(kmrels, depth-1);
 	uint32_t	rd_pos;
 	uint32_t	wr_pos;
 	uint32_t	count;
-	bool		left_outer = kmrels->chunks[depth-1].left_outer;
+	bool		semi_join = kmrels->chunks[depth-1].semi_join;
+	bool		anti_join = kmrels->chunks[depth-1].anti_join;
+	bool		left_outer = (kmrels->chunks[depth-1].left_outer || anti_join);
 	bool		tuple_is_valid = false;
 
+	if (range && range->nitems == 0)
+		range = NULL;		/* not built, walk on the entire inner rows */
+	if (inet_index && inet_index->nitems == 0)
+		inet_index = NULL;	/* same as above */
 	if (WARP_WRITE_POS(wp,depth) >= WARP_READ_POS(wp,depth) + get_local_size())
 	{
 		/*
@@ -85,8 +211,16 @@ execGpuJoinNestLoop(kern_context *kcxt,
 	kcxt->kvecs_curr_buffer = src_kvecs_buffer;
 	if (rd_pos < WARP_WRITE_POS(wp,depth-1))
 	{
-		uint32_t	index = l_state++;
+		uint32_t	index;
 
+		if (range)
+			index = __execGpuJoinRangeJoinIndex(kcxt, depth, kds_heap,
+												range, l_state);
+		else if (inet_index)
+			index = __execGpuJoinInetJoinIndex(kcxt, depth, kds_heap,
+											   inet_index, l_state);
+		else
+			index = l_state++;
 		if (index < kds_heap->nitems)
 		{
 			kern_tupitem *tupitem;
@@ -112,10 +246,17 @@ execGpuJoinNestLoop(kern_context *kcxt,
 				assert(tupitem->rowid < kds_heap->nitems);
 				oj_map[tupitem->rowid] = true;
 			}
+			if (matched && (semi_join || anti_join))
+			{
+				/* SEMI JOIN emits the first match only, ANTI JOIN nothing */
+				if (anti_join)
+					tuple_is_valid = false;
+				l_state = UINT_MAX;
+			}
 		}
 		else if (left_outer && index >= kds_heap->nitems && !matched)
 		{
-			/* fill up NULL fields, if FULL/LEFT OUTER JOIN */
+			/* fill up NULL fields, if FULL/LEFT OUTER or ANTI JOIN */
 			kexp = SESSION_KEXP_LOAD_VARS(kcxt->session, depth);
 			ExecLoadVarsHeapTuple(kcxt, kexp, depth, kds_heap, NULL);
 			tuple_is_valid = true;
@@ -174,12 +315,26 @@ execGpuJoinHashJoin(kern_context *kcxt,
 {
 	kern_data_store *kds_hash = KERN_MULTIRELS_INNER_KDS(kmrels, depth-1);
 	bool	   *oj_map = KERN_MULTIRELS_OUTER_JOIN_MAP(kmrels, depth-1);
+	kern_hash_heavy *heavy = KERN_MULTIRELS_HEAVY_HITTERS(kmrels, depth-1);
+	kern_hash_bucket *bucket = KERN_MULTIRELS_HASH_BUCKET(kmrels, depth-1);
+	kern_hash_direct *direct = KERN_MULTIRELS_HASH_DIRECT(kmrels, depth-1);
 	kern_expression *kexp = NULL;
 	kern_hashitem *khitem = NULL;
 	uint32_t	rd_pos;
 	uint32_t	wr_pos;
 	uint32_t	count;
+	uint32_t	heavy_run = 0;	/* current run of the heavy-hitter, if any */
+	uint32_t	heavy_next = 0;	/* next rowid to be processed in the run */
 	bool		tuple_is_valid = false;
+	__shared__ uint32_t	heavy_prefix[MAXTHREADS_PER_BLOCK];
+	__shared__ uint32_t	heavy_base[MAXTHREADS_PER_BLOCK];
+
+	if (heavy && heavy->nruns == 0)
+		heavy = NULL;
+	if (bucket && bucket->nslots == 0)
+		bucket = NULL;
+	if (direct && direct->nitems == 0)
+		direct = NULL;
 
 	if (WARP_WRITE_POS(wp,depth) >= WARP_READ_POS(wp,depth) + get_local_size())
 	{
@@ -239,7 +394,40 @@ execGpuJoinHashJoin(kern_context *kcxt,
 	if (l_state == 0)
 	{
 		/* pick up the first item from the hash-slot */
-		if (rd_pos < wr_pos)
+		if (rd_pos < wr_pos && direct)
+		{
+			const kern_expression *karg;
+			xpu_int8_t	key;	/* large enough for int2/int4/int8 */
+
+			/* direct-mapped index by the outer key value */
+			kexp = SESSION_KEXP_HASH_VALUE(kcxt->session, depth);
+			assert(kexp->nr_args == 1);
+			karg = KEXP_FIRST_ARG(kexp);
+			if (EXEC_KERN_EXPRESSION(kcxt, karg, &key) &&
+				!XPU_DATUM_ISNULL(&key))
+			{
+				int64_t		ival;
+				uint64_t	index;
+
+				if (karg->expr_ops == &xpu_int2_ops)
+					ival = ((xpu_int2_t *)&key)->value;
+				else if (karg->expr_ops == &xpu_int4_ops)
+					ival = ((xpu_int4_t *)&key)->value;
+				else
+				{
+					assert(karg->expr_ops == &xpu_int8_ops);
+					ival = key.value;
+				}
+				index = (uint64_t)(ival - direct->min_value);
+				if (ival >= direct->min_value &&
+					index < direct->nitems &&
+					direct->items[index] != 0)
+					khitem = (kern_hashitem *)((char *)kds_hash
+											   + kds_hash->length
+											   - __kds_unpack(direct->items[index]));
+			}
+		}
+		else if (rd_pos < wr_pos)
 		{
 			xpu_int4_t	hash;
 
@@ -247,9 +435,18 @@ execGpuJoinHashJoin(kern_context *kcxt,
 			if (EXEC_KERN_EXPRESSION(kcxt, kexp, &hash))
 			{
 				assert(!XPU_DATUM_ISNULL(&hash));
-				for (khitem = KDS_HASH_FIRST_ITEM(kds_hash, hash.value);
-					 khitem != NULL && khitem->hash != hash.value;
-					 khitem = KDS_HASH_NEXT_ITEM(kds_hash, khitem->next));
+				if (bucket)
+					khitem = KDS_HASH_BUCKET_FIRST_ITEM(kds_hash, bucket, hash.value);
+				else
+				{
+					for (khitem = KDS_HASH_FIRST_ITEM(kds_hash, hash.value);
+						 khitem != NULL && khitem->hash != hash.value;
+						 khitem = KDS_HASH_NEXT_ITEM(kds_hash, khitem->next));
+				}
+				/* runs of the heavy-hitter follow the hash chain */
+				if (!khitem && heavy &&
+					(heavy_run = KERN_HASH_HEAVY_LOOKUP(heavy, hash.value)) != 0)
+					heavy_next = heavy->runs[heavy_run-1].head;
 			}
 		}
 		else
@@ -261,12 +458,47 @@ execGpuJoinHashJoin(kern_context *kcxt,
 	{
 		/* pick up the next one if any */
 		uint32_t	hash_value;
+		uint32_t	row_id;
 
 		khitem = (kern_hashitem *)((char *)kds_hash + __kds_unpack(l_state));
 		hash_value = khitem->hash;
-		for (khitem = KDS_HASH_NEXT_ITEM(kds_hash, khitem->next);
-			 khitem != NULL && khitem->hash != hash_value;
-			 khitem = KDS_HASH_NEXT_ITEM(kds_hash, khitem->next));
+		row_id = khitem->t.rowid;
+		if (heavy && !direct)
+		{
+			/* l_state points the next item, if it is on the run */
+			for (heavy_run = KERN_HASH_HEAVY_LOOKUP(heavy, hash_value);
+				 heavy_run != 0;
+				 heavy_run = heavy->runs[heavy_run-1].next)
+			{
+				if (row_id >= heavy->runs[heavy_run-1].head &&
+					row_id <  heavy->runs[heavy_run-1].tail)
+					break;
+			}
+		}
+		if (direct)
+		{
+			/* inner keys are unique, so no more rows */
+			khitem = NULL;
+		}
+		else if (heavy_run != 0)
+		{
+			heavy_next = row_id;
+			khitem = NULL;
+		}
+		else
+		{
+			if (bucket)
+				khitem = KDS_HASH_BUCKET_NEXT_ITEM(kds_hash, bucket, khitem);
+			else
+			{
+				for (khitem = KDS_HASH_NEXT_ITEM(kds_hash, khitem->next);
+					 khitem != NULL && khitem->hash != hash_value;
+					 khitem = KDS_HASH_NEXT_ITEM(kds_hash, khitem->next));
+			}
+			if (!khitem && heavy &&
+				(heavy_run = KERN_HASH_HEAVY_LOOKUP(heavy, hash_value)) != 0)
+				heavy_next = heavy->runs[heavy_run-1].head;
+		}
 	}
 	/* error checks */
 	if (__syncthreads_count(kcxt->errcode != ERRCODE_STROM_SUCCESS) > 0)
@@ -293,10 +525,19 @@ execGpuJoinHashJoin(kern_context *kcxt,
 			oj_map[khitem->t.rowid] = true;
 		}
 		l_state = __kds_packed((char *)khitem - (char *)kds_hash);
+		if (matched && (kmrels->chunks[depth-1].semi_join ||
+						kmrels->chunks[depth-1].anti_join))
+		{
+			/* SEMI JOIN emits the first match only, ANTI JOIN nothing */
+			if (kmrels->chunks[depth-1].anti_join)
+				tuple_is_valid = false;
+			l_state = UINT_MAX;
+		}
 	}
 	else
 	{
-		if (kmrels->chunks[depth-1].left_outer &&
+		if ((kmrels->chunks[depth-1].left_outer ||
+			 kmrels->chunks[depth-1].anti_join) &&
 			l_state != UINT_MAX && !matched)
 		{
 			/* load NULL values on the inner portion */
@@ -306,6 +547,84 @@ execGpuJoinHashJoin(kern_context *kcxt,
 		}
 		l_state = UINT_MAX;
 	}
+
+	/*
+	 * Heavy-hitter runs: threads with no item on the hash chain in this
+	 * round process the remaining items of the runs on behalf of the owner
+	 * threads. Heavy-hitters are never set up for OUTER JOIN, so neither
+	 * 'matched' nor 'oj_map' needs to be updated here.
+	 */
+	if (heavy)
+	{
+		uint32_t	nfree;
+		uint32_t	nwork;
+		uint32_t	free_id;
+		uint32_t	prefix;
+		uint32_t	nremains = 0;
+		bool		is_free = (khitem == NULL);
+
+		if (heavy_run != 0)
+			nremains = heavy->runs[heavy_run-1].tail - heavy_next;
+		prefix  = pgstrom_stair_sum_uint32(nremains, &nwork);
+		free_id = pgstrom_stair_sum_binary(is_free, &nfree);
+		heavy_prefix[get_local_id()] = prefix;
+		heavy_base[get_local_id()] = heavy_next;
+		__syncthreads();
+
+		if (is_free && free_id < nwork)
+		{
+			kern_tupitem *tupitem;
+			xpu_int4_t	status;
+			uint32_t	lo = 0;
+			uint32_t	hi = get_local_size();
+
+			/* find the owner thread of the free_id'th item */
+			while (hi - lo > 1)
+			{
+				uint32_t	mid = (lo + hi) / 2;
+
+				if (heavy_prefix[mid] <= free_id)
+					lo = mid;
+				else
+					hi = mid;
+			}
+			tupitem = KDS_GET_TUPITEM(kds_hash, (heavy_base[lo] +
+												 free_id - heavy_prefix[lo]));
+			khitem = (kern_hashitem *)((char *)tupitem -
+									   offsetof(kern_hashitem, t));
+			/* outer values are on the kvecs-slot of the owner thread */
+			kcxt->kvecs_curr_id = ((WARP_READ_POS(wp,depth-1) + lo) % KVEC_UNITSZ);
+			kexp = SESSION_KEXP_LOAD_VARS(kcxt->session, depth);
+			ExecLoadVarsHeapTuple(kcxt, kexp, depth, kds_hash, &khitem->t.htup);
+			kexp = SESSION_KEXP_JOIN_QUALS(kcxt->session, depth);
+			if (EXEC_KERN_EXPRESSION(kcxt, kexp, &status))
+			{
+				assert(!XPU_DATUM_ISNULL(&status));
+				if (status.value > 0)
+					tuple_is_valid = true;
+			}
+		}
+		/* the owner thread moves forward the run */
+		if (nremains > 0)
+		{
+			heavy_next += (nfree > prefix ? Min(nfree - prefix, nremains) : 0);
+			if (heavy_next >= heavy->runs[heavy_run-1].tail)
+			{
+				heavy_run = heavy->runs[heavy_run-1].next;
+				if (heavy_run != 0)
+					heavy_next = heavy->runs[heavy_run-1].head;
+			}
+		}
+		if (heavy_run != 0)
+		{
+			kern_tupitem *tupitem = KDS_GET_TUPITEM(kds_hash, heavy_next);
+
+			l_state = __kds_packed((char *)tupitem -
+								   offsetof(kern_hashitem, t) -
+								   (char *)kds_hash);
+		}
+		__syncthreads();
+	}
 	/* error checks */
 	if (__syncthreads_count(kcxt->errcode != ERRCODE_STROM_SUCCESS) > 0)
 		return -1;
@@ -346,8 +665,7 @@ gpujoin_prep_gistindex(kern_multirels *kmrels, int depth)
 	BlockNumber		block_nr;
 	OffsetNumber	i, maxoff;
 
-	assert(kds_hash && kds_hash->format == KDS_FORMAT_HASH &&
-		   kds_gist && kds_gist->format == KDS_FORMAT_BLOCK);
+	assert(kds_hash && kds_hash->format == KDS_FORMAT_HASH);
 	for (block_nr = get_group_id();
 		 block_nr < kds_gist->nitems;
 		 block_nr += get_num_groups())
@@ -368,7 +686,6 @@ gpujoin_prep_gistindex(kern_multirels *kmrels, int depth)
 			if (ItemIdIsDead(lpp))
 				continue;
 			itup = (IndexTupleData *)PageGetItem(gist_page, lpp);
-
 			/* lookup kds_hash */
 			hash = pg_hash_any(&itup->t_tid, sizeof(ItemPointerData));
 			for (khitem = KDS_HASH_FIRST_ITEM(kds_hash, hash);
@@ -392,6 +709,67 @@ gpujoin_prep_gistindex(kern_multirels *kmrels, int depth)
 	}
 }
 
+/*
+ * gpujoin_prep_hashtable
+ *
+ * It computes the hash-value of the inner rows, then links them to the
+ * hash-slot of kds_hash (and sets the bloom filter bits, if any), when
+ * the host code preloaded the inner rows without hash-values.
+ */
+KERNEL_FUNCTION(void)
+gpujoin_prep_hashtable(kern_session_info *session,
+					   kern_multirels *kmrels,
+					   int depth,
+					   kern_errorbuf *kerror)
+{
+	kern_data_store *kds_hash = KERN_MULTIRELS_INNER_KDS(kmrels, depth-1);
+	uint32_t	   *bloom = KERN_MULTIRELS_BLOOM_FILTER(kmrels, depth-1);
+	uint32_t		bloom_mask = kmrels->chunks[depth-1].bloom_nbits - 1;
+	kern_expression *kexp_load = SESSION_KEXP_LOAD_VARS(session, depth);
+	kern_expression *kexp_hash = SESSION_KEXP_HASH_INNER(session, depth);
+	kern_context   *kcxt;
+	uint32_t		index;
+
+	assert(kds_hash && kds_hash->format == KDS_FORMAT_HASH && kexp_hash);
+	INIT_KERNEL_CONTEXT(kcxt, session);
+	kcxt->kmrels = kmrels;
+	for (index = get_global_id();
+		 index < kds_hash->nitems;
+		 index += get_global_size())
+	{
+		kern_tupitem   *titem = KDS_GET_TUPITEM(kds_hash, index);
+		kern_hashitem  *khitem;
+		xpu_int4_t		hash;
+		uint32_t		self;
+
+		if (!titem)
+			continue;
+		khitem = (kern_hashitem *)((char *)titem - offsetof(kern_hashitem, t));
+		kcxt_reset(kcxt);
+		if (!ExecLoadVarsHeapTuple(kcxt, kexp_load, depth,
+								   kds_hash, &titem->htup) ||
+			!EXEC_KERN_EXPRESSION(kcxt, kexp_hash, &hash))
+		{
+			assert(kcxt->errcode != ERRCODE_STROM_SUCCESS);
+			break;
+		}
+		assert(!XPU_DATUM_ISNULL(&hash));
+		khitem->hash = hash.value;
+		self = __kds_packed((char *)kds_hash + kds_hash->length - (char *)khitem);
+		khitem->next = __atomic_write_uint32(KDS_GET_HASHSLOT(kds_hash, hash.value),
+											 self);
+		if (bloom)
+		{
+			uint32_t	h1 = ((uint32_t)hash.value & bloom_mask);
+			uint32_t	h2 = (__bloom_filter_hash2(hash.value) & bloom_mask);
+
+			atomicOr(&bloom[h1 >> 5], (1U << (h1 & 0x1f)));
+			atomicOr(&bloom[h2 >> 5], (1U << (h2 & 0x1f)));
+		}
+	}
+	STROM_WRITEBACK_ERROR_STATUS(kerror, kcxt);
+}
+
 /*
  * GiST-INDEX-JOIN
  */
@@ -408,7 +786,7 @@ execGpuJoinGiSTJoin(kern_context *kcxt,
 					bool       &matched)
 {
 	kern_data_store *kds_hash = KERN_MULTIRELS_INNER_KDS(kmrels, depth-1);
-	kern_data_store *kds_gist = KERN_MULTIRELS_GIST_INDEX(kmrels, depth-1);
+	bool			gist_rtree = kmrels->chunks[depth-1].gist_rtree;
 	int				gist_depth = kexp_gist->u.gist.gist_depth;
 	uint32_t		count;
 	uint32_t		rd_pos;
@@ -546,11 +924,18 @@ execGpuJoinGiSTJoin(kern_context *kcxt,
 		{
 			kcxt->kvecs_curr_buffer = src_kvecs_buffer;
 			kcxt->kvecs_curr_id = (rd_pos % KVEC_UNITSZ);
-			l_state = ExecGiSTIndexGetNext(kcxt,
-										   kds_hash,
-										   kds_gist,
-										   kexp_gist,
-										   l_state);
+			if (gist_rtree)
+				l_state = ExecRTreeIndexGetNext(kcxt,
+												kds_hash,
+												KERN_MULTIRELS_RTREE_INDEX(kmrels, depth-1),
+												kexp_gist,
+												l_state);
+			else
+				l_state = ExecGiSTIndexGetNext(kcxt,
+											   kds_hash,
+											   KERN_MULTIRELS_GIST_INDEX(kmrels, depth-1),
+											   kexp_gist,
+											   l_state);
 		}
 	}
 	else
@@ -602,6 +987,7 @@ execGpuJoinProjection(kern_context *kcxt,
 	uint32_t	row_id;
 	int64_t		offset;
 	int			tupsz = 0;
+	int			vl_sz = 0;
 	uint32_t	total_sz = 0;
 	bool		try_suspend = false;
 	__shared__ uint32_t	base_rowid;
@@ -624,10 +1010,70 @@ execGpuJoinProjection(kern_context *kcxt,
 										kds_dst);
 		if (tupsz < 0)
 			STROM_ELOG(kcxt, "unable to compute tuple size");
+		else if (kds_dst->format == KDS_FORMAT_COLUMN && kds_dst->has_varlena)
+		{
+			vl_sz = kern_estimate_columnar_row(kcxt,
+											   kexp_projection,
+											   kds_dst);
+			if (vl_sz < 0)
+				STROM_ELOG(kcxt, "unable to compute varlena size");
+		}
 	}
 	/* error checks */
 	if (__syncthreads_count(kcxt->errcode != ERRCODE_STROM_SUCCESS) > 0)
 		return -1;
+	/* columnar projection */
+	if (kds_dst->format == KDS_FORMAT_COLUMN)
+	{
+		row_id = pgstrom_stair_sum_binary(tupsz > 0, &count);
+		pgstrom_stair_sum_uint32(vl_sz, &total_sz);
+		if (get_local_id() == 0)
+		{
+			union {
+				struct {
+					uint32_t	nitems;
+					uint32_t	usage;
+				} i;
+				uint64_t		v64;
+			} oldval, curval, newval;
+
+			/*
+			 * kds_dst->usage reserves the worst case length of the varlena
+			 * heap, then kern_form_columnar_row() consumes the actual length
+			 * from the reserved area.
+			 */
+			curval.i.nitems = kds_dst->nitems;
+			curval.i.usage  = kds_dst->usage;
+			do {
+				newval = oldval = curval;
+				newval.i.nitems += count;
+				newval.i.usage  += __kds_packed(total_sz);
+
+				if (newval.i.nitems > kds_dst->column_nrooms ||
+					__kds_unpack(kds_dst->column_vl_offset) +
+					__kds_unpack(newval.i.usage) > kds_dst->length)
+				{
+					try_suspend = true;
+					break;
+				}
+			} while ((curval.v64 = atomicCAS((unsigned long long *)&kds_dst->nitems,
+											 oldval.v64,
+											 newval.v64)) != oldval.v64);
+			base_rowid = oldval.i.nitems;
+		}
+		if (__syncthreads_count(try_suspend) > 0)
+		{
+			*p_try_suspend = true;
+			return -1;
+		}
+		if (tupsz > 0 &&
+			!kern_form_columnar_row(kcxt,
+									kexp_projection,
+									kds_dst,
+									base_rowid + row_id))
+			STROM_ELOG(kcxt, "unable to write out columnar projection");
+		goto bailout;
+	}
 	/* allocation of the destination buffer */
 	assert(kds_dst->format == KDS_FORMAT_ROW &&
 		   tupsz == MAXALIGN(tupsz));
@@ -685,6 +1131,7 @@ execGpuJoinProjection(kern_context *kcxt,
 											 kds_dst,
 											 &tupitem->htup);
 	}
+bailout:
 	/* update the read position */
 	if (get_local_id() == 0)
 	{
@@ -705,6 +1152,156 @@ execGpuJoinProjection(kern_context *kcxt,
 	return n_rels + 1;		/* elsewhere, try again? */
 }
 
+/*
+ * GPU Right Outer Join
+ *
+ * It loads the inner rows of RIGHT/FULL OUTER JOIN that were never matched
+ * to any outer rows, according to the outer-join-map, as if they were the
+ * source rows of this depth. The outer portion is all NULL (the caller fills
+ * up the src_kvecs_buffer by NULLs), so only the pushed-down qualifiers of
+ * the JoinQuals are evaluated, like the CPU fallback doing.
+ */
+STATIC_FUNCTION(bool)
+__execGpuJoinRightOuterQuals(kern_context *kcxt,
+							 const kern_expression *kexp)
+{
+	const kern_expression *karg;
+	int			i;
+
+	if (!kexp)
+		return true;
+	assert(kexp->opcode == FuncOpCode__JoinQuals);
+	for (i=0, karg = KEXP_FIRST_ARG(kexp);
+		 i < kexp->nr_args;
+		 i++, karg = KEXP_NEXT_ARG(karg))
+	{
+		xpu_bool_t	datum;
+
+		if ((karg->expflags & KEXP_FLAG__IS_PUSHED_DOWN) == 0)
+			continue;
+		if (!EXEC_KERN_EXPRESSION(kcxt, karg, &datum) ||
+			XPU_DATUM_ISNULL(&datum) || !datum.value)
+			return false;
+	}
+	return true;
+}
+
+STATIC_FUNCTION(int)
+execGpuJoinRightOuter(kern_context *kcxt,
+					  kern_warp_context *wp,
+					  kern_multirels *kmrels,
+					  int depth,
+					  char *src_kvecs_buffer,
+					  char *dst_kvecs_buffer)
+{
+	kern_data_store *kds_in = KERN_MULTIRELS_INNER_KDS(kmrels, depth-1);
+	bool	   *oj_map = KERN_MULTIRELS_OUTER_JOIN_MAP(kmrels, depth-1);
+	kern_tupitem *tupitem = NULL;
+	uint32_t	count;
+	uint32_t	index;
+	uint32_t	wr_pos;
+
+	assert(oj_map != NULL);
+	if (wp->scan_done > depth ||
+		WARP_WRITE_POS(wp,depth) >= WARP_READ_POS(wp,depth) + get_local_size())
+		return depth+1;
+
+	/* compute the next row-index */
+	count = wp->smx_row_count;
+	__syncthreads();
+	if (get_local_id() == 0)
+		wp->smx_row_count++;
+	index = get_global_size() * count + get_global_base();
+	if (index >= kds_in->nitems)
+	{
+		if (get_local_id() == 0)
+			wp->scan_done = depth+1;
+		__syncthreads();
+		return depth+1;
+	}
+	index += get_local_id();
+
+	/* outer columns are referenced from the NULL-filled kvecs-buffer */
+	kcxt->kvecs_curr_buffer = src_kvecs_buffer;
+	kcxt->kvecs_curr_id = 0;
+	if (index < kds_in->nitems && !oj_map[index])
+	{
+		tupitem = KDS_GET_TUPITEM(kds_in, index);
+		if (tupitem &&
+			(!ExecLoadVarsHeapTuple(kcxt,
+									SESSION_KEXP_LOAD_VARS(kcxt->session, depth),
+									depth,
+									kds_in,
+									&tupitem->htup) ||
+			 !__execGpuJoinRightOuterQuals(kcxt,
+										   SESSION_KEXP_JOIN_QUALS(kcxt->session,
+																   depth))))
+			tupitem = NULL;
+	}
+	/* error checks */
+	if (__syncthreads_count(kcxt->errcode != ERRCODE_STROM_SUCCESS) > 0)
+		return -1;
+
+	/* save the result on the destination buffer */
+	wr_pos = WARP_WRITE_POS(wp,depth);
+	wr_pos += pgstrom_stair_sum_binary(tupitem != NULL, &count);
+	if (get_local_id() == 0)
+		WARP_WRITE_POS(wp,depth) += count;
+	if (tupitem != NULL)
+	{
+		const kern_expression  *kexp_move
+			= SESSION_KEXP_MOVE_VARS(kcxt->session, depth);
+		if (!ExecMoveKernelVariables(kcxt,
+									 kexp_move,
+									 dst_kvecs_buffer,
+									 (wr_pos % KVEC_UNITSZ)))
+		{
+			assert(kcxt->errcode != ERRCODE_STROM_SUCCESS);
+		}
+	}
+	/* error checks */
+	if (__syncthreads_count(kcxt->errcode != ERRCODE_STROM_SUCCESS) > 0)
+		return -1;
+	if (WARP_WRITE_POS(wp,depth) >= WARP_READ_POS(wp,depth) + get_local_size())
+		return depth+1;
+	return depth;
+}
+
+/*
+ * __gpujoinNextDestSegment
+ *
+ * It switches the destination buffer to the next spare segment, if any.
+ * Other blocks may already switch the segment; it is harmless because
+ * the caller retries the projection on the current segment.
+ */
+STATIC_FUNCTION(bool)
+__gpujoinNextDestSegment(kern_gputask *kgtask, uint32_t seg_id)
+{
+	bool	has_next = false;
+
+	if (get_local_id() == 0 && seg_id < kgtask->kds_dst_nsegments)
+	{
+		__atomic_cas_uint32(&kgtask->kds_dst_curr_seg, seg_id, seg_id + 1);
+		has_next = true;
+	}
+	return (__syncthreads_count(has_next) > 0);
+}
+
+/*
+ * __gpujoinCheckTaskAbort
+ *
+ * It checks the host-mapped abort flag set by the GPU service, when the
+ * query is cancelled or the session is closed.
+ */
+INLINE_FUNCTION(void)
+__gpujoinCheckTaskAbort(kern_context *kcxt, kern_gputask *kgtask)
+{
+	if (get_local_id() == 0 &&
+		kgtask->abort_flag != NULL &&
+		__volatileRead(kgtask->abort_flag) != 0)
+		STROM_EREPORT(kcxt, ERRCODE_TASK_CANCELLED, "task is cancelled");
+}
+
 /*
  * kern_gpujoin_main
  */
@@ -725,6 +1322,7 @@ kern_gpujoin_main(kern_session_info *session,
 	uint32_t			wp_base_sz;
 	uint32_t			n_rels = (kmrels ? kmrels->num_rels : 0);
 	int					depth;
+	__shared__ uint32_t	dst_seg_id;
 
 	assert(kgtask->kvars_nslots == session->kcxt_kvars_nslots &&
 		   kgtask->kvecs_bufsz  == session->kcxt_kvecs_bufsz &&
@@ -732,6 +1330,7 @@ kern_gpujoin_main(kern_session_info *session,
 		   kgtask->n_rels       == n_rels);
 	/* setup execution context */
 	INIT_KERNEL_CONTEXT(kcxt, session);
+	kcxt->kmrels = kmrels;
 	wp_base_sz = __KERN_WARP_CONTEXT_BASESZ(kgtask->kvecs_ndims);
 	wp = (kern_warp_context *)SHARED_WORKMEM(0);
 	INIT_KERN_GPUTASK_SUBFIELDS(kgtask,
@@ -762,7 +1361,23 @@ kern_gpujoin_main(kern_session_info *session,
 			l_state[d * get_global_size() + get_global_id()] = 0;
 			matched[d * get_global_size() + get_global_id()] = false;
 		}
-		depth = 0;
+		if (kgtask->right_outer_depth > 0)
+		{
+			/*
+			 * RIGHT OUTER JOIN rows on XpuTaskFinal; no source rows,
+			 * and all the outer columns are NULL.
+			 */
+			char   *kvecs = __KVEC_BUFFER(kgtask->right_outer_depth-1);
+
+			assert(kgtask->right_outer_depth <= n_rels);
+			for (uint32_t i=get_local_id(); i < kvec_buffer_size; i += get_local_size())
+				kvecs[i] = 1;
+			depth = kgtask->right_outer_depth;
+		}
+		else
+		{
+			depth = 0;
+		}
 	}
 	__syncthreads();
 #define __L_STATE(__depth)						\
@@ -777,25 +1392,33 @@ kern_gpujoin_main(kern_session_info *session,
 		if (depth == 0)
 		{
 			/* LOAD FROM THE SOURCE */
+			__gpujoinCheckTaskAbort(kcxt, kgtask);
 			depth = execGpuScanLoadSource(kcxt, wp,
 										  kds_src,
 										  kds_extra,
 										  SESSION_KEXP_LOAD_VARS(session, 0),
 										  SESSION_KEXP_SCAN_QUALS(session),
 										  SESSION_KEXP_MOVE_VARS(session, 0),
-										  __KVEC_BUFFER(0));
+										  __KVEC_BUFFER(0),
+										  kgtask->kds_fallback);
 		}
 		else if (depth > n_rels)
 		{
 			bool	try_suspend = false;
 
 			assert(depth == n_rels+1);
+			__gpujoinCheckTaskAbort(kcxt, kgtask);
 			if (session->xpucode_projection)
 			{
 				/* PROJECTION */
+				if (get_local_id() == 0)
+					dst_seg_id = __volatileRead(&kgtask->kds_dst_curr_seg);
+				__syncthreads();
 				depth = execGpuJoinProjection(kcxt, wp,
 											  n_rels,
-											  kds_dst,
+											  (dst_seg_id == 0
+											   ? kds_dst
+											   : kgtask->kds_dst_segments[dst_seg_id-1]),
 											  SESSION_KEXP_PROJECTION(session),
 											  __KVEC_BUFFER(n_rels),
 											  &try_suspend);
@@ -811,11 +1434,29 @@ kern_gpujoin_main(kern_session_info *session,
 			}
 			if (__syncthreads_count(try_suspend) > 0)
 			{
-				if (get_local_id() == 0)
-					atomicAdd(&kgtask->suspend_count, 1);
-				assert(depth < 0);
+				if (session->xpucode_projection &&
+					__gpujoinNextDestSegment(kgtask, dst_seg_id))
+				{
+					/* retry the projection on the next segment */
+					depth = n_rels + 1;
+				}
+				else
+				{
+					if (get_local_id() == 0)
+						atomicAdd(&kgtask->suspend_count, 1);
+					assert(depth < 0);
+				}
 			}
 		}
+		else if (depth == kgtask->right_outer_depth)
+		{
+			/* RIGHT-OUTER-JOIN */
+			depth = execGpuJoinRightOuter(kcxt, wp,
+										  kmrels,
+										  depth,
+										  __KVEC_BUFFER(depth-1),
+										  __KVEC_BUFFER(depth));
+		}
 		else if (kmrels->chunks[depth-1].is_nestloop)
 		{
 			/* NEST-LOOP */
@@ -877,10 +1518,13 @@ kern_gpujoin_main(kern_session_info *session,
 	{
 		if (depth < 0 && WARP_READ_POS(wp,n_rels) >= WARP_WRITE_POS(wp,n_rels))
 		{
-			/* number of raw-tuples fetched from the heap block */
-			if (kds_src->format == KDS_FORMAT_BLOCK)
+			/*
+			 * number of raw-tuples fetched from the heap block
+			 * (RIGHT OUTER JOIN rows on XpuTaskFinal have no source)
+			 */
+			if (kds_src && kds_src->format == KDS_FORMAT_BLOCK)
 				atomicAdd(&kgtask->nitems_raw, wp->lp_wr_pos);
-			else if (get_global_id() == 0)
+			else if (kds_src && get_global_id() == 0)
 				atomicAdd(&kgtask->nitems_raw, kds_src->nitems);
 			atomicAdd(&kgtask->nitems_in, WARP_WRITE_POS(wp, 0));
 			for (int i=0; i < n_rels; i++)
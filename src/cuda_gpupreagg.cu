@@ -161,6 +161,22 @@ __writeOutOneTuplePreAgg(kern_context *kcxt,
 				t_infomask |= HEAP_HASVARWIDTH;
 				break;
 
+			case KAGG_ACTION__PSUM_NUMERIC:
+			case KAGG_ACTION__PAVG_NUMERIC:
+			case KAGG_ACTION__PSUM_INT128:
+			case KAGG_ACTION__PAVG_INT128:
+				nbytes = sizeof(kagg_state__psum_numeric_packed);
+				if (buffer)
+				{
+					kagg_state__psum_numeric_packed *r =
+						(kagg_state__psum_numeric_packed *)buffer;
+					memset(r, 0, sizeof(kagg_state__psum_numeric_packed));
+					r->scale = desc->arg_scale;
+					SET_VARSIZE(r, sizeof(kagg_state__psum_numeric_packed));
+				}
+				t_infomask |= HEAP_HASVARWIDTH;
+				break;
+
 			case KAGG_ACTION__STDDEV:
 				nbytes = sizeof(kagg_state__stddev_packed);
 				if (buffer)
@@ -181,6 +197,20 @@ __writeOutOneTuplePreAgg(kern_context *kcxt,
 				t_infomask |= HEAP_HASVARWIDTH;
 				break;
 
+			case KAGG_ACTION__PCTILE_FP:
+				nbytes = sizeof(kagg_state__pctile_packed);
+				if (buffer)
+				{
+					kagg_state__pctile_packed *r =
+						(kagg_state__pctile_packed *)buffer;
+					memset(r, 0, sizeof(kagg_state__pctile_packed));
+					r->min_value = DBL_MAX;
+					r->max_value = -DBL_MAX;
+					SET_VARSIZE(r, sizeof(kagg_state__pctile_packed));
+				}
+				t_infomask |= HEAP_HASVARWIDTH;
+				break;
+
 			default:
 				STROM_ELOG(kcxt, "unknown xpuPreAgg action");
 				return -1;
@@ -534,7 +564,7 @@ __update_nogroups__psum_int(kern_context *kcxt,
 		kagg_state__psum_int_packed *r =
 			(kagg_state__psum_int_packed *)buffer;
 
-		pgstrom_stair_sum_int64(ival, &sum);
+		sum = pgstrom_local_sum_int64(ival);
 		if (get_local_id() == 0)
 		{
 			if (__isShared(r))
@@ -577,7 +607,7 @@ __update_nogroups__psum_fp(kern_context *kcxt,
 		kagg_state__psum_fp_packed *r =
 			(kagg_state__psum_fp_packed *)buffer;
 
-		pgstrom_stair_sum_fp64(fval, &sum);
+		sum = pgstrom_local_sum_fp64(fval);
 		if (get_local_id() == 0)
 		{
 			if (__isShared(r))
@@ -594,6 +624,67 @@ __update_nogroups__psum_fp(kern_context *kcxt,
 	}
 }
 
+/*
+ * __update_nogroups__psum_numeric
+ */
+INLINE_FUNCTION(void)
+__update_nogroups__psum_numeric(kern_context *kcxt,
+								char *buffer,
+								kern_colmeta *cmeta,
+								kern_aggregate_desc *desc,
+								bool source_is_valid)
+{
+	int128_t	ival = 0;
+	bool		isnan = false;
+	int			count;
+	int			nnans;
+
+	if (source_is_valid)
+	{
+		xpu_datum_t *xdatum = kcxt->kvars_slot[desc->arg0_slot_id];
+
+		if (!__preagg_fetch_xdatum_as_fixed_numeric(kcxt, &ival, &isnan,
+													xdatum,
+													desc->arg_scale))
+			source_is_valid = false;
+	}
+	count = __syncthreads_count(source_is_valid);
+	nnans = __syncthreads_count(isnan);
+	if (count > 0 || nnans > 0)
+	{
+		kagg_state__psum_numeric_packed *r =
+			(kagg_state__psum_numeric_packed *)buffer;
+		int64_t		sum_lo, sum_hi;
+		int128_t	sum;
+
+		/*
+		 * local-sum works on int64, so the value is split into the upper
+		 * and lower 32bit parts. Both partial sums never overflow within
+		 * a thread-block (see KAGG_NUMERIC_FIXED_MAX_PRECISION).
+		 */
+		sum_lo = pgstrom_local_sum_int64((int64_t)(ival & 0xffffffffU));
+		sum_hi = pgstrom_local_sum_int64((int64_t)(ival >> 32));
+		sum = ((int128_t)sum_hi << 32) + (int128_t)sum_lo;
+		if (get_local_id() == 0)
+		{
+			if (__isShared(r))
+			{
+				r->nitems += count;
+				r->nnans  += nnans;
+				__kagg_psum_numeric_set_sum(r, __kagg_psum_numeric_get_sum(r) + sum);
+			}
+			else
+			{
+				if (count > 0)
+					__atomic_add_uint32(&r->nitems, count);
+				if (nnans > 0)
+					__atomic_add_uint32(&r->nnans, nnans);
+				__atomic_add_fixed_numeric(r, sum);
+			}
+		}
+	}
+}
+
 /*
  * __update_nogroups__pstddev
  */
@@ -619,8 +710,8 @@ __update_nogroups__pstddev(kern_context *kcxt,
 	{
 		float8_t	sum_x, sum_x2;
 
-		pgstrom_stair_sum_fp64(xval, &sum_x);
-		pgstrom_stair_sum_fp64(xval * xval, &sum_x2);
+		sum_x  = pgstrom_local_sum_fp64(xval);
+		sum_x2 = pgstrom_local_sum_fp64(xval * xval);
 
 		if (get_local_id() == 0)
 		{
@@ -670,11 +761,11 @@ __update_nogroups__pcovar(kern_context *kcxt,
 	{
 		float8_t	sum_x, sum_y, sum_xx, sum_yy, sum_xy;
 
-		pgstrom_stair_sum_fp64(xval, &sum_x);
-		pgstrom_stair_sum_fp64(yval, &sum_y);
-		pgstrom_stair_sum_fp64(xval * xval, &sum_xx);
-		pgstrom_stair_sum_fp64(yval * yval, &sum_yy);
-		pgstrom_stair_sum_fp64(xval * yval, &sum_xy);
+		sum_x  = pgstrom_local_sum_fp64(xval);
+		sum_y  = pgstrom_local_sum_fp64(yval);
+		sum_xx = pgstrom_local_sum_fp64(xval * xval);
+		sum_yy = pgstrom_local_sum_fp64(yval * yval);
+		sum_xy = pgstrom_local_sum_fp64(xval * yval);
 
 		if (get_global_id() == 0)
 		{
@@ -702,6 +793,47 @@ __update_nogroups__pcovar(kern_context *kcxt,
 	}
 }
 
+/*
+ * __update_nogroups__ppctile
+ */
+INLINE_FUNCTION(void)
+__update_nogroups__ppctile(kern_context *kcxt,
+						   char *buffer,
+						   kern_colmeta *cmeta,
+						   kern_aggregate_desc *desc,
+						   bool source_is_valid)
+{
+	float8_t	fval = 0.0;
+
+	if (source_is_valid)
+	{
+		const xpu_datum_t *xdatum = kcxt->kvars_slot[desc->arg0_slot_id];
+
+		if (!__preagg_fetch_xdatum_as_float64(&fval, xdatum))
+			source_is_valid = false;
+	}
+	/*
+	 * histogram buckets are too many to reduce in the thread-block,
+	 * so each thread updates the buffer by atomic operations.
+	 */
+	if (source_is_valid)
+	{
+		kagg_state__pctile_packed *r =
+			(kagg_state__pctile_packed *)buffer;
+		int		index = __kagg_pctile_bucket_index(fval);
+
+		__atomic_add_uint32(&r->nitems, 1);
+		__atomic_min_fp64(&r->min_value, fval);
+		__atomic_max_fp64(&r->max_value, fval);
+		if (index < 0)
+			__atomic_add_uint32(&r->nzeros, 1);
+		else if (fval < 0.0)
+			__atomic_add_uint32(&r->negative[index], 1);
+		else
+			__atomic_add_uint32(&r->positive[index], 1);
+	}
+}
+
 /*
  * __updateOneTupleNoGroups
  */
@@ -801,6 +933,14 @@ __updateOneTupleNoGroups(kern_context *kcxt,
 										   cmeta, desc,
 										   source_is_valid);
 				break;
+			case KAGG_ACTION__PSUM_NUMERIC:
+			case KAGG_ACTION__PAVG_NUMERIC:
+			case KAGG_ACTION__PSUM_INT128:
+			case KAGG_ACTION__PAVG_INT128:
+				__update_nogroups__psum_numeric(kcxt, buffer,
+												cmeta, desc,
+												source_is_valid);
+				break;
 			case KAGG_ACTION__STDDEV:
 				__update_nogroups__pstddev(kcxt, buffer,
 										   cmeta, desc,
@@ -811,6 +951,11 @@ __updateOneTupleNoGroups(kern_context *kcxt,
 										  cmeta, desc,
 										  source_is_valid);
 				break;
+			case KAGG_ACTION__PCTILE_FP:
+				__update_nogroups__ppctile(kcxt, buffer,
+										   cmeta, desc,
+										   source_is_valid);
+				break;
 			default:
 				/*
 				 * No more partial aggregation exists after grouping-keys
@@ -846,7 +991,7 @@ __insertOneTupleNoGroups(kern_context *kcxt,
 									 kexp_groupby_actions);
 	assert(tupsz > 0);
 	required = MAXALIGN(offsetof(kern_tupitem, htup) + tupsz);
-	assert(required < 1000);
+	assert(required < 1000 + kcxt->session->groupby_prepfn_bufsz);
 	total_sz = (KDS_HEAD_LENGTH(kds_final) +
 				MAXALIGN(sizeof(uint32_t)) +
 				required + __kds_unpack(kds_final->usage));
@@ -1035,6 +1180,57 @@ __insertOneTupleGroupBy(kern_context *kcxt,
 	return hitem;
 }
 
+/*
+ * Warp-level pre-aggregation
+ *
+ * When number of groups is small, many threads in a warp update the same
+ * group at once, and atomic operations on the same address are serialized.
+ * So, lanes which update the same buffer (peers) reduce their values by
+ * warp shuffle first, then the leader lane only runs atomic operations.
+ * It needs __match_any_sync() of Volta or later; elsewhere each lane is
+ * its own peer, thus it works as before.
+ */
+INLINE_FUNCTION(uint32_t)
+__warp_peers_mask(const char *buffer)
+{
+#if __CUDA_ARCH__ >= 700
+	return __match_any_sync(__activemask(), (uint64_t)buffer);
+#else
+	return (1U << LaneId());
+#endif
+}
+
+INLINE_FUNCTION(bool)
+__warp_peers_is_leader(uint32_t peers)
+{
+	return (__ffs(peers) - 1 == LaneId());
+}
+
+template <typename T>
+INLINE_FUNCTION(T)
+__warp_peers_sum(uint32_t peers, T value)
+{
+#if __CUDA_ARCH__ >= 700
+	T		sum = 0;
+
+	for (uint32_t mask = peers; mask != 0; mask &= (mask - 1))
+		sum += __shfl_sync(peers, value, __ffs(mask) - 1);
+	return sum;
+#else
+	return value;
+#endif
+}
+
+INLINE_FUNCTION(uint32_t)
+__warp_peers_count(uint32_t peers, bool predicate)
+{
+#if __CUDA_ARCH__ >= 700
+	return __popc(__ballot_sync(peers, predicate));
+#else
+	return (predicate ? 1 : 0);
+#endif
+}
+
 /*
  * __update_groupby__nrows_any
  */
@@ -1042,9 +1238,11 @@ INLINE_FUNCTION(int)
 __update_groupby__nrows_any(kern_context *kcxt,
 							char *buffer,
 							const kern_colmeta *cmeta,
-							const kern_aggregate_desc *desc)
+							const kern_aggregate_desc *desc,
+							uint32_t peers)
 {
-	__atomic_add_uint64((uint64_t *)buffer, 1);
+	if (__warp_peers_is_leader(peers))
+		__atomic_add_uint64((uint64_t *)buffer, __popc(peers));
 	return sizeof(uint64_t);
 }
 
@@ -1052,12 +1250,15 @@ INLINE_FUNCTION(int)
 __update_groupby__nrows_cond(kern_context *kcxt,
 							 char *buffer,
 							 const kern_colmeta *cmeta,
-							 const kern_aggregate_desc *desc)
+							 const kern_aggregate_desc *desc,
+							 uint32_t peers)
 {
 	xpu_datum_t	   *xdatum = kcxt->kvars_slot[desc->arg0_slot_id];
+	uint32_t		count;
 
-	if (!XPU_DATUM_ISNULL(xdatum))
-		__atomic_add_uint64((uint64_t *)buffer, 1);
+	count = __warp_peers_count(peers, !XPU_DATUM_ISNULL(xdatum));
+	if (count > 0 && __warp_peers_is_leader(peers))
+		__atomic_add_uint64((uint64_t *)buffer, count);
 	return sizeof(uint64_t);
 }
 
@@ -1185,17 +1386,21 @@ INLINE_FUNCTION(int)
 __update_groupby__psum_int(kern_context *kcxt,
 						   char *buffer,
 						   const kern_colmeta *cmeta,
-						   const kern_aggregate_desc *desc)
+						   const kern_aggregate_desc *desc,
+						   uint32_t peers)
 {
 	const xpu_datum_t *xdatum = kcxt->kvars_slot[desc->arg0_slot_id];
-	int64_t		ival;
+	int64_t		ival = 0;
+	uint32_t	count;
 
-	if (__preagg_fetch_xdatum_as_int64(&ival, xdatum))
+	count = __warp_peers_count(peers, __preagg_fetch_xdatum_as_int64(&ival, xdatum));
+	ival = __warp_peers_sum(peers, ival);
+	if (count > 0 && __warp_peers_is_leader(peers))
 	{
 		kagg_state__psum_int_packed *r =
 			(kagg_state__psum_int_packed *)buffer;
 
-		__atomic_add_uint32(&r->nitems, 1);
+		__atomic_add_uint32(&r->nitems, count);
 		__atomic_add_int64(&r->sum, ival);
 	}
 	return sizeof(kagg_state__psum_int_packed);
@@ -1205,22 +1410,56 @@ INLINE_FUNCTION(int)
 __update_groupby__psum_fp(kern_context *kcxt,
 						  char *buffer,
 						  const kern_colmeta *cmeta,
-						  const kern_aggregate_desc *desc)
+						  const kern_aggregate_desc *desc,
+						  uint32_t peers)
 {
 	const xpu_datum_t *xdatum = kcxt->kvars_slot[desc->arg0_slot_id];
-	float8_t	fval;
+	float8_t	fval = 0.0;
+	uint32_t	count;
 
-	if (__preagg_fetch_xdatum_as_float64(&fval, xdatum))
+	count = __warp_peers_count(peers, __preagg_fetch_xdatum_as_float64(&fval, xdatum));
+	fval = __warp_peers_sum(peers, fval);
+	if (count > 0 && __warp_peers_is_leader(peers))
 	{
 		kagg_state__psum_fp_packed *r =
 			(kagg_state__psum_fp_packed *)buffer;
 
-		__atomic_add_uint32(&r->nitems, 1);
+		__atomic_add_uint32(&r->nitems, count);
 		__atomic_add_fp64(&r->sum, fval);
 	}
 	return sizeof(kagg_state__psum_fp_packed);
 }
 
+INLINE_FUNCTION(int)
+__update_groupby__psum_numeric(kern_context *kcxt,
+							   char *buffer,
+							   const kern_colmeta *cmeta,
+							   const kern_aggregate_desc *desc)
+{
+	xpu_datum_t *xdatum = kcxt->kvars_slot[desc->arg0_slot_id];
+	int128_t	ival;
+	bool		isnan;
+
+	if (__preagg_fetch_xdatum_as_fixed_numeric(kcxt, &ival, &isnan,
+												xdatum,
+												desc->arg_scale))
+	{
+		kagg_state__psum_numeric_packed *r =
+			(kagg_state__psum_numeric_packed *)buffer;
+
+		__atomic_add_uint32(&r->nitems, 1);
+		__atomic_add_fixed_numeric(r, ival);
+	}
+	else if (isnan)
+	{
+		kagg_state__psum_numeric_packed *r =
+			(kagg_state__psum_numeric_packed *)buffer;
+
+		__atomic_add_uint32(&r->nnans, 1);
+	}
+	return sizeof(kagg_state__psum_numeric_packed);
+}
+
 INLINE_FUNCTION(int)
 __update_groupby__pstddev(kern_context *kcxt,
 						  char *buffer,
@@ -1268,6 +1507,34 @@ __update_groupby__pcovar(kern_context *kcxt,
 	return sizeof(kagg_state__covar_packed);
 }
 
+INLINE_FUNCTION(int)
+__update_groupby__ppctile(kern_context *kcxt,
+						  char *buffer,
+						  const kern_colmeta *cmeta,
+						  const kern_aggregate_desc *desc)
+{
+	const xpu_datum_t *xdatum = kcxt->kvars_slot[desc->arg0_slot_id];
+	float8_t	fval;
+
+	if (__preagg_fetch_xdatum_as_float64(&fval, xdatum))
+	{
+		kagg_state__pctile_packed *r =
+			(kagg_state__pctile_packed *)buffer;
+		int		index = __kagg_pctile_bucket_index(fval);
+
+		__atomic_add_uint32(&r->nitems, 1);
+		__atomic_min_fp64(&r->min_value, fval);
+		__atomic_max_fp64(&r->max_value, fval);
+		if (index < 0)
+			__atomic_add_uint32(&r->nzeros, 1);
+		else if (fval < 0.0)
+			__atomic_add_uint32(&r->negative[index], 1);
+		else
+			__atomic_add_uint32(&r->positive[index], 1);
+	}
+	return sizeof(kagg_state__pctile_packed);
+}
+
 /*
  * __updateOneTupleGroupBy
  */
@@ -1279,6 +1546,7 @@ __updateOneTupleGroupBy(kern_context *kcxt,
 						const kern_expression *kexp_groupby_actions)
 {
 	char	   *curr;
+	uint32_t	peers;
 
 	if (!groupby_prepfn_buffer)
 	{
@@ -1293,6 +1561,7 @@ __updateOneTupleGroupBy(kern_context *kcxt,
 		groupby_prepfn_buffer = (char *)htup + t_hoff;
 	}
 	assert((uintptr_t)groupby_prepfn_buffer == MAXALIGN(groupby_prepfn_buffer));
+	peers = __warp_peers_mask(groupby_prepfn_buffer);
 
 	curr = groupby_prepfn_buffer;
 	for (int j=0; j < kexp_groupby_actions->u.pagg.nattrs; j++)
@@ -1308,10 +1577,10 @@ __updateOneTupleGroupBy(kern_context *kcxt,
 		switch (desc->action)
 		{
 			case KAGG_ACTION__NROWS_ANY:
-				curr += __update_groupby__nrows_any(kcxt, curr, cmeta, desc);
+				curr += __update_groupby__nrows_any(kcxt, curr, cmeta, desc, peers);
 				break;
 			case KAGG_ACTION__NROWS_COND:
-				curr += __update_groupby__nrows_cond(kcxt, curr, cmeta, desc);
+				curr += __update_groupby__nrows_cond(kcxt, curr, cmeta, desc, peers);
 				break;
 			case KAGG_ACTION__PMIN_INT32:
 				curr += __update_groupby__pmin_int32(kcxt, curr, cmeta, desc);
@@ -1333,11 +1602,17 @@ __updateOneTupleGroupBy(kern_context *kcxt,
 				break;
 			case KAGG_ACTION__PAVG_INT:
 			case KAGG_ACTION__PSUM_INT:
-				curr += __update_groupby__psum_int(kcxt, curr, cmeta, desc);
+				curr += __update_groupby__psum_int(kcxt, curr, cmeta, desc, peers);
 				break;
 			case KAGG_ACTION__PAVG_FP:
 			case KAGG_ACTION__PSUM_FP:
-				curr += __update_groupby__psum_fp(kcxt, curr, cmeta, desc);
+				curr += __update_groupby__psum_fp(kcxt, curr, cmeta, desc, peers);
+				break;
+			case KAGG_ACTION__PSUM_NUMERIC:
+			case KAGG_ACTION__PAVG_NUMERIC:
+			case KAGG_ACTION__PSUM_INT128:
+			case KAGG_ACTION__PAVG_INT128:
+				curr += __update_groupby__psum_numeric(kcxt, curr, cmeta, desc);
 				break;
 			case KAGG_ACTION__STDDEV:
 				curr += __update_groupby__pstddev(kcxt, curr, cmeta, desc);
@@ -1345,6 +1620,9 @@ __updateOneTupleGroupBy(kern_context *kcxt,
 			case KAGG_ACTION__COVAR:
 				curr += __update_groupby__pcovar(kcxt, curr, cmeta, desc);
 				break;
+			case KAGG_ACTION__PCTILE_FP:
+				curr += __update_groupby__ppctile(kcxt, curr, cmeta, desc);
+				break;
 			default:
 				/*
 				 * No more partial aggregation exists after grouping-keys
@@ -1577,6 +1855,20 @@ __setupGpuPreAggGroupByBufferOne(kern_context *kcxt,
 				pos += sizeof(kagg_state__psum_fp_packed);
 				break;
 
+			case KAGG_ACTION__PSUM_NUMERIC:
+			case KAGG_ACTION__PAVG_NUMERIC:
+			case KAGG_ACTION__PSUM_INT128:
+			case KAGG_ACTION__PAVG_INT128:
+				{
+					kagg_state__psum_numeric_packed *r =
+						(kagg_state__psum_numeric_packed *)pos;
+					memset(r, 0, sizeof(kagg_state__psum_numeric_packed));
+					r->scale = desc->arg_scale;
+					SET_VARSIZE(r, sizeof(kagg_state__psum_numeric_packed));
+					pos += sizeof(kagg_state__psum_numeric_packed);
+				}
+				break;
+
 			case KAGG_ACTION__STDDEV:
 				memset(pos, 0, sizeof(kagg_state__stddev_packed));
 				SET_VARSIZE(pos, sizeof(kagg_state__stddev_packed));
@@ -1589,6 +1881,18 @@ __setupGpuPreAggGroupByBufferOne(kern_context *kcxt,
 				pos += sizeof(kagg_state__covar_packed);
 				break;
 
+			case KAGG_ACTION__PCTILE_FP:
+				{
+					kagg_state__pctile_packed *r =
+						(kagg_state__pctile_packed *)pos;
+					memset(r, 0, sizeof(kagg_state__pctile_packed));
+					r->min_value = DBL_MAX;
+					r->max_value = -DBL_MAX;
+					SET_VARSIZE(r, sizeof(kagg_state__pctile_packed));
+					pos += sizeof(kagg_state__pctile_packed);
+				}
+				break;
+
 			default:
 				/* no more prep-function should exist after the keyref */
 				goto bailout;
@@ -1772,6 +2076,26 @@ __mergeGpuPreAggGroupByBufferOne(kern_context *kcxt,
 				}
 				break;
 
+			case KAGG_ACTION__PSUM_NUMERIC:
+			case KAGG_ACTION__PAVG_NUMERIC:
+			case KAGG_ACTION__PSUM_INT128:
+			case KAGG_ACTION__PAVG_INT128:
+				{
+					const kagg_state__psum_numeric_packed *s =
+						(const kagg_state__psum_numeric_packed *)pos;
+					kagg_state__psum_numeric_packed *r =
+						(kagg_state__psum_numeric_packed *)((char *)htup + t_hoff);
+					if (s->nitems > 0)
+					{
+						__atomic_add_uint32(&r->nitems, s->nitems);
+						__atomic_add_fixed_numeric(r, __kagg_psum_numeric_get_sum(s));
+					}
+					if (s->nnans > 0)
+						__atomic_add_uint32(&r->nnans, s->nnans);
+					nbytes = sizeof(kagg_state__psum_numeric_packed);
+				}
+				break;
+
 			case KAGG_ACTION__STDDEV:
 				{
 					const kagg_state__stddev_packed *s =
@@ -1807,6 +2131,31 @@ __mergeGpuPreAggGroupByBufferOne(kern_context *kcxt,
 				}
 				break;
 
+			case KAGG_ACTION__PCTILE_FP:
+				{
+					const kagg_state__pctile_packed *s =
+						(const kagg_state__pctile_packed *)pos;
+					kagg_state__pctile_packed *r =
+						(kagg_state__pctile_packed *)((char *)htup + t_hoff);
+					if (s->nitems > 0)
+					{
+						__atomic_add_uint32(&r->nitems, s->nitems);
+						__atomic_min_fp64(&r->min_value, s->min_value);
+						__atomic_max_fp64(&r->max_value, s->max_value);
+						if (s->nzeros > 0)
+							__atomic_add_uint32(&r->nzeros, s->nzeros);
+						for (int k=0; k < KAGG_PCTILE_NBUCKETS; k++)
+						{
+							if (s->negative[k] > 0)
+								__atomic_add_uint32(&r->negative[k], s->negative[k]);
+							if (s->positive[k] > 0)
+								__atomic_add_uint32(&r->positive[k], s->positive[k]);
+						}
+					}
+					nbytes = sizeof(kagg_state__pctile_packed);
+				}
+				break;
+
 			default:
 				goto bailout;
 		}
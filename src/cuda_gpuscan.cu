@@ -177,12 +177,141 @@ PGSTROM_LOCAL_MINMAX_TEMPLATE(max_int64, int64_t, i64,  Max,  LONG_MIN)
 PGSTROM_LOCAL_MINMAX_TEMPLATE(min_fp64, float8_t, fp64, Min,  DBL_MAX)
 PGSTROM_LOCAL_MINMAX_TEMPLATE(max_fp64, float8_t, fp64, Max, -DBL_MAX)
 
+/*
+ * pgstrom_local_sum_xxxx
+ *
+ * It returns the total sum of the thread-block, but no prefix sum unlike
+ * pgstrom_stair_sum_xxxx; so lighter for the partial aggregation.
+ */
+#define PGSTROM_LOCAL_SUM_TEMPLATE(SUFFIX, BASETYPE, FIELD)				\
+	PUBLIC_FUNCTION(BASETYPE)											\
+	pgstrom_local_sum_##SUFFIX(BASETYPE my_value)						\
+	{																	\
+		int			warp_id = get_local_id()   / warpSize;				\
+		int			n_warps = get_local_size() / warpSize;				\
+		BASETYPE	curr = my_value;									\
+																		\
+		/* makes warp local sum */										\
+		assert(__activemask() == ~0U);									\
+		curr += __shfl_xor_sync(__activemask(), curr, 0x0001);			\
+		curr += __shfl_xor_sync(__activemask(), curr, 0x0002);			\
+		curr += __shfl_xor_sync(__activemask(), curr, 0x0004);			\
+		curr += __shfl_xor_sync(__activemask(), curr, 0x0008);			\
+		curr += __shfl_xor_sync(__activemask(), curr, 0x0010);			\
+																		\
+		if (LaneId() == 0)												\
+			__stair_sum_buffer.FIELD[warp_id] = curr;					\
+		__syncthreads();												\
+																		\
+		if (warp_id == 0)												\
+		{																\
+			assert(__activemask() == ~0U);								\
+			curr = (LaneId() < n_warps ? __stair_sum_buffer.FIELD[LaneId()] : 0); \
+																		\
+			curr += __shfl_xor_sync(__activemask(), curr, 0x0001);		\
+			curr += __shfl_xor_sync(__activemask(), curr, 0x0002);		\
+			curr += __shfl_xor_sync(__activemask(), curr, 0x0004);		\
+			curr += __shfl_xor_sync(__activemask(), curr, 0x0008);		\
+			curr += __shfl_xor_sync(__activemask(), curr, 0x0010);		\
+																		\
+			__stair_sum_buffer.FIELD[LaneId()] = curr;					\
+		}																\
+		__syncthreads();												\
+		curr = __stair_sum_buffer.FIELD[LaneId()];						\
+		__syncthreads();												\
+		return curr;													\
+	}
+
+PGSTROM_LOCAL_SUM_TEMPLATE(int64, int64_t,  i64)
+PGSTROM_LOCAL_SUM_TEMPLATE(fp64,  float8_t, fp64)
+
 /* ----------------------------------------------------------------
  *
  * execGpuScanLoadSource and related
  *
  * ----------------------------------------------------------------
  */
+/*
+ * __gpuscan_save_fallback_row
+ *
+ * It saves the source tuple that raised ERRCODE_CPU_FALLBACK on the
+ * kds_fallback buffer, then clears the error status of the thread.
+ * So, only this row is re-executed by the CPU, and the results of
+ * other rows are kept. If no space left, the error status is kept
+ * as is, then the whole chunk shall be re-executed by the CPU.
+ */
+STATIC_FUNCTION(void)
+__gpuscan_save_fallback_row(kern_context *kcxt,
+							kern_data_store *kds_fallback,
+							const HeapTupleHeaderData *htup,
+							uint32_t t_len)
+{
+	union {
+		struct {
+			uint32_t	nitems;
+			uint32_t	usage;
+		} i;
+		uint64_t		v64;
+	} oldval, curval, newval;
+	uint32_t		sz = MAXALIGN(offsetof(kern_tupitem, htup) + t_len);
+	kern_tupitem   *tupitem;
+
+	if (!kds_fallback || !htup || t_len == 0 ||
+		kcxt->errcode != ERRCODE_CPU_FALLBACK)
+		return;
+	curval.i.nitems = __volatileRead(&kds_fallback->nitems);
+	curval.i.usage  = __volatileRead(&kds_fallback->usage);
+	do {
+		newval = oldval = curval;
+		newval.i.nitems += 1;
+		newval.i.usage  += __kds_packed(sz);
+
+		if (KDS_HEAD_LENGTH(kds_fallback) +
+			MAXALIGN(sizeof(uint32_t) * newval.i.nitems) +
+			__kds_unpack(newval.i.usage) > kds_fallback->length)
+			return;		/* no space left */
+	} while ((curval.v64 = atomicCAS((unsigned long long *)&kds_fallback->nitems,
+									 oldval.v64,
+									 newval.v64)) != oldval.v64);
+	tupitem = (kern_tupitem *)((char *)kds_fallback +
+							   kds_fallback->length -
+							   __kds_unpack(newval.i.usage));
+	tupitem->t_len = t_len;
+	tupitem->rowid = oldval.i.nitems;
+	memcpy(&tupitem->htup, htup, t_len);
+	KDS_GET_ROWINDEX(kds_fallback)[oldval.i.nitems] = newval.i.usage;
+	/* this row is no longer processed by the GPU */
+	kcxt->errcode = ERRCODE_STROM_SUCCESS;
+}
+
+/*
+ * __gpuscan_block_htup_length
+ *
+ * lp_items[] keeps only the offset of the tuple, so we look up the line
+ * pointer again. It is rarely called, only for row-granular CPU fallback.
+ */
+STATIC_FUNCTION(uint32_t)
+__gpuscan_block_htup_length(const kern_data_store *kds_src,
+							const HeapTupleHeaderData *htup)
+{
+	const char	   *base = (const char *)kds_src + kds_src->block_offset;
+	PageHeaderData *pg_page;
+	uint32_t		lp_off;
+	uint32_t		nitems;
+
+	pg_page = (PageHeaderData *)(base + (((const char *)htup - base) & ~(BLCKSZ-1)));
+	lp_off = (const char *)htup - (const char *)pg_page;
+	nitems = PageGetMaxOffsetNumber(pg_page);
+	for (uint32_t k=0; k < nitems; k++)
+	{
+		ItemIdData *lpp = &pg_page->pd_linp[k];
+
+		if (ItemIdIsNormal(lpp) && ItemIdGetOffset(lpp) == lp_off)
+			return ItemIdGetLength(lpp);
+	}
+	return 0;
+}
+
 STATIC_FUNCTION(int)
 __gpuscan_load_source_row(kern_context *kcxt,
 						  kern_warp_context *wp,
@@ -190,7 +319,8 @@ __gpuscan_load_source_row(kern_context *kcxt,
 						  const kern_expression *kexp_load_vars,
 						  const kern_expression *kexp_scan_quals,
 						  const kern_expression *kexp_move_vars,
-						  char *dst_kvecs_buffer)
+						  char *dst_kvecs_buffer,
+						  kern_data_store *kds_fallback)
 {
 	uint32_t	count;
 	uint32_t	index;
@@ -230,7 +360,12 @@ __gpuscan_load_source_row(kern_context *kcxt,
 								  kexp_scan_quals,
 								  kds_src,
 								  &tupitem->htup))
+		{
+			__gpuscan_save_fallback_row(kcxt, kds_fallback,
+										&tupitem->htup,
+										tupitem->t_len);
 			tupitem = NULL;
+		}
 	}
 	/* error checks */
 	if (__syncthreads_count(kcxt->errcode != ERRCODE_STROM_SUCCESS) > 0)
@@ -260,6 +395,98 @@ __gpuscan_load_source_row(kern_context *kcxt,
 	return (WARP_WRITE_POS(wp,0) >= WARP_READ_POS(wp,0) + get_local_size() ? 1 : 0);
 }
 
+/*
+ * MVCC visibility checks on the device
+ *
+ * It checks visibility of the heap tuple using the hint bits and the
+ * snapshot of the query, without commit-logs. It returns 1 (visible),
+ * 0 (invisible), or -1 if we cannot determine it on the device.
+ */
+INLINE_FUNCTION(bool)
+__gpuscan_xid_precedes(TransactionId xid1, TransactionId xid2)
+{
+	if (xid1 < FirstNormalTransactionId ||
+		xid2 < FirstNormalTransactionId)
+		return (xid1 < xid2);
+	return ((int32_t)(xid1 - xid2) < 0);
+}
+
+STATIC_FUNCTION(int)
+__gpuscan_xid_in_snapshot(const kern_snapshot_info *snap, TransactionId xid)
+{
+	uint32_t	i;
+
+	if (__gpuscan_xid_precedes(xid, snap->xmin))
+		return 0;
+	if (!__gpuscan_xid_precedes(xid, snap->xmax))
+		return 1;
+	for (i=0; i < snap->xcnt + snap->subxcnt; i++)
+	{
+		if (snap->xip[i] == xid)
+			return 1;
+	}
+	/* xid may be a sub-transaction not in the subxip[] */
+	if (snap->suboverflowed)
+		return -1;
+	return 0;
+}
+
+STATIC_FUNCTION(int)
+__gpuscan_heap_tuple_visibility(const kern_snapshot_info *snap,
+								const HeapTupleHeaderData *htup)
+{
+	uint16_t	infomask = htup->t_infomask;
+	int			status;
+
+	if ((infomask & (HEAP_MOVED_OFF | HEAP_MOVED_IN)) != 0)
+		return -1;
+	/* checks for xmin */
+	if ((infomask & HEAP_XMIN_COMMITTED) == 0)
+		return ((infomask & HEAP_XMIN_INVALID) != 0 ? 0 : -1);
+	if ((infomask & HEAP_XMIN_INVALID) == 0)	/* not frozen */
+	{
+		status = __gpuscan_xid_in_snapshot(snap, htup->t_choice.t_heap.t_xmin);
+		if (status != 0)
+			return (status > 0 ? 0 : -1);
+	}
+	/* checks for xmax */
+	if ((infomask & HEAP_XMAX_INVALID) != 0)
+		return 1;
+	if ((infomask & HEAP_XMAX_LOCK_ONLY) != 0 ||
+		(infomask & (HEAP_XMAX_IS_MULTI |
+					 HEAP_XMAX_KEYSHR_LOCK |
+					 HEAP_XMAX_EXCL_LOCK)) == HEAP_XMAX_EXCL_LOCK)
+		return 1;		/* locked only */
+	if ((infomask & HEAP_XMAX_IS_MULTI) != 0 ||
+		(infomask & HEAP_XMAX_COMMITTED) == 0)
+		return -1;
+	status = __gpuscan_xid_in_snapshot(snap, htup->t_choice.t_heap.t_xmax);
+	if (status != 0)
+		return (status > 0 ? 1 : -1);
+	return 0;
+}
+
+/*
+ * __gpuscan_tablesample_tuple
+ *
+ * TABLESAMPLE BERNOULLI on the device; it is the same logic as
+ * bernoulli_nextsampletuple() doing on the host.
+ */
+INLINE_FUNCTION(bool)
+__gpuscan_tablesample_tuple(const kern_session_info *session,
+							BlockNumber block_nr,
+							uint32_t lineoff)
+{
+	uint32_t	hashinput[3];
+
+	if (session->tablesample_method != KERN_TABLESAMPLE__BERNOULLI)
+		return true;
+	hashinput[0] = block_nr;
+	hashinput[1] = lineoff;
+	hashinput[2] = session->tablesample_seed;
+	return (pg_hash_any(hashinput, sizeof(hashinput)) < session->tablesample_cutoff);
+}
+
 /*
  * __gpuscan_load_source_block
  */
@@ -270,7 +497,8 @@ __gpuscan_load_source_block(kern_context *kcxt,
 							const kern_expression *kexp_load_vars,
 							const kern_expression *kexp_scan_quals,
 							const kern_expression *kexp_move_vars,
-							char *dst_kvecs_buffer)
+							char *dst_kvecs_buffer,
+							kern_data_store *kds_fallback)
 {
 	uint32_t	wr_pos = wp->lp_wr_pos;
 	uint32_t	rd_pos = wp->lp_rd_pos;
@@ -278,6 +506,7 @@ __gpuscan_load_source_block(kern_context *kcxt,
 	uint32_t	count;
 	bool		has_next_lp_items = false;
 	HeapTupleHeaderData *htup = NULL;
+	const kern_snapshot_info *snap = SESSION_SNAPSHOT(kcxt->session);
 
 	assert(wr_pos >= rd_pos);
 	block_id = (get_global_size() / warpSize) * wp->smx_row_count;
@@ -294,7 +523,12 @@ __gpuscan_load_source_block(kern_context *kcxt,
 									  kexp_load_vars,
 									  kexp_scan_quals,
 									  kds_src, htup))
+			{
+				if (kds_fallback && kcxt->errcode == ERRCODE_CPU_FALLBACK)
+					__gpuscan_save_fallback_row(kcxt, kds_fallback, htup,
+												__gpuscan_block_htup_length(kds_src, htup));
 				htup = NULL;
+			}
 		}
 		/* error checks */
 		if (__syncthreads_count(kcxt->errcode != ERRCODE_STROM_SUCCESS) > 0)
@@ -363,6 +597,25 @@ __gpuscan_load_source_block(kern_context *kcxt,
 				htup->t_ctid.ip_blkid.bi_hi = (uint16_t)(block_nr >> 16);
 				htup->t_ctid.ip_blkid.bi_lo = (uint16_t)(block_nr & 0xffffU);
 				htup->t_ctid.ip_posid = index + 1;
+				/* TABLESAMPLE BERNOULLI, if any */
+				if (!__gpuscan_tablesample_tuple(kcxt->session,
+												 block_nr, index + 1))
+					htup = NULL;
+				/* MVCC checks, if page is not all-visible */
+				else if (snap && (pg_page->pd_flags & PD_ALL_VISIBLE) == 0)
+				{
+					int		status = __gpuscan_heap_tuple_visibility(snap, htup);
+
+					if (status < 0)
+					{
+						STROM_CPU_FALLBACK(kcxt, "tuple visibility is not determined by the hint bits");
+						__gpuscan_save_fallback_row(kcxt, kds_fallback, htup,
+													ItemIdGetLength(lpp));
+						htup = NULL;
+					}
+					else if (status == 0)
+						htup = NULL;
+				}
 			}
 		}
 		has_next_lp_items = (index + warpSize < nitems);
@@ -518,6 +771,186 @@ xmin_is_visible:
 	return true;
 }
 
+/*
+ * kds_column_check_bitfilter
+ *
+ * It evaluates the boolean scan qualifiers (like 'flag AND NOT other_flag')
+ * on the bit-packed columns by 32bit word-wide operations, prior to the
+ * load of the row. All the threads in a warp fetch the same words, then
+ * pick up their own bit. It only skips the rows never satisfy the scan
+ * qualifiers (false or NULL), so the rows survived are evaluated as usual.
+ */
+STATIC_FUNCTION(bool)
+kds_column_check_bitfilter(const kern_session_info *session,
+						   const kern_data_store *kds,
+						   uint32_t rowid)
+{
+	uint32_t	bits = ~0U;
+
+	for (int i=0; i < session->gpucache_bitfilter_nkeys; i++)
+	{
+		int			attnum = session->gpucache_bitfilter_attnums[i];
+		const kern_colmeta *cmeta;
+		const uint32_t *values;
+
+		cmeta = &kds->colmeta[Abs(attnum) - 1];
+		if (cmeta->encode_width != KDS_COLUMN_ENCODE_BITMAP)
+			continue;
+		values = (const uint32_t *)
+			((const char *)kds + __kds_unpack(cmeta->values_offset));
+		if (attnum > 0)
+			bits &= values[rowid>>5];
+		else
+			bits &= ~values[rowid>>5];
+		if (cmeta->nullmap_offset != 0)
+		{
+			const uint32_t *nullmap = (const uint32_t *)
+				((const char *)kds + __kds_unpack(cmeta->nullmap_offset));
+			bits &= nullmap[rowid>>5];
+		}
+	}
+	return (bits & (1U << (rowid & 31))) != 0;
+}
+
+/*
+ * kds_column_fetch_int64 - int64 form of the integer-like column, if not NULL
+ */
+STATIC_FUNCTION(bool)
+kds_column_fetch_int64(const kern_data_store *kds,
+					   uint32_t attnum,
+					   uint32_t rowid,
+					   int64_t *p_ival)
+{
+	const kern_colmeta *cmeta = &kds->colmeta[attnum - 1];
+	const char *values;
+
+	if (KDS_COLUMN_ITEM_ISNULL(kds, cmeta, rowid))
+		return false;
+	values = (const char *)kds + __kds_unpack(cmeta->values_offset);
+	if (cmeta->encode_width > 0)
+		*p_ival = KDS_COLUMN_DECODE_VALUE(cmeta, values, rowid);
+	else if (cmeta->attlen == sizeof(int16_t))
+		*p_ival = ((const int16_t *)values)[rowid];
+	else if (cmeta->attlen == sizeof(int32_t))
+		*p_ival = ((const int32_t *)values)[rowid];
+	else
+		*p_ival = ((const int64_t *)values)[rowid];
+	return true;
+}
+
+/*
+ * kds_column_fetch_index_key - int64 form of the index key, if not NULL
+ */
+INLINE_FUNCTION(bool)
+kds_column_fetch_index_key(const kern_data_store *kds,
+						   uint32_t rowid,
+						   int64_t *p_key)
+{
+	return kds_column_fetch_int64(kds, kds->column_index_attnum, rowid, p_key);
+}
+
+/*
+ * __gpuscan_load_source_column_index
+ *
+ * It fetches the rows by the hash-chain of the GpuCache index, instead of
+ * the full scan. The first thread-block only walks on the chain; its thread
+ * zero collects the next blockSize candidates, then scan_quals shall be
+ * evaluated for them as usual, because the chain may contain the rows with
+ * other key values (hash collision) or being invisible.
+ * wp->smx_row_count saves the cursor (rowid+1) of the chain; 0 means the
+ * head of chain, and UINT_MAX means the end of chain.
+ */
+STATIC_FUNCTION(int)
+__gpuscan_load_source_column_index(kern_context *kcxt,
+								   kern_warp_context *wp,
+								   const kern_data_store *kds_src,
+								   const kern_data_extra *kds_extra,
+								   const kern_expression *kexp_load_vars,
+								   const kern_expression *kexp_scan_quals,
+								   const kern_expression *kexp_move_vars,
+								   char *dst_kvecs_buffer)
+{
+	__shared__ uint32_t smx_rowids[MAXTHREADS_PER_BLOCK];
+	__shared__ uint32_t smx_nrows;
+	int64_t		key = kcxt->session->gpucache_index_value;
+	uint32_t	cursor;
+	uint32_t	count;
+	uint32_t	wr_pos;
+	bool		is_valid = false;
+
+	cursor = wp->smx_row_count;
+	__syncthreads();
+	if (get_global_base() > 0 || cursor == UINT_MAX)
+	{
+		if (get_local_id() == 0)
+			wp->scan_done = 1;
+		return 1;
+	}
+	if (get_local_id() == 0)
+	{
+		const uint32_t *islots = KDS_COLUMN_INDEX_SLOTS(kds_src);
+		const uint32_t *inexts = KDS_COLUMN_INDEX_NEXTS(kds_src);
+		uint32_t	rowid;
+		uint32_t	nrows = 0;
+
+		if (cursor == 0)
+			rowid = islots[KDS_COLUMN_INDEX_HASH(key) %
+						   kds_src->column_index_nslots];
+		else
+			rowid = cursor - 1;
+		while (rowid != UINT_MAX && nrows < get_local_size())
+		{
+			int64_t		ival;
+
+			if (kds_column_fetch_index_key(kds_src, rowid, &ival) && ival == key)
+				smx_rowids[nrows++] = rowid;
+			rowid = inexts[rowid];
+		}
+		smx_nrows = nrows;
+		wp->smx_row_count = (rowid == UINT_MAX ? UINT_MAX : rowid + 1);
+	}
+	__syncthreads();
+
+	if (get_local_id() < smx_nrows)
+	{
+		uint32_t	rowid = smx_rowids[get_local_id()];
+
+		if (kds_column_check_visibility(kcxt, kds_src, rowid) &&
+			ExecLoadVarsOuterColumn(kcxt,
+									kexp_load_vars,
+									kexp_scan_quals,
+									kds_src,
+									kds_extra,
+									rowid))
+			is_valid = true;
+	}
+	/* error checks */
+	if (__syncthreads_count(kcxt->errcode != ERRCODE_STROM_SUCCESS) > 0)
+		return -1;
+	/*
+	 * save the private kvars slot on the combination buffer (depth=0)
+	 */
+	wr_pos = WARP_WRITE_POS(wp,0);
+	wr_pos += pgstrom_stair_sum_binary(is_valid, &count);
+	if (get_local_id() == 0)
+		WARP_WRITE_POS(wp,0) += count;
+	if (is_valid)
+	{
+		if (!ExecMoveKernelVariables(kcxt,
+									 kexp_move_vars,
+									 dst_kvecs_buffer,
+									 (wr_pos % KVEC_UNITSZ)))
+		{
+			assert(kcxt->errcode != ERRCODE_STROM_SUCCESS);
+		}
+	}
+	/* error checks */
+	if (__syncthreads_count(kcxt->errcode != ERRCODE_STROM_SUCCESS) > 0)
+		return -1;
+	/* move to the next depth if more than blockSize rows were fetched */
+	return (WARP_WRITE_POS(wp,0) >= WARP_READ_POS(wp,0) + get_local_size() ? 1 : 0);
+}
+
 STATIC_FUNCTION(int)
 __gpuscan_load_source_column(kern_context *kcxt,
 							 kern_warp_context *wp,
@@ -533,6 +966,16 @@ __gpuscan_load_source_column(kern_context *kcxt,
 	uint32_t	wr_pos;
 	bool		is_valid = false;
 
+	/* lookup by the GpuCache index, if available */
+	if (kcxt->session->gpucache_index_attnum > 0 &&
+		kcxt->session->gpucache_index_attnum == kds_src->column_index_attnum)
+		return __gpuscan_load_source_column_index(kcxt, wp,
+												  kds_src,
+												  kds_extra,
+												  kexp_load_vars,
+												  kexp_scan_quals,
+												  kexp_move_vars,
+												  dst_kvecs_buffer);
 	/* fetch next blockSize tuples */
 	count = wp->smx_row_count;
 	__syncthreads();
@@ -551,6 +994,7 @@ __gpuscan_load_source_column(kern_context *kcxt,
 	 * fetch the outer tuple to scan
 	 */
 	if (index < kds_src->nitems &&
+		kds_column_check_bitfilter(kcxt->session, kds_src, index) &&
 		kds_column_check_visibility(kcxt, kds_src, index))
 	{
 		if (ExecLoadVarsOuterColumn(kcxt,
@@ -596,7 +1040,8 @@ execGpuScanLoadSource(kern_context *kcxt,
 					  const kern_expression *kexp_load_vars,
 					  const kern_expression *kexp_scan_quals,
 					  const kern_expression *kexp_move_vars,
-					  char *dst_kvecs_buffer)
+					  char *dst_kvecs_buffer,
+					  kern_data_store *kds_fallback)
 {
 	/*
 	 * Move to the next depth (or projection), if combination buffer (depth=0)
@@ -618,14 +1063,16 @@ execGpuScanLoadSource(kern_context *kcxt,
 											 kexp_load_vars,
 											 kexp_scan_quals,
 											 kexp_move_vars,
-											 dst_kvecs_buffer);
+											 dst_kvecs_buffer,
+											 kds_fallback);
 		case KDS_FORMAT_BLOCK:
 			return __gpuscan_load_source_block(kcxt, wp,
 											   kds_src,
 											   kexp_load_vars,
 											   kexp_scan_quals,
 											   kexp_move_vars,
-											   dst_kvecs_buffer);
+											   dst_kvecs_buffer,
+											   kds_fallback);
 		case KDS_FORMAT_ARROW:
 			return __gpuscan_load_source_arrow(kcxt, wp,
 											   kds_src,
@@ -773,7 +1220,47 @@ __gpucache_apply_insert_log(kern_context *kcxt,
 
 		assert(cmeta->values_offset != 0);
 		base = (char *)kds + __kds_unpack(cmeta->values_offset);
-		if (cmeta->attlen > 0)
+		if (cmeta->encode_width == KDS_COLUMN_ENCODE_BITMAP)
+		{
+			uint32_t   *bitmap = (uint32_t *)base;
+
+			offset = TYPEALIGN(cmeta->attalign, offset);
+			if (*((const bool *)((const char *)htup + offset)))
+				__atomic_or_uint32(&bitmap[rowid>>5], (1U<<(rowid&31)));
+			else
+				__atomic_and_uint32(&bitmap[rowid>>5], ~(1U<<(rowid&31)));
+			offset += cmeta->attlen;
+		}
+		else if (cmeta->encode_width > 0)
+		{
+			const char *pos;
+			int64_t		ival;
+			uint64_t	delta;
+
+			offset = TYPEALIGN(cmeta->attalign, offset);
+			pos = (const char *)htup + offset;
+			if (cmeta->attlen == sizeof(int16_t))
+				ival = *((const int16_t *)pos);
+			else if (cmeta->attlen == sizeof(int32_t))
+				ival = *((const int32_t *)pos);
+			else
+				ival = *((const int64_t *)pos);
+			delta = (uint64_t)(ival - cmeta->encode_base);
+			if (ival < cmeta->encode_base ||
+				delta >= (1UL << (8 * cmeta->encode_width)))
+			{
+				STROM_ELOG(kcxt, "gpucache: value is out of range of the column encoding");
+				return false;
+			}
+			if (cmeta->encode_width == sizeof(uint8_t))
+				((uint8_t *)base)[rowid] = delta;
+			else if (cmeta->encode_width == sizeof(uint16_t))
+				((uint16_t *)base)[rowid] = delta;
+			else
+				((uint32_t *)base)[rowid] = delta;
+			offset += cmeta->attlen;
+		}
+		else if (cmeta->attlen > 0)
 		{
 			offset = TYPEALIGN(cmeta->attalign, offset);
 			memcpy(base + cmeta->attlen * rowid,
@@ -785,7 +1272,7 @@ __gpucache_apply_insert_log(kern_context *kcxt,
 		{
 			char	   *vl_pos;
 			uint32_t	vl_len;
-			uint32_t	vl_off;
+			uint64_t	vl_off;
 
 			assert(cmeta->attlen == -1);
 			if (!VARATT_NOT_PAD_BYTE((char *)htup + offset))
@@ -802,7 +1289,7 @@ __gpucache_apply_insert_log(kern_context *kcxt,
 			memcpy((char *)extra + vl_off,
 				   (char *)htup + offset,
 				   vl_len);
-			((uint32_t *)base)[rowid] = __kds_packed(vl_off);
+			KDS_COLUMN_EXTRA_OFFSETS(kds, cmeta)[rowid] = vl_off;
 			offset += vl_len;
 		}
 	}
@@ -813,6 +1300,119 @@ __gpucache_apply_insert_log(kern_context *kcxt,
 	return true;
 }
 
+/*
+ * __gpucache_summary_lookup - lookup the group-slot, or setup the new one
+ */
+STATIC_FUNCTION(kern_gpucache_summary_slot *)
+__gpucache_summary_lookup(kern_context *kcxt,
+						  kern_gpucache_summary *gsum,
+						  bool key_isnull, int64_t key)
+{
+	uint32_t	hindex = (key_isnull ? 0 : KDS_COLUMN_INDEX_HASH(key)) % gsum->nslots;
+
+	for (uint32_t count=0; count < gsum->nslots; count++)
+	{
+		kern_gpucache_summary_slot *slot = GPUCACHE_SUMMARY_SLOT(gsum, hindex);
+		uint32_t	state = __volatileRead(&slot->state);
+
+		if (state == GPUCACHE_SUMMARY_SLOT__EMPTY)
+		{
+			state = __atomic_cas_uint32(&slot->state,
+										GPUCACHE_SUMMARY_SLOT__EMPTY,
+										GPUCACHE_SUMMARY_SLOT__SETUP);
+			if (state == GPUCACHE_SUMMARY_SLOT__EMPTY)
+			{
+				/* ok, this thread setup the new group */
+				slot->key_isnull = key_isnull;
+				slot->key = (key_isnull ? 0 : key);
+				__threadfence();
+				__atomic_write_uint32(&slot->state, GPUCACHE_SUMMARY_SLOT__VALID);
+				__atomic_add_uint32(&gsum->ngroups, 1);
+				return slot;
+			}
+		}
+		/* wait for the concurrent setup of the group, if any */
+		while (state == GPUCACHE_SUMMARY_SLOT__SETUP)
+			state = __volatileRead(&slot->state);
+		if (slot->key_isnull == key_isnull &&
+			(key_isnull || slot->key == key))
+			return slot;
+		hindex = (hindex + 1) % gsum->nslots;
+	}
+	STROM_ELOG(kcxt, "gpucache: summary has no space for the new group, increase 'summary_nslots'");
+	return NULL;
+}
+
+/*
+ * gpucache_summary_update - reconciles the summary with visibility of the row
+ *
+ * If @overwrite, the row is going to be overwritten by the INSERT log, so
+ * it is removed from the summary prior to the update of the values.
+ * Only one thread touches a particular rowid in the phase (by the owner-id),
+ * but the group-slots are shared by the concurrent threads.
+ */
+STATIC_FUNCTION(void)
+gpucache_summary_update(kern_context *kcxt,
+						kern_data_store *kds,
+						GpuCacheSysattr *sysattr,
+						uint32_t rowid,
+						bool overwrite)
+{
+	kern_gpucache_summary *gsum;
+	kern_gpucache_summary_slot *slot;
+	bool		is_counted;
+	bool		is_visible;
+	bool		key_isnull;
+	int64_t		key = 0;
+	int64_t		sign;
+
+	if (kds->column_summary_offset == 0)
+		return;
+	is_counted = ((sysattr->flags & GCACHE_SYSATTR_FLAG__SUMMARIZED) != 0);
+	is_visible = (!overwrite &&
+				  sysattr->xmin == FrozenTransactionId &&
+				  sysattr->xmax != FrozenTransactionId);
+	if (is_counted == is_visible)
+		return;
+	gsum = KDS_COLUMN_SUMMARY(kds);
+	key_isnull = !kds_column_fetch_int64(kds, gsum->key_attnum, rowid, &key);
+	slot = __gpucache_summary_lookup(kcxt, gsum, key_isnull, key);
+	if (!slot)
+		return;
+	sign = (is_visible ? 1 : -1);
+	__atomic_add_int64(&slot->nitems, sign);
+	for (int k=0; k < gsum->nvalues; k++)
+	{
+		const kern_colmeta *cmeta = &kds->colmeta[gsum->value_attnums[k] - 1];
+		const char *values;
+		int64_t		ival;
+
+		if (gsum->value_kinds[k] == 'i')
+		{
+			if (!kds_column_fetch_int64(kds, gsum->value_attnums[k], rowid, &ival))
+				continue;
+			__atomic_add_int64(&slot->values[k].sum.ival, sign * ival);
+		}
+		else
+		{
+			if (KDS_COLUMN_ITEM_ISNULL(kds, cmeta, rowid))
+				continue;
+			values = (const char *)kds + __kds_unpack(cmeta->values_offset);
+			if (cmeta->attlen == sizeof(float4_t))
+				__atomic_add_fp64(&slot->values[k].sum.fval,
+								  (float8_t)sign * ((const float4_t *)values)[rowid]);
+			else
+				__atomic_add_fp64(&slot->values[k].sum.fval,
+								  (float8_t)sign * ((const float8_t *)values)[rowid]);
+		}
+		__atomic_add_int64(&slot->values[k].nvalids, sign);
+	}
+	if (is_visible)
+		sysattr->flags |= GCACHE_SYSATTR_FLAG__SUMMARIZED;
+	else
+		sysattr->flags &= ~GCACHE_SYSATTR_FLAG__SUMMARIZED;
+}
+
 STATIC_FUNCTION(void)
 gpucache_apply_update_logs(kern_context *kcxt,
 						   kern_gpucache_redolog *redo,
@@ -844,7 +1444,9 @@ gpucache_apply_update_logs(kern_context *kcxt,
 			sysattr = kds_column_get_sysattr(kds, i_log->rowid);
 			if (sysattr->owner == owner_id)
 			{
+				gpucache_summary_update(kcxt, kds, sysattr, i_log->rowid, true);
 				__gpucache_apply_insert_log(kcxt, kds, extra, sysattr, i_log);
+				gpucache_summary_update(kcxt, kds, sysattr, i_log->rowid, false);
 				if (rowid_max == UINT_MAX || rowid_max < i_log->rowid)
 					rowid_max = i_log->rowid;
 			}
@@ -918,9 +1520,8 @@ __gpucache_count_deadspace(kern_data_store *kds,
 			assert(cmeta->attlen == -1);
 			if (!KDS_COLUMN_ITEM_ISNULL(kds, cmeta, rowid))
 			{
-				uint32_t   *base = (uint32_t *)
-					((char *)kds + __kds_unpack(cmeta->values_offset));
-				char	   *vl = (char *)extra + __kds_unpack(base[rowid]);
+				char	   *vl = ((char *)extra +
+								  KDS_COLUMN_EXTRA_OFFSETS(kds, cmeta)[rowid]);
 
 				retval += MAXALIGN(VARSIZE_ANY(vl));
 			}
@@ -966,6 +1567,7 @@ gpucache_apply_xact_logs(kern_context *kcxt,
 				if (sysattr->owner == owner_id)
 				{
 					sysattr->xmin = FrozenTransactionId;
+					gpucache_summary_update(kcxt, kds, sysattr, tx_log->rowid, false);
 					if (rowid_max == UINT_MAX || rowid_max < tx_log->rowid)
 						rowid_max = tx_log->rowid;
 				}
@@ -975,6 +1577,7 @@ gpucache_apply_xact_logs(kern_context *kcxt,
 				if (sysattr->owner == owner_id)
 				{
 					sysattr->xmax = FrozenTransactionId;
+					gpucache_summary_update(kcxt, kds, sysattr, tx_log->rowid, false);
 					if (rowid_max == UINT_MAX || rowid_max < tx_log->rowid)
 						rowid_max = tx_log->rowid;
 					sz = __gpucache_count_deadspace(kds, extra, tx_log->rowid);
@@ -1020,6 +1623,51 @@ gpucache_apply_xact_logs(kern_context *kcxt,
 	}
 }
 
+/*
+ * gpucache_rebuild_index - rebuilds the hash index of the key column
+ *
+ * The rowid of the deleted rows may be reused by the later INSERT, so we
+ * rebuild the entire hash-chain rather than incremental maintenance.
+ */
+STATIC_FUNCTION(void)
+gpucache_rebuild_index(kern_context *kcxt,
+					   kern_data_store *kds,
+					   int phase)
+{
+	uint32_t   *islots = KDS_COLUMN_INDEX_SLOTS(kds);
+	uint32_t   *inexts = KDS_COLUMN_INDEX_NEXTS(kds);
+	uint32_t	index;
+
+	if (kds->column_index_attnum == 0)
+		return;
+	if (phase == 7)
+	{
+		for (index = get_global_id();
+			 index < kds->column_index_nslots;
+			 index += get_global_size())
+			islots[index] = UINT_MAX;
+	}
+	else
+	{
+		for (index = get_global_id();
+			 index < kds->nitems;
+			 index += get_global_size())
+		{
+			GpuCacheSysattr *sysattr = kds_column_get_sysattr(kds, index);
+			int64_t		key;
+			uint32_t	hindex;
+
+			inexts[index] = UINT_MAX;
+			if (sysattr->xmin == InvalidTransactionId ||
+				sysattr->xmax == FrozenTransactionId ||
+				!kds_column_fetch_index_key(kds, index, &key))
+				continue;
+			hindex = KDS_COLUMN_INDEX_HASH(key) % kds->column_index_nslots;
+			inexts[index] = __atomic_write_uint32(&islots[hindex], index);
+		}
+	}
+}
+
 KERNEL_FUNCTION(void)
 kern_gpucache_apply_redo(kern_gpucache_redolog *gcache_redo,
 						 kern_data_store *kds,
@@ -1053,6 +1701,10 @@ kern_gpucache_apply_redo(kern_gpucache_redolog *gcache_redo,
 		case 6:		/* apply XACT log entries */
 			gpucache_apply_xact_logs(&kcxt, gcache_redo, kds, extra);
 			break;
+		case 7:		/* clean up the hash-slots of the index */
+		case 8:		/* link the live rows to the hash-chain */
+			gpucache_rebuild_index(&kcxt, kds, phase);
+			break;
 		default:
 			STROM_ELOG(&kcxt, "gpucache: unknown phase");
 			break;
@@ -1060,46 +1712,75 @@ kern_gpucache_apply_redo(kern_gpucache_redolog *gcache_redo,
 	STROM_WRITEBACK_ERROR_STATUS(&gcache_redo->kerror, &kcxt);
 }
 
+/*
+ * kern_gpucache_compaction
+ *
+ * phase-1: copies the varlena values of the rows in [row_start, row_end)
+ *          into the new extra buffer, and saves the new offsets on the
+ *          @new_offsets array. The main buffer is not modified, so the
+ *          concurrent scans can keep referencing the old extra buffer.
+ * phase-2: installs the @new_offsets onto the main buffer; caller must
+ *          hold the exclusive lock of the GpuCache.
+ */
 KERNEL_FUNCTION(void)
 kern_gpucache_compaction(kern_data_store *kds,
 						 kern_data_extra *extra_src,
-						 kern_data_extra *extra_dst)
+						 kern_data_extra *extra_dst,
+						 uint64_t *new_offsets,
+						 uint32_t nitems,
+						 uint32_t row_start,
+						 uint32_t row_end,
+						 int phase)
 {
 	uint32_t	index;
 
-	for (index = get_global_id();
-		 index < kds->nitems;
+	assert(nitems <= kds->nitems && row_end <= nitems);
+	for (index = row_start + get_global_id();
+		 index < row_end;
 		 index += get_global_size())
 	{
+		uint64_t   *__new_offsets = new_offsets;
+
 		for (int j=0; j < kds->ncols; j++)
 		{
 			kern_colmeta   *cmeta = &kds->colmeta[j];
-			uint32_t	   *values;
+			uint64_t	   *values;
 			char		   *vl_src;
 			uint32_t		vl_len;
 			uint64_t		offset;
 
 			if (cmeta->attlen >= 0)
 				continue;
+			values = KDS_COLUMN_EXTRA_OFFSETS(kds, cmeta);
+			if (phase == 2)
+			{
+				if (__new_offsets[index] != 0)
+					values[index] = __new_offsets[index];
+				__new_offsets += nitems;
+				continue;
+			}
+			__new_offsets[index] = 0;
 			if (cmeta->nullmap_offset != 0)
 			{
 				uint8_t	   *nullmap = (uint8_t *)
 					((char *)kds + __kds_unpack(cmeta->nullmap_offset));
 
 				if (att_isnull(index, nullmap))
+				{
+					__new_offsets += nitems;
 					continue;
+				}
 			}
-			values = (uint32_t *)
-				((char *)kds + __kds_unpack(cmeta->values_offset));
-			vl_src = ((char *)extra_src + __kds_unpack(values[index]));
+			vl_src = ((char *)extra_src + values[index]);
 			vl_len = VARSIZE_ANY(vl_src);
 
 			offset = __atomic_add_uint64(&extra_dst->usage, MAXALIGN(vl_len));
 			if (offset + vl_len <= extra_dst->length)
 			{
 				memcpy((char *)extra_dst + offset, vl_src, vl_len);
-				values[index] = __kds_packed(offset);
+				__new_offsets[index] = offset;
 			}
+			__new_offsets += nitems;
 		}
 	}
 }
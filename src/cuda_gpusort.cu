@@ -0,0 +1,253 @@
+/*
+ * cuda_gpusort.cu
+ *
+ * Device implementation of GPU top-k for ORDER BY ... LIMIT
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include "cuda_common.h"
+
+/*
+ * __gpusort_fetch_attr
+ *
+ * It returns the address of the 'resno' column of the tuple, or NULL if
+ * the column is NULL or not exists.
+ */
+PUBLIC_FUNCTION(const char *)
+__gpusort_fetch_attr(const kern_data_store *kds,
+					 const kern_tupitem *tupitem,
+					 int resno)
+{
+	const HeapTupleHeaderData *htup = &tupitem->htup;
+	int			ncols = Min(htup->t_infomask2 & HEAP_NATTS_MASK, kds->ncols);
+	bool		heap_hasnull = ((htup->t_infomask & HEAP_HASNULL) != 0);
+	uint32_t	offset = htup->t_hoff;
+	const char *addr = NULL;
+
+	if (resno < 1 || resno > ncols)
+		return NULL;
+	for (int j=0; j < resno; j++)
+	{
+		const kern_colmeta *cmeta = &kds->colmeta[j];
+
+		if (heap_hasnull && att_isnull(j, htup->t_bits))
+		{
+			addr = NULL;
+			continue;
+		}
+		if (cmeta->attlen > 0)
+			offset = TYPEALIGN(cmeta->attalign, offset);
+		else if (!VARATT_NOT_PAD_BYTE((char *)htup + offset))
+			offset = TYPEALIGN(cmeta->attalign, offset);
+		addr = ((const char *)htup + offset);
+		if (cmeta->attlen > 0)
+			offset += cmeta->attlen;
+		else
+			offset += VARSIZE_ANY(addr);
+	}
+	return addr;
+}
+
+/*
+ * __gpusort_normalized_value
+ *
+ * It returns the not-null value as an unsigned 64bit integer; its order is
+ * identical to the ascending order of the original type, so radix-select
+ * works on it. -0.0 and NaN are normalized as PostgreSQL considers.
+ */
+PUBLIC_FUNCTION(uint64_t)
+__gpusort_normalized_value(char kind, int attlen, const char *addr)
+{
+	switch (kind)
+	{
+		case GPUSORT_KIND__INT:
+			{
+				int64_t		ival;
+
+				switch (attlen)
+				{
+					case 1:  ival = *((const int8_t  *)addr); break;
+					case 2:  ival = *((const int16_t *)addr); break;
+					case 4:  ival = *((const int32_t *)addr); break;
+					default: ival = *((const int64_t *)addr); break;
+				}
+				return ((uint64_t)ival ^ 0x8000000000000000UL);
+			}
+		case GPUSORT_KIND__FLOAT:
+			{
+				float8_t	fval;
+				uint64_t	bits;
+
+				if (attlen == sizeof(float4_t))
+					fval = *((const float4_t *)addr);
+				else
+					fval = *((const float8_t *)addr);
+				if (isnan(fval))
+					return ~0UL;	/* NaN is larger than any other values */
+				if (fval == 0.0)
+					fval = 0.0;		/* -0.0 is equal to 0.0 */
+				bits = __double_as_longlong(fval);
+				if ((bits & 0x8000000000000000UL) != 0)
+					return ~bits;
+				return (bits | 0x8000000000000000UL);
+			}
+		default:
+			break;
+	}
+	return 0;	/* should not happen */
+}
+
+/*
+ * __gpusort_normalized_key
+ *
+ * It returns the sort key of the tuple as an unsigned 64bit integer; its
+ * order is identical to the ORDER BY clause, so radix-select works on it.
+ * Different values may be mapped to the same key (e.g, NULL and the min
+ * value), however, it never reverses the order of two values.
+ */
+STATIC_FUNCTION(uint64_t)
+__gpusort_normalized_key(const kern_session_info *session,
+						 const kern_data_store *kds,
+						 const kern_tupitem *tupitem)
+{
+	int			resno = session->gpusort_resno;
+	const char *addr;
+	uint64_t	key;
+
+	addr = __gpusort_fetch_attr(kds, tupitem, resno);
+	if (!addr)
+		return (session->gpusort_nulls_first ? 0UL : ~0UL);
+	key = __gpusort_normalized_value(session->gpusort_kind,
+									 kds->colmeta[resno-1].attlen,
+									 addr);
+	return (session->gpusort_desc ? ~key : key);
+}
+
+/*
+ * kern_gpusort_topk
+ *
+ * It picks up the first 'gpusort_limit' rows (and ties) from kds_src
+ * according to the sort key, and writes out them to kds_dst.
+ * kds_src may be the kds_final of GpuPreAgg (KDS_FORMAT_HASH); its row-index
+ * also points the kern_tupitem of the hash-items.
+ * The k-th key is determined by MSB radix-select (8bits x 8 passes).
+ * It shall be launched with a single thread-block per kds_src, because
+ * sort order within the kds_dst is not significant; the Sort node
+ * on the host side sorts the survived rows again.
+ */
+KERNEL_FUNCTION(void)
+kern_gpusort_topk(kern_session_info *session,
+				  kern_data_store *kds_src,
+				  kern_data_store *kds_dst)
+{
+	__shared__ uint32_t	smx_hist[256];
+	__shared__ uint64_t	smx_prefix;
+	__shared__ uint64_t	smx_mask;
+	__shared__ uint32_t	smx_remain;
+	__shared__ uint32_t	base_rowid;
+	__shared__ uint32_t	base_usage;
+	uint32_t	nitems = kds_src->nitems;
+	uint32_t	index;
+
+	assert((kds_src->format == KDS_FORMAT_ROW ||
+			kds_src->format == KDS_FORMAT_HASH) &&
+		   kds_dst->format == KDS_FORMAT_ROW &&
+		   get_num_groups() == 1);
+	if (get_local_id() == 0)
+	{
+		smx_prefix = 0;
+		smx_mask   = 0;
+		smx_remain = session->gpusort_limit;
+	}
+	__syncthreads();
+
+	/* radix-select to find out the k-th key */
+	for (int shift = 56; shift >= 0; shift -= 8)
+	{
+		for (index = get_local_id(); index < 256; index += get_local_size())
+			smx_hist[index] = 0;
+		__syncthreads();
+
+		for (index = get_local_id(); index < nitems; index += get_local_size())
+		{
+			kern_tupitem   *tupitem = KDS_GET_TUPITEM(kds_src, index);
+			uint64_t		key;
+
+			if (!tupitem)
+				continue;
+			key = __gpusort_normalized_key(session, kds_src, tupitem);
+			if ((key & smx_mask) == smx_prefix)
+				atomicAdd(&smx_hist[(key >> shift) & 0xff], 1U);
+		}
+		__syncthreads();
+
+		if (get_local_id() == 0)
+		{
+			uint32_t	count = 0;
+			uint32_t	digit;
+
+			for (digit=0; digit < 255; digit++)
+			{
+				if (count + smx_hist[digit] >= smx_remain)
+					break;
+				count += smx_hist[digit];
+			}
+			smx_remain -= count;
+			smx_prefix |= ((uint64_t)digit << shift);
+			smx_mask   |= (0xffUL << shift);
+		}
+		__syncthreads();
+	}
+
+	/* write out the rows less than or equal to the k-th key */
+	if (get_local_id() == 0)
+	{
+		kds_dst->nitems = 0;
+		kds_dst->usage  = 0;
+	}
+	__syncthreads();
+	for (uint32_t base = 0; base < nitems; base += get_local_size())
+	{
+		kern_tupitem   *tupitem = NULL;
+		uint32_t		tupsz = 0;
+		uint32_t		row_id;
+		uint32_t		offset;
+		uint32_t		count;
+		uint32_t		total_sz;
+
+		index = base + get_local_id();
+		if (index < nitems)
+		{
+			tupitem = KDS_GET_TUPITEM(kds_src, index);
+			if (tupitem &&
+				__gpusort_normalized_key(session, kds_src, tupitem) <= smx_prefix)
+				tupsz = MAXALIGN(offsetof(kern_tupitem, htup) + tupitem->t_len);
+		}
+		row_id = pgstrom_stair_sum_binary(tupsz > 0, &count);
+		offset = pgstrom_stair_sum_uint32(tupsz, &total_sz);
+		if (get_local_id() == 0)
+		{
+			base_rowid = kds_dst->nitems;
+			base_usage = __kds_unpack(kds_dst->usage);
+			kds_dst->nitems += count;
+			kds_dst->usage   = __kds_packed(base_usage + total_sz);
+		}
+		__syncthreads();
+		if (tupsz > 0)
+		{
+			kern_tupitem   *titem;
+
+			row_id += base_rowid;
+			offset += base_usage;
+			titem = (kern_tupitem *)((char *)kds_dst + kds_dst->length - offset);
+			memcpy(titem, tupitem, offsetof(kern_tupitem, htup) + tupitem->t_len);
+			titem->rowid = row_id;
+			KDS_GET_ROWINDEX(kds_dst)[row_id] = __kds_packed(offset);
+		}
+		__syncthreads();
+	}
+}
@@ -0,0 +1,560 @@
+/*
+ * cuda_gpuwindow.cu
+ *
+ * Device implementation of GPU window functions
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include "cuda_common.h"
+
+/*
+ * kwin_scan_item - an item of the segmented scan
+ */
+typedef struct
+{
+	uint64_t	value;		/* int64 or fp64 bits */
+	int64_t		count;		/* number of not-null inputs */
+	bool		head;		/* true, if beginning of the segment */
+} kwin_scan_item;
+
+/*
+ * __gpuwindow_compare
+ *
+ * It compares the keys[key_start...key_end-1] of the two rows; the dummy
+ * rows (>= nrows) are larger than any other rows.
+ */
+STATIC_FUNCTION(int)
+__gpuwindow_compare(const kern_window_desc *kwin_desc,
+					const kern_window_buffer *kwin,
+					uint32_t row_a, uint32_t row_b,
+					int key_start, int key_end)
+{
+	uint32_t	nkeys = kwin_desc->nkeys;
+
+	if (row_a >= kwin->nrows || row_b >= kwin->nrows)
+	{
+		if (row_a < kwin->nrows)
+			return -1;
+		if (row_b < kwin->nrows)
+			return 1;
+		return 0;
+	}
+	for (int k=key_start; k < key_end; k++)
+	{
+		const kern_window_key *wkey = &kwin_desc->keys[k];
+		bool		a_isnull = ((kwin->key_nulls[row_a] & (1U<<k)) != 0);
+		bool		b_isnull = ((kwin->key_nulls[row_b] & (1U<<k)) != 0);
+		uint64_t	a_key;
+		uint64_t	b_key;
+
+		if (a_isnull && b_isnull)
+			continue;
+		if (a_isnull)
+			return (wkey->nulls_first ? -1 : 1);
+		if (b_isnull)
+			return (wkey->nulls_first ? 1 : -1);
+		a_key = kwin->keys[(size_t)row_a * nkeys + k];
+		b_key = kwin->keys[(size_t)row_b * nkeys + k];
+		if (a_key < b_key)
+			return -1;
+		if (a_key > b_key)
+			return 1;
+	}
+	return 0;
+}
+
+/*
+ * kern_gpuwindow_init
+ */
+KERNEL_FUNCTION(void)
+kern_gpuwindow_init(kern_session_info *session,
+					kern_window_buffer *kwin)
+{
+	for (uint32_t i = get_global_id(); i < kwin->nrooms; i += get_global_size())
+		kwin->order[i] = i;
+}
+
+/*
+ * kern_gpuwindow_setup
+ *
+ * It registers the rows of the kds_src; 'base' is the first row-index
+ * of the kds_src in the window buffer.
+ */
+KERNEL_FUNCTION(void)
+kern_gpuwindow_setup(kern_session_info *session,
+					 kern_window_buffer *kwin,
+					 kern_data_store *kds_src,
+					 uint32_t base)
+{
+	const kern_window_desc *kwin_desc = SESSION_WINDOW_DESC(session);
+	uint32_t	nkeys = kwin_desc->nkeys;
+
+	assert(kds_src->format == KDS_FORMAT_ROW);
+	for (uint32_t i = get_global_id(); i < kds_src->nitems; i += get_global_size())
+	{
+		kern_tupitem   *tupitem = KDS_GET_TUPITEM(kds_src, i);
+		uint32_t		row = base + i;
+		uint32_t		key_nulls = 0;
+
+		kwin->tuples[row] = tupitem;
+		for (int k=0; k < nkeys; k++)
+		{
+			const kern_window_key *wkey = &kwin_desc->keys[k];
+			const char *addr = NULL;
+			uint64_t	key = 0;
+
+			if (tupitem)
+				addr = __gpusort_fetch_attr(kds_src, tupitem, wkey->resno);
+			if (!addr)
+				key_nulls |= (1U<<k);
+			else
+			{
+				key = __gpusort_normalized_value(wkey->kind,
+												 kds_src->colmeta[wkey->resno-1].attlen,
+												 addr);
+				if (wkey->desc)
+					key = ~key;
+			}
+			kwin->keys[(size_t)row * nkeys + k] = key;
+		}
+		kwin->key_nulls[row] = key_nulls;
+	}
+}
+
+/*
+ * kern_gpuwindow_bitonic
+ *
+ * A step of the bitonic sorting on the order[]; host code launches this
+ * kernel for each (k,j) pair.
+ */
+KERNEL_FUNCTION(void)
+kern_gpuwindow_bitonic(kern_session_info *session,
+					   kern_window_buffer *kwin,
+					   uint32_t k, uint32_t j)
+{
+	const kern_window_desc *kwin_desc = SESSION_WINDOW_DESC(session);
+
+	for (uint32_t i = get_global_id(); i < kwin->nrooms; i += get_global_size())
+	{
+		uint32_t	ixj = (i ^ j);
+		uint32_t	row_a;
+		uint32_t	row_b;
+		int			comp;
+
+		if (ixj <= i)
+			continue;
+		row_a = kwin->order[i];
+		row_b = kwin->order[ixj];
+		comp = __gpuwindow_compare(kwin_desc, kwin, row_a, row_b,
+								   0, kwin_desc->nkeys);
+		if ((i & k) == 0 ? comp > 0 : comp < 0)
+		{
+			kwin->order[i]   = row_b;
+			kwin->order[ixj] = row_a;
+		}
+	}
+}
+
+/*
+ * __gpuwindow_load_value
+ */
+STATIC_FUNCTION(uint64_t)
+__gpuwindow_load_value(char kind, int attlen, const char *addr)
+{
+	if (kind == GPUSORT_KIND__FLOAT)
+	{
+		float8_t	fval;
+
+		if (attlen == sizeof(float4_t))
+			fval = *((const float4_t *)addr);
+		else
+			fval = *((const float8_t *)addr);
+		return __double_as_longlong(fval);
+	}
+	switch (attlen)
+	{
+		case 1:  return (int64_t)*((const int8_t  *)addr);
+		case 2:  return (int64_t)*((const int16_t *)addr);
+		case 4:  return (int64_t)*((const int32_t *)addr);
+		default: return (int64_t)*((const int64_t *)addr);
+	}
+}
+
+/*
+ * __gpuwindow_fp_less
+ *
+ * NaN is larger than any other values, as PostgreSQL considers
+ */
+INLINE_FUNCTION(bool)
+__gpuwindow_fp_less(uint64_t a, uint64_t b)
+{
+	float8_t	fa = __longlong_as_double(a);
+	float8_t	fb = __longlong_as_double(b);
+
+	if (isnan(fa))
+		return false;
+	if (isnan(fb))
+		return true;
+	return (fa < fb);
+}
+
+/*
+ * __gpuwindow_combine
+ *
+ * It combines the item 'a' and the later item 'b'. If 'action' is not
+ * an aggregate, it propagates the first value of the segment.
+ */
+STATIC_FUNCTION(kwin_scan_item)
+__gpuwindow_combine(uint32_t action, kwin_scan_item a, kwin_scan_item b)
+{
+	kwin_scan_item	r;
+
+	if (b.head)
+		return b;
+	r.head  = a.head;
+	r.count = a.count + b.count;
+	if (a.count == 0)
+		r.value = b.value;
+	else if (b.count == 0)
+		r.value = a.value;
+	else
+	{
+		switch (action)
+		{
+			case KWIN_ACTION__PSUM_INT:
+				r.value = (uint64_t)((int64_t)a.value + (int64_t)b.value);
+				break;
+			case KWIN_ACTION__PSUM_FP:
+				r.value = __double_as_longlong(__longlong_as_double(a.value) +
+											   __longlong_as_double(b.value));
+				break;
+			case KWIN_ACTION__PMIN_INT:
+				r.value = ((int64_t)b.value < (int64_t)a.value ? b.value : a.value);
+				break;
+			case KWIN_ACTION__PMAX_INT:
+				r.value = ((int64_t)a.value < (int64_t)b.value ? b.value : a.value);
+				break;
+			case KWIN_ACTION__PMIN_FP:
+				r.value = (__gpuwindow_fp_less(b.value, a.value) ? b.value : a.value);
+				break;
+			case KWIN_ACTION__PMAX_FP:
+				r.value = (__gpuwindow_fp_less(a.value, b.value) ? b.value : a.value);
+				break;
+			default:
+				r.value = a.value;
+				break;
+		}
+	}
+	return r;
+}
+
+/*
+ * __gpuwindow_block_scan
+ *
+ * Inclusive segmented scan within the thread-block, then the carry from
+ * the previous loop is merged. All the threads in the block must call it.
+ */
+STATIC_FUNCTION(kwin_scan_item)
+__gpuwindow_block_scan(uint32_t action, kwin_scan_item item,
+					   kwin_scan_item *p_carry)
+{
+	__shared__ kwin_scan_item smx_items[MAXTHREADS_PER_BLOCK];
+	uint32_t	id = get_local_id();
+
+	smx_items[id] = item;
+	__syncthreads();
+	for (uint32_t dist=1; dist < get_local_size(); dist <<= 1)
+	{
+		kwin_scan_item	temp;
+
+		if (id >= dist)
+			temp = __gpuwindow_combine(action, smx_items[id - dist], smx_items[id]);
+		__syncthreads();
+		if (id >= dist)
+			smx_items[id] = temp;
+		__syncthreads();
+	}
+	item = __gpuwindow_combine(action, *p_carry, smx_items[id]);
+	__syncthreads();
+	if (id == get_local_size() - 1)
+		*p_carry = item;
+	__syncthreads();
+	return item;
+}
+
+/*
+ * kern_gpuwindow_scan
+ *
+ * It calculates the window functions along with the sorted rows. It shall
+ * be launched with a single thread-block, because the carry of the running
+ * aggregates goes across the entire rows.
+ */
+KERNEL_FUNCTION(void)
+kern_gpuwindow_scan(kern_session_info *session,
+					kern_window_buffer *kwin)
+{
+	const kern_window_desc *kwin_desc = SESSION_WINDOW_DESC(session);
+	__shared__ kwin_scan_item carry_part;
+	__shared__ kwin_scan_item carry_peer;
+	__shared__ kwin_scan_item carry_funcs[KWIN_MAX_FUNCS];
+	uint32_t	nrows = kwin->nrows;
+	uint32_t	nkeys = kwin_desc->nkeys;
+	uint32_t	npart_keys = kwin_desc->npart_keys;
+
+	assert(get_num_groups() == 1 &&
+		   kwin_desc->nfuncs <= KWIN_MAX_FUNCS);
+	if (get_local_id() == 0)
+	{
+		memset(&carry_part, 0, sizeof(kwin_scan_item));
+		memset(&carry_peer, 0, sizeof(kwin_scan_item));
+		memset(carry_funcs, 0, sizeof(carry_funcs));
+	}
+	__syncthreads();
+
+	for (uint32_t base=0; base < nrows; base += get_local_size())
+	{
+		uint32_t	pos = base + get_local_id();
+		bool		is_valid = (pos < nrows);
+		bool		part_start = false;
+		bool		peer_start = false;
+		bool		peer_end = false;
+		uint32_t	row = UINT_MAX;
+		uint32_t	part_head;
+		uint32_t	peer_head;
+		kern_tupitem *tupitem = NULL;
+		kwin_scan_item item;
+
+		if (is_valid)
+		{
+			row = kwin->order[pos];
+			tupitem = kwin->tuples[row];
+			if (pos == 0)
+				part_start = peer_start = true;
+			else
+			{
+				uint32_t	prev = kwin->order[pos-1];
+
+				part_start = (__gpuwindow_compare(kwin_desc, kwin, prev, row,
+												  0, npart_keys) != 0);
+				peer_start = (part_start ||
+							  __gpuwindow_compare(kwin_desc, kwin, prev, row,
+												  npart_keys, nkeys) != 0);
+			}
+			if (pos == nrows - 1)
+				peer_end = true;
+			else
+			{
+				uint32_t	next = kwin->order[pos+1];
+
+				peer_end = (__gpuwindow_compare(kwin_desc, kwin, row, next,
+												0, nkeys) != 0);
+			}
+		}
+		/* first position of the partition */
+		item.value = pos;
+		item.count = (is_valid ? 1 : 0);
+		item.head  = part_start;
+		item = __gpuwindow_block_scan(0, item, &carry_part);
+		part_head = item.value;
+		/* first position of the peer rows */
+		item.value = pos;
+		item.count = (is_valid ? 1 : 0);
+		item.head  = peer_start;
+		item = __gpuwindow_block_scan(0, item, &carry_peer);
+		peer_head = item.value;
+		if (is_valid)
+			kwin->peer_head[pos] = peer_head;
+
+		for (int i=0; i < kwin_desc->nfuncs; i++)
+		{
+			const kern_window_func *wfunc = &kwin_desc->funcs[i];
+			size_t		dindex = (size_t)i * nrows + pos;
+
+			switch (wfunc->action)
+			{
+				case KWIN_ACTION__ROW_NUMBER:
+					if (is_valid)
+					{
+						kwin->values[dindex] = pos - part_head + 1;
+						kwin->isnull[dindex] = false;
+					}
+					break;
+				case KWIN_ACTION__RANK:
+					if (is_valid)
+					{
+						kwin->values[dindex] = peer_head - part_head + 1;
+						kwin->isnull[dindex] = false;
+					}
+					break;
+				case KWIN_ACTION__DENSE_RANK:
+					item.value = (peer_start ? 1 : 0);
+					item.count = (is_valid ? 1 : 0);
+					item.head  = part_start;
+					item = __gpuwindow_block_scan(KWIN_ACTION__PSUM_INT, item,
+												  &carry_funcs[i]);
+					if (is_valid)
+					{
+						kwin->values[dindex] = item.value;
+						kwin->isnull[dindex] = false;
+					}
+					break;
+				default:
+					item.value = 0;
+					item.count = 0;
+					item.head  = part_start;
+					if (is_valid && tupitem)
+					{
+						if (wfunc->action == KWIN_ACTION__NROWS_ANY)
+							item.count = 1;
+						else
+						{
+							const char *addr
+								= __gpusort_fetch_attr(kwin->kds_head, tupitem,
+													   wfunc->arg_resno);
+							if (addr)
+							{
+								int		attlen = kwin->kds_head->colmeta[wfunc->arg_resno-1].attlen;
+
+								item.value = __gpuwindow_load_value(wfunc->arg_kind,
+																	attlen, addr);
+								item.count = 1;
+							}
+						}
+					}
+					item = __gpuwindow_block_scan(wfunc->action, item,
+												  &carry_funcs[i]);
+					/*
+					 * RANGE frame includes all the peer rows, so the results
+					 * at the last row of the peer group is saved for the
+					 * first position of the peer rows.
+					 */
+					if (is_valid && (kwin_desc->rows_frame || peer_end))
+					{
+						if (!kwin_desc->rows_frame)
+							dindex = (size_t)i * nrows + peer_head;
+						if (wfunc->action == KWIN_ACTION__NROWS_ANY ||
+							wfunc->action == KWIN_ACTION__NROWS_COND)
+						{
+							kwin->values[dindex] = item.count;
+							kwin->isnull[dindex] = false;
+						}
+						else
+						{
+							kwin->values[dindex] = item.value;
+							kwin->isnull[dindex] = (item.count == 0);
+						}
+					}
+					break;
+			}
+		}
+	}
+}
+
+/*
+ * __gpuwindow_store_value
+ */
+STATIC_FUNCTION(void)
+__gpuwindow_store_value(uint32_t action, int attlen, char *addr, uint64_t value)
+{
+	if (action == KWIN_ACTION__PSUM_FP ||
+		action == KWIN_ACTION__PMIN_FP ||
+		action == KWIN_ACTION__PMAX_FP)
+	{
+		float8_t	fval = __longlong_as_double(value);
+
+		if (attlen == sizeof(float4_t))
+			*((float4_t *)addr) = (float4_t)fval;
+		else
+			*((float8_t *)addr) = fval;
+		return;
+	}
+	switch (attlen)
+	{
+		case 1:  *((int8_t  *)addr) = (int8_t)value;  break;
+		case 2:  *((int16_t *)addr) = (int16_t)value; break;
+		case 4:  *((int32_t *)addr) = (int32_t)value; break;
+		default: *((int64_t *)addr) = (int64_t)value; break;
+	}
+}
+
+/*
+ * kern_gpuwindow_writeback
+ *
+ * It writes back the results of window functions to the placeholder
+ * columns; they are fixed-length columns at the tail of the tuple,
+ * next to the NULL column, so they never overrun the tuple even if some
+ * of them become NULL.
+ */
+KERNEL_FUNCTION(void)
+kern_gpuwindow_writeback(kern_session_info *session,
+						 kern_window_buffer *kwin)
+{
+	const kern_window_desc *kwin_desc = SESSION_WINDOW_DESC(session);
+	const kern_data_store *kds_head = kwin->kds_head;
+	uint32_t	nrows = kwin->nrows;
+
+	for (uint32_t pos = get_global_id(); pos < nrows; pos += get_global_size())
+	{
+		kern_tupitem *tupitem = kwin->tuples[kwin->order[pos]];
+		HeapTupleHeaderData *htup;
+		uint32_t	offset;
+
+		if (!tupitem)
+			continue;
+		htup = &tupitem->htup;
+		if ((htup->t_infomask & HEAP_HASNULL) == 0 ||
+			(htup->t_infomask2 & HEAP_NATTS_MASK) <
+			kwin_desc->funcs[kwin_desc->nfuncs-1].resno)
+			continue;	/* should not happen */
+		/* offset of the first placeholder */
+		offset = htup->t_hoff;
+		for (int j=0; j < kwin_desc->funcs[0].resno - 1; j++)
+		{
+			const kern_colmeta *cmeta = &kds_head->colmeta[j];
+			const char *addr;
+
+			if (att_isnull(j, htup->t_bits))
+				continue;
+			if (cmeta->attlen > 0)
+				offset = TYPEALIGN(cmeta->attalign, offset);
+			else if (!VARATT_NOT_PAD_BYTE((char *)htup + offset))
+				offset = TYPEALIGN(cmeta->attalign, offset);
+			addr = ((const char *)htup + offset);
+			if (cmeta->attlen > 0)
+				offset += cmeta->attlen;
+			else
+				offset += VARSIZE_ANY(addr);
+		}
+
+		for (int i=0; i < kwin_desc->nfuncs; i++)
+		{
+			const kern_window_func *wfunc = &kwin_desc->funcs[i];
+			const kern_colmeta *cmeta = &kds_head->colmeta[wfunc->resno-1];
+			int			j = wfunc->resno - 1;
+			uint32_t	vindex = pos;
+			size_t		dindex;
+
+			if (!kwin_desc->rows_frame &&
+				wfunc->action != KWIN_ACTION__ROW_NUMBER &&
+				wfunc->action != KWIN_ACTION__RANK &&
+				wfunc->action != KWIN_ACTION__DENSE_RANK)
+				vindex = kwin->peer_head[pos];
+			dindex = (size_t)i * nrows + vindex;
+			if (kwin->isnull[dindex])
+				htup->t_bits[j>>3] &= ~(1<<(j & 7));
+			else
+			{
+				offset = TYPEALIGN(cmeta->attalign, offset);
+				__gpuwindow_store_value(wfunc->action, cmeta->attlen,
+										(char *)htup + offset,
+										kwin->values[dindex]);
+				htup->t_bits[j>>3] |= (1<<(j & 7));
+				offset += cmeta->attlen;
+			}
+		}
+	}
+}
@@ -9,9 +9,31 @@
  * This program is free software; you can redistribute it and/or modify
  * it under the terms of the PostgreSQL License.
  */
+#include <dlfcn.h>
 #include "dpuserv.h"
+#ifdef HAVE_LIBLZ4
+#include <lz4frame.h>
+#endif
 
 struct groupby_final_buffer;
+struct dpuInnerCacheEntry;
+
+/*
+ * dpuRunQueue
+ *
+ * Per-core run queue of XpuCommands. Every worker thread is bound to a
+ * particular run queue and CPU core, and steals the commands from the other
+ * run queues if its own one is empty. It reduces lock handoffs and context
+ * switches on the small number of DPU cores.
+ */
+typedef struct
+{
+	pthread_mutex_t		lock;
+	pthread_cond_t		cond;
+	dlist_head			cmd_list;
+	volatile uint32_t	nitems;		/* number of queued commands */
+	volatile uint32_t	nidles;		/* number of sleeping workers */
+} dpuRunQueue;
 
 #define PEER_ADDR_LEN	80
 typedef struct
@@ -20,12 +42,17 @@ typedef struct
 	kern_session_info  *session;/* per-session information */
 	kern_multirels	   *kmrels;		/* join inner buffer */
 	size_t				kmrels_sz;	/* join inner buffer mmap-sz */
+	struct dpuInnerCacheEntry *inner_cache; /* cached inner buffer, if any */
 	struct groupby_final_buffer *gf_buf; /* group-by final buffer */
 	volatile bool		in_termination; /* true, if error status */
 	volatile int32_t	refcnt;	/* odd-number as long as socket is active */
 	pthread_mutex_t		mutex;	/* mutex to write the socket */
 	int					sockfd;	/* connection to PG-backend */
-	pthread_t			worker;	/* receiver thread */
+	uint32_t			runq_index; /* preferred dpuRunQueue */
+	/* sequential read-ahead (hint only; updated without locks) */
+	dev_t				ra_st_dev;
+	ino_t				ra_st_ino;
+	off_t				ra_next_offset;
 	char				peer_addr[PEER_ADDR_LEN];
 } dpuClient;
 
@@ -37,11 +64,16 @@ static char			   *dpuserv_identifier = NULL;
 static const char	   *dpuserv_logfile = NULL;
 static bool				verbose = false;
 static bool				use_direct_io = false;
+static size_t			dpuserv_cache_size = 0;		/* --cache-size */
+static size_t			dpuserv_readahead_sz = (8UL << 20);	/* --readahead */
+static size_t			dpuserv_inner_cache_size = (1UL << 30);	/* --inner-cache-size */
+static const char	  **dpuserv_extension_libs = NULL;	/* --extension */
+static int				dpuserv_num_extension_libs = 0;
 static pthread_mutex_t	dpu_client_mutex;
 static dlist_head		dpu_client_list;
-static pthread_mutex_t	dpu_command_mutex;
-static pthread_cond_t	dpu_command_cond;
-static dlist_head		dpu_command_list;
+static dpuRunQueue	   *dpu_runq_array = NULL;
+static uint32_t			dpu_runq_nums = 0;
+static uint32_t			dpu_runq_next = 0;	/* round-robin for new clients */
 static volatile bool	got_sigterm = false;
 static xpu_type_hash_table *dpuserv_type_htable = NULL;
 static xpu_func_hash_table *dpuserv_func_htable = NULL;
@@ -109,9 +141,11 @@ __dpuClientWriteBack(dpuClient *dclient, struct iovec *iov, int iovcnt)
 				/*
 				 * Peer socket is closed? Anyway, we cannot continue to
 				 * send back the message any more. So, clean up this client.
+				 * The socket is closed on the release of dpuClient, because
+				 * event loop still monitors the socket.
 				 */
-				close(dclient->sockfd);
-				dclient->sockfd = -1;
+				shutdown(dclient->sockfd, SHUT_RDWR);
+				dclient->in_termination = true;
 				break;
 			}
 		}
@@ -224,9 +258,9 @@ __dpuClientElog(dpuClient *dclient,
 	iov.iov_len  = resp.length;
 	__dpuClientWriteBack(dclient, &iov, 1);
 
-	/* go to termination of this client */
+	/* go to termination of this client; event loop will release it */
 	dclient->in_termination = true;
-	pthread_kill(dclient->worker, SIGUSR1);
+	shutdown(dclient->sockfd, SHUT_RD);
 }
 
 #define dpuClientElog(dclient,fmt,...)			\
@@ -235,7 +269,20 @@ __dpuClientElog(dpuClient *dclient,
 					(fmt), ##__VA_ARGS__)
 /*
  * Get/Put Group-By Final Buffer
+ *
+ * GROUP BY final buffer is partitioned by the hash value of the grouping
+ * keys. Each partition has its own kds_final and rwlock on the individual
+ * cache line, so workers don't share the lock counter on every row, and
+ * expansion of a partition does not block the insertion to the others.
  */
+#define GROUPBY_FINAL_BUFFER_NPARTS		16
+
+typedef struct
+{
+	pthread_rwlock_t kds_final_rwlock;
+	kern_data_store *kds_final;
+} __attribute__((aligned(64))) groupby_final_part;
+
 struct groupby_final_buffer
 {
 	dlist_node	chain;
@@ -243,11 +290,14 @@ struct groupby_final_buffer
 	uint32_t	pgsql_port_number;
 	uint32_t	pgsql_plan_node_id;
 	uint32_t	pgsql_client_hash;
-	pthread_rwlock_t kds_final_rwlock;
-	kern_data_store *kds_final;
+	uint32_t	nparts;		/* 1, if no-groups */
+	groupby_final_part parts[1];
 };
 typedef struct groupby_final_buffer		groupby_final_buffer;
 
+#define GROUPBY_FINAL_PART(gf_buf,hash)			\
+	(&(gf_buf)->parts[((hash) >> 24) % (gf_buf)->nparts])
+
 static pthread_mutex_t	groupby_final_buffer_lock;
 #define GROUPBY_FINAL_BUFFER_HASHSZ		200
 static dlist_head		groupby_final_buffer_hash[GROUPBY_FINAL_BUFFER_HASHSZ];
@@ -264,6 +314,8 @@ dpuServGetGroupByFinalBuffer(dpuClient *dclient, kern_session_info *session)
 		uint32_t	pgsql_plan_node_id;
 	} hkey;
 	groupby_final_buffer *gf_buf;
+	uint32_t		nparts = 1;
+	size_t			sz;
 
 	assert(session->groupby_kds_final != 0);
 	hkey.pgsql_port_number  = session->pgsql_port_number;
@@ -288,27 +340,49 @@ dpuServGetGroupByFinalBuffer(dpuClient *dclient, kern_session_info *session)
 	}
 	/* not found, so create a new one */
 	kds_final = (kern_data_store *)((char *)session + session->groupby_kds_final);
-	gf_buf = calloc(sizeof(groupby_final_buffer), 1);
-	if (!gf_buf)
+	if (kds_final->format == KDS_FORMAT_HASH)
+		nparts = GROUPBY_FINAL_BUFFER_NPARTS;
+	sz = offsetof(groupby_final_buffer, parts[nparts]);
+	if (posix_memalign((void **)&gf_buf, 64, sz) != 0)
 	{
 		pthreadMutexUnlock(&groupby_final_buffer_lock);
 		fprintf(stderr, "out of memory 1\n");
 		return false;
 	}
-	gf_buf->kds_final = malloc(kds_final->length);
-	if (!gf_buf->kds_final)
+	memset(gf_buf, 0, sz);
+	gf_buf->nparts = nparts;
+	for (uint32_t k=0; k < nparts; k++)
 	{
-		pthreadMutexUnlock(&groupby_final_buffer_lock);
-		free(gf_buf);
-		fprintf(stderr, "out of memory 2\n");
-        return false;
+		groupby_final_part *part = &gf_buf->parts[k];
+		kern_data_store	*kds_part;
+		size_t		length = kds_final->length;
+
+		if (nparts > 1)
+			length = Max(PAGE_ALIGN(length / nparts), (64UL << 20));
+		kds_part = malloc(length);
+		if (!kds_part)
+		{
+			while (k-- > 0)
+				free(gf_buf->parts[k].kds_final);
+			pthreadMutexUnlock(&groupby_final_buffer_lock);
+			free(gf_buf);
+			fprintf(stderr, "out of memory 2\n");
+			return false;
+		}
+		memcpy(kds_part, kds_final, KDS_HEAD_LENGTH(kds_final));
+		kds_part->length = length;
+		if (nparts > 1)
+			kds_part->hash_nslots = Max(kds_final->hash_nslots / nparts, 1000);
+		if (kds_part->hash_nslots > 0)
+			memset(KDS_GET_HASHSLOT_BASE(kds_part), 0,
+				   sizeof(uint32_t) * kds_part->hash_nslots);
+		pthreadRWLockInit(&part->kds_final_rwlock);
+		part->kds_final = kds_part;
 	}
 	gf_buf->refcnt = 1;
 	gf_buf->pgsql_port_number  = session->pgsql_port_number;
 	gf_buf->pgsql_plan_node_id = session->pgsql_plan_node_id;
 	gf_buf->pgsql_client_hash  = hash;
-	pthreadRWLockInit(&gf_buf->kds_final_rwlock);
-	memcpy(gf_buf->kds_final, kds_final, KDS_HEAD_LENGTH(kds_final));
 
 	dlist_push_tail(slot, &gf_buf->chain);
 found:
@@ -325,12 +399,340 @@ dpuServPutGroupByFinalBuffer(groupby_final_buffer *gf_buf)
 	if (--gf_buf->refcnt == 0)
 	{
 		dlist_delete(&gf_buf->chain);
-		free(gf_buf->kds_final);
+		for (uint32_t k=0; k < gf_buf->nparts; k++)
+			free(gf_buf->parts[k].kds_final);
 		free(gf_buf);
 	}
 	pthreadMutexUnlock(&groupby_final_buffer_lock);
 }
 
+/*
+ * DPU inner buffer cache
+ *
+ * PG backend publishes the read-only inner buffer image on the base directory,
+ * named by its content digest, unless the same image already exists. DPU
+ * service loads the image on the first session, then keeps the buffer for
+ * the following sessions as long as the total size is less than
+ * --inner-cache-size. The image file is removed when the buffer is released,
+ * so PG backend publishes the image again only if it is not cached.
+ */
+#define DPU_INNER_IMAGE_UNITSZ		(4UL << 20)
+
+typedef struct dpuInnerCacheEntry
+{
+	dlist_node	chain;		/* link to dpu_inner_cache_lru */
+	uint64_t	digest;
+	int			refcnt;
+	bool		is_cached;	/* true, if linked to dpu_inner_cache_lru */
+	size_t		length;
+	kern_multirels *kmrels;
+} dpuInnerCacheEntry;
+
+static pthread_mutex_t	dpu_inner_cache_lock;
+static size_t			dpu_inner_cache_usage = 0;
+static dlist_head		dpu_inner_cache_lru;
+
+static void
+__dpuInnerCacheDrop(dpuInnerCacheEntry *entry)
+{
+	char		namebuf[100];
+
+	snprintf(namebuf, sizeof(namebuf),
+			 KERN_INNER_IMAGE_PREFIX "%016lx", entry->digest);
+	if (unlink(namebuf) != 0 && errno != ENOENT)
+		fprintf(stderr, "failed on unlink('%s'): %m\n", namebuf);
+	free(entry->kmrels);
+	free(entry);
+}
+
+/*
+ * __dpuInnerCacheLookup - caller must hold dpu_inner_cache_lock
+ */
+static dpuInnerCacheEntry *
+__dpuInnerCacheLookup(uint64_t digest)
+{
+	dlist_iter	iter;
+
+	dlist_foreach (iter, &dpu_inner_cache_lru)
+	{
+		dpuInnerCacheEntry *entry = dlist_container(dpuInnerCacheEntry,
+													chain, iter.cur);
+		if (entry->digest == digest)
+			return entry;
+	}
+	return NULL;
+}
+
+/*
+ * __dpuInnerCacheReclaim - caller must hold dpu_inner_cache_lock
+ */
+static void
+__dpuInnerCacheReclaim(size_t required)
+{
+	dlist_node *dnode;
+	dlist_node *prev;
+
+	for (dnode = dpu_inner_cache_lru.head.prev;
+		 dnode != &dpu_inner_cache_lru.head &&
+			 dpu_inner_cache_usage + required > dpuserv_inner_cache_size;
+		 dnode = prev)
+	{
+		dpuInnerCacheEntry *entry = dlist_container(dpuInnerCacheEntry,
+													chain, dnode);
+		prev = dnode->prev;
+		if (entry->refcnt > 0)
+			continue;
+		dlist_delete(&entry->chain);
+		dpu_inner_cache_usage -= entry->length;
+		__dpuInnerCacheDrop(entry);
+	}
+}
+
+static bool
+__dpuInnerCacheReadFully(int fdesc, void *buffer, size_t nbytes)
+{
+	ssize_t		rv;
+
+	while (nbytes > 0)
+	{
+		rv = read(fdesc, buffer, nbytes);
+		if (rv > 0)
+		{
+			buffer = (char *)buffer + rv;
+			nbytes -= rv;
+		}
+		else if (rv == 0 || errno != EINTR)
+			return false;
+	}
+	return true;
+}
+
+#ifdef HAVE_LIBLZ4
+static bool
+__dpuInnerCacheDecompressLZ4(int fdesc, const char *fname,
+							 char *dst, size_t dst_len)
+{
+	LZ4F_dctx  *dctx;
+	LZ4F_errorCode_t rc;
+	char	   *ibuf;
+	size_t		dst_pos = 0;
+	bool		done = false;
+
+	ibuf = malloc(DPU_INNER_IMAGE_UNITSZ);
+	if (!ibuf)
+		return false;
+	rc = LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION);
+	if (LZ4F_isError(rc))
+	{
+		fprintf(stderr, "failed on LZ4F_createDecompressionContext: %s\n",
+				LZ4F_getErrorName(rc));
+		free(ibuf);
+		return false;
+	}
+	while (!done)
+	{
+		ssize_t		nbytes = read(fdesc, ibuf, DPU_INNER_IMAGE_UNITSZ);
+		size_t		ipos = 0;
+
+		if (nbytes < 0 && errno == EINTR)
+			continue;
+		if (nbytes <= 0)
+			break;
+		while (ipos < nbytes && !done)
+		{
+			size_t	src_sz = nbytes - ipos;
+			size_t	dst_sz = dst_len - dst_pos;
+
+			rc = LZ4F_decompress(dctx,
+								 dst + dst_pos, &dst_sz,
+								 ibuf + ipos, &src_sz, NULL);
+			if (LZ4F_isError(rc))
+			{
+				fprintf(stderr, "failed on LZ4F_decompress('%s'): %s\n",
+						fname, LZ4F_getErrorName(rc));
+				goto bailout;
+			}
+			if (src_sz == 0 && dst_sz == 0)
+				goto bailout;	/* broken image */
+			dst_pos += dst_sz;
+			ipos += src_sz;
+			if (rc == 0)
+				done = true;	/* end of the frame */
+		}
+	}
+bailout:
+	LZ4F_freeDecompressionContext(dctx);
+	free(ibuf);
+	return (done && dst_pos == dst_len);
+}
+#endif
+
+/*
+ * __dpuInnerCacheLoadImage
+ */
+static kern_multirels *
+__dpuInnerCacheLoadImage(uint64_t digest, size_t *p_length)
+{
+	kern_inner_image head;
+	char		namebuf[100];
+	char	   *kmrels = NULL;
+	bool		status = false;
+	int			fdesc;
+
+	snprintf(namebuf, sizeof(namebuf),
+			 KERN_INNER_IMAGE_PREFIX "%016lx", digest);
+	fdesc = open(namebuf, O_RDONLY);
+	if (fdesc < 0)
+	{
+		fprintf(stderr, "failed on open('%s'): %m\n", namebuf);
+		return NULL;
+	}
+	if (!__dpuInnerCacheReadFully(fdesc, &head, sizeof(kern_inner_image)) ||
+		head.magic != KERN_INNER_IMAGE_MAGIC ||
+		head.digest != digest ||
+		head.raw_length < offsetof(kern_multirels, chunks))
+	{
+		fprintf(stderr, "inner image '%s' is corrupted\n", namebuf);
+		goto bailout;
+	}
+	if (posix_memalign((void **)&kmrels, PAGE_SIZE, head.raw_length) != 0)
+	{
+		kmrels = NULL;
+		goto bailout;
+	}
+	switch (head.codec)
+	{
+		case KERN_INNER_IMAGE_CODEC__NONE:
+			status = __dpuInnerCacheReadFully(fdesc, kmrels, head.raw_length);
+			break;
+#ifdef HAVE_LIBLZ4
+		case KERN_INNER_IMAGE_CODEC__LZ4:
+			status = __dpuInnerCacheDecompressLZ4(fdesc, namebuf, kmrels,
+												  head.raw_length);
+			break;
+#endif
+		default:
+			fprintf(stderr, "inner image '%s' has unsupported codec (%u)\n",
+					namebuf, head.codec);
+			break;
+	}
+bailout:
+	close(fdesc);
+	if (!status)
+	{
+		free(kmrels);
+		return NULL;
+	}
+	*p_length = head.raw_length;
+	return (kern_multirels *)kmrels;
+}
+
+/*
+ * dpuInnerCacheGet
+ *
+ * It returns the pinned inner buffer identified by the digest; it is loaded
+ * from the published image on cache miss. NULL means the image is not
+ * available.
+ */
+static dpuInnerCacheEntry *
+dpuInnerCacheGet(uint64_t digest)
+{
+	dpuInnerCacheEntry *entry;
+	dpuInnerCacheEntry *temp;
+	kern_multirels *kmrels;
+	size_t		length;
+
+	pthreadMutexLock(&dpu_inner_cache_lock);
+	entry = __dpuInnerCacheLookup(digest);
+	if (entry)
+	{
+		entry->refcnt++;
+		dlist_delete(&entry->chain);
+		dlist_push_head(&dpu_inner_cache_lru, &entry->chain);
+		pthreadMutexUnlock(&dpu_inner_cache_lock);
+		return entry;
+	}
+	pthreadMutexUnlock(&dpu_inner_cache_lock);
+
+	/* cache miss, so load the image */
+	kmrels = __dpuInnerCacheLoadImage(digest, &length);
+	if (!kmrels)
+		return NULL;
+	entry = calloc(1, sizeof(dpuInnerCacheEntry));
+	if (!entry)
+	{
+		free(kmrels);
+		return NULL;
+	}
+	entry->digest = digest;
+	entry->refcnt = 1;
+	entry->length = length;
+	entry->kmrels = kmrels;
+
+	/* insert the entry, unless someone already loaded the same one */
+	pthreadMutexLock(&dpu_inner_cache_lock);
+	temp = __dpuInnerCacheLookup(digest);
+	if (temp)
+	{
+		temp->refcnt++;
+		pthreadMutexUnlock(&dpu_inner_cache_lock);
+		free(entry->kmrels);
+		free(entry);
+		return temp;
+	}
+	__dpuInnerCacheReclaim(length);
+	if (dpu_inner_cache_usage + length <= dpuserv_inner_cache_size)
+	{
+		dlist_push_head(&dpu_inner_cache_lru, &entry->chain);
+		dpu_inner_cache_usage += length;
+		entry->is_cached = true;
+	}
+	pthreadMutexUnlock(&dpu_inner_cache_lock);
+	if (verbose)
+		fprintf(stderr, "[%016lx] inner image loaded (%zu bytes, %s)\n",
+				digest, length, entry->is_cached ? "cached" : "not cached");
+	return entry;
+}
+
+static void
+dpuInnerCachePut(dpuInnerCacheEntry *entry)
+{
+	pthreadMutexLock(&dpu_inner_cache_lock);
+	assert(entry->refcnt > 0);
+	if (--entry->refcnt == 0 && !entry->is_cached)
+	{
+		pthreadMutexUnlock(&dpu_inner_cache_lock);
+		/* no space to cache, so release the buffer and the image */
+		__dpuInnerCacheDrop(entry);
+		return;
+	}
+	pthreadMutexUnlock(&dpu_inner_cache_lock);
+}
+
+/*
+ * dpuInnerCacheCleanup
+ *
+ * It removes the inner images left by the previous run.
+ */
+static void
+dpuInnerCacheCleanup(void)
+{
+	DIR		   *dir;
+	struct dirent *dent;
+
+	dir = opendir(".");
+	if (!dir)
+		__Elog("failed on opendir('%s'): %m", dpuserv_base_directory);
+	while ((dent = readdir(dir)) != NULL)
+	{
+		if (strncmp(dent->d_name, KERN_INNER_IMAGE_PREFIX,
+					strlen(KERN_INNER_IMAGE_PREFIX)) == 0 &&
+			unlink(dent->d_name) != 0)
+			fprintf(stderr, "failed on unlink('%s'): %m\n", dent->d_name);
+	}
+	closedir(dir);
+}
+
 /*
  * mmap/munmap session buffer
  */
@@ -343,7 +745,19 @@ dpuServMapSessionBuffers(dpuClient *dclient, kern_session_info *session)
 	void	   *mmap_addr;
 	size_t		mmap_sz;
 
-	if (session->join_inner_handle != 0)
+	if (session->join_inner_handle != 0 &&
+		session->join_inner_fingerprint != 0)
+	{
+		dpuInnerCacheEntry *entry;
+
+		entry = dpuInnerCacheGet(session->join_inner_fingerprint);
+		if (!entry)
+			return false;
+		dclient->inner_cache = entry;
+		dclient->kmrels = entry->kmrels;
+		dclient->kmrels_sz = entry->length;
+	}
+	else if (session->join_inner_handle != 0)
 	{
 		snprintf(namebuf, sizeof(namebuf),
 				 ".pgstrom_shmbuf_%u_%d",
@@ -382,7 +796,9 @@ dpuServMapSessionBuffers(dpuClient *dclient, kern_session_info *session)
 static void
 dpuServUnmapSessionBuffers(dpuClient *dclient)
 {
-	if (dclient->kmrels)
+	if (dclient->inner_cache)
+		dpuInnerCachePut(dclient->inner_cache);
+	else if (dclient->kmrels)
 	{
 		if (munmap(dclient->kmrels,
 				   dclient->kmrels_sz) != 0)
@@ -466,7 +882,46 @@ __setupDevFuncLinkageTable(uint32_t xpu_func_hash_nslots)
 		entry->next = dpuserv_func_htable->slots[k];
 		dpuserv_func_htable->slots[k] = entry;
 	}
-	/* add custom functions here */
+	/* device functions supplied by extensions */
+	for (int j=0; j < dpuserv_num_extension_libs; j++)
+	{
+		const char *library = dpuserv_extension_libs[j];
+		const xpu_user_function_catalog_entry *catalog;
+		void	   *handle;
+
+		handle = dlopen(library, RTLD_NOW | RTLD_LOCAL);
+		if (!handle)
+			__Elog("failed on dlopen('%s'): %s", library, dlerror());
+		catalog = dlsym(handle, "xpu_user_functions_catalog");
+		if (!catalog)
+			__Elog("extension '%s' has no xpu_user_functions_catalog: %s",
+				   library, dlerror());
+		for (i=0; catalog[i].func_signature != NULL; i++)
+		{
+			FuncOpCode	func_opcode;
+
+			func_opcode = xpu_user_function_opcode(catalog[i].func_signature);
+			k = (uint32_t)func_opcode % xpu_func_hash_nslots;
+			for (entry = dpuserv_func_htable->slots[k];
+				 entry != NULL;
+				 entry = entry->next)
+			{
+				if (entry->cat.func_opcode == func_opcode)
+					__Elog("device function '%s' of '%s' conflicts to others",
+						   catalog[i].func_signature, library);
+			}
+			entry = malloc(sizeof(xpu_func_hash_entry));
+			if (!entry)
+				__Elog("out of memory");
+			entry->cat.func_opcode = func_opcode;
+			entry->cat.func_dptr = catalog[i].func_dptr;
+			entry->next = dpuserv_func_htable->slots[k];
+			dpuserv_func_htable->slots[k] = entry;
+			if (verbose)
+				fprintf(stderr, "device function '%s' was loaded from '%s'\n",
+						catalog[i].func_signature, library);
+		}
+	}
 }
 
 static const xpu_func_hash_entry *
@@ -669,6 +1124,280 @@ dpuservHandleOpenSession(dpuClient *dclient, XpuCommand *xcmd)
 	return true;
 }
 
+/*
+ * DPU buffer cache of Apache Arrow files
+ *
+ * Arrow files are immutable once written, so the record-batches loaded
+ * from the local filesystem are kept in the extents of 1MB as long as the
+ * total size is less than --cache-size. The file is identified by its
+ * device, inode and mtime, so re-written files never hit the old extents.
+ * Extents are released by LRU.
+ */
+#define DPU_CACHE_EXTENT_SZ		(1UL << 20)
+#define DPU_CACHE_HASHSZ		4000
+
+typedef struct
+{
+	dlist_node	hash_chain;
+	dlist_node	lru_chain;
+	dev_t		st_dev;
+	ino_t		st_ino;
+	struct timespec st_mtim;
+	uint64_t	extent_id;
+	int			refcnt;
+	size_t		length;		/* valid length; may be short at EOF */
+	char	   *data;		/* PAGE_SIZE aligned for O_DIRECT */
+} dpuCacheExtent;
+
+static pthread_mutex_t	dpu_cache_lock;
+static size_t			dpu_cache_usage = 0;
+static dlist_head		dpu_cache_lru;
+static dlist_head		dpu_cache_hash[DPU_CACHE_HASHSZ];
+
+static inline uint32_t
+__dpuCacheHash(const struct stat *st, uint64_t extent_id)
+{
+	struct {
+		dev_t		st_dev;
+		ino_t		st_ino;
+		uint64_t	extent_id;
+	} hkey;
+
+	memset(&hkey, 0, sizeof(hkey));
+	hkey.st_dev = st->st_dev;
+	hkey.st_ino = st->st_ino;
+	hkey.extent_id = extent_id;
+	return pg_hash_any(&hkey, sizeof(hkey));
+}
+
+/*
+ * __dpuCacheLookup - caller must hold dpu_cache_lock
+ */
+static dpuCacheExtent *
+__dpuCacheLookup(const struct stat *st, uint64_t extent_id, uint32_t hash)
+{
+	dlist_iter	iter;
+
+	dlist_foreach (iter, &dpu_cache_hash[hash % DPU_CACHE_HASHSZ])
+	{
+		dpuCacheExtent *ext = dlist_container(dpuCacheExtent,
+											  hash_chain, iter.cur);
+		if (ext->st_dev == st->st_dev &&
+			ext->st_ino == st->st_ino &&
+			ext->st_mtim.tv_sec  == st->st_mtim.tv_sec &&
+			ext->st_mtim.tv_nsec == st->st_mtim.tv_nsec &&
+			ext->extent_id == extent_id)
+			return ext;
+	}
+	return NULL;
+}
+
+/*
+ * __dpuCacheReclaim - caller must hold dpu_cache_lock
+ */
+static void
+__dpuCacheReclaim(size_t required)
+{
+	dlist_node *dnode;
+	dlist_node *prev;
+
+	for (dnode = dpu_cache_lru.head.prev;
+		 dnode != &dpu_cache_lru.head &&
+			 dpu_cache_usage + required > dpuserv_cache_size;
+		 dnode = prev)
+	{
+		dpuCacheExtent *ext = dlist_container(dpuCacheExtent,
+											  lru_chain, dnode);
+		prev = dnode->prev;
+		if (ext->refcnt > 0)
+			continue;
+		dlist_delete(&ext->hash_chain);
+		dlist_delete(&ext->lru_chain);
+		dpu_cache_usage -= DPU_CACHE_EXTENT_SZ;
+		free(ext->data);
+		free(ext);
+	}
+}
+
+static void
+dpuCacheRelease(dpuCacheExtent *ext)
+{
+	pthreadMutexLock(&dpu_cache_lock);
+	assert(ext->refcnt > 0);
+	ext->refcnt--;
+	pthreadMutexUnlock(&dpu_cache_lock);
+}
+
+/*
+ * dpuCacheGetExtent
+ *
+ * It returns the pinned extent that contains the 'extent_id'; it is loaded
+ * from the file on cache miss. NULL means no cache is available for some
+ * reasons, then caller should read the file by itself.
+ */
+static dpuCacheExtent *
+dpuCacheGetExtent(int fdesc, const struct stat *st, uint64_t extent_id)
+{
+	dpuCacheExtent *ext;
+	dpuCacheExtent *temp;
+	uint32_t	hash = __dpuCacheHash(st, extent_id);
+	off_t		offset = extent_id * DPU_CACHE_EXTENT_SZ;
+	ssize_t		nbytes;
+
+	pthreadMutexLock(&dpu_cache_lock);
+	ext = __dpuCacheLookup(st, extent_id, hash);
+	if (ext)
+	{
+		ext->refcnt++;
+		dlist_delete(&ext->lru_chain);
+		dlist_push_head(&dpu_cache_lru, &ext->lru_chain);
+		pthreadMutexUnlock(&dpu_cache_lock);
+		return ext;
+	}
+	pthreadMutexUnlock(&dpu_cache_lock);
+
+	/* cache miss, so load the extent */
+	ext = calloc(1, sizeof(dpuCacheExtent));
+	if (!ext)
+		return NULL;
+	if (posix_memalign((void **)&ext->data, PAGE_SIZE, DPU_CACHE_EXTENT_SZ) != 0)
+	{
+		free(ext);
+		return NULL;
+	}
+	ext->st_dev = st->st_dev;
+	ext->st_ino = st->st_ino;
+	ext->st_mtim = st->st_mtim;
+	ext->extent_id = extent_id;
+	ext->refcnt = 1;
+	while (ext->length < DPU_CACHE_EXTENT_SZ)
+	{
+		nbytes = pread(fdesc,
+					   ext->data + ext->length,
+					   DPU_CACHE_EXTENT_SZ - ext->length,
+					   offset + ext->length);
+		if (nbytes > 0)
+			ext->length += nbytes;
+		else if (nbytes == 0)
+			break;		/* EOF */
+		else if (errno != EINTR)
+		{
+			free(ext->data);
+			free(ext);
+			return NULL;
+		}
+	}
+
+	/* insert the extent, unless someone already loaded the same one */
+	pthreadMutexLock(&dpu_cache_lock);
+	temp = __dpuCacheLookup(st, extent_id, hash);
+	if (temp)
+	{
+		temp->refcnt++;
+		pthreadMutexUnlock(&dpu_cache_lock);
+		free(ext->data);
+		free(ext);
+		return temp;
+	}
+	__dpuCacheReclaim(DPU_CACHE_EXTENT_SZ);
+	if (dpu_cache_usage + DPU_CACHE_EXTENT_SZ <= dpuserv_cache_size)
+	{
+		dlist_push_head(&dpu_cache_hash[hash % DPU_CACHE_HASHSZ],
+						&ext->hash_chain);
+		dlist_push_head(&dpu_cache_lru, &ext->lru_chain);
+		dpu_cache_usage += DPU_CACHE_EXTENT_SZ;
+		pthreadMutexUnlock(&dpu_cache_lock);
+		return ext;
+	}
+	pthreadMutexUnlock(&dpu_cache_lock);
+	/* all the extents are pinned; no space to cache */
+	free(ext->data);
+	free(ext);
+	return NULL;
+}
+
+/*
+ * __dpuCacheReadFile
+ *
+ * pread(2) equivalent by the buffer cache. It returns false if cache is not
+ * available for the range; caller falls back to the normal read.
+ */
+static bool
+__dpuCacheReadFile(int fdesc, const struct stat *st,
+				   char *dest, off_t offset, size_t length)
+{
+	while (length > 0)
+	{
+		uint64_t	extent_id = offset / DPU_CACHE_EXTENT_SZ;
+		size_t		ext_offset = offset % DPU_CACHE_EXTENT_SZ;
+		size_t		nbytes = Min(length, DPU_CACHE_EXTENT_SZ - ext_offset);
+		dpuCacheExtent *ext;
+
+		ext = dpuCacheGetExtent(fdesc, st, extent_id);
+		if (!ext)
+			return false;
+		if (ext_offset + nbytes <= ext->length)
+			memcpy(dest, ext->data + ext_offset, nbytes);
+		else
+		{
+			/* over the tail of the file */
+			size_t	nvalids = (ext_offset < ext->length
+							   ? ext->length - ext_offset : 0);
+
+			memcpy(dest, ext->data + ext_offset, nvalids);
+			memset(dest + nvalids, 0, nbytes - nvalids);
+		}
+		dpuCacheRelease(ext);
+
+		dest   += nbytes;
+		offset += nbytes;
+		length -= nbytes;
+	}
+	return true;
+}
+
+/*
+ * __dpuservReadAhead
+ *
+ * If the client requests the chunks of the file sequentially, it hints the
+ * kernel to read ahead the next portion.
+ */
+static void
+__dpuservReadAhead(dpuClient *dclient, int fdesc, const struct stat *st,
+				   const strom_io_vector *kds_iovec)
+{
+	off_t		head = -1;
+	off_t		tail = -1;
+
+	if (dpuserv_readahead_sz == 0 || use_direct_io || !kds_iovec)
+		return;
+	for (int i=0; i < kds_iovec->nr_chunks; i++)
+	{
+		const strom_io_chunk *ioc = &kds_iovec->ioc[i];
+		off_t		offset = PAGE_SIZE * (off_t)ioc->fchunk_id;
+		off_t		length = PAGE_SIZE * (off_t)ioc->nr_pages;
+
+		if (head < 0 || offset < head)
+			head = offset;
+		if (tail < 0 || offset + length > tail)
+			tail = offset + length;
+	}
+	if (head < 0)
+		return;
+	/* multiple workers may run the chunks in parallel */
+	if (dclient->ra_st_dev == st->st_dev &&
+		dclient->ra_st_ino == st->st_ino &&
+		head >= dclient->ra_next_offset - (off_t)dpuserv_readahead_sz &&
+		head <= dclient->ra_next_offset + (off_t)dpuserv_readahead_sz)
+	{
+		(void)posix_fadvise(fdesc, tail, dpuserv_readahead_sz,
+							POSIX_FADV_WILLNEED);
+	}
+	dclient->ra_st_dev = st->st_dev;
+	dclient->ra_st_ino = st->st_ino;
+	dclient->ra_next_offset = tail;
+}
+
 /*
  * dpuservLoadKdsBlock
  *
@@ -680,6 +1409,7 @@ __dpuservLoadKdsCommon(dpuClient *dclient,
 					   size_t preload_sz,
 					   const char *pathname,
 					   const strom_io_vector *kds_iovec,
+					   bool use_cache,
 					   char **p_base_addr)
 {
 	kern_data_store *kds;
@@ -687,6 +1417,7 @@ __dpuservLoadKdsCommon(dpuClient *dclient,
 	char	   *end		__attribute__((unused));
 	int			flags = O_RDONLY | O_NOATIME;
 	int			fdesc;
+	struct stat	stat_buf;
 
 	if (use_direct_io)
 		flags |= O_DIRECT;
@@ -696,6 +1427,16 @@ __dpuservLoadKdsCommon(dpuClient *dclient,
 		dpuClientElog(dclient, "failed on open('%s'): %m", pathname);
 		return NULL;
 	}
+	if (fstat(fdesc, &stat_buf) != 0)
+	{
+		close(fdesc);
+		dpuClientElog(dclient, "failed on fstat('%s'): %m", pathname);
+		return NULL;
+	}
+	if (dpuserv_cache_size == 0)
+		use_cache = false;
+	if (!use_cache)
+		__dpuservReadAhead(dclient, fdesc, &stat_buf, kds_iovec);
 
 	data = malloc(kds_head->length + 2 * PAGE_SIZE);
 	if (!data)
@@ -728,6 +1469,9 @@ __dpuservLoadKdsCommon(dpuClient *dclient,
 			ssize_t		nbytes;
 
 			assert(dest + length <= end);
+			if (use_cache &&
+				__dpuCacheReadFile(fdesc, &stat_buf, dest, offset, length))
+				continue;
 			while (length > 0)
 			{
 				nbytes = pread(fdesc, dest, length, offset);
@@ -779,6 +1523,7 @@ dpuservLoadKdsBlock(dpuClient *dclient,
 								  kds_head->block_offset,
 								  pathname,
 								  kds_iovec,
+								  false,
 								  p_base_addr);
 }
 
@@ -795,6 +1540,7 @@ dpuservLoadKdsArrow(dpuClient *dclient,
 								  KDS_HEAD_LENGTH(kds_head),
 								  pathname,
 								  kds_iovec,
+								  true,		/* Arrow files are immutable */
 								  p_base_addr);
 }
 
@@ -1039,6 +1785,22 @@ __writeOutOneTuplePreAgg(kern_context *kcxt,
 				t_infomask |= HEAP_HASVARWIDTH;
 				break;
 
+			case KAGG_ACTION__PSUM_NUMERIC:
+			case KAGG_ACTION__PAVG_NUMERIC:
+			case KAGG_ACTION__PSUM_INT128:
+			case KAGG_ACTION__PAVG_INT128:
+				nbytes = sizeof(kagg_state__psum_numeric_packed);
+				if (buffer)
+				{
+					kagg_state__psum_numeric_packed *r =
+						(kagg_state__psum_numeric_packed *)buffer;
+					memset(r, 0, sizeof(kagg_state__psum_numeric_packed));
+					r->scale = desc->arg_scale;
+					SET_VARSIZE(r, sizeof(kagg_state__psum_numeric_packed));
+				}
+				t_infomask |= HEAP_HASVARWIDTH;
+				break;
+
 			case KAGG_ACTION__STDDEV:
 				nbytes = sizeof(kagg_state__stddev_packed);
 				if (buffer)
@@ -1059,6 +1821,20 @@ __writeOutOneTuplePreAgg(kern_context *kcxt,
 				t_infomask |= HEAP_HASVARWIDTH;
 				break;
 
+			case KAGG_ACTION__PCTILE_FP:
+				nbytes = sizeof(kagg_state__pctile_packed);
+				if (buffer)
+				{
+					kagg_state__pctile_packed *r =
+						(kagg_state__pctile_packed *)buffer;
+					memset(r, 0, sizeof(kagg_state__pctile_packed));
+					r->min_value = DBL_MAX;
+					r->max_value = -DBL_MAX;
+					SET_VARSIZE(r, sizeof(kagg_state__pctile_packed));
+				}
+				t_infomask |= HEAP_HASVARWIDTH;
+				break;
+
 			default:
 				fprintf(stderr, "Bug? unknown DpuPreAgg action: %d",
 						(int)desc->action);
@@ -1378,6 +2154,32 @@ __update_preagg__psum_fp(kern_context *kcxt,
 	}
 }
 
+/*
+ * __update_preagg__psum_numeric
+ */
+static inline void
+__update_preagg__psum_numeric(kern_context *kcxt,
+							  char *buffer,
+							  kern_colmeta *cmeta,
+							  kern_aggregate_desc *desc)
+{
+	xpu_datum_t	   *xdatum = kcxt->kvars_slot[desc->arg0_slot_id];
+	kagg_state__psum_numeric_packed *r =
+		(kagg_state__psum_numeric_packed *)buffer;
+	int128_t		ival;
+	bool			isnan;
+
+	if (__preagg_fetch_xdatum_as_fixed_numeric(kcxt, &ival, &isnan,
+												xdatum,
+												desc->arg_scale))
+	{
+		__atomic_add_uint32(&r->nitems, 1);
+		__atomic_add_fixed_numeric(r, ival);
+	}
+	else if (isnan)
+		__atomic_add_uint32(&r->nnans, 1);
+}
+
 /*
  * __update_preagg__pstddev
  */
@@ -1429,6 +2231,36 @@ __update_preagg__pcovar(kern_context *kcxt,
 	}
 }
 
+/*
+ * __update_preagg__ppctile
+ */
+static inline void
+__update_preagg__ppctile(kern_context *kcxt,
+						 char *buffer,
+						 kern_colmeta *cmeta,
+						 kern_aggregate_desc *desc)
+{
+	const xpu_datum_t  *xdatum = kcxt->kvars_slot[desc->arg0_slot_id];
+	float8_t	fval;
+
+	if (__preagg_fetch_xdatum_as_float64(&fval, xdatum))
+	{
+		kagg_state__pctile_packed *r =
+			(kagg_state__pctile_packed *)buffer;
+		int		index = __kagg_pctile_bucket_index(fval);
+
+		__atomic_add_uint32(&r->nitems, 1);
+		__atomic_min_fp64(&r->min_value, fval);
+		__atomic_max_fp64(&r->max_value, fval);
+		if (index < 0)
+			__atomic_add_uint32(&r->nzeros, 1);
+		else if (fval < 0.0)
+			__atomic_add_uint32(&r->negative[index], 1);
+		else
+			__atomic_add_uint32(&r->positive[index], 1);
+	}
+}
+
 /*
  * __updateOneTupleDpuPreAgg (for both of NoGroups and GroupBy)
  */
@@ -1504,12 +2336,21 @@ __updateOneTupleDpuPreAgg(kern_context *kcxt,
 			case KAGG_ACTION__PAVG_FP:
 				__update_preagg__psum_fp(kcxt, buffer, cmeta, desc);
 				break;
+			case KAGG_ACTION__PSUM_NUMERIC:
+			case KAGG_ACTION__PAVG_NUMERIC:
+			case KAGG_ACTION__PSUM_INT128:
+			case KAGG_ACTION__PAVG_INT128:
+				__update_preagg__psum_numeric(kcxt, buffer, cmeta, desc);
+				break;
 			case KAGG_ACTION__STDDEV:
 				__update_preagg__pstddev(kcxt, buffer, cmeta, desc);
 				break;
 			case KAGG_ACTION__COVAR:
 				__update_preagg__pcovar(kcxt, buffer, cmeta, desc);
 				break;
+			case KAGG_ACTION__PCTILE_FP:
+				__update_preagg__ppctile(kcxt, buffer, cmeta, desc);
+				break;
 			default:
 				/*
 				 * No more partial aggregation exists after grouping-keys
@@ -1523,11 +2364,12 @@ __updateOneTupleDpuPreAgg(kern_context *kcxt,
  * expandGroupByFinalBuffer
  *
  * NOTE: this function must be called under kds_final_rwlock WRITE-LOCK
+ * of the partition
  */
 static bool
-expandGroupByFinalBuffer(groupby_final_buffer *gf_buf)
+expandGroupByFinalBuffer(groupby_final_part *part)
 {
-	kern_data_store *kds_old = gf_buf->kds_final;
+	kern_data_store *kds_old = part->kds_final;
 	kern_data_store *kds_new;
 	size_t		sz, length;
 
@@ -1548,7 +2390,7 @@ expandGroupByFinalBuffer(groupby_final_buffer *gf_buf)
 		   (char *)kds_old + kds_old->length - sz, sz);
 
 	/* swap them */
-	gf_buf->kds_final = kds_new;
+	part->kds_final = kds_new;
 	free(kds_old);
 
 	return true;
@@ -1562,7 +2404,7 @@ __handleDpuTaskExecNoGroupPreAgg(dpuClient *dclient,
 								 dpuTaskExecState *dtes,
 								 kern_context *kcxt)
 {
-	groupby_final_buffer *gf_buf = dclient->gf_buf;
+	groupby_final_part *part = &dclient->gf_buf->parts[0];
 	kern_session_info  *session = dclient->session;
 	kern_expression	   *kexp_groupby_actions = SESSION_KEXP_GROUPBY_ACTIONS(session);
 	kern_expression	   *karg;
@@ -1582,10 +2424,11 @@ __handleDpuTaskExecNoGroupPreAgg(dpuClient *dclient,
 			return false;
 	}
 
-	pthreadRWLockReadLock(&gf_buf->kds_final_rwlock);
+	assert(dclient->gf_buf->nparts == 1);
+	pthreadRWLockReadLock(&part->kds_final_rwlock);
 	while (!tupitem)
 	{
-		kds_final = gf_buf->kds_final;
+		kds_final = part->kds_final;
 
 		assert(kds_final->format == KDS_FORMAT_ROW);
 		if (kds_final->nitems == 1)
@@ -1596,8 +2439,8 @@ __handleDpuTaskExecNoGroupPreAgg(dpuClient *dclient,
 		}
 		else if (!has_exclusive)
 		{
-			pthreadRWLockUnlock(&gf_buf->kds_final_rwlock);
-			pthreadRWLockWriteLock(&gf_buf->kds_final_rwlock);
+			pthreadRWLockUnlock(&part->kds_final_rwlock);
+			pthreadRWLockWriteLock(&part->kds_final_rwlock);
 			has_exclusive = true;
 		}
 		else
@@ -1606,10 +2449,10 @@ __handleDpuTaskExecNoGroupPreAgg(dpuClient *dclient,
 			tupitem = __insertOneTupleNoGroups(kcxt, kds_final,
 											   kexp_groupby_actions);
 			if (!tupitem &&
-				!expandGroupByFinalBuffer(gf_buf))
+				!expandGroupByFinalBuffer(part))
 			{
 				/* out of memory */
-				pthreadRWLockUnlock(&gf_buf->kds_final_rwlock);
+				pthreadRWLockUnlock(&part->kds_final_rwlock);
 				return false;
 			}
 		}
@@ -1618,7 +2461,7 @@ __handleDpuTaskExecNoGroupPreAgg(dpuClient *dclient,
 	__updateOneTupleDpuPreAgg(kcxt, kds_final,
 							  &tupitem->htup,
 							  kexp_groupby_actions);
-	pthreadRWLockUnlock(&gf_buf->kds_final_rwlock);
+	pthreadRWLockUnlock(&part->kds_final_rwlock);
 	return true;
 }
 
@@ -1630,7 +2473,7 @@ __handleDpuTaskExecGroupByPreAgg(dpuClient *dclient,
 								 dpuTaskExecState *dtes,
 								 kern_context *kcxt)
 {
-	groupby_final_buffer *gf_buf = dclient->gf_buf;
+	groupby_final_part *part;
 	kern_session_info  *session = dclient->session;
 	kern_expression	   *kexp_groupby_keyhash = SESSION_KEXP_GROUPBY_KEYHASH(session);
 	kern_expression	   *kexp_groupby_keyload = SESSION_KEXP_GROUPBY_KEYLOAD(session);
@@ -1664,15 +2507,21 @@ __handleDpuTaskExecGroupByPreAgg(dpuClient *dclient,
 	if (XPU_DATUM_ISNULL(&hash))
 		return false;
 
-	pthreadRWLockReadLock(&gf_buf->kds_final_rwlock);
-	kds_final = gf_buf->kds_final;
-	assert(kds_final->format == KDS_FORMAT_HASH);
+	part = GROUPBY_FINAL_PART(dclient->gf_buf, (uint32_t)hash.value);
+	pthreadRWLockReadLock(&part->kds_final_rwlock);
 	do {
-		uint32_t   *hslot = KDS_GET_HASHSLOT(kds_final, hash.value);
-		uint32_t	hoffset = __volatileRead(hslot);
-		uint32_t	saved = hoffset;
+		uint32_t   *hslot;
+		uint32_t	hoffset;
+		uint32_t	saved;
 		xpu_bool_t	status;
 
+		/* kds_final may be replaced by the expansion */
+		kds_final = part->kds_final;
+		assert(kds_final->format == KDS_FORMAT_HASH);
+		hslot = KDS_GET_HASHSLOT(kds_final, hash.value);
+		hoffset = __volatileRead(hslot);
+		saved = hoffset;
+		hitem = NULL;
 		if (hoffset == UINT_MAX)
 		{
 			/* someone already hold the hslot-lock */
@@ -1726,16 +2575,16 @@ __handleDpuTaskExecGroupByPreAgg(dpuClient *dclient,
 				__atomic_write_uint32(hslot, saved);
 				if (!has_exclusive)
 				{
-					pthreadRWLockUnlock(&gf_buf->kds_final_rwlock);
-					pthreadRWLockWriteLock(&gf_buf->kds_final_rwlock);
+					pthreadRWLockUnlock(&part->kds_final_rwlock);
+					pthreadRWLockWriteLock(&part->kds_final_rwlock);
 					has_exclusive = true;
 				}
 				else
 				{
-					/* expand the kds_final buffer */
-					if (!expandGroupByFinalBuffer(gf_buf))
+					/* expand the kds_final buffer of this partition */
+					if (!expandGroupByFinalBuffer(part))
 					{
-						pthreadRWLockUnlock(&gf_buf->kds_final_rwlock);
+						pthreadRWLockUnlock(&part->kds_final_rwlock);
 						return false;
 					}
 				}
@@ -1746,7 +2595,7 @@ __handleDpuTaskExecGroupByPreAgg(dpuClient *dclient,
 	__updateOneTupleDpuPreAgg(kcxt, kds_final,
 							  &hitem->t.htup,
 							  kexp_groupby_actions);
-	pthreadRWLockUnlock(&gf_buf->kds_final_rwlock);
+	pthreadRWLockUnlock(&part->kds_final_rwlock);
 
 	return true;
 }
@@ -1939,6 +2788,7 @@ __handleDpuScanExecBlock(dpuClient *dclient,
 	assert(kds_src->format == KDS_FORMAT_BLOCK);
 	assert(!kmrels || kmrels->num_rels > 0);
 	INIT_KERNEL_CONTEXT(kcxt, session);
+	kcxt->kmrels = kmrels;
 
 	for (block_index = 0; block_index < kds_src->nitems; block_index++)
 	{
@@ -1996,6 +2846,292 @@ __handleDpuScanExecBlock(dpuClient *dclient,
 	return true;
 }
 
+/*
+ * Vectorized pre-filter for Arrow
+ *
+ * Simple comparisons between a fixed-width column and a constant in the
+ * top-level AND of the scan qualifiers are evaluated per column chunk, using
+ * branch-free loops that the compiler auto-vectorizes (NEON/SVE on DPU, or
+ * SSE/AVX on x86). It is a pre-filter; the rows survived are checked by the
+ * entire scan qualifiers again, row-by-row. So, the pre-filter never drops
+ * the rows that may satisfy the qualifiers, and falls back to row-at-a-time
+ * evaluation for the other expressions.
+ */
+#define DPU_VECQUAL_MAX_NUMS	32
+#define DPU_VECQUAL_UNITSZ		2048
+
+typedef enum
+{
+	DpuVecQualOper__EQ,
+	DpuVecQualOper__NE,
+	DpuVecQualOper__LT,
+	DpuVecQualOper__LE,
+	DpuVecQualOper__GT,
+	DpuVecQualOper__GE,
+} DpuVecQualOper;
+
+typedef struct
+{
+	const kern_colmeta *cmeta;
+	TypeOpCode		type_code;
+	DpuVecQualOper	oper;
+	union {
+		int64_t		ival;
+		double		fval;
+	} c;
+} dpuVecQual;
+
+static DpuVecQualOper
+__dpuVecQualCommute(DpuVecQualOper oper)
+{
+	switch (oper)
+	{
+		case DpuVecQualOper__LT: return DpuVecQualOper__GT;
+		case DpuVecQualOper__LE: return DpuVecQualOper__GE;
+		case DpuVecQualOper__GT: return DpuVecQualOper__LT;
+		case DpuVecQualOper__GE: return DpuVecQualOper__LE;
+		default:
+			break;
+	}
+	return oper;
+}
+
+static bool
+__dpuVecQualBuildOne(const kern_expression *kexp,
+					 const kern_expression *kexp_load_vars,
+					 const kern_data_store *kds,
+					 dpuVecQual *vqual)
+{
+	const kern_expression *karg1;
+	const kern_expression *karg2;
+	const kern_colmeta *cmeta = NULL;
+	TypeOpCode	type_code;
+	DpuVecQualOper oper;
+
+	switch (kexp->opcode)
+	{
+#define __DPU_VECQUAL_OPCODE(TYPE)										\
+		case FuncOpCode__##TYPE##eq:									\
+			type_code = TypeOpCode__##TYPE; oper = DpuVecQualOper__EQ; break; \
+		case FuncOpCode__##TYPE##ne:									\
+			type_code = TypeOpCode__##TYPE; oper = DpuVecQualOper__NE; break; \
+		case FuncOpCode__##TYPE##lt:									\
+			type_code = TypeOpCode__##TYPE; oper = DpuVecQualOper__LT; break; \
+		case FuncOpCode__##TYPE##le:									\
+			type_code = TypeOpCode__##TYPE; oper = DpuVecQualOper__LE; break; \
+		case FuncOpCode__##TYPE##gt:									\
+			type_code = TypeOpCode__##TYPE; oper = DpuVecQualOper__GT; break; \
+		case FuncOpCode__##TYPE##ge:									\
+			type_code = TypeOpCode__##TYPE; oper = DpuVecQualOper__GE; break;
+		__DPU_VECQUAL_OPCODE(int2)
+		__DPU_VECQUAL_OPCODE(int4)
+		__DPU_VECQUAL_OPCODE(int8)
+		__DPU_VECQUAL_OPCODE(float4)
+		__DPU_VECQUAL_OPCODE(float8)
+#undef __DPU_VECQUAL_OPCODE
+		default:
+			return false;
+	}
+	if (kexp->nr_args != 2)
+		return false;
+	karg1 = KEXP_FIRST_ARG(kexp);
+	karg2 = KEXP_NEXT_ARG(karg1);
+	if (karg1->opcode == FuncOpCode__ConstExpr &&
+		karg2->opcode == FuncOpCode__VarExpr)
+	{
+		const kern_expression *temp = karg1;
+
+		karg1 = karg2;
+		karg2 = temp;
+		oper = __dpuVecQualCommute(oper);
+	}
+	if (karg1->opcode != FuncOpCode__VarExpr ||
+		karg1->u.v.var_offset >= 0 ||
+		karg2->opcode != FuncOpCode__ConstExpr ||
+		karg2->u.c.const_isnull)
+		return false;
+	/* lookup the source column of the VarExpr */
+	for (int i=0; i < kexp_load_vars->u.load.nitems; i++)
+	{
+		const kern_varload_desc *vl_desc = &kexp_load_vars->u.load.desc[i];
+
+		if (vl_desc->vl_slot_id == karg1->u.v.var_slot_id)
+		{
+			if (vl_desc->vl_resno > 0 && vl_desc->vl_resno <= kds->ncols)
+				cmeta = &kds->colmeta[vl_desc->vl_resno - 1];
+			break;
+		}
+	}
+	if (!cmeta ||
+		cmeta->values_offset == 0 ||
+		cmeta->extra_offset != 0 ||
+		cmeta->dict_index_sz != 0)
+		return false;
+
+	switch (type_code)
+	{
+		case TypeOpCode__int2:
+		case TypeOpCode__int4:
+		case TypeOpCode__int8:
+			/* unsigned Arrow::Int may raise an error by row-at-a-time */
+			if (cmeta->attopts.tag != ArrowType__Int ||
+				!cmeta->attopts.integer.is_signed ||
+				cmeta->attopts.integer.bitWidth != cmeta->attlen * 8)
+				return false;
+			if (type_code == TypeOpCode__int2)
+				vqual->c.ival = *((const int16_t *)karg2->u.c.const_value);
+			else if (type_code == TypeOpCode__int4)
+				vqual->c.ival = *((const int32_t *)karg2->u.c.const_value);
+			else
+				vqual->c.ival = *((const int64_t *)karg2->u.c.const_value);
+			break;
+		case TypeOpCode__float4:
+		case TypeOpCode__float8:
+			if (cmeta->attopts.tag != ArrowType__FloatingPoint ||
+				cmeta->attopts.floating_point.precision !=
+				(type_code == TypeOpCode__float4
+				 ? ArrowPrecision__Single
+				 : ArrowPrecision__Double))
+				return false;
+			if (type_code == TypeOpCode__float4)
+				vqual->c.fval = *((const float *)karg2->u.c.const_value);
+			else
+				vqual->c.fval = *((const double *)karg2->u.c.const_value);
+			/* PostgreSQL considers NaN larger than any other values */
+			if (isnan(vqual->c.fval))
+				return false;
+			break;
+		default:
+			return false;
+	}
+	vqual->cmeta = cmeta;
+	vqual->type_code = type_code;
+	vqual->oper = oper;
+	return true;
+}
+
+static int
+dpuVecQualBuild(const kern_expression *kexp_scan_quals,
+				const kern_expression *kexp_load_vars,
+				const kern_data_store *kds,
+				dpuVecQual *vqual_array)
+{
+	const kern_expression *karg;
+	int		nquals = 0;
+	int		i;
+
+	if (!kexp_scan_quals || !kexp_load_vars)
+		return 0;
+	if (kexp_scan_quals->opcode != FuncOpCode__BoolExpr_And)
+		return (__dpuVecQualBuildOne(kexp_scan_quals,
+									 kexp_load_vars,
+									 kds, vqual_array) ? 1 : 0);
+	for (i=0, karg = KEXP_FIRST_ARG(kexp_scan_quals);
+		 i < kexp_scan_quals->nr_args && nquals < DPU_VECQUAL_MAX_NUMS;
+		 i++, karg = KEXP_NEXT_ARG(karg))
+	{
+		if (__dpuVecQualBuildOne(karg, kexp_load_vars, kds,
+								 &vqual_array[nquals]))
+			nquals++;
+	}
+	return nquals;
+}
+
+#define __DPU_VECQUAL_LOOP(BASETYPE,CVAL,CMP,IS_FLOAT)					\
+	do {																\
+		const BASETYPE *values = (const BASETYPE *)						\
+			((const char *)kds + __kds_unpack(cmeta->values_offset));	\
+		BASETYPE	cval = (BASETYPE)(CVAL);							\
+																		\
+		for (uint32_t i=base; i < end; i++)								\
+		{																\
+			BASETYPE	v = values[i];									\
+																		\
+			if (IS_FLOAT)												\
+				rowmap[i-base] &= ((v CMP cval) | (v != v));			\
+			else														\
+				rowmap[i-base] &= (v CMP cval);							\
+		}																\
+	} while(0)
+
+#define __DPU_VECQUAL_OPER(BASETYPE,CVAL,IS_FLOAT)						\
+	do {																\
+		switch (vqual->oper)											\
+		{																\
+			case DpuVecQualOper__EQ:									\
+				__DPU_VECQUAL_LOOP(BASETYPE,CVAL,==,IS_FLOAT); break;	\
+			case DpuVecQualOper__NE:									\
+				__DPU_VECQUAL_LOOP(BASETYPE,CVAL,!=,IS_FLOAT); break;	\
+			case DpuVecQualOper__LT:									\
+				__DPU_VECQUAL_LOOP(BASETYPE,CVAL,<,IS_FLOAT); break;	\
+			case DpuVecQualOper__LE:									\
+				__DPU_VECQUAL_LOOP(BASETYPE,CVAL,<=,IS_FLOAT); break;	\
+			case DpuVecQualOper__GT:									\
+				__DPU_VECQUAL_LOOP(BASETYPE,CVAL,>,IS_FLOAT); break;	\
+			case DpuVecQualOper__GE:									\
+				__DPU_VECQUAL_LOOP(BASETYPE,CVAL,>=,IS_FLOAT); break;	\
+		}																\
+	} while(0)
+
+/*
+ * dpuVecQualExec
+ *
+ * It sets rowmap[] of the rows in [base, base + nrows) to 1, if the row may
+ * satisfy all the vectorized qualifiers. NULL never satisfies comparisons.
+ */
+static void
+dpuVecQualExec(const kern_data_store *kds,
+			   const dpuVecQual *vqual_array, int nquals,
+			   uint32_t base, uint32_t nrows, uint8_t *rowmap)
+{
+	memset(rowmap, 1, nrows);
+	for (int k=0; k < nquals; k++)
+	{
+		const dpuVecQual   *vqual = &vqual_array[k];
+		const kern_colmeta *cmeta = vqual->cmeta;
+		uint32_t	nvalids = __kds_unpack(cmeta->values_length) / cmeta->attlen;
+		uint32_t	end = Min(base + nrows, nvalids);
+
+		if (end < base + nrows)
+			memset(rowmap + (end > base ? end - base : 0), 0,
+				   base + nrows - Max(end, base));
+		switch (vqual->type_code)
+		{
+			case TypeOpCode__int2:
+				__DPU_VECQUAL_OPER(int16_t, vqual->c.ival, false);
+				break;
+			case TypeOpCode__int4:
+				__DPU_VECQUAL_OPER(int32_t, vqual->c.ival, false);
+				break;
+			case TypeOpCode__int8:
+				__DPU_VECQUAL_OPER(int64_t, vqual->c.ival, false);
+				break;
+			case TypeOpCode__float4:
+				__DPU_VECQUAL_OPER(float,   vqual->c.fval, true);
+				break;
+			case TypeOpCode__float8:
+				__DPU_VECQUAL_OPER(double,  vqual->c.fval, true);
+				break;
+			default:
+				break;
+		}
+		/* null bitmap */
+		if (cmeta->nullmap_offset)
+		{
+			const uint8_t *nullmap = ((const uint8_t *)kds +
+									  __kds_unpack(cmeta->nullmap_offset));
+			uint32_t	nullmap_nbits = 8 * __kds_unpack(cmeta->nullmap_length);
+
+			end = Min(base + nrows, nullmap_nbits);
+			if (end < base + nrows)
+				memset(rowmap + (end > base ? end - base : 0), 0,
+					   base + nrows - Max(end, base));
+			for (uint32_t i=base; i < end; i++)
+				rowmap[i-base] &= ((nullmap[i>>3] >> (i & 7)) & 1);
+		}
+	}
+}
+
 static bool
 __handleDpuScanExecArrow(dpuClient *dclient,
 						 dpuTaskExecState *dtes,
@@ -2007,11 +3143,31 @@ __handleDpuScanExecArrow(dpuClient *dclient,
 	kern_expression	   *kexp_scan_quals = SESSION_KEXP_SCAN_QUALS(session);
 	kern_context	   *kcxt;
 	uint32_t			kds_index;
+	dpuVecQual			vqual_array[DPU_VECQUAL_MAX_NUMS];
+	int					vqual_nums;
+	uint8_t				rowmap[DPU_VECQUAL_UNITSZ];
 
 	assert(kds_src->format == KDS_FORMAT_ARROW);
 	INIT_KERNEL_CONTEXT(kcxt, session);
+	kcxt->kmrels = kmrels;
+	vqual_nums = dpuVecQualBuild(kexp_scan_quals,
+								 kexp_load_vars,
+								 kds_src,
+								 vqual_array);
 	for (kds_index = 0; kds_index < kds_src->nitems; kds_index++)
 	{
+		if (vqual_nums > 0)
+		{
+			uint32_t	unitsz = DPU_VECQUAL_UNITSZ;
+
+			if (kds_index % unitsz == 0)
+				dpuVecQualExec(kds_src, vqual_array, vqual_nums,
+							   kds_index,
+							   Min(unitsz, kds_src->nitems - kds_index),
+							   rowmap);
+			if (!rowmap[kds_index % unitsz])
+				continue;
+		}
 		kcxt_reset(kcxt);
 		if (ExecLoadVarsOuterArrow(kcxt,
 								   kexp_load_vars,
@@ -2168,7 +3324,8 @@ dpuservHandleDpuTaskFinal(dpuClient *dclient, XpuCommand *xcmd)
 
 	/* iovec allocation */
 	iovec_array = alloca(sizeof(struct iovec) *
-						 ((kmrels ? kmrels->num_rels : 0) + 8));
+						 ((kmrels ? kmrels->num_rels : 0) +
+						  (gf_buf ? 3 * gf_buf->nparts : 0) + 8));
 	/* Xcmd for the response */
 	memset(&resp, 0, sizeof(XpuCommand));
 	resp_sz = MAXALIGN(offsetof(XpuCommand, u.results.stats));
@@ -2212,77 +3369,89 @@ dpuservHandleDpuTaskFinal(dpuClient *dclient, XpuCommand *xcmd)
 	}
 
 	/*
-	 * KDS-Final buffer if DpuPreAgg
+	 * KDS-Final buffer if DpuPreAgg; every partition is written back as
+	 * an individual chunk.
 	 */
 	if (xcmd->u.fin.final_plan_node && gf_buf)
 	{
-		kern_data_store *kds_final;
-		size_t		sz1, sz2, sz3;
-
-		pthreadRWLockReadLock(&gf_buf->kds_final_rwlock);
+		for (uint32_t k=0; k < gf_buf->nparts; k++)
+			pthreadRWLockReadLock(&gf_buf->parts[k].kds_final_rwlock);
 		gf_buf_locked = true;
 
-		kds_final = gf_buf->kds_final;
-		if (kds_final->format == KDS_FORMAT_HASH)
+		resp.u.results.final_plan_node = true;
+		resp.u.results.chunks_nitems = 0;
+		resp.u.results.chunks_offset = resp_sz;
+		for (uint32_t k=0; k < gf_buf->nparts; k++)
 		{
-			assert(kds_final->hash_nslots > 0);
-			sz1 = KDS_HEAD_LENGTH(kds_final);
-			iov = &iovec_array[iovcnt++];
-			iov->iov_base = kds_final;
-			iov->iov_len  = sz1;
+			kern_data_store *kds_final = gf_buf->parts[k].kds_final;
+			size_t		sz1, sz2, sz3;
 
-			sz2 = MAXALIGN(sizeof(uint32_t) * kds_final->nitems);
-			if (sz2 > 0)
-			{
-				iov = &iovec_array[iovcnt++];
-				iov->iov_base = KDS_GET_ROWINDEX(kds_final);
-				iov->iov_len  = sz2;
-			}
-
-			sz3 = __kds_unpack(kds_final->usage);
-			if (sz3 > 0)
-			{
-				iov = &iovec_array[iovcnt++];
-				iov->iov_base = (char *)kds_final + kds_final->length - sz3;
-				iov->iov_len  = sz3;
-			}
-			/* fixup kds */
-			kds_final->format = KDS_FORMAT_ROW;
-			kds_final->hash_nslots = 0;
-			kds_final->length = (sz1 + sz2 + sz3);
-		}
-		else
-		{
-			assert(kds_final->format == KDS_FORMAT_ROW &&
-				   kds_final->hash_nslots == 0);
-			sz1 = (KDS_HEAD_LENGTH(kds_final) +
-				   MAXALIGN(sizeof(uint32_t) * kds_final->nitems));
-			if (sz1 > 0)
+			/* empty partitions are skipped, but one chunk at least */
+			if (kds_final->nitems == 0 &&
+				(k + 1 < gf_buf->nparts || resp.u.results.chunks_nitems > 0))
+				continue;
+			if (kds_final->format == KDS_FORMAT_HASH)
 			{
+				assert(kds_final->hash_nslots > 0);
+				sz1 = KDS_HEAD_LENGTH(kds_final);
 				iov = &iovec_array[iovcnt++];
 				iov->iov_base = kds_final;
 				iov->iov_len  = sz1;
+
+				sz2 = MAXALIGN(sizeof(uint32_t) * kds_final->nitems);
+				if (sz2 > 0)
+				{
+					iov = &iovec_array[iovcnt++];
+					iov->iov_base = KDS_GET_ROWINDEX(kds_final);
+					iov->iov_len  = sz2;
+				}
+
+				sz3 = __kds_unpack(kds_final->usage);
+				if (sz3 > 0)
+				{
+					iov = &iovec_array[iovcnt++];
+					iov->iov_base = (char *)kds_final + kds_final->length - sz3;
+					iov->iov_len  = sz3;
+				}
+				/* fixup kds */
+				kds_final->format = KDS_FORMAT_ROW;
+				kds_final->hash_nslots = 0;
+				kds_final->length = (sz1 + sz2 + sz3);
 			}
-			sz2 = __kds_unpack(kds_final->usage);
-			if (sz2 > 0)
+			else
 			{
-				iov = &iovec_array[iovcnt++];
-				iov->iov_base = (char *)kds_final + kds_final->length - sz2;
-				iov->iov_len  = sz2;
+				assert(kds_final->format == KDS_FORMAT_ROW &&
+					   kds_final->hash_nslots == 0);
+				sz1 = (KDS_HEAD_LENGTH(kds_final) +
+					   MAXALIGN(sizeof(uint32_t) * kds_final->nitems));
+				if (sz1 > 0)
+				{
+					iov = &iovec_array[iovcnt++];
+					iov->iov_base = kds_final;
+					iov->iov_len  = sz1;
+				}
+				sz2 = __kds_unpack(kds_final->usage);
+				if (sz2 > 0)
+				{
+					iov = &iovec_array[iovcnt++];
+					iov->iov_base = (char *)kds_final + kds_final->length - sz2;
+					iov->iov_len  = sz2;
+				}
+				/* fixup kds */
+				kds_final->length = sz1 + sz2;
 			}
-			/* fixup kds */
-			kds_final->length = sz1 + sz2;
+			resp.u.results.chunks_nitems++;
+			resp_sz += kds_final->length;
 		}
-		resp.u.results.final_plan_node = true;
-		resp.u.results.chunks_nitems = 1;
-		resp.u.results.chunks_offset = resp_sz;
-		resp_sz += kds_final->length;
 	}
 	resp.length = resp_sz;
 	__dpuClientWriteBack(dclient, iovec_array, iovcnt);
 
 	if (gf_buf_locked)
-		pthreadRWLockUnlock(&gf_buf->kds_final_rwlock);
+	{
+		for (uint32_t k=0; k < gf_buf->nparts; k++)
+			pthreadRWLockUnlock(&gf_buf->parts[k].kds_final_rwlock);
+	}
 }
 
 /*
@@ -2329,76 +3498,169 @@ putDpuClient(dpuClient *dclient, int count)
 	}
 }
 
+/*
+ * dpuRunQueuePush
+ */
+static void
+dpuRunQueuePush(XpuCommand *xcmd, uint32_t index)
+{
+	dpuRunQueue *runq = &dpu_runq_array[index % dpu_runq_nums];
+	bool		has_idle;
+
+	pthreadMutexLock(&runq->lock);
+	dlist_push_tail(&runq->cmd_list, &xcmd->chain);
+	runq->nitems++;
+	has_idle = (runq->nidles > 0);
+	if (has_idle)
+		pthreadCondSignal(&runq->cond);
+	pthreadMutexUnlock(&runq->lock);
+
+	/*
+	 * All the workers on the run queue are busy, so wake up an idle worker
+	 * on the other run queue to steal the command.
+	 */
+	if (!has_idle)
+	{
+		for (uint32_t k=1; k < dpu_runq_nums; k++)
+		{
+			dpuRunQueue *curr = &dpu_runq_array[(index + k) % dpu_runq_nums];
+
+			if (__atomic_load_n(&curr->nidles, __ATOMIC_RELAXED) > 0)
+			{
+				pthreadMutexLock(&curr->lock);
+				pthreadCondSignal(&curr->cond);
+				pthreadMutexUnlock(&curr->lock);
+				break;
+			}
+		}
+	}
+}
+
+/*
+ * dpuRunQueueFetch
+ *
+ * It fetches a command from the run queue of the worker, or steals
+ * a command from the other run queues. It returns NULL on termination.
+ */
+static XpuCommand *
+__dpuRunQueuePop(dpuRunQueue *runq)
+{
+	dlist_node *dnode;
+
+	if (dlist_is_empty(&runq->cmd_list))
+		return NULL;
+	dnode = dlist_pop_head_node(&runq->cmd_list);
+	runq->nitems--;
+	return dlist_container(XpuCommand, chain, dnode);
+}
+
+static XpuCommand *
+dpuRunQueueFetch(uint32_t index)
+{
+	dpuRunQueue *runq = &dpu_runq_array[index];
+	XpuCommand *xcmd = NULL;
+
+	pthreadMutexLock(&runq->lock);
+	while (!got_sigterm)
+	{
+		xcmd = __dpuRunQueuePop(runq);
+		if (xcmd)
+			break;
+		pthreadMutexUnlock(&runq->lock);
+
+		/* try work stealing */
+		for (uint32_t k=1; k < dpu_runq_nums; k++)
+		{
+			dpuRunQueue *curr = &dpu_runq_array[(index + k) % dpu_runq_nums];
+
+			if (__atomic_load_n(&curr->nitems, __ATOMIC_RELAXED) == 0)
+				continue;
+			pthreadMutexLock(&curr->lock);
+			xcmd = __dpuRunQueuePop(curr);
+			pthreadMutexUnlock(&curr->lock);
+			if (xcmd)
+				return xcmd;
+		}
+
+		pthreadMutexLock(&runq->lock);
+		if (!dlist_is_empty(&runq->cmd_list))
+			continue;
+		/* timeout is a safety-net towards the lost wakeup by stealing */
+		runq->nidles++;
+		pthreadCondWaitTimeout(&runq->cond, &runq->lock, 1000);
+		runq->nidles--;
+	}
+	pthreadMutexUnlock(&runq->lock);
+
+	return xcmd;
+}
+
 /*
  * dpuservDpuWorkerMain
  */
 static void *
 dpuservDpuWorkerMain(void *__priv)
 {
-	long	worker_id = (long)__priv;
-
+	long		worker_id = (long)__priv;
+	uint32_t	runq_index = worker_id % dpu_runq_nums;
+	XpuCommand *xcmd;
+	cpu_set_t	cpuset;
+
+	/* bind the worker to the CPU core of the run queue */
+	CPU_ZERO(&cpuset);
+	CPU_SET(runq_index, &cpuset);
+	if ((errno = pthread_setaffinity_np(pthread_self(),
+										sizeof(cpu_set_t), &cpuset)) != 0)
+		fprintf(stderr, "[worker-%lu] failed on pthread_setaffinity_np: %m\n",
+				worker_id);
 	if (verbose)
-		fprintf(stderr, "[worker-%lu] DPU service worker start.\n", worker_id);
-	pthreadMutexLock(&dpu_command_mutex);
-	while (!got_sigterm)
+		fprintf(stderr, "[worker-%lu] DPU service worker start (run-queue %u).\n",
+				worker_id, runq_index);
+	while ((xcmd = dpuRunQueueFetch(runq_index)) != NULL)
 	{
-		if (!dlist_is_empty(&dpu_command_list))
+		dpuClient  *dclient = xcmd->priv;
+
+		/*
+		 * MEMO: If the least bit of gclient->refcnt is not set,
+		 * it means the gpu-client connection is no longer available.
+		 * (event loop has already released the socket)
+		 */
+		if ((dclient->refcnt & 1) == 1)
 		{
-			dlist_node	   *dnode = dlist_pop_head_node(&dpu_command_list);
-			XpuCommand	   *xcmd = dlist_container(XpuCommand, chain, dnode);
-			dpuClient	   *dclient;
-			pthreadMutexUnlock(&dpu_command_mutex);
-
-			dclient = xcmd->priv;
-			/*
-			 * MEMO: If the least bit of gclient->refcnt is not set,
-			 * it means the gpu-client connection is no longer available.
-			 * (monitor thread has already gone)
-			 */
-			if ((dclient->refcnt & 1) == 1)
+			switch (xcmd->tag)
 			{
-				switch (xcmd->tag)
-				{
-					case XpuCommandTag__OpenSession:
-						if (dpuservHandleOpenSession(dclient, xcmd))
-							xcmd = NULL;	/* session information shall be kept until
-											 * end of the session. */
-						if (verbose)
-							fprintf(stderr, "[DPU-%ld@%s] OpenSession ... %s\n",
-									worker_id, dclient->peer_addr,
-									(xcmd != NULL ? "failed" : "ok"));
-						break;
-					case XpuCommandTag__XpuTaskExec:
-						dpuservHandleDpuTaskExec(dclient, xcmd);
-						if (verbose)
-							fprintf(stderr, "[DPU-%ld@%s] CMD=XpuTaskExec\n",
-									worker_id, dclient->peer_addr);
-						break;
-					case XpuCommandTag__XpuTaskFinal:
-						dpuservHandleDpuTaskFinal(dclient, xcmd);
-						if (verbose)
-							fprintf(stderr, "[DPU-%ld@%s] CMD=XpuTaskFinal\n",
-									worker_id, dclient->peer_addr);
-						break;
-					default:
-						fprintf(stderr, "[DPU-%ld@%s] unknown xPU command (tag=%u, len=%ld)\n",
+				case XpuCommandTag__OpenSession:
+					if (dpuservHandleOpenSession(dclient, xcmd))
+						xcmd = NULL;	/* session information shall be kept until
+										 * end of the session. */
+					if (verbose)
+						fprintf(stderr, "[DPU-%ld@%s] OpenSession ... %s\n",
 								worker_id, dclient->peer_addr,
-								xcmd->tag, xcmd->length);
-						break;
-				}
+								(xcmd != NULL ? "failed" : "ok"));
+					break;
+				case XpuCommandTag__XpuTaskExec:
+					dpuservHandleDpuTaskExec(dclient, xcmd);
+					if (verbose)
+						fprintf(stderr, "[DPU-%ld@%s] CMD=XpuTaskExec\n",
+								worker_id, dclient->peer_addr);
+					break;
+				case XpuCommandTag__XpuTaskFinal:
+					dpuservHandleDpuTaskFinal(dclient, xcmd);
+					if (verbose)
+						fprintf(stderr, "[DPU-%ld@%s] CMD=XpuTaskFinal\n",
+								worker_id, dclient->peer_addr);
+					break;
+				default:
+					fprintf(stderr, "[DPU-%ld@%s] unknown xPU command (tag=%u, len=%ld)\n",
+							worker_id, dclient->peer_addr,
+							xcmd->tag, xcmd->length);
+					break;
 			}
-			if (xcmd)
-				free(xcmd);
-			putDpuClient(dclient, 2);
-			pthreadMutexLock(&dpu_command_mutex);
-		}
-		else
-		{
-			pthreadCondWait(&dpu_command_cond,
-							&dpu_command_mutex);
 		}
+		if (xcmd)
+			free(xcmd);
+		putDpuClient(dclient, 2);
 	}
-	pthreadMutexUnlock(&dpu_command_mutex);
 	if (verbose)
 		fprintf(stderr, "[worker-%lu] DPU service worker terminated.\n", worker_id);
 	return NULL;
@@ -2426,59 +3688,98 @@ __dpuServAttachCommand(void *__priv, XpuCommand *xcmd)
 				dclient->peer_addr,
 				xcmd->tag, xcmd->length);
 
-	pthreadMutexLock(&dpu_command_mutex);
-	dlist_push_tail(&dpu_command_list, &xcmd->chain);
-	pthreadCondSignal(&dpu_command_cond);
-	pthreadMutexUnlock(&dpu_command_mutex);
+	dpuRunQueuePush(xcmd, dclient->runq_index);
 }
 
 TEMPLATE_XPU_CONNECT_RECEIVE_COMMANDS(__dpuServ)
 
-static void *
-dpuservMonitorClient(void *__priv)
+/*
+ * dpuservCloseClient
+ *
+ * It detaches the client socket from the event loop. The dpuClient shall be
+ * released when the last command in the run queues is completed.
+ */
+static void
+dpuservCloseClient(int epoll_fd, dpuClient *dclient)
 {
-	dpuClient  *dclient = (dpuClient *)__priv;
-
-	if (verbose)
-		fprintf(stderr, "[%s] connection start\n", dclient->peer_addr);
-	while (!got_sigterm && !dclient->in_termination)
-	{
-		struct pollfd  pfd;
-		int		rv;
+	/* dpu_client_list tracks the clients monitored by the event loop */
+	pthreadMutexLock(&dpu_client_mutex);
+	if (dclient->chain.prev && dclient->chain.next)
+		dlist_delete(&dclient->chain);
+	pthreadMutexUnlock(&dpu_client_mutex);
 
-		pfd.fd = dclient->sockfd;
-		pfd.events = POLLIN | POLLRDHUP;
-		pfd.revents = 0;
-		rv = poll(&pfd, 1, -1);
-		if (rv < 0)
-		{
-			if (errno == EINTR)
-				continue;
-			fprintf(stderr, "[%s] failed on poll(2): %m\n", dclient->peer_addr);
-			break;
-		}
-		else if (rv > 0)
-		{
-			assert(rv == 1);
-			if (pfd.revents == POLLIN)
-			{
-				if (__dpuServReceiveCommands(dclient->sockfd, dclient,
-											 dclient->peer_addr) < 0)
-					break;
-			}
-			else if (pfd.revents & ~POLLIN)
-			{
-				if (verbose)
-					fprintf(stderr, "[%s] peer socket closed\n", dclient->peer_addr);
-				break;
-			}
-		}
-	}
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_DEL, dclient->sockfd, NULL) != 0)
+		fprintf(stderr, "[%s] failed on epoll_ctl(EPOLL_CTL_DEL): %m\n",
+				dclient->peer_addr);
 	dclient->in_termination = true;
 	putDpuClient(dclient, 1);
 	if (verbose)
 		fprintf(stderr, "[%s] connection terminated\n", dclient->peer_addr);
-	return NULL;
+}
+
+/*
+ * dpuservAcceptClient
+ */
+static void
+dpuservAcceptClient(int epoll_fd, int serv_fd)
+{
+	union {
+		struct sockaddr		addr;
+		struct sockaddr_in	in;
+		struct sockaddr_in6	in6;
+	} peer;
+	socklen_t	peer_sz = sizeof(peer);
+	int			client_fd;
+	dpuClient  *dclient;
+	struct epoll_event epoll_ev;
+
+	client_fd = accept(serv_fd, &peer.addr, &peer_sz);
+	if (client_fd < 0)
+	{
+		if (errno != EINTR)
+			__Elog("failed on accept: %m");
+		return;
+	}
+	dclient = calloc(1, sizeof(dpuClient));
+	if (!dclient)
+		__Elog("out of memory: %m");
+	dclient->refcnt = 1;
+	pthreadMutexInit(&dclient->mutex);
+	dclient->sockfd = client_fd;
+	dclient->runq_index = (dpu_runq_next++ % dpu_runq_nums);
+	if (peer.addr.sa_family == AF_INET)
+	{
+		inet_ntop(peer.in.sin_family,
+				  &peer.in.sin_addr,
+				  dclient->peer_addr,
+				  PEER_ADDR_LEN);
+	}
+	else if (peer.addr.sa_family == AF_INET6)
+	{
+		inet_ntop(peer.in6.sin6_family,
+				  &peer.in6.sin6_addr,
+				  dclient->peer_addr,
+				  PEER_ADDR_LEN);
+	}
+	else
+	{
+		snprintf(dclient->peer_addr, PEER_ADDR_LEN,
+				 "Unknown DpuClient");
+	}
+	epoll_ev.events = EPOLLIN | EPOLLRDHUP;
+	epoll_ev.data.ptr = dclient;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, client_fd, &epoll_ev) != 0)
+	{
+		fprintf(stderr, "failed on epoll_ctl(EPOLL_CTL_ADD): %m\n");
+		close(client_fd);
+		free(dclient);
+		return;
+	}
+	pthreadMutexLock(&dpu_client_mutex);
+	dlist_push_tail(&dpu_client_list, &dclient->chain);
+	pthreadMutexUnlock(&dpu_client_mutex);
+	if (verbose)
+		fprintf(stderr, "[%s] connection start\n", dclient->peer_addr);
 }
 
 static void
@@ -2493,6 +3794,18 @@ dpuserv_signal_handler(int signum)
 	errno = errno_saved;
 }
 
+/*
+ * dpuserv_main
+ *
+ * A single event loop receives the commands from all the client sockets,
+ * the listen socket and stdin, then dispatches the commands to the per-core
+ * run queues. Socket reads are non-blocking unless an XpuCommand is arrived
+ * partially, so we don't need a receiver thread for each connection.
+ */
+#define DPUSERV_EPOLL_NEVENTS	64
+static char		dpuserv_epoll_listen;	/* marker of epoll_event */
+static char		dpuserv_epoll_stdin;	/* marker of epoll_event */
+
 static int
 dpuserv_main(struct sockaddr *addr, socklen_t addr_len)
 {
@@ -2500,12 +3813,26 @@ dpuserv_main(struct sockaddr *addr, socklen_t addr_len)
 	int			serv_fd;
 	int			epoll_fd;
 	struct epoll_event epoll_ev;
+	struct epoll_event epoll_events[DPUSERV_EPOLL_NEVENTS];
 
 	/* setup signal handler */
 	signal(SIGTERM, dpuserv_signal_handler);
 	signal(SIGUSR1, dpuserv_signal_handler);
 	signal(SIGPIPE, SIG_IGN);
 
+	/* setup run queues, one per CPU core */
+	dpu_runq_nums = Max(Min(sysconf(_SC_NPROCESSORS_ONLN),
+							dpuserv_num_workers), 1);
+	dpu_runq_array = calloc(dpu_runq_nums, sizeof(dpuRunQueue));
+	if (!dpu_runq_array)
+		__Elog("out of memory: %m");
+	for (uint32_t k=0; k < dpu_runq_nums; k++)
+	{
+		pthreadMutexInit(&dpu_runq_array[k].lock);
+		pthreadCondInit(&dpu_runq_array[k].cond);
+		dlist_init(&dpu_runq_array[k].cmd_list);
+	}
+
 	/* start worker threads */
 	dpuserv_workers = alloca(sizeof(pthread_t) * dpuserv_num_workers);
 	for (long i=0; i < dpuserv_num_workers; i++)
@@ -2529,114 +3856,86 @@ dpuserv_main(struct sockaddr *addr, socklen_t addr_len)
 	if (epoll_fd < 0)
 		__Elog("failed on epoll_create: %m");
 	epoll_ev.events = EPOLLIN;
-	epoll_ev.data.fd = serv_fd;
+	epoll_ev.data.ptr = &dpuserv_epoll_listen;
 	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, serv_fd, &epoll_ev) != 0)
 		__Elog("failed on epoll_ctl(EPOLL_CTL_ADD): %m");
 	epoll_ev.events = EPOLLIN | EPOLLRDHUP;
-	epoll_ev.data.fd = fileno(stdin);
+	epoll_ev.data.ptr = &dpuserv_epoll_stdin;
 	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fileno(stdin), &epoll_ev) != 0)
 		__Elog("failed on epoll_ctl(EPOLL_CTL_ADD): %m");
 	
 	while (!got_sigterm)
 	{
-		int		rv;
+		int		nevents;
 
-		rv = epoll_wait(epoll_fd, &epoll_ev, 1, 2000);
-		if (rv > 0)
+		nevents = epoll_wait(epoll_fd, epoll_events,
+							 DPUSERV_EPOLL_NEVENTS, 2000);
+		if (nevents < 0)
+		{
+			if (errno != EINTR)
+				__Elog("failed on epoll_wait(2): %m");
+			continue;
+		}
+		for (int i=0; i < nevents; i++)
 		{
-			assert(rv == 1);
-			if (epoll_ev.data.fd == serv_fd)
+			struct epoll_event *ev = &epoll_events[i];
+
+			if (ev->data.ptr == &dpuserv_epoll_listen)
 			{
-				union {
-					struct sockaddr		addr;
-					struct sockaddr_in	in;
-					struct sockaddr_in6	in6;
-				} peer;
-				socklen_t	peer_sz = sizeof(peer);
-				int			client_fd;
-
-				if ((epoll_ev.events & ~EPOLLIN) != 0)
+				if ((ev->events & ~EPOLLIN) != 0)
 					__Elog("listen socket raised unexpected error events (%08x): %m",
-						   epoll_ev.events);
-
-				client_fd = accept(serv_fd, &peer.addr, &peer_sz);
-				if (client_fd < 0)
-				{
-					if (errno != EINTR)
-						__Elog("failed on accept: %m");
-				}
-				else
-				{
-					dpuClient  *dclient;
-
-					dclient = calloc(1, sizeof(dpuClient));
-					if (!dclient)
-						__Elog("out of memory: %m");
-					dclient->refcnt = 1;
-					pthreadMutexInit(&dclient->mutex);
-					dclient->sockfd = client_fd;
-					if (peer.addr.sa_family == AF_INET)
-					{
-						inet_ntop(peer.in.sin_family,
-								  &peer.in.sin_addr,
-								  dclient->peer_addr,
-								  PEER_ADDR_LEN);
-					}
-					else if (peer.addr.sa_family == AF_INET6)
-					{
-						inet_ntop(peer.in6.sin6_family,
-								  &peer.in6.sin6_addr,
-								  dclient->peer_addr,
-								  PEER_ADDR_LEN);
-					}
-					else
-					{
-						snprintf(dclient->peer_addr, PEER_ADDR_LEN,
-								 "Unknown DpuClient");
-					}
-					pthreadMutexLock(&dpu_client_mutex);
-					if ((errno = pthread_create(&dclient->worker, NULL,
-												dpuservMonitorClient,
-												dclient)) == 0)
-					{
-						dlist_push_tail(&dpu_client_list,
-										&dclient->chain);
-					}
-					else
-					{
-						fprintf(stderr, "failed on pthread_create: %m\n");
-						close(client_fd);
-						free(dclient);
-					}
-					pthreadMutexUnlock(&dpu_client_mutex);
-				}
+						   ev->events);
+				dpuservAcceptClient(epoll_fd, serv_fd);
 			}
-			else
+			else if (ev->data.ptr == &dpuserv_epoll_stdin)
 			{
 				char	buffer[1024];
 				ssize_t	nbytes;
 
-				assert(epoll_ev.data.fd == fileno(stdin));
-				if ((epoll_ev.events & ~EPOLLIN) != 0)
+				if ((ev->events & ~EPOLLIN) != 0)
 					got_sigterm = true;
 				else
 				{
 					/* make stdin buffer empty */
-					nbytes = read(epoll_ev.data.fd, buffer, 1024);
+					nbytes = read(fileno(stdin), buffer, 1024);
 					if (nbytes < 0)
 						__Elog("failed on read(stdin): %m");
 				}
 			}
+			else
+			{
+				dpuClient  *dclient = ev->data.ptr;
+
+				if (dclient->in_termination)
+					dpuservCloseClient(epoll_fd, dclient);
+				else if (ev->events == EPOLLIN)
+				{
+					if (__dpuServReceiveCommands(dclient->sockfd, dclient,
+												 dclient->peer_addr) < 0)
+						dpuservCloseClient(epoll_fd, dclient);
+				}
+				else
+				{
+					if (verbose)
+						fprintf(stderr, "[%s] peer socket closed\n",
+								dclient->peer_addr);
+					dpuservCloseClient(epoll_fd, dclient);
+				}
+			}
 		}
-		else if (rv < 0 && errno != EINTR)
-			__Elog("failed on poll(2): %m");
 	}
 	close(serv_fd);
 
 	/* wait for completion of worker threads */
-	pthread_cond_broadcast(&dpu_command_cond);
+	for (uint32_t k=0; k < dpu_runq_nums; k++)
+	{
+		pthreadMutexLock(&dpu_runq_array[k].lock);
+		pthreadCondBroadcast(&dpu_runq_array[k].cond);
+		pthreadMutexUnlock(&dpu_runq_array[k].lock);
+	}
 	for (int i=0; i < dpuserv_num_workers; i++)
 		pthread_join(dpuserv_workers[i], NULL);
+	/* release the client sockets still alive */
 	pthreadMutexLock(&dpu_client_mutex);
 	while (!dlist_is_empty(&dpu_client_list))
 	{
@@ -2645,12 +3944,12 @@ dpuserv_main(struct sockaddr *addr, socklen_t addr_len)
 
 		pthreadMutexUnlock(&dpu_client_mutex);
 
-		pthread_kill(dclient->worker, SIGUSR1);
-		pthread_join(dclient->worker, NULL);
+		dpuservCloseClient(epoll_fd, dclient);
 
 		pthreadMutexLock(&dpu_client_mutex);
 	}
 	pthreadMutexUnlock(&dpu_client_mutex);
+	close(epoll_fd);
 	printf("OK terminate\n");
 	return 0;
 }
@@ -2666,6 +3965,10 @@ main(int argc, char *argv[])
 		{"identifier", required_argument, 0,  'i'},
 		{"log",        required_argument, 0,  'l'},
 		{"direct-io",  no_argument,       0, 1001},
+		{"cache-size", required_argument, 0, 1002},
+		{"readahead",  required_argument, 0, 1003},
+		{"inner-cache-size", required_argument, 0, 1004},
+		{"extension",  required_argument, 0, 1005},
 		{"verbose",    no_argument,       0,  'v'},
 		{"help",       no_argument,       0,  'h'},
 		{NULL, 0, 0, 0},
@@ -2676,9 +3979,6 @@ main(int argc, char *argv[])
 	/* init misc variables */
 	pthreadMutexInit(&dpu_client_mutex);
 	dlist_init(&dpu_client_list);
-	pthreadMutexInit(&dpu_command_mutex);
-	pthreadCondInit(&dpu_command_cond);
-	dlist_init(&dpu_command_list);
 
 	/* parse command line options */
 	for (;;)
@@ -2742,6 +4042,36 @@ main(int argc, char *argv[])
 				use_direct_io = true;
 				break;
 
+			case 1002:
+				dpuserv_cache_size = strtoul(optarg, &end, 10);
+				if (*optarg == '\0' || *end != '\0')
+					__Elog("cache size [%s] is not valid", optarg);
+				dpuserv_cache_size <<= 20;	/* MB */
+				break;
+
+			case 1003:
+				dpuserv_readahead_sz = strtoul(optarg, &end, 10);
+				if (*optarg == '\0' || *end != '\0')
+					__Elog("read-ahead size [%s] is not valid", optarg);
+				dpuserv_readahead_sz <<= 10;	/* kB */
+				break;
+
+			case 1004:
+				dpuserv_inner_cache_size = strtoul(optarg, &end, 10);
+				if (*optarg == '\0' || *end != '\0')
+					__Elog("inner cache size [%s] is not valid", optarg);
+				dpuserv_inner_cache_size <<= 20;	/* MB */
+				break;
+
+			case 1005:
+				dpuserv_extension_libs = realloc(dpuserv_extension_libs,
+												 sizeof(const char *) *
+												 (dpuserv_num_extension_libs + 1));
+				if (!dpuserv_extension_libs)
+					__Elog("out of memory");
+				dpuserv_extension_libs[dpuserv_num_extension_libs++] = optarg;
+				break;
+
 			case 'v':
 				verbose = true;
 				break;
@@ -2754,6 +4084,10 @@ main(int argc, char *argv[])
 					  "\t-i|--identifier=IDENT    security identifier\n"
 					  "\t-l|--log=LOGFILE         log file (default: stderr)\n"
 					  "\t   --direct-io           enables O_DIRECT (default: no)\n"
+					  "\t   --cache-size=MB       Arrow buffer cache size (default: 0)\n"
+					  "\t   --readahead=KB        sequential read-ahead (default: 8192)\n"
+					  "\t   --inner-cache-size=MB join inner buffer cache size (default: 1024)\n"
+					  "\t   --extension=LIBRARY   device functions supplied by extension\n"
 					  "\t-v|--verbose             verbose output\n"
 					  "\t-h|--help                shows this message\n",
 					  stderr);
@@ -2781,6 +4115,7 @@ main(int argc, char *argv[])
 	/* change the current working directory */
 	if (chdir(dpuserv_base_directory) != 0)
 		__Elog("failed on chdir('%s'): %m", dpuserv_base_directory);
+	dpuInnerCacheCleanup();
 	/* resolve host and port */
 	if (!dpuserv_listen_addr)
 	{
@@ -2816,6 +4151,14 @@ main(int argc, char *argv[])
 	__setupDevTypeLinkageTable(2 * TypeOpCode__BuiltInMax + 20);
 	__setupDevFuncLinkageTable(2 * FuncOpCode__BuiltInMax + 100);
 
+	pthreadMutexInit(&dpu_cache_lock);
+	dlist_init(&dpu_cache_lru);
+	for (int i=0; i < DPU_CACHE_HASHSZ; i++)
+		dlist_init(&dpu_cache_hash[i]);
+
+	pthreadMutexInit(&dpu_inner_cache_lock);
+	dlist_init(&dpu_inner_cache_lru);
+
 	pthreadMutexInit(&groupby_final_buffer_lock);
 	for (int i=0; i < GROUPBY_FINAL_BUFFER_HASHSZ; i++)
 		dlist_init(&groupby_final_buffer_hash[i]);
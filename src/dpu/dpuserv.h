@@ -12,9 +12,11 @@
 #ifndef DPUSERV_H
 #define DPUSERV_H
 #include <assert.h>
+#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <getopt.h>
+#include <math.h>
 #include <poll.h>
 #include <pthread.h>
 #include <stdlib.h>
@@ -86,6 +88,15 @@ dlist_is_empty(dlist_head *head)
 			head->head.prev == &(head->head));
 }
 
+static inline void
+dlist_push_head(dlist_head *head, dlist_node *node)
+{
+	node->next = head->head.next;
+	node->prev = &head->head;
+	node->next->prev = node;
+	head->head.next = node;
+}
+
 static inline void
 dlist_push_tail(dlist_head *head, dlist_node *node)
 {
@@ -180,6 +191,28 @@ pthreadCondWait(pthread_cond_t *cond, pthread_mutex_t *mutex)
 		__Elog("failed on pthread_cond_wait: %m");
 }
 
+static inline bool
+pthreadCondWaitTimeout(pthread_cond_t *cond, pthread_mutex_t *mutex,
+					   long timeout_ms)
+{
+	struct timespec tm;
+
+	clock_gettime(CLOCK_REALTIME, &tm);
+	tm.tv_sec  += (timeout_ms / 1000);
+	tm.tv_nsec += (timeout_ms % 1000) * 1000000;
+	if (tm.tv_nsec >= 1000000000L)
+	{
+		tm.tv_sec += tm.tv_nsec / 1000000000;
+		tm.tv_nsec = tm.tv_nsec % 1000000000;
+	}
+	errno = pthread_cond_timedwait(cond, mutex, &tm);
+	if (errno == 0)
+		return true;
+	else if (errno == ETIMEDOUT)
+		return false;
+	__Elog("failed on pthread_cond_timedwait: %m");
+}
+
 static inline void
 pthreadCondBroadcast(pthread_cond_t *cond)
 {
@@ -0,0 +1 @@
+../xpu_bench.cu
\ No newline at end of file
@@ -11,6 +11,9 @@
  */
 #include "pg_strom.h"
 #include <netdb.h>
+#ifdef HAVE_LIBLZ4
+#include <lz4frame.h>
+#endif
 
 static char	   *pgstrom_dpu_endpoint_list;	/* GUC */
 static int		pgstrom_dpu_endpoint_default_port;	/* GUC */
@@ -19,12 +22,16 @@ static int		pgstrom_dpu_endpoint_default_port;	/* GUC */
 #define DEFAULT_DPU_OPERATOR_COST	(1.2 * DEFAULT_CPU_OPERATOR_COST)
 #define DEFAULT_DPU_SEQ_PAGE_COST	(DEFAULT_SEQ_PAGE_COST / 4)
 #define DEFAULT_DPU_TUPLE_COST		(DEFAULT_CPU_TUPLE_COST)
+#define DPU_ENDPOINT_RETRY_INTERVAL	30		/* seconds */
 
 double		pgstrom_dpu_setup_cost    = DEFAULT_DPU_SETUP_COST;		/* GUC */
 double		pgstrom_dpu_operator_cost = DEFAULT_DPU_OPERATOR_COST;	/* GUC */
 double		pgstrom_dpu_seq_page_cost = DEFAULT_DPU_SEQ_PAGE_COST;	/* GUC */
 double		pgstrom_dpu_tuple_cost    = DEFAULT_DPU_TUPLE_COST;		/* GUC */
 bool		pgstrom_dpu_handle_cached_pages = false;	/* GUC */
+bool		pgstrom_dpu_inner_cache = true;				/* GUC */
+static bool	pgstrom_dpu_inner_cache_compression = true;	/* GUC */
+#define DPU_INNER_IMAGE_UNITSZ		(4UL << 20)		/* 4MB */
 
 struct DpuStorageEntry
 {
@@ -36,9 +43,18 @@ struct DpuStorageEntry
 	const struct sockaddr *endpoint_addr;
 	socklen_t	endpoint_addr_len;
 	struct stat	endpoint_stat_buf;
-	pg_atomic_uint32 *validated;	/* shared memory */
+	pg_atomic_uint32 *validated;	/* shared memory; 0 = healthy, elsewhere
+									 * time(2) when it was marked unhealthy */
+	pg_atomic_uint32 *nsessions;	/* shared memory; number of sessions
+									 * currently connected */
 };
 
+typedef struct
+{
+	pg_atomic_uint32 validated;
+	pg_atomic_uint32 nsessions;
+} DpuStorageShared;
+
 typedef struct
 {
 	uint32_t	nitems;
@@ -49,6 +65,79 @@ static DpuStorageArray		   *dpu_storage_master_array = NULL;
 static shmem_request_hook_type	shmem_request_next = NULL;
 static shmem_startup_hook_type	shmem_startup_next = NULL;
 
+/*
+ * __dpuStorageEntryIsHealthy
+ *
+ * An endpoint marked unhealthy is skipped until DPU_ENDPOINT_RETRY_INTERVAL
+ * elapsed, then next session tries to connect it again.
+ */
+static bool
+__dpuStorageEntryIsHealthy(const DpuStorageEntry *ds_entry)
+{
+	uint32_t	tv = pg_atomic_read_u32(ds_entry->validated);
+
+	if (tv == 0)
+		return true;
+	return ((uint32_t)time(NULL) - tv >= DPU_ENDPOINT_RETRY_INTERVAL);
+}
+
+/*
+ * __dpuStorageEntryIsReplica
+ *
+ * Endpoints that expose the same directory (same device and inode) are
+ * replicas of each other; any of them can process the files underlying.
+ */
+static bool
+__dpuStorageEntryIsReplica(DpuStorageEntry *ds_entry1,
+						   DpuStorageEntry *ds_entry2)
+{
+	if (ds_entry1 == ds_entry2)
+		return true;
+	if (ds_entry1->endpoint_stat_buf.st_mode == 0)
+		stat(ds_entry1->endpoint_dir, &ds_entry1->endpoint_stat_buf);
+	if (ds_entry2->endpoint_stat_buf.st_mode == 0)
+		stat(ds_entry2->endpoint_dir, &ds_entry2->endpoint_stat_buf);
+	if (ds_entry1->endpoint_stat_buf.st_mode == 0 ||
+		ds_entry2->endpoint_stat_buf.st_mode == 0)
+		return (strcmp(ds_entry1->endpoint_dir,
+					   ds_entry2->endpoint_dir) == 0);
+	return (ds_entry1->endpoint_stat_buf.st_dev ==
+			ds_entry2->endpoint_stat_buf.st_dev &&
+			ds_entry1->endpoint_stat_buf.st_ino ==
+			ds_entry2->endpoint_stat_buf.st_ino);
+}
+
+/*
+ * __pickupLeastLoadedDpuReplica
+ *
+ * It picks up the healthy replica of the primary endpoint with the least
+ * number of running sessions, except for the already tried ones.
+ */
+static DpuStorageEntry *
+__pickupLeastLoadedDpuReplica(const DpuStorageEntry *primary, bool *tried)
+{
+	DpuStorageEntry *ds_entry = NULL;
+	uint32_t	nsessions = UINT_MAX;
+
+	for (int i=0; i < dpu_storage_master_array->nitems; i++)
+	{
+		DpuStorageEntry *curr = &dpu_storage_master_array->entries[i];
+		uint32_t	__nsessions;
+
+		if ((tried && tried[i]) ||
+			!__dpuStorageEntryIsReplica((DpuStorageEntry *)primary, curr) ||
+			!__dpuStorageEntryIsHealthy(curr))
+			continue;
+		__nsessions = pg_atomic_read_u32(curr->nsessions);
+		if (!ds_entry || __nsessions < nsessions)
+		{
+			ds_entry = curr;
+			nsessions = __nsessions;
+		}
+	}
+	return ds_entry;
+}
+
 /*
  * GetOptimalDpuForFile
  */
@@ -233,15 +322,33 @@ GetOptimalDpuForBaseRel(PlannerInfo *root, RelOptInfo *baserel)
 									&rte->relid,
 									HASH_FIND,
 									NULL)) != NULL)
-			return drc_item->ds_entry;
-
-		relation = table_open(rte->relid, AccessShareLock);
-		ds_entry = GetOptimalDpuForRelation(relation, NULL);
-		table_close(relation, NoLock);
+			ds_entry = drc_item->ds_entry;
+		else
+		{
+			relation = table_open(rte->relid, AccessShareLock);
+			ds_entry = GetOptimalDpuForRelation(relation, NULL);
+			table_close(relation, NoLock);
+		}
 	}
+	/* no DPU plan, if all the replicas are unavailable right now */
+	if (!DpuStorageEntryIsAvailable(ds_entry))
+		return NULL;
 	return ds_entry;
 }
 
+/*
+ * DpuStorageEntryIsAvailable
+ *
+ * It checks whether the endpoint or any of its replicas are healthy.
+ */
+bool
+DpuStorageEntryIsAvailable(const DpuStorageEntry *ds_entry)
+{
+	if (!ds_entry || !dpu_storage_master_array)
+		return false;
+	return (__pickupLeastLoadedDpuReplica(ds_entry, NULL) != NULL);
+}
+
 /*
  * DpuStorageEntryBaseDir
  */
@@ -302,34 +409,204 @@ DpuStorageEntryCount(void)
 }
 
 /*
- * DpuClientOpenSession 
+ * DpuClientOpenSession
+ *
+ * It connects to the least-loaded healthy replica of pts->ds_entry.
+ * An endpoint which refused the connection is marked unhealthy, then
+ * the next replica shall be tried.
  */
 void
 DpuClientOpenSession(pgstromTaskState *pts,
 					 const XpuCommand *session)
 {
-	const DpuStorageEntry *ds_entry = pts->ds_entry;
-    pgsocket    sockfd;
-    char        namebuf[32];
+	const DpuStorageEntry *primary = pts->ds_entry;
+	DpuStorageEntry *ds_entry;
+	bool	   *tried;
+	pgsocket	sockfd;
+	char		namebuf[32];
 
-	if (!ds_entry)
+	if (!primary)
 		elog(ERROR, "Bug? no DPU device is configured");
 
-	sockfd = socket(ds_entry->endpoint_domain, SOCK_STREAM, 0);
-	if (sockfd < 0)
-		elog(ERROR, "failed on socket(2) dom=%d: %m", ds_entry->endpoint_domain);
-	if (connect(sockfd,
-				ds_entry->endpoint_addr,
-				ds_entry->endpoint_addr_len) != 0)
+	tried = alloca(sizeof(bool) * dpu_storage_master_array->nitems);
+	memset(tried, 0, sizeof(bool) * dpu_storage_master_array->nitems);
+	for (;;)
 	{
+		ds_entry = __pickupLeastLoadedDpuReplica(primary, tried);
+		if (!ds_entry)
+			elog(ERROR, "no healthy DPU endpoint is available for '%s'",
+				 primary->endpoint_dir);
+		tried[ds_entry->endpoint_id] = true;
+
+		sockfd = socket(ds_entry->endpoint_domain, SOCK_STREAM, 0);
+		if (sockfd < 0)
+			elog(ERROR, "failed on socket(2) dom=%d: %m",
+				 ds_entry->endpoint_domain);
+		if (connect(sockfd,
+					ds_entry->endpoint_addr,
+					ds_entry->endpoint_addr_len) == 0)
+			break;
+		elog(LOG, "DPU%u: failed on connect('%s'): %m, marked as unhealthy",
+			 ds_entry->endpoint_id, ds_entry->config_host);
 		close(sockfd);
-		elog(ERROR, "failed on connect('%s'): %m", ds_entry->config_host);
+		pg_atomic_write_u32(ds_entry->validated,
+							Max((uint32_t)time(NULL), 1));
 	}
-	snprintf(namebuf, sizeof(namebuf), "DPU-%u", ds_entry->endpoint_id);
+	/* ok, the endpoint is alive */
+	if (pg_atomic_read_u32(ds_entry->validated) != 0)
+		pg_atomic_write_u32(ds_entry->validated, 0);
+	pg_atomic_fetch_add_u32(ds_entry->nsessions, 1);
+	pts->ds_entry = ds_entry;
 
+	snprintf(namebuf, sizeof(namebuf), "DPU-%u", ds_entry->endpoint_id);
 	__xpuClientOpenSession(pts, session, sockfd, namebuf, ds_entry->endpoint_id);
 }
 
+/*
+ * DpuClientCloseSession
+ */
+void
+DpuClientCloseSession(int endpoint_id)
+{
+	const DpuStorageEntry *ds_entry = DpuStorageEntryByEndpointId(endpoint_id);
+
+	if (ds_entry)
+	{
+		Assert(pg_atomic_read_u32(ds_entry->nsessions) > 0);
+		pg_atomic_fetch_sub_u32(ds_entry->nsessions, 1);
+	}
+}
+
+/*
+ * __writeInnerImageLZ4
+ */
+#ifdef HAVE_LIBLZ4
+static void
+__writeInnerImageChunk(int fdesc, const char *fname,
+					   LZ4F_cctx *cctx, const char *buf, size_t sz)
+{
+	if (LZ4F_isError(sz))
+	{
+		LZ4F_freeCompressionContext(cctx);
+		elog(ERROR, "failed on LZ4F compression of '%s': %s",
+			 fname, LZ4F_getErrorName(sz));
+	}
+	if (__writeFile(fdesc, buf, sz) != sz)
+	{
+		LZ4F_freeCompressionContext(cctx);
+		elog(ERROR, "failed on __writeFile('%s'): %m", fname);
+	}
+}
+
+static void
+__writeInnerImageLZ4(int fdesc, const char *fname,
+					 const kern_multirels *h_kmrels)
+{
+	LZ4F_cctx  *cctx;
+	LZ4F_errorCode_t rc;
+	const char *pos = (const char *)h_kmrels;
+	size_t		remained = h_kmrels->length;
+	size_t		bufsz = LZ4F_compressBound(DPU_INNER_IMAGE_UNITSZ, NULL);
+	char	   *buf = palloc(bufsz);
+	size_t		sz;
+
+	rc = LZ4F_createCompressionContext(&cctx, LZ4F_VERSION);
+	if (LZ4F_isError(rc))
+		elog(ERROR, "failed on LZ4F_createCompressionContext: %s",
+			 LZ4F_getErrorName(rc));
+	sz = LZ4F_compressBegin(cctx, buf, bufsz, NULL);
+	__writeInnerImageChunk(fdesc, fname, cctx, buf, sz);
+	while (remained > 0)
+	{
+		size_t	unitsz = Min(remained, DPU_INNER_IMAGE_UNITSZ);
+
+		sz = LZ4F_compressUpdate(cctx, buf, bufsz, pos, unitsz, NULL);
+		__writeInnerImageChunk(fdesc, fname, cctx, buf, sz);
+		pos += unitsz;
+		remained -= unitsz;
+	}
+	sz = LZ4F_compressEnd(cctx, buf, bufsz, NULL);
+	__writeInnerImageChunk(fdesc, fname, cctx, buf, sz);
+	LZ4F_freeCompressionContext(cctx);
+	pfree(buf);
+}
+#endif
+
+/*
+ * DpuInnerCachePublish
+ *
+ * It writes out the read-only inner buffer image on the directory of the DPU
+ * endpoint, unless the image with the same digest already exists, because
+ * the DPU service keeps the loaded image as long as the file exists.
+ */
+void
+DpuInnerCachePublish(const DpuStorageEntry *ds_entry,
+					 uint64_t digest,
+					 const kern_multirels *h_kmrels)
+{
+	kern_inner_image head;
+	char		fname[MAXPGPATH];
+	char		tname[MAXPGPATH];
+	struct stat	stat_buf;
+	volatile int fdesc = -1;
+
+	snprintf(fname, sizeof(fname), "%s/%s%016lx",
+			 ds_entry->endpoint_dir,
+			 KERN_INNER_IMAGE_PREFIX, digest);
+	if (stat(fname, &stat_buf) == 0)
+	{
+		elog(DEBUG2, "DPU%u: inner image '%s' is already published",
+			 ds_entry->endpoint_id, fname);
+		return;
+	}
+	if (errno != ENOENT)
+		elog(ERROR, "failed on stat('%s'): %m", fname);
+
+	snprintf(tname, sizeof(tname), "%s.%d.tmp", fname, MyProcPid);
+	fdesc = open(tname, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if (fdesc < 0)
+		elog(ERROR, "failed on open('%s'): %m", tname);
+	PG_TRY();
+	{
+		memset(&head, 0, sizeof(kern_inner_image));
+		head.magic = KERN_INNER_IMAGE_MAGIC;
+		head.codec = KERN_INNER_IMAGE_CODEC__NONE;
+		head.digest = digest;
+		head.raw_length = h_kmrels->length;
+#ifdef HAVE_LIBLZ4
+		if (pgstrom_dpu_inner_cache_compression)
+			head.codec = KERN_INNER_IMAGE_CODEC__LZ4;
+#endif
+		if (__writeFile(fdesc, &head, sizeof(kern_inner_image)) != sizeof(kern_inner_image))
+			elog(ERROR, "failed on __writeFile('%s'): %m", tname);
+#ifdef HAVE_LIBLZ4
+		if (head.codec == KERN_INNER_IMAGE_CODEC__LZ4)
+			__writeInnerImageLZ4(fdesc, tname, h_kmrels);
+		else
+#endif
+		if (__writeFile(fdesc, h_kmrels, h_kmrels->length) != h_kmrels->length)
+			elog(ERROR, "failed on __writeFile('%s'): %m", tname);
+		if (close(fdesc) != 0)
+		{
+			fdesc = -1;
+			elog(ERROR, "failed on close('%s'): %m", tname);
+		}
+		fdesc = -1;
+		if (rename(tname, fname) != 0)
+			elog(ERROR, "failed on rename('%s' -> '%s'): %m", tname, fname);
+	}
+	PG_CATCH();
+	{
+		if (fdesc >= 0)
+			close(fdesc);
+		unlink(tname);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	elog(DEBUG2, "DPU%u: inner image '%s' (%zu bytes) is published",
+		 ds_entry->endpoint_id, fname, h_kmrels->length);
+}
+
 /*
  * explainDpuStorageEntry
  */
@@ -455,7 +732,7 @@ pgstrom_request_dpu_device(void)
 {
 	if (shmem_request_next)
 		shmem_request_next();
-	RequestAddinShmemSpace(MAXALIGN(sizeof(pg_atomic_uint32) *
+	RequestAddinShmemSpace(MAXALIGN(sizeof(DpuStorageShared) *
 									dpu_storage_master_array->nitems));
 }
 
@@ -465,19 +742,27 @@ pgstrom_request_dpu_device(void)
 static void
 pgstrom_startup_dpu_device(void)
 {
-	pg_atomic_uint32 *validated;
+	DpuStorageShared *ds_shared;
 	uint32_t	nitems = dpu_storage_master_array->nitems;
 	bool		found;
 
 	if (shmem_startup_next)
 		shmem_startup_next();
 	Assert(nitems > 0);
-	validated = ShmemInitStruct("DPU-Tablespace Info",
-								sizeof(pg_atomic_uint32) * nitems,
+	ds_shared = ShmemInitStruct("DPU-Tablespace Info",
+								sizeof(DpuStorageShared) * nitems,
 								&found);
 	for (int i=0; i < dpu_storage_master_array->nitems; i++)
 	{
-		dpu_storage_master_array->entries[i].validated = &validated[i];
+		DpuStorageEntry *ds_entry = &dpu_storage_master_array->entries[i];
+
+		if (!found)
+		{
+			pg_atomic_init_u32(&ds_shared[i].validated, 0);
+			pg_atomic_init_u32(&ds_shared[i].nsessions, 0);
+		}
+		ds_entry->validated = &ds_shared[i].validated;
+		ds_entry->nsessions = &ds_shared[i].nsessions;
 	}
 }
 
@@ -553,6 +838,24 @@ pgstrom_init_dpu_options(void)
 							 PGC_USERSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* control whether DPU service caches the inner buffer */
+	DefineCustomBoolVariable("pg_strom.dpu_inner_cache",
+							 "Enables to publish the inner buffer to DPUs by its content digest, to be reused by the DPU service",
+							 NULL,
+							 &pgstrom_dpu_inner_cache,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* control whether the inner image is compressed */
+	DefineCustomBoolVariable("pg_strom.dpu_inner_cache_compression",
+							 "Enables LZ4 compression of the inner buffer image published to DPUs",
+							 NULL,
+							 &pgstrom_dpu_inner_cache_compression,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 }
 
 /*
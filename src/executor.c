@@ -30,6 +30,7 @@ struct XpuConnection
 	int				num_ready_cmds;
 	dlist_head		ready_cmds_list;	/* ready, but not fetched yet  */
 	dlist_head		active_cmds_list;	/* currently in-use */
+	xpuStagingRing *staging_ring;		/* staged responses, if any */
 	kern_errorbuf	errorbuf;
 };
 
@@ -39,6 +40,18 @@ extern TransactionId   *ParallelCurrentXids;
 
 /* static variables */
 static dlist_head		xpu_connections_list;
+static int				pgstrom_scan_prefetch_depth;	/* GUC */
+static int				pgstrom_gpu_mem_quota_mb;		/* GUC */
+static bool				pgstrom_enable_columnar_projection;	/* GUC */
+static bool				pgstrom_enable_columnar_dictionary;	/* GUC */
+static bool				pgstrom_enable_adaptive_exec;	/* GUC */
+static double			pgstrom_adaptive_fallback_threshold;	/* GUC */
+static int				pgstrom_cpu_direct_scan_threshold;	/* GUC */
+#define ADAPTIVE_EXEC_MIN_CHUNKS		8
+#define ADAPTIVE_EXEC_PROBE_INTERVAL	32
+static bool				pgstrom_enable_adaptive_chunk_size;	/* GUC */
+#define ADAPTIVE_CHUNK_MIN_NBLOCKS		64
+static int				pgstrom_gpu_scan_max_devices;	/* GUC */
 
 /*
  * Worker thread to receive response messages
@@ -49,11 +62,68 @@ __xpuConnectAllocCommand(void *__priv, size_t sz)
 	return malloc(sz);
 }
 
+static inline bool
+__xpuConnectIsStagedCommand(XpuConnection *conn, XpuCommand *xcmd)
+{
+	xpuStagingRing *ring = conn->staging_ring;
+
+	return (ring != NULL &&
+			(char *)xcmd >= (char *)ring &&
+			(char *)xcmd <  (char *)ring + XPU_STAGING_RING_LENGTH(ring->nslots));
+}
+
+static void
+__xpuConnectFreeCommand(XpuConnection *conn, XpuCommand *xcmd)
+{
+	if (__xpuConnectIsStagedCommand(conn, xcmd))
+	{
+		xpuStagingRing *ring = conn->staging_ring;
+		size_t		slot_id = (((char *)xcmd - (char *)ring -
+								XPU_STAGING_RING_HEADSZ(ring->nslots)) /
+							   ring->slot_sz);
+		/* release the slot for the next command */
+		pg_atomic_write_u32(&ring->slot_busy[slot_id], 0);
+	}
+	else
+		free(xcmd);
+}
+
 static void
 __xpuConnectAttachCommand(void *__priv, XpuCommand *xcmd)
 {
 	XpuConnection *conn = __priv;
 
+	/*
+	 * GPU service put the response on the staging ring, so the results
+	 * are referenced in-place, instead of the copy over the socket.
+	 */
+	if (xcmd->tag == XpuCommandTag__ResponseStaged)
+	{
+		xpuStagingRing *ring = conn->staging_ring;
+		uint32_t	slot_id = xcmd->u.staged.slot_id;
+
+		free(xcmd);
+		if (!ring || slot_id >= ring->nslots)
+		{
+			pthreadMutexLock(&conn->mutex);
+			conn->num_running_cmds--;
+			if (conn->errorbuf.errcode == ERRCODE_STROM_SUCCESS)
+			{
+				conn->errorbuf.errcode = ERRCODE_INTERNAL_ERROR;
+				conn->errorbuf.lineno = __LINE__;
+				strncpy(conn->errorbuf.filename, __FILE_NAME__,
+						KERN_ERRORBUF_FILENAME_LEN);
+				strncpy(conn->errorbuf.funcname, __FUNCTION__,
+						KERN_ERRORBUF_FUNCNAME_LEN);
+				snprintf(conn->errorbuf.message, KERN_ERRORBUF_MESSAGE_LEN,
+						 "invalid staging ring slot (%u)", slot_id);
+			}
+			SetLatch(MyLatch);
+			pthreadMutexUnlock(&conn->mutex);
+			return;
+		}
+		xcmd = XPU_STAGING_RING_SLOT(ring, slot_id);
+	}
 	xcmd->priv = conn;
 	pthreadMutexLock(&conn->mutex);
 	Assert(conn->num_running_cmds > 0);
@@ -65,7 +135,7 @@ __xpuConnectAttachCommand(void *__priv, XpuCommand *xcmd)
 			Assert(xcmd->u.error.errcode != ERRCODE_STROM_SUCCESS);
 			memcpy(&conn->errorbuf, &xcmd->u.error, sizeof(kern_errorbuf));
 		}
-		free(xcmd);
+		__xpuConnectFreeCommand(conn, xcmd);
 	}
 	else
 	{
@@ -208,6 +278,28 @@ xpuClientSendCommandIOV(XpuConnection *conn, struct iovec *iov, int iovcnt)
 	}
 }
 
+/*
+ * xpuClientCancelTasks
+ *
+ * It sends XpuTaskCancel to the xPU service; no response is returned,
+ * so it is not counted as a running command.
+ */
+void
+xpuClientCancelTasks(XpuConnection *conn)
+{
+	XpuCommand	xcmd;
+
+	memset(&xcmd, 0, sizeof(XpuCommand));
+	xcmd.magic  = XpuCommandMagicNumber;
+	xcmd.tag    = XpuCommandTag__XpuTaskCancel;
+	xcmd.length = offsetof(XpuCommand, u);
+
+	xpuClientSendCommand(conn, &xcmd);
+	pthreadMutexLock(&conn->mutex);
+	conn->num_running_cmds--;
+	pthreadMutexUnlock(&conn->mutex);
+}
+
 /*
  * xpuClientPutResponse
  */
@@ -219,7 +311,7 @@ xpuClientPutResponse(XpuCommand *xcmd)
 	pthreadMutexLock(&conn->mutex);
 	dlist_delete(&xcmd->chain);
 	pthreadMutexUnlock(&conn->mutex);
-	free(xcmd);
+	__xpuConnectFreeCommand(conn, xcmd);
 }
 
 /*
@@ -242,14 +334,17 @@ xpuClientCloseSession(XpuConnection *conn)
 	{
 		dnode = dlist_pop_head_node(&conn->ready_cmds_list);
 		xcmd = dlist_container(XpuCommand, chain, dnode);
-		free(xcmd);
+		__xpuConnectFreeCommand(conn, xcmd);
 	}
 	while (!dlist_is_empty(&conn->active_cmds_list))
 	{
 		dnode = dlist_pop_head_node(&conn->active_cmds_list);
 		xcmd = dlist_container(XpuCommand, chain, dnode);
-		free(xcmd);
+		__xpuConnectFreeCommand(conn, xcmd);
 	}
+	/* release the load counter of DPU endpoint */
+	if (strncmp(conn->devname, "DPU-", 4) == 0)
+		DpuClientCloseSession(conn->dev_index);
 	dlist_delete(&conn->chain);
 	free(conn);
 }
@@ -435,7 +530,7 @@ __setup_session_kvars_defs_array(kern_varslot_desc *vslot_desc_root,
 													 vslot_desc_base,
 													 kvdef->kv_subfields);
 			vs_desc->idx_subfield = (vslot_desc_base - vslot_desc_root);
-			vs_desc->num_subfield = count;
+			vs_desc->num_subfield = list_length(kvdef->kv_subfields);
 
 			vslot_desc_base += count;
 			nitems += count;
@@ -488,6 +583,29 @@ __build_session_xact_state(StringInfo buf)
 	return __appendBinaryStringInfo(buf, buffer, bufsz);
 }
 
+static uint32_t
+__build_session_snapshot(StringInfo buf, Snapshot snapshot)
+{
+	kern_snapshot_info *ksnap;
+	uint32_t	nitems = snapshot->xcnt + Max(snapshot->subxcnt, 0);
+	size_t		sz = offsetof(kern_snapshot_info, xip[nitems]);
+
+	ksnap = alloca(sz);
+	memset(ksnap, 0, sz);
+	ksnap->xmin = snapshot->xmin;
+	ksnap->xmax = snapshot->xmax;
+	ksnap->xcnt = snapshot->xcnt;
+	ksnap->subxcnt = Max(snapshot->subxcnt, 0);
+	ksnap->suboverflowed = snapshot->suboverflowed;
+	if (snapshot->xcnt > 0)
+		memcpy(ksnap->xip, snapshot->xip,
+			   sizeof(TransactionId) * snapshot->xcnt);
+	if (snapshot->subxcnt > 0)
+		memcpy(ksnap->xip + snapshot->xcnt, snapshot->subxip,
+			   sizeof(TransactionId) * snapshot->subxcnt);
+	return __appendBinaryStringInfo(buf, ksnap, sz);
+}
+
 static uint32_t
 __build_session_timezone(StringInfo buf)
 {
@@ -525,6 +643,49 @@ __build_session_lconvert(kern_session_info *session)
 	session->session_currency_frac_digits = lconvert->frac_digits;
 }
 
+/*
+ * __estimateGroupByFinalLength
+ *
+ * It estimates the initial length of kds_final by the number of groups.
+ * Expansion of kds_final needs suspend/resume of the GPU kernel and copy
+ * of the buffer, so high-cardinality GROUP BY prefers the large buffer
+ * from the beginning. Each tuple occupies at least one L1 cache line.
+ */
+static size_t
+__estimateGroupByFinalLength(pgstromTaskState *pts,
+							 TupleDesc groupby_tdesc_final,
+							 double n_groups,
+							 uint32_t hash_nslots)
+{
+	Plan	   *plan = pts->css.ss.ps.plan;
+	size_t		tupsz;
+	size_t		limit = __KDS_LENGTH_LIMIT;
+	double		length;
+	int			k;
+
+	tupsz = TYPEALIGN(CUDA_L1_CACHELINE_SZ,
+					  offsetof(kern_hashitem, t.htup) +
+					  MAXALIGN(offsetof(HeapTupleHeaderData, t_bits) +
+							   BITMAPLEN(groupby_tdesc_final->natts)) +
+					  MAXALIGN(plan->plan_width));
+	length = (estimate_kern_data_store(groupby_tdesc_final) +
+			  sizeof(uint32_t) * ((double)hash_nslots + n_groups) +
+			  (double)tupsz * n_groups) * 1.25;
+	/* managed memory can be oversubscribed, but up to half of the device */
+	for (k = bms_next_member(pts->optimal_gpus, -1);
+		 k >= 0;
+		 k = bms_next_member(pts->optimal_gpus, k))
+	{
+		if (k < numGpuDevAttrs)
+			limit = Min(limit, gpuDevAttrs[k].DEV_TOTAL_MEMSZ / 2);
+	}
+	if (length < (double)(1UL << 30))
+		return (1UL << 30);		/* 1GB at least */
+	if (length > (double)limit)
+		return Max(TYPEALIGN_DOWN(PAGE_SIZE, limit), (1UL << 30));
+	return PAGE_ALIGN((size_t)length);
+}
+
 const XpuCommand *
 pgstromBuildSessionInfo(pgstromTaskState *pts,
 						uint32_t join_inner_handle,
@@ -590,6 +751,14 @@ pgstromBuildSessionInfo(pgstromTaskState *pts,
 									 VARDATA(xpucode),
 									 VARSIZE(xpucode) - VARHDRSZ);
 	}
+	if (pp_info->kexp_hash_inner_packed)
+	{
+		xpucode = pp_info->kexp_hash_inner_packed;
+		session->xpucode_hash_inner_packed =
+			__appendBinaryStringInfo(&buf,
+									 VARDATA(xpucode),
+									 VARSIZE(xpucode) - VARHDRSZ);
+	}
 	if (pp_info->kexp_gist_evals_packed)
 	{
 		xpucode = pp_info->kexp_gist_evals_packed;
@@ -598,6 +767,14 @@ pgstromBuildSessionInfo(pgstromTaskState *pts,
 									 VARDATA(xpucode),
 									 VARSIZE(xpucode) - VARHDRSZ);
 	}
+	if (pp_info->kexp_range_keys_packed)
+	{
+		xpucode = pp_info->kexp_range_keys_packed;
+		session->xpucode_range_keys_packed =
+			__appendBinaryStringInfo(&buf,
+									 VARDATA(xpucode),
+									 VARSIZE(xpucode) - VARHDRSZ);
+	}
 	if (pp_info->kexp_projection)
 	{
 		xpucode = pp_info->kexp_projection;
@@ -652,6 +829,12 @@ pgstromBuildSessionInfo(pgstromTaskState *pts,
 		{
 			double	n_groups = pts->css.ss.ps.plan->plan_rows;
 
+			/* kds_final shared by siblings also keeps their groups */
+			if (pp_info->groupby_nsiblings > 1)
+				n_groups *= (double)pp_info->groupby_nsiblings;
+			/* streaming kds_final keeps the groups of a chunk only */
+			if (pp_info->groupby_streaming)
+				n_groups = Min(n_groups, 5000.0);
 			format = KDS_FORMAT_HASH;
 			if (n_groups <= 5000.0)
 				hash_nslots = 20000;
@@ -659,30 +842,105 @@ pgstromBuildSessionInfo(pgstromTaskState *pts,
 				hash_nslots = 20000 + (int)(2.0 * n_groups);
 			else
 				hash_nslots = 8020000 + n_groups;
-			kds_length = (1UL << 30);			/* 1GB */
+			kds_length = __estimateGroupByFinalLength(pts, groupby_tdesc_final,
+													  n_groups, hash_nslots);
 		}
 		setup_kern_data_store(kds_temp, groupby_tdesc_final, kds_length, format);
 		kds_temp->hash_nslots = hash_nslots;
 		session->groupby_kds_final = __appendBinaryStringInfo(&buf, kds_temp, sz);
 		session->groupby_prepfn_bufsz = pp_info->groupby_prepfn_bufsz;
 		session->groupby_ngroups_estimation = pts->css.ss.ps.plan->plan_rows;
+		session->groupby_nsiblings = pp_info->groupby_nsiblings;
+		session->groupby_streaming = pp_info->groupby_streaming;
 	}
+	/* GPU top-k for ORDER BY ... LIMIT */
+	session->gpusort_limit = pp_info->gpusort_limit;
+	session->gpusort_resno = pp_info->gpusort_resno;
+	session->gpusort_kind  = pp_info->gpusort_kind;
+	session->gpusort_desc  = pp_info->gpusort_desc;
+	session->gpusort_nulls_first = pp_info->gpusort_nulls_first;
+	/* GPU window functions */
+	if (pp_info->gpuwin_desc)
+		session->gpuwin_desc = __appendBinaryStringInfo(&buf,
+														VARDATA(pp_info->gpuwin_desc),
+														VARSIZE(pp_info->gpuwin_desc) - VARHDRSZ);
 	/* other database session information */
-	session->query_plan_id = ps_state->query_plan_id;
+	/*
+	 * hash-batched GpuJoin needs a distinct inner buffer for each batch,
+	 * and partition-wise siblings that share the inner buffer use the same
+	 * query_plan_id to reuse the device inner buffer.
+	 */
+	if (pts->inner_sibling)
+		session->query_plan_id = pts->inner_sibling->ps_state->query_plan_id;
+	else
+		session->query_plan_id = (ps_state->query_plan_id ^
+								  ((uint64_t)pts->inner_batch_id << 20));
 	session->kcxt_kvecs_bufsz = pp_info->kvecs_bufsz;
 	session->kcxt_kvecs_ndims = pp_info->kvecs_ndims;
 	session->kcxt_extra_bufsz = pp_info->extra_bufsz;
 	session->cuda_stack_size  = pp_info->cuda_stack_size;
 	session->xpu_task_flags = pts->xpu_task_flags;
+	session->jit_kernels = pgstrom_jit_kernels;
+	session->gpu_trace = pgstrom_gpu_trace;
+	session->tablesample_method = pts->tablesample_method;
+	session->tablesample_seed   = pts->tablesample_seed;
+	session->tablesample_cutoff = pts->tablesample_cutoff;
+	session->gpucache_vcols = (pts->gcache_desc != NULL &&
+							   gpuCacheMatchVirtualColumns(pts->gcache_desc,
+														   pp_info->gpu_cache_vcols));
+	if (pts->gcache_desc != NULL &&
+		pp_info->gpu_cache_index_attnum > 0 &&
+		gpuCacheLookupIndexKey(pts->gcache_desc, pts,
+							   &session->gpucache_index_value))
+		session->gpucache_index_attnum = pp_info->gpu_cache_index_attnum;
+	if (pts->gcache_desc != NULL)
+		gpuCacheSetupBitFilter(pts->gcache_desc, pts, session);
 	session->hostEpochTimestamp = SetEpochTimestamp();
 	session->xactStartTimestamp = GetCurrentTransactionStartTimestamp();
 	session->session_xact_state = __build_session_xact_state(&buf);
+	if (pts->gpu_direct_mvcc)
+		session->session_snapshot =
+			__build_session_snapshot(&buf, pts->css.ss.ps.state->es_snapshot);
 	session->session_timezone = __build_session_timezone(&buf);
 	session->session_encode = __build_session_encode(&buf);
 	__build_session_lconvert(session);
 	session->pgsql_port_number = PostPortNumber;
+	session->pgsql_backend_pid = MyProcPid;
+	session->gpu_mem_quota = ((uint64_t)pgstrom_gpu_mem_quota_mb << 20);
 	session->pgsql_plan_node_id = pts->css.ss.ps.plan->plan_node_id;
 	session->join_inner_handle = join_inner_handle;
+	/* pinned host staging ring to send the chunks, if any */
+	if ((pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0)
+		session->staging_ring_handle = gpuClientSetupStagingRing(pts);
+	/*
+	 * GpuJoin inner buffer can be split over multiple GPUs, unless GpuPreAgg
+	 * final buffer or GpuWindow results are also kept in the same per-query
+	 * buffer, or it is kept by GPU service for the following queries or
+	 * the rescans. Hash-batched inner buffer is not kept, because it does
+	 * not fit the device memory at once.
+	 */
+	if (pts->inner_cache_fingerprint != 0 &&
+		pts->inner_batch_depth == 0)
+	{
+		session->join_inner_fingerprint = pts->inner_cache_fingerprint;
+		memcpy(session->join_inner_digest, pts->inner_cache_digest,
+			   KERN_INNER_CACHE_DIGEST_LEN);
+	}
+	else if (join_inner_handle != 0 &&
+			 pts->ds_entry != NULL &&
+			 GpuJoinInnerImageDigest(pts) != 0)
+		session->join_inner_fingerprint = GpuJoinInnerImageDigest(pts);
+	else if (join_inner_handle != 0 &&
+			 (pts->inner_rescan_keep || pts->inner_sibling) &&
+			 pts->inner_nbatches <= 1)
+		session->join_inner_generation = pts->inner_generation;
+	else if (join_inner_handle != 0 &&
+			 session->groupby_kds_final == 0 &&
+			 session->gpuwin_desc == 0 &&
+			 (pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0 &&
+			 pgstrom_gpujoin_multi_gpu_inner &&
+			 numGpuDevAttrs > 1)
+		session->join_inner_multi_gpu = true;
 	memcpy(buf.data, session, session_sz);
 
 	/* setup XpuCommand */
@@ -697,6 +955,43 @@ pgstromBuildSessionInfo(pgstromTaskState *pts,
 	return xcmd;
 }
 
+/*
+ * pgstromTaskStateNumDevs
+ *
+ * number of devices to be tracked by the rjoin_devs_count[]. Hybrid GpuScan
+ * also tracks the DPUs next to the GPUs.
+ */
+static int
+pgstromTaskStateNumDevs(pgstromTaskState *pts)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+
+	if ((pp_info->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0)
+	{
+		if (pp_info->ds_entry)
+			return numGpuDevAttrs + DpuStorageEntryCount();
+		return numGpuDevAttrs;
+	}
+	else if ((pp_info->xpu_task_flags & DEVKIND__NVIDIA_DPU) != 0)
+		return DpuStorageEntryCount();
+	return 0;
+}
+
+/*
+ * pgstromTaskStateDevIndex
+ */
+static inline int
+pgstromTaskStateDevIndex(pgstromTaskState *pts, XpuConnection *conn)
+{
+	int		dev_index = conn->dev_index;
+
+	/* DPU participant of the hybrid GpuScan */
+	if ((pts->pp_info->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0 &&
+		(pts->xpu_task_flags & DEVKIND__NVIDIA_DPU) != 0)
+		dev_index += numGpuDevAttrs;
+	return dev_index;
+}
+
 /*
  * pgstromTaskStateBeginScan
  */
@@ -705,17 +1000,28 @@ pgstromTaskStateBeginScan(pgstromTaskState *pts)
 {
 	pgstromSharedState *ps_state = pts->ps_state;
 	XpuConnection  *conn = pts->conn;
+	int				nconns = Max(pts->num_mgpu_conns, 1);
 	uint32_t		curval, newval;
 
 	Assert(conn != NULL);
+	/* every session to the multiple GPUs is a participant of the scan */
 	curval = pg_atomic_read_u32(&ps_state->parallel_task_control);
 	do {
 		if ((curval & 1) != 0)
 			return false;
-		newval = curval + 2;
+		newval = curval + 2 * nconns;
 	} while (!pg_atomic_compare_exchange_u32(&ps_state->parallel_task_control,
 											 &curval, newval));
-	pg_atomic_fetch_add_u32(&pts->rjoin_devs_count[conn->dev_index], 1);
+	if (pts->num_mgpu_conns == 0)
+		pg_atomic_fetch_add_u32(&pts->rjoin_devs_count[pgstromTaskStateDevIndex(pts, conn)], 1);
+	else
+	{
+		for (int i=0; i < pts->num_mgpu_conns; i++)
+		{
+			conn = pts->mgpu_conns[i];
+			pg_atomic_fetch_add_u32(&pts->rjoin_devs_count[pgstromTaskStateDevIndex(pts, conn)], 1);
+		}
+	}
 	return true;
 }
 
@@ -740,7 +1046,7 @@ pgstromTaskStateEndScan(pgstromTaskState *pts, kern_final_task *kfin)
 	if (newval == 1)
 		kfin->final_plan_node = true;
 
-	if (pg_atomic_sub_fetch_u32(&pts->rjoin_devs_count[conn->dev_index], 1) == 0)
+	if (pg_atomic_sub_fetch_u32(&pts->rjoin_devs_count[pgstromTaskStateDevIndex(pts, conn)], 1) == 0)
 		kfin->final_this_device = true;
 
 	return (kfin->final_plan_node | kfin->final_this_device);
@@ -753,7 +1059,7 @@ static void
 pgstromTaskStateResetScan(pgstromTaskState *pts)
 {
 	pgstromSharedState *ps_state = pts->ps_state;
-	int		num_devs = 0;
+	int		num_devs;
 
 	/*
 	 * pgstromExecTaskState() is never called on the single process
@@ -762,11 +1068,8 @@ pgstromTaskStateResetScan(pgstromTaskState *pts)
 	if (!ps_state)
 		return;
 
-	if ((pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0)
-		num_devs = numGpuDevAttrs;
-	else if ((pts->xpu_task_flags & DEVKIND__NVIDIA_DPU) != 0)
-		num_devs = DpuStorageEntryCount();
-	else
+	num_devs = pgstromTaskStateNumDevs(pts);
+	if (num_devs == 0)
 		elog(ERROR, "Bug? no GPU/DPUs are in use");
 
 	pg_atomic_write_u32(&ps_state->parallel_task_control, 0);
@@ -777,6 +1080,10 @@ pgstromTaskStateResetScan(pgstromTaskState *pts)
 	{
 		pgstromArrowFdwExecReset(pts->arrow_state);
 	}
+	else if (pts->file_state)
+	{
+		pgstromFileFdwExecReset(pts);
+	}
 	else if (ps_state->ss_handle == DSM_HANDLE_INVALID)
 	{
 		TableScanDesc scan = pts->css.ss.ss_currentScanDesc;
@@ -799,6 +1106,12 @@ pgstromTaskStateResetScan(pgstromTaskState *pts)
 static void
 __updateStatsXpuCommand(pgstromTaskState *pts, const XpuCommand *xcmd)
 {
+	/* shared buffers loaded by DMA are no longer referenced */
+	if (xcmd->tag == XpuCommandTag__Success && xcmd->u.results.shbuf_tag != 0)
+		pgstromRelScanReleaseSharedBuffers(pts, xcmd->u.results.shbuf_tag);
+	else if (xcmd->tag == XpuCommandTag__CPUFallback && xcmd->u.fallback.shbuf_tag != 0)
+		pgstromRelScanReleaseSharedBuffers(pts, xcmd->u.fallback.shbuf_tag);
+
 	if (xcmd->tag == XpuCommandTag__Success)
 	{
 		pgstromSharedState *ps_state = pts->ps_state;
@@ -820,6 +1133,24 @@ __updateStatsXpuCommand(pgstromTaskState *pts, const XpuCommand *xcmd)
 									xcmd->u.results.stats[i].nitems_out);
 		}
 		pg_atomic_fetch_add_u64(&ps_state->result_ntuples, xcmd->u.results.nitems_out);
+		if (xcmd->u.results.prof_nkernels > 0)
+		{
+			pg_atomic_fetch_add_u64(&ps_state->prof_ntasks, 1);
+			pg_atomic_fetch_add_u64(&ps_state->prof_nkernels,
+									xcmd->u.results.prof_nkernels);
+			pg_atomic_fetch_add_u64(&ps_state->prof_nresumes,
+									xcmd->u.results.prof_nresumes);
+			pg_atomic_fetch_add_u64(&ps_state->prof_h2d_bytes,
+									xcmd->u.results.prof_h2d_bytes);
+			pg_atomic_fetch_add_u64(&ps_state->prof_d2h_bytes,
+									xcmd->u.results.prof_d2h_bytes);
+			pg_atomic_fetch_add_u64(&ps_state->prof_h2d_usec,
+									xcmd->u.results.prof_h2d_usec);
+			pg_atomic_fetch_add_u64(&ps_state->prof_kern_usec,
+									xcmd->u.results.prof_kern_usec);
+			pg_atomic_fetch_add_u64(&ps_state->prof_occupancy,
+									(uint64_t)(xcmd->u.results.prof_occupancy * 1000.0));
+		}
 	}
 	else if (xcmd->tag == XpuCommandTag__CPUFallback)
 	{
@@ -830,6 +1161,109 @@ __updateStatsXpuCommand(pgstromTaskState *pts, const XpuCommand *xcmd)
 		pg_atomic_fetch_add_u64(&ps_state->npages_vfs_read,
 								xcmd->u.fallback.npages_vfs_read);
 	}
+	__updateAdaptiveExecStats(pts, xcmd);
+	__updateChunkSizeStats(pts, xcmd);
+}
+
+/*
+ * __updateAdaptiveExecStats
+ *
+ * It watches the fallback ratio of the chunks. Once most of the rows fall
+ * back to CPU, it makes no sense to send the blocks to the device, so the
+ * following blocks are processed by CPU directly (see the block loop of
+ * pgstromRelScanChunkDirect). During the CPU mode, one chunk is sent to
+ * the device for each ADAPTIVE_EXEC_PROBE_INTERVAL rounds, to switch back
+ * once the device can process the rows again.
+ */
+static void
+__updateAdaptiveExecStats(pgstromTaskState *pts, const XpuCommand *xcmd)
+{
+	pgstromSharedState *ps_state = pts->ps_state;
+	double		frac;
+
+	if (!pgstrom_enable_adaptive_exec ||
+		(pts->xpu_task_flags & DEVTASK__SCAN) == 0 ||
+		pts->num_rels > 0 ||
+		pts->cb_final_chunk != NULL ||
+		pts->cb_next_chunk != pgstromRelScanChunkDirect)
+		return;
+	if (xcmd->tag == XpuCommandTag__Success)
+	{
+		if (xcmd->u.results.nitems_raw == 0)
+			return;
+		frac = ((double)xcmd->u.results.fallback_nitems /
+				(double)xcmd->u.results.nitems_raw);
+		frac = Min(frac, 1.0);
+	}
+	else if (xcmd->tag == XpuCommandTag__CPUFallback)
+		frac = 1.0;
+	else
+		return;
+
+	if (pts->adaptive_nchunks++ == 0)
+		pts->adaptive_fallback_ratio = frac;
+	else
+		pts->adaptive_fallback_ratio = (0.75 * pts->adaptive_fallback_ratio +
+										0.25 * frac);
+	if (!pts->adaptive_cpu_mode)
+	{
+		if (pts->adaptive_nchunks >= ADAPTIVE_EXEC_MIN_CHUNKS &&
+			pts->adaptive_fallback_ratio >= pgstrom_adaptive_fallback_threshold)
+		{
+			elog(pgstrom_cpu_fallback_elevel,
+				 "adaptive execution switched to CPU (fallback ratio %.1f%%)",
+				 100.0 * pts->adaptive_fallback_ratio);
+			pts->adaptive_cpu_mode = true;
+			pts->adaptive_nrounds = 0;
+			pg_atomic_fetch_add_u32(&ps_state->adaptive_to_cpu, 1);
+		}
+	}
+	else if (frac < pgstrom_adaptive_fallback_threshold)
+	{
+		/* the probe chunk was processed by the device */
+		elog(pgstrom_cpu_fallback_elevel,
+			 "adaptive execution switched back to the device (fallback ratio %.1f%%)",
+			 100.0 * frac);
+		pts->adaptive_cpu_mode = false;
+		pts->adaptive_fallback_ratio = frac;
+		pg_atomic_fetch_add_u32(&ps_state->adaptive_to_xpu, 1);
+	}
+}
+
+/*
+ * __updateChunkSizeStats
+ *
+ * It adjusts the number of blocks per chunk for the next KDS_FORMAT_BLOCK
+ * chunks, by the response of GPU. If the destination buffer overflowed and
+ * the kernel had to suspend/resume, the chunk is shrunk to reduce the
+ * size of the results buffer. Once the results get sparse, the chunk is
+ * grown again (up to PGSTROM_CHUNK_SIZE) to reduce the number of kernel
+ * invocations.
+ */
+static void
+__updateChunkSizeStats(pgstromTaskState *pts, const XpuCommand *xcmd)
+{
+	uint32_t	curr_nblocks;
+	uint32_t	max_nblocks;
+
+	if (!pgstrom_enable_adaptive_chunk_size ||
+		xcmd->tag != XpuCommandTag__Success ||
+		xcmd->u.results.prof_nkernels == 0 ||
+		pts->cb_next_chunk != pgstromRelScanChunkDirect)
+		return;
+	max_nblocks = PGSTROM_CHUNK_SIZE / (sizeof(BlockNumber) + BLCKSZ);
+	curr_nblocks = (pts->chunk_nblocks > 0 ? pts->chunk_nblocks : max_nblocks);
+	if (xcmd->u.results.prof_nresumes > 0)
+	{
+		curr_nblocks /= (xcmd->u.results.prof_nresumes + 1);
+		curr_nblocks = Max(curr_nblocks, ADAPTIVE_CHUNK_MIN_NBLOCKS);
+	}
+	else if (curr_nblocks < max_nblocks &&
+			 2 * xcmd->u.results.prof_d2h_bytes < (uint64_t)curr_nblocks * BLCKSZ)
+	{
+		curr_nblocks = Min(2 * curr_nblocks, max_nblocks);
+	}
+	pts->chunk_nblocks = (curr_nblocks < max_nblocks ? curr_nblocks : 0);
 }
 
 /*
@@ -852,6 +1286,137 @@ __pickupNextXpuCommand(XpuConnection *conn)
 	return xcmd;
 }
 
+/*
+ * __updatePrefetchDeviceTime / __updatePrefetchBuildTime
+ *
+ * Moving average of the time to build a chunk and the turnaround time of
+ * the chunk by the device. The turnaround time is measured by the send
+ * timestamp of the oldest command, because responses mostly come back
+ * in order of the submission.
+ */
+#define PGSTROM_PREFETCH_ALPHA		0.25
+
+static void
+__updatePrefetchDeviceTime(pgstromTaskState *pts)
+{
+	if (pts->prefetch_head != pts->prefetch_tail)
+	{
+		TimestampTz	ts = pts->prefetch_send_ts[pts->prefetch_head++ %
+											   PGSTROM_PREFETCH_NSLOTS];
+		double		usec = (double)(GetCurrentTimestamp() - ts);
+
+		if (pts->prefetch_device_usec == 0.0)
+			pts->prefetch_device_usec = usec;
+		else
+			pts->prefetch_device_usec += PGSTROM_PREFETCH_ALPHA *
+				(usec - pts->prefetch_device_usec);
+	}
+}
+
+static void
+__updatePrefetchBuildTime(pgstromTaskState *pts, TimestampTz ts_begin)
+{
+	TimestampTz	ts_end = GetCurrentTimestamp();
+	double		usec = (double)(ts_end - ts_begin);
+
+	if (pts->prefetch_build_usec == 0.0)
+		pts->prefetch_build_usec = usec;
+	else
+		pts->prefetch_build_usec += PGSTROM_PREFETCH_ALPHA *
+			(usec - pts->prefetch_build_usec);
+	/* remember the send timestamp */
+	if (pts->prefetch_tail - pts->prefetch_head >= PGSTROM_PREFETCH_NSLOTS)
+		pts->prefetch_head++;
+	pts->prefetch_send_ts[pts->prefetch_tail++ %
+						  PGSTROM_PREFETCH_NSLOTS] = ts_end;
+}
+
+/*
+ * __computePrefetchDepth
+ *
+ * Number of chunks to be kept in flight. The device can process chunks
+ * concurrently while we build the next ones, so we need (turnaround time /
+ * build time) chunks in flight to keep the device busy, and one more for
+ * the chunk being consumed.
+ */
+static int
+__computePrefetchDepth(pgstromTaskState *pts, int max_async_tasks)
+{
+	int		depth;
+
+	if (pgstrom_scan_prefetch_depth > 0)
+		depth = pgstrom_scan_prefetch_depth;
+	else if (pts->prefetch_build_usec <= 0.0 ||
+			 pts->prefetch_device_usec <= 0.0)
+		depth = max_async_tasks / 2;	/* not measured yet */
+	else
+		depth = (int)ceil(pts->prefetch_device_usec /
+						  pts->prefetch_build_usec) + 1;
+	pts->prefetch_depth = Max(Min(depth, max_async_tasks), 1);
+	return pts->prefetch_depth;
+}
+
+/*
+ * __sendNextXpuChunk
+ *
+ * It loads the next chunk and sends the command to the connection. It returns
+ * NULL if no chunk was sent; the end of the scan, or a round of blocks were
+ * processed by CPU (adaptive execution).
+ */
+static XpuCommand *
+__sendNextXpuChunk(pgstromTaskState *pts, XpuConnection *conn)
+{
+	TimestampTz		ts_begin = GetCurrentTimestamp();
+	XpuCommand	   *xcmd;
+	struct iovec	xcmd_iov[10];
+	int				xcmd_iovcnt;
+	bool			probe = false;
+
+	/* adaptive execution sends a probe chunk to the device */
+	if (pts->adaptive_cpu_mode &&
+		++pts->adaptive_nrounds >= ADAPTIVE_EXEC_PROBE_INTERVAL)
+	{
+		pts->adaptive_cpu_mode = false;
+		pts->adaptive_nrounds = 0;
+		probe = true;
+	}
+	xcmd = pts->cb_next_chunk(pts, xcmd_iov, &xcmd_iovcnt);
+	if (probe)
+		pts->adaptive_cpu_mode = true;
+	if (xcmd)
+	{
+		/* only the slot number is sent, if staged */
+		if (pts->staging_ring)
+			gpuClientStageXpuCommand(pts, xcmd_iov, &xcmd_iovcnt);
+		xpuClientSendCommandIOV(conn, xcmd_iov, xcmd_iovcnt);
+		__updatePrefetchBuildTime(pts, ts_begin);
+	}
+	return xcmd;
+}
+
+/*
+ * __xpuConnectCheckErrors
+ *
+ * MEMO: caller must hold 'conn->mutex'; it is released on errors.
+ */
+static inline void
+__xpuConnectCheckErrors(XpuConnection *conn)
+{
+	if (conn->errorbuf.errcode != ERRCODE_STROM_SUCCESS)
+	{
+		pthreadMutexUnlock(&conn->mutex);
+		ereport(ERROR,
+				(errcode(conn->errorbuf.errcode),
+				 errmsg("%s:%d  %s",
+						conn->errorbuf.filename,
+						conn->errorbuf.lineno,
+						conn->errorbuf.message),
+				 errhint("device at %s, function at %s",
+						 conn->devname,
+						 conn->errorbuf.funcname)));
+	}
+}
+
 static XpuCommand *
 __waitAndFetchNextXpuCommand(pgstromTaskState *pts, bool try_final_callback)
 {
@@ -867,20 +1432,7 @@ __waitAndFetchNextXpuCommand(pgstromTaskState *pts, bool try_final_callback)
 		ResetLatch(MyLatch);
 
 		/* device error checks */
-		if (conn->errorbuf.errcode != ERRCODE_STROM_SUCCESS)
-		{
-			pthreadMutexUnlock(&conn->mutex);
-			ereport(ERROR,
-					(errcode(conn->errorbuf.errcode),
-					 errmsg("%s:%d  %s",
-							conn->errorbuf.filename,
-							conn->errorbuf.lineno,
-							conn->errorbuf.message),
-					 errhint("device at %s, function at %s",
-							 conn->devname,
-							 conn->errorbuf.funcname)));
-
-		}
+		__xpuConnectCheckErrors(conn);
 		if (!dlist_is_empty(&conn->ready_cmds_list))
 		{
 			/* ok, ready commands we have */
@@ -929,63 +1481,229 @@ __waitAndFetchNextXpuCommand(pgstromTaskState *pts, bool try_final_callback)
 	}
 	xcmd = __pickupNextXpuCommand(conn);
 	pthreadMutexUnlock(&conn->mutex);
+	__updatePrefetchDeviceTime(pts);
 	__updateStatsXpuCommand(pts, xcmd);
 	return xcmd;
 }
 
+/*
+ * __waitAndFetchNextXpuCommandMultiGpu
+ *
+ * A variation of __waitAndFetchNextXpuCommand() for the scan with sessions
+ * to the multiple GPUs. It fetches the ready command from any session, and
+ * sends the final command to the session individually once it gets idle.
+ */
 static XpuCommand *
-__fetchNextXpuCommand(pgstromTaskState *pts)
+__waitAndFetchNextXpuCommandMultiGpu(pgstromTaskState *pts)
 {
-	XpuConnection  *conn = pts->conn;
+	XpuConnection  *conn;
 	XpuCommand	   *xcmd;
 	struct iovec	xcmd_iov[10];
 	int				xcmd_iovcnt;
 	int				ev;
+
+	for (;;)
+	{
+		bool	has_running = false;
+		bool	retry = false;
+		int		nrunning;
+
+		ResetLatch(MyLatch);
+		for (int i=0; i < pts->num_mgpu_conns; i++)
+		{
+			conn = pts->mgpu_conns[i];
+
+			pthreadMutexLock(&conn->mutex);
+			__xpuConnectCheckErrors(conn);
+			if (!dlist_is_empty(&conn->ready_cmds_list))
+				goto found;
+			nrunning = conn->num_running_cmds;
+			pthreadMutexUnlock(&conn->mutex);
+
+			if (nrunning > 0)
+				has_running = true;
+			else if ((pts->mgpu_final_mask & (1UL << i)) == 0)
+			{
+				kern_final_task	kfin;
+
+				pts->mgpu_final_mask |= (1UL << i);
+				pts->conn = conn;
+				if (pgstromTaskStateEndScan(pts, &kfin) &&
+					pts->cb_final_chunk != NULL)
+				{
+					xcmd = pts->cb_final_chunk(pts, &kfin, xcmd_iov, &xcmd_iovcnt);
+					if (xcmd)
+						xpuClientSendCommandIOV(conn, xcmd_iov, xcmd_iovcnt);
+				}
+				retry = true;
+			}
+		}
+		if (retry)
+			continue;
+		if (!has_running)
+		{
+			pts->final_done = true;
+			return NULL;
+		}
+		CHECK_FOR_INTERRUPTS();
+
+		ev = WaitLatch(MyLatch,
+					   WL_LATCH_SET |
+					   WL_TIMEOUT |
+					   WL_POSTMASTER_DEATH,
+					   1000L,
+					   PG_WAIT_EXTENSION);
+		if (ev & WL_POSTMASTER_DEATH)
+			ereport(FATAL,
+					(errcode(ERRCODE_ADMIN_SHUTDOWN),
+					 errmsg("Unexpected Postmaster dead")));
+	}
+found:
+	xcmd = __pickupNextXpuCommand(conn);
+	pthreadMutexUnlock(&conn->mutex);
+	__updatePrefetchDeviceTime(pts);
+	__updateStatsXpuCommand(pts, xcmd);
+	return xcmd;
+}
+
+/*
+ * __fetchNextXpuCommandMultiGpu
+ *
+ * A variation of __fetchNextXpuCommand() for the scan with sessions to the
+ * multiple GPUs. The next chunk is sent to the least loaded session, so
+ * the faster GPU processes more chunks, and the ready command is fetched
+ * from any session.
+ */
+static XpuCommand *
+__fetchNextXpuCommandMultiGpu(pgstromTaskState *pts)
+{
+	XpuConnection  *conn;
+	XpuCommand	   *xcmd;
+	int				ev;
 	int				max_async_tasks = pgstrom_max_async_tasks();
+	int				prefetch_depth = __computePrefetchDepth(pts, max_async_tasks);
 
 	while (!pts->scan_done)
 	{
+		XpuConnection *send_conn = NULL;
+		XpuConnection *ready_conn = NULL;
+		int		send_load = INT_MAX;
+		int		num_running = 0;
+
 		CHECK_FOR_INTERRUPTS();
 
-		pthreadMutexLock(&conn->mutex);
-		/* device error checks */
-		if (conn->errorbuf.errcode != ERRCODE_STROM_SUCCESS)
+		ResetLatch(MyLatch);
+		for (int i=0; i < pts->num_mgpu_conns; i++)
 		{
+			int		load;
+
+			conn = pts->mgpu_conns[i];
+			pthreadMutexLock(&conn->mutex);
+			__xpuConnectCheckErrors(conn);
+			load = conn->num_running_cmds + conn->num_ready_cmds;
+			if (load < max_async_tasks && load < send_load)
+			{
+				send_conn = conn;
+				send_load = load;
+			}
+			if (!ready_conn && !dlist_is_empty(&conn->ready_cmds_list))
+				ready_conn = conn;
+			num_running += conn->num_running_cmds;
 			pthreadMutexUnlock(&conn->mutex);
-			ereport(ERROR,
-					(errcode(conn->errorbuf.errcode),
-					 errmsg("%s:%d  %s",
-							conn->errorbuf.filename,
-							conn->errorbuf.lineno,
-							conn->errorbuf.message),
-					 errhint("device at %s, function at %s",
-							 conn->devname,
-							 conn->errorbuf.funcname)));
 		}
 
+		if (send_conn && (!ready_conn || num_running < prefetch_depth))
+		{
+			/* see the comment in __fetchNextXpuCommand() */
+			pts->conn = send_conn;
+			if (!__sendNextXpuChunk(pts, send_conn))
+			{
+				/* a round of blocks were processed by CPU (adaptive execution) */
+				if (!pts->scan_done)
+					return NULL;
+				break;
+			}
+		}
+		else if (ready_conn)
+		{
+			/* only this backend fetches the ready commands */
+			pthreadMutexLock(&ready_conn->mutex);
+			xcmd = __pickupNextXpuCommand(ready_conn);
+			pthreadMutexUnlock(&ready_conn->mutex);
+			__updatePrefetchDeviceTime(pts);
+			__updateStatsXpuCommand(pts, xcmd);
+			return xcmd;
+		}
+		else if (num_running > 0)
+		{
+			/* wait for the response from any of GPUs */
+			ev = WaitLatch(MyLatch,
+						   WL_LATCH_SET |
+						   WL_TIMEOUT |
+						   WL_POSTMASTER_DEATH,
+						   1000L,
+						   PG_WAIT_EXTENSION);
+			if (ev & WL_POSTMASTER_DEATH)
+				ereport(FATAL,
+						(errcode(ERRCODE_ADMIN_SHUTDOWN),
+						 errmsg("Unexpected Postmaster dead")));
+		}
+		else
+		{
+			/*
+			 * Unfortunately, we touched the threshold. Take a short wait
+			 */
+			pg_usleep(20000L);		/* 20ms */
+		}
+	}
+	return __waitAndFetchNextXpuCommandMultiGpu(pts);
+}
+
+static XpuCommand *
+__fetchNextXpuCommand(pgstromTaskState *pts)
+{
+	XpuConnection  *conn = pts->conn;
+	XpuCommand	   *xcmd;
+	int				ev;
+	int				max_async_tasks = pgstrom_max_async_tasks();
+	int				prefetch_depth;
+
+	if (pts->num_mgpu_conns > 0)
+		return __fetchNextXpuCommandMultiGpu(pts);
+	prefetch_depth = __computePrefetchDepth(pts, max_async_tasks);
+	while (!pts->scan_done)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		pthreadMutexLock(&conn->mutex);
+		/* device error checks */
+		__xpuConnectCheckErrors(conn);
+
 		if ((conn->num_running_cmds + conn->num_ready_cmds) < max_async_tasks &&
 			(dlist_is_empty(&conn->ready_cmds_list) ||
-			 conn->num_running_cmds < max_async_tasks / 2))
+			 conn->num_running_cmds < prefetch_depth))
 		{
 			/*
 			 * xPU service still has margin to enqueue new commands.
 			 * If we have no ready commands or number of running commands
-			 * are less than pg_strom.max_async_tasks/2, we try to load
-			 * the next chunk and enqueue this command.
+			 * are less than the prefetch depth, we try to load the next
+			 * chunk and enqueue this command prior to the consumption of
+			 * the ready one.
 			 */
 			pthreadMutexUnlock(&conn->mutex);
-			xcmd = pts->cb_next_chunk(pts, xcmd_iov, &xcmd_iovcnt);
-			if (!xcmd)
+			if (!__sendNextXpuChunk(pts, conn))
 			{
-				Assert(pts->scan_done);
+				/* a round of blocks were processed by CPU (adaptive execution) */
+				if (!pts->scan_done)
+					return NULL;
 				break;
 			}
-			xpuClientSendCommandIOV(conn, xcmd_iov, xcmd_iovcnt);
 		}
 		else if (!dlist_is_empty(&conn->ready_cmds_list))
 		{
 			xcmd = __pickupNextXpuCommand(conn);
 			pthreadMutexUnlock(&conn->mutex);
+			__updatePrefetchDeviceTime(pts);
 			__updateStatsXpuCommand(pts, xcmd);
 			return xcmd;
 		}
@@ -1035,7 +1753,42 @@ pgstromScanNextTuple(pgstromTaskState *pts)
 		kern_data_store *kds = pts->curr_kds;
 		int64_t		index = pts->curr_index++;
 
-		if (index < kds->nitems)
+		if (index < kds->nitems && kds->format == KDS_FORMAT_COLUMN)
+		{
+			/* columnar projection results */
+			ExecClearTuple(slot);
+			for (int j=0; j < kds->ncols; j++)
+			{
+				kern_colmeta *cmeta = &kds->colmeta[j];
+				bits8	   *nullmap;
+				char	   *addr;
+
+				nullmap = (bits8 *)((char *)kds + __kds_unpack(cmeta->nullmap_offset));
+				if ((nullmap[index>>3] & (1<<(index & 7))) == 0)
+				{
+					slot->tts_values[j] = 0;
+					slot->tts_isnull[j] = true;
+					continue;
+				}
+				if (cmeta->attlen < 0)
+				{
+					/* varlena heap, maybe shared by the dictionary */
+					addr = KDS_COLUMN_VARLENA_ADDR(kds, cmeta, index);
+					slot->tts_values[j] = PointerGetDatum(addr);
+				}
+				else
+				{
+					addr = ((char *)kds + __kds_unpack(cmeta->values_offset) +
+							TYPEALIGN(cmeta->attalign, cmeta->attlen) * index);
+					slot->tts_values[j] = fetch_att(addr,
+													cmeta->attbyval,
+													cmeta->attlen);
+				}
+				slot->tts_isnull[j] = false;
+			}
+			return ExecStoreVirtualTuple(slot);
+		}
+		else if (index < kds->nitems)
 		{
 			kern_tupitem   *tupitem = KDS_GET_TUPITEM(kds, index);
 
@@ -1075,6 +1828,14 @@ pgstromExecFinalChunk(pgstromTaskState *pts,
 	xcmd->tag    = XpuCommandTag__XpuTaskFinal;
 	xcmd->length = offsetof(XpuCommand, u.fin.data);
 	memcpy(&xcmd->u.fin, kfin, sizeof(kern_final_task));
+	/*
+	 * RIGHT OUTER JOIN rows can be emitted by the GPU device, if no other
+	 * devices may still update the outer-join-map.
+	 */
+	if (kfin->final_plan_node &&
+		kfin->final_this_device &&
+		pgstromTaskStateNumDevs(pts) == 1)
+		xcmd->u.fin.final_right_outer = GpuJoinRightOuterOnDevice(pts);
 
 	xcmd_iov[0].iov_base = xcmd;
 	xcmd_iov[0].iov_len  = offsetof(XpuCommand, u.fin.data);
@@ -1117,12 +1878,37 @@ pgstromExecFinalChunkDummy(pgstromTaskState *pts,
 		SetLatch(MyLatch);
 		pthreadMutexUnlock(&conn->mutex);
 	}
-	return NULL;
+	return NULL;
+}
+
+/*
+ * CPU Fallback Routines
+ */
+
+/*
+ * __execFallbackTupleMVCC
+ *
+ * When GPU checks MVCC visibility of the heap pages loaded by GPU-Direct
+ * SQL (pts->gpu_direct_mvcc), the rows whose visibility is not determined
+ * by the hint bits are re-executed by CPU. These rows are fetched again
+ * from the shared buffer to check the visibility.
+ */
+static void
+__execFallbackTupleMVCC(pgstromTaskState *pts, HeapTuple tuple)
+{
+	Relation		rel = pts->css.ss.ss_currentRelation;
+	Snapshot		snapshot = pts->css.ss.ps.state->es_snapshot;
+	HeapTupleData	htup;
+	Buffer			buffer;
+
+	ItemPointerCopy(&tuple->t_self, &htup.t_self);
+	if (heap_fetch(rel, snapshot, &htup, &buffer, false))
+	{
+		pts->cb_cpu_fallback(pts, &htup);
+		ReleaseBuffer(buffer);
+	}
 }
 
-/*
- * CPU Fallback Routines
- */
 static void
 ExecFallbackRowDataStore(pgstromTaskState *pts,
 						 kern_data_store *kds)
@@ -1136,10 +1922,36 @@ ExecFallbackRowDataStore(pgstromTaskState *pts,
 		ItemPointerCopy(&tupitem->htup.t_ctid, &tuple.t_self);
 		tuple.t_tableOid = kds->table_oid;
 		tuple.t_data = &tupitem->htup;
-		pts->cb_cpu_fallback(pts, &tuple);
+		if (pts->gpu_direct_mvcc)
+			__execFallbackTupleMVCC(pts, &tuple);
+		else
+			pts->cb_cpu_fallback(pts, &tuple);
 	}
 }
 
+/*
+ * ExecFallbackPartialRows
+ *
+ * It re-executes the source rows that the device could not process
+ * (row-granular CPU fallback); these rows are written back in the
+ * KDS_FORMAT_ROW buffer next to the result chunks.
+ */
+static void
+ExecFallbackPartialRows(pgstromTaskState *pts, XpuCommand *resp)
+{
+	kern_data_store *kds = (kern_data_store *)
+		((char *)resp + resp->u.results.chunks_offset);
+
+	for (int i=0; i < resp->u.results.chunks_nitems; i++)
+		kds = (kern_data_store *)((char *)kds + kds->length);
+	Assert(kds->format == KDS_FORMAT_ROW &&
+		   kds->nitems == resp->u.results.fallback_nitems &&
+		   (char *)kds + kds->length <= (char *)resp + resp->length);
+	elog(pgstrom_cpu_fallback_elevel,
+		 "CPU fallback of %u rows in the chunk", kds->nitems);
+	ExecFallbackRowDataStore(pts, kds);
+}
+
 static void
 ExecFallbackBlockDataStore(pgstromTaskState *pts,
 						   kern_data_store *kds)
@@ -1155,7 +1967,8 @@ ExecFallbackBlockDataStore(pgstromTaskState *pts,
 			ItemIdData	   *lpp = &pg_page->pd_linp[k];
 			HeapTupleData	tuple;
 
-			if (ItemIdIsNormal(lpp))
+			if (ItemIdIsNormal(lpp) &&
+				pgstromTableSampleTuple(pts, block_nr, k+1))
 			{
 				tuple.t_len = ItemIdGetLength(lpp);
 				tuple.t_self.ip_blkid.bi_hi = (uint16_t)(block_nr >> 16);
@@ -1164,7 +1977,10 @@ ExecFallbackBlockDataStore(pgstromTaskState *pts,
 				tuple.t_tableOid = kds->table_oid;
 				tuple.t_data = (HeapTupleHeader)PageGetItem((Page)pg_page, lpp);
 
-				pts->cb_cpu_fallback(pts, &tuple);
+				if (pts->gpu_direct_mvcc && !PageIsAllVisible((Page)pg_page))
+					__execFallbackTupleMVCC(pts, &tuple);
+				else
+					pts->cb_cpu_fallback(pts, &tuple);
 			}
 		}
 	}
@@ -1215,6 +2031,42 @@ ExecFallbackArrowDataStore(pgstromTaskState *pts,
 	}
 }
 
+/*
+ * __columnarProjectionIsAvailable
+ *
+ * GPU projection can write back the results in KDS_FORMAT_COLUMN, instead
+ * of heap-tuples, if GpuScan/GpuJoin on heap tables generates only
+ * fixed-length attributes; that reduces D2H data size and deform cost.
+ * Varlena attributes are also available with the dictionary, that shares
+ * the repeated values within a chunk.
+ */
+static bool
+__columnarProjectionIsAvailable(pgstromTaskState *pts,
+								TupleDesc tdesc_dst,
+								char format)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+
+	if (!pgstrom_enable_columnar_projection ||
+		(format != KDS_FORMAT_BLOCK && format != KDS_FORMAT_ROW) ||
+		(pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0 ||
+		(pts->xpu_task_flags & DEVTASK__PREAGG) != 0 ||
+		pp_info->gpusort_limit > 0 ||
+		pp_info->gpuwin_desc != NULL ||
+		tdesc_dst->natts == 0)
+		return false;
+	for (int j=0; j < tdesc_dst->natts; j++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tdesc_dst, j);
+
+		if (attr->attlen > 0)
+			continue;
+		if (attr->attlen != -1 || !pgstrom_enable_columnar_dictionary)
+			return false;
+	}
+	return true;
+}
+
 /*
  * __setupTaskStateRequestBuffer
  */
@@ -1253,7 +2105,10 @@ __setupTaskStateRequestBuffer(pgstromTaskState *pts,
 	{
 		xcmd->u.task.kds_dst_offset = off;
 		kds  = (kern_data_store *)((char *)xcmd + off);
-		off += setup_kern_data_store(kds, tdesc_dst, 0, KDS_FORMAT_ROW);
+		off += setup_kern_data_store(kds, tdesc_dst, 0,
+									 __columnarProjectionIsAvailable(pts, tdesc_dst, format)
+									 ? KDS_FORMAT_COLUMN
+									 : KDS_FORMAT_ROW);
 	}
 	if (tdesc_src)
 	{
@@ -1357,6 +2212,12 @@ __execInitTaskStateCpuFallback(pgstromTaskState *pts)
 	pts->base_quals = ExecInitQual(pp_info->scan_quals, &pts->css.ss.ps);
 	pts->base_slot = MakeSingleTupleTableSlot(RelationGetDescr(rel),
 											  table_slot_callbacks(rel));
+	/*
+	 * Tuples handed to the CPU fallback are already formed HeapTuple;
+	 * a heap-tuple slot can reference them without any copy.
+	 */
+	pts->fallback_base_slot = MakeSingleTupleTableSlot(RelationGetDescr(rel),
+													   &TTSOpsHeapTuple);
 	/*
 	 * CPU-Projection
 	 */
@@ -1375,7 +2236,7 @@ __execInitTaskStateCpuFallback(pgstromTaskState *pts)
 			vl_map[nitems].dst_resno = tle->resno;
 			nitems++;
 		}
-		else if (!tle->resjunk)
+		else if (!tle->resjunk && !IsA(tle->expr, WindowFunc))
 		{
 			Assert(tle->resorigtbl == (Oid)UINT_MAX);
 			expr = __fixup_fallback_projection((Node *)tle->expr,
@@ -1402,6 +2263,10 @@ __execInitTaskStateCpuFallback(pgstromTaskState *pts)
 			{
 				pts->fallback_load_src = src_list;
 				pts->fallback_load_dst = dst_list;
+				/* only the referenced prefix shall be deformed */
+				foreach (lc, src_list)
+					pts->fallback_load_natts = Max(pts->fallback_load_natts,
+												   lfirst_int(lc));
 			}
 			else if (last_depth > 0 &&
 					 last_depth <= pts->num_rels)
@@ -1461,6 +2326,7 @@ pgstromExecInitTaskState(CustomScanState *node, EState *estate, int eflags)
 	TupleDesc	tupdesc_dst;
 	int			depth_index = 0;
 	bool		has_right_outer = false;
+	List	   *dfilter_quals;
 	ListCell   *lc;
 
 	/* sanity checks */
@@ -1469,6 +2335,9 @@ pgstromExecInitTaskState(CustomScanState *node, EState *estate, int eflags)
 		   innerPlanState(node) == NULL &&
 		   pp_info->num_rels == list_length(cscan->custom_plans) &&
 		   pts->num_rels == list_length(cscan->custom_plans));
+	/* dynamic filter by the inner rows of GpuJoin, if any */
+	dfilter_quals = GpuJoinDynamicFilterExecInit(pts);
+
 	/*
 	 * PG-Strom supports:
 	 * - regular relation with 'heap' access method
@@ -1492,18 +2361,44 @@ pgstromExecInitTaskState(CustomScanState *node, EState *estate, int eflags)
 								  pp_info->brin_index_oid,
 								  pp_info->brin_index_conds,
 								  pp_info->brin_index_quals);
+		/*
+		 * Hybrid GpuScan: even-numbered parallel workers run the scan on
+		 * the DPU that shares the storage. The parallel block scan hands
+		 * out the next chunk to whoever is ready, so faster participants
+		 * process more chunks and the results are merged by Gather.
+		 */
+		if ((pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0 &&
+			pp_info->ds_entry != NULL &&
+			IsParallelWorker() &&
+			(ParallelWorkerNumber % 2) == 0 &&
+			DpuStorageEntryIsAvailable(pp_info->ds_entry))
+		{
+			pts->xpu_task_flags = ((pts->xpu_task_flags & ~DEVKIND__NVIDIA_GPU) |
+								   DEVKIND__NVIDIA_DPU);
+		}
 		if ((pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0)
-			pts->optimal_gpus = GetOptimalGpuForRelation(rel);
+		{
+			if (pts->gcache_desc)
+				pts->optimal_gpus = GetOptimalGpuForGpuCache(pts->gcache_desc);
+			else
+				pts->optimal_gpus = GetOptimalGpuForRelation(rel);
+		}
 		if ((pts->xpu_task_flags & DEVKIND__NVIDIA_DPU) != 0)
 			pts->ds_entry = GetOptimalDpuForRelation(rel, &kds_pathname);
 		pts->kds_pathname = kds_pathname;
+		/* setup zone-map if any */
+		pgstromZoneMapExecInit(pts);
+		/* setup TABLESAMPLE if any */
+		pgstromTableSampleExecInit(pts);
 	}
 	else if (RelationGetForm(rel)->relkind == RELKIND_FOREIGN_TABLE)
 	{
 		if (!pgstromArrowFdwExecInit(pts,
-									 pp_info->scan_quals,
-									 pp_info->outer_refs))
-			elog(ERROR, "Bug? only arrow_fdw is supported in PG-Strom");
+									 list_concat(list_copy(pp_info->scan_quals),
+												 dfilter_quals),
+									 pp_info->outer_refs) &&
+			!pgstromFileFdwExecInit(pts))
+			elog(ERROR, "Bug? only arrow_fdw and file_fdw are supported in PG-Strom");
 	}
 	else
 	{
@@ -1584,6 +2479,10 @@ pgstromExecInitTaskState(CustomScanState *node, EState *estate, int eflags)
 			istate->hash_inner_funcs = lappend(istate->hash_inner_funcs,
 											   dtype->type_hashfunc);
 		}
+		istate->hash_build_on_device = pp_inner->hash_build_on_device;
+		if (pp_inner->dfilter_keynum > 0)
+			istate->dfilter_inner_key = list_nth(istate->hash_inner_keys,
+												 pp_inner->dfilter_keynum - 1);
 
 		if (OidIsValid(pp_inner->gist_index_oid))
 		{
@@ -1592,11 +2491,35 @@ pgstromExecInitTaskState(CustomScanState *node, EState *estate, int eflags)
 			istate->gist_clause = ExecInitExpr((Expr *)pp_inner->gist_clause,
 											   &pts->css.ss.ps);
 			istate->gist_ctid_resno = pp_inner->gist_ctid_resno;
+			/* GiST index of box2df can be converted to the compact R-tree */
+			istate->gist_rtree = (RelationGetDescr(istate->gist_irel)->natts == 1 &&
+								  pgstromGistKeyIsBox2df(pp_inner->gist_key_type));
+		}
+		else if (pp_inner->gist_clause)
+		{
+			/* R-tree shall be built on the inner preloading */
+			FuncExpr   *func = (FuncExpr *)pp_inner->gist_clause;
+			Expr	   *inner_key = linitial(func->args);
+
+			Assert(IsA(func, FuncExpr));
+			istate->gist_clause = ExecInitExpr((Expr *)pp_inner->gist_clause,
+											   &pts->css.ss.ps);
+			istate->spatial_key = ExecInitExpr(inner_key, &pts->css.ss.ps);
+			istate->gist_rtree = true;
+			pgstromSetupSpatialIndexFuncs(istate, exprType((Node *)inner_key));
 		}
+		istate->gist_prep_resno = pp_inner->gist_prep_resno;
+		if (pp_inner->range_inner_key)
+			istate->range_inner_key = ExecInitExpr(pp_inner->range_inner_key,
+												   &pts->css.ss.ps);
 		pts->css.custom_ps = lappend(pts->css.custom_ps, istate->ps);
 		depth_index++;
 	}
 	Assert(depth_index == pts->num_rels);
+	/* inner buffer can be kept by GPU service for the following queries? */
+	pts->inner_cache_fingerprint = GpuJoinInnerCacheFingerprint(pts, eflags);
+	/* elsewhere, it may be kept by GPU service for the rescans? */
+	pts->inner_rescan_keep = GpuJoinInnerRescanKeep(pts, eflags);
 	
 	/*
 	 * Setup request buffer
@@ -1610,6 +2533,15 @@ pgstromExecInitTaskState(CustomScanState *node, EState *estate, int eflags)
 									  tupdesc_dst,
 									  KDS_FORMAT_ARROW);
 	}
+	else if (pts->file_state)		/* file_fdw */
+	{
+		pts->cb_next_chunk = pgstromScanChunkFileFdw;
+		pts->cb_next_tuple = pgstromScanNextTuple;
+		__setupTaskStateRequestBuffer(pts,
+									  tupdesc_src,
+									  tupdesc_dst,
+									  KDS_FORMAT_ROW);
+	}
 	else if (pts->gcache_desc)		/* GPU-Cache */
 	{
 		pts->cb_next_chunk = pgstromScanChunkGpuCache;
@@ -1624,6 +2556,9 @@ pgstromExecInitTaskState(CustomScanState *node, EState *estate, int eflags)
 	{
 		pts->cb_next_chunk = pgstromRelScanChunkDirect;
 		pts->cb_next_tuple = pgstromScanNextTuple;
+		pts->gpu_direct_mvcc = pgstromRelScanDirectMVCCEnabled(pts);
+		if (pts->gpu_direct_mvcc)
+			pgstromHintBitsSetterRegister(pts->css.ss.ss_currentRelation);
 		__setupTaskStateRequestBuffer(pts,
 									  tupdesc_src,
 									  tupdesc_dst,
@@ -1661,8 +2596,22 @@ pgstromExecInitTaskState(CustomScanState *node, EState *estate, int eflags)
 	}
 	else
 		elog(ERROR, "Bug? unknown DEVTASK");
+	/* GpuWindow computes the window functions on XpuTaskFinal */
+	if (pp_info->gpuwin_desc)
+	{
+		pts->cb_final_chunk = pgstromExecFinalChunk;
+		pts->cb_cpu_fallback = ExecFallbackCpuWindow;
+	}
+	/*
+	 * LIMIT pushdown terminates the scan once enough rows are returned, so
+	 * it is not applicable if XpuTaskFinal may return the rows.
+	 */
+	if (pp_info->scan_limit > 0 &&
+		pts->cb_final_chunk != pgstromExecFinalChunk)
+		pts->scan_limit = pp_info->scan_limit;
 	/* other fields init */
 	pts->curr_vm_buffer = InvalidBuffer;
+	dlist_init(&pts->shbuf_pins_list);
 }
 
 /*
@@ -1674,6 +2623,8 @@ pgstromExecScanAccess(pgstromTaskState *pts)
 	TupleTableSlot *slot;
 	XpuCommand	   *resp;
 
+	if (pts->cpu_direct_scan)
+		return pgstromRelScanCpuDirect(pts);
 	slot = pgstromFetchFallbackTuple(pts);
 	if (slot)
 		return slot;
@@ -1685,15 +2636,24 @@ pgstromExecScanAccess(pgstromTaskState *pts)
 			xpuClientPutResponse(pts->curr_resp);
 		pts->curr_resp = __fetchNextXpuCommand(pts);
 		if (!pts->curr_resp)
-			return pgstromFetchFallbackTuple(pts);
+		{
+			/* blocks may be processed by CPU, if scan is not done yet */
+			slot = pgstromFetchFallbackTuple(pts);
+			if (slot || pts->scan_done)
+				return slot;
+			continue;
+		}
 		resp = pts->curr_resp;
 		switch (resp->tag)
 		{
 			case XpuCommandTag__Success:
 				if (resp->u.results.ojmap_offset != 0)
 					ExecFallbackCpuJoinOuterJoinMap(pts, resp);
-				if (resp->u.results.final_plan_node)
+				if (resp->u.results.final_plan_node &&
+					!resp->u.results.final_right_outer)
 					ExecFallbackCpuJoinRightOuter(pts);
+				if (resp->u.results.fallback_nitems > 0)
+					ExecFallbackPartialRows(pts, resp);
 				if (resp->u.results.chunks_nitems == 0)
 					goto next_chunks;
 				pts->curr_kds = (kern_data_store *)
@@ -1761,8 +2721,7 @@ pgstromExecScanReCheck(pgstromTaskState *pts, EPQState *epqstate)
 	{
 		TupleTableSlot *ss_slot = pts->css.ss.ss_ScanTupleSlot;
 		TupleTableSlot *epq_slot = epqstate->relsubs_slot[scanrelid-1];
-		size_t			fallback_index_saved = pts->fallback_index;
-		size_t			fallback_usage_saved = pts->fallback_usage;
+		size_t			fallback_nitems_saved = pts->fallback_nitems;
 
 		Assert(epqstate->relsubs_rowmark[scanrelid - 1] == NULL);
 		/* Mark to remember that we shouldn't return it again */
@@ -1787,19 +2746,9 @@ pgstromExecScanReCheck(pgstromTaskState *pts, EPQState *epqstate)
 			epq_tuple = ExecFetchSlotHeapTuple(epq_slot, false,
 											   &should_free);
 			if (pts->cb_cpu_fallback(pts, epq_tuple) &&
-				pts->fallback_tuples != NULL &&
-				pts->fallback_buffer != NULL &&
-				pts->fallback_nitems > fallback_index_saved)
+				pts->fallback_nitems > fallback_nitems_saved)
 			{
-				HeapTupleData	htup;
-				kern_tupitem   *titem = (kern_tupitem *)
-					(pts->fallback_buffer +
-					 pts->fallback_tuples[fallback_index_saved]);
-
-				htup.t_len = titem->t_len;
-				htup.t_data = &titem->htup;
-				ss_slot = pts->css.ss.ss_ScanTupleSlot;
-				ExecForceStoreHeapTuple(&htup, ss_slot, false);
+				ss_slot = pgstromFetchFallbackTuple(pts);
 			}
 			else
 			{
@@ -1808,8 +2757,7 @@ pgstromExecScanReCheck(pgstromTaskState *pts, EPQState *epqstate)
 			/* release fallback tuple & buffer */
 			if (should_free)
 				pfree(epq_tuple);
-			pts->fallback_index = fallback_index_saved;
-			pts->fallback_usage = fallback_usage_saved;
+			pgstromResetFallbackBuffer(pts);
 		}
 		return ss_slot;
 	}
@@ -1821,6 +2769,83 @@ pgstromExecScanReCheck(pgstromTaskState *pts, EPQState *epqstate)
 	return pgstromExecScanAccess(pts);
 }
 
+/*
+ * __pgstromExecTaskOpenMultiGpuSessions
+ *
+ * A backend without parallel workers opens sessions to the other optimal
+ * GPUs also (up to pg_strom.gpu_scan_max_devices), then the chunks are
+ * distributed to the GPUs. It is not applied to the workloads that need
+ * all the rows on a particular GPU (RIGHT OUTER JOIN, GPU window functions,
+ * GpuPreAgg without Agg node, inner cache and GpuCache), the staging
+ * ring bound to the session, and the session on the remote GPU service.
+ */
+static void
+__pgstromExecTaskOpenMultiGpuSessions(pgstromTaskState *pts,
+									  const XpuCommand *session)
+{
+	EState		   *estate = pts->css.ss.ps.state;
+	XpuConnection  *primary = pts->conn;
+	const Bitmapset *gpuset = pts->optimal_gpus;
+	int				max_conns;
+	int				nconns = 1;
+
+	if (pgstrom_gpu_scan_max_devices <= 1 ||
+		numGpuDevAttrs <= 1 ||
+		IsParallelWorker() ||
+		pts->css.ss.ps.plan->parallel_aware ||
+		(pts->xpu_task_flags & DEVKIND__NVIDIA_DPU) != 0 ||
+		pts->inner_cache_handle != 0 ||
+		pts->gcache_desc != NULL ||
+		pts->staging_ring != NULL ||
+		strncmp(primary->devname, "RGPU-", 5) == 0 ||
+		pts->pp_info->gpuwin_desc != NULL ||
+		pts->pp_info->groupby_final_on_device ||
+		((pts->xpu_task_flags & DEVTASK__JOIN) != 0 &&
+		 pts->cb_final_chunk == pgstromExecFinalChunk))
+		return;
+
+	/* mgpu_final_mask tracks up to 64 sessions */
+	max_conns = Min(Min(pgstrom_gpu_scan_max_devices, numGpuDevAttrs), 64);
+	if (!pts->mgpu_conns)
+		pts->mgpu_conns = MemoryContextAllocZero(estate->es_query_cxt,
+												 sizeof(XpuConnection *) * 64);
+	pts->mgpu_conns[0] = primary;
+	for (int k=0; k < numGpuDevAttrs && nconns < max_conns; k++)
+	{
+		if (k == primary->dev_index ||
+			!gpuClientDeviceIsAllowed(k) ||
+			(!bms_is_empty(gpuset) && !bms_is_member(k, gpuset)))
+			continue;
+		pts->conn = NULL;
+		gpuClientOpenSessionOnDevice(pts, session, k);
+		pts->mgpu_conns[nconns++] = pts->conn;
+	}
+	pts->conn = primary;
+	if (nconns > 1)
+	{
+		pts->num_mgpu_conns = nconns;
+		pts->mgpu_final_mask = 0;
+	}
+}
+
+/*
+ * __pgstromExecTaskCloseSessions
+ */
+static void
+__pgstromExecTaskCloseSessions(pgstromTaskState *pts)
+{
+	if (pts->num_mgpu_conns > 0)
+	{
+		for (int i=0; i < pts->num_mgpu_conns; i++)
+			xpuClientCloseSession(pts->mgpu_conns[i]);
+		pts->num_mgpu_conns = 0;
+		pts->mgpu_final_mask = 0;
+	}
+	else if (pts->conn)
+		xpuClientCloseSession(pts->conn);
+	pts->conn = NULL;
+}
+
 /*
  * __pgstromExecTaskOpenConnection
  */
@@ -1830,16 +2855,21 @@ __pgstromExecTaskOpenConnection(pgstromTaskState *pts)
 	const XpuCommand *session;
 	uint32_t	inner_handle = 0;
 	TupleDesc	tupdesc_kds_final = NULL;
+	TimestampTz	ts_setup;
 
 	/* attach pgstromSharedState, if none */
 	if (!pts->ps_state)
 		pgstromSharedStateInitDSM(&pts->css, NULL, NULL);
-	/* preload inner buffer, if any */
+	/* preload inner buffer, if any (unless GPU service keeps the same one) */
 	if (pts->num_rels > 0)
 	{
-		inner_handle = GpuJoinInnerPreload(pts);
+		inner_handle = GpuJoinInnerCacheAttach(pts);
 		if (inner_handle == 0)
-			return false;
+		{
+			inner_handle = GpuJoinInnerPreload(pts);
+			if (inner_handle == 0)
+				return false;
+		}
 	}
 	/* XPU-PreAgg needs tupdesc of kds_final */
 	if ((pts->xpu_task_flags & DEVTASK__PREAGG) != 0)
@@ -1870,9 +2900,11 @@ __pgstromExecTaskOpenConnection(pgstromTaskState *pts)
 	/* build the session information */
 	session = pgstromBuildSessionInfo(pts, inner_handle, tupdesc_kds_final);
 
+	ts_setup = GetCurrentTimestamp();
 	if ((pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0)
 	{
 		gpuClientOpenSession(pts, session);
+		__pgstromExecTaskOpenMultiGpuSessions(pts, session);
 	}
 	else if ((pts->xpu_task_flags & DEVKIND__NVIDIA_DPU) != 0)
 	{
@@ -1883,6 +2915,9 @@ __pgstromExecTaskOpenConnection(pgstromTaskState *pts)
 	{
 		elog(ERROR, "Bug? unknown PG-Strom task kind: %08x", pts->xpu_task_flags);
 	}
+	pts->calib_start_ts = GetCurrentTimestamp();
+	pts->calib_setup_usec = (double)(pts->calib_start_ts - ts_setup);
+	pts->calib_nsessions++;
 	/* update the scan/join control variables */
 	if (!pgstromTaskStateBeginScan(pts))
 		return false;
@@ -1890,6 +2925,97 @@ __pgstromExecTaskOpenConnection(pgstromTaskState *pts)
 	return true;
 }
 
+/*
+ * __pgstromExecTaskNextInnerBatch
+ *
+ * Hash-batched GpuJoin scans the outer relation again with the next batch
+ * of the inner buffer, once the current batch is completed.
+ */
+static bool
+__pgstromExecTaskNextInnerBatch(pgstromTaskState *pts)
+{
+	uint32_t	batch_id = pts->inner_batch_id + 1;
+	int64_t		scan_nrows = pts->scan_nrows;
+
+	if (batch_id >= pts->inner_nbatches)
+		return false;
+	/* LIMIT pushdown already got enough rows */
+	if (pts->scan_limit > 0 && scan_nrows >= pts->scan_limit)
+		return false;
+	if (pts->curr_resp)
+	{
+		xpuClientPutResponse(pts->curr_resp);
+		pts->curr_resp = NULL;
+	}
+	pgstromExecResetTaskState(&pts->css);
+	pts->inner_batch_id = batch_id;
+	pts->scan_nrows = scan_nrows;
+	pts->scan_done  = false;
+	pts->final_done = false;
+	pts->curr_tbm = NULL;
+	pts->curr_block_num = 0;
+	pts->curr_block_tail = 0;
+	return __pgstromExecTaskOpenConnection(pts);
+}
+
+/*
+ * __pgstromExecTaskCpuDirectScan
+ *
+ * The runtime parameters or partition pruning may shrink the input to a few
+ * blocks, even if GPU/DPU plan was chosen. Then, the setup of the session
+ * and kernel launch is much more expensive than the scan itself, so a simple
+ * scan of the heap relation that is not larger than the threshold is run by
+ * CPU using the fallback expressions, without opening any sessions.
+ */
+static bool
+__pgstromExecTaskCpuDirectScan(pgstromTaskState *pts)
+{
+	Relation	rel = pts->css.ss.ss_currentRelation;
+
+	if (pgstrom_cpu_direct_scan_threshold <= 0 ||
+		!rel ||
+		(pts->xpu_task_flags & DEVTASK__SCAN) == 0 ||
+		pts->num_rels > 0 ||
+		pts->cb_final_chunk != NULL ||
+		pts->cb_next_chunk != pgstromRelScanChunkDirect ||
+		pts->br_state != NULL ||
+		(pts->ps_state && pts->ps_state->ss_handle != DSM_HANDLE_INVALID) ||
+		RelationGetNumberOfBlocks(rel) > pgstrom_cpu_direct_scan_threshold)
+		return false;
+	if (!pts->ps_state)
+		pgstromSharedStateInitDSM(&pts->css, NULL, NULL);
+	elog(pgstrom_cpu_fallback_elevel,
+		 "relation '%s' is scanned by CPU directly (%u blocks)",
+		 RelationGetRelationName(rel),
+		 RelationGetNumberOfBlocks(rel));
+	return true;
+}
+
+/*
+ * __pgstromExecTaskCancel
+ *
+ * It stops to issue the next chunks once the scan returned enough rows for
+ * the LIMIT clause, and cancels the tasks already sent to the GPU service.
+ * The cancelled tasks send back empty results, so the in-flight responses
+ * are consumed as usual.
+ */
+static void
+__pgstromExecTaskCancel(pgstromTaskState *pts)
+{
+	if (pts->scan_done)
+		return;
+	pts->scan_done = true;
+	if ((pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0)
+		return;
+	if (pts->num_mgpu_conns > 0)
+	{
+		for (int i=0; i < pts->num_mgpu_conns; i++)
+			xpuClientCancelTasks(pts->mgpu_conns[i]);
+	}
+	else if (pts->conn)
+		xpuClientCancelTasks(pts->conn);
+}
+
 /*
  * pgstromExecTaskState
  */
@@ -1903,11 +3029,14 @@ pgstromExecTaskState(CustomScanState *node)
 	ProjectionInfo *proj_info = node->ss.ps.ps_ProjInfo;
 	TupleTableSlot *slot;
 
-	if (!pts->conn)
+	if (!pts->conn && !pts->cpu_direct_scan)
 	{
-		if (!__pgstromExecTaskOpenConnection(pts))
+		if (__pgstromExecTaskCpuDirectScan(pts))
+			pts->cpu_direct_scan = true;
+		else if (!__pgstromExecTaskOpenConnection(pts))
 			return NULL;
-		Assert(pts->conn);
+		else
+			Assert(pts->conn);
 	}
 
 	/*
@@ -1931,13 +3060,20 @@ pgstromExecTaskState(CustomScanState *node)
 	{
 		slot = pgstromExecScanAccess(pts);
 		if (TupIsNull(slot))
+		{
+			if (__pgstromExecTaskNextInnerBatch(pts))
+				continue;
 			break;
+		}
 		/* check whether the current tuple satisfies the qual-clause */
 		ResetExprContext(econtext);
 		econtext->ecxt_scantuple = slot;
 
 		if (!host_quals || ExecQual(host_quals, econtext))
 		{
+			if (pts->scan_limit > 0 &&
+				++pts->scan_nrows >= pts->scan_limit)
+				__pgstromExecTaskCancel(pts);
 			if (proj_info)
 				return ExecProject(proj_info);
 			return slot;
@@ -1947,6 +3083,94 @@ pgstromExecTaskState(CustomScanState *node)
 	return NULL;
 }
 
+/*
+ * pgstromExecTaskNextBatch
+ *
+ * It hands off the rest of the current result chunk to the PG-Strom aware
+ * consumer as column vectors, if the GPU projection returned the results
+ * in KDS_FORMAT_COLUMN and the scan tuples are returned as is (no host
+ * quals and projection). Varlena columns are referenced by
+ * KDS_COLUMN_VARLENA_ADDR(). The rows [*p_index, *p_index + *p_nitems) of the
+ * KDS are consumed, and the KDS is valid until the next call of this
+ * function or ExecProcNode().
+ * It returns NULL if there are no rows to be handed off as column vectors
+ * right now (including the end of the chunk); the consumer must fetch the
+ * next row by ExecProcNode() then, and may try this function again.
+ */
+kern_data_store *
+pgstromExecTaskNextBatch(PlanState *ps, int64_t *p_index, int64_t *p_nitems)
+{
+	pgstromTaskState *pts = (pgstromTaskState *)ps;
+	kern_data_store *kds;
+	int64_t		nitems;
+
+	if (!IsA(ps, CustomScanState) ||
+		((CustomScanState *)ps)->methods->ExecCustomScan != pgstromExecTaskState)
+		return NULL;
+	if (!pts->conn ||
+		!pts->curr_resp ||
+		ps->qual != NULL ||
+		ps->ps_ProjInfo != NULL ||
+		ps->state->es_epq_active != NULL)
+		return NULL;
+	/* CPU fallback tuples are returned by ExecProcNode() first */
+	if (pts->fallback_index < pts->fallback_nitems)
+		return NULL;
+	kds = pts->curr_kds;
+	if (kds->format != KDS_FORMAT_COLUMN ||
+		pts->curr_index >= kds->nitems)
+		return NULL;
+	nitems = kds->nitems - pts->curr_index;
+	*p_index = pts->curr_index;
+	*p_nitems = nitems;
+	pts->curr_index = kds->nitems;
+	if (ps->instrument)
+		ps->instrument->tuplecount += nitems;
+	if (pts->scan_limit > 0 &&
+		(pts->scan_nrows += nitems) >= pts->scan_limit)
+		__pgstromExecTaskCancel(pts);
+	return kds;
+}
+
+/*
+ * pgstromCostCalibRecordTaskState
+ *
+ * It records the runtime statistics of the simple scan (without join,
+ * aggregation and rescan) for the cost calibration. Only the leader process
+ * records it, after all the workers are done, so the wall-clock time is
+ * multiplied by the parallel divisor same as the planner does.
+ */
+static void
+pgstromCostCalibRecordTaskState(pgstromTaskState *pts)
+{
+	pgstromSharedState *ps_state = pts->ps_state;
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	Relation	rel = pts->css.ss.ss_currentRelation;
+	double		run_usec;
+	double		npages;
+
+	if (!ps_state || !rel ||
+		pts->calib_nsessions != 1 ||
+		pts->num_rels > 0 ||
+		pp_info->gpuwin_desc != NULL ||
+		(pts->xpu_task_flags & DEVTASK__SCAN) == 0 ||
+		((pp_info->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0 &&
+		 pp_info->ds_entry != NULL))	/* hybrid scan */
+		return;
+	run_usec = (double)(GetCurrentTimestamp() - pts->calib_start_ts);
+	if (ps_state->ss_handle != DSM_HANDLE_INVALID)
+		run_usec *= pp_info->parallel_divisor;
+	npages = (pg_atomic_read_u64(&ps_state->npages_direct_read) +
+			  pg_atomic_read_u64(&ps_state->npages_vfs_read) +
+			  pg_atomic_read_u64(&ps_state->npages_buffer_read));
+	pgstromCostCalibRecord(pts->xpu_task_flags & DEVKIND__ANY,
+						   RelationGetForm(rel)->reltablespace,
+						   pts->calib_setup_usec,
+						   run_usec,
+						   npages,
+						   (double)pg_atomic_read_u64(&ps_state->result_ntuples));
+}
+
 /*
  * pgstromExecEndTaskState
  */
@@ -1959,16 +3183,26 @@ pgstromExecEndTaskState(CustomScanState *node)
 
 	if (pts->curr_vm_buffer != InvalidBuffer)
 		ReleaseBuffer(pts->curr_vm_buffer);
-	if (pts->conn)
-		xpuClientCloseSession(pts->conn);
+	if (!IsParallelWorker())
+		pgstromCostCalibRecordTaskState(pts);
+	__pgstromExecTaskCloseSessions(pts);
+	/* no responses come any more */
+	pgstromRelScanReleaseSharedBuffers(pts, 0);
+	if (pts->staging_ring_handle != 0)
+		gpuClientReleaseStagingRing(pts);
 	if (pts->br_state)
 		pgstromBrinIndexExecEnd(pts);
 	if (pts->gcache_desc)
 		pgstromGpuCacheExecEnd(pts);
 	if (pts->arrow_state)
 		pgstromArrowFdwExecEnd(pts->arrow_state);
+	if (pts->file_state)
+		pgstromFileFdwExecEnd(pts);
 	if (pts->base_slot)
 		ExecDropSingleTupleTableSlot(pts->base_slot);
+	if (pts->fallback_base_slot)
+		ExecDropSingleTupleTableSlot(pts->fallback_base_slot);
+	pgstromReleaseFallbackBuffer(pts);
 	if (pts->css.ss.ss_currentScanDesc)
 		table_endscan(pts->css.ss.ss_currentScanDesc);
 	for (int i=0; i < pts->num_rels; i++)
@@ -1997,12 +3231,24 @@ pgstromExecResetTaskState(CustomScanState *node)
 {
 	pgstromTaskState *pts = (pgstromTaskState *) node;
 
-	if (pts->conn)
-	{
-		xpuClientCloseSession(pts->conn);
-		pts->conn = NULL;
-	}
+	__pgstromExecTaskCloseSessions(pts);
+	pgstromRelScanReleaseSharedBuffers(pts, 0);
+	pts->adaptive_cpu_mode = false;
+	pts->adaptive_nchunks = 0;
+	pts->adaptive_nrounds = 0;
+	pts->cpu_direct_scan = false;
+	pts->chunk_nblocks = 0;
+	pts->scan_nrows = 0;
+	pgstromResetFallbackBuffer(pts);
+	if (pts->staging_ring_handle != 0)
+		gpuClientReleaseStagingRing(pts);
 	pgstromTaskStateResetScan(pts);
+	/* inner buffer is kept, unless inner plans depend on changed params */
+	if (pts->num_rels > 0)
+		GpuJoinInnerRescan(pts);
+	pts->inner_batch_id = 0;
+	/* in-flight chunks are gone, but keep the measured time */
+	pts->prefetch_head = pts->prefetch_tail = 0;
 	if (pts->br_state)
 		pgstromBrinIndexExecReset(pts);
 	if (pts->arrow_state)
@@ -2028,13 +3274,10 @@ pgstromSharedStateEstimateDSM(CustomScanState *node,
 		len += pgstromBrinIndexEstimateDSM(pts);
 	len += MAXALIGN(offsetof(pgstromSharedState, inners[num_rels]));
 
-	if ((pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0)
-		num_devs = numGpuDevAttrs;
-	else if ((pts->xpu_task_flags & DEVKIND__NVIDIA_DPU) != 0)
-		num_devs = DpuStorageEntryCount();
+	num_devs = pgstromTaskStateNumDevs(pts);
 	len += MAXALIGN(sizeof(pg_atomic_uint32) * num_devs);
 
-	if (!pts->arrow_state)
+	if (!pts->arrow_state && !pts->file_state)
 		len += table_parallelscan_estimate(relation, snapshot);
 
 	return MAXALIGN(len);
@@ -2060,10 +3303,7 @@ pgstromSharedStateInitDSM(CustomScanState *node,
 	TableScanDesc scan = NULL;
 
 	Assert(!IsBackgroundWorker);
-	if ((pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0)
-		num_devs = numGpuDevAttrs;
-	else if ((pts->xpu_task_flags & DEVKIND__NVIDIA_DPU) != 0)
-		num_devs = DpuStorageEntryCount();
+	num_devs = pgstromTaskStateNumDevs(pts);
 
 	if (pts->br_state)
 		dsm_addr += pgstromBrinIndexInitDSM(pts, dsm_addr);
@@ -2087,6 +3327,8 @@ pgstromSharedStateInitDSM(CustomScanState *node,
 			pgstromGpuCacheInitDSM(pts, ps_state);
 		if (pts->arrow_state)
 			pgstromArrowFdwInitDSM(pts->arrow_state, ps_state);
+		else if (pts->file_state)
+			elog(ERROR, "Bug? parallel scan on file_fdw is not supported");
 		else
 		{
 			ParallelTableScanDesc pdesc = (ParallelTableScanDesc) dsm_addr;
@@ -2113,16 +3355,25 @@ pgstromSharedStateInitDSM(CustomScanState *node,
 			pgstromGpuCacheInitDSM(pts, ps_state);
 		if (pts->arrow_state)
 			pgstromArrowFdwInitDSM(pts->arrow_state, ps_state);
-		else
+		else if (!pts->file_state)
 			scan = table_beginscan(relation, estate->es_snapshot, 0, NULL);
 	}
-	ps_state->query_plan_id = ((uint64_t)MyProcPid) << 32 |
-		(uint64_t)pts->css.ss.ps.plan->plan_node_id;	
+	if (pts->pp_info->groupby_nsiblings > 0)
+	{
+		/* partition-wise GpuPreAgg siblings share the kds_final */
+		ps_state->query_plan_id = ((uint64_t)MyProcPid) << 32 | (1UL << 31) |
+			(uint64_t)pts->pp_info->groupby_sibling_id;
+	}
+	else
+	{
+		ps_state->query_plan_id = ((uint64_t)MyProcPid) << 32 |
+			(uint64_t)pts->css.ss.ps.plan->plan_node_id;
+	}
 	ps_state->num_rels = num_rels;
 	ConditionVariableInit(&ps_state->preload_cond);
 	SpinLockInit(&ps_state->preload_mutex);
 	if (num_rels > 0)
-		ps_state->preload_shmem_handle = __shmemCreate(pts->ds_entry);
+		ps_state->preload_shmem_handle = __shmemCreate(GpuJoinInnerShmemEntry(pts));
 	pts->ps_state = ps_state;
 	pts->css.ss.ss_currentScanDesc = scan;
 }
@@ -2141,10 +3392,7 @@ pgstromSharedStateAttachDSM(CustomScanState *node,
 	int			num_rels = list_length(pts->css.custom_ps);
 	int			num_devs = 0;
 
-	if ((pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0)
-		num_devs = numGpuDevAttrs;
-	else if ((pts->xpu_task_flags & DEVKIND__NVIDIA_DPU) != 0)
-		num_devs = DpuStorageEntryCount();
+	num_devs = pgstromTaskStateNumDevs(pts);
 
 	if (pts->br_state)
 		dsm_addr += pgstromBrinIndexAttachDSM(pts, dsm_addr);
@@ -2244,7 +3492,14 @@ pgstromGpuDirectExplain(pgstromTaskState *pts,
 		appendStringInfo(&buf, "%s (", (bms_is_empty(pts->optimal_gpus)
 										? "disabled"
 										: "enabled"));
-		if (!pgstrom_regression_test_mode && conn)
+		if (!pgstrom_regression_test_mode && pts->num_mgpu_conns > 0)
+		{
+			for (int i=0; i < pts->num_mgpu_conns; i++)
+				appendStringInfo(&buf, "%s%s", (i > 0 ? ", " : ""),
+								 pts->mgpu_conns[i]->devname);
+			appendStringInfo(&buf, "; ");
+		}
+		else if (!pgstrom_regression_test_mode && conn)
 			appendStringInfo(&buf, "%s; ", conn->devname);
 		pos = buf.len;
 
@@ -2275,6 +3530,70 @@ pgstromGpuDirectExplain(pgstromTaskState *pts,
 	pfree(buf.data);
 }
 
+/*
+ * pgstromGpuProfileExplain
+ *
+ * device profiling counters; only EXPLAIN (ANALYZE, VERBOSE) because the
+ * timings are not stable.
+ */
+static void
+pgstromGpuProfileExplain(pgstromTaskState *pts, ExplainState *es)
+{
+	pgstromSharedState *ps_state = pts->ps_state;
+	uint64_t	ntasks;
+	uint64_t	occupancy;
+
+	if (!es->analyze || !es->verbose || !ps_state ||
+		(pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0 ||
+		pgstrom_regression_test_mode)
+		return;
+	ntasks = pg_atomic_read_u64(&ps_state->prof_ntasks);
+	if (ntasks == 0)
+		return;
+	occupancy = pg_atomic_read_u64(&ps_state->prof_occupancy);
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		StringInfoData	buf;
+
+		initStringInfo(&buf);
+		appendStringInfo(&buf, "tasks=%lu, kernels=%lu, resumes=%lu, "
+						 "h2d=%s (%.2fms), d2h=%s, kernel=%.2fms, occupancy=%.1f%%",
+						 ntasks,
+						 pg_atomic_read_u64(&ps_state->prof_nkernels),
+						 pg_atomic_read_u64(&ps_state->prof_nresumes),
+						 format_bytesz(pg_atomic_read_u64(&ps_state->prof_h2d_bytes)),
+						 (double)pg_atomic_read_u64(&ps_state->prof_h2d_usec) / 1000.0,
+						 format_bytesz(pg_atomic_read_u64(&ps_state->prof_d2h_bytes)),
+						 (double)pg_atomic_read_u64(&ps_state->prof_kern_usec) / 1000.0,
+						 (double)occupancy / (10.0 * (double)ntasks));
+		ExplainPropertyText("GPU Profile", buf.data, es);
+		pfree(buf.data);
+	}
+	else
+	{
+		ExplainOpenGroup("GPU Profile", "GPU Profile", true, es);
+		ExplainPropertyUInteger("Tasks", NULL, ntasks, es);
+		ExplainPropertyUInteger("Kernel Launches", NULL,
+								pg_atomic_read_u64(&ps_state->prof_nkernels), es);
+		ExplainPropertyUInteger("Suspend/Resume", NULL,
+								pg_atomic_read_u64(&ps_state->prof_nresumes), es);
+		ExplainPropertyUInteger("H2D Bytes", "bytes",
+								pg_atomic_read_u64(&ps_state->prof_h2d_bytes), es);
+		ExplainPropertyFloat("H2D Time", "ms",
+							 (double)pg_atomic_read_u64(&ps_state->prof_h2d_usec) / 1000.0,
+							 3, es);
+		ExplainPropertyUInteger("D2H Bytes", "bytes",
+								pg_atomic_read_u64(&ps_state->prof_d2h_bytes), es);
+		ExplainPropertyFloat("Kernel Time", "ms",
+							 (double)pg_atomic_read_u64(&ps_state->prof_kern_usec) / 1000.0,
+							 3, es);
+		ExplainPropertyFloat("Occupancy", "%",
+							 (double)occupancy / (10.0 * (double)ntasks),
+							 1, es);
+		ExplainCloseGroup("GPU Profile", "GPU Profile", true, es);
+	}
+}
+
 /*
  * pgstromExplainTaskState
  */
@@ -2459,18 +3778,58 @@ pgstromExplainTaskState(CustomScanState *node,
 					 "%s Inner Hash [%d]", xpu_label, i+1);
 			ExplainPropertyText(label, buf.data, es);
 		}
+		if (pp_inner->dfilter_keynum > 0)
+		{
+			Node   *outer_key = list_nth(pp_inner->hash_outer_keys,
+										 pp_inner->dfilter_keynum - 1);
+			EState *estate = pts->css.ss.ps.state;
+
+			resetStringInfo(&buf);
+			str = deparse_expression(outer_key, dcontext, verbose, true);
+			appendStringInfo(&buf, "%s BETWEEN $%d AND $%d", str,
+							 pp_inner->dfilter_param_id,
+							 pp_inner->dfilter_param_id + 1);
+			if (es->analyze && pts->h_kmrels)
+			{
+				ParamExecData *prm = &estate->es_param_exec_vals[pp_inner->dfilter_param_id];
+				Oid		type_output;
+				bool	type_is_varlena;
+
+				getTypeOutputInfo(exprType(outer_key),
+								  &type_output,
+								  &type_is_varlena);
+				appendStringInfo(&buf, " [range: %s .. %s]",
+								 OidOutputFunctionCall(type_output, prm[0].value),
+								 OidOutputFunctionCall(type_output, prm[1].value));
+			}
+			snprintf(label, sizeof(label),
+					 "%s Dynamic Filter [%d]", xpu_label, i+1);
+			ExplainPropertyText(label, buf.data, es);
+		}
+		if (es->analyze && pts->inner_batch_depth == i+1)
+		{
+			snprintf(label, sizeof(label),
+					 "%s Hash Batches [%d]", xpu_label, i+1);
+			ExplainPropertyInteger(label, NULL, pts->inner_nbatches, es);
+		}
 		if (pp_inner->gist_clause)
 		{
-			char   *idxname = get_rel_name(pp_inner->gist_index_oid);
-			char   *colname = get_attname(pp_inner->gist_index_oid,
-										  pp_inner->gist_index_col, false);
 			resetStringInfo(&buf);
 
 			str = deparse_expression((Node *)pp_inner->gist_clause,
 									 dcontext, verbose, true);
 			appendStringInfoString(&buf, str);
-			if (idxname && colname)
-				appendStringInfo(&buf, " on %s (%s)", idxname, colname);
+			if (OidIsValid(pp_inner->gist_index_oid))
+			{
+				char   *idxname = get_rel_name(pp_inner->gist_index_oid);
+				char   *colname = get_attname(pp_inner->gist_index_oid,
+											  pp_inner->gist_index_col, true);
+				if (idxname && colname)
+					appendStringInfo(&buf, " on %s (%s)", idxname, colname);
+			}
+			else
+				appendStringInfo(&buf, " on R-tree (%.0f nodes)",
+								 pp_inner->gist_npages);
 			if (es->analyze && ps_state)
 			{
 				appendStringInfo(&buf, " [fetched: %lu]",
@@ -2480,10 +3839,117 @@ pgstromExplainTaskState(CustomScanState *node,
 					 "%s GiST Join [%d]", xpu_label, i+1);
 			ExplainPropertyText(label, buf.data, es);
 		}
+		if (pp_inner->range_inner_key &&
+			(exprType((Node *)pp_inner->range_inner_key) == INETOID ||
+			 exprType((Node *)pp_inner->range_inner_key) == CIDROID))
+		{
+			resetStringInfo(&buf);
+			str = deparse_expression((Node *)pp_inner->range_inner_key,
+									 dcontext, verbose, true);
+			appendStringInfo(&buf, "%s >>= ", str);
+			str = deparse_expression((Node *)pp_inner->range_outer_lower,
+									 dcontext, verbose, true);
+			appendStringInfoString(&buf, str);
+			snprintf(label, sizeof(label),
+					 "%s Inet Join [%d]", xpu_label, i+1);
+			ExplainPropertyText(label, buf.data, es);
+		}
+		else if (pp_inner->range_inner_key)
+		{
+			resetStringInfo(&buf);
+			if (pp_inner->range_outer_lower)
+			{
+				str = deparse_expression((Node *)pp_inner->range_outer_lower,
+										 dcontext, verbose, true);
+				appendStringInfo(&buf, "%s <= ", str);
+			}
+			str = deparse_expression((Node *)pp_inner->range_inner_key,
+									 dcontext, verbose, true);
+			appendStringInfoString(&buf, str);
+			if (pp_inner->range_outer_upper)
+			{
+				str = deparse_expression((Node *)pp_inner->range_outer_upper,
+										 dcontext, verbose, true);
+				appendStringInfo(&buf, " <= %s", str);
+			}
+			snprintf(label, sizeof(label),
+					 "%s Range Join [%d]", xpu_label, i+1);
+			ExplainPropertyText(label, buf.data, es);
+		}
 	}
 	if (pp_info->sibling_param_id >= 0)
+	{
 		ExplainPropertyInteger("Inner Siblings-Id", NULL,
 							   pp_info->sibling_param_id, es);
+		if (es->analyze && pts->inner_sibling && pts->inner_sibling != pts)
+			ExplainPropertyInteger("Inner Buffer Shared with", NULL,
+								   pts->inner_sibling->css.ss.ps.plan->plan_node_id, es);
+	}
+	if (pp_info->groupby_nsiblings > 0)
+	{
+		resetStringInfo(&buf);
+		appendStringInfo(&buf, "shared by %d siblings (id: %d)",
+						 pp_info->groupby_nsiblings,
+						 pp_info->groupby_sibling_id);
+		snprintf(label, sizeof(label), "%s Final Buffer", xpu_label);
+		ExplainPropertyText(label, buf.data, es);
+	}
+	if (pp_info->groupby_streaming)
+	{
+		snprintf(label, sizeof(label), "%s Group-By Streaming", xpu_label);
+		ExplainPropertyText(label, "groups are returned for each chunk", es);
+	}
+	if (pp_info->gpusort_limit > 0)
+	{
+		TargetEntry *tle = list_nth(cscan->custom_scan_tlist,
+									pp_info->gpusort_resno - 1);
+
+		resetStringInfo(&buf);
+		str = deparse_expression((Node *)tle->expr, dcontext, verbose, true);
+		appendStringInfo(&buf, "%s %s NULLS %s [limit: %d]",
+						 str,
+						 pp_info->gpusort_desc ? "DESC" : "ASC",
+						 pp_info->gpusort_nulls_first ? "FIRST" : "LAST",
+						 pp_info->gpusort_limit);
+		snprintf(label, sizeof(label), "%s Sort Top-K", xpu_label);
+		ExplainPropertyText(label, buf.data, es);
+	}
+	if (pp_info->scan_limit > 0)
+	{
+		snprintf(label, sizeof(label), "%s Scan Limit", xpu_label);
+		ExplainPropertyInteger(label, NULL, pp_info->scan_limit, es);
+	}
+	if (pp_info->gpuwin_desc)
+	{
+		const kern_window_desc *kwin_desc = (const kern_window_desc *)
+			VARDATA(pp_info->gpuwin_desc);
+
+		resetStringInfo(&buf);
+		for (int k=0; k < kwin_desc->nkeys; k++)
+		{
+			const kern_window_key *wkey = &kwin_desc->keys[k];
+			TargetEntry *tle = list_nth(cscan->custom_scan_tlist,
+										wkey->resno - 1);
+
+			if (k == 0 && kwin_desc->npart_keys > 0)
+				appendStringInfoString(&buf, "PARTITION BY ");
+			else if (k == kwin_desc->npart_keys)
+				appendStringInfoString(&buf, k > 0 ? " ORDER BY " : "ORDER BY ");
+			else
+				appendStringInfoString(&buf, ", ");
+			str = deparse_expression((Node *)tle->expr, dcontext, verbose, true);
+			appendStringInfoString(&buf, str);
+			if (k >= kwin_desc->npart_keys)
+				appendStringInfo(&buf, " %s NULLS %s",
+								 wkey->desc ? "DESC" : "ASC",
+								 wkey->nulls_first ? "FIRST" : "LAST");
+		}
+		appendStringInfo(&buf, "%s%s UNBOUNDED PRECEDING",
+						 buf.len > 0 ? " " : "",
+						 kwin_desc->rows_frame ? "ROWS" : "RANGE");
+		snprintf(label, sizeof(label), "%s Window Keys", xpu_label);
+		ExplainPropertyText(label, buf.data, es);
+	}
 
 	/*
 	 * Storage related info
@@ -2495,6 +3961,11 @@ pgstromExplainTaskState(CustomScanState *node,
 							   es, dcontext);
 		pgstromGpuDirectExplain(pts, es, dcontext);
 	}
+	else if (pts->file_state)
+	{
+		/* file_fdw */
+		pgstromFileFdwExplain(pts, es);
+	}
 	else if (pts->gcache_desc)
 	{
 		/* GPU-Cache */
@@ -2514,9 +3985,38 @@ pgstromExplainTaskState(CustomScanState *node,
 	{
 		/* Normal Heap Storage */
 	}
+	/* Hybrid GpuScan also runs on the DPU */
+	if ((pp_info->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0 &&
+		pp_info->ds_entry != NULL)
+	{
+		ExplainPropertyText("Hybrid Scan", "GPU+DPU", es);
+		explainDpuStorageEntry(pp_info->ds_entry, es);
+	}
 	/* State of BRIN-index */
 	if (pts->br_state)
 		pgstromBrinIndexExplain(pts, dcontext, es);
+	/* State of zone-map */
+	if (pts->zm_state)
+		pgstromZoneMapExplain(pts, dcontext, es);
+	/* TABLESAMPLE, if any */
+	if (pp_info->tablesample_method != '\0')
+		pgstromTableSampleExplain(pts, es);
+	/* State of adaptive execution */
+	if (es->analyze && ps_state &&
+		pg_atomic_read_u32(&ps_state->adaptive_to_cpu) > 0)
+	{
+		resetStringInfo(&buf);
+		appendStringInfo(&buf, "to CPU: %u, to %s: %u, blocks by CPU: %lu",
+						 pg_atomic_read_u32(&ps_state->adaptive_to_cpu),
+						 xpu_label,
+						 pg_atomic_read_u32(&ps_state->adaptive_to_xpu),
+						 pg_atomic_read_u64(&ps_state->adaptive_cpu_blocks));
+		ExplainPropertyText("Adaptive Exec", buf.data, es);
+	}
+	if (es->analyze && pts->cpu_direct_scan)
+		ExplainPropertyBool("CPU Direct Scan", true, es);
+	/* device profiling counters */
+	pgstromGpuProfileExplain(pts, es);
 
 	/*
 	 * Dump the XPU code (only if verbose)
@@ -2540,9 +4040,15 @@ pgstromExplainTaskState(CustomScanState *node,
 		pgstrom_explain_xpucode(&pts->css, es, dcontext,
 								"Join HashValue OpCode",
 								pp_info->kexp_hash_keys_packed);
+		pgstrom_explain_xpucode(&pts->css, es, dcontext,
+								"Inner HashValue OpCode",
+								pp_info->kexp_hash_inner_packed);
 		pgstrom_explain_xpucode(&pts->css, es, dcontext,
 								"GiST-Index Join OpCode",
 								pp_info->kexp_gist_evals_packed);
+		pgstrom_explain_xpucode(&pts->css, es, dcontext,
+								"Range Join Keys OpCode",
+								pp_info->kexp_range_keys_packed);
 		pgstrom_explain_xpucode(&pts->css, es, dcontext,
 								"Projection OpCode",
 								pp_info->kexp_projection);
@@ -2599,6 +4105,7 @@ __xpuClientOpenSession(pgstromTaskState *pts,
 	conn->num_ready_cmds = 0;
 	dlist_init(&conn->ready_cmds_list);
 	dlist_init(&conn->active_cmds_list);
+	conn->staging_ring = pts->staging_ring;
 	dlist_push_tail(&xpu_connections_list, &conn->chain);
 	pts->conn = conn;
 
@@ -2634,6 +4141,97 @@ __xpuClientOpenSession(pgstromTaskState *pts,
 void
 pgstrom_init_executor(void)
 {
+	/* GUC: pg_strom.scan_prefetch_depth */
+	DefineCustomIntVariable("pg_strom.scan_prefetch_depth",
+							"Number of chunks to be in flight per scan (0 = adaptive)",
+							NULL,
+							&pgstrom_scan_prefetch_depth,
+							0,
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	/* GUC: pg_strom.gpu_mem_quota */
+	DefineCustomIntVariable("pg_strom.gpu_mem_quota",
+							"Device memory quota per query (0 = unlimited)",
+							NULL,
+							&pgstrom_gpu_mem_quota_mb,
+							0,
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_MB,
+							NULL, NULL, NULL);
+	/* GUC: pg_strom.enable_adaptive_exec */
+	DefineCustomBoolVariable("pg_strom.enable_adaptive_exec",
+							 "Enables to switch GPU/DPU scan to CPU by the runtime statistics",
+							 NULL,
+							 &pgstrom_enable_adaptive_exec,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* GUC: pg_strom.adaptive_fallback_threshold */
+	DefineCustomRealVariable("pg_strom.adaptive_fallback_threshold",
+							 "Fallback ratio to switch GPU/DPU scan to CPU",
+							 NULL,
+							 &pgstrom_adaptive_fallback_threshold,
+							 0.5,
+							 0.0,
+							 1.0,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* GUC: pg_strom.cpu_direct_scan_threshold */
+	DefineCustomIntVariable("pg_strom.cpu_direct_scan_threshold",
+							"Max number of blocks to scan by CPU without GPU/DPU sessions",
+							NULL,
+							&pgstrom_cpu_direct_scan_threshold,
+							0,
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_BLOCKS,
+							NULL, NULL, NULL);
+	/* GUC: pg_strom.enable_adaptive_chunk_size */
+	DefineCustomBoolVariable("pg_strom.enable_adaptive_chunk_size",
+							 "Enables to adjust the number of blocks per chunk by the runtime statistics",
+							 NULL,
+							 &pgstrom_enable_adaptive_chunk_size,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* GUC: pg_strom.gpu_scan_max_devices */
+	DefineCustomIntVariable("pg_strom.gpu_scan_max_devices",
+							"Max number of GPUs that a scan without parallel workers uses",
+							NULL,
+							&pgstrom_gpu_scan_max_devices,
+							1,
+							1,
+							64,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	/* GUC: pg_strom.enable_columnar_projection */
+	DefineCustomBoolVariable("pg_strom.enable_columnar_projection",
+							 "Enables GPU projection results in columnar format",
+							 NULL,
+							 &pgstrom_enable_columnar_projection,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* GUC: pg_strom.enable_columnar_dictionary */
+	DefineCustomBoolVariable("pg_strom.enable_columnar_dictionary",
+							 "Enables columnar projection results with varlena columns, using dictionary of the repeated values",
+							 NULL,
+							 &pgstrom_enable_columnar_dictionary,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	dlist_init(&xpu_connections_list);
 	RegisterResourceReleaseCallback(xpuclientCleanupConnections, NULL);
 }
@@ -10,6 +10,9 @@
  * it under the terms of the PostgreSQL License.
  */
 #include <dlfcn.h>
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
 #include "pg_strom.h"
 
 
@@ -19,6 +22,11 @@
 static int		gpudirect_driver_kind;
 static __thread void   *gpudirect_vfs_dma_buffer = NULL;
 static __thread size_t	gpudirect_vfs_dma_buffer_sz = 0UL;
+static int		gpudirect_vfs_uring_depth;		/* GUC */
+#ifdef HAVE_LIBURING
+static __thread struct io_uring *gpudirect_vfs_uring = NULL;
+static __thread bool	gpudirect_vfs_uring_failed = false;
+#endif
 
 /*
  * heterodbExtraModuleInfo
@@ -358,9 +366,8 @@ gpuDirectRegisterStream(CUstream cuda_stream)
 		case GPUDIRECT_DRIVER__CUFILE:
 			/*
 			 * NOTE: CU_FILE_STREAM_* labels are defined at CUDA12.2,
-			 * so older CUDA version leads build errors. Right now,
-			 * we don't use Async-Read APIs, so tentatively put the
-			 * equivalent immidiate value.
+			 * so older CUDA version leads build errors. So, we put
+			 * the equivalent immidiate value for the Async-Read APIs.
 			 */
 			if (p_cufile__register_stream_v3 == NULL ||
 				p_cufile__register_stream_v3(cuda_stream, 15) != 0)
@@ -521,6 +528,295 @@ static int	(*p_vfs_fallback__read_file_iov)(
 	uint32_t *p_npages_direct_read,
 	uint32_t *p_npages_vfs_read) = NULL;
 
+#ifdef HAVE_LIBURING
+/*
+ * __gpuDirectSetupUringOnDemand
+ *
+ * It sets up the io_uring of the current thread, with the DMA buffer
+ * registered as a fixed buffer.
+ */
+static bool
+__gpuDirectSetupUringOnDemand(void)
+{
+	struct io_uring *ring;
+	struct iovec	iov;
+	int				rv;
+
+	if (gpudirect_vfs_uring)
+		return true;
+	if (gpudirect_vfs_uring_depth <= 0 || gpudirect_vfs_uring_failed)
+		return false;
+	ring = calloc(1, sizeof(struct io_uring));
+	if (!ring)
+		goto error_0;
+	rv = io_uring_queue_init(gpudirect_vfs_uring_depth, ring, 0);
+	if (rv < 0)
+	{
+		fprintf(stderr, "failed on io_uring_queue_init: %s\n", strerror(-rv));
+		goto error_1;
+	}
+	iov.iov_base = gpudirect_vfs_dma_buffer;
+	iov.iov_len  = gpudirect_vfs_dma_buffer_sz;
+	rv = io_uring_register_buffers(ring, &iov, 1);
+	if (rv < 0)
+	{
+		fprintf(stderr, "failed on io_uring_register_buffers: %s\n", strerror(-rv));
+		goto error_2;
+	}
+	gpudirect_vfs_uring = ring;
+	return true;
+
+error_2:
+	io_uring_queue_exit(ring);
+error_1:
+	free(ring);
+error_0:
+	/* never try again; use the synchronous fallback */
+	gpudirect_vfs_uring_failed = true;
+	return false;
+}
+
+/*
+ * __uringFileReadIOV
+ *
+ * It loads the iovec using io_uring with deep queue depth. The DMA buffer
+ * is split into slots per queue entry, then the slot is copied to the device
+ * memory on the completion, while other read requests are still in-flight.
+ */
+typedef struct
+{
+	off_t		file_pos;
+	off_t		dest_pos;
+	size_t		length;
+	char	   *buffer;
+} uringReadSlot;
+
+static bool
+__uringSubmitRead(struct io_uring *ring, int fdesc, uringReadSlot *slot)
+{
+	struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+
+	if (!sqe)
+		return false;
+	io_uring_prep_read_fixed(sqe, fdesc,
+							 slot->buffer,
+							 slot->length,
+							 slot->file_pos, 0);
+	io_uring_sqe_set_data(sqe, slot);
+	return true;
+}
+
+static bool
+__uringFileReadIOV(const char *pathname,
+				   CUdeviceptr m_segment,
+				   off_t m_offset,
+				   const strom_io_vector *iovec,
+				   uint32_t *p_npages_direct_read,
+				   uint32_t *p_npages_vfs_read)
+{
+	struct io_uring *ring = gpudirect_vfs_uring;
+	uringReadSlot *slots;
+	uringReadSlot **free_slots;
+	int			nslots = gpudirect_vfs_uring_depth;
+	int			nfree = 0;
+	int			ninflight = 0;
+	size_t		slot_sz;
+	int			fdesc;
+	int			i = 0;
+	size_t		remained = 0;
+	off_t		file_pos = 0;
+	off_t		dest_pos = 0;
+	uint32_t	nr_pages = 0;
+	struct stat	stat_buf;
+	bool		retval = false;
+
+	slot_sz = PAGE_ALIGN_DOWN(gpudirect_vfs_dma_buffer_sz / nslots);
+	if (slot_sz == 0)
+		return false;
+	slots = alloca(sizeof(uringReadSlot) * nslots);
+	free_slots = alloca(sizeof(uringReadSlot *) * nslots);
+	for (int k=0; k < nslots; k++)
+	{
+		slots[k].buffer = (char *)gpudirect_vfs_dma_buffer + k * slot_sz;
+		free_slots[nfree++] = &slots[k];
+	}
+
+	fdesc = open(pathname, O_RDONLY);
+	if (fdesc < 0)
+	{
+		fprintf(stderr, "failed on open('%s'): %m\n", pathname);
+		return false;
+	}
+	if (fstat(fdesc, &stat_buf) != 0)
+	{
+		fprintf(stderr, "failed on fstat('%s'): %m\n", pathname);
+		goto bailout;
+	}
+
+	for (;;)
+	{
+		struct io_uring_cqe *cqe;
+		uringReadSlot *slot;
+		int			rv;
+
+		/* fill up the submission queue */
+		while (nfree > 0)
+		{
+			if (remained == 0)
+			{
+				const strom_io_chunk *ioc;
+
+				if (i >= iovec->nr_chunks)
+					break;
+				ioc = &iovec->ioc[i++];
+				remained = ioc->nr_pages * PAGE_SIZE;
+				file_pos = ioc->fchunk_id * PAGE_SIZE;
+				dest_pos = m_offset + ioc->m_offset;
+				nr_pages += ioc->nr_pages;
+				/* cut off the file tail */
+				if (file_pos >= stat_buf.st_size)
+					remained = 0;
+				else if (file_pos + remained > stat_buf.st_size)
+					remained = stat_buf.st_size - file_pos;
+				continue;
+			}
+			slot = free_slots[--nfree];
+			slot->file_pos = file_pos;
+			slot->dest_pos = dest_pos;
+			slot->length   = Min(remained, slot_sz);
+			if (!__uringSubmitRead(ring, fdesc, slot))
+			{
+				free_slots[nfree++] = slot;
+				break;
+			}
+			ninflight++;
+			file_pos += slot->length;
+			dest_pos += slot->length;
+			remained -= slot->length;
+		}
+		if (ninflight == 0)
+			break;		/* all done */
+		rv = io_uring_submit_and_wait(ring, 1);
+		if (rv < 0)
+		{
+			if (rv == -EINTR)
+				continue;
+			fprintf(stderr, "failed on io_uring_submit_and_wait: %s\n",
+					strerror(-rv));
+			goto bailout;
+		}
+		/* handle the completions */
+		while (io_uring_peek_cqe(ring, &cqe) == 0)
+		{
+			CUresult	rc;
+
+			slot = io_uring_cqe_get_data(cqe);
+			rv = cqe->res;
+			io_uring_cqe_seen(ring, cqe);
+			ninflight--;
+			if (rv <= 0)
+			{
+				if (rv == -EINTR || rv == -EAGAIN)
+				{
+					if (__uringSubmitRead(ring, fdesc, slot))
+					{
+						ninflight++;
+						continue;
+					}
+				}
+				fprintf(stderr, "failed on io_uring read: %s\n",
+						rv < 0 ? strerror(-rv) : "unexpected EOF");
+				goto bailout;
+			}
+			rc = cuMemcpyHtoD(m_segment + slot->dest_pos, slot->buffer, rv);
+			if (rc != CUDA_SUCCESS)
+			{
+				fprintf(stderr, "failed on cuMemcpyHtoD\n");
+				goto bailout;
+			}
+			if (rv < slot->length)
+			{
+				/* short read, so read the remaining portion again */
+				slot->file_pos += rv;
+				slot->dest_pos += rv;
+				slot->length   -= rv;
+				if (__uringSubmitRead(ring, fdesc, slot))
+				{
+					ninflight++;
+					continue;
+				}
+				fprintf(stderr, "failed on io_uring_get_sqe\n");
+				goto bailout;
+			}
+			free_slots[nfree++] = slot;
+		}
+	}
+	/* update statistics */
+	if (p_npages_direct_read)
+		*p_npages_direct_read = 0;
+	if (p_npages_vfs_read)
+		*p_npages_vfs_read = nr_pages;
+	retval = true;
+bailout:
+	/* wait for the in-flight requests, not to reuse the buffer */
+	while (ninflight > 0)
+	{
+		struct io_uring_cqe *cqe;
+
+		if (io_uring_wait_cqe(ring, &cqe) != 0)
+			break;
+		io_uring_cqe_seen(ring, cqe);
+		ninflight--;
+	}
+	close(fdesc);
+	return retval;
+}
+#endif	/* HAVE_LIBURING */
+
+/*
+ * __vfsFileReadIOV
+ *
+ * read the iovec by the regular filesystem; using io_uring if available.
+ */
+static bool
+__vfsFileReadIOV(const char *pathname,
+				 CUdeviceptr m_segment,
+				 off_t m_offset,
+				 const strom_io_vector *iovec,
+				 uint32_t *p_npages_direct_read,
+				 uint32_t *p_npages_vfs_read)
+{
+	if (!__gpuDirectAllocDMABufferOnDemand())
+		return false;
+#ifdef HAVE_LIBURING
+	if (__gpuDirectSetupUringOnDemand())
+		return __uringFileReadIOV(pathname,
+								  m_segment,
+								  m_offset,
+								  iovec,
+								  p_npages_direct_read,
+								  p_npages_vfs_read);
+#endif
+	if (p_vfs_fallback__read_file_iov)
+		return (p_vfs_fallback__read_file_iov(pathname,
+											  m_segment,
+											  m_offset,
+											  gpudirect_vfs_dma_buffer,
+											  gpudirect_vfs_dma_buffer_sz,
+											  NULL,
+											  iovec,
+											  p_npages_direct_read,
+											  p_npages_vfs_read) == 0);
+	return __fallbackFileReadIOV(pathname,
+								 m_segment,
+								 m_offset,
+								 gpudirect_vfs_dma_buffer,
+								 gpudirect_vfs_dma_buffer_sz,
+								 iovec,
+								 p_npages_direct_read,
+								 p_npages_vfs_read);
+}
+
 bool
 gpuDirectFileReadIOV(const char *pathname,
 					 CUdeviceptr m_segment,
@@ -550,36 +846,16 @@ gpuDirectFileReadIOV(const char *pathname,
 													p_npages_direct_read,
 													p_npages_vfs_read) == 0);
 			break;
-		case GPUDIRECT_DRIVER__VFS:
-			if (p_vfs_fallback__read_file_iov)
-			{
-				if (!__gpuDirectAllocDMABufferOnDemand())
-					return false;
-				return (p_vfs_fallback__read_file_iov(pathname,
-													  m_segment,
-													  m_offset,
-													  gpudirect_vfs_dma_buffer,
-													  gpudirect_vfs_dma_buffer_sz,
-													  NULL,
-													  iovec,
-													  p_npages_direct_read,
-													  p_npages_vfs_read) == 0);
-			}
-			break;
 		default:
 			break;
 	}
 	/* fallback using regular filesystem */
-	if (!__gpuDirectAllocDMABufferOnDemand())
-		return false;
-	return __fallbackFileReadIOV(pathname,
-								 m_segment,
-								 m_offset,
-								 gpudirect_vfs_dma_buffer,
-								 gpudirect_vfs_dma_buffer_sz,
-								 iovec,
-								 p_npages_direct_read,
-								 p_npages_vfs_read);
+	return __vfsFileReadIOV(pathname,
+							m_segment,
+							m_offset,
+							iovec,
+							p_npages_direct_read,
+							p_npages_vfs_read);
 }
 
 /*
@@ -609,7 +885,7 @@ gpuDirectFileReadAsyncIOV(const char *pathname,
 	switch (gpudirect_driver_kind)
 	{
 		case GPUDIRECT_DRIVER__CUFILE:
-			if (p_cufile__read_file_iov_v3)
+			if (p_cufile__read_file_async_iov_v3)
 				return (p_cufile__read_file_async_iov_v3(pathname,
 														 m_segment,
 														 m_offset,
@@ -825,6 +1101,20 @@ pgstrom_init_extra(void)
 	int			enum_index = 0;
 	static struct config_enum_entry enum_options[4];
 
+	DefineCustomIntVariable("pg_strom.gpudirect_vfs_uring_depth",
+							"Queue depth of io_uring for the VFS fallback reader (0 = disabled)",
+							NULL,
+							&gpudirect_vfs_uring_depth,
+#ifdef HAVE_LIBURING
+							64,
+#else
+							0,
+#endif
+							0,
+							1024,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
 	/* load the extra module */
 	handle = dlopen(HETERODB_EXTRA_FILENAME,
 					RTLD_NOW | RTLD_LOCAL);
@@ -1165,3 +1165,71 @@ pgstrom_float2_sum(PG_FUNCTION_ARGS)
 	}
 	PG_RETURN_FLOAT8(newval);
 }
+
+/*
+ * dot product / cosine similarity of float2[]
+ *
+ * Accumulation is done in fp32, as the device functions doing.
+ */
+static void
+__float2_array_dot_sums(ArrayType *a, ArrayType *b,
+						float *p_dot, float *p_norma, float *p_normb)
+{
+	const uint16   *av = (const uint16 *)ARR_DATA_PTR(a);
+	const uint16   *bv = (const uint16 *)ARR_DATA_PTR(b);
+	int				nitems;
+	float			dot = 0.0;
+	float			norma = 0.0;
+	float			normb = 0.0;
+
+	if (ARR_HASNULL(a) || ARR_HASNULL(b))
+		elog(ERROR, "float2 array must not contain NULLs");
+	nitems = ArrayGetNItems(ARR_NDIM(a), ARR_DIMS(a));
+	if (nitems != ArrayGetNItems(ARR_NDIM(b), ARR_DIMS(b)))
+		elog(ERROR, "different float2 array dimensions");
+	for (int i=0; i < nitems; i++)
+	{
+		float	ax = fp16_to_fp32(__short_as_half__(av[i]));
+		float	bx = fp16_to_fp32(__short_as_half__(bv[i]));
+
+		dot += ax * bx;
+		norma += ax * ax;
+		normb += bx * bx;
+	}
+	*p_dot = dot;
+	if (p_norma)
+		*p_norma = norma;
+	if (p_normb)
+		*p_normb = normb;
+}
+
+PG_FUNCTION_INFO_V1(pgstrom_float2_dot_product);
+PUBLIC_FUNCTION(Datum)
+pgstrom_float2_dot_product(PG_FUNCTION_ARGS)
+{
+	ArrayType  *a = PG_GETARG_ARRAYTYPE_P(0);
+	ArrayType  *b = PG_GETARG_ARRAYTYPE_P(1);
+	float		dot;
+
+	__float2_array_dot_sums(a, b, &dot, NULL, NULL);
+	PG_RETURN_FLOAT8((double)dot);
+}
+
+PG_FUNCTION_INFO_V1(pgstrom_float2_cosine_similarity);
+PUBLIC_FUNCTION(Datum)
+pgstrom_float2_cosine_similarity(PG_FUNCTION_ARGS)
+{
+	ArrayType  *a = PG_GETARG_ARRAYTYPE_P(0);
+	ArrayType  *b = PG_GETARG_ARRAYTYPE_P(1);
+	float		dot, norma, normb;
+	double		similarity;
+
+	__float2_array_dot_sums(a, b, &dot, &norma, &normb);
+	similarity = ((double)dot / sqrt((double)norma * (double)normb));
+	/* keep in range; NaN (zero vector) is propagated as is */
+	if (similarity > 1.0)
+		similarity = 1.0;
+	else if (similarity < -1.0)
+		similarity = -1.0;
+	PG_RETURN_FLOAT8(similarity);
+}
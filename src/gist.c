@@ -283,7 +283,7 @@ __get_func_signature(Oid func_oid)
  * fixup_gist_clause_for_device
  */
 static Oid
-__lookup_gist_device_function(Oid opno, Oid left_oid, Oid right_oid, Oid gist_oid)
+__lookup_gist_device_function(Oid func_oid, Oid left_oid, Oid right_oid, Oid gist_oid)
 {
 	char	   *orig_fname;
 	char	   *orig_left;
@@ -292,7 +292,7 @@ __lookup_gist_device_function(Oid opno, Oid left_oid, Oid right_oid, Oid gist_oi
 	char	   *gist_right;
 	oidvector  *gist_argtypes;
 
-	orig_fname = __get_func_signature(get_opcode(opno));
+	orig_fname = __get_func_signature(func_oid);
 	orig_left  = __get_type_signature(left_oid);
 	orig_right = __get_type_signature(right_oid);
 	gist_left  = __get_type_signature(gist_oid);
@@ -405,7 +405,7 @@ fixup_gist_clause_for_device(PlannerInfo *root,
 	else
 		return false;
 
-	func_oid = __lookup_gist_device_function(op->opno,
+	func_oid = __lookup_gist_device_function(get_opcode(op->opno),
 											 left_oid,
 											 right_oid,
 											 gist_oid);
@@ -635,5 +635,600 @@ pgstromTryFindGistIndex(PlannerInfo *root,
 	pp_inner->gist_selectivity     = gist_selectivity;
 	pp_inner->gist_npages          = gist_index->pages;
 	pp_inner->gist_height          = gist_index->tree_height;
+	pp_inner->gist_key_type        = get_atttype(gist_index->indexoid,
+												 gist_index_col);
 	return inner_path;
 }
+
+/*
+ * Spatial join without GiST index
+ *
+ * If inner relation has no GiST index on the geometry column, the inner
+ * preloader builds a temporary R-tree over the bounding-boxes of the inner
+ * geometries (STR bulk loading), in the same page layout of GiST index.
+ * Then, GPU kernel probes it from the outer side as if GiST-Index Join.
+ */
+static Oid
+__lookup_postgis_function(Oid nsp_oid, const char *func_name,
+						  Oid type1, Oid type2)
+{
+	oidvector  *argtypes = __buildoidvector2(type1, type2);
+
+	return GetSysCacheOid3(PROCNAMEARGSNSP,
+						   Anum_pg_proc_oid,
+						   CStringGetDatum(func_name),
+						   PointerGetDatum(argtypes),
+						   ObjectIdGetDatum(nsp_oid));
+}
+
+/*
+ * __build_spatial_join_clause
+ *
+ * It builds an index clause in the form of (inner_geom OP outer_expr),
+ * where OP is one of geometry_overlaps, geometry_contains or geometry_within,
+ * from the join clause that is a supported spatial relationship.
+ */
+static Expr *
+__build_spatial_join_clause(PlannerInfo *root,
+							RelOptInfo *inner_rel,
+							Expr *clause,
+							Oid *p_geom_oid)
+{
+	Oid			func_oid;
+	List	   *func_args;
+	const char *func_name;
+	const char *gist_fname = NULL;
+	Expr	   *inner_arg;
+	Expr	   *outer_arg;
+	Relids		relids1;
+	Relids		relids2;
+	Oid			geom_oid;
+	Oid			nsp_oid;
+	Oid			gist_func;
+	bool		inner_is_left;
+
+	if (IsA(clause, OpExpr))
+	{
+		func_oid  = get_opcode(((OpExpr *)clause)->opno);
+		func_args = ((OpExpr *)clause)->args;
+	}
+	else if (IsA(clause, FuncExpr))
+	{
+		func_oid  = ((FuncExpr *)clause)->funcid;
+		func_args = ((FuncExpr *)clause)->args;
+	}
+	else
+		return NULL;
+	if (list_length(func_args) < 2)
+		return NULL;
+	func_name = __get_func_signature(func_oid);
+
+	/* which side is inner relation? */
+	relids1 = pull_varnos(root, linitial(func_args));
+	relids2 = pull_varnos(root, lsecond(func_args));
+	if (!bms_is_empty(relids1) && bms_is_subset(relids1, inner_rel->relids) &&
+		!bms_is_empty(relids2) && !bms_overlap(relids2, inner_rel->relids))
+	{
+		inner_is_left = true;
+		inner_arg = linitial(func_args);
+		outer_arg = lsecond(func_args);
+	}
+	else if (!bms_is_empty(relids2) && bms_is_subset(relids2, inner_rel->relids) &&
+			 !bms_is_empty(relids1) && !bms_overlap(relids1, inner_rel->relids))
+	{
+		inner_is_left = false;
+		inner_arg = lsecond(func_args);
+		outer_arg = linitial(func_args);
+	}
+	else
+		return NULL;
+	geom_oid = exprType((Node *)inner_arg);
+	if (strcmp(__get_type_signature(geom_oid), __GEOM) != 0 ||
+		exprType((Node *)outer_arg) != geom_oid)
+		return NULL;
+	nsp_oid = get_func_namespace(func_oid);
+
+	if (strcmp(func_name, "st_contains" __POSTGIS) == 0 ||
+		strcmp(func_name, "geometry_contains" __POSTGIS) == 0)
+	{
+		if (list_length(func_args) != 2)
+			return NULL;
+		gist_fname = (inner_is_left ? "geometry_contains" : "geometry_within");
+	}
+	else if (strcmp(func_name, "geometry_within" __POSTGIS) == 0)
+	{
+		if (list_length(func_args) != 2)
+			return NULL;
+		gist_fname = (inner_is_left ? "geometry_within" : "geometry_contains");
+	}
+	else if (strcmp(func_name, "geometry_overlaps" __POSTGIS) == 0)
+	{
+		if (list_length(func_args) != 2)
+			return NULL;
+		gist_fname = "geometry_overlaps";
+	}
+	else if (strcmp(func_name, "st_dwithin" __POSTGIS) == 0)
+	{
+		Expr   *dist = lthird(func_args);
+		Oid		expand_func;
+
+		/* ST_DWithin(A,B,d) implies A && ST_Expand(B,d) */
+		if (list_length(func_args) != 3 ||
+			exprType((Node *)dist) != FLOAT8OID ||
+			bms_overlap(pull_varnos(root, (Node *)dist), inner_rel->relids))
+			return NULL;
+		expand_func = __lookup_postgis_function(nsp_oid, "st_expand",
+												geom_oid, FLOAT8OID);
+		if (!OidIsValid(expand_func))
+			return NULL;
+		outer_arg = (Expr *)makeFuncExpr(expand_func,
+										 geom_oid,
+										 list_make2(outer_arg, dist),
+										 InvalidOid,
+										 InvalidOid,
+										 COERCE_EXPLICIT_CALL);
+		gist_fname = "geometry_overlaps";
+	}
+	else
+		return NULL;
+
+	gist_func = __lookup_postgis_function(nsp_oid, gist_fname,
+										  geom_oid, geom_oid);
+	if (!OidIsValid(gist_func))
+		return NULL;
+	*p_geom_oid = geom_oid;
+	return (Expr *)makeFuncExpr(gist_func,
+								BOOLOID,
+								list_make2(inner_arg, outer_arg),
+								InvalidOid,
+								InvalidOid,
+								COERCE_EXPLICIT_CALL);
+}
+
+/*
+ * pgstromGistKeyIsBox2df
+ *
+ * It checks whether the GiST index key is box2df of PostGIS; that can be
+ * converted to the compact R-tree on the inner preloading.
+ */
+bool
+pgstromGistKeyIsBox2df(Oid type_oid)
+{
+	HeapTuple	tup;
+	Form_pg_type typ;
+	bool		retval;
+
+	tup = SearchSysCache1(TYPEOID, ObjectIdGetDatum(type_oid));
+	if (!HeapTupleIsValid(tup))
+		return false;
+	typ = (Form_pg_type) GETSTRUCT(tup);
+	retval = (strcmp(NameStr(typ->typname), "box2df") == 0 &&
+			  typ->typlen == 4 * sizeof(float));
+	ReleaseSysCache(tup);
+
+	return retval;
+}
+
+/*
+ * pgstromTryBuildSpatialIndex
+ */
+bool
+pgstromTryBuildSpatialIndex(PlannerInfo *root,
+							Path *inner_path,
+							List *restrict_clauses,
+							uint32_t xpu_task_flags,
+							Index base_scan_relid,
+							List *inner_target_list,
+							pgstromPlanInnerInfo *pp_inner)
+{
+	RelOptInfo *inner_rel = inner_path->parent;
+	Expr	   *gist_clause = NULL;
+	Oid			gist_func_oid = InvalidOid;
+	Oid			gist_key_type = InvalidOid;
+	Selectivity	gist_selectivity = 1.0;
+	ListCell   *lc;
+	double		nrows;
+	double		nitems_per_page;
+	double		npages;
+	int			height;
+
+	Assert(pp_inner->hash_outer_keys == NIL &&
+		   pp_inner->hash_inner_keys == NIL &&
+		   !OidIsValid(pp_inner->gist_index_oid));
+	foreach (lc, restrict_clauses)
+	{
+		RestrictInfo *rinfo = lfirst(lc);
+		Expr	   *__clause;
+		Oid			__geom_oid;
+		Oid			__key_type;
+		Oid			__func_oid;
+		Selectivity	__selectivity;
+		HeapTuple	tup;
+
+		if (rinfo->pseudoconstant ||
+			!rinfo->clause ||
+			restriction_is_or_clause(rinfo))
+			continue;
+		__clause = __build_spatial_join_clause(root, inner_rel,
+											   rinfo->clause,
+											   &__geom_oid);
+		if (!__clause)
+			continue;
+		/* index key is box2df on the same namespace with geometry */
+		tup = SearchSysCache1(TYPEOID, ObjectIdGetDatum(__geom_oid));
+		if (!HeapTupleIsValid(tup))
+			elog(ERROR, "cache lookup failed for type %u", __geom_oid);
+		__key_type = GetSysCacheOid2(TYPENAMENSP,
+									 Anum_pg_type_oid,
+									 CStringGetDatum("box2df"),
+									 ObjectIdGetDatum(((Form_pg_type)
+													   GETSTRUCT(tup))->typnamespace));
+		ReleaseSysCache(tup);
+		if (!OidIsValid(__key_type) ||
+			get_typlen(__key_type) != 4 * sizeof(float))
+			continue;
+		__func_oid = __lookup_gist_device_function(((FuncExpr *)__clause)->funcid,
+												   __geom_oid,
+												   __geom_oid,
+												   __key_type);
+		if (!OidIsValid(__func_oid) ||
+			!pgstrom_xpu_expression(__clause,
+									xpu_task_flags,
+									base_scan_relid,
+									inner_target_list,
+									NULL))
+			continue;
+		__selectivity = clauselist_selectivity(root,
+											   list_make1(__clause),
+											   0,
+											   JOIN_INNER,
+											   NULL);
+		if (!gist_clause || gist_selectivity > __selectivity)
+		{
+			gist_clause      = __clause;
+			gist_func_oid    = __func_oid;
+			gist_key_type    = __key_type;
+			gist_selectivity = __selectivity;
+		}
+	}
+	if (!gist_clause)
+		return false;
+
+	/* estimation of the R-tree size; see innerPreloadSpatialIndexNEntries */
+	nrows = Max(inner_path->rows, 1.0);
+	nitems_per_page = ((BLCKSZ - (SizeOfPageHeaderData +
+								  MAXALIGN(sizeof(GISTPageOpaqueData)))) /
+					   (MAXALIGN(sizeof(IndexTupleData) + 4 * sizeof(float)) +
+						sizeof(ItemIdData)));
+	npages = 0.0;
+	height = 0;
+	do {
+		nrows = ceil(nrows / nitems_per_page);
+		npages += nrows;
+		height++;
+	} while (nrows > 1.0);
+
+	pp_inner->gist_index_oid       = InvalidOid;
+	pp_inner->gist_index_col       = 1;
+	pp_inner->gist_ctid_resno      = -1;
+	pp_inner->gist_func_oid        = gist_func_oid;
+	pp_inner->gist_slot_id         = -1;	/* to be set later */
+	pp_inner->gist_clause          = gist_clause;
+	pp_inner->gist_selectivity     = gist_selectivity;
+	pp_inner->gist_npages          = npages;
+	pp_inner->gist_height          = height;
+	pp_inner->gist_key_type        = gist_key_type;
+	return true;
+}
+
+/*
+ * pgstromTryPrepareGeometry
+ *
+ * It picks up the inner geometry column that is the container argument of
+ * st_contains() in the join quals; its prepared form shall be built on the
+ * inner preloading (see pgstromBuildPrepPolygon).
+ */
+void
+pgstromTryPrepareGeometry(PathTarget *inner_target,
+						  pgstromPlanInnerInfo *pp_inner)
+{
+	ListCell   *lc1, *lc2;
+
+	foreach (lc1, pp_inner->join_quals)
+	{
+		FuncExpr   *func = lfirst(lc1);
+		Expr	   *arg;
+		int			resno = 1;
+
+		if (!IsA(func, FuncExpr) ||
+			list_length(func->args) != 2 ||
+			strcmp(__get_func_signature(func->funcid),
+				   "st_contains" __POSTGIS) != 0)
+			continue;
+		arg = linitial(func->args);
+		while (IsA(arg, RelabelType))
+			arg = ((RelabelType *)arg)->arg;
+		if (!IsA(arg, Var) ||
+			strcmp(__get_type_signature(exprType((Node *)arg)), __GEOM) != 0)
+			continue;
+		foreach (lc2, inner_target->exprs)
+		{
+			if (equal(arg, lfirst(lc2)))
+			{
+				pp_inner->gist_prep_resno = resno;
+				return;
+			}
+			resno++;
+		}
+	}
+}
+
+/*
+ * pgstromBuildPrepPolygon
+ *
+ * It builds kern_prep_polygon on the 'buf' from the (multi-)polygon datum,
+ * and returns its length. It returns 0 if the geometry is not a polygon,
+ * too small to be prepared, or the 'buf' has no space.
+ */
+typedef struct
+{
+	uint32_t	nrings;
+	uint32_t	nrooms_rings;
+	uint32_t   *ring_info;
+	uint32_t	nedges;
+	uint32_t	nrooms_edges;
+	kern_prep_edge *edges;
+	double		ymin;
+	double		ymax;
+} prep_polygon_builder;
+
+#define PREP_POLYGON_MIN_EDGES		16
+
+static const char *
+__prepPolygonLoadBody(prep_polygon_builder *pb,
+					  const char *pos, const char *end,
+					  uint32_t nrings, uint32_t ndims,
+					  uint32_t poly_index)
+{
+	const char *counts = pos;
+
+	pos += LONGALIGN(sizeof(uint32_t) * nrings);
+	if (pos > end)
+		return NULL;
+	for (uint32_t r=0; r < nrings; r++)
+	{
+		uint32_t	npoints;
+		size_t		unitsz = sizeof(double) * ndims;
+		uint32_t	ring_id;
+
+		memcpy(&npoints, counts + sizeof(uint32_t) * r, sizeof(uint32_t));
+		if (pos + unitsz * npoints > end)
+			return NULL;
+		if (pb->nrings >= pb->nrooms_rings)
+		{
+			pb->nrooms_rings = 2 * pb->nrooms_rings + 32;
+			pb->ring_info = repalloc(pb->ring_info, sizeof(uint32_t) *
+									 pb->nrooms_rings);
+		}
+		ring_id = pb->nrings++;
+		pb->ring_info[ring_id] = ((poly_index << 1) | (r > 0 ? 1 : 0));
+
+		for (uint32_t i=1; i < npoints; i++)
+		{
+			kern_prep_edge *edge;
+			double		p1[2];
+			double		p2[2];
+
+			memcpy(p1, pos + unitsz * (i-1), sizeof(double) * 2);
+			memcpy(p2, pos + unitsz * i,     sizeof(double) * 2);
+			/* zero length segments are ignored. */
+			if (p1[0] == p2[0] && p1[1] == p2[1])
+				continue;
+			if (pb->nedges >= pb->nrooms_edges)
+			{
+				pb->nrooms_edges = 2 * pb->nrooms_edges + 256;
+				pb->edges = repalloc_huge(pb->edges, sizeof(kern_prep_edge) *
+										  pb->nrooms_edges);
+			}
+			edge = &pb->edges[pb->nedges++];
+			edge->x1 = p1[0];
+			edge->y1 = p1[1];
+			edge->x2 = p2[0];
+			edge->y2 = p2[1];
+			edge->ring_id = ring_id;
+			edge->__padding = 0;
+			pb->ymin = Min(pb->ymin, Min(p1[1], p2[1]));
+			pb->ymax = Max(pb->ymax, Max(p1[1], p2[1]));
+		}
+		pos += unitsz * npoints;
+	}
+	return pos;
+}
+
+static inline uint32_t
+__prepPolygonSlabIndex(double y, double ymin, double yunit, uint32_t nslabs)
+{
+	/* must be consistent to __geom_point_in_prep_polygon */
+	double		slab = floor((y - ymin) / yunit);
+
+	if (slab < 0.0)
+		return 0;
+	return (slab >= (double)nslabs ? nslabs - 1 : (uint32_t)slab);
+}
+
+size_t
+pgstromBuildPrepPolygon(const char *gs_addr, char *buf, size_t bufsz)
+{
+	const __GSERIALIZED *gs;
+	const char *pos;
+	const char *end;
+	uint16_t	geom_flags = 0;
+	uint32_t	gs_type;
+	uint32_t	nitems;
+	uint32_t	ndims;
+	uint32_t	nslabs;
+	uint64_t	nrefs;
+	double		yunit;
+	size_t		length = 0;
+	prep_polygon_builder pb;
+
+	if (VARATT_IS_EXTERNAL(gs_addr) || VARATT_IS_COMPRESSED(gs_addr))
+		return 0;
+	gs = (const __GSERIALIZED *)VARDATA_ANY(gs_addr);
+	end = (const char *)gs + VARSIZE_ANY_EXHDR(gs_addr);
+	pos = gs->data;
+	/* see __geometry_datum_ref_v1 and __geometry_datum_ref_v2 */
+	if ((gs->gflags & G2FLAG_VER_0) != 0)
+	{
+		if ((gs->gflags & G2FLAG_Z) != 0)
+			geom_flags |= GEOM_FLAG__Z;
+		if ((gs->gflags & G2FLAG_M) != 0)
+			geom_flags |= GEOM_FLAG__M;
+		if ((gs->gflags & G2FLAG_BBOX) != 0)
+			geom_flags |= GEOM_FLAG__BBOX;
+		if ((gs->gflags & G2FLAG_GEODETIC) != 0)
+			geom_flags |= GEOM_FLAG__GEODETIC;
+		if ((gs->gflags & G2FLAG_EXTENDED) != 0)
+			pos += sizeof(uint64_t);
+	}
+	else
+	{
+		if ((gs->gflags & G1FLAG_Z) != 0)
+			geom_flags |= GEOM_FLAG__Z;
+		if ((gs->gflags & G1FLAG_M) != 0)
+			geom_flags |= GEOM_FLAG__M;
+		if ((gs->gflags & G1FLAG_BBOX) != 0)
+			geom_flags |= GEOM_FLAG__BBOX;
+		if ((gs->gflags & G1FLAG_GEODETIC) != 0)
+			geom_flags |= GEOM_FLAG__GEODETIC;
+	}
+	if ((geom_flags & GEOM_FLAG__GEODETIC) != 0)
+		return 0;
+	if ((geom_flags & GEOM_FLAG__BBOX) != 0)
+		pos += geometry_bbox_size(geom_flags);
+	ndims = GEOM_FLAGS_NDIMS(geom_flags);
+	if (pos + 2 * sizeof(uint32_t) > end)
+		return 0;
+	memcpy(&gs_type, pos, sizeof(uint32_t));
+	memcpy(&nitems, pos + sizeof(uint32_t), sizeof(uint32_t));
+	pos += 2 * sizeof(uint32_t);
+	if (gs_type != GEOM_POLYGONTYPE &&
+		gs_type != GEOM_MULTIPOLYGONTYPE)
+		return 0;
+
+	memset(&pb, 0, sizeof(prep_polygon_builder));
+	pb.ring_info = palloc(sizeof(uint32_t) * 32);
+	pb.nrooms_rings = 32;
+	pb.edges = palloc(sizeof(kern_prep_edge) * 256);
+	pb.nrooms_edges = 256;
+	pb.ymin = DBL_MAX;
+	pb.ymax = -DBL_MAX;
+	if (gs_type == GEOM_POLYGONTYPE)
+		pos = __prepPolygonLoadBody(&pb, pos, end, nitems, ndims, 0);
+	else
+	{
+		for (uint32_t j=0; pos && j < nitems; j++)
+		{
+			uint32_t	sub_type;
+			uint32_t	nrings;
+
+			if (pos + 2 * sizeof(uint32_t) > end)
+				goto out;
+			memcpy(&sub_type, pos, sizeof(uint32_t));
+			memcpy(&nrings, pos + sizeof(uint32_t), sizeof(uint32_t));
+			if (sub_type != GEOM_POLYGONTYPE)
+				goto out;
+			pos = __prepPolygonLoadBody(&pb, pos + 2 * sizeof(uint32_t), end,
+										nrings, ndims, j);
+		}
+	}
+	if (!pos || pb.nedges < PREP_POLYGON_MIN_EDGES)
+		goto out;
+
+	/*
+	 * A horizontal line usually crosses a few edges only, so the number of
+	 * slabs is about the half of edges; but edges longer than the slabs are
+	 * referenced multiple times, so it is reduced to keep the references
+	 * less than 4 times of the edges.
+	 */
+	nslabs = Max(pb.nedges / 2, 1);
+	for (;;)
+	{
+		yunit = (pb.ymax - pb.ymin) / (double)nslabs;
+		if (yunit <= 0.0)
+		{
+			nslabs = 1;
+			yunit = 1.0;
+		}
+		nrefs = 0;
+		for (uint32_t k=0; k < pb.nedges; k++)
+		{
+			kern_prep_edge *edge = &pb.edges[k];
+
+			nrefs += (__prepPolygonSlabIndex(Max(edge->y1, edge->y2),
+											 pb.ymin, yunit, nslabs) -
+					  __prepPolygonSlabIndex(Min(edge->y1, edge->y2),
+											 pb.ymin, yunit, nslabs) + 1);
+		}
+		if (nrefs <= 4 * (uint64_t)pb.nedges || nslabs == 1)
+			break;
+		nslabs /= 2;
+	}
+
+	length = (MAXALIGN(offsetof(kern_prep_polygon, data) +
+					   sizeof(uint32_t) * (pb.nrings + nslabs + 1)) +
+			  sizeof(kern_prep_edge) * nrefs);
+	if (length > bufsz || length >= UINT_MAX)
+		length = 0;
+	else
+	{
+		kern_prep_polygon *prep = (kern_prep_polygon *)buf;
+		uint32_t   *slab_head;
+		uint32_t   *slab_curr;
+		kern_prep_edge *edges;
+
+		memset(prep, 0, offsetof(kern_prep_polygon, data));
+		prep->length = length;
+		prep->nrings = pb.nrings;
+		prep->nslabs = nslabs;
+		prep->nedges = nrefs;
+		prep->ymin   = pb.ymin;
+		prep->yunit  = yunit;
+		memcpy(KERN_PREP_POLYGON_RING_INFO(prep), pb.ring_info,
+			   sizeof(uint32_t) * pb.nrings);
+		slab_head = KERN_PREP_POLYGON_SLAB_HEAD(prep);
+		edges = KERN_PREP_POLYGON_EDGES(prep);
+
+		/* counting sort by the slab; ring order is kept in the slab */
+		slab_curr = palloc0(sizeof(uint32_t) * (nslabs + 1));
+		for (uint32_t k=0; k < pb.nedges; k++)
+		{
+			kern_prep_edge *edge = &pb.edges[k];
+			uint32_t	s1 = __prepPolygonSlabIndex(Min(edge->y1, edge->y2),
+												pb.ymin, yunit, nslabs);
+			uint32_t	s2 = __prepPolygonSlabIndex(Max(edge->y1, edge->y2),
+												pb.ymin, yunit, nslabs);
+			for (uint32_t s=s1; s <= s2; s++)
+				slab_curr[s+1]++;
+		}
+		for (uint32_t s=0; s < nslabs; s++)
+			slab_curr[s+1] += slab_curr[s];
+		memcpy(slab_head, slab_curr, sizeof(uint32_t) * (nslabs + 1));
+		for (uint32_t k=0; k < pb.nedges; k++)
+		{
+			kern_prep_edge *edge = &pb.edges[k];
+			uint32_t	s1 = __prepPolygonSlabIndex(Min(edge->y1, edge->y2),
+												pb.ymin, yunit, nslabs);
+			uint32_t	s2 = __prepPolygonSlabIndex(Max(edge->y1, edge->y2),
+												pb.ymin, yunit, nslabs);
+			for (uint32_t s=s1; s <= s2; s++)
+				edges[slab_curr[s]++] = *edge;
+		}
+		Assert(slab_curr[nslabs-1] == nrefs);
+		pfree(slab_curr);
+	}
+out:
+	pfree(pb.ring_info);
+	pfree(pb.edges);
+	return length;
+}
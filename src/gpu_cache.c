@@ -35,6 +35,8 @@ typedef struct
 /*
  * GpuCacheSharedHead (shared structure; static)
  */
+#define GCACHE_RESIZE_NSLOTS		32
+
 typedef struct
 {
 	/* pg_strom.gpucache_auto_preload related */
@@ -42,10 +44,17 @@ typedef struct
 	NameData		gcache_auto_preload_dbname;
 	/* Mutex for creation of GpuCacheSharedState shared-memory segment */
 	pthread_mutex_t	gcache_sstate_mutex;
+	/* LWLock tranche of GpuCacheSharedState::wal_lock */
+	int				gcache_wal_lock_tranche;
 	/* IPC to GpuService background workers */
 	pthread_mutex_t	gcache_cmd_mutex;
 	dlist_head		gcache_free_cmds;
 	GpuCacheControlCommand __gcache_control_cmds[100];
+	/* pending online resizing (protected by gcache_sstate_mutex) */
+	struct {
+		GpuCacheIdent	ident;			/* the previous GpuCache */
+		uint64_t		new_signature;	/* or 0, if unused */
+	} gcache_resize_slots[GCACHE_RESIZE_NSLOTS];
 	struct {
 		pthread_cond_t	cond;
 		dlist_head		queue;
@@ -54,7 +63,21 @@ typedef struct
 
 /*
  * GpuCacheOptions
+ *
+ * Virtual columns are text values of 'jsonb ->> key' precomputed on the
+ * load and REDO-log, stored next to the regular columns of kds_head.
+ * The index_attnum is the key column of the hash index on the GpuCache.
+ * The summary_key_attnum is the grouping key of the summary; it keeps the
+ * count and sum of the summary_value_attnums per group on the device.
+ * The recent_partitions limits the GpuCache of a range partition to the
+ * most recent N ones of the parent, so the older ones are evicted.
+ * The tiered mode keeps only the columns frequently referenced by scans
+ * on the device memory, and the other (cold) columns on the host memory.
+ * The layout_signature is common to the GpuCaches which differ only in the
+ * sizing options, so the new one can be cloned from the previous one.
  */
+#define GCACHE_MAX_VIRTUAL_COLUMNS	8
+
 typedef struct
 {
 	Oid			tg_sync_row;
@@ -64,8 +87,30 @@ typedef struct
 	int64		max_num_rows;
 	int64		rowid_hash_nslots;
 	size_t		redo_buffer_size;
+	bool		compression;
+	int			num_replicas;
+	int			num_vcols;
+	struct {
+		AttrNumber	attnum;				/* source jsonb column */
+		char		key[NAMEDATALEN];	/* key of the jsonb object */
+	} vcols[GCACHE_MAX_VIRTUAL_COLUMNS];
+	AttrNumber	index_attnum;			/* key column of the index, or 0 */
+	AttrNumber	summary_key_attnum;		/* key column of the summary, or 0 */
+	int32		summary_nslots;			/* number of the group-slots */
+	int			summary_nvalues;
+	AttrNumber	summary_value_attnums[GPUCACHE_SUMMARY_MAX_NVALUES];
+	int32		recent_partitions;		/* number of partitions to cache */
+	bool		tiered;					/* cold columns on the host memory */
+	uint64_t	layout_signature;		/* signature except for the sizing
+										 * options (not a part of signature) */
 } GpuCacheOptions;
 
+/*
+ * GpuCache can be replicated on multiple GPUs; the replica-N is located
+ * at the GPU (cuda_dindex + N) % numGpuDevAttrs.
+ */
+#define GCACHE_MAX_REPLICAS		8
+
 INLINE_FUNCTION(bool)
 GpuCacheOptionsEqual(const GpuCacheOptions *a, const GpuCacheOptions *b)
 {
@@ -75,7 +120,20 @@ GpuCacheOptionsEqual(const GpuCacheOptions *a, const GpuCacheOptions *b)
 			a->gpu_sync_threshold == b->gpu_sync_threshold &&
 			a->max_num_rows       == b->max_num_rows &&
 			a->rowid_hash_nslots  == b->rowid_hash_nslots &&
-			a->redo_buffer_size   == b->redo_buffer_size);
+			a->redo_buffer_size   == b->redo_buffer_size &&
+			a->compression        == b->compression &&
+			a->num_replicas       == b->num_replicas &&
+			a->num_vcols          == b->num_vcols &&
+			memcmp(a->vcols, b->vcols, sizeof(a->vcols)) == 0 &&
+			a->index_attnum       == b->index_attnum &&
+			a->summary_key_attnum == b->summary_key_attnum &&
+			a->summary_nslots     == b->summary_nslots &&
+			a->summary_nvalues    == b->summary_nvalues &&
+			memcmp(a->summary_value_attnums,
+				   b->summary_value_attnums,
+				   sizeof(a->summary_value_attnums)) == 0 &&
+			a->recent_partitions  == b->recent_partitions &&
+			a->tiered             == b->tiered);
 }
 
 /*
@@ -103,6 +161,8 @@ typedef struct
 	Oid			table_oid;
 	uint64_t	signature;
 	GpuCacheOptions gc_options;
+	Oid			parent_oid;		/* parent, if 'recent_partitions' is given */
+	bool		evicted;		/* not in the recent partitions */
 } GpuCacheTableSignatureCache;
 
 /*
@@ -134,19 +194,48 @@ typedef struct
 	pg_atomic_uint64 gcache_extra_usage;	/* used in extra buffer (incl dead space) */
 	pg_atomic_uint64 gcache_extra_dead;		/* dead space in extra buffer */
 
+	/* progress of the compaction */
+	pg_atomic_uint64 gcache_compaction_pos;		/* rows already copied */
+	pg_atomic_uint64 gcache_compaction_nitems;	/* rows to be copied, or 0 */
+	pg_atomic_uint64 gcache_compaction_count;	/* number of compactions */
+
 	/* rowid-map propertoes */
 	pthread_mutex_t	rowid_mutex;
 	uint32_t		rowid_next_free;
 	uint32_t		rowid_num_free;
+	uint64_t		rowid_map_version;	/* incremented on updates */
 
 	/* redo buffer properties */
 	pthread_mutex_t	redo_mutex;
+	LWLock			wal_lock;		/* keeps the order of WAL records */
 	uint64_t		redo_write_timestamp;
 	uint64_t		redo_write_nitems;
 	uint64_t		redo_write_pos;
-	uint64_t		redo_read_nitems;
-	uint64_t		redo_read_pos;
+	uint64_t		redo_read_nitems;	/* min of the replicas */
+	uint64_t		redo_read_pos;		/* min of the replicas */
 	uint64_t		redo_sync_pos;
+	uint64_t		replica_read_nitems[GCACHE_MAX_REPLICAS];
+	uint64_t		replica_read_pos[GCACHE_MAX_REPLICAS];
+
+	/* number of running scans per replica (for load balancing) */
+	pg_atomic_uint32 replica_nscans[GCACHE_MAX_REPLICAS];
+
+	/* on-disk snapshot properties (protected by redo_mutex) */
+	uint32_t		snapshot_valid;		/* generation of the valid snapshot,
+										 * or 0 if no snapshot file */
+	uint32_t		snapshot_generation;
+	uint64_t		snapshot_timestamp;	/* last try to write snapshot */
+	pg_atomic_uint32 snapshot_restore;	/* device buffer is loaded from
+										 * the snapshot on allocation */
+	/* signature of the previous GpuCache being cloned, or 0 */
+	pg_atomic_uint64 clone_signature;
+
+	/* number of scans that referenced the column (for the tiered mode) */
+	pg_atomic_uint32 column_nscans[MaxTupleAttributeNumber];
+
+	/* copy of the summary on the primary device, if any */
+	pthread_mutex_t	summary_mutex;
+	uint64_t		summary_offset;
 
 	/* schema definitions (KDS_FORMAT_COLUMN) */
 	size_t			kds_extra_sz;
@@ -158,6 +247,40 @@ typedef struct
 			 ".gpucache_p%u_d%u_r%u.%09lx.buf",							\
 			 PostPortNumber, (datOid), (relOid), (signature))
 
+#define GpuCacheSnapshotFileName(nameBuf,nameLen,datOid,relOid,signature,suffix) \
+	snprintf((nameBuf), (nameLen),										\
+			 "%s/gpucache_d%u_r%u.%09lx.snap%s",						\
+			 pgstrom_gpucache_snapshot_dir,								\
+			 (datOid), (relOid), (signature), (suffix))
+
+/*
+ * GpuCacheSnapshotHeader
+ *
+ * On-disk snapshot of GpuCache consists of the header, the rowid-map, and
+ * the image of main/extra device buffers, each of them are page aligned.
+ * It is valid only if table is not modified after the snapshot, so the
+ * file shall be removed prior to any REDO-log writes.
+ */
+typedef struct
+{
+	char			magic[8];	/* = "GCSNAP02" */
+	uint64_t		system_identifier;
+	GpuCacheIdent	ident;
+	uint32_t		rowid_next_free;
+	uint32_t		rowid_num_free;
+	uint64_t		rowid_map_sz;
+	uint64_t		main_sz;
+	uint64_t		extra_length;
+	uint64_t		extra_usage;	/* bytes written in the file */
+} GpuCacheSnapshotHeader;
+
+#define GpuCacheSnapshotRowIdMapOffset(h)		\
+	PAGE_ALIGN(sizeof(GpuCacheSnapshotHeader))
+#define GpuCacheSnapshotMainOffset(h)			\
+	(GpuCacheSnapshotRowIdMapOffset(h) + PAGE_ALIGN((h)->rowid_map_sz))
+#define GpuCacheSnapshotExtraOffset(h)			\
+	(GpuCacheSnapshotMainOffset(h) + PAGE_ALIGN((h)->main_sz))
+
 /*
  * GpuCacheRowIdItem
  */
@@ -174,6 +297,22 @@ gpuCacheRedoLogBuffer(GpuCacheSharedState *gc_sstate)
 	return (char *)gc_sstate + gc_sstate->redo_buffer_offset;
 }
 
+INLINE_FUNCTION(kern_gpucache_summary *)
+gpuCacheSummaryBuffer(GpuCacheSharedState *gc_sstate)
+{
+	return (kern_gpucache_summary *)
+		((char *)gc_sstate + gc_sstate->summary_offset);
+}
+
+INLINE_FUNCTION(size_t)
+gpuCacheSummaryLength(const GpuCacheOptions *gc_options)
+{
+	if (gc_options->summary_key_attnum == 0)
+		return 0;
+	return GPUCACHE_SUMMARY_LENGTH(gc_options->summary_nslots,
+								   gc_options->summary_nvalues);
+}
+
 INLINE_FUNCTION(uint32_t *)
 gpuCacheRowIdHashSlot(GpuCacheSharedState *gc_sstate)
 {
@@ -188,9 +327,31 @@ gpuCacheRowIdItemArray(GpuCacheSharedState *gc_sstate)
 }
 
 /*
- * GpuCacheLocalMapping
+ * GpuCacheDeviceBuffer (per replica; valid only GpuService context)
  */
+typedef struct GpuCacheLocalMapping	GpuCacheLocalMapping;
+
 typedef struct
+{
+	GpuCacheLocalMapping *gc_lmap;	/* back pointer */
+	int				replica;
+	pthread_rwlock_t gcache_rwlock;
+	CUdeviceptr		gcache_main_devptr;
+	CUdeviceptr		gcache_extra_devptr;
+	ssize_t			gcache_main_size;
+	ssize_t			gcache_extra_size;
+	uint64_t		gcache_epoch;	/* incremented on device buffer updates */
+	/* current location of the columns (only tiered mode) */
+#define GCACHE_COLUMN_TIER__UNKNOWN		0
+#define GCACHE_COLUMN_TIER__HOST		1
+#define GCACHE_COLUMN_TIER__DEVICE		2
+	uint8_t			column_tiers[MaxTupleAttributeNumber];
+} GpuCacheDeviceBuffer;
+
+/*
+ * GpuCacheLocalMapping
+ */
+struct GpuCacheLocalMapping
 {
 	dlist_node		chain;
 	GpuCacheIdent	ident;
@@ -198,12 +359,8 @@ typedef struct
 	GpuCacheSharedState *gc_sstate;
 	size_t			mmap_sz;
 	/* fields below are valid only GpuService context */
-	pthread_rwlock_t gcache_rwlock;
-	CUdeviceptr		gcache_main_devptr;
-	CUdeviceptr		gcache_extra_devptr;
-	ssize_t			gcache_main_size;
-	ssize_t			gcache_extra_size;
-} GpuCacheLocalMapping;
+	GpuCacheDeviceBuffer gc_dbuf[GCACHE_MAX_REPLICAS];
+};
 
 /*
  * GpuCacheDesc (GpuCache Descriptor per backend)
@@ -216,8 +373,11 @@ struct GpuCacheDesc
 	GpuCacheLocalMapping *gc_lmap;
 	bool			drop_on_rollback;
 	bool			drop_on_commit;
+	uint64_t		resize_signature;	/* resized online on commit, or 0 */
 	uint32_t		nitems;
 	StringInfoData	buf;	/* array of PendingCtidItem */
+	uint32_t		log_nitems;
+	StringInfoData	logbuf;	/* REDO logs not appended yet */
 };
 
 typedef struct
@@ -227,11 +387,48 @@ typedef struct
 	ItemPointerData	ctid;
 } PendingCtidItem;
 
+/*
+ * WAL records of GpuCache (custom resource manager)
+ *
+ * If pg_strom.gpucache_wal_logging is enabled, the primary server writes
+ * the REDO logs of GpuCache to WAL, then the standby server replays them
+ * to build its own GpuCache. Every record begins with GpuCacheIdent.
+ * The resource manager ID is pg_strom.gpucache_rmgr_id; it must be same
+ * on the primary and the standby servers.
+ */
+#define GPUCACHE_RMGR_ID		((RmgrId)pgstrom_gpucache_rmgr_id)
+#define XLOG_GPUCACHE_RESET		0x00	/* initial loading begins */
+#define XLOG_GPUCACHE_REDO		0x10	/* a batch of REDO logs */
+#define XLOG_GPUCACHE_READY		0x20	/* initial loading is completed */
+#define XLOG_GPUCACHE_DROP		0x30	/* GpuCache is dropped */
+
+typedef struct
+{
+	GpuCacheIdent	ident;
+	char			table_name[NAMEDATALEN];
+	GpuCacheOptions	gc_options;
+	uint64_t		kds_extra_sz;
+	/* followed by kds_head of KDS_HEAD_LENGTH() */
+} xl_gpucache_reset;
+
+typedef struct
+{
+	GpuCacheIdent	ident;
+	uint32_t		nitems;
+	/* followed by the REDO logs */
+} xl_gpucache_redo;
+
 /* --- static variables --- */
 static char	   *pgstrom_gpucache_auto_preload;		/* GUC */
 static bool		pgstrom_enable_gpucache;			/* GUC */
+static char	   *pgstrom_gpucache_snapshot_dir;		/* GUC */
+static int		pgstrom_gpucache_snapshot_interval;	/* GUC */
+static bool		pgstrom_gpucache_wal_logging;		/* GUC */
+static int		pgstrom_gpucache_rmgr_id;			/* GUC */
+static int		pgstrom_gpucache_initial_load_workers;	/* GUC */
 static GpuCacheSharedHead *gcache_shared_head = NULL;
 static HTAB	   *gcache_descriptors_htab = NULL;
+static GpuCacheDesc *gcache_pending_desc = NULL;	/* has logbuf in use */
 static HTAB	   *gcache_signatures_htab = NULL;
 static shmem_request_hook_type shmem_request_next = NULL;
 static shmem_startup_hook_type shmem_startup_next = NULL;
@@ -240,10 +437,31 @@ static object_access_hook_type object_access_next = NULL;
 /* --- function declarations --- */
 static void		__gpuCacheAppendLog(GpuCacheDesc *gc_desc,
 									GCacheTxLogCommon *tx_log);
+static void		__gpuCacheBatchLog(GpuCacheDesc *gc_desc,
+								   GCacheTxLogCommon *tx_log);
+static void		__gpuCacheFlushLogs(void);
 static void		gpuCacheInvokeDropUnload(const GpuCacheDesc *gc_desc,
 										 bool is_async);
+static void		__gpuCacheRemoveSnapshot(const GpuCacheIdent *ident);
+static bool		__gpuCacheRestoreSnapshot(GpuCacheDesc *gc_desc);
+static bool		__gpuCacheCloneFromPrevious(GpuCacheDesc *gc_desc);
+static void		__gpuCacheDropPreviousCache(const GpuCacheIdent *ident,
+											int cuda_dindex);
+static void		__gpuCacheXLogReset(GpuCacheSharedState *gc_sstate);
+static void		__gpuCacheXLogIdent(const GpuCacheIdent *ident, uint8 info);
 void	gpuCacheStartupPreloader(Datum arg);
 
+/*
+ * gpuCacheWalLoggingEnabled
+ */
+static inline bool
+gpuCacheWalLoggingEnabled(void)
+{
+	return (pgstrom_gpucache_wal_logging &&
+			XLogIsNeeded() &&
+			!RecoveryInProgress());
+}
+
 /*
  * gpucache_sync_trigger_function_oid
  */
@@ -300,6 +518,93 @@ is_gpucache_sync_trigger(int16 trig_type,
 	return false;
 }
 
+/*
+ * gpuCacheIndexKeyTypeIsSupported
+ *
+ * The index key must be a fixed-length integer-like type; its equality
+ * operator has to be identical to the comparison of the int64 value.
+ */
+static bool
+gpuCacheIndexKeyTypeIsSupported(Oid type_oid)
+{
+	switch (type_oid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case OIDOID:
+		case DATEOID:
+		case TIMEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/*
+ * gpuCacheSummaryValueKind
+ *
+ * The summary value is accumulated as int64 ('i') or float8 ('f').
+ */
+static char
+gpuCacheSummaryValueKind(Oid type_oid)
+{
+	switch (type_oid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+			return 'i';
+		case FLOAT4OID:
+		case FLOAT8OID:
+			return 'f';
+		default:
+			return '\0';
+	}
+}
+
+/*
+ * __gpuCacheLookupAttnum
+ */
+static AttrNumber
+__gpuCacheLookupAttnum(Form_pg_class pg_class,
+					   FormData_pg_attribute *pg_attrs,
+					   const char *attname)
+{
+	for (int j=0; j < pg_class->relnatts; j++)
+	{
+		Form_pg_attribute attr = &pg_attrs[j];
+
+		if (!attr->attisdropped &&
+			strcmp(NameStr(attr->attname), attname) == 0)
+			return j + 1;
+	}
+	return InvalidAttrNumber;
+}
+
+/*
+ * gpuCacheIndexKeyDatum - int64 form of the index key value
+ */
+static int64
+gpuCacheIndexKeyDatum(Oid type_oid, Datum datum)
+{
+	switch (get_typlen(type_oid))
+	{
+		case sizeof(int16):
+			return (int64)DatumGetInt16(datum);
+		case sizeof(int32):
+			return (int64)DatumGetInt32(datum);
+		case sizeof(int64):
+			return DatumGetInt64(datum);
+		default:
+			elog(ERROR, "gpucache: unexpected index key type %s",
+				 format_type_be(type_oid));
+	}
+	return 0;	/* not reachable */
+}
+
 /*
  * parseSyncTriggerOptions
  */
@@ -318,6 +623,18 @@ __parseSyncTriggerOptions(int elevel,
 	int64		max_num_rows = (10UL << 20);	/* default: 10M rows */
 	int64		rowid_hash_nslots = -1;			/* default: auto */
 	ssize_t		redo_buffer_size = (160UL << 20);	/* default: 160MB */
+	bool		compression = false;			/* default: off */
+	int			num_replicas = 1;				/* default: no replica */
+	int			num_vcols = 0;					/* default: no virtual columns */
+	AttrNumber	vcol_attnums[GCACHE_MAX_VIRTUAL_COLUMNS];
+	char		vcol_keys[GCACHE_MAX_VIRTUAL_COLUMNS][NAMEDATALEN];
+	AttrNumber	index_attnum = 0;				/* default: no index */
+	AttrNumber	summary_key_attnum = 0;			/* default: no summary */
+	int64		summary_nslots = 65536;			/* default: 64K groups */
+	int			summary_nvalues = 0;
+	AttrNumber	summary_value_attnums[GPUCACHE_SUMMARY_MAX_NVALUES];
+	int32		recent_partitions = 0;			/* default: all partitions */
+	bool		tiered = false;					/* default: off */
 	char	   *config;
 	char	   *key, *value;
 	char	   *saved;
@@ -325,6 +642,9 @@ __parseSyncTriggerOptions(int elevel,
 	size_t		extra_sz = 0;
 	int			unitsz;
 
+	memset(vcol_attnums, 0, sizeof(vcol_attnums));
+	memset(vcol_keys, 0, sizeof(vcol_keys));
+	memset(summary_value_attnums, 0, sizeof(summary_value_attnums));
 	if (!trigger_config)
 		goto out;
 	config = alloca(strlen(trigger_config) + 1);
@@ -409,6 +729,163 @@ __parseSyncTriggerOptions(int elevel,
 				return false;
 			}
 		}
+		else if (strcmp(key, "gpu_replicas") == 0)
+		{
+			num_replicas = __strtol(value);
+			if (errno != 0)
+			{
+				elog(elevel, "gpucache: invalid option [%s]=[%s] : %m", key, value);
+				return false;
+			}
+		}
+		else if (strcmp(key, "compression") == 0)
+		{
+			if (!parse_bool(value, &compression))
+			{
+				elog(elevel, "gpucache: invalid option [%s]=[%s]", key, value);
+				return false;
+			}
+		}
+		else if (strcmp(key, "virtual_column") == 0)
+		{
+			/* virtual_column=ATTNAME->>KEY */
+			char	   *sep = strstr(value, "->>");
+			char	   *jkey;
+			int			j;
+
+			if (!sep)
+			{
+				elog(elevel, "gpucache: virtual_column must be 'ATTNAME->>KEY' form [%s]", value);
+				return false;
+			}
+			*sep = '\0';
+			jkey = __trim(sep + 3);
+			value = __trim(value);
+			if (num_vcols >= GCACHE_MAX_VIRTUAL_COLUMNS)
+			{
+				elog(elevel, "gpucache: too many virtual columns (up to %d)",
+					 GCACHE_MAX_VIRTUAL_COLUMNS);
+				return false;
+			}
+			if (*jkey == '\0' || strlen(jkey) >= NAMEDATALEN)
+			{
+				elog(elevel, "gpucache: invalid key of virtual_column [%s]", jkey);
+				return false;
+			}
+			for (j=0; j < pg_class->relnatts; j++)
+			{
+				Form_pg_attribute attr = &pg_attrs[j];
+
+				if (!attr->attisdropped &&
+					strcmp(NameStr(attr->attname), value) == 0)
+					break;
+			}
+			if (j >= pg_class->relnatts)
+			{
+				elog(elevel, "gpucache: virtual_column refers unknown column [%s]", value);
+				return false;
+			}
+			if (pg_attrs[j].atttypid != JSONBOID)
+			{
+				elog(elevel, "gpucache: virtual_column must refer jsonb column, but [%s] is %s",
+					 value, format_type_be(pg_attrs[j].atttypid));
+				return false;
+			}
+			vcol_attnums[num_vcols] = j + 1;
+			strcpy(vcol_keys[num_vcols], jkey);
+			num_vcols++;
+		}
+		else if (strcmp(key, "index_key") == 0)
+		{
+			int			j;
+
+			for (j=0; j < pg_class->relnatts; j++)
+			{
+				Form_pg_attribute attr = &pg_attrs[j];
+
+				if (!attr->attisdropped &&
+					strcmp(NameStr(attr->attname), value) == 0)
+					break;
+			}
+			if (j >= pg_class->relnatts)
+			{
+				elog(elevel, "gpucache: index_key refers unknown column [%s]", value);
+				return false;
+			}
+			if (!gpuCacheIndexKeyTypeIsSupported(pg_attrs[j].atttypid))
+			{
+				elog(elevel, "gpucache: index_key [%s] of %s is not supported",
+					 value, format_type_be(pg_attrs[j].atttypid));
+				return false;
+			}
+			index_attnum = j + 1;
+		}
+		else if (strcmp(key, "summary_key") == 0)
+		{
+			AttrNumber	anum = __gpuCacheLookupAttnum(pg_class, pg_attrs, value);
+
+			if (anum == InvalidAttrNumber)
+			{
+				elog(elevel, "gpucache: summary_key refers unknown column [%s]", value);
+				return false;
+			}
+			if (!gpuCacheIndexKeyTypeIsSupported(pg_attrs[anum-1].atttypid))
+			{
+				elog(elevel, "gpucache: summary_key [%s] of %s is not supported",
+					 value, format_type_be(pg_attrs[anum-1].atttypid));
+				return false;
+			}
+			summary_key_attnum = anum;
+		}
+		else if (strcmp(key, "summary_value") == 0)
+		{
+			AttrNumber	anum = __gpuCacheLookupAttnum(pg_class, pg_attrs, value);
+
+			if (anum == InvalidAttrNumber)
+			{
+				elog(elevel, "gpucache: summary_value refers unknown column [%s]", value);
+				return false;
+			}
+			if (gpuCacheSummaryValueKind(pg_attrs[anum-1].atttypid) == '\0')
+			{
+				elog(elevel, "gpucache: summary_value [%s] of %s is not supported",
+					 value, format_type_be(pg_attrs[anum-1].atttypid));
+				return false;
+			}
+			if (summary_nvalues >= GPUCACHE_SUMMARY_MAX_NVALUES)
+			{
+				elog(elevel, "gpucache: too many summary values (up to %d)",
+					 GPUCACHE_SUMMARY_MAX_NVALUES);
+				return false;
+			}
+			summary_value_attnums[summary_nvalues++] = anum;
+		}
+		else if (strcmp(key, "summary_nslots") == 0)
+		{
+			summary_nslots = __strtol(value);
+			if (errno != 0 || summary_nslots < 1 || summary_nslots >= INT_MAX)
+			{
+				elog(elevel, "gpucache: invalid option [%s]=[%s]", key, value);
+				return false;
+			}
+		}
+		else if (strcmp(key, "tiered") == 0)
+		{
+			if (!parse_bool(value, &tiered))
+			{
+				elog(elevel, "gpucache: invalid option [%s]=[%s]", key, value);
+				return false;
+			}
+		}
+		else if (strcmp(key, "recent_partitions") == 0)
+		{
+			recent_partitions = __strtol(value);
+			if (errno != 0 || recent_partitions < 0)
+			{
+				elog(elevel, "gpucache: invalid option [%s]=[%s]", key, value);
+				return false;
+			}
+		}
 		else
 		{
 			elog(elevel, "gpucache: unknown option [%s]=[%s]", key, value);
@@ -445,6 +922,18 @@ out:
 		elog(elevel, "gpucache: max_num_rows too large (%lu)", max_num_rows);
 		return false;
 	}
+	if (summary_nvalues > 0 && summary_key_attnum == 0)
+	{
+		elog(elevel, "gpucache: 'summary_value' requires 'summary_key'");
+		return false;
+	}
+	if (num_replicas < 1 ||
+		num_replicas > Min(numGpuDevAttrs, GCACHE_MAX_REPLICAS))
+	{
+		elog(elevel, "gpucache: 'gpu_replicas' is out of range (%d), must be 1..%d",
+			 num_replicas, Min(numGpuDevAttrs, GCACHE_MAX_REPLICAS));
+		return false;
+	}
 
 	/* check initial kds_column/kds_extra size */
 	for (int j=0; j < pg_class->relnatts; j++)
@@ -461,7 +950,7 @@ out:
 		}
 		else if (attr->attlen == -1)
 		{
-			main_sz += MAXALIGN(sizeof(uint32_t) * max_num_rows);
+			main_sz += MAXALIGN(sizeof(uint64_t) * max_num_rows);
 			unitsz = get_typavgwidth(attr->atttypid,
 									 attr->atttypmod);
 			extra_sz += MAXALIGN(unitsz) * max_num_rows;
@@ -474,16 +963,37 @@ out:
 			return false;
 		}
 	}
+	/* virtual columns (text) */
+	for (int k=0; k < num_vcols; k++)
+	{
+		main_sz += MAXALIGN(BITMAPLEN(max_num_rows));
+		main_sz += MAXALIGN(sizeof(uint64_t) * max_num_rows);
+		unitsz = get_typavgwidth(TEXTOID, -1);
+		extra_sz += MAXALIGN(unitsz) * max_num_rows;
+	}
 	main_sz += (MAXALIGN(offsetof(kern_data_store,					/* KDS Header */
-								  colmeta[pg_class->relnatts+1])) +
+								  colmeta[pg_class->relnatts+num_vcols+1])) +
 				MAXALIGN(sizeof(GpuCacheSysattr) * max_num_rows));	/* System Column */
+	if (index_attnum > 0)
+		main_sz += MAXALIGN(sizeof(uint32_t) * (rowid_hash_nslots +	/* Index */
+												max_num_rows));
+	if (summary_key_attnum > 0)
+		main_sz += GPUCACHE_SUMMARY_LENGTH(summary_nslots,			/* Summary */
+										   summary_nvalues);
 	if (extra_sz > 0)
 	{
 		/* 25% margin + header */
 		extra_sz += extra_sz / 4;
 		extra_sz += offsetof(kern_data_extra, data);
 	}
-	if (main_sz >= __KDS_LENGTH_LIMIT || extra_sz >= __KDS_LENGTH_LIMIT)
+	/*
+	 * The main buffer is addressed by the packed 32bit offset, but the extra
+	 * buffer is addressed by the 64bit offset, so it is limited only by the
+	 * device memory capacity.
+	 */
+	if (main_sz >= __KDS_LENGTH_LIMIT ||
+		(cuda_dindex < numGpuDevAttrs &&
+		 main_sz + extra_sz >= gpuDevAttrs[cuda_dindex].DEV_TOTAL_MEMSZ))
 	{
 		elog(elevel, "gpucache: max_num_rows = %ld consumes too much GPU device memory (main: %s, extra: %s), so we recommend to reduce 'max_num_rows' configuration",
 			 max_num_rows,
@@ -504,10 +1014,67 @@ out:
 		gc_options->max_num_rows = max_num_rows;
 		gc_options->rowid_hash_nslots = rowid_hash_nslots;
 		gc_options->redo_buffer_size  = redo_buffer_size;
+		gc_options->compression = compression;
+		gc_options->num_replicas = num_replicas;
+		gc_options->num_vcols = num_vcols;
+		for (int k=0; k < GCACHE_MAX_VIRTUAL_COLUMNS; k++)
+		{
+			gc_options->vcols[k].attnum = vcol_attnums[k];
+			memcpy(gc_options->vcols[k].key, vcol_keys[k], NAMEDATALEN);
+		}
+		gc_options->index_attnum = index_attnum;
+		gc_options->summary_key_attnum = summary_key_attnum;
+		gc_options->summary_nslots = (summary_key_attnum > 0 ? summary_nslots : 0);
+		gc_options->summary_nvalues = summary_nvalues;
+		memcpy(gc_options->summary_value_attnums, summary_value_attnums,
+			   sizeof(summary_value_attnums));
+		gc_options->recent_partitions = recent_partitions;
+		gc_options->tiered = tiered;
 	}
 	return true;
 }
 
+/*
+ * __gpuCachePartitionIsRecent
+ *
+ * It checks whether the supplied partition is one of the most recent N
+ * partitions of the parent. Only range partitions are ordered by the
+ * partition bounds, so all the list/hash partitions are considered recent.
+ */
+static bool
+__gpuCachePartitionIsRecent(Oid parent_oid, Oid table_oid,
+							int recent_partitions)
+{
+	Relation	prel;
+	PartitionDesc pdesc;
+	int			default_index = -1;
+	int			count = 0;
+	bool		retval = true;
+
+	prel = table_open(parent_oid, AccessShareLock);
+	if (get_partition_strategy(RelationGetPartitionKey(prel)) == PARTITION_STRATEGY_RANGE)
+	{
+		pdesc = RelationGetPartitionDesc(prel, true);
+		if (pdesc->boundinfo)
+			default_index = pdesc->boundinfo->default_index;
+		/* PartitionDesc->oids[] is sorted by the partition bounds */
+		for (int i = pdesc->nparts - 1; i >= 0; i--)
+		{
+			if (i == default_index)
+				continue;
+			if (pdesc->oids[i] == table_oid)
+			{
+				retval = (count < recent_partitions);
+				break;
+			}
+			count++;
+		}
+	}
+	table_close(prel, AccessShareLock);
+
+	return retval;
+}
+
 /* ------------------------------------------------------------
  *
  * Routines to manage the table signature
@@ -530,6 +1097,7 @@ gpuCacheTableSignatureCommon(int elevel,
 	GpuCacheTableSignatureBuffer *sig;
 	int			nattrs = pg_class->relnatts;
 	size_t		len;
+	uint64_t	signature;
 
 
 	len = offsetof(GpuCacheTableSignatureBuffer,
@@ -560,9 +1128,20 @@ gpuCacheTableSignatureCommon(int elevel,
 								   &sig->gc_options))
 		return 0UL;
 
+	signature = (uint64_t)hash_any((unsigned char *)sig, len) | 0x100000000UL;
 	if (gc_options)
+	{
 		memcpy(gc_options, &sig->gc_options, sizeof(GpuCacheOptions));
-	return (uint64_t)hash_any((unsigned char *)sig, len) | 0x100000000UL;
+		/* GpuCache can be resized online if only sizing options differ */
+		sig->gc_options.gpu_sync_interval  = 0;
+		sig->gc_options.gpu_sync_threshold = 0;
+		sig->gc_options.max_num_rows       = 0;
+		sig->gc_options.rowid_hash_nslots  = 0;
+		sig->gc_options.redo_buffer_size   = 0;
+		gc_options->layout_signature
+			= (uint64_t)hash_any((unsigned char *)sig, len) | 0x100000000UL;
+	}
+	return signature;
 }
 
 static void
@@ -604,6 +1183,8 @@ __gpuCacheTableSignature(Relation rel, GpuCacheTableSignatureCache *entry)
 
 		if (OidIsValid(trigger_oid))
 		{
+			entry->parent_oid = InvalidOid;
+			entry->evicted = false;
 			entry->signature
 				= gpuCacheTableSignatureCommon(WARNING,
 											   rel_form,
@@ -613,13 +1194,27 @@ __gpuCacheTableSignature(Relation rel, GpuCacheTableSignatureCache *entry)
 											   trigger_config,
 											   &entry->gc_options);
 			if (entry->signature != 0UL)
+			{
+				if (entry->gc_options.recent_partitions > 0 &&
+					rel_form->relispartition)
+				{
+					entry->parent_oid = get_partition_parent(RelationGetRelid(rel),
+															 true);
+					entry->evicted =
+						!__gpuCachePartitionIsRecent(entry->parent_oid,
+													 RelationGetRelid(rel),
+													 entry->gc_options.recent_partitions);
+				}
 				return;
+			}
 		}
 	}
 no_gpu_cache:
 	memset(&entry->gc_options, 0, sizeof(GpuCacheOptions));
 	entry->gc_options.cuda_dindex = -1;
 	entry->signature = 0;
+	entry->parent_oid = InvalidOid;
+	entry->evicted = false;
 }
 
 static inline uint64_t
@@ -646,11 +1241,30 @@ gpuCacheTableSignature(Relation rel, GpuCacheOptions *gc_options)
 		}
 		PG_END_TRY();
 	}
+	if (entry->evicted)
+		return 0UL;		/* evicted partition has no GpuCache */
 	if (gc_options)
 		memcpy(gc_options, &entry->gc_options, sizeof(GpuCacheOptions));
 	return entry->signature;
 }
 
+/*
+ * gpuCacheTableIsEvicted
+ *
+ * It checks whether the relation is a partition out of 'recent_partitions'.
+ */
+static bool
+gpuCacheTableIsEvicted(Relation rel)
+{
+	GpuCacheTableSignatureCache *entry;
+	Oid			table_oid = RelationGetRelid(rel);
+
+	(void)gpuCacheTableSignature(rel, NULL);
+	entry = hash_search(gcache_signatures_htab,
+						&table_oid, HASH_FIND, NULL);
+	return (entry != NULL && entry->evicted);
+}
+
 static uint64_t
 __gpuCacheTableSignatureSnapshot(Form_pg_class pg_class,
 								 Snapshot snapshot,
@@ -794,8 +1408,19 @@ gpuCacheTableSignatureSnapshot(Oid table_oid,
 static void
 gpuCacheTableSignatureInvalidation(Oid table_oid)
 {
+	GpuCacheTableSignatureCache *entry;
+	HASH_SEQ_STATUS	hseq;
+
 	hash_search(gcache_signatures_htab,
 				&table_oid, HASH_REMOVE, NULL);
+	/* ATTACH/DETACH PARTITION may change the recent partitions */
+	hash_seq_init(&hseq, gcache_signatures_htab);
+	while ((entry = hash_seq_search(&hseq)) != NULL)
+	{
+		if (entry->parent_oid == table_oid)
+			hash_search(gcache_signatures_htab,
+						&entry->table_oid, HASH_REMOVE, NULL);
+	}
 }
 
 /* ------------------------------------------------------------
@@ -824,24 +1449,143 @@ __gpuCacheSharedMappingHashSlot(Oid database_oid,
 }
 
 /*
- * __setup_kern_data_store_column
+ * __setup_column_encoding
+ *
+ * It chooses frame-of-reference encoding of the integer column according to
+ * the min/max values in pg_statistic. Because GpuCache is updated row-by-row
+ * by the redo-log, the base and width are fixed on the layout; so it takes
+ * a margin at both sides of the range. A value out of the range makes the
+ * GpuCache corrupted, then it shall be rebuilt with the latest statistics.
  */
 static void
-__setup_kern_data_store_column(kern_data_store *kds_head,
-							   size_t *p_extra_sz,
-							   Relation rel,
-							   uint32_t nrooms)
+__setup_column_encoding(kern_colmeta *cmeta,
+						Relation rel,
+						Form_pg_attribute attr)
 {
-	TupleDesc	tupdesc = RelationGetDescr(rel);
-	kern_colmeta *cmeta;
-	size_t		sz, off;
-	size_t		unitsz;
-	size_t		extra_sz = 0;
+	HeapTuple	tup;
+	AttStatsSlot sslot;
+	int64		min_value = LONG_MAX;
+	int64		max_value = LONG_MIN;
+	int64		margin;
+	uint64		span;
+	int			width;
+	static int	stakinds[] = { STATISTIC_KIND_HISTOGRAM,
+							   STATISTIC_KIND_MCV };
+
+	switch (attr->atttypid)
+	{
+		case BOOLOID:
+			/* bit-packed as like nullmap */
+			cmeta->encode_width = KDS_COLUMN_ENCODE_BITMAP;
+			return;
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case DATEOID:
+		case TIMEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			break;
+		default:
+			return;		/* not supported */
+	}
+	tup = SearchSysCache3(STATRELATTINH,
+						  ObjectIdGetDatum(RelationGetRelid(rel)),
+						  Int16GetDatum(attr->attnum),
+						  BoolGetDatum(false));
+	if (!HeapTupleIsValid(tup))
+		return;		/* not analyzed yet */
+	for (int k=0; k < lengthof(stakinds); k++)
+	{
+		if (!get_attstatsslot(&sslot, tup, stakinds[k], InvalidOid,
+							  ATTSTATSSLOT_VALUES))
+			continue;
+		for (int i=0; i < sslot.nvalues; i++)
+		{
+			Datum	datum = sslot.values[i];
+			int64	ival;
 
-	setup_kern_data_store(kds_head, tupdesc, 0, KDS_FORMAT_COLUMN);
-	kds_head->table_oid = RelationGetRelid(rel);
-	kds_head->column_nrooms = nrooms;
-	Assert(kds_head->nr_colmeta > tupdesc->natts);
+			if (attr->attlen == sizeof(int16))
+				ival = DatumGetInt16(datum);
+			else if (attr->attlen == sizeof(int32))
+				ival = DatumGetInt32(datum);
+			else
+				ival = DatumGetInt64(datum);
+			min_value = Min(min_value, ival);
+			max_value = Max(max_value, ival);
+		}
+		free_attstatsslot(&sslot);
+	}
+	ReleaseSysCache(tup);
+
+	if (min_value > max_value)
+		return;		/* no values in the statistics */
+	if ((uint64)(max_value - min_value) > (uint64)(UINT_MAX / 3))
+		return;		/* too wide */
+	margin = Max(max_value - min_value, 32);
+	if (min_value < LONG_MIN + margin)
+		return;
+	span = (uint64)(max_value - min_value) + 2 * margin;
+	for (width=1; width < attr->attlen; width *= 2)
+	{
+		if (span < (1UL << (8 * width)))
+		{
+			cmeta->encode_base  = min_value - margin;
+			cmeta->encode_width = width;
+			break;
+		}
+	}
+}
+
+/*
+ * __gpuCacheVirtualTupleDesc
+ *
+ * It returns TupleDesc of the GpuCache; virtual columns (text) follow the
+ * regular columns of the relation.
+ */
+static TupleDesc
+__gpuCacheVirtualTupleDesc(Relation rel, const GpuCacheOptions *gc_options)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	TupleDesc	vtupdesc;
+	int			natts = tupdesc->natts;
+
+	if (gc_options->num_vcols == 0)
+		return tupdesc;
+	vtupdesc = CreateTemplateTupleDesc(natts + gc_options->num_vcols);
+	for (int j=0; j < natts; j++)
+		TupleDescCopyEntry(vtupdesc, j+1, tupdesc, j+1);
+	for (int k=0; k < gc_options->num_vcols; k++)
+	{
+		char		attname[NAMEDATALEN];
+
+		snprintf(attname, sizeof(attname), "vcol%d", k+1);
+		TupleDescInitEntry(vtupdesc, natts+k+1, attname, TEXTOID, -1, 0);
+	}
+	return vtupdesc;
+}
+
+/*
+ * __setup_kern_data_store_column
+ */
+static void
+__setup_kern_data_store_column(kern_data_store *kds_head,
+							   size_t *p_extra_sz,
+							   Relation rel,
+							   const GpuCacheOptions *gc_options)
+{
+	TupleDesc	tupdesc = __gpuCacheVirtualTupleDesc(rel, gc_options);
+	uint32_t	nrooms = gc_options->max_num_rows;
+	bool		compression = gc_options->compression;
+	kern_colmeta *cmeta;
+	size_t		sz, off;
+	size_t		unitsz;
+	size_t		extra_sz = 0;
+
+	setup_kern_data_store(kds_head, tupdesc, 0, KDS_FORMAT_COLUMN);
+	kds_head->table_oid = RelationGetRelid(rel);
+	kds_head->column_nrooms = nrooms;
+	Assert(kds_head->nr_colmeta > tupdesc->natts);
 
 	off = KDS_HEAD_LENGTH(kds_head);
 	for (int j=0; j < tupdesc->natts; j++)
@@ -859,16 +1603,26 @@ __setup_kern_data_store_column(kern_data_store *kds_head,
 
 		if (attr->attlen > 0)
 		{
-			unitsz = att_align_nominal(attr->attlen,
-									   attr->attalign);
-			sz = MAXALIGN(unitsz * nrooms);
+			if (compression && attr->attbyval)
+				__setup_column_encoding(cmeta, rel, attr);
+			if (cmeta->encode_width == KDS_COLUMN_ENCODE_BITMAP)
+				sz = MAXALIGN(BITMAPLEN(nrooms));
+			else
+			{
+				if (cmeta->encode_width > 0)
+					unitsz = cmeta->encode_width;
+				else
+					unitsz = att_align_nominal(attr->attlen,
+											   attr->attalign);
+				sz = MAXALIGN(unitsz * nrooms);
+			}
 			cmeta->values_offset = __kds_packed(off);
 			cmeta->values_length = __kds_packed(sz);
 			off += sz;
 		}
 		else if (attr->attlen == -1)
 		{
-			sz = MAXALIGN(sizeof(uint32) * nrooms);
+			sz = MAXALIGN(sizeof(uint64_t) * nrooms);
 			cmeta->values_offset = __kds_packed(off);
 			cmeta->values_length = __kds_packed(sz);
 			off += sz;
@@ -890,6 +1644,21 @@ __setup_kern_data_store_column(kern_data_store *kds_head,
 	cmeta->values_offset = __kds_packed(off);
 	cmeta->values_length = __kds_packed(sz);
 	off += sz;
+	/* index of the key column, if any */
+	if (gc_options->index_attnum > 0)
+	{
+		kds_head->column_index_attnum = gc_options->index_attnum;
+		kds_head->column_index_nslots = gc_options->rowid_hash_nslots;
+		kds_head->column_index_offset = __kds_packed(off);
+		off += MAXALIGN(sizeof(uint32_t) * (gc_options->rowid_hash_nslots +
+											nrooms));
+	}
+	/* summary of the groups, if any */
+	if (gc_options->summary_key_attnum > 0)
+	{
+		kds_head->column_summary_offset = __kds_packed(off);
+		off += gpuCacheSummaryLength(gc_options);
+	}
 	kds_head->length = off;
 
 	/* varlena buffer size */
@@ -902,6 +1671,55 @@ __setup_kern_data_store_column(kern_data_store *kds_head,
 	*p_extra_sz = extra_sz;
 }
 
+/*
+ * __initGpuCacheDeviceBuffers
+ */
+static void
+__initGpuCacheDeviceBuffers(GpuCacheLocalMapping *gc_lmap)
+{
+	for (int r=0; r < GCACHE_MAX_REPLICAS; r++)
+	{
+		GpuCacheDeviceBuffer *gc_dbuf = &gc_lmap->gc_dbuf[r];
+
+		memset(gc_dbuf, 0, sizeof(GpuCacheDeviceBuffer));
+		gc_dbuf->gc_lmap = gc_lmap;
+		gc_dbuf->replica = r;
+		pthreadRWLockInit(&gc_dbuf->gcache_rwlock);
+	}
+}
+
+/*
+ * gpuCacheReplicaIndex - replica index on the supplied GPU, or -1
+ */
+static int
+gpuCacheReplicaIndex(const GpuCacheOptions *gc_options, int cuda_dindex)
+{
+	int		r;
+
+	if (cuda_dindex < 0 || cuda_dindex >= numGpuDevAttrs)
+		return -1;
+	r = (cuda_dindex - gc_options->cuda_dindex +
+		 numGpuDevAttrs) % numGpuDevAttrs;
+	return (r < gc_options->num_replicas ? r : -1);
+}
+
+static inline int
+gpuCacheReplicaDevice(const GpuCacheOptions *gc_options, int replica)
+{
+	return (gc_options->cuda_dindex + replica) % numGpuDevAttrs;
+}
+
+/*
+ * gpuCacheLookupDeviceBuffer - replica on the supplied GPU, or the primary
+ */
+static inline GpuCacheDeviceBuffer *
+gpuCacheLookupDeviceBuffer(GpuCacheLocalMapping *gc_lmap, int cuda_dindex)
+{
+	int		r = gpuCacheReplicaIndex(&gc_lmap->gc_sstate->gc_options,
+									 cuda_dindex);
+	return &gc_lmap->gc_dbuf[r < 0 ? 0 : r];
+}
+
 /*
  * __openGpuCacheSharedState
  *
@@ -1013,6 +1831,15 @@ __openGpuCacheSharedState(Oid database_oid,
 		goto bailout;
 	}
 	off += gc_sstate->gc_options.redo_buffer_size;
+	if (gc_sstate->gc_options.summary_key_attnum > 0)
+	{
+		if (off != gc_sstate->summary_offset)
+		{
+			snprintf(errbuf, errbuf_sz, "GpuCacheSharedState validation error");
+			goto bailout;
+		}
+		off += PAGE_ALIGN(gpuCacheSummaryLength(&gc_sstate->gc_options));
+	}
 	if (off != stat_buf.st_size)
 	{
 		snprintf(errbuf, errbuf_sz,
@@ -1037,7 +1864,7 @@ __openGpuCacheSharedState(Oid database_oid,
 	gc_lmap->refcnt = 3;
 	gc_lmap->gc_sstate = gc_sstate;
 	gc_lmap->mmap_sz = stat_buf.st_size;
-	pthreadRWLockInit(&gc_lmap->gcache_rwlock);
+	__initGpuCacheDeviceBuffers(gc_lmap);
 	hslot = __gpuCacheSharedMappingHashSlot(database_oid,
 											table_oid,
 											signature);
@@ -1075,6 +1902,7 @@ __resetGpuCacheSharedState(GpuCacheSharedState *gc_sstate)
 	rowid_items[rowid_nrooms-1].next = UINT_MAX;	/* terminator */
 	gc_sstate->rowid_next_free = 0;
 	gc_sstate->rowid_num_free = rowid_nrooms;
+	gc_sstate->rowid_map_version++;
 	pthreadMutexUnlock(&gc_sstate->rowid_mutex);
 
 	/* reset redo-log-buffer */
@@ -1085,45 +1913,64 @@ __resetGpuCacheSharedState(GpuCacheSharedState *gc_sstate)
     gc_sstate->redo_read_nitems = 0;
     gc_sstate->redo_read_pos = 0;
     gc_sstate->redo_sync_pos = 0;
+	for (int r=0; r < GCACHE_MAX_REPLICAS; r++)
+	{
+		gc_sstate->replica_read_nitems[r] = 0;
+		gc_sstate->replica_read_pos[r] = 0;
+		pg_atomic_init_u32(&gc_sstate->replica_nscans[r], 0);
+	}
+	for (int j=0; j < MaxTupleAttributeNumber; j++)
+		pg_atomic_init_u32(&gc_sstate->column_nscans[j], 0);
+	/* snapshot file may exist, so the first REDO-log write removes it */
+	gc_sstate->snapshot_valid = (pgstrom_gpucache_snapshot_dir ? UINT_MAX : 0);
+	gc_sstate->snapshot_timestamp = 0;
+	pg_atomic_init_u32(&gc_sstate->snapshot_restore, 0);
+	pg_atomic_init_u64(&gc_sstate->clone_signature, 0);
 	pthreadMutexUnlock(&gc_sstate->redo_mutex);
 
 	/* initial buffer size should be legal */
-	Assert(gc_sstate->kds_head.length <= __KDS_LENGTH_LIMIT &&
-		   gc_sstate->kds_extra_sz    <= __KDS_LENGTH_LIMIT);
+	Assert(gc_sstate->kds_head.length <= __KDS_LENGTH_LIMIT);
 	/* make this GpuCache available again */
 	pg_atomic_write_u32(&gc_sstate->phase, GCACHE_PHASE__IS_EMPTY);
 }
 
 /*
- * __createGpuCacheSharedState
+ * __buildGpuCacheSharedState
+ *
+ * It constructs a new GpuCacheSharedState segment with the supplied layout,
+ * or opens the existing one if concurrent process already built.
  */
 static GpuCacheLocalMapping *
-__createGpuCacheSharedState(Relation rel,
-							uint64_t signature,
-							const GpuCacheOptions *gc_options)
+__buildGpuCacheSharedState(const GpuCacheIdent *ident,
+						   const char *table_name,
+						   const GpuCacheOptions *gc_options,
+						   const kern_data_store *kds_head,
+						   size_t kds_extra_sz)
 {
-	TupleDesc	tupdesc = RelationGetDescr(rel);
 	int			fdesc = -1;
 	size_t		rowid_map_offset;
 	size_t		redo_buffer_offset;
+	size_t		summary_offset;
 	size_t		mmap_sz;
 	char		namebuf[MAXPGPATH];
 	dlist_head *hslot;
 	GpuCacheSharedState *gc_sstate = MAP_FAILED;
 	GpuCacheLocalMapping *gc_lmap;
 
-	Assert(signature != 0UL);
+	Assert(ident->signature != 0UL);
 	GpuCacheSharedStateName(namebuf,MAXPGPATH,
-							MyDatabaseId,
-							RelationGetRelid(rel),
-							signature);
+							ident->database_oid,
+							ident->table_oid,
+							ident->signature);
 	mmap_sz = PAGE_ALIGN(offsetof(GpuCacheSharedState, kds_head) +
-						 estimate_kern_data_store(tupdesc));
+						 KDS_HEAD_LENGTH(kds_head));
 	rowid_map_offset = mmap_sz;
 	mmap_sz += PAGE_ALIGN(sizeof(uint32_t) * gc_options->rowid_hash_nslots +
 						  sizeof(GpuCacheRowIdItem) * gc_options->max_num_rows);
 	redo_buffer_offset = mmap_sz;
 	mmap_sz += PAGE_ALIGN(gc_options->redo_buffer_size);
+	summary_offset = mmap_sz;
+	mmap_sz += PAGE_ALIGN(gpuCacheSummaryLength(gc_options));
 
 	fdesc = shm_open(namebuf, O_RDWR | O_CREAT | O_EXCL | O_TRUNC, 0600);
 	if (fdesc < 0)
@@ -1132,9 +1979,9 @@ __createGpuCacheSharedState(Relation rel,
 
 		if (errno != EEXIST)
 			elog(ERROR, "failed on shm_open('%s'): %m\n", namebuf);
-		gc_lmap = __openGpuCacheSharedState(MyDatabaseId,
-											RelationGetRelid(rel),
-											signature,
+		gc_lmap = __openGpuCacheSharedState(ident->database_oid,
+											ident->table_oid,
+											ident->signature,
 											false,
 											errbuf, sizeof(errbuf));
 		if (!gc_lmap || gc_lmap == MAP_FAILED)
@@ -1154,19 +2001,19 @@ __createGpuCacheSharedState(Relation rel,
 			elog(ERROR, "failed on mmap('%s',%zu): %m", namebuf, mmap_sz);
 		memset(gc_sstate, 0, offsetof(GpuCacheSharedState, kds_head));
 		memcpy(gc_sstate->magic, "GpuCache", 8);
-		gc_sstate->ident.database_oid = MyDatabaseId;
-		gc_sstate->ident.table_oid    = RelationGetRelid(rel);
-		gc_sstate->ident.signature    = signature;
-		strncpy(gc_sstate->table_name, RelationGetRelationName(rel), NAMEDATALEN);
+		memcpy(&gc_sstate->ident, ident, sizeof(GpuCacheIdent));
+		strncpy(gc_sstate->table_name, table_name, NAMEDATALEN);
 		gc_sstate->rowid_map_offset = rowid_map_offset;
 		gc_sstate->redo_buffer_offset = redo_buffer_offset;
+		gc_sstate->summary_offset = summary_offset;
 		memcpy(&gc_sstate->gc_options, gc_options, sizeof(GpuCacheOptions));
 		pthreadMutexInitShared(&gc_sstate->rowid_mutex);
 		pthreadMutexInitShared(&gc_sstate->redo_mutex);
-		__setup_kern_data_store_column(&gc_sstate->kds_head,
-									   &gc_sstate->kds_extra_sz,
-									   rel,
-									   gc_options->max_num_rows);
+		LWLockInitialize(&gc_sstate->wal_lock,
+						 gcache_shared_head->gcache_wal_lock_tranche);
+		pthreadMutexInitShared(&gc_sstate->summary_mutex);
+		memcpy(&gc_sstate->kds_head, kds_head, KDS_HEAD_LENGTH(kds_head));
+		gc_sstate->kds_extra_sz = kds_extra_sz;
 		__resetGpuCacheSharedState(gc_sstate);
 
 		/* build GpuCacheLocalMapping */
@@ -1174,15 +2021,15 @@ __createGpuCacheSharedState(Relation rel,
 		if (!gc_lmap)
 			elog(ERROR, "out of memory: %m");
 
-		memcpy(&gc_lmap->ident, &gc_sstate->ident, sizeof(GpuCacheOptions));
+		memcpy(&gc_lmap->ident, &gc_sstate->ident, sizeof(GpuCacheIdent));
 		gc_lmap->refcnt       = 3;
 		gc_lmap->gc_sstate    = gc_sstate;
 		gc_lmap->mmap_sz      = mmap_sz;
-		pthreadRWLockInit(&gc_lmap->gcache_rwlock);
+		__initGpuCacheDeviceBuffers(gc_lmap);
 
-		hslot = __gpuCacheSharedMappingHashSlot(MyDatabaseId,
-												RelationGetRelid(rel),
-												signature);
+		hslot = __gpuCacheSharedMappingHashSlot(ident->database_oid,
+												ident->table_oid,
+												ident->signature);
 		pthreadMutexLock(&gcache_shared_mapping_lock);
 		dlist_push_tail(hslot, &gc_lmap->chain);
 		pthreadMutexUnlock(&gcache_shared_mapping_lock);
@@ -1202,6 +2049,38 @@ __createGpuCacheSharedState(Relation rel,
 	return gc_lmap;
 }
 
+/*
+ * __createGpuCacheSharedState
+ */
+static GpuCacheLocalMapping *
+__createGpuCacheSharedState(Relation rel,
+							uint64_t signature,
+							const GpuCacheOptions *gc_options)
+{
+	TupleDesc	tupdesc = __gpuCacheVirtualTupleDesc(rel, gc_options);
+	GpuCacheIdent ident;
+	GpuCacheLocalMapping *gc_lmap;
+	kern_data_store *kds_head;
+	size_t		kds_extra_sz;
+
+	ident.database_oid = MyDatabaseId;
+	ident.table_oid    = RelationGetRelid(rel);
+	ident.signature    = signature;
+	kds_head = palloc0(estimate_kern_data_store(tupdesc));
+	__setup_kern_data_store_column(kds_head,
+								   &kds_extra_sz,
+								   rel,
+								   gc_options);
+	gc_lmap = __buildGpuCacheSharedState(&ident,
+										 RelationGetRelationName(rel),
+										 gc_options,
+										 kds_head,
+										 kds_extra_sz);
+	pfree(kds_head);
+
+	return gc_lmap;
+}
+
 /*
  * getGpuCacheLocalMappingIfExist
  */
@@ -1291,26 +2170,31 @@ __removeGpuCacheLocalMapping(GpuCacheLocalMapping *gc_lmap)
 	Assert(gc_lmap->refcnt == 0);
 	dlist_delete(&gc_lmap->chain);
 	munmap(gc_lmap->gc_sstate, gc_lmap->mmap_sz);
-	if (gc_lmap->gcache_main_devptr != 0UL)
+	for (int r=0; r < GCACHE_MAX_REPLICAS; r++)
 	{
-		/* only GpuService context */
-		rc = cuMemFree(gc_lmap->gcache_main_devptr);
-		if (rc != CUDA_SUCCESS)
-			fprintf(stderr, "failed on cuMemFree: %s\n", cuStrError(rc));
-	}
-	if (gc_lmap->gcache_extra_devptr != 0UL)
-	{
-		/* only GpuService context */
-		rc = cuMemFree(gc_lmap->gcache_extra_devptr);
-		if (rc != CUDA_SUCCESS)
-			fprintf(stderr, "failed on cuMemFree: %s\n", cuStrError(rc));
-	}
+		GpuCacheDeviceBuffer *gc_dbuf = &gc_lmap->gc_dbuf[r];
+
+		if (gc_dbuf->gcache_main_devptr != 0UL)
+		{
+			/* only GpuService context */
+			rc = cuMemFree(gc_dbuf->gcache_main_devptr);
+			if (rc != CUDA_SUCCESS)
+				fprintf(stderr, "failed on cuMemFree: %s\n", cuStrError(rc));
+		}
+		if (gc_dbuf->gcache_extra_devptr != 0UL)
+		{
+			/* only GpuService context */
+			rc = cuMemFree(gc_dbuf->gcache_extra_devptr);
+			if (rc != CUDA_SUCCESS)
+				fprintf(stderr, "failed on cuMemFree: %s\n", cuStrError(rc));
+		}
 
-	if (gc_lmap->gcache_main_devptr != 0UL)
-		fprintf(stderr, "%s: main %llu, extra %llu\n",
-				__FUNCTION__,
-				gc_lmap->gcache_main_devptr,
-				gc_lmap->gcache_extra_devptr);
+		if (gc_dbuf->gcache_main_devptr != 0UL)
+			fprintf(stderr, "%s: replica %d main %llu, extra %llu\n",
+					__FUNCTION__, r,
+					gc_dbuf->gcache_main_devptr,
+					gc_dbuf->gcache_extra_devptr);
+	}
 	free(gc_lmap);
 }
 
@@ -1401,6 +2285,7 @@ __allocGpuCacheRowId(GpuCacheLocalMapping *gc_lmap, const ItemPointer ctid)
 		hslot[hindex] = rowid;
 		Assert(gc_sstate->rowid_num_free > 0);
 		gc_sstate->rowid_num_free--;
+		gc_sstate->rowid_map_version++;
 	}
 	else
 	{
@@ -1486,6 +2371,7 @@ __removeGpuCacheRowId(GpuCacheLocalMapping *gc_lmap, const ItemPointer ctid)
 			gc_sstate->rowid_next_free = rowid;
 			ItemPointerSetInvalid(&ritem->ctid);
 			gc_sstate->rowid_num_free++;
+			gc_sstate->rowid_map_version++;
 			found = true;
 			break;
 		}
@@ -1549,8 +2435,11 @@ lookupGpuCacheDescNoLoad(Oid table_oid,
 			gc_desc->gc_lmap = gc_lmap;		//may be NULL
 			gc_desc->drop_on_rollback = false;
 			gc_desc->drop_on_commit = false;
+			gc_desc->resize_signature = 0;
 			gc_desc->nitems = 0;
 			memset(&gc_desc->buf, 0, sizeof(StringInfoData));
+			gc_desc->log_nitems = 0;
+			memset(&gc_desc->logbuf, 0, sizeof(StringInfoData));
 		}
 		PG_CATCH();
 		{
@@ -1608,8 +2497,11 @@ lookupGpuCacheDesc(Relation rel)
 			gc_desc->gc_lmap = gc_lmap;
 			gc_desc->drop_on_rollback = false;
 			gc_desc->drop_on_commit = false;
+			gc_desc->resize_signature = 0;
 			gc_desc->nitems = 0;
 			memset(&gc_desc->buf, 0, sizeof(StringInfoData));
+			gc_desc->log_nitems = 0;
+			memset(&gc_desc->logbuf, 0, sizeof(StringInfoData));
 		}
 		PG_CATCH();
 		{
@@ -1622,15 +2514,175 @@ lookupGpuCacheDesc(Relation rel)
 	return gc_desc;
 }
 
+/*
+ * lookupGpuCacheDescOnStandby
+ *
+ * It looks up the GpuCacheDesc on the hot-standby server, if the WAL replay
+ * already built the GpuCache. No transaction-id is assigned on the standby
+ * server, and it is released at the end of the (read-only) transaction.
+ */
+static GpuCacheDesc *
+lookupGpuCacheDescOnStandby(Relation rel,
+							uint64_t signature,
+							GpuCacheOptions *gc_options)
+{
+	GpuCacheDesc	hkey;
+	GpuCacheDesc   *gc_desc;
+	bool			found;
+
+	Assert(RecoveryInProgress());
+	if (signature == 0)
+		return NULL;
+	memset(&hkey, 0, sizeof(GpuCacheDesc));
+	hkey.ident.database_oid = MyDatabaseId;
+	hkey.ident.table_oid = RelationGetRelid(rel);
+	hkey.ident.signature = signature;
+	hkey.xid = InvalidTransactionId;
+
+	gc_desc = hash_search(gcache_descriptors_htab,
+						  &hkey, HASH_FIND, NULL);
+	if (gc_desc)
+		return gc_desc;
+
+	PG_TRY();
+	{
+		GpuCacheLocalMapping *gc_lmap
+			= getGpuCacheLocalMappingIfExist(MyDatabaseId,
+											 RelationGetRelid(rel),
+											 signature,
+											 false);
+		if (!gc_lmap)
+		{
+			elog(DEBUG2, "gpucache: table '%s' is not replayed on the hot-standby server",
+				 RelationGetRelationName(rel));
+			return NULL;
+		}
+		gc_desc = hash_search(gcache_descriptors_htab,
+							  &hkey, HASH_ENTER, &found);
+		Assert(!found);
+		memcpy(&gc_desc->gc_options, gc_options, sizeof(GpuCacheOptions));
+		gc_desc->gc_lmap = gc_lmap;
+		gc_desc->drop_on_rollback = false;
+		gc_desc->drop_on_commit = false;
+		gc_desc->resize_signature = 0;
+		gc_desc->nitems = 0;
+		memset(&gc_desc->buf, 0, sizeof(StringInfoData));
+		gc_desc->log_nitems = 0;
+		memset(&gc_desc->logbuf, 0, sizeof(StringInfoData));
+	}
+	PG_CATCH();
+	{
+		hash_search(gcache_descriptors_htab,
+					&hkey, HASH_REMOVE, NULL);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	return gc_desc;
+}
+
+/*
+ * __gpuCacheRegisterResizing
+ *
+ * It keeps the previous GpuCache until the new one is cloned from it on
+ * the initial loading. If the new one is already built, or no free slot
+ * is left, the previous one shall be dropped as usual.
+ */
+static bool
+__gpuCacheRegisterResizing(GpuCacheDesc *gc_desc)
+{
+	char		namebuf[MAXPGPATH];
+	int			fdesc;
+	int			index = -1;
+
+	GpuCacheSharedStateName(namebuf, MAXPGPATH,
+							gc_desc->ident.database_oid,
+							gc_desc->ident.table_oid,
+							gc_desc->resize_signature);
+	pthreadMutexLock(&gcache_shared_head->gcache_sstate_mutex);
+	fdesc = shm_open(namebuf, O_RDONLY, 0600);
+	if (fdesc >= 0)
+		close(fdesc);
+	else
+	{
+		for (int i=0; i < GCACHE_RESIZE_NSLOTS; i++)
+		{
+			if (gcache_shared_head->gcache_resize_slots[i].new_signature == 0)
+			{
+				index = i;
+				break;
+			}
+		}
+		if (index >= 0)
+		{
+			memcpy(&gcache_shared_head->gcache_resize_slots[index].ident,
+				   &gc_desc->ident, sizeof(GpuCacheIdent));
+			gcache_shared_head->gcache_resize_slots[index].new_signature
+				= gc_desc->resize_signature;
+		}
+	}
+	pthreadMutexUnlock(&gcache_shared_head->gcache_sstate_mutex);
+
+	return (index >= 0);
+}
+
+/*
+ * __gpuCacheFetchResizing
+ *
+ * It fetches the previous GpuCache to be cloned to the supplied one.
+ */
+static bool
+__gpuCacheFetchResizing(const GpuCacheIdent *ident, GpuCacheIdent *prev)
+{
+	bool		found = false;
+
+	pthreadMutexLock(&gcache_shared_head->gcache_sstate_mutex);
+	for (int i=0; i < GCACHE_RESIZE_NSLOTS; i++)
+	{
+		GpuCacheIdent *curr = &gcache_shared_head->gcache_resize_slots[i].ident;
+
+		if (curr->database_oid == ident->database_oid &&
+			curr->table_oid    == ident->table_oid &&
+			gcache_shared_head->gcache_resize_slots[i].new_signature == ident->signature)
+		{
+			memcpy(prev, curr, sizeof(GpuCacheIdent));
+			memset(&gcache_shared_head->gcache_resize_slots[i], 0,
+				   sizeof(gcache_shared_head->gcache_resize_slots[i]));
+			found = true;
+			break;
+		}
+	}
+	pthreadMutexUnlock(&gcache_shared_head->gcache_sstate_mutex);
+
+	return found;
+}
+
 static void
 releaseGpuCacheDesc(GpuCacheDesc *gc_desc, bool normal_commit)
 {
-	if (normal_commit
-		? gc_desc->drop_on_commit
-		: gc_desc->drop_on_rollback)
+	bool		drop_cache = (normal_commit
+							  ? gc_desc->drop_on_commit
+							  : gc_desc->drop_on_rollback);
+
+	/* the previous GpuCache is kept for the online resizing */
+	if (normal_commit && !drop_cache &&
+		gc_desc->resize_signature != 0 &&
+		!__gpuCacheRegisterResizing(gc_desc))
+		drop_cache = true;
+
+	if (drop_cache)
 	{
+		GpuCacheIdent prev_ident;
 		char	namebuf[MAXPGPATH];
 
+		/* pending logs make no sense any more */
+		if (gcache_pending_desc == gc_desc)
+			gcache_pending_desc = NULL;
+		/* the previous GpuCache to be cloned is no longer needed */
+		if (__gpuCacheFetchResizing(&gc_desc->ident, &prev_ident))
+			__gpuCacheDropPreviousCache(&prev_ident,
+										gc_desc->gc_options.cuda_dindex);
+
 		/* unload from the server */
 		gpuCacheInvokeDropUnload(gc_desc, true);
 		/* unlink the shared memory segment */
@@ -1639,6 +2691,8 @@ releaseGpuCacheDesc(GpuCacheDesc *gc_desc, bool normal_commit)
 								gc_desc->ident.table_oid,
 								gc_desc->ident.signature);
 		shm_unlink(namebuf);
+		if (gpuCacheWalLoggingEnabled())
+			__gpuCacheXLogIdent(&gc_desc->ident, XLOG_GPUCACHE_DROP);
 
 		if (gc_desc->gc_lmap)
 			putGpuCacheLocalMapping(gc_desc->gc_lmap);
@@ -1647,6 +2701,8 @@ releaseGpuCacheDesc(GpuCacheDesc *gc_desc, bool normal_commit)
 	{
 		const char *pos = gc_desc->buf.data;
 
+		/* INSERT/DELETE logs must be prior to the COMMIT/ABORT logs */
+		__gpuCacheFlushLogs();
 		for (uint32_t i=0; i < gc_desc->nitems; i++)
 		{
 			PendingCtidItem	   *pitem = (PendingCtidItem *)pos;
@@ -1686,15 +2742,19 @@ releaseGpuCacheDesc(GpuCacheDesc *gc_desc, bool normal_commit)
 					 pitem->tag);
 				continue;
 			}
-			__gpuCacheAppendLog(gc_desc, (GCacheTxLogCommon *)&tx_log);
+			__gpuCacheBatchLog(gc_desc, (GCacheTxLogCommon *)&tx_log);
 
 			pos += sizeof(PendingCtidItem);
 		}
+		__gpuCacheFlushLogs();
 		putGpuCacheLocalMapping(gc_desc->gc_lmap);
 	}
 	/* cleanup itself */
+	Assert(gcache_pending_desc != gc_desc);
 	if (gc_desc->buf.data)
 		pfree(gc_desc->buf.data);
+	if (gc_desc->logbuf.data)
+		pfree(gc_desc->logbuf.data);
 	hash_search(gcache_descriptors_htab,
 				gc_desc, HASH_REMOVE, NULL);
 }
@@ -1955,6 +3015,108 @@ __makeFlattenHeapTuple(Relation rel, HeapTuple tuple)
 	return tuple;
 }
 
+/*
+ * __gpuCacheJsonbFieldText - same as jsonb_object_field_text()
+ */
+static Datum
+__gpuCacheJsonbFieldText(Datum datum, const char *key, bool *p_isnull)
+{
+	Jsonb	   *jb = DatumGetJsonbP(datum);
+	JsonbValue	vbuf;
+	JsonbValue *v;
+
+	*p_isnull = true;
+	if (!JB_ROOT_IS_OBJECT(jb))
+		return 0;
+	v = getKeyJsonValueFromContainer(&jb->root, key, strlen(key), &vbuf);
+	if (!v)
+		return 0;
+	switch (v->type)
+	{
+		case jbvNull:
+			return 0;
+		case jbvBool:
+			*p_isnull = false;
+			return CStringGetTextDatum(v->val.boolean ? "true" : "false");
+		case jbvString:
+			*p_isnull = false;
+			return PointerGetDatum(cstring_to_text_with_len(v->val.string.val,
+															v->val.string.len));
+		case jbvNumeric:
+			*p_isnull = false;
+			return CStringGetTextDatum(DatumGetCString(DirectFunctionCall1(numeric_out,
+												NumericGetDatum(v->val.numeric))));
+		case jbvBinary:
+			*p_isnull = false;
+			return CStringGetTextDatum(JsonbToCString(NULL,
+													  v->val.binary.data,
+													  v->val.binary.len));
+		default:
+			elog(ERROR, "unrecognized jsonb type: %d", (int) v->type);
+	}
+	return 0;
+}
+
+/*
+ * __makeGpuCacheLogTuple
+ *
+ * It makes a flatten HeapTuple to be written to the REDO-log. If GpuCache
+ * has virtual columns, the tuple also contains their values next to the
+ * regular columns, so the device code applies them as usual.
+ */
+static HeapTuple
+__makeGpuCacheLogTuple(GpuCacheDesc *gc_desc, Relation rel, HeapTuple tuple)
+{
+	const GpuCacheOptions *gc_options = &gc_desc->gc_options;
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	TupleDesc	vtupdesc;
+	HeapTuple	vtuple;
+	Datum	   *values;
+	bool	   *isnull;
+	int			natts = tupdesc->natts;
+
+	if (gc_options->num_vcols == 0)
+		return __makeFlattenHeapTuple(rel, tuple);
+
+	vtupdesc = __gpuCacheVirtualTupleDesc(rel, gc_options);
+	values = palloc(sizeof(Datum) * vtupdesc->natts);
+	isnull = palloc(sizeof(bool)  * vtupdesc->natts);
+	heap_deform_tuple(tuple, tupdesc, values, isnull);
+	for (int j=0; j < natts; j++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+
+		/* device code cannot de-toast varlena */
+		if (!isnull[j] && attr->attlen == -1)
+			values[j] = PointerGetDatum(pg_detoast_datum_packed((struct varlena *)
+																DatumGetPointer(values[j])));
+	}
+	for (int k=0; k < gc_options->num_vcols; k++)
+	{
+		int		anum = gc_options->vcols[k].attnum;
+
+		if (anum < 1 || anum > natts || isnull[anum-1])
+		{
+			values[natts+k] = 0;
+			isnull[natts+k] = true;
+		}
+		else
+		{
+			values[natts+k] = __gpuCacheJsonbFieldText(values[anum-1],
+													   gc_options->vcols[k].key,
+													   &isnull[natts+k]);
+		}
+	}
+	vtuple = heap_form_tuple(vtupdesc, values, isnull);
+	vtuple->t_self = tuple->t_self;
+	vtuple->t_tableOid = tuple->t_tableOid;
+	vtuple->t_data->t_ctid = tuple->t_data->t_ctid;
+
+	pfree(values);
+	pfree(isnull);
+	return vtuple;
+}
+
 /*
  * __gpuCacheInitLoadTrackCtid
  */
@@ -1986,72 +3148,331 @@ __gpuCacheInitLoadTrackCtid(GpuCacheDesc *gc_desc,
 }
 
 /*
- * __initialLoadGpuCache - entrypoint of the initial loading
+ * __initialLoadGpuCacheTuple
+ *
+ * It writes out the INSERT log of the supplied tuple. It returns false if
+ * no rowid is available any more (GpuCache is already corrupted).
  */
-static void
-__initialLoadGpuCache(GpuCacheDesc *gc_desc, Relation rel)
+static bool
+__initialLoadGpuCacheTuple(GpuCacheDesc *gc_desc, Relation rel,
+						   HeapTuple scantup,
+						   TransactionId gcache_xmin,
+						   TransactionId gcache_xmax,
+						   StringInfo ibuf)
 {
-	TableScanDesc	hscan;
-	HeapTuple		scantup;
-	HeapTuple		tuple;
-	size_t			item_sz = 2048;
-	GCacheTxLogInsert *item = alloca(item_sz);
+	GCacheTxLogInsert *item;
+	HeapTuple	tuple;
+	uint32_t	rowid;
+	size_t		sz;
 
-	Assert(gc_desc->gc_lmap != NULL);
+	tuple = __makeGpuCacheLogTuple(gc_desc, rel, scantup);
+	sz = MAXALIGN(offsetof(GCacheTxLogInsert, htup) + tuple->t_len);
+	resetStringInfo(ibuf);
+	enlargeStringInfo(ibuf, sz);
+	item = (GCacheTxLogInsert *)ibuf->data;
 
-	hscan = table_beginscan(rel, SnapshotAny, 0, NULL);
-	while ((scantup = heap_getnext(hscan, ForwardScanDirection)) != NULL)
+	rowid = __allocGpuCacheRowId(gc_desc->gc_lmap, &tuple->t_self);
+	if (rowid == UINT_MAX)
+		return false;
+	PG_TRY();
 	{
-		TransactionId	gcache_xmin;
-		TransactionId	gcache_xmax;
-		uint32_t		rowid;
-		size_t			sz;
-
-		CHECK_FOR_INTERRUPTS();
+		if (TransactionIdIsNormal(gcache_xmin))
+			__gpuCacheInitLoadTrackCtid(gc_desc, gcache_xmin,
+										'I', rowid, &tuple->t_self);
+		if (TransactionIdIsNormal(gcache_xmax))
+			__gpuCacheInitLoadTrackCtid(gc_desc, gcache_xmax,
+										'D', rowid, &tuple->t_self);
 
-		if (!__initialLoadGpuCacheVisibilityCheck(scantup,
-												  &gcache_xmin,
-												  &gcache_xmax))
-			continue;
+		item->type = GCACHE_TX_LOG__INSERT;
+		item->length = sz;
+		item->rowid = rowid;
+		memcpy(&item->htup, tuple->t_data, tuple->t_len);
+		memcpy(&item->htup.t_ctid, &tuple->t_self, sizeof(ItemPointerData));
+		HeapTupleHeaderSetXmin(&item->htup, gcache_xmin);
+		HeapTupleHeaderSetXmax(&item->htup, gcache_xmax);
+		HeapTupleHeaderSetCmin(&item->htup, InvalidCommandId);
 
-		tuple = __makeFlattenHeapTuple(rel, scantup);
-		sz = MAXALIGN(offsetof(GCacheTxLogInsert, htup) + tuple->t_len);
-		if (sz > item_sz)
-		{
-			item_sz = 2 * sz + 1024;
-			item = alloca(item_sz);
-		}
-		rowid = __allocGpuCacheRowId(gc_desc->gc_lmap, &tuple->t_self);
-		if (rowid == UINT_MAX)
-			break;
-		PG_TRY();
-		{
-			if (TransactionIdIsNormal(gcache_xmin))
-				__gpuCacheInitLoadTrackCtid(gc_desc, gcache_xmin,
-											'I', rowid, &tuple->t_self);
-			if (TransactionIdIsNormal(gcache_xmax))
-				__gpuCacheInitLoadTrackCtid(gc_desc, gcache_xmax,
-											'D', rowid, &tuple->t_self);
+		__gpuCacheBatchLog(gc_desc, (GCacheTxLogCommon *)item);
+	}
+	PG_CATCH();
+	{
+		__removeGpuCacheRowId(gc_desc->gc_lmap, &tuple->t_self);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	return true;
+}
+
+/*
+ * GpuCacheInitLoadShared
+ *
+ * The initial loading of a large table is parallelized by block range; the
+ * leader and workers share the parallel heap scan, and append the INSERT
+ * logs to the REDO log buffer concurrently.
+ * The tuples inserted or deleted by the current transaction have to be
+ * tracked by the GpuCacheDesc of the leader, so workers skip them and mark
+ * the blocks to be loaded by the leader later.
+ */
+#define PARALLEL_KEY_GCACHE_SHARED	UINT64CONST(0xE000000000000001)
+#define PARALLEL_KEY_GCACHE_PSCAN	UINT64CONST(0xE000000000000002)
+
+typedef struct
+{
+	Oid			database_oid;
+	Oid			table_oid;
+	uint64_t	signature;
+	BlockNumber	nblocks;
+	pg_atomic_uint32 own_blocks[FLEXIBLE_ARRAY_MEMBER];	/* bitmap */
+} GpuCacheInitLoadShared;
+
+void	gpuCacheInitialLoadWorker(dsm_segment *seg, shm_toc *toc);
+
+/*
+ * __initialLoadGpuCacheParallelScan
+ */
+static void
+__initialLoadGpuCacheParallelScan(GpuCacheDesc *gc_desc, Relation rel,
+								  GpuCacheInitLoadShared *gc_ishared,
+								  ParallelTableScanDesc pscan)
+{
+	TableScanDesc	hscan;
+	HeapTuple		scantup;
+	StringInfoData	ibuf;
+
+	initStringInfo(&ibuf);
+	hscan = table_beginscan_parallel(rel, pscan);
+	while ((scantup = heap_getnext(hscan, ForwardScanDirection)) != NULL)
+	{
+		TransactionId	gcache_xmin;
+		TransactionId	gcache_xmax;
+
+		CHECK_FOR_INTERRUPTS();
 
-			item->type = GCACHE_TX_LOG__INSERT;
-			item->length = sz;
-			item->rowid = rowid;
-			memcpy(&item->htup, tuple->t_data, tuple->t_len);
-			memcpy(&item->htup.t_ctid, &tuple->t_self, sizeof(ItemPointerData));
-			HeapTupleHeaderSetXmin(&item->htup, gcache_xmin);
-			HeapTupleHeaderSetXmax(&item->htup, gcache_xmax);
-			HeapTupleHeaderSetCmin(&item->htup, InvalidCommandId);
+		if (!__initialLoadGpuCacheVisibilityCheck(scantup,
+												  &gcache_xmin,
+												  &gcache_xmax))
+			continue;
+		if (TransactionIdIsNormal(gcache_xmin) ||
+			TransactionIdIsNormal(gcache_xmax))
+		{
+			BlockNumber	blkno = ItemPointerGetBlockNumber(&scantup->t_self);
 
-			__gpuCacheAppendLog(gc_desc, (GCacheTxLogCommon *)item);
+			Assert(blkno < gc_ishared->nblocks);
+			pg_atomic_fetch_or_u32(&gc_ishared->own_blocks[blkno / 32],
+								   (1U << (blkno % 32)));
+			continue;
 		}
-		PG_CATCH();
+		if (!__initialLoadGpuCacheTuple(gc_desc, rel, scantup,
+										gcache_xmin,
+										gcache_xmax, &ibuf))
+			break;
+	}
+	table_endscan(hscan);
+	__gpuCacheFlushLogs();
+	pfree(ibuf.data);
+}
+
+/*
+ * gpuCacheInitialLoadWorker - entrypoint of the parallel worker
+ */
+void
+gpuCacheInitialLoadWorker(dsm_segment *seg, shm_toc *toc)
+{
+	GpuCacheInitLoadShared *gc_ishared;
+	ParallelTableScanDesc pscan;
+	GpuCacheLocalMapping *gc_lmap;
+	GpuCacheDesc	gc_desc;
+	Relation		rel;
+
+	gc_ishared = shm_toc_lookup(toc, PARALLEL_KEY_GCACHE_SHARED, false);
+	pscan = shm_toc_lookup(toc, PARALLEL_KEY_GCACHE_PSCAN, false);
+
+	gc_lmap = getGpuCacheLocalMappingIfExist(gc_ishared->database_oid,
+											 gc_ishared->table_oid,
+											 gc_ishared->signature,
+											 false);
+	if (!gc_lmap)
+		elog(ERROR, "gpucache: GpuCache of the initial loading not found");
+	rel = table_open(gc_ishared->table_oid, AccessShareLock);
+
+	memset(&gc_desc, 0, sizeof(GpuCacheDesc));
+	memcpy(&gc_desc.ident, &gc_lmap->ident, sizeof(GpuCacheIdent));
+	gc_desc.xid = GetCurrentTransactionIdIfAny();
+	memcpy(&gc_desc.gc_options, &gc_lmap->gc_sstate->gc_options,
+		   sizeof(GpuCacheOptions));
+	gc_desc.gc_lmap = gc_lmap;
+
+	__initialLoadGpuCacheParallelScan(&gc_desc, rel, gc_ishared, pscan);
+
+	if (gc_desc.logbuf.data)
+		pfree(gc_desc.logbuf.data);
+	table_close(rel, AccessShareLock);
+	putGpuCacheLocalMapping(gc_lmap);
+}
+
+/*
+ * __initialLoadGpuCacheParallel
+ *
+ * It returns false if no parallel workers are available, then the caller
+ * loads the table by itself.
+ */
+static bool
+__initialLoadGpuCacheParallel(GpuCacheDesc *gc_desc, Relation rel)
+{
+	ParallelContext *pcxt;
+	ParallelTableScanDesc pscan;
+	GpuCacheInitLoadShared *gc_ishared;
+	BlockNumber	nblocks;
+	size_t		sz;
+	bool		snapshot_pushed = false;
+	int			nworkers = pgstrom_gpucache_initial_load_workers;
+
+	if (nworkers <= 0 ||
+		IsInParallelMode() ||
+		rel->rd_rel->relpersistence == RELPERSISTENCE_TEMP)
+		return false;
+	nblocks = RelationGetNumberOfBlocks(rel);
+	if (nblocks < (BlockNumber)min_parallel_table_scan_size * 2)
+		return false;
+	nworkers = Min(nworkers, nblocks / min_parallel_table_scan_size);
+
+	/* parallel context needs the active snapshot */
+	if (!ActiveSnapshotSet())
+	{
+		PushActiveSnapshot(GetTransactionSnapshot());
+		snapshot_pushed = true;
+	}
+	EnterParallelMode();
+	pcxt = CreateParallelContext("$libdir/pg_strom",
+								 "gpuCacheInitialLoadWorker",
+								 nworkers);
+	sz = offsetof(GpuCacheInitLoadShared,
+				  own_blocks[(nblocks + 31) / 32]);
+	shm_toc_estimate_chunk(&pcxt->estimator, sz);
+	shm_toc_estimate_chunk(&pcxt->estimator,
+						   table_parallelscan_estimate(rel, SnapshotAny));
+	shm_toc_estimate_keys(&pcxt->estimator, 2);
+	InitializeParallelDSM(pcxt);
+	if (!pcxt->seg)
+	{
+		/* no DSM segment; shall be loaded serially */
+		DestroyParallelContext(pcxt);
+		ExitParallelMode();
+		if (snapshot_pushed)
+			PopActiveSnapshot();
+		return false;
+	}
+	gc_ishared = shm_toc_allocate(pcxt->toc, sz);
+	memset(gc_ishared, 0, sz);
+	gc_ishared->database_oid = gc_desc->ident.database_oid;
+	gc_ishared->table_oid = gc_desc->ident.table_oid;
+	gc_ishared->signature = gc_desc->ident.signature;
+	gc_ishared->nblocks = nblocks;
+	for (BlockNumber i=0; i < (nblocks + 31) / 32; i++)
+		pg_atomic_init_u32(&gc_ishared->own_blocks[i], 0);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_GCACHE_SHARED, gc_ishared);
+
+	pscan = shm_toc_allocate(pcxt->toc,
+							 table_parallelscan_estimate(rel, SnapshotAny));
+	table_parallelscan_initialize(rel, pscan, SnapshotAny);
+	/*
+	 * Blocks extended later contain only tuples of concurrent transactions;
+	 * their sync triggers wait for the initial loading, then write the logs.
+	 */
+	if (((ParallelBlockTableScanDesc)pscan)->phs_nblocks > nblocks)
+		((ParallelBlockTableScanDesc)pscan)->phs_nblocks = nblocks;
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_GCACHE_PSCAN, pscan);
+
+	LaunchParallelWorkers(pcxt);
+	elog(DEBUG1, "gpucache: initial loading of '%s' by %d parallel workers",
+		 RelationGetRelationName(rel), pcxt->nworkers_launched);
+	/* the leader also participates in the scan */
+	__initialLoadGpuCacheParallelScan(gc_desc, rel, gc_ishared, pscan);
+	WaitForParallelWorkersToFinish(pcxt);
+
+	/* tuples of the current transaction, skipped by the parallel scan */
+	if (pg_atomic_read_u32(&gc_desc->gc_lmap->gc_sstate->phase) != GCACHE_PHASE__IS_CORRUPTED)
+	{
+		TableScanDesc	hscan;
+		HeapTuple		scantup;
+		StringInfoData	ibuf;
+
+		initStringInfo(&ibuf);
+		hscan = table_beginscan(rel, SnapshotAny, 0, NULL);
+		for (BlockNumber blkno=0; blkno < nblocks; blkno++)
 		{
-			__removeGpuCacheRowId(gc_desc->gc_lmap, &tuple->t_self);
-			PG_RE_THROW();
+			if ((pg_atomic_read_u32(&gc_ishared->own_blocks[blkno / 32]) &
+				 (1U << (blkno % 32))) == 0)
+				continue;
+			table_rescan(hscan, NULL);
+			heap_setscanlimits(hscan, blkno, 1);
+			while ((scantup = heap_getnext(hscan, ForwardScanDirection)) != NULL)
+			{
+				TransactionId	gcache_xmin;
+				TransactionId	gcache_xmax;
+
+				CHECK_FOR_INTERRUPTS();
+
+				if (!__initialLoadGpuCacheVisibilityCheck(scantup,
+														  &gcache_xmin,
+														  &gcache_xmax) ||
+					(!TransactionIdIsNormal(gcache_xmin) &&
+					 !TransactionIdIsNormal(gcache_xmax)))
+					continue;
+				if (!__initialLoadGpuCacheTuple(gc_desc, rel, scantup,
+												gcache_xmin,
+												gcache_xmax, &ibuf))
+					break;
+			}
 		}
-		PG_END_TRY();
+		table_endscan(hscan);
+		__gpuCacheFlushLogs();
+		pfree(ibuf.data);
+	}
+	DestroyParallelContext(pcxt);
+	ExitParallelMode();
+	if (snapshot_pushed)
+		PopActiveSnapshot();
+
+	return true;
+}
+
+/*
+ * __initialLoadGpuCache - entrypoint of the initial loading
+ */
+static void
+__initialLoadGpuCache(GpuCacheDesc *gc_desc, Relation rel)
+{
+	TableScanDesc	hscan;
+	HeapTuple		scantup;
+	StringInfoData	ibuf;
+
+	Assert(gc_desc->gc_lmap != NULL);
+	if (__initialLoadGpuCacheParallel(gc_desc, rel))
+		return;
+
+	initStringInfo(&ibuf);
+	hscan = table_beginscan(rel, SnapshotAny, 0, NULL);
+	while ((scantup = heap_getnext(hscan, ForwardScanDirection)) != NULL)
+	{
+		TransactionId	gcache_xmin;
+		TransactionId	gcache_xmax;
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (!__initialLoadGpuCacheVisibilityCheck(scantup,
+												  &gcache_xmin,
+												  &gcache_xmax))
+			continue;
+		if (!__initialLoadGpuCacheTuple(gc_desc, rel, scantup,
+										gcache_xmin,
+										gcache_xmax, &ibuf))
+			break;
 	}
 	table_endscan(hscan);
+	__gpuCacheFlushLogs();
+	pfree(ibuf.data);
 }
 
 static bool
@@ -2059,6 +3480,11 @@ initialLoadGpuCache(GpuCacheDesc *gc_desc, Relation rel)
 {
 	GpuCacheSharedState *gc_sstate;
 
+	/* GpuCache on the standby server is built only by the WAL replay */
+	if (RecoveryInProgress())
+		return (gc_desc->gc_lmap != NULL &&
+				pg_atomic_read_u32(&gc_desc->gc_lmap->gc_sstate->phase)
+				== GCACHE_PHASE__IS_READY);
 	if (!gc_desc->gc_lmap)
 	{
 		GpuCacheOptions gc_options;
@@ -2079,7 +3505,24 @@ initialLoadGpuCache(GpuCacheDesc *gc_desc, Relation rel)
 		{
 			PG_TRY();
 			{
-				__initialLoadGpuCache(gc_desc, rel);
+				/*
+				 * The standby server cannot clone its GpuCache nor restore
+				 * the snapshot in the same manner, so the initial loading
+				 * shall be written to WAL.
+				 */
+				if (gpuCacheWalLoggingEnabled())
+				{
+					GpuCacheIdent prev_ident;
+
+					if (__gpuCacheFetchResizing(&gc_desc->ident, &prev_ident))
+						__gpuCacheDropPreviousCache(&prev_ident,
+													gc_desc->gc_options.cuda_dindex);
+					__gpuCacheXLogReset(gc_sstate);
+					__initialLoadGpuCache(gc_desc, rel);
+				}
+				else if (!__gpuCacheCloneFromPrevious(gc_desc) &&
+						 !__gpuCacheRestoreSnapshot(gc_desc))
+					__initialLoadGpuCache(gc_desc, rel);
 			}
 			PG_CATCH();
 			{
@@ -2097,6 +3540,8 @@ initialLoadGpuCache(GpuCacheDesc *gc_desc, Relation rel)
 				Assert(phase == GCACHE_PHASE__IS_CORRUPTED);
 				return false;
 			}
+			if (gpuCacheWalLoggingEnabled())
+				__gpuCacheXLogIdent(&gc_desc->ident, XLOG_GPUCACHE_READY);
 			return true;
 		}
 		else if (phase == GCACHE_PHASE__IS_READY)
@@ -2144,13 +3589,31 @@ baseRelHasGpuCache(PlannerInfo *root, RelOptInfo *baserel)
 			GpuCacheLocalMapping *gc_lmap;
 			uint32_t	phase;
 
-			gc_lmap = getGpuCacheLocalMapping(rel, signature, &gc_options);
-			phase = pg_atomic_read_u32(&gc_lmap->gc_sstate->phase);
-			if (phase == GCACHE_PHASE__IS_EMPTY ||
-				phase == GCACHE_PHASE__IS_LOADING ||
-				phase == GCACHE_PHASE__IS_READY)
+			if (RecoveryInProgress())
+			{
+				/* only GpuCache already built by the WAL replay */
+				gc_lmap = getGpuCacheLocalMappingIfExist(MyDatabaseId,
+														 RelationGetRelid(rel),
+														 signature,
+														 false);
+				if (gc_lmap)
+				{
+					phase = pg_atomic_read_u32(&gc_lmap->gc_sstate->phase);
+					if (phase == GCACHE_PHASE__IS_READY)
+						cuda_dindex = gc_options.cuda_dindex;
+					putGpuCacheLocalMapping(gc_lmap);
+				}
+			}
+			else
 			{
-				cuda_dindex = gc_options.cuda_dindex;
+				gc_lmap = getGpuCacheLocalMapping(rel, signature, &gc_options);
+				phase = pg_atomic_read_u32(&gc_lmap->gc_sstate->phase);
+				if (phase == GCACHE_PHASE__IS_EMPTY ||
+					phase == GCACHE_PHASE__IS_LOADING ||
+					phase == GCACHE_PHASE__IS_READY)
+				{
+					cuda_dindex = gc_options.cuda_dindex;
+				}
 			}
 		}
 		table_close(rel, NoLock);
@@ -2158,6 +3621,207 @@ baseRelHasGpuCache(PlannerInfo *root, RelOptInfo *baserel)
 	return (pgstrom_enable_gpucache ? cuda_dindex : -1);
 }
 
+/*
+ * baseRelGpuCacheVirtualColumns
+ *
+ * It returns the list of virtual columns of GpuCache, as a list of
+ * (attnum, key, resno) triples; resno is the column number on the KDS
+ * of GpuCache, next to the regular columns.
+ */
+List *
+baseRelGpuCacheVirtualColumns(PlannerInfo *root, RelOptInfo *baserel)
+{
+	RangeTblEntry *rte = root->simple_rte_array[baserel->relid];
+	GpuCacheOptions gc_options;
+	Relation	rel;
+	List	   *vcols = NIL;
+
+	if (rte->rtekind != RTE_RELATION)
+		return NIL;
+	rel = table_open(rte->relid, NoLock);
+	if (gpuCacheTableSignature(rel, &gc_options) != 0UL)
+	{
+		for (int k=0; k < gc_options.num_vcols; k++)
+		{
+			vcols = lappend(vcols,
+							list_make3(makeInteger(gc_options.vcols[k].attnum),
+									   makeString(pstrdup(gc_options.vcols[k].key)),
+									   makeInteger(RelationGetNumberOfAttributes(rel) + k + 1)));
+		}
+	}
+	table_close(rel, NoLock);
+
+	return vcols;
+}
+
+/*
+ * gpuCacheMatchVirtualColumns
+ *
+ * It checks whether the virtual columns of GpuCache are identical to the
+ * ones at the planning time.
+ */
+bool
+gpuCacheMatchVirtualColumns(const GpuCacheDesc *gc_desc, List *vcols)
+{
+	const GpuCacheOptions *gc_options = &gc_desc->gc_options;
+	ListCell   *lc;
+	int			k = 0;
+
+	if (vcols == NIL || list_length(vcols) != gc_options->num_vcols)
+		return false;
+	foreach (lc, vcols)
+	{
+		List   *vcol = lfirst(lc);
+
+		if (intVal(linitial(vcol)) != gc_options->vcols[k].attnum ||
+			strcmp(strVal(lsecond(vcol)), gc_options->vcols[k].key) != 0)
+			return false;
+		k++;
+	}
+	return true;
+}
+
+/*
+ * baseRelGpuCacheIndexQual
+ *
+ * It looks for the 'KEY = Const/Param' form of the device qualifiers on
+ * the index key of GpuCache, and returns the key expression if any.
+ */
+Expr *
+baseRelGpuCacheIndexQual(PlannerInfo *root,
+						 RelOptInfo *baserel,
+						 List *dev_quals,
+						 int *p_index_attnum)
+{
+	RangeTblEntry *rte = root->simple_rte_array[baserel->relid];
+	GpuCacheOptions gc_options;
+	Relation	rel;
+	Oid			index_typeid;
+	TypeCacheEntry *tcache;
+	ListCell   *lc;
+
+	*p_index_attnum = 0;
+	if (rte->rtekind != RTE_RELATION || dev_quals == NIL)
+		return NULL;
+	rel = table_open(rte->relid, NoLock);
+	if (gpuCacheTableSignature(rel, &gc_options) == 0UL ||
+		gc_options.index_attnum == 0)
+	{
+		table_close(rel, NoLock);
+		return NULL;
+	}
+	index_typeid = TupleDescAttr(RelationGetDescr(rel),
+								 gc_options.index_attnum - 1)->atttypid;
+	table_close(rel, NoLock);
+
+	tcache = lookup_type_cache(index_typeid, TYPECACHE_EQ_OPR);
+	foreach (lc, dev_quals)
+	{
+		OpExpr	   *op = lfirst(lc);
+		Node	   *var;
+		Node	   *key;
+
+		if (!IsA(op, OpExpr) ||
+			op->opno != tcache->eq_opr ||
+			list_length(op->args) != 2)
+			continue;
+		var = linitial(op->args);
+		key = lsecond(op->args);
+		if (!IsA(var, Var))
+		{
+			var = lsecond(op->args);
+			key = linitial(op->args);
+		}
+		if (!IsA(var, Var) ||
+			((Var *)var)->varno != baserel->relid ||
+			((Var *)var)->varattno != gc_options.index_attnum ||
+			exprType(key) != index_typeid)
+			continue;
+		if ((IsA(key, Const) && !((Const *)key)->constisnull) ||
+			(IsA(key, Param) && (((Param *)key)->paramkind == PARAM_EXTERN ||
+								 ((Param *)key)->paramkind == PARAM_EXEC)))
+		{
+			*p_index_attnum = gc_options.index_attnum;
+			return (Expr *)key;
+		}
+	}
+	return NULL;
+}
+
+/*
+ * gpuCacheLookupIndexKey
+ *
+ * It evaluates the key value of the GpuCache index lookup, if the index of
+ * GpuCache is identical to the one at the planning time.
+ */
+bool
+gpuCacheLookupIndexKey(const GpuCacheDesc *gc_desc,
+					   pgstromTaskState *pts,
+					   int64_t *p_index_value)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	ExprContext	   *econtext = pts->css.ss.ps.ps_ExprContext;
+	Expr		   *key = pp_info->gpu_cache_index_key;
+	ExprState	   *key_state;
+	Datum			datum;
+	bool			isnull;
+
+	if (!key || gc_desc->gc_options.index_attnum != pp_info->gpu_cache_index_attnum)
+		return false;
+	key_state = ExecInitExpr(key, &pts->css.ss.ps);
+	datum = ExecEvalExprSwitchContext(key_state, econtext, &isnull);
+	if (isnull)
+		return false;	/* full scan, but no rows shall match */
+	*p_index_value = gpuCacheIndexKeyDatum(exprType((Node *)key), datum);
+	return true;
+}
+
+/*
+ * gpuCacheSetupBitFilter
+ *
+ * It picks up the boolean scan qualifiers ('flag' or 'NOT flag') that can
+ * be evaluated on the bit-packed columns of GpuCache (compression=on),
+ * prior to the load of rows. The attribute number is negative for 'NOT'.
+ */
+void
+gpuCacheSetupBitFilter(const GpuCacheDesc *gc_desc,
+					   pgstromTaskState *pts,
+					   kern_session_info *session)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	int			nkeys = 0;
+	ListCell   *lc;
+
+	if (!gc_desc->gc_options.compression)
+		return;
+	foreach (lc, pp_info->scan_quals)
+	{
+		Node   *expr = lfirst(lc);
+		bool	negate = false;
+		Var	   *var;
+
+		if (is_notclause(expr))
+		{
+			expr = (Node *)get_notclausearg((Expr *)expr);
+			negate = true;
+		}
+		if (!IsA(expr, Var))
+			continue;
+		var = (Var *)expr;
+		if (var->varno != pp_info->scan_relid ||
+			var->vartype != BOOLOID ||
+			var->varattno <= 0 ||
+			var->varattno > RelationGetNumberOfAttributes(pts->css.ss.ss_currentRelation))
+			continue;
+		session->gpucache_bitfilter_attnums[nkeys++] = (negate
+														? -var->varattno
+														:  var->varattno);
+		if (nkeys >= GPUCACHE_BITFILTER_MAX_NKEYS)
+			break;
+	}
+	session->gpucache_bitfilter_nkeys = nkeys;
+}
+
 /*
  * RelationHasGpuCache
  */
@@ -2283,6 +3947,15 @@ gpuCacheInvokeApplyRedo(const GpuCacheDesc *gc_desc,
 						uint64 sync_pos,
 						bool is_async)
 {
+	/* replicas shall be updated asynchronously, then the primary one */
+	for (int r=1; r < gc_desc->gc_options.num_replicas; r++)
+	{
+		__gpuCacheInvokeBackgroundCommand(&gc_desc->ident,
+										  gpuCacheReplicaDevice(&gc_desc->gc_options, r),
+										  true,
+										  GCACHE_CONTROL_CMD__APPLY_REDO,
+										  sync_pos);
+	}
 	__gpuCacheInvokeBackgroundCommand(&gc_desc->ident,
 									  gc_desc->gc_options.cuda_dindex,
 									  is_async,
@@ -2296,6 +3969,14 @@ gpuCacheInvokeApplyRedo(const GpuCacheDesc *gc_desc,
 static void
 gpuCacheInvokeCompaction(const GpuCacheDesc *gc_desc, bool is_async)
 {
+	for (int r=1; r < gc_desc->gc_options.num_replicas; r++)
+	{
+		__gpuCacheInvokeBackgroundCommand(&gc_desc->ident,
+										  gpuCacheReplicaDevice(&gc_desc->gc_options, r),
+										  true,
+										  GCACHE_CONTROL_CMD__COMPACTION,
+										  0);
+	}
 	__gpuCacheInvokeBackgroundCommand(&gc_desc->ident,
 									  gc_desc->gc_options.cuda_dindex,
 									  is_async,
@@ -2316,45 +3997,246 @@ gpuCacheInvokeDropUnload(const GpuCacheDesc *gc_desc, bool is_async)
 									  0);
 }
 
+/* ------------------------------------------------------------
+ *
+ * Routines to restore GpuCache from the on-disk snapshot
+ *
+ * ------------------------------------------------------------
+ */
+
 /*
- * __gpuCacheAppendLog
+ * __gpuCacheRemoveSnapshot
  */
 static void
-__gpuCacheAppendLog(GpuCacheDesc *gc_desc, GCacheTxLogCommon *tx_log)
+__gpuCacheRemoveSnapshot(const GpuCacheIdent *ident)
 {
-	GpuCacheSharedState *gc_sstate = gc_desc->gc_lmap->gc_sstate;
-	char	   *redo_buffer = gpuCacheRedoLogBuffer(gc_sstate);
-	size_t		buffer_sz = gc_sstate->gc_options.redo_buffer_size;
-	bool		append_done = false;
+	char		path[MAXPGPATH];
 
-	Assert(tx_log->length == MAXALIGN(tx_log->length));
-	while (!append_done)
-	{
-		size_t		usage;
-		uint32_t	phase;
-		uint64_t	sync_pos;
+	if (!pgstrom_gpucache_snapshot_dir)
+		return;
+	GpuCacheSnapshotFileName(path, MAXPGPATH,
+							 ident->database_oid,
+							 ident->table_oid,
+							 ident->signature, "");
+	if (unlink(path) == 0)
+		fsync_fname(pgstrom_gpucache_snapshot_dir, true);
+	else if (errno != ENOENT)
+		elog(ERROR, "failed on unlink('%s'): %m", path);
+}
 
-		/*
-		 * Once GPU buffer is marked to 'corrupted', any following REDO-logs
-		 * make no sense, until pgstrom.gpucache_recovery() is called.
-		 */
-		phase = pg_atomic_read_u32(&gc_sstate->phase);
-		if (phase == GCACHE_PHASE__IS_CORRUPTED)
-			return;
-		Assert(phase == GCACHE_PHASE__IS_LOADING ||
-			   phase == GCACHE_PHASE__IS_READY);
+/*
+ * __gpuCacheRestoreSnapshot
+ *
+ * It loads the rowid-map from the snapshot, then GpuService loads the device
+ * buffers of the primary and replicas from the file. The snapshot is linked
+ * to another name during the restore, because concurrent REDO-log writes
+ * may remove the snapshot.
+ */
+static bool
+__gpuCacheRestoreSnapshot(GpuCacheDesc *gc_desc)
+{
+	GpuCacheSharedState *gc_sstate = gc_desc->gc_lmap->gc_sstate;
+	GpuCacheOptions *gc_options = &gc_sstate->gc_options;
+	GpuCacheSnapshotHeader h;
+	kern_data_store *kds_head = &gc_sstate->kds_head;
+	kern_data_store *kds_temp;
+	char		path[MAXPGPATH];
+	char		rpath[MAXPGPATH];
+	size_t		rowid_map_sz;
+	size_t		head_sz = KDS_HEAD_LENGTH(kds_head);
+	int			fdesc;
+	bool		is_fresh;
+	bool		read_ok;
+
+	if (!pgstrom_gpucache_snapshot_dir)
+		return false;
+	GpuCacheSnapshotFileName(path, MAXPGPATH,
+							 gc_sstate->ident.database_oid,
+							 gc_sstate->ident.table_oid,
+							 gc_sstate->ident.signature, "");
+	GpuCacheSnapshotFileName(rpath, MAXPGPATH,
+							 gc_sstate->ident.database_oid,
+							 gc_sstate->ident.table_oid,
+							 gc_sstate->ident.signature, ".restore");
+	if (unlink(rpath) != 0 && errno != ENOENT)
+		elog(ERROR, "failed on unlink('%s'): %m", rpath);
+	if (link(path, rpath) != 0)
+	{
+		if (errno != ENOENT)
+			elog(LOG, "gpucache: failed on link('%s','%s'): %m", path, rpath);
+		return false;
+	}
+	fdesc = open(rpath, O_RDONLY);
+	if (fdesc < 0)
+	{
+		elog(LOG, "gpucache: failed on open('%s'): %m", rpath);
+		goto skip;
+	}
+	/* validation checks */
+	rowid_map_sz = (sizeof(uint32_t) * gc_options->rowid_hash_nslots +
+					sizeof(GpuCacheRowIdItem) * gc_options->max_num_rows);
+	kds_temp = alloca(head_sz);
+	if (__preadFile(fdesc, &h, sizeof(h), 0) != sizeof(h) ||
+		memcmp(h.magic, "GCSNAP02", 8) != 0 ||
+		h.system_identifier != GetSystemIdentifier() ||
+		!GpuCacheIdentEqual(&h.ident, &gc_sstate->ident) ||
+		h.rowid_map_sz != rowid_map_sz ||
+		h.extra_usage > h.extra_length ||
+		__preadFile(fdesc, kds_temp, head_sz,
+					GpuCacheSnapshotMainOffset(&h)) != head_sz ||
+		kds_temp->format != KDS_FORMAT_COLUMN ||
+		kds_temp->ncols != kds_head->ncols ||
+		kds_temp->nr_colmeta != kds_head->nr_colmeta ||
+		kds_temp->length != h.main_sz)
+	{
+		elog(LOG, "gpucache: snapshot '%s' is not valid, so ignored", path);
+		close(fdesc);
+		goto skip;
+	}
 
-		pthreadMutexLock(&gc_sstate->redo_mutex);
+	/*
+	 * Load the rowid-map, only if nobody touched the GpuCache yet.
+	 * Any REDO-log writes during the restore removes the snapshot, but
+	 * it is still consistent with the rowid-map and the device buffers,
+	 * then, the REDO-log shall be applied on the restored GpuCache.
+	 */
+	pthreadMutexLock(&gc_sstate->rowid_mutex);
+	pthreadMutexLock(&gc_sstate->redo_mutex);
+	is_fresh = (gc_sstate->redo_write_pos == 0 &&
+				gc_sstate->rowid_num_free == gc_options->max_num_rows);
+	if (is_fresh)
+		pg_atomic_write_u32(&gc_sstate->snapshot_restore, 1);
+	pthreadMutexUnlock(&gc_sstate->redo_mutex);
+	if (!is_fresh)
+	{
+		pthreadMutexUnlock(&gc_sstate->rowid_mutex);
+		close(fdesc);
+		goto skip;
+	}
+	read_ok = (__preadFile(fdesc, gpuCacheRowIdHashSlot(gc_sstate),
+						   rowid_map_sz,
+						   GpuCacheSnapshotRowIdMapOffset(&h)) == rowid_map_sz);
+	if (read_ok)
+	{
+		gc_sstate->rowid_next_free = h.rowid_next_free;
+		gc_sstate->rowid_num_free  = h.rowid_num_free;
+	}
+	gc_sstate->rowid_map_version++;
+	pthreadMutexUnlock(&gc_sstate->rowid_mutex);
+	close(fdesc);
+	if (!read_ok)
+	{
+		pg_atomic_write_u32(&gc_sstate->snapshot_restore, 0);
+		unlink(rpath);
+		elog(ERROR, "failed on read('%s'): %m", rpath);
+	}
+
+	memcpy(kds_head, kds_temp, head_sz);
+	gc_sstate->kds_extra_sz = h.extra_length;
+	pg_atomic_write_u64(&gc_sstate->gcache_main_size, h.main_sz);
+	pg_atomic_write_u64(&gc_sstate->gcache_main_nitems, kds_temp->nitems);
+	pg_atomic_write_u64(&gc_sstate->gcache_extra_size, h.extra_length);
+	pg_atomic_write_u64(&gc_sstate->gcache_extra_usage, h.extra_usage);
+
+	/* the snapshot on the disk is still valid */
+	pthreadMutexLock(&gc_sstate->redo_mutex);
+	if (gc_sstate->snapshot_valid == UINT_MAX)
+		gc_sstate->snapshot_valid = ++gc_sstate->snapshot_generation;
+	pthreadMutexUnlock(&gc_sstate->redo_mutex);
+
+	/* load the device buffers of all the replicas */
+	PG_TRY();
+	{
+		for (int r=0; r < gc_options->num_replicas; r++)
+		{
+			__gpuCacheInvokeBackgroundCommand(&gc_desc->ident,
+											  gpuCacheReplicaDevice(gc_options, r),
+											  false,
+											  GCACHE_CONTROL_CMD__APPLY_REDO,
+											  0);
+		}
+	}
+	PG_FINALLY();
+	{
+		pg_atomic_write_u32(&gc_sstate->snapshot_restore, 0);
+		unlink(rpath);
+	}
+	PG_END_TRY();
+	elog(LOG, "gpucache: table '%s' was restored from the snapshot (nitems=%u)",
+		 gc_sstate->table_name, kds_temp->nitems);
+	return true;
+
+skip:
+	unlink(rpath);
+	return false;
+}
+
+/*
+ * __gpuCacheAppendLogs
+ *
+ * It appends 'nitems' REDO logs of 'length' bytes in total to the shared
+ * REDO log buffer at once.
+ */
+static void
+__gpuCacheAppendLogs(GpuCacheDesc *gc_desc,
+					 const char *logs, size_t length, uint32_t nitems)
+{
+	GpuCacheSharedState *gc_sstate = gc_desc->gc_lmap->gc_sstate;
+	char	   *redo_buffer = gpuCacheRedoLogBuffer(gc_sstate);
+	size_t		buffer_sz = gc_sstate->gc_options.redo_buffer_size;
+	bool		wal_logging = gpuCacheWalLoggingEnabled();
+	bool		append_done = false;
+
+	Assert(length == MAXALIGN(length) && length <= buffer_sz);
+	while (!append_done)
+	{
+		size_t		usage;
+		uint32_t	phase;
+		uint64_t	sync_pos = 0;
+
+		/*
+		 * Once GPU buffer is marked to 'corrupted', any following REDO-logs
+		 * make no sense, until pgstrom.gpucache_recovery() is called.
+		 */
+		phase = pg_atomic_read_u32(&gc_sstate->phase);
+		if (phase == GCACHE_PHASE__IS_CORRUPTED)
+			return;
+		Assert(phase == GCACHE_PHASE__IS_LOADING ||
+			   phase == GCACHE_PHASE__IS_READY);
+
+		/*
+		 * WAL records are written in the order of the REDO log buffer, under
+		 * the wal_lock. Unlike the redo_mutex, the LWLock is released on
+		 * ERROR, and the GPU service never waits for the WAL insertion.
+		 */
+		if (wal_logging)
+			LWLockAcquire(&gc_sstate->wal_lock, LW_EXCLUSIVE);
+		pthreadMutexLock(&gc_sstate->redo_mutex);
+		/* on-disk snapshot must be removed prior to the modification */
+		if (gc_sstate->snapshot_valid != 0)
+		{
+			uint32_t	generation = gc_sstate->snapshot_valid;
+
+			pthreadMutexUnlock(&gc_sstate->redo_mutex);
+			if (wal_logging)
+				LWLockRelease(&gc_sstate->wal_lock);
+			__gpuCacheRemoveSnapshot(&gc_sstate->ident);
+			pthreadMutexLock(&gc_sstate->redo_mutex);
+			if (gc_sstate->snapshot_valid == generation)
+				gc_sstate->snapshot_valid = 0;
+			pthreadMutexUnlock(&gc_sstate->redo_mutex);
+			continue;
+		}
 		Assert(gc_sstate->redo_write_pos >= gc_sstate->redo_read_pos &&
 			   gc_sstate->redo_write_pos <= gc_sstate->redo_read_pos + buffer_sz &&
 			   gc_sstate->redo_sync_pos <= gc_sstate->redo_write_pos);
 		usage = gc_sstate->redo_write_pos - gc_sstate->redo_read_pos;
 
 		/* buffer has enough space? */
-		if (usage + tx_log->length <= buffer_sz)
+		if (usage + length <= buffer_sz)
 		{
-			const char *pos = (const char *)tx_log;
-			size_t		remain = tx_log->length;
+			const char *pos = logs;
+			size_t		remain = length;
 			size_t		offset;
 			size_t		nbytes;
 
@@ -2370,7 +4252,7 @@ __gpuCacheAppendLog(GpuCacheDesc *gc_desc, GCacheTxLogCommon *tx_log)
 				pos += nbytes;
 				remain -= nbytes;
 			}
-			gc_sstate->redo_write_nitems++;
+			gc_sstate->redo_write_nitems += nitems;
 			gc_sstate->redo_write_timestamp = GetCurrentTimestamp();
 			append_done = true;
 		}
@@ -2380,21 +4262,96 @@ __gpuCacheAppendLog(GpuCacheDesc *gc_desc, GCacheTxLogCommon *tx_log)
 		 */
 		if (gc_sstate->redo_write_pos >= (gc_sstate->redo_sync_pos +
 										  gc_sstate->gc_options.gpu_sync_threshold))
-		{
 			sync_pos = gc_sstate->redo_sync_pos = gc_sstate->redo_write_pos;
-			pthreadMutexUnlock(&gc_sstate->redo_mutex);
-			gpuCacheInvokeApplyRedo(gc_desc, sync_pos, append_done);
-		}
-		else
+		pthreadMutexUnlock(&gc_sstate->redo_mutex);
+
+		if (wal_logging)
 		{
-			pthreadMutexUnlock(&gc_sstate->redo_mutex);
+			if (append_done)
+			{
+				xl_gpucache_redo xlrec;
+
+				memcpy(&xlrec.ident, &gc_sstate->ident, sizeof(GpuCacheIdent));
+				xlrec.nitems = nitems;
+				XLogBeginInsert();
+				XLogRegisterData((char *)&xlrec, sizeof(xl_gpucache_redo));
+				XLogRegisterData((char *)logs, length);
+				XLogInsert(GPUCACHE_RMGR_ID, XLOG_GPUCACHE_REDO);
+			}
+			LWLockRelease(&gc_sstate->wal_lock);
 		}
+		if (sync_pos != 0)
+			gpuCacheInvokeApplyRedo(gc_desc, sync_pos, append_done);
 
 		if (!append_done)
 			pg_usleep(2000L);	/* 2ms */
 	}
 }
 
+/*
+ * __gpuCacheAppendLog
+ */
+static void
+__gpuCacheAppendLog(GpuCacheDesc *gc_desc, GCacheTxLogCommon *tx_log)
+{
+	__gpuCacheAppendLogs(gc_desc, (const char *)tx_log, tx_log->length, 1);
+}
+
+/*
+ * __gpuCacheBatchLog
+ *
+ * It keeps the REDO log in the local buffer, then appends a batch of logs
+ * to the shared REDO log buffer at once. Bulk INSERT / COPY FROM fires the
+ * sync trigger for each row, and the initial loading writes a log for each
+ * tuple, so the redo_mutex per log was the bottleneck of the ingestion.
+ * Logs must be appended in order, so the pending logs of another
+ * GpuCacheDesc (e.g, sub-transaction) are flushed first.
+ */
+#define GPUCACHE_LOG_BATCH_SIZE		(256UL << 10)	/* 256kB */
+
+static void
+__gpuCacheBatchLog(GpuCacheDesc *gc_desc, GCacheTxLogCommon *tx_log)
+{
+	size_t		batch_sz = Min(GPUCACHE_LOG_BATCH_SIZE,
+							   gc_desc->gc_options.redo_buffer_size / 4);
+
+	Assert(tx_log->length == MAXALIGN(tx_log->length));
+	if (gcache_pending_desc != gc_desc ||
+		gc_desc->logbuf.len + tx_log->length > batch_sz)
+		__gpuCacheFlushLogs();
+	if (tx_log->length > batch_sz)
+	{
+		__gpuCacheAppendLog(gc_desc, tx_log);
+		return;
+	}
+	if (!gc_desc->logbuf.data)
+		initStringInfoCxt(CacheMemoryContext, &gc_desc->logbuf);
+	appendBinaryStringInfo(&gc_desc->logbuf, (char *)tx_log, tx_log->length);
+	gc_desc->log_nitems++;
+	gcache_pending_desc = gc_desc;
+}
+
+/*
+ * __gpuCacheFlushLogs
+ */
+static void
+__gpuCacheFlushLogs(void)
+{
+	GpuCacheDesc *gc_desc = gcache_pending_desc;
+
+	if (gc_desc)
+	{
+		if (gc_desc->log_nitems > 0)
+			__gpuCacheAppendLogs(gc_desc,
+								 gc_desc->logbuf.data,
+								 gc_desc->logbuf.len,
+								 gc_desc->log_nitems);
+		resetStringInfo(&gc_desc->logbuf);
+		gc_desc->log_nitems = 0;
+		gcache_pending_desc = NULL;
+	}
+}
+
 /*
  * __gpuCacheInsertLog
  */
@@ -2433,7 +4390,7 @@ __gpuCacheInsertLog(HeapTuple tuple, GpuCacheDesc *gc_desc)
 		HeapTupleHeaderSetXmax(&item->htup, InvalidTransactionId);
 		HeapTupleHeaderSetCmin(&item->htup, InvalidCommandId);
 
-		__gpuCacheAppendLog(gc_desc, (GCacheTxLogCommon *)item);
+		__gpuCacheBatchLog(gc_desc, (GCacheTxLogCommon *)item);
 	}
 	PG_CATCH();
 	{
@@ -2474,7 +4431,7 @@ __gpuCacheDeleteLog(HeapTuple tuple, GpuCacheDesc *gc_desc)
 	item.rowid = rowid;
 	memcpy(&item.ctid, &tuple->t_self, sizeof(ItemPointerData));
 
-	__gpuCacheAppendLog(gc_desc, (GCacheTxLogCommon *)&item);
+	__gpuCacheBatchLog(gc_desc, (GCacheTxLogCommon *)&item);
 }
 
 /*
@@ -2528,8 +4485,12 @@ pgstrom_gpucache_sync_trigger(PG_FUNCTION_ARGS)
 
 		gc_desc = lookupGpuCacheDesc(trigdata->tg_relation);
 		if (!gc_desc)
+		{
+			if (gpuCacheTableIsEvicted(trigdata->tg_relation))
+				goto bailout;
 			elog(ERROR, "gpucache is not configured for %s",
 				 RelationGetRelationName(trigdata->tg_relation));
+		}
 		if (!initialLoadGpuCache(gc_desc, trigdata->tg_relation))
 			goto bailout;
 		if (gc_desc->buf.data == NULL)
@@ -2537,7 +4498,8 @@ pgstrom_gpucache_sync_trigger(PG_FUNCTION_ARGS)
 
 		if (TRIGGER_FIRED_BY_INSERT(trigdata->tg_event))
 		{
-			tuple = __makeFlattenHeapTuple(trigdata->tg_relation,
+			tuple = __makeGpuCacheLogTuple(gc_desc,
+										   trigdata->tg_relation,
 										   trigdata->tg_trigtuple);
 			__gpuCacheInsertLog(tuple, gc_desc);
 			if (tuple != trigdata->tg_trigtuple)
@@ -2545,7 +4507,8 @@ pgstrom_gpucache_sync_trigger(PG_FUNCTION_ARGS)
 		}
 		else if (TRIGGER_FIRED_BY_UPDATE(trigdata->tg_event))
 		{
-			tuple = __makeFlattenHeapTuple(trigdata->tg_relation,
+			tuple = __makeGpuCacheLogTuple(gc_desc,
+										   trigdata->tg_relation,
 										   trigdata->tg_newtuple);
 
 			__gpuCacheDeleteLog(trigdata->tg_trigtuple, gc_desc);
@@ -2590,6 +4553,7 @@ pgstrom_gpucache_apply_redo(PG_FUNCTION_ARGS)
 		GpuCacheSharedState *gc_sstate = gc_desc->gc_lmap->gc_sstate;
 		uint64_t	sync_pos;
 
+		__gpuCacheFlushLogs();
 		pthreadMutexLock(&gc_sstate->redo_mutex);
 		sync_pos = gc_sstate->redo_sync_pos = gc_sstate->redo_write_pos;
 		pthreadMutexUnlock(&gc_sstate->redo_mutex);
@@ -2669,6 +4633,151 @@ pgstrom_gpucache_recovery(PG_FUNCTION_ARGS)
 	PG_RETURN_VOID();
 }
 
+/*
+ * pgstrom_gpucache_summary
+ *
+ * It returns the group states of the GpuCache summary, after the pending
+ * REDO-log is applied. It reflects all the committed rows at that time,
+ * regardless of the snapshot of the caller. The key is returned in int64
+ * form, and sum of the 'summary_value' columns is numeric.
+ */
+typedef struct
+{
+	kern_gpucache_summary *gsum;
+	uint32_t	index;
+} GpuCacheSummaryCursor;
+
+PG_FUNCTION_INFO_V1(pgstrom_gpucache_summary);
+PUBLIC_FUNCTION(Datum)
+pgstrom_gpucache_summary(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *fncxt;
+	GpuCacheSummaryCursor *cursor;
+	kern_gpucache_summary *gsum;
+	kern_gpucache_summary_slot *slot = NULL;
+	Datum		values[4];
+	bool		isnull[4];
+	Datum	   *elems;
+	bool	   *enulls;
+	int			lbound = 1;
+	HeapTuple	tuple;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		Oid			table_oid = PG_GETARG_OID(0);
+		Relation	rel;
+		GpuCacheDesc *gc_desc;
+		GpuCacheSharedState *gc_sstate;
+		TupleDesc	tupdesc;
+		MemoryContext oldcxt;
+		uint64_t	sync_pos;
+
+		fncxt = SRF_FIRSTCALL_INIT();
+		oldcxt = MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
+		tupdesc = CreateTemplateTupleDesc(4);
+		TupleDescInitEntry(tupdesc, 1, "key",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 2, "nitems",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 3, "nvalids",
+						   INT8ARRAYOID, -1, 0);
+		TupleDescInitEntry(tupdesc, 4, "sums",
+						   NUMERICARRAYOID, -1, 0);
+		fncxt->tuple_desc = BlessTupleDesc(tupdesc);
+
+		rel = table_open(table_oid, RowExclusiveLock);
+		gc_desc = lookupGpuCacheDesc(rel);
+		if (!gc_desc || gc_desc->gc_options.summary_key_attnum == 0)
+			elog(ERROR, "gpucache: table '%s' has no summary - check 'summary_key' option of the sync trigger",
+				 RelationGetRelationName(rel));
+		if (!initialLoadGpuCache(gc_desc, rel))
+			elog(ERROR, "gpucache: table '%s' is not loaded",
+				 RelationGetRelationName(rel));
+		gc_sstate = gc_desc->gc_lmap->gc_sstate;
+
+		__gpuCacheFlushLogs();
+		pthreadMutexLock(&gc_sstate->redo_mutex);
+		sync_pos = gc_sstate->redo_sync_pos = gc_sstate->redo_write_pos;
+		pthreadMutexUnlock(&gc_sstate->redo_mutex);
+		gpuCacheInvokeApplyRedo(gc_desc, sync_pos, false);
+
+		gsum = palloc(gpuCacheSummaryLength(&gc_sstate->gc_options));
+		pthreadMutexLock(&gc_sstate->summary_mutex);
+		memcpy(gsum, gpuCacheSummaryBuffer(gc_sstate),
+			   gpuCacheSummaryLength(&gc_sstate->gc_options));
+		pthreadMutexUnlock(&gc_sstate->summary_mutex);
+		table_close(rel, RowExclusiveLock);
+
+		cursor = palloc0(sizeof(GpuCacheSummaryCursor));
+		cursor->gsum = gsum;
+		fncxt->user_fctx = cursor;
+
+		MemoryContextSwitchTo(oldcxt);
+	}
+	fncxt = SRF_PERCALL_SETUP();
+	cursor = (GpuCacheSummaryCursor *)fncxt->user_fctx;
+	gsum = cursor->gsum;
+	while (cursor->index < gsum->nslots)
+	{
+		slot = GPUCACHE_SUMMARY_SLOT(gsum, cursor->index++);
+		if (slot->state == GPUCACHE_SUMMARY_SLOT__VALID && slot->nitems > 0)
+			break;
+		slot = NULL;
+	}
+	if (!slot)
+		SRF_RETURN_DONE(fncxt);
+
+	memset(isnull, 0, sizeof(isnull));
+	if (slot->key_isnull)
+		isnull[0] = true;
+	else
+		values[0] = Int64GetDatum(slot->key);
+	values[1] = Int64GetDatum(slot->nitems);
+	if (gsum->nvalues == 0)
+	{
+		isnull[2] = true;
+		isnull[3] = true;
+	}
+	else
+	{
+		int			nvalues = gsum->nvalues;
+
+		elems  = alloca(sizeof(Datum) * nvalues);
+		enulls = alloca(sizeof(bool) * nvalues);
+		for (int k=0; k < nvalues; k++)
+		{
+			elems[k] = Int64GetDatum(slot->values[k].nvalids);
+			enulls[k] = false;
+		}
+		values[2] = PointerGetDatum(construct_array(elems, nvalues,
+													INT8OID, sizeof(int64),
+													FLOAT8PASSBYVAL,
+													TYPALIGN_DOUBLE));
+		for (int k=0; k < nvalues; k++)
+		{
+			if (slot->values[k].nvalids == 0)
+			{
+				elems[k] = 0;
+				enulls[k] = true;	/* sum() of no rows is NULL */
+			}
+			else if (gsum->value_kinds[k] == 'i')
+				elems[k] = DirectFunctionCall1(int8_numeric,
+											   Int64GetDatum(slot->values[k].sum.ival));
+			else
+				elems[k] = DirectFunctionCall1(float8_numeric,
+											   Float8GetDatum(slot->values[k].sum.fval));
+		}
+		values[3] = PointerGetDatum(construct_md_array(elems, enulls,
+													   1, &nvalues, &lbound,
+													   NUMERICOID, -1,
+													   false,
+													   TYPALIGN_INT));
+	}
+	tuple = heap_form_tuple(fncxt->tuple_desc, values, isnull);
+
+	SRF_RETURN_NEXT(fncxt, HeapTupleGetDatum(tuple));
+}
+
 /* ------------------------------------------------------------
  *
  * Routines to support executor
@@ -2684,12 +4793,6 @@ pgstromGpuCacheExecInit(pgstromTaskState *pts)
 
 	if (!rel)
 		return NULL;
-	/* GpuCache is not workable on hot-standby server */
-	if (RecoveryInProgress())
-	{
-		elog(DEBUG2, "gpucache: not valid in hot-standby slave server");
-		return NULL;
-	}
 	/* only READ COMMITTED transaction can use GpuCache */
 	if (XactIsoLevel > XACT_READ_COMMITTED)
 	{
@@ -2707,9 +4810,40 @@ pgstromGpuCacheExecInit(pgstromTaskState *pts)
 			 RelationGetRelationName(rel));
 		return NULL;
 	}
+	/* GpuCache on hot-standby server is built by the WAL replay, if any */
+	if (RecoveryInProgress())
+		return lookupGpuCacheDescOnStandby(rel, signature, &gc_options);
+	/* REDO logs by this backend must be visible to the scan */
+	__gpuCacheFlushLogs();
 	return lookupGpuCacheDesc(rel);
 }
 
+/*
+ * __gpuCacheCountColumnScans
+ */
+static void
+__gpuCacheCountColumnScans(GpuCacheSharedState *gc_sstate,
+						   const Bitmapset *outer_refs)
+{
+	int		nattrs = gc_sstate->kds_head.ncols - gc_sstate->gc_options.num_vcols;
+	int		k = -1;
+
+	/* whole-row reference */
+	if (bms_is_member(-FirstLowInvalidHeapAttributeNumber, outer_refs))
+	{
+		for (int j=0; j < nattrs; j++)
+			pg_atomic_fetch_add_u32(&gc_sstate->column_nscans[j], 1);
+		return;
+	}
+	while ((k = bms_next_member(outer_refs, k)) >= 0)
+	{
+		int		j = k + FirstLowInvalidHeapAttributeNumber - 1;
+
+		if (j >= 0 && j < nattrs)
+			pg_atomic_fetch_add_u32(&gc_sstate->column_nscans[j], 1);
+	}
+}
+
 XpuCommand *
 pgstromScanChunkGpuCache(pgstromTaskState *pts,
 						 struct iovec *xcmd_iov,
@@ -2741,6 +4875,9 @@ pgstromScanChunkGpuCache(pgstromTaskState *pts,
 			pts->scan_done = true;
 			return NULL;
 		}
+		/* access statistics for the tiered mode */
+		if (gc_sstate->gc_options.tiered)
+			__gpuCacheCountColumnScans(gc_sstate, pts->pp_info->outer_refs);
 		/* force to apply pending REDO logs, if any */
 		if (sync_pos != ULONG_MAX)
 		{
@@ -2766,6 +4903,35 @@ pgstromScanChunkGpuCache(pgstromTaskState *pts,
 	return xcmd;
 }
 
+/*
+ * GetOptimalGpuForGpuCache
+ *
+ * It returns the GPU that holds the least busy replica of the GpuCache.
+ */
+const Bitmapset *
+GetOptimalGpuForGpuCache(const GpuCacheDesc *gc_desc)
+{
+	GpuCacheSharedState *gc_sstate;
+	const GpuCacheOptions *gc_options = &gc_desc->gc_options;
+	uint32_t	nscans_min = UINT_MAX;
+	int			replica = 0;
+
+	if (!gc_desc->gc_lmap || gc_options->num_replicas <= 1)
+		return bms_make_singleton(gc_options->cuda_dindex);
+	gc_sstate = gc_desc->gc_lmap->gc_sstate;
+	for (int r=0; r < gc_options->num_replicas; r++)
+	{
+		uint32_t	nscans = pg_atomic_read_u32(&gc_sstate->replica_nscans[r]);
+
+		if (nscans < nscans_min)
+		{
+			nscans_min = nscans;
+			replica = r;
+		}
+	}
+	return bms_make_singleton(gpuCacheReplicaDevice(gc_options, replica));
+}
+
 void
 pgstromGpuCacheExecEnd(pgstromTaskState *pts)
 {
@@ -2875,6 +5041,21 @@ pgstromGpuCacheExplain(pgstromTaskState *pts,
 	{
 		ExplainPropertyText("GPU Cache", "invalid device", es);
 	}
+	/* index lookup, if any */
+	if (pts->pp_info->gpu_cache_index_key &&
+		gc_options->index_attnum == pts->pp_info->gpu_cache_index_attnum)
+	{
+		Relation	rel = pts->css.ss.ss_currentRelation;
+		char	   *key;
+
+		key = deparse_expression((Node *)pts->pp_info->gpu_cache_index_key,
+								 dcontext, false, false);
+		snprintf(temp, sizeof(temp), "%s = %s",
+				 get_attname(RelationGetRelid(rel),
+							 gc_options->index_attnum, false),
+				 key);
+		ExplainPropertyText("GPU Cache Index", temp, es);
+	}
 
 	if (es->verbose)
 	{
@@ -2889,67 +5070,408 @@ pgstromGpuCacheExplain(pgstromTaskState *pts,
 				 "max_num_rows=%ld,"
 				 "redo_buffer_size=%zu,"
 				 "gpu_sync_interval=%d,"
-				 "gpu_sync_threshold=%zu",
+				 "gpu_sync_threshold=%zu,"
+				 "gpu_replicas=%d,"
+				 "compression=%s",
 				 gpu_device_id,
 				 gc_options->max_num_rows,
 				 gc_options->redo_buffer_size,
 				 gc_options->gpu_sync_interval,
-				 gc_options->gpu_sync_threshold);
+				 gc_options->gpu_sync_threshold,
+				 gc_options->num_replicas,
+				 gc_options->compression ? "on" : "off");
 		ExplainPropertyText("GPU Cache Options", temp, es);
 	}
 }
 
 /* ------------------------------------------------------------
  *
- * Routines to support DDL callbacks
+ * Routines to resize GpuCache online
  *
  * ------------------------------------------------------------
  */
 
 /*
- * gpuCacheObjectAccess
- *
- * This callback marks drop_on_commit / drop_on_rollback for the pending
- * GpuCache entries on DDL commands.
+ * __gpuCacheDropPreviousCache
  */
 static void
-__gpuCacheCallbackOnAlterTable(Oid table_oid)
+__gpuCacheDropPreviousCache(const GpuCacheIdent *ident, int cuda_dindex)
 {
-	Datum		signature_old;
-	Datum		signature_new;
-	GpuCacheOptions options_old;
-	GpuCacheOptions options_new;
-	GpuCacheDesc *gc_desc;
+	char		namebuf[MAXPGPATH];
 
-	signature_old = gpuCacheTableSignatureSnapshot(table_oid, NULL,
-												   &options_old);
-	signature_new = gpuCacheTableSignatureSnapshot(table_oid, SnapshotSelf,
-												   &options_new);
-#ifdef GPUCACHE_DEBUG_MESSAGE
-	elog(LOG, "__gpuCacheCallbackOnAlterTable(table_oid=%u): signature %lx -> %lx",
-		 table_oid, signature_old, signature_new);
-#endif
-	if (signature_old != 0UL &&
-		signature_old != signature_new)
-	{
-		gc_desc = lookupGpuCacheDescNoLoad(table_oid,
-										   signature_old,
-										   InvalidTransactionId,
-										   &options_old);
-		if (gc_desc)
-			gc_desc->drop_on_commit = true;
-	}
+	__gpuCacheInvokeBackgroundCommand(ident,
+									  cuda_dindex,
+									  true,
+									  GCACHE_CONTROL_CMD__DROP_UNLOAD,
+									  0);
+	GpuCacheSharedStateName(namebuf, MAXPGPATH,
+							ident->database_oid,
+							ident->table_oid,
+							ident->signature);
+	shm_unlink(namebuf);
+	__gpuCacheRemoveSnapshot(ident);
+	if (gpuCacheWalLoggingEnabled())
+		__gpuCacheXLogIdent(ident, XLOG_GPUCACHE_DROP);
+}
 
-	if (signature_new != 0UL &&
-		signature_new != signature_old)
+/*
+ * __gpuCacheLayoutIsCompatible
+ *
+ * The previous GpuCache has to store the columns in the same manner.
+ * Offset and length of the columns may be different by max_num_rows.
+ */
+static bool
+__gpuCacheLayoutIsCompatible(const kern_data_store *kds_prev,
+							 const kern_data_store *kds_head)
+{
+	if (kds_prev->format != KDS_FORMAT_COLUMN ||
+		kds_prev->ncols != kds_head->ncols ||
+		kds_prev->nr_colmeta != kds_head->nr_colmeta ||
+		kds_prev->has_varlena != kds_head->has_varlena)
+		return false;
+	for (int j=0; j < kds_head->nr_colmeta; j++)
 	{
-		gc_desc = lookupGpuCacheDescNoLoad(table_oid,
-										   signature_new,
-										   InvalidTransactionId,
-										   &options_new);
-		if (gc_desc)
-			gc_desc->drop_on_rollback = true;
+		const kern_colmeta *cmeta_prev = &kds_prev->colmeta[j];
+		const kern_colmeta *cmeta = &kds_head->colmeta[j];
+
+		if (cmeta_prev->atttypid != cmeta->atttypid ||
+			cmeta_prev->attlen != cmeta->attlen ||
+			(cmeta_prev->nullmap_offset != 0) != (cmeta->nullmap_offset != 0) ||
+			(cmeta_prev->values_offset != 0) != (cmeta->values_offset != 0) ||
+			cmeta_prev->encode_base != cmeta->encode_base ||
+			cmeta_prev->encode_width != cmeta->encode_width)
+			return false;
 	}
+	return true;
+}
+
+/*
+ * __gpuCacheCloneFromPrevious
+ *
+ * When only the sizing options are changed, the new GpuCache is built from
+ * the previous one kept at the commit, instead of the initial loading from
+ * the heap. It rebuilds the rowid-map with the same rowid for each ctid,
+ * then GpuService copies the device buffers of the previous one to the new
+ * one (device-to-device) on the allocation. The previous GpuCache is dropped
+ * regardless of the result, because nobody can reference it any more.
+ */
+static bool
+__gpuCacheCloneFromPrevious(GpuCacheDesc *gc_desc)
+{
+	GpuCacheSharedState *gc_sstate = gc_desc->gc_lmap->gc_sstate;
+	GpuCacheOptions *gc_options = &gc_sstate->gc_options;
+	GpuCacheLocalMapping *prev_lmap;
+	GpuCacheSharedState *prev_sstate;
+	GpuCacheOptions *prev_options;
+	GpuCacheIdent prev_ident;
+	uint32_t   *hslot;
+	uint32_t   *prev_hslot;
+	GpuCacheRowIdItem *rowitems;
+	GpuCacheRowIdItem *prev_rowitems;
+	uint32_t	nvalids = 0;
+	bool		is_fresh;
+	bool		is_valid = false;
+
+	if (!__gpuCacheFetchResizing(&gc_sstate->ident, &prev_ident))
+		return false;
+	prev_lmap = getGpuCacheLocalMappingIfExist(prev_ident.database_oid,
+											   prev_ident.table_oid,
+											   prev_ident.signature,
+											   true);
+	if (!prev_lmap)
+		return false;
+	PG_TRY();
+	{
+		prev_sstate = prev_lmap->gc_sstate;
+		prev_options = &prev_sstate->gc_options;
+		if (pg_atomic_read_u32(&prev_sstate->phase) != GCACHE_PHASE__IS_READY ||
+			prev_options->layout_signature != gc_options->layout_signature ||
+			!__gpuCacheLayoutIsCompatible(&prev_sstate->kds_head,
+										  &gc_sstate->kds_head))
+			goto skip;
+
+		/* apply the pending REDO-log of the previous one */
+		for (int r=0; r < prev_options->num_replicas; r++)
+		{
+			__gpuCacheInvokeBackgroundCommand(&prev_ident,
+											  gpuCacheReplicaDevice(prev_options, r),
+											  false,
+											  GCACHE_CONTROL_CMD__APPLY_REDO,
+											  0);
+		}
+		if (pg_atomic_read_u32(&prev_sstate->phase) != GCACHE_PHASE__IS_READY ||
+			pg_atomic_read_u64(&prev_sstate->gcache_extra_usage) > gc_sstate->kds_extra_sz)
+			goto skip;
+
+		/*
+		 * Rebuild the rowid-map, only if nobody touched the GpuCache yet.
+		 * rowid of the live rows must be less than the new max_num_rows.
+		 */
+		pthreadMutexLock(&gc_sstate->rowid_mutex);
+		pthreadMutexLock(&gc_sstate->redo_mutex);
+		is_fresh = (gc_sstate->redo_write_pos == 0 &&
+					gc_sstate->rowid_num_free == gc_options->max_num_rows);
+		pthreadMutexUnlock(&gc_sstate->redo_mutex);
+		if (!is_fresh)
+		{
+			pthreadMutexUnlock(&gc_sstate->rowid_mutex);
+			goto skip;
+		}
+		hslot = gpuCacheRowIdHashSlot(gc_sstate);
+		rowitems = gpuCacheRowIdItemArray(gc_sstate);
+		prev_hslot = gpuCacheRowIdHashSlot(prev_sstate);
+		prev_rowitems = gpuCacheRowIdItemArray(prev_sstate);
+
+		for (uint32_t i=0; i < gc_options->max_num_rows; i++)
+			ItemPointerSetInvalid(&rowitems[i].ctid);
+		pthreadMutexLock(&prev_sstate->rowid_mutex);
+		is_valid = true;
+		for (uint32_t i=0; is_valid && i < prev_options->rowid_hash_nslots; i++)
+		{
+			for (uint32_t rowid = prev_hslot[i];
+				 rowid < prev_options->max_num_rows;
+				 rowid = prev_rowitems[rowid].next)
+			{
+				ItemPointer	ctid = &prev_rowitems[rowid].ctid;
+				uint32_t	hindex;
+
+				if (rowid >= gc_options->max_num_rows)
+				{
+					is_valid = false;
+					break;
+				}
+				hindex = hash_bytes((unsigned char *)ctid,
+									sizeof(ItemPointerData))
+					% gc_options->rowid_hash_nslots;
+				ItemPointerCopy(ctid, &rowitems[rowid].ctid);
+				rowitems[rowid].next = hslot[hindex];
+				hslot[hindex] = rowid;
+				nvalids++;
+			}
+		}
+		pthreadMutexUnlock(&prev_sstate->rowid_mutex);
+		if (is_valid)
+		{
+			/* rebuild the free-list, from the smaller rowid */
+			gc_sstate->rowid_next_free = UINT_MAX;
+			gc_sstate->rowid_num_free = 0;
+			for (uint32_t rowid = gc_options->max_num_rows; rowid > 0; rowid--)
+			{
+				GpuCacheRowIdItem *ritem = &rowitems[rowid-1];
+
+				if (ItemPointerIsValid(&ritem->ctid))
+					continue;
+				ritem->next = gc_sstate->rowid_next_free;
+				gc_sstate->rowid_next_free = rowid-1;
+				gc_sstate->rowid_num_free++;
+			}
+			Assert(gc_sstate->rowid_num_free + nvalids == gc_options->max_num_rows);
+		}
+		else
+		{
+			/* revert the rowid-map */
+			for (uint32_t i=0; i < gc_options->rowid_hash_nslots; i++)
+				hslot[i] = UINT_MAX;
+			for (uint32_t i=0; i < gc_options->max_num_rows; i++)
+			{
+				ItemPointerSetInvalid(&rowitems[i].ctid);
+				rowitems[i].next = (i+1 < gc_options->max_num_rows ? i+1 : UINT_MAX);
+			}
+			gc_sstate->rowid_next_free = 0;
+			gc_sstate->rowid_num_free = gc_options->max_num_rows;
+		}
+		gc_sstate->rowid_map_version++;
+		pthreadMutexUnlock(&gc_sstate->rowid_mutex);
+		if (!is_valid)
+			goto skip;
+
+		/* statistics of the tiered mode are also inherited */
+		for (int j=0; j < MaxTupleAttributeNumber; j++)
+			pg_atomic_write_u32(&gc_sstate->column_nscans[j],
+								pg_atomic_read_u32(&prev_sstate->column_nscans[j]));
+
+		/* clone the device buffers of all the replicas */
+		pg_atomic_write_u64(&gc_sstate->clone_signature, prev_ident.signature);
+		PG_TRY();
+		{
+			for (int r=0; r < gc_options->num_replicas; r++)
+			{
+				__gpuCacheInvokeBackgroundCommand(&gc_desc->ident,
+												  gpuCacheReplicaDevice(gc_options, r),
+												  false,
+												  GCACHE_CONTROL_CMD__APPLY_REDO,
+												  0);
+			}
+		}
+		PG_FINALLY();
+		{
+			pg_atomic_write_u64(&gc_sstate->clone_signature, 0);
+		}
+		PG_END_TRY();
+		elog(LOG, "gpucache: table '%s' was resized online (nitems=%u, max_num_rows=%ld)",
+			 gc_sstate->table_name, nvalids, gc_options->max_num_rows);
+	skip:
+		;
+	}
+	PG_FINALLY();
+	{
+		putGpuCacheLocalMapping(prev_lmap);
+		__gpuCacheDropPreviousCache(&prev_ident, gc_options->cuda_dindex);
+	}
+	PG_END_TRY();
+
+	return is_valid;
+}
+
+/* ------------------------------------------------------------
+ *
+ * Routines to support DDL callbacks
+ *
+ * ------------------------------------------------------------
+ */
+
+/*
+ * __gpuCacheResolveResizing
+ *
+ * It re-targets the pending online resizing in the current transaction to
+ * the latest signature of the table, or drops the previous GpuCache if its
+ * layout is no longer compatible (or the table has no GpuCache any more).
+ */
+static void
+__gpuCacheResolveResizing(Oid table_oid,
+						  uint64_t signature,
+						  const GpuCacheOptions *gc_options)
+{
+	TransactionId	curr_xid = GetCurrentTransactionIdIfAny();
+	HASH_SEQ_STATUS	hseq;
+	GpuCacheDesc   *gc_desc;
+
+	if (hash_get_num_entries(gcache_descriptors_htab) == 0)
+		return;
+	hash_seq_init(&hseq, gcache_descriptors_htab);
+	while ((gc_desc = hash_seq_search(&hseq)) != NULL)
+	{
+		if (gc_desc->xid != curr_xid ||
+			gc_desc->ident.database_oid != MyDatabaseId ||
+			gc_desc->ident.table_oid != table_oid ||
+			gc_desc->resize_signature == 0 ||
+			gc_desc->resize_signature == signature)
+			continue;
+		if (signature != 0UL &&
+			gc_desc->ident.signature != signature &&
+			gc_desc->gc_options.layout_signature == gc_options->layout_signature)
+		{
+			gc_desc->resize_signature = signature;
+		}
+		else
+		{
+			gc_desc->drop_on_commit = (gc_desc->ident.signature != signature);
+			gc_desc->resize_signature = 0;
+		}
+	}
+}
+
+/*
+ * gpuCacheObjectAccess
+ *
+ * This callback marks drop_on_commit / drop_on_rollback for the pending
+ * GpuCache entries on DDL commands. If only sizing options are changed,
+ * the previous GpuCache is kept to clone the new one without reloading.
+ */
+static void
+__gpuCacheCallbackOnAlterTable(Oid table_oid)
+{
+	Datum		signature_old;
+	Datum		signature_new;
+	GpuCacheOptions options_old;
+	GpuCacheOptions options_new;
+	GpuCacheDesc *gc_desc;
+
+	signature_old = gpuCacheTableSignatureSnapshot(table_oid, NULL,
+												   &options_old);
+	signature_new = gpuCacheTableSignatureSnapshot(table_oid, SnapshotSelf,
+												   &options_new);
+#ifdef GPUCACHE_DEBUG_MESSAGE
+	elog(LOG, "__gpuCacheCallbackOnAlterTable(table_oid=%u): signature %lx -> %lx",
+		 table_oid, signature_old, signature_new);
+#endif
+	if (signature_old != 0UL &&
+		signature_old != signature_new)
+	{
+		gc_desc = lookupGpuCacheDescNoLoad(table_oid,
+										   signature_old,
+										   InvalidTransactionId,
+										   &options_old);
+		if (gc_desc)
+		{
+			if (signature_new != 0UL &&
+				gc_desc->gc_lmap != NULL &&
+				!gc_desc->drop_on_commit &&
+				options_old.layout_signature == options_new.layout_signature)
+			{
+				/* only sizing options are changed, so resize it online */
+				gc_desc->resize_signature = signature_new;
+			}
+			else
+			{
+				gc_desc->drop_on_commit = true;
+				gc_desc->resize_signature = 0;
+			}
+		}
+	}
+
+	if (signature_new != 0UL &&
+		signature_new != signature_old)
+	{
+		gc_desc = lookupGpuCacheDescNoLoad(table_oid,
+										   signature_new,
+										   InvalidTransactionId,
+										   &options_new);
+		if (gc_desc)
+			gc_desc->drop_on_rollback = true;
+	}
+	__gpuCacheResolveResizing(table_oid, signature_new, &options_new);
+}
+
+/*
+ * __gpuCacheEvictOldPartitions
+ *
+ * It drops the GpuCache of the partitions being out of 'recent_partitions'
+ * on the commit, to release the device memory.
+ */
+static void
+__gpuCacheEvictOldPartitions(Oid parent_oid)
+{
+	Relation	prel;
+	PartitionDesc pdesc;
+
+	prel = table_open(parent_oid, AccessShareLock);
+	pdesc = RelationGetPartitionDesc(prel, true);
+	for (int i=0; i < pdesc->nparts; i++)
+	{
+		Oid			table_oid = pdesc->oids[i];
+		uint64_t	signature;
+		GpuCacheOptions gc_options;
+		GpuCacheDesc *gc_desc;
+
+		signature = gpuCacheTableSignatureSnapshot(table_oid, NULL,
+												   &gc_options);
+		if (signature == 0UL ||
+			gc_options.recent_partitions == 0 ||
+			__gpuCachePartitionIsRecent(parent_oid, table_oid,
+										gc_options.recent_partitions))
+			continue;
+		/* force to assign a valid transaction-id */
+		(void)GetCurrentTransactionId();
+
+		gc_desc = lookupGpuCacheDescNoLoad(table_oid,
+										   signature,
+										   InvalidTransactionId,
+										   &gc_options);
+		if (gc_desc)
+			gc_desc->drop_on_commit = true;
+	}
+	table_close(prel, AccessShareLock);
 }
 
 /*
@@ -2987,6 +5509,17 @@ __gpuCacheCallbackOnAlterTrigger(Oid trigger_oid, bool validate_options)
 		if (!isnull)
 			trigger_config = TextDatumGetCString(datum);
 
+		/*
+		 * ENABLE REPLICA trigger is skipped by the local writes, so GPU Cache
+		 * would silently go stale. It is not a sync trigger of GPU Cache.
+		 */
+		if (pg_trig->tgfoid == gpucache_sync_trigger_function_oid() &&
+			pg_trig->tgenabled == TRIGGER_FIRES_ON_REPLICA)
+			ereport(WARNING,
+					(errmsg("gpucache: trigger \"%s\" on \"%s\" is ENABLE REPLICA, GPU Cache is disabled on this table",
+							trigger_name, RelationGetRelationName(__rel)),
+					 errhint("Use ALTER TABLE ... ENABLE ALWAYS TRIGGER to keep GPU Cache on the subscriber of logical replication.")));
+
 		gpuCacheTableSignatureCommon(ERROR,
 									 RelationGetForm(__rel),
 									 RelationGetDescr(__rel)->attrs,
@@ -3017,6 +5550,10 @@ __gpuCacheCallbackOnAlterTrigger(Oid trigger_oid, bool validate_options)
 		table_close(__rel, NoLock);
 
 		__gpuCacheCallbackOnAlterTable(pg_trig->tgrelid);
+		/* CREATE/ATTACH PARTITION clones the trigger of the parent */
+		if (OidIsValid(pg_trig->tgparentid))
+			__gpuCacheEvictOldPartitions(get_partition_parent(pg_trig->tgrelid,
+															  true));
 	}
 	systable_endscan(sscan);
 	table_close(srel, AccessShareLock);
@@ -3040,6 +5577,7 @@ __gpuCacheOnDropRelation(Oid table_oid)
 		if (gc_desc)
 			gc_desc->drop_on_commit = true;
 	}
+	__gpuCacheResolveResizing(table_oid, 0UL, NULL);
 }
 
 static void
@@ -3078,7 +5616,10 @@ __gpuCacheOnDropTrigger(Oid trigger_oid)
 		if (gc_desc)
 		{
 			if (gc_options.tg_sync_row == trigger_oid)
+			{
 				gc_desc->drop_on_commit = true;
+				__gpuCacheResolveResizing(table_oid, 0UL, NULL);
+			}
 		}
 	}
 	systable_endscan(sscan);
@@ -3216,61 +5757,795 @@ gpuCacheXactCallback(XactEvent event, void *arg)
 	}
 }
 
-/*
- * gpuCacheSubXactCallback 
- */
+/*
+ * gpuCacheSubXactCallback 
+ */
+static void
+gpuCacheSubXactCallback(SubXactEvent event,
+						SubTransactionId mySubid,
+						SubTransactionId parentSubid, void *arg)
+{
+#ifdef GPUCACHE_DEBUG_MESSAGE
+	elog(INFO, "SubXactCallback: ev=%s xid=%u top-xid=%u",
+		 event == SUBXACT_EVENT_START_SUB ? "SUBXACT_EVENT_START_SUB" :
+		 event == SUBXACT_EVENT_COMMIT_SUB ? "SUBXACT_EVENT_COMMIT_SUB" :
+		 event == SUBXACT_EVENT_ABORT_SUB ? "SUBXACT_EVENT_ABORT_SUB" :
+		 event == SUBXACT_EVENT_PRE_COMMIT_SUB ? "SUBXACT_EVENT_PRE_COMMIT_SUB" : "???",
+		 GetCurrentTransactionIdIfAny(),
+		 GetTopTransactionIdIfAny());
+#endif
+	if (hash_get_num_entries(gcache_descriptors_htab) > 0 &&
+		event == SUBXACT_EVENT_ABORT_SUB)
+	{
+		TransactionId	curr_xid = GetCurrentTransactionIdIfAny();
+		HASH_SEQ_STATUS	hseq;
+		GpuCacheDesc   *gc_desc;
+
+		hash_seq_init(&hseq, gcache_descriptors_htab);
+		while ((gc_desc = hash_seq_search(&hseq)) != NULL)
+		{
+			if (gc_desc->xid == curr_xid)
+				releaseGpuCacheDesc(gc_desc, false);
+		}
+	}
+}
+
+/* ------------------------------------------------------------
+ *
+ * Routines to replicate GpuCache on the hot-standby server
+ *
+ * PostgreSQL provides no hook on the WAL replay of heap modification, so
+ * the sync trigger never works on the standby server. Instead, the primary
+ * server writes the REDO logs of GpuCache to WAL using the custom resource
+ * manager, then the startup process of the standby server appends them to
+ * its own GpuCache; the GPU service applies them as usual.
+ *
+ * ------------------------------------------------------------
+ */
+
+/*
+ * __gpuCacheXLogReset
+ */
+static void
+__gpuCacheXLogReset(GpuCacheSharedState *gc_sstate)
+{
+	xl_gpucache_reset xlrec;
+
+	memset(&xlrec, 0, sizeof(xl_gpucache_reset));
+	memcpy(&xlrec.ident, &gc_sstate->ident, sizeof(GpuCacheIdent));
+	strncpy(xlrec.table_name, gc_sstate->table_name, NAMEDATALEN);
+	memcpy(&xlrec.gc_options, &gc_sstate->gc_options, sizeof(GpuCacheOptions));
+	xlrec.kds_extra_sz = gc_sstate->kds_extra_sz;
+
+	XLogBeginInsert();
+	XLogRegisterData((char *)&xlrec, sizeof(xl_gpucache_reset));
+	XLogRegisterData((char *)&gc_sstate->kds_head,
+					 KDS_HEAD_LENGTH(&gc_sstate->kds_head));
+	XLogInsert(GPUCACHE_RMGR_ID, XLOG_GPUCACHE_RESET);
+}
+
+/*
+ * __gpuCacheXLogIdent
+ */
+static void
+__gpuCacheXLogIdent(const GpuCacheIdent *ident, uint8 info)
+{
+	GpuCacheIdent	xlrec;
+
+	memcpy(&xlrec, ident, sizeof(GpuCacheIdent));
+	XLogBeginInsert();
+	XLogRegisterData((char *)&xlrec, sizeof(GpuCacheIdent));
+	XLogInsert(GPUCACHE_RMGR_ID, info);
+}
+
+/*
+ * __gpuCacheReplayUnmap
+ *
+ * It releases the GpuCache built by the WAL replay, then the GPU service
+ * unloads the device buffers asynchronously.
+ */
+static void
+__gpuCacheReplayUnmap(GpuCacheLocalMapping *gc_lmap, bool with_ref)
+{
+	GpuCacheIdent ident;
+	int			cuda_dindex = gc_lmap->gc_sstate->gc_options.cuda_dindex;
+	char		namebuf[MAXPGPATH];
+
+	memcpy(&ident, &gc_lmap->ident, sizeof(GpuCacheIdent));
+	pthreadMutexLock(&gcache_shared_mapping_lock);
+	gc_lmap->refcnt &= 0xfffffffeU;		/* no longer preserved */
+	if (with_ref)
+		__putGpuCacheLocalMappingNoLock(gc_lmap);
+	else if (gc_lmap->refcnt == 0)
+		__removeGpuCacheLocalMapping(gc_lmap);
+	pthreadMutexUnlock(&gcache_shared_mapping_lock);
+
+	__gpuCacheInvokeBackgroundCommand(&ident,
+									  cuda_dindex,
+									  true,
+									  GCACHE_CONTROL_CMD__DROP_UNLOAD,
+									  0);
+	GpuCacheSharedStateName(namebuf, MAXPGPATH,
+							ident.database_oid,
+							ident.table_oid,
+							ident.signature);
+	shm_unlink(namebuf);
+}
+
+/*
+ * __gpuCacheReplayDrop
+ */
+static void
+__gpuCacheReplayDrop(const GpuCacheIdent *ident)
+{
+	GpuCacheLocalMapping *gc_lmap;
+
+	gc_lmap = getGpuCacheLocalMappingIfExist(ident->database_oid,
+											 ident->table_oid,
+											 ident->signature,
+											 true);
+	if (gc_lmap)
+		__gpuCacheReplayUnmap(gc_lmap, true);
+}
+
+/*
+ * __gpuCacheReplayReset
+ */
+static void
+__gpuCacheReplayReset(const xl_gpucache_reset *xlrec,
+					  const kern_data_store *kds_head)
+{
+	const GpuCacheOptions *gc_options = &xlrec->gc_options;
+	GpuCacheLocalMapping *gc_lmap;
+
+	/* the previous GpuCache (if any) is discarded */
+	__gpuCacheReplayDrop(&xlrec->ident);
+
+	if (gc_options->cuda_dindex >= numGpuDevAttrs ||
+		gc_options->num_replicas > numGpuDevAttrs)
+	{
+		elog(LOG, "gpucache: table '%s' is not replayed, because GPU%d and %d replicas are not available on the standby server",
+			 xlrec->table_name,
+			 gc_options->cuda_dindex,
+			 gc_options->num_replicas);
+		return;
+	}
+	pthreadMutexLock(&gcache_shared_head->gcache_sstate_mutex);
+	PG_TRY();
+	{
+		gc_lmap = __buildGpuCacheSharedState(&xlrec->ident,
+											 xlrec->table_name,
+											 gc_options,
+											 kds_head,
+											 xlrec->kds_extra_sz);
+	}
+	PG_CATCH();
+	{
+		pthreadMutexUnlock(&gcache_shared_head->gcache_sstate_mutex);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	pthreadMutexUnlock(&gcache_shared_head->gcache_sstate_mutex);
+	pg_atomic_write_u32(&gc_lmap->gc_sstate->phase,
+						GCACHE_PHASE__IS_LOADING);
+	/* the mapping is preserved until DROP or promotion */
+	putGpuCacheLocalMapping(gc_lmap);
+}
+
+/*
+ * __gpuCacheReplayRedo
+ */
+static void
+__gpuCacheReplayRedo(const xl_gpucache_redo *xlrec, size_t length)
+{
+	GpuCacheLocalMapping *gc_lmap;
+	GpuCacheDesc	gc_desc;
+
+	gc_lmap = getGpuCacheLocalMappingIfExist(xlrec->ident.database_oid,
+											 xlrec->ident.table_oid,
+											 xlrec->ident.signature,
+											 true);
+	if (!gc_lmap)
+		return;		/* not built on the standby */
+	PG_TRY();
+	{
+		memset(&gc_desc, 0, sizeof(GpuCacheDesc));
+		memcpy(&gc_desc.ident, &xlrec->ident, sizeof(GpuCacheIdent));
+		memcpy(&gc_desc.gc_options, &gc_lmap->gc_sstate->gc_options,
+			   sizeof(GpuCacheOptions));
+		gc_desc.gc_lmap = gc_lmap;
+		__gpuCacheAppendLogs(&gc_desc,
+							 (const char *)(xlrec + 1),
+							 length - sizeof(xl_gpucache_redo),
+							 xlrec->nitems);
+	}
+	PG_CATCH();
+	{
+		putGpuCacheLocalMapping(gc_lmap);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+	putGpuCacheLocalMapping(gc_lmap);
+}
+
+/*
+ * __gpuCacheReplayReady
+ */
+static void
+__gpuCacheReplayReady(const GpuCacheIdent *ident)
+{
+	GpuCacheLocalMapping *gc_lmap;
+	uint32_t	phase = GCACHE_PHASE__IS_LOADING;
+
+	gc_lmap = getGpuCacheLocalMappingIfExist(ident->database_oid,
+											 ident->table_oid,
+											 ident->signature,
+											 true);
+	if (gc_lmap)
+	{
+		pg_atomic_compare_exchange_u32(&gc_lmap->gc_sstate->phase,
+									   &phase,
+									   GCACHE_PHASE__IS_READY);
+		putGpuCacheLocalMapping(gc_lmap);
+	}
+}
+
+/*
+ * gpuCacheRmgrRedo
+ *
+ * Any errors are not raised, because it stops the WAL replay; the GpuCache
+ * on the standby server is not available in this case.
+ */
+static void
+gpuCacheRmgrRedo(XLogReaderState *record)
+{
+	uint8		info = XLogRecGetInfo(record) & ~XLR_INFO_MASK;
+	char	   *data = XLogRecGetData(record);
+	size_t		length = XLogRecGetDataLen(record);
+	MemoryContext oldcxt = CurrentMemoryContext;
+
+	/* GpuCache is built only on the hot-standby server with GPUs */
+	if (!StandbyMode || !gcache_shared_head)
+		return;
+	PG_TRY();
+	{
+		switch (info)
+		{
+			case XLOG_GPUCACHE_RESET:
+				__gpuCacheReplayReset((xl_gpucache_reset *)data,
+									  (kern_data_store *)(data + sizeof(xl_gpucache_reset)));
+				break;
+			case XLOG_GPUCACHE_REDO:
+				__gpuCacheReplayRedo((xl_gpucache_redo *)data, length);
+				break;
+			case XLOG_GPUCACHE_READY:
+				__gpuCacheReplayReady((GpuCacheIdent *)data);
+				break;
+			case XLOG_GPUCACHE_DROP:
+				__gpuCacheReplayDrop((GpuCacheIdent *)data);
+				break;
+			default:
+				elog(ERROR, "unknown GpuCache WAL record: %u", info);
+		}
+	}
+	PG_CATCH();
+	{
+		ErrorData  *edata;
+
+		MemoryContextSwitchTo(oldcxt);
+		edata = CopyErrorData();
+		FlushErrorState();
+		elog(LOG, "gpucache: failed on WAL replay (%s), GpuCache on the standby server may be unavailable",
+			 edata->message);
+		FreeErrorData(edata);
+	}
+	PG_END_TRY();
+}
+
+/*
+ * gpuCacheRmgrDesc
+ */
+static void
+gpuCacheRmgrDesc(StringInfo buf, XLogReaderState *record)
+{
+	uint8		info = XLogRecGetInfo(record) & ~XLR_INFO_MASK;
+	GpuCacheIdent *ident = (GpuCacheIdent *)XLogRecGetData(record);
+
+	appendStringInfo(buf, "dat %u, rel %u, sig %09lx",
+					 ident->database_oid,
+					 ident->table_oid,
+					 ident->signature);
+	if (info == XLOG_GPUCACHE_RESET)
+		appendStringInfo(buf, ", table %s",
+						 ((xl_gpucache_reset *)ident)->table_name);
+	else if (info == XLOG_GPUCACHE_REDO)
+		appendStringInfo(buf, ", nitems %u",
+						 ((xl_gpucache_redo *)ident)->nitems);
+}
+
+/*
+ * gpuCacheRmgrIdentify
+ */
+static const char *
+gpuCacheRmgrIdentify(uint8 info)
+{
+	switch (info & ~XLR_INFO_MASK)
+	{
+		case XLOG_GPUCACHE_RESET:
+			return "RESET";
+		case XLOG_GPUCACHE_REDO:
+			return "REDO";
+		case XLOG_GPUCACHE_READY:
+			return "READY";
+		case XLOG_GPUCACHE_DROP:
+			return "DROP";
+	}
+	return NULL;
+}
+
+/*
+ * gpuCacheRmgrCleanup
+ *
+ * GpuCache built by the WAL replay is no longer maintained once the standby
+ * server is promoted, because the sync trigger never wrote the rowid-map of
+ * the backends, so it shall be dropped then rebuilt on demand.
+ */
+static void
+gpuCacheRmgrCleanup(void)
+{
+	if (!gcache_shared_head)
+		return;
+	for (int i=0; i < GCACHE_SHARED_MAPPING_NSLOTS; i++)
+	{
+		dlist_head *hslot = &gcache_shared_mapping_slot[i];
+		dlist_mutable_iter iter;
+
+		dlist_foreach_modify(iter, hslot)
+		{
+			GpuCacheLocalMapping *gc_lmap = dlist_container(GpuCacheLocalMapping,
+															 chain, iter.cur);
+			PG_TRY();
+			{
+				__gpuCacheReplayUnmap(gc_lmap, false);
+			}
+			PG_CATCH();
+			{
+				EmitErrorReport();
+				FlushErrorState();
+			}
+			PG_END_TRY();
+		}
+	}
+}
+
+static const RmgrData	gpucache_rmgr_data = {
+	.rm_name		= "pg_strom_gpucache",
+	.rm_redo		= gpuCacheRmgrRedo,
+	.rm_desc		= gpuCacheRmgrDesc,
+	.rm_identify	= gpuCacheRmgrIdentify,
+	.rm_startup		= NULL,
+	.rm_cleanup		= gpuCacheRmgrCleanup,
+	.rm_mask		= NULL,
+	.rm_decode		= NULL,
+};
+
+/*
+ * pgstrom_init_gpu_cache_rmgr
+ *
+ * The custom resource manager must be registered on the standby server,
+ * even if it has no GPUs, to replay the WAL written by the primary server.
+ */
+void
+pgstrom_init_gpu_cache_rmgr(void)
+{
+	/* GUC: pg_strom.gpucache_wal_logging */
+	DefineCustomBoolVariable("pg_strom.gpucache_wal_logging",
+							 "Writes REDO logs of GpuCache to WAL for the hot-standby servers",
+							 NULL,
+							 &pgstrom_gpucache_wal_logging,
+							 false,
+							 PGC_POSTMASTER,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* GUC: pg_strom.gpucache_rmgr_id */
+	DefineCustomIntVariable("pg_strom.gpucache_rmgr_id",
+							"Custom WAL resource manager ID of GpuCache",
+							"It must be unique among the extensions, and same on the primary and the standby servers",
+							&pgstrom_gpucache_rmgr_id,
+							RM_EXPERIMENTAL_ID,
+							RM_MIN_CUSTOM_ID,
+							RM_MAX_CUSTOM_ID,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	RegisterCustomRmgr(GPUCACHE_RMGR_ID, &gpucache_rmgr_data);
+}
+
+/* ------------------------------------------------------------
+ *
+ * GpuCache Manager Routines
+ *
+ * ------------------------------------------------------------
+ */
+
+/*
+ * __gpucacheAllocDeviceMemory
+ *
+ * NOTE: must be called under the exclusive lock of gcache_rwlock
+ */
+/*
+ * __gpucacheLoadSnapshot
+ *
+ * It reads the image of device buffers from the snapshot being restored.
+ * The managed memory is directly written by the host, then it shall be
+ * migrated to the device on demand.
+ */
+static int
+__gpucacheLoadSnapshot(GpuCacheSharedState *gc_sstate,
+					   CUdeviceptr gcache_main_devptr,
+					   CUdeviceptr gcache_extra_devptr,
+					   size_t gcache_extra_size,
+					   char *errbuf, int errbuf_sz)
+{
+	GpuCacheSnapshotHeader h;
+	char		rpath[MAXPGPATH];
+	int			fdesc;
+	int			status = EIO;
+
+	GpuCacheSnapshotFileName(rpath, MAXPGPATH,
+							 gc_sstate->ident.database_oid,
+							 gc_sstate->ident.table_oid,
+							 gc_sstate->ident.signature, ".restore");
+	fdesc = open(rpath, O_RDONLY);
+	if (fdesc < 0)
+	{
+		snprintf(errbuf, errbuf_sz, "failed on open('%s'): %m", rpath);
+		return EIO;
+	}
+	if (__preadFile(fdesc, &h, sizeof(h), 0) != sizeof(h))
+		snprintf(errbuf, errbuf_sz, "failed on read('%s'): %m", rpath);
+	else if (h.main_sz != gc_sstate->kds_head.length ||
+			 h.extra_length > gcache_extra_size ||
+			 (h.extra_usage > 0 && gcache_extra_devptr == 0UL))
+		snprintf(errbuf, errbuf_sz, "snapshot '%s' is not valid", rpath);
+	else if (__preadFile(fdesc, (void *)gcache_main_devptr, h.main_sz,
+						 GpuCacheSnapshotMainOffset(&h)) != h.main_sz ||
+			 (h.extra_usage > 0 &&
+			  __preadFile(fdesc, (void *)gcache_extra_devptr, h.extra_usage,
+						  GpuCacheSnapshotExtraOffset(&h)) != h.extra_usage))
+		snprintf(errbuf, errbuf_sz, "failed on read('%s'): %m", rpath);
+	else
+	{
+		if (gcache_extra_devptr != 0UL)
+			((kern_data_extra *)gcache_extra_devptr)->length = gcache_extra_size;
+		status = 0;
+	}
+	close(fdesc);
+	return status;
+}
+
+/*
+ * __gpucacheCloneDeviceBuffer
+ *
+ * It copies the device buffers of the previous GpuCache on the same GPU
+ * to the new (resized) one. Each column is copied as is, because rowid
+ * is not changed on the resizing, and the varlena offsets on the extra
+ * buffer are still valid. The index shall be rebuilt on the REDO-log apply.
+ */
+static int
+__gpucacheCloneDeviceBuffer(GpuCacheDeviceBuffer *gc_dbuf,
+							uint64_t prev_signature,
+							CUdeviceptr gcache_main_devptr,
+							CUdeviceptr gcache_extra_devptr,
+							size_t gcache_extra_size,
+							char *errbuf, int errbuf_sz)
+{
+	GpuCacheSharedState *gc_sstate = gc_dbuf->gc_lmap->gc_sstate;
+	GpuCacheLocalMapping *prev_lmap;
+	GpuCacheDeviceBuffer *prev_dbuf;
+	kern_data_store *kds = (kern_data_store *)gcache_main_devptr;
+	kern_data_store *kds_prev;
+	kern_data_extra *extra_prev;
+	size_t		extra_usage = 0;
+	CUresult	rc;
+	int			status = EIO;
+
+	prev_lmap = getGpuCacheLocalMappingIfExist(gc_sstate->ident.database_oid,
+											   gc_sstate->ident.table_oid,
+											   prev_signature,
+											   false);
+	if (!prev_lmap)
+	{
+		snprintf(errbuf, errbuf_sz,
+				 "previous GpuCache (sig=%09lx) not found", prev_signature);
+		return ENOENT;
+	}
+	prev_dbuf = &prev_lmap->gc_dbuf[gc_dbuf->replica];
+	pthreadRWLockReadLock(&prev_dbuf->gcache_rwlock);
+	if (prev_dbuf->gcache_main_devptr == 0UL)
+	{
+		snprintf(errbuf, errbuf_sz,
+				 "previous GpuCache (sig=%09lx) is not loaded", prev_signature);
+		goto bailout;
+	}
+	kds_prev = (kern_data_store *)prev_dbuf->gcache_main_devptr;
+	if (kds_prev->nr_colmeta != kds->nr_colmeta)
+	{
+		snprintf(errbuf, errbuf_sz,
+				 "previous GpuCache (sig=%09lx) is not compatible", prev_signature);
+		goto bailout;
+	}
+	if (prev_dbuf->gcache_extra_devptr != 0UL)
+	{
+		extra_prev = (kern_data_extra *)prev_dbuf->gcache_extra_devptr;
+		extra_usage = extra_prev->usage;
+		if (gcache_extra_devptr == 0UL || extra_usage > gcache_extra_size)
+		{
+			snprintf(errbuf, errbuf_sz,
+					 "extra buffer (%zu) is too small to clone (%zu)",
+					 gcache_extra_size, extra_usage);
+			goto bailout;
+		}
+	}
+
+	for (int j=0; j < kds->nr_colmeta; j++)
+	{
+		kern_colmeta *cmeta = &kds->colmeta[j];
+		kern_colmeta *cmeta_prev = &kds_prev->colmeta[j];
+
+		if (cmeta->nullmap_offset != 0 && cmeta_prev->nullmap_offset != 0)
+		{
+			rc = cuMemcpyDtoDAsync(gcache_main_devptr +
+								   __kds_unpack(cmeta->nullmap_offset),
+								   prev_dbuf->gcache_main_devptr +
+								   __kds_unpack(cmeta_prev->nullmap_offset),
+								   Min(__kds_unpack(cmeta->nullmap_length),
+									   __kds_unpack(cmeta_prev->nullmap_length)),
+								   CU_STREAM_LEGACY);
+			if (rc != CUDA_SUCCESS)
+				goto error;
+		}
+		if (cmeta->values_offset != 0 && cmeta_prev->values_offset != 0)
+		{
+			rc = cuMemcpyDtoDAsync(gcache_main_devptr +
+								   __kds_unpack(cmeta->values_offset),
+								   prev_dbuf->gcache_main_devptr +
+								   __kds_unpack(cmeta_prev->values_offset),
+								   Min(__kds_unpack(cmeta->values_length),
+									   __kds_unpack(cmeta_prev->values_length)),
+								   CU_STREAM_LEGACY);
+			if (rc != CUDA_SUCCESS)
+				goto error;
+		}
+	}
+	/* summary has the same layout, because it is not a sizing option */
+	if (kds->column_summary_offset != 0 && kds_prev->column_summary_offset != 0)
+	{
+		rc = cuMemcpyDtoDAsync(gcache_main_devptr +
+							   __kds_unpack(kds->column_summary_offset),
+							   prev_dbuf->gcache_main_devptr +
+							   __kds_unpack(kds_prev->column_summary_offset),
+							   gpuCacheSummaryLength(&gc_sstate->gc_options),
+							   CU_STREAM_LEGACY);
+		if (rc != CUDA_SUCCESS)
+			goto error;
+	}
+	if (extra_usage > 0)
+	{
+		rc = cuMemcpyDtoDAsync(gcache_extra_devptr,
+							   prev_dbuf->gcache_extra_devptr,
+							   extra_usage,
+							   CU_STREAM_LEGACY);
+		if (rc != CUDA_SUCCESS)
+			goto error;
+	}
+	rc = cuStreamSynchronize(CU_STREAM_LEGACY);
+	if (rc != CUDA_SUCCESS)
+		goto error;
+	/* rows beyond the new max_num_rows are already removed */
+	kds->nitems = Min(kds_prev->nitems, kds->column_nrooms);
+	if (gcache_extra_devptr != 0UL)
+		((kern_data_extra *)gcache_extra_devptr)->length = gcache_extra_size;
+	pg_atomic_write_u64(&gc_sstate->gcache_main_nitems, kds->nitems);
+	pg_atomic_write_u64(&gc_sstate->gcache_extra_usage, extra_usage);
+	pg_atomic_write_u64(&gc_sstate->gcache_extra_dead,
+						pg_atomic_read_u64(&prev_lmap->gc_sstate->gcache_extra_dead));
+	status = 0;
+	goto bailout;
+
+error:
+	snprintf(errbuf, errbuf_sz,
+			 "failed on cuMemcpyDtoDAsync: %s", cuStrError(rc));
+bailout:
+	pthreadRWLockUnlock(&prev_dbuf->gcache_rwlock);
+	putGpuCacheLocalMapping(prev_lmap);
+	return status;
+}
+
+/*
+ * __gpucacheAdviseTieredColumns
+ *
+ * In the tiered mode, the columns referenced by a considerable portion of
+ * the recent scans (hot) prefer the device memory, and the other (cold)
+ * ones prefer the host memory; GPU kernels access the cold columns over
+ * the PCI-E bus without page migration, because the entire main buffer is
+ * mapped to the device by CU_MEM_ADVISE_SET_ACCESSED_BY.
+ * The system column, the index and the virtual columns are always hot.
+ */
+static void
+__gpucacheAdviseColumnLocation(GpuCacheDeviceBuffer *gc_dbuf,
+							   const kern_colmeta *cmeta,
+							   CUdevice location)
+{
+	CUdeviceptr	base = gc_dbuf->gcache_main_devptr;
+
+	if (cmeta->nullmap_offset != 0)
+	{
+		(void)cuMemAdvise(base + __kds_unpack(cmeta->nullmap_offset),
+						  __kds_unpack(cmeta->nullmap_length),
+						  CU_MEM_ADVISE_SET_PREFERRED_LOCATION,
+						  location);
+		if (location != CU_DEVICE_CPU)
+			(void)cuMemPrefetchAsync(base + __kds_unpack(cmeta->nullmap_offset),
+									 __kds_unpack(cmeta->nullmap_length),
+									 location,
+									 CU_STREAM_LEGACY);
+	}
+	if (cmeta->values_offset != 0)
+	{
+		(void)cuMemAdvise(base + __kds_unpack(cmeta->values_offset),
+						  __kds_unpack(cmeta->values_length),
+						  CU_MEM_ADVISE_SET_PREFERRED_LOCATION,
+						  location);
+		if (location != CU_DEVICE_CPU)
+			(void)cuMemPrefetchAsync(base + __kds_unpack(cmeta->values_offset),
+									 __kds_unpack(cmeta->values_length),
+									 location,
+									 CU_STREAM_LEGACY);
+	}
+}
+
 static void
-gpuCacheSubXactCallback(SubXactEvent event,
-						SubTransactionId mySubid,
-						SubTransactionId parentSubid, void *arg)
+__gpucacheAdviseTieredColumns(GpuCacheDeviceBuffer *gc_dbuf)
 {
-#ifdef GPUCACHE_DEBUG_MESSAGE
-	elog(INFO, "SubXactCallback: ev=%s xid=%u top-xid=%u",
-		 event == SUBXACT_EVENT_START_SUB ? "SUBXACT_EVENT_START_SUB" :
-		 event == SUBXACT_EVENT_COMMIT_SUB ? "SUBXACT_EVENT_COMMIT_SUB" :
-		 event == SUBXACT_EVENT_ABORT_SUB ? "SUBXACT_EVENT_ABORT_SUB" :
-		 event == SUBXACT_EVENT_PRE_COMMIT_SUB ? "SUBXACT_EVENT_PRE_COMMIT_SUB" : "???",
-		 GetCurrentTransactionIdIfAny(),
-		 GetTopTransactionIdIfAny());
-#endif
-	if (hash_get_num_entries(gcache_descriptors_htab) > 0 &&
-		event == SUBXACT_EVENT_ABORT_SUB)
+	GpuCacheSharedState *gc_sstate = gc_dbuf->gc_lmap->gc_sstate;
+	const kern_data_store *kds_head = &gc_sstate->kds_head;
+	int			nattrs = Min(kds_head->ncols, MaxTupleAttributeNumber);
+	uint32_t	nscans[MaxTupleAttributeNumber];
+	uint32_t	max_nscans = 0;
+	CUdevice	cuda_device;
+
+	if (!gc_sstate->gc_options.tiered ||
+		gc_dbuf->gcache_main_devptr == 0UL ||
+		cuCtxGetDevice(&cuda_device) != CUDA_SUCCESS)
+		return;
+	for (int j=0; j < nattrs; j++)
 	{
-		TransactionId	curr_xid = GetCurrentTransactionIdIfAny();
-		HASH_SEQ_STATUS	hseq;
-		GpuCacheDesc   *gc_desc;
+		nscans[j] = pg_atomic_read_u32(&gc_sstate->column_nscans[j]);
+		max_nscans = Max(max_nscans, nscans[j]);
+		/* decay of the access statistics */
+		if (nscans[j] > 1)
+			pg_atomic_fetch_sub_u32(&gc_sstate->column_nscans[j], nscans[j] / 2);
+	}
+	for (int j=0; j < nattrs; j++)
+	{
+		const kern_colmeta *cmeta = &kds_head->colmeta[j];
+		uint8_t		tier;
 
-		hash_seq_init(&hseq, gcache_descriptors_htab);
-		while ((gc_desc = hash_seq_search(&hseq)) != NULL)
-		{
-			if (gc_desc->xid == curr_xid)
-				releaseGpuCacheDesc(gc_desc, false);
-		}
+		if (j >= kds_head->ncols - gc_sstate->gc_options.num_vcols ||
+			j + 1 == gc_sstate->gc_options.index_attnum)
+			tier = GCACHE_COLUMN_TIER__DEVICE;	/* virtual or index key */
+		else if (nscans[j] > 0 && nscans[j] * 10 >= max_nscans)
+			tier = GCACHE_COLUMN_TIER__DEVICE;
+		else
+			tier = GCACHE_COLUMN_TIER__HOST;
+		if (gc_dbuf->column_tiers[j] == tier)
+			continue;
+		__gpucacheAdviseColumnLocation(gc_dbuf, cmeta,
+									   tier == GCACHE_COLUMN_TIER__DEVICE
+									   ? cuda_device
+									   : CU_DEVICE_CPU);
+		gc_dbuf->column_tiers[j] = tier;
 	}
 }
 
-/* ------------------------------------------------------------
- *
- * GpuCache Manager Routines
+/*
+ * __gpucacheInitSummary
  *
- * ------------------------------------------------------------
+ * It clears the group-slots and the GCACHE_SYSATTR_FLAG__SUMMARIZED flags
+ * of the new main buffer, then sets up the summary header. Snapshot and
+ * clone overwrite both of them consistently, if any.
  */
+static int
+__gpucacheInitSummary(GpuCacheSharedState *gc_sstate,
+					  CUdeviceptr gcache_main_devptr,
+					  char *errbuf, int errbuf_sz)
+{
+	const GpuCacheOptions *gc_options = &gc_sstate->gc_options;
+	const kern_data_store *kds_head = &gc_sstate->kds_head;
+	const kern_colmeta *cmeta = &kds_head->colmeta[kds_head->nr_colmeta - 1];
+	kern_gpucache_summary *gsum;
+	CUresult	rc;
+
+	if (kds_head->column_summary_offset == 0)
+		return 0;
+	rc = cuMemsetD8Async(gcache_main_devptr + __kds_unpack(cmeta->values_offset),
+						 0, __kds_unpack(cmeta->values_length),
+						 CU_STREAM_LEGACY);
+	if (rc == CUDA_SUCCESS)
+		rc = cuMemsetD8Async(gcache_main_devptr +
+							 __kds_unpack(kds_head->column_summary_offset),
+							 0, gpuCacheSummaryLength(gc_options),
+							 CU_STREAM_LEGACY);
+	if (rc == CUDA_SUCCESS)
+		rc = cuStreamSynchronize(CU_STREAM_LEGACY);
+	if (rc != CUDA_SUCCESS)
+	{
+		snprintf(errbuf, errbuf_sz,
+				 "failed on cuMemsetD8Async: %s", cuStrError(rc));
+		return EIO;
+	}
+	gsum = KDS_COLUMN_SUMMARY((kern_data_store *)gcache_main_devptr);
+	gsum->nslots = gc_options->summary_nslots;
+	gsum->ngroups = 0;
+	gsum->slot_sz = GPUCACHE_SUMMARY_SLOT_SZ(gc_options->summary_nvalues);
+	gsum->key_attnum = gc_options->summary_key_attnum;
+	gsum->nvalues = gc_options->summary_nvalues;
+	for (int k=0; k < gc_options->summary_nvalues; k++)
+	{
+		AttrNumber	anum = gc_options->summary_value_attnums[k];
+
+		gsum->value_attnums[k] = anum;
+		gsum->value_kinds[k] =
+			(kds_head->colmeta[anum-1].atttypid == FLOAT4OID ||
+			 kds_head->colmeta[anum-1].atttypid == FLOAT8OID ? 'f' : 'i');
+	}
+	return 0;
+}
 
 /*
- * __gpucacheAllocDeviceMemory
+ * __gpucacheMirrorSummary
  *
- * NOTE: must be called under the exclusive lock of gcache_rwlock
+ * It copies the summary of the primary device buffer to the shared memory
+ * segment, for the backends to read by pgstrom.gpucache_summary().
  */
+static void
+__gpucacheMirrorSummary(GpuCacheDeviceBuffer *gc_dbuf)
+{
+	GpuCacheSharedState *gc_sstate = gc_dbuf->gc_lmap->gc_sstate;
+	kern_data_store *kds = (kern_data_store *)gc_dbuf->gcache_main_devptr;
+	CUresult	rc;
+
+	if (gc_dbuf->replica != 0 || kds->column_summary_offset == 0)
+		return;
+	pthreadMutexLock(&gc_sstate->summary_mutex);
+	rc = cuMemcpyDtoH(gpuCacheSummaryBuffer(gc_sstate),
+					  gc_dbuf->gcache_main_devptr +
+					  __kds_unpack(kds->column_summary_offset),
+					  gpuCacheSummaryLength(&gc_sstate->gc_options));
+	if (rc != CUDA_SUCCESS)
+	{
+		/* readers see the empty summary, rather than the broken one */
+		memset(gpuCacheSummaryBuffer(gc_sstate), 0,
+			   offsetof(kern_gpucache_summary, slots));
+		fprintf(stderr, "gpucache: failed on cuMemcpyDtoH: %s\n",
+				cuStrError(rc));
+	}
+	pthreadMutexUnlock(&gc_sstate->summary_mutex);
+}
+
 static int
-__gpucacheAllocDeviceMemory(GpuCacheLocalMapping *gc_lmap,
+__gpucacheAllocDeviceMemory(GpuCacheDeviceBuffer *gc_dbuf,
 							char *errbuf, int errbuf_sz)
 {
-
+	GpuCacheLocalMapping *gc_lmap = gc_dbuf->gc_lmap;
 	GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
 	size_t		gcache_main_size = gc_sstate->kds_head.length;
 	size_t		gcache_extra_size = gc_sstate->kds_extra_sz;
 	CUdeviceptr	gcache_main_devptr = 0UL;
 	CUdeviceptr	gcache_extra_devptr = 0UL;
+	CUdevice	cuda_device;
+	uint64_t	prev_signature;
 	CUresult	rc;
 
 	rc = cuMemAllocManaged(&gcache_main_devptr,
@@ -3285,6 +6560,12 @@ __gpucacheAllocDeviceMemory(GpuCacheLocalMapping *gc_lmap,
 	memcpy((void *)gcache_main_devptr,
 		   &gc_sstate->kds_head,
 		   KDS_HEAD_LENGTH(&gc_sstate->kds_head));
+	if (__gpucacheInitSummary(gc_sstate, gcache_main_devptr,
+							  errbuf, errbuf_sz) != 0)
+	{
+		cuMemFree(gcache_main_devptr);
+		return EIO;
+	}
 
 	if (gcache_extra_size > 0)
 	{
@@ -3304,19 +6585,67 @@ __gpucacheAllocDeviceMemory(GpuCacheLocalMapping *gc_lmap,
 		kds_extra->length = gcache_extra_size;
 		kds_extra->usage = offsetof(kern_data_extra, data);
 	}
-	gc_lmap->gcache_main_devptr = gcache_main_devptr;
-	gc_lmap->gcache_extra_devptr = gcache_extra_devptr;
-	gc_lmap->gcache_main_size = gcache_main_size;
-	gc_lmap->gcache_extra_size = gcache_extra_size;
+	/* restore the device buffers from the snapshot, if any */
+	if (pg_atomic_read_u32(&gc_sstate->snapshot_restore) != 0 &&
+		__gpucacheLoadSnapshot(gc_sstate,
+							   gcache_main_devptr,
+							   gcache_extra_devptr,
+							   gcache_extra_size,
+							   errbuf, errbuf_sz) != 0)
+	{
+		cuMemFree(gcache_main_devptr);
+		if (gcache_extra_devptr != 0UL)
+			cuMemFree(gcache_extra_devptr);
+		return EIO;
+	}
+	/* clone the device buffers from the previous GpuCache, if resized */
+	prev_signature = pg_atomic_read_u64(&gc_sstate->clone_signature);
+	if (prev_signature != 0UL &&
+		__gpucacheCloneDeviceBuffer(gc_dbuf,
+									prev_signature,
+									gcache_main_devptr,
+									gcache_extra_devptr,
+									gcache_extra_size,
+									errbuf, errbuf_sz) != 0)
+	{
+		cuMemFree(gcache_main_devptr);
+		if (gcache_extra_devptr != 0UL)
+			cuMemFree(gcache_extra_devptr);
+		return EIO;
+	}
+	/* the replica should be resident on the GPU that manages it */
+	if (cuCtxGetDevice(&cuda_device) == CUDA_SUCCESS)
+	{
+		(void)cuMemAdvise(gcache_main_devptr, gcache_main_size,
+						  CU_MEM_ADVISE_SET_PREFERRED_LOCATION,
+						  cuda_device);
+		/* cold columns on the host memory are accessed without migration */
+		if (gc_sstate->gc_options.tiered)
+			(void)cuMemAdvise(gcache_main_devptr, gcache_main_size,
+							  CU_MEM_ADVISE_SET_ACCESSED_BY,
+							  cuda_device);
+		if (gcache_extra_devptr != 0UL)
+			(void)cuMemAdvise(gcache_extra_devptr, gcache_extra_size,
+							  CU_MEM_ADVISE_SET_PREFERRED_LOCATION,
+							  cuda_device);
+	}
+	gc_dbuf->gcache_main_devptr = gcache_main_devptr;
+	gc_dbuf->gcache_extra_devptr = gcache_extra_devptr;
+	gc_dbuf->gcache_main_size = gcache_main_size;
+	gc_dbuf->gcache_extra_size = gcache_extra_size;
+	gc_dbuf->gcache_epoch++;
+	memset(gc_dbuf->column_tiers, 0, sizeof(gc_dbuf->column_tiers));
+	__gpucacheAdviseTieredColumns(gc_dbuf);
 	pg_atomic_write_u64(&gc_sstate->gcache_main_size, gcache_main_size);
 	pg_atomic_write_u64(&gc_sstate->gcache_extra_size, gcache_extra_size);
 #if 1
-	fprintf(stderr, "%s: main %p (%lu), extra %p (%lu)\n",
+	fprintf(stderr, "%s: replica %d main %p (%lu), extra %p (%lu)\n",
 			__FUNCTION__,
-			(void *)gc_lmap->gcache_main_devptr,
-			gc_lmap->gcache_main_size,
-			(void *)gc_lmap->gcache_extra_devptr,
-			gc_lmap->gcache_extra_size);
+			gc_dbuf->replica,
+			(void *)gc_dbuf->gcache_main_devptr,
+			gc_dbuf->gcache_main_size,
+			(void *)gc_dbuf->gcache_extra_devptr,
+			gc_dbuf->gcache_extra_size);
 #endif
 	return 0;
 }
@@ -3325,22 +6654,24 @@ __gpucacheAllocDeviceMemory(GpuCacheLocalMapping *gc_lmap,
  * __gpucacheMarkAsCorrupted
  */
 static void
-__gpucacheMarkAsCorrupted(GpuCacheLocalMapping *gc_lmap)
+__gpucacheMarkAsCorrupted(GpuCacheDeviceBuffer *gc_dbuf)
 {
+	GpuCacheLocalMapping *gc_lmap = gc_dbuf->gc_lmap;
 	GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
 
 	pg_atomic_write_u32(&gc_sstate->phase, GCACHE_PHASE__IS_CORRUPTED);
-	if (gc_lmap->gcache_main_devptr != 0)
+	gc_dbuf->gcache_epoch++;
+	if (gc_dbuf->gcache_main_devptr != 0)
 	{
-		cuMemFree(gc_lmap->gcache_main_devptr);
-		gc_lmap->gcache_main_devptr = 0;
-		gc_lmap->gcache_main_size = 0;
+		cuMemFree(gc_dbuf->gcache_main_devptr);
+		gc_dbuf->gcache_main_devptr = 0;
+		gc_dbuf->gcache_main_size = 0;
 	}
-	if (gc_lmap->gcache_extra_devptr != 0UL)
+	if (gc_dbuf->gcache_extra_devptr != 0UL)
 	{
-		cuMemFree(gc_lmap->gcache_extra_devptr);
-		gc_lmap->gcache_extra_devptr = 0;
-		gc_lmap->gcache_extra_size = 0;
+		cuMemFree(gc_dbuf->gcache_extra_devptr);
+		gc_dbuf->gcache_extra_devptr = 0;
+		gc_dbuf->gcache_extra_size = 0;
 	}
 	/* clear the preserving flag */
 	pthreadMutexLock(&gcache_shared_mapping_lock);
@@ -3365,22 +6696,71 @@ __gpucacheMarkAsCorrupted(GpuCacheLocalMapping *gc_lmap)
 
 /*
  * GCACHE_CONTROL_CMD__COMPACTION
+ *
+ * The compaction copies the varlena values into the new extra buffer by
+ * GCACHE_COMPACTION_UNITSZ rows per cycle, without modification of the
+ * main buffer. So, unless caller already holds the exclusive lock, the
+ * concurrent scans can run on the old extra buffer by the last cycle.
+ * Then, it installs the new offsets and swaps the extra buffer under
+ * the exclusive lock. If GpuCache is updated during the cycles (it shall
+ * be detected by @gcache_epoch), the compaction is restarted.
  */
+#define GCACHE_COMPACTION_UNITSZ	(1U << 20)	/* rows per cycle */
+
 static int
 __gpucacheExecCompactionKernel(GpuCacheControlCommand *cmd,
-							   GpuCacheLocalMapping *gc_lmap,
+							   GpuCacheDeviceBuffer *gc_dbuf,
 							   CUfunction f_gcache_compaction,
-							   size_t gcache_extra_size)
+							   size_t gcache_extra_size,
+							   bool has_exclusive)
 {
-	GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
+	GpuCacheSharedState *gc_sstate = gc_dbuf->gc_lmap->gc_sstate;
+	kern_data_store *kds;
 	kern_data_extra *kds_extra;
 	CUdeviceptr	m_kds_extra = 0UL;
+	CUdeviceptr	m_new_offsets = 0UL;
+	uint64_t	epoch;
+	uint32_t	nitems;
+	uint32_t	row_start;
+	uint32_t	row_end;
+	int			nvarlena = 0;
+	int			phase;
 	int			grid_sz, block_sz;
-	void	   *kern_args[4];
+	void	   *kern_args[8];
 	CUresult	rc;
 
-	if (gcache_extra_size < gc_lmap->gcache_extra_size)
-		gcache_extra_size = gc_lmap->gcache_extra_size;
+	if (gcache_extra_size < gc_dbuf->gcache_extra_size)
+		gcache_extra_size = gc_dbuf->gcache_extra_size;
+	rc = gpuOptimalBlockSize(&grid_sz,
+							 &block_sz,
+							 f_gcache_compaction, 0);
+	if (rc != CUDA_SUCCESS)
+	{
+		snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+				 "failed on gpuOptimalBlockSize: %s", cuStrError(rc));
+		return EIO;
+	}
+restart:
+	kds = (kern_data_store *)gc_dbuf->gcache_main_devptr;
+	if (!kds)
+		return 0;	/* GpuCache is already released */
+	for (int j=0; j < kds->ncols; j++)
+	{
+		if (kds->colmeta[j].attlen < 0)
+			nvarlena++;
+	}
+	epoch = gc_dbuf->gcache_epoch;
+	nitems = kds->nitems;
+	if (nvarlena == 0 || gc_dbuf->gcache_extra_devptr == 0UL)
+		return 0;	/* nothing to do */
+	rc = cuMemAlloc(&m_new_offsets, sizeof(uint64_t) *
+					Max((size_t)nvarlena * (size_t)nitems, 1));
+	if (rc != CUDA_SUCCESS)
+	{
+		snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+				 "failed on cuMemAlloc: %s", cuStrError(rc));
+		return ENOMEM;
+	}
 retry:
 	rc = cuMemAllocManaged(&m_kds_extra,
 						   gcache_extra_size,
@@ -3389,24 +6769,85 @@ retry:
 	{
 		snprintf(cmd->errbuf, sizeof(cmd->errbuf),
 				 "failed on cuMemAllocManaged: %s", cuStrError(rc));
+		cuMemFree(m_new_offsets);
 		return ENOMEM;
 	}
 	kds_extra = (kern_data_extra *)m_kds_extra;
 	kds_extra->length = gcache_extra_size;
 	kds_extra->usage = offsetof(kern_data_extra, data);
 
-	rc = gpuOptimalBlockSize(&grid_sz,
-							 &block_sz,
-							 f_gcache_compaction, 0);
-	if (rc != CUDA_SUCCESS)
+	pg_atomic_write_u64(&gc_sstate->gcache_compaction_pos, 0);
+	pg_atomic_write_u64(&gc_sstate->gcache_compaction_nitems, nitems);
+	for (row_start = 0; row_start < nitems; row_start = row_end)
+	{
+		row_end = Min(nitems - row_start,
+					  GCACHE_COMPACTION_UNITSZ) + row_start;
+		phase = 1;
+		kern_args[0] = &gc_dbuf->gcache_main_devptr;
+		kern_args[1] = &gc_dbuf->gcache_extra_devptr;	/* OLD extra */
+		kern_args[2] = &m_kds_extra;					/* NEW extra */
+		kern_args[3] = &m_new_offsets;
+		kern_args[4] = &nitems;
+		kern_args[5] = &row_start;
+		kern_args[6] = &row_end;
+		kern_args[7] = &phase;
+		rc = cuLaunchKernel(f_gcache_compaction,
+							grid_sz, 1, 1,
+							block_sz, 1, 1,
+							0,
+							CU_STREAM_LEGACY,
+							kern_args,
+							NULL);
+		if (rc != CUDA_SUCCESS)
+		{
+			snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+					 "failed on cuLaunchKernel: %s", cuStrError(rc));
+			goto bailout;
+		}
+		rc = cuStreamSynchronize(CU_STREAM_LEGACY);
+		if (rc != CUDA_SUCCESS)
+		{
+			snprintf(cmd->errbuf, sizeof(cmd->errbuf),
+					 "failed on cuStreamSynchronize: %s", cuStrError(rc));
+			goto bailout;
+		}
+		pg_atomic_write_u64(&gc_sstate->gcache_compaction_pos, row_end);
+		if (kds_extra->usage > kds_extra->length)
+			break;
+		if (!has_exclusive)
+		{
+			/* give the concurrent tasks a chance to acquire the lock */
+			pthreadRWLockUnlock(&gc_dbuf->gcache_rwlock);
+			pthreadRWLockReadLock(&gc_dbuf->gcache_rwlock);
+			if (gc_dbuf->gcache_epoch != epoch)
+				goto restart_cleanup;
+		}
+	}
+
+	if (kds_extra->usage > kds_extra->length)
 	{
-		snprintf(cmd->errbuf, sizeof(cmd->errbuf),
-				 "failed on gpuOptimalBlockSize: %s", cuStrError(rc));
-		goto bailout;
+		/*
+		 * 64bit offset of the extra buffer has no hard limit, so only
+		 * the device memory allocation may fail.
+		 */
+		gcache_extra_size = PAGE_ALIGN(kds_extra->usage * 5 / 4);	/* 25% margin */
+		cuMemFree(m_kds_extra);
+		m_kds_extra = 0UL;
+		goto retry;
+	}
+
+	/* install the new offsets under the exclusive lock */
+	if (!has_exclusive)
+	{
+		pthreadRWLockUnlock(&gc_dbuf->gcache_rwlock);
+		pthreadRWLockWriteLock(&gc_dbuf->gcache_rwlock);
+		has_exclusive = true;
+		if (gc_dbuf->gcache_epoch != epoch)
+			goto restart_cleanup;
 	}
-	kern_args[0] = &gc_lmap->gcache_main_devptr;
-	kern_args[1] = &gc_lmap->gcache_extra_devptr;	/* OLD extra */
-	kern_args[2] = &m_kds_extra;					/* NEW extra */
+	phase = 2;
+	row_start = 0;
+	row_end = nitems;
 	rc = cuLaunchKernel(f_gcache_compaction,
 						grid_sz, 1, 1,
 						block_sz, 1, 1,
@@ -3427,49 +6868,50 @@ retry:
 				 "failed on cuStreamSynchronize: %s", cuStrError(rc));
 		goto bailout;
 	}
-	if (kds_extra->usage > kds_extra->length)
-	{
-		gcache_extra_size = PAGE_ALIGN(kds_extra->usage * 5 / 4);	/* 25% margin */
-		if (gcache_extra_size >= __KDS_LENGTH_LIMIT)
-		{
-#if 1
-			fprintf(stderr,
-					"GpuCache (%s) extra buffer (%ldMB) exceeds the hard limit\n",
-					gc_sstate->table_name,
-					gcache_extra_size >> 20);
-#endif
-			goto bailout;
-		}
-		cuMemFree(m_kds_extra);
-		m_kds_extra = 0UL;
-		goto retry;
-	}
 #if 1
 	fprintf(stderr, "%s: extra %p (%lu) --> %p (%lu)\n",
 			__FUNCTION__,
-			(void *)gc_lmap->gcache_extra_devptr,
-			gc_lmap->gcache_extra_size,
+			(void *)gc_dbuf->gcache_extra_devptr,
+			gc_dbuf->gcache_extra_size,
 			(void *)m_kds_extra,
 			gcache_extra_size);
 #endif
 	/* swap extra buffers */
-	cuMemFree(gc_lmap->gcache_extra_devptr);
-	gc_lmap->gcache_extra_devptr = m_kds_extra;
-	gc_lmap->gcache_extra_size   = gcache_extra_size;
+	cuMemFree(m_new_offsets);
+	cuMemFree(gc_dbuf->gcache_extra_devptr);
+	gc_dbuf->gcache_extra_devptr = m_kds_extra;
+	gc_dbuf->gcache_extra_size   = gcache_extra_size;
+	gc_dbuf->gcache_epoch++;
 	pg_atomic_write_u64(&gc_sstate->gcache_extra_size, gcache_extra_size);
+	pg_atomic_write_u64(&gc_sstate->gcache_compaction_pos, 0);
+	pg_atomic_write_u64(&gc_sstate->gcache_compaction_nitems, 0);
+	pg_atomic_fetch_add_u64(&gc_sstate->gcache_compaction_count, 1);
 	return 0;
 
+restart_cleanup:
+	cuMemFree(m_kds_extra);
+	m_kds_extra = 0UL;
+	cuMemFree(m_new_offsets);
+	m_new_offsets = 0UL;
+	nvarlena = 0;
+	goto restart;
+
 bailout:
 	if (m_kds_extra != 0)
 		cuMemFree(m_kds_extra);
+	cuMemFree(m_new_offsets);
+	pg_atomic_write_u64(&gc_sstate->gcache_compaction_pos, 0);
+	pg_atomic_write_u64(&gc_sstate->gcache_compaction_nitems, 0);
 	return EIO;
 }
 
 static int
 __gpucacheExecCompaction(GpuCacheControlCommand *cmd,
+						 int cuda_dindex,
 						 CUfunction f_gcache_compaction)
 {
 	GpuCacheLocalMapping *gc_lmap;
+	GpuCacheDeviceBuffer *gc_dbuf;
 	int		status = 0;
 
 	gc_lmap = getGpuCacheLocalMappingIfExist(cmd->ident.database_oid,
@@ -3485,31 +6927,111 @@ __gpucacheExecCompaction(GpuCacheControlCommand *cmd,
 				 cmd->ident.signature);
 		return EEXIST;
 	}
-	pthreadRWLockWriteLock(&gc_lmap->gcache_rwlock);
-	if (gc_lmap->gcache_main_devptr != 0UL)
+	gc_dbuf = gpuCacheLookupDeviceBuffer(gc_lmap, cuda_dindex);
+	pthreadRWLockReadLock(&gc_dbuf->gcache_rwlock);
+	if (gc_dbuf->gcache_main_devptr != 0UL)
 	{
 		status = __gpucacheExecCompactionKernel(cmd,
-												gc_lmap,
+												gc_dbuf,
 												f_gcache_compaction,
-												gc_lmap->gcache_extra_size);
+												gc_dbuf->gcache_extra_size,
+												false);
 	}
-	pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+	pthreadRWLockUnlock(&gc_dbuf->gcache_rwlock);
 	return status;
 }
 
+/*
+ * __gpucacheCoalesceRedoLog
+ *
+ * kern_gpucache_apply_redo applies only the last INSERT/DELETE log for each
+ * rowid (see gpucache_assign_update_owner), so the earlier ones are never
+ * applied. This routine removes them from the redo-log prior to the kernel
+ * invocation, to reduce the data transfer and the log scan on the device.
+ * It returns the new end of the redo-log.
+ */
+static char *
+__gpucacheCoalesceRedoLog(char *head, char *end, uint64_t nitems)
+{
+	uint64_t   *hslots;
+	uint64_t	nslots = 2 * nitems + 1;
+	uint64_t	index;
+	char	   *pos;
+	char	   *wpos;
+
+	hslots = calloc(nslots, sizeof(uint64_t));
+	if (!hslots)
+		return end;		/* no coalescing, but not an error */
+	/* 1st pass: the last INSERT/DELETE log for each rowid */
+	for (pos = head, index = 0; pos < end; index++)
+	{
+		GCacheTxLogCommon *tx_log = (GCacheTxLogCommon *)pos;
+		uint32_t	rowid;
+		uint64_t	k;
+
+		pos += tx_log->length;
+		if (tx_log->type == GCACHE_TX_LOG__INSERT)
+			rowid = ((GCacheTxLogInsert *)tx_log)->rowid;
+		else if (tx_log->type == GCACHE_TX_LOG__DELETE)
+			rowid = ((GCacheTxLogDelete *)tx_log)->rowid;
+		else
+			continue;
+		for (k = rowid % nslots; hslots[k] != 0; k = (k + 1) % nslots)
+		{
+			if ((uint32_t)(hslots[k] >> 32) == rowid)
+				break;
+		}
+		hslots[k] = ((uint64_t)rowid << 32) | (index + 1);
+	}
+	/* 2nd pass: removes the overwritten logs */
+	for (pos = wpos = head, index = 0; pos < end; index++)
+	{
+		GCacheTxLogCommon *tx_log = (GCacheTxLogCommon *)pos;
+		uint32_t	length = tx_log->length;
+		uint32_t	rowid;
+		uint64_t	k;
+
+		if (tx_log->type == GCACHE_TX_LOG__INSERT)
+			rowid = ((GCacheTxLogInsert *)tx_log)->rowid;
+		else if (tx_log->type == GCACHE_TX_LOG__DELETE)
+			rowid = ((GCacheTxLogDelete *)tx_log)->rowid;
+		else
+			goto keep;
+		for (k = rowid % nslots; (uint32_t)(hslots[k] >> 32) != rowid;
+			 k = (k + 1) % nslots)
+			Assert(hslots[k] != 0);
+		if ((uint32_t)hslots[k] != index + 1)
+		{
+			pos += length;
+			continue;
+		}
+	keep:
+		if (wpos != pos)
+			memmove(wpos, pos, length);
+		wpos += length;
+		pos  += length;
+	}
+	free(hslots);
+	return wpos;
+}
+
 /*
  * GCACHE_CONTROL_CMD__APPLY_REDO
  */
 static int
 __gpucacheExecApplyRedoKernel(GpuCacheControlCommand *cmd,
-							  GpuCacheLocalMapping *gc_lmap,
+							  GpuCacheDeviceBuffer *gc_dbuf,
 							  CUfunction f_gcache_apply_redo,
 							  CUfunction f_gcache_compaction)
 {
-	GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
+	GpuCacheSharedState *gc_sstate = gc_dbuf->gc_lmap->gc_sstate;
 	char	   *redo_buf = gpuCacheRedoLogBuffer(gc_sstate);
 	size_t		redo_bufsz = gc_sstate->gc_options.redo_buffer_size;
+	int			num_replicas = gc_sstate->gc_options.num_replicas;
+	int			replica = gc_dbuf->replica;
+	uint32_t	nphases = (gc_sstate->kds_head.column_index_attnum > 0 ? 8 : 6);
 	uint64_t	head_pos, tail_pos;
+	uint64_t	min_read_pos, min_read_nitems;
 	uint64_t	nitems;
 	size_t		length;
 	size_t		offset;
@@ -3518,15 +7040,21 @@ __gpucacheExecApplyRedoKernel(GpuCacheControlCommand *cmd,
 	void	   *kern_args[4];
 	kern_gpucache_redolog *gcache_redo;
 	CUdeviceptr	m_gcache_redo = 0UL;
+	CUdevice	cuda_device;
 	CUresult	rc;
 	int			status = EIO;
 
+	/*
+	 * Each replica consumes the redo-log by its own read position, so
+	 * the redo_read_pos is the oldest one not applied to all the replicas.
+	 */
 	pthreadMutexLock(&gc_sstate->redo_mutex);
-	Assert(gc_sstate->redo_write_pos    >= gc_sstate->redo_read_pos &&
-		   gc_sstate->redo_write_nitems >= gc_sstate->redo_read_nitems);
-	head_pos = gc_sstate->redo_read_pos;
+	Assert(gc_sstate->redo_write_pos    >= gc_sstate->replica_read_pos[replica] &&
+		   gc_sstate->redo_write_nitems >= gc_sstate->replica_read_nitems[replica]);
+	head_pos = gc_sstate->replica_read_pos[replica];
 	tail_pos = gc_sstate->redo_write_pos;
-	nitems  = (gc_sstate->redo_write_nitems - gc_sstate->redo_read_nitems);
+	nitems  = (gc_sstate->redo_write_nitems -
+			   gc_sstate->replica_read_nitems[replica]);
 	pthreadMutexUnlock(&gc_sstate->redo_mutex);
 
 	/* alloc kern_gpucache_redolog */
@@ -3568,12 +7096,25 @@ __gpucacheExecApplyRedoKernel(GpuCacheControlCommand *cmd,
 
 	/* make advance the read position */
 	pthreadMutexLock(&gc_sstate->redo_mutex);
-	gc_sstate->redo_read_pos    += length;
-	gc_sstate->redo_read_nitems += nitems;
+	gc_sstate->replica_read_pos[replica]    += length;
+	gc_sstate->replica_read_nitems[replica] += nitems;
+	min_read_pos    = gc_sstate->replica_read_pos[0];
+	min_read_nitems = gc_sstate->replica_read_nitems[0];
+	for (int r=1; r < num_replicas; r++)
+	{
+		min_read_pos    = Min(min_read_pos, gc_sstate->replica_read_pos[r]);
+		min_read_nitems = Min(min_read_nitems, gc_sstate->replica_read_nitems[r]);
+	}
+	gc_sstate->redo_read_pos    = min_read_pos;
+	gc_sstate->redo_read_nitems = min_read_nitems;
 	Assert(gc_sstate->redo_write_pos    >= gc_sstate->redo_read_pos &&
 		   gc_sstate->redo_write_nitems >= gc_sstate->redo_read_nitems);
 	pthreadMutexUnlock(&gc_sstate->redo_mutex);
 
+	/* remove the INSERT/DELETE logs overwritten by the later ones */
+	end = __gpucacheCoalesceRedoLog(pos, end, nitems);
+	length = end - (char *)gcache_redo;
+
 	/* setup kern_gpucache_redolog index */
 	while (pos < end)
 	{
@@ -3585,6 +7126,12 @@ __gpucacheExecApplyRedoKernel(GpuCacheControlCommand *cmd,
 		pos += tx_log->length;
 	}
 
+	/* kick the data transfer of the redo-log prior to the kernel */
+	if (cuCtxGetDevice(&cuda_device) == CUDA_SUCCESS)
+		(void)cuMemPrefetchAsync(m_gcache_redo, length,
+								 cuda_device,
+								 CU_STREAM_LEGACY);
+
 	/* GPU kernel invocation */
 	rc = gpuOptimalBlockSize(&grid_sz,
 							 &block_sz,
@@ -3596,11 +7143,13 @@ __gpucacheExecApplyRedoKernel(GpuCacheControlCommand *cmd,
 		goto bailout;
 	}
 retry:
-	for (uint32_t phase = 1; phase <= 6; phase++)
+	gc_dbuf->gcache_epoch++;
+	/* phase-7 and 8 rebuild the index, if any */
+	for (uint32_t phase = 1; phase <= nphases; phase++)
 	{
 		kern_args[0] = &m_gcache_redo;
-		kern_args[1] = &gc_lmap->gcache_main_devptr;
-		kern_args[2] = &gc_lmap->gcache_extra_devptr;
+		kern_args[1] = &gc_dbuf->gcache_main_devptr;
+		kern_args[2] = &gc_dbuf->gcache_extra_devptr;
 		kern_args[3] = &phase;
 
 		rc = cuLaunchKernel(f_gcache_apply_redo,
@@ -3627,16 +7176,17 @@ retry:
 
 	if (gcache_redo->kerror.errcode == ERRCODE_BUFFER_NO_SPACE)
 	{
-		kern_data_extra *extra = (kern_data_extra *)gc_lmap->gcache_extra_devptr;
+		kern_data_extra *extra = (kern_data_extra *)gc_dbuf->gcache_extra_devptr;
 		size_t		gcache_extra_size;
 		int			__status;
 
 		/* expand the extra buffer with 25% larger virtual space */
 		gcache_extra_size = PAGE_ALIGN((extra->length * 5) / 4);
 		__status = __gpucacheExecCompactionKernel(cmd,
-												  gc_lmap,
+												  gc_dbuf,
 												  f_gcache_compaction,
-												  gcache_extra_size);
+												  gcache_extra_size,
+												  true);
 		if (__status == 0)
 			goto retry;
 		/* abort */
@@ -3654,10 +7204,12 @@ retry:
 	}
 	else
 	{
-		kern_data_store	   *kds = (kern_data_store *)gc_lmap->gcache_main_devptr;
-		kern_data_extra	   *extra = (kern_data_extra *)gc_lmap->gcache_extra_devptr;
+		kern_data_store	   *kds = (kern_data_store *)gc_dbuf->gcache_main_devptr;
+		kern_data_extra	   *extra = (kern_data_extra *)gc_dbuf->gcache_extra_devptr;
 
 		pg_atomic_write_u64(&gc_sstate->gcache_main_nitems, kds->nitems);
+		__gpucacheAdviseTieredColumns(gc_dbuf);
+		__gpucacheMirrorSummary(gc_dbuf);
 		if (extra)
 		{
 			pg_atomic_write_u64(&gc_sstate->gcache_extra_usage, extra->usage);
@@ -3678,16 +7230,18 @@ bailout:
 	if (m_gcache_redo != 0UL)
 		cuMemFree(m_gcache_redo);
 	if (status)
-		__gpucacheMarkAsCorrupted(gc_lmap);
+		__gpucacheMarkAsCorrupted(gc_dbuf);
 	return status;
 }
 
 static int
 __gpucacheExecApplyRedo(GpuCacheControlCommand *cmd,
+						int cuda_dindex,
 						CUfunction f_gcache_apply_redo,
 						CUfunction f_gcache_compaction)
 {
 	GpuCacheLocalMapping *gc_lmap;
+	GpuCacheDeviceBuffer *gc_dbuf;
 	int		status = 0;
 
 	gc_lmap = getGpuCacheLocalMappingIfExist(cmd->ident.database_oid,
@@ -3703,23 +7257,24 @@ __gpucacheExecApplyRedo(GpuCacheControlCommand *cmd,
 				 cmd->ident.signature);
 		return EEXIST;
 	}
+	gc_dbuf = gpuCacheLookupDeviceBuffer(gc_lmap, cuda_dindex);
 
-	pthreadRWLockWriteLock(&gc_lmap->gcache_rwlock);
-	if (gc_lmap->gcache_main_devptr == 0UL)
+	pthreadRWLockWriteLock(&gc_dbuf->gcache_rwlock);
+	if (gc_dbuf->gcache_main_devptr == 0UL)
 	{
-		status = __gpucacheAllocDeviceMemory(gc_lmap,
+		status = __gpucacheAllocDeviceMemory(gc_dbuf,
 											 cmd->errbuf,
 											 sizeof(cmd->errbuf));
 		if (status)
 			goto bailout;
 	}
-	status = __gpucacheExecApplyRedoKernel(cmd, gc_lmap,
+	status = __gpucacheExecApplyRedoKernel(cmd, gc_dbuf,
 										   f_gcache_apply_redo,
 										   f_gcache_compaction);
 bailout:
 	if (status)
-		__gpucacheMarkAsCorrupted(gc_lmap);
-	pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+		__gpucacheMarkAsCorrupted(gc_dbuf);
+	pthreadRWLockUnlock(&gc_dbuf->gcache_rwlock);
 	putGpuCacheLocalMapping(gc_lmap);
 	return status;
 }
@@ -3752,6 +7307,196 @@ __gpucacheExecDropUnload(GpuCacheControlCommand *cmd)
 	return 0;
 }
 
+/*
+ * __gpucacheWriteSnapshot
+ *
+ * It writes out the primary device buffers and the rowid-map of the idle
+ * GpuCache. The snapshot is discarded if any REDO-log or rowid-map updates
+ * happen during the write; it is not consistent anyway.
+ */
+static void
+__gpucacheWriteSnapshot(GpuCacheLocalMapping *gc_lmap)
+{
+	GpuCacheSharedState *gc_sstate = gc_lmap->gc_sstate;
+	GpuCacheDeviceBuffer *gc_dbuf = &gc_lmap->gc_dbuf[0];
+	GpuCacheSnapshotHeader h;
+	kern_data_store *kds;
+	kern_data_extra *extra;
+	char		path[MAXPGPATH];
+	char		tpath[MAXPGPATH];
+	uint64_t	write_pos;
+	uint64_t	rowid_map_version;
+	int			fdesc = -1;
+	int			dirfd;
+	bool		is_valid;
+
+	GpuCacheSnapshotFileName(path, MAXPGPATH,
+							 gc_sstate->ident.database_oid,
+							 gc_sstate->ident.table_oid,
+							 gc_sstate->ident.signature, "");
+	GpuCacheSnapshotFileName(tpath, MAXPGPATH,
+							 gc_sstate->ident.database_oid,
+							 gc_sstate->ident.table_oid,
+							 gc_sstate->ident.signature, ".tmp");
+	pthreadRWLockReadLock(&gc_dbuf->gcache_rwlock);
+	kds = (kern_data_store *)gc_dbuf->gcache_main_devptr;
+	extra = (kern_data_extra *)gc_dbuf->gcache_extra_devptr;
+	if (!kds)
+		goto out_unlock;
+
+	memset(&h, 0, sizeof(GpuCacheSnapshotHeader));
+	pthreadMutexLock(&gc_sstate->rowid_mutex);
+	pthreadMutexLock(&gc_sstate->redo_mutex);
+	gc_sstate->snapshot_timestamp = GetCurrentTimestamp();
+	write_pos = gc_sstate->redo_write_pos;
+	is_valid = (gc_sstate->snapshot_valid == 0 &&
+				gc_sstate->replica_read_pos[0] == write_pos);
+	pthreadMutexUnlock(&gc_sstate->redo_mutex);
+	rowid_map_version = gc_sstate->rowid_map_version;
+	h.rowid_next_free = gc_sstate->rowid_next_free;
+	h.rowid_num_free  = gc_sstate->rowid_num_free;
+	pthreadMutexUnlock(&gc_sstate->rowid_mutex);
+	if (!is_valid)
+		goto out_unlock;
+
+	/*
+	 * Rows of in-progress transactions must not be saved, because their
+	 * COMMIT/ABORT logs may be written without removal of the snapshot.
+	 */
+	{
+		kern_colmeta *cmeta = &kds->colmeta[kds->nr_colmeta - 1];
+		GpuCacheSysattr *sysattr = (GpuCacheSysattr *)
+			((char *)kds + __kds_unpack(cmeta->values_offset));
+
+		for (uint32_t i=0; i < kds->nitems; i++)
+		{
+			if ((sysattr[i].xmin != InvalidTransactionId &&
+				 sysattr[i].xmin != FrozenTransactionId) ||
+				(sysattr[i].xmax != InvalidTransactionId &&
+				 sysattr[i].xmax != FrozenTransactionId))
+				goto out_unlock;
+		}
+	}
+	memcpy(h.magic, "GCSNAP02", 8);
+	h.system_identifier = GetSystemIdentifier();
+	memcpy(&h.ident, &gc_sstate->ident, sizeof(GpuCacheIdent));
+	h.rowid_map_sz = (sizeof(uint32_t) * gc_sstate->gc_options.rowid_hash_nslots +
+					  sizeof(GpuCacheRowIdItem) * gc_sstate->gc_options.max_num_rows);
+	h.main_sz = gc_dbuf->gcache_main_size;
+	h.extra_length = (extra ? extra->length : 0);
+	h.extra_usage  = (extra ? extra->usage : 0);
+
+	fdesc = open(tpath, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fdesc < 0)
+	{
+		fprintf(stderr, "gpucache: failed on open('%s'): %m\n", tpath);
+		goto out_unlock;
+	}
+	if (__pwriteFile(fdesc, &h, sizeof(h), 0) != sizeof(h) ||
+		__pwriteFile(fdesc, gpuCacheRowIdHashSlot(gc_sstate), h.rowid_map_sz,
+					 GpuCacheSnapshotRowIdMapOffset(&h)) != h.rowid_map_sz ||
+		__pwriteFile(fdesc, kds, h.main_sz,
+					 GpuCacheSnapshotMainOffset(&h)) != h.main_sz ||
+		(h.extra_usage > 0 &&
+		 __pwriteFile(fdesc, extra, h.extra_usage,
+					  GpuCacheSnapshotExtraOffset(&h)) != h.extra_usage) ||
+		fsync(fdesc) != 0)
+	{
+		fprintf(stderr, "gpucache: failed on write('%s'): %m\n", tpath);
+		goto out_unlink;
+	}
+	close(fdesc);
+	fdesc = -1;
+
+	/* install the snapshot, if GpuCache is not modified during the write */
+	pthreadMutexLock(&gc_sstate->rowid_mutex);
+	pthreadMutexLock(&gc_sstate->redo_mutex);
+	if (gc_sstate->redo_write_pos == write_pos &&
+		gc_sstate->rowid_map_version == rowid_map_version &&
+		gc_sstate->snapshot_valid == 0 &&
+		rename(tpath, path) == 0)
+	{
+		gc_sstate->snapshot_valid = ++gc_sstate->snapshot_generation;
+		if (gc_sstate->snapshot_valid == UINT_MAX)
+			gc_sstate->snapshot_valid = gc_sstate->snapshot_generation = 1;
+		is_valid = true;
+	}
+	else
+	{
+		is_valid = false;
+	}
+	pthreadMutexUnlock(&gc_sstate->redo_mutex);
+	pthreadMutexUnlock(&gc_sstate->rowid_mutex);
+	if (is_valid)
+	{
+		dirfd = open(pgstrom_gpucache_snapshot_dir, O_RDONLY);
+		if (dirfd >= 0)
+		{
+			fsync(dirfd);
+			close(dirfd);
+		}
+		fprintf(stderr, "gpucache: snapshot of '%s' was written (nitems=%u)\n",
+				gc_sstate->table_name, kds->nitems);
+		goto out_unlock;
+	}
+out_unlink:
+	if (fdesc >= 0)
+		close(fdesc);
+	unlink(tpath);
+out_unlock:
+	pthreadRWLockUnlock(&gc_dbuf->gcache_rwlock);
+}
+
+/*
+ * __gpucacheManagerMaintenance
+ *
+ * It writes out the snapshot of a GpuCache on this device, if it is idle
+ * for more than pg_strom.gpucache_snapshot_interval.
+ */
+static void
+__gpucacheManagerMaintenance(int cuda_dindex)
+{
+	GpuCacheLocalMapping *gc_lmap = NULL;
+	uint64_t	threshold;
+
+	if (!pgstrom_gpucache_snapshot_dir ||
+		pgstrom_gpucache_snapshot_interval <= 0)
+		return;
+	threshold = GetCurrentTimestamp() -
+		(uint64_t)pgstrom_gpucache_snapshot_interval * USECS_PER_SEC;
+
+	pthreadMutexLock(&gcache_shared_mapping_lock);
+	for (int i=0; !gc_lmap && i < GCACHE_SHARED_MAPPING_NSLOTS; i++)
+	{
+		dlist_iter	iter;
+
+		dlist_foreach(iter, &gcache_shared_mapping_slot[i])
+		{
+			GpuCacheLocalMapping *__gc_lmap
+				= dlist_container(GpuCacheLocalMapping, chain, iter.cur);
+			GpuCacheSharedState *gc_sstate = __gc_lmap->gc_sstate;
+
+			if (gc_sstate->gc_options.cuda_dindex == cuda_dindex &&
+				pg_atomic_read_u32(&gc_sstate->phase) == GCACHE_PHASE__IS_READY &&
+				gc_sstate->snapshot_valid == 0 &&
+				gc_sstate->redo_write_timestamp < threshold &&
+				gc_sstate->snapshot_timestamp < threshold)
+			{
+				__gc_lmap->refcnt += 2;
+				gc_lmap = __gc_lmap;
+				break;
+			}
+		}
+	}
+	pthreadMutexUnlock(&gcache_shared_mapping_lock);
+
+	if (gc_lmap)
+	{
+		__gpucacheWriteSnapshot(gc_lmap);
+		putGpuCacheLocalMapping(gc_lmap);
+	}
+}
+
 /*
  * gpucacheManagerEventLoop
  */
@@ -3794,7 +7539,10 @@ gpucacheManagerEventLoop(int cuda_dindex,
 		{
 			if (!pthreadCondWaitTimeout(cmd_cond, cmd_mutex, 5000L))
 			{
-				/* timeout -> add some maintenance work here*/
+				/* timeout -> maintenance work */
+				pthreadMutexUnlock(cmd_mutex);
+				__gpucacheManagerMaintenance(cuda_dindex);
+				pthreadMutexLock(cmd_mutex);
 			}
 			continue;
 		}
@@ -3809,11 +7557,14 @@ gpucacheManagerEventLoop(int cuda_dindex,
 		{
 			case GCACHE_CONTROL_CMD__APPLY_REDO:
 				status = __gpucacheExecApplyRedo(cmd,
+												 cuda_dindex,
 												 f_gcache_apply_redo,
 												 f_gcache_compaction);
 				break;
 			case GCACHE_CONTROL_CMD__COMPACTION:
-				status = __gpucacheExecCompaction(cmd, f_gcache_compaction);
+				status = __gpucacheExecCompaction(cmd,
+												  cuda_dindex,
+												  f_gcache_compaction);
 				break;
 			case GCACHE_CONTROL_CMD__DROP_UNLOAD:
 				status = __gpucacheExecDropUnload(cmd);
@@ -3870,14 +7621,19 @@ gpucacheManagerWakeUp(int cuda_dindex)
 
 /*
  * gpuCacheGetDeviceBuffer
+ *
+ * It returns the replica of GpuCache on the supplied GPU, or the primary
+ * one if no replica is built on the device.
  */
 void *
 gpuCacheGetDeviceBuffer(const GpuCacheIdent *ident,
+						int cuda_dindex,
 						CUdeviceptr *p_gcache_main_devptr,
 						CUdeviceptr *p_gcache_extra_devptr,
 						char *errbuf, size_t errbuf_sz)
 {
 	GpuCacheLocalMapping *gc_lmap;
+	GpuCacheDeviceBuffer *gc_dbuf;
 	bool		has_exclusive = false;
 
 	gc_lmap = getGpuCacheLocalMappingIfExist(ident->database_oid,
@@ -3886,40 +7642,44 @@ gpuCacheGetDeviceBuffer(const GpuCacheIdent *ident,
 											 false);
 	if (!gc_lmap)
 		return NULL;
-	pthreadRWLockReadLock(&gc_lmap->gcache_rwlock);
+	gc_dbuf = gpuCacheLookupDeviceBuffer(gc_lmap, cuda_dindex);
+	pthreadRWLockReadLock(&gc_dbuf->gcache_rwlock);
 retry:
-	if (gc_lmap->gcache_main_devptr == 0UL)
+	if (gc_dbuf->gcache_main_devptr == 0UL)
 	{
 		if (!has_exclusive)
 		{
-			pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+			pthreadRWLockUnlock(&gc_dbuf->gcache_rwlock);
 			has_exclusive = true;
-			pthreadRWLockWriteLock(&gc_lmap->gcache_rwlock);
+			pthreadRWLockWriteLock(&gc_dbuf->gcache_rwlock);
 			goto retry;
 		}
-		if (__gpucacheAllocDeviceMemory(gc_lmap,
+		if (__gpucacheAllocDeviceMemory(gc_dbuf,
 										errbuf, errbuf_sz) != 0)
 		{
-			pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+			pthreadRWLockUnlock(&gc_dbuf->gcache_rwlock);
 			putGpuCacheLocalMapping(gc_lmap);
 			return NULL;
 		}
 	}
 	/* ok, valid result */
-	*p_gcache_main_devptr  = gc_lmap->gcache_main_devptr;
-	*p_gcache_extra_devptr = gc_lmap->gcache_extra_devptr;
-	return gc_lmap;
+	*p_gcache_main_devptr  = gc_dbuf->gcache_main_devptr;
+	*p_gcache_extra_devptr = gc_dbuf->gcache_extra_devptr;
+	pg_atomic_fetch_add_u32(&gc_lmap->gc_sstate->replica_nscans[gc_dbuf->replica], 1);
+	return gc_dbuf;
 }
 
 /*
  * gpuCachePutDeviceBuffer
  */
 void
-gpuCachePutDeviceBuffer(void *__gc_lmap)
+gpuCachePutDeviceBuffer(void *__gc_dbuf)
 {
-	GpuCacheLocalMapping *gc_lmap = (GpuCacheLocalMapping *)__gc_lmap;
+	GpuCacheDeviceBuffer *gc_dbuf = (GpuCacheDeviceBuffer *)__gc_dbuf;
+	GpuCacheLocalMapping *gc_lmap = gc_dbuf->gc_lmap;
 
-	pthreadRWLockUnlock(&gc_lmap->gcache_rwlock);
+	pg_atomic_fetch_sub_u32(&gc_lmap->gc_sstate->replica_nscans[gc_dbuf->replica], 1);
+	pthreadRWLockUnlock(&gc_dbuf->gcache_rwlock);
 	putGpuCacheLocalMapping(gc_lmap);
 }
 
@@ -4306,8 +8066,8 @@ pgstrom_gpucache_info(PG_FUNCTION_ARGS)
 	GpuCacheSharedState *gc_sstate;
 	FuncCallContext *fncxt;
 	List	   *info_list;
-	Datum		values[20];
-	bool		isnull[20];
+	Datum		values[23];
+	bool		isnull[23];
 	HeapTuple	tuple;
 	uint32_t	phase;
 	char	   *str;
@@ -4319,7 +8079,7 @@ pgstrom_gpucache_info(PG_FUNCTION_ARGS)
 
 		fncxt = SRF_FIRSTCALL_INIT();
 		oldcxt = MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
-		tupdesc = CreateTemplateTupleDesc(20);
+		tupdesc = CreateTemplateTupleDesc(23);
 		TupleDescInitEntry(tupdesc,  1, "database_oid",
 						   OIDOID, -1, 0);
 		TupleDescInitEntry(tupdesc,  2, "database_name",
@@ -4360,6 +8120,12 @@ pgstrom_gpucache_info(PG_FUNCTION_ARGS)
 						   INT8OID, -1, 0);
 		TupleDescInitEntry(tupdesc, 20, "config_options",
 						   TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, 21, "compaction_pos",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 22, "compaction_nitems",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 23, "compaction_count",
+						   INT8OID, -1, 0);
 		fncxt->tuple_desc = BlessTupleDesc(tupdesc);
 		fncxt->user_fctx = __pgstrom_gpucache_info();
 
@@ -4417,18 +8183,25 @@ pgstrom_gpucache_info(PG_FUNCTION_ARGS)
 					   "max_num_rows=%ld,"
 					   "redo_buffer_size=%zu,"
 					   "gpu_sync_interval=%d,"
-					   "gpu_sync_threshold=%zu",
+					   "gpu_sync_threshold=%zu,"
+					   "gpu_replicas=%d,"
+					   "compression=%s",
 					   gpuDevAttrs[gc_sstate->gc_options.cuda_dindex].DEV_ID,
 					   gc_sstate->gc_options.max_num_rows,
 					   gc_sstate->gc_options.redo_buffer_size,
 					   gc_sstate->gc_options.gpu_sync_interval,
-					   gc_sstate->gc_options.gpu_sync_threshold);
+					   gc_sstate->gc_options.gpu_sync_threshold,
+					   gc_sstate->gc_options.num_replicas,
+					   gc_sstate->gc_options.compression ? "on" : "off");
 		values[19] = CStringGetTextDatum(str);
 	}
 	else
 	{
 		isnull[19] = true;
 	}
+	values[20] = Int64GetDatum(pg_atomic_read_u64(&gc_sstate->gcache_compaction_pos));
+	values[21] = Int64GetDatum(pg_atomic_read_u64(&gc_sstate->gcache_compaction_nitems));
+	values[22] = Int64GetDatum(pg_atomic_read_u64(&gc_sstate->gcache_compaction_count));
 	tuple = heap_form_tuple(fncxt->tuple_desc, values, isnull);
 	SRF_RETURN_NEXT(fncxt, HeapTupleGetDatum(tuple));
 }
@@ -4500,6 +8273,7 @@ pgstrom_startup_gpu_cache(void)
 		elog(ERROR, "Bug? GpuCacheSharedHead already exists");
 	memset(gcache_shared_head, 0, sz);
 	pthreadMutexInitShared(&gcache_shared_head->gcache_sstate_mutex);
+	gcache_shared_head->gcache_wal_lock_tranche = LWLockNewTrancheId();
 	pthreadMutexInitShared(&gcache_shared_head->gcache_cmd_mutex);
 	dlist_init(&gcache_shared_head->gcache_free_cmds);
 	for (int i=0; i < lengthof(gcache_shared_head->__gcache_control_cmds); i++)
@@ -4543,6 +8317,37 @@ pgstrom_init_gpu_cache(void)
 							 PGC_USERSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* GUC: pg_strom.gpucache_snapshot_dir */
+	DefineCustomStringVariable("pg_strom.gpucache_snapshot_dir",
+							   "directory to save GpuCache snapshot for warm restart",
+							   NULL,
+							   &pgstrom_gpucache_snapshot_dir,
+							   NULL,
+							   PGC_POSTMASTER,
+							   GUC_NOT_IN_SAMPLE,
+							   NULL, NULL, NULL);
+	/* GUC: pg_strom.gpucache_snapshot_interval */
+	DefineCustomIntVariable("pg_strom.gpucache_snapshot_interval",
+							"idle time of GpuCache prior to write out its snapshot",
+							NULL,
+							&pgstrom_gpucache_snapshot_interval,
+							60,
+							0,
+							INT_MAX,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_S,
+							NULL, NULL, NULL);
+	/* GUC: pg_strom.gpucache_initial_load_workers */
+	DefineCustomIntVariable("pg_strom.gpucache_initial_load_workers",
+							"number of parallel workers for the initial loading of GpuCache",
+							NULL,
+							&pgstrom_gpucache_initial_load_workers,
+							4,
+							0,
+							MAX_PARALLEL_WORKER_LIMIT,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
 	/* setup local hash tables */
 	memset(&hctl, 0, sizeof(HASHCTL));
 	hctl.keysize = offsetof(GpuCacheDesc, xid) + sizeof(TransactionId);
@@ -11,6 +11,7 @@
  */
 #include "pg_strom.h"
 #include "cuda_common.h"
+#include <netdb.h>
 
 /* variable declarations */
 GpuDevAttributes *gpuDevAttrs = NULL;
@@ -21,6 +22,31 @@ double			pgstrom_gpu_operator_cost;		/* GUC */
 double			pgstrom_gpu_direct_seq_page_cost; /* GUC */
 static bool		pgstrom_gpudirect_enabled;			/* GUC */
 static int		__pgstrom_gpudirect_threshold_kb;	/* GUC */
+static int		pgstrom_gpu_staging_ring_nslots;	/* GUC */
+static char	   *pgstrom_gpu_device_set = NULL;		/* GUC */
+static int64_t	pgstrom_gpu_device_set_mask = 0;	/* 0 = all the GPUs */
+static char	   *pgstrom_gpu_endpoint_list = NULL;	/* GUC */
+
+/* remote GPU service endpoints; by pg_strom.gpu_endpoint_list */
+#define GPU_REMOTE_ENDPOINT_MAX_NITEMS		64
+#define GPU_REMOTE_ENDPOINT_RETRY_INTERVAL	30		/* sec */
+typedef struct
+{
+	char		config_host[NI_MAXHOST];
+	char		config_port[NI_MAXSERV];
+	int			endpoint_domain;
+	socklen_t	endpoint_addr_len;
+	struct sockaddr_storage endpoint_addr;
+} GpuRemoteEndpoint;
+
+typedef struct
+{
+	int			nitems;
+	GpuRemoteEndpoint entries[FLEXIBLE_ARRAY_MEMBER];
+} GpuRemoteEndpointArray;
+
+static GpuRemoteEndpointArray *gpu_remote_endpoints = NULL;
+static time_t	gpu_remote_endpoint_failed[GPU_REMOTE_ENDPOINT_MAX_NITEMS];
 #define pgstrom_gpudirect_threshold		((size_t)__pgstrom_gpudirect_threshold_kb << 10)
 
 
@@ -75,7 +101,7 @@ sysfs_read_line(const char *path)
 		}
 	}
 	close(fdesc);
-	buffer[sz] = '\0';
+	buffer[off] = '\0';
 	pos = strchr(buffer, '\n');
 	if (pos)
 		*pos = '\0';
@@ -645,6 +671,8 @@ GetOptimalGpuForBaseRel(PlannerInfo *root, RelOptInfo *baserel)
 			return GetOptimalGpusForArrowFdw(root, baserel);
 		return NULL;
 	}
+	if (baseRelIsFileFdw(baserel))
+		return NULL;	/* rows are loaded by the host */
 	total_sz = (size_t)baserel->pages * (size_t)BLCKSZ;
 	if (total_sz < pgstrom_gpudirect_threshold)
 		return NULL;	/* table is too small */
@@ -777,11 +805,27 @@ pgstrom_print_gpu_properties(const char *manual_config)
 					char   *uuid = __fetchJsonFieldText(gpu, "uuid");
 					char   *pcie = __fetchJsonFieldText(gpu, "pcie");
 
-					elog(LOG, "[%s] GPU%s (%s; %s)",
+					int		numa_node = -1;
+					const char *cpulist = NULL;
+
+					if (dindex && atoi(dindex) >= 0 && atoi(dindex) < numGpuDevAttrs)
+						numa_node = gpuDevAttrs[atoi(dindex)].NUMA_NODE_ID;
+					if (numa_node >= 0)
+					{
+						char	path[MAXPGPATH];
+
+						snprintf(path, sizeof(path),
+								 "/sys/devices/system/node/node%d/cpulist",
+								 numa_node);
+						cpulist = sysfs_read_line(path);
+					}
+					elog(LOG, "[%s] GPU%s (%s; %s) NUMA node %s (CPUs: %s)",
 						 pcie ? pcie : "????:??:??.?",
 						 dindex ? dindex : "??",
 						 name ? name : "unknown GPU",
-						 uuid ? uuid : "unknown UUID");
+						 uuid ? uuid : "unknown UUID",
+						 numa_node >= 0 ? psprintf("%d", numa_node) : "unknown",
+						 cpulist ? cpulist : "???");
 				}
 			}
 
@@ -839,6 +883,172 @@ pgstrom_print_gpu_properties(const char *manual_config)
 	}
 }
 
+/*
+ * pg_strom.gpu_device_set
+ *
+ * config := <token>[,<token> ...]
+ * token  := (<device index>|gpu<device index>|<device UUID>)
+ *
+ * It restricts the GPU devices to be used by the session, e.g, to isolate
+ * the tenants by ALTER ROLE ... SET pg_strom.gpu_device_set = 'gpu1'.
+ * UUID is the identifier of the device reported by pgstrom.gpu_device_info,
+ * so MIG instance is also available if visible by pg_strom.cuda_visible_devices.
+ */
+static bool
+check_gpu_device_set(char **newval, void **extra, GucSource source)
+{
+	char	   *config;
+	char	   *tok, *pos;
+	int64_t		mask = 0;
+
+	if (*newval && numGpuDevAttrs > 0)
+	{
+		config = alloca(strlen(*newval) + 1);
+		strcpy(config, *newval);
+		for (tok = strtok_r(config, ",", &pos);
+			 tok != NULL;
+			 tok = strtok_r(NULL, ",", &pos))
+		{
+			char	   *end;
+			long		dindex = -1;
+
+			tok = __trim(tok);
+			if (*tok == '\0')
+				continue;
+			if (strncasecmp(tok, "gpu", 3) == 0 && isdigit(tok[3]))
+				dindex = strtol(tok+3, &end, 10);
+			else if (isdigit(*tok))
+				dindex = strtol(tok, &end, 10);
+			else
+			{
+				for (int i=0; i < numGpuDevAttrs; i++)
+				{
+					if (strcasecmp(tok, gpuDevAttrs[i].DEV_UUID) == 0)
+					{
+						dindex = i;
+						break;
+					}
+				}
+				end = "";
+			}
+			if (dindex < 0 || dindex >= numGpuDevAttrs || *end != '\0')
+			{
+				GUC_check_errdetail("\"%s\" is not a valid GPU device", tok);
+				return false;
+			}
+			mask |= (1UL << dindex);
+		}
+	}
+	*extra = guc_malloc(ERROR, sizeof(int64_t));
+	*((int64_t *)*extra) = mask;
+	return true;
+}
+
+static void
+assign_gpu_device_set(const char *newval, void *extra)
+{
+	pgstrom_gpu_device_set_mask = *((int64_t *)extra);
+}
+
+/*
+ * check_gpu_endpoint_list
+ *
+ * config := <token>[,<token> ...]
+ * token  := <host>[:<port>]
+ *
+ * Each token is a TCP listen socket of the remote GPU service, opened at
+ * pg_strom.gpuserv_remote_listen_port + device index of the GPU server.
+ */
+static bool
+check_gpu_endpoint_list(char **newval, void **extra, GucSource source)
+{
+	GpuRemoteEndpointArray *ep_array;
+	char	   *config;
+	char	   *tok, *pos;
+	int			nitems = 0;
+
+	ep_array = guc_malloc(LOG, offsetof(GpuRemoteEndpointArray,
+										entries[GPU_REMOTE_ENDPOINT_MAX_NITEMS]));
+	if (!ep_array)
+		return false;
+	if (*newval)
+	{
+		config = alloca(strlen(*newval) + 1);
+		strcpy(config, *newval);
+		for (tok = strtok_r(config, ",", &pos);
+			 tok != NULL;
+			 tok = strtok_r(NULL, ",", &pos))
+		{
+			GpuRemoteEndpoint *curr;
+			struct addrinfo hints, *addr;
+			char	   *host, *port;
+			int			rv;
+
+			tok = __trim(tok);
+			if (*tok == '\0')
+				continue;
+			if (nitems >= GPU_REMOTE_ENDPOINT_MAX_NITEMS)
+			{
+				GUC_check_errdetail("too many endpoints (up to %d)",
+									GPU_REMOTE_ENDPOINT_MAX_NITEMS);
+				free(ep_array);
+				return false;
+			}
+			host = tok;
+			port = strrchr(host, ':');
+			if (!port || port[1] == '\0')
+			{
+				GUC_check_errdetail("\"%s\" has no port number", tok);
+				free(ep_array);
+				return false;
+			}
+			*port++ = '\0';
+
+			memset(&hints, 0, sizeof(struct addrinfo));
+			hints.ai_family = AF_UNSPEC;
+			hints.ai_socktype = SOCK_STREAM;
+			rv = getaddrinfo(host, port, &hints, &addr);
+			if (rv != 0)
+			{
+				GUC_check_errdetail("failed on getaddrinfo('%s','%s'): %s",
+									host, port, gai_strerror(rv));
+				free(ep_array);
+				return false;
+			}
+			curr = &ep_array->entries[nitems++];
+			memset(curr, 0, sizeof(GpuRemoteEndpoint));
+			strncpy(curr->config_host, host, NI_MAXHOST-1);
+			strncpy(curr->config_port, port, NI_MAXSERV-1);
+			curr->endpoint_domain = addr->ai_family;
+			curr->endpoint_addr_len = addr->ai_addrlen;
+			memcpy(&curr->endpoint_addr, addr->ai_addr, addr->ai_addrlen);
+			freeaddrinfo(addr);
+		}
+	}
+	ep_array->nitems = nitems;
+	*extra = ep_array;
+	return true;
+}
+
+static void
+assign_gpu_endpoint_list(const char *newval, void *extra)
+{
+	GpuRemoteEndpointArray *ep_array = extra;
+
+	gpu_remote_endpoints = (ep_array->nitems > 0 ? ep_array : NULL);
+	memset(gpu_remote_endpoint_failed, 0, sizeof(gpu_remote_endpoint_failed));
+}
+
+/*
+ * gpuClientDeviceIsAllowed
+ */
+bool
+gpuClientDeviceIsAllowed(int cuda_dindex)
+{
+	return (pgstrom_gpu_device_set_mask == 0 ||
+			(pgstrom_gpu_device_set_mask & (1UL << cuda_dindex)) != 0);
+}
+
 /*
  * pgstrom_init_gpu_options - init GUC options related to GPUs
  */
@@ -911,6 +1121,39 @@ pgstrom_init_gpu_options(void)
 							PGC_SUSET,
 							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
 							NULL, NULL, NULL);
+	/* number of pinned host buffers to stage the chunks */
+	DefineCustomIntVariable("pg_strom.gpu_staging_ring_nslots",
+							"number of pinned host buffers shared with GPU service to stage the chunks (0 = disabled)",
+							NULL,
+							&pgstrom_gpu_staging_ring_nslots,
+							0,
+							0,
+							64,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	/* GPU devices available for the session */
+	DefineCustomStringVariable("pg_strom.gpu_device_set",
+							   "GPU devices available for the session (empty = all)",
+							   NULL,
+							   &pgstrom_gpu_device_set,
+							   NULL,
+							   PGC_SUSET,
+							   GUC_NOT_IN_SAMPLE,
+							   check_gpu_device_set,
+							   assign_gpu_device_set,
+							   NULL);
+	/* GPU service on the remote GPU servers */
+	DefineCustomStringVariable("pg_strom.gpu_endpoint_list",
+							   "List of the remote GPU service endpoints (host:port,...)",
+							   NULL,
+							   &pgstrom_gpu_endpoint_list,
+							   NULL,
+							   PGC_SUSET,
+							   GUC_NOT_IN_SAMPLE,
+							   check_gpu_endpoint_list,
+							   assign_gpu_endpoint_list,
+							   NULL);
 }
 
 /*
@@ -986,7 +1229,19 @@ __gpuClientChooseDevice(const Bitmapset *gpuset)
 
 	if (!rr_initialized)
 	{
-		rr_counter = (uint32)getpid();
+		/*
+		 * Only the seed of the round-robin choice; the parallel workers start
+		 * from the GPUs next to the leader's first choice, instead of
+		 * the arbitrary choice by their own PIDs. It makes the first sessions
+		 * of the leader and the workers less likely to share one GPU, but
+		 * each backend still sends all of its chunks to the GPU it has
+		 * opened the session with, regardless of the drive (or RAID stripe)
+		 * the chunks are stored on.
+		 */
+		if (IsParallelWorker())
+			rr_counter = (uint32)ParallelLeaderPid + ParallelWorkerNumber + 1;
+		else
+			rr_counter = (uint32)getpid();
 		rr_initialized = true;
 	}
 
@@ -998,24 +1253,37 @@ __gpuClientChooseDevice(const Bitmapset *gpuset)
 
 		for (i=0, k=bms_next_member(gpuset, -1);
 			 k >= 0;
-			 i++, k=bms_next_member(gpuset, k))
+			 k=bms_next_member(gpuset, k))
+		{
+			if (gpuClientDeviceIsAllowed(k))
+				dindex[i++] = k;
+		}
+		if (i > 0)
+			return dindex[rr_counter++ % i];
+		/* no optimal GPUs are allowed, so choose one of the allowed ones */
+	}
+	if (pgstrom_gpu_device_set_mask != 0)
+	{
+		int		num = __builtin_popcountl(pgstrom_gpu_device_set_mask);
+		int		nth = rr_counter++ % num;
+
+		for (int k=0; k < numGpuDevAttrs; k++)
 		{
-			dindex[i] = k;
+			if ((pgstrom_gpu_device_set_mask & (1UL << k)) != 0 && nth-- == 0)
+				return k;
 		}
-		Assert(i == num);
-		return dindex[rr_counter++ % num];
 	}
 	/* a simple round-robin if no GPUs preference */
 	return (rr_counter++ % numGpuDevAttrs);
 }
 
 void
-gpuClientOpenSession(pgstromTaskState *pts,
-					 const XpuCommand *session)
+gpuClientOpenSessionOnDevice(pgstromTaskState *pts,
+							 const XpuCommand *session,
+							 int cuda_dindex)
 {
 	struct sockaddr_un addr;
 	pgsocket	sockfd;
-	int			cuda_dindex = __gpuClientChooseDevice(pts->optimal_gpus);
 	char		namebuf[32];
 
 	sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
@@ -1037,6 +1305,314 @@ gpuClientOpenSession(pgstromTaskState *pts,
 	__xpuClientOpenSession(pts, session, sockfd, namebuf, cuda_dindex);
 }
 
+/*
+ * __gpuClientChooseFixedDevice
+ *
+ * It chooses the first allowed GPU in the gpuset, so all the parallel workers
+ * of the plan node choose the same one.
+ */
+static int
+__gpuClientChooseFixedDevice(const Bitmapset *gpuset)
+{
+	int		k;
+
+	for (k = bms_next_member(gpuset, -1); k >= 0; k = bms_next_member(gpuset, k))
+	{
+		if (gpuClientDeviceIsAllowed(k))
+			return k;
+	}
+	for (k=0; k < numGpuDevAttrs; k++)
+	{
+		if (gpuClientDeviceIsAllowed(k))
+			return k;
+	}
+	return 0;
+}
+
+/*
+ * __gpuClientRemoteSessionIsEligible
+ *
+ * The remote GPU service can run the session only if all the inputs are
+ * delivered by the commands, or Arrow files on the storage shared with
+ * the GPU server. Inner buffer of GpuJoin (DSM segment), the staging ring,
+ * GpuCache and GPU-Direct SQL on the heap files are local resources.
+ * kds_final shared by parallel workers needs a particular GPU also.
+ */
+static bool
+__gpuClientRemoteSessionIsEligible(pgstromTaskState *pts,
+								   const XpuCommand *session)
+{
+	const kern_session_info *kses = &session->u.session;
+	uint32_t	xpucode_offsets[] = {
+		kses->xpucode_load_vars_packed,
+		kses->xpucode_move_vars_packed,
+		kses->xpucode_scan_quals,
+		kses->xpucode_join_quals_packed,
+		kses->xpucode_hash_values_packed,
+		kses->xpucode_hash_inner_packed,
+		kses->xpucode_gist_evals_packed,
+		kses->xpucode_range_keys_packed,
+		kses->xpucode_projection,
+		kses->xpucode_groupby_keyhash,
+		kses->xpucode_groupby_keyload,
+		kses->xpucode_groupby_keycomp,
+		kses->xpucode_groupby_actions,
+	};
+
+	if (!gpu_remote_endpoints ||
+		!pgstrom_gpuserv_remote_secret ||
+		*pgstrom_gpuserv_remote_secret == '\0')
+		return false;
+	if (kses->join_inner_handle != 0 ||
+		kses->staging_ring_handle != 0 ||
+		pts->num_rels > 0 ||
+		pts->gcache_desc != NULL)
+		return false;
+	if (pts->pp_info->groupby_final_on_device &&
+		pts->css.ss.ps.plan->parallel_aware)
+		return false;
+	/* some device functions are not available on the remote GPU service */
+	for (int i=0; i < lengthof(xpucode_offsets); i++)
+	{
+		if (xpucode_offsets[i] != 0 &&
+			!gpuservRemoteKexpIsSupported((const kern_expression *)
+										  ((const char *)kses + xpucode_offsets[i])))
+			return false;
+	}
+	return (pts->cb_next_chunk == pgstromScanChunkArrowFdw ||
+			pts->cb_next_chunk == pgstromScanChunkFileFdw ||
+			pts->cb_next_chunk == pgstromRelScanChunkNormal);
+}
+
+/*
+ * __gpuClientRemoteAuthenticate
+ *
+ * It returns the digest of the nonce sent by the remote GPU service, by
+ * pg_strom.gpuserv_remote_secret, then waits for the ack.
+ */
+static bool
+__gpuClientRemoteAuthenticate(pgsocket sockfd)
+{
+	uint8_t		nonce[GPUSERV_REMOTE_AUTH_NONCE_LEN];
+	uint8_t		digest[GPUSERV_REMOTE_AUTH_DIGEST_LEN];
+	uint8_t		ack;
+	struct timeval tv;
+	size_t		nbytes = 0;
+
+	tv.tv_sec = GPUSERV_REMOTE_AUTH_TIMEOUT;
+	tv.tv_usec = 0;
+	if (setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0)
+		return false;
+	while (nbytes < sizeof(nonce))
+	{
+		ssize_t		nread = recv(sockfd, nonce + nbytes,
+								 sizeof(nonce) - nbytes, 0);
+		if (nread < 0 && errno == EINTR)
+			continue;
+		if (nread <= 0)
+			return false;
+		nbytes += nread;
+	}
+	if (!gpuservRemoteAuthDigest(nonce, digest) ||
+		send(sockfd, digest, sizeof(digest), MSG_NOSIGNAL) != sizeof(digest))
+		return false;
+	/* GPU service closes the connection without ack, on wrong digest */
+	if (recv(sockfd, &ack, sizeof(ack), MSG_WAITALL) != sizeof(ack) || ack != 1)
+		return false;
+	memset(&tv, 0, sizeof(tv));
+	if (setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0)
+		return false;
+	return true;
+}
+
+/*
+ * gpuClientOpenRemoteSession
+ *
+ * It connects to one of the remote GPU service endpoints in round-robin.
+ * An endpoint which refused the connection is skipped for a while, and it
+ * returns false if no endpoints are alive, to run the session locally.
+ */
+static bool
+gpuClientOpenRemoteSession(pgstromTaskState *pts,
+						   const XpuCommand *session)
+{
+	static uint32_t	rr_counter = 0;
+	int			nitems = gpu_remote_endpoints->nitems;
+	time_t		now = time(NULL);
+	char		namebuf[32];
+
+	for (int loop=0; loop < nitems; loop++)
+	{
+		int			k = (rr_counter++ % nitems);
+		GpuRemoteEndpoint *ep = &gpu_remote_endpoints->entries[k];
+		pgsocket	sockfd;
+
+		if (gpu_remote_endpoint_failed[k] != 0 &&
+			now - gpu_remote_endpoint_failed[k] < GPU_REMOTE_ENDPOINT_RETRY_INTERVAL)
+			continue;
+		sockfd = socket(ep->endpoint_domain, SOCK_STREAM, 0);
+		if (sockfd < 0)
+			elog(ERROR, "failed on socket(2) dom=%d: %m",
+				 ep->endpoint_domain);
+		if (connect(sockfd,
+					(struct sockaddr *)&ep->endpoint_addr,
+					ep->endpoint_addr_len) != 0)
+		{
+			elog(LOG, "RGPU-%d: failed on connect('%s:%s'): %m, skipped for %ds",
+				 k, ep->config_host, ep->config_port,
+				 GPU_REMOTE_ENDPOINT_RETRY_INTERVAL);
+			close(sockfd);
+			gpu_remote_endpoint_failed[k] = Max(now, 1);
+			continue;
+		}
+		if (!__gpuClientRemoteAuthenticate(sockfd))
+		{
+			elog(LOG, "RGPU-%d: failed on authentication at '%s:%s', skipped for %ds",
+				 k, ep->config_host, ep->config_port,
+				 GPU_REMOTE_ENDPOINT_RETRY_INTERVAL);
+			close(sockfd);
+			gpu_remote_endpoint_failed[k] = Max(now, 1);
+			continue;
+		}
+		gpu_remote_endpoint_failed[k] = 0;
+		snprintf(namebuf, sizeof(namebuf), "RGPU-%d", k);
+		__xpuClientOpenSession(pts, session, sockfd, namebuf, k);
+		return true;
+	}
+	return false;
+}
+
+void
+gpuClientOpenSession(pgstromTaskState *pts,
+					 const XpuCommand *session)
+{
+	int			cuda_dindex;
+
+	/* remote GPU service, if the session is self-contained */
+	if (__gpuClientRemoteSessionIsEligible(pts, session) &&
+		gpuClientOpenRemoteSession(pts, session))
+		return;
+	/* cached inner buffer is only available on the GPU that keeps it */
+	if (pts->inner_cache_handle != 0)
+		cuda_dindex = pts->inner_cache_dindex;
+	/* parallel workers share a kds_final for the unique groups */
+	else if (pts->pp_info->groupby_final_on_device &&
+			 pts->css.ss.ps.plan->parallel_aware)
+		cuda_dindex = __gpuClientChooseFixedDevice(pts->optimal_gpus);
+	else
+		cuda_dindex = __gpuClientChooseDevice(pts->optimal_gpus);
+	gpuClientOpenSessionOnDevice(pts, session, cuda_dindex);
+}
+
+/*
+ * gpuClientSetupStagingRing
+ *
+ * It creates a shared memory segment with pg_strom.gpu_staging_ring_nslots
+ * slots; GPU service maps and pins it on OpenSession. It returns the shmem
+ * handle to be delivered by the session info, or 0 if not available.
+ */
+uint32_t
+gpuClientSetupStagingRing(pgstromTaskState *pts)
+{
+	int			nslots = pgstrom_gpu_staging_ring_nslots;
+	xpuStagingRing *ring;
+	uint32_t	handle;
+
+	gpuClientReleaseStagingRing(pts);
+	/* GpuCache does not send the chunks */
+	if (nslots == 0 ||
+		(pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0 ||
+		pts->gcache_desc != NULL)
+		return 0;
+
+	handle = __shmemCreate(NULL);
+	ring = __mmapShmem(handle, XPU_STAGING_RING_LENGTH(nslots), NULL);
+	memset(ring, 0, XPU_STAGING_RING_HEADSZ(nslots));
+	ring->nslots = nslots;
+	ring->slot_sz = XPU_STAGING_RING_SLOTSZ;
+	for (int i=0; i < nslots; i++)
+		pg_atomic_init_u32(&ring->slot_busy[i], 0);
+	pts->staging_ring = ring;
+	pts->staging_ring_handle = handle;
+
+	return handle;
+}
+
+/*
+ * gpuClientReleaseStagingRing
+ */
+void
+gpuClientReleaseStagingRing(pgstromTaskState *pts)
+{
+	if (pts->staging_ring)
+	{
+		__munmapShmem(pts->staging_ring);
+		pts->staging_ring = NULL;
+	}
+	if (pts->staging_ring_handle != 0)
+	{
+		__shmemDrop(pts->staging_ring_handle);
+		pts->staging_ring_handle = 0;
+	}
+}
+
+/*
+ * gpuClientStageXpuCommand
+ *
+ * It moves the XpuTaskExec command on a free slot of the staging ring, then
+ * replaces the iovec by a small XpuTaskExecStaged command. If no free slots,
+ * the command is sent over the socket as usual.
+ */
+bool
+gpuClientStageXpuCommand(pgstromTaskState *pts,
+						 struct iovec *xcmd_iov,
+						 int *xcmd_iovcnt)
+{
+	static XpuCommand staged;
+	xpuStagingRing *ring = pts->staging_ring;
+	XpuCommand *xcmd = (XpuCommand *)xcmd_iov[0].iov_base;
+	char	   *pos;
+	int			slot_id = -1;
+
+	if (!ring ||
+		xcmd->tag != XpuCommandTag__XpuTaskExec ||
+		xcmd->length > ring->slot_sz)
+		return false;
+	for (int i=0; i < ring->nslots; i++)
+	{
+		uint32_t	expected = 0;
+
+		if (pg_atomic_compare_exchange_u32(&ring->slot_busy[i],
+										   &expected, 1))
+		{
+			slot_id = i;
+			break;
+		}
+	}
+	if (slot_id < 0)
+		return false;
+
+	pos = (char *)XPU_STAGING_RING_SLOT(ring, slot_id);
+	for (int i=0; i < *xcmd_iovcnt; i++)
+	{
+		memcpy(pos, xcmd_iov[i].iov_base, xcmd_iov[i].iov_len);
+		pos += xcmd_iov[i].iov_len;
+	}
+	Assert(pos - (char *)XPU_STAGING_RING_SLOT(ring, slot_id) == xcmd->length);
+
+	memset(&staged, 0, offsetof(XpuCommand, u.staged));
+	staged.magic = XpuCommandMagicNumber;
+	staged.tag = XpuCommandTag__XpuTaskExecStaged;
+	staged.length = offsetof(XpuCommand, u.staged) + sizeof(kern_staged_task);
+	staged.u.staged.slot_id = slot_id;
+
+	xcmd_iov[0].iov_base = &staged;
+	xcmd_iov[0].iov_len  = staged.length;
+	*xcmd_iovcnt = 1;
+
+	return true;
+}
+
 /*
  * optimal_workgroup_size - calculates the optimal block size
  * according to the function and device attributes
@@ -11,6 +11,7 @@
  */
 #include "pg_strom.h"
 #include "cuda_common.h"
+#include "utils/snapmgr.h"
 
 
 /* static variables */
@@ -22,7 +23,14 @@ static CustomExecMethods	gpujoin_exec_methods;
 static bool					pgstrom_enable_gpujoin = false;		/* GUC */
 static bool					pgstrom_enable_gpuhashjoin = false;	/* GUC */
 static bool					pgstrom_enable_gpugistindex = false;/* GUC */
+static bool					pgstrom_enable_gpuspatialjoin = false;/* GUC */
 static bool					pgstrom_enable_partitionwise_gpujoin = false;
+bool						pgstrom_gpujoin_multi_gpu_inner = false;	/* GUC */
+static int					pgstrom_gpujoin_inner_buffer_limit = 0;		/* GUC */
+int							pgstrom_gpujoin_inner_cache_size = 0;		/* GUC */
+static int					pgstrom_gpujoin_device_hash_build_threshold = 0;	/* GUC */
+static int					pgstrom_gpujoin_heavy_hitter_threshold = 0;	/* GUC */
+static bool					pgstrom_enable_gpujoin_right_outer = false;	/* GUC */
 
 static CustomPathMethods	dpujoin_path_methods;
 static CustomScanMethods	dpujoin_plan_methods;
@@ -33,6 +41,18 @@ static bool					pgstrom_enable_dpugistindex = false;/* GUC */
 static bool					pgstrom_enable_partitionwise_dpujoin = false;
 
 static bool					pgstrom_debug_xpujoinpath = false;
+static bool					pgstrom_enable_xpujoin_bloom_filter = false; /* GUC */
+static bool					pgstrom_enable_xpujoin_dynamic_filter = false; /* GUC */
+static bool					pgstrom_enable_gpujoin_hash_bucket = false;	/* GUC */
+static bool					pgstrom_enable_gpujoin_direct_map = false;	/* GUC */
+static bool					pgstrom_enable_gpujoin_range_index = false;	/* GUC */
+static bool					pgstrom_enable_gpujoin_inet_index = false;	/* GUC */
+
+/*
+ * Bloom filter is pushed down to the outer scan only if the hash-join
+ * (without bloom filter) is expected to drop more than half of the rows.
+ */
+#define XPUJOIN_BLOOM_FILTER_SELECTIVITY	0.5
 
 /*
  * DEBUG_XpuJoinPath
@@ -133,6 +153,213 @@ try_fetch_xpujoin_planinfo(const Path *path)
 	return NULL;
 }
 
+/*
+ * __rangeJoinKeyKind - category of the range-join key type
+ */
+static char
+__rangeJoinKeyKind(Oid type_oid)
+{
+	switch (type_oid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+			return 'i';		/* integers are comparable each other */
+		case DATEOID:
+			return 'd';
+		case TIMESTAMPOID:
+			return 't';
+		case TIMESTAMPTZOID:
+			return 'z';
+		default:
+			break;
+	}
+	return '\0';
+}
+
+/*
+ * __tryBuildRangeJoinKeys
+ *
+ * It picks up the range clauses in the form of (inner_key OP outer_expr)
+ * from the join quals of the nested-loop, then returns the list of them.
+ * Inner rows are sorted by the inner key on the preloading, so GPU kernel
+ * walks on only the inner rows between the lower and upper bounds for each
+ * outer row. The range clauses are still evaluated as a part of the join
+ * quals, so '<' and '>' are handled as '<=' and '>=' here.
+ */
+static List *
+__tryBuildRangeJoinKeys(PlannerInfo *root,
+						RelOptInfo *outer_rel,
+						RelOptInfo *inner_rel,
+						List *join_quals,
+						pgstromPlanInnerInfo *pp_inner)
+{
+	Expr	   *inner_key = NULL;
+	Expr	   *outer_lower = NULL;
+	Expr	   *outer_upper = NULL;
+	List	   *range_quals = NIL;
+	ListCell   *lc;
+
+	foreach (lc, join_quals)
+	{
+		OpExpr	   *op = lfirst(lc);
+		Expr	   *arg1;
+		Expr	   *arg2;
+		Relids		relids1;
+		Relids		relids2;
+		Oid			opclass;
+		int			strategy;
+		bool		inner_is_left;
+
+		if (!IsA(op, OpExpr) || list_length(op->args) != 2)
+			continue;
+		arg1 = linitial(op->args);
+		arg2 = lsecond(op->args);
+		if (__rangeJoinKeyKind(exprType((Node *)arg1)) == '\0' ||
+			__rangeJoinKeyKind(exprType((Node *)arg1)) !=
+			__rangeJoinKeyKind(exprType((Node *)arg2)) ||
+			contain_volatile_functions((Node *)op))
+			continue;
+		relids1 = pull_varnos(root, (Node *)arg1);
+		relids2 = pull_varnos(root, (Node *)arg2);
+		if (!bms_is_empty(relids1) && bms_is_subset(relids1, inner_rel->relids) &&
+			!bms_is_empty(relids2) && bms_is_subset(relids2, outer_rel->relids))
+			inner_is_left = true;
+		else if (!bms_is_empty(relids1) && bms_is_subset(relids1, outer_rel->relids) &&
+				 !bms_is_empty(relids2) && bms_is_subset(relids2, inner_rel->relids))
+			inner_is_left = false;
+		else
+			continue;
+		/* operator must be the btree ordering of the inner key type */
+		opclass = GetDefaultOpClass(exprType(inner_is_left ? (Node *)arg1
+															: (Node *)arg2),
+									BTREE_AM_OID);
+		if (!OidIsValid(opclass))
+			continue;
+		strategy = get_op_opfamily_strategy(op->opno,
+											get_opclass_family(opclass));
+		if (!inner_is_left)
+		{
+			/* commute (outer OP inner) to (inner OP' outer) */
+			if (strategy == BTLessStrategyNumber)
+				strategy = BTGreaterStrategyNumber;
+			else if (strategy == BTLessEqualStrategyNumber)
+				strategy = BTGreaterEqualStrategyNumber;
+			else if (strategy == BTGreaterStrategyNumber)
+				strategy = BTLessStrategyNumber;
+			else if (strategy == BTGreaterEqualStrategyNumber)
+				strategy = BTLessEqualStrategyNumber;
+			else
+				continue;
+		}
+		/* all the range clauses must have an identical inner key */
+		if (!inner_key)
+			inner_key = (inner_is_left ? arg1 : arg2);
+		else if (!equal(inner_key, inner_is_left ? arg1 : arg2))
+			continue;
+
+		if ((strategy == BTLessStrategyNumber ||
+			 strategy == BTLessEqualStrategyNumber) && !outer_upper)
+			outer_upper = (inner_is_left ? arg2 : arg1);
+		else if ((strategy == BTGreaterStrategyNumber ||
+				  strategy == BTGreaterEqualStrategyNumber) && !outer_lower)
+			outer_lower = (inner_is_left ? arg2 : arg1);
+		else
+			continue;
+		range_quals = lappend(range_quals, op);
+	}
+
+	if (range_quals != NIL)
+	{
+		pp_inner->range_inner_key   = inner_key;
+		pp_inner->range_outer_lower = outer_lower;
+		pp_inner->range_outer_upper = outer_upper;
+	}
+	return range_quals;
+}
+
+/*
+ * __tryBuildInetJoinKeys
+ *
+ * It picks up the containment clauses in the form of (inner_key >>= outer)
+ * or (outer <<= inner_key), including the strict ones, from the join quals
+ * of the nested-loop, then returns the list of them. Inner rows are sorted
+ * by the network prefix on the preloading, so GPU kernel walks on only the
+ * inner prefixes that contain the outer network (longest one first).
+ * The clauses are still evaluated as a part of the join quals, so strict
+ * operators are handled as non-strict ones here.
+ */
+static List *
+__tryBuildInetJoinKeys(PlannerInfo *root,
+					   RelOptInfo *outer_rel,
+					   RelOptInfo *inner_rel,
+					   List *join_quals,
+					   pgstromPlanInnerInfo *pp_inner)
+{
+	Expr	   *inner_key = NULL;
+	Expr	   *outer_key = NULL;
+	List	   *inet_quals = NIL;
+	ListCell   *lc;
+
+	foreach (lc, join_quals)
+	{
+		OpExpr	   *op = lfirst(lc);
+		Expr	   *arg1;
+		Expr	   *arg2;
+		Oid			type1;
+		Oid			type2;
+		Relids		relids1;
+		Relids		relids2;
+		bool		inner_is_left;
+
+		if (!IsA(op, OpExpr) || list_length(op->args) != 2)
+			continue;
+		arg1 = linitial(op->args);
+		arg2 = lsecond(op->args);
+		type1 = exprType((Node *)arg1);
+		type2 = exprType((Node *)arg2);
+		if ((type1 != INETOID && type1 != CIDROID) ||
+			(type2 != INETOID && type2 != CIDROID) ||
+			contain_volatile_functions((Node *)op))
+			continue;
+		switch (get_opcode(op->opno))
+		{
+			case F_NETWORK_SUP:
+			case F_NETWORK_SUPEQ:
+				inner_is_left = true;	/* inner >>= outer */
+				break;
+			case F_NETWORK_SUB:
+			case F_NETWORK_SUBEQ:
+				inner_is_left = false;	/* outer <<= inner */
+				break;
+			default:
+				continue;
+		}
+		relids1 = pull_varnos(root, (Node *)arg1);
+		relids2 = pull_varnos(root, (Node *)arg2);
+		if (inner_is_left
+			? (bms_is_empty(relids1) || !bms_is_subset(relids1, inner_rel->relids) ||
+			   bms_is_empty(relids2) || !bms_is_subset(relids2, outer_rel->relids))
+			: (bms_is_empty(relids1) || !bms_is_subset(relids1, outer_rel->relids) ||
+			   bms_is_empty(relids2) || !bms_is_subset(relids2, inner_rel->relids)))
+			continue;
+		/* only one containment clause is used for the index */
+		if (inner_key)
+			continue;
+		inner_key = (inner_is_left ? arg1 : arg2);
+		outer_key = (inner_is_left ? arg2 : arg1);
+		inet_quals = lappend(inet_quals, op);
+	}
+
+	if (inet_quals != NIL)
+	{
+		pp_inner->range_inner_key   = inner_key;
+		pp_inner->range_outer_lower = outer_key;
+		pp_inner->range_outer_upper = NULL;
+	}
+	return inet_quals;
+}
+
 /*
  * __buildXpuJoinPlanInfo
  */
@@ -161,6 +388,7 @@ __buildXpuJoinPlanInfo(PlannerInfo *root,
 	Cost			comp_cost = 0.0;
 	bool			enable_xpuhashjoin;
 	bool			enable_xpugistindex;
+	bool			enable_xpuspatialjoin;
 	double			xpu_tuple_cost;
 	Cost			xpu_ratio;
 	QualCost		join_quals_cost;
@@ -169,6 +397,7 @@ __buildXpuJoinPlanInfo(PlannerInfo *root,
 	List		   *hash_outer_keys = NIL;
 	List		   *hash_inner_keys = NIL;
 	List		   *inner_target_list = NIL;
+	List		   *range_quals = NIL;
 	ListCell	   *lc;
 	bool			clauses_are_immutable = true;
 
@@ -183,6 +412,7 @@ __buildXpuJoinPlanInfo(PlannerInfo *root,
 	{
 		enable_xpuhashjoin  = pgstrom_enable_gpuhashjoin;
 		enable_xpugistindex = pgstrom_enable_gpugistindex;
+		enable_xpuspatialjoin = pgstrom_enable_gpuspatialjoin;
 		xpu_tuple_cost      = pgstrom_gpu_tuple_cost;
 		xpu_ratio           = pgstrom_gpu_operator_ratio();
 	}
@@ -190,6 +420,7 @@ __buildXpuJoinPlanInfo(PlannerInfo *root,
 	{
 		enable_xpuhashjoin  = pgstrom_enable_dpuhashjoin;
 		enable_xpugistindex = pgstrom_enable_dpugistindex;
+		enable_xpuspatialjoin = false;	/* not supported on DPU */
 		xpu_tuple_cost      = pgstrom_dpu_tuple_cost;
 		xpu_ratio           = pgstrom_dpu_operator_ratio();
 	}
@@ -198,6 +429,10 @@ __buildXpuJoinPlanInfo(PlannerInfo *root,
 		elog(ERROR, "Bug? unexpected xpu_task_flags: %08x",
 			 pp_prev->xpu_task_flags);
 	}
+	/* calibrated by the runtime statistics, if any */
+	pgstromCostCalibLookup(pp_prev->xpu_task_flags & DEVKIND__ANY,
+						   pgstromCostCalibSpcId(root, pp_prev->scan_relid),
+						   NULL, NULL, &xpu_tuple_cost);
 
 	/* setup inner_target_list */
 	foreach (lc, inner_paths_list)
@@ -329,6 +564,8 @@ __buildXpuJoinPlanInfo(PlannerInfo *root,
 	pp_inner->other_quals = other_quals;
 	/* GiST-Index availability checks */
 	if (enable_xpugistindex &&
+		join_type != JOIN_SEMI &&
+		join_type != JOIN_ANTI &&
 		hash_outer_keys == NIL &&
 		hash_inner_keys == NIL)
 	{
@@ -344,6 +581,55 @@ __buildXpuJoinPlanInfo(PlannerInfo *root,
 		if (gist_inner_path)
 			llast(inner_paths_list) = gist_inner_path;
 	}
+	/* Spatial-Join by R-tree built on the fly, if no GiST-Index */
+	if (enable_xpuspatialjoin &&
+		join_type != JOIN_SEMI &&
+		join_type != JOIN_ANTI &&
+		hash_outer_keys == NIL &&
+		hash_inner_keys == NIL &&
+		!OidIsValid(pp_inner->gist_index_oid))
+	{
+		pgstromTryBuildSpatialIndex(root,
+									llast(inner_paths_list),
+									restrict_clauses,
+									pp_prev->xpu_task_flags,
+									pp_prev->scan_relid,
+									inner_target_list,
+									pp_inner);
+	}
+	/* Range-Join on the sorted inner rows, if neither hash nor GiST */
+	if ((pp_prev->xpu_task_flags & DEVKIND__ANY) == DEVKIND__NVIDIA_GPU &&
+		pgstrom_enable_gpujoin_range_index &&
+		hash_outer_keys == NIL &&
+		hash_inner_keys == NIL &&
+		pp_inner->gist_clause == NULL)
+	{
+		range_quals = __tryBuildRangeJoinKeys(root,
+											  outer_rel,
+											  inner_rel,
+											  join_quals,
+											  pp_inner);
+	}
+	/* Inet-Join on the sorted network prefixes, if neither hash nor GiST */
+	if ((pp_prev->xpu_task_flags & DEVKIND__ANY) == DEVKIND__NVIDIA_GPU &&
+		pgstrom_enable_gpujoin_inet_index &&
+		hash_outer_keys == NIL &&
+		hash_inner_keys == NIL &&
+		pp_inner->gist_clause == NULL &&
+		range_quals == NIL)
+	{
+		range_quals = __tryBuildInetJoinKeys(root,
+											 outer_rel,
+											 inner_rel,
+											 join_quals,
+											 pp_inner);
+	}
+	/* prepared geometry for st_contains() in the GiST/Spatial-Join */
+	if (pp_inner->gist_clause != NULL &&
+		(pp_prev->xpu_task_flags & DEVKIND__ANY) == DEVKIND__NVIDIA_GPU)
+	{
+		pgstromTryPrepareGeometry(llast(inner_target_list), pp_inner);
+	}
 
 	/*
 	 * Cost estimation
@@ -397,10 +683,10 @@ __buildXpuJoinPlanInfo(PlannerInfo *root,
 		/* cost to evaluate join qualifiers */
 		comp_cost += join_quals_cost.per_tuple * xpu_ratio * outer_nrows;
 	}
-	else if (OidIsValid(pp_inner->gist_index_oid))
+	else if (pp_inner->gist_clause != NULL)
 	{
 		/*
-		 * GpuNestLoop+GiST-Index
+		 * GpuNestLoop+GiST-Index (or R-tree built on the fly)
 		 */
 		Expr	   *gist_clause = pp_inner->gist_clause;
 		double		gist_selectivity = pp_inner->gist_selectivity;
@@ -409,7 +695,14 @@ __buildXpuJoinPlanInfo(PlannerInfo *root,
 		/* cost to preload inner heap tuples by CPU */
 		startup_cost += cpu_tuple_cost * inner_path->rows;
 		/* cost to preload the entire index pages once */
-		startup_cost += seq_page_cost * pp_inner->gist_npages;
+		if (OidIsValid(pp_inner->gist_index_oid))
+			startup_cost += seq_page_cost * pp_inner->gist_npages;
+		else
+		{
+			/* cost to build the R-tree by CPU (sort by STR) */
+			startup_cost += (cpu_operator_cost * 4.0 * inner_path->rows *
+							 log2(Max(inner_path->rows, 2.0)));
+		}
 		/* cost to evaluate GiST index by GPU */
 		cost_qual_eval_node(&gist_clause_cost, (Node *)gist_clause, root);
 		comp_cost += gist_clause_cost.per_tuple * xpu_ratio * outer_nrows;
@@ -419,6 +712,32 @@ __buildXpuJoinPlanInfo(PlannerInfo *root,
 					  gist_selectivity *
 					  inner_path->rows);
 	}
+	else if (range_quals != NIL)
+	{
+		/*
+		 * GpuNestLoop+Range - It evaluates join-qual for each pair of outer
+		 * and inner tuples between the lower and upper bounds only.
+		 */
+		Selectivity	range_selectivity
+			= clauselist_selectivity(root,
+									 range_quals,
+									 0,
+									 JOIN_INNER,
+									 NULL);
+		double		inner_rows = Max(inner_path->rows, 2.0);
+
+		/* cost to preload and sort inner heap tuples by CPU */
+		startup_cost += (cpu_tuple_cost * inner_path->rows +
+						 cpu_operator_cost * inner_rows * log2(inner_rows));
+		/* cost to binary-search the lower bound by GPU */
+		comp_cost += (cpu_operator_cost * xpu_ratio *
+					  outer_nrows * log2(inner_rows));
+		/* cost to evaluate join qualifiers by GPU */
+		comp_cost += (join_quals_cost.per_tuple * xpu_ratio *
+					  outer_nrows *
+					  range_selectivity *
+					  inner_path->rows);
+	}
 	else
 	{
 		/*
@@ -988,13 +1307,20 @@ __xpuJoinAddCustomPathCommon(PlannerInfo *root,
 	List	   *inner_pathlist;
 	ListCell   *lc;
 
-	/* quick bailout if unsupported join type */
+	/*
+	 * quick bailout if unsupported join type
+	 *
+	 * EXISTS / NOT EXISTS sub-queries are pulled up to JOIN_SEMI / JOIN_ANTI
+	 * by the planner, then GPU runs them as a depth that emits the outer row
+	 * on the first match, or on no match. DPU does not support them yet.
+	 */
 	if (join_type != JOIN_INNER &&
 		join_type != JOIN_FULL &&
 		join_type != JOIN_RIGHT &&
-		join_type != JOIN_LEFT)
+		join_type != JOIN_LEFT &&
+		((join_type != JOIN_SEMI && join_type != JOIN_ANTI) ||
+		 (xpu_task_flags & DEVKIND__ANY) != DEVKIND__NVIDIA_GPU))
 		return;
-	//TODO: JOIN_SEMI and JOIN_ANTI
 
 	inner_pathlist = innerrel->pathlist;
 	for (int try_parallel=0; try_parallel < 2; try_parallel++)
@@ -1385,6 +1711,12 @@ build_explain_tlist_junks(codegen_context *context,
 										   context);
 		__build_explain_tlist_junks_walker((Node *)pp_inner->gist_clause,
 										   context);
+		__build_explain_tlist_junks_walker((Node *)pp_inner->range_inner_key,
+										   context);
+		__build_explain_tlist_junks_walker((Node *)pp_inner->range_outer_lower,
+										   context);
+		__build_explain_tlist_junks_walker((Node *)pp_inner->range_outer_upper,
+										   context);
 	}
 	__build_explain_tlist_junks_walker((Node *)vars_in_exprs, context);
 	
@@ -1417,6 +1749,150 @@ build_explain_tlist_junks(codegen_context *context,
 #endif
 }
 
+/*
+ * __pickup_bloom_filter_depths
+ *
+ * It picks up the INNER/SEMI hash-join depths whose outer hash-keys reference
+ * the outer relation only, and are expected to be selective. Bloom filter of
+ * the inner hash-keys can drop the outer rows that never match at the depth-0,
+ * prior to the MoveVars and the further JOIN.
+ */
+static List *
+__pickup_bloom_filter_depths(PlannerInfo *root, pgstromPlanInfo *pp_info)
+{
+	List	   *bloom_depths = NIL;
+	double		nrows = pp_info->scan_nrows;
+
+	if (!pgstrom_enable_xpujoin_bloom_filter)
+		return NIL;
+	for (int i=0; i < pp_info->num_rels; i++)
+	{
+		pgstromPlanInnerInfo *pp_inner = &pp_info->inners[i];
+
+		if ((pp_inner->join_type == JOIN_INNER ||
+			 pp_inner->join_type == JOIN_SEMI) &&
+			pp_inner->hash_outer_keys != NIL &&
+			pp_inner->hash_inner_keys != NIL &&
+			pp_inner->join_nrows < nrows * XPUJOIN_BLOOM_FILTER_SELECTIVITY &&
+			!contain_volatile_functions((Node *)pp_inner->hash_outer_keys))
+		{
+			Relids	relids = pull_varnos(root, (Node *)pp_inner->hash_outer_keys);
+			int		relid;
+
+			if (bms_get_singleton_member(relids, &relid) &&
+				relid == pp_info->scan_relid)
+			{
+				pp_inner->bloom_filter = true;
+				bloom_depths = lappend_int(bloom_depths, i+1);
+			}
+		}
+		/*
+		 * outer rows dropped by the bloom filter would turn the inner rows
+		 * of RIGHT/FULL OUTER JOIN unmatched.
+		 */
+		if (pp_inner->join_type == JOIN_RIGHT ||
+			pp_inner->join_type == JOIN_FULL)
+			break;
+		nrows = pp_inner->join_nrows;
+	}
+	return bloom_depths;
+}
+
+/*
+ * Dynamic filter support
+ *
+ * The min/max values of the inner hash-key are collected on the inner
+ * preloading, then delivered to the outer scan using a pair of PARAM_EXEC
+ * slots. BRIN-index and min/max statistics of arrow_fdw skip the block-ranges
+ * or record-batches that never match the inner rows, prior to any I/O.
+ * Only integer-comparable data types are supported.
+ */
+static inline bool
+__dynamicFilterTypeIsSupported(Oid type_oid)
+{
+	return (type_oid == INT2OID ||
+			type_oid == INT4OID ||
+			type_oid == INT8OID ||
+			type_oid == DATEOID ||
+			type_oid == TIMESTAMPOID ||
+			type_oid == TIMESTAMPTZOID);
+}
+
+static Param *
+__makeDynamicFilterParam(int param_id, Oid type_oid)
+{
+	Param	   *param = makeNode(Param);
+
+	param->paramkind = PARAM_EXEC;
+	param->paramid = param_id;
+	param->paramtype = type_oid;
+	param->paramtypmod = -1;
+	param->paramcollid = InvalidOid;
+	param->location = -1;
+
+	return param;
+}
+
+/*
+ * __pickup_dynamic_filter_depths
+ *
+ * It picks up the INNER/SEMI hash-join depths whose outer hash-key is a simple
+ * column reference of the outer relation, then reserves the PARAM_EXEC slots.
+ */
+static void
+__pickup_dynamic_filter_depths(PlannerInfo *root, pgstromPlanInfo *pp_info)
+{
+	PlannerGlobal  *glob = root->glob;
+
+	if (!pgstrom_enable_xpujoin_dynamic_filter)
+		return;
+	for (int i=0; i < pp_info->num_rels; i++)
+	{
+		pgstromPlanInnerInfo *pp_inner = &pp_info->inners[i];
+
+		if ((pp_inner->join_type == JOIN_INNER ||
+			 pp_inner->join_type == JOIN_SEMI) &&
+			pp_inner->hash_outer_keys != NIL &&
+			pp_inner->hash_inner_keys != NIL)
+		{
+			ListCell   *lc1, *lc2;
+			int			keynum = 1;
+
+			forboth (lc1, pp_inner->hash_outer_keys,
+					 lc2, pp_inner->hash_inner_keys)
+			{
+				Var	   *var = lfirst(lc1);
+				int		param_id;
+
+				if (IsA(var, Var) &&
+					var->varno == pp_info->scan_relid &&
+					var->varattno > 0 &&
+					var->varlevelsup == 0 &&
+					__dynamicFilterTypeIsSupported(var->vartype) &&
+					exprType((Node *)lfirst(lc2)) == var->vartype)
+				{
+					param_id = list_length(glob->paramExecTypes);
+					glob->paramExecTypes = lappend_oid(glob->paramExecTypes,
+													   var->vartype);
+					glob->paramExecTypes = lappend_oid(glob->paramExecTypes,
+													   var->vartype);
+					pp_inner->dfilter_keynum = keynum;
+					pp_inner->dfilter_param_id = param_id;
+					pgstromBrinIndexAddDynamicFilter(root, pp_info, var,
+						__makeDynamicFilterParam(param_id, var->vartype),
+						__makeDynamicFilterParam(param_id + 1, var->vartype));
+					break;
+				}
+				keynum++;
+			}
+		}
+		/* outer rows of RIGHT/FULL OUTER JOIN must not be dropped */
+		if (pp_inner->join_type == JOIN_RIGHT ||
+			pp_inner->join_type == JOIN_FULL)
+			break;
+	}
+}
+
 /*
  * PlanXpuJoinPathCommon
  */
@@ -1435,6 +1911,7 @@ PlanXpuJoinPathCommon(PlannerInfo *root,
 	List	   *join_quals_stacked = NIL;
 	List	   *other_quals_stacked = NIL;
 	List	   *hash_keys_stacked = NIL;
+	List	   *hash_inner_stacked = NIL;
 	List	   *gist_quals_stacked = NIL;
 
 	Assert(pp_info->num_rels == list_length(custom_plans));
@@ -1461,17 +1938,35 @@ PlanXpuJoinPathCommon(PlannerInfo *root,
 		if (pp_inner->hash_outer_keys != NIL &&
 			pp_inner->hash_inner_keys != NIL)
 		{
+			Plan   *i_plan = list_nth(custom_plans, i);
+
 			hash_keys_stacked = lappend(hash_keys_stacked,
 										pp_inner->hash_outer_keys);
 			pull_varattnos((Node *)pp_inner->hash_outer_keys,
 						   pp_info->scan_relid,
 						   &outer_refs);
+			/*
+			 * Large inner hash table shall be built on the GPU device;
+			 * host code only collects the inner rows, then GPU kernel
+			 * calculates the hash-values and links the hash-slots.
+			 */
+			if ((pp_info->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0 &&
+				pgstrom_gpujoin_device_hash_build_threshold > 0 &&
+				i_plan->plan_rows >= pgstrom_gpujoin_device_hash_build_threshold)
+			{
+				pp_inner->hash_build_on_device = true;
+				hash_inner_stacked = lappend(hash_inner_stacked,
+											 pp_inner->hash_inner_keys);
+			}
+			else
+				hash_inner_stacked = lappend(hash_inner_stacked, NIL);
 		}
 		else
 		{
 			Assert(pp_inner->hash_outer_keys == NIL &&
 				   pp_inner->hash_inner_keys == NIL);
 			hash_keys_stacked = lappend(hash_keys_stacked, NIL);
+			hash_inner_stacked = lappend(hash_inner_stacked, NIL);
 		}
 		
 		/* xpu code to evaluate join qualifiers */
@@ -1491,6 +1986,14 @@ PlanXpuJoinPathCommon(PlannerInfo *root,
 		pull_varattnos((Node *)pp_inner->gist_clause,
 					   pp_info->scan_relid,
 					   &outer_refs);
+
+		/* xpu code to evaluate the bounds of range-join */
+		pull_varattnos((Node *)pp_inner->range_outer_lower,
+					   pp_info->scan_relid,
+					   &outer_refs);
+		pull_varattnos((Node *)pp_inner->range_outer_upper,
+					   pp_info->scan_relid,
+					   &outer_refs);
 	}
 
 	/*
@@ -1508,7 +2011,11 @@ PlanXpuJoinPathCommon(PlannerInfo *root,
 	{
 		/* build device projection */
 		pgstrom_build_join_tlist_dev(context, root, joinrel, tlist);
+		if (pp_info->gpuwin_funcs != NIL)
+			pgstrom_build_window_tlist_dev(context, pp_info);
 		pp_info->kexp_projection = codegen_build_projection(context);
+		if (pp_info->gpuwin_funcs != NIL)
+			pgstrom_fixup_window_tlist_dev(context, pp_info);
 	}
 	pull_varattnos((Node *)context->tlist_dev,
 				   pp_info->scan_relid,
@@ -1523,7 +2030,15 @@ PlanXpuJoinPathCommon(PlannerInfo *root,
 	pp_info->kexp_hash_keys_packed
 		= codegen_build_packed_hashkeys(context,
 										hash_keys_stacked);
+	pp_info->kexp_hash_inner_packed
+		= codegen_build_packed_hashkeys(context,
+										hash_inner_stacked);
+	codegen_build_bloom_filters(context, pp_info,
+								__pickup_bloom_filter_depths(root, pp_info));
+	__pickup_dynamic_filter_depths(root, pp_info);
 	codegen_build_packed_gistevals(context, pp_info);
+	pp_info->kexp_range_keys_packed
+		= codegen_build_packed_rangekeys(context, pp_info);
 	/* LoadVars for each depth */
 	codegen_build_packed_kvars_load(context, pp_info);
 	/* MoveVars for each depth (only GPUs) */
@@ -1572,6 +2087,8 @@ PlanGpuJoinPath(PlannerInfo *root,
 								  custom_plans,
 								  pp_info,
 								  &gpujoin_plan_methods);
+	pgstrom_build_gpusort_topk(root, joinrel, cscan, pp_info);
+	pgstrom_build_scan_limit(root, joinrel, pp_info);
 	form_pgstrom_plan_info(cscan, pp_info);
 	return &cscan->scan.plan;
 }
@@ -1639,12 +2156,19 @@ typedef struct
 	uint32_t		nitems;
 	uint32_t		nrooms;
 	size_t			usage;
-	struct {
+	struct inner_preload_row {
 		HeapTuple	htup;
 		uint32_t	hash;		/* if hash-join or gist-join */
 	} rows[1];
 } inner_preload_buffer;
 
+/*
+ * hash-batch of the inner row; hash value is mixed again not to correlate
+ * with the hash-slot index (hash % nslots) in the inner KDS.
+ */
+#define INNER_BATCH_ID(hash,nbatches)	(murmurhash32(hash) % (nbatches))
+#define INNER_BATCH_MAX_NBATCHES		4096
+
 static uint32_t
 get_tuple_hashvalue(pgstromTaskState *pts,
 					pgstromTaskInnerState *istate,
@@ -1684,71 +2208,284 @@ get_tuple_hashvalue(pgstromTaskState *pts,
 }
 
 /*
- * execInnerPreloadOneDepth
+ * get_tuple_direct_key - the integer join key for kern_hash_direct
  */
-static void
-execInnerPreloadOneDepth(MemoryContext memcxt,
-						 pgstromTaskState *pts,
-						 pgstromTaskInnerState *istate,
-						 pg_atomic_uint64 *p_shared_inner_nitems,
-						 pg_atomic_uint64 *p_shared_inner_usage)
+static bool
+get_tuple_direct_key(pgstromTaskState *pts,
+					 pgstromTaskInnerState *istate,
+					 TupleTableSlot *inner_slot,
+					 int64_t *p_value)
 {
-	PlanState	   *ps = istate->ps;
-	MemoryContext	oldcxt;
-	inner_preload_buffer *preload_buf;
-
-	/* initial alloc of inner_preload_buffer */
-	preload_buf = MemoryContextAlloc(memcxt, offsetof(inner_preload_buffer,
-													  rows[12000]));
-	memset(preload_buf, 0, offsetof(inner_preload_buffer, rows));
-	preload_buf->nrooms = 12000;
+	ExprContext	   *econtext = pts->css.ss.ps.ps_ExprContext;
+	TupleTableSlot *scan_slot = pts->css.ss.ss_ScanTupleSlot;
+	ExprState	   *es = linitial(istate->hash_inner_keys);
+	Datum			datum;
+	bool			isnull;
+	ListCell	   *lc1, *lc2;
 
-	ExecStoreAllNullTuple(pts->css.ss.ss_ScanTupleSlot);
-	for (;;)
+	/* move to scan_slot from inner_slot */
+	forboth (lc1, istate->inner_load_src,
+			 lc2, istate->inner_load_dst)
 	{
-		TupleTableSlot *slot;
-		TupleDesc		tupdesc;
-		HeapTuple		htup;
-		uint32_t		index;
-
-		CHECK_FOR_INTERRUPTS();
+		int		src = lfirst_int(lc1) - 1;
+		int		dst = lfirst_int(lc2) - 1;
 
-		slot = ExecProcNode(ps);
-		if (TupIsNull(slot))
+		scan_slot->tts_isnull[dst] = inner_slot->tts_isnull[src];
+		scan_slot->tts_values[dst] = inner_slot->tts_values[src];
+	}
+	econtext->ecxt_scantuple = scan_slot;
+	datum = ExecEvalExpr(es, econtext, &isnull);
+	if (isnull)
+		return false;
+	switch (exprType((Node *)es->expr))
+	{
+		case INT2OID:
+			*p_value = DatumGetInt16(datum);
 			break;
+		case INT4OID:
+			*p_value = DatumGetInt32(datum);
+			break;
+		default:
+			*p_value = DatumGetInt64(datum);
+			break;
+	}
+	return true;
+}
 
-		/*
-		 * NOTE: If varlena datum is compressed / toasted, obviously,
-		 * GPU kernel cannot handle operators that reference these
-		 * values. Even though we cannot prevent this kind of datum
-		 * in OUTER side, we can fix up preloaded values on INNER-side.
-		 */
-		slot_getallattrs(slot);
-		tupdesc = slot->tts_tupleDescriptor;
-		for (int j=0; j < tupdesc->natts; j++)
-		{
-			Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
-
-			if (!slot->tts_isnull[j] && attr->attlen == -1)
-				slot->tts_values[j] = (Datum)PG_DETOAST_DATUM(slot->tts_values[j]);
-		}
-		oldcxt = MemoryContextSwitchTo(memcxt);
-		htup = heap_form_tuple(slot->tts_tupleDescriptor,
-							   slot->tts_values,
-							   slot->tts_isnull);
-		if (preload_buf->nitems >= preload_buf->nrooms)
-		{
-			uint32_t	nrooms_new = 2 * preload_buf->nrooms + 4000;
+/*
+ * __get_tuple_range_datum - the inner key of range-join or inet-join
+ */
+static Datum
+__get_tuple_range_datum(pgstromTaskState *pts,
+						pgstromTaskInnerState *istate,
+						TupleTableSlot *inner_slot,
+						bool *p_isnull)
+{
+	ExprContext	   *econtext = pts->css.ss.ps.ps_ExprContext;
+	TupleTableSlot *scan_slot = pts->css.ss.ss_ScanTupleSlot;
+	ListCell	   *lc1, *lc2;
 
-			preload_buf = repalloc_huge(preload_buf, offsetof(inner_preload_buffer,
-															  rows[nrooms_new]));
-			preload_buf->nrooms = nrooms_new;
-		}
-		index = preload_buf->nitems++;
+	/* move to scan_slot from inner_slot */
+	forboth (lc1, istate->inner_load_src,
+			 lc2, istate->inner_load_dst)
+	{
+		int		src = lfirst_int(lc1) - 1;
+		int		dst = lfirst_int(lc2) - 1;
 
-		if (istate->hash_inner_keys != NIL)
-		{
-			uint32_t	hash = get_tuple_hashvalue(pts, istate, slot);
+		scan_slot->tts_isnull[dst] = inner_slot->tts_isnull[src];
+		scan_slot->tts_values[dst] = inner_slot->tts_values[src];
+	}
+	econtext->ecxt_scantuple = scan_slot;
+	return ExecEvalExpr(istate->range_inner_key, econtext, p_isnull);
+}
+
+/*
+ * get_tuple_range_key - the inner key of range-join as int64
+ */
+static bool
+get_tuple_range_key(pgstromTaskState *pts,
+					pgstromTaskInnerState *istate,
+					TupleTableSlot *inner_slot,
+					int64_t *p_value)
+{
+	Datum		datum;
+	bool		isnull;
+
+	datum = __get_tuple_range_datum(pts, istate, inner_slot, &isnull);
+	if (isnull)
+		return false;
+	switch (exprType((Node *)istate->range_inner_key->expr))
+	{
+		case INT2OID:
+			*p_value = DatumGetInt16(datum);
+			break;
+		case INT4OID:
+			*p_value = DatumGetInt32(datum);
+			break;
+		case DATEOID:
+			*p_value = DatumGetDateADT(datum);
+			break;
+		default:	/* int8, timestamp and timestamptz */
+			*p_value = DatumGetInt64(datum);
+			break;
+	}
+	return true;
+}
+
+/*
+ * get_tuple_dfilter_key - the inner key of dynamic filter as int64
+ */
+static bool
+get_tuple_dfilter_key(pgstromTaskState *pts,
+					  pgstromTaskInnerState *istate,
+					  TupleTableSlot *inner_slot,
+					  int64_t *p_value)
+{
+	ExprContext	   *econtext = pts->css.ss.ps.ps_ExprContext;
+	TupleTableSlot *scan_slot = pts->css.ss.ss_ScanTupleSlot;
+	ExprState	   *es = istate->dfilter_inner_key;
+	Datum			datum;
+	bool			isnull;
+	ListCell	   *lc1, *lc2;
+
+	/* move to scan_slot from inner_slot */
+	forboth (lc1, istate->inner_load_src,
+			 lc2, istate->inner_load_dst)
+	{
+		int		src = lfirst_int(lc1) - 1;
+		int		dst = lfirst_int(lc2) - 1;
+
+		scan_slot->tts_isnull[dst] = inner_slot->tts_isnull[src];
+		scan_slot->tts_values[dst] = inner_slot->tts_values[src];
+	}
+	econtext->ecxt_scantuple = scan_slot;
+	datum = ExecEvalExpr(es, econtext, &isnull);
+	if (isnull)
+		return false;
+	switch (exprType((Node *)es->expr))
+	{
+		case INT2OID:
+			*p_value = DatumGetInt16(datum);
+			break;
+		case INT4OID:
+			*p_value = DatumGetInt32(datum);
+			break;
+		case DATEOID:
+			*p_value = DatumGetDateADT(datum);
+			break;
+		default:	/* int8, timestamp and timestamptz */
+			*p_value = DatumGetInt64(datum);
+			break;
+	}
+	return true;
+}
+
+/*
+ * __rangeJoinKeyIsInet - true, if the inner key is network of inet-join
+ */
+static inline bool
+__rangeJoinKeyIsInet(ExprState *es)
+{
+	Oid		type_oid = exprType((Node *)es->expr);
+
+	return (type_oid == INETOID || type_oid == CIDROID);
+}
+
+/*
+ * innerPreloadHashDirectIsAvailable
+ */
+static bool
+innerPreloadHashDirectIsAvailable(pgstromTaskState *pts,
+								  pgstromTaskInnerState *istate)
+{
+	ListCell   *lc;
+
+	if ((pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0 ||
+		!pgstrom_enable_gpujoin_direct_map ||
+		istate->hash_build_on_device ||
+		list_length(istate->hash_inner_keys) != 1 ||
+		list_length(istate->hash_outer_keys) != 1)
+		return false;
+	/* GPU kernel reads the outer key as int2/int4/int8 as well */
+	foreach (lc, list_make2(linitial(istate->hash_inner_keys),
+							linitial(istate->hash_outer_keys)))
+	{
+		ExprState  *es = lfirst(lc);
+		Oid			type_oid = exprType((Node *)es->expr);
+
+		if (type_oid != INT2OID &&
+			type_oid != INT4OID &&
+			type_oid != INT8OID)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * execInnerPreloadOneDepth
+ */
+static void
+execInnerPreloadOneDepth(MemoryContext memcxt,
+						 pgstromTaskState *pts,
+						 pgstromTaskInnerState *istate,
+						 pgstromSharedState *ps_state)
+{
+	pgstromSharedInnerState *ps_inner = &ps_state->inners[istate->depth-1];
+	PlanState	   *ps = istate->ps;
+	MemoryContext	oldcxt;
+	inner_preload_buffer *preload_buf;
+	uint64_t		dfilter_nitems = 0;
+	int64_t			dfilter_min = PG_INT64_MAX;
+	int64_t			dfilter_max = PG_INT64_MIN;
+
+	/* initial alloc of inner_preload_buffer */
+	preload_buf = MemoryContextAlloc(memcxt, offsetof(inner_preload_buffer,
+													  rows[12000]));
+	memset(preload_buf, 0, offsetof(inner_preload_buffer, rows));
+	preload_buf->nrooms = 12000;
+
+	ExecStoreAllNullTuple(pts->css.ss.ss_ScanTupleSlot);
+	for (;;)
+	{
+		TupleTableSlot *slot;
+		TupleDesc		tupdesc;
+		HeapTuple		htup;
+		uint32_t		index;
+
+		CHECK_FOR_INTERRUPTS();
+
+		slot = ExecProcNode(ps);
+		if (TupIsNull(slot))
+			break;
+
+		/*
+		 * NOTE: If varlena datum is compressed / toasted, obviously,
+		 * GPU kernel cannot handle operators that reference these
+		 * values. Even though we cannot prevent this kind of datum
+		 * in OUTER side, we can fix up preloaded values on INNER-side.
+		 */
+		slot_getallattrs(slot);
+		tupdesc = slot->tts_tupleDescriptor;
+		for (int j=0; j < tupdesc->natts; j++)
+		{
+			Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+
+			if (!slot->tts_isnull[j] && attr->attlen == -1)
+				slot->tts_values[j] = (Datum)PG_DETOAST_DATUM(slot->tts_values[j]);
+		}
+		/* min/max of the inner key for the dynamic filter */
+		if (istate->dfilter_inner_key)
+		{
+			int64_t		value;
+
+			if (get_tuple_dfilter_key(pts, istate, slot, &value))
+			{
+				dfilter_min = Min(dfilter_min, value);
+				dfilter_max = Max(dfilter_max, value);
+				dfilter_nitems++;
+			}
+		}
+		oldcxt = MemoryContextSwitchTo(memcxt);
+		htup = heap_form_tuple(slot->tts_tupleDescriptor,
+							   slot->tts_values,
+							   slot->tts_isnull);
+		if (preload_buf->nitems >= preload_buf->nrooms)
+		{
+			uint32_t	nrooms_new = 2 * preload_buf->nrooms + 4000;
+
+			preload_buf = repalloc_huge(preload_buf, offsetof(inner_preload_buffer,
+															  rows[nrooms_new]));
+			preload_buf->nrooms = nrooms_new;
+		}
+		index = preload_buf->nitems++;
+
+		if (istate->hash_inner_keys != NIL)
+		{
+			uint32_t	hash = 0;
+
+			/* GPU kernel calculates the hash-value later, if device build */
+			if (!istate->hash_build_on_device)
+				hash = get_tuple_hashvalue(pts, istate, slot);
 
 			preload_buf->rows[index].htup = htup;
 			preload_buf->rows[index].hash = hash;
@@ -1773,6 +2510,18 @@ execInnerPreloadOneDepth(MemoryContext memcxt,
 			preload_buf->usage += MAXALIGN(offsetof(kern_hashitem,
 													t.htup) + htup->t_len);
 		}
+		else if (istate->spatial_key)
+		{
+			/*
+			 * R-tree shall be built over the entire inner rows later, so
+			 * all the rows are linked to the hash-slot of zero; it allows
+			 * CPU fallback to walk on them as nested-loop.
+			 */
+			preload_buf->rows[index].htup = htup;
+			preload_buf->rows[index].hash = 0;
+			preload_buf->usage += MAXALIGN(offsetof(kern_hashitem,
+													t.htup) + htup->t_len);
+		}
 		else
 		{
 			preload_buf->rows[index].htup = htup;
@@ -1783,8 +2532,25 @@ execInnerPreloadOneDepth(MemoryContext memcxt,
 		MemoryContextSwitchTo(oldcxt);
 	}
 	istate->preload_buffer = preload_buf;
-	pg_atomic_fetch_add_u64(p_shared_inner_nitems, preload_buf->nitems);
-	pg_atomic_fetch_add_u64(p_shared_inner_usage,  preload_buf->usage);
+	pg_atomic_fetch_add_u64(&ps_inner->inner_nitems, preload_buf->nitems);
+	pg_atomic_fetch_add_u64(&ps_inner->inner_usage,  preload_buf->usage);
+	/* merge the min/max of the inner key by the concurrent workers */
+	if (dfilter_nitems > 0)
+	{
+		SpinLockAcquire(&ps_state->preload_mutex);
+		if (ps_inner->dfilter_nitems == 0)
+		{
+			ps_inner->dfilter_min = dfilter_min;
+			ps_inner->dfilter_max = dfilter_max;
+		}
+		else
+		{
+			ps_inner->dfilter_min = Min(ps_inner->dfilter_min, dfilter_min);
+			ps_inner->dfilter_max = Max(ps_inner->dfilter_max, dfilter_max);
+		}
+		ps_inner->dfilter_nitems += dfilter_nitems;
+		SpinLockRelease(&ps_state->preload_mutex);
+	}
 }
 
 /*
@@ -1834,248 +2600,2236 @@ innerPreloadSetupGiSTIndex(kern_data_store *kds_gist)
 }
 
 /*
- * innerPreloadAllocHostBuffer
+ * Routines to build the compact R-tree (kern_rtree_index)
  *
- * NOTE: This function is called with preload_mutex locked
+ * Bounding-boxes of the GiST index (if box2df key), or the ones of the entire
+ * inner rows (spatial-join without GiST index; by STR bulk loading), are
+ * written out to the kern_rtree_index in breadth-first order. Leaf entries
+ * point the inner rows on the kds_hash directly, so gpujoin_prep_gistindex
+ * is not needed for them.
  */
-static void
-innerPreloadAllocHostBuffer(pgstromTaskState *pts)
+typedef struct
 {
-	pgstromSharedState *ps_state = pts->ps_state;
-	kern_multirels	   *h_kmrels = NULL;
-	kern_data_store	   *kds = NULL;
-	size_t				offset;
+	float		xmin, xmax;		/* same layout of box2df */
+	float		ymin, ymax;
+	uint32_t	child;			/* packed offset of the inner row, or
+								 * index of the child node */
+} spatial_index_entry;
 
-	/* other backend already setup the buffer metadata */
-	if (ps_state->preload_shmem_length > 0)
-		return;
-	
-	/*
-	 * 1st pass: calculation of the buffer length
-	 * 2nd pass: initialization of buffer metadata
-	 */
-again:
-	offset = MAXALIGN(offsetof(kern_multirels, chunks[pts->num_rels]));
-	for (int i=0; i < pts->num_rels; i++)
-	{
-		pgstromTaskInnerState *istate = &pts->inners[i];
-		TupleDesc	tupdesc = istate->ps->ps_ResultTupleDesc;
-		uint64_t	nrooms;
-		uint64_t	usage;
-		size_t		nbytes;
+#define RTREE_ARRAY_ALIGN(x)	TYPEALIGN(128,(x))
 
-		nrooms = pg_atomic_read_u64(&ps_state->inners[i].inner_nitems);
-		usage  = pg_atomic_read_u64(&ps_state->inners[i].inner_usage);
-		if (h_kmrels)
-		{
-			kds = (kern_data_store *)((char *)h_kmrels + offset);
-			h_kmrels->chunks[i].kds_offset = offset;
-		}
+static uint32_t
+innerPreloadSpatialIndexFanout(void)
+{
+	/* same as the number of box2df items per GiST page */
+	return ((BLCKSZ - (SizeOfPageHeaderData +
+					   MAXALIGN(sizeof(GISTPageOpaqueData)))) /
+			(MAXALIGN(sizeof(IndexTupleData) + 4 * sizeof(float)) +
+			 sizeof(ItemIdData)));
+}
 
-		nbytes = estimate_kern_data_store(tupdesc);
-		if (istate->hash_inner_keys != NIL &&
-			istate->hash_outer_keys != NIL)
-		{
-			/* Hash-Join */
-			uint32_t	nslots = Max(320, nrooms);
+static uint64_t
+innerPreloadSpatialIndexNEntries(uint64_t nitems, uint64_t *p_nnodes)
+{
+	uint32_t	fanout = innerPreloadSpatialIndexFanout();
+	uint64_t	nentries = nitems;
+	uint64_t	nnodes = 0;
 
-			nbytes += (MAXALIGN(sizeof(uint32_t) * nrooms) +
-					   MAXALIGN(sizeof(uint32_t) * nslots) +
-					   MAXALIGN(usage));
-			if (h_kmrels)
-			{
-				setup_kern_data_store(kds, tupdesc, nbytes,
-									  KDS_FORMAT_HASH);
-				kds->hash_nslots = nslots;
-				memset(KDS_GET_HASHSLOT_BASE(kds), 0, sizeof(uint32_t) * nslots);
-			}
-			offset += nbytes;
-		}
-		else if (istate->gist_irel != NULL)
-		{
-			/* GiST-Join */
-			Relation	i_rel = istate->gist_irel;
-			TupleDesc	i_tupdesc = RelationGetDescr(i_rel);
-			BlockNumber	nblocks = RelationGetNumberOfBlocks(i_rel);
-			uint32_t	block_offset;
-			uint32_t	nslots = Max(320, nrooms);
+	for (;;)
+	{
+		uint64_t	n = Max((nitems + fanout - 1) / fanout, 1);
 
-			/* 1st part - inner tuples indexed by ctid */
-			nbytes += (MAXALIGN(sizeof(uint32_t) * nrooms) +
-					   MAXALIGN(sizeof(uint32_t) * nslots) +
-					   MAXALIGN(usage));
-			if (h_kmrels)
-			{
-				setup_kern_data_store(kds, tupdesc, nbytes,
-									  KDS_FORMAT_HASH);
-				kds->hash_nslots = nslots;
-			}
-			offset += nbytes;
+		nnodes += n;
+		if (n == 1)
+			break;
+		nentries += n;
+		nitems = n;
+	}
+	*p_nnodes = nnodes;
+	return nentries;
+}
 
-			/* 2nd part - GiST index blocks */
-			Assert(i_rel->rd_amhandler == F_GISTHANDLER);
-			block_offset = (estimate_kern_data_store(i_tupdesc) +
-							MAXALIGN(sizeof(uint32_t) * nblocks));
-			if (h_kmrels)
-			{
-				kds = (kern_data_store *)((char *)h_kmrels + offset);
-				h_kmrels->chunks[i].gist_offset = offset;
+/*
+ * innerPreloadRTreeInit - setup (or estimate) the kern_rtree_index
+ */
+static size_t
+innerPreloadRTreeInit(kern_rtree_index *rtree,
+					  uint64_t nentries, uint64_t nnodes)
+{
+	size_t		length = RTREE_ARRAY_ALIGN(sizeof(kern_rtree_index));
+	uint64_t	offsets[7];
+	size_t		unitsz[7] = { sizeof(float) * nentries,
+							  sizeof(float) * nentries,
+							  sizeof(float) * nentries,
+							  sizeof(float) * nentries,
+							  sizeof(uint32_t) * nentries,
+							  sizeof(uint32_t) * (nnodes + 1),
+							  sizeof(uint32_t) * nnodes };
+
+	for (int k=0; k < lengthof(offsets); k++)
+	{
+		offsets[k] = length;
+		length += RTREE_ARRAY_ALIGN(unitsz[k]);
+	}
+	if (rtree)
+	{
+		memset(rtree, 0, sizeof(kern_rtree_index));
+		rtree->length = length;
+		/* capacity until the R-tree gets built */
+		rtree->nnodes = nnodes;
+		rtree->nentries = nentries;
+		rtree->xmin_offset   = offsets[0];
+		rtree->xmax_offset   = offsets[1];
+		rtree->ymin_offset   = offsets[2];
+		rtree->ymax_offset   = offsets[3];
+		rtree->child_offset  = offsets[4];
+		rtree->head_offset   = offsets[5];
+		rtree->parent_offset = offsets[6];
+	}
+	return length;
+}
 
-				setup_kern_data_store(kds, i_tupdesc, nbytes,
-									  KDS_FORMAT_BLOCK);
-				kds->block_offset = block_offset;
-				for (int k=0; k < nblocks; k++)
-				{
-					Buffer		buffer;
-					Page		page;
-					PageHeader	hpage;
+static inline void
+__innerPreloadRTreeSetEntry(kern_rtree_index *rtree, uint32_t index,
+							const float *bbox, uint32_t child)
+{
+	((float *)KERN_RTREE_ARRAY(rtree, xmin))[index] = bbox[0];
+	((float *)KERN_RTREE_ARRAY(rtree, xmax))[index] = bbox[1];
+	((float *)KERN_RTREE_ARRAY(rtree, ymin))[index] = bbox[2];
+	((float *)KERN_RTREE_ARRAY(rtree, ymax))[index] = bbox[3];
+	((uint32_t *)KERN_RTREE_ARRAY(rtree, child))[index] = child;
+}
 
-					buffer = ReadBuffer(i_rel, k);
-					LockBuffer(buffer, BUFFER_LOCK_SHARE);
-					page = BufferGetPage(buffer);
-					hpage = KDS_BLOCK_PGPAGE(kds, k);
+void
+pgstromSetupSpatialIndexFuncs(pgstromTaskInnerState *istate, Oid geom_oid)
+{
+	static const char *bound_fnames[4] = {"st_xmin", "st_xmax",
+										  "st_ymin", "st_ymax"};
+	HeapTuple	tup;
+	Oid			nsp_oid;
+	Oid			box3d_oid;
+	Oid			func_oid;
+	char	   *nspname;
+
+	tup = SearchSysCache1(TYPEOID, ObjectIdGetDatum(geom_oid));
+	if (!HeapTupleIsValid(tup))
+		elog(ERROR, "cache lookup failed for type %u", geom_oid);
+	nsp_oid = ((Form_pg_type) GETSTRUCT(tup))->typnamespace;
+	ReleaseSysCache(tup);
+	nspname = get_namespace_name(nsp_oid);
+
+	box3d_oid = GetSysCacheOid2(TYPENAMENSP,
+								Anum_pg_type_oid,
+								CStringGetDatum("box3d"),
+								ObjectIdGetDatum(nsp_oid));
+	if (!OidIsValid(box3d_oid))
+		elog(ERROR, "type %s.box3d was not found", quote_identifier(nspname));
+	func_oid = LookupFuncName(list_make2(makeString(nspname),
+										 makeString("box3d")),
+							  1, &geom_oid, false);
+	fmgr_info(func_oid, &istate->spatial_box3d);
+	for (int k=0; k < 4; k++)
+	{
+		func_oid = LookupFuncName(list_make2(makeString(nspname),
+											 makeString((char *)bound_fnames[k])),
+								  1, &box3d_oid, false);
+		fmgr_info(func_oid, &istate->spatial_bound[k]);
+	}
+}
 
-					memcpy(hpage, page, BLCKSZ);
-					hpage->pd_lsn.xlogid = InvalidBlockNumber;
-					hpage->pd_lsn.xrecoff = InvalidOffsetNumber;
-					KDS_BLOCK_BLCKNR(kds, k) = k;
+static Datum
+__spatialIndexCallFunc1(FmgrInfo *flinfo, Datum arg, bool *p_isnull)
+{
+	LOCAL_FCINFO(fcinfo, 1);
+	Datum		result;
+
+	InitFunctionCallInfoData(*fcinfo, flinfo, 1, InvalidOid, NULL, NULL);
+	fcinfo->args[0].value = arg;
+	fcinfo->args[0].isnull = false;
+	result = FunctionCallInvoke(fcinfo);
+	*p_isnull = fcinfo->isnull;
+	return result;
+}
 
-					UnlockReleaseBuffer(buffer);
-				}
-				kds->length = block_offset + BLCKSZ * nblocks;
-				kds->nitems = nblocks;
-				kds->block_nloaded = nblocks;
-				innerPreloadSetupGiSTIndex(kds);
+/*
+ * get_tuple_spatial_bbox
+ *
+ * It computes the bounding-box of the inner geometry, rounded to the outer
+ * float values as PostGIS doing for box2df. It returns false if the inner
+ * geometry is NULL or EMPTY; these rows will never match.
+ */
+static bool
+get_tuple_spatial_bbox(pgstromTaskState *pts,
+					   pgstromTaskInnerState *istate,
+					   TupleTableSlot *inner_slot,
+					   spatial_index_entry *entry)
+{
+	ExprContext	   *econtext = pts->css.ss.ps.ps_ExprContext;
+	TupleTableSlot *scan_slot = pts->css.ss.ss_ScanTupleSlot;
+	Datum			geom;
+	Datum			box3d;
+	float		   *fvals = &entry->xmin;
+	bool			isnull;
+	ListCell	   *lc1, *lc2;
+
+	/* move to scan_slot from inner_slot */
+	forboth (lc1, istate->inner_load_src,
+			 lc2, istate->inner_load_dst)
+	{
+		int		src = lfirst_int(lc1) - 1;
+		int		dst = lfirst_int(lc2) - 1;
+
+		scan_slot->tts_isnull[dst] = inner_slot->tts_isnull[src];
+		scan_slot->tts_values[dst] = inner_slot->tts_values[src];
+	}
+	econtext->ecxt_scantuple = scan_slot;
+	geom = ExecEvalExpr(istate->spatial_key, econtext, &isnull);
+	if (isnull)
+		return false;
+	box3d = __spatialIndexCallFunc1(&istate->spatial_box3d, geom, &isnull);
+	if (isnull)
+		return false;
+	for (int k=0; k < 4; k++)
+	{
+		double	dval;
+		float	fval;
+
+		dval = DatumGetFloat8(__spatialIndexCallFunc1(&istate->spatial_bound[k],
+													  box3d, &isnull));
+		if (isnull)
+			return false;
+		fval = (float)dval;
+		if ((k & 1) == 0 && (double)fval > dval)
+			fval = nextafterf(fval, -FLT_MAX);		/* xmin, ymin */
+		else if ((k & 1) != 0 && (double)fval < dval)
+			fval = nextafterf(fval, FLT_MAX);		/* xmax, ymax */
+		fvals[k] = fval;
+	}
+	return true;
+}
+
+static int
+__spatialIndexCompareX(const void *__a, const void *__b)
+{
+	const spatial_index_entry *a = __a;
+	const spatial_index_entry *b = __b;
+	float		x1 = a->xmin + a->xmax;
+	float		x2 = b->xmin + b->xmax;
+
+	return (x1 < x2 ? -1 : (x1 > x2 ? 1 : 0));
+}
+
+static int
+__spatialIndexCompareY(const void *__a, const void *__b)
+{
+	const spatial_index_entry *a = __a;
+	const spatial_index_entry *b = __b;
+	float		y1 = a->ymin + a->ymax;
+	float		y2 = b->ymin + b->ymax;
+
+	return (y1 < y2 ? -1 : (y1 > y2 ? 1 : 0));
+}
+
+/*
+ * innerPreloadSetupSpatialIndex
+ *
+ * NOTE: It has to be called by only one process, after all the inner rows
+ * are loaded onto the kds_hash.
+ */
+static void
+innerPreloadSetupSpatialIndex(pgstromTaskState *pts,
+							  kern_multirels *h_kmrels, int depth_index)
+{
+	pgstromTaskInnerState *istate = &pts->inners[depth_index];
+	kern_data_store *kds_hash = KERN_MULTIRELS_INNER_KDS(h_kmrels, depth_index);
+	kern_rtree_index *rtree = KERN_MULTIRELS_RTREE_INDEX(h_kmrels, depth_index);
+	uint32_t	fanout = innerPreloadSpatialIndexFanout();
+	spatial_index_entry *entries;
+	List	   *levels = NIL;
+	List	   *levels_nitems = NIL;
+	uint32_t	nitems = 0;
+	uint32_t	node_base = 0;
+	uint32_t	entry_base = 0;
+	uint32_t   *r_head;
+	uint32_t   *r_parent;
+	TupleTableSlot *slot;
+	int			depth;
+
+	Assert(kds_hash->format == KDS_FORMAT_HASH);
+	/* bounding-boxes of the inner rows */
+	entries = MemoryContextAllocHuge(CurrentMemoryContext,
+									 sizeof(spatial_index_entry) *
+									 Max(kds_hash->nitems, 1));
+	slot = MakeSingleTupleTableSlot(ExecGetResultType(istate->ps),
+									&TTSOpsHeapTuple);
+	for (uint32_t rowid=0; rowid < kds_hash->nitems; rowid++)
+	{
+		kern_tupitem   *titem = KDS_GET_TUPITEM(kds_hash, rowid);
+		HeapTupleData	tuple;
+
+		CHECK_FOR_INTERRUPTS();
+		if (!titem)
+			continue;
+		tuple.t_len  = titem->t_len;
+		ItemPointerSetInvalid(&tuple.t_self);
+		tuple.t_tableOid = InvalidOid;
+		tuple.t_data = &titem->htup;
+		ExecStoreHeapTuple(&tuple, slot, false);
+		slot_getallattrs(slot);
+		if (get_tuple_spatial_bbox(pts, istate, slot, &entries[nitems]))
+		{
+			entries[nitems].child = __kds_packed((char *)&titem->htup -
+												 (char *)kds_hash);
+			nitems++;
+		}
+	}
+	ExecDropSingleTupleTableSlot(slot);
+
+	/* STR bulk loading, from the leaf level */
+	for (;;)
+	{
+		uint32_t	nnodes = Max((nitems + fanout - 1) / fanout, 1);
+		uint32_t	nslices = (uint32_t)ceil(sqrt((double)nnodes));
+		uint32_t	slice_sz = nslices * fanout;
+		spatial_index_entry *parents;
+
+		if (nitems > 1)
+		{
+			qsort(entries, nitems, sizeof(spatial_index_entry),
+				  __spatialIndexCompareX);
+			for (uint32_t i=0; i < nitems; i += slice_sz)
+				qsort(entries + i, Min(slice_sz, nitems - i),
+					  sizeof(spatial_index_entry),
+					  __spatialIndexCompareY);
+		}
+		levels = lappend(levels, entries);
+		levels_nitems = lappend_int(levels_nitems, nitems);
+		if (nnodes == 1)
+			break;
+		/* entries of the upper level */
+		parents = MemoryContextAllocHuge(CurrentMemoryContext,
+										 sizeof(spatial_index_entry) *
+										 nnodes);
+		for (uint32_t j=0; j < nnodes; j++)
+		{
+			spatial_index_entry *parent = &parents[j];
+			uint32_t	tail = Min((j+1) * fanout, nitems);
+
+			*parent = entries[j * fanout];
+			for (uint32_t i = j * fanout + 1; i < tail; i++)
+			{
+				parent->xmin = Min(parent->xmin, entries[i].xmin);
+				parent->xmax = Max(parent->xmax, entries[i].xmax);
+				parent->ymin = Min(parent->ymin, entries[i].ymin);
+				parent->ymax = Max(parent->ymax, entries[i].ymax);
 			}
-			offset += (block_offset + BLCKSZ * nblocks);
+			parent->child = j;
 		}
-		else
+		entries = parents;
+		nitems = nnodes;
+	}
+
+	/* write out the R-tree in breadth-first order, from the root level */
+	r_head = KERN_RTREE_ARRAY(rtree, head);
+	r_parent = KERN_RTREE_ARRAY(rtree, parent);
+	for (depth = list_length(levels) - 1; depth >= 0; depth--)
+	{
+		spatial_index_entry *curr = list_nth(levels, depth);
+		uint32_t	curr_nitems = list_nth_int(levels_nitems, depth);
+		uint32_t	nnodes = Max((curr_nitems + fanout - 1) / fanout, 1);
+
+		if (node_base + nnodes > rtree->nnodes ||
+			entry_base + curr_nitems > rtree->nentries)
+			elog(ERROR, "R-tree buffer is too small (nnodes=%u, nentries=%u)",
+				 rtree->nnodes, rtree->nentries);
+		for (uint32_t j=0; j < nnodes; j++)
+			r_head[node_base + j] = entry_base + j * fanout;
+		for (uint32_t i=0; i < curr_nitems; i++)
 		{
-			/* Nested-Loop */
+			uint32_t	child = curr[i].child;
+
+			if (depth > 0)
+			{
+				child += node_base + nnodes;
+				r_parent[child] = entry_base + i;
+			}
+			__innerPreloadRTreeSetEntry(rtree, entry_base + i,
+										&curr[i].xmin, child);
+		}
+		if (depth == 0)
+			rtree->leaf_base = entry_base;
+		node_base  += nnodes;
+		entry_base += curr_nitems;
+	}
+	r_head[node_base] = entry_base;
+	r_parent[0] = UINT_MAX;
+	rtree->nnodes = node_base;
+	rtree->nentries = entry_base;
+}
+
+/*
+ * innerPreloadSetupGiSTRTree
+ *
+ * It converts the GiST index pages with box2df key into the compact R-tree.
+ * Leaf items are resolved to the inner rows on the kds_hash by ctid, so it
+ * has to be called by only one process, after all the inner rows are loaded.
+ */
+static uint32_t
+__innerPreloadLookupCtid(kern_data_store *kds_hash, ItemPointer ctid)
+{
+	kern_hashitem *khitem;
+	uint32_t	hash;
+
+	hash = hash_any((unsigned char *)ctid, sizeof(ItemPointerData));
+	for (khitem = KDS_HASH_FIRST_ITEM(kds_hash, hash);
+		 khitem != NULL;
+		 khitem = KDS_HASH_NEXT_ITEM(kds_hash, khitem->next))
+	{
+		if (ItemPointerEquals(&khitem->t.htup.t_ctid, ctid))
+			return __kds_packed((char *)&khitem->t.htup -
+								(char *)kds_hash);
+	}
+	return 0;
+}
+
+static void
+innerPreloadSetupGiSTRTree(pgstromTaskState *pts,
+						   kern_multirels *h_kmrels, int depth_index)
+{
+	pgstromTaskInnerState *istate = &pts->inners[depth_index];
+	kern_data_store *kds_hash = KERN_MULTIRELS_INNER_KDS(h_kmrels, depth_index);
+	kern_rtree_index *rtree = KERN_MULTIRELS_RTREE_INDEX(h_kmrels, depth_index);
+	Relation	i_rel = istate->gist_irel;
+	TupleDesc	i_tupdesc = RelationGetDescr(i_rel);
+	uint32_t   *r_head = KERN_RTREE_ARRAY(rtree, head);
+	uint32_t   *r_parent = KERN_RTREE_ARRAY(rtree, parent);
+	BlockNumber *blknos;
+	uint32_t	nqueued = 1;
+	uint32_t	nentries = 0;
+	uint32_t	leaf_base = UINT_MAX;
+
+	Assert(kds_hash->format == KDS_FORMAT_HASH);
+	blknos = palloc(sizeof(BlockNumber) * rtree->nnodes);
+	blknos[0] = GIST_ROOT_BLKNO;
+	r_parent[0] = UINT_MAX;
+	for (uint32_t node=0; node < nqueued; node++)
+	{
+		Buffer		buffer;
+		Page		page;
+		OffsetNumber i, maxoff;
+		bool		is_leaf;
+
+		CHECK_FOR_INTERRUPTS();
+		buffer = ReadBuffer(i_rel, blknos[node]);
+		LockBuffer(buffer, BUFFER_LOCK_SHARE);
+		page = BufferGetPage(buffer);
+		is_leaf = GistPageIsLeaf(page);
+		/*
+		 * GiST index is balanced, so breadth-first walk always visits
+		 * the leaf pages at the last.
+		 */
+		if (is_leaf && leaf_base == UINT_MAX)
+			leaf_base = nentries;
+		else if (!is_leaf && leaf_base != UINT_MAX)
+			elog(ERROR, "GiST index '%s' is not balanced",
+				 RelationGetRelationName(i_rel));
+		r_head[node] = nentries;
+
+		maxoff = (GistPageIsDeleted(page) ? InvalidOffsetNumber
+										  : PageGetMaxOffsetNumber(page));
+		for (i=FirstOffsetNumber; i <= maxoff; i = OffsetNumberNext(i))
+		{
+			ItemId		iid = PageGetItemId(page, i);
+			IndexTuple	itup;
+			Datum		datum;
+			bool		isnull;
+			uint32_t	child;
+
+			if (!ItemIdIsNormal(iid))
+				continue;
+			itup = (IndexTuple) PageGetItem(page, iid);
+			datum = index_getattr(itup, 1, i_tupdesc, &isnull);
+			if (isnull)
+				continue;
+			if (is_leaf)
+			{
+				/* skip the item, if not exist on kds_hash */
+				child = __innerPreloadLookupCtid(kds_hash, &itup->t_tid);
+				if (child == 0)
+					continue;
+			}
+			else
+			{
+				if (nqueued >= rtree->nnodes)
+					elog(ERROR, "GiST index '%s' grew during inner preloading",
+						 RelationGetRelationName(i_rel));
+				blknos[nqueued] = ItemPointerGetBlockNumberNoCheck(&itup->t_tid);
+				r_parent[nqueued] = nentries;
+				child = nqueued++;
+			}
+			if (nentries >= rtree->nentries)
+				elog(ERROR, "GiST index '%s' grew during inner preloading",
+					 RelationGetRelationName(i_rel));
+			__innerPreloadRTreeSetEntry(rtree, nentries++,
+										(const float *)DatumGetPointer(datum),
+										child);
+		}
+		UnlockReleaseBuffer(buffer);
+	}
+	r_head[nqueued] = nentries;
+	rtree->leaf_base = (leaf_base == UINT_MAX ? nentries : leaf_base);
+	rtree->nnodes = nqueued;
+	rtree->nentries = nentries;
+	pfree(blknos);
+}
+
+/*
+ * innerPreloadSetupPrepGeometry
+ *
+ * It builds the prepared form of the inner polygons, referenced by
+ * st_contains() in the join quals. Polygons that cannot be prepared, or
+ * are out of the buffer, are evaluated in the normal way.
+ *
+ * NOTE: It has to be called by only one process, after all the inner rows
+ * are loaded onto the kds_hash.
+ */
+static void
+innerPreloadSetupPrepGeometry(pgstromTaskState *pts,
+							  kern_multirels *h_kmrels, int depth_index)
+{
+	pgstromTaskInnerState *istate = &pts->inners[depth_index];
+	kern_data_store *kds_hash = KERN_MULTIRELS_INNER_KDS(h_kmrels, depth_index);
+	kern_prep_geometry *prep = (kern_prep_geometry *)
+		((char *)h_kmrels + h_kmrels->chunks[depth_index].prep_geom_offset);
+	TupleDesc	tupdesc = istate->ps->ps_ResultTupleDesc;
+	char	   *pool = (char *)prep + prep->pool_offset;
+	size_t		pool_sz = prep->length - prep->pool_offset;
+
+	Assert(h_kmrels->chunks[depth_index].prep_geom_offset != 0);
+	for (uint32_t rowid=0; rowid < kds_hash->nitems; rowid++)
+	{
+		kern_tupitem   *titem = KDS_GET_TUPITEM(kds_hash, rowid);
+		HeapTupleData	tuple;
+		Datum			datum;
+		bool			isnull;
+		size_t			sz;
+		uint64_t		key;
+		uint32_t		index;
+
+		CHECK_FOR_INTERRUPTS();
+		if (!titem)
+			continue;
+		if (prep->nitems >= prep->nslots / 2)
+			break;
+		tuple.t_len  = titem->t_len;
+		ItemPointerSetInvalid(&tuple.t_self);
+		tuple.t_tableOid = InvalidOid;
+		tuple.t_data = &titem->htup;
+		datum = heap_getattr(&tuple, istate->gist_prep_resno, tupdesc, &isnull);
+		if (isnull)
+			continue;
+		sz = pgstromBuildPrepPolygon(DatumGetPointer(datum),
+									 pool + prep->usage,
+									 pool_sz - prep->usage);
+		if (sz == 0)
+			continue;
+		/* the key is the address of the datum on the inner buffer */
+		key = (DatumGetPointer(datum) - (char *)kds_hash);
+		index = __kern_prep_geometry_hash(key) % prep->nslots;
+		while (prep->slots[index].key != 0)
+			index = (index + 1) % prep->nslots;
+		prep->slots[index].key = key;
+		prep->slots[index].value = prep->pool_offset + prep->usage;
+		prep->usage += MAXALIGN(sz);
+		prep->nitems++;
+	}
+}
+
+/*
+ * __innerPreloadBloomFilterNBits
+ *
+ * It returns the number of bloom filter bits (2^N) for the 'nrooms' rows;
+ * 16 bits per row gives about 1.4% of false-positive with k=2.
+ */
+static uint32_t
+__innerPreloadBloomFilterNBits(uint64_t nrooms)
+{
+	uint64_t	nbits = 1024;
+
+	while (nbits < 16 * nrooms && nbits < (1UL << 31))
+		nbits <<= 1;
+	return nbits;
+}
+
+/*
+ * innerPreloadAllocHostBuffer
+ *
+ * NOTE: This function is called with preload_mutex locked
+ */
+static void
+innerPreloadAllocHostBuffer(pgstromTaskState *pts)
+{
+	pgstromSharedState *ps_state = pts->ps_state;
+	kern_multirels	   *h_kmrels = NULL;
+	kern_data_store	   *kds = NULL;
+	size_t				offset;
+
+	/* other backend already setup the buffer metadata */
+	if (ps_state->preload_shmem_length > 0)
+		return;
+	
+	/*
+	 * 1st pass: calculation of the buffer length
+	 * 2nd pass: initialization of buffer metadata
+	 */
+again:
+	offset = MAXALIGN(offsetof(kern_multirels, chunks[pts->num_rels]));
+	for (int i=0; i < pts->num_rels; i++)
+	{
+		pgstromTaskInnerState *istate = &pts->inners[i];
+		TupleDesc	tupdesc = istate->ps->ps_ResultTupleDesc;
+		uint64_t	nrooms;
+		uint64_t	usage;
+		size_t		nbytes;
+
+		nrooms = pg_atomic_read_u64(&ps_state->inners[i].inner_nitems);
+		usage  = pg_atomic_read_u64(&ps_state->inners[i].inner_usage);
+		if (h_kmrels)
+		{
+			kds = (kern_data_store *)((char *)h_kmrels + offset);
+			h_kmrels->chunks[i].kds_offset = offset;
+		}
+
+		nbytes = estimate_kern_data_store(tupdesc);
+		if (istate->hash_inner_keys != NIL &&
+			istate->hash_outer_keys != NIL)
+		{
+			/* Hash-Join */
+			uint32_t	nslots = Max(320, nrooms);
+
 			nbytes += (MAXALIGN(sizeof(uint32_t) * nrooms) +
+					   MAXALIGN(sizeof(uint32_t) * nslots) +
 					   MAXALIGN(usage));
 			if (h_kmrels)
 			{
 				setup_kern_data_store(kds, tupdesc, nbytes,
-									  KDS_FORMAT_ROW);
-				h_kmrels->chunks[i].is_nestloop = true;
+									  KDS_FORMAT_HASH);
+				kds->hash_nslots = nslots;
+				memset(KDS_GET_HASHSLOT_BASE(kds), 0, sizeof(uint32_t) * nslots);
+				h_kmrels->chunks[i].hash_build_on_device
+					= istate->hash_build_on_device;
 			}
 			offset += nbytes;
+
+			/* bloom filter pushed down to the outer scan, if any */
+			if (pts->pp_info->inners[i].bloom_filter)
+			{
+				uint32_t	nbits = __innerPreloadBloomFilterNBits(nrooms);
+
+				nbytes = MAXALIGN(nbits / BITS_PER_BYTE);
+				if (h_kmrels)
+				{
+					h_kmrels->chunks[i].bloom_offset = offset;
+					h_kmrels->chunks[i].bloom_nbits = nbits;
+					memset((char *)h_kmrels + offset, 0, nbytes);
+				}
+				offset += nbytes;
+			}
+
+			/* bucketized index of the hash table; see innerPreloadSetupHashBucket */
+			if ((pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0 &&
+				pgstrom_enable_gpujoin_hash_bucket &&
+				!istate->hash_build_on_device)
+			{
+				nbytes = KERN_HASH_BUCKET_LENGTH(nslots, nrooms);
+				if (h_kmrels)
+				{
+					kern_hash_bucket *bucket = (kern_hash_bucket *)
+						((char *)h_kmrels + offset);
+
+					memset(bucket, 0, offsetof(kern_hash_bucket, start));
+					bucket->nrooms = nrooms;
+					h_kmrels->chunks[i].bucket_offset = offset;
+				}
+				offset += nbytes;
+			}
+
+			/* direct-mapped index; see innerPreloadSetupHashDirect */
+			if (innerPreloadHashDirectIsAvailable(pts, istate))
+			{
+				nbytes = KERN_HASH_DIRECT_LENGTH(2 * nrooms);
+				if (h_kmrels)
+				{
+					kern_hash_direct *direct = (kern_hash_direct *)
+						((char *)h_kmrels + offset);
+
+					memset(direct, 0, offsetof(kern_hash_direct, items));
+					direct->nrooms = 2 * nrooms;
+					h_kmrels->chunks[i].direct_offset = offset;
+				}
+				offset += nbytes;
+			}
+
+			/* runs of the heavy-hitter keys; see __innerPreloadSetupHashBuffer */
+			if ((pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) != 0 &&
+				pgstrom_gpujoin_heavy_hitter_threshold > 0 &&
+				nrooms >= pgstrom_gpujoin_heavy_hitter_threshold &&
+				istate->join_type == JOIN_INNER &&
+				!istate->hash_build_on_device)
+			{
+				nbytes = MAXALIGN(sizeof(kern_hash_heavy));
+				if (h_kmrels)
+				{
+					h_kmrels->chunks[i].heavy_offset = offset;
+					memset((char *)h_kmrels + offset, 0, nbytes);
+				}
+				offset += nbytes;
+			}
 		}
+		else if (istate->gist_rtree)
+		{
+			/* GiST/Spatial-Join by the compact R-tree */
+			uint64_t	nnodes;
+			uint64_t	nentries;
+			uint32_t	nslots = Max(320, nrooms);
 
-		if (istate->join_type == JOIN_RIGHT ||
-			istate->join_type == JOIN_FULL)
+			/* 1st part - inner tuples (indexed by ctid, if GiST) */
+			nbytes += (MAXALIGN(sizeof(uint32_t) * nrooms) +
+					   MAXALIGN(sizeof(uint32_t) * nslots) +
+					   MAXALIGN(usage));
+			if (h_kmrels)
+			{
+				setup_kern_data_store(kds, tupdesc, nbytes,
+									  KDS_FORMAT_HASH);
+				kds->hash_nslots = nslots;
+			}
+			offset += nbytes;
+
+			/*
+			 * 2nd part - R-tree; built by innerPreloadSetupGiSTRTree or
+			 * innerPreloadSetupSpatialIndex later
+			 */
+			if (istate->gist_irel)
+			{
+				nnodes = Max(RelationGetNumberOfBlocks(istate->gist_irel), 1);
+				nentries = nnodes * innerPreloadSpatialIndexFanout();
+			}
+			else
+			{
+				nentries = innerPreloadSpatialIndexNEntries(nrooms, &nnodes);
+			}
+			offset = RTREE_ARRAY_ALIGN(offset);
+			if (h_kmrels)
+			{
+				h_kmrels->chunks[i].gist_offset = offset;
+				h_kmrels->chunks[i].gist_rtree = true;
+				offset += innerPreloadRTreeInit((kern_rtree_index *)
+												((char *)h_kmrels + offset),
+												nentries, nnodes);
+			}
+			else
+			{
+				offset += innerPreloadRTreeInit(NULL, nentries, nnodes);
+			}
+		}
+		else if (istate->gist_irel != NULL)
+		{
+			/* GiST-Join */
+			Relation	i_rel = istate->gist_irel;
+			TupleDesc	i_tupdesc = RelationGetDescr(i_rel);
+			BlockNumber	nblocks = RelationGetNumberOfBlocks(i_rel);
+			uint32_t	block_offset;
+			uint32_t	nslots = Max(320, nrooms);
+
+			/* 1st part - inner tuples indexed by ctid */
+			nbytes += (MAXALIGN(sizeof(uint32_t) * nrooms) +
+					   MAXALIGN(sizeof(uint32_t) * nslots) +
+					   MAXALIGN(usage));
+			if (h_kmrels)
+			{
+				setup_kern_data_store(kds, tupdesc, nbytes,
+									  KDS_FORMAT_HASH);
+				kds->hash_nslots = nslots;
+			}
+			offset += nbytes;
+
+			/* 2nd part - GiST index blocks */
+			Assert(i_rel->rd_amhandler == F_GISTHANDLER);
+			block_offset = (estimate_kern_data_store(i_tupdesc) +
+							MAXALIGN(sizeof(uint32_t) * nblocks));
+			if (h_kmrels)
+			{
+				kds = (kern_data_store *)((char *)h_kmrels + offset);
+				h_kmrels->chunks[i].gist_offset = offset;
+
+				setup_kern_data_store(kds, i_tupdesc, nbytes,
+									  KDS_FORMAT_BLOCK);
+				kds->block_offset = block_offset;
+				for (int k=0; k < nblocks; k++)
+				{
+					Buffer		buffer;
+					Page		page;
+					PageHeader	hpage;
+
+					buffer = ReadBuffer(i_rel, k);
+					LockBuffer(buffer, BUFFER_LOCK_SHARE);
+					page = BufferGetPage(buffer);
+					hpage = KDS_BLOCK_PGPAGE(kds, k);
+
+					memcpy(hpage, page, BLCKSZ);
+					hpage->pd_lsn.xlogid = InvalidBlockNumber;
+					hpage->pd_lsn.xrecoff = InvalidOffsetNumber;
+					KDS_BLOCK_BLCKNR(kds, k) = k;
+
+					UnlockReleaseBuffer(buffer);
+				}
+				kds->length = block_offset + BLCKSZ * nblocks;
+				kds->nitems = nblocks;
+				kds->block_nloaded = nblocks;
+				innerPreloadSetupGiSTIndex(kds);
+			}
+			offset += (block_offset + BLCKSZ * nblocks);
+		}
+		else
+		{
+			/* Nested-Loop */
+			nbytes += (MAXALIGN(sizeof(uint32_t) * nrooms) +
+					   MAXALIGN(usage));
+			if (h_kmrels)
+			{
+				setup_kern_data_store(kds, tupdesc, nbytes,
+									  KDS_FORMAT_ROW);
+				h_kmrels->chunks[i].is_nestloop = true;
+			}
+			offset += nbytes;
+
+			/* sorted prefixes of inet-join; see innerPreloadSetupInetIndex */
+			if (istate->range_inner_key &&
+				__rangeJoinKeyIsInet(istate->range_inner_key))
+			{
+				nbytes = KERN_INET_INDEX_LENGTH(nrooms);
+				if (h_kmrels)
+				{
+					kern_inet_index *inet_index = (kern_inet_index *)
+						((char *)h_kmrels + offset);
+
+					memset(inet_index, 0, offsetof(kern_inet_index, items));
+					inet_index->nrooms = nrooms;
+					h_kmrels->chunks[i].inet_offset = offset;
+				}
+				offset += nbytes;
+			}
+			/* sorted keys of range-join; see innerPreloadSetupRangeIndex */
+			else if (istate->range_inner_key)
+			{
+				nbytes = KERN_RANGE_INDEX_LENGTH(nrooms);
+				if (h_kmrels)
+				{
+					kern_range_index *range = (kern_range_index *)
+						((char *)h_kmrels + offset);
+
+					memset(range, 0, offsetof(kern_range_index, keys));
+					range->nrooms = nrooms;
+					h_kmrels->chunks[i].range_offset = offset;
+				}
+				offset += nbytes;
+			}
+		}
+
+		/* prepared inner geometries; see innerPreloadSetupPrepGeometry */
+		if (istate->gist_prep_resno > 0)
+		{
+			uint32_t	nslots = Max(2 * nrooms, 64);
+			size_t		head_sz = MAXALIGN(offsetof(kern_prep_geometry,
+													slots[nslots]));
+
+			nbytes = head_sz + 4 * MAXALIGN(usage);
+			if (h_kmrels)
+			{
+				kern_prep_geometry *prep = (kern_prep_geometry *)
+					((char *)h_kmrels + offset);
+
+				memset(prep, 0, head_sz);
+				prep->length = nbytes;
+				prep->nslots = nslots;
+				prep->pool_offset = head_sz;
+				h_kmrels->chunks[i].prep_geom_offset = offset;
+			}
+			offset += nbytes;
+		}
+
+		if (istate->join_type == JOIN_RIGHT ||
+			istate->join_type == JOIN_FULL)
+		{
+			nbytes = MAXALIGN(sizeof(bool) * nrooms);
+			if (h_kmrels)
+			{
+				h_kmrels->chunks[i].right_outer = true;
+				h_kmrels->chunks[i].ojmap_offset = offset;
+				memset((char *)h_kmrels + offset, 0, nbytes);
+			}
+			offset += nbytes;
+		}
+		if (istate->join_type == JOIN_LEFT ||
+			istate->join_type == JOIN_FULL)
+		{
+			if (h_kmrels)
+				h_kmrels->chunks[i].left_outer = true;
+		}
+		if (h_kmrels)
+		{
+			h_kmrels->chunks[i].semi_join = (istate->join_type == JOIN_SEMI);
+			h_kmrels->chunks[i].anti_join = (istate->join_type == JOIN_ANTI);
+		}
+	}
+
+	/*
+	 * allocation of the host inner-buffer
+	 */
+	if (!h_kmrels)
+	{
+		size_t		shmem_length = PAGE_ALIGN(offset);
+
+		Assert(ps_state->preload_shmem_handle != 0);
+		h_kmrels = __mmapShmem(ps_state->preload_shmem_handle,
+							   shmem_length, GpuJoinInnerShmemEntry(pts));
+		memset(h_kmrels, 0, offsetof(kern_multirels,
+									 chunks[pts->num_rels]));
+		h_kmrels->length = offset;
+		h_kmrels->num_rels = pts->num_rels;
+		ps_state->preload_shmem_length = shmem_length;
+		goto again;
+	}
+	pts->h_kmrels = h_kmrels;
+}
+
+/*
+ * __innerPreloadSetupHeapBuffer
+ */
+static void
+__innerPreloadSetupHeapBuffer(kern_data_store *kds,
+							  pgstromTaskInnerState *istate,
+							  uint32_t base_nitems,
+							  uint32_t base_usage)
+{
+	uint32_t   *row_index = KDS_GET_ROWINDEX(kds);
+	uint32_t	rowid = base_nitems;
+	char	   *tail_pos = (char *)kds + kds->length;
+	char	   *curr_pos = tail_pos - __kds_unpack(base_usage);
+	inner_preload_buffer *preload_buf = istate->preload_buffer;
+
+	for (uint32_t index=0; index < preload_buf->nitems; index++)
+	{
+		HeapTuple	htup = preload_buf->rows[index].htup;
+		size_t		sz;
+		kern_tupitem *titem;
+
+		sz = MAXALIGN(offsetof(kern_tupitem, htup) + htup->t_len);
+		curr_pos -= sz;
+		titem = (kern_tupitem *)curr_pos;
+		titem->t_len = htup->t_len;
+		titem->rowid = rowid;
+		memcpy(&titem->htup, htup->t_data, htup->t_len);
+		memcpy(&titem->htup.t_ctid, &htup->t_self, sizeof(ItemPointerData));
+
+		row_index[rowid++] = __kds_packed(tail_pos - curr_pos);
+	}
+}
+
+/*
+ * __innerPreloadRegisterHeavyRun
+ *
+ * It registers a run of heavy-hitter rows [head, tail) on the kern_hash_heavy.
+ * If no more room, the rows are linked to the hash-slot as usual.
+ */
+static bool
+__innerPreloadRegisterHeavyRun(pgstromSharedState *ps_state,
+							   kern_hash_heavy *heavy,
+							   uint32_t hash,
+							   uint32_t head,
+							   uint32_t tail)
+{
+	uint32_t	index = hash % KERN_HASH_HEAVY_NSLOTS;
+	uint32_t	run_id;
+	bool		retval = false;
+
+	SpinLockAcquire(&ps_state->preload_mutex);
+	if (heavy->nruns < KERN_HASH_HEAVY_NRUNS)
+	{
+		while (heavy->slots[index].run_id != 0 &&
+			   heavy->slots[index].hash != hash)
+			index = (index + 1) % KERN_HASH_HEAVY_NSLOTS;
+		run_id = ++heavy->nruns;
+		heavy->runs[run_id-1].head = head;
+		heavy->runs[run_id-1].tail = tail;
+		heavy->runs[run_id-1].next = heavy->slots[index].run_id;
+		heavy->slots[index].hash = hash;
+		heavy->slots[index].run_id = run_id;
+		retval = true;
+	}
+	SpinLockRelease(&ps_state->preload_mutex);
+
+	return retval;
+}
+
+static int
+__innerPreloadCompareHash(const void *__a, const void *__b)
+{
+	const struct inner_preload_row *a = __a;
+	const struct inner_preload_row *b = __b;
+
+	return (a->hash < b->hash ? -1 : (a->hash > b->hash ? 1 : 0));
+}
+
+/*
+ * __innerPreloadSetupHashBuffer
+ *
+ * If kern_hash_heavy is given, the preloaded rows are sorted by the hash
+ * value, then the rows of the heavy-hitter keys (more than
+ * pg_strom.gpujoin_heavy_hitter_threshold rows in this process) are stored
+ * as a run of consecutive rowids, instead of the long hash-slot chain.
+ */
+static void
+__innerPreloadSetupHashBuffer(kern_data_store *kds,
+							  pgstromTaskState *pts,
+							  pgstromTaskInnerState *istate,
+							  uint32_t base_nitems,
+							  uint32_t base_usage,
+							  uint32_t nbatches,
+							  uint32_t batch_id,
+							  uint32_t *bloom,
+							  uint32_t bloom_nbits,
+							  kern_hash_heavy *heavy)
+{
+	uint32_t   *row_index = KDS_GET_ROWINDEX(kds);
+	uint32_t   *hash_slot = KDS_GET_HASHSLOT_BASE(kds);
+	uint32_t	rowid = base_nitems;
+	char	   *tail_pos = (char *)kds + kds->length;
+	char	   *curr_pos = tail_pos - __kds_unpack(base_usage);
+	inner_preload_buffer *preload_buf = istate->preload_buffer;
+	uint32_t	heavy_tail = 0;		/* end of the current heavy-hitter run */
+
+	if (istate->hash_build_on_device)
+		heavy = NULL;
+	if (heavy)
+		qsort(preload_buf->rows, preload_buf->nitems,
+			  sizeof(struct inner_preload_row),
+			  __innerPreloadCompareHash);
+	for (uint32_t index=0; index < preload_buf->nitems; index++)
+	{
+		HeapTuple	htup = preload_buf->rows[index].htup;
+		uint32_t	hash = preload_buf->rows[index].hash;
+		uint32_t	hindex = hash % kds->hash_nslots;
+		uint32_t	next, self;
+		size_t		sz;
+		kern_hashitem *hitem;
+
+		/* skip rows that belong to other hash-batches */
+		if (nbatches > 1 && INNER_BATCH_ID(hash, nbatches) != batch_id)
+			continue;
+		/* is it the head of the heavy-hitter run? */
+		if (heavy && index >= heavy_tail &&
+			(index == 0 || preload_buf->rows[index-1].hash != hash))
+		{
+			uint32_t	k = index + 1;
+
+			while (k < preload_buf->nitems &&
+				   preload_buf->rows[k].hash == hash)
+				k++;
+			if (k - index >= pgstrom_gpujoin_heavy_hitter_threshold &&
+				__innerPreloadRegisterHeavyRun(pts->ps_state, heavy, hash,
+											   rowid, rowid + (k - index)))
+				heavy_tail = k;
+		}
+		sz = MAXALIGN(offsetof(kern_hashitem, t.htup) + htup->t_len);
+		curr_pos -= sz;
+		if (istate->hash_build_on_device)
+		{
+			/* GPU kernel links the hash-slot and bloom filter later */
+			next = 0;
+		}
+		else if (index < heavy_tail)
+		{
+			/* rows on the heavy-hitter run are not linked to hash-slot */
+			next = 0;
+		}
+		else
+		{
+			self = __kds_packed(tail_pos - curr_pos);
+			__atomic_exchange(&hash_slot[hindex], &self, &next,
+							  __ATOMIC_SEQ_CST);
+		}
+		hitem = (kern_hashitem *)curr_pos;
+		hitem->hash = hash;
+		hitem->next = next;
+		hitem->t.t_len = htup->t_len;
+		hitem->t.rowid = rowid;
+		memcpy(&hitem->t.htup, htup->t_data, htup->t_len);
+		memcpy(&hitem->t.htup.t_ctid, &htup->t_self, sizeof(ItemPointerData));
+
+		row_index[rowid++] = __kds_packed(tail_pos - (char *)&hitem->t);
+
+		/* bloom filter shall be shared by concurrent workers */
+		if (bloom && !istate->hash_build_on_device)
+		{
+			uint32_t	h1 = (hash & (bloom_nbits - 1));
+			uint32_t	h2 = (__bloom_filter_hash2(hash) & (bloom_nbits - 1));
+
+			__atomic_fetch_or(&bloom[h1 >> 5], (1U << (h1 & 0x1f)),
+							  __ATOMIC_RELAXED);
+			__atomic_fetch_or(&bloom[h2 >> 5], (1U << (h2 & 0x1f)),
+							  __ATOMIC_RELAXED);
+		}
+	}
+}
+
+/*
+ * innerPreloadSetupHashBucket
+ *
+ * It builds the bucketized index from the hash-slot chains, so it has to be
+ * called by only one process, after all the inner rows are loaded.
+ */
+static void
+innerPreloadSetupHashBucket(pgstromTaskState *pts,
+							kern_multirels *h_kmrels, int depth_index)
+{
+	pgstromTaskInnerState *istate = &pts->inners[depth_index];
+	kern_data_store *kds = KERN_MULTIRELS_INNER_KDS(h_kmrels, depth_index);
+	kern_hash_bucket *bucket = KERN_MULTIRELS_HASH_BUCKET(h_kmrels, depth_index);
+	uint32_t   *hash_slot;
+	uint32_t   *tags;
+	uint32_t   *items;
+	uint32_t	nitems = 0;
+
+	/* GPU kernel links the hash-slot later, if device build */
+	if (!bucket || istate->hash_build_on_device)
+		return;
+	Assert(kds->format == KDS_FORMAT_HASH && kds->nitems <= bucket->nrooms);
+	hash_slot = KDS_GET_HASHSLOT_BASE(kds);
+	bucket->nslots = kds->hash_nslots;
+	tags  = KERN_HASH_BUCKET_TAGS(bucket);
+	items = KERN_HASH_BUCKET_ITEMS(bucket);
+	for (uint32_t k=0; k < kds->hash_nslots; k++)
+	{
+		kern_hashitem *hitem;
+		uint32_t	offset;
+
+		bucket->start[k] = nitems;
+		for (offset = hash_slot[k];
+			 (hitem = KDS_HASH_NEXT_ITEM(kds, offset)) != NULL;
+			 offset = hitem->next)
+		{
+			Assert(nitems < bucket->nrooms);
+			tags[nitems] = hitem->hash;
+			items[nitems] = offset;
+			nitems++;
+		}
+	}
+	bucket->start[kds->hash_nslots] = nitems;
+	bucket->nitems = nitems;
+}
+
+/*
+ * innerPreloadSetupHashDirect
+ *
+ * It builds the direct-mapped index, if the inner keys are unique and dense
+ * (range of the keys is less than twice of the rows). Elsewhere, it keeps
+ * kern_hash_direct empty, and GPU kernel walks on the hash table as usual.
+ * It has to be called by only one process, after all the inner rows are
+ * loaded.
+ */
+static void
+innerPreloadSetupHashDirect(pgstromTaskState *pts,
+							kern_multirels *h_kmrels, int depth_index)
+{
+	pgstromTaskInnerState *istate = &pts->inners[depth_index];
+	kern_data_store *kds = KERN_MULTIRELS_INNER_KDS(h_kmrels, depth_index);
+	kern_hash_direct *direct = KERN_MULTIRELS_HASH_DIRECT(h_kmrels, depth_index);
+	kern_hash_heavy *heavy = KERN_MULTIRELS_HEAVY_HITTERS(h_kmrels, depth_index);
+	TupleTableSlot *slot;
+	int64_t	   *keys;
+	bool	   *nulls;
+	int64_t		min_value = PG_INT64_MAX;
+	int64_t		max_value = PG_INT64_MIN;
+	uint64_t	nitems;
+
+	if (!direct || istate->hash_build_on_device ||
+		(heavy && heavy->nruns > 0) || kds->nitems == 0)
+		return;
+	keys  = palloc(sizeof(int64_t) * kds->nitems);
+	nulls = palloc(sizeof(bool) * kds->nitems);
+	slot = MakeSingleTupleTableSlot(ExecGetResultType(istate->ps),
+									&TTSOpsHeapTuple);
+	for (uint32_t rowid=0; rowid < kds->nitems; rowid++)
+	{
+		kern_tupitem   *titem = KDS_GET_TUPITEM(kds, rowid);
+		HeapTupleData	tuple;
+
+		CHECK_FOR_INTERRUPTS();
+		nulls[rowid] = true;
+		if (!titem)
+			continue;
+		tuple.t_len  = titem->t_len;
+		ItemPointerSetInvalid(&tuple.t_self);
+		tuple.t_tableOid = InvalidOid;
+		tuple.t_data = &titem->htup;
+		ExecStoreHeapTuple(&tuple, slot, false);
+		slot_getallattrs(slot);
+		if (get_tuple_direct_key(pts, istate, slot, &keys[rowid]))
+		{
+			nulls[rowid] = false;
+			min_value = Min(min_value, keys[rowid]);
+			max_value = Max(max_value, keys[rowid]);
+		}
+	}
+	ExecDropSingleTupleTableSlot(slot);
+
+	if (min_value > max_value ||
+		(uint64_t)(max_value - min_value) >= direct->nrooms)
+		goto out;		/* not dense */
+	nitems = (uint64_t)(max_value - min_value) + 1;
+	memset(direct->items, 0, sizeof(uint32_t) * nitems);
+	for (uint32_t rowid=0; rowid < kds->nitems; rowid++)
+	{
+		kern_tupitem   *titem;
+		uint64_t		index;
+
+		if (nulls[rowid])
+			continue;
+		index = (uint64_t)(keys[rowid] - min_value);
+		if (direct->items[index] != 0)
+			goto out;	/* not unique */
+		titem = KDS_GET_TUPITEM(kds, rowid);
+		direct->items[index] = __kds_packed((char *)kds + kds->length -
+											((char *)titem -
+											 offsetof(kern_hashitem, t)));
+	}
+	direct->min_value = min_value;
+	direct->nitems = nitems;
+out:
+	pfree(keys);
+	pfree(nulls);
+}
+
+/*
+ * innerPreloadSetupRangeIndex
+ *
+ * It sorts the row-index of the inner KDS_FORMAT_ROW by the inner key of
+ * the range-join, and saves the sorted keys on the kern_range_index.
+ * It has to be called by only one process, after all the inner rows are
+ * loaded.
+ */
+typedef struct
+{
+	int64_t		key;
+	uint32_t	rowindex;
+	bool		isnull;
+} inner_range_item;
+
+static int
+__innerPreloadCompareRangeItem(const void *__a, const void *__b)
+{
+	const inner_range_item *a = __a;
+	const inner_range_item *b = __b;
+
+	if (a->isnull != b->isnull)
+		return (a->isnull ? 1 : -1);	/* NULLs are last */
+	if (a->key != b->key)
+		return (a->key < b->key ? -1 : 1);
+	return (a->rowindex < b->rowindex ? -1 : (a->rowindex > b->rowindex ? 1 : 0));
+}
+
+static void
+innerPreloadSetupRangeIndex(pgstromTaskState *pts,
+							kern_multirels *h_kmrels, int depth_index)
+{
+	pgstromTaskInnerState *istate = &pts->inners[depth_index];
+	kern_data_store *kds = KERN_MULTIRELS_INNER_KDS(h_kmrels, depth_index);
+	kern_range_index *range = KERN_MULTIRELS_RANGE_INDEX(h_kmrels, depth_index);
+	uint32_t	   *rowindex = KDS_GET_ROWINDEX(kds);
+	inner_range_item *items;
+	TupleTableSlot *slot;
+	uint32_t		nitems = 0;
+
+	if (!range || !istate->range_inner_key || kds->nitems == 0)
+		return;
+	Assert(kds->format == KDS_FORMAT_ROW && kds->nitems <= range->nrooms);
+	items = MemoryContextAllocHuge(CurrentMemoryContext,
+								   sizeof(inner_range_item) * kds->nitems);
+	slot = MakeSingleTupleTableSlot(ExecGetResultType(istate->ps),
+									&TTSOpsHeapTuple);
+	for (uint32_t index=0; index < kds->nitems; index++)
+	{
+		kern_tupitem   *titem = KDS_GET_TUPITEM(kds, index);
+		HeapTupleData	tuple;
+
+		CHECK_FOR_INTERRUPTS();
+		items[index].rowindex = rowindex[index];
+		items[index].isnull = true;
+		if (!titem)
+			continue;
+		tuple.t_len  = titem->t_len;
+		ItemPointerSetInvalid(&tuple.t_self);
+		tuple.t_tableOid = InvalidOid;
+		tuple.t_data = &titem->htup;
+		ExecStoreHeapTuple(&tuple, slot, false);
+		slot_getallattrs(slot);
+		if (get_tuple_range_key(pts, istate, slot, &items[index].key))
+		{
+			items[index].isnull = false;
+			nitems++;
+		}
+	}
+	ExecDropSingleTupleTableSlot(slot);
+
+	qsort(items, kds->nitems,
+		  sizeof(inner_range_item),
+		  __innerPreloadCompareRangeItem);
+	for (uint32_t index=0; index < kds->nitems; index++)
+	{
+		rowindex[index] = items[index].rowindex;
+		if (index < nitems)
+			range->keys[index] = items[index].key;
+	}
+	range->nitems = nitems;
+	pfree(items);
+}
+
+/*
+ * innerPreloadSetupInetIndex
+ *
+ * It sorts the row-index of the inner KDS_FORMAT_ROW by the network prefix
+ * of the inet-join, and saves the sorted prefixes with the link to the
+ * nearest enclosing prefix on the kern_inet_index. It has to be called by
+ * only one process, after all the inner rows are loaded.
+ */
+typedef struct
+{
+	kern_inet_index_item item;
+	uint32_t	rowindex;
+	bool		isnull;
+} inner_inet_item;
+
+static int
+__innerPreloadCompareInetItem(const void *__a, const void *__b)
+{
+	const inner_inet_item *a = __a;
+	const inner_inet_item *b = __b;
+
+	if (a->isnull != b->isnull)
+		return (a->isnull ? 1 : -1);	/* NULLs are last */
+	if (a->isnull)
+		return 0;
+	if (a->item.family != b->item.family)
+		return (a->item.family < b->item.family ? -1 : 1);
+	for (int k=0; k < 2; k++)
+	{
+		if (a->item.addr[k] != b->item.addr[k])
+			return (a->item.addr[k] < b->item.addr[k] ? -1 : 1);
+	}
+	/* wider prefix (less bits) first */
+	if (a->item.bits != b->item.bits)
+		return (a->item.bits < b->item.bits ? -1 : 1);
+	return (a->rowindex < b->rowindex ? -1 : (a->rowindex > b->rowindex ? 1 : 0));
+}
+
+static void
+innerPreloadSetupInetIndex(pgstromTaskState *pts,
+						   kern_multirels *h_kmrels, int depth_index)
+{
+	pgstromTaskInnerState *istate = &pts->inners[depth_index];
+	kern_data_store *kds = KERN_MULTIRELS_INNER_KDS(h_kmrels, depth_index);
+	kern_inet_index *inet_index = KERN_MULTIRELS_INET_INDEX(h_kmrels, depth_index);
+	uint32_t	   *rowindex = KDS_GET_ROWINDEX(kds);
+	inner_inet_item *items;
+	uint32_t	   *stack;
+	uint32_t		depth = 0;
+	TupleTableSlot *slot;
+	uint32_t		nitems = 0;
+
+	if (!inet_index || !istate->range_inner_key || kds->nitems == 0)
+		return;
+	Assert(kds->format == KDS_FORMAT_ROW && kds->nitems <= inet_index->nrooms);
+	items = MemoryContextAllocHuge(CurrentMemoryContext,
+								   sizeof(inner_inet_item) * kds->nitems);
+	slot = MakeSingleTupleTableSlot(ExecGetResultType(istate->ps),
+									&TTSOpsHeapTuple);
+	for (uint32_t index=0; index < kds->nitems; index++)
+	{
+		kern_tupitem   *titem = KDS_GET_TUPITEM(kds, index);
+		HeapTupleData	tuple;
+		Datum			datum;
+		bool			isnull;
+
+		CHECK_FOR_INTERRUPTS();
+		items[index].rowindex = rowindex[index];
+		items[index].isnull = true;
+		if (!titem)
+			continue;
+		tuple.t_len  = titem->t_len;
+		ItemPointerSetInvalid(&tuple.t_self);
+		tuple.t_tableOid = InvalidOid;
+		tuple.t_data = &titem->htup;
+		ExecStoreHeapTuple(&tuple, slot, false);
+		slot_getallattrs(slot);
+		datum = __get_tuple_range_datum(pts, istate, slot, &isnull);
+		if (!isnull)
+		{
+			inet	   *ip = DatumGetInetPP(datum);
+			inet_struct	ipaddr;
+
+			memset(&ipaddr, 0, sizeof(inet_struct));
+			ipaddr.family = ip_family(ip);
+			ipaddr.bits = ip_bits(ip);
+			memcpy(ipaddr.ipaddr, ip_addr(ip), ip_addrsize(ip));
+			__inetjoin_fetch_address(items[index].item.addr, &ipaddr);
+			items[index].item.family = ipaddr.family;
+			items[index].item.bits = ipaddr.bits;
+			items[index].isnull = false;
+			nitems++;
+		}
+	}
+	ExecDropSingleTupleTableSlot(slot);
+
+	qsort(items, kds->nitems,
+		  sizeof(inner_inet_item),
+		  __innerPreloadCompareInetItem);
+	/*
+	 * The sorted prefixes are pre-order of the containment tree, so the
+	 * nearest enclosing prefix is on the top of the stack, after the pop
+	 * of the prefixes that don't contain the current one.
+	 */
+	stack = palloc(sizeof(uint32_t) * (nitems + 1));
+	for (uint32_t index=0; index < kds->nitems; index++)
+	{
+		rowindex[index] = items[index].rowindex;
+		if (index < nitems)
+		{
+			kern_inet_index_item *curr = &items[index].item;
+			inet_struct	ipaddr;
+
+			/* pseudo inet to check the containment by the prefix */
+			memset(&ipaddr, 0, sizeof(inet_struct));
+			ipaddr.family = curr->family;
+			ipaddr.bits = curr->bits;
+			while (depth > 0 &&
+				   !__inetjoin_item_contains(&inet_index->items[stack[depth-1]],
+											 &ipaddr, curr->addr))
+				depth--;
+			curr->parent = (depth > 0 ? stack[depth-1] : UINT_MAX);
+			stack[depth++] = index;
+			memcpy(&inet_index->items[index], curr,
+				   sizeof(kern_inet_index_item));
+		}
+	}
+	inet_index->nitems = nitems;
+	pfree(stack);
+	pfree(items);
+}
+
+/*
+ * innerPreloadSetupOneDepth
+ */
+static void
+innerPreloadSetupOneDepth(pgstromTaskState *pts,
+						  kern_multirels *h_kmrels, int i)
+{
+	pgstromTaskInnerState *istate = &pts->inners[i];
+	inner_preload_buffer *preload_buf = istate->preload_buffer;
+	kern_data_store *kds = KERN_MULTIRELS_INNER_KDS(h_kmrels, i);
+	uint32_t	nbatches = 1;
+	uint32_t	batch_id = 0;
+	uint64_t	nitems;
+	uint64_t	usage;
+	uint64_t	base_nitems;
+	uint64_t	base_usage;
+
+	/*
+	 * If this backend/worker process called GpuJoinInnerPreload()
+	 * after the INNER_PHASE__SCAN_RELATIONS completed, it has no
+	 * preload_buf, thus, no tuples should be added.
+	 */
+	if (!preload_buf)
+		return;
+	nitems = preload_buf->nitems;
+	usage  = preload_buf->usage;
+	if (pts->inner_batch_depth == i+1)
+	{
+		/* only rows of the current hash-batch are loaded */
+		nbatches = pts->inner_nbatches;
+		batch_id = pts->inner_batch_id;
+		nitems = pts->inner_batch_nitems[batch_id];
+		usage  = pts->inner_batch_usage[batch_id];
+	}
+
+	/*
+	 * Reservation of the range of rowid and the heap region of this
+	 * process. They are independent each other, so concurrent workers
+	 * can reserve them by atomic operations without locks, then write
+	 * out the preloaded rows onto the shared buffer in parallel.
+	 */
+	base_nitems = __atomic_fetch_add(&kds->nitems, (uint32_t)nitems,
+									 __ATOMIC_RELAXED);
+	base_usage  = __atomic_fetch_add(&kds->usage, __kds_packed(usage),
+									 __ATOMIC_RELAXED);
+	/*
+	 * Sanity checks - KDS must be less than 32GB because of 32-bit
+	 * offset design (it is always aligned to 64bit).
+	 */
+	if (KDS_HEAD_LENGTH(kds) +
+		MAXALIGN(sizeof(uint32_t) * (kds->hash_nslots +
+									 base_nitems +
+									 nitems)) +
+		__kds_unpack(base_usage) +
+		usage >= __KDS_LENGTH_LIMIT)
+		elog(ERROR, "Inner-KDS was expanding too large");
+
+	if (kds->format == KDS_FORMAT_ROW)
+		__innerPreloadSetupHeapBuffer(kds, istate,
+									  base_nitems,
+									  base_usage);
+	else if (kds->format == KDS_FORMAT_HASH)
+		__innerPreloadSetupHashBuffer(kds, pts, istate,
+									  base_nitems,
+									  base_usage,
+									  nbatches,
+									  batch_id,
+									  KERN_MULTIRELS_BLOOM_FILTER(h_kmrels, i),
+									  h_kmrels->chunks[i].bloom_nbits,
+									  KERN_MULTIRELS_HEAVY_HITTERS(h_kmrels, i));
+	else
+		elog(ERROR, "unexpected inner-KDS format");
+}
+
+/*
+ * __innerPreloadFixupHashValues
+ *
+ * Hash-batches are partitioned by the hash-value of the inner rows, so the
+ * host code calculates them instead of GPU kernel.
+ */
+static void
+__innerPreloadFixupHashValues(pgstromTaskState *pts,
+							  pgstromTaskInnerState *istate)
+{
+	inner_preload_buffer *preload_buf = istate->preload_buffer;
+	TupleTableSlot *slot;
+
+	slot = MakeSingleTupleTableSlot(ExecGetResultType(istate->ps),
+									&TTSOpsHeapTuple);
+	for (uint32_t index=0; index < preload_buf->nitems; index++)
+	{
+		ExecStoreHeapTuple(preload_buf->rows[index].htup, slot, false);
+		slot_getallattrs(slot);
+		preload_buf->rows[index].hash = get_tuple_hashvalue(pts, istate, slot);
+	}
+	ExecDropSingleTupleTableSlot(slot);
+	istate->hash_build_on_device = false;
+}
+
+/*
+ * __innerPreloadMultiGpuInner
+ *
+ * It returns true, if the inner buffer shall be split over multiple GPUs;
+ * the same conditions to set join_inner_multi_gpu in pgstromBuildSessionInfo
+ * except for the hash-batches.
+ */
+static bool
+__innerPreloadMultiGpuInner(pgstromTaskState *pts)
+{
+	return (pgstrom_gpujoin_multi_gpu_inner &&
+			numGpuDevAttrs > 1 &&
+			(pts->xpu_task_flags & DEVTASK__PREAGG) == 0 &&
+			pts->pp_info->gpuwin_desc == NULL &&
+			pts->inner_cache_fingerprint == 0 &&
+			!pts->inner_rescan_keep &&
+			!pts->inner_sibling);
+}
+
+/*
+ * innerPreloadSetupBatches
+ *
+ * When the inner buffer is larger than pg_strom.gpujoin_inner_buffer_limit,
+ * rows of the largest hash-join depth are partitioned into multiple batches
+ * by their hash value. Only one batch is loaded to the device memory at once,
+ * and the outer relation is scanned again for each batch. The preloaded rows
+ * stay in the host memory (memcxt) until the last batch.
+ *
+ * NOTE: This function is called with preload_mutex locked
+ */
+static void
+innerPreloadSetupBatches(pgstromTaskState *pts, MemoryContext memcxt)
+{
+	pgstromSharedState *ps_state = pts->ps_state;
+	inner_preload_buffer *preload_buf;
+	size_t		limit = (size_t)pgstrom_gpujoin_inner_buffer_limit << 10;
+	size_t		total_sz = 0;
+	size_t		batch_sz = 0;
+	size_t		avail_sz;
+	uint32_t	nbatches;
+	int			depth = 0;
+
+	/*
+	 * Only non-parallel GpuJoin can rescan the outer relation for each batch.
+	 * DpuJoin does not support hash-batches right now. GpuWindow also needs
+	 * all the rows in a single per-query buffer, and GpuPreAgg without the
+	 * upper Agg node must build unique groups on a single kds_final.
+	 */
+	if ((pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0 ||
+		ps_state->ss_handle != DSM_HANDLE_INVALID ||
+		pts->pp_info->gpuwin_desc != NULL ||
+		pts->pp_info->groupby_final_on_device ||
+		pts->inner_nbatches > 0 ||
+		numGpuDevAttrs == 0)
+		return;
+	if (limit == 0 && __innerPreloadMultiGpuInner(pts))
+	{
+		/*
+		 * auto configuration; half of the total device memory, because
+		 * the inner buffer is split over all the GPUs.
+		 */
+		for (int i=0; i < numGpuDevAttrs; i++)
+			limit += gpuDevAttrs[i].DEV_TOTAL_MEMSZ / 2;
+	}
+	else if (limit == 0)
+	{
+		/* auto configuration; half of the smallest GPU device memory */
+		for (int i=0; i < numGpuDevAttrs; i++)
+		{
+			size_t	sz = gpuDevAttrs[i].DEV_TOTAL_MEMSZ / 2;
+
+			if (i == 0 || sz < limit)
+				limit = sz;
+		}
+	}
+
+	for (int i=0; i < pts->num_rels; i++)
+	{
+		pgstromTaskInnerState *istate = &pts->inners[i];
+		uint64_t	nitems = pg_atomic_read_u64(&ps_state->inners[i].inner_nitems);
+		uint64_t	usage  = pg_atomic_read_u64(&ps_state->inners[i].inner_usage);
+		size_t		sz = MAXALIGN(usage) + 2 * MAXALIGN(sizeof(uint32_t) * nitems);
+
+		/* outer-join-map must track all the inner rows at once */
+		if (istate->join_type == JOIN_RIGHT ||
+			istate->join_type == JOIN_FULL)
+			return;
+		total_sz += sz;
+		if (istate->join_type == JOIN_INNER &&
+			istate->hash_inner_keys != NIL &&
+			istate->hash_outer_keys != NIL &&
+			istate->preload_buffer != NULL &&
+			sz > batch_sz)
+		{
+			batch_sz = sz;
+			depth = i+1;
+		}
+	}
+	if (total_sz <= limit || depth == 0)
+		return;
+	if (total_sz - batch_sz >= limit)
+	{
+		elog(DEBUG1, "GpuJoin: inner buffer (%zu bytes) exceeds the limit (%zu bytes), but unable to split into hash-batches",
+			 total_sz, limit);
+		return;
+	}
+	avail_sz = limit - (total_sz - batch_sz);
+	nbatches = Min((batch_sz + avail_sz - 1) / avail_sz,
+				   INNER_BATCH_MAX_NBATCHES);
+	nbatches = Max(nbatches, 2);
+
+	/* count rows and usage of each hash-batch */
+	preload_buf = pts->inners[depth-1].preload_buffer;
+	if (pts->inners[depth-1].hash_build_on_device)
+		__innerPreloadFixupHashValues(pts, &pts->inners[depth-1]);
+	pts->inner_batch_nitems = MemoryContextAllocZero(memcxt, sizeof(uint64_t) * nbatches);
+	pts->inner_batch_usage = MemoryContextAllocZero(memcxt, sizeof(uint64_t) * nbatches);
+	for (uint32_t index=0; index < preload_buf->nitems; index++)
+	{
+		HeapTuple	htup = preload_buf->rows[index].htup;
+		uint32_t	k = INNER_BATCH_ID(preload_buf->rows[index].hash, nbatches);
+
+		pts->inner_batch_nitems[k]++;
+		pts->inner_batch_usage[k] += MAXALIGN(offsetof(kern_hashitem,
+													   t.htup) + htup->t_len);
+	}
+	pts->inner_batch_depth = depth;
+	pts->inner_batch_id = 0;
+	pts->inner_batch_loaded = 0;
+	pts->inner_nbatches = nbatches;
+	pg_atomic_write_u64(&ps_state->inners[depth-1].inner_nitems,
+						pts->inner_batch_nitems[0]);
+	pg_atomic_write_u64(&ps_state->inners[depth-1].inner_usage,
+						pts->inner_batch_usage[0]);
+	/* preloaded rows must survive until the last batch */
+	MemoryContextSetParent(memcxt, pts->css.ss.ps.state->es_query_cxt);
+	pts->inner_batch_memcxt = memcxt;
+
+	elog(DEBUG1, "GpuJoin: inner buffer (%zu bytes) exceeds the limit (%zu bytes), so depth=%d is split into %u hash-batches",
+		 total_sz, limit, depth, nbatches);
+}
+
+/*
+ * innerPreloadSwitchBatch
+ *
+ * It rebuilds the host inner buffer with rows of the current hash-batch.
+ * A new shared memory segment is assigned for each batch, because GPU-Service
+ * may still map the previous one until its session is closed.
+ */
+static void
+innerPreloadSwitchBatch(pgstromTaskState *pts)
+{
+	pgstromSharedState *ps_state = pts->ps_state;
+	int			k = pts->inner_batch_depth - 1;
+	uint32_t	batch_id = pts->inner_batch_id;
+
+	Assert(ps_state->ss_handle == DSM_HANDLE_INVALID &&
+		   batch_id < pts->inner_nbatches);
+	if (pts->h_kmrels)
+	{
+		__munmapShmem(pts->h_kmrels);
+		pts->h_kmrels = NULL;
+	}
+	__shmemDrop(ps_state->preload_shmem_handle);
+	ps_state->preload_shmem_handle = 0;
+	ps_state->preload_shmem_handle = __shmemCreate(GpuJoinInnerShmemEntry(pts));
+	ps_state->preload_shmem_length = 0;
+
+	pg_atomic_write_u64(&ps_state->inners[k].inner_nitems,
+						pts->inner_batch_nitems[batch_id]);
+	pg_atomic_write_u64(&ps_state->inners[k].inner_usage,
+						pts->inner_batch_usage[batch_id]);
+	innerPreloadAllocHostBuffer(pts);
+	for (int i=0; i < pts->num_rels; i++)
+	{
+		innerPreloadSetupOneDepth(pts, pts->h_kmrels, i);
+		innerPreloadSetupHashBucket(pts, pts->h_kmrels, i);
+		innerPreloadSetupHashDirect(pts, pts->h_kmrels, i);
+		innerPreloadSetupRangeIndex(pts, pts->h_kmrels, i);
+		innerPreloadSetupInetIndex(pts, pts->h_kmrels, i);
+	}
+	pts->inner_batch_loaded = batch_id;
+}
+
+/*
+ * GpuJoinInnerCacheFingerprint
+ *
+ * It returns the fingerprint of the inner buffer if the GPU service can keep
+ * it after the query end for the following queries, or 0 if not cacheable.
+ * Inner buffers are identical if the same inner plans on the same relations
+ * run on the same MVCC snapshot, so the fingerprint is built from the plans,
+ * the relfilenodes and the snapshot (xmin, xmax and in-progress xids) instead
+ * of the xmin horizon only; any commit after the build makes it stale.
+ * Inner buffer must be read-only (no RIGHT/FULL OUTER JOIN) and built at once.
+ */
+uint64_t
+GpuJoinInnerCacheFingerprint(pgstromTaskState *pts, int eflags)
+{
+	EState	   *estate = pts->css.ss.ps.state;
+	Snapshot	snapshot = estate->es_snapshot;
+	CustomScan *cscan = (CustomScan *)pts->css.ss.ps.plan;
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	StringInfoData buf;
+	pg_cryptohash_ctx *hash_ctx;
+	uint64_t	fingerprint = 0;
+
+	if (pgstrom_gpujoin_inner_cache_size == 0 ||
+		pts->num_rels == 0 ||
+		(pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0 ||
+		(pts->xpu_task_flags & DEVTASK__PREAGG) != 0 ||
+		pp_info->gpuwin_desc != NULL ||
+		(eflags & EXEC_FLAG_REWIND) != 0 ||
+		cscan->scan.plan.parallel_aware ||
+		!bms_is_empty(cscan->scan.plan.allParam) ||
+		!IsMVCCSnapshot(snapshot) ||
+		TransactionIdIsValid(GetTopTransactionIdIfAny()))
+		return 0;
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "%u %u", MyDatabaseId, GetUserId());
+	for (int i=0; i < pts->num_rels; i++)
+	{
+		pgstromPlanInnerInfo *pp_inner = &pp_info->inners[i];
+		pgstromTaskInnerState *istate = &pts->inners[i];
+		Plan	   *plan = istate->ps->plan;
+		Relation	rel;
+
+		/* only simple scan on the inner relation is supported right now */
+		if (pp_inner->join_type == JOIN_RIGHT ||
+			pp_inner->join_type == JOIN_FULL ||
+			pp_inner->gist_clause != NULL ||
+			!IsA(plan, SeqScan) ||
+			!bms_is_empty(plan->allParam) ||
+			contain_subplans((Node *)plan->qual) ||
+			contain_mutable_functions((Node *)plan->qual) ||
+			contain_mutable_functions((Node *)plan->targetlist) ||
+			contain_mutable_functions((Node *)pp_inner->hash_inner_keys))
+			goto bailout;
+		rel = ((ScanState *)istate->ps)->ss_currentRelation;
+		appendStringInfo(&buf, " %u/%u %d %s %s %s",
+						 RelationGetRelid(rel),
+						 rel->rd_rel->relfilenode,
+						 (int)pp_inner->join_type,
+						 nodeToString(plan),
+						 nodeToString(pp_inner->hash_inner_keys),
+						 nodeToString(pp_inner->range_inner_key));
+	}
+	appendStringInfo(&buf, " %u %u", snapshot->xmin, snapshot->xmax);
+	for (int i=0; i < snapshot->xcnt; i++)
+		appendStringInfo(&buf, " %u", snapshot->xip[i]);
+	appendStringInfo(&buf, " %d", snapshot->suboverflowed);
+	for (int i=0; i < snapshot->subxcnt; i++)
+		appendStringInfo(&buf, " %u", snapshot->subxip[i]);
+
+	/*
+	 * The slot of GPU service keeps the SHA-256 digest of the whole text,
+	 * and the lookup compares it byte by byte; the leading 64 bits are just
+	 * the key of the slots and the query buffers.
+	 */
+	hash_ctx = pg_cryptohash_create(PG_SHA256);
+	if (!hash_ctx ||
+		pg_cryptohash_init(hash_ctx) != 0 ||
+		pg_cryptohash_update(hash_ctx, (const uint8 *)buf.data, buf.len) != 0 ||
+		pg_cryptohash_final(hash_ctx, pts->inner_cache_digest,
+							KERN_INNER_CACHE_DIGEST_LEN) != 0)
+	{
+		pg_cryptohash_free(hash_ctx);
+		elog(ERROR, "failed on SHA-256 of the GpuJoin inner buffer fingerprint");
+	}
+	pg_cryptohash_free(hash_ctx);
+	memcpy(&fingerprint, pts->inner_cache_digest, sizeof(uint64_t));
+	if (fingerprint == 0)
+		fingerprint = 1;	/* 0 means not cacheable */
+bailout:
+	pfree(buf.data);
+	return fingerprint;
+}
+
+/*
+ * GpuJoinInnerCacheAttach
+ *
+ * It maps the inner buffer kept by the GPU service, if any, instead of the
+ * inner preloading. It returns the shared memory handle to be sent with the
+ * session, or 0 if no cached buffer is available.
+ */
+uint32_t
+GpuJoinInnerCacheAttach(pgstromTaskState *pts)
+{
+	int			cuda_dindex;
+	uint32_t	shmem_handle;
+	size_t		kmrels_sz;
+
+	if (pts->inner_cache_fingerprint == 0)
+		return 0;
+	/* parallel workers must be on the same GPU for the unique groups */
+	if (pts->pp_info->groupby_final_on_device &&
+		pts->css.ss.ps.plan->parallel_aware)
+		return 0;
+	/* inner buffer is already built by the preloading */
+	if (pts->h_kmrels && pts->inner_cache_handle == 0)
+		return 0;
+	if (!gpuservLookupInnerCache(pts->inner_cache_fingerprint,
+								 pts->inner_cache_digest,
+								 pts->optimal_gpus,
+								 &cuda_dindex,
+								 &shmem_handle,
+								 &kmrels_sz) ||
+		(pts->inner_cache_handle == 0 &&
+		 !gpuClientDeviceIsAllowed(cuda_dindex)))
+	{
+		if (pts->inner_cache_handle != 0)
+			elog(ERROR, "GpuJoin inner buffer cache was released during the scan");
+		return 0;
+	}
+	if (pts->inner_cache_handle == 0)
+	{
+		pts->h_kmrels = __mmapShmem(shmem_handle, kmrels_sz, NULL);
+		pts->inner_cache_handle = shmem_handle;
+	}
+	else if (pts->inner_cache_handle != shmem_handle)
+		elog(ERROR, "GpuJoin inner buffer cache was replaced during the scan");
+	pts->inner_cache_dindex = cuda_dindex;
+
+	return shmem_handle;
+}
+
+/*
+ * __gpuJoinNextInnerGeneration
+ *
+ * It returns an inner generation unique in this backend; query_plan_id is
+ * reused by the next query, so GPU service identifies the kept device inner
+ * buffer by the pair of them.
+ */
+static uint32_t
+__gpuJoinNextInnerGeneration(void)
+{
+	static uint32_t inner_generation = 0;
+
+	if (++inner_generation == 0)
+		inner_generation = 1;
+	return inner_generation;
+}
+
+/*
+ * GpuJoin inner buffer shared by the partition-wise siblings
+ *
+ * Partition-wise GpuJoin runs a GpuJoin for each partition leaf, but their
+ * inner relations are identical, and the planner assigned a PARAM_EXEC slot
+ * (sibling_param_id) for them. The first sibling that completed the inner
+ * preloading publishes itself on the slot, then the following siblings map
+ * its host inner buffer instead of the preloading, and open the session with
+ * the same query_plan_id and inner generation, so GPU service also reuses
+ * the device inner buffer kept for a while after the previous session.
+ */
+static ParamExecData *
+__gpuJoinInnerSiblingParam(pgstromTaskState *pts)
+{
+	EState	   *estate = pts->css.ss.ps.state;
+	CustomScan *cscan = (CustomScan *)pts->css.ss.ps.plan;
+	pgstromPlanInfo *pp_info = pts->pp_info;
+
+	if (pp_info->sibling_param_id < 0 ||
+		pts->num_rels == 0 ||
+		(pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0 ||
+		((pts->xpu_task_flags & DEVTASK__PREAGG) != 0 &&
+		 pp_info->groupby_nsiblings == 0) ||
+		pp_info->gpuwin_desc != NULL ||
+		pts->inner_cache_fingerprint != 0 ||
+		pts->inner_rescan_keep ||
+		cscan->scan.plan.parallel_aware ||
+		pts->ps_state->ss_handle != DSM_HANDLE_INVALID)
+		return NULL;
+	/* outer-join-map of RIGHT/FULL OUTER JOIN is updated by the scan */
+	for (int i=0; i < pp_info->num_rels; i++)
+	{
+		JoinType	join_type = pp_info->inners[i].join_type;
+
+		if (join_type == JOIN_RIGHT || join_type == JOIN_FULL)
+			return NULL;
+	}
+	Assert(pp_info->sibling_param_id < list_length(estate->es_plannedstmt->paramExecTypes));
+	return &estate->es_param_exec_vals[pp_info->sibling_param_id];
+}
+
+static bool
+__gpuJoinInnerSiblingIsCompatible(pgstromTaskState *leader,
+								  pgstromTaskState *pts)
+{
+	if (leader->num_rels != pts->num_rels ||
+		leader->inner_nbatches > 1 ||
+		!leader->h_kmrels)
+		return false;
+	for (int i=0; i < pts->num_rels; i++)
+	{
+		pgstromPlanInnerInfo *l_inner = &leader->pp_info->inners[i];
+		pgstromPlanInnerInfo *p_inner = &pts->pp_info->inners[i];
+		Plan	   *l_plan = leader->inners[i].ps->plan;
+		Plan	   *p_plan = pts->inners[i].ps->plan;
+
+		if (l_inner->join_type != p_inner->join_type ||
+			!equal(l_inner->hash_inner_keys, p_inner->hash_inner_keys) ||
+			!equal(l_inner->range_inner_key, p_inner->range_inner_key) ||
+			!equal(l_inner->gist_clause, p_inner->gist_clause) ||
+			!equal(l_plan->targetlist, p_plan->targetlist) ||
+			!equal(l_plan->qual, p_plan->qual))
+			return false;
+	}
+	return true;
+}
+
+static uint32_t
+__gpuJoinInnerSiblingAttach(pgstromTaskState *pts)
+{
+	ParamExecData *prm = __gpuJoinInnerSiblingParam(pts);
+	pgstromTaskState *leader;
+
+	if (!prm || prm->isnull || prm->value == 0)
+		return 0;
+	leader = (pgstromTaskState *)DatumGetPointer(prm->value);
+	if (leader == pts ||
+		!__gpuJoinInnerSiblingIsCompatible(leader, pts))
+		return 0;
+	if (!pts->h_kmrels)
+		pts->h_kmrels = __mmapShmem(leader->ps_state->preload_shmem_handle,
+									leader->ps_state->preload_shmem_length,
+									GpuJoinInnerShmemEntry(leader));
+	pts->inner_sibling = leader;
+	pts->inner_generation = leader->inner_generation;
+	__gpuJoinDynamicFilterAssign(pts, leader->ps_state);
+	elog(DEBUG2, "GpuJoin: inner buffer is shared with the sibling (plan_node_id=%d)",
+		 leader->css.ss.ps.plan->plan_node_id);
+	return leader->ps_state->preload_shmem_handle;
+}
+
+static void
+__gpuJoinInnerSiblingPublish(pgstromTaskState *pts)
+{
+	ParamExecData *prm = __gpuJoinInnerSiblingParam(pts);
+
+	if (!prm || prm->value != 0 || pts->inner_nbatches > 1)
+		return;
+	pts->inner_sibling = pts;
+	pts->inner_generation = __gpuJoinNextInnerGeneration();
+	prm->value = PointerGetDatum(pts);
+	prm->isnull = false;
+}
+
+/*
+ * GpuJoinDynamicFilterExecInit / __gpuJoinDynamicFilterAssign
+ *
+ * The PARAM_EXEC slots of the dynamic filter must not filter out anything
+ * until the inner preloading (or when the inner buffer is attached from the
+ * cache), so they are initialized to the entire range of the data type.
+ */
+static void
+__dynamicFilterTypeRange(Oid type_oid, int64_t *p_lower, int64_t *p_upper)
+{
+	switch (type_oid)
+	{
+		case INT2OID:
+			*p_lower = PG_INT16_MIN;
+			*p_upper = PG_INT16_MAX;
+			break;
+		case INT4OID:
+		case DATEOID:
+			*p_lower = PG_INT32_MIN;
+			*p_upper = PG_INT32_MAX;
+			break;
+		default:	/* int8, timestamp and timestamptz */
+			*p_lower = PG_INT64_MIN;
+			*p_upper = PG_INT64_MAX;
+			break;
+	}
+}
+
+static void
+__dynamicFilterSetParam(EState *estate, int param_id,
+						Oid type_oid, int64_t ival)
+{
+	ParamExecData *prm = &estate->es_param_exec_vals[param_id];
+
+	Assert(param_id < list_length(estate->es_plannedstmt->paramExecTypes));
+	prm->execPlan = NULL;
+	switch (type_oid)
+	{
+		case INT2OID:
+			prm->value = Int16GetDatum(ival);
+			break;
+		case INT4OID:
+			prm->value = Int32GetDatum(ival);
+			break;
+		case DATEOID:
+			prm->value = DateADTGetDatum(ival);
+			break;
+		default:	/* int8, timestamp and timestamptz */
+			prm->value = Int64GetDatum(ival);
+			break;
+	}
+	prm->isnull = false;
+}
+
+static void
+__gpuJoinDynamicFilterAssign(pgstromTaskState *pts,
+							 pgstromSharedState *ps_state)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	EState	   *estate = pts->css.ss.ps.state;
+
+	for (int i=0; i < pp_info->num_rels; i++)
+	{
+		pgstromPlanInnerInfo *pp_inner = &pp_info->inners[i];
+		Node	   *outer_key;
+		Oid			type_oid;
+		int64_t		lower;
+		int64_t		upper;
+
+		if (pp_inner->dfilter_keynum == 0)
+			continue;
+		outer_key = list_nth(pp_inner->hash_outer_keys,
+							 pp_inner->dfilter_keynum - 1);
+		type_oid = exprType(outer_key);
+		__dynamicFilterTypeRange(type_oid, &lower, &upper);
+		if (ps_state)
 		{
-			nbytes = MAXALIGN(sizeof(bool) * nrooms);
-			if (h_kmrels)
+			pgstromSharedInnerState *ps_inner = &ps_state->inners[i];
+
+			if (ps_inner->dfilter_nitems > 0)
 			{
-				h_kmrels->chunks[i].right_outer = true;
-				h_kmrels->chunks[i].ojmap_offset = offset;
-				memset((char *)h_kmrels + offset, 0, nbytes);
+				lower = ps_inner->dfilter_min;
+				upper = ps_inner->dfilter_max;
+			}
+			else
+			{
+				/* no inner rows to match, so empty range */
+				int64_t		temp = lower;
+
+				lower = upper;
+				upper = temp;
 			}
-			offset += nbytes;
-		}
-		if (istate->join_type == JOIN_LEFT ||
-			istate->join_type == JOIN_FULL)
-		{
-			if (h_kmrels)
-				h_kmrels->chunks[i].left_outer = true;
 		}
+		__dynamicFilterSetParam(estate, pp_inner->dfilter_param_id,
+								type_oid, lower);
+		__dynamicFilterSetParam(estate, pp_inner->dfilter_param_id + 1,
+								type_oid, upper);
 	}
+}
 
-	/*
-	 * allocation of the host inner-buffer
-	 */
-	if (!h_kmrels)
-	{
-		size_t		shmem_length = PAGE_ALIGN(offset);
+List *
+GpuJoinDynamicFilterExecInit(pgstromTaskState *pts)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	List	   *dfilter_quals = NIL;
 
-		Assert(ps_state->preload_shmem_handle != 0);
-		h_kmrels = __mmapShmem(ps_state->preload_shmem_handle,
-							   shmem_length, pts->ds_entry);
-		memset(h_kmrels, 0, offsetof(kern_multirels,
-									 chunks[pts->num_rels]));
-		h_kmrels->length = offset;
-		h_kmrels->num_rels = pts->num_rels;
-		ps_state->preload_shmem_length = shmem_length;
-		goto again;
+	for (int i=0; i < pp_info->num_rels; i++)
+	{
+		pgstromPlanInnerInfo *pp_inner = &pp_info->inners[i];
+		Expr	   *outer_key;
+		Oid			type_oid;
+		TypeCacheEntry *tcache;
+		Oid			ge_op;
+		Oid			le_op;
+		Expr	   *expr;
+
+		if (pp_inner->dfilter_keynum == 0)
+			continue;
+		outer_key = list_nth(pp_inner->hash_outer_keys,
+							 pp_inner->dfilter_keynum - 1);
+		type_oid = exprType((Node *)outer_key);
+		tcache = lookup_type_cache(type_oid, TYPECACHE_BTREE_OPFAMILY);
+		ge_op = get_opfamily_member(tcache->btree_opf, type_oid, type_oid,
+									BTGreaterEqualStrategyNumber);
+		le_op = get_opfamily_member(tcache->btree_opf, type_oid, type_oid,
+									BTLessEqualStrategyNumber);
+		if (!OidIsValid(ge_op) || !OidIsValid(le_op))
+			elog(ERROR, "btree operators of %s are not found",
+				 format_type_be(type_oid));
+		/* (OUTER_KEY >= $min) and (OUTER_KEY <= $max) */
+		expr = make_opclause(ge_op, BOOLOID, false,
+							 (Expr *)copyObject(outer_key),
+							 (Expr *)__makeDynamicFilterParam(pp_inner->dfilter_param_id,
+															  type_oid),
+							 InvalidOid, InvalidOid);
+		set_opfuncid((OpExpr *)expr);
+		dfilter_quals = lappend(dfilter_quals, expr);
+		expr = make_opclause(le_op, BOOLOID, false,
+							 (Expr *)copyObject(outer_key),
+							 (Expr *)__makeDynamicFilterParam(pp_inner->dfilter_param_id + 1,
+															  type_oid),
+							 InvalidOid, InvalidOid);
+		set_opfuncid((OpExpr *)expr);
+		dfilter_quals = lappend(dfilter_quals, expr);
 	}
-	pts->h_kmrels = h_kmrels;
+	__gpuJoinDynamicFilterAssign(pts, NULL);
+
+	return dfilter_quals;
 }
 
 /*
- * __innerPreloadSetupHeapBuffer
+ * GpuJoinInnerShmemEntry
+ *
+ * It returns the DPU storage entry where the host inner buffer shall be
+ * built on, or NULL if it is built on the local /dev/shm. When DPU inner
+ * cache is available, the inner buffer is built locally, then published to
+ * the DPU as a read-only image named by the content digest, so the DPU
+ * service can reuse the image already loaded by the previous queries.
+ * RIGHT/FULL OUTER JOIN needs the outer-join-map written back by the DPU,
+ * and GiST-index needs the index pages, so they use the shared buffer.
  */
-static void
-__innerPreloadSetupHeapBuffer(kern_data_store *kds,
-							  pgstromTaskInnerState *istate,
-							  uint32_t base_nitems,
-							  uint32_t base_usage)
+const DpuStorageEntry *
+GpuJoinInnerShmemEntry(pgstromTaskState *pts)
 {
-	uint32_t   *row_index = KDS_GET_ROWINDEX(kds);
-	uint32_t	rowid = base_nitems;
-	char	   *tail_pos = (char *)kds + kds->length;
-	char	   *curr_pos = tail_pos - __kds_unpack(base_usage);
-	inner_preload_buffer *preload_buf = istate->preload_buffer;
+	pgstromPlanInfo *pp_info = pts->pp_info;
 
-	for (uint32_t index=0; index < preload_buf->nitems; index++)
+	if (!pts->ds_entry || !pgstrom_dpu_inner_cache)
+		return pts->ds_entry;
+	for (int i=0; i < pp_info->num_rels; i++)
 	{
-		HeapTuple	htup = preload_buf->rows[index].htup;
-		size_t		sz;
-		kern_tupitem *titem;
-
-		sz = MAXALIGN(offsetof(kern_tupitem, htup) + htup->t_len);
-		curr_pos -= sz;
-		titem = (kern_tupitem *)curr_pos;
-		titem->t_len = htup->t_len;
-		titem->rowid = rowid;
-		memcpy(&titem->htup, htup->t_data, htup->t_len);
-		memcpy(&titem->htup.t_ctid, &htup->t_self, sizeof(ItemPointerData));
+		pgstromPlanInnerInfo *pp_inner = &pp_info->inners[i];
 
-		row_index[rowid++] = __kds_packed(tail_pos - curr_pos);
+		if (pp_inner->join_type == JOIN_RIGHT ||
+			pp_inner->join_type == JOIN_FULL ||
+			pp_inner->gist_clause != NULL ||
+			pp_inner->gist_prep_resno > 0)
+			return pts->ds_entry;
 	}
+	return NULL;
 }
 
 /*
- * __innerPreloadSetupHashBuffer
+ * GpuJoinInnerImageDigest
+ *
+ * It returns the content digest of the inner image published to the DPU,
+ * or 0 if the inner buffer is shared with the DPU as is.
  */
-static void
-__innerPreloadSetupHashBuffer(kern_data_store *kds,
-							  pgstromTaskInnerState *istate,
-							  uint32_t base_nitems,
-							  uint32_t base_usage)
+uint64_t
+GpuJoinInnerImageDigest(pgstromTaskState *pts)
 {
-	uint32_t   *row_index = KDS_GET_ROWINDEX(kds);
-	uint32_t   *hash_slot = KDS_GET_HASHSLOT_BASE(kds);
-	uint32_t	rowid = base_nitems;
-	char	   *tail_pos = (char *)kds + kds->length;
-	char	   *curr_pos = tail_pos - __kds_unpack(base_usage);
-	inner_preload_buffer *preload_buf = istate->preload_buffer;
+	pgstromTaskState *leader = (pts->inner_sibling ? pts->inner_sibling : pts);
 
-	for (uint32_t index=0; index < preload_buf->nitems; index++)
-	{
-		HeapTuple	htup = preload_buf->rows[index].htup;
-		uint32_t	hash = preload_buf->rows[index].hash;
-		uint32_t	hindex = hash % kds->hash_nslots;
-		uint32_t	next, self;
-		size_t		sz;
-		kern_hashitem *hitem;
+	if (!pts->ds_entry || !leader->ps_state)
+		return 0;
+	return leader->ps_state->preload_inner_digest;
+}
 
-		sz = MAXALIGN(offsetof(kern_hashitem, t.htup) + htup->t_len);
-		curr_pos -= sz;
-		self = __kds_packed(tail_pos - curr_pos);
-		__atomic_exchange(&hash_slot[hindex], &self, &next,
-						  __ATOMIC_SEQ_CST);
-		hitem = (kern_hashitem *)curr_pos;
-		hitem->hash = hash;
-		hitem->next = next;
-		hitem->t.t_len = htup->t_len;
-		hitem->t.rowid = rowid;
-		memcpy(&hitem->t.htup, htup->t_data, htup->t_len);
-		memcpy(&hitem->t.htup.t_ctid, &htup->t_self, sizeof(ItemPointerData));
+/*
+ * __gpuJoinInnerImageDigest
+ *
+ * It calculates the content digest of the inner buffer. The order of the
+ * inner rows depends on the (parallel) inner scan, so the per-row hash is
+ * combined by the order independent manner. The index structures are
+ * built from the rows and the inner keys, so the inner keys are put into
+ * the digest, instead of their contents.
+ */
+static uint64_t
+__gpuJoinInnerImageDigest(pgstromTaskState *pts, kern_multirels *h_kmrels)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	uint64_t	digest;
 
-		row_index[rowid++] = __kds_packed(tail_pos - (char *)&hitem->t);
+	digest = hash_bytes_extended((const unsigned char *)h_kmrels,
+								 offsetof(kern_multirels,
+										  chunks[h_kmrels->num_rels]), 0);
+	for (int i=0; i < h_kmrels->num_rels; i++)
+	{
+		pgstromPlanInnerInfo *pp_inner = &pp_info->inners[i];
+		kern_data_store *kds = KERN_MULTIRELS_INNER_KDS(h_kmrels, i);
+		char	   *keys;
+		uint64_t	hsum = 0;
+		uint64_t	hxor = 0;
+
+		keys = psprintf("%s %s",
+						nodeToString(pp_inner->hash_inner_keys),
+						nodeToString(pp_inner->range_inner_key));
+		digest = hash_combine64(digest,
+								hash_bytes_extended((const unsigned char *)keys,
+													strlen(keys), 0));
+		pfree(keys);
+		if (!kds)
+			continue;
+		digest = hash_combine64(digest,
+								hash_bytes_extended((const unsigned char *)kds,
+													KDS_HEAD_LENGTH(kds), 0));
+		for (uint32_t k=0; k < kds->nitems; k++)
+		{
+			kern_tupitem *titem = KDS_GET_TUPITEM(kds, k);
+			uint64_t	seed = 0;
+			uint64_t	hash;
+
+			if (!titem)
+				continue;
+			if (kds->format == KDS_FORMAT_HASH)
+				seed = ((kern_hashitem *)((char *)titem -
+										  offsetof(kern_hashitem, t)))->hash;
+			hash = hash_bytes_extended((const unsigned char *)&titem->htup,
+									   titem->t_len, seed);
+			hsum += hash;
+			hxor ^= hash;
+		}
+		digest = hash_combine64(digest, hsum);
+		digest = hash_combine64(digest, hxor);
 	}
+	if (digest == 0)
+		digest = 1;		/* 0 means no inner image */
+	return digest;
 }
 
 #define INNER_PHASE__SCAN_RELATIONS		0
@@ -2088,10 +4842,12 @@ GpuJoinInnerPreload(pgstromTaskState *pts)
 	pgstromTaskState   *leader = pts;
 	pgstromSharedState *ps_state;
 	MemoryContext		memcxt;
+	uint32_t			shmem_handle;
 
-	//pick up leader's ps_state if partitionwise plan
-	//if (sibling is exist)
-	// leader = pts->sibling->leader;
+	/* partition-wise sibling may already build the identical one */
+	shmem_handle = __gpuJoinInnerSiblingAttach(pts);
+	if (shmem_handle != 0)
+		return shmem_handle;
 	ps_state = leader->ps_state;
 
 	/* memory context for temporary store  */
@@ -2114,9 +4870,7 @@ GpuJoinInnerPreload(pgstromTaskState *pts)
 			{
 				pgstromTaskInnerState *istate = &leader->inners[i];
 
-				execInnerPreloadOneDepth(memcxt, pts, istate,
-										 &ps_state->inners[i].inner_nitems,
-										 &ps_state->inners[i].inner_usage);
+				execInnerPreloadOneDepth(memcxt, pts, istate, ps_state);
 			}
 
 			/*
@@ -2165,6 +4919,7 @@ GpuJoinInnerPreload(pgstromTaskState *pts)
 			 */
 			PG_TRY();
 			{
+				innerPreloadSetupBatches(leader, memcxt);
 				innerPreloadAllocHostBuffer(leader);
 			}
 			PG_CATCH();
@@ -2182,63 +4937,56 @@ GpuJoinInnerPreload(pgstromTaskState *pts)
 			{
 				pts->h_kmrels = __mmapShmem(ps_state->preload_shmem_handle,
 											ps_state->preload_shmem_length,
-											pts->ds_entry);
+											GpuJoinInnerShmemEntry(pts));
 			}
 
 			for (int i=0; i < leader->num_rels; i++)
-			{
-				pgstromTaskInnerState *istate = &leader->inners[i];
-				inner_preload_buffer *preload_buf = istate->preload_buffer;
-				kern_data_store *kds = KERN_MULTIRELS_INNER_KDS(pts->h_kmrels, i);
-				uint64_t	base_nitems;
-				uint64_t	base_usage;
-
-				/*
-				 * If this backend/worker process called GpuJoinInnerPreload()
-				 * after the INNER_PHASE__SCAN_RELATIONS completed, it has no
-				 * preload_buf, thus, no tuples should be added.
-				 */
-				if (!preload_buf)
-					continue;
+				innerPreloadSetupOneDepth(leader, pts->h_kmrels, i);
 
-				SpinLockAcquire(&ps_state->preload_mutex);
+			/*
+			 * Wait for completion of the host buffer setup
+			 * by other concurrent workers
+			 */
+			SpinLockAcquire(&ps_state->preload_mutex);
+			if (ps_state->preload_nr_scanning == 0 &&
+				ps_state->preload_nr_setup == 1)
+			{
 				/*
-				 * Sanity checks - KDS must be less than 32GB because of 32-bit
-				 * offset design (it is always aligned to 64bit).
+				 * The last process builds R-tree of the GiST/spatial-join,
+				 * because it needs all the inner rows being loaded.
 				 */
-				if (KDS_HEAD_LENGTH(kds) +
-					MAXALIGN(sizeof(uint32_t) * (kds->hash_nslots +
-												 kds->nitems +
-												 preload_buf->nitems)) +
-					__kds_unpack(kds->usage) +
-					preload_buf->usage >= __KDS_LENGTH_LIMIT)
+				SpinLockRelease(&ps_state->preload_mutex);
+				for (int i=0; i < leader->num_rels; i++)
 				{
-					SpinLockRelease(&ps_state->preload_mutex);
-					elog(ERROR, "Inner-KDS was expanding too large");
+					pgstromTaskInnerState *istate = &leader->inners[i];
+					MemoryContext	oldcxt;
+
+					innerPreloadSetupHashBucket(leader, pts->h_kmrels, i);
+					innerPreloadSetupHashDirect(leader, pts->h_kmrels, i);
+					innerPreloadSetupRangeIndex(leader, pts->h_kmrels, i);
+					innerPreloadSetupInetIndex(leader, pts->h_kmrels, i);
+					if (!istate->gist_rtree && istate->gist_prep_resno == 0)
+						continue;
+					oldcxt = MemoryContextSwitchTo(memcxt);
+					if (istate->gist_rtree && istate->spatial_key != NULL)
+						innerPreloadSetupSpatialIndex(leader, pts->h_kmrels, i);
+					else if (istate->gist_rtree)
+						innerPreloadSetupGiSTRTree(leader, pts->h_kmrels, i);
+					if (istate->gist_prep_resno > 0)
+						innerPreloadSetupPrepGeometry(leader, pts->h_kmrels, i);
+					MemoryContextSwitchTo(oldcxt);
 				}
-				base_nitems  = kds->nitems;
-				kds->nitems += preload_buf->nitems;
-				base_usage   = kds->usage;
-				kds->usage  += __kds_packed(preload_buf->usage);
-				SpinLockRelease(&ps_state->preload_mutex);
+				/* publish the read-only inner image to the DPU, if any */
+				if (pts->ds_entry && !GpuJoinInnerShmemEntry(leader))
+				{
+					uint64_t	digest;
 
-				if (kds->format == KDS_FORMAT_ROW)
-					__innerPreloadSetupHeapBuffer(kds, istate,
-												  base_nitems,
-												  base_usage);
-				else if (kds->format == KDS_FORMAT_HASH)
-					__innerPreloadSetupHashBuffer(kds, istate,
-												  base_nitems,
-												  base_usage);
-				else
-					elog(ERROR, "unexpected inner-KDS format");
+					digest = __gpuJoinInnerImageDigest(leader, pts->h_kmrels);
+					DpuInnerCachePublish(pts->ds_entry, digest, pts->h_kmrels);
+					ps_state->preload_inner_digest = digest;
+				}
+				SpinLockAcquire(&ps_state->preload_mutex);
 			}
-
-			/*
-			 * Wait for completion of the host buffer setup
-			 * by other concurrent workers
-			 */
-			SpinLockAcquire(&ps_state->preload_mutex);
 			ps_state->preload_nr_setup--;
 			if (ps_state->preload_nr_scanning == 0 &&
 				ps_state->preload_nr_setup == 0)
@@ -2272,7 +5020,7 @@ GpuJoinInnerPreload(pgstromTaskState *pts)
 			{
 				pts->h_kmrels = __mmapShmem(ps_state->preload_shmem_handle,
 											ps_state->preload_shmem_length,
-											pts->ds_entry);
+											GpuJoinInnerShmemEntry(pts));
 			}
 
 			//TODO: send the shmem handle to the GPU server or DPU server
@@ -2285,13 +5033,124 @@ GpuJoinInnerPreload(pgstromTaskState *pts)
 			break;
 	}
 	SpinLockRelease(&ps_state->preload_mutex);
-	/* release working memory */
-	MemoryContextDelete(memcxt);
+	/* hash-batched GpuJoin switches the inner buffer, if needed */
+	if (pts->inner_nbatches > 1 &&
+		pts->inner_batch_loaded != pts->inner_batch_id)
+		innerPreloadSwitchBatch(pts);
+	/* release working memory, unless it keeps rows of the hash-batches */
+	if (memcxt != pts->inner_batch_memcxt)
+		MemoryContextDelete(memcxt);
 	Assert(pts->h_kmrels != NULL);
+	/* min/max of the inner keys are delivered to the outer scan */
+	__gpuJoinDynamicFilterAssign(pts, ps_state);
+	/* the following siblings can share the inner buffer */
+	__gpuJoinInnerSiblingPublish(pts);
 
 	return ps_state->preload_shmem_handle;
 }
 
+/*
+ * GpuJoinInnerRescanKeep
+ *
+ * It checks whether GPU service can keep the device inner buffer across the
+ * rescans, like the inner side of NestLoop or the correlated sub-plan.
+ * Outer-join-map of RIGHT/FULL OUTER JOIN is updated by the scan, so it
+ * cannot be reused.
+ */
+bool
+GpuJoinInnerRescanKeep(pgstromTaskState *pts, int eflags)
+{
+	CustomScan *cscan = (CustomScan *)pts->css.ss.ps.plan;
+	pgstromPlanInfo *pp_info = pts->pp_info;
+
+	if (pts->num_rels == 0 ||
+		(pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0 ||
+		(pts->xpu_task_flags & DEVTASK__PREAGG) != 0 ||
+		pp_info->gpuwin_desc != NULL ||
+		pts->inner_cache_fingerprint != 0 ||
+		cscan->scan.plan.parallel_aware ||
+		((eflags & EXEC_FLAG_REWIND) == 0 &&
+		 bms_is_empty(cscan->scan.plan.allParam)))
+		return false;
+	for (int i=0; i < pp_info->num_rels; i++)
+	{
+		JoinType	join_type = pp_info->inners[i].join_type;
+
+		if (join_type == JOIN_RIGHT || join_type == JOIN_FULL)
+			return false;
+	}
+	pts->inner_generation = __gpuJoinNextInnerGeneration();
+	return true;
+}
+
+/*
+ * GpuJoinInnerRescan
+ *
+ * It propagates the changed parameters to the inner plans on rescan. The
+ * inner buffer is rebuilt only if any inner plan depends on them; elsewhere,
+ * the host buffer and the device buffer kept by GPU service are reused, so
+ * the rescan costs kernel launches, not a preload.
+ */
+void
+GpuJoinInnerRescan(pgstromTaskState *pts)
+{
+	pgstromSharedState *ps_state = pts->ps_state;
+	Bitmapset  *chgParam = pts->css.ss.ps.chgParam;
+	bool		rebuild = false;
+
+	for (int i=0; i < pts->num_rels; i++)
+	{
+		PlanState  *ps = pts->inners[i].ps;
+
+		if (chgParam)
+			UpdateChangedParamSet(ps, chgParam);
+		if (ps->chgParam != NULL)
+			rebuild = true;
+	}
+	/* parallel workers may still map the shared inner buffer */
+	if (!rebuild || !ps_state ||
+		ps_state->ss_handle != DSM_HANDLE_INVALID ||
+		ps_state->preload_phase == INNER_PHASE__SCAN_RELATIONS)
+		return;
+	Assert(pts->inner_cache_handle == 0);
+
+	if (pts->h_kmrels)
+	{
+		__munmapShmem(pts->h_kmrels);
+		pts->h_kmrels = NULL;
+	}
+	__shmemDrop(ps_state->preload_shmem_handle);
+	ps_state->preload_shmem_handle = 0;
+	ps_state->preload_shmem_handle = __shmemCreate(GpuJoinInnerShmemEntry(pts));
+	ps_state->preload_shmem_length = 0;
+	ps_state->preload_inner_digest = 0;
+	ps_state->preload_phase = INNER_PHASE__SCAN_RELATIONS;
+	ps_state->preload_nr_scanning = 0;
+	ps_state->preload_nr_setup = 0;
+	for (int i=0; i < pts->num_rels; i++)
+	{
+		pg_atomic_write_u64(&ps_state->inners[i].inner_nitems, 0);
+		pg_atomic_write_u64(&ps_state->inners[i].inner_usage, 0);
+		ps_state->inners[i].dfilter_nitems = 0;
+		ExecReScan(pts->inners[i].ps);
+	}
+	/* hash-batches are re-planned on the new inner rows */
+	if (pts->inner_batch_memcxt)
+	{
+		MemoryContextDelete(pts->inner_batch_memcxt);
+		pts->inner_batch_memcxt = NULL;
+	}
+	pts->inner_batch_depth = 0;
+	pts->inner_batch_loaded = 0;
+	pts->inner_nbatches = 0;
+	pts->inner_batch_nitems = NULL;
+	pts->inner_batch_usage = NULL;
+	/* GPU service must not reuse the device buffer of the old inner rows */
+	if (pts->inner_rescan_keep)
+		GpuJoinInnerRescanKeep(pts, EXEC_FLAG_REWIND);
+	elog(DEBUG2, "GpuJoin: inner buffer is rebuilt by the changed parameters");
+}
+
 /*
  * CPU Fallback for JOIN
  */
@@ -2421,6 +5280,32 @@ __execFallbackLoadVarsSlot(TupleTableSlot *fallback_slot,
 	}
 }
 
+/*
+ * __execFallbackCpuAntiJoin
+ *
+ * It moves to the next depth with NULL inner values, if ANTI JOIN found
+ * no matched inner rows.
+ */
+static void
+__execFallbackCpuAntiJoin(pgstromTaskState *pts, int depth)
+{
+	pgstromTaskInnerState *istate = &pts->inners[depth-1];
+	ExprContext    *econtext = pts->css.ss.ps.ps_ExprContext;
+	TupleTableSlot *scan_slot = pts->css.ss.ss_ScanTupleSlot;
+	ListCell	   *lc;
+
+	foreach (lc, istate->inner_load_dst)
+	{
+		int		dst = lfirst_int(lc);
+
+		scan_slot->tts_isnull[dst] = true;
+		scan_slot->tts_values[dst] = 0;
+	}
+	if (istate->other_quals == NULL ||
+		ExecQual(istate->other_quals, econtext))
+		__execFallbackCpuJoinOneDepth(pts, depth+1);
+}
+
 static void
 __execFallbackCpuNestLoop(pgstromTaskState *pts,
 						  kern_data_store *kds_in,
@@ -2453,10 +5338,13 @@ __execFallbackCpuNestLoop(pgstromTaskState *pts,
 									   &tupitem->htup);
 		}
 		/* check JOIN-clause */
-		if (istate->join_quals != NULL ||
+		if (istate->join_quals == NULL ||
 			ExecQual(istate->join_quals, econtext))
 		{
-			if (istate->other_quals != NULL ||
+			/* ANTI JOIN emits nothing once matched */
+			if (istate->join_type == JOIN_ANTI)
+				return;
+			if (istate->other_quals == NULL ||
 				ExecQual(istate->other_quals, econtext))
 			{
 				/* Ok, go to the next depth */
@@ -2465,13 +5353,58 @@ __execFallbackCpuNestLoop(pgstromTaskState *pts,
 			/* mark outer-join map, if any */
 			if (oj_map)
 				oj_map[index] = true;
+			/* SEMI JOIN emits the first match only */
+			if (istate->join_type == JOIN_SEMI)
+				return;
 		}
 	}
+	if (istate->join_type == JOIN_ANTI)
+		__execFallbackCpuAntiJoin(pts, depth);
+}
+
+/*
+ * __execFallbackHashNextItem
+ *
+ * It returns the next inner row of the hash value; rows of the heavy-hitter
+ * runs follow the hash-slot chain.
+ */
+static kern_hashitem *
+__execFallbackHashNextItem(kern_data_store *kds_in,
+						   kern_hash_heavy *heavy,
+						   uint32_t hash,
+						   kern_hashitem *hitem,
+						   uint32_t *p_run_id,
+						   uint32_t *p_row_id)
+{
+	kern_tupitem   *titem;
+
+	if (*p_run_id == 0)
+	{
+		hitem = (!hitem
+				 ? KDS_HASH_FIRST_ITEM(kds_in, hash)
+				 : KDS_HASH_NEXT_ITEM(kds_in, hitem->next));
+		if (hitem || !heavy)
+			return hitem;
+		*p_run_id = KERN_HASH_HEAVY_LOOKUP(heavy, hash);
+		if (*p_run_id == 0)
+			return NULL;
+		*p_row_id = heavy->runs[*p_run_id-1].head;
+	}
+	else if (++(*p_row_id) >= heavy->runs[*p_run_id-1].tail)
+	{
+		*p_run_id = heavy->runs[*p_run_id-1].next;
+		if (*p_run_id == 0)
+			return NULL;
+		*p_row_id = heavy->runs[*p_run_id-1].head;
+	}
+	titem = KDS_GET_TUPITEM(kds_in, *p_row_id);
+	return (kern_hashitem *)((char *)titem - offsetof(kern_hashitem, t));
 }
 
 static void
 __execFallbackCpuHashJoin(pgstromTaskState *pts,
 						  kern_data_store *kds_in,
+						  kern_hash_heavy *heavy,
 						  bool *oj_map, int depth)
 {
 	pgstromTaskInnerState *istate = &pts->inners[depth-1];
@@ -2479,6 +5412,8 @@ __execFallbackCpuHashJoin(pgstromTaskState *pts,
 	TupleTableSlot *scan_slot = pts->css.ss.ss_ScanTupleSlot;
 	kern_hashitem  *hitem;
 	uint32_t		hash;
+	uint32_t		run_id = 0;
+	uint32_t		row_id = 0;
 	ListCell	   *lc1, *lc2;
 
 	Assert(kds_in->format == KDS_FORMAT_HASH);
@@ -2503,9 +5438,11 @@ __execFallbackCpuHashJoin(pgstromTaskState *pts,
 	/*
 	 * walks on the hash-join-table
 	 */
-	for (hitem = KDS_HASH_FIRST_ITEM(kds_in, hash);
+	for (hitem = __execFallbackHashNextItem(kds_in, heavy, hash, NULL,
+											&run_id, &row_id);
 		 hitem != NULL;
-		 hitem = KDS_HASH_NEXT_ITEM(kds_in, hitem->next))
+		 hitem = __execFallbackHashNextItem(kds_in, heavy, hash, hitem,
+											&run_id, &row_id))
 	{
 		if (hitem->hash != hash)
 			continue;
@@ -2526,6 +5463,9 @@ __execFallbackCpuHashJoin(pgstromTaskState *pts,
 		if (istate->join_quals == NULL ||
 			ExecQual(istate->join_quals, econtext))
 		{
+			/* ANTI JOIN emits nothing once matched */
+			if (istate->join_type == JOIN_ANTI)
+				return;
 			if (istate->other_quals == NULL ||
 				ExecQual(istate->other_quals, econtext))
 			{
@@ -2535,8 +5475,13 @@ __execFallbackCpuHashJoin(pgstromTaskState *pts,
 			/* mark outer-join map, if any */
 			if (oj_map)
 				oj_map[hitem->t.rowid] = true;
+			/* SEMI JOIN emits the first match only */
+			if (istate->join_type == JOIN_SEMI)
+				return;
 		}
 	}
+	if (istate->join_type == JOIN_ANTI)
+		__execFallbackCpuAntiJoin(pts, depth);
 }
 
 static void
@@ -2579,15 +5524,10 @@ __execFallbackCpuJoinOneDepth(pgstromTaskState *pts, int depth)
 	{
 		/* apply projection if any */
 		TupleTableSlot *scan_slot = pts->css.ss.ss_ScanTupleSlot;
-		HeapTuple	tuple;
 
 		if (pts->fallback_proj)
 			__execFallbackCpuProjection(pts);
-		tuple = heap_form_tuple(scan_slot->tts_tupleDescriptor,
-								scan_slot->tts_values,
-								scan_slot->tts_isnull);
-		pgstromStoreFallbackTuple(pts, tuple);
-		pfree(tuple);
+		pgstromStoreFallbackSlot(pts, scan_slot);
 	}
 	else
 	{
@@ -2603,7 +5543,9 @@ __execFallbackCpuJoinOneDepth(pgstromTaskState *pts, int depth)
 		}
 		else
 		{
-			__execFallbackCpuHashJoin(pts, kds_in, oj_map, depth);
+			__execFallbackCpuHashJoin(pts, kds_in,
+									  KERN_MULTIRELS_HEAVY_HITTERS(h_kmrels, depth-1),
+									  oj_map, depth);
 		}
 	}
 }
@@ -2612,14 +5554,13 @@ bool
 ExecFallbackCpuJoin(pgstromTaskState *pts, HeapTuple tuple)
 {
 	ExprContext    *econtext = pts->css.ss.ps.ps_ExprContext;
-	TupleTableSlot *base_slot = pts->base_slot;
+	TupleTableSlot *base_slot;
 	TupleTableSlot *scan_slot = pts->css.ss.ss_ScanTupleSlot;
-	size_t			fallback_index_saved = pts->fallback_index;
+	size_t			fallback_nitems_saved = pts->fallback_nitems;
 	ListCell	   *lc1, *lc2;
 
 	/* Load the base tuple (depth-0) to the fallback slot */
-	ExecForceStoreHeapTuple(tuple, base_slot, false);
-	slot_getallattrs(base_slot);
+	base_slot = pgstromLoadFallbackBaseTuple(pts, tuple);
 	ExecStoreAllNullTuple(scan_slot);
 	forboth (lc1, pts->fallback_load_src,
 			 lc2, pts->fallback_load_dst)
@@ -2641,7 +5582,7 @@ ExecFallbackCpuJoin(pgstromTaskState *pts, HeapTuple tuple)
 	}
 	/* Run JOIN, if any */
 	__execFallbackCpuJoinOneDepth(pts, 1);
-	return (pts->fallback_index -  fallback_index_saved > 0);
+	return (pts->fallback_nitems > fallback_nitems_saved);
 }
 
 static void
@@ -2703,6 +5644,33 @@ ExecFallbackCpuJoinRightOuter(pgstromTaskState *pts)
 	}
 }
 
+/*
+ * GpuJoinRightOuterOnDevice
+ *
+ * It checks whether the GPU device can emit the unmatched inner rows of
+ * RIGHT/FULL OUTER JOIN on XpuTaskFinal, instead of the CPU fallback.
+ * Only GpuPreAgg is supported, because these rows are aggregated on the
+ * final buffer of the device.
+ */
+bool
+GpuJoinRightOuterOnDevice(pgstromTaskState *pts)
+{
+	if (!pgstrom_enable_gpujoin_right_outer ||
+		(pts->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0 ||
+		(pts->xpu_task_flags & DEVTASK__PREAGG) == 0 ||
+		pts->pp_info->gpuwin_desc != NULL ||
+		!pts->h_kmrels)
+		return false;
+	for (int depth=1; depth <= pts->num_rels; depth++)
+	{
+		JoinType	join_type = pts->inners[depth-1].join_type;
+
+		if (join_type == JOIN_RIGHT || join_type == JOIN_FULL)
+			return true;
+	}
+	return false;
+}
+
 void
 ExecFallbackCpuJoinOuterJoinMap(pgstromTaskState *pts, XpuCommand *resp)
 {
@@ -2746,6 +5714,24 @@ __pgstrom_init_xpujoin_common(void)
 								 PGC_USERSET,
 								 GUC_NOT_IN_SAMPLE,
 								 NULL, NULL, NULL);
+		/* pg_strom.enable_xpujoin_bloom_filter */
+		DefineCustomBoolVariable("pg_strom.enable_xpujoin_bloom_filter",
+								 "Enables bloom filter of the inner hash-keys pushed down to the outer scan",
+								 NULL,
+								 &pgstrom_enable_xpujoin_bloom_filter,
+								 true,
+								 PGC_USERSET,
+								 GUC_NOT_IN_SAMPLE,
+								 NULL, NULL, NULL);
+		/* pg_strom.enable_xpujoin_dynamic_filter */
+		DefineCustomBoolVariable("pg_strom.enable_xpujoin_dynamic_filter",
+								 "Enables min/max of the inner hash-keys pushed down to the BRIN-index or arrow_fdw statistics of the outer scan",
+								 NULL,
+								 &pgstrom_enable_xpujoin_dynamic_filter,
+								 true,
+								 PGC_USERSET,
+								 GUC_NOT_IN_SAMPLE,
+								 NULL, NULL, NULL);
 		/* hook registration */
 		set_join_pathlist_next = set_join_pathlist_hook;
 		set_join_pathlist_hook = XpuJoinAddCustomPath;
@@ -2787,6 +5773,15 @@ pgstrom_init_gpu_join(void)
 							 PGC_USERSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* turn on/off gpuspatialjoin */
+	DefineCustomBoolVariable("pg_strom.enable_gpuspatialjoin",
+							 "Enables the use of spatial GpuJoin without GiST index",
+							 NULL,
+							 &pgstrom_enable_gpuspatialjoin,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	/* turn on/off partition-wise gpujoin */
 	DefineCustomBoolVariable("pg_strom.enable_partitionwise_gpujoin",
 							 "Enables the use of partition-wise GpuJoin",
@@ -2796,6 +5791,104 @@ pgstrom_init_gpu_join(void)
 							 PGC_USERSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* turn on/off inner buffer split over multiple GPUs */
+	DefineCustomBoolVariable("pg_strom.gpujoin_multi_gpu_inner",
+							 "Enables to split GpuJoin inner buffer over multiple GPUs",
+							 NULL,
+							 &pgstrom_gpujoin_multi_gpu_inner,
+							 false,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* threshold to split the inner buffer into hash-batches */
+	DefineCustomIntVariable("pg_strom.gpujoin_inner_buffer_limit",
+							"Max size of GpuJoin inner buffer; larger one is split into hash-batches (0 = auto)",
+							NULL,
+							&pgstrom_gpujoin_inner_buffer_limit,
+							0,
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
+	/* device memory to keep the inner buffers for the following queries */
+	DefineCustomIntVariable("pg_strom.gpujoin_inner_cache_size",
+							"Max size of GpuJoin inner buffers kept on each GPU for the following queries (0 = disabled)",
+							NULL,
+							&pgstrom_gpujoin_inner_cache_size,
+							0,
+							0,
+							INT_MAX,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
+	/* threshold to build the inner hash table on the GPU device */
+	DefineCustomIntVariable("pg_strom.gpujoin_device_hash_build_threshold",
+							"Min number of inner rows to build the GpuJoin hash table on the GPU device (0 = disabled)",
+							NULL,
+							&pgstrom_gpujoin_device_hash_build_threshold,
+							500000,
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	/* pg_strom.enable_gpujoin_hash_bucket */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_hash_bucket",
+							 "Enables the bucketized index of the GpuHashJoin inner hash table",
+							 NULL,
+							 &pgstrom_enable_gpujoin_hash_bucket,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* pg_strom.enable_gpujoin_direct_map */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_direct_map",
+							 "Enables the direct-mapped index of GpuHashJoin for the dense integer keys",
+							 NULL,
+							 &pgstrom_enable_gpujoin_direct_map,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* pg_strom.enable_gpujoin_range_index */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_range_index",
+							 "Enables the sorted inner rows for range clauses of GpuNestLoop",
+							 NULL,
+							 &pgstrom_enable_gpujoin_range_index,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* pg_strom.enable_gpujoin_inet_index */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_inet_index",
+							 "Enables the sorted network prefixes for inet containment clauses of GpuNestLoop",
+							 NULL,
+							 &pgstrom_enable_gpujoin_inet_index,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* threshold of the heavy-hitter keys in the inner hash table */
+	DefineCustomIntVariable("pg_strom.gpujoin_heavy_hitter_threshold",
+							"Min number of inner rows with the same hash value to split over the GPU threads (0 = disabled)",
+							NULL,
+							&pgstrom_gpujoin_heavy_hitter_threshold,
+							1000,
+							0,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	/* turn on/off emission of RIGHT OUTER JOIN rows by GPU */
+	DefineCustomBoolVariable("pg_strom.enable_gpujoin_right_outer",
+							 "Enables GPU to emit the unmatched rows of RIGHT/FULL OUTER JOIN under GpuPreAgg",
+							 NULL,
+							 &pgstrom_enable_gpujoin_right_outer,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	/* setup path methods */
 	memset(&gpujoin_path_methods, 0, sizeof(CustomPathMethods));
 	gpujoin_path_methods.CustomName				= "GpuJoin";
@@ -23,6 +23,9 @@ static bool					pgstrom_enable_dpupreagg = false;
 static bool					pgstrom_enable_partitionwise_dpupreagg = false;
 static bool					pgstrom_enable_gpupreagg = false;
 static bool					pgstrom_enable_partitionwise_gpupreagg = false;
+static bool					pgstrom_enable_gpupreagg_final = false;
+static bool					pgstrom_enable_gpupreagg_distinct = false;
+static bool					pgstrom_enable_gpupreagg_streaming = false;
 static bool					pgstrom_enable_numeric_aggfuncs;
 int							pgstrom_hll_register_bits;
 
@@ -43,6 +46,7 @@ typedef struct
 	const char *partfn_signature;
 	int			partfn_action;	/* any of KAGG_ACTION__* */
 	bool		numeric_aware;	/* ignored, if !enable_numeric_aggfuncs */
+	bool		fixed_numeric;	/* only if numeric argument has typmod */
 } aggfunc_catalog_t;
 
 static aggfunc_catalog_t	aggfunc_catalog_array[] = {
@@ -212,10 +216,11 @@ static aggfunc_catalog_t	aggfunc_catalog_array[] = {
 	 "s:psum(int8)",
 	 KAGG_ACTION__PSUM_INT,  false
 	},
+	/* SUM(int8) uses 128bit accumulator not to overflow */
 	{"sum(int8)",
-	 "s:sum_int_num(bytea)",
-	 "s:psum(int8)",
-	 KAGG_ACTION__PSUM_INT,  false
+	 "s:sum_numeric(bytea)",
+	 "s:psum128(int8)",
+	 KAGG_ACTION__PSUM_INT128,  false
 	},
 	{"sum(float2)",
 	 "s:sum_fp64(bytea)",
@@ -237,6 +242,12 @@ static aggfunc_catalog_t	aggfunc_catalog_array[] = {
 	 "s:psum(float8)",
 	 KAGG_ACTION__PSUM_FP, true
 	},
+	/* SUM(numeric(P,S)) is exact by the fixed-point sum */
+	{"sum(numeric)",
+	 "s:sum_numeric(bytea)",
+	 "s:psum(numeric)",
+	 KAGG_ACTION__PSUM_NUMERIC, false, true
+	},
 	{"sum(money)",
 	 "s:sum_cash(bytea)",
 	 "s:psum(money)",
@@ -261,9 +272,9 @@ static aggfunc_catalog_t	aggfunc_catalog_array[] = {
 	 KAGG_ACTION__PAVG_INT, false
 	},
 	{"avg(int8)",
-	 "s:avg_int(bytea)",
-	 "s:pavg(int8)",
-	 KAGG_ACTION__PAVG_INT, false
+	 "s:avg_numeric(bytea)",
+	 "s:pavg128(int8)",
+	 KAGG_ACTION__PAVG_INT128, false
 	},
 	{"avg(float2)",
 	 "s:avg_fp(bytea)",
@@ -285,6 +296,11 @@ static aggfunc_catalog_t	aggfunc_catalog_array[] = {
 	 "s:pavg(float8)",
 	 KAGG_ACTION__PAVG_FP, true
 	},
+	{"avg(numeric)",
+	 "s:avg_numeric(bytea)",
+	 "s:pavg(numeric)",
+	 KAGG_ACTION__PAVG_NUMERIC, false, true
+	},
 	/*
 	 * STDDEV(X) = EX_STDDEV_SAMP(NROWS(),PSUM(X),PSUM(X*X))
 	 */
@@ -614,6 +630,15 @@ static aggfunc_catalog_t	aggfunc_catalog_array[] = {
 	 "s:pcovar(float8,float8)",
 	 KAGG_ACTION__COVAR, false
 	},
+	/*
+	 * PGSTROM.PERCENTILE_SKETCH(X) = PERCENTILE_SKETCH_MERGE(PPERCENTILE(X))
+	 * (signature with "s:" prefix is PG-Strom's own aggregate function)
+	 */
+	{"s:percentile_sketch(float8)",
+	 "s:percentile_sketch_merge(bytea)",
+	 "s:ppercentile(float8)",
+	 KAGG_ACTION__PCTILE_FP, false
+	},
 	{ NULL, NULL, NULL, -1, false },
 };
 
@@ -623,6 +648,12 @@ static aggfunc_catalog_t	aggfunc_catalog_array[] = {
 typedef struct
 {
 	Oid		aggfn_oid;
+	bool	fixed_numeric;
+} aggfunc_catalog_key;
+
+typedef struct
+{
+	aggfunc_catalog_key key;
 	Oid		final_func_oid;
 	Oid		partial_func_oid;
 	Oid		partial_func_rettype;
@@ -757,6 +788,15 @@ __aggfunc_resolve_partial_func(aggfunc_catalog_entry *entry,
 			partfn_bufsz = sizeof(kagg_state__psum_fp_packed);
 			break;
 			
+		case KAGG_ACTION__PAVG_NUMERIC:
+		case KAGG_ACTION__PSUM_NUMERIC:
+		case KAGG_ACTION__PAVG_INT128:
+		case KAGG_ACTION__PSUM_INT128:
+			func_nargs = 1;
+			type_oid = BYTEAOID;
+			partfn_bufsz = sizeof(kagg_state__psum_numeric_packed);
+			break;
+
 		case KAGG_ACTION__STDDEV:
 			func_nargs = 1;
 			type_oid = BYTEAOID;
@@ -767,6 +807,11 @@ __aggfunc_resolve_partial_func(aggfunc_catalog_entry *entry,
 			type_oid = BYTEAOID;
 			partfn_bufsz = sizeof(kagg_state__covar_packed);
 			break;
+		case KAGG_ACTION__PCTILE_FP:
+			func_nargs = 1;
+			type_oid = BYTEAOID;
+			partfn_bufsz = sizeof(kagg_state__pctile_packed);
+			break;
 		default:
 			elog(ERROR, "Catalog corruption? unknown action: %d", partfn_action);
 			break;
@@ -812,9 +857,10 @@ __aggfunc_resolve_final_func(aggfunc_catalog_entry *entry,
 }
 
 static const aggfunc_catalog_entry *
-aggfunc_catalog_lookup_by_oid(Oid aggfn_oid)
+aggfunc_catalog_lookup_by_oid(Oid aggfn_oid, bool fixed_numeric)
 {
 	aggfunc_catalog_entry *entry;
+	aggfunc_catalog_key key;
 	bool		found;
 
 	/* fast path by the hashtable */
@@ -823,7 +869,7 @@ aggfunc_catalog_lookup_by_oid(Oid aggfn_oid)
 		HASHCTL		hctl;
 
 		memset(&hctl, 0, sizeof(HASHCTL));
-		hctl.keysize = sizeof(Oid);
+		hctl.keysize = sizeof(aggfunc_catalog_key);
 		hctl.entrysize = sizeof(aggfunc_catalog_entry);
 		hctl.hcxt = CacheMemoryContext;
 		aggfunc_catalog_htable = hash_create("XPU GroupBy Catalog Hash",
@@ -831,8 +877,11 @@ aggfunc_catalog_lookup_by_oid(Oid aggfn_oid)
 											 &hctl,
 											 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
 	}
+	memset(&key, 0, sizeof(aggfunc_catalog_key));
+	key.aggfn_oid = aggfn_oid;
+	key.fixed_numeric = fixed_numeric;
 	entry = hash_search(aggfunc_catalog_htable,
-						&aggfn_oid,
+						&key,
 						HASH_ENTER,
 						&found);
 	if (!found)
@@ -847,13 +896,16 @@ aggfunc_catalog_lookup_by_oid(Oid aggfn_oid)
 			if (!HeapTupleIsValid(htup))
 				elog(ERROR, "cache lookup failed for function %u", aggfn_oid);
 			proc = (Form_pg_proc) GETSTRUCT(htup);
-			if (proc->pronamespace == PG_CATALOG_NAMESPACE &&
+			if ((proc->pronamespace == PG_CATALOG_NAMESPACE ||
+				 proc->pronamespace == get_namespace_oid("pgstrom", true)) &&
 				proc->pronargs <= 2)
 			{
 				char	buf[3*NAMEDATALEN+100];
 				int		off;
 
-				off = sprintf(buf, "%s(", NameStr(proc->proname));
+				off = sprintf(buf, "%s%s(",
+							  proc->pronamespace == PG_CATALOG_NAMESPACE ? "" : "s:",
+							  NameStr(proc->proname));
 				for (int j=0; j < proc->pronargs; j++)
 				{
 					Oid		type_oid = proc->proargtypes.values[j];
@@ -869,7 +921,8 @@ aggfunc_catalog_lookup_by_oid(Oid aggfn_oid)
 				{
 					const aggfunc_catalog_t *cat = &aggfunc_catalog_array[i];
 
-					if (strcmp(buf, cat->aggfn_signature) == 0)
+					if (strcmp(buf, cat->aggfn_signature) == 0 &&
+						cat->fixed_numeric == fixed_numeric)
 					{
 						__aggfunc_resolve_partial_func(entry,
 													   cat->partfn_signature,
@@ -887,7 +940,7 @@ aggfunc_catalog_lookup_by_oid(Oid aggfn_oid)
 		}
 		PG_CATCH();
 		{
-			hash_search(aggfunc_catalog_htable, &aggfn_oid, HASH_REMOVE, NULL);
+			hash_search(aggfunc_catalog_htable, &key, HASH_REMOVE, NULL);
 			PG_RE_THROW();
 		}
 		PG_END_TRY();
@@ -911,6 +964,7 @@ typedef struct
 	ParamPathInfo  *param_info;
 	double			num_groups;
 	bool			try_parallel;
+	List		   *group_clause;	/* GROUP BY, or DISTINCT clause */
 	PathTarget	   *target_upper;
 	PathTarget	   *target_partial;
 	PathTarget	   *target_final;
@@ -921,9 +975,85 @@ typedef struct
 	List		   *inner_target_list;
 	List		   *groupby_keys;
 	List		   *groupby_keys_refno;
+	List		   *distinct_keys;	/* arguments of DISTINCT aggregates */
 	Node		   *havingQual;
 } xpugroupby_build_path_context;
 
+/*
+ * __groupby_input_is_clustered
+ *
+ * It checks whether the input rows are physically clustered by the first
+ * grouping key, according to the correlation statistics of the column;
+ * e.g, Arrow files written in time order, or heap tables loaded in time
+ * order (usually indexed by BRIN). The grouping key may be a column
+ * reference, its type cast, or date_trunc() of the column.
+ */
+#define GPUPREAGG_STREAMING_CORRELATION		0.95
+
+static bool
+__groupby_input_is_clustered(xpugroupby_build_path_context *con)
+{
+	pgstromPlanInfo *pp_info = con->pp_info;
+	VariableStatData vardata;
+	Node	   *expr;
+	float8		correlation = 0.0;
+
+	if (con->groupby_keys == NIL)
+		return false;
+	expr = linitial(con->groupby_keys);
+	for (;;)
+	{
+		if (IsA(expr, RelabelType))
+			expr = (Node *)((RelabelType *)expr)->arg;
+		else if (IsA(expr, FuncExpr))
+		{
+			FuncExpr   *func = (FuncExpr *)expr;
+			char	   *func_name;
+
+			if ((func->funcformat == COERCE_EXPLICIT_CAST ||
+				 func->funcformat == COERCE_IMPLICIT_CAST) &&
+				list_length(func->args) == 1)
+			{
+				expr = linitial(func->args);
+				continue;
+			}
+			func_name = get_func_name(func->funcid);
+			if (func_name && strcmp(func_name, "date_trunc") == 0 &&
+				list_length(func->args) >= 2 &&
+				IsA(linitial(func->args), Const))
+			{
+				expr = lsecond(func->args);
+				continue;
+			}
+			return false;
+		}
+		else
+			break;
+	}
+	if (!IsA(expr, Var) ||
+		((Var *)expr)->varno != pp_info->scan_relid ||
+		((Var *)expr)->varattno <= 0)
+		return false;
+
+	examine_variable(con->root, expr, 0, &vardata);
+	if (HeapTupleIsValid(vardata.statsTuple))
+	{
+		AttStatsSlot	sslot;
+
+		if (get_attstatsslot(&sslot, vardata.statsTuple,
+							 STATISTIC_KIND_CORRELATION, InvalidOid,
+							 ATTSTATSSLOT_NUMBERS))
+		{
+			if (sslot.nnumbers > 0)
+				correlation = sslot.numbers[0];
+			free_attstatsslot(&sslot);
+		}
+	}
+	ReleaseVariableStats(vardata);
+
+	return (fabs(correlation) >= GPUPREAGG_STREAMING_CORRELATION);
+}
+
 /*
  * make_expr_typecast - constructor of type cast
  */
@@ -985,6 +1115,121 @@ make_expr_typecast(Expr *expr, Oid target_type)
  * It makes an alternative final aggregate function towards the supplied
  * Aggref, and append its arguments on the target_partial/target_device.
  */
+/*
+ * make_distinct_aggref
+ *
+ * Aggregate with DISTINCT, like COUNT(DISTINCT X), is processed in two
+ * levels. GpuPreAgg adds the arguments to the grouping-keys, so the device
+ * hash table (kds_final) works as a hash set of the (group-key, value)
+ * pairs. Then, the upper Agg node runs the original aggregate with DISTINCT
+ * on the deduplicated rows. It is still correct even if multiple kds_final
+ * are merged (parallel workers, multiple GPUs, or partitions), because the
+ * upper Agg node eliminates the remained duplications.
+ */
+static Node *
+make_distinct_aggref(xpugroupby_build_path_context *con, Aggref *aggref)
+{
+	pgstromPlanInfo *pp_info = con->pp_info;
+	Aggref	   *aggref_alt;
+	HeapTuple	htup;
+	Form_pg_aggregate agg;
+	ListCell   *lc;
+
+	if (aggref->aggkind != AGGKIND_NORMAL ||
+		aggref->aggvariadic ||
+		aggref->aggfilter != NULL ||
+		aggref->aggdirectargs != NIL)
+	{
+		elog(DEBUG2, "Aggregate with DISTINCT is not supported form: %s",
+			 nodeToString(aggref));
+		return NULL;
+	}
+	foreach (lc, aggref->args)
+	{
+		TargetEntry *tle = lfirst(lc);
+		Expr	   *expr = tle->expr;
+		Oid			type_oid = exprType((Node *)expr);
+		devtype_info *dtype;
+
+		if (tle->resjunk)
+			continue;
+		dtype = pgstrom_devtype_lookup(type_oid);
+		if (!dtype || !dtype->type_hashfunc ||
+			!devtype_lookup_equal_func(dtype, exprCollation((Node *)expr)))
+		{
+			elog(DEBUG2, "DISTINCT argument has unsupported type (%s): %s",
+				 format_type_be(type_oid),
+				 nodeToString(expr));
+			return NULL;
+		}
+		if (!pgstrom_xpu_expression(expr,
+									pp_info->xpu_task_flags,
+									pp_info->scan_relid,
+									con->inner_target_list,
+									NULL))
+		{
+			elog(DEBUG2, "DISTINCT argument is not device executable: %s",
+				 nodeToString(expr));
+			return NULL;
+		}
+		if (!list_member(con->distinct_keys, expr))
+			con->distinct_keys = lappend(con->distinct_keys, expr);
+	}
+
+	/* the upper Agg node runs the original aggregate function */
+	aggref_alt = copyObject(aggref);
+#if PG_VERSION_NUM >= 160000
+	aggref_alt->aggpresorted = false;
+#endif
+	htup = SearchSysCache1(AGGFNOID, ObjectIdGetDatum(aggref->aggfnoid));
+	if (!HeapTupleIsValid(htup))
+		elog(ERROR, "cache lookup failed for pg_aggregate %u",
+			 aggref->aggfnoid);
+	agg = (Form_pg_aggregate) GETSTRUCT(htup);
+	if (OidIsValid(agg->aggtransfn))
+		add_function_cost(con->root,
+						  agg->aggtransfn,
+						  NULL,
+						  &con->final_clause_costs.transCost);
+	if (OidIsValid(agg->aggfinalfn))
+		add_function_cost(con->root,
+						  agg->aggfinalfn,
+						  NULL,
+						  &con->final_clause_costs.finalCost);
+	ReleaseSysCache(htup);
+
+	return (Node *)aggref_alt;
+}
+
+/*
+ * aggref_is_fixed_numeric
+ *
+ * It checks whether the argument of the aggregate function is numeric with
+ * typmod, that can be accumulated by the fixed-point sum on the device.
+ */
+static bool
+aggref_is_fixed_numeric(Aggref *aggref)
+{
+	TargetEntry *tle;
+	int32		typmod;
+	int			precision;
+	int			scale;
+
+	if (list_length(aggref->args) != 1)
+		return false;
+	tle = linitial(aggref->args);
+	if (exprType((Node *)tle->expr) != NUMERICOID)
+		return false;
+	typmod = exprTypmod((Node *)tle->expr);
+	if (typmod < (int32) VARHDRSZ)
+		return false;
+	precision = ((typmod - VARHDRSZ) >> 16) & 0xffff;
+	scale = (((typmod - VARHDRSZ) & 0x7ff) ^ 1024) - 1024;
+	return (scale >= 0 &&
+			scale <= precision &&
+			precision <= KAGG_NUMERIC_FIXED_MAX_PRECISION);
+}
+
 static Node *
 make_alternative_aggref(xpugroupby_build_path_context *con, Aggref *aggref)
 {
@@ -1001,9 +1246,9 @@ make_alternative_aggref(xpugroupby_build_path_context *con, Aggref *aggref)
 	ListCell   *lc;
 	int			j;
 
-	if (aggref->aggorder != NIL || aggref->aggdistinct != NIL)
+	if (aggref->aggorder != NIL)
 	{
-		elog(DEBUG2, "Aggregate with ORDER BY/DISTINCT is not supported: %s",
+		elog(DEBUG2, "Aggregate with ORDER BY is not supported: %s",
 			 nodeToString(aggref));
 		return NULL;
 	}
@@ -1013,11 +1258,17 @@ make_alternative_aggref(xpugroupby_build_path_context *con, Aggref *aggref)
 			 nodeToString(aggref));
 		return NULL;
 	}
+	if (aggref->aggdistinct != NIL)
+		return make_distinct_aggref(con, aggref);
 
 	/*
 	 * Lookup properties of aggregate function
 	 */
-	aggfn_cat = aggfunc_catalog_lookup_by_oid(aggref->aggfnoid);
+	aggfn_cat = NULL;
+	if (aggref_is_fixed_numeric(aggref))
+		aggfn_cat = aggfunc_catalog_lookup_by_oid(aggref->aggfnoid, true);
+	if (!aggfn_cat)
+		aggfn_cat = aggfunc_catalog_lookup_by_oid(aggref->aggfnoid, false);
 	if (!aggfn_cat)
 	{
 		elog(DEBUG2, "Aggregate function '%s' is not device executable",
@@ -1212,9 +1463,9 @@ xpugroupby_build_path_target(xpugroupby_build_path_context *con)
 		Expr   *expr = lfirst(lc1);
 		Index	sortgroupref = get_pathtarget_sortgroupref(target_upper, i++);
 
-		if (sortgroupref && parse->groupClause &&
+		if (sortgroupref && con->group_clause &&
 			get_sortgroupref_clause_noerr(sortgroupref,
-										  parse->groupClause) != NULL)
+										  con->group_clause) != NULL)
 		{
 			/* Grouping Key */
 			devtype_info *dtype;
@@ -1273,6 +1524,11 @@ xpugroupby_build_path_target(xpugroupby_build_path_context *con)
 			}
 			add_column_to_pathtarget(con->target_final, altfn, 0);
 		}
+		else if (IsA(expr, GroupingFunc) && parse->groupingSets != NIL)
+		{
+			/* GROUPING() shall be evaluated by the final Agg node */
+			add_column_to_pathtarget(con->target_final, expr, 0);
+		}
 		else
 		{
 			elog(DEBUG2, "unexpected expression on the upper-tlist: %s",
@@ -1312,12 +1568,277 @@ xpugroupby_build_path_target(xpugroupby_build_path_context *con)
 											   ? KAGG_ACTION__VREF_NOKEY
 											   : KAGG_ACTION__VREF);
 	}
+	/* arguments of DISTINCT aggregates are also grouping-keys on the device */
+	foreach (lc1, con->distinct_keys)
+	{
+		Expr   *key = lfirst(lc1);
+
+		if (list_member(con->groupby_keys, key))
+			continue;
+		add_column_to_pathtarget(con->target_partial, key, 0);
+		pp_info->groupby_actions = lappend_int(pp_info->groupby_actions,
+											   KAGG_ACTION__VREF);
+	}
 	set_pathtarget_cost_width(root, con->target_final);
 	set_pathtarget_cost_width(root, con->target_partial);
 
 	return true;
 }
 
+/*
+ * __make_final_groupby_expr
+ *
+ * It replaces the alternative Aggref by its final function call on the
+ * partial result, if the kds_final already keeps unique groups. It works
+ * only if transition function by a single partial value is identical to
+ * the partial value itself; e.g, transfn(NULL, X) = X, or int8pl(0, X) = X.
+ */
+static Node *
+__make_final_groupby_expr(Node *node, void *__data)
+{
+	bool	   *p_invalid = __data;
+
+	if (!node || *p_invalid)
+		return node;
+	if (IsA(node, Aggref))
+	{
+		Aggref	   *aggref = (Aggref *)node;
+		Expr	   *partial;
+		Node	   *result = NULL;
+		HeapTuple	htup;
+		Form_pg_aggregate agg;
+		bool		initval_isnull;
+
+		if (list_length(aggref->args) != 1)
+		{
+			*p_invalid = true;
+			return node;
+		}
+		partial = ((TargetEntry *)linitial(aggref->args))->expr;
+
+		htup = SearchSysCache1(AGGFNOID, ObjectIdGetDatum(aggref->aggfnoid));
+		if (!HeapTupleIsValid(htup))
+			elog(ERROR, "cache lookup failed for pg_aggregate %u",
+				 aggref->aggfnoid);
+		agg = (Form_pg_aggregate) GETSTRUCT(htup);
+		SysCacheGetAttr(AGGFNOID, htup,
+						Anum_pg_aggregate_agginitval,
+						&initval_isnull);
+		if (OidIsValid(agg->aggfinalfn))
+		{
+			if (initval_isnull &&
+				!agg->aggfinalextra &&
+				agg->aggtranstype == exprType((Node *)partial) &&
+				get_func_rettype(agg->aggfinalfn) == aggref->aggtype &&
+				func_strict(agg->aggfinalfn))
+			{
+				result = (Node *)makeFuncExpr(agg->aggfinalfn,
+											  aggref->aggtype,
+											  list_make1(partial),
+											  aggref->aggcollid,
+											  aggref->inputcollid,
+											  COERCE_EXPLICIT_CALL);
+			}
+		}
+		else if (agg->aggtransfn == F_INT8PL &&
+				 !initval_isnull &&
+				 exprType((Node *)partial) == aggref->aggtype)
+		{
+			/* pgstrom.fcount(bigint) with initcond = 0 */
+			result = (Node *)partial;
+		}
+		ReleaseSysCache(htup);
+
+		if (!result)
+		{
+			elog(DEBUG2, "Aggregate '%s' cannot be finalized without Agg node",
+				 format_procedure(aggref->aggfnoid));
+			*p_invalid = true;
+			return node;
+		}
+		return result;
+	}
+	return expression_tree_mutator(node, __make_final_groupby_expr, __data);
+}
+
+/*
+ * try_add_final_groupby_nonagg_path
+ *
+ * If GpuPreAgg runs on a single kds_final, it already has unique groups
+ * at the end of the execution, so the upper Agg node has nothing to merge.
+ * This path replaces the Agg node by a simple projection that applies the
+ * final functions on the partial results.
+ */
+static void
+try_add_final_groupby_nonagg_path(xpugroupby_build_path_context *con,
+								  Path *part_path)
+{
+	PlannerInfo *root = con->root;
+	CustomPath *cpath;
+	CustomPath *cpath_new;
+	pgstromPlanInfo *pp_info;
+	PathTarget *target_nonagg;
+	Path	   *proj_path;
+	Path	   *dummy_path;
+	bool		invalid = false;
+
+	if (!pgstrom_enable_gpupreagg_final ||
+		!con->group_clause ||
+		con->havingQual != NULL ||
+		con->distinct_keys != NIL)
+		return;
+	/*
+	 * Only a single kds_final shall be built, if non-parallel, or parallel
+	 * workers run on the same GPU device; gpuClientOpenSession() attaches
+	 * all the workers to one GPU on the groupby_final_on_device, then the
+	 * last worker alone returns the merged groups through Gather.
+	 * Partition-wise GpuPreAgg builds kds_final for each partition, so
+	 * groups are not unique.
+	 */
+	if (IsA(part_path, GatherPath) && numGpuDevAttrs > 0)
+	{
+		Path   *sub_path = ((GatherPath *)part_path)->subpath;
+
+		if (!IsA(sub_path, CustomPath))
+			return;
+		cpath = (CustomPath *)sub_path;
+	}
+	else if (IsA(part_path, CustomPath) &&
+			 part_path->parallel_workers == 0)
+		cpath = (CustomPath *)part_path;
+	else
+		return;
+	if (cpath->methods != &gpupreagg_path_methods)
+		return;
+
+	/* build the target-list without Aggref */
+	target_nonagg = copy_pathtarget(con->target_final);
+	target_nonagg->exprs = (List *)
+		__make_final_groupby_expr((Node *)target_nonagg->exprs, &invalid);
+	if (invalid)
+		return;
+	set_pathtarget_cost_width(root, target_nonagg);
+
+	/* mark the GpuPreAgg path not to split kds_final */
+	cpath_new = (CustomPath *)pgstrom_copy_pathnode(&cpath->path);
+	pp_info = copy_pgstrom_plan_info(linitial(cpath->custom_private));
+	pp_info->groupby_final_on_device = true;
+	pp_info->groupby_streaming = false;		/* groups must be unique */
+	cpath_new->custom_private = list_make1(pp_info);
+	if (IsA(part_path, GatherPath))
+	{
+		GatherPath *gpath = (GatherPath *)pgstrom_copy_pathnode(part_path);
+
+		gpath->subpath = &cpath_new->path;
+		part_path = &gpath->path;
+	}
+	else
+	{
+		part_path = &cpath_new->path;
+	}
+	proj_path = (Path *)create_projection_path(root,
+											   con->group_rel,
+											   part_path,
+											   target_nonagg);
+	dummy_path = pgstrom_create_dummy_path(root, proj_path);
+	add_path(con->group_rel, dummy_path);
+}
+
+/*
+ * try_add_final_groupingsets_path
+ *
+ * GROUPING SETS, ROLLUP and CUBE; XpuPreAgg runs the partial aggregation
+ * by the finest grain (all the grouping columns), then the Agg node rolls up
+ * the partial results into each grouping set. The partial results are much
+ * smaller than the input, so the relation is scanned only once.
+ */
+static void
+try_add_final_groupingsets_path(xpugroupby_build_path_context *con,
+								Path *part_path)
+{
+	PlannerInfo *root = con->root;
+	Query	   *parse = root->parse;
+	List	   *tlist_partial = make_tlist_from_pathtarget(con->target_partial);
+	List	   *gsets;
+	List	   *rollups = NIL;
+	List	   *empty_sets = NIL;
+	List	   *empty_sets_data = NIL;
+	AggStrategy	strategy;
+	Path	   *gset_path;
+	Path	   *dummy_path;
+	ListCell   *lc1, *lc2;
+
+	/* Agg node cannot run DISTINCT aggregates in the hashed strategy */
+	if (con->distinct_keys != NIL)
+		return;
+	gsets = expand_grouping_sets(parse->groupingSets,
+								 parse->groupDistinct, -1);
+	foreach (lc1, gsets)
+	{
+		List	   *gset = lfirst(lc1);
+		GroupingSetData *gs = makeNode(GroupingSetData);
+		RollupData *rollup;
+		List	   *index = NIL;
+
+		gs->set = gset;
+		if (gset == NIL)
+		{
+			/* empty grouping set cannot be hashed */
+			gs->numGroups = 1.0;
+			empty_sets = lappend(empty_sets, NIL);
+			empty_sets_data = lappend(empty_sets_data, gs);
+			continue;
+		}
+		rollup = makeNode(RollupData);
+		foreach (lc2, gset)
+		{
+			Index		sortgroupref = lfirst_int(lc2);
+			SortGroupClause *gc = get_sortgroupref_clause(sortgroupref,
+														  parse->groupClause);
+			index = lappend_int(index, list_length(rollup->groupClause));
+			rollup->groupClause = lappend(rollup->groupClause, gc);
+		}
+		gs->numGroups = estimate_num_groups(root,
+											get_sortgrouplist_exprs(rollup->groupClause,
+																	tlist_partial),
+											part_path->rows,
+											NULL, NULL);
+		rollup->gsets = list_make1(index);
+		rollup->gsets_data = list_make1(gs);
+		rollup->numGroups = gs->numGroups;
+		rollup->hashable = true;
+		rollup->is_hashed = true;
+		rollups = lappend(rollups, rollup);
+	}
+
+	if (empty_sets == NIL)
+		strategy = AGG_HASHED;
+	else
+	{
+		RollupData *rollup = makeNode(RollupData);
+
+		rollup->groupClause = NIL;
+		rollup->gsets = empty_sets;
+		rollup->gsets_data = empty_sets_data;
+		rollup->numGroups = list_length(empty_sets);
+		rollup->hashable = false;
+		rollup->is_hashed = false;
+		rollups = lappend(rollups, rollup);
+		/* create_groupingsets_path() downgrades it, if only empty sets */
+		strategy = (list_length(rollups) > 1 ? AGG_MIXED : AGG_SORTED);
+	}
+	gset_path = (Path *)create_groupingsets_path(root,
+												 con->group_rel,
+												 part_path,
+												 (List *)con->havingQual,
+												 strategy,
+												 rollups,
+												 &con->final_clause_costs);
+	gset_path->pathtarget = con->target_final;
+	dummy_path = pgstrom_create_dummy_path(root, gset_path);
+	add_path(con->group_rel, dummy_path);
+}
+
 /*
  * try_add_final_groupby_paths
  */
@@ -1329,7 +1850,11 @@ try_add_final_groupby_paths(xpugroupby_build_path_context *con,
 	Path	   *agg_path;
 	Path	   *dummy_path;
 
-	if (!parse->groupClause)
+	if (parse->groupingSets != NIL)
+	{
+		try_add_final_groupingsets_path(con, part_path);
+	}
+	else if (!con->group_clause)
 	{
 		agg_path = (Path *)create_agg_path(con->root,
 										   con->group_rel,
@@ -1337,28 +1862,64 @@ try_add_final_groupby_paths(xpugroupby_build_path_context *con,
 										   con->target_final,
 										   AGG_PLAIN,
 										   AGGSPLIT_SIMPLE,
-										   parse->groupClause,
+										   con->group_clause,
 										   (List *)con->havingQual,
 										   &con->final_clause_costs,
 										   con->num_groups);
 		dummy_path = pgstrom_create_dummy_path(con->root, agg_path);
 		add_path(con->group_rel, dummy_path);
 	}
+	else if (con->distinct_keys != NIL)
+	{
+		/*
+		 * Agg node cannot run DISTINCT aggregates in the hashed strategy,
+		 * so the partial results are sorted by the grouping-keys.
+		 */
+		PlannerInfo *root = con->root;
+		List	   *group_pathkeys = root->group_pathkeys;
+		Path	   *sort_path;
+
+		if (!grouping_is_sortable(con->group_clause))
+			return;
+#if PG_VERSION_NUM >= 160000
+		group_pathkeys = list_copy_head(root->group_pathkeys,
+										root->num_groupby_pathkeys);
+#endif
+		sort_path = (Path *)create_sort_path(root,
+											 con->group_rel,
+											 part_path,
+											 group_pathkeys,
+											 -1.0);
+		agg_path = (Path *)create_agg_path(root,
+										   con->group_rel,
+										   sort_path,
+										   con->target_final,
+										   AGG_SORTED,
+										   AGGSPLIT_SIMPLE,
+										   con->group_clause,
+										   (List *)con->havingQual,
+										   &con->final_clause_costs,
+										   con->num_groups);
+		dummy_path = pgstrom_create_dummy_path(root, agg_path);
+		add_path(con->group_rel, dummy_path);
+	}
 	else
 	{
-		Assert(grouping_is_hashable(parse->groupClause));
+		Assert(grouping_is_hashable(con->group_clause));
 		agg_path = (Path *)create_agg_path(con->root,
 										   con->group_rel,
 										   part_path,
 										   con->target_final,
 										   AGG_HASHED,
 										   AGGSPLIT_SIMPLE,
-										   parse->groupClause,
+										   con->group_clause,
 										   (List *)con->havingQual,
 										   &con->final_clause_costs,
 										   con->num_groups);
 		dummy_path = pgstrom_create_dummy_path(con->root, agg_path);
 		add_path(con->group_rel, dummy_path);
+		/* GpuPreAgg without Agg node, if kds_final has unique groups */
+		try_add_final_groupby_nonagg_path(con, part_path);
 	}
 }
 
@@ -1368,7 +1929,6 @@ try_add_final_groupby_paths(xpugroupby_build_path_context *con,
 static CustomPath *
 __buildXpuPreAggCustomPath(xpugroupby_build_path_context *con)
 {
-	Query	   *parse = con->root->parse;
 	CustomPath *cpath = makeNode(CustomPath);
 	PathTarget *target_partial = con->target_partial;
 	pgstromPlanInfo *pp_info = copy_pgstrom_plan_info(con->pp_info);
@@ -1402,16 +1962,59 @@ __buildXpuPreAggCustomPath(xpugroupby_build_path_context *con)
 	{
 		elog(ERROR, "Bug? unexpected task_kind: %08x", pp_info->xpu_task_flags);
 	}
+	/* calibrated by the runtime statistics, if any */
+	pgstromCostCalibLookup(pp_info->xpu_task_flags & DEVKIND__ANY,
+						   pgstromCostCalibSpcId(con->root, pp_info->scan_relid),
+						   NULL, NULL, &xpu_tuple_cost);
 	pp_info->xpu_task_flags &= ~DEVTASK__MASK;
 	pp_info->xpu_task_flags |= DEVTASK__PREAGG;
 	pp_info->sibling_param_id = con->sibling_param_id;
 
-	/* No tuples shall be generated until child JOIN/SCAN path completion */
-	startup_cost = (pp_info->startup_cost +
-					pp_info->inner_cost +
-					pp_info->run_cost);
+	/*
+	 * Group-By Streaming; when the input is clustered by the grouping key,
+	 * each GPU task builds and returns its own groups, then the upper Agg
+	 * node merges a few duplicated groups across the chunk boundaries.
+	 * It is not available if RIGHT/FULL OUTER JOIN, because the outer-only
+	 * rows are generated at the end of the task.
+	 */
+	pp_info->groupby_streaming = false;
+	if (pgstrom_enable_gpupreagg_streaming &&
+		(pp_info->xpu_task_flags & DEVKIND__ANY) == DEVKIND__NVIDIA_GPU &&
+		con->group_clause != NIL &&
+		con->distinct_keys == NIL)
+	{
+		bool	streaming = true;
+
+		for (int i=0; i < pp_info->num_rels; i++)
+		{
+			JoinType	join_type = pp_info->inners[i].join_type;
+
+			if (join_type == JOIN_RIGHT || join_type == JOIN_FULL)
+			{
+				streaming = false;
+				break;
+			}
+		}
+		if (streaming && __groupby_input_is_clustered(con))
+			pp_info->groupby_streaming = true;
+	}
+
+	if (pp_info->groupby_streaming)
+	{
+		/* The first groups are returned after the first chunk */
+		startup_cost = (pp_info->startup_cost +
+						pp_info->inner_cost);
+		run_cost = pp_info->run_cost;
+	}
+	else
+	{
+		/* No tuples shall be generated until child JOIN/SCAN path completion */
+		startup_cost = (pp_info->startup_cost +
+						pp_info->inner_cost +
+						pp_info->run_cost);
+	}
 	/* Cost estimation for grouping */
-	num_group_keys = list_length(parse->groupClause);
+	num_group_keys = list_length(con->group_clause);
 	startup_cost += (xpu_operator_cost *
 					 num_group_keys *
 					 input_nrows);
@@ -1419,7 +2022,7 @@ __buildXpuPreAggCustomPath(xpugroupby_build_path_context *con)
 	startup_cost += (target_partial->cost.per_tuple * input_nrows +
 					 target_partial->cost.startup) * xpu_ratio;
 	/* Cost estimation to fetch results */
-	run_cost = xpu_tuple_cost * con->num_groups;
+	run_cost += xpu_tuple_cost * con->num_groups;
 
 	cpath->path.pathtype         = T_CustomScan;
 	cpath->path.parent           = con->input_rel;
@@ -1442,25 +2045,26 @@ static void
 __try_add_xpupreagg_normal_path(PlannerInfo *root,
 								RelOptInfo *input_rel,
 								RelOptInfo *group_rel,
-								GroupPathExtraData *gp_extra,
+								List *group_clause,
+								List *group_tlist,
+								PathTarget *target_upper,
 								uint32_t xpu_task_flags,
 								bool be_parallel,
 								pgstromOuterPathLeafInfo *op_leaf)
 {
 	xpugroupby_build_path_context con;
-	Query	   *parse = root->parse;
 	List	   *inner_target_list = NIL;
 	ListCell   *lc;
 	Path	   *part_path;
 	double		num_groups = 1.0;
 
 	/* estimate number of groups */
-	if (parse->groupClause)
+	if (group_clause)
 	{
 		List   *groupExprs;
 
-		groupExprs = get_sortgrouplist_exprs(parse->groupClause,
-											 gp_extra->targetList);
+		groupExprs = get_sortgrouplist_exprs(group_clause,
+											 group_tlist);
 		num_groups = estimate_num_groups(root, groupExprs,
 										 op_leaf->leaf_nrows,
 										 NULL, NULL);
@@ -1480,7 +2084,8 @@ __try_add_xpupreagg_normal_path(PlannerInfo *root,
 	con.param_info     = op_leaf->leaf_param;
 	con.num_groups     = num_groups;
 	con.try_parallel   = be_parallel;
-	con.target_upper   = root->upper_targets[UPPERREL_GROUP_AGG];
+	con.group_clause   = group_clause;
+	con.target_upper   = target_upper;
 	con.target_partial = create_empty_pathtarget();
 	con.target_final   = create_empty_pathtarget();
 	con.pp_info        = op_leaf->pp_info;
@@ -1511,20 +2116,33 @@ static void
 __try_add_xpupreagg_partition_path(PlannerInfo *root,
 								   RelOptInfo *input_rel,
 								   RelOptInfo *group_rel,
-								   GroupPathExtraData *gp_extra,
+								   List *group_clause,
+								   List *group_tlist,
+								   PathTarget *target_upper,
 								   uint32_t xpu_task_flags,
 								   bool try_parallel_path,
 								   int sibling_param_id,
 								   List *op_leaf_list)
 {
 	xpugroupby_build_path_context con;
-	Query	   *parse = root->parse;
 	List	   *preagg_cpath_list = NIL;
 	ListCell   *lc1, *lc2;
 	PathTarget *part_target = NULL;
 	Path	   *part_path;
 	int			parallel_nworkers = 0;
 	double		total_nrows = 0.0;
+	bool		share_kds_final;
+
+	/*
+	 * GpuPreAgg on the partition leafs can share a single kds_final on
+	 * the GPU device, instead of the individual partial results for each
+	 * leaf, if they run one by one on the same device. It needs no inner
+	 * buffer, because the per-query buffer is also used for the inner
+	 * relations of GpuJoin.
+	 */
+	share_kds_final = (!try_parallel_path &&
+					   numGpuDevAttrs == 1 &&
+					   (xpu_task_flags & DEVKIND__ANY) == DEVKIND__NVIDIA_GPU);
 
 	foreach (lc1, op_leaf_list)
 	{
@@ -1534,12 +2152,12 @@ __try_add_xpupreagg_partition_path(PlannerInfo *root,
 		CustomPath *cpath;
 
 		/* estimate number of groups */
-		if (parse->groupClause)
+		if (group_clause)
 		{
 			List   *groupExprs;
 
-			groupExprs = get_sortgrouplist_exprs(parse->groupClause,
-												 gp_extra->targetList);
+			groupExprs = get_sortgrouplist_exprs(group_clause,
+												 group_tlist);
 			num_groups = estimate_num_groups(root, groupExprs,
 											 op_leaf->leaf_nrows,
 											 NULL, NULL);
@@ -1559,7 +2177,8 @@ __try_add_xpupreagg_partition_path(PlannerInfo *root,
 		con.param_info     = op_leaf->leaf_param;
 		con.num_groups     = num_groups;
 		con.try_parallel   = try_parallel_path;
-		con.target_upper   = root->upper_targets[UPPERREL_GROUP_AGG];
+		con.group_clause   = group_clause;
+		con.target_upper   = target_upper;
 		con.target_partial = create_empty_pathtarget();
 		con.target_final   = create_empty_pathtarget();
 		con.pp_info        = op_leaf->pp_info;
@@ -1578,6 +2197,8 @@ __try_add_xpupreagg_partition_path(PlannerInfo *root,
 											   op_leaf->leaf_rel->relids,
 											   con.target_partial->exprs);
 		cpath = __buildXpuPreAggCustomPath(&con);
+		if (op_leaf->inner_paths_list != NIL || op_leaf->leaf_param != NULL)
+			share_kds_final = false;
 
 		parallel_nworkers += cpath->path.parallel_workers;
 		total_nrows       += cpath->path.rows;
@@ -1587,6 +2208,24 @@ __try_add_xpupreagg_partition_path(PlannerInfo *root,
 
 	if (list_length(preagg_cpath_list) == 0)
 		return;
+	if (list_length(preagg_cpath_list) < 2)
+		share_kds_final = false;
+	if (share_kds_final)
+	{
+		PlannerGlobal  *glob = root->glob;
+		int		sibling_id = list_length(glob->paramExecTypes);
+
+		glob->paramExecTypes = lappend_oid(glob->paramExecTypes,
+										   INTERNALOID);
+		foreach (lc1, preagg_cpath_list)
+		{
+			CustomPath *cpath = lfirst(lc1);
+			pgstromPlanInfo *pp_info = linitial(cpath->custom_private);
+
+			pp_info->groupby_sibling_id = sibling_id;
+			pp_info->groupby_nsiblings = list_length(preagg_cpath_list);
+		}
+	}
 	/* adjust number of workers */
 	if (try_parallel_path)
 	{
@@ -1595,10 +2234,16 @@ __try_add_xpupreagg_partition_path(PlannerInfo *root,
 		if (parallel_nworkers == 0)
 			return;
 	}
-	/* Append path to consolidate partition leafs */
+	/*
+	 * Append path to consolidate partition leafs
+	 *
+	 * If kds_final is shared, every sibling must run to write back the
+	 * final results by the last one, so Append is built on the group_rel
+	 * (that has no restrictions) not to prune the leafs at run-time.
+	 */
 	part_path = (Path *)
 		create_append_path(root,
-						   input_rel,
+						   (share_kds_final ? group_rel : input_rel),
 						   (try_parallel_path ? NIL : preagg_cpath_list),
 						   (try_parallel_path ? preagg_cpath_list : NIL),
 						   NIL,
@@ -1627,15 +2272,19 @@ static void
 __xpuPreAggAddCustomPathCommon(PlannerInfo *root,
 							   RelOptInfo *input_rel,
 							   RelOptInfo *group_rel,
-							   void *extra,
+							   List *group_clause,
+							   List *group_tlist,
+							   PathTarget *target_upper,
 							   uint32_t xpu_task_flags,
 							   bool consider_partition)
 {
-	Query	   *parse = root->parse;
-
-	/* quick bailout if not supported */
-	if (parse->groupingSets != NIL ||
-		!grouping_is_hashable(parse->groupClause))
+	/*
+	 * quick bailout if not supported
+	 *
+	 * GROUPING SETS is supported by the partial aggregation on all
+	 * the grouping columns; see try_add_final_groupingsets_path()
+	 */
+	if (!grouping_is_hashable(group_clause))
 	{
 		elog(DEBUG2, "GROUP BY clause is not supported form");
 		return;
@@ -1656,7 +2305,9 @@ __xpuPreAggAddCustomPathCommon(PlannerInfo *root,
 			__try_add_xpupreagg_normal_path(root,
 											input_rel,
 											group_rel,
-											extra,
+											group_clause,
+											group_tlist,
+											target_upper,
 											xpu_task_flags,
 											(try_parallel > 0),
 											op_leaf);
@@ -1687,7 +2338,9 @@ __xpuPreAggAddCustomPathCommon(PlannerInfo *root,
 				__try_add_xpupreagg_partition_path(root,
 												   input_rel,
 												   group_rel,
-												   extra,
+												   group_clause,
+												   group_tlist,
+												   target_upper,
 												   xpu_task_flags,
 												   (try_parallel > 0),
 												   sibling_param_id,
@@ -1712,25 +2365,63 @@ XpuPreAggAddCustomPath(PlannerInfo *root,
 								input_rel,
 								group_rel,
 								extra);
-	if (stage != UPPERREL_GROUP_AGG)
+	if (!pgstrom_enabled())
 		return;
-	if (pgstrom_enabled())
+	if (stage == UPPERREL_GROUP_AGG)
 	{
+		Query	   *parse = root->parse;
+		GroupPathExtraData *gp_extra = extra;
+
 		if (pgstrom_enable_gpupreagg && gpuserv_ready_accept())
 			__xpuPreAggAddCustomPathCommon(root,
 										   input_rel,
 										   group_rel,
-										   extra,
+										   parse->groupClause,
+										   gp_extra->targetList,
+										   root->upper_targets[UPPERREL_GROUP_AGG],
 										   TASK_KIND__GPUPREAGG,
 										   pgstrom_enable_partitionwise_gpupreagg);
 		if (pgstrom_enable_dpupreagg)
 			__xpuPreAggAddCustomPathCommon(root,
 										   input_rel,
 										   group_rel,
-										   extra,
+										   parse->groupClause,
+										   gp_extra->targetList,
+										   root->upper_targets[UPPERREL_GROUP_AGG],
 										   TASK_KIND__DPUPREAGG,
 										   pgstrom_enable_partitionwise_dpupreagg);
 	}
+	else if (stage == UPPERREL_DISTINCT)
+	{
+		Query	   *parse = root->parse;
+
+		/*
+		 * SELECT DISTINCT on the scan/join results is equivalent to GROUP BY
+		 * on all the target columns without aggregate functions, so it runs
+		 * as a key-only GpuPreAgg. DISTINCT ON needs the first row of each
+		 * group, so it is not supported.
+		 */
+		if (!pgstrom_enable_gpupreagg_distinct ||
+			!pgstrom_enable_gpupreagg ||
+			!gpuserv_ready_accept() ||
+			parse->distinctClause == NIL ||
+			parse->hasDistinctOn ||
+			parse->hasAggs ||
+			parse->groupClause != NIL ||
+			parse->groupingSets != NIL ||
+			parse->havingQual != NULL ||
+			parse->hasWindowFuncs ||
+			parse->hasTargetSRFs)
+			return;
+		__xpuPreAggAddCustomPathCommon(root,
+									   input_rel,
+									   group_rel,
+									   parse->distinctClause,
+									   parse->targetList,
+									   root->upper_targets[UPPERREL_DISTINCT],
+									   TASK_KIND__GPUPREAGG,
+									   pgstrom_enable_partitionwise_gpupreagg);
+	}
 }
 
 /*
@@ -1754,6 +2445,8 @@ PlanGpuPreAggPath(PlannerInfo *root,
 								  custom_plans,
 								  pp_info,
 								  &gpupreagg_plan_methods);
+	if (pp_info->groupby_final_on_device)
+		pgstrom_build_gpusort_topk(root, joinrel, cscan, pp_info);
 	form_pgstrom_plan_info(cscan, pp_info);
 	return &cscan->scan.plan;
 }
@@ -1817,6 +2510,168 @@ ExecFallbackCpuPreAgg(pgstromTaskState *pts, HeapTuple tuple)
 	return false;
 }
 
+/*
+ * pgstrom_gpu_analyze
+ *
+ * It runs ANALYZE on the supplied relation, then replaces the null fraction
+ * and the number of distinct values, estimated from the samples by CPU, by
+ * the ones counted on the entire relation. Both of the queries are simple
+ * aggregation and SELECT DISTINCT, so GpuPreAgg shall process them.
+ * MCVs and histograms are still built from the samples.
+ */
+PG_FUNCTION_INFO_V1(pgstrom_gpu_analyze);
+PUBLIC_FUNCTION(Datum)
+pgstrom_gpu_analyze(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	Relation	rel;
+	Relation	sd;
+	TupleDesc	tupdesc;
+	char		relkind;
+	char	   *relname;
+	double		totalrows = 0.0;
+	double	   *nonnulls;
+	double	   *ndistincts;
+	StringInfoData buf;
+
+	rel = relation_open(relid, ShareUpdateExclusiveLock);
+	relkind = RelationGetForm(rel)->relkind;
+	if (relkind != RELKIND_RELATION &&
+		relkind != RELKIND_MATVIEW &&
+		relkind != RELKIND_FOREIGN_TABLE)
+		elog(ERROR, "\"%s\" is not a table, materialized view or foreign table",
+			 RelationGetRelationName(rel));
+#if PG_VERSION_NUM < 160000
+	if (!pg_class_ownercheck(relid, GetUserId()))
+#else
+	if (!object_ownercheck(RelationRelationId, relid, GetUserId()))
+#endif
+		aclcheck_error(ACLCHECK_NOT_OWNER,
+					   get_relkind_objtype(relkind),
+					   RelationGetRelationName(rel));
+	relname = quote_qualified_identifier(get_namespace_name(RelationGetNamespace(rel)),
+										 RelationGetRelationName(rel));
+	tupdesc = CreateTupleDescCopy(RelationGetDescr(rel));
+	/* the lock shall be kept until end of the transaction */
+	relation_close(rel, NoLock);
+
+	nonnulls = palloc0(sizeof(double) * tupdesc->natts);
+	ndistincts = palloc0(sizeof(double) * tupdesc->natts);
+	initStringInfo(&buf);
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "failed on SPI_connect");
+	/* MCVs, histograms and so on, from the samples */
+	appendStringInfo(&buf, "ANALYZE %s", relname);
+	if (SPI_execute(buf.data, false, 0) != SPI_OK_UTILITY)
+		elog(ERROR, "failed on SPI_execute: %s", buf.data);
+	/* number of rows and non-NULL values for each column */
+	resetStringInfo(&buf);
+	appendStringInfo(&buf, "SELECT count(*)");
+	for (int j=0; j < tupdesc->natts; j++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+
+		if (attr->attisdropped)
+			appendStringInfo(&buf, ", 0::bigint");
+		else
+			appendStringInfo(&buf, ", count(%s)",
+							 quote_identifier(NameStr(attr->attname)));
+	}
+	appendStringInfo(&buf, " FROM ONLY %s", relname);
+	if (SPI_execute(buf.data, true, 0) != SPI_OK_SELECT || SPI_processed != 1)
+		elog(ERROR, "failed on SPI_execute: %s", buf.data);
+	for (int j=0; j <= tupdesc->natts; j++)
+	{
+		bool		isnull;
+		Datum		datum;
+
+		datum = SPI_getbinval(SPI_tuptable->vals[0],
+							  SPI_tuptable->tupdesc, j+1, &isnull);
+		if (j == 0)
+			totalrows = (isnull ? 0.0 : (double)DatumGetInt64(datum));
+		else
+			nonnulls[j-1] = (isnull ? 0.0 : (double)DatumGetInt64(datum));
+	}
+	/* number of distinct values for each column */
+	for (int j=0; j < tupdesc->natts && totalrows > 0.0; j++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+		TypeCacheEntry *tcache;
+		const char *attname;
+		bool		isnull;
+		Datum		datum;
+
+		CHECK_FOR_INTERRUPTS();
+		if (attr->attisdropped || nonnulls[j] == 0.0)
+			continue;
+		tcache = lookup_type_cache(attr->atttypid, TYPECACHE_EQ_OPR);
+		if (!OidIsValid(tcache->eq_opr))
+			continue;	/* SELECT DISTINCT is not available */
+		attname = quote_identifier(NameStr(attr->attname));
+		resetStringInfo(&buf);
+		appendStringInfo(&buf,
+						 "SELECT count(*) FROM (SELECT DISTINCT %s FROM ONLY %s"
+						 " WHERE %s IS NOT NULL) __d",
+						 attname, relname, attname);
+		if (SPI_execute(buf.data, true, 0) != SPI_OK_SELECT || SPI_processed != 1)
+			elog(ERROR, "failed on SPI_execute: %s", buf.data);
+		datum = SPI_getbinval(SPI_tuptable->vals[0],
+							  SPI_tuptable->tupdesc, 1, &isnull);
+		if (!isnull)
+			ndistincts[j] = (double)DatumGetInt64(datum);
+	}
+	SPI_finish();
+
+	/* update pg_statistic that was built by the above ANALYZE */
+	sd = table_open(StatisticRelationId, RowExclusiveLock);
+	for (int j=0; j < tupdesc->natts && totalrows > 0.0; j++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+		Datum		values[Natts_pg_statistic];
+		bool		nulls[Natts_pg_statistic];
+		bool		replaces[Natts_pg_statistic];
+		double		stadistinct = ndistincts[j];
+		HeapTuple	oldtup;
+		HeapTuple	newtup;
+
+		if (attr->attisdropped)
+			continue;
+		oldtup = SearchSysCache3(STATRELATTINH,
+								 ObjectIdGetDatum(relid),
+								 Int16GetDatum(attr->attnum),
+								 BoolGetDatum(false));
+		if (!HeapTupleIsValid(oldtup))
+			continue;	/* column was not analyzed */
+		memset(values, 0, sizeof(values));
+		memset(nulls, 0, sizeof(nulls));
+		memset(replaces, 0, sizeof(replaces));
+		values[Anum_pg_statistic_stanullfrac - 1]
+			= Float4GetDatum(1.0 - nonnulls[j] / totalrows);
+		replaces[Anum_pg_statistic_stanullfrac - 1] = true;
+		if (stadistinct > 0.0)
+		{
+			/* same as the rule of compute_scalar_stats() */
+			if (stadistinct > 0.1 * totalrows)
+				stadistinct = -(stadistinct / totalrows);
+			values[Anum_pg_statistic_stadistinct - 1]
+				= Float4GetDatum(stadistinct);
+			replaces[Anum_pg_statistic_stadistinct - 1] = true;
+		}
+		newtup = heap_modify_tuple(oldtup, RelationGetDescr(sd),
+								   values, nulls, replaces);
+		ReleaseSysCache(oldtup);
+		CatalogTupleUpdate(sd, &newtup->t_self, newtup);
+		heap_freetuple(newtup);
+	}
+	table_close(sd, RowExclusiveLock);
+	CommandCounterIncrement();
+
+	pfree(buf.data);
+	pfree(ndistincts);
+	pfree(nonnulls);
+	PG_RETURN_VOID();
+}
+
 /*
  * __pgstrom_init_xpupreagg_common
  */
@@ -1868,6 +2723,33 @@ pgstrom_init_gpu_preagg(void)
 							 PGC_USERSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* pg_strom.enable_gpupreagg_final */
+	DefineCustomBoolVariable("pg_strom.enable_gpupreagg_final",
+							 "Enables GPU-PreAgg to return the final results without Agg node",
+							 NULL,
+							 &pgstrom_enable_gpupreagg_final,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* pg_strom.enable_gpupreagg_distinct */
+	DefineCustomBoolVariable("pg_strom.enable_gpupreagg_distinct",
+							 "Enables GPU-PreAgg to deduplicate SELECT DISTINCT",
+							 NULL,
+							 &pgstrom_enable_gpupreagg_distinct,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* pg_strom.enable_gpupreagg_streaming */
+	DefineCustomBoolVariable("pg_strom.enable_gpupreagg_streaming",
+							 "Enables GPU-PreAgg to return groups for each chunk, if input is clustered by the grouping key",
+							 NULL,
+							 &pgstrom_enable_gpupreagg_streaming,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	/* pg_strom.hll_registers_bits */
 	DefineCustomIntVariable("pg_strom.hll_registers_bits",
 							"Accuracy of HyperLogLog COUNT(distinct ...) estimation",
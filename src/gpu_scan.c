@@ -17,6 +17,7 @@ static CustomPathMethods	gpuscan_path_methods;
 static CustomScanMethods	gpuscan_plan_methods;
 static CustomExecMethods	gpuscan_exec_methods;
 static bool					enable_gpuscan = false;		/* GUC */
+static bool					enable_hybrid_scan = false;	/* GUC */
 static CustomPathMethods	dpuscan_path_methods;
 static CustomScanMethods	dpuscan_plan_methods;
 static CustomExecMethods	dpuscan_exec_methods;
@@ -70,6 +71,61 @@ sort_device_qualifiers(List *dev_quals_list, List *dev_costs_list)
 	}
 }
 
+/*
+ * __buildSimpleScanTableSample
+ *
+ * It checks whether the TABLESAMPLE clause, if any, is supported by
+ * the xPU scan. Only built-in SYSTEM and BERNOULLI methods with constant
+ * arguments are supported on GPU. Without REPEATABLE clause, the seed is
+ * chosen at the executor startup, thus, parallel workers cannot share it.
+ */
+static bool
+__buildSimpleScanTableSample(RangeTblEntry *rte,
+							 uint32_t xpu_task_flags,
+							 bool parallel_path,
+							 char *p_method,
+							 double *p_percent,
+							 bool *p_repeatable,
+							 double *p_seed)
+{
+	TableSampleClause *tsc = rte->tablesample;
+	Const	   *con;
+
+	*p_method = '\0';
+	*p_percent = 100.0;
+	*p_repeatable = false;
+	*p_seed = 0.0;
+	if (!tsc)
+		return true;
+	if ((xpu_task_flags & DEVKIND__ANY) != DEVKIND__NVIDIA_GPU)
+		return false;
+	if (tsc->tsmhandler == F_SYSTEM)
+		*p_method = KERN_TABLESAMPLE__SYSTEM;
+	else if (tsc->tsmhandler == F_BERNOULLI)
+		*p_method = KERN_TABLESAMPLE__BERNOULLI;
+	else
+		return false;
+	if (list_length(tsc->args) != 1)
+		return false;
+	con = linitial(tsc->args);
+	if (!IsA(con, Const) || con->constisnull ||
+		con->consttype != FLOAT4OID)
+		return false;
+	*p_percent = DatumGetFloat4(con->constvalue);
+	if (tsc->repeatable)
+	{
+		con = (Const *)tsc->repeatable;
+		if (!IsA(con, Const) || con->constisnull ||
+			con->consttype != FLOAT8OID)
+			return false;
+		*p_repeatable = true;
+		*p_seed = DatumGetFloat8(con->constvalue);
+	}
+	else if (parallel_path)
+		return false;
+	return true;
+}
+
 /*
  * buildSimpleScanPlanInfo
  */
@@ -103,9 +159,24 @@ __buildSimpleScanPlanInfo(PlannerInfo *root,
 	double			avg_seq_page_cost;
 	double			xpu_ratio;
 	double			xpu_tuple_cost;
+	double			xpu_setup_cost;
 	QualCost		qcost;
 	double			ntuples = baserel->tuples;
 	double			selectivity;
+	char			tablesample_method;
+	double			tablesample_percent;
+	bool			tablesample_repeatable;
+	double			tablesample_seed;
+
+	/*
+	 * Check TABLESAMPLE clause, if any
+	 */
+	if (!__buildSimpleScanTableSample(rte, xpu_task_flags, parallel_path,
+									  &tablesample_method,
+									  &tablesample_percent,
+									  &tablesample_repeatable,
+									  &tablesample_seed))
+		return NULL;
 
 	/*
 	 * CPU Parallel parameters
@@ -141,9 +212,10 @@ __buildSimpleScanPlanInfo(PlannerInfo *root,
 	{
 		xpu_ratio = pgstrom_gpu_operator_ratio();
 		xpu_tuple_cost = pgstrom_gpu_tuple_cost;
-		startup_cost += pgstrom_gpu_setup_cost;
-		/* Is GPU-Cache available? */
-		gpu_cache_dindex = baseRelHasGpuCache(root, baserel);
+		xpu_setup_cost = pgstrom_gpu_setup_cost;
+		/* Is GPU-Cache available? (not for TABLESAMPLE) */
+		if (!rte->tablesample)
+			gpu_cache_dindex = baseRelHasGpuCache(root, baserel);
 		/* Is GPU-Direct SQL available? */
 		gpu_direct_devs = GetOptimalGpuForBaseRel(root, baserel);
 		if (gpu_cache_dindex >= 0)
@@ -158,7 +230,7 @@ __buildSimpleScanPlanInfo(PlannerInfo *root,
 	{
 		xpu_ratio = pgstrom_dpu_operator_ratio();
 		xpu_tuple_cost = pgstrom_dpu_tuple_cost;
-		startup_cost += pgstrom_dpu_setup_cost;
+		xpu_setup_cost = pgstrom_dpu_setup_cost;
 		/* Is DPU-attached Storage available? */
 		if (rte->relkind == RELKIND_FOREIGN_TABLE)
 			ds_entry = GetOptimalDpuForArrowFdw(root, baserel);
@@ -173,6 +245,14 @@ __buildSimpleScanPlanInfo(PlannerInfo *root,
 	{
 		elog(ERROR, "Bug? unsupported xpu_task_flags: %08x", xpu_task_flags);
 	}
+	/* calibrated by the runtime statistics, if any (except for GPU-Cache) */
+	if (gpu_cache_dindex < 0)
+		pgstromCostCalibLookup(xpu_task_flags & DEVKIND__ANY,
+							   baserel->reltablespace,
+							   &xpu_setup_cost,
+							   &avg_seq_page_cost,
+							   &xpu_tuple_cost);
+	startup_cost += xpu_setup_cost;
 
 	/*
 	 * NOTE: ArrowGetForeignRelSize() already discount baserel->pages according
@@ -256,11 +336,18 @@ __buildSimpleScanPlanInfo(PlannerInfo *root,
 	pp_info = palloc0(sizeof(pgstromPlanInfo));
 	pp_info->xpu_task_flags = xpu_task_flags;
 	pp_info->gpu_cache_dindex = gpu_cache_dindex;
+	if (gpu_cache_dindex >= 0)
+		pp_info->gpu_cache_vcols = baseRelGpuCacheVirtualColumns(root, baserel);
 	pp_info->gpu_direct_devs = gpu_direct_devs;
 	pp_info->ds_entry = ds_entry;
 	pp_info->scan_relid = baserel->relid;
 	pp_info->host_quals = extract_actual_clauses(host_quals, false);
 	pp_info->scan_quals = extract_actual_clauses(dev_quals, false);
+	if (gpu_cache_dindex >= 0)
+		pp_info->gpu_cache_index_key =
+			baseRelGpuCacheIndexQual(root, baserel,
+									 pp_info->scan_quals,
+									 &pp_info->gpu_cache_index_attnum);
 	pp_info->scan_tuples = baserel->tuples;
 	pp_info->scan_nrows = scan_nrows;
 	pp_info->parallel_nworkers = parallel_nworkers;
@@ -274,6 +361,10 @@ __buildSimpleScanPlanInfo(PlannerInfo *root,
 		pp_info->brin_index_conds = indexConds;
 		pp_info->brin_index_quals = indexQuals;
 	}
+	pp_info->tablesample_method = tablesample_method;
+	pp_info->tablesample_repeatable = tablesample_repeatable;
+	pp_info->tablesample_percent = tablesample_percent;
+	pp_info->tablesample_seed = tablesample_seed;
 	outer_refs = pickup_outer_referenced(root, baserel, outer_refs);
 	pull_varattnos((Node *)pp_info->host_quals,
 				   baserel->relid, &outer_refs);
@@ -409,6 +500,16 @@ try_add_simple_scan_path(PlannerInfo *root,
 											  xpu_task_flags,
 											  be_parallel);
 		}
+		else if (baseRelIsFileFdw(baserel) &&
+				 (xpu_task_flags & DEVKIND__ANY) == DEVKIND__NVIDIA_GPU &&
+				 !be_parallel)
+		{
+			/* file_fdw rows are parsed by the host, then sent to GPU */
+			op_leaf = buildSimpleScanPlanInfo(root,
+											  baserel,
+											  xpu_task_flags,
+											  be_parallel);
+		}
 	}
 
 	if (op_leaf)
@@ -861,6 +962,59 @@ PlanXpuScanPathCommon(PlannerInfo *root,
 	return cscan;
 }
 
+/*
+ * __gpuscan_try_hybrid_dpu
+ *
+ * It returns the DPU endpoint to share a parallel GpuScan, if the relation
+ * is also on the DPU storage and the device code is runnable on the DPU.
+ */
+static const DpuStorageEntry *
+__gpuscan_try_hybrid_dpu(PlannerInfo *root,
+						 RelOptInfo *baserel,
+						 CustomPath *best_path,
+						 CustomScan *cscan,
+						 pgstromPlanInfo *pp_info)
+{
+	RangeTblEntry  *rte = root->simple_rte_array[baserel->relid];
+	const DpuStorageEntry *ds_entry;
+	uint32_t		dpu_task_flags;
+	ListCell	   *lc;
+
+	if (!enable_hybrid_scan ||
+		!best_path->path.parallel_aware ||
+		rte->relkind != RELKIND_RELATION ||
+		pp_info->gpu_cache_dindex >= 0 ||
+		pp_info->tablesample_method != '\0')
+		return NULL;
+	ds_entry = GetOptimalDpuForBaseRel(root, baserel);
+	if (!ds_entry)
+		return NULL;
+	dpu_task_flags = ((pp_info->xpu_task_flags & ~DEVKIND__ANY) |
+					  DEVKIND__NVIDIA_DPU);
+	foreach (lc, pp_info->scan_quals)
+	{
+		if (!pgstrom_xpu_expression(lfirst(lc),
+									dpu_task_flags,
+									baserel->relid,
+									NIL,
+									NULL))
+			return NULL;
+	}
+	foreach (lc, cscan->custom_scan_tlist)
+	{
+		TargetEntry *tle = lfirst(lc);
+
+		if (!IsA(tle->expr, Var) &&
+			!pgstrom_xpu_expression(tle->expr,
+									dpu_task_flags,
+									baserel->relid,
+									NIL,
+									NULL))
+			return NULL;
+	}
+	return ds_entry;
+}
+
 /*
  * PlanGpuScanPath
  */
@@ -886,6 +1040,10 @@ PlanGpuScanPath(PlannerInfo *root,
 								  clauses,
 								  pp_info,
 								  &gpuscan_plan_methods);
+	pp_info->ds_entry = __gpuscan_try_hybrid_dpu(root, baserel, best_path,
+												 cscan, pp_info);
+	pgstrom_build_gpusort_topk(root, baserel, cscan, pp_info);
+	pgstrom_build_scan_limit(root, baserel, pp_info);
 	form_pgstrom_plan_info(cscan, pp_info);
 	return &cscan->scan.plan;
 }
@@ -947,15 +1105,13 @@ bool
 ExecFallbackCpuScan(pgstromTaskState *pts, HeapTuple tuple)
 {
 	ExprContext	   *econtext = pts->css.ss.ps.ps_ExprContext;
-	TupleTableSlot *base_slot = pts->base_slot;
+	TupleTableSlot *base_slot;
 	TupleTableSlot *fallback_slot = pts->css.ss.ss_ScanTupleSlot;
 	ListCell	   *lc1, *lc2;
 	int				attidx = 0;
-	bool			should_free;
 
 	/* Load the base tuple (depth-0) to the fallback slot */
-	ExecForceStoreHeapTuple(tuple, base_slot, false);
-	slot_getallattrs(base_slot);
+	base_slot = pgstromLoadFallbackBaseTuple(pts, tuple);
 	ExecStoreAllNullTuple(fallback_slot);
 	forboth (lc1, pts->fallback_load_src,
 			 lc2, pts->fallback_load_dst)
@@ -999,12 +1155,7 @@ ExecFallbackCpuScan(pgstromTaskState *pts, HeapTuple tuple)
 		attidx++;
 	}
 	/* save the tuple on the fallback buffer */
-	tuple = ExecFetchSlotHeapTuple(fallback_slot,
-								   false,
-								   &should_free);
-	pgstromStoreFallbackTuple(pts, tuple);
-	if (should_free)
-		pfree(tuple);
+	pgstromStoreFallbackSlot(pts, fallback_slot);
 	return true;
 }
 
@@ -1041,6 +1192,15 @@ pgstrom_init_gpu_scan(void)
 							 PGC_USERSET,
 							 GUC_NOT_IN_SAMPLE,
 							 NULL, NULL, NULL);
+	/* pg_strom.enable_hybrid_scan */
+	DefineCustomBoolVariable("pg_strom.enable_hybrid_scan",
+							 "Enables parallel GpuScan to share the scan with DPU",
+							 NULL,
+							 &enable_hybrid_scan,
+							 false,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	/* setup path methods */
 	memset(&gpuscan_path_methods, 0, sizeof(gpuscan_path_methods));
 	gpuscan_path_methods.CustomName			= "GpuScan";
@@ -12,6 +12,15 @@
 #include "pg_strom.h"
 #include "cuda_common.h"
 #include <cudaProfiler.h>
+#include <limits.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#ifndef IOV_MAX
+#define IOV_MAX		1024
+#endif
 /*
  * gpuContext / gpuMemory
  */
@@ -20,15 +29,70 @@ typedef struct
 	pthread_mutex_t	lock;
 	bool			is_managed;	/* true, if managed memory pool */
 	size_t			total_sz;	/* total pool size */
+	size_t			active_sz;	/* total size of the active chunks */
+	int				nsegments;	/* number of segments */
 	size_t			hard_limit;
 	size_t			keep_limit;
 	dlist_head		segment_list;
+	struct gpuServiceStats *stats; /* shared statistics of the device */
 } gpuMemoryPool;
 
+/*
+ * gpuCommandQueue
+ *
+ * XPU commands are distributed to the queues per client, and each worker
+ * thread fetches commands from its home queue first, then steals commands
+ * from the other queues. Commands of the client that already has a backlog
+ * are enqueued to the low-priority lane, so short queries are not blocked
+ * by the full-table scan.
+ */
+#define GPUSERV_COMMAND_NQUEUES			8
+#define GPUSERV_COMMAND_LANE__HIGH		0
+#define GPUSERV_COMMAND_LANE__LOW		1
+#define GPUSERV_COMMAND_NLANES			2
+#define GPUSERV_COMMAND_HIGH_PRIO_LIMIT	2	/* per client */
+
+typedef struct
+{
+	pthread_mutex_t	lock;
+	dlist_head		lanes[GPUSERV_COMMAND_NLANES];
+} gpuCommandQueue;
+
+#define GPU_SESSION_CODE_CACHE_NSLOTS	256
+#define GPU_AUTOTUNE_NSLOTS				256
+
+/*
+ * gpuMonitor
+ *
+ * A fixed number of monitor threads per device receive the commands from
+ * the clients assigned to, using epoll(7), instead of a thread per client.
+ */
+typedef struct gpuMonitor
+{
+	struct gpuContext *gcontext;
+	pthread_t		thread;
+	int				epoll_fd;
+	pg_atomic_uint32 num_clients;	/* # of the clients assigned */
+} gpuMonitor;
+
+#define GPUSERV_MONITOR_NEVENTS		32
+
+/*
+ * gpuDevTypeEntry - an entry of gpuContext::cuda_type_htab
+ */
+typedef struct
+{
+	TypeOpCode	type_opcode;	/* hash key */
+	xpu_datum_operators *type_ops;	/* device pointer */
+	int16_t		type_length;	/* copy of xpu_type_length */
+	int			kvec_sizeof;	/* copy of xpu_kvec_sizeof */
+} gpuDevTypeEntry;
+
 struct gpuContext
 {
 	dlist_node		chain;
 	int				serv_fd;		/* for accept(2) */
+	int				remote_fd;		/* for accept(2) of remote clients, or -1 */
 	int				cuda_dindex;
 	CUdevice		cuda_device;
 	CUcontext		cuda_context;
@@ -42,16 +106,37 @@ struct gpuContext
 	volatile uint32_t cuda_stack_limit;	/* current configuration */
 	pthread_mutex_t	cuda_setlimit_lock;
 	int				gpumain_shmem_sz_dynamic;
+	bool			numa_binding;	/* true, if numa_cpuset is valid */
+	cpu_set_t		numa_cpuset;	/* CPUs on the local NUMA node */
 	/* GPU client */
 	pthread_mutex_t	client_lock;
 	dlist_head		client_list;
+	int				num_monitors;
+	gpuMonitor	   *monitors;
 	/* GPU workers */
 	pthread_mutex_t	worker_lock;
 	dlist_head		worker_list;
+	/* admission control of the sessions */
+	pthread_mutex_t	admission_lock;
+	pthread_cond_t	admission_cond;
+	uint32_t		num_active_sessions;
+	uint64_t		reserved_mem_quota;
 	/* XPU commands */
-	pthread_cond_t	cond;
+	pthread_cond_t	cond;		/* to wake up the idle workers */
 	pthread_mutex_t	lock;
-	dlist_head		command_list;
+	pg_atomic_uint32 num_queued_cmds;
+	pg_atomic_uint32 num_idle_workers;
+	pg_atomic_uint32 worker_seq;
+	pg_atomic_uint32 client_seq;
+	gpuCommandQueue	cmd_queues[GPUSERV_COMMAND_NQUEUES];
+	/* statistics */
+	struct gpuServiceStats *stats;
+	/* resolved xpucode of the recent sessions */
+	pthread_mutex_t	session_code_lock;
+	struct gpuSessionCodeEntry *session_code_cache[GPU_SESSION_CODE_CACHE_NSLOTS];
+	/* launch configuration chosen by the autotuner */
+	pthread_mutex_t	autotune_lock;
+	struct gpuAutoTuneEntry *autotune_cache[GPU_AUTOTUNE_NSLOTS];
 };
 
 struct gpuClient
@@ -63,7 +148,22 @@ struct gpuClient
 	pg_atomic_uint32 refcnt;	/* odd number, if error status */
 	pthread_mutex_t	mutex;		/* mutex to write the socket */
 	int				sockfd;		/* connection to PG backend */
-	pthread_t		worker;		/* receiver thread */
+	bool			is_remote;	/* connected over TCP from the other host */
+	uint64_t		remote_peer_key; /* hash of the peer address, if remote */
+	gpuMonitor	   *monitor;	/* receiver thread */
+	CUfunction		jit_kern_gpumain; /* runtime-specialized kernel, if any */
+	xpuStagingRing *staging_ring; /* pinned host staging ring, if any */
+	size_t			staging_ring_sz;
+	bool			staging_ring_pinned;
+	uint32_t		queue_index;	/* home of the commands */
+	pg_atomic_uint32 num_queued_cmds; /* commands not picked up yet */
+	bool			admitted;		/* counted in num_active_sessions */
+	gpuSessionInfoSlot *sinfo;		/* slot of gpu_session_info, or local */
+	gpuSessionInfoSlot __sinfo_local;
+	struct gpuTraceBuffer *trace;	/* execution trace, if pg_strom.gpu_trace */
+	volatile bool	task_cancelled;	/* XpuTaskCancel was received */
+	uint32_t	   *abort_flag;		/* host-mapped flag for running kernels */
+	CUdeviceptr		m_abort_flag;
 };
 
 #define GPUSERV_WORKER_KIND__GPUTASK		't'
@@ -84,15 +184,94 @@ typedef struct
 //#define __SIGWAKEUP		(__SIGRTMIN + 3)
 #define __SIGWAKEUP		SIGUSR2
 
+/*
+ * GpuJoin inner buffer cache
+ *
+ * The slots tell the backends which inner buffers are kept by the GPU
+ * service after the query end. They are updated only by the GPU service,
+ * except for 'last_used' that is also touched by the backend when it
+ * attaches the cached buffer. A slot with last_used == 0 is being released.
+ */
+#define GPU_INNER_CACHE_NSLOTS		64
+#define GPU_INNER_CACHE_LEASE		30000000UL	/* 30s; min idle time to evict */
+#define GPU_INNER_CACHE_EXPIRE		600000000UL	/* 10min; idle time to expire */
+#define GPU_QUERY_BUFFER_RETAIN		2000000UL	/* 2s; idle time to keep the
+												 * inner buffer for rescan */
+
+typedef struct
+{
+	pg_atomic_uint64	fingerprint;	/* 0, if unused slot */
+	pg_atomic_uint64	last_used;		/* timestamp in usec (monotonic) */
+	uint8_t				digest[KERN_INNER_CACHE_DIGEST_LEN];
+										/* SHA-256 of the whole fingerprint */
+	uint32_t			shmem_handle;	/* alias of the host inner buffer */
+	int32_t				cuda_dindex;	/* GPU device that keeps the buffer */
+	uint64_t			kmrels_sz;		/* length of the inner buffer */
+} gpuInnerCacheSlot;
+
+/*
+ * GPU session info
+ *
+ * The slots expose the device memory usage of the sessions connected to
+ * the GPU service, for the pgstrom.gpu_session_info view.
+ */
+#define GPU_SESSION_INFO_NSLOTS		256
+
+typedef struct
+{
+	pg_atomic_uint32	backend_pid;	/* 0, if unused slot */
+	int32_t				cuda_dindex;
+	uint32_t			plan_node_id;
+	uint64_t			mem_quota;		/* 0, if unlimited */
+	pg_atomic_uint64	mem_usage;		/* current usage of the session */
+	pg_atomic_uint64	mem_peak;		/* peak usage of the session */
+	uint64_t			admission_wait;	/* usec to wait for the admission */
+} gpuSessionInfoSlot;
+
+/*
+ * GPU service statistics
+ *
+ * Per-device counters for the pgstrom.gpu_service_stats view. Pool sizes and
+ * queue depth are the current values, the others are cumulative since the
+ * GPU service starts.
+ */
+#define GPUSERV_LATENCY_NBUCKETS	6	/* <100us, <1ms, <10ms, <100ms, <1s, or more */
+
+typedef struct gpuServiceStats
+{
+	pg_atomic_uint32	num_clients;		/* # of connected clients */
+	pg_atomic_uint32	num_queued_cmds;	/* # of commands in the queues */
+	pg_atomic_uint32	pool_nsegments[2];	/* [0]: device, [1]: managed */
+	pg_atomic_uint64	pool_total_sz[2];
+	pg_atomic_uint64	pool_active_sz[2];
+	pg_atomic_uint64	alloc_failures;
+	pg_atomic_uint64	npages_direct_read;
+	pg_atomic_uint64	npages_vfs_read;
+	pg_atomic_uint64	num_tasks;
+	pg_atomic_uint64	num_fallbacks;
+	pg_atomic_uint64	kern_nlaunches;
+	pg_atomic_uint64	kern_total_usec;
+	pg_atomic_uint64	kern_latency_hist[GPUSERV_LATENCY_NBUCKETS];
+} gpuServiceStats;
+
 typedef struct
 {
 	volatile pid_t		gpuserv_pid;
 	volatile bool		gpuserv_ready_accept;
+	volatile bool		shared_buffers_dma;	/* shared_buffers is registered */
 	pg_atomic_uint32	max_async_tasks_updated;
 	pg_atomic_uint32	max_async_tasks;
 	pg_atomic_uint32	gpuserv_debug_output;
+	pg_atomic_uint64	gpu_module_cache_hits;
+	pg_atomic_uint64	gpu_module_cache_misses;
+	gpuInnerCacheSlot	inner_cache[GPU_INNER_CACHE_NSLOTS];
+	gpuSessionInfoSlot	session_info[GPU_SESSION_INFO_NSLOTS];
+	gpuServiceStats		gpu_stats[FLEXIBLE_ARRAY_MEMBER];	/* per device */
 } gpuServSharedState;
 
+#define GPUSERV_SHARED_STATE_LENGTH								\
+	MAXALIGN(offsetof(gpuServSharedState, gpu_stats[numGpuDevAttrs]))
+
 /*
  * variables
  */
@@ -101,7 +280,17 @@ static __thread CUdevice	MY_DEVICE_PER_THREAD = -1;
 static __thread CUcontext	MY_CONTEXT_PER_THREAD = NULL;
 static __thread CUstream	MY_STREAM_PER_THREAD = NULL;
 static __thread CUevent		MY_EVENT_PER_THREAD = NULL;
+static __thread CUevent		MY_EVENT_BEGIN_PER_THREAD = NULL;
+static __thread CUmemoryPool MY_MEMPOOL_PER_THREAD = NULL;
+static __thread CUstream	MY_LOAD_STREAM_PER_THREAD = NULL;
+static __thread CUevent		MY_LOAD_EVENT_PER_THREAD = NULL;
+static __thread uint32_t	MY_LOAD_ERRCODE_PER_THREAD = 0;
+static __thread CUfunction	MY_GRAPH_FUNC_PER_THREAD = NULL;
+static __thread CUgraph		MY_GRAPH_PER_THREAD = NULL;
+static __thread CUgraphNode	MY_GRAPH_NODE_PER_THREAD = NULL;
+static __thread CUgraphExec	MY_GRAPH_EXEC_PER_THREAD = NULL;
 static __thread gpuContext *GpuWorkerCurrentContext = NULL;
+static __thread pid_t		MY_TRACE_TID_PER_THREAD = 0;
 static volatile int	gpuserv_bgworker_got_signal = 0;
 static dlist_head	gpuserv_gpucontext_list;
 static int			gpuserv_epoll_fdesc = -1;
@@ -112,10 +301,48 @@ static shmem_request_hook_type shmem_request_next = NULL;
 static shmem_startup_hook_type shmem_startup_next = NULL;
 static gpuServSharedState *gpuserv_shared_state = NULL;
 static int			__pgstrom_max_async_tasks_dummy;
+static int			pgstrom_gpu_admission_max_sessions;	/* GUC */
+static int			pgstrom_gpuserv_monitor_threads;	/* GUC */
+static char		   *pgstrom_gpuserv_remote_listen_address = NULL;	/* GUC */
+static int			pgstrom_gpuserv_remote_listen_port = 0;		/* GUC */
+static char		   *pgstrom_gpuserv_remote_allowed_hosts = NULL;	/* GUC */
+static char		   *pgstrom_gpuserv_remote_arrow_dir = NULL;	/* GUC */
+char			   *pgstrom_gpuserv_remote_secret = NULL;	/* GUC */
+
+/* peers of remote clients; by pg_strom.gpuserv_remote_allowed_hosts */
+#define GPUSERV_REMOTE_ALLOWED_MAX_NITEMS	64
+typedef struct
+{
+	int			family;		/* AF_INET or AF_INET6 */
+	int			masklen;	/* length of the network prefix in bits */
+	uint8_t		addr[16];
+} gpuServRemoteAllowedHost;
+
+typedef struct
+{
+	int			nitems;
+	gpuServRemoteAllowedHost entries[FLEXIBLE_ARRAY_MEMBER];
+} gpuServRemoteAllowedHosts;
+
+static gpuServRemoteAllowedHosts *gpuserv_remote_allowed_hosts = NULL;
+static const char  *gpuserv_remote_arrow_dir = NULL;	/* canonical path */
 static int			__pgstrom_cuda_stack_limit_kb;
 static bool			__gpuserv_debug_output_dummy;
 static char		   *pgstrom_cuda_toolkit_basedir = CUDA_TOOLKIT_BASEDIR; /* GUC */
+bool				pgstrom_jit_kernels = false;		/* GUC */
+bool				pgstrom_gpu_trace = false;			/* GUC */
+static char		   *pgstrom_gpu_trace_directory = NULL;	/* GUC */
 static const char  *pgstrom_fatbin_image_filename = "/dev/null";
+static const char  *pgstrom_fatbin_image_basename = NULL;
+static char		  **gpuserv_user_cuda_sources = NULL;	/* by extensions */
+static int			gpuserv_num_user_cuda_sources = 0;
+static bool			pgstrom_gpu_module_cache;	/* GUC */
+static bool			pgstrom_gpu_mempool_stream_ordered;	/* GUC */
+static bool			pgstrom_gpu_task_graph_launch;		/* GUC */
+static bool			pgstrom_gpudirect_async_load;		/* GUC */
+static bool			pgstrom_gpu_numa_binding;			/* GUC */
+static bool			pgstrom_gpu_kernel_autotune;		/* GUC */
+static bool			pgstrom_gpu_shared_buffers_dma;		/* GUC */
 
 
 static void
@@ -415,13 +642,10 @@ __gpu_archtecture_label(int major_cc, int minor_cc)
 #define PGSTROM_FATBIN_DIR		".pgstrom_fatbin"
 
 static void
-__appendTextFromFile(StringInfo buf, const char *filename, const char *suffix)
+__appendTextFromPath(StringInfo buf, const char *path)
 {
-	char	path[MAXPGPATH];
 	int		fdesc;
 
-	snprintf(path, MAXPGPATH,
-			 PGSHAREDIR "/pg_strom/%s%s", filename, suffix ? suffix : "");
 	fdesc = open(path, O_RDONLY);
 	if (fdesc < 0)
 		elog(ERROR, "could not open '%s': %m", path);
@@ -465,6 +689,56 @@ __appendTextFromFile(StringInfo buf, const char *filename, const char *suffix)
 	close(fdesc);
 }
 
+static void
+__appendTextFromFile(StringInfo buf, const char *filename, const char *suffix)
+{
+	char	path[MAXPGPATH];
+
+	snprintf(path, MAXPGPATH,
+			 PGSHAREDIR "/pg_strom/%s%s", filename, suffix ? suffix : "");
+	__appendTextFromPath(buf, path);
+}
+
+/*
+ * __setup_user_cuda_sources
+ *
+ * It picks up the distinct CUDA sources of the device functions registered
+ * by extensions. The list is kept on the malloc'ed memory, because the
+ * builder threads of the JIT modules also reference it.
+ */
+static void
+__setup_user_cuda_sources(void)
+{
+	const pgstromUserDevFunc *ufuncs;
+	int			nitems;
+
+	ufuncs = pgstrom_user_devfunc_catalog(&nitems);
+	if (nitems == 0)
+		return;
+	gpuserv_user_cuda_sources = calloc(nitems, sizeof(char *));
+	if (!gpuserv_user_cuda_sources)
+		elog(ERROR, "out of memory");
+	for (int i=0; i < nitems; i++)
+	{
+		const char *source = ufuncs[i].cuda_source;
+		int			j;
+
+		if (!source)
+			continue;
+		for (j=0; j < gpuserv_num_user_cuda_sources; j++)
+		{
+			if (strcmp(gpuserv_user_cuda_sources[j], source) == 0)
+				break;
+		}
+		if (j < gpuserv_num_user_cuda_sources)
+			continue;
+		gpuserv_user_cuda_sources[j] = strdup(source);
+		if (!gpuserv_user_cuda_sources[j])
+			elog(ERROR, "out of memory");
+		gpuserv_num_user_cuda_sources++;
+	}
+}
+
 static char *
 __setup_gpu_fatbin_filename(void)
 {
@@ -504,6 +778,9 @@ __setup_gpu_fatbin_filename(void)
 	{
 		__appendTextFromFile(&buf, tok, ".cu");
 	}
+	/* CUDA sources supplied by extensions */
+	for (int i=0; i < gpuserv_num_user_cuda_sources; i++)
+		__appendTextFromPath(&buf, gpuserv_user_cuda_sources[i]);
 	/*
 	 * Calculation of MD5SUM. Note that pg_md5_hash internally use
 	 * ResourceOwner to track openSSL memory, however, we may not
@@ -683,6 +960,25 @@ __rebuild_gpu_fatbin_file(const char *fatbin_dir,
 						 tok,
 						 PGSHAREDIR, tok, tok);
 	}
+	for (int i=0; i < gpuserv_num_user_cuda_sources; i++)
+	{
+		appendStringInfo(&cmd,
+						 " & /bin/sh -x -c '%s/bin/nvcc"
+						 " --maxrregcount=%d"
+						 " --source-in-ptx -lineinfo"
+						 " -I. -I%s -I%s/pg_strom"
+						 " -DHAVE_FLOAT2 "
+						 " -arch=native --threads 4"
+						 " --device-c"
+						 " -o user_%d.o"
+						 " %s' > user_%d.log 2>&1",
+						 pgstrom_cuda_toolkit_basedir,
+						 CUDA_MAXREGCOUNT,
+						 PGINCLUDEDIR,
+						 PGSHAREDIR,
+						 i,
+						 gpuserv_user_cuda_sources[i], i);
+	}
 	appendStringInfo(&cmd,
 					 ") && wait;"
 					 " /bin/sh -x -c '%s/bin/nvcc"
@@ -699,6 +995,8 @@ __rebuild_gpu_fatbin_file(const char *fatbin_dir,
 	{
 		appendStringInfo(&cmd, " %s.o", tok);
 	}
+	for (int i=0; i < gpuserv_num_user_cuda_sources; i++)
+		appendStringInfo(&cmd, " user_%d.o", i);
 	appendStringInfo(&cmd, "' > %s.log 2>&1", fatbin_file);
 
 	elog(LOG, "rebuild fatbin command: %s", cmd.data);
@@ -726,6 +1024,12 @@ __rebuild_gpu_fatbin_file(const char *fatbin_dir,
 						 workdir, tok,
 						 PGSTROM_FATBIN_DIR, fatbin_file);
 	}
+	for (int i=0; i < gpuserv_num_user_cuda_sources; i++)
+	{
+		appendStringInfo(&cmd, "; cat %s/user_%d.log >> %s/%s.log",
+						 workdir, i,
+						 PGSTROM_FATBIN_DIR, fatbin_file);
+	}
 	appendStringInfo(&cmd, "; cat %s/%s.log >> %s/%s.log",
 					 workdir, fatbin_file,
 					 PGSTROM_FATBIN_DIR, fatbin_file);
@@ -734,13 +1038,41 @@ __rebuild_gpu_fatbin_file(const char *fatbin_dir,
 		elog(ERROR, "failed on shell command: %s", cmd.data);
 }
 
+/*
+ * gpuservSetupFatbin
+ *
+ * It determines the fatbin filename only. Validation (and rebuild on
+ * demand) of the fatbin is deferred to __gpuservValidateFatbin() for
+ * the case when GPU module cache is not available.
+ */
 static void
 gpuservSetupFatbin(void)
 {
-	const char *fatbin_file = __setup_gpu_fatbin_filename();
+	const char *fatbin_file;
+	char	   *path;
+
+	__setup_user_cuda_sources();
+	fatbin_file = __setup_gpu_fatbin_filename();
+
+	path = alloca(strlen(PGSTROM_FATBIN_DIR) +
+				  strlen(fatbin_file) + 100);
+	sprintf(path, "%s/%s", PGSTROM_FATBIN_DIR, fatbin_file);
+	pgstrom_fatbin_image_filename = strdup(path);
+	pgstrom_fatbin_image_basename = strdup(fatbin_file);
+	if (!pgstrom_fatbin_image_filename || !pgstrom_fatbin_image_basename)
+		elog(ERROR, "out of memory");
+}
+
+static void
+__gpuservValidateFatbin(void)
+{
+	static bool	fatbin_validated = false;
+	const char *fatbin_file = pgstrom_fatbin_image_basename;
 	const char *fatbin_dir = PGSHAREDIR "/pg_strom";
 	char	   *path;
 
+	if (fatbin_validated)
+		return;
 	if (!__validate_gpu_fatbin_file(fatbin_dir,
 									fatbin_file))
 	{
@@ -759,6 +1091,335 @@ gpuservSetupFatbin(void)
 	if (!pgstrom_fatbin_image_filename)
 		elog(ERROR, "out of memory");
 	elog(LOG, "PG-Strom fatbin image is ready: %s", fatbin_file);
+	fatbin_validated = true;
+}
+
+/*
+ * GPU module cache
+ *
+ * Validation of the fatbin takes a few seconds because it runs cuobjdump,
+ * and cuModuleLoad() also needs to pick up the device code for each GPU.
+ * So, we keep the cubin image linked for each device at the
+ * PGSTROM_FATBIN_DIR/cache directory, and load it using cuModuleLoadData()
+ * on the next startup. The cache filename contains the fatbin name (CUDA
+ * driver version and md5 of the GPU source code as build-id) and the
+ * compute capability of the device, thus, it is never used for different
+ * device or binary.
+ */
+static char *
+__gpuModuleCacheFilename(gpuContext *gcontext)
+{
+	GpuDevAttributes *dattrs = &gpuDevAttrs[gcontext->cuda_dindex];
+	const char *base = pgstrom_fatbin_image_basename;
+	int			len = strlen(base);
+
+	if (len > 7 && strcmp(base + len - 7, ".fatbin") == 0)
+		len -= 7;
+	return psprintf("%s/cache/%.*s-%s.cubin",
+					PGSTROM_FATBIN_DIR, len, base,
+					__gpu_archtecture_label(dattrs->COMPUTE_CAPABILITY_MAJOR,
+											dattrs->COMPUTE_CAPABILITY_MINOR));
+}
+
+static bool
+__gpuModuleCacheLoad(gpuContext *gcontext, CUmodule *p_cuda_module)
+{
+	char	   *path = __gpuModuleCacheFilename(gcontext);
+	char	   *image = NULL;
+	struct stat	stat_buf;
+	int			fdesc;
+	CUresult	rc;
+	bool		retval = false;
+
+	fdesc = open(path, O_RDONLY);
+	if (fdesc < 0)
+	{
+		if (errno != ENOENT)
+			elog(LOG, "could not open '%s': %m", path);
+		goto out;
+	}
+	if (fstat(fdesc, &stat_buf) != 0)
+	{
+		elog(LOG, "failed on fstat('%s'): %m", path);
+		goto out;
+	}
+	image = palloc(stat_buf.st_size);
+	if (__readFile(fdesc, image, stat_buf.st_size) != stat_buf.st_size)
+	{
+		elog(LOG, "failed on read('%s'): %m", path);
+		goto out;
+	}
+	rc = cuModuleLoadData(p_cuda_module, image);
+	if (rc != CUDA_SUCCESS)
+	{
+		elog(LOG, "failed on cuModuleLoadData('%s'): %s",
+			 path, cuStrError(rc));
+		goto out;
+	}
+	elog(LOG, "GPU%d: PG-Strom GPU module was loaded from the cache: %s",
+		 gcontext->cuda_dindex, path);
+	retval = true;
+out:
+	if (fdesc >= 0)
+		close(fdesc);
+	if (image)
+		pfree(image);
+	pfree(path);
+	return retval;
+}
+
+static void
+__gpuModuleCacheStore(gpuContext *gcontext)
+{
+	char	   *path = __gpuModuleCacheFilename(gcontext);
+	char	   *temp = psprintf("%s.%u.tmp", path, MyProcPid);
+	CUlinkState	lstate;
+	void	   *cubin;
+	size_t		cubin_sz;
+	int			fdesc;
+	CUresult	rc;
+
+	rc = cuLinkCreate(0, NULL, NULL, &lstate);
+	if (rc != CUDA_SUCCESS)
+	{
+		elog(LOG, "failed on cuLinkCreate: %s", cuStrError(rc));
+		goto out;
+	}
+	rc = cuLinkAddFile(lstate, CU_JIT_INPUT_FATBINARY,
+					   pgstrom_fatbin_image_filename,
+					   0, NULL, NULL);
+	if (rc != CUDA_SUCCESS)
+	{
+		elog(LOG, "failed on cuLinkAddFile('%s'): %s",
+			 pgstrom_fatbin_image_filename, cuStrError(rc));
+		goto out_link;
+	}
+	rc = cuLinkComplete(lstate, &cubin, &cubin_sz);
+	if (rc != CUDA_SUCCESS)
+	{
+		elog(LOG, "failed on cuLinkComplete: %s", cuStrError(rc));
+		goto out_link;
+	}
+	/* write out the cubin image, then rename it */
+	if ((mkdir(PGSTROM_FATBIN_DIR, 0755) != 0 && errno != EEXIST) ||
+		(mkdir(PGSTROM_FATBIN_DIR "/cache", 0755) != 0 && errno != EEXIST))
+	{
+		elog(LOG, "could not create directory '%s/cache': %m",
+			 PGSTROM_FATBIN_DIR);
+		goto out_link;
+	}
+	fdesc = open(temp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fdesc < 0)
+	{
+		elog(LOG, "could not open '%s': %m", temp);
+		goto out_link;
+	}
+	if (__writeFile(fdesc, cubin, cubin_sz) != cubin_sz)
+	{
+		elog(LOG, "failed on write('%s'): %m", temp);
+		close(fdesc);
+		unlink(temp);
+		goto out_link;
+	}
+	close(fdesc);
+	if (rename(temp, path) != 0)
+	{
+		elog(LOG, "failed on rename('%s','%s'): %m", temp, path);
+		unlink(temp);
+		goto out_link;
+	}
+	elog(LOG, "GPU%d: PG-Strom GPU module cache was stored: %s",
+		 gcontext->cuda_dindex, path);
+out_link:
+	rc = cuLinkDestroy(lstate);
+	if (rc != CUDA_SUCCESS)
+		elog(LOG, "failed on cuLinkDestroy: %s", cuStrError(rc));
+out:
+	pfree(temp);
+	pfree(path);
+}
+
+/*
+ * pgstrom_gpu_module_cache_info - SQL function to dump hit/miss counter
+ */
+PG_FUNCTION_INFO_V1(pgstrom_gpu_module_cache_info);
+PUBLIC_FUNCTION(Datum)
+pgstrom_gpu_module_cache_info(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[2];
+	bool		isnull[2];
+	HeapTuple	tuple;
+
+	tupdesc = CreateTemplateTupleDesc(2);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "cache_hits",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 2, "cache_misses",
+					   INT8OID, -1, 0);
+	tupdesc = BlessTupleDesc(tupdesc);
+
+	memset(isnull, 0, sizeof(isnull));
+	values[0] = Int64GetDatum(pg_atomic_read_u64(&gpuserv_shared_state->gpu_module_cache_hits));
+	values[1] = Int64GetDatum(pg_atomic_read_u64(&gpuserv_shared_state->gpu_module_cache_misses));
+	tuple = heap_form_tuple(tupdesc, values, isnull);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(tuple));
+}
+
+/*
+ * pgstrom_gpu_session_info - SQL function to dump device memory usage
+ * of the sessions
+ */
+PG_FUNCTION_INFO_V1(pgstrom_gpu_session_info);
+PUBLIC_FUNCTION(Datum)
+pgstrom_gpu_session_info(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *fncxt;
+	uint32_t   *p_index;
+	Datum		values[7];
+	bool		isnull[7];
+	HeapTuple	tuple;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext	oldcxt;
+		TupleDesc		tupdesc;
+
+		fncxt = SRF_FIRSTCALL_INIT();
+		oldcxt = MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
+
+		tupdesc = CreateTemplateTupleDesc(7);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "pid",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "gpu_id",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 3, "plan_node_id",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 4, "mem_usage",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 5, "mem_peak",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 6, "mem_quota",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 7, "admission_wait",
+						   FLOAT8OID, -1, 0);
+		fncxt->tuple_desc = BlessTupleDesc(tupdesc);
+		fncxt->user_fctx = palloc0(sizeof(uint32_t));
+
+		MemoryContextSwitchTo(oldcxt);
+	}
+	fncxt = SRF_PERCALL_SETUP();
+	p_index = fncxt->user_fctx;
+	while (*p_index < GPU_SESSION_INFO_NSLOTS)
+	{
+		gpuSessionInfoSlot *sinfo = &gpuserv_shared_state->session_info[*p_index];
+		uint32_t	pid = pg_atomic_read_u32(&sinfo->backend_pid);
+
+		(*p_index)++;
+		if (pid == 0 || pid == UINT_MAX)
+			continue;
+		memset(isnull, 0, sizeof(isnull));
+		values[0] = Int32GetDatum(pid);
+		values[1] = Int32GetDatum(sinfo->cuda_dindex);
+		values[2] = Int32GetDatum(sinfo->plan_node_id);
+		values[3] = Int64GetDatum(pg_atomic_read_u64(&sinfo->mem_usage));
+		values[4] = Int64GetDatum(pg_atomic_read_u64(&sinfo->mem_peak));
+		if (sinfo->mem_quota > 0)
+			values[5] = Int64GetDatum(sinfo->mem_quota);
+		else
+			isnull[5] = true;
+		values[6] = Float8GetDatum((double)sinfo->admission_wait / 1000.0);
+
+		tuple = heap_form_tuple(fncxt->tuple_desc, values, isnull);
+		SRF_RETURN_NEXT(fncxt, HeapTupleGetDatum(tuple));
+	}
+	SRF_RETURN_DONE(fncxt);
+}
+
+/*
+ * pgstrom_gpu_service_stats - SQL function to dump the statistics of
+ * the GPU service per device
+ */
+PG_FUNCTION_INFO_V1(pgstrom_gpu_service_stats);
+PUBLIC_FUNCTION(Datum)
+pgstrom_gpu_service_stats(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *fncxt;
+	gpuServiceStats *stats;
+	Datum		values[18];
+	bool		isnull[18];
+	Datum		hist[GPUSERV_LATENCY_NBUCKETS];
+	uint64_t	nlaunches;
+	HeapTuple	tuple;
+	int			j = 0;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext	oldcxt;
+		TupleDesc		tupdesc;
+
+		fncxt = SRF_FIRSTCALL_INIT();
+		oldcxt = MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
+
+		tupdesc = CreateTemplateTupleDesc(18);
+		TupleDescInitEntry(tupdesc, ++j, "gpu_id",            INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, ++j, "active_clients",    INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, ++j, "queued_commands",   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, ++j, "pool_segments",     INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, ++j, "pool_total_sz",     INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, ++j, "pool_used_sz",      INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, ++j, "managed_segments",  INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, ++j, "managed_total_sz",  INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, ++j, "managed_used_sz",   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, ++j, "alloc_failures",    INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, ++j, "direct_read_sz",    INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, ++j, "vfs_read_sz",       INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, ++j, "num_tasks",         INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, ++j, "num_fallbacks",     INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, ++j, "kernel_launches",   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, ++j, "kernel_total_time", FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, ++j, "kernel_avg_time",   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, ++j, "kernel_latency_hist", INT8ARRAYOID, -1, 0);
+		fncxt->tuple_desc = BlessTupleDesc(tupdesc);
+
+		MemoryContextSwitchTo(oldcxt);
+	}
+	fncxt = SRF_PERCALL_SETUP();
+	if (fncxt->call_cntr >= numGpuDevAttrs)
+		SRF_RETURN_DONE(fncxt);
+	stats = &gpuserv_shared_state->gpu_stats[fncxt->call_cntr];
+
+	j = 0;
+	memset(isnull, 0, sizeof(isnull));
+	values[j++] = Int32GetDatum(fncxt->call_cntr);
+	values[j++] = Int32GetDatum(pg_atomic_read_u32(&stats->num_clients));
+	values[j++] = Int32GetDatum(pg_atomic_read_u32(&stats->num_queued_cmds));
+	values[j++] = Int32GetDatum(pg_atomic_read_u32(&stats->pool_nsegments[0]));
+	values[j++] = Int64GetDatum(pg_atomic_read_u64(&stats->pool_total_sz[0]));
+	values[j++] = Int64GetDatum(pg_atomic_read_u64(&stats->pool_active_sz[0]));
+	values[j++] = Int32GetDatum(pg_atomic_read_u32(&stats->pool_nsegments[1]));
+	values[j++] = Int64GetDatum(pg_atomic_read_u64(&stats->pool_total_sz[1]));
+	values[j++] = Int64GetDatum(pg_atomic_read_u64(&stats->pool_active_sz[1]));
+	values[j++] = Int64GetDatum(pg_atomic_read_u64(&stats->alloc_failures));
+	values[j++] = Int64GetDatum(pg_atomic_read_u64(&stats->npages_direct_read) * PAGE_SIZE);
+	values[j++] = Int64GetDatum(pg_atomic_read_u64(&stats->npages_vfs_read) * PAGE_SIZE);
+	values[j++] = Int64GetDatum(pg_atomic_read_u64(&stats->num_tasks));
+	values[j++] = Int64GetDatum(pg_atomic_read_u64(&stats->num_fallbacks));
+	nlaunches = pg_atomic_read_u64(&stats->kern_nlaunches);
+	values[j++] = Int64GetDatum(nlaunches);
+	values[j++] = Float8GetDatum((double)pg_atomic_read_u64(&stats->kern_total_usec) / 1000.0);
+	if (nlaunches > 0)
+		values[j++] = Float8GetDatum((double)pg_atomic_read_u64(&stats->kern_total_usec) /
+									 (1000.0 * (double)nlaunches));
+	else
+		isnull[j++] = true;
+	for (int k=0; k < GPUSERV_LATENCY_NBUCKETS; k++)
+		hist[k] = Int64GetDatum(pg_atomic_read_u64(&stats->kern_latency_hist[k]));
+	values[j++] = PointerGetDatum(construct_array(hist, GPUSERV_LATENCY_NBUCKETS,
+												  INT8OID, sizeof(int64),
+												  FLOAT8PASSBYVAL, TYPALIGN_DOUBLE));
+	tuple = heap_form_tuple(fncxt->tuple_desc, values, isnull);
+	SRF_RETURN_NEXT(fncxt, HeapTupleGetDatum(tuple));
 }
 
 /* ----------------------------------------------------------------
@@ -771,6 +1432,8 @@ static int		pgstrom_gpu_mempool_segment_sz_kb;	/* GUC */
 static double	pgstrom_gpu_mempool_max_ratio;		/* GUC */
 static double	pgstrom_gpu_mempool_min_ratio;		/* GUC */
 static int		pgstrom_gpu_mempool_release_delay;	/* GUC */
+static int		pgstrom_gpu_query_buffer_mode;		/* GUC */
+static int		pgstrom_gpu_query_buffer_zerocopy_threshold_kb;	/* GUC */
 typedef struct
 {
 	dlist_node		chain;
@@ -789,12 +1452,27 @@ typedef struct
 	dlist_node	free_chain;
 	dlist_node	addr_chain;
 	gpuMemorySegment *mseg;
+	gpuSessionInfoSlot *owner;	/* session that is charged, if any */
 	CUdeviceptr	__base;		/* base pointer of the segment */
 	size_t		__offset;	/* offset from the base */
 	size_t		__length;	/* length of the chunk */
 	CUdeviceptr	m_devptr;	/* __base + __offset */
 } gpuMemChunk;
 
+static inline void
+__gpuMemoryPoolUpdateStats(gpuMemoryPool *pool)
+{
+	gpuServiceStats *stats = pool->stats;
+	int			k = (pool->is_managed ? 1 : 0);
+
+	if (stats)
+	{
+		pg_atomic_write_u32(&stats->pool_nsegments[k], pool->nsegments);
+		pg_atomic_write_u64(&stats->pool_total_sz[k], pool->total_sz);
+		pg_atomic_write_u64(&stats->pool_active_sz[k], pool->active_sz);
+	}
+}
+
 static gpuMemChunk *
 __gpuMemAllocFromSegment(gpuMemoryPool *pool,
 						 gpuMemorySegment *mseg,
@@ -835,6 +1513,8 @@ __gpuMemAllocFromSegment(gpuMemoryPool *pool,
 			dlist_delete(&chunk->free_chain);
 			memset(&chunk->free_chain, 0, sizeof(dlist_node));
 			mseg->active_sz += chunk->__length;
+			pool->active_sz += chunk->__length;
+			__gpuMemoryPoolUpdateStats(pool);
 
 			/* update the LRU ordered segment list and timestamp */
 			gettimeofday(&mseg->tval, NULL);
@@ -900,6 +1580,8 @@ __gpuMemAllocNewSegment(gpuMemoryPool *pool, size_t segment_sz)
 
 	dlist_push_head(&pool->segment_list, &mseg->chain);
 	pool->total_sz += segment_sz;
+	pool->nsegments++;
+	__gpuMemoryPoolUpdateStats(pool);
 
 	return mseg;
 error:
@@ -949,7 +1631,10 @@ __gpuMemAllocCommon(gpuMemoryPool *pool, size_t bytesize)
 	}
 out_unlock:	
 	pthreadMutexUnlock(&pool->lock);
-
+	if (chunk)
+		chunk->owner = NULL;
+	else if (pool->stats)
+		pg_atomic_fetch_add_u64(&pool->stats->alloc_failures, 1);
 	return (chunk ? chunk : NULL);
 }
 
@@ -965,6 +1650,44 @@ gpuMemAllocManaged(size_t bytesize)
 	return __gpuMemAllocCommon(&GpuWorkerCurrentContext->pool_managed, bytesize);
 }
 
+/*
+ * gpuMemAllocStreamOrdered
+ *
+ * It allocates the device memory from the stream-ordered memory pool of
+ * the worker thread, if any. Unlike the memory pool above, it takes no
+ * lock shared with the other workers, however, the chunk is not mapped
+ * for GPU-Direct SQL, and must be released by the same worker thread.
+ * Elsewhere, it falls back to the usual gpuMemAlloc().
+ */
+static gpuMemChunk *
+gpuMemAllocStreamOrdered(size_t bytesize)
+{
+	gpuMemChunk *chunk;
+	CUresult	rc;
+
+	if (!MY_MEMPOOL_PER_THREAD)
+		return gpuMemAlloc(bytesize);
+	chunk = calloc(1, sizeof(gpuMemChunk));
+	if (!chunk)
+		return NULL;
+	bytesize = PAGE_ALIGN(bytesize);
+	rc = cuMemAllocFromPoolAsync(&chunk->__base,
+								 bytesize,
+								 MY_MEMPOOL_PER_THREAD,
+								 MY_STREAM_PER_THREAD);
+	if (rc != CUDA_SUCCESS)
+	{
+		__gsDebug("failed on cuMemAllocFromPoolAsync(%zu): %s",
+				  bytesize, cuStrError(rc));
+		free(chunk);
+		return gpuMemAlloc(bytesize);
+	}
+	chunk->__offset = 0;
+	chunk->__length = bytesize;
+	chunk->m_devptr = chunk->__base;
+	return chunk;
+}
+
 static void
 gpuMemFree(gpuMemChunk *chunk)
 {
@@ -975,11 +1698,31 @@ gpuMemFree(gpuMemChunk *chunk)
 
 	Assert(!chunk->free_chain.prev && !chunk->free_chain.next);
 	mseg = chunk->mseg;
+	if (!mseg)
+	{
+		/* chunk of the stream-ordered memory pool */
+		CUresult	rc;
+
+		if (chunk->owner)
+			pg_atomic_fetch_sub_u64(&chunk->owner->mem_usage, chunk->__length);
+		rc = cuMemFreeAsync(chunk->__base, MY_STREAM_PER_THREAD);
+		if (rc != CUDA_SUCCESS)
+			__gsDebug("failed on cuMemFreeAsync: %s", cuStrError(rc));
+		free(chunk);
+		return;
+	}
 	pool = mseg->pool;
+	if (chunk->owner)
+	{
+		pg_atomic_fetch_sub_u64(&chunk->owner->mem_usage, chunk->__length);
+		chunk->owner = NULL;
+	}
 
 	pthreadMutexLock(&pool->lock);
 	/* revert this chunk state to 'free' */
 	mseg->active_sz -= chunk->__length;
+	pool->active_sz -= chunk->__length;
+	__gpuMemoryPoolUpdateStats(pool);
 	dlist_push_head(&mseg->free_chunks,
 					&chunk->free_chain);
 
@@ -1078,6 +1821,8 @@ __gpuMemoryPoolMaintenanceTask(gpuContext *gcontext, gpuMemoryPool *pool)
 					  gcontext->cuda_dindex, mseg->segment_sz);
 			Assert(pool->total_sz >= mseg->segment_sz);
 			pool->total_sz -= mseg->segment_sz;
+			pool->nsegments--;
+			__gpuMemoryPoolUpdateStats(pool);
 			free(mseg);
 			break;
 		}
@@ -1096,11 +1841,15 @@ gpuMemoryPoolMaintenance(gpuContext *gcontext)
 static void
 gpuMemoryPoolInit(gpuMemoryPool *pool,
 				  bool is_managed,
-				  size_t dev_total_memsz)
+				  size_t dev_total_memsz,
+				  gpuServiceStats *stats)
 {
 	pthreadMutexInit(&pool->lock);
 	pool->is_managed = is_managed;
 	pool->total_sz = 0;
+	pool->active_sz = 0;
+	pool->nsegments = 0;
+	pool->stats = stats;
 	pool->hard_limit = pgstrom_gpu_mempool_max_ratio * (double)dev_total_memsz;
 	pool->keep_limit = pgstrom_gpu_mempool_min_ratio * (double)dev_total_memsz;
 	dlist_init(&pool->segment_list);
@@ -1123,50 +1872,294 @@ struct gpuQueryBuffer
 									 *  1: buffer is ready,
 									 * -1: error, during buffer setup */
 	uint64_t		buffer_id;		/* unique buffer id */
-	int				cuda_dindex;	/* GPU device identifier */
+	uint64_t		inner_fingerprint; /* key of the cached inner buffer */
+	uint8_t			inner_digest[KERN_INNER_CACHE_DIGEST_LEN];
+									/* SHA-256 of the whole fingerprint */
+	int				inner_cache_slot; /* index of inner_cache[], or -1 */
+	uint32_t		inner_generation; /* kept for rescan, if not 0 */
+	uint64_t		retain_until;	/* timestamp to release the unused
+									 * buffer kept for rescan, or 0 */
+	int				cuda_dindex;	/* GPU device identifier, or -1 if the
+									 * inner buffer is split over GPUs */
 	CUdeviceptr		m_kmrels;		/* GpuJoin inner buffer (device) */
 	void		   *h_kmrels;		/* GpuJoin inner buffer (host) */
 	size_t			kmrels_sz;		/* GpuJoin inner buffer size */
+	int				kmrels_mode;	/* one of GQBUF_MODE__* */
+	gpuMemChunk	   *kmrels_chunk;	/* if GQBUF_MODE__DEVICE */
 	CUdeviceptr		m_kds_final;	/* GpuPreAgg final buffer (device) */
+	int				kds_final_mode;	/* one of GQBUF_MODE__* */
+	gpuMemChunk	   *kds_final_chunk; /* if GQBUF_MODE__DEVICE */
 	size_t			m_kds_final_length;	/* length of GpuPreAgg final buffer */
 	pthread_rwlock_t m_kds_final_rwlock;  /* RWLock for the final buffer */
+	uint32_t		m_kds_final_nfinals; /* number of sibling sessions that
+										  * reached XpuTaskFinal */
+	pthread_mutex_t	win_mutex;		/* mutex for GpuWindow result chunks */
+	int				win_nchunks;	/* number of GpuWindow result chunks */
+	int				win_nrooms;		/* length of win_chunks[] */
+	gpuMemChunk	  **win_chunks;		/* GpuWindow result chunks */
 };
 typedef struct gpuQueryBuffer		gpuQueryBuffer;
 
+/*
+ * GQBUF_MODE__* - memory of the inner buffer and the final buffer
+ *
+ * MANAGED is the unified memory prefetched to the device, DEVICE is the
+ * device memory of the pool_raw with explicit copies from/to the host,
+ * and ZEROCOPY is the host buffer itself, pinned and mapped to the device.
+ */
+#define GQBUF_MODE__MANAGED			0
+#define GQBUF_MODE__DEVICE			1
+#define GQBUF_MODE__ZEROCOPY		2
+#define GQBUF_COPY_UNITSZ			(64UL << 20)
+
 #define GPU_QUERY_BUFFER_NSLOTS		320
 static dlist_head		gpu_query_buffer_hslot[GPU_QUERY_BUFFER_NSLOTS];
 static pthread_mutex_t	gpu_query_buffer_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t	gpu_query_buffer_cond = PTHREAD_COND_INITIALIZER;
+static gpuQueryBuffer  *gpu_inner_cache_bufs[GPU_INNER_CACHE_NSLOTS];
 
-static void
-__putGpuQueryBufferNoLock(gpuQueryBuffer *gq_buf)
+static inline uint64_t
+__innerCacheTimestamp(void)
 {
-	Assert(gq_buf->refcnt > 0);
-	if (--gq_buf->refcnt == 0)
-	{
-		CUresult	rc;
+	struct timespec	ts;
 
-		if (gq_buf->m_kmrels)
-		{
-			rc = cuMemFree(gq_buf->m_kmrels);
-			if (rc != CUDA_SUCCESS)
-				__gsDebug("failed on cuMemFree: %s", cuStrError(rc));
-		}
-		if (gq_buf->h_kmrels)
-		{
-			if (munmap(gq_buf->h_kmrels,
-					   gq_buf->kmrels_sz) != 0)
-				__gsDebug("failed on munmap: %m");
-		}
-		if (gq_buf->m_kds_final)
-		{
-			rc = cuMemFree(gq_buf->m_kds_final);
-			if (rc != CUDA_SUCCESS)
-				__gsDebug("failed on cuMemFree: %s", cuStrError(rc));
-		}
-		dlist_delete(&gq_buf->chain);
-		free(gq_buf);
-	}
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000UL + (uint64_t)ts.tv_nsec / 1000UL;
+}
+
+static void
+__innerCacheShmemName(char *namebuf, size_t namebuf_sz, uint32_t shmem_handle)
+{
+	snprintf(namebuf, namebuf_sz,
+			 "/dev/shm/.pgstrom_shmbuf_%u_%d",
+			 PostPortNumber, shmem_handle);
+}
+
+static void
+__releaseGpuQueryBufferNoLock(gpuQueryBuffer *gq_buf)
+{
+	CUresult	rc;
+
+	Assert(gq_buf->refcnt == 0);
+	if (gq_buf->kmrels_chunk)
+		gpuMemFree(gq_buf->kmrels_chunk);
+	else if (gq_buf->kmrels_mode == GQBUF_MODE__ZEROCOPY)
+	{
+		rc = cuMemHostUnregister(gq_buf->h_kmrels);
+		if (rc != CUDA_SUCCESS)
+			__gsDebug("failed on cuMemHostUnregister: %s", cuStrError(rc));
+	}
+	else if (gq_buf->m_kmrels)
+	{
+		rc = cuMemFree(gq_buf->m_kmrels);
+		if (rc != CUDA_SUCCESS)
+			__gsDebug("failed on cuMemFree: %s", cuStrError(rc));
+	}
+	if (gq_buf->h_kmrels)
+	{
+		if (munmap(gq_buf->h_kmrels,
+				   gq_buf->kmrels_sz) != 0)
+			__gsDebug("failed on munmap: %m");
+	}
+	if (gq_buf->kds_final_chunk)
+		gpuMemFree(gq_buf->kds_final_chunk);
+	else if (gq_buf->m_kds_final)
+	{
+		rc = cuMemFree(gq_buf->m_kds_final);
+		if (rc != CUDA_SUCCESS)
+			__gsDebug("failed on cuMemFree: %s", cuStrError(rc));
+	}
+	for (int i=0; i < gq_buf->win_nchunks; i++)
+		gpuMemFree(gq_buf->win_chunks[i]);
+	if (gq_buf->win_chunks)
+		free(gq_buf->win_chunks);
+	dlist_delete(&gq_buf->chain);
+	free(gq_buf);
+}
+
+/*
+ * __releaseGpuInnerCacheNoLock
+ *
+ * It releases the cached inner buffer, if it is not in use and has not been
+ * attached by anybody for the 'idle_time'. The backend that touched the
+ * last_used of the slot concurrently wins, and the buffer is kept.
+ */
+static bool
+__releaseGpuInnerCacheNoLock(int index, uint64_t now, uint64_t idle_time)
+{
+	gpuQueryBuffer *gq_buf = gpu_inner_cache_bufs[index];
+	gpuInnerCacheSlot *slot = &gpuserv_shared_state->inner_cache[index];
+	uint64_t	last_used = pg_atomic_read_u64(&slot->last_used);
+	char		namebuf[MAXPGPATH];
+
+	Assert(gq_buf->inner_cache_slot == index);
+	if (gq_buf->refcnt > 0 || now < last_used + idle_time)
+		return false;
+	if (!pg_atomic_compare_exchange_u64(&slot->last_used, &last_used, 0))
+		return false;
+	pg_atomic_write_u64(&slot->fingerprint, 0);
+	__innerCacheShmemName(namebuf, sizeof(namebuf), slot->shmem_handle);
+	if (unlink(namebuf) != 0)
+		__gsDebug("failed on unlink('%s'): %m", namebuf);
+	__gsDebug("GpuJoin inner buffer cache (fingerprint=%016lx, sz=%zu) was released",
+			  gq_buf->inner_fingerprint, gq_buf->kmrels_sz);
+	gpu_inner_cache_bufs[index] = NULL;
+	gq_buf->inner_cache_slot = -1;
+	__releaseGpuQueryBufferNoLock(gq_buf);
+	return true;
+}
+
+/*
+ * __reclaimGpuInnerCacheNoLock
+ *
+ * It releases the expired inner buffers on the current device, and the least
+ * recently used ones if 'required' bytes are not available in the cache.
+ * It returns the usage of the cache on the current device.
+ */
+static size_t
+__reclaimGpuInnerCacheNoLock(size_t required)
+{
+	size_t		limit = (size_t)pgstrom_gpujoin_inner_cache_size << 10;
+	size_t		usage = 0;
+	uint64_t	now = __innerCacheTimestamp();
+
+	for (int i=0; i < GPU_INNER_CACHE_NSLOTS; i++)
+	{
+		gpuQueryBuffer *gq_buf = gpu_inner_cache_bufs[i];
+
+		if (!gq_buf || gq_buf->cuda_dindex != MY_DINDEX_PER_THREAD)
+			continue;
+		if (!__releaseGpuInnerCacheNoLock(i, now, GPU_INNER_CACHE_EXPIRE))
+			usage += gq_buf->kmrels_sz;
+	}
+
+	while (usage + required > limit)
+	{
+		int			victim = -1;
+		uint64_t	oldest = ULONG_MAX;
+		size_t		sz;
+
+		for (int i=0; i < GPU_INNER_CACHE_NSLOTS; i++)
+		{
+			gpuQueryBuffer *gq_buf = gpu_inner_cache_bufs[i];
+			uint64_t	last_used;
+
+			if (!gq_buf ||
+				gq_buf->cuda_dindex != MY_DINDEX_PER_THREAD ||
+				gq_buf->refcnt > 0)
+				continue;
+			last_used = pg_atomic_read_u64(&gpuserv_shared_state->inner_cache[i].last_used);
+			if (last_used + GPU_INNER_CACHE_LEASE <= now && last_used < oldest)
+			{
+				victim = i;
+				oldest = last_used;
+			}
+		}
+		if (victim < 0)
+			break;
+		sz = gpu_inner_cache_bufs[victim]->kmrels_sz;
+		if (__releaseGpuInnerCacheNoLock(victim, now, GPU_INNER_CACHE_LEASE))
+			usage -= sz;
+	}
+	return usage;
+}
+
+/*
+ * __registerGpuInnerCacheNoLock
+ *
+ * It tries to keep the inner buffer that is just built, and publishes the
+ * slot to the backends. Alias of the host shared memory segment is also
+ * kept, because CPU fallback on the backend side needs the host buffer.
+ */
+static void
+__registerGpuInnerCacheNoLock(gpuQueryBuffer *gq_buf, uint32_t kmrels_handle)
+{
+	gpuInnerCacheSlot *slot;
+	uint32_t	shmem_handle;
+	int			index = -1;
+	char		src_name[MAXPGPATH];
+	char		dst_name[MAXPGPATH];
+
+	if (pgstrom_gpujoin_inner_cache_size == 0 ||
+		gq_buf->cuda_dindex < 0 ||
+		gq_buf->m_kmrels == 0UL)
+		return;
+	if (__reclaimGpuInnerCacheNoLock(gq_buf->kmrels_sz) + gq_buf->kmrels_sz >
+		(size_t)pgstrom_gpujoin_inner_cache_size << 10)
+		return;		/* no room to keep the buffer */
+	for (int i=0; i < GPU_INNER_CACHE_NSLOTS; i++)
+	{
+		if (!gpu_inner_cache_bufs[i])
+		{
+			index = i;
+			break;
+		}
+	}
+	if (index < 0)
+		return;		/* no free slot */
+
+	/* make an alias of the host buffer, to be mapped by the backends */
+	__innerCacheShmemName(src_name, sizeof(src_name), kmrels_handle);
+	shmem_handle = (uint32_t)(gq_buf->inner_fingerprint ^
+							  (gq_buf->inner_fingerprint >> 32));
+	for (;;)
+	{
+		shmem_handle &= 0x7fffffffU;	/* see __shmemCreate */
+		if (shmem_handle != 0 && shmem_handle != kmrels_handle)
+		{
+			__innerCacheShmemName(dst_name, sizeof(dst_name), shmem_handle);
+			if (link(src_name, dst_name) == 0)
+				break;
+			if (errno != EEXIST)
+			{
+				__gsDebug("failed on link('%s','%s'): %m", src_name, dst_name);
+				return;
+			}
+		}
+		shmem_handle++;
+	}
+	slot = &gpuserv_shared_state->inner_cache[index];
+	slot->shmem_handle = shmem_handle;
+	slot->cuda_dindex = gq_buf->cuda_dindex;
+	slot->kmrels_sz = gq_buf->kmrels_sz;
+	memcpy(slot->digest, gq_buf->inner_digest, KERN_INNER_CACHE_DIGEST_LEN);
+	pg_atomic_write_u64(&slot->last_used, __innerCacheTimestamp());
+	pg_write_barrier();
+	pg_atomic_write_u64(&slot->fingerprint, gq_buf->inner_fingerprint);
+
+	gpu_inner_cache_bufs[index] = gq_buf;
+	gq_buf->inner_cache_slot = index;
+	__gsDebug("GpuJoin inner buffer cache (fingerprint=%016lx, sz=%zu) was registered",
+			  gq_buf->inner_fingerprint, gq_buf->kmrels_sz);
+}
+
+static void
+__putGpuQueryBufferNoLock(gpuQueryBuffer *gq_buf)
+{
+	Assert(gq_buf->refcnt > 0);
+	if (--gq_buf->refcnt == 0)
+	{
+		/*
+		 * inner buffer of the rescan-able GpuJoin is kept for a while,
+		 * because the next session of the rescan shall reuse it.
+		 */
+		if (gq_buf->inner_generation != 0 && gq_buf->phase > 0)
+		{
+			gq_buf->retain_until = (__innerCacheTimestamp() +
+									GPU_QUERY_BUFFER_RETAIN);
+			return;
+		}
+		/* cached inner buffer is kept until eviction */
+		if (gq_buf->inner_cache_slot >= 0)
+		{
+			gpuInnerCacheSlot *slot =
+				&gpuserv_shared_state->inner_cache[gq_buf->inner_cache_slot];
+
+			pg_atomic_write_u64(&slot->last_used, __innerCacheTimestamp());
+			return;
+		}
+		__releaseGpuQueryBufferNoLock(gq_buf);
+	}
 }
 
 static void
@@ -1177,6 +2170,102 @@ putGpuQueryBuffer(gpuQueryBuffer *gq_buf)
 	pthreadMutexUnlock(&gpu_query_buffer_mutex);
 }
 
+/*
+ * gpuservReclaimRetainedQueryBuffers
+ *
+ * It releases the inner buffers kept for rescan on the current device, if
+ * no session attached them during GPU_QUERY_BUFFER_RETAIN.
+ */
+static void
+gpuservReclaimRetainedQueryBuffers(void)
+{
+	uint64_t	now = __innerCacheTimestamp();
+
+	pthreadMutexLock(&gpu_query_buffer_mutex);
+	for (int i=0; i < GPU_QUERY_BUFFER_NSLOTS; i++)
+	{
+		dlist_mutable_iter iter;
+
+		dlist_foreach_modify(iter, &gpu_query_buffer_hslot[i])
+		{
+			gpuQueryBuffer *gq_buf = dlist_container(gpuQueryBuffer,
+													 chain, iter.cur);
+			if (gq_buf->refcnt == 0 &&
+				gq_buf->retain_until != 0 &&
+				gq_buf->retain_until <= now &&
+				gq_buf->cuda_dindex == MY_DINDEX_PER_THREAD)
+			{
+				__gsDebug("GpuJoin inner buffer (id=%016lx, sz=%zu) kept for rescan was released",
+						  gq_buf->buffer_id, gq_buf->kmrels_sz);
+				__releaseGpuQueryBufferNoLock(gq_buf);
+			}
+		}
+	}
+	pthreadMutexUnlock(&gpu_query_buffer_mutex);
+}
+
+/*
+ * __gpuQueryBufferMemcpyDtoH / __gpuQueryBufferMemcpyHtoD
+ *
+ * Copies between the query buffer and the host memory; managed memory is
+ * directly accessible and the zero-copy buffer is the host buffer itself,
+ * but device memory needs the explicit copy. HtoD is split into GQBUF_COPY_UNITSZ pieces on
+ * the worker stream, so the staging of the pageable host buffer by the
+ * driver and the DMA are pipelined.
+ */
+static bool
+__gpuQueryBufferMemcpyDtoH(int mode, void *dst, CUdeviceptr src, size_t sz)
+{
+	CUresult	rc;
+
+	if (mode == GQBUF_MODE__ZEROCOPY)
+		return true;	/* same memory to the host buffer */
+	if (mode == GQBUF_MODE__MANAGED)
+	{
+		memcpy(dst, (void *)src, sz);
+		return true;
+	}
+	rc = cuMemcpyDtoH(dst, src, sz);
+	if (rc != CUDA_SUCCESS)
+	{
+		__gsDebug("failed on cuMemcpyDtoH: %s", cuStrError(rc));
+		return false;
+	}
+	return true;
+}
+
+static bool
+__gpuQueryBufferMemcpyHtoD(int mode, CUdeviceptr dst, const void *src, size_t sz)
+{
+	CUresult	rc;
+
+	if (mode != GQBUF_MODE__DEVICE)
+	{
+		if ((void *)dst != src)
+			memcpy((void *)dst, src, sz);
+		return true;
+	}
+	for (size_t offset=0; offset < sz; offset += GQBUF_COPY_UNITSZ)
+	{
+		rc = cuMemcpyHtoDAsync(dst + offset,
+							   (const char *)src + offset,
+							   Min(GQBUF_COPY_UNITSZ, sz - offset),
+							   MY_STREAM_PER_THREAD);
+		if (rc != CUDA_SUCCESS)
+		{
+			__gsDebug("failed on cuMemcpyHtoDAsync: %s", cuStrError(rc));
+			return false;
+		}
+	}
+	rc = cuStreamSynchronize(MY_STREAM_PER_THREAD);
+	if (rc != CUDA_SUCCESS)
+	{
+		__gsDebug("failed on cuStreamSynchronize: %s", cuStrError(rc));
+		return false;
+	}
+	return true;
+}
+
 static bool
 __setupGpuQueryJoinGiSTIndexBuffer(gpuContext *gcontext,
 								   gpuQueryBuffer *gq_buf,
@@ -1192,8 +2281,9 @@ __setupGpuQueryJoinGiSTIndexBuffer(gpuContext *gcontext,
 
 	for (int depth=1; depth <= h_kmrels->num_rels; depth++)
 	{
-		if (h_kmrels->chunks[depth-1].gist_offset == 0)
-			continue;
+		if (h_kmrels->chunks[depth-1].gist_offset == 0 ||
+			h_kmrels->chunks[depth-1].gist_rtree)
+			continue;	/* R-tree is already resolved on the preloading */
 		if (!f_prep_gist)
 		{
 			rc = cuModuleGetFunction(&f_prep_gist,
@@ -1253,82 +2343,358 @@ __setupGpuQueryJoinGiSTIndexBuffer(gpuContext *gcontext,
 	return true;
 }
 
+/*
+ * __setupGpuQueryJoinHashTable
+ *
+ * It builds the inner hash table on the device, if the host code preloaded
+ * the inner rows without hash-values (pg_strom.gpujoin_device_hash_build).
+ * The result is written back to the host buffer also, because CPU fallback
+ * walks on the hash table on the host side.
+ */
 static bool
-__setupGpuQueryJoinInnerBuffer(gpuContext *gcontext,
-							   gpuQueryBuffer *gq_buf,
-							   uint32_t kmrels_handle,
-							   char *errmsg, size_t errmsg_sz)
+__setupGpuQueryJoinHashTable(gpuContext *gcontext,
+							 gpuQueryBuffer *gq_buf,
+							 kern_session_info *session,
+							 char *errmsg, size_t errmsg_sz)
 {
-	kern_multirels *h_kmrels;
-	CUdeviceptr	m_kmrels;
+	kern_multirels *h_kmrels = gq_buf->h_kmrels;
+	CUfunction	f_prep_hash = NULL;
+	CUdeviceptr	m_kerror = 0UL;
+	kern_errorbuf *kerror;
 	CUresult	rc;
-	int			fdesc;
-	struct stat	stat_buf;
-	char		namebuf[100];
-	size_t		mmap_sz;
-
-	if (kmrels_handle == 0)
-		return true;
+	int			grid_sz;
+	int			block_sz;
+	void	   *kern_args[10];
+	bool		retval = false;
 
-	snprintf(namebuf, sizeof(namebuf),
-			 ".pgstrom_shmbuf_%u_%d",
-			 PostPortNumber, kmrels_handle);
-	fdesc = shm_open(namebuf, O_RDWR, 0600);
-	if (fdesc < 0)
-	{
-		snprintf(errmsg, errmsg_sz,
-				 "failed on shm_open('%s'): %m", namebuf);
-		return false;
-	}
-	if (fstat(fdesc, &stat_buf) != 0)
+	for (int depth=1; depth <= h_kmrels->num_rels; depth++)
 	{
-		snprintf(errmsg, errmsg_sz,
-				 "failed on fstat('%s'): %m", namebuf);
-		close(fdesc);
-		return false;
+		if (!h_kmrels->chunks[depth-1].hash_build_on_device)
+			continue;
+		if (!f_prep_hash)
+		{
+			rc = cuModuleGetFunction(&f_prep_hash,
+									 gcontext->cuda_module,
+									 "gpujoin_prep_hashtable");
+			if (rc != CUDA_SUCCESS)
+			{
+				snprintf(errmsg, errmsg_sz,
+						 "failed on cuModuleGetFunction: %s", cuStrError(rc));
+				goto bailout;
+			}
+			rc = gpuOptimalBlockSize(&grid_sz,
+									 &block_sz,
+									 f_prep_hash, 0);
+			if (rc != CUDA_SUCCESS)
+			{
+				snprintf(errmsg, errmsg_sz,
+						 "failed on gpuOptimalBlockSize: %s", cuStrError(rc));
+				goto bailout;
+			}
+			rc = cuMemAllocManaged(&m_kerror, sizeof(kern_errorbuf),
+								   CU_MEM_ATTACH_GLOBAL);
+			if (rc != CUDA_SUCCESS)
+			{
+				snprintf(errmsg, errmsg_sz,
+						 "failed on cuMemAllocManaged: %s", cuStrError(rc));
+				goto bailout;
+			}
+			memset((void *)m_kerror, 0, sizeof(kern_errorbuf));
+		}
+		kern_args[0] = &session;
+		kern_args[1] = &gq_buf->m_kmrels;
+		kern_args[2] = &depth;
+		kern_args[3] = &m_kerror;
+		rc = cuLaunchKernel(f_prep_hash,
+							grid_sz, 1, 1,
+							block_sz, 1, 1,
+							0,
+							MY_STREAM_PER_THREAD,
+							kern_args,
+							NULL);
+		if (rc != CUDA_SUCCESS)
+		{
+			snprintf(errmsg, errmsg_sz,
+					 "failed on cuLaunchKernel: %s", cuStrError(rc));
+			goto bailout;
+		}
 	}
-	mmap_sz = PAGE_ALIGN(stat_buf.st_size);
+	if (!f_prep_hash)
+		return true;	/* nothing to do */
 
-	h_kmrels = mmap(NULL, mmap_sz,
-					PROT_READ | PROT_WRITE,
-					MAP_SHARED,
-					fdesc, 0);
-	close(fdesc);
-	if (h_kmrels == MAP_FAILED)
+	rc = cuEventRecord(MY_EVENT_PER_THREAD, MY_STREAM_PER_THREAD);
+	if (rc != CUDA_SUCCESS)
 	{
 		snprintf(errmsg, errmsg_sz,
-				 "failed on mmap('%s', %zu): %m", namebuf, mmap_sz);
-		return false;
+				 "failed on cuEventRecord: %s", cuStrError(rc));
+		goto bailout;
 	}
-
-	rc = cuMemAllocManaged(&m_kmrels, mmap_sz,
-						   CU_MEM_ATTACH_GLOBAL);
+	rc = cuEventSynchronize(MY_EVENT_PER_THREAD);
 	if (rc != CUDA_SUCCESS)
 	{
 		snprintf(errmsg, errmsg_sz,
-				 "failed on cuMemAllocManaged: %s", cuStrError(rc));
-		munmap(h_kmrels, mmap_sz);
-		return false;
+				 "failed on cuEventSynchronize: %s", cuStrError(rc));
+		goto bailout;
 	}
-	memcpy((void *)m_kmrels, h_kmrels, mmap_sz);
-	(void)cuMemPrefetchAsync(m_kmrels, mmap_sz,
-							 MY_DEVICE_PER_THREAD,
-							 MY_STREAM_PER_THREAD);
-	gq_buf->m_kmrels = m_kmrels;
-	gq_buf->h_kmrels = h_kmrels;
-	gq_buf->kmrels_sz = mmap_sz;
-
-	/* preparation of GiST-index buffer, if any */
-	if (!__setupGpuQueryJoinGiSTIndexBuffer(gcontext, gq_buf,
-											errmsg, errmsg_sz))
+	kerror = (kern_errorbuf *)m_kerror;
+	if (kerror->errcode != ERRCODE_STROM_SUCCESS)
 	{
-		cuMemFree(m_kmrels);
-		munmap(h_kmrels, mmap_sz);
-		return false;
+		snprintf(errmsg, errmsg_sz,
+				 "GPU inner hash build failed: %s (%s:%d)",
+				 kerror->message,
+				 kerror->filename,
+				 kerror->lineno);
+		goto bailout;
 	}
-	return true;
-}
-
+	/* write back the hash table and bloom filter to the host buffer */
+	for (int depth=1; depth <= h_kmrels->num_rels; depth++)
+	{
+		kern_data_store *kds;
+		uint64_t	offset;
+
+		if (!h_kmrels->chunks[depth-1].hash_build_on_device)
+			continue;
+		/* device buffer has the identical layout to the host buffer */
+		kds = KERN_MULTIRELS_INNER_KDS(h_kmrels, depth-1);
+		offset = h_kmrels->chunks[depth-1].kds_offset;
+		if (!__gpuQueryBufferMemcpyDtoH(gq_buf->kmrels_mode, kds,
+										gq_buf->m_kmrels + offset,
+										kds->length))
+		{
+			snprintf(errmsg, errmsg_sz,
+					 "failed on write back of the inner hash table");
+			goto bailout;
+		}
+		offset = h_kmrels->chunks[depth-1].bloom_offset;
+		if (offset != 0 &&
+			!__gpuQueryBufferMemcpyDtoH(gq_buf->kmrels_mode,
+										KERN_MULTIRELS_BLOOM_FILTER(h_kmrels, depth-1),
+										gq_buf->m_kmrels + offset,
+										h_kmrels->chunks[depth-1].bloom_nbits / BITS_PER_BYTE))
+		{
+			snprintf(errmsg, errmsg_sz,
+					 "failed on write back of the bloom filter");
+			goto bailout;
+		}
+	}
+	__gsDebug("GpuJoin inner hash table was built on GPU%d",
+			  gcontext->cuda_dindex);
+	retval = true;
+bailout:
+	if (m_kerror)
+		cuMemFree(m_kerror);
+	return retval;
+}
+
+/*
+ * __distributeGpuQueryJoinInnerBuffer
+ *
+ * It splits the managed inner buffer into per-device ranges according to
+ * the device memory size. Each range prefers to be located on the device,
+ * and is mapped to the other devices (over NVLink or PCIe P2P if any).
+ * So, capacity of the inner buffer grows with the number of GPUs, instead
+ * of being capped by the smallest device.
+ */
+static void
+__distributeGpuQueryJoinInnerBuffer(CUdeviceptr m_kmrels, size_t length)
+{
+	size_t		total_memsz = 0;
+	size_t		offset = 0;
+	dlist_iter	iter;
+	CUresult	rc;
+
+	dlist_foreach(iter, &gpuserv_gpucontext_list)
+	{
+		gpuContext *gcontext = dlist_container(gpuContext, chain, iter.cur);
+
+		total_memsz += gpuDevAttrs[gcontext->cuda_dindex].DEV_TOTAL_MEMSZ;
+	}
+
+	dlist_foreach(iter, &gpuserv_gpucontext_list)
+	{
+		gpuContext *gcontext = dlist_container(gpuContext, chain, iter.cur);
+		size_t		dev_memsz = gpuDevAttrs[gcontext->cuda_dindex].DEV_TOTAL_MEMSZ;
+		size_t		sz;
+
+		if (offset >= length)
+			break;
+		if (!dlist_has_next(&gpuserv_gpucontext_list, iter.cur))
+			sz = length - offset;
+		else
+		{
+			sz = TYPEALIGN(2UL<<20, ((double)length *
+									 (double)dev_memsz /
+									 (double)total_memsz));
+			sz = Min(sz, length - offset);
+		}
+		rc = cuMemAdvise(m_kmrels + offset, sz,
+						 CU_MEM_ADVISE_SET_PREFERRED_LOCATION,
+						 gcontext->cuda_device);
+		if (rc != CUDA_SUCCESS)
+			__gsDebug("failed on cuMemAdvise(SET_PREFERRED_LOCATION): %s",
+					  cuStrError(rc));
+		rc = cuMemPrefetchAsync(m_kmrels + offset, sz,
+								gcontext->cuda_device,
+								MY_STREAM_PER_THREAD);
+		if (rc != CUDA_SUCCESS)
+			__gsDebug("failed on cuMemPrefetchAsync: %s", cuStrError(rc));
+		__gsDebug("GpuJoin inner buffer [%zu..%zu] is located on GPU%d",
+				  offset, offset + sz, gcontext->cuda_dindex);
+		offset += sz;
+	}
+
+	/* all the devices can access the entire buffer without migration */
+	dlist_foreach(iter, &gpuserv_gpucontext_list)
+	{
+		gpuContext *gcontext = dlist_container(gpuContext, chain, iter.cur);
+
+		rc = cuMemAdvise(m_kmrels, length,
+						 CU_MEM_ADVISE_SET_ACCESSED_BY,
+						 gcontext->cuda_device);
+		if (rc != CUDA_SUCCESS)
+			__gsDebug("failed on cuMemAdvise(SET_ACCESSED_BY): %s",
+					  cuStrError(rc));
+	}
+}
+
+static bool
+__setupGpuQueryJoinInnerBuffer(gpuContext *gcontext,
+							   gpuQueryBuffer *gq_buf,
+							   kern_session_info *session,
+							   uint32_t kmrels_handle,
+							   char *errmsg, size_t errmsg_sz)
+{
+	kern_multirels *h_kmrels;
+	CUdeviceptr	m_kmrels;
+	CUresult	rc;
+	int			fdesc;
+	struct stat	stat_buf;
+	char		namebuf[100];
+	size_t		mmap_sz;
+
+	if (kmrels_handle == 0)
+		return true;
+
+	snprintf(namebuf, sizeof(namebuf),
+			 ".pgstrom_shmbuf_%u_%d",
+			 PostPortNumber, kmrels_handle);
+	fdesc = shm_open(namebuf, O_RDWR, 0600);
+	if (fdesc < 0)
+	{
+		snprintf(errmsg, errmsg_sz,
+				 "failed on shm_open('%s'): %m", namebuf);
+		return false;
+	}
+	if (fstat(fdesc, &stat_buf) != 0)
+	{
+		snprintf(errmsg, errmsg_sz,
+				 "failed on fstat('%s'): %m", namebuf);
+		close(fdesc);
+		return false;
+	}
+	mmap_sz = PAGE_ALIGN(stat_buf.st_size);
+
+	h_kmrels = mmap(NULL, mmap_sz,
+					PROT_READ | PROT_WRITE,
+					MAP_SHARED,
+					fdesc, 0);
+	close(fdesc);
+	if (h_kmrels == MAP_FAILED)
+	{
+		snprintf(errmsg, errmsg_sz,
+				 "failed on mmap('%s', %zu): %m", namebuf, mmap_sz);
+		return false;
+	}
+
+	/*
+	 * Inner buffer split over multiple GPUs has to be the managed memory.
+	 * Elsewhere, very large buffer is mapped to the device as is, and the
+	 * device memory is used instead of the managed memory if configured.
+	 */
+	gq_buf->h_kmrels = h_kmrels;
+	gq_buf->kmrels_sz = mmap_sz;
+	gq_buf->kmrels_mode = GQBUF_MODE__MANAGED;
+	if (gq_buf->cuda_dindex >= 0 &&
+		pgstrom_gpu_query_buffer_zerocopy_threshold_kb > 0 &&
+		mmap_sz >= ((size_t)pgstrom_gpu_query_buffer_zerocopy_threshold_kb << 10))
+	{
+		rc = cuMemHostRegister(h_kmrels, mmap_sz,
+							   CU_MEMHOSTREGISTER_DEVICEMAP);
+		if (rc == CUDA_SUCCESS)
+		{
+			rc = cuMemHostGetDevicePointer(&m_kmrels, h_kmrels, 0);
+			if (rc == CUDA_SUCCESS)
+				gq_buf->kmrels_mode = GQBUF_MODE__ZEROCOPY;
+			else
+			{
+				__gsDebug("failed on cuMemHostGetDevicePointer: %s",
+						  cuStrError(rc));
+				cuMemHostUnregister(h_kmrels);
+			}
+		}
+		else
+			__gsDebug("failed on cuMemHostRegister: %s", cuStrError(rc));
+	}
+	if (gq_buf->kmrels_mode == GQBUF_MODE__MANAGED &&
+		gq_buf->cuda_dindex >= 0 &&
+		pgstrom_gpu_query_buffer_mode == GQBUF_MODE__DEVICE)
+	{
+		gpuMemChunk *chunk = gpuMemAlloc(mmap_sz);
+
+		if (chunk)
+		{
+			if (__gpuQueryBufferMemcpyHtoD(GQBUF_MODE__DEVICE,
+										   chunk->m_devptr,
+										   h_kmrels, mmap_sz))
+			{
+				m_kmrels = chunk->m_devptr;
+				gq_buf->kmrels_chunk = chunk;
+				gq_buf->kmrels_mode = GQBUF_MODE__DEVICE;
+			}
+			else
+				gpuMemFree(chunk);
+		}
+	}
+	if (gq_buf->kmrels_mode == GQBUF_MODE__MANAGED)
+	{
+		/* fallback to the managed memory */
+		rc = cuMemAllocManaged(&m_kmrels, mmap_sz,
+							   CU_MEM_ATTACH_GLOBAL);
+		if (rc != CUDA_SUCCESS)
+		{
+			snprintf(errmsg, errmsg_sz,
+					 "failed on cuMemAllocManaged: %s", cuStrError(rc));
+			gq_buf->h_kmrels = NULL;
+			munmap(h_kmrels, mmap_sz);
+			return false;
+		}
+		memcpy((void *)m_kmrels, h_kmrels, mmap_sz);
+		if (gq_buf->cuda_dindex < 0)
+			__distributeGpuQueryJoinInnerBuffer(m_kmrels, mmap_sz);
+		else
+			(void)cuMemPrefetchAsync(m_kmrels, mmap_sz,
+									 MY_DEVICE_PER_THREAD,
+									 MY_STREAM_PER_THREAD);
+	}
+	gq_buf->m_kmrels = m_kmrels;
+	__gsDebug("GpuJoin inner buffer (sz=%zu) is set up on the %s memory",
+			  mmap_sz,
+			  gq_buf->kmrels_mode == GQBUF_MODE__DEVICE ? "device" :
+			  gq_buf->kmrels_mode == GQBUF_MODE__ZEROCOPY ? "zero-copy host" :
+			  "managed");
+
+	/*
+	 * preparation of hash table and GiST-index buffer, if any;
+	 * buffers are released by __releaseGpuQueryBufferNoLock on error.
+	 */
+	if (!__setupGpuQueryJoinHashTable(gcontext, gq_buf, session,
+									  errmsg, errmsg_sz) ||
+		!__setupGpuQueryJoinGiSTIndexBuffer(gcontext, gq_buf,
+											errmsg, errmsg_sz))
+		return false;
+	return true;
+}
+
 static bool
 __setupGpuQueryGroupByBuffer(gpuContext *gcontext,
 							 gpuQueryBuffer *gq_buf,
@@ -1342,6 +2708,29 @@ __setupGpuQueryGroupByBuffer(gpuContext *gcontext,
 		return true;	/* nothing to do */
 
 	Assert(KDS_HEAD_LENGTH(kds_final_head) <= kds_final_head->length);
+	if (gq_buf->cuda_dindex >= 0 &&
+		pgstrom_gpu_query_buffer_mode == GQBUF_MODE__DEVICE)
+	{
+		gpuMemChunk *chunk = gpuMemAlloc(kds_final_head->length);
+
+		if (chunk)
+		{
+			if (__gpuQueryBufferMemcpyHtoD(GQBUF_MODE__DEVICE,
+										   chunk->m_devptr,
+										   kds_final_head,
+										   KDS_HEAD_LENGTH(kds_final_head)))
+			{
+				gq_buf->kds_final_chunk = chunk;
+				gq_buf->kds_final_mode = GQBUF_MODE__DEVICE;
+				gq_buf->m_kds_final = chunk->m_devptr;
+				gq_buf->m_kds_final_length = kds_final_head->length;
+				pthreadRWLockInit(&gq_buf->m_kds_final_rwlock);
+				return true;
+			}
+			gpuMemFree(chunk);
+		}
+		/* elsewhere, fallback to the managed memory */
+	}
 	rc =  cuMemAllocManaged(&m_kds_final,
 							kds_final_head->length,
 							CU_MEM_ATTACH_GLOBAL);
@@ -1366,6 +2755,97 @@ __setupGpuQueryGroupByBuffer(gpuContext *gcontext,
 	return true;
 }
 
+/*
+ * __expandGpuQueryGroupByDeviceBuffer
+ *
+ * Same as the managed memory below, but the header is fetched and both
+ * halves are moved by the device-to-device copy. Caller holds the write
+ * lock of the m_kds_final_rwlock.
+ */
+static bool
+__expandGpuQueryGroupByDeviceBuffer(gpuQueryBuffer *gq_buf)
+{
+	kern_data_store	kds_old;
+	gpuMemChunk	   *chunk;
+	CUdeviceptr		m_devptr;
+	CUresult		rc;
+	size_t			sz, length;
+
+	rc = cuMemcpyDtoH(&kds_old, gq_buf->m_kds_final,
+					  offsetof(kern_data_store, colmeta));
+	if (rc != CUDA_SUCCESS)
+		return false;
+	assert(kds_old.length == gq_buf->m_kds_final_length);
+	length = kds_old.length + Min(kds_old.length, 1UL<<30);
+	if (length > __KDS_LENGTH_LIMIT)
+	{
+		/* 32bit packed offset cannot point beyond the limit */
+		if (kds_old.length >= __KDS_LENGTH_LIMIT)
+			return false;
+		length = __KDS_LENGTH_LIMIT;
+	}
+	chunk = gpuMemAlloc(length);
+	if (!chunk)
+		return false;
+	m_devptr = chunk->m_devptr;
+
+	/* early half */
+	sz = (KDS_HEAD_LENGTH(&kds_old) +
+		  MAXALIGN(sizeof(uint32_t) * (kds_old.nitems +
+									   kds_old.hash_nslots)));
+	rc = cuMemcpyDtoD(m_devptr, gq_buf->m_kds_final, sz);
+	if (rc != CUDA_SUCCESS)
+		goto bailout;
+	rc = cuMemcpyHtoD(m_devptr + offsetof(kern_data_store, length),
+					  &length, sizeof(kds_old.length));
+	if (rc != CUDA_SUCCESS)
+		goto bailout;
+	/* later half */
+	sz = __kds_unpack(kds_old.usage);
+	rc = cuMemcpyDtoD(m_devptr + length - sz,
+					  gq_buf->m_kds_final + kds_old.length - sz, sz);
+	if (rc != CUDA_SUCCESS)
+		goto bailout;
+
+	/* swap them */
+	__gsDebug("kds_final expand: %lu => %lu\n", kds_old.length, length);
+	gpuMemFree(gq_buf->kds_final_chunk);
+	gq_buf->kds_final_chunk = chunk;
+	gq_buf->m_kds_final = m_devptr;
+	gq_buf->m_kds_final_length = length;
+	return true;
+
+bailout:
+	gpuMemFree(chunk);
+	return false;
+}
+
+/*
+ * __copyGroupByBufferExpanded
+ *
+ * It copies the early half (header, hash-slots and row-index) and the later
+ * half (tuples) of the final buffer to the expanded one on the host memory.
+ */
+static void
+__copyGroupByBufferExpanded(kern_data_store *kds_new,
+							const kern_data_store *kds_old,
+							size_t length)
+{
+	size_t		sz;
+
+	/* early half */
+	sz = (KDS_HEAD_LENGTH(kds_old) +
+		  MAXALIGN(sizeof(uint32_t) * (kds_old->nitems +
+									   kds_old->hash_nslots)));
+	memcpy(kds_new, kds_old, sz);
+	kds_new->length = length;
+
+	/* later half */
+	sz = __kds_unpack(kds_old->usage);
+	memcpy((char *)kds_new + kds_new->length - sz,
+		   (const char *)kds_old + kds_old->length - sz, sz);
+}
+
 /*
  * __expandGpuQueryGroupByBuffer
  */
@@ -1375,16 +2855,35 @@ __expandGpuQueryGroupByBuffer(gpuQueryBuffer *gq_buf,
 {
 	assert(kds_length_last != 0);	/* must be 2nd or later trial */
 	pthreadRWLockWriteLock(&gq_buf->m_kds_final_rwlock);
-	if (gq_buf->m_kds_final_length == kds_length_last)
+	if (gq_buf->m_kds_final_length == kds_length_last &&
+		gq_buf->kds_final_mode == GQBUF_MODE__DEVICE)
+	{
+		if (!__expandGpuQueryGroupByDeviceBuffer(gq_buf))
+		{
+			pthreadRWLockUnlock(&gq_buf->m_kds_final_rwlock);
+			return false;
+		}
+	}
+	else if (gq_buf->m_kds_final_length == kds_length_last)
 	{
 		kern_data_store *kds_old = (kern_data_store *)gq_buf->m_kds_final;
 		kern_data_store *kds_new;
 		CUdeviceptr		m_devptr;
 		CUresult		rc;
-		size_t			sz, length;
+		size_t			length;
 
 		assert(kds_old->length == gq_buf->m_kds_final_length);
 		length = kds_old->length + Min(kds_old->length, 1UL<<30);
+		if (length > __KDS_LENGTH_LIMIT)
+		{
+			/* 32bit packed offset cannot point beyond the limit */
+			if (kds_old->length >= __KDS_LENGTH_LIMIT)
+			{
+				pthreadRWLockUnlock(&gq_buf->m_kds_final_rwlock);
+				return false;
+			}
+			length = __KDS_LENGTH_LIMIT;
+		}
 		rc = cuMemAllocManaged(&m_devptr, length,
 							   CU_MEM_ATTACH_GLOBAL);
 		if (rc != CUDA_SUCCESS)
@@ -1393,18 +2892,7 @@ __expandGpuQueryGroupByBuffer(gpuQueryBuffer *gq_buf,
 			return false;
 		}
 		kds_new = (kern_data_store *)m_devptr;
-
-		/* early half */
-		sz = (KDS_HEAD_LENGTH(kds_old) +
-			  MAXALIGN(sizeof(uint32_t) * (kds_old->nitems +
-										   kds_old->hash_nslots)));
-		memcpy(kds_new, kds_old, sz);
-		kds_new->length = length;
-
-		/* later falf */
-		sz = __kds_unpack(kds_old->usage);
-		memcpy((char *)kds_new + kds_new->length - sz,
-			   (char *)kds_old + kds_old->length - sz, sz);
+		__copyGroupByBufferExpanded(kds_new, kds_old, length);
 
 		/* swap them */
 		__gsDebug("kds_final expand: %lu => %lu\n",
@@ -1418,25 +2906,106 @@ __expandGpuQueryGroupByBuffer(gpuQueryBuffer *gq_buf,
 	return true;
 }
 
+/*
+ * __setupGpuTaskGroupByBuffer
+ *
+ * Streaming GpuPreAgg aggregates a chunk on the private kds_final of the
+ * task, then returns the groups as the results of the task; the upper Agg
+ * merges the groups across the chunks. If chunk_old is given, it expands
+ * the buffer for the suspended kernel.
+ */
+static gpuMemChunk *
+__setupGpuTaskGroupByBuffer(kern_session_info *session,
+							gpuMemChunk *chunk_old)
+{
+	kern_data_store *kds_head = (kern_data_store *)
+		((char *)session + session->groupby_kds_final);
+	kern_data_store *kds;
+	gpuMemChunk	   *chunk;
+	size_t			length;
+
+	if (!chunk_old)
+	{
+		chunk = gpuMemAllocManaged(kds_head->length);
+		if (!chunk)
+			return NULL;
+		kds = (kern_data_store *)chunk->m_devptr;
+		memcpy(kds, kds_head, KDS_HEAD_LENGTH(kds_head));
+		/* the chunk may be recycled by the memory pool */
+		memset(KDS_BODY_ADDR(kds), 0, sizeof(uint32_t) * kds->hash_nslots);
+	}
+	else
+	{
+		kern_data_store *kds_old = (kern_data_store *)chunk_old->m_devptr;
+
+		length = kds_old->length + Min(kds_old->length, 1UL<<30);
+		if (length > __KDS_LENGTH_LIMIT)
+		{
+			/* 32bit packed offset cannot point beyond the limit */
+			if (kds_old->length >= __KDS_LENGTH_LIMIT)
+				return NULL;
+			length = __KDS_LENGTH_LIMIT;
+		}
+		chunk = gpuMemAllocManaged(length);
+		if (!chunk)
+			return NULL;
+		kds = (kern_data_store *)chunk->m_devptr;
+		__copyGroupByBufferExpanded(kds, kds_old, length);
+		__gsDebug("streaming kds_final expand: %lu => %lu\n",
+				  kds_old->length, length);
+		gpuMemFree(chunk_old);
+	}
+	return chunk;
+}
+
 static gpuQueryBuffer *
 getGpuQueryBuffer(gpuContext *gcontext,
+				  kern_session_info *session,
 				  uint64_t buffer_id,
 				  uint32_t kmrels_handle,
+				  bool kmrels_multi_gpu,
+				  uint64_t kmrels_fingerprint,
+				  const uint8_t *kmrels_digest,
 				  kern_data_store *kds_final_head,
 				  char *errmsg, size_t errmsg_sz)
 {
 	gpuQueryBuffer *gq_buf;
 	dlist_iter		iter;
 	int				hindex;
+	int				cuda_dindex;
+	uint32_t		inner_generation = 0;
 	struct {
 		uint64_t	buffer_id;
-		uint32_t	cuda_dindex;
+		int32_t		cuda_dindex;
 	} hkey;
 
+	/*
+	 * inner buffer split over multiple GPUs is shared by all the devices,
+	 * but not used with GpuPreAgg final buffer that is per-device.
+	 */
+	Assert(!kmrels_multi_gpu || !kds_final_head);
+	cuda_dindex = (kmrels_multi_gpu ? -1 : MY_DINDEX_PER_THREAD);
+	/*
+	 * cached inner buffer is identified by the fingerprint, instead of the
+	 * query, to be shared with the following queries.
+	 */
+	Assert(kmrels_fingerprint == 0 || (!kmrels_multi_gpu && !kds_final_head));
+	if (kmrels_fingerprint != 0)
+		buffer_id = kmrels_fingerprint;
+	/*
+	 * inner buffer of the rescan-able GpuJoin is kept after the session
+	 * closed; the generation is bumped when the inner rows are rebuilt.
+	 */
+	if (kmrels_handle != 0 &&
+		!kmrels_multi_gpu &&
+		kmrels_fingerprint == 0 &&
+		!kds_final_head)
+		inner_generation = session->join_inner_generation;
+
 	/* lookup hash table first */
 	memset(&hkey, 0, sizeof(hkey));
 	hkey.buffer_id = buffer_id;
-	hkey.cuda_dindex = MY_DINDEX_PER_THREAD;
+	hkey.cuda_dindex = cuda_dindex;
 	hindex = hash_bytes((unsigned char *)&hkey,
 						sizeof(hkey)) % GPU_QUERY_BUFFER_NSLOTS;
 	pthreadMutexLock(&gpu_query_buffer_mutex);
@@ -1445,9 +3014,15 @@ getGpuQueryBuffer(gpuContext *gcontext,
 		gq_buf = dlist_container(gpuQueryBuffer,
 								 chain, iter.cur);
 		if (gq_buf->buffer_id   == buffer_id &&
-			gq_buf->cuda_dindex == MY_DINDEX_PER_THREAD)
+			gq_buf->cuda_dindex == cuda_dindex &&
+			gq_buf->inner_fingerprint == kmrels_fingerprint &&
+			(kmrels_fingerprint == 0 ||
+			 memcmp(gq_buf->inner_digest, kmrels_digest,
+					KERN_INNER_CACHE_DIGEST_LEN) == 0) &&
+			gq_buf->inner_generation == inner_generation)
 		{
 			gq_buf->refcnt++;
+			gq_buf->retain_until = 0;
 
 			/* wait for initial setup by other thread */
 			while (gq_buf->phase == 0)
@@ -1475,13 +3050,20 @@ getGpuQueryBuffer(gpuContext *gcontext,
 	gq_buf->refcnt = 1;
 	gq_buf->phase  = 0;	/* not initialized yet */
 	gq_buf->buffer_id = buffer_id;
-	gq_buf->cuda_dindex = MY_DINDEX_PER_THREAD;
+	gq_buf->inner_fingerprint = kmrels_fingerprint;
+	if (kmrels_fingerprint != 0)
+		memcpy(gq_buf->inner_digest, kmrels_digest,
+			   KERN_INNER_CACHE_DIGEST_LEN);
+	gq_buf->inner_cache_slot = -1;
+	gq_buf->inner_generation = inner_generation;
+	gq_buf->cuda_dindex = cuda_dindex;
+	pthreadMutexInit(&gq_buf->win_mutex);
 	dlist_push_tail(&gpu_query_buffer_hslot[hindex], &gq_buf->chain);
 	pthreadMutexUnlock(&gpu_query_buffer_mutex);
 
 	if ((kmrels_handle == 0 ||
 		 __setupGpuQueryJoinInnerBuffer(gcontext,
-										gq_buf, kmrels_handle,
+										gq_buf, session, kmrels_handle,
 										errmsg, errmsg_sz)) &&
 		(kds_final_head == NULL ||
 		 __setupGpuQueryGroupByBuffer(gcontext,
@@ -1491,6 +3073,8 @@ getGpuQueryBuffer(gpuContext *gcontext,
 		/* ok, buffer is now ready */
 		pthreadMutexLock(&gpu_query_buffer_mutex);
 		gq_buf->phase = 1;		/* buffer is now ready */
+		if (kmrels_fingerprint != 0)
+			__registerGpuInnerCacheNoLock(gq_buf, kmrels_handle);
 		pthreadCondBroadcast(&gpu_query_buffer_cond);
 		pthreadMutexUnlock(&gpu_query_buffer_mutex);		
 		return gq_buf;
@@ -1504,6 +3088,82 @@ getGpuQueryBuffer(gpuContext *gcontext,
 	return NULL;
 }
 
+/*
+ * gpuservLookupInnerCache
+ *
+ * It is called by the backend to find out the inner buffer with the same
+ * fingerprint, kept by the GPU service. The 64bit fingerprint is only a key
+ * of the slots, so the SHA-256 digest of the whole fingerprint must also
+ * match by byte-by-byte comparison. Once it touched the last_used of
+ * the slot, the buffer is not evicted for GPU_INNER_CACHE_LEASE at least,
+ * so the backend can open the session to attach the buffer.
+ */
+bool
+gpuservLookupInnerCache(uint64_t fingerprint,
+						const uint8_t *digest,
+						const Bitmapset *gpuset,
+						int *p_cuda_dindex,
+						uint32_t *p_shmem_handle,
+						size_t *p_kmrels_sz)
+{
+	if (!gpuserv_shared_state || fingerprint == 0)
+		return false;
+	for (int i=0; i < GPU_INNER_CACHE_NSLOTS; i++)
+	{
+		gpuInnerCacheSlot *slot = &gpuserv_shared_state->inner_cache[i];
+		uint64_t	last_used;
+		int			cuda_dindex;
+		uint32_t	shmem_handle;
+		size_t		kmrels_sz;
+
+		if (pg_atomic_read_u64(&slot->fingerprint) != fingerprint)
+			continue;
+		pg_read_barrier();
+		last_used = pg_atomic_read_u64(&slot->last_used);
+		cuda_dindex = slot->cuda_dindex;
+		shmem_handle = slot->shmem_handle;
+		kmrels_sz = slot->kmrels_sz;
+		if (last_used == 0)
+			continue;		/* being released */
+		if (memcmp(slot->digest, digest, KERN_INNER_CACHE_DIGEST_LEN) != 0)
+			continue;		/* hash collision of the fingerprint */
+		if (!bms_is_empty(gpuset) && !bms_is_member(cuda_dindex, gpuset))
+			continue;		/* not an optimal GPU */
+		if (!pg_atomic_compare_exchange_u64(&slot->last_used, &last_used,
+											__innerCacheTimestamp()))
+			continue;		/* released or reused concurrently */
+		*p_cuda_dindex = cuda_dindex;
+		*p_shmem_handle = shmem_handle;
+		*p_kmrels_sz = kmrels_sz;
+		return true;
+	}
+	return false;
+}
+
+/*
+ * __gpuservCleanupInnerCache
+ *
+ * It unlinks the alias of host inner buffers; device memory is released
+ * with the CUDA context.
+ */
+static void
+__gpuservCleanupInnerCache(void)
+{
+	for (int i=0; i < GPU_INNER_CACHE_NSLOTS; i++)
+	{
+		gpuInnerCacheSlot *slot = &gpuserv_shared_state->inner_cache[i];
+		char		namebuf[MAXPGPATH];
+
+		if (pg_atomic_exchange_u64(&slot->fingerprint, 0) == 0)
+			continue;
+		pg_atomic_write_u64(&slot->last_used, 0);
+		__innerCacheShmemName(namebuf, sizeof(namebuf), slot->shmem_handle);
+		if (unlink(namebuf) != 0 && errno != ENOENT)
+			elog(LOG, "failed on unlink('%s'): %m", namebuf);
+		gpu_inner_cache_bufs[i] = NULL;
+	}
+}
+
 /*
  * gpuServiceGoingTerminate
  */
@@ -1525,44 +3185,324 @@ typedef struct
 	XpuCommand		xcmd;
 } gpuServXpuCommandPacked;
 
-static void *
-__gpuServiceAllocCommand(void *__priv, size_t sz)
-{
-	gpuMemChunk	   *chunk;
-	gpuServXpuCommandPacked *packed;
+/* ----------------------------------------------------------------
+ *
+ * GPU execution trace (pg_strom.gpu_trace)
+ *
+ * Events of the session are recorded on the gpuTraceBuffer, then written
+ * out to pg_strom.gpu_trace_directory in the Chrome trace event format
+ * (chrome://tracing, Perfetto or Nsight Systems can import) at the end of
+ * the session. Timestamps are CLOCK_MONOTONIC in microseconds.
+ *
+ * ----------------------------------------------------------------
+ */
+#define GPU_TRACE_MAX_EVENTS		200000
 
-	chunk = gpuMemAllocManaged(offsetof(gpuServXpuCommandPacked, xcmd) + sz);
-	if (!chunk)
+typedef struct
+{
+	const char *name;		/* static string */
+	char		ph;			/* 'X' (complete) or 'i' (instant) */
+	pid_t		tid;
+	uint64_t	ts;
+	uint64_t	dur;
+	uint64_t	bytes;		/* argument, if not zero */
+} gpuTraceEvent;
+
+typedef struct gpuTraceBuffer
+{
+	pthread_mutex_t	lock;
+	uint32_t		nitems;
+	uint32_t		nrooms;
+	uint64_t		ndropped;	/* events not recorded due to the limit */
+	gpuTraceEvent  *events;
+} gpuTraceBuffer;
+
+static uint32_t		gpuserv_trace_seqno = 0;
+
+static inline uint64_t
+__gpuservTimestampUsec(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000UL + (uint64_t)ts.tv_nsec / 1000UL;
+}
+
+static gpuTraceBuffer *
+__gpuTraceCreate(void)
+{
+	gpuTraceBuffer *trace = calloc(1, sizeof(gpuTraceBuffer));
+
+	if (trace)
+		pthreadMutexInit(&trace->lock);
+	return trace;
+}
+
+static void
+__gpuTraceRecord(gpuClient *gclient, const char *name, char ph,
+				 uint64_t ts_begin, uint64_t bytes)
+{
+	gpuTraceBuffer *trace = gclient->trace;
+	gpuTraceEvent  *ev;
+	uint64_t		now = __gpuservTimestampUsec();
+
+	if (MY_TRACE_TID_PER_THREAD == 0)
+		MY_TRACE_TID_PER_THREAD = (pid_t)syscall(SYS_gettid);
+	pthreadMutexLock(&trace->lock);
+	if (trace->nitems >= trace->nrooms)
+	{
+		uint32_t	nrooms = Min(2 * trace->nrooms + 1000,
+								 GPU_TRACE_MAX_EVENTS);
+		gpuTraceEvent *events = NULL;
+
+		if (nrooms > trace->nrooms)
+			events = realloc(trace->events, sizeof(gpuTraceEvent) * nrooms);
+		if (!events)
+		{
+			trace->ndropped++;
+			pthreadMutexUnlock(&trace->lock);
+			return;
+		}
+		trace->events = events;
+		trace->nrooms = nrooms;
+	}
+	ev = &trace->events[trace->nitems++];
+	ev->name  = name;
+	ev->ph    = ph;
+	ev->tid   = MY_TRACE_TID_PER_THREAD;
+	ev->ts    = (ph == 'X' ? ts_begin : now);
+	ev->dur   = (ph == 'X' ? now - ts_begin : 0);
+	ev->bytes = bytes;
+	pthreadMutexUnlock(&trace->lock);
+}
+
+/* begin timestamp of the complete event; 0 if not traced */
+#define gpuTraceBegin(gclient)							\
+	((gclient)->trace ? __gpuservTimestampUsec() : 0)
+#define gpuTraceComplete(gclient,name,ts_begin,bytes)	\
+	do {												\
+		if ((gclient)->trace)							\
+			__gpuTraceRecord((gclient),(name),'X',(ts_begin),(bytes)); \
+	} while(0)
+#define gpuTraceInstant(gclient,name)					\
+	do {												\
+		if ((gclient)->trace)							\
+			__gpuTraceRecord((gclient),(name),'i',0,0);	\
+	} while(0)
+
+static const char *
+__gpuTraceCommandName(int tag)
+{
+	switch (tag)
+	{
+		case XpuCommandTag__OpenSession:			return "OpenSession";
+		case XpuCommandTag__XpuTaskExec:			return "XpuTaskExec";
+		case XpuCommandTag__XpuTaskExecGpuCache:	return "XpuTaskExecGpuCache";
+		case XpuCommandTag__XpuTaskExecStaged:		return "XpuTaskExecStaged";
+		case XpuCommandTag__XpuTaskCancel:			return "XpuTaskCancel";
+		case XpuCommandTag__XpuTaskFinal:			return "XpuTaskFinal";
+		default:									return "XpuCommand";
+	}
+}
+
+/*
+ * __gpuTraceDump
+ *
+ * It writes out the trace of the session, then releases the buffer.
+ */
+static void
+__gpuTraceDump(gpuClient *gclient)
+{
+	gpuTraceBuffer *trace = gclient->trace;
+	kern_session_info *session = gclient->session;
+	uint32_t	backend_pid = (session ? session->pgsql_backend_pid : 0);
+	uint64_t	query_plan_id = (session ? session->query_plan_id : 0);
+	int			dindex = gclient->gcontext->cuda_dindex;
+	char		path[MAXPGPATH];
+	FILE	   *filp;
+
+	snprintf(path, sizeof(path), "%s/pgstrom-trace-%u-%016lx-gpu%d-%u.json",
+			 pgstrom_gpu_trace_directory,
+			 backend_pid,
+			 query_plan_id,
+			 dindex,
+			 __atomic_fetch_add(&gpuserv_trace_seqno, 1, __ATOMIC_SEQ_CST));
+	filp = fopen(path, "w");
+	if (!filp)
+		__gsLog("failed on fopen('%s'): %s", path, strerror(errno));
+	else
+	{
+		fprintf(filp,
+				"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+				"{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,"
+				"\"args\":{\"name\":\"PID%u/GPU%d\"}}",
+				backend_pid, backend_pid, dindex);
+		for (uint32_t i=0; i < trace->nitems; i++)
+		{
+			gpuTraceEvent *ev = &trace->events[i];
+
+			fprintf(filp,
+					",\n{\"name\":\"%s\",\"cat\":\"pgstrom\",\"ph\":\"%c\","
+					"\"pid\":%u,\"tid\":%d,\"ts\":%lu",
+					ev->name, ev->ph, backend_pid, (int)ev->tid, ev->ts);
+			if (ev->ph == 'X')
+				fprintf(filp, ",\"dur\":%lu", ev->dur);
+			else
+				fprintf(filp, ",\"s\":\"t\"");
+			if (ev->bytes > 0)
+				fprintf(filp, ",\"args\":{\"bytes\":%lu}", ev->bytes);
+			fputc('}', filp);
+		}
+		fprintf(filp,
+				"\n],\"otherData\":{\"query_plan_id\":\"%016lx\","
+				"\"dropped_events\":%lu}}\n",
+				query_plan_id, trace->ndropped);
+		if (fclose(filp) != 0)
+			__gsLog("failed on fclose('%s'): %s", path, strerror(errno));
+		else
+			__gsLog("GPU execution trace was written on '%s' (%u events)",
+					path, trace->nitems);
+	}
+	free(trace->events);
+	free(trace);
+	gclient->trace = NULL;
+}
+
+static void *
+__gpuServiceAllocCommand(void *__priv, size_t sz)
+{
+	gpuMemChunk	   *chunk;
+	gpuServXpuCommandPacked *packed;
+
+	chunk = gpuMemAllocManaged(offsetof(gpuServXpuCommandPacked, xcmd) + sz);
+	if (!chunk)
 		return NULL;
 	packed = (gpuServXpuCommandPacked *)chunk->m_devptr;
 	packed->chunk = chunk;
 	return &packed->xcmd;
 }
 
+static void
+__gpuServiceFreeCommand(XpuCommand *xcmd)
+{
+	gpuServXpuCommandPacked *packed = (gpuServXpuCommandPacked *)
+		((char *)xcmd - offsetof(gpuServXpuCommandPacked, xcmd));
+	gpuMemFree(packed->chunk);
+}
+
+/*
+ * __gpuClientCancelTasks
+ *
+ * The tasks of the client picked up later reply empty results without any
+ * execution, and the running kernels are aborted by the host-mapped flag.
+ */
+static void
+__gpuClientCancelTasks(gpuClient *gclient)
+{
+	gclient->task_cancelled = true;
+	if (gclient->abort_flag)
+		*((volatile uint32_t *)gclient->abort_flag) = 1;
+	pg_memory_barrier();
+}
+
 static void
 __gpuServiceAttachCommand(void *__priv, XpuCommand *xcmd)
 {
 	gpuClient  *gclient = (gpuClient *)__priv;
 	gpuContext *gcontext = gclient->gcontext;
 
+	gpuCommandQueue *cqueue = &gcontext->cmd_queues[gclient->queue_index];
+	int			lane;
+
+	gpuTraceInstant(gclient, __gpuTraceCommandName(xcmd->tag));
+	/*
+	 * XpuTaskCancel is not queued, but applied immediately; elsewhere, the
+	 * tasks already queued would be picked up prior to the cancel request.
+	 */
+	if (xcmd->tag == XpuCommandTag__XpuTaskCancel)
+	{
+		__gpuClientCancelTasks(gclient);
+		__gpuServiceFreeCommand(xcmd);
+		return;
+	}
 	pg_atomic_fetch_add_u32(&gclient->refcnt, 2);
 	xcmd->priv = gclient;
 
-	pthreadMutexLock(&gcontext->lock);
-	dlist_push_tail(&gcontext->command_list, &xcmd->chain);
-	pthreadMutexUnlock(&gcontext->lock);
-	pthreadCondSignal(&gcontext->cond);
+	if (pg_atomic_fetch_add_u32(&gclient->num_queued_cmds, 1) < GPUSERV_COMMAND_HIGH_PRIO_LIMIT)
+		lane = GPUSERV_COMMAND_LANE__HIGH;
+	else
+		lane = GPUSERV_COMMAND_LANE__LOW;
+	pthreadMutexLock(&cqueue->lock);
+	dlist_push_tail(&cqueue->lanes[lane], &xcmd->chain);
+	pthreadMutexUnlock(&cqueue->lock);
+	/*
+	 * MEMO: num_idle_workers is incremented prior to the check of
+	 * num_queued_cmds by the worker, so either of them can see the update.
+	 */
+	pg_atomic_fetch_add_u32(&gcontext->num_queued_cmds, 1);
+	pg_atomic_fetch_add_u32(&gcontext->stats->num_queued_cmds, 1);
+	if (pg_atomic_read_u32(&gcontext->num_idle_workers) > 0)
+	{
+		pthreadMutexLock(&gcontext->lock);
+		pthreadCondSignal(&gcontext->cond);
+		pthreadMutexUnlock(&gcontext->lock);
+	}
 }
 
-static void
-__gpuServiceFreeCommand(XpuCommand *xcmd)
+/*
+ * __gpuServiceFetchCommand
+ *
+ * It picks up a command from the high-priority lane of the home queue and
+ * the other queues, then the low-priority lane. Other queues are checked
+ * with trylock at the first pass, not to contend with the owner workers.
+ */
+static XpuCommand *
+__gpuServiceFetchCommand(gpuContext *gcontext, uint32_t home)
 {
-	gpuServXpuCommandPacked *packed = (gpuServXpuCommandPacked *)
-		((char *)xcmd - offsetof(gpuServXpuCommandPacked, xcmd));
-	gpuMemFree(packed->chunk);
+	for (int pass=0; pass < 2; pass++)
+	{
+		for (int lane=0; lane < GPUSERV_COMMAND_NLANES; lane++)
+		{
+			for (int i=0; i < GPUSERV_COMMAND_NQUEUES; i++)
+			{
+				gpuCommandQueue *cqueue = &gcontext->cmd_queues[(home + i) %
+																GPUSERV_COMMAND_NQUEUES];
+				XpuCommand *xcmd = NULL;
+
+				if (dlist_is_empty(&cqueue->lanes[lane]))
+					continue;	/* quick check without lock */
+				if (i == 0 || pass > 0)
+					pthreadMutexLock(&cqueue->lock);
+				else if (pthread_mutex_trylock(&cqueue->lock) != 0)
+					continue;
+				if (!dlist_is_empty(&cqueue->lanes[lane]))
+				{
+					dlist_node *dnode = dlist_pop_head_node(&cqueue->lanes[lane]);
+
+					xcmd = dlist_container(XpuCommand, chain, dnode);
+				}
+				pthreadMutexUnlock(&cqueue->lock);
+				if (xcmd)
+				{
+					gpuClient  *gclient = xcmd->priv;
+
+					pg_atomic_fetch_sub_u32(&gcontext->num_queued_cmds, 1);
+					pg_atomic_fetch_sub_u32(&gcontext->stats->num_queued_cmds, 1);
+					pg_atomic_fetch_sub_u32(&gclient->num_queued_cmds, 1);
+					return xcmd;
+				}
+			}
+		}
+		if (pg_atomic_read_u32(&gcontext->num_queued_cmds) == 0)
+			break;
+	}
+	return NULL;
 }
+
 TEMPLATE_XPU_CONNECT_RECEIVE_COMMANDS(__gpuService)
 
+static void	__gpuservReleaseSession(gpuClient *gclient);
+
 /*
  * gpuClientPut
  */
@@ -1579,9 +3519,15 @@ gpuClientPut(gpuClient *gclient, bool exit_monitor_thread)
 		pthreadMutexLock(&gcontext->client_lock);
 		dlist_delete(&gclient->chain);
 		pthreadMutexUnlock(&gcontext->client_lock);
+		pg_atomic_fetch_sub_u32(&gcontext->stats->num_clients, 1);
+		if (gclient->monitor)
+			pg_atomic_fetch_sub_u32(&gclient->monitor->num_clients, 1);
 
 		if (gclient->sockfd >= 0)
 			close(gclient->sockfd);
+		__gpuservReleaseSession(gclient);
+		if (gclient->trace)
+			__gpuTraceDump(gclient);
 		if (gclient->gq_buf)
 			putGpuQueryBuffer(gclient->gq_buf);
 		if (gclient->session)
@@ -1590,10 +3536,116 @@ gpuClientPut(gpuClient *gclient, bool exit_monitor_thread)
 												  offsetof(XpuCommand, u.session));
 			__gpuServiceFreeCommand(xcmd);
 		}
+		if (gclient->staging_ring)
+		{
+			if (gclient->staging_ring_pinned)
+				cuMemHostUnregister(gclient->staging_ring);
+			munmap(gclient->staging_ring, gclient->staging_ring_sz);
+		}
+		if (gclient->abort_flag)
+			cuMemFreeHost(gclient->abort_flag);
 		free(gclient);
 	}
 }
 
+/*
+ * __setupGpuColumnarDestBuffer
+ *
+ * It assigns nullmap/values of the columnar projection buffer according
+ * to the kds->length. Varlena attributes have an array of the distance to
+ * the varlena heap at the tail, and the dictionary to share the identical
+ * values; half of the buffer is kept for the varlena heap in this case.
+ */
+static void
+__setupGpuColumnarDestBuffer(kern_data_store *kds)
+{
+	size_t		head_sz = KDS_HEAD_LENGTH(kds);
+	size_t		unitsz = 0;
+	size_t		dict_sz = 0;
+	size_t		avail, off;
+	uint32_t	nrooms;
+
+	for (int j=0; j < kds->ncols; j++)
+	{
+		kern_colmeta *cmeta = &kds->colmeta[j];
+
+		if (cmeta->attlen > 0)
+			unitsz += TYPEALIGN(cmeta->attalign, cmeta->attlen);
+		else
+		{
+			assert(cmeta->attlen == -1);
+			unitsz += sizeof(uint32_t);
+			dict_sz += MAXALIGN(sizeof(uint32_t) * KDS_COLUMN_DICT_NSLOTS);
+		}
+	}
+	avail = kds->length - head_sz - dict_sz - 2 * MAXIMUM_ALIGNOF * kds->ncols;
+	if (dict_sz > 0)
+		avail /= 2;
+	nrooms = (8 * avail) / (8 * unitsz + kds->ncols);
+	nrooms &= ~31U;		/* nullmap is updated per 32bit word */
+
+	off = head_sz;
+	for (int j=0; j < kds->ncols; j++)
+	{
+		kern_colmeta *cmeta = &kds->colmeta[j];
+		size_t		sz;
+
+		sz = MAXALIGN(BITMAPLEN(nrooms));
+		cmeta->nullmap_offset = __kds_packed(off);
+		cmeta->nullmap_length = __kds_packed(sz);
+		off += sz;
+
+		if (cmeta->attlen > 0)
+			sz = MAXALIGN(TYPEALIGN(cmeta->attalign, cmeta->attlen) * nrooms);
+		else
+			sz = MAXALIGN(sizeof(uint32_t) * nrooms);
+		cmeta->values_offset = __kds_packed(off);
+		cmeta->values_length = __kds_packed(sz);
+		off += sz;
+
+		if (cmeta->attlen > 0)
+		{
+			cmeta->extra_offset = 0;
+			cmeta->extra_length = 0;
+		}
+		else
+		{
+			sz = MAXALIGN(sizeof(uint32_t) * KDS_COLUMN_DICT_NSLOTS);
+			memset((char *)kds + off, 0, sz);
+			cmeta->extra_offset = __kds_packed(off);
+			cmeta->extra_length = __kds_packed(sz);
+			off += sz;
+		}
+	}
+	assert(off <= kds->length);
+	kds->nitems = 0;
+	kds->usage  = 0;
+	kds->column_nrooms = nrooms;
+	kds->column_vl_offset = __kds_packed(off);
+	kds->column_vl_usage = 0;
+}
+
+/*
+ * __gpuColumnarDestLength
+ */
+static size_t
+__gpuColumnarDestLength(const kern_data_store *kds)
+{
+	size_t		len = KDS_HEAD_LENGTH(kds);
+
+	for (int j=0; j < kds->ncols; j++)
+	{
+		const kern_colmeta *cmeta = &kds->colmeta[j];
+		size_t		unitsz = (cmeta->attlen > 0
+							  ? TYPEALIGN(cmeta->attalign, cmeta->attlen)
+							  : sizeof(uint32_t));
+
+		len += (MAXALIGN(BITMAPLEN(kds->nitems)) +
+				MAXALIGN(unitsz * kds->nitems));
+	}
+	return len + __kds_unpack(kds->column_vl_usage);
+}
+
 /*
  * gpuClientWriteBack
  */
@@ -1607,7 +3659,7 @@ __gpuClientWriteBack(gpuClient *gclient, struct iovec *iov, int iovcnt)
 
 		while (iovcnt > 0)
 		{
-			nbytes = writev(gclient->sockfd, iov, iovcnt);
+			nbytes = writev(gclient->sockfd, iov, Min(iovcnt, IOV_MAX));
 			if (nbytes > 0)
 			{
 				do {
@@ -1629,11 +3681,11 @@ __gpuClientWriteBack(gpuClient *gclient, struct iovec *iov, int iovcnt)
 			{
 				/*
 				 * Peer socket is closed? Anyway, it looks we cannot continue
-				 * to send back the message any more. So, clean up this gpuClient.
+				 * to send back the message any more. The socket is shut down,
+				 * then the monitor thread detects the hang-up and releases
+				 * its reference to this gpuClient.
 				 */
-				pg_atomic_fetch_and_u32(&gclient->refcnt, ~1U);
-				close(gclient->sockfd);
-				gclient->sockfd = -1;
+				shutdown(gclient->sockfd, SHUT_RDWR);
 				break;
 			}
 		}
@@ -1641,6 +3693,58 @@ __gpuClientWriteBack(gpuClient *gclient, struct iovec *iov, int iovcnt)
 	pthreadMutexUnlock(&gclient->mutex);
 }
 
+/*
+ * __gpuClientWriteBackStaged
+ *
+ * It puts the response on a free slot of the staging ring, then sends only
+ * the slot number, so the backend can reference the results in-place.
+ */
+static bool
+__gpuClientWriteBackStaged(gpuClient *gclient,
+						   struct iovec *iov_array, int iovcnt,
+						   size_t resp_sz)
+{
+	xpuStagingRing *ring = gclient->staging_ring;
+	XpuCommand	staged;
+	struct iovec iov;
+	char	   *pos;
+	int			slot_id = -1;
+
+	if (!ring || resp_sz > ring->slot_sz)
+		return false;
+	for (int i=0; i < ring->nslots; i++)
+	{
+		uint32_t	expected = 0;
+
+		if (pg_atomic_compare_exchange_u32(&ring->slot_busy[i],
+										   &expected, 2))
+		{
+			slot_id = i;
+			break;
+		}
+	}
+	if (slot_id < 0)
+		return false;
+
+	pos = (char *)XPU_STAGING_RING_SLOT(ring, slot_id);
+	for (int i=0; i < iovcnt; i++)
+	{
+		memcpy(pos, iov_array[i].iov_base, iov_array[i].iov_len);
+		pos += iov_array[i].iov_len;
+	}
+	memset(&staged, 0, offsetof(XpuCommand, u.staged));
+	staged.magic = XpuCommandMagicNumber;
+	staged.tag = XpuCommandTag__ResponseStaged;
+	staged.length = offsetof(XpuCommand, u.staged) + sizeof(kern_staged_task);
+	staged.u.staged.slot_id = slot_id;
+
+	iov.iov_base = &staged;
+	iov.iov_len  = staged.length;
+	__gpuClientWriteBack(gclient, &iov, 1);
+
+	return true;
+}
+
 static void
 gpuClientWriteBack(gpuClient  *gclient,
 				   XpuCommand *resp,
@@ -1650,9 +3754,19 @@ gpuClientWriteBack(gpuClient  *gclient,
 {
 	struct iovec   *iov_array;
 	struct iovec   *iov;
+	uint64_t		trace_ts;
 	int				i, iovcnt = 0;
 
-	iov_array = alloca(sizeof(struct iovec) * (3 * kds_nitems + 1));
+	iovcnt = 1;
+	for (i=0; i < kds_nitems; i++)
+	{
+		if (kds_array[i]->format == KDS_FORMAT_COLUMN)
+			iovcnt += 2 * kds_array[i]->ncols + 2;
+		else
+			iovcnt += 3;
+	}
+	iov_array = alloca(sizeof(struct iovec) * iovcnt);
+	iovcnt = 0;
 	iov = &iov_array[iovcnt++];
 	iov->iov_base = resp;
 	iov->iov_len  = resp_sz;
@@ -1717,6 +3831,60 @@ gpuClientWriteBack(gpuClient  *gclient,
 				kds->length = (sz1 + sz2);
 			}
 		}
+		else if (kds->format == KDS_FORMAT_COLUMN)
+		{
+			/*
+			 * Columnar projection results; only the used portion of nullmap,
+			 * values and varlena heap are sent back, then the offsets are
+			 * fixed up. The dictionary is not needed any more.
+			 */
+			size_t		off = KDS_HEAD_LENGTH(kds);
+			size_t		vl_sz = __kds_unpack(kds->column_vl_usage);
+
+			iov = &iov_array[iovcnt++];
+			iov->iov_base = kds;
+			iov->iov_len  = off;
+			for (int j=0; j < kds->ncols; j++)
+			{
+				kern_colmeta *cmeta = &kds->colmeta[j];
+				size_t		unitsz = (cmeta->attlen > 0
+									  ? TYPEALIGN(cmeta->attalign,
+												  cmeta->attlen)
+									  : sizeof(uint32_t));
+
+				sz1 = MAXALIGN(BITMAPLEN(kds->nitems));
+				sz2 = MAXALIGN(unitsz * kds->nitems);
+				if (sz1 > 0)
+				{
+					iov = &iov_array[iovcnt++];
+					iov->iov_base = (char *)kds + __kds_unpack(cmeta->nullmap_offset);
+					iov->iov_len  = sz1;
+				}
+				if (sz2 > 0)
+				{
+					iov = &iov_array[iovcnt++];
+					iov->iov_base = (char *)kds + __kds_unpack(cmeta->values_offset);
+					iov->iov_len  = sz2;
+				}
+				cmeta->nullmap_offset = __kds_packed(off);
+				cmeta->nullmap_length = __kds_packed(sz1);
+				cmeta->values_offset  = __kds_packed(off + sz1);
+				cmeta->values_length  = __kds_packed(sz2);
+				cmeta->extra_offset   = 0;
+				cmeta->extra_length   = 0;
+				off += sz1 + sz2;
+			}
+			if (vl_sz > 0)
+			{
+				iov = &iov_array[iovcnt++];
+				iov->iov_base = (char *)kds + kds->length - vl_sz;
+				iov->iov_len  = vl_sz;
+			}
+			kds->column_nrooms = kds->nitems;
+			kds->column_vl_offset = __kds_packed(off);
+			kds->usage = __kds_packed(vl_sz);
+			kds->length = off + vl_sz;
+		}
 		else
 		{
 			/*
@@ -1730,7 +3898,10 @@ gpuClientWriteBack(gpuClient  *gclient,
 		resp_sz += kds->length;
 	}
 	resp->length = resp_sz;
-	__gpuClientWriteBack(gclient, iov_array, iovcnt);
+	trace_ts = gpuTraceBegin(gclient);
+	if (!__gpuClientWriteBackStaged(gclient, iov_array, iovcnt, resp_sz))
+		__gpuClientWriteBack(gclient, iov_array, iovcnt);
+	gpuTraceComplete(gclient, "write-back", trace_ts, resp_sz);
 }
 
 /* ----------------------------------------------------------------
@@ -1889,7 +4060,7 @@ __lookupDeviceTypeOper(gpuContext *gcontext,
 					   TypeOpCode type_code,
 					   char *emsg, size_t emsg_sz)
 {
-	xpu_type_catalog_entry *xpu_type;
+	gpuDevTypeEntry *xpu_type;
 
 	xpu_type = hash_search(gcontext->cuda_type_htab,
 						   &type_code,
@@ -1927,14 +4098,29 @@ __lookupDeviceFuncDptr(gpuContext *gcontext,
 	return true;
 }
 
+/*
+ * opcode bitmap to identify the set of device functions in use
+ */
+#define GPU_JIT_OPCODE_NWORDS		((FuncOpCode__LoadVars + 63) / 64)
+#define GPU_JIT_OPCODE_TEST(bitmap,opcode)						\
+	(((bitmap)[(opcode) / 64] & (1UL << ((opcode) % 64))) != 0)
+#define GPU_JIT_OPCODE_SET(bitmap,opcode)						\
+	((bitmap)[(opcode) / 64] |= (1UL << ((opcode) % 64)))
+
 static bool
 __resolveDevicePointersWalker(gpuContext *gcontext,
 							  kern_expression *kexp,
+							  uint64_t *opcode_bitmap,
 							  char *emsg, size_t emsg_sz)
 {
 	kern_expression *karg;
 	int		i;
 
+	if (opcode_bitmap &&
+		kexp->opcode > FuncOpCode__Invalid &&
+		kexp->opcode < FuncOpCode__LoadVars)
+		GPU_JIT_OPCODE_SET(opcode_bitmap, kexp->opcode);
+
 	if (!__lookupDeviceFuncDptr(gcontext,
 								&kexp->fn_dptr,
 								kexp->opcode,
@@ -1958,6 +4144,7 @@ __resolveDevicePointersWalker(gpuContext *gcontext,
 				if (!__KEXP_IS_VALID(kexp,karg))
 					goto corruption;
 				if (!__resolveDevicePointersWalker(gcontext, karg,
+												   opcode_bitmap,
 												   emsg, emsg_sz))
 					return false;
 			}
@@ -1968,6 +4155,7 @@ __resolveDevicePointersWalker(gpuContext *gcontext,
 				if (!__KEXP_IS_VALID(kexp,karg))
 					goto corruption;
 				if (!__resolveDevicePointersWalker(gcontext, karg,
+												   opcode_bitmap,
 												   emsg, emsg_sz))
 					return false;
 			}
@@ -1983,7 +4171,9 @@ __resolveDevicePointersWalker(gpuContext *gcontext,
 	{
 		if (!__KEXP_IS_VALID(kexp,karg))
 			goto corruption;
-		if (!__resolveDevicePointersWalker(gcontext, karg, emsg, emsg_sz))
+		if (!__resolveDevicePointersWalker(gcontext, karg,
+										   opcode_bitmap,
+										   emsg, emsg_sz))
 			return false;
 	}
 	return true;
@@ -1993,14 +4183,10 @@ corruption:
 	return false;
 }
 
-static bool
-__resolveDevicePointers(gpuContext *gcontext,
-						kern_session_info *session,
-						char *emsg, size_t emsg_sz)
+static int
+__listupSessionKernExpressions(kern_session_info *session,
+							   kern_expression **__kexp)
 {
-	kern_varslot_desc *kvslot_desc = SESSION_KVARS_SLOT_DESC(session);
-	xpu_encode_info *encode = SESSION_ENCODE(session);
-	kern_expression *__kexp[20];
 	int		nitems = 0;
 
 	__kexp[nitems++] = SESSION_KEXP_LOAD_VARS(session, -1);
@@ -2008,6 +4194,7 @@ __resolveDevicePointers(gpuContext *gcontext,
 	__kexp[nitems++] = SESSION_KEXP_SCAN_QUALS(session);
 	__kexp[nitems++] = SESSION_KEXP_JOIN_QUALS(session, -1);
 	__kexp[nitems++] = SESSION_KEXP_HASH_VALUE(session, -1);
+	__kexp[nitems++] = SESSION_KEXP_HASH_INNER(session, -1);
 	__kexp[nitems++] = SESSION_KEXP_GIST_EVALS(session, -1);
 	__kexp[nitems++] = SESSION_KEXP_PROJECTION(session);
 	__kexp[nitems++] = SESSION_KEXP_GROUPBY_KEYHASH(session);
@@ -2015,10 +4202,28 @@ __resolveDevicePointers(gpuContext *gcontext,
 	__kexp[nitems++] = SESSION_KEXP_GROUPBY_KEYCOMP(session);
 	__kexp[nitems++] = SESSION_KEXP_GROUPBY_ACTIONS(session);
 
+	return nitems;
+}
+
+static bool	__resolveSessionEncode(gpuContext *gcontext,
+									   kern_session_info *session,
+									   char *emsg, size_t emsg_sz);
+
+static bool
+__resolveDevicePointers(gpuContext *gcontext,
+						kern_session_info *session,
+						uint64_t *opcode_bitmap,
+						char *emsg, size_t emsg_sz)
+{
+	kern_varslot_desc *kvslot_desc = SESSION_KVARS_SLOT_DESC(session);
+	kern_expression *__kexp[20];
+	int		nitems = __listupSessionKernExpressions(session, __kexp);
+
 	for (int i=0; i < nitems; i++)
 	{
 		if (__kexp[i] && !__resolveDevicePointersWalker(gcontext,
 														__kexp[i],
+														opcode_bitmap,
 														emsg, emsg_sz))
 			return false;
 	}
@@ -2033,7 +4238,16 @@ __resolveDevicePointers(gpuContext *gcontext,
 			return false;
 	}
 
-	/**/
+	return __resolveSessionEncode(gcontext, session, emsg, emsg_sz);
+}
+
+static bool
+__resolveSessionEncode(gpuContext *gcontext,
+					   kern_session_info *session,
+					   char *emsg, size_t emsg_sz)
+{
+	xpu_encode_info *encode = SESSION_ENCODE(session);
+
 	if (encode)
 	{
 		xpu_encode_info *catalog = gcontext->cuda_encode_catalog;
@@ -2057,744 +4271,4290 @@ __resolveDevicePointers(gpuContext *gcontext,
 	return true;
 }
 
+/*
+ * Session code cache
+ *
+ * A prepared statement runs the same xpucode on every execution, so GPU
+ * service receives the identical kvars-slot descriptors and kern_expressions
+ * by the OpenSession command each time. The cache keeps the image of this
+ * region as received and as resolved, then the following sessions with the
+ * identical image just copy the resolved one, instead of walking on the
+ * expression tree to look up the device pointers.
+ * The region is position independent (offsets in kern_expression are
+ * relative), so the parameters in front of the region may have different
+ * lengths on each execution.
+ * Sessions with pg_strom.jit_kernels are not cached, because their device
+ * pointers are relinked to the JIT module.
+ */
+typedef struct gpuSessionCodeEntry
+{
+	uint64_t	hash;
+	uint32_t	length;
+	char		data[FLEXIBLE_ARRAY_MEMBER];	/* received + resolved image */
+} gpuSessionCodeEntry;
+
 static bool
-gpuservHandleOpenSession(gpuClient *gclient, XpuCommand *xcmd)
+__sessionCodeRegion(kern_session_info *session, size_t session_sz,
+					uint32_t *p_head, uint32_t *p_tail)
 {
-	gpuContext	   *gcontext = gclient->gcontext;
-	kern_session_info *session = &xcmd->u.session;
-	XpuCommand		resp;
-	char			emsg[512];
-	struct iovec	iov;
+	kern_expression *__kexp[20];
+	int			nitems = __listupSessionKernExpressions(session, __kexp);
+	uint64_t	head = UINT_MAX;
+	uint64_t	tail = 0;
 
-	if (gclient->session)
+	if (session->kcxt_kvars_defs != 0)
 	{
-		gpuClientELog(gclient, "OpenSession is called twice");
-		return false;
+		head = session->kcxt_kvars_defs;
+		tail = head + sizeof(kern_varslot_desc) * session->kcxt_kvars_nslots;
 	}
-	/* expand CUDA thread stack limit on demand */
-	if (!expandCudaStackLimit(gclient, session))
+	for (int i=0; i < nitems; i++)
+	{
+		uint64_t	off;
+
+		if (!__kexp[i])
+			continue;
+		off = (char *)__kexp[i] - (char *)session;
+		head = Min(head, off);
+		tail = Max(tail, off + __kexp[i]->len);
+	}
+	if (head >= tail || tail > session_sz)
 		return false;
+	*p_head = head;
+	*p_tail = tail;
+	return true;
+}
 
-	/* resolve device pointers */
-	if (!__resolveDevicePointers(gcontext, session, emsg, sizeof(emsg)))
+static bool
+__resolveDevicePointersCached(gpuContext *gcontext,
+							  kern_session_info *session,
+							  size_t session_sz,
+							  char *emsg, size_t emsg_sz)
+{
+	gpuSessionCodeEntry *entry;
+	gpuSessionCodeEntry *victim;
+	uint32_t	head, tail, length;
+	uint64_t	hash;
+	char	   *region;
+	int			index;
+
+	if (!__sessionCodeRegion(session, session_sz, &head, &tail))
+		return __resolveDevicePointers(gcontext, session, NULL, emsg, emsg_sz);
+	region = (char *)session + head;
+	length = tail - head;
+	hash = hash_bytes_extended((const unsigned char *)region, length, 0);
+	index = hash % GPU_SESSION_CODE_CACHE_NSLOTS;
+
+	pthreadMutexLock(&gcontext->session_code_lock);
+	entry = gcontext->session_code_cache[index];
+	if (entry &&
+		entry->hash == hash &&
+		entry->length == length &&
+		memcmp(entry->data, region, length) == 0)
 	{
-		gpuClientELog(gclient, "%s", emsg);
+		memcpy(region, entry->data + length, length);
+		pthreadMutexUnlock(&gcontext->session_code_lock);
+		return __resolveSessionEncode(gcontext, session, emsg, emsg_sz);
+	}
+	pthreadMutexUnlock(&gcontext->session_code_lock);
+
+	/* not cached yet, so resolve the device pointers as usual */
+	entry = malloc(offsetof(gpuSessionCodeEntry, data) + 2 * length);
+	if (entry)
+	{
+		entry->hash = hash;
+		entry->length = length;
+		memcpy(entry->data, region, length);
+	}
+	if (!__resolveDevicePointers(gcontext, session, NULL, emsg, emsg_sz))
+	{
+		if (entry)
+			free(entry);
 		return false;
 	}
-	if (session->join_inner_handle != 0 ||
-		session->groupby_kds_final != 0)
+	if (entry)
 	{
-		kern_data_store *kds_final_head = NULL;
-
-		if (session->groupby_kds_final != 0)
-		{
-			kds_final_head = (kern_data_store *)
-				((char *)session + session->groupby_kds_final);
-		}
-		gclient->gq_buf = getGpuQueryBuffer(gcontext,
-											session->query_plan_id,
-											session->join_inner_handle,
-											kds_final_head,
-											emsg, sizeof(emsg));
-		if (!gclient->gq_buf)
-		{
-			gpuClientELog(gclient, "%s", emsg);
-			return false;
-		}
+		memcpy(entry->data + length, region, length);
+		pthreadMutexLock(&gcontext->session_code_lock);
+		victim = gcontext->session_code_cache[index];
+		gcontext->session_code_cache[index] = entry;
+		pthreadMutexUnlock(&gcontext->session_code_lock);
+		if (victim)
+			free(victim);
 	}
-	gclient->session = session;
-
-	/* success status */
-	memset(&resp, 0, sizeof(resp));
-	resp.magic = XpuCommandMagicNumber;
-	resp.tag = XpuCommandTag__Success;
-	resp.length = offsetof(XpuCommand, u.results.stats);
-
-	iov.iov_base = &resp;
-	iov.iov_len  = resp.length;
-	__gpuClientWriteBack(gclient, &iov, 1);
-
 	return true;
 }
 
 /* ----------------------------------------------------------------
  *
- * gpuservLoadKdsXXXX - Load data chunks using GPU-Direct SQL
+ * Runtime-specialized GPU kernels (pg_strom.jit_kernels)
+ *
+ * The kern_expression interpreter invokes device functions using the
+ * function pointers (fn_dptr), so nvcc can neither inline nor optimize
+ * across the expression tree. If pg_strom.jit_kernels is enabled, GPU
+ * service builds an alternative fatbin for the set of device functions
+ * used by the session in the background. It has a dispatcher function
+ * that calls these device functions directly, and the whole device code
+ * is linked with link-time optimization.
+ * Sessions opened prior to the completion of the build run on the
+ * interpreter as usual, and the built fatbin is kept on the
+ * PGSTROM_FATBIN_DIR/jit directory for reuse.
  *
  * ----------------------------------------------------------------
  */
-static gpuMemChunk *
-__gpuservLoadKdsCommon(gpuClient *gclient,
-					   kern_data_store *kds,
-					   size_t base_offset,
-					   const char *pathname,
-					   strom_io_vector *kds_iovec,
-					   uint32_t *p_npages_direct_read,
-					   uint32_t *p_npages_vfs_read)
+#define GPU_JIT_MODULE__BUILDING	0
+#define GPU_JIT_MODULE__READY		1
+#define GPU_JIT_MODULE__FAILED		2
+
+typedef struct
 {
-	gpuMemChunk *chunk;
-	CUresult	rc;
-	off_t		off = PAGE_ALIGN(base_offset);
-	size_t		gap = off - base_offset;
+	CUmodule	cuda_module;
+	CUfunction	kern_gpumain;
+	int			nr_types;
+	xpu_type_catalog_entry *type_catalog;	/* sorted by type_opcode */
+	int			nr_funcs;
+	xpu_function_catalog_entry *func_catalog; /* sorted by func_opcode */
+	xpu_encode_info *encode_catalog;
+} gpuJitModuleDevice;
 
-	chunk = gpuMemAlloc(gap + kds->length);
-	if (!chunk)
+typedef struct
+{
+	dlist_node	chain;
+	uint64_t	hash;			/* hash of the opcode_bitmap */
+	uint64_t	opcode_bitmap[GPU_JIT_OPCODE_NWORDS];
+	volatile int status;		/* one of GPU_JIT_MODULE__* */
+	char	   *fatbin_path;	/* absolute path of the fatbin */
+	gpuJitModuleDevice devs[FLEXIBLE_ARRAY_MEMBER];	/* per device */
+} gpuJitModule;
+
+static pthread_mutex_t	gpuserv_jit_module_lock = PTHREAD_MUTEX_INITIALIZER;
+static dlist_head		gpuserv_jit_module_list =
+	DLIST_STATIC_INIT(gpuserv_jit_module_list);
+
+static const struct {
+	FuncOpCode	func_opcode;
+	const char *func_name;
+} gpuserv_jit_function_names[] = {
+#define FUNC_OPCODE(a,b,c,NAME,d,e)			\
+	{FuncOpCode__##NAME, "pgfn_" #NAME},
+#define DEVONLY_FUNC_OPCODE(a,NAME,b,c,d)	\
+	{FuncOpCode__##NAME, "pgfn_" #NAME},
+#include "xpu_opcodes.h"
+	{FuncOpCode__Invalid, NULL}
+};
+
+/*
+ * __gpuservJitBuilderMain
+ *
+ * NOTE: it runs on a worker thread, so must not use elog() or palloc().
+ */
+static void *
+__gpuservJitBuilderMain(void *__priv)
+{
+	gpuJitModule *jit_module = __priv;
+	char		workdir[200];
+	char		path[MAXPGPATH];
+	char	   *namebuf;
+	char	   *tok, *pos;
+	char	   *cmd = NULL;
+	size_t		cmd_sz = 0;
+	FILE	   *filp;
+	int			status = GPU_JIT_MODULE__FAILED;
+
+	strcpy(workdir, "/tmp/.pgstrom_jit_build_XXXXXX");
+	if (!mkdtemp(workdir))
 	{
-		gpuClientELog(gclient, "failed on gpuMemAlloc(%zu)", kds->length);
-		return NULL;
+		__gsLog("unable to create work directory for JIT build: %m");
+		goto out;
 	}
-	chunk->m_devptr = chunk->__base + chunk->__offset + gap;
-
-	rc = cuMemcpyHtoD(chunk->m_devptr, kds, base_offset);
-	if (rc != CUDA_SUCCESS)
+	/* generation of the dispatcher function */
+	snprintf(path, sizeof(path), "%s/jit_dispatch.cu", workdir);
+	filp = fopen(path, "w");
+	if (!filp)
 	{
-		gpuClientELog(gclient, "failed on cuMemcpyHtoD: %s", cuStrError(rc));
-		goto error;
+		__gsLog("failed on fopen('%s'): %m", path);
+		goto out;
 	}
-	if (!gpuDirectFileReadIOV(pathname,
-							  chunk->__base,
-							  chunk->__offset + off,
-							  chunk->mseg->iomap_handle,
-							  kds_iovec,
-							  p_npages_direct_read,
-							  p_npages_vfs_read))
+	fprintf(filp,
+			"#include \"xpu_common.h\"\n"
+			"\n"
+			"EXTERN_FUNCTION(bool)\n"
+			"__jit_exec_kern_expression(XPU_PGFUNCTION_ARGS)\n"
+			"{\n"
+			"\tswitch (kexp->opcode)\n"
+			"\t{\n");
+	for (int i=0; gpuserv_jit_function_names[i].func_name != NULL; i++)
 	{
-		gpuClientELogByExtraModule(gclient);
-		goto error;
+		FuncOpCode	func_opcode = gpuserv_jit_function_names[i].func_opcode;
+
+		if (!GPU_JIT_OPCODE_TEST(jit_module->opcode_bitmap, func_opcode))
+			continue;
+		fprintf(filp,
+				"\t\tcase %u:\n"
+				"\t\t\treturn %s(kcxt, kexp, __result);\n",
+				(uint32_t)func_opcode,
+				gpuserv_jit_function_names[i].func_name);
+	}
+	fprintf(filp,
+			"\t\tdefault:\n"
+			"\t\t\tbreak;\n"
+			"\t}\n"
+			"\t/* elsewhere, invocation via the function pointer */\n"
+			"\treturn kexp->fn_dptr(kcxt, kexp, __result);\n"
+			"}\n");
+	if (fclose(filp) != 0)
+	{
+		__gsLog("failed on fclose('%s'): %m", path);
+		goto out;
 	}
-	return chunk;
 
-error:
-	gpuMemFree(chunk);
+	/* build the fatbin with the same options as the core fatbin */
+	filp = open_memstream(&cmd, &cmd_sz);
+	if (!filp)
+	{
+		__gsLog("failed on open_memstream: %m");
+		goto out;
+	}
+	fprintf(filp, "cd '%s' && (", workdir);
+	namebuf = alloca(sizeof(CUDA_CORE_FILES) + 1);
+	strcpy(namebuf, CUDA_CORE_FILES);
+	for (tok = strtok_r(namebuf, " ", &pos);
+		 tok != NULL;
+		 tok = strtok_r(NULL,    " ", &pos))
+	{
+		fprintf(filp,
+				" /bin/sh -x -c '%s/bin/nvcc"
+				" --maxrregcount=%d"
+				" -I. -I%s "
+				" -DHAVE_FLOAT2 -DPGSTROM_JIT_KERNELS=1"
+				" -arch=native -dlto --threads 4"
+				" --device-c"
+				" -o %s.o"
+				" %s/pg_strom/%s.cu' > %s.log 2>&1 &",
+				pgstrom_cuda_toolkit_basedir,
+				CUDA_MAXREGCOUNT,
+				PGINCLUDEDIR,
+				tok,
+				PGSHAREDIR, tok, tok);
+	}
+	for (int i=0; i < gpuserv_num_user_cuda_sources; i++)
+	{
+		fprintf(filp,
+				" /bin/sh -x -c '%s/bin/nvcc"
+				" --maxrregcount=%d"
+				" -I. -I%s -I%s/pg_strom"
+				" -DHAVE_FLOAT2 -DPGSTROM_JIT_KERNELS=1"
+				" -arch=native -dlto --threads 4"
+				" --device-c"
+				" -o user_%d.o"
+				" %s' > user_%d.log 2>&1 &",
+				pgstrom_cuda_toolkit_basedir,
+				CUDA_MAXREGCOUNT,
+				PGINCLUDEDIR,
+				PGSHAREDIR,
+				i,
+				gpuserv_user_cuda_sources[i], i);
+	}
+	fprintf(filp,
+			" /bin/sh -x -c '%s/bin/nvcc"
+			" --maxrregcount=%d"
+			" -I. -I%s -I%s/pg_strom"
+			" -DHAVE_FLOAT2 -DPGSTROM_JIT_KERNELS=1"
+			" -arch=native -dlto --threads 4"
+			" --device-c"
+			" -o jit_dispatch.o"
+			" jit_dispatch.cu' > jit_dispatch.log 2>&1;"
+			" wait) &&"
+			" /bin/sh -x -c '%s/bin/nvcc"
+			" -Xnvlink --suppress-stack-size-warning"
+			" -arch=native -dlto --threads 4"
+			" --device-link --fatbin"
+			" -o jit.fatbin",
+			pgstrom_cuda_toolkit_basedir,
+			CUDA_MAXREGCOUNT,
+			PGINCLUDEDIR,
+			PGSHAREDIR,
+			pgstrom_cuda_toolkit_basedir);
+	strcpy(namebuf, CUDA_CORE_FILES);
+	for (tok = strtok_r(namebuf, " ", &pos);
+		 tok != NULL;
+		 tok = strtok_r(NULL,    " ", &pos))
+	{
+		fprintf(filp, " %s.o", tok);
+	}
+	for (int i=0; i < gpuserv_num_user_cuda_sources; i++)
+		fprintf(filp, " user_%d.o", i);
+	fprintf(filp,
+			" jit_dispatch.o' > jit.log 2>&1 &&"
+			" mkdir -p '%s/%s/jit' &&"
+			" install -m 0644 jit.fatbin '%s' &&"
+			" cd / && rm -rf '%s'",
+			DataDir, PGSTROM_FATBIN_DIR,
+			jit_module->fatbin_path,
+			workdir);
+	if (fclose(filp) != 0)
+	{
+		__gsLog("failed on fclose(memstream): %m");
+		goto out;
+	}
+	__gsDebug("JIT build command: %s", cmd);
+	if (system(cmd) != 0)
+	{
+		__gsLog("failed on the JIT build process at [%s]", workdir);
+		goto out;
+	}
+	__gsLog("runtime-specialized fatbin is ready: %s", jit_module->fatbin_path);
+	status = GPU_JIT_MODULE__READY;
+out:
+	if (cmd)
+		free(cmd);
+	pg_memory_barrier();
+	jit_module->status = status;
 	return NULL;
 }
 
 /*
- * gpuservLoadKdsBlock
- *
- * fill up KDS_FORMAT_BLOCK using GPU-Direct
+ * gpuservJitLookupModule
  */
-static gpuMemChunk *
-gpuservLoadKdsBlock(gpuClient *gclient,
-					kern_data_store *kds,
-					const char *pathname,
-					strom_io_vector *kds_iovec,
-					uint32_t *p_npages_direct_read,
-					uint32_t *p_npages_vfs_read)
+static gpuJitModule *
+gpuservJitLookupModule(const uint64_t *opcode_bitmap)
 {
-	size_t		base_offset;
+	gpuJitModule *jit_module;
+	const char *base;
+	uint64_t	hash;
+	size_t		sz;
+	dlist_iter	iter;
+	pthread_t	thread;
+	int			errcode;
 
-	Assert(kds->format == KDS_FORMAT_BLOCK);
-	base_offset = kds->block_offset + kds->block_nloaded * BLCKSZ;
-	return __gpuservLoadKdsCommon(gclient,
-								  kds,
-								  base_offset,
-								  pathname,
-								  kds_iovec,
-								  p_npages_direct_read,
-								  p_npages_vfs_read);
+	hash = hash_bytes_extended((const unsigned char *)opcode_bitmap,
+							   sizeof(uint64_t) * GPU_JIT_OPCODE_NWORDS, 0);
+	pthreadMutexLock(&gpuserv_jit_module_lock);
+	dlist_foreach(iter, &gpuserv_jit_module_list)
+	{
+		jit_module = dlist_container(gpuJitModule, chain, iter.cur);
+		if (jit_module->hash == hash &&
+			memcmp(jit_module->opcode_bitmap, opcode_bitmap,
+				   sizeof(uint64_t) * GPU_JIT_OPCODE_NWORDS) == 0)
+			goto found;
+	}
+	/* not found, so construct a new one */
+	sz = offsetof(gpuJitModule, devs[numGpuDevAttrs]);
+	jit_module = calloc(1, sz + MAXPGPATH);
+	if (!jit_module)
+	{
+		pthreadMutexUnlock(&gpuserv_jit_module_lock);
+		return NULL;
+	}
+	jit_module->hash = hash;
+	memcpy(jit_module->opcode_bitmap, opcode_bitmap,
+		   sizeof(uint64_t) * GPU_JIT_OPCODE_NWORDS);
+	jit_module->fatbin_path = (char *)jit_module + sz;
+	/* fatbin name follows the core fatbin; CUDA version and source md5 */
+	base = pgstrom_fatbin_image_basename;
+	snprintf(jit_module->fatbin_path, MAXPGPATH,
+			 "%s/%s/jit/%.*s-%016lx.fatbin",
+			 DataDir, PGSTROM_FATBIN_DIR,
+			 (int)(strlen(base) - Min(strlen(base), 7)), base,
+			 (unsigned long)hash);
+	if (access(jit_module->fatbin_path, R_OK) == 0)
+	{
+		/* already built at the previous run */
+		jit_module->status = GPU_JIT_MODULE__READY;
+	}
+	else
+	{
+		jit_module->status = GPU_JIT_MODULE__BUILDING;
+		if ((errcode = pthread_create(&thread, NULL,
+									  __gpuservJitBuilderMain,
+									  jit_module)) != 0)
+		{
+			__gsLog("failed on pthread_create: %s", strerror(errcode));
+			jit_module->status = GPU_JIT_MODULE__FAILED;
+		}
+		else
+			pthread_detach(thread);
+	}
+	dlist_push_tail(&gpuserv_jit_module_list, &jit_module->chain);
+found:
+	pthreadMutexUnlock(&gpuserv_jit_module_lock);
+
+	return jit_module;
 }
 
 /*
- * gpuservLoadKdsArrow
+ * __gpuservJitLoadModuleDevice
  *
- * fill up KDS_FORMAT_ARROW using GPU-Direct
+ * NOTE: caller must hold gpuserv_jit_module_lock
  */
-static gpuMemChunk *
-gpuservLoadKdsArrow(gpuClient *gclient,
-					kern_data_store *kds,
-					const char *pathname,
-					strom_io_vector *kds_iovec,
-					uint32_t *p_npages_direct_read,
-					uint32_t *p_npages_vfs_read)
+static int
+__compareJitTypeCatalog(const void *__a, const void *__b)
 {
-	size_t		base_offset;
+	const xpu_type_catalog_entry *a = __a;
+	const xpu_type_catalog_entry *b = __b;
+
+	if (a->type_opcode < b->type_opcode)
+		return -1;
+	if (a->type_opcode > b->type_opcode)
+		return 1;
+	return 0;
+}
 
-	Assert(kds->format == KDS_FORMAT_ARROW);
-	base_offset = KDS_HEAD_LENGTH(kds);
-	return __gpuservLoadKdsCommon(gclient,
-								  kds,
-								  base_offset,
-								  pathname,
-								  kds_iovec,
-								  p_npages_direct_read,
-								  p_npages_vfs_read);
+static int
+__compareJitFuncCatalog(const void *__a, const void *__b)
+{
+	const xpu_function_catalog_entry *a = __a;
+	const xpu_function_catalog_entry *b = __b;
+
+	if (a->func_opcode < b->func_opcode)
+		return -1;
+	if (a->func_opcode > b->func_opcode)
+		return 1;
+	return 0;
 }
 
-/* ----------------------------------------------------------------
- *
- * gpuservHandleGpuTaskExec
+/*
+ * __resolveUserDevFuncDptr
  *
- * ----------------------------------------------------------------
+ * It fetches the device function pointer supplied by extension, from the
+ * __device__ variable of xpu_function_t in the GPU module.
  */
-static unsigned int
-__expand_gpupreagg_prepfunc_buffer(kern_session_info *session,
-								   int grid_sz, int block_sz,
-								   unsigned int __shmem_dynamic_sz,
-								   unsigned int shmem_dynamic_limit,
-								   unsigned int *p_groupby_prepfn_bufsz,
-								   unsigned int *p_groupby_prepfn_nbufs)
+static bool
+__resolveUserDevFuncDptr(CUmodule cuda_module, const char *symbol,
+						 xpu_function_t *p_func_dptr,
+						 char *emsg, size_t emsg_sz)
 {
-	unsigned int	shmem_dynamic_sz = TYPEALIGN(1024, __shmem_dynamic_sz);
-
-	if (session->groupby_prepfn_bufsz == 0 || shmem_dynamic_sz >= shmem_dynamic_limit)
-		goto no_prepfunc_buffer;
+	CUdeviceptr	dptr;
+	CUresult	rc;
+	size_t		nbytes;
 
-	if (session->xpucode_groupby_keyhash &&
-		session->xpucode_groupby_keyload &&
-		session->xpucode_groupby_keycomp)
+	rc = cuModuleGetGlobal(&dptr, &nbytes, cuda_module, symbol);
+	if (rc != CUDA_SUCCESS)
 	{
-		/* GROUP-BY */
-		int		num_buffers = 2 * session->groupby_ngroups_estimation + 100;
-		int		prepfn_usage = session->groupby_prepfn_bufsz * num_buffers;
+		snprintf(emsg, emsg_sz, "failed on cuModuleGetGlobal('%s'): %s",
+				 symbol, cuStrError(rc));
+		return false;
+	}
+	if (nbytes != sizeof(xpu_function_t))
+	{
+		snprintf(emsg, emsg_sz, "device symbol '%s' is not xpu_function_t",
+				 symbol);
+		return false;
+	}
+	rc = cuMemcpyDtoH(p_func_dptr, dptr, nbytes);
+	if (rc != CUDA_SUCCESS)
+	{
+		snprintf(emsg, emsg_sz, "failed on cuMemcpyDtoH: %s",
+				 cuStrError(rc));
+		return false;
+	}
+	return true;
+}
 
-		if (shmem_dynamic_sz + prepfn_usage > shmem_dynamic_limit)
-		{
-			/* adjust num_buffers, if too large */
-			num_buffers = (shmem_dynamic_limit -
-						   shmem_dynamic_sz) / session->groupby_prepfn_bufsz;
-			prepfn_usage = session->groupby_prepfn_bufsz * num_buffers;
-		}
-		Assert(shmem_dynamic_sz + prepfn_usage <= shmem_dynamic_limit);
-		if (num_buffers >= 32)
-		{
-			*p_groupby_prepfn_bufsz = session->groupby_prepfn_bufsz;
-			*p_groupby_prepfn_nbufs = num_buffers;
-			return shmem_dynamic_sz + prepfn_usage;
-		}
+static void *
+__gpuservJitLoadCatalog(CUmodule cuda_module, const char *symbol)
+{
+	CUdeviceptr	dptr;
+	CUresult	rc;
+	size_t		nbytes;
+	void	   *catalog;
+
+	rc = cuModuleGetGlobal(&dptr, &nbytes, cuda_module, symbol);
+	if (rc != CUDA_SUCCESS)
+	{
+		__gsLog("failed on cuModuleGetGlobal('%s'): %s",
+				symbol, cuStrError(rc));
+		return NULL;
 	}
-	else if (session->xpucode_groupby_actions)
+	catalog = malloc(nbytes);
+	if (!catalog)
 	{
-		/* NO-GROUPS */
-		if (shmem_dynamic_sz + session->groupby_prepfn_bufsz <= shmem_dynamic_limit)
-		{
-			*p_groupby_prepfn_bufsz = session->groupby_prepfn_bufsz;
-			*p_groupby_prepfn_nbufs = 1;
-			return shmem_dynamic_sz + session->groupby_prepfn_bufsz;
-		}
+		__gsLog("out of memory");
+		return NULL;
 	}
-no_prepfunc_buffer:
-	*p_groupby_prepfn_bufsz = 0;
-	*p_groupby_prepfn_nbufs = 0;
-	return __shmem_dynamic_sz;		/* unaligned original size */
+	rc = cuMemcpyDtoH(catalog, dptr, nbytes);
+	if (rc != CUDA_SUCCESS)
+	{
+		__gsLog("failed on cuMemcpyDtoH: %s", cuStrError(rc));
+		free(catalog);
+		return NULL;
+	}
+	return catalog;
 }
 
-static void
-gpuservHandleGpuTaskExec(gpuClient *gclient, XpuCommand *xcmd)
+static bool
+__gpuservJitLoadModuleDevice(gpuContext *gcontext, gpuJitModule *jit_module)
 {
-	gpuContext		*gcontext = gclient->gcontext;
-	kern_session_info *session = gclient->session;
-	gpuQueryBuffer  *gq_buf = gclient->gq_buf;
-	kern_gputask	*kgtask = NULL;
-	const char		*kds_src_pathname = NULL;
-	strom_io_vector *kds_src_iovec = NULL;
-	kern_data_store *kds_src = NULL;
-	kern_data_store *kds_dst = NULL;
-	kern_data_store *kds_dst_head = NULL;
-	kern_data_store **kds_dst_array = NULL;
-	int				kds_dst_nrooms = 0;
-	int				kds_dst_nitems = 0;
-	int				num_inner_rels = 0;
-	uint32_t		npages_direct_read = 0;
-	uint32_t		npages_vfs_read = 0;
-	CUfunction		f_kern_gpuscan;
-	void		   *gc_lmap = NULL;
-	gpuMemChunk	   *s_chunk = NULL;		/* for kds_src */
-	gpuMemChunk	   *t_chunk = NULL;		/* for kern_gputask */
-	gpuMemChunk	  **d_chunk_array = NULL; /* for kds_dst_array */
-	CUdeviceptr		m_kds_src = 0UL;
-	CUdeviceptr		m_kds_extra = 0UL;
-	CUdeviceptr		m_kmrels = 0UL;
-	CUresult		rc;
-	int				grid_sz;
-	int				block_sz;
-	unsigned int	shmem_dynamic_sz;
-	unsigned int	groupby_prepfn_bufsz = 0;
-	unsigned int	groupby_prepfn_nbufs = 0;
-	size_t			kds_final_length = 0;
-	bool			kds_final_locked = false;
-	size_t			sz;
-	void		   *kern_args[10];
+	gpuJitModuleDevice *jdev = &jit_module->devs[gcontext->cuda_dindex];
+	const pgstromUserDevFunc *ufuncs;
+	int			nr_ufuncs;
+	CUmodule	cuda_module;
+	CUresult	rc;
 
-	if (xcmd->u.task.kds_src_pathname)
-		kds_src_pathname = (char *)xcmd + xcmd->u.task.kds_src_pathname;
-	if (xcmd->u.task.kds_src_iovec)
-		kds_src_iovec = (strom_io_vector *)((char *)xcmd + xcmd->u.task.kds_src_iovec);
-	if (xcmd->u.task.kds_src_offset)
-		kds_src = (kern_data_store *)((char *)xcmd + xcmd->u.task.kds_src_offset);
-	if (xcmd->u.task.kds_dst_offset)
-		kds_dst_head = (kern_data_store *)((char *)xcmd + xcmd->u.task.kds_dst_offset);
-	if (!kds_src)
+	rc = cuModuleLoad(&cuda_module, jit_module->fatbin_path);
+	if (rc != CUDA_SUCCESS)
 	{
-		const GpuCacheIdent *ident = (GpuCacheIdent *)xcmd->u.task.data;
-		char		errbuf[120];
+		__gsLog("failed on cuModuleLoad('%s'): %s",
+				jit_module->fatbin_path, cuStrError(rc));
+		goto error;
+	}
+	jdev->cuda_module = cuda_module;
 
-		Assert(xcmd->tag == XpuCommandTag__XpuTaskExecGpuCache);
-		gc_lmap = gpuCacheGetDeviceBuffer(ident,
-										  &m_kds_src,
-										  &m_kds_extra,
-										  errbuf, sizeof(errbuf));
-		if (!gc_lmap)
-		{
-			gpuClientELog(gclient, "no GpuCache (dat=%u,rel=%u,sig=%09lx) found - %s",
-						  ident->database_oid,
-						  ident->table_oid,
-						  ident->signature,
-						  errbuf);
-			return;
-		}
+	rc = cuModuleGetFunction(&jdev->kern_gpumain,
+							 cuda_module,
+							 "kern_gpujoin_main");
+	if (rc != CUDA_SUCCESS)
+	{
+		__gsLog("failed on cuModuleGetFunction: %s", cuStrError(rc));
+		goto error;
 	}
-	else if (kds_src->format == KDS_FORMAT_ROW)
+	rc = cuFuncSetAttribute(jdev->kern_gpumain,
+							CU_FUNC_ATTRIBUTE_MAX_DYNAMIC_SHARED_SIZE_BYTES,
+							gcontext->gpumain_shmem_sz_dynamic);
+	if (rc != CUDA_SUCCESS)
 	{
-		m_kds_src = (CUdeviceptr)kds_src;
+		__gsLog("failed on cuFuncSetAttribute(MAX_DYNAMIC_SHARED_SIZE_BYTES, %d): %s",
+				gcontext->gpumain_shmem_sz_dynamic, cuStrError(rc));
+		goto error;
 	}
-	else if (kds_src->format == KDS_FORMAT_BLOCK)
+	/* device types and functions linkage of the JIT module */
+	jdev->type_catalog = __gpuservJitLoadCatalog(cuda_module,
+												 "builtin_xpu_types_catalog");
+	if (!jdev->type_catalog)
+		goto error;
+	while (jdev->type_catalog[jdev->nr_types].type_opcode != TypeOpCode__Invalid)
+		jdev->nr_types++;
+	qsort(jdev->type_catalog, jdev->nr_types,
+		  sizeof(xpu_type_catalog_entry),
+		  __compareJitTypeCatalog);
+
+	jdev->func_catalog = __gpuservJitLoadCatalog(cuda_module,
+												 "builtin_xpu_functions_catalog");
+	if (!jdev->func_catalog)
+		goto error;
+	while (jdev->func_catalog[jdev->nr_funcs].func_opcode != FuncOpCode__Invalid)
+		jdev->nr_funcs++;
+	/* device functions supplied by extensions */
+	ufuncs = pgstrom_user_devfunc_catalog(&nr_ufuncs);
+	if (nr_ufuncs > 0)
 	{
-		if (kds_src_pathname && kds_src_iovec)
+		xpu_function_catalog_entry *func_catalog;
+
+		func_catalog = realloc(jdev->func_catalog,
+							   sizeof(xpu_function_catalog_entry) *
+							   (jdev->nr_funcs + nr_ufuncs + 1));
+		if (!func_catalog)
 		{
-			s_chunk = gpuservLoadKdsBlock(gclient,
-										  kds_src,
-										  kds_src_pathname,
-										  kds_src_iovec,
-										  &npages_direct_read,
-										  &npages_vfs_read);
-			if (!s_chunk)
-				return;
-			m_kds_src = s_chunk->m_devptr;
+			__gsLog("out of memory");
+			goto error;
 		}
-		else
+		jdev->func_catalog = func_catalog;
+		for (int i=0; i < nr_ufuncs; i++)
 		{
-			Assert(kds_src->block_nloaded == kds_src->nitems);
-			m_kds_src = (CUdeviceptr)kds_src;
+			xpu_function_catalog_entry *entry;
+			char		emsg[512];
+
+			if ((ufuncs[i].func_flags & DEVKIND__NVIDIA_GPU) == 0)
+				continue;
+			entry = &jdev->func_catalog[jdev->nr_funcs];
+			if (!__resolveUserDevFuncDptr(cuda_module,
+										  ufuncs[i].cuda_symbol,
+										  &entry->func_dptr,
+										  emsg, sizeof(emsg)))
+			{
+				__gsLog("%s", emsg);
+				goto error;
+			}
+			entry->func_opcode = ufuncs[i].func_code;
+			jdev->nr_funcs++;
 		}
 	}
-	else if (kds_src->format == KDS_FORMAT_ARROW)
+	qsort(jdev->func_catalog, jdev->nr_funcs,
+		  sizeof(xpu_function_catalog_entry),
+		  __compareJitFuncCatalog);
+
+	jdev->encode_catalog = __gpuservJitLoadCatalog(cuda_module,
+												   "xpu_encode_catalog");
+	if (!jdev->encode_catalog)
+		goto error;
+	return true;
+
+error:
+	if (jdev->cuda_module)
+		cuModuleUnload(jdev->cuda_module);
+	if (jdev->type_catalog)
+		free(jdev->type_catalog);
+	if (jdev->func_catalog)
+		free(jdev->func_catalog);
+	memset(jdev, 0, sizeof(gpuJitModuleDevice));
+	jit_module->status = GPU_JIT_MODULE__FAILED;
+	return false;
+}
+
+/*
+ * __gpuservJitRelinkSession
+ *
+ * It replaces the device pointers resolved by __resolveDevicePointers()
+ * with the ones in the JIT module.
+ */
+static const xpu_datum_operators *
+__gpuservJitLookupTypeOps(gpuJitModuleDevice *jdev, TypeOpCode type_opcode)
+{
+	xpu_type_catalog_entry key, *entry;
+
+	key.type_opcode = type_opcode;
+	entry = bsearch(&key, jdev->type_catalog, jdev->nr_types,
+					sizeof(xpu_type_catalog_entry),
+					__compareJitTypeCatalog);
+	return (entry ? entry->type_ops : NULL);
+}
+
+static bool
+__gpuservJitRelinkWalker(gpuJitModuleDevice *jdev, kern_expression *kexp)
+{
+	xpu_function_catalog_entry key, *entry;
+	kern_expression *karg;
+	int		i;
+
+	key.func_opcode = kexp->opcode;
+	entry = bsearch(&key, jdev->func_catalog, jdev->nr_funcs,
+					sizeof(xpu_function_catalog_entry),
+					__compareJitFuncCatalog);
+	if (!entry)
+		return false;
+	kexp->fn_dptr = entry->func_dptr;
+	kexp->expr_ops = __gpuservJitLookupTypeOps(jdev, kexp->exptype);
+	if (!kexp->expr_ops)
+		return false;
+
+	/* already validated by __resolveDevicePointersWalker */
+	if (kexp->opcode == FuncOpCode__CaseWhenExpr)
 	{
-		if (kds_src_iovec->nr_chunks == 0)
-			m_kds_src = (CUdeviceptr)kds_src;
-		else
+		if (kexp->u.casewhen.case_comp)
 		{
-			if (!kds_src_pathname)
-			{
-				gpuClientELog(gclient, "GpuScan: arrow file is missing");
-				return;
-			}
-			s_chunk = gpuservLoadKdsArrow(gclient,
-										  kds_src,
-										  kds_src_pathname,
-										  kds_src_iovec,
-										  &npages_direct_read,
-										  &npages_vfs_read);
-			if (!s_chunk)
-				return;
-			m_kds_src = s_chunk->m_devptr;
+			karg = (kern_expression *)
+				((char *)kexp + kexp->u.casewhen.case_comp);
+			if (!__gpuservJitRelinkWalker(jdev, karg))
+				return false;
+		}
+		if (kexp->u.casewhen.case_else)
+		{
+			karg = (kern_expression *)
+				((char *)kexp + kexp->u.casewhen.case_else);
+			if (!__gpuservJitRelinkWalker(jdev, karg))
+				return false;
 		}
 	}
-	else
+	for (i=0, karg = KEXP_FIRST_ARG(kexp);
+		 i < kexp->nr_args;
+		 i++, karg = KEXP_NEXT_ARG(karg))
 	{
-		gpuClientELog(gclient, "unknown GpuScan Source format (%c)",
-					  kds_src->format);
-		return;
+		if (!__gpuservJitRelinkWalker(jdev, karg))
+			return false;
 	}
-	/* inner buffer of GpuJoin */
-	if (gq_buf && gq_buf->m_kmrels)
-	{
-		kern_multirels *h_kmrels = (kern_multirels *)gq_buf->h_kmrels;
+	return true;
+}
 
-		m_kmrels = gq_buf->m_kmrels;
-		num_inner_rels = h_kmrels->num_rels;
-	}
+static bool
+__gpuservJitRelinkSession(gpuJitModuleDevice *jdev,
+						  kern_session_info *session)
+{
+	kern_varslot_desc *kvslot_desc = SESSION_KVARS_SLOT_DESC(session);
+	xpu_encode_info *encode = SESSION_ENCODE(session);
+	kern_expression *__kexp[20];
+	int		nitems = __listupSessionKernExpressions(session, __kexp);
 
-	rc = cuModuleGetFunction(&f_kern_gpuscan,
-							 gcontext->cuda_module,
-							 "kern_gpujoin_main");
-	if (rc != CUDA_SUCCESS)
+	for (int i=0; i < nitems; i++)
 	{
-		gpuClientFatal(gclient, "failed on cuModuleGetFunction: %s",
-					   cuStrError(rc));
-		goto bailout;
+		if (__kexp[i] && !__gpuservJitRelinkWalker(jdev, __kexp[i]))
+			return false;
 	}
-	shmem_dynamic_sz = __KERN_WARP_CONTEXT_BASESZ(session->kcxt_kvecs_ndims);
-	rc = gpuOptimalBlockSize(&grid_sz,
-							 &block_sz,
-							 f_kern_gpuscan,
-							 shmem_dynamic_sz);
-	if (rc != CUDA_SUCCESS)
+	for (int i=0; i < session->kcxt_kvars_nslots; i++)
 	{
-		gpuClientFatal(gclient, "failed on gpuOptimalBlockSize: %s",
-					   cuStrError(rc));
-		goto bailout;
+		kvslot_desc[i].vs_ops =
+			__gpuservJitLookupTypeOps(jdev, kvslot_desc[i].vs_type_code);
+		if (!kvslot_desc[i].vs_ops)
+			return false;
 	}
-//	block_sz = 128;
-//	grid_sz = 1;
-
-	/* allocation of extra shared memory for GpuPreAgg (if any) */
-	shmem_dynamic_sz =
-		__expand_gpupreagg_prepfunc_buffer(session,
-										   grid_sz, block_sz,
-										   shmem_dynamic_sz,
-										   gcontext->gpumain_shmem_sz_dynamic,
-										   &groupby_prepfn_bufsz,
-										   &groupby_prepfn_nbufs);
-	/*
-	 * Allocation of the control structure
-	 */
-	sz = KERN_GPUTASK_LENGTH(session->kcxt_kvecs_ndims,
-							 session->kcxt_kvecs_bufsz,
-							 grid_sz, block_sz);
-	t_chunk = gpuMemAllocManaged(sz);
-	if (!t_chunk)
+	if (encode)
 	{
-		gpuClientFatal(gclient, "failed on gpuMemAllocManaged: %lu", sz);
-		goto bailout;
-	}
-	kgtask = (kern_gputask *)t_chunk->m_devptr;
-	memset(kgtask, 0, offsetof(kern_gputask, stats[num_inner_rels]));
-	kgtask->grid_sz  = grid_sz;
-	kgtask->block_sz = block_sz;
-	kgtask->kvars_nslots = session->kcxt_kvars_nslots;
-	kgtask->kvecs_bufsz  = session->kcxt_kvecs_bufsz;
-	kgtask->kvecs_ndims  = session->kcxt_kvecs_ndims;
-	kgtask->n_rels       = num_inner_rels;
-	kgtask->groupby_prepfn_bufsz = groupby_prepfn_bufsz;
-	kgtask->groupby_prepfn_nbufs = groupby_prepfn_nbufs;
+		xpu_encode_info *catalog = jdev->encode_catalog;
 
-	/* prefetch source KDS, if managed memory */
-	if (!s_chunk && !gc_lmap)
-	{
-		rc = cuMemPrefetchAsync((CUdeviceptr)kds_src,
-								kds_src->length,
-								MY_DEVICE_PER_THREAD,
-								MY_STREAM_PER_THREAD);
-		if (rc != CUDA_SUCCESS)
+		for (int i=0; ; i++)
 		{
-			gpuClientFatal(gclient, "failed on cuMemPrefetchAsync: %s",
-						   cuStrError(rc));
-			goto bailout;
+			if (!catalog[i].enc_mblen || catalog[i].enc_maxlen < 1)
+				return false;
+			if (strcmp(encode->encname, catalog[i].encname) == 0)
+			{
+				encode->enc_mblen = catalog[i].enc_mblen;
+				break;
+			}
 		}
 	}
+	return true;
+}
 
-	/*
-	 * Allocation of the destination buffer
-	 */
-resume_kernel:
-	if (gq_buf && gq_buf->m_kds_final)
+/*
+ * gpuservJitSetupSession
+ *
+ * It returns the runtime-specialized kernel if the JIT module for the
+ * opcode set is ready. Elsewhere, it launches the background build and
+ * returns NULL; the session runs on the interpreter.
+ */
+static CUfunction
+gpuservJitSetupSession(gpuContext *gcontext,
+					   kern_session_info *session,
+					   const uint64_t *opcode_bitmap)
+{
+	gpuJitModule *jit_module;
+	gpuJitModuleDevice *jdev;
+	CUfunction	kern_gpumain = NULL;
+	char		emsg[512];
+
+	jit_module = gpuservJitLookupModule(opcode_bitmap);
+	if (!jit_module || jit_module->status != GPU_JIT_MODULE__READY)
+		return NULL;
+
+	pthreadMutexLock(&gpuserv_jit_module_lock);
+	jdev = &jit_module->devs[gcontext->cuda_dindex];
+	if (jit_module->status == GPU_JIT_MODULE__READY &&
+		(jdev->cuda_module != NULL ||
+		 __gpuservJitLoadModuleDevice(gcontext, jit_module)))
 	{
-		/*
-		 * Suspend of GpuPreAgg kernel means the kds_final buffer is
-		 * almost full, thus GPU kernel wants to expand the buffer.
-		 * It must be done under the exclusive lock.
-		 */
-		if (kgtask->resume_context)
+		if (__gpuservJitRelinkSession(jdev, session))
+			kern_gpumain = jdev->kern_gpumain;
+		else
 		{
-			if (!__expandGpuQueryGroupByBuffer(gq_buf, kds_final_length))
-			{
-				gpuClientFatal(gclient, "unable to expand GpuPreAgg final buffer");
-				goto bailout;
-			}
+			/* revert the device pointers to the core module */
+			__gsLog("unable to relink the session to the JIT module: %s",
+					jit_module->fatbin_path);
+			if (!__resolveDevicePointers(gcontext, session, NULL,
+										 emsg, sizeof(emsg)))
+				__FATAL("failed on __resolveDevicePointers: %s", emsg);
 		}
-		pthreadRWLockReadLock(&gq_buf->m_kds_final_rwlock);
-		kds_dst = (kern_data_store *)gq_buf->m_kds_final;
-		kds_final_length = gq_buf->m_kds_final_length;
-		kds_final_locked = true;
 	}
-	else
+	pthreadMutexUnlock(&gpuserv_jit_module_lock);
+
+	return kern_gpumain;
+}
+
+/*
+ * __gpuservAttachStagingRing
+ *
+ * It maps the staging ring created by the backend, and registers it as
+ * page-locked memory for the asynchronous copy to the device.
+ */
+static bool
+__gpuservAttachStagingRing(gpuClient *gclient,
+						   uint32_t shmem_handle,
+						   char *errmsg, size_t errmsg_sz)
+{
+	xpuStagingRing *ring;
+	int			fdesc;
+	struct stat	stat_buf;
+	char		namebuf[100];
+	size_t		mmap_sz;
+	CUresult	rc;
+
+	snprintf(namebuf, sizeof(namebuf),
+			 ".pgstrom_shmbuf_%u_%d",
+			 PostPortNumber, shmem_handle);
+	fdesc = shm_open(namebuf, O_RDWR, 0600);
+	if (fdesc < 0)
 	{
-		gpuMemChunk	   *d_chunk;
+		snprintf(errmsg, errmsg_sz,
+				 "failed on shm_open('%s'): %m", namebuf);
+		return false;
+	}
+	if (fstat(fdesc, &stat_buf) != 0)
+	{
+		snprintf(errmsg, errmsg_sz,
+				 "failed on fstat('%s'): %m", namebuf);
+		close(fdesc);
+		return false;
+	}
+	mmap_sz = PAGE_ALIGN(stat_buf.st_size);
 
-		sz = KDS_HEAD_LENGTH(kds_dst_head) + PGSTROM_CHUNK_SIZE;
-		d_chunk = gpuMemAllocManaged(sz);
-		if (!d_chunk)
-		{
-			gpuClientFatal(gclient, "failed on gpuMemAllocManaged(%lu)", sz);
-			goto bailout;
-		}
-		kds_dst = (kern_data_store *)d_chunk->m_devptr;
-		memcpy(kds_dst, kds_dst_head, KDS_HEAD_LENGTH(kds_dst_head));
-		kds_dst->length = sz;
-		if (kds_dst_nitems >= kds_dst_nrooms)
-		{
-			kern_data_store	**kds_dst_temp;
-			gpuMemChunk		**d_chunk_temp;
+	ring = mmap(NULL, mmap_sz,
+				PROT_READ | PROT_WRITE,
+				MAP_SHARED,
+				fdesc, 0);
+	close(fdesc);
+	if (ring == MAP_FAILED)
+	{
+		snprintf(errmsg, errmsg_sz,
+				 "failed on mmap('%s', %zu): %m", namebuf, mmap_sz);
+		return false;
+	}
+	if (mmap_sz < XPU_STAGING_RING_LENGTH(ring->nslots) ||
+		ring->slot_sz != XPU_STAGING_RING_SLOTSZ)
+	{
+		snprintf(errmsg, errmsg_sz,
+				 "staging ring '%s' is corrupted", namebuf);
+		munmap(ring, mmap_sz);
+		return false;
+	}
+	gclient->staging_ring = ring;
+	gclient->staging_ring_sz = mmap_sz;
 
-			kds_dst_nrooms = 2 * kds_dst_nrooms + 10;
-			kds_dst_temp = alloca(sizeof(kern_data_store *) * kds_dst_nrooms);
-			d_chunk_temp = alloca(sizeof(gpuMemChunk *) * kds_dst_nrooms);
-			if (kds_dst_nitems > 0)
-			{
-				memcpy(kds_dst_temp, kds_dst_array,
-					   sizeof(kern_data_store *) * kds_dst_nitems);
-				memcpy(d_chunk_temp, d_chunk_array,
-					   sizeof(gpuMemChunk *) * kds_dst_nitems);
-			}
-			kds_dst_array = kds_dst_temp;
-			d_chunk_array = d_chunk_temp;
+	/* works without page-locking, but the copy is not asynchronous */
+	rc = cuMemHostRegister(ring, mmap_sz, CU_MEMHOSTREGISTER_PORTABLE);
+	if (rc == CUDA_SUCCESS)
+		gclient->staging_ring_pinned = true;
+	else
+		__gsDebug("failed on cuMemHostRegister('%s', %zu): %s",
+				  namebuf, mmap_sz, cuStrError(rc));
+	return true;
+}
+
+/*
+ * __gpuservAdmitSession
+ *
+ * A new session waits for the admission, if the GPU device already serves
+ * pg_strom.gpu_admission_max_sessions sessions, or the sum of memory quota
+ * of the active sessions exceeds the hard-limit of the memory pool.
+ * It does not fail the session, but delays it.
+ */
+static bool
+__gpuservAdmitSession(gpuClient *gclient, kern_session_info *session)
+{
+	gpuContext *gcontext = gclient->gcontext;
+	gpuServSharedState *gs_state = gpuserv_shared_state;
+	gpuSessionInfoSlot *sinfo = NULL;
+	uint64_t	hard_limit = gcontext->pool_raw.hard_limit;
+	uint64_t	mem_quota = Min(session->gpu_mem_quota, hard_limit);
+	struct timeval tv1, tv2;
+
+	gettimeofday(&tv1, NULL);
+	pthreadMutexLock(&gcontext->admission_lock);
+	while (gcontext->num_active_sessions > 0 &&
+		   ((pgstrom_gpu_admission_max_sessions > 0 &&
+			 gcontext->num_active_sessions >= pgstrom_gpu_admission_max_sessions) ||
+			gcontext->reserved_mem_quota + mem_quota > hard_limit))
+	{
+		if (gpuServiceGoingTerminate())
+		{
+			pthreadMutexUnlock(&gcontext->admission_lock);
+			gpuClientELog(gclient, "GPU service is going to terminate");
+			return false;
 		}
-		kds_dst_array[kds_dst_nitems] = kds_dst;
-		d_chunk_array[kds_dst_nitems] = d_chunk;
-		kds_dst_nitems++;
+		pthreadCondWaitTimeout(&gcontext->admission_cond,
+							   &gcontext->admission_lock, 1000);
 	}
+	gcontext->num_active_sessions++;
+	gcontext->reserved_mem_quota += mem_quota;
+	gclient->admitted = true;
+	pthreadMutexUnlock(&gcontext->admission_lock);
+	gettimeofday(&tv2, NULL);
 
 	/*
-	 * Launch kernel
+	 * assign a slot of the gpu_session_info; backend_pid of the remote
+	 * client is not a process on this host, so it uses the local one.
 	 */
-	kern_args[0] = &gclient->session;
-	kern_args[1] = &kgtask;
-	kern_args[2] = &m_kmrels;
-	kern_args[3] = &m_kds_src;
-	kern_args[4] = &m_kds_extra;
-	kern_args[5] = &kds_dst;
-
-	rc = cuLaunchKernel(f_kern_gpuscan,
-						grid_sz, 1, 1,
-						block_sz, 1, 1,
-						shmem_dynamic_sz,
-						MY_STREAM_PER_THREAD,
-						kern_args,
-						NULL);
-	if (rc != CUDA_SUCCESS)
+	for (int i=0; !gclient->is_remote && i < GPU_SESSION_INFO_NSLOTS; i++)
 	{
-		gpuClientFatal(gclient, "failed on cuLaunchKernel: %s", cuStrError(rc));
-		goto bailout;
+		uint32_t	expected = 0;
+
+		if (pg_atomic_compare_exchange_u32(&gs_state->session_info[i].backend_pid,
+										   &expected, UINT_MAX))
+		{
+			sinfo = &gs_state->session_info[i];
+			break;
+		}
 	}
+	if (!sinfo)
+		sinfo = &gclient->__sinfo_local;
+	sinfo->cuda_dindex = gcontext->cuda_dindex;
+	sinfo->plan_node_id = session->pgsql_plan_node_id;
+	sinfo->mem_quota = mem_quota;
+	pg_atomic_init_u64(&sinfo->mem_usage, 0);
+	pg_atomic_init_u64(&sinfo->mem_peak, 0);
+	sinfo->admission_wait = ((tv2.tv_sec  - tv1.tv_sec) * 1000000L +
+							 (tv2.tv_usec - tv1.tv_usec));
+	pg_atomic_write_u32(&sinfo->backend_pid, session->pgsql_backend_pid);
+	gclient->sinfo = sinfo;
 
-	rc = cuEventRecord(MY_EVENT_PER_THREAD, MY_STREAM_PER_THREAD);
-	if (rc != CUDA_SUCCESS)
+	return true;
+}
+
+static void
+__gpuservReleaseSession(gpuClient *gclient)
+{
+	gpuContext *gcontext = gclient->gcontext;
+
+	if (gclient->admitted)
 	{
-		gpuClientFatal(gclient, "failed on cuEventRecord: %s", cuStrError(rc));
-		goto bailout;
+		pthreadMutexLock(&gcontext->admission_lock);
+		Assert(gcontext->num_active_sessions > 0);
+		gcontext->num_active_sessions--;
+		gcontext->reserved_mem_quota -= gclient->sinfo->mem_quota;
+		pthreadCondBroadcast(&gcontext->admission_cond);
+		pthreadMutexUnlock(&gcontext->admission_lock);
+		gclient->admitted = false;
+	}
+	if (gclient->sinfo)
+	{
+		pg_atomic_write_u32(&gclient->sinfo->backend_pid, 0);
+		gclient->sinfo = NULL;
 	}
+}
 
-	/* point of synchronization */
-	rc = cuEventSynchronize(MY_EVENT_PER_THREAD);
-	if (rc != CUDA_SUCCESS)
+static bool
+gpuservHandleOpenSession(gpuClient *gclient, XpuCommand *xcmd)
+{
+	gpuContext	   *gcontext = gclient->gcontext;
+	kern_session_info *session = &xcmd->u.session;
+	XpuCommand		resp;
+	char			emsg[512];
+	struct iovec	iov;
+	uint64_t		opcode_bitmap[GPU_JIT_OPCODE_NWORDS];
+
+	if (gclient->session)
 	{
-		gpuClientFatal(gclient, "failed on cuEventSynchronize: %s", cuStrError(rc));
-		goto bailout;
+		gpuClientELog(gclient, "OpenSession is called twice");
+		return false;
 	}
-	/* unlock kds_final buffer */
-	if (kds_final_locked)
+	/*
+	 * The remote client cannot share the host resources (DSM segment of the
+	 * inner buffer, pinned staging ring) with GPU service. query_plan_id is
+	 * built on the backend's PID, so it is mixed with the peer address to
+	 * avoid conflicts of the query buffers between the database nodes.
+	 */
+	if (gclient->is_remote)
 	{
-		pthreadRWLockUnlock(&gq_buf->m_kds_final_rwlock);
-		kds_final_locked = false;
+		if (session->join_inner_handle != 0 ||
+			session->staging_ring_handle != 0)
+		{
+			gpuClientELog(gclient, "GPU%d: remote session cannot use %s",
+						  gcontext->cuda_dindex,
+						  session->join_inner_handle != 0
+						  ? "the inner buffer on the shared memory"
+						  : "the pinned staging ring");
+			return false;
+		}
+		session->query_plan_id ^= gclient->remote_peer_key;
 	}
+	/* admission control */
+	if (!__gpuservAdmitSession(gclient, session))
+		return false;
+	/* expand CUDA thread stack limit on demand */
+	if (!expandCudaStackLimit(gclient, session))
+		return false;
 
-	/* status check */
-	if (kgtask->kerror.errcode == ERRCODE_STROM_SUCCESS)
+	/* resolve device pointers */
+	memset(opcode_bitmap, 0, sizeof(opcode_bitmap));
+	if (session->jit_kernels
+		? !__resolveDevicePointers(gcontext, session,
+								   opcode_bitmap,
+								   emsg, sizeof(emsg))
+		: !__resolveDevicePointersCached(gcontext, session,
+										 xcmd->length - offsetof(XpuCommand, u.session),
+										 emsg, sizeof(emsg)))
 	{
-		XpuCommand *resp;
-		size_t		resp_sz;
+		gpuClientELog(gclient, "%s", emsg);
+		return false;
+	}
+	/* pinned host staging ring, if any */
+	if (session->staging_ring_handle != 0 &&
+		!__gpuservAttachStagingRing(gclient, session->staging_ring_handle,
+									emsg, sizeof(emsg)))
+	{
+		gpuClientELog(gclient, "%s", emsg);
+		return false;
+	}
+	/* runtime-specialized kernels, if available */
+	if (session->jit_kernels)
+		gclient->jit_kern_gpumain = gpuservJitSetupSession(gcontext, session,
+														   opcode_bitmap);
+	if (session->join_inner_handle != 0 ||
+		(session->groupby_kds_final != 0 && !session->groupby_streaming) ||
+		session->gpuwin_desc != 0)
+	{
+		kern_data_store *kds_final_head = NULL;
 
-		if (kgtask->suspend_count > 0)
+		/* streaming GpuPreAgg has kds_final for each task */
+		if (session->groupby_kds_final != 0 && !session->groupby_streaming)
 		{
-			if (gpuServiceGoingTerminate())
-			{
-				gpuClientFatal(gclient, "GpuService is going to terminate during GpuScan kernel suspend/resume");
-				goto bailout;
-			}
-			/* restore warp context from the previous state */
-			kgtask->resume_context = true;
-			kgtask->suspend_count = 0;
-			__gsDebug("suspend / resume happen\n");
-			if (kds_final_locked)
-				pthreadRWLockUnlock(&gq_buf->m_kds_final_rwlock);
-			goto resume_kernel;
+			kds_final_head = (kern_data_store *)
+				((char *)session + session->groupby_kds_final);
 		}
-		/* send back status and kds_dst */
-		resp_sz = MAXALIGN(offsetof(XpuCommand,
-									u.results.stats[num_inner_rels]));
-		resp = alloca(resp_sz);
-		memset(resp, 0, resp_sz);
-		resp->magic = XpuCommandMagicNumber;
-		resp->tag   = XpuCommandTag__Success;
-		resp->u.results.chunks_nitems = kds_dst_nitems;
-		resp->u.results.chunks_offset = resp_sz;
-		resp->u.results.npages_direct_read = npages_direct_read;
-		resp->u.results.npages_vfs_read = npages_vfs_read;
-		resp->u.results.nitems_raw = kgtask->nitems_raw;
-		resp->u.results.nitems_in  = kgtask->nitems_in;
-		resp->u.results.nitems_out = kgtask->nitems_out;
-		resp->u.results.num_rels = num_inner_rels;
-		for (int i=0; i < num_inner_rels; i++)
+		gclient->gq_buf = getGpuQueryBuffer(gcontext,
+											session,
+											session->query_plan_id,
+											session->join_inner_handle,
+											session->join_inner_multi_gpu,
+											session->join_inner_fingerprint,
+											session->join_inner_digest,
+											kds_final_head,
+											emsg, sizeof(emsg));
+		if (!gclient->gq_buf)
 		{
-			resp->u.results.stats[i].nitems_gist = kgtask->stats[i].nitems_gist;
-			resp->u.results.stats[i].nitems_out  = kgtask->stats[i].nitems_out;
+			gpuClientELog(gclient, "%s", emsg);
+			return false;
 		}
-		gpuClientWriteBack(gclient,
-						   resp, resp_sz,
-						   kds_dst_nitems, kds_dst_array);
 	}
-	else if (kgtask->kerror.errcode == ERRCODE_CPU_FALLBACK)
+	gclient->session = session;
+	/*
+	 * host-mapped abort flag for the running kernels; the session works
+	 * without cooperative abort if not available.
+	 */
+	if (!gclient->abort_flag)
 	{
-		kern_data_store *__kds_src = kds_src;
-		XpuCommand	resp;
+		void	   *abort_flag;
+		CUresult	rc;
 
-		/*
-		 * Send back the source buffer with XpuCommandTag__CPUFallback
-		 *
-		 * KDS_FORMAT_BLOCK and KDS_FORMAT_ARROW must be send back the
-		 * backend process from the GPU device buffer, because the original
-		 * kds_src does not have data contents itself.
-		 * For KDS_FORMAT_COLUMN, it is equivalent to the kernel buffer,
-		 * and its size tends to be large. So, CPU fallback uses regular
-		 * heap-scan instead.
-		 */
-		if (s_chunk)
+		rc = cuMemHostAlloc(&abort_flag, sizeof(uint32_t),
+							CU_MEMHOSTALLOC_PORTABLE |
+							CU_MEMHOSTALLOC_DEVICEMAP);
+		if (rc != CUDA_SUCCESS)
+			__gsDebug("failed on cuMemHostAlloc: %s", cuStrError(rc));
+		else
 		{
-			__kds_src = malloc(s_chunk->__length);
-			if (!__kds_src)
+			*((uint32_t *)abort_flag) = (gclient->task_cancelled ? 1 : 0);
+			rc = cuMemHostGetDevicePointer(&gclient->m_abort_flag, abort_flag, 0);
+			if (rc != CUDA_SUCCESS)
 			{
-				gpuClientELog(gclient, "out of memory for CPU fallback (sz=%lu)",
-							  s_chunk->__length);
-				goto bailout;
+				__gsDebug("failed on cuMemHostGetDevicePointer: %s",
+						  cuStrError(rc));
+				cuMemFreeHost(abort_flag);
 			}
-			rc = cuMemcpyDtoH(__kds_src, s_chunk->m_devptr, s_chunk->__length);
-			if (rc != CUDA_SUCCESS)
+			else
 			{
-				free(__kds_src);
-				gpuClientELog(gclient, "failed on cuMemcpyDtoH: %s", cuStrError(rc));
-				goto bailout;
+				pg_memory_barrier();
+				gclient->abort_flag = abort_flag;
 			}
 		}
-		memset(&resp, 0, sizeof(resp));
-		resp.magic = XpuCommandMagicNumber;
-		resp.tag   = XpuCommandTag__CPUFallback;
-		memcpy(&resp.u.fallback.error,
-			   &kgtask->kerror,
-			   sizeof(kern_errorbuf));
-		resp.u.fallback.npages_direct_read = npages_direct_read;
-		resp.u.fallback.npages_vfs_read = npages_vfs_read;
-		gpuClientWriteBack(gclient,
-						   &resp,
-						   offsetof(XpuCommand, u.fallback.kds_src),
-						   1, &__kds_src);
-		if (kds_src != __kds_src)
-			free(__kds_src);
-	}
-	else
-	{
-		/* send back error status */
-		__gpuClientELogRaw(gclient, &kgtask->kerror);
 	}
-bailout:
-	if (kds_final_locked)
-		pthreadRWLockUnlock(&gq_buf->m_kds_final_rwlock);
-	if (s_chunk)
-		gpuMemFree(s_chunk);
-	if (t_chunk)
-		gpuMemFree(t_chunk);
-	while (kds_dst_nitems > 0)
-		gpuMemFree(d_chunk_array[--kds_dst_nitems]);
-	if (gc_lmap)
-		gpuCachePutDeviceBuffer(gc_lmap);
+	/* execution trace of the session, if any */
+	if (session->gpu_trace &&
+		pgstrom_gpu_trace_directory &&
+		*pgstrom_gpu_trace_directory != '\0')
+		gclient->trace = __gpuTraceCreate();
+
+	/* success status */
+	memset(&resp, 0, sizeof(resp));
+	resp.magic = XpuCommandMagicNumber;
+	resp.tag = XpuCommandTag__Success;
+	resp.length = offsetof(XpuCommand, u.results.stats);
+
+	iov.iov_base = &resp;
+	iov.iov_len  = resp.length;
+	__gpuClientWriteBack(gclient, &iov, 1);
+
+	return true;
 }
 
-/* ------------------------------------------------------------
+/* ----------------------------------------------------------------
  *
- * gpuservGpuCacheManager - GpuCache worker
+ * gpuservLoadKdsXXXX - Load data chunks using GPU-Direct SQL
  *
- * ------------------------------------------------------------
+ * ----------------------------------------------------------------
  */
-static void *
-gpuservGpuCacheManager(void *__arg)
+/*
+ * gpuClientMemAlloc
+ *
+ * allocation of the device memory charged to the session; it fails if the
+ * session already consumes pg_strom.gpu_mem_quota.
+ */
+static gpuMemChunk *
+gpuClientMemAlloc(gpuClient *gclient, size_t bytesize, bool stream_ordered)
 {
-	gpuWorker  *gworker = (gpuWorker *)__arg;
-	gpuContext *gcontext = gworker->gcontext;
-	CUresult	rc;
+	gpuSessionInfoSlot *sinfo = gclient->sinfo;
+	gpuMemChunk *chunk;
+	uint64_t	usage;
+	uint64_t	peak;
+
+	if (!sinfo)
+		return (stream_ordered
+				? gpuMemAllocStreamOrdered(bytesize)
+				: gpuMemAlloc(bytesize));
+	usage = pg_atomic_read_u64(&sinfo->mem_usage);
+	if (sinfo->mem_quota > 0 &&
+		usage + PAGE_ALIGN(bytesize) > sinfo->mem_quota)
+	{
+		gpuClientELog(gclient, "GPU memory quota exceeded (usage: %lu, required: %zu, quota: %lu)",
+					  usage, bytesize, sinfo->mem_quota);
+		return NULL;
+	}
+	chunk = (stream_ordered
+			 ? gpuMemAllocStreamOrdered(bytesize)
+			 : gpuMemAlloc(bytesize));
+	if (!chunk)
+	{
+		gpuClientELog(gclient, "failed on gpuMemAlloc(%zu)", bytesize);
+		return NULL;
+	}
+	chunk->owner = sinfo;
+	usage = pg_atomic_add_fetch_u64(&sinfo->mem_usage, chunk->__length);
+	peak = pg_atomic_read_u64(&sinfo->mem_peak);
+	while (usage > peak)
+	{
+		if (pg_atomic_compare_exchange_u64(&sinfo->mem_peak, &peak, usage))
+			break;
+	}
+	return chunk;
+}
 
-	rc = cuCtxSetCurrent(gcontext->cuda_context);
+/*
+ * __gpuservLoadSharedBuffers
+ *
+ * It loads the pages on the shared buffers; pinned by the backend, to the
+ * device memory by DMA from the registered host memory. The consecutive
+ * buffers are coalesced to a copy. Then, the page heads captured by the
+ * backend are written over the pages.
+ */
+static bool
+__gpuservLoadSharedBuffers(gpuClient *gclient,
+						   CUdeviceptr m_pages,
+						   const kern_shbuf_vector *shbufs,
+						   CUstream stream)
+{
+	CUDA_MEMCPY2D	m2d;
+	CUresult		rc;
+	uint32_t		i, j;
+
+	if (!gpuserv_shared_state->shared_buffers_dma)
+	{
+		gpuClientELog(gclient, "shared buffers are not registered for DMA");
+		return false;
+	}
+	for (i=0; i < shbufs->nitems; i = j)
+	{
+		int32_t		buf_id = shbufs->buf_id[i];
+
+		if (buf_id < 0 || buf_id >= NBuffers)
+		{
+			gpuClientELog(gclient, "invalid buffer id (%d)", buf_id);
+			return false;
+		}
+		for (j=i+1; j < shbufs->nitems; j++)
+		{
+			if (shbufs->buf_id[j] != buf_id + (j - i))
+				break;
+		}
+		if (stream)
+			rc = cuMemcpyHtoDAsync(m_pages + (size_t)i * BLCKSZ,
+								   BufferBlocks + (size_t)buf_id * BLCKSZ,
+								   (size_t)(j - i) * BLCKSZ,
+								   stream);
+		else
+			rc = cuMemcpyHtoD(m_pages + (size_t)i * BLCKSZ,
+							  BufferBlocks + (size_t)buf_id * BLCKSZ,
+							  (size_t)(j - i) * BLCKSZ);
+		if (rc != CUDA_SUCCESS)
+		{
+			gpuClientELog(gclient, "failed on cuMemcpyHtoD: %s", cuStrError(rc));
+			return false;
+		}
+	}
+	memset(&m2d, 0, sizeof(CUDA_MEMCPY2D));
+	m2d.srcMemoryType = CU_MEMORYTYPE_HOST;
+	m2d.srcHost       = KDS_SHBUF_HEADS(shbufs);
+	m2d.srcPitch      = KDS_SHBUF_HEAD_SZ;
+	m2d.dstMemoryType = CU_MEMORYTYPE_DEVICE;
+	m2d.dstDevice     = m_pages;
+	m2d.dstPitch      = BLCKSZ;
+	m2d.WidthInBytes  = KDS_SHBUF_HEAD_SZ;
+	m2d.Height        = shbufs->nitems;
+	if (stream)
+		rc = cuMemcpy2DAsync(&m2d, stream);
+	else
+		rc = cuMemcpy2D(&m2d);
 	if (rc != CUDA_SUCCESS)
-		__FATAL("failed on cuCtxSetCurrent: %s", cuStrError(rc));
+	{
+		gpuClientELog(gclient, "failed on cuMemcpy2D: %s", cuStrError(rc));
+		return false;
+	}
+	return true;
+}
 
-	GpuWorkerCurrentContext	= gcontext;
-	MY_DINDEX_PER_THREAD	= gcontext->cuda_dindex;
-	MY_DEVICE_PER_THREAD	= gcontext->cuda_device;
-	MY_CONTEXT_PER_THREAD	= gcontext->cuda_context;
-	MY_STREAM_PER_THREAD	= CU_STREAM_LEGACY;
-	MY_EVENT_PER_THREAD		= NULL;
-	pg_memory_barrier();
+static gpuMemChunk *
+__gpuservLoadKdsCommon(gpuClient *gclient,
+					   kern_data_store *kds,
+					   size_t base_offset,
+					   const char *pathname,
+					   strom_io_vector *kds_iovec,
+					   const kern_shbuf_vector *shbufs,
+					   uint32_t *p_npages_direct_read,
+					   uint32_t *p_npages_vfs_read)
+{
+	gpuMemChunk *chunk;
+	CUresult	rc;
+	off_t		off = PAGE_ALIGN(base_offset);
+	size_t		gap = off - base_offset;
+	size_t		host_length = base_offset;
 
-	__gsDebug("GPU-%d GpuCache manager thread launched.",
-			  MY_DINDEX_PER_THREAD);
-	
-	gpucacheManagerEventLoop(gcontext->cuda_dindex,
-							 gcontext->cuda_context,
-							 gcontext->cuda_module);
+	chunk = gpuClientMemAlloc(gclient, gap + kds->length, false);
+	if (!chunk)
+		return NULL;
+	chunk->m_devptr = chunk->__base + chunk->__offset + gap;
+	/* pages on the shared buffers are not on the command buffer */
+	if (shbufs)
+		host_length -= (size_t)shbufs->nitems * BLCKSZ;
 
-	/* delete gpuWorker from the gpuContext */
-	pthreadMutexLock(&gcontext->worker_lock);
-	dlist_delete(&gworker->chain);
-	pthreadMutexUnlock(&gcontext->worker_lock);
-	free(gworker);
+	if (MY_LOAD_STREAM_PER_THREAD)
+	{
+		/*
+		 * Asynchronous load on the load stream; the worker stream waits for
+		 * the completion at the device side, so the preparation of the task
+		 * on the host side is overlapped with the storage I/O.
+		 * The error code is checked after the kernel synchronization.
+		 */
+		rc = cuMemcpyHtoDAsync(chunk->m_devptr, kds, host_length,
+							   MY_LOAD_STREAM_PER_THREAD);
+		if (rc != CUDA_SUCCESS)
+		{
+			gpuClientELog(gclient, "failed on cuMemcpyHtoDAsync: %s", cuStrError(rc));
+			goto error;
+		}
+		if (shbufs &&
+			!__gpuservLoadSharedBuffers(gclient,
+										chunk->m_devptr + host_length,
+										shbufs,
+										MY_LOAD_STREAM_PER_THREAD))
+			goto error;
+		MY_LOAD_ERRCODE_PER_THREAD = 0;
+		if (pathname &&
+			!gpuDirectFileReadAsyncIOV(pathname,
+									   chunk->__base,
+									   chunk->__offset + off,
+									   chunk->mseg->iomap_handle,
+									   kds_iovec,
+									   MY_LOAD_STREAM_PER_THREAD,
+									   &MY_LOAD_ERRCODE_PER_THREAD,
+									   p_npages_direct_read,
+									   p_npages_vfs_read))
+		{
+			gpuClientELogByExtraModule(gclient);
+			goto error;
+		}
+		rc = cuEventRecord(MY_LOAD_EVENT_PER_THREAD,
+						   MY_LOAD_STREAM_PER_THREAD);
+		if (rc != CUDA_SUCCESS)
+		{
+			gpuClientELog(gclient, "failed on cuEventRecord: %s", cuStrError(rc));
+			goto error;
+		}
+		rc = cuStreamWaitEvent(MY_STREAM_PER_THREAD,
+							   MY_LOAD_EVENT_PER_THREAD, 0);
+		if (rc != CUDA_SUCCESS)
+		{
+			gpuClientELog(gclient, "failed on cuStreamWaitEvent: %s", cuStrError(rc));
+			goto error;
+		}
+		return chunk;
+	}
+	rc = cuMemcpyHtoD(chunk->m_devptr, kds, host_length);
+	if (rc != CUDA_SUCCESS)
+	{
+		gpuClientELog(gclient, "failed on cuMemcpyHtoD: %s", cuStrError(rc));
+		goto error;
+	}
+	if (shbufs &&
+		!__gpuservLoadSharedBuffers(gclient,
+									chunk->m_devptr + host_length,
+									shbufs,
+									NULL))
+		goto error;
+	if (pathname &&
+		!gpuDirectFileReadIOV(pathname,
+							  chunk->__base,
+							  chunk->__offset + off,
+							  chunk->mseg->iomap_handle,
+							  kds_iovec,
+							  p_npages_direct_read,
+							  p_npages_vfs_read))
+	{
+		gpuClientELogByExtraModule(gclient);
+		goto error;
+	}
+	return chunk;
 
-	__gsDebug("GPU-%d GpuCache manager terminated.",
-			  MY_DINDEX_PER_THREAD);
+error:
+	/* in-flight DMA must be completed prior to release */
+	if (MY_LOAD_STREAM_PER_THREAD)
+		cuStreamSynchronize(MY_LOAD_STREAM_PER_THREAD);
+	gpuMemFree(chunk);
 	return NULL;
 }
 
-/* ----------------------------------------------------------------
- *
- * gpuservHandleGpuTaskFinal
- *
- * ----------------------------------------------------------------
- */
-static void
-gpuservHandleGpuTaskFinal(gpuClient *gclient, XpuCommand *xcmd)
+/*
+ * gpuservLoadKdsStaged
+ *
+ * copy the kds_src on the staging ring to the device memory
+ */
+static gpuMemChunk *
+gpuservLoadKdsStaged(gpuClient *gclient,
+					 kern_data_store *kds)
+{
+	gpuMemChunk *chunk;
+	CUresult	rc;
+
+	/* no GPU-Direct SQL here, so stream-ordered memory pool is available */
+	chunk = gpuClientMemAlloc(gclient, kds->length, true);
+	if (!chunk)
+		return NULL;
+	rc = cuMemcpyHtoDAsync(chunk->m_devptr, kds, kds->length,
+						   MY_STREAM_PER_THREAD);
+	if (rc != CUDA_SUCCESS)
+	{
+		gpuClientELog(gclient, "failed on cuMemcpyHtoDAsync: %s",
+					  cuStrError(rc));
+		gpuMemFree(chunk);
+		return NULL;
+	}
+	return chunk;
+}
+
+/*
+ * gpuservLoadKdsBlock
+ *
+ * fill up KDS_FORMAT_BLOCK using GPU-Direct
+ */
+static gpuMemChunk *
+gpuservLoadKdsBlock(gpuClient *gclient,
+					kern_data_store *kds,
+					const char *pathname,
+					strom_io_vector *kds_iovec,
+					const kern_shbuf_vector *shbufs,
+					uint32_t *p_npages_direct_read,
+					uint32_t *p_npages_vfs_read)
+{
+	size_t		base_offset;
+
+	Assert(kds->format == KDS_FORMAT_BLOCK);
+	base_offset = kds->block_offset + kds->block_nloaded * BLCKSZ;
+	return __gpuservLoadKdsCommon(gclient,
+								  kds,
+								  base_offset,
+								  pathname,
+								  kds_iovec,
+								  shbufs,
+								  p_npages_direct_read,
+								  p_npages_vfs_read);
+}
+
+/*
+ * gpuservLoadKdsArrow
+ *
+ * fill up KDS_FORMAT_ARROW using GPU-Direct
+ */
+static gpuMemChunk *
+gpuservLoadKdsArrow(gpuClient *gclient,
+					kern_data_store *kds,
+					const char *pathname,
+					strom_io_vector *kds_iovec,
+					uint32_t *p_npages_direct_read,
+					uint32_t *p_npages_vfs_read)
+{
+	size_t		base_offset;
+
+	Assert(kds->format == KDS_FORMAT_ARROW);
+	base_offset = KDS_HEAD_LENGTH(kds);
+	return __gpuservLoadKdsCommon(gclient,
+								  kds,
+								  base_offset,
+								  pathname,
+								  kds_iovec,
+								  NULL,
+								  p_npages_direct_read,
+								  p_npages_vfs_read);
+}
+
+/* ----------------------------------------------------------------
+ *
+ * gpuservHandleGpuTaskExec
+ *
+ * ----------------------------------------------------------------
+ */
+
+/*
+ * __gpuservRemoteArrowFileIsAllowed
+ *
+ * It resolves the pathname of the arrow file from the remote client, then
+ * checks whether it is located under pg_strom.gpuserv_remote_arrow_dir.
+ * The resolved pathname (PATH_MAX bytes) shall be used to read the file.
+ */
+static bool
+__gpuservRemoteArrowFileIsAllowed(const char *pathname, char *resolved)
+{
+	const char *dir = gpuserv_remote_arrow_dir;
+	size_t		len;
+
+	if (!dir || !realpath(pathname, resolved))
+		return false;
+	len = strlen(dir);
+	return (strncmp(resolved, dir, len) == 0 &&
+			(dir[len-1] == '/' || resolved[len] == '/'));
+}
+
+static unsigned int
+__expand_gpupreagg_prepfunc_buffer(kern_session_info *session,
+								   int grid_sz, int block_sz,
+								   unsigned int __shmem_dynamic_sz,
+								   unsigned int shmem_dynamic_limit,
+								   unsigned int *p_groupby_prepfn_bufsz,
+								   unsigned int *p_groupby_prepfn_nbufs)
+{
+	unsigned int	shmem_dynamic_sz = TYPEALIGN(1024, __shmem_dynamic_sz);
+
+	if (session->groupby_prepfn_bufsz == 0 || shmem_dynamic_sz >= shmem_dynamic_limit)
+		goto no_prepfunc_buffer;
+
+	if (session->xpucode_groupby_keyhash &&
+		session->xpucode_groupby_keyload &&
+		session->xpucode_groupby_keycomp)
+	{
+		/* GROUP-BY */
+		int		num_buffers = 2 * session->groupby_ngroups_estimation + 100;
+		int		prepfn_usage = session->groupby_prepfn_bufsz * num_buffers;
+
+		if (shmem_dynamic_sz + prepfn_usage > shmem_dynamic_limit)
+		{
+			/* adjust num_buffers, if too large */
+			num_buffers = (shmem_dynamic_limit -
+						   shmem_dynamic_sz) / session->groupby_prepfn_bufsz;
+			prepfn_usage = session->groupby_prepfn_bufsz * num_buffers;
+		}
+		Assert(shmem_dynamic_sz + prepfn_usage <= shmem_dynamic_limit);
+		if (num_buffers >= 32)
+		{
+			*p_groupby_prepfn_bufsz = session->groupby_prepfn_bufsz;
+			*p_groupby_prepfn_nbufs = num_buffers;
+			return shmem_dynamic_sz + prepfn_usage;
+		}
+	}
+	else if (session->xpucode_groupby_actions)
+	{
+		/* NO-GROUPS */
+		if (shmem_dynamic_sz + session->groupby_prepfn_bufsz <= shmem_dynamic_limit)
+		{
+			*p_groupby_prepfn_bufsz = session->groupby_prepfn_bufsz;
+			*p_groupby_prepfn_nbufs = 1;
+			return shmem_dynamic_sz + session->groupby_prepfn_bufsz;
+		}
+	}
+no_prepfunc_buffer:
+	*p_groupby_prepfn_bufsz = 0;
+	*p_groupby_prepfn_nbufs = 0;
+	return __shmem_dynamic_sz;		/* unaligned original size */
+}
+
+/*
+ * __gpuservGpuSortTopK
+ *
+ * It prunes the result chunks to the first session->gpusort_limit rows
+ * (and ties), according to the sort key. The survived rows are copied to
+ * a new chunk, to reduce the amount of DMA and host-side sorting.
+ * If d_chunk_array[i] is NULL, kds_dst_array[i] is not released here;
+ * e.g, GpuPreAgg's kds_final is owned by the gpuQueryBuffer.
+ */
+static bool
+__gpuservGpuSortTopK(gpuClient *gclient,
+					 int kds_dst_nitems,
+					 kern_data_store **kds_dst_array,
+					 gpuMemChunk **d_chunk_array)
+{
+	gpuContext	   *gcontext = gclient->gcontext;
+	kern_session_info *session = gclient->session;
+	CUfunction		f_kern_topk;
+	CUresult		rc;
+	int				grid_sz;
+	int				block_sz;
+	void		   *kern_args[3];
+
+	rc = cuModuleGetFunction(&f_kern_topk,
+							 gcontext->cuda_module,
+							 "kern_gpusort_topk");
+	if (rc != CUDA_SUCCESS)
+	{
+		gpuClientFatal(gclient, "failed on cuModuleGetFunction: %s",
+					   cuStrError(rc));
+		return false;
+	}
+	rc = gpuOptimalBlockSize(&grid_sz,
+							 &block_sz,
+							 f_kern_topk, 0);
+	if (rc != CUDA_SUCCESS)
+	{
+		gpuClientFatal(gclient, "failed on gpuOptimalBlockSize: %s",
+					   cuStrError(rc));
+		return false;
+	}
+
+	for (int i=0; i < kds_dst_nitems; i++)
+	{
+		kern_data_store *kds_src = kds_dst_array[i];
+		kern_data_store *kds_topk;
+		gpuMemChunk	   *chunk;
+		size_t			sz;
+
+		if (kds_src->nitems <= session->gpusort_limit)
+			continue;
+		sz = (KDS_HEAD_LENGTH(kds_src) +
+			  MAXALIGN(sizeof(uint32_t) * kds_src->nitems) +
+			  __kds_unpack(kds_src->usage));
+		chunk = gpuMemAllocManaged(sz);
+		if (!chunk)
+		{
+			gpuClientFatal(gclient, "failed on gpuMemAllocManaged(%lu)", sz);
+			return false;
+		}
+		kds_topk = (kern_data_store *)chunk->m_devptr;
+		memcpy(kds_topk, kds_src, KDS_HEAD_LENGTH(kds_src));
+		kds_topk->length = sz;
+		kds_topk->format = KDS_FORMAT_ROW;
+		kds_topk->hash_nslots = 0;
+
+		kern_args[0] = &gclient->session;
+		kern_args[1] = &kds_src;
+		kern_args[2] = &kds_topk;
+		rc = cuLaunchKernel(f_kern_topk,
+							1, 1, 1,
+							block_sz, 1, 1,
+							0,
+							MY_STREAM_PER_THREAD,
+							kern_args,
+							NULL);
+		if (rc != CUDA_SUCCESS)
+		{
+			gpuMemFree(chunk);
+			gpuClientFatal(gclient, "failed on cuLaunchKernel: %s", cuStrError(rc));
+			return false;
+		}
+		rc = cuEventRecord(MY_EVENT_PER_THREAD, MY_STREAM_PER_THREAD);
+		if (rc == CUDA_SUCCESS)
+			rc = cuEventSynchronize(MY_EVENT_PER_THREAD);
+		if (rc != CUDA_SUCCESS)
+		{
+			gpuMemFree(chunk);
+			gpuClientFatal(gclient, "failed on cuEventSynchronize: %s", cuStrError(rc));
+			return false;
+		}
+		/* replace the result chunk */
+		if (d_chunk_array[i])
+			gpuMemFree(d_chunk_array[i]);
+		d_chunk_array[i] = chunk;
+		kds_dst_array[i] = kds_topk;
+	}
+	return true;
+}
+
+/*
+ * __gpuservGpuWindowSaveChunks
+ *
+ * GpuWindow needs all the result rows at once, so the result chunks are
+ * kept in the per-query buffer until XpuTaskFinal. Unused portion of the
+ * chunks are compacted to save the device memory.
+ */
+static bool
+__gpuservGpuWindowSaveChunks(gpuClient *gclient,
+							 gpuQueryBuffer *gq_buf,
+							 int kds_dst_nitems,
+							 kern_data_store **kds_dst_array,
+							 gpuMemChunk **d_chunk_array)
+{
+	for (int i=0; i < kds_dst_nitems; i++)
+	{
+		kern_data_store *kds = kds_dst_array[i];
+		gpuMemChunk	   *chunk = d_chunk_array[i];
+		size_t			sz1, sz2;
+
+		if (kds->nitems == 0)
+		{
+			gpuMemFree(chunk);
+			d_chunk_array[i] = NULL;
+			continue;
+		}
+		sz1 = (KDS_HEAD_LENGTH(kds) +
+			   MAXALIGN(sizeof(uint32_t) * kds->nitems));
+		sz2 = __kds_unpack(kds->usage);
+		if (sz1 + sz2 < kds->length)
+		{
+			gpuMemChunk *c_chunk = gpuMemAllocManaged(sz1 + sz2);
+			CUresult	rc;
+
+			if (!c_chunk)
+			{
+				gpuClientFatal(gclient, "failed on gpuMemAllocManaged(%lu)",
+							   sz1 + sz2);
+				return false;
+			}
+			rc = cuMemcpyDtoD(c_chunk->m_devptr, chunk->m_devptr, sz1);
+			if (rc == CUDA_SUCCESS && sz2 > 0)
+				rc = cuMemcpyDtoD(c_chunk->m_devptr + sz1,
+								  chunk->m_devptr + kds->length - sz2, sz2);
+			if (rc != CUDA_SUCCESS)
+			{
+				gpuMemFree(c_chunk);
+				gpuClientFatal(gclient, "failed on cuMemcpyDtoD: %s",
+							   cuStrError(rc));
+				return false;
+			}
+			((kern_data_store *)c_chunk->m_devptr)->length = sz1 + sz2;
+			gpuMemFree(chunk);
+			d_chunk_array[i] = chunk = c_chunk;
+			kds_dst_array[i] = (kern_data_store *)c_chunk->m_devptr;
+		}
+		pthreadMutexLock(&gq_buf->win_mutex);
+		if (gq_buf->win_nchunks >= gq_buf->win_nrooms)
+		{
+			int			nrooms = 2 * gq_buf->win_nrooms + 20;
+			gpuMemChunk **chunks = realloc(gq_buf->win_chunks,
+										  sizeof(gpuMemChunk *) * nrooms);
+			if (!chunks)
+			{
+				pthreadMutexUnlock(&gq_buf->win_mutex);
+				gpuClientFatal(gclient, "out of memory");
+				return false;
+			}
+			gq_buf->win_chunks = chunks;
+			gq_buf->win_nrooms = nrooms;
+		}
+		gq_buf->win_chunks[gq_buf->win_nchunks++] = chunk;
+		pthreadMutexUnlock(&gq_buf->win_mutex);
+		/* chunk is now owned by the gq_buf */
+		d_chunk_array[i] = NULL;
+	}
+	return true;
+}
+
+static inline bool
+__gpuClientIsStagedCommand(gpuClient *gclient, XpuCommand *xcmd)
+{
+	return (gclient->staging_ring != NULL &&
+			(char *)xcmd >= (char *)gclient->staging_ring &&
+			(char *)xcmd <  (char *)gclient->staging_ring + gclient->staging_ring_sz);
+}
+
+static void
+__gpuServiceStatsKernelLatency(gpuServiceStats *stats, float elapsed_ms)
+{
+	uint64_t	usec = (uint64_t)(elapsed_ms * 1000.0);
+	uint64_t	limit = 100;
+	int			k;
+
+	for (k=0; k < GPUSERV_LATENCY_NBUCKETS-1 && usec >= limit; k++)
+		limit *= 10;
+	pg_atomic_fetch_add_u64(&stats->kern_latency_hist[k], 1);
+	pg_atomic_fetch_add_u64(&stats->kern_nlaunches, 1);
+	pg_atomic_fetch_add_u64(&stats->kern_total_usec, usec);
+}
+
+/*
+ * __gpuservTheoreticalOccupancy
+ *
+ * ratio of the active warps per SM to the max warps per SM
+ */
+static float
+__gpuservTheoreticalOccupancy(CUfunction kern_function,
+							  int grid_sz, int block_sz,
+							  unsigned int shmem_dynamic_sz)
+{
+	GpuDevAttributes *dattrs = &gpuDevAttrs[MY_DINDEX_PER_THREAD];
+	int			nblocks;
+	double		nthreads;
+
+	if (cuOccupancyMaxActiveBlocksPerMultiprocessor(&nblocks,
+													kern_function,
+													block_sz,
+													shmem_dynamic_sz) != CUDA_SUCCESS ||
+		dattrs->MAX_THREADS_PER_MULTIPROCESSOR <= 0 ||
+		dattrs->MULTIPROCESSOR_COUNT <= 0)
+		return 0.0;
+	/* grid may be smaller than the capacity of the device */
+	nblocks = Min(nblocks, (grid_sz + dattrs->MULTIPROCESSOR_COUNT - 1) /
+			  dattrs->MULTIPROCESSOR_COUNT);
+	nthreads = (double)nblocks * (double)block_sz;
+	return Min(nthreads / (double)dattrs->MAX_THREADS_PER_MULTIPROCESSOR, 1.0);
+}
+
+/* ----------------------------------------------------------------
+ *
+ * Autotuning of the kernel launch configuration
+ *
+ * cuOccupancyMaxPotentialBlockSize() picks up the block size that maximizes
+ * the theoretical occupancy, however, it is not always the fastest for the
+ * register heavy kernels (e.g, GpuJoin with PostGIS) or GpuPreAgg with large
+ * prep-function buffer on the shared memory. If pg_strom.gpu_kernel_autotune
+ * is enabled, the GPU service tries a few candidates of the block size and
+ * the shared memory limit for each shape of the session, in round-robin.
+ * Once every candidate has GPU_AUTOTUNE_NTRIALS samples, the one with the
+ * least kernel time per source row is chosen, and saved to the file for
+ * the next start-up.
+ *
+ * ----------------------------------------------------------------
+ */
+#define GPU_AUTOTUNE_MAX_CANDS		8
+#define GPU_AUTOTUNE_NTRIALS		3
+#define GPU_AUTOTUNE_MIN_ROWS		10000
+#define GPU_AUTOTUNE_FILENAME		"pg_strom_autotune.gpu%d"
+
+typedef struct
+{
+	uint32_t	xpu_task_flags;
+	uint32_t	num_rels;
+	uint32_t	kvars_nslots;
+	uint32_t	kvecs_ndims;
+	uint32_t	kvecs_bufsz;
+	uint32_t	groupby_prepfn_bufsz;
+	uint32_t	groupby_ngroups_class;	/* log2 of the estimation */
+	uint32_t	jit_kernel;
+} gpuAutoTuneKey;
+
+typedef struct
+{
+	int			block_sz;
+	unsigned int shmem_limit;	/* limit of the dynamic shared memory */
+	uint32_t	nsamples;
+	double		total_msec;
+	double		total_rows;
+} gpuAutoTuneConfig;
+
+typedef struct gpuAutoTuneEntry
+{
+	gpuAutoTuneKey key;
+	int			best;		/* index of the chosen config, or -1 */
+	int			ncands;
+	int			next;		/* next candidate to be tried */
+	gpuAutoTuneConfig cands[GPU_AUTOTUNE_MAX_CANDS];
+} gpuAutoTuneEntry;
+
+static void
+__gpuservAutoTuneKey(gpuAutoTuneKey *key,
+					 gpuClient *gclient, int num_rels)
+{
+	kern_session_info *session = gclient->session;
+	double		ngroups = session->groupby_ngroups_estimation;
+
+	memset(key, 0, sizeof(gpuAutoTuneKey));
+	key->xpu_task_flags = session->xpu_task_flags;
+	key->num_rels = num_rels;
+	key->kvars_nslots = session->kcxt_kvars_nslots;
+	key->kvecs_ndims = session->kcxt_kvecs_ndims;
+	key->kvecs_bufsz = session->kcxt_kvecs_bufsz;
+	key->groupby_prepfn_bufsz = session->groupby_prepfn_bufsz;
+	if (ngroups >= 1.0)
+		key->groupby_ngroups_class = (uint32_t)ceil(log2(ngroups));
+	key->jit_kernel = (gclient->jit_kern_gpumain != NULL);
+}
+
+/*
+ * __gpuservAutoTuneSaveFile - must be called under the autotune_lock
+ */
+static void
+__gpuservAutoTuneSaveFile(gpuContext *gcontext)
+{
+	GpuDevAttributes *dattrs = &gpuDevAttrs[gcontext->cuda_dindex];
+	char		path[MAXPGPATH];
+	char		temp[MAXPGPATH];
+	FILE	   *filp;
+
+	snprintf(path, sizeof(path), GPU_AUTOTUNE_FILENAME, gcontext->cuda_dindex);
+	snprintf(temp, sizeof(temp), "%s.tmp", path);
+	filp = fopen(temp, "w");
+	if (!filp)
+	{
+		__gsLog("failed on fopen('%s'): %s", temp, strerror(errno));
+		return;
+	}
+	fprintf(filp, "%s\n", dattrs->DEV_UUID);
+	for (int i=0; i < GPU_AUTOTUNE_NSLOTS; i++)
+	{
+		gpuAutoTuneEntry *entry = gcontext->autotune_cache[i];
+		gpuAutoTuneKey *key;
+
+		if (!entry || entry->best < 0)
+			continue;
+		key = &entry->key;
+		fprintf(filp, "%u %u %u %u %u %u %u %u %d %u\n",
+				key->xpu_task_flags,
+				key->num_rels,
+				key->kvars_nslots,
+				key->kvecs_ndims,
+				key->kvecs_bufsz,
+				key->groupby_prepfn_bufsz,
+				key->groupby_ngroups_class,
+				key->jit_kernel,
+				entry->cands[entry->best].block_sz,
+				entry->cands[entry->best].shmem_limit);
+	}
+	if (fclose(filp) != 0)
+		__gsLog("failed on fclose('%s'): %s", temp, strerror(errno));
+	else if (rename(temp, path) != 0)
+		__gsLog("failed on rename('%s','%s'): %s", temp, path, strerror(errno));
+}
+
+/*
+ * __gpuservAutoTuneLoadFile
+ */
+static void
+__gpuservAutoTuneLoadFile(gpuContext *gcontext)
+{
+	GpuDevAttributes *dattrs = &gpuDevAttrs[gcontext->cuda_dindex];
+	char		path[MAXPGPATH];
+	char		linebuf[1024];
+	FILE	   *filp;
+
+	snprintf(path, sizeof(path), GPU_AUTOTUNE_FILENAME, gcontext->cuda_dindex);
+	filp = fopen(path, "r");
+	if (!filp)
+		return;
+	/* the choices are valid only for the same device */
+	if (!fgets(linebuf, sizeof(linebuf), filp) ||
+		strcmp(__trim(linebuf), dattrs->DEV_UUID) != 0)
+	{
+		fclose(filp);
+		return;
+	}
+	while (fgets(linebuf, sizeof(linebuf), filp))
+	{
+		gpuAutoTuneEntry *entry;
+		gpuAutoTuneKey key;
+		int			block_sz;
+		unsigned int shmem_limit;
+		int			index;
+
+		memset(&key, 0, sizeof(gpuAutoTuneKey));
+		if (sscanf(linebuf, "%u %u %u %u %u %u %u %u %d %u",
+				   &key.xpu_task_flags,
+				   &key.num_rels,
+				   &key.kvars_nslots,
+				   &key.kvecs_ndims,
+				   &key.kvecs_bufsz,
+				   &key.groupby_prepfn_bufsz,
+				   &key.groupby_ngroups_class,
+				   &key.jit_kernel,
+				   &block_sz,
+				   &shmem_limit) != 10 ||
+			block_sz <= 0 || block_sz > MAXTHREADS_PER_BLOCK)
+			continue;
+		entry = calloc(1, sizeof(gpuAutoTuneEntry));
+		if (!entry)
+			break;
+		memcpy(&entry->key, &key, sizeof(gpuAutoTuneKey));
+		entry->best = 0;
+		entry->ncands = 1;
+		entry->cands[0].block_sz = block_sz;
+		entry->cands[0].shmem_limit = shmem_limit;
+
+		index = (hash_bytes((unsigned char *)&key,
+							sizeof(gpuAutoTuneKey)) % GPU_AUTOTUNE_NSLOTS);
+		if (gcontext->autotune_cache[index])
+			free(gcontext->autotune_cache[index]);
+		gcontext->autotune_cache[index] = entry;
+	}
+	fclose(filp);
+}
+
+/*
+ * __gpuservAutoTuneSetupEntry
+ */
+static gpuAutoTuneEntry *
+__gpuservAutoTuneSetupEntry(gpuContext *gcontext,
+							const gpuAutoTuneKey *key,
+							CUfunction kern_function,
+							int block_sz_default,
+							unsigned int shmem_dynamic_sz)
+{
+	static const int block_sz_candidates[] = { 128, 256, 512, 1024 };
+	gpuAutoTuneEntry *entry;
+	unsigned int shmem_limit = gcontext->gpumain_shmem_sz_dynamic;
+	int			max_block_sz;
+	int			nblocks;
+
+	if (cuFuncGetAttribute(&max_block_sz,
+						   CU_FUNC_ATTRIBUTE_MAX_THREADS_PER_BLOCK,
+						   kern_function) != CUDA_SUCCESS)
+		max_block_sz = block_sz_default;
+	max_block_sz = Min(max_block_sz, MAXTHREADS_PER_BLOCK);
+
+	entry = calloc(1, sizeof(gpuAutoTuneEntry));
+	if (!entry)
+		return NULL;
+	memcpy(&entry->key, key, sizeof(gpuAutoTuneKey));
+	entry->best = -1;
+	/* the default configuration by the occupancy calculator */
+	entry->cands[entry->ncands].block_sz = block_sz_default;
+	entry->cands[entry->ncands].shmem_limit = shmem_limit;
+	entry->ncands++;
+	/* GpuPreAgg may run faster with smaller prep-function buffer */
+	if (key->groupby_prepfn_bufsz > 0)
+	{
+		entry->cands[entry->ncands].block_sz = block_sz_default;
+		entry->cands[entry->ncands].shmem_limit = shmem_limit / 2;
+		entry->ncands++;
+	}
+	for (int i=0; i < lengthof(block_sz_candidates); i++)
+	{
+		int		block_sz = block_sz_candidates[i];
+
+		if (block_sz == block_sz_default ||
+			block_sz > max_block_sz ||
+			cuOccupancyMaxActiveBlocksPerMultiprocessor(&nblocks,
+														kern_function,
+														block_sz,
+														shmem_dynamic_sz) != CUDA_SUCCESS ||
+			nblocks == 0)
+			continue;
+		Assert(entry->ncands < GPU_AUTOTUNE_MAX_CANDS);
+		entry->cands[entry->ncands].block_sz = block_sz;
+		entry->cands[entry->ncands].shmem_limit = shmem_limit;
+		entry->ncands++;
+	}
+	return entry;
+}
+
+/*
+ * __gpuservAutoTuneBegin
+ *
+ * It picks up the launch configuration of the main kernel. It returns
+ * the index of the candidate under the trial, or -1 if no trials are needed
+ * (then, the chosen or the default configuration is used).
+ */
+static int
+__gpuservAutoTuneBegin(gpuContext *gcontext,
+					   const gpuAutoTuneKey *key,
+					   CUfunction kern_function,
+					   unsigned int shmem_dynamic_sz,
+					   int *p_grid_sz,
+					   int *p_block_sz,
+					   unsigned int *p_shmem_limit)
+{
+	GpuDevAttributes *dattrs = &gpuDevAttrs[gcontext->cuda_dindex];
+	gpuAutoTuneEntry *entry;
+	unsigned int shmem_limit;
+	int			index;
+	int			cand = -1;
+	int			block_sz;
+	int			nblocks;
+
+	if (!pgstrom_gpu_kernel_autotune)
+		return -1;
+	index = (hash_bytes((const unsigned char *)key,
+						sizeof(gpuAutoTuneKey)) % GPU_AUTOTUNE_NSLOTS);
+	pthreadMutexLock(&gcontext->autotune_lock);
+	entry = gcontext->autotune_cache[index];
+	if (!entry || memcmp(&entry->key, key, sizeof(gpuAutoTuneKey)) != 0)
+	{
+		entry = __gpuservAutoTuneSetupEntry(gcontext, key,
+											kern_function,
+											*p_block_sz,
+											shmem_dynamic_sz);
+		if (!entry)
+		{
+			pthreadMutexUnlock(&gcontext->autotune_lock);
+			return -1;
+		}
+		if (gcontext->autotune_cache[index])
+			free(gcontext->autotune_cache[index]);
+		gcontext->autotune_cache[index] = entry;
+	}
+	if (entry->best >= 0)
+	{
+		block_sz = entry->cands[entry->best].block_sz;
+		shmem_limit = entry->cands[entry->best].shmem_limit;
+	}
+	else
+	{
+		cand = entry->next;
+		entry->next = (entry->next + 1) % entry->ncands;
+		block_sz = entry->cands[cand].block_sz;
+		shmem_limit = entry->cands[cand].shmem_limit;
+	}
+	pthreadMutexUnlock(&gcontext->autotune_lock);
+
+	/* grid size to fill up the device by the block size */
+	if (block_sz != *p_block_sz)
+	{
+		if (cuOccupancyMaxActiveBlocksPerMultiprocessor(&nblocks,
+														kern_function,
+														block_sz,
+														shmem_dynamic_sz) != CUDA_SUCCESS ||
+			nblocks == 0)
+			return -1;	/* e.g, the choice by the older fatbin */
+		*p_grid_sz = nblocks * dattrs->MULTIPROCESSOR_COUNT;
+		*p_block_sz = block_sz;
+	}
+	*p_shmem_limit = Min(shmem_limit, gcontext->gpumain_shmem_sz_dynamic);
+	return cand;
+}
+
+/*
+ * __gpuservAutoTuneRecord
+ */
+static void
+__gpuservAutoTuneRecord(gpuContext *gcontext,
+						const gpuAutoTuneKey *key, int cand,
+						float kern_msec, uint64_t nitems_raw)
+{
+	gpuAutoTuneEntry *entry;
+	int			index;
+
+	if (cand < 0 || nitems_raw < GPU_AUTOTUNE_MIN_ROWS)
+		return;
+	index = (hash_bytes((const unsigned char *)key,
+						sizeof(gpuAutoTuneKey)) % GPU_AUTOTUNE_NSLOTS);
+	pthreadMutexLock(&gcontext->autotune_lock);
+	entry = gcontext->autotune_cache[index];
+	if (entry &&
+		entry->best < 0 &&
+		cand < entry->ncands &&
+		memcmp(&entry->key, key, sizeof(gpuAutoTuneKey)) == 0)
+	{
+		gpuAutoTuneConfig *config = &entry->cands[cand];
+		double		best_cost = DBL_MAX;
+		int			best = -1;
+
+		config->nsamples++;
+		config->total_msec += kern_msec;
+		config->total_rows += (double)nitems_raw;
+		for (int i=0; i < entry->ncands; i++)
+		{
+			double	cost;
+
+			config = &entry->cands[i];
+			if (config->nsamples < GPU_AUTOTUNE_NTRIALS)
+				goto out;
+			cost = config->total_msec / config->total_rows;
+			if (cost < best_cost)
+			{
+				best_cost = cost;
+				best = i;
+			}
+		}
+		entry->best = best;
+		__gsLog("GPU%d autotune chose block_sz=%d shmem_limit=%u for task_flags=0x%08x num_rels=%u",
+				gcontext->cuda_dindex,
+				entry->cands[best].block_sz,
+				entry->cands[best].shmem_limit,
+				key->xpu_task_flags,
+				key->num_rels);
+		__gpuservAutoTuneSaveFile(gcontext);
+	}
+out:
+	pthreadMutexUnlock(&gcontext->autotune_lock);
+}
+
+/*
+ * __gpuservReleaseTaskGraph
+ */
+static void
+__gpuservReleaseTaskGraph(void)
+{
+	if (MY_GRAPH_EXEC_PER_THREAD)
+		cuGraphExecDestroy(MY_GRAPH_EXEC_PER_THREAD);
+	if (MY_GRAPH_PER_THREAD)
+		cuGraphDestroy(MY_GRAPH_PER_THREAD);
+	MY_GRAPH_FUNC_PER_THREAD = NULL;
+	MY_GRAPH_PER_THREAD = NULL;
+	MY_GRAPH_NODE_PER_THREAD = NULL;
+	MY_GRAPH_EXEC_PER_THREAD = NULL;
+}
+
+/*
+ * __gpuservLaunchTaskKernel
+ *
+ * It launches the main kernel of the task. If pg_strom.gpu_task_graph_launch
+ * is enabled, the worker thread keeps an instantiated CUDA graph of the main
+ * kernel, and the later tasks only update the parameters of the kernel node
+ * (grid/block size, shared memory and arguments) and launch the graph; it is
+ * much cheaper than the individual kernel launch on the CPU side.
+ * The graph is rebuilt when the kernel function is switched, e.g, by the JIT
+ * kernels of the other sessions.
+ */
+static CUresult
+__gpuservLaunchTaskKernel(CUfunction f_kernel,
+						  int grid_sz, int block_sz,
+						  unsigned int shmem_dynamic_sz,
+						  void **kern_args)
+{
+	CUDA_KERNEL_NODE_PARAMS	params;
+	CUresult	rc;
+
+	if (!pgstrom_gpu_task_graph_launch)
+		return cuLaunchKernel(f_kernel,
+							  grid_sz, 1, 1,
+							  block_sz, 1, 1,
+							  shmem_dynamic_sz,
+							  MY_STREAM_PER_THREAD,
+							  kern_args,
+							  NULL);
+	memset(&params, 0, sizeof(CUDA_KERNEL_NODE_PARAMS));
+	params.func           = f_kernel;
+	params.gridDimX       = grid_sz;
+	params.gridDimY       = 1;
+	params.gridDimZ       = 1;
+	params.blockDimX      = block_sz;
+	params.blockDimY      = 1;
+	params.blockDimZ      = 1;
+	params.sharedMemBytes = shmem_dynamic_sz;
+	params.kernelParams   = kern_args;
+	params.extra          = NULL;
+
+	if (MY_GRAPH_EXEC_PER_THREAD && MY_GRAPH_FUNC_PER_THREAD == f_kernel)
+	{
+		rc = cuGraphExecKernelNodeSetParams(MY_GRAPH_EXEC_PER_THREAD,
+											MY_GRAPH_NODE_PER_THREAD,
+											&params);
+		if (rc == CUDA_SUCCESS)
+			return cuGraphLaunch(MY_GRAPH_EXEC_PER_THREAD,
+								 MY_STREAM_PER_THREAD);
+		__gsDebug("failed on cuGraphExecKernelNodeSetParams: %s",
+				  cuStrError(rc));
+	}
+	/* (re-)build the graph of the main kernel */
+	__gpuservReleaseTaskGraph();
+	rc = cuGraphCreate(&MY_GRAPH_PER_THREAD, 0);
+	if (rc != CUDA_SUCCESS)
+		goto fallback;
+	rc = cuGraphAddKernelNode(&MY_GRAPH_NODE_PER_THREAD,
+							  MY_GRAPH_PER_THREAD,
+							  NULL, 0,
+							  &params);
+	if (rc != CUDA_SUCCESS)
+		goto fallback;
+	rc = cuGraphInstantiate(&MY_GRAPH_EXEC_PER_THREAD,
+							MY_GRAPH_PER_THREAD, 0);
+	if (rc != CUDA_SUCCESS)
+		goto fallback;
+	MY_GRAPH_FUNC_PER_THREAD = f_kernel;
+	return cuGraphLaunch(MY_GRAPH_EXEC_PER_THREAD,
+						 MY_STREAM_PER_THREAD);
+
+fallback:
+	__gsDebug("unable to build CUDA graph of the task: %s", cuStrError(rc));
+	__gpuservReleaseTaskGraph();
+	return cuLaunchKernel(f_kernel,
+						  grid_sz, 1, 1,
+						  block_sz, 1, 1,
+						  shmem_dynamic_sz,
+						  MY_STREAM_PER_THREAD,
+						  kern_args,
+						  NULL);
+}
+
+/*
+ * __gpuservReplyCancelledTask
+ *
+ * It sends back an empty result for the task cancelled by XpuTaskCancel,
+ * because the backend still counts it as a running command.
+ */
+static void
+__gpuservReplyCancelledTask(gpuClient *gclient)
+{
+	XpuCommand	resp;
+	size_t		resp_sz = MAXALIGN(offsetof(XpuCommand, u.results.stats));
+
+	memset(&resp, 0, sizeof(resp));
+	resp.magic = XpuCommandMagicNumber;
+	resp.tag   = XpuCommandTag__Success;
+	resp.u.results.chunks_offset = resp_sz;
+	gpuClientWriteBack(gclient, &resp, resp_sz, 0, NULL);
+}
+
+static void
+gpuservHandleGpuTaskExec(gpuClient *gclient, XpuCommand *xcmd)
+{
+	gpuContext		*gcontext = gclient->gcontext;
+	kern_session_info *session = gclient->session;
+	gpuQueryBuffer  *gq_buf = gclient->gq_buf;
+	kern_gputask	*kgtask = NULL;
+	const char		*kds_src_pathname = NULL;
+	strom_io_vector *kds_src_iovec = NULL;
+	kern_shbuf_vector *kds_src_shbufs = NULL;
+	kern_data_store *kds_src = NULL;
+	kern_data_store *kds_dst = NULL;
+	kern_data_store *kds_dst_head = NULL;
+	kern_data_store **kds_dst_array = NULL;
+	int				kds_dst_nrooms = 0;
+	int				kds_dst_nitems = 0;
+	int				num_inner_rels = 0;
+	uint32_t		npages_direct_read = 0;
+	uint32_t		npages_vfs_read = 0;
+	uint32_t		prof_nkernels = 0;
+	uint64_t		prof_h2d_bytes = 0;
+	uint64_t		prof_h2d_usec;
+	uint64_t		trace_ts = 0;
+	float			prof_kern_msec = 0.0;
+	float			prof_occupancy = 0.0;
+	CUfunction		f_kern_gpuscan;
+	void		   *gc_lmap = NULL;
+	gpuMemChunk	   *s_chunk = NULL;		/* for kds_src */
+	gpuMemChunk	   *t_chunk = NULL;		/* for kern_gputask */
+	gpuMemChunk	  **d_chunk_array = NULL; /* for kds_dst_array */
+	gpuMemChunk	   *f_chunk = NULL;		/* for kds_fallback */
+	gpuMemChunk	   *g_chunk = NULL;		/* for streaming kds_final */
+	kern_data_store *kds_fallback = NULL;
+	CUdeviceptr		m_kds_src = 0UL;
+	CUdeviceptr		m_kds_extra = 0UL;
+	CUdeviceptr		m_kmrels = 0UL;
+	CUresult		rc;
+	int				grid_sz;
+	int				block_sz;
+	unsigned int	shmem_dynamic_sz;
+	unsigned int	shmem_dynamic_limit = gcontext->gpumain_shmem_sz_dynamic;
+	unsigned int	groupby_prepfn_bufsz = 0;
+	unsigned int	groupby_prepfn_nbufs = 0;
+	gpuAutoTuneKey	autotune_key;
+	int				autotune_cand = -1;
+	size_t			kds_final_length = 0;
+	bool			kds_final_locked = false;
+	size_t			sz;
+	void		   *kern_args[10];
+
+	/* the backend already got enough rows (LIMIT pushdown) */
+	if (gclient->task_cancelled)
+	{
+		__gpuservReplyCancelledTask(gclient);
+		return;
+	}
+	if (xcmd->u.task.kds_src_pathname)
+		kds_src_pathname = (char *)xcmd + xcmd->u.task.kds_src_pathname;
+	if (xcmd->u.task.kds_src_iovec)
+		kds_src_iovec = (strom_io_vector *)((char *)xcmd + xcmd->u.task.kds_src_iovec);
+	if (xcmd->u.task.kds_src_offset)
+		kds_src = (kern_data_store *)((char *)xcmd + xcmd->u.task.kds_src_offset);
+	if (xcmd->u.task.kds_dst_offset)
+		kds_dst_head = (kern_data_store *)((char *)xcmd + xcmd->u.task.kds_dst_offset);
+	if (xcmd->u.task.kds_src_shbufs)
+		kds_src_shbufs = (kern_shbuf_vector *)((char *)xcmd + xcmd->u.task.kds_src_shbufs);
+	/* GpuCache and heap files are visible only to the local clients */
+	if (gclient->is_remote &&
+		(!kds_src ||
+		 kds_src_shbufs ||
+		 (kds_src->format == KDS_FORMAT_BLOCK &&
+		  kds_src_pathname && kds_src_iovec)))
+	{
+		gpuClientELog(gclient, "GPU%d: remote session cannot use %s",
+					  MY_DINDEX_PER_THREAD,
+					  !kds_src ? "GpuCache" : "GPU-Direct SQL on the heap");
+		return;
+	}
+	/* arrow files are read only under pg_strom.gpuserv_remote_arrow_dir */
+	if (gclient->is_remote && kds_src_pathname)
+	{
+		char	   *resolved = alloca(PATH_MAX);
+
+		if (!__gpuservRemoteArrowFileIsAllowed(kds_src_pathname, resolved))
+		{
+			gpuClientELog(gclient, "GPU%d: remote session cannot read '%s' out of pg_strom.gpuserv_remote_arrow_dir",
+						  MY_DINDEX_PER_THREAD, kds_src_pathname);
+			return;
+		}
+		kds_src_pathname = resolved;
+	}
+	prof_h2d_usec = __gpuservTimestampUsec();
+	if (!kds_src)
+	{
+		const GpuCacheIdent *ident = (GpuCacheIdent *)xcmd->u.task.data;
+		char		errbuf[120];
+
+		Assert(xcmd->tag == XpuCommandTag__XpuTaskExecGpuCache);
+		gc_lmap = gpuCacheGetDeviceBuffer(ident,
+										  MY_DINDEX_PER_THREAD,
+										  &m_kds_src,
+										  &m_kds_extra,
+										  errbuf, sizeof(errbuf));
+		if (!gc_lmap)
+		{
+			gpuClientELog(gclient, "no GpuCache (dat=%u,rel=%u,sig=%09lx) found - %s",
+						  ident->database_oid,
+						  ident->table_oid,
+						  ident->signature,
+						  errbuf);
+			return;
+		}
+	}
+	else if (__gpuClientIsStagedCommand(gclient, xcmd) &&
+			 (kds_src->format == KDS_FORMAT_ROW ||
+			  (kds_src->format == KDS_FORMAT_BLOCK &&
+			   !(kds_src_pathname && kds_src_iovec) &&
+			   !kds_src_shbufs) ||
+			  (kds_src->format == KDS_FORMAT_ARROW && kds_src_iovec->nr_chunks == 0)))
+	{
+		/* kds_src on the staging ring is not visible to the device */
+		s_chunk = gpuservLoadKdsStaged(gclient, kds_src);
+		if (!s_chunk)
+			return;
+		m_kds_src = s_chunk->m_devptr;
+	}
+	else if (kds_src->format == KDS_FORMAT_ROW)
+	{
+		m_kds_src = (CUdeviceptr)kds_src;
+	}
+	else if (kds_src->format == KDS_FORMAT_BLOCK)
+	{
+		if ((kds_src_pathname && kds_src_iovec) || kds_src_shbufs)
+		{
+			s_chunk = gpuservLoadKdsBlock(gclient,
+										  kds_src,
+										  kds_src_pathname,
+										  kds_src_iovec,
+										  kds_src_shbufs,
+										  &npages_direct_read,
+										  &npages_vfs_read);
+			if (!s_chunk)
+				return;
+			m_kds_src = s_chunk->m_devptr;
+		}
+		else
+		{
+			Assert(kds_src->block_nloaded == kds_src->nitems);
+			m_kds_src = (CUdeviceptr)kds_src;
+		}
+	}
+	else if (kds_src->format == KDS_FORMAT_ARROW)
+	{
+		if (kds_src_iovec->nr_chunks == 0)
+			m_kds_src = (CUdeviceptr)kds_src;
+		else
+		{
+			if (!kds_src_pathname)
+			{
+				gpuClientELog(gclient, "GpuScan: arrow file is missing");
+				return;
+			}
+			s_chunk = gpuservLoadKdsArrow(gclient,
+										  kds_src,
+										  kds_src_pathname,
+										  kds_src_iovec,
+										  &npages_direct_read,
+										  &npages_vfs_read);
+			if (!s_chunk)
+				return;
+			m_kds_src = s_chunk->m_devptr;
+		}
+	}
+	else
+	{
+		gpuClientELog(gclient, "unknown GpuScan Source format (%c)",
+					  kds_src->format);
+		return;
+	}
+	if (s_chunk)
+		prof_h2d_bytes = s_chunk->__length;
+	else if (!gc_lmap)
+		prof_h2d_bytes = kds_src->length;
+	/* inner buffer of GpuJoin */
+	if (gq_buf && gq_buf->m_kmrels)
+	{
+		kern_multirels *h_kmrels = (kern_multirels *)gq_buf->h_kmrels;
+
+		m_kmrels = gq_buf->m_kmrels;
+		num_inner_rels = h_kmrels->num_rels;
+	}
+
+	if (gclient->jit_kern_gpumain)
+		f_kern_gpuscan = gclient->jit_kern_gpumain;
+	else
+	{
+		rc = cuModuleGetFunction(&f_kern_gpuscan,
+								 gcontext->cuda_module,
+								 "kern_gpujoin_main");
+		if (rc != CUDA_SUCCESS)
+		{
+			gpuClientFatal(gclient, "failed on cuModuleGetFunction: %s",
+						   cuStrError(rc));
+			goto bailout;
+		}
+	}
+	shmem_dynamic_sz = __KERN_WARP_CONTEXT_BASESZ(session->kcxt_kvecs_ndims);
+	rc = gpuOptimalBlockSize(&grid_sz,
+							 &block_sz,
+							 f_kern_gpuscan,
+							 shmem_dynamic_sz);
+	if (rc != CUDA_SUCCESS)
+	{
+		gpuClientFatal(gclient, "failed on gpuOptimalBlockSize: %s",
+					   cuStrError(rc));
+		goto bailout;
+	}
+//	block_sz = 128;
+//	grid_sz = 1;
+	__gpuservAutoTuneKey(&autotune_key, gclient, num_inner_rels);
+	autotune_cand = __gpuservAutoTuneBegin(gcontext,
+										   &autotune_key,
+										   f_kern_gpuscan,
+										   shmem_dynamic_sz,
+										   &grid_sz,
+										   &block_sz,
+										   &shmem_dynamic_limit);
+	prof_occupancy = __gpuservTheoreticalOccupancy(f_kern_gpuscan,
+												   grid_sz, block_sz,
+												   shmem_dynamic_sz);
+
+	/* allocation of extra shared memory for GpuPreAgg (if any) */
+	shmem_dynamic_sz =
+		__expand_gpupreagg_prepfunc_buffer(session,
+										   grid_sz, block_sz,
+										   shmem_dynamic_sz,
+										   shmem_dynamic_limit,
+										   &groupby_prepfn_bufsz,
+										   &groupby_prepfn_nbufs);
+	/*
+	 * Allocation of the control structure
+	 */
+	sz = KERN_GPUTASK_LENGTH(session->kcxt_kvecs_ndims,
+							 session->kcxt_kvecs_bufsz,
+							 grid_sz, block_sz);
+	t_chunk = gpuMemAllocManaged(sz);
+	if (!t_chunk)
+	{
+		gpuClientFatal(gclient, "failed on gpuMemAllocManaged: %lu", sz);
+		goto bailout;
+	}
+	kgtask = (kern_gputask *)t_chunk->m_devptr;
+	memset(kgtask, 0, offsetof(kern_gputask, stats[num_inner_rels]));
+	kgtask->grid_sz  = grid_sz;
+	kgtask->block_sz = block_sz;
+	kgtask->kvars_nslots = session->kcxt_kvars_nslots;
+	kgtask->kvecs_bufsz  = session->kcxt_kvecs_bufsz;
+	kgtask->kvecs_ndims  = session->kcxt_kvecs_ndims;
+	kgtask->n_rels       = num_inner_rels;
+	kgtask->abort_flag   = (uint32_t *)gclient->m_abort_flag;
+	kgtask->groupby_prepfn_bufsz = groupby_prepfn_bufsz;
+	kgtask->groupby_prepfn_nbufs = groupby_prepfn_nbufs;
+
+	/*
+	 * Allocation of the buffer for row-granular CPU fallback.
+	 * The source rows that raised ERRCODE_CPU_FALLBACK on the depth-0 are
+	 * saved here, then only these rows are re-executed by the CPU.
+	 * GpuWindow needs all the rows on the device, so not supported.
+	 * If unable to allocate, it just falls back on the whole chunk.
+	 */
+	if (kds_src && (kds_src->format == KDS_FORMAT_ROW ||
+					kds_src->format == KDS_FORMAT_BLOCK) &&
+		session->gpuwin_desc == 0)
+	{
+		sz = KDS_HEAD_LENGTH(kds_src) + PGSTROM_CHUNK_SIZE / 16;
+		f_chunk = gpuMemAllocManaged(sz);
+		if (f_chunk)
+		{
+			kds_fallback = (kern_data_store *)f_chunk->m_devptr;
+			memcpy(kds_fallback, kds_src, KDS_HEAD_LENGTH(kds_src));
+			kds_fallback->length = sz;
+			kds_fallback->nitems = 0;
+			kds_fallback->usage  = 0;
+			kds_fallback->format = KDS_FORMAT_ROW;
+			kds_fallback->hash_nslots = 0;
+			kds_fallback->block_offset = 0;
+			kds_fallback->block_nloaded = 0;
+		}
+	}
+	kgtask->kds_fallback = kds_fallback;
+
+	/* prefetch source KDS, if managed memory */
+	if (!s_chunk && !gc_lmap)
+	{
+		rc = cuMemPrefetchAsync((CUdeviceptr)kds_src,
+								kds_src->length,
+								MY_DEVICE_PER_THREAD,
+								MY_STREAM_PER_THREAD);
+		if (rc != CUDA_SUCCESS)
+		{
+			gpuClientFatal(gclient, "failed on cuMemPrefetchAsync: %s",
+						   cuStrError(rc));
+			goto bailout;
+		}
+	}
+	/* NOTE: prefetch and staged copy are asynchronous, so they are included in the kernel time */
+	gpuTraceComplete(gclient, "load", prof_h2d_usec, prof_h2d_bytes);
+	prof_h2d_usec = __gpuservTimestampUsec() - prof_h2d_usec;
+
+	/*
+	 * Allocation of the destination buffer
+	 */
+resume_kernel:
+	if (session->groupby_streaming)
+	{
+		/*
+		 * Streaming GpuPreAgg; suspend of the kernel means the private
+		 * kds_final is almost full, so it is expanded.
+		 */
+		if (!g_chunk || kgtask->resume_context)
+		{
+			gpuMemChunk *chunk = __setupGpuTaskGroupByBuffer(session, g_chunk);
+
+			if (!chunk)
+			{
+				gpuClientFatal(gclient, "unable to %s GpuPreAgg streaming buffer",
+							   g_chunk ? "expand" : "allocate");
+				goto bailout;
+			}
+			g_chunk = chunk;
+		}
+		kds_dst = (kern_data_store *)g_chunk->m_devptr;
+	}
+	else if (gq_buf && gq_buf->m_kds_final)
+	{
+		/*
+		 * Suspend of GpuPreAgg kernel means the kds_final buffer is
+		 * almost full, thus GPU kernel wants to expand the buffer.
+		 * It must be done under the exclusive lock.
+		 */
+		if (kgtask->resume_context)
+		{
+			if (!__expandGpuQueryGroupByBuffer(gq_buf, kds_final_length))
+			{
+				gpuClientFatal(gclient, "unable to expand GpuPreAgg final buffer");
+				goto bailout;
+			}
+		}
+		pthreadRWLockReadLock(&gq_buf->m_kds_final_rwlock);
+		kds_dst = (kern_data_store *)gq_buf->m_kds_final;
+		kds_final_length = gq_buf->m_kds_final_length;
+		kds_final_locked = true;
+	}
+	else
+	{
+		gpuMemChunk	   *d_chunk;
+
+		sz = KDS_HEAD_LENGTH(kds_dst_head) + PGSTROM_CHUNK_SIZE;
+		d_chunk = gpuMemAllocManaged(sz);
+		if (!d_chunk)
+		{
+			gpuClientFatal(gclient, "failed on gpuMemAllocManaged(%lu)", sz);
+			goto bailout;
+		}
+		kds_dst = (kern_data_store *)d_chunk->m_devptr;
+		memcpy(kds_dst, kds_dst_head, KDS_HEAD_LENGTH(kds_dst_head));
+		kds_dst->length = sz;
+		if (kds_dst->format == KDS_FORMAT_COLUMN)
+			__setupGpuColumnarDestBuffer(kds_dst);
+		if (kds_dst_nitems + GPUTASK_MAX_DST_SEGMENTS >= kds_dst_nrooms)
+		{
+			kern_data_store	**kds_dst_temp;
+			gpuMemChunk		**d_chunk_temp;
+
+			kds_dst_nrooms = 2 * kds_dst_nrooms + 10 + GPUTASK_MAX_DST_SEGMENTS;
+			kds_dst_temp = alloca(sizeof(kern_data_store *) * kds_dst_nrooms);
+			d_chunk_temp = alloca(sizeof(gpuMemChunk *) * kds_dst_nrooms);
+			if (kds_dst_nitems > 0)
+			{
+				memcpy(kds_dst_temp, kds_dst_array,
+					   sizeof(kern_data_store *) * kds_dst_nitems);
+				memcpy(d_chunk_temp, d_chunk_array,
+					   sizeof(gpuMemChunk *) * kds_dst_nitems);
+			}
+			kds_dst_array = kds_dst_temp;
+			d_chunk_array = d_chunk_temp;
+		}
+		kds_dst_array[kds_dst_nitems] = kds_dst;
+		d_chunk_array[kds_dst_nitems] = d_chunk;
+		kds_dst_nitems++;
+
+		/*
+		 * Once the kernel got suspended, it likely produces large results
+		 * (e.g, skewed join with high fanout). So, it hands out the spare
+		 * segments of the destination buffer, then the kernel switches
+		 * the segment by itself, instead of the suspend/resume.
+		 * Managed memory is not populated until the first touch, so the
+		 * unused segments are cheap.
+		 */
+		kgtask->kds_dst_nsegments = 0;
+		kgtask->kds_dst_curr_seg = 0;
+		if (kgtask->resume_context)
+		{
+			for (int k=0; k < GPUTASK_MAX_DST_SEGMENTS; k++)
+			{
+				kern_data_store *kds_seg;
+
+				d_chunk = gpuMemAllocManaged(sz);
+				if (!d_chunk)
+					break;
+				kds_seg = (kern_data_store *)d_chunk->m_devptr;
+				memcpy(kds_seg, kds_dst_head, KDS_HEAD_LENGTH(kds_dst_head));
+				kds_seg->length = sz;
+				if (kds_seg->format == KDS_FORMAT_COLUMN)
+					__setupGpuColumnarDestBuffer(kds_seg);
+				kgtask->kds_dst_segments[k] = kds_seg;
+				kgtask->kds_dst_nsegments++;
+				kds_dst_array[kds_dst_nitems] = kds_seg;
+				d_chunk_array[kds_dst_nitems] = d_chunk;
+				kds_dst_nitems++;
+			}
+		}
+	}
+
+	/*
+	 * Launch kernel
+	 */
+	kern_args[0] = &gclient->session;
+	kern_args[1] = &kgtask;
+	kern_args[2] = &m_kmrels;
+	kern_args[3] = &m_kds_src;
+	kern_args[4] = &m_kds_extra;
+	kern_args[5] = &kds_dst;
+
+	trace_ts = gpuTraceBegin(gclient);
+	rc = cuEventRecord(MY_EVENT_BEGIN_PER_THREAD, MY_STREAM_PER_THREAD);
+	if (rc != CUDA_SUCCESS)
+	{
+		gpuClientFatal(gclient, "failed on cuEventRecord: %s", cuStrError(rc));
+		goto bailout;
+	}
+	rc = __gpuservLaunchTaskKernel(f_kern_gpuscan,
+								   grid_sz, block_sz,
+								   shmem_dynamic_sz,
+								   kern_args);
+	if (rc != CUDA_SUCCESS)
+	{
+		gpuClientFatal(gclient, "failed on cuLaunchKernel: %s", cuStrError(rc));
+		goto bailout;
+	}
+
+	rc = cuEventRecord(MY_EVENT_PER_THREAD, MY_STREAM_PER_THREAD);
+	if (rc != CUDA_SUCCESS)
+	{
+		gpuClientFatal(gclient, "failed on cuEventRecord: %s", cuStrError(rc));
+		goto bailout;
+	}
+
+	/* point of synchronization */
+	rc = cuEventSynchronize(MY_EVENT_PER_THREAD);
+	if (rc != CUDA_SUCCESS)
+	{
+		gpuClientFatal(gclient, "failed on cuEventSynchronize: %s", cuStrError(rc));
+		goto bailout;
+	}
+	else if (MY_LOAD_ERRCODE_PER_THREAD != 0)
+	{
+		gpuClientELog(gclient, "failed on asynchronous GPU-Direct read (code=%u)",
+					  MY_LOAD_ERRCODE_PER_THREAD);
+		MY_LOAD_ERRCODE_PER_THREAD = 0;
+		goto bailout;
+	}
+	else
+	{
+		float	elapsed;
+
+		gpuTraceComplete(gclient, "kernel", trace_ts, 0);
+		if (cuEventElapsedTime(&elapsed, MY_EVENT_BEGIN_PER_THREAD,
+							   MY_EVENT_PER_THREAD) == CUDA_SUCCESS)
+		{
+			prof_kern_msec += elapsed;
+			__gpuServiceStatsKernelLatency(gcontext->stats, elapsed);
+		}
+		prof_nkernels++;
+	}
+	/* unlock kds_final buffer */
+	if (kds_final_locked)
+	{
+		pthreadRWLockUnlock(&gq_buf->m_kds_final_rwlock);
+		kds_final_locked = false;
+	}
+	/* release the spare segments not used by the kernel */
+	while (kgtask->kds_dst_nsegments > kgtask->kds_dst_curr_seg)
+	{
+		gpuMemFree(d_chunk_array[--kds_dst_nitems]);
+		kgtask->kds_dst_nsegments--;
+	}
+
+	/* status check */
+	if (kgtask->kerror.errcode == ERRCODE_STROM_SUCCESS)
+	{
+		XpuCommand *resp;
+		size_t		resp_sz;
+
+		if (kgtask->suspend_count > 0)
+		{
+			if (gpuServiceGoingTerminate())
+			{
+				gpuClientFatal(gclient, "GpuService is going to terminate during GpuScan kernel suspend/resume");
+				goto bailout;
+			}
+			if (gclient->task_cancelled)
+			{
+				__gpuservReplyCancelledTask(gclient);
+				goto bailout;
+			}
+			/* restore warp context from the previous state */
+			kgtask->resume_context = true;
+			kgtask->suspend_count = 0;
+			__gsDebug("suspend / resume happen\n");
+			gpuTraceInstant(gclient, "suspend");
+			if (kds_final_locked)
+				pthreadRWLockUnlock(&gq_buf->m_kds_final_rwlock);
+			goto resume_kernel;
+		}
+		__gpuservAutoTuneRecord(gcontext, &autotune_key, autotune_cand,
+								prof_kern_msec, kgtask->nitems_raw);
+		/* streaming GpuPreAgg returns the groups of this chunk */
+		if (g_chunk)
+		{
+			kern_data_store *kds_final = (kern_data_store *)g_chunk->m_devptr;
+
+			Assert(kds_dst_nitems == 0);
+			if (kds_final->nitems > 0)
+			{
+				kds_dst_array = alloca(sizeof(kern_data_store *));
+				d_chunk_array = alloca(sizeof(gpuMemChunk *));
+				kds_dst_array[0] = kds_final;
+				d_chunk_array[0] = g_chunk;
+				kds_dst_nitems = 1;
+				g_chunk = NULL;
+			}
+		}
+		/* GPU top-k for ORDER BY ... LIMIT, if any */
+		if (session->gpusort_limit > 0 &&
+			!session->groupby_streaming &&
+			!(gq_buf && gq_buf->m_kds_final) &&
+			!__gpuservGpuSortTopK(gclient,
+								  kds_dst_nitems,
+								  kds_dst_array,
+								  d_chunk_array))
+			goto bailout;
+		/* GpuWindow keeps the results until XpuTaskFinal */
+		if (session->gpuwin_desc != 0)
+		{
+			if (!__gpuservGpuWindowSaveChunks(gclient, gq_buf,
+											  kds_dst_nitems,
+											  kds_dst_array,
+											  d_chunk_array))
+				goto bailout;
+			kds_dst_nitems = 0;
+		}
+		/* send back status and kds_dst */
+		resp_sz = MAXALIGN(offsetof(XpuCommand,
+									u.results.stats[num_inner_rels]));
+		resp = alloca(resp_sz);
+		memset(resp, 0, resp_sz);
+		resp->magic = XpuCommandMagicNumber;
+		resp->tag   = XpuCommandTag__Success;
+		resp->u.results.chunks_nitems = kds_dst_nitems;
+		resp->u.results.chunks_offset = resp_sz;
+		if (kds_src_shbufs)
+			resp->u.results.shbuf_tag = kds_src_shbufs->tag;
+		resp->u.results.npages_direct_read = npages_direct_read;
+		resp->u.results.npages_vfs_read = npages_vfs_read;
+		resp->u.results.nitems_raw = kgtask->nitems_raw;
+		resp->u.results.nitems_in  = kgtask->nitems_in;
+		resp->u.results.nitems_out = kgtask->nitems_out;
+		pg_atomic_fetch_add_u64(&gcontext->stats->num_tasks, 1);
+		pg_atomic_fetch_add_u64(&gcontext->stats->npages_direct_read,
+								npages_direct_read);
+		pg_atomic_fetch_add_u64(&gcontext->stats->npages_vfs_read,
+								npages_vfs_read);
+		resp->u.results.prof_nkernels = prof_nkernels;
+		resp->u.results.prof_nresumes = prof_nkernels - 1;
+		resp->u.results.prof_h2d_bytes = prof_h2d_bytes;
+		for (int i=0; i < kds_dst_nitems; i++)
+		{
+			kern_data_store *__kds = kds_dst_array[i];
+
+			if (__kds->format == KDS_FORMAT_COLUMN)
+				resp->u.results.prof_d2h_bytes += __gpuColumnarDestLength(__kds);
+			else
+				resp->u.results.prof_d2h_bytes += (KDS_HEAD_LENGTH(__kds) +
+												   MAXALIGN(sizeof(uint32_t) * __kds->nitems) +
+												   __kds_unpack(__kds->usage));
+		}
+		resp->u.results.prof_h2d_usec = prof_h2d_usec;
+		resp->u.results.prof_kern_usec = (uint32_t)(prof_kern_msec * 1000.0);
+		resp->u.results.prof_occupancy = prof_occupancy;
+		resp->u.results.num_rels = num_inner_rels;
+		for (int i=0; i < num_inner_rels; i++)
+		{
+			resp->u.results.stats[i].nitems_gist = kgtask->stats[i].nitems_gist;
+			resp->u.results.stats[i].nitems_out  = kgtask->stats[i].nitems_out;
+		}
+		/* rows to be re-executed by CPU follow the kds_dst array */
+		if (kds_fallback && kds_fallback->nitems > 0)
+		{
+			kern_data_store **kds_temp;
+
+			kds_temp = alloca(sizeof(kern_data_store *) * (kds_dst_nitems + 1));
+			if (kds_dst_nitems > 0)
+				memcpy(kds_temp, kds_dst_array,
+					   sizeof(kern_data_store *) * kds_dst_nitems);
+			kds_temp[kds_dst_nitems] = kds_fallback;
+			resp->u.results.fallback_nitems = kds_fallback->nitems;
+			pg_atomic_fetch_add_u64(&gcontext->stats->num_fallbacks, 1);
+			gpuClientWriteBack(gclient,
+							   resp, resp_sz,
+							   kds_dst_nitems + 1, kds_temp);
+		}
+		else
+		{
+			gpuClientWriteBack(gclient,
+							   resp, resp_sz,
+							   kds_dst_nitems, kds_dst_array);
+		}
+	}
+	else if (kgtask->kerror.errcode == ERRCODE_CPU_FALLBACK)
+	{
+		kern_data_store *__kds_src = kds_src;
+		XpuCommand	resp;
+
+		/*
+		 * Send back the source buffer with XpuCommandTag__CPUFallback
+		 *
+		 * KDS_FORMAT_BLOCK and KDS_FORMAT_ARROW must be send back the
+		 * backend process from the GPU device buffer, because the original
+		 * kds_src does not have data contents itself.
+		 * For KDS_FORMAT_COLUMN, it is equivalent to the kernel buffer,
+		 * and its size tends to be large. So, CPU fallback uses regular
+		 * heap-scan instead.
+		 */
+		if (s_chunk)
+		{
+			__kds_src = malloc(s_chunk->__length);
+			if (!__kds_src)
+			{
+				gpuClientELog(gclient, "out of memory for CPU fallback (sz=%lu)",
+							  s_chunk->__length);
+				goto bailout;
+			}
+			rc = cuMemcpyDtoH(__kds_src, s_chunk->m_devptr, s_chunk->__length);
+			if (rc != CUDA_SUCCESS)
+			{
+				free(__kds_src);
+				gpuClientELog(gclient, "failed on cuMemcpyDtoH: %s", cuStrError(rc));
+				goto bailout;
+			}
+		}
+		memset(&resp, 0, sizeof(resp));
+		resp.magic = XpuCommandMagicNumber;
+		resp.tag   = XpuCommandTag__CPUFallback;
+		memcpy(&resp.u.fallback.error,
+			   &kgtask->kerror,
+			   sizeof(kern_errorbuf));
+		if (kds_src_shbufs)
+			resp.u.fallback.shbuf_tag = kds_src_shbufs->tag;
+		resp.u.fallback.npages_direct_read = npages_direct_read;
+		resp.u.fallback.npages_vfs_read = npages_vfs_read;
+		pg_atomic_fetch_add_u64(&gcontext->stats->num_tasks, 1);
+		pg_atomic_fetch_add_u64(&gcontext->stats->num_fallbacks, 1);
+		pg_atomic_fetch_add_u64(&gcontext->stats->npages_direct_read,
+								npages_direct_read);
+		pg_atomic_fetch_add_u64(&gcontext->stats->npages_vfs_read,
+								npages_vfs_read);
+		gpuClientWriteBack(gclient,
+						   &resp,
+						   offsetof(XpuCommand, u.fallback.kds_src),
+						   1, &__kds_src);
+		if (kds_src != __kds_src)
+			free(__kds_src);
+	}
+	else if (kgtask->kerror.errcode == ERRCODE_TASK_CANCELLED)
+	{
+		/* aborted by XpuTaskCancel, or the session was closed */
+		__gpuservReplyCancelledTask(gclient);
+	}
+	else
+	{
+		/* send back error status */
+		__gpuClientELogRaw(gclient, &kgtask->kerror);
+	}
+bailout:
+	if (kds_final_locked)
+		pthreadRWLockUnlock(&gq_buf->m_kds_final_rwlock);
+	if (s_chunk)
+		gpuMemFree(s_chunk);
+	if (t_chunk)
+		gpuMemFree(t_chunk);
+	if (f_chunk)
+		gpuMemFree(f_chunk);
+	if (g_chunk)
+		gpuMemFree(g_chunk);
+	while (kds_dst_nitems > 0)
+	{
+		gpuMemChunk *chunk = d_chunk_array[--kds_dst_nitems];
+
+		if (chunk)
+			gpuMemFree(chunk);
+	}
+	if (gc_lmap)
+		gpuCachePutDeviceBuffer(gc_lmap);
+}
+
+/*
+ * gpuservHandleGpuTaskExecStaged
+ *
+ * It runs the XpuTaskExec command put on the staging ring, then releases
+ * the slot for the next chunk.
+ */
+static void
+gpuservHandleGpuTaskExecStaged(gpuClient *gclient, XpuCommand *xcmd)
+{
+	xpuStagingRing *ring = gclient->staging_ring;
+	uint32_t	slot_id = xcmd->u.staged.slot_id;
+	XpuCommand *s_xcmd;
+
+	if (!ring || slot_id >= ring->nslots)
+	{
+		gpuClientELog(gclient, "invalid staging ring slot (%u)", slot_id);
+		return;
+	}
+	s_xcmd = XPU_STAGING_RING_SLOT(ring, slot_id);
+	if (s_xcmd->magic != XpuCommandMagicNumber ||
+		s_xcmd->tag != XpuCommandTag__XpuTaskExec ||
+		s_xcmd->length > ring->slot_sz)
+		gpuClientELog(gclient, "staging ring slot (%u) is corrupted", slot_id);
+	else
+		gpuservHandleGpuTaskExec(gclient, s_xcmd);
+	pg_atomic_write_u32(&ring->slot_busy[slot_id], 0);
+}
+
+/* ------------------------------------------------------------
+ *
+ * gpuservGpuCacheManager - GpuCache worker
+ *
+ * ------------------------------------------------------------
+ */
+static void *
+gpuservGpuCacheManager(void *__arg)
+{
+	gpuWorker  *gworker = (gpuWorker *)__arg;
+	gpuContext *gcontext = gworker->gcontext;
+	CUresult	rc;
+
+	__gpuContextBindNumaNode(gcontext);
+	rc = cuCtxSetCurrent(gcontext->cuda_context);
+	if (rc != CUDA_SUCCESS)
+		__FATAL("failed on cuCtxSetCurrent: %s", cuStrError(rc));
+
+	GpuWorkerCurrentContext	= gcontext;
+	MY_DINDEX_PER_THREAD	= gcontext->cuda_dindex;
+	MY_DEVICE_PER_THREAD	= gcontext->cuda_device;
+	MY_CONTEXT_PER_THREAD	= gcontext->cuda_context;
+	MY_STREAM_PER_THREAD	= CU_STREAM_LEGACY;
+	MY_EVENT_PER_THREAD		= NULL;
+	pg_memory_barrier();
+
+	__gsDebug("GPU-%d GpuCache manager thread launched.",
+			  MY_DINDEX_PER_THREAD);
+	
+	gpucacheManagerEventLoop(gcontext->cuda_dindex,
+							 gcontext->cuda_context,
+							 gcontext->cuda_module);
+
+	/* delete gpuWorker from the gpuContext */
+	pthreadMutexLock(&gcontext->worker_lock);
+	dlist_delete(&gworker->chain);
+	pthreadMutexUnlock(&gcontext->worker_lock);
+	free(gworker);
+
+	__gsDebug("GPU-%d GpuCache manager terminated.",
+			  MY_DINDEX_PER_THREAD);
+	return NULL;
+}
+
+/*
+ * __gpuservGpuWindowKernel
+ */
+static CUfunction
+__gpuservGpuWindowKernel(gpuClient *gclient, const char *kfunc_name,
+						 int *p_grid_sz, int *p_block_sz)
+{
+	CUfunction	kfunc;
+	CUresult	rc;
+
+	rc = cuModuleGetFunction(&kfunc,
+							 gclient->gcontext->cuda_module,
+							 kfunc_name);
+	if (rc != CUDA_SUCCESS)
+	{
+		gpuClientFatal(gclient, "failed on cuModuleGetFunction('%s'): %s",
+					   kfunc_name, cuStrError(rc));
+		return NULL;
+	}
+	rc = gpuOptimalBlockSize(p_grid_sz, p_block_sz, kfunc, 0);
+	if (rc != CUDA_SUCCESS)
+	{
+		gpuClientFatal(gclient, "failed on gpuOptimalBlockSize: %s",
+					   cuStrError(rc));
+		return NULL;
+	}
+	return kfunc;
+}
+
+/*
+ * __gpuservGpuWindowExec
+ *
+ * It sorts all the rows kept in the per-query buffer by the PARTITION BY
+ * and ORDER BY keys, then computes the window functions.
+ */
+static bool
+__gpuservGpuWindowExec(gpuClient *gclient, gpuQueryBuffer *gq_buf)
+{
+	kern_session_info *session = gclient->session;
+	kern_window_desc *kwin_desc = SESSION_WINDOW_DESC(session);
+	kern_window_buffer *kwin;
+	gpuMemChunk	   *w_chunk;
+	CUfunction		f_init;
+	CUfunction		f_setup;
+	CUfunction		f_bitonic;
+	CUfunction		f_scan;
+	CUfunction		f_writeback;
+	int				grid_sz[5];
+	int				block_sz[5];
+	void		   *kern_args[4];
+	uint64_t		nrows = 0;
+	uint32_t		nrooms;
+	uint32_t		base;
+	size_t			nvalues;
+	size_t			sz;
+	char		   *pos;
+	CUresult		rc;
+
+	for (int i=0; i < gq_buf->win_nchunks; i++)
+		nrows += ((kern_data_store *)gq_buf->win_chunks[i]->m_devptr)->nitems;
+	if (nrows == 0)
+		return true;
+	if (nrows > INT_MAX)
+	{
+		gpuClientELog(gclient, "GpuWindow: too many rows (%lu)", nrows);
+		return false;
+	}
+	for (nrooms = 1; nrooms < nrows; nrooms <<= 1);
+	nvalues = (size_t)kwin_desc->nfuncs * nrows;
+
+	sz = (MAXALIGN(sizeof(kern_window_buffer)) +
+		  MAXALIGN(sizeof(kern_tupitem *) * nrows) +
+		  MAXALIGN(sizeof(uint32_t) * nrooms) +
+		  MAXALIGN(sizeof(uint64_t) * kwin_desc->nkeys * nrows) +
+		  MAXALIGN(sizeof(uint32_t) * nrows) +
+		  MAXALIGN(sizeof(uint32_t) * nrows) +
+		  MAXALIGN(sizeof(uint64_t) * nvalues) +
+		  MAXALIGN(sizeof(bool)     * nvalues));
+	w_chunk = gpuMemAllocManaged(sz);
+	if (!w_chunk)
+	{
+		gpuClientFatal(gclient, "failed on gpuMemAllocManaged(%lu)", sz);
+		return false;
+	}
+	kwin = (kern_window_buffer *)w_chunk->m_devptr;
+	memset(kwin, 0, sizeof(kern_window_buffer));
+	kwin->nrows  = nrows;
+	kwin->nrooms = nrooms;
+	kwin->kds_head = (kern_data_store *)gq_buf->win_chunks[0]->m_devptr;
+	pos = (char *)kwin + MAXALIGN(sizeof(kern_window_buffer));
+	kwin->tuples    = (kern_tupitem **)pos;
+	pos += MAXALIGN(sizeof(kern_tupitem *) * nrows);
+	kwin->order     = (uint32_t *)pos;
+	pos += MAXALIGN(sizeof(uint32_t) * nrooms);
+	kwin->keys      = (uint64_t *)pos;
+	pos += MAXALIGN(sizeof(uint64_t) * kwin_desc->nkeys * nrows);
+	kwin->key_nulls = (uint32_t *)pos;
+	pos += MAXALIGN(sizeof(uint32_t) * nrows);
+	kwin->peer_head = (uint32_t *)pos;
+	pos += MAXALIGN(sizeof(uint32_t) * nrows);
+	kwin->values    = (uint64_t *)pos;
+	pos += MAXALIGN(sizeof(uint64_t) * nvalues);
+	kwin->isnull    = (bool *)pos;
+	pos += MAXALIGN(sizeof(bool) * nvalues);
+	Assert(pos == (char *)kwin + sz);
+
+	if (!(f_init = __gpuservGpuWindowKernel(gclient, "kern_gpuwindow_init",
+											&grid_sz[0], &block_sz[0])) ||
+		!(f_setup = __gpuservGpuWindowKernel(gclient, "kern_gpuwindow_setup",
+											 &grid_sz[1], &block_sz[1])) ||
+		!(f_bitonic = __gpuservGpuWindowKernel(gclient, "kern_gpuwindow_bitonic",
+											   &grid_sz[2], &block_sz[2])) ||
+		!(f_scan = __gpuservGpuWindowKernel(gclient, "kern_gpuwindow_scan",
+											&grid_sz[3], &block_sz[3])) ||
+		!(f_writeback = __gpuservGpuWindowKernel(gclient, "kern_gpuwindow_writeback",
+												 &grid_sz[4], &block_sz[4])))
+		goto bailout;
+
+	/* init order[] */
+	kern_args[0] = &gclient->session;
+	kern_args[1] = &kwin;
+	rc = cuLaunchKernel(f_init,
+						grid_sz[0], 1, 1,
+						block_sz[0], 1, 1,
+						0,
+						MY_STREAM_PER_THREAD,
+						kern_args,
+						NULL);
+	if (rc != CUDA_SUCCESS)
+		goto launch_error;
+
+	/* setup rows and sort keys for each chunk */
+	base = 0;
+	for (int i=0; i < gq_buf->win_nchunks; i++)
+	{
+		kern_data_store *kds = (kern_data_store *)gq_buf->win_chunks[i]->m_devptr;
+
+		kern_args[0] = &gclient->session;
+		kern_args[1] = &kwin;
+		kern_args[2] = &kds;
+		kern_args[3] = &base;
+		rc = cuLaunchKernel(f_setup,
+							grid_sz[1], 1, 1,
+							block_sz[1], 1, 1,
+							0,
+							MY_STREAM_PER_THREAD,
+							kern_args,
+							NULL);
+		if (rc != CUDA_SUCCESS)
+			goto launch_error;
+		base += kds->nitems;
+	}
+
+	/* bitonic sorting */
+	if (kwin_desc->nkeys > 0)
+	{
+		for (uint32_t k = 2; k <= nrooms; k <<= 1)
+		{
+			for (uint32_t j = k / 2; j > 0; j >>= 1)
+			{
+				kern_args[0] = &gclient->session;
+				kern_args[1] = &kwin;
+				kern_args[2] = &k;
+				kern_args[3] = &j;
+				rc = cuLaunchKernel(f_bitonic,
+									grid_sz[2], 1, 1,
+									block_sz[2], 1, 1,
+									0,
+									MY_STREAM_PER_THREAD,
+									kern_args,
+									NULL);
+				if (rc != CUDA_SUCCESS)
+					goto launch_error;
+			}
+		}
+	}
+
+	/* window functions with single thread-block */
+	kern_args[0] = &gclient->session;
+	kern_args[1] = &kwin;
+	rc = cuLaunchKernel(f_scan,
+						1, 1, 1,
+						block_sz[3], 1, 1,
+						0,
+						MY_STREAM_PER_THREAD,
+						kern_args,
+						NULL);
+	if (rc != CUDA_SUCCESS)
+		goto launch_error;
+
+	/* write back the results */
+	rc = cuLaunchKernel(f_writeback,
+						grid_sz[4], 1, 1,
+						block_sz[4], 1, 1,
+						0,
+						MY_STREAM_PER_THREAD,
+						kern_args,
+						NULL);
+	if (rc != CUDA_SUCCESS)
+		goto launch_error;
+
+	rc = cuEventRecord(MY_EVENT_PER_THREAD, MY_STREAM_PER_THREAD);
+	if (rc == CUDA_SUCCESS)
+		rc = cuEventSynchronize(MY_EVENT_PER_THREAD);
+	if (rc != CUDA_SUCCESS)
+	{
+		gpuClientFatal(gclient, "failed on cuEventSynchronize: %s", cuStrError(rc));
+		goto bailout;
+	}
+	gpuMemFree(w_chunk);
+	return true;
+
+launch_error:
+	gpuClientFatal(gclient, "failed on cuLaunchKernel: %s", cuStrError(rc));
+bailout:
+	gpuMemFree(w_chunk);
+	return false;
+}
+
+/*
+ * __gpuservGpuJoinRightOuter
+ *
+ * It emits the inner rows of RIGHT/FULL OUTER JOIN that were never matched
+ * to any outer rows into the GpuPreAgg final buffer, using kern_gpujoin_main
+ * that starts from the depth of the RIGHT OUTER JOIN, instead of the CPU
+ * fallback. The outer-join-map on the host buffer must be already merged.
+ */
+static bool
+__gpuservGpuJoinRightOuter(gpuClient *gclient, gpuQueryBuffer *gq_buf)
+{
+	gpuContext	   *gcontext = gclient->gcontext;
+	kern_session_info *session = gclient->session;
+	kern_multirels *h_kmrels = (kern_multirels *)gq_buf->h_kmrels;
+	kern_gputask   *kgtask;
+	kern_data_store *kds_dst;
+	gpuMemChunk	   *t_chunk;
+	CUfunction		f_kernel;
+	CUdeviceptr		m_kmrels = gq_buf->m_kmrels;
+	CUdeviceptr		m_kds_src = 0UL;
+	CUdeviceptr		m_kds_extra = 0UL;
+	CUresult		rc;
+	int				num_rels = h_kmrels->num_rels;
+	int				grid_sz;
+	int				block_sz;
+	unsigned int	shmem_dynamic_sz;
+	unsigned int	groupby_prepfn_bufsz = 0;
+	unsigned int	groupby_prepfn_nbufs = 0;
+	size_t			kds_final_length = 0;
+	size_t			sz;
+	void		   *kern_args[6];
+	bool			retval = false;
+
+	/* the merged outer-join-map must be visible to the device */
+	for (int i=0; i < num_rels; i++)
+	{
+		kern_data_store *kds = KERN_MULTIRELS_INNER_KDS(h_kmrels, i);
+		bool   *h_ojmap = KERN_MULTIRELS_OUTER_JOIN_MAP(h_kmrels, i);
+
+		if (!h_ojmap || gq_buf->kmrels_mode == GQBUF_MODE__ZEROCOPY)
+			continue;
+		if (!__gpuQueryBufferMemcpyHtoD(gq_buf->kmrels_mode,
+										m_kmrels + h_kmrels->chunks[i].ojmap_offset,
+										h_ojmap,
+										kds->nitems))
+		{
+			gpuClientFatal(gclient, "unable to write back the outer-join-map");
+			return false;
+		}
+	}
+
+	if (gclient->jit_kern_gpumain)
+		f_kernel = gclient->jit_kern_gpumain;
+	else
+	{
+		rc = cuModuleGetFunction(&f_kernel,
+								 gcontext->cuda_module,
+								 "kern_gpujoin_main");
+		if (rc != CUDA_SUCCESS)
+		{
+			gpuClientFatal(gclient, "failed on cuModuleGetFunction: %s",
+						   cuStrError(rc));
+			return false;
+		}
+	}
+	shmem_dynamic_sz = __KERN_WARP_CONTEXT_BASESZ(session->kcxt_kvecs_ndims);
+	rc = gpuOptimalBlockSize(&grid_sz,
+							 &block_sz,
+							 f_kernel,
+							 shmem_dynamic_sz);
+	if (rc != CUDA_SUCCESS)
+	{
+		gpuClientFatal(gclient, "failed on gpuOptimalBlockSize: %s",
+					   cuStrError(rc));
+		return false;
+	}
+	shmem_dynamic_sz =
+		__expand_gpupreagg_prepfunc_buffer(session,
+										   grid_sz, block_sz,
+										   shmem_dynamic_sz,
+										   gcontext->gpumain_shmem_sz_dynamic,
+										   &groupby_prepfn_bufsz,
+										   &groupby_prepfn_nbufs);
+	sz = KERN_GPUTASK_LENGTH(session->kcxt_kvecs_ndims,
+							 session->kcxt_kvecs_bufsz,
+							 grid_sz, block_sz);
+	t_chunk = gpuMemAllocManaged(sz);
+	if (!t_chunk)
+	{
+		gpuClientFatal(gclient, "failed on gpuMemAllocManaged: %lu", sz);
+		return false;
+	}
+	kgtask = (kern_gputask *)t_chunk->m_devptr;
+
+	for (int depth=1; depth <= num_rels; depth++)
+	{
+		if (!h_kmrels->chunks[depth-1].right_outer)
+			continue;
+
+		memset(kgtask, 0, offsetof(kern_gputask, stats[num_rels]));
+		kgtask->grid_sz  = grid_sz;
+		kgtask->block_sz = block_sz;
+		kgtask->kvars_nslots = session->kcxt_kvars_nslots;
+		kgtask->kvecs_bufsz  = session->kcxt_kvecs_bufsz;
+		kgtask->kvecs_ndims  = session->kcxt_kvecs_ndims;
+		kgtask->n_rels       = num_rels;
+		kgtask->right_outer_depth = depth;
+		kgtask->abort_flag   = (uint32_t *)gclient->m_abort_flag;
+		kgtask->groupby_prepfn_bufsz = groupby_prepfn_bufsz;
+		kgtask->groupby_prepfn_nbufs = groupby_prepfn_nbufs;
+		for (;;)
+		{
+			/* kds_final may be expanded on the suspend, like GpuPreAgg */
+			if (kgtask->resume_context &&
+				!__expandGpuQueryGroupByBuffer(gq_buf, kds_final_length))
+			{
+				gpuClientFatal(gclient, "unable to expand GpuPreAgg final buffer");
+				goto bailout;
+			}
+			pthreadRWLockReadLock(&gq_buf->m_kds_final_rwlock);
+			kds_dst = (kern_data_store *)gq_buf->m_kds_final;
+			kds_final_length = gq_buf->m_kds_final_length;
+
+			kern_args[0] = &gclient->session;
+			kern_args[1] = &kgtask;
+			kern_args[2] = &m_kmrels;
+			kern_args[3] = &m_kds_src;
+			kern_args[4] = &m_kds_extra;
+			kern_args[5] = &kds_dst;
+			rc = cuLaunchKernel(f_kernel,
+								grid_sz, 1, 1,
+								block_sz, 1, 1,
+								shmem_dynamic_sz,
+								MY_STREAM_PER_THREAD,
+								kern_args,
+								NULL);
+			if (rc == CUDA_SUCCESS)
+				rc = cuEventRecord(MY_EVENT_PER_THREAD, MY_STREAM_PER_THREAD);
+			if (rc == CUDA_SUCCESS)
+				rc = cuEventSynchronize(MY_EVENT_PER_THREAD);
+			pthreadRWLockUnlock(&gq_buf->m_kds_final_rwlock);
+			if (rc != CUDA_SUCCESS)
+			{
+				gpuClientFatal(gclient, "failed on GpuJoin RIGHT OUTER kernel: %s",
+							   cuStrError(rc));
+				goto bailout;
+			}
+			if (kgtask->kerror.errcode == ERRCODE_CPU_FALLBACK)
+			{
+				/* rows already merged to kds_final cannot be re-executed */
+				gpuClientELog(gclient, "CPU fallback is not available on RIGHT OUTER JOIN rows by GPU: %s",
+							  kgtask->kerror.message);
+				goto bailout;
+			}
+			else if (kgtask->kerror.errcode != ERRCODE_STROM_SUCCESS)
+			{
+				__gpuClientELogRaw(gclient, &kgtask->kerror);
+				goto bailout;
+			}
+			if (kgtask->suspend_count == 0)
+				break;
+			if (gpuServiceGoingTerminate())
+			{
+				gpuClientFatal(gclient, "GpuService is going to terminate during GpuJoin kernel suspend/resume");
+				goto bailout;
+			}
+			kgtask->resume_context = true;
+			kgtask->suspend_count = 0;
+		}
+	}
+	retval = true;
+bailout:
+	gpuMemFree(t_chunk);
+	return retval;
+}
+
+/* ----------------------------------------------------------------
+ *
+ * gpuservHandleGpuTaskFinal
+ *
+ * ----------------------------------------------------------------
+ */
+static void
+gpuservHandleGpuTaskFinal(gpuClient *gclient, XpuCommand *xcmd)
+{
+	kern_final_task *kfin = &xcmd->u.fin;
+	gpuQueryBuffer *gq_buf = gclient->gq_buf;
+	XpuCommand		resp;
+	kern_data_store	*kds_final = NULL;
+	kern_data_store **kds_array = &kds_final;
+	gpuMemChunk	   *topk_chunk = NULL;
+	gpuMemChunk	   *final_chunk = NULL;
+
+	memset(&resp, 0, sizeof(XpuCommand));
+	resp.magic = XpuCommandMagicNumber;
+	resp.tag   = XpuCommandTag__Success;
+	resp.u.results.chunks_offset = MAXALIGN(offsetof(XpuCommand, u.results.stats));
+	resp.u.results.chunks_nitems = 0;
+
+	if (kfin->final_this_device && gq_buf)
+	{
+		/*
+		 * Is the outer-join-map written back to the host buffer?
+		 */
+		if (gq_buf->m_kmrels != 0UL &&
+			gq_buf->h_kmrels != NULL)
+		{
+			kern_multirels *h_kmrels = (kern_multirels *)gq_buf->h_kmrels;
+
+			for (int i=0; i < h_kmrels->num_rels; i++)
+			{
+				kern_data_store *kds = KERN_MULTIRELS_INNER_KDS(h_kmrels, i);
+				bool   *h_ojmap = KERN_MULTIRELS_OUTER_JOIN_MAP(h_kmrels, i);
+				bool   *d_ojmap;
+
+				if (!h_ojmap)
+					continue;
+				resp.u.results.final_this_device = true;
+				if (gq_buf->kmrels_mode == GQBUF_MODE__ZEROCOPY)
+					continue;	/* GPU kernel already updated the host buffer */
+				if (gq_buf->kmrels_mode == GQBUF_MODE__DEVICE)
+				{
+					d_ojmap = malloc(kds->nitems);
+					if (!d_ojmap ||
+						!__gpuQueryBufferMemcpyDtoH(GQBUF_MODE__DEVICE, d_ojmap,
+													gq_buf->m_kmrels +
+													h_kmrels->chunks[i].ojmap_offset,
+													kds->nitems))
+					{
+						if (d_ojmap)
+							free(d_ojmap);
+						gpuClientFatal(gclient, "unable to write back the outer-join-map");
+						return;
+					}
+					for (uint32_t j=0; j < kds->nitems; j++)
+						h_ojmap[j] |= d_ojmap[j];
+					free(d_ojmap);
+				}
+				else
+				{
+					kern_multirels *d_kmrels = (kern_multirels *)gq_buf->m_kmrels;
+
+					d_ojmap = KERN_MULTIRELS_OUTER_JOIN_MAP(d_kmrels, i);
+					for (uint32_t j=0; j < kds->nitems; j++)
+						h_ojmap[j] |= d_ojmap[j];
+				}
+			}
+		}
+
+		/*
+		 * RIGHT OUTER JOIN rows are emitted by the GPU device, if GpuPreAgg
+		 * on the single device. Elsewhere, CPU fallback handles them.
+		 */
+		if (kfin->final_right_outer &&
+			kfin->final_plan_node &&
+			gq_buf->m_kmrels != 0UL &&
+			gq_buf->h_kmrels != NULL &&
+			gq_buf->m_kds_final != 0UL &&
+			gclient->session->xpucode_projection == 0 &&
+			gclient->session->groupby_nsiblings <= 1)
+		{
+			if (!__gpuservGpuJoinRightOuter(gclient, gq_buf))
+				return;
+			resp.u.results.final_right_outer = true;
+		}
+
+		/*
+		 * Is the GpuPreAgg final buffer written back?
+		 *
+		 * If the kds_final is shared by the sibling sessions of the
+		 * partition-wise GpuPreAgg, only the last one writes back.
+		 */
+		if (gq_buf->m_kds_final != 0UL &&
+			(gclient->session->groupby_nsiblings <= 1 ||
+			 __atomic_add_fetch(&gq_buf->m_kds_final_nfinals, 1,
+								__ATOMIC_SEQ_CST) == gclient->session->groupby_nsiblings))
+		{
+			kds_final = (kern_data_store *)gq_buf->m_kds_final;
+			if (gq_buf->kds_final_mode == GQBUF_MODE__DEVICE)
+			{
+				/* device memory is not visible to the host; copy it first */
+				final_chunk = gpuMemAllocManaged(gq_buf->m_kds_final_length);
+				if (!final_chunk ||
+					!__gpuQueryBufferMemcpyDtoH(GQBUF_MODE__DEVICE,
+												(void *)final_chunk->m_devptr,
+												gq_buf->m_kds_final,
+												gq_buf->m_kds_final_length))
+				{
+					if (final_chunk)
+						gpuMemFree(final_chunk);
+					gpuClientFatal(gclient, "unable to write back GpuPreAgg final buffer");
+					return;
+				}
+				kds_final = (kern_data_store *)final_chunk->m_devptr;
+			}
+			resp.u.results.chunks_nitems = 1;
+			resp.u.results.final_this_device = true;
+			/*
+			 * GPU top-k on the unique groups, if ORDER BY ... LIMIT is
+			 * on the GpuPreAgg without upper Agg node.
+			 */
+			if (gclient->session->gpusort_limit > 0 &&
+				!__gpuservGpuSortTopK(gclient, 1, &kds_final, &topk_chunk))
+			{
+				if (final_chunk)
+					gpuMemFree(final_chunk);
+				return;
+			}
+		}
+
+		/*
+		 * Is the GpuWindow results written back?
+		 */
+		if (gclient->session->gpuwin_desc != 0 &&
+			gq_buf->win_nchunks > 0)
+		{
+			if (!__gpuservGpuWindowExec(gclient, gq_buf))
+				return;
+			kds_array = alloca(sizeof(kern_data_store *) * gq_buf->win_nchunks);
+			for (int i=0; i < gq_buf->win_nchunks; i++)
+				kds_array[i] = (kern_data_store *)gq_buf->win_chunks[i]->m_devptr;
+			resp.u.results.chunks_nitems = gq_buf->win_nchunks;
+			resp.u.results.final_this_device = true;
+		}
+	}
+	resp.u.results.final_plan_node = kfin->final_plan_node;
+
+	gpuClientWriteBack(gclient, &resp,
+					   resp.u.results.chunks_offset,
+					   resp.u.results.chunks_nitems,
+					   kds_array);
+	if (topk_chunk)
+		gpuMemFree(topk_chunk);
+	if (final_chunk)
+		gpuMemFree(final_chunk);
+}
+
+/*
+ * __gpuservValidateRemoteCommand
+ *
+ * The commands from the remote clients are checked prior to the handlers,
+ * because the offsets and lengths in the command are used as-is on the
+ * host and device memory. Every offset of the command must be within the
+ * xcmd->length. The payload of xpucode is also checked for each opcode;
+ * slot-ids, kvecs-offsets and depth must be within the session, and Const
+ * or Param datum must be within the command.
+ */
+#define __REMOTE_RANGE_IS_VALID(avail,offset,length)			\
+	((uint64_t)(offset) <= (uint64_t)(avail) &&					\
+	 (uint64_t)(length) <= (uint64_t)(avail) - (uint64_t)(offset))
+
+#define GPUSERV_REMOTE_KEXP_MAX_DEPTH	1000
+
+typedef struct
+{
+	gpuContext *gcontext;
+	const kern_session_info *session;
+	uint64_t	avail;			/* length of the session */
+	char	   *emsg;
+	size_t		emsg_sz;
+} gpuServRemoteValidator;
+
+static bool	__gpuservValidateRemoteKexp(gpuServRemoteValidator *rv,
+										const kern_expression *kexp,
+										int depth);
+
+/*
+ * __gpuservRemoteOpcodeIsAllowed
+ *
+ * Some device functions take the payload that is built by the host code
+ * for the device (hash set of ScalarArrayOpHash, DFA tables of regular
+ * expression, skip tables of LIKE, compiled JSONPath programs, and the
+ * extension's functions), but GPU service cannot validate them on behalf
+ * of the device code. So, remote clients cannot use these opcodes.
+ * GiST-index is available only with the inner buffer, never from remote.
+ */
+static bool
+__gpuservRemoteOpcodeIsAllowed(FuncOpCode opcode)
+{
+	switch (opcode)
+	{
+		case FuncOpCode__ScalarArrayOpHash:
+		case FuncOpCode__textregex_dfa:
+		case FuncOpCode__textlike_substr:
+		case FuncOpCode__jsonb_path_exists_prog:
+		case FuncOpCode__jsonb_path_match_prog:
+		case FuncOpCode__GiSTEval:
+			return false;
+		default:
+			break;
+	}
+	return (opcode < FuncOpCode__BuiltInMax);
+}
+
+/*
+ * gpuservRemoteKexpIsSupported
+ *
+ * It checks whether the expression tree built by the local code generator
+ * runs on the remote GPU service; called by the client side.
+ */
+bool
+gpuservRemoteKexpIsSupported(const kern_expression *kexp)
+{
+	const kern_expression *karg;
+	int			i;
+
+	if (!__gpuservRemoteOpcodeIsAllowed(kexp->opcode))
+		return false;
+	if (kexp->opcode == FuncOpCode__Packed)
+	{
+		for (i=0; i < kexp->u.pack.npacked; i++)
+		{
+			uint32_t	offset = kexp->u.pack.offset[i];
+
+			if (offset != 0 &&
+				!gpuservRemoteKexpIsSupported((const kern_expression *)
+											  ((const char *)kexp + offset)))
+				return false;
+		}
+	}
+	else if (kexp->opcode == FuncOpCode__CaseWhenExpr)
+	{
+		if (kexp->u.casewhen.case_comp != 0 &&
+			!gpuservRemoteKexpIsSupported((const kern_expression *)
+										  ((const char *)kexp +
+										   kexp->u.casewhen.case_comp)))
+			return false;
+		if (kexp->u.casewhen.case_else != 0 &&
+			!gpuservRemoteKexpIsSupported((const kern_expression *)
+										  ((const char *)kexp +
+										   kexp->u.casewhen.case_else)))
+			return false;
+	}
+	for (i=0, karg = KEXP_FIRST_ARG(kexp);
+		 i < kexp->nr_args;
+		 i++, karg = KEXP_NEXT_ARG(karg))
+	{
+		if (!gpuservRemoteKexpIsSupported(karg))
+			return false;
+	}
+	return true;
+}
+
+static const gpuDevTypeEntry *
+__gpuservRemoteLookupType(gpuServRemoteValidator *rv, TypeOpCode type_code)
+{
+	return hash_search(rv->gcontext->cuda_type_htab,
+					   &type_code, HASH_FIND, NULL);
+}
+
+/*
+ * __gpuservValidateRemoteDatum
+ *
+ * It checks the datum of ConstExpr and ParamExpr is within the 'avail'
+ * bytes, according to the type length; device code reads them by the
+ * xpu_datum_heap_read handler.
+ */
+static bool
+__gpuservValidateRemoteDatum(const gpuDevTypeEntry *dtype,
+							 const char *addr, uint64_t avail)
+{
+	if (dtype->type_length > 0)
+		return (dtype->type_length <= avail);
+	if (dtype->type_length == -1)
+	{
+		if (avail < 1 || VARATT_IS_EXTERNAL(addr))
+			return false;
+		if (!VARATT_IS_1B(addr) && avail < VARHDRSZ)
+			return false;
+		return (VARSIZE_ANY(addr) <= avail);
+	}
+	if (dtype->type_length == -2)
+		return (memchr(addr, '\0', avail) != NULL);
+	return false;
+}
+
+#define __REMOTE_SLOT_IS_VALID(rv,slot_id)		\
+	((int64_t)(slot_id) >= 0 &&					\
+	 (int64_t)(slot_id) < (int64_t)(rv)->session->kcxt_kvars_nslots)
+#define __REMOTE_DEPTH_IS_VALID(rv,depth)		\
+	((int64_t)(depth) >= 0 &&					\
+	 (int64_t)(depth) < (int64_t)(rv)->session->kcxt_kvecs_ndims)
+
+static bool
+__gpuservValidateRemoteKvecs(gpuServRemoteValidator *rv,
+							 int32_t kvecs_offset, TypeOpCode type_code)
+{
+	const gpuDevTypeEntry *dtype = __gpuservRemoteLookupType(rv, type_code);
+
+	return (dtype != NULL &&
+			kvecs_offset >= 0 &&
+			__REMOTE_RANGE_IS_VALID(rv->session->kcxt_kvecs_bufsz,
+									kvecs_offset, dtype->kvec_sizeof));
+}
+
+static bool
+__gpuservValidateRemoteKarg(gpuServRemoteValidator *rv,
+							const kern_expression *kexp,
+							uint32_t offset, int depth)
+{
+	const kern_expression *karg = (const kern_expression *)
+		((const char *)kexp + offset);
+
+	if (!__REMOTE_RANGE_IS_VALID(kexp->len, offset,
+								 offsetof(kern_expression, u)) ||
+		karg->len < offsetof(kern_expression, u) + sizeof(uint32_t) ||
+		!__KEXP_IS_VALID(kexp, karg))
+	{
+		snprintf(rv->emsg, rv->emsg_sz,
+				 "OpenSession has corrupted xpucode (opcode=%u)",
+				 (uint32_t)kexp->opcode);
+		return false;
+	}
+	return __gpuservValidateRemoteKexp(rv, karg, depth + 1);
+}
+
+static bool
+__gpuservValidateRemoteKexp(gpuServRemoteValidator *rv,
+							const kern_expression *kexp,
+							int depth)
+{
+	const kern_session_info *session = rv->session;
+	const gpuDevTypeEntry *dtype;
+	uint64_t	payload;	/* bytes of kexp->u, except for the magic */
+	uint32_t	offset;
+
+	if (depth > GPUSERV_REMOTE_KEXP_MAX_DEPTH)
+	{
+		snprintf(rv->emsg, rv->emsg_sz,
+				 "OpenSession has too deep xpucode");
+		return false;
+	}
+	if (!__gpuservRemoteOpcodeIsAllowed(kexp->opcode))
+	{
+		snprintf(rv->emsg, rv->emsg_sz,
+				 "remote session cannot use the device function (opcode=%u)",
+				 (uint32_t)kexp->opcode);
+		return false;
+	}
+	dtype = __gpuservRemoteLookupType(rv, kexp->exptype);
+	if (!dtype)
+	{
+		snprintf(rv->emsg, rv->emsg_sz,
+				 "OpenSession has unknown device type (type=%u)",
+				 (uint32_t)kexp->exptype);
+		return false;
+	}
+	payload = kexp->len - sizeof(uint32_t) - offsetof(kern_expression, u);
+
+	switch (kexp->opcode)
+	{
+		case FuncOpCode__ConstExpr:
+			if (payload < offsetof(kern_expression, u.c.const_value) -
+						  offsetof(kern_expression, u))
+				goto corrupted;
+			if (!kexp->u.c.const_isnull &&
+				!__gpuservValidateRemoteDatum(dtype, kexp->u.c.const_value,
+											  kexp->len - sizeof(uint32_t) -
+											  offsetof(kern_expression,
+													   u.c.const_value)))
+				goto corrupted;
+			break;
+
+		case FuncOpCode__ParamExpr:
+			if (payload < sizeof(kexp->u.p.param_id))
+				goto corrupted;
+			if (kexp->u.p.param_id < session->nparams &&
+				session->poffset[kexp->u.p.param_id] != 0)
+			{
+				offset = session->poffset[kexp->u.p.param_id];
+				if (!__gpuservValidateRemoteDatum(dtype,
+												  (const char *)session + offset,
+												  rv->avail - offset))
+					goto corrupted;
+			}
+			break;
+
+		case FuncOpCode__VarExpr:
+			if (payload < offsetof(kern_expression, u.v.__data) -
+						  offsetof(kern_expression, u))
+				goto corrupted;
+			if (kexp->u.v.var_offset < 0
+				? !__REMOTE_SLOT_IS_VALID(rv, kexp->u.v.var_slot_id)
+				: !__gpuservValidateRemoteKvecs(rv, kexp->u.v.var_offset,
+												kexp->exptype))
+				goto corrupted;
+			break;
+
+		case FuncOpCode__CaseWhenExpr:
+			if (payload < offsetof(kern_expression, u.casewhen.data) -
+						  offsetof(kern_expression, u))
+				goto corrupted;
+			offset = kexp->u.casewhen.case_comp;
+			if (offset != 0 && !__gpuservValidateRemoteKarg(rv, kexp, offset, depth))
+				return false;
+			offset = kexp->u.casewhen.case_else;
+			if (offset != 0 && !__gpuservValidateRemoteKarg(rv, kexp, offset, depth))
+				return false;
+			break;
+
+		case FuncOpCode__ScalarArrayOpAny:
+		case FuncOpCode__ScalarArrayOpAll:
+			if (payload < offsetof(kern_expression, u.saop.data) -
+						  offsetof(kern_expression, u) ||
+				!__REMOTE_SLOT_IS_VALID(rv, kexp->u.saop.elem_slot_id) ||
+				kexp->u.saop.hset_offset != 0)
+				goto corrupted;
+			break;
+
+		case FuncOpCode__FieldSelectExpr:
+		case FuncOpCode__ArraySubscriptExpr:
+			if (payload < offsetof(kern_expression, u.fsel.data) -
+						  offsetof(kern_expression, u) ||
+				!__REMOTE_SLOT_IS_VALID(rv, kexp->u.fsel.src_slot_id))
+				goto corrupted;
+			break;
+
+		case FuncOpCode__LoadVars:
+			if (payload < offsetof(kern_expression, u.load.desc) -
+						  offsetof(kern_expression, u) ||
+				kexp->u.load.nitems < 0 ||
+				payload < offsetof(kern_expression, u.load.desc) -
+						  offsetof(kern_expression, u) +
+						  sizeof(kern_varload_desc) * (uint64_t)kexp->u.load.nitems ||
+				kexp->u.load.proj_nitems < 0 ||
+				kexp->u.load.proj_nitems > kexp->u.load.nitems ||
+				(kexp->u.load.depth != SPECIAL_DEPTH__PREAGG_FINAL &&
+				 !__REMOTE_DEPTH_IS_VALID(rv, kexp->u.load.depth)))
+				goto corrupted;
+			for (int i=0; i < kexp->u.load.nitems; i++)
+			{
+				if (!__REMOTE_SLOT_IS_VALID(rv, kexp->u.load.desc[i].vl_slot_id))
+					goto corrupted;
+			}
+			break;
+
+		case FuncOpCode__MoveVars:
+			if (payload < offsetof(kern_expression, u.move.desc) -
+						  offsetof(kern_expression, u) ||
+				kexp->u.move.nitems < 0 ||
+				payload < offsetof(kern_expression, u.move.desc) -
+						  offsetof(kern_expression, u) +
+						  sizeof(kern_varmove_desc) * (uint64_t)kexp->u.move.nitems ||
+				!__REMOTE_DEPTH_IS_VALID(rv, kexp->u.move.depth))
+				goto corrupted;
+			for (int i=0; i < kexp->u.move.nitems; i++)
+			{
+				const kern_varmove_desc *vm_desc = &kexp->u.move.desc[i];
+				const kern_varslot_desc *vs_desc;
+
+				if (!__REMOTE_SLOT_IS_VALID(rv, vm_desc->vm_slot_id))
+					goto corrupted;
+				vs_desc = (const kern_varslot_desc *)
+					((const char *)session + session->kcxt_kvars_defs) + vm_desc->vm_slot_id;
+				if (!__gpuservValidateRemoteKvecs(rv, vm_desc->vm_offset,
+												  vs_desc->vs_type_code))
+					goto corrupted;
+			}
+			break;
+
+		case FuncOpCode__SaveExpr:
+			if (payload < offsetof(kern_expression, u.save.data) -
+						  offsetof(kern_expression, u) ||
+				!__REMOTE_SLOT_IS_VALID(rv, kexp->u.save.sv_slot_id))
+				goto corrupted;
+			break;
+
+		case FuncOpCode__AggFuncs:
+			if (payload < offsetof(kern_expression, u.pagg.desc) -
+						  offsetof(kern_expression, u) ||
+				kexp->u.pagg.nattrs < 0 ||
+				payload < offsetof(kern_expression, u.pagg.desc) -
+						  offsetof(kern_expression, u) +
+						  sizeof(kern_aggregate_desc) * (uint64_t)kexp->u.pagg.nattrs)
+				goto corrupted;
+			for (int i=0; i < kexp->u.pagg.nattrs; i++)
+			{
+				const kern_aggregate_desc *desc = &kexp->u.pagg.desc[i];
+
+				/* arg1 is referenced by the covariance only */
+				if (desc->action != KAGG_ACTION__NROWS_ANY &&
+					!__REMOTE_SLOT_IS_VALID(rv, desc->arg0_slot_id))
+					goto corrupted;
+				if (desc->action == KAGG_ACTION__COVAR &&
+					!__REMOTE_SLOT_IS_VALID(rv, desc->arg1_slot_id))
+					goto corrupted;
+			}
+			break;
+
+		case FuncOpCode__Projection:
+			if (payload < offsetof(kern_expression, u.proj.slot_id) -
+						  offsetof(kern_expression, u) ||
+				kexp->u.proj.nattrs < 0 ||
+				payload < offsetof(kern_expression, u.proj.slot_id) -
+						  offsetof(kern_expression, u) +
+						  sizeof(uint16_t) * (uint64_t)kexp->u.proj.nattrs)
+				goto corrupted;
+			for (int i=0; i < kexp->u.proj.nattrs; i++)
+			{
+				if (!__REMOTE_SLOT_IS_VALID(rv, kexp->u.proj.slot_id[i]))
+					goto corrupted;
+			}
+			break;
+
+		case FuncOpCode__Packed:
+			if (payload < offsetof(kern_expression, u.pack.offset) -
+						  offsetof(kern_expression, u) ||
+				payload < offsetof(kern_expression, u.pack.offset) -
+						  offsetof(kern_expression, u) +
+						  sizeof(uint32_t) * (uint64_t)kexp->u.pack.npacked)
+				goto corrupted;
+			for (int i=0; i < kexp->u.pack.npacked; i++)
+			{
+				offset = kexp->u.pack.offset[i];
+				if (offset != 0 && !__gpuservValidateRemoteKarg(rv, kexp, offset, depth))
+					return false;
+			}
+			break;
+
+		default:
+			/* no payload for the other opcodes */
+			break;
+	}
+	offset = kexp->args_offset;
+	for (int i=0; i < kexp->nr_args; i++)
+	{
+		const kern_expression *karg = (const kern_expression *)
+			((const char *)kexp + offset);
+
+		if (!__gpuservValidateRemoteKarg(rv, kexp, offset, depth))
+			return false;
+		offset += MAXALIGN(karg->len);
+	}
+	return true;
+
+corrupted:
+	snprintf(rv->emsg, rv->emsg_sz,
+			 "OpenSession has corrupted xpucode (opcode=%u)",
+			 (uint32_t)kexp->opcode);
+	return false;
+}
+#undef __REMOTE_SLOT_IS_VALID
+#undef __REMOTE_DEPTH_IS_VALID
+
+static bool
+__gpuservValidateRemoteSession(gpuContext *gcontext,
+							   const kern_session_info *session,
+							   uint64_t avail,
+							   char *emsg, size_t emsg_sz)
+{
+	gpuServRemoteValidator rv;
+	const char *base = (const char *)session;
+	uint32_t	xpucode_offsets[] = {
+		session->xpucode_load_vars_packed,
+		session->xpucode_move_vars_packed,
+		session->xpucode_scan_quals,
+		session->xpucode_join_quals_packed,
+		session->xpucode_hash_values_packed,
+		session->xpucode_hash_inner_packed,
+		session->xpucode_gist_evals_packed,
+		session->xpucode_range_keys_packed,
+		session->xpucode_projection,
+		session->xpucode_groupby_keyhash,
+		session->xpucode_groupby_keyload,
+		session->xpucode_groupby_keycomp,
+		session->xpucode_groupby_actions,
+	};
+
+	if (!__REMOTE_RANGE_IS_VALID(avail, offsetof(kern_session_info, poffset),
+								 sizeof(uint32_t) * (uint64_t)session->nparams))
+	{
+		snprintf(emsg, emsg_sz, "OpenSession command is too short");
+		return false;
+	}
+	/* kvars-slot descriptors */
+	if (session->kcxt_kvars_nslots > session->kcxt_kvars_nrooms ||
+		(session->kcxt_kvars_nslots > 0 && session->kcxt_kvars_defs == 0) ||
+		(session->kcxt_kvars_defs != 0 &&
+		 !__REMOTE_RANGE_IS_VALID(avail, session->kcxt_kvars_defs,
+								  sizeof(kern_varslot_desc) *
+								  (uint64_t)session->kcxt_kvars_nrooms)))
+	{
+		snprintf(emsg, emsg_sz, "OpenSession has corrupted kvars-slot definitions");
+		return false;
+	}
+	for (int i=0; session->kcxt_kvars_defs != 0 &&
+			 i < session->kcxt_kvars_nrooms; i++)
+	{
+		const kern_varslot_desc *vs_desc = (const kern_varslot_desc *)
+			(base + session->kcxt_kvars_defs) + i;
+
+		if ((uint32_t)vs_desc->idx_subfield +
+			(uint32_t)vs_desc->num_subfield > session->kcxt_kvars_nrooms)
+		{
+			snprintf(emsg, emsg_sz, "OpenSession has corrupted kvars-slot definitions");
+			return false;
+		}
+	}
+	/* executor parameters */
+	for (int i=0; i < session->nparams; i++)
+	{
+		if (session->poffset[i] != 0 &&
+			!__REMOTE_RANGE_IS_VALID(avail, session->poffset[i], 1))
+		{
+			snprintf(emsg, emsg_sz, "OpenSession has corrupted parameter ($%d)", i+1);
+			return false;
+		}
+	}
+	/* xpucode */
+	rv.gcontext = gcontext;
+	rv.session = session;
+	rv.avail = avail;
+	rv.emsg = emsg;
+	rv.emsg_sz = emsg_sz;
+	for (int i=0; i < lengthof(xpucode_offsets); i++)
+	{
+		const kern_expression *kexp;
+		uint32_t	offset = xpucode_offsets[i];
+
+		if (offset == 0)
+			continue;
+		kexp = (const kern_expression *)(base + offset);
+		if (!__REMOTE_RANGE_IS_VALID(avail, offset, offsetof(kern_expression, u)) ||
+			kexp->len < offsetof(kern_expression, u) + sizeof(uint32_t) ||
+			!__REMOTE_RANGE_IS_VALID(avail, offset, kexp->len) ||
+			*((const uint32_t *)((const char *)kexp + kexp->len - sizeof(uint32_t))) !=
+			(KERN_EXPRESSION_MAGIC
+			 ^ ((uint32_t)kexp->exptype << 6)
+			 ^ ((uint32_t)kexp->opcode << 14)))
+		{
+			snprintf(emsg, emsg_sz, "OpenSession has corrupted xpucode");
+			return false;
+		}
+		if (!__gpuservValidateRemoteKexp(&rv, kexp, 0))
+			return false;
+	}
+	/* transaction state */
+	if (session->session_xact_state != 0)
+	{
+		const SerializedTransactionState *xstate = (const SerializedTransactionState *)
+			(base + session->session_xact_state);
+
+		if (!__REMOTE_RANGE_IS_VALID(avail, session->session_xact_state,
+									 offsetof(SerializedTransactionState,
+											  parallelCurrentXids)) ||
+			xstate->nParallelCurrentXids < 0 ||
+			!__REMOTE_RANGE_IS_VALID(avail, session->session_xact_state,
+									 offsetof(SerializedTransactionState,
+											  parallelCurrentXids) +
+									 sizeof(TransactionId) *
+									 (uint64_t)xstate->nParallelCurrentXids))
+		{
+			snprintf(emsg, emsg_sz, "OpenSession has corrupted transaction state");
+			return false;
+		}
+	}
+	/* MVCC snapshot */
+	if (session->session_snapshot != 0)
+	{
+		const kern_snapshot_info *snapshot = (const kern_snapshot_info *)
+			(base + session->session_snapshot);
+
+		if (!__REMOTE_RANGE_IS_VALID(avail, session->session_snapshot,
+									 offsetof(kern_snapshot_info, xip)) ||
+			!__REMOTE_RANGE_IS_VALID(avail, session->session_snapshot,
+									 offsetof(kern_snapshot_info, xip) +
+									 sizeof(TransactionId) *
+									 ((uint64_t)snapshot->xcnt +
+									  (uint64_t)snapshot->subxcnt)))
+		{
+			snprintf(emsg, emsg_sz, "OpenSession has corrupted snapshot");
+			return false;
+		}
+	}
+	/* timezone */
+	if (session->session_timezone != 0)
+	{
+		const struct pg_tz *tz = (const struct pg_tz *)
+			(base + session->session_timezone);
+
+		if (!__REMOTE_RANGE_IS_VALID(avail, session->session_timezone,
+									 sizeof(struct pg_tz)) ||
+			tz->state.leapcnt < 0 || tz->state.leapcnt > TZ_MAX_LEAPS ||
+			tz->state.timecnt < 0 || tz->state.timecnt > TZ_MAX_TIMES ||
+			tz->state.typecnt < 0 || tz->state.typecnt > TZ_MAX_TYPES ||
+			tz->state.charcnt < 0 || tz->state.charcnt > sizeof(tz->state.chars))
+		{
+			snprintf(emsg, emsg_sz, "OpenSession has corrupted timezone");
+			return false;
+		}
+	}
+	/* database encoding */
+	if (session->session_encode != 0)
+	{
+		const xpu_encode_info *encode = (const xpu_encode_info *)
+			(base + session->session_encode);
+
+		if (!__REMOTE_RANGE_IS_VALID(avail, session->session_encode,
+									 sizeof(xpu_encode_info)) ||
+			!memchr(encode->encname, '\0', sizeof(encode->encname)))
+		{
+			snprintf(emsg, emsg_sz, "OpenSession has corrupted encoding");
+			return false;
+		}
+	}
+	/* window functions */
+	if (session->gpuwin_desc != 0)
+	{
+		const kern_window_desc *kwin = (const kern_window_desc *)
+			(base + session->gpuwin_desc);
+
+		if (!__REMOTE_RANGE_IS_VALID(avail, session->gpuwin_desc,
+									 offsetof(kern_window_desc, funcs)) ||
+			kwin->nkeys > KWIN_MAX_KEYS ||
+			kwin->npart_keys > kwin->nkeys ||
+			kwin->nfuncs > KWIN_MAX_FUNCS ||
+			!__REMOTE_RANGE_IS_VALID(avail, session->gpuwin_desc,
+									 offsetof(kern_window_desc, funcs) +
+									 sizeof(kern_window_func) * kwin->nfuncs))
+		{
+			snprintf(emsg, emsg_sz, "OpenSession has corrupted window functions");
+			return false;
+		}
+	}
+	/* header portion of kds_final */
+	if (session->groupby_kds_final != 0)
+	{
+		const kern_data_store *kds = (const kern_data_store *)
+			(base + session->groupby_kds_final);
+
+		if (!__REMOTE_RANGE_IS_VALID(avail, session->groupby_kds_final,
+									 offsetof(kern_data_store, colmeta)) ||
+			!__REMOTE_RANGE_IS_VALID(avail, session->groupby_kds_final,
+									 KDS_HEAD_LENGTH(kds)))
+		{
+			snprintf(emsg, emsg_sz, "OpenSession has corrupted kds_final");
+			return false;
+		}
+	}
+	/* group-by actions are written to kds_final */
+	if (session->xpucode_groupby_actions != 0)
+	{
+		const kern_expression *kexp = (const kern_expression *)
+			(base + session->xpucode_groupby_actions);
+		const kern_data_store *kds = (const kern_data_store *)
+			(base + session->groupby_kds_final);
+
+		if (kexp->opcode != FuncOpCode__AggFuncs ||
+			session->groupby_kds_final == 0 ||
+			kexp->u.pagg.nattrs > kds->ncols)
+		{
+			snprintf(emsg, emsg_sz, "OpenSession has corrupted group-by actions");
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool
+__gpuservValidateRemoteTask(const XpuCommand *xcmd,
+							char *emsg, size_t emsg_sz)
 {
-	kern_final_task *kfin = &xcmd->u.fin;
-	gpuQueryBuffer *gq_buf = gclient->gq_buf;
-	XpuCommand		resp;
-	kern_data_store	*kds_final = NULL;
-
-	memset(&resp, 0, sizeof(XpuCommand));
-	resp.magic = XpuCommandMagicNumber;
-	resp.tag   = XpuCommandTag__Success;
-	resp.u.results.chunks_offset = MAXALIGN(offsetof(XpuCommand, u.results.stats));
-	resp.u.results.chunks_nitems = 0;
+	const kern_exec_task *task = &xcmd->u.task;
+	const char *base = (const char *)xcmd;
+	uint64_t	avail = xcmd->length;
+	const strom_io_vector *iovec = NULL;
+	const kern_data_store *kds;
 
-	if (kfin->final_this_device && gq_buf)
+	if (avail < offsetof(XpuCommand, u.task.data))
 	{
-		/*
-		 * Is the outer-join-map written back to the host buffer?
-		 */
-		if (gq_buf->m_kmrels != 0UL &&
-			gq_buf->h_kmrels != NULL)
+		snprintf(emsg, emsg_sz, "XpuTaskExec command is too short");
+		return false;
+	}
+	if (task->kds_src_pathname != 0 &&
+		(task->kds_src_pathname >= avail ||
+		 !memchr(base + task->kds_src_pathname, '\0',
+				 avail - task->kds_src_pathname)))
+	{
+		snprintf(emsg, emsg_sz, "XpuTaskExec has corrupted pathname");
+		return false;
+	}
+	if (task->kds_src_iovec != 0)
+	{
+		iovec = (const strom_io_vector *)(base + task->kds_src_iovec);
+		if (!__REMOTE_RANGE_IS_VALID(avail, task->kds_src_iovec,
+									 offsetof(strom_io_vector, ioc)) ||
+			!__REMOTE_RANGE_IS_VALID(avail, task->kds_src_iovec,
+									 offsetof(strom_io_vector, ioc) +
+									 sizeof(strom_io_chunk) * (uint64_t)iovec->nr_chunks))
 		{
-			kern_multirels *d_kmrels = (kern_multirels *)gq_buf->m_kmrels;
-			kern_multirels *h_kmrels = (kern_multirels *)gq_buf->h_kmrels;
+			snprintf(emsg, emsg_sz, "XpuTaskExec has corrupted I/O vector");
+			return false;
+		}
+	}
+	if (task->kds_src_offset == 0)
+	{
+		snprintf(emsg, emsg_sz, "remote session cannot use GpuCache");
+		return false;
+	}
+	kds = (const kern_data_store *)(base + task->kds_src_offset);
+	if (!__REMOTE_RANGE_IS_VALID(avail, task->kds_src_offset,
+								 offsetof(kern_data_store, colmeta)) ||
+		!__REMOTE_RANGE_IS_VALID(avail, task->kds_src_offset,
+								 KDS_HEAD_LENGTH(kds)))
+	{
+		snprintf(emsg, emsg_sz, "XpuTaskExec has corrupted kds_src");
+		return false;
+	}
+	if (kds->format == KDS_FORMAT_ARROW && iovec && iovec->nr_chunks > 0)
+	{
+		uint64_t	head_sz = KDS_HEAD_LENGTH(kds);
 
-			for (int i=0; i < d_kmrels->num_rels; i++)
-			{
-				kern_data_store *kds = KERN_MULTIRELS_INNER_KDS(h_kmrels, i);
-				bool   *d_ojmap = KERN_MULTIRELS_OUTER_JOIN_MAP(d_kmrels, i);
-				bool   *h_ojmap = KERN_MULTIRELS_OUTER_JOIN_MAP(h_kmrels, i);
+		/* the arrow file is loaded onto the kds_src buffer on the device */
+		if (task->kds_src_pathname == 0)
+		{
+			snprintf(emsg, emsg_sz, "XpuTaskExec has no arrow file");
+			return false;
+		}
+		for (int i=0; i < iovec->nr_chunks; i++)
+		{
+			const strom_io_chunk *ioc = &iovec->ioc[i];
 
-				if (d_ojmap && h_ojmap)
-				{
-					for (uint32_t j=0; j < kds->nitems; j++)
-						h_ojmap[j] |= d_ojmap[j];
-					resp.u.results.final_this_device = true;
-				}
+			if (head_sz + (uint64_t)ioc->m_offset +
+				(uint64_t)ioc->nr_pages * PAGE_SIZE > kds->length)
+			{
+				snprintf(emsg, emsg_sz, "XpuTaskExec has I/O chunk out of kds_src");
+				return false;
 			}
 		}
-
-		/*
-		 * Is the GpuPreAgg final buffer written back?
-		 */
-		if (gq_buf->m_kds_final != 0UL)
+	}
+	else if (kds->format == KDS_FORMAT_ARROW && !iovec)
+	{
+		snprintf(emsg, emsg_sz, "XpuTaskExec has no I/O vector for arrow");
+		return false;
+	}
+	else if (!__REMOTE_RANGE_IS_VALID(avail, task->kds_src_offset, kds->length))
+	{
+		/* elsewhere, whole the kds_src must be on the command */
+		snprintf(emsg, emsg_sz, "XpuTaskExec has corrupted kds_src");
+		return false;
+	}
+	if (task->kds_dst_offset != 0)
+	{
+		kds = (const kern_data_store *)(base + task->kds_dst_offset);
+		if (!__REMOTE_RANGE_IS_VALID(avail, task->kds_dst_offset,
+									 offsetof(kern_data_store, colmeta)) ||
+			!__REMOTE_RANGE_IS_VALID(avail, task->kds_dst_offset,
+									 KDS_HEAD_LENGTH(kds)))
 		{
-			kds_final = (kern_data_store *)gq_buf->m_kds_final;
-			resp.u.results.chunks_nitems = 1;
-			resp.u.results.final_this_device = true;
+			snprintf(emsg, emsg_sz, "XpuTaskExec has corrupted kds_dst");
+			return false;
 		}
 	}
-	resp.u.results.final_plan_node = kfin->final_plan_node;
+	if (task->kds_src_shbufs != 0)
+	{
+		snprintf(emsg, emsg_sz, "remote session cannot use the shared buffers");
+		return false;
+	}
+	return true;
+}
 
-	gpuClientWriteBack(gclient, &resp,
-					   resp.u.results.chunks_offset,
-					   resp.u.results.chunks_nitems,
-					   &kds_final);
+static bool
+__gpuservValidateRemoteCommand(gpuContext *gcontext,
+							   const XpuCommand *xcmd,
+							   char *emsg, size_t emsg_sz)
+{
+	switch (xcmd->tag)
+	{
+		case XpuCommandTag__OpenSession:
+			if (xcmd->length < offsetof(XpuCommand, u.session.poffset))
+				break;
+			return __gpuservValidateRemoteSession(gcontext,
+												  &xcmd->u.session,
+												  xcmd->length -
+												  offsetof(XpuCommand, u.session),
+												  emsg, emsg_sz);
+		case XpuCommandTag__XpuTaskExec:
+			return __gpuservValidateRemoteTask(xcmd, emsg, emsg_sz);
+		case XpuCommandTag__XpuTaskFinal:
+			if (xcmd->length < offsetof(XpuCommand, u.fin.data))
+				break;
+			return true;
+		case XpuCommandTag__XpuTaskExecGpuCache:
+			snprintf(emsg, emsg_sz, "remote session cannot use GpuCache");
+			return false;
+		case XpuCommandTag__XpuTaskExecStaged:
+			snprintf(emsg, emsg_sz, "remote session cannot use the pinned staging ring");
+			return false;
+		default:
+			snprintf(emsg, emsg_sz, "unknown XPU command (%d)", (int)xcmd->tag);
+			return false;
+	}
+	snprintf(emsg, emsg_sz, "XPU command (%d) is too short", (int)xcmd->tag);
+	return false;
 }
+#undef __REMOTE_RANGE_IS_VALID
 
 /*
  * gpuservGpuWorkerMain -- actual worker
@@ -2805,10 +8565,13 @@ gpuservGpuWorkerMain(void *__arg)
 	gpuWorker  *gworker = (gpuWorker *)__arg;
 	gpuContext *gcontext = gworker->gcontext;
 	gpuClient  *gclient;
+	uint32_t	home;
 	CUstream	cuda_stream;
 	CUevent		cuda_event;
+	CUevent		cuda_event_begin;
 	CUresult	rc;
 
+	__gpuContextBindNumaNode(gcontext);
 	rc = cuCtxSetCurrent(gcontext->cuda_context);
 	if (rc != CUDA_SUCCESS)
 		__FATAL("failed on cuCtxSetCurrent: %s", cuStrError(rc));
@@ -2816,6 +8579,9 @@ gpuservGpuWorkerMain(void *__arg)
 	if (rc != CUDA_SUCCESS)
 		 __FATAL("failed on cuStreamCreate: %s", cuStrError(rc));
 	rc = cuEventCreate(&cuda_event, CU_EVENT_BLOCKING_SYNC);
+	if (rc != CUDA_SUCCESS)
+		__FATAL("failed on cuEventCreate: %s", cuStrError(rc));
+	rc = cuEventCreate(&cuda_event_begin, CU_EVENT_DEFAULT);
 	if (rc != CUDA_SUCCESS)
 		__FATAL("failed on cuEventCreate: %s", cuStrError(rc));
 
@@ -2825,22 +8591,70 @@ gpuservGpuWorkerMain(void *__arg)
 	MY_CONTEXT_PER_THREAD	= gcontext->cuda_context;
 	MY_STREAM_PER_THREAD	= cuda_stream;
 	MY_EVENT_PER_THREAD		= cuda_event;
+	MY_EVENT_BEGIN_PER_THREAD = cuda_event_begin;
+	if (pgstrom_gpu_mempool_stream_ordered)
+	{
+		CUmemPoolProps	props;
+		CUmemoryPool	mempool;
+		cuuint64_t		threshold;
+
+		memset(&props, 0, sizeof(CUmemPoolProps));
+		props.allocType     = CU_MEM_ALLOCATION_TYPE_PINNED;
+		props.location.type = CU_MEM_LOCATION_TYPE_DEVICE;
+		props.location.id   = gcontext->cuda_device;
+		rc = cuMemPoolCreate(&mempool, &props);
+		if (rc != CUDA_SUCCESS)
+			__gsDebug("failed on cuMemPoolCreate: %s", cuStrError(rc));
+		else
+		{
+			/* keep the released memory in the pool, as the segment size */
+			threshold = ((size_t)pgstrom_gpu_mempool_segment_sz_kb << 10);
+			rc = cuMemPoolSetAttribute(mempool,
+									   CU_MEMPOOL_ATTR_RELEASE_THRESHOLD,
+									   &threshold);
+			if (rc != CUDA_SUCCESS)
+				__gsDebug("failed on cuMemPoolSetAttribute: %s", cuStrError(rc));
+			MY_MEMPOOL_PER_THREAD = mempool;
+		}
+	}
+	if (pgstrom_gpudirect_async_load)
+	{
+		CUstream	load_stream;
+		CUevent		load_event;
+
+		rc = cuStreamCreate(&load_stream, CU_STREAM_NON_BLOCKING);
+		if (rc != CUDA_SUCCESS)
+			__gsDebug("failed on cuStreamCreate: %s", cuStrError(rc));
+		else if ((rc = cuEventCreate(&load_event,
+									 CU_EVENT_DISABLE_TIMING)) != CUDA_SUCCESS)
+		{
+			__gsDebug("failed on cuEventCreate: %s", cuStrError(rc));
+			cuStreamDestroy(load_stream);
+		}
+		else if (!gpuDirectRegisterStream(load_stream))
+		{
+			__gsDebug("unable to register the stream for asynchronous read");
+			cuEventDestroy(load_event);
+			cuStreamDestroy(load_stream);
+		}
+		else
+		{
+			MY_LOAD_STREAM_PER_THREAD = load_stream;
+			MY_LOAD_EVENT_PER_THREAD = load_event;
+		}
+	}
 	pg_memory_barrier();
 
 	__gsDebug("GPU-%d worker thread launched\n", MY_DINDEX_PER_THREAD);
-	
-	pthreadMutexLock(&gcontext->lock);
+
+	home = (pg_atomic_fetch_add_u32(&gcontext->worker_seq, 1) %
+			GPUSERV_COMMAND_NQUEUES);
 	while (!gpuServiceGoingTerminate() && !gworker->termination)
 	{
-		XpuCommand *xcmd;
-		dlist_node *dnode;
+		XpuCommand *xcmd = __gpuServiceFetchCommand(gcontext, home);
 
-		if (!dlist_is_empty(&gcontext->command_list))
+		if (xcmd)
 		{
-			dnode = dlist_pop_head_node(&gcontext->command_list);
-			xcmd = dlist_container(XpuCommand, chain, dnode);
-			pthreadMutexUnlock(&gcontext->lock);
-
 			gclient = xcmd->priv;
 			/*
 			 * MEMO: If the least bit of gclient->refcnt is not set,
@@ -2849,49 +8663,90 @@ gpuservGpuWorkerMain(void *__arg)
 			 */
 			if ((pg_atomic_read_u32(&gclient->refcnt) & 1) == 1)
 			{
-				switch (xcmd->tag)
+				const char *trace_name = __gpuTraceCommandName(xcmd->tag);
+				uint64_t	trace_ts = gpuTraceBegin(gclient);
+				char		emsg[512];
+
+				if (gclient->is_remote &&
+					!__gpuservValidateRemoteCommand(gcontext, xcmd,
+													emsg, sizeof(emsg)))
 				{
-					case XpuCommandTag__OpenSession:
-						if (gpuservHandleOpenSession(gclient, xcmd))
-							xcmd = NULL;	/* session information shall be kept until
-											 * end of the session. */
-						break;
-					case XpuCommandTag__XpuTaskExec:
-					case XpuCommandTag__XpuTaskExecGpuCache:
-						gpuservHandleGpuTaskExec(gclient, xcmd);
-						break;
-					case XpuCommandTag__XpuTaskFinal:
-						gpuservHandleGpuTaskFinal(gclient, xcmd);
-						break;
-					default:
-						gpuClientELog(gclient, "unknown XPU command (%d)",
-									  (int)xcmd->tag);
-						break;
+					gpuClientELog(gclient, "GPU%d: %s",
+								  MY_DINDEX_PER_THREAD, emsg);
+				}
+				else
+				{
+					switch (xcmd->tag)
+					{
+						case XpuCommandTag__OpenSession:
+							if (gpuservHandleOpenSession(gclient, xcmd))
+								xcmd = NULL;	/* session information shall be kept until
+												 * end of the session. */
+							break;
+						case XpuCommandTag__XpuTaskExec:
+						case XpuCommandTag__XpuTaskExecGpuCache:
+							gpuservHandleGpuTaskExec(gclient, xcmd);
+							break;
+						case XpuCommandTag__XpuTaskExecStaged:
+							gpuservHandleGpuTaskExecStaged(gclient, xcmd);
+							break;
+						case XpuCommandTag__XpuTaskFinal:
+							gpuservHandleGpuTaskFinal(gclient, xcmd);
+							break;
+						default:
+							gpuClientELog(gclient, "unknown XPU command (%d)",
+										  (int)xcmd->tag);
+							break;
+					}
 				}
+				gpuTraceComplete(gclient, trace_name, trace_ts, 0);
 			}
 
 			if (xcmd)
 				__gpuServiceFreeCommand(xcmd);
 			gpuClientPut(gclient, false);
-			pthreadMutexLock(&gcontext->lock);
 		}
-		else if (!pthreadCondWaitTimeout(&gcontext->cond,
-										 &gcontext->lock,
-										 5000))
+		else
 		{
+			bool	timeout = false;
+
+			pthreadMutexLock(&gcontext->lock);
+			pg_atomic_fetch_add_u32(&gcontext->num_idle_workers, 1);
+			if (pg_atomic_read_u32(&gcontext->num_queued_cmds) == 0 &&
+				!gpuServiceGoingTerminate() && !gworker->termination)
+				timeout = !pthreadCondWaitTimeout(&gcontext->cond,
+												  &gcontext->lock,
+												  5000);
+			pg_atomic_fetch_sub_u32(&gcontext->num_idle_workers, 1);
 			pthreadMutexUnlock(&gcontext->lock);
 			/* maintenance works */
-			gpuMemoryPoolMaintenance(gcontext);
-			pthreadMutexLock(&gcontext->lock);
+			if (timeout)
+				gpuMemoryPoolMaintenance(gcontext);
 		}
 	}
-	pthreadMutexUnlock(&gcontext->lock);
 
 	/* detach from the gpuContext */
 	pthreadMutexLock(&gcontext->worker_lock);
 	dlist_delete(&gworker->chain);
 	pthreadMutexUnlock(&gcontext->worker_lock);
 	/* release */
+	__gpuservReleaseTaskGraph();
+	if (MY_LOAD_STREAM_PER_THREAD)
+	{
+		cuStreamSynchronize(MY_LOAD_STREAM_PER_THREAD);
+		gpuDirectDeregisterStream(MY_LOAD_STREAM_PER_THREAD);
+		cuEventDestroy(MY_LOAD_EVENT_PER_THREAD);
+		cuStreamDestroy(MY_LOAD_STREAM_PER_THREAD);
+		MY_LOAD_STREAM_PER_THREAD = NULL;
+		MY_LOAD_EVENT_PER_THREAD = NULL;
+	}
+	if (MY_MEMPOOL_PER_THREAD)
+	{
+		cuStreamSynchronize(cuda_stream);
+		cuMemPoolDestroy(MY_MEMPOOL_PER_THREAD);
+		MY_MEMPOOL_PER_THREAD = NULL;
+	}
+	cuEventDestroy(cuda_event_begin);
 	cuEventDestroy(cuda_event);
 	cuStreamDestroy(cuda_stream);
 	free(gworker);
@@ -2904,77 +8759,301 @@ gpuservGpuWorkerMain(void *__arg)
 static void *
 gpuservMonitorClient(void *__priv)
 {
-	gpuClient  *gclient = __priv;
-	gpuContext *gcontext = gclient->gcontext;
-	pgsocket	sockfd = gclient->sockfd;
+	gpuMonitor *gmon = __priv;
+	gpuContext *gcontext = gmon->gcontext;
+	struct epoll_event ep_evs[GPUSERV_MONITOR_NEVENTS];
 	char		elabel[32];
+	uint64_t	next_reclaim = 0;
 	CUresult	rc;
 
 	snprintf(elabel, sizeof(elabel), "GPU-%d", gcontext->cuda_dindex);
 
+	__gpuContextBindNumaNode(gcontext);
 	rc = cuCtxSetCurrent(gcontext->cuda_context);
 	if (rc != CUDA_SUCCESS)
 	{
-		__gsDebug("[%s] failed on cuCtxSetCurrent: %s\n",
-				  elabel, cuStrError(rc));
-		goto out;
+		__gsLog("[%s] failed on cuCtxSetCurrent: %s",
+				elabel, cuStrError(rc));
+		return NULL;
 	}
 	GpuWorkerCurrentContext = gcontext;
+	MY_DINDEX_PER_THREAD = gcontext->cuda_dindex;
 	pg_memory_barrier();
 
-	for (;;)
+	while (!gpuServiceGoingTerminate())
 	{
-		struct pollfd  pfd;
+		uint64_t now = __innerCacheTimestamp();
 		int		nevents;
 
-		pfd.fd = sockfd;
-		pfd.events = POLLIN;
-		pfd.revents = 0;
-		nevents = poll(&pfd, 1, -1);
+		/* release the inner buffers no longer used for rescan */
+		if (now >= next_reclaim)
+		{
+			gpuservReclaimRetainedQueryBuffers();
+			next_reclaim = now + GPU_QUERY_BUFFER_RETAIN / 2;
+		}
+		nevents = epoll_wait(gmon->epoll_fd, ep_evs,
+							 GPUSERV_MONITOR_NEVENTS, 1000);
 		if (nevents < 0)
 		{
 			if (errno == EINTR)
 				continue;
-			__gsDebug("[%s] failed on poll(2): %m", elabel);
+			__gsLog("[%s] failed on epoll_wait(2): %m", elabel);
 			break;
 		}
-		if (nevents == 0)
+		for (int i=0; i < nevents; i++)
+		{
+			gpuClient  *gclient = ep_evs[i].data.ptr;
+			uint32_t	events = ep_evs[i].events;
+			bool		closed = false;
+
+			if ((events & EPOLLIN) != 0 &&
+				__gpuServiceReceiveCommands(gclient->sockfd,
+											gclient, elabel) < 0)
+				closed = true;
+			if ((events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) != 0)
+			{
+				__gsDebug("[%s] peer socket closed.", elabel);
+				closed = true;
+			}
+			if (closed)
+			{
+				epoll_ctl(gmon->epoll_fd, EPOLL_CTL_DEL, gclient->sockfd, NULL);
+				/* nobody receives the results of the running tasks */
+				__gpuClientCancelTasks(gclient);
+				gpuClientPut(gclient, true);
+			}
+		}
+	}
+	return NULL;
+}
+
+/*
+ * __gpuservSetupMonitors
+ */
+static void
+__gpuservSetupMonitors(gpuContext *gcontext)
+{
+	int		nthreads = pgstrom_gpuserv_monitor_threads;
+	int		errcode;
+
+	gcontext->monitors = calloc(nthreads, sizeof(gpuMonitor));
+	if (!gcontext->monitors)
+		elog(ERROR, "out of memory");
+	for (int i=0; i < nthreads; i++)
+	{
+		gpuMonitor *gmon = &gcontext->monitors[i];
+
+		gmon->gcontext = gcontext;
+		pg_atomic_init_u32(&gmon->num_clients, 0);
+		gmon->epoll_fd = epoll_create(GPUSERV_MONITOR_NEVENTS);
+		if (gmon->epoll_fd < 0)
+			elog(ERROR, "failed on epoll_create: %m");
+		if ((errcode = pthread_create(&gmon->thread, NULL,
+									  gpuservMonitorClient,
+									  gmon)) != 0)
+		{
+			close(gmon->epoll_fd);
+			elog(ERROR, "failed on pthread_create: %s", strerror(errcode));
+		}
+		gcontext->num_monitors++;
+	}
+}
+
+/*
+ * gpuservRemoteAuthDigest
+ *
+ * It computes HMAC-SHA256 of the nonce by pg_strom.gpuserv_remote_secret,
+ * for the challenge-response authentication of the remote clients.
+ * Both of GPU service and the remote clients share this routine.
+ */
+bool
+gpuservRemoteAuthDigest(const uint8_t *nonce, uint8_t *digest)
+{
+	const char *secret = pgstrom_gpuserv_remote_secret;
+	pg_hmac_ctx *hmac;
+	bool		retval = false;
+
+	if (!secret || *secret == '\0')
+		return false;
+	hmac = pg_hmac_create(PG_SHA256);
+	if (hmac)
+	{
+		if (pg_hmac_init(hmac, (const uint8 *)secret, strlen(secret)) == 0 &&
+			pg_hmac_update(hmac, nonce, GPUSERV_REMOTE_AUTH_NONCE_LEN) == 0 &&
+			pg_hmac_final(hmac, digest, GPUSERV_REMOTE_AUTH_DIGEST_LEN) == 0)
+			retval = true;
+		pg_hmac_free(hmac);
+	}
+	return retval;
+}
+
+/*
+ * __gpuservRemoteAuthenticate
+ *
+ * It sends a random nonce to the remote client just accepted, then checks
+ * the digest returned by the client within GPUSERV_REMOTE_AUTH_TIMEOUT.
+ * A byte of ack is sent back on success; elsewhere, the connection is
+ * closed without any reply.
+ */
+static bool
+__gpuservRemoteAuthenticate(int sockfd)
+{
+	uint8_t		nonce[GPUSERV_REMOTE_AUTH_NONCE_LEN];
+	uint8_t		digest[GPUSERV_REMOTE_AUTH_DIGEST_LEN];
+	uint8_t		expected[GPUSERV_REMOTE_AUTH_DIGEST_LEN];
+	struct timeval tv;
+	size_t		nbytes = 0;
+	uint8_t		diff = 0;
+	uint8_t		ack = 1;
+
+	if (!pg_strong_random(nonce, sizeof(nonce)) ||
+		!gpuservRemoteAuthDigest(nonce, expected))
+		return false;
+	tv.tv_sec = GPUSERV_REMOTE_AUTH_TIMEOUT;
+	tv.tv_usec = 0;
+	if (setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0 ||
+		setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) != 0)
+		return false;
+	if (send(sockfd, nonce, sizeof(nonce), MSG_NOSIGNAL) != sizeof(nonce))
+		return false;
+	while (nbytes < sizeof(digest))
+	{
+		ssize_t		nread = recv(sockfd, digest + nbytes,
+								 sizeof(digest) - nbytes, 0);
+		if (nread < 0 && errno == EINTR)
 			continue;
-		Assert(nevents == 1);
-		if (pfd.revents == POLLIN)
+		if (nread <= 0)
+			return false;
+		nbytes += nread;
+	}
+	/* compare in constant time */
+	for (int i=0; i < sizeof(digest); i++)
+		diff |= (digest[i] ^ expected[i]);
+	if (diff != 0)
+		return false;
+	if (send(sockfd, &ack, sizeof(ack), MSG_NOSIGNAL) != sizeof(ack))
+		return false;
+	/* the monitor thread receives the commands without timeout */
+	memset(&tv, 0, sizeof(tv));
+	if (setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) != 0 ||
+		setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) != 0)
+		return false;
+	return true;
+}
+
+/*
+ * __gpuservRemotePeerIsAllowed
+ *
+ * It checks the peer address of the remote client with the networks listed
+ * in pg_strom.gpuserv_remote_allowed_hosts. IPv4-mapped IPv6 address is
+ * compared as IPv4 address.
+ */
+static bool
+__gpuservRemotePeerIsAllowed(const struct sockaddr_storage *peer)
+{
+	const uint8_t *addr;
+	int			family;
+
+	if (peer->ss_family == AF_INET)
+	{
+		family = AF_INET;
+		addr = (const uint8_t *)&((const struct sockaddr_in *)peer)->sin_addr;
+	}
+	else if (peer->ss_family == AF_INET6)
+	{
+		const struct in6_addr *addr6 = &((const struct sockaddr_in6 *)peer)->sin6_addr;
+
+		if (IN6_IS_ADDR_V4MAPPED(addr6))
 		{
-			if (__gpuServiceReceiveCommands(sockfd, gclient, elabel) < 0)
-				break;
+			family = AF_INET;
+			addr = addr6->s6_addr + 12;
 		}
-		else if (pfd.revents & ~POLLIN)
+		else
 		{
-			__gsDebug("[%s] peer socket closed.", elabel);
-			break;
+			family = AF_INET6;
+			addr = addr6->s6_addr;
 		}
 	}
-out:
-	gpuClientPut(gclient, true);
-	return NULL;
+	else
+		return false;
+
+	for (int i=0; gpuserv_remote_allowed_hosts &&
+			 i < gpuserv_remote_allowed_hosts->nitems; i++)
+	{
+		const gpuServRemoteAllowedHost *curr = &gpuserv_remote_allowed_hosts->entries[i];
+		int			nbytes = curr->masklen / 8;
+		int			nbits = curr->masklen % 8;
+
+		if (curr->family != family ||
+			memcmp(addr, curr->addr, nbytes) != 0)
+			continue;
+		if (nbits > 0 &&
+			((addr[nbytes] ^ curr->addr[nbytes]) & (0xff00 >> nbits) & 0xff) != 0)
+			continue;
+		return true;
+	}
+	return false;
 }
 
 /*
  * gpuservAcceptClient
+ *
+ * Both of the listen sockets (UNIX domain and TCP) are non-blocking, and
+ * epoll(7) wakes up with the gpuContext, so it tries the local one first.
  */
 static void
 gpuservAcceptClient(gpuContext *gcontext)
 {
 	gpuClient  *gclient;
+	gpuMonitor *gmon;
 	pgsocket	sockfd;
-	int			errcode;
+	struct sockaddr_storage peer;
+	socklen_t	peer_len = 0;
+	struct epoll_event ev;
 
 	sockfd = accept(gcontext->serv_fd, NULL, NULL);
+	if (sockfd < 0 && errno == EAGAIN && gcontext->remote_fd >= 0)
+	{
+		peer_len = sizeof(peer);
+		sockfd = accept(gcontext->remote_fd, (struct sockaddr *)&peer, &peer_len);
+		if (sockfd < 0)
+			peer_len = 0;
+	}
 	if (sockfd < 0)
 	{
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			return;
 		elog(LOG, "GPU%d: could not accept new connection: %m",
 			 gcontext->cuda_dindex);
 		pg_usleep(10000L);		/* wait 10ms */
 		return;
 	}
+	/* remote clients must come from the allowed hosts */
+	if (peer_len > 0 && !__gpuservRemotePeerIsAllowed(&peer))
+	{
+		char		host[NI_MAXHOST];
+
+		if (getnameinfo((struct sockaddr *)&peer, peer_len,
+						host, sizeof(host), NULL, 0, NI_NUMERICHOST) != 0)
+			strcpy(host, "???");
+		elog(LOG, "GPU%d: connection from %s is not allowed by pg_strom.gpuserv_remote_allowed_hosts",
+			 gcontext->cuda_dindex, host);
+		close(sockfd);
+		return;
+	}
+	/* remote clients must know pg_strom.gpuserv_remote_secret */
+	if (peer_len > 0 && !__gpuservRemoteAuthenticate(sockfd))
+	{
+		char		host[NI_MAXHOST];
+
+		if (getnameinfo((struct sockaddr *)&peer, peer_len,
+						host, sizeof(host), NULL, 0, NI_NUMERICHOST) != 0)
+			strcpy(host, "???");
+		elog(LOG, "GPU%d: authentication failed for the connection from %s",
+			 gcontext->cuda_dindex, host);
+		close(sockfd);
+		return;
+	}
 
 	gclient = calloc(1, sizeof(gpuClient));
 	if (!gclient)
@@ -2988,19 +9067,53 @@ gpuservAcceptClient(gpuContext *gcontext)
 	pg_atomic_init_u32(&gclient->refcnt, 1);
 	pthreadMutexInit(&gclient->mutex);
 	gclient->sockfd = sockfd;
+	if (peer_len > 0)
+	{
+		const void *host = NULL;
+		size_t		host_sz = 0;
+
+		if (peer.ss_family == AF_INET)
+		{
+			host = &((struct sockaddr_in *)&peer)->sin_addr;
+			host_sz = sizeof(struct in_addr);
+		}
+		else if (peer.ss_family == AF_INET6)
+		{
+			host = &((struct sockaddr_in6 *)&peer)->sin6_addr;
+			host_sz = sizeof(struct in6_addr);
+		}
+		gclient->is_remote = true;
+		if (host)
+			gclient->remote_peer_key = hash_bytes_extended(host, host_sz, 0);
+	}
+	gclient->queue_index = (pg_atomic_fetch_add_u32(&gcontext->client_seq, 1) %
+							GPUSERV_COMMAND_NQUEUES);
+	pg_atomic_init_u32(&gclient->num_queued_cmds, 0);
 
-	if ((errcode = pthread_create(&gclient->worker, NULL,
-								  gpuservMonitorClient,
-								  gclient)) != 0)
+	/* assign the monitor thread with the least clients */
+	gmon = &gcontext->monitors[0];
+	for (int i=1; i < gcontext->num_monitors; i++)
 	{
-		elog(LOG, "failed on pthread_create: %s", strerror(errcode));
-		close(sockfd);
-		free(gclient);
-		return;
+		if (pg_atomic_read_u32(&gcontext->monitors[i].num_clients) <
+			pg_atomic_read_u32(&gmon->num_clients))
+			gmon = &gcontext->monitors[i];
 	}
+	gclient->monitor = gmon;
+	pg_atomic_fetch_add_u32(&gmon->num_clients, 1);
+
 	pthreadMutexLock(&gcontext->client_lock);
 	dlist_push_tail(&gcontext->client_list, &gclient->chain);
 	pthreadMutexUnlock(&gcontext->client_lock);
+	pg_atomic_fetch_add_u32(&gcontext->stats->num_clients, 1);
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN | EPOLLRDHUP;
+	ev.data.ptr = gclient;
+	if (epoll_ctl(gmon->epoll_fd, EPOLL_CTL_ADD, sockfd, &ev) != 0)
+	{
+		elog(LOG, "failed on epoll_ctl(2): %m");
+		gpuClientPut(gclient, true);
+	}
 }
 
 /*
@@ -3021,7 +9134,7 @@ __setupDevTypeLinkageTable(CUmodule cuda_module)
 	/* build device type table */
 	memset(&hctl, 0, sizeof(HASHCTL));
 	hctl.keysize = sizeof(TypeOpCode);
-	hctl.entrysize = sizeof(xpu_type_catalog_entry);
+	hctl.entrysize = sizeof(gpuDevTypeEntry);
 	hctl.hcxt = TopMemoryContext;
 	htab = hash_create("CUDA device type hash table",
 					   512,
@@ -3040,7 +9153,8 @@ __setupDevTypeLinkageTable(CUmodule cuda_module)
 	for (i=0; xpu_types_catalog[i].type_opcode != TypeOpCode__Invalid; i++)
 	{
 		TypeOpCode	type_opcode = xpu_types_catalog[i].type_opcode;
-		xpu_type_catalog_entry *entry;
+		gpuDevTypeEntry *entry;
+		xpu_datum_operators type_ops;
 		bool		found;
 
 		entry = hash_search(htab, &type_opcode, HASH_ENTER, &found);
@@ -3048,6 +9162,13 @@ __setupDevTypeLinkageTable(CUmodule cuda_module)
 			elog(ERROR, "Bug? duplicated TypeOpCode: %u", (uint32_t)type_opcode);
 		Assert(entry->type_opcode == type_opcode);
 		entry->type_ops = xpu_types_catalog[i].type_ops;
+		/* layout of the type, to validate the commands of remote clients */
+		rc = cuMemcpyDtoH(&type_ops, (CUdeviceptr)entry->type_ops,
+						  sizeof(xpu_datum_operators));
+		if (rc != CUDA_SUCCESS)
+			elog(ERROR, "failed on cuMemcpyDtoH: %s", cuStrError(rc));
+		entry->type_length = type_ops.xpu_type_length;
+		entry->kvec_sizeof = type_ops.xpu_kvec_sizeof;
 	}
 	return htab;
 }
@@ -3060,6 +9181,8 @@ __setupDevFuncLinkageTable(CUmodule cuda_module)
 {
 	xpu_function_catalog_entry *xpu_funcs_catalog;
 	const char *symbol = "builtin_xpu_functions_catalog";
+	const pgstromUserDevFunc *ufuncs;
+	int			nr_ufuncs;
 	HASHCTL		hctl;
 	HTAB	   *htab;
 	CUdeviceptr	dptr;
@@ -3086,15 +9209,39 @@ __setupDevFuncLinkageTable(CUmodule cuda_module)
 		elog(ERROR, "failed on cuMemcpyDtoH: %s", cuStrError(rc));
 	for (i=0; xpu_funcs_catalog[i].func_opcode != FuncOpCode__Invalid; i++)
 	{
-		FuncOpCode	func_opcode = xpu_funcs_catalog[i].func_opcode;
+		FuncOpCode	func_opcode = xpu_funcs_catalog[i].func_opcode;
+		xpu_function_catalog_entry *entry;
+		bool		found;
+
+		entry = hash_search(htab, &func_opcode, HASH_ENTER, &found);
+		if (found)
+			elog(ERROR, "Bug? duplicated FuncOpCode: %u", (uint32_t)func_opcode);
+		Assert(entry->func_opcode == func_opcode);
+		entry->func_dptr = xpu_funcs_catalog[i].func_dptr;
+	}
+	/* device functions supplied by extensions */
+	ufuncs = pgstrom_user_devfunc_catalog(&nr_ufuncs);
+	for (i=0; i < nr_ufuncs; i++)
+	{
+		FuncOpCode	func_opcode = ufuncs[i].func_code;
 		xpu_function_catalog_entry *entry;
+		xpu_function_t func_dptr;
+		char		emsg[512];
 		bool		found;
 
+		if ((ufuncs[i].func_flags & DEVKIND__NVIDIA_GPU) == 0)
+			continue;
+		if (!__resolveUserDevFuncDptr(cuda_module,
+									  ufuncs[i].cuda_symbol,
+									  &func_dptr,
+									  emsg, sizeof(emsg)))
+			elog(ERROR, "unable to link device function '%s': %s",
+				 ufuncs[i].func_signature, emsg);
 		entry = hash_search(htab, &func_opcode, HASH_ENTER, &found);
 		if (found)
 			elog(ERROR, "Bug? duplicated FuncOpCode: %u", (uint32_t)func_opcode);
 		Assert(entry->func_opcode == func_opcode);
-		entry->func_dptr = xpu_funcs_catalog[i].func_dptr;
+		entry->func_dptr = func_dptr;
 	}
 	return htab;
 }
@@ -3173,11 +9320,23 @@ gpuservSetupGpuModule(gpuContext *gcontext)
 	CUmodule	cuda_module;
 	CUresult	rc;
 
-	rc = cuModuleLoad(&cuda_module, pgstrom_fatbin_image_filename);
-	if (rc != CUDA_SUCCESS)
-		elog(ERROR, "failed on cuModuleLoad('%s'): %s",
-			 pgstrom_fatbin_image_filename,
-			 cuStrError(rc));
+	if (pgstrom_gpu_module_cache &&
+		__gpuModuleCacheLoad(gcontext, &cuda_module))
+	{
+		pg_atomic_fetch_add_u64(&gpuserv_shared_state->gpu_module_cache_hits, 1);
+	}
+	else
+	{
+		__gpuservValidateFatbin();
+		rc = cuModuleLoad(&cuda_module, pgstrom_fatbin_image_filename);
+		if (rc != CUDA_SUCCESS)
+			elog(ERROR, "failed on cuModuleLoad('%s'): %s",
+				 pgstrom_fatbin_image_filename,
+				 cuStrError(rc));
+		pg_atomic_fetch_add_u64(&gpuserv_shared_state->gpu_module_cache_misses, 1);
+		if (pgstrom_gpu_module_cache)
+			__gpuModuleCacheStore(gcontext);
+	}
 	/* setup XPU linkage hash tables */
 	gcontext->cuda_type_htab = __setupDevTypeLinkageTable(cuda_module);
 	gcontext->cuda_func_htab = __setupDevFuncLinkageTable(cuda_module);
@@ -3354,6 +9513,144 @@ __gpuContextTerminateWorkers(gpuContext *gcontext)
 /*
  * gpuservSetupGpuContext
  */
+/*
+ * __gpuContextSetupNumaCpuset
+ *
+ * It collects the CPUs on the NUMA node local to the GPU, to bind the worker
+ * and monitor threads of the gpuContext. The host buffers allocated and
+ * touched first by these threads are also located on the local node by the
+ * first-touch policy, so DMA does not cross the socket interconnect.
+ */
+static void
+__gpuContextSetupNumaCpuset(gpuContext *gcontext)
+{
+	GpuDevAttributes *dattrs = &gpuDevAttrs[gcontext->cuda_dindex];
+	cpu_set_t	allowed;
+	char		path[MAXPGPATH];
+	char		linebuf[4096];
+	char		cpulist[4096];
+	char	   *tok, *pos;
+	FILE	   *filp;
+
+	gcontext->numa_binding = false;
+	CPU_ZERO(&gcontext->numa_cpuset);
+	if (!pgstrom_gpu_numa_binding || dattrs->NUMA_NODE_ID < 0)
+		return;
+	snprintf(path, sizeof(path),
+			 "/sys/devices/system/node/node%d/cpulist",
+			 dattrs->NUMA_NODE_ID);
+	filp = fopen(path, "r");
+	if (!filp)
+		return;
+	if (!fgets(linebuf, sizeof(linebuf), filp))
+	{
+		fclose(filp);
+		return;
+	}
+	fclose(filp);
+	strcpy(cpulist, __trim(linebuf));
+
+	/* cpulist := <cpu>[-<cpu>][,<cpu>[-<cpu>] ...] */
+	for (tok = strtok_r(linebuf, ",\n", &pos);
+		 tok != NULL;
+		 tok = strtok_r(NULL, ",\n", &pos))
+	{
+		int		head, tail;
+
+		if (sscanf(tok, "%d-%d", &head, &tail) != 2)
+		{
+			if (sscanf(tok, "%d", &head) != 1)
+				continue;
+			tail = head;
+		}
+		for (int cpu=head; cpu <= tail && cpu < CPU_SETSIZE; cpu++)
+			CPU_SET(cpu, &gcontext->numa_cpuset);
+	}
+	/* must be a subset of the CPUs available for the process */
+	if (sched_getaffinity(0, sizeof(cpu_set_t), &allowed) == 0)
+		CPU_AND(&gcontext->numa_cpuset, &gcontext->numa_cpuset, &allowed);
+	if (CPU_COUNT(&gcontext->numa_cpuset) > 0)
+	{
+		gcontext->numa_binding = true;
+		elog(LOG, "GPU%d worker threads are bound to NUMA node %d (CPUs: %s)",
+			 gcontext->cuda_dindex, dattrs->NUMA_NODE_ID, cpulist);
+	}
+}
+
+/*
+ * __gpuContextBindNumaNode - bind the current thread to the local NUMA node
+ */
+static void
+__gpuContextBindNumaNode(gpuContext *gcontext)
+{
+	int		errcode;
+
+	if (!gcontext->numa_binding)
+		return;
+	errcode = pthread_setaffinity_np(pthread_self(),
+									 sizeof(cpu_set_t),
+									 &gcontext->numa_cpuset);
+	if (errcode != 0)
+		__gsDebug("failed on pthread_setaffinity_np: %s", strerror(errcode));
+}
+
+/*
+ * __gpuservSetupRemoteListenSocket
+ *
+ * It opens the TCP listen socket for the remote clients, at the port number
+ * of pg_strom.gpuserv_remote_listen_port + cuda_dindex.
+ */
+static void
+__gpuservSetupRemoteListenSocket(gpuContext *gcontext)
+{
+	struct addrinfo hints;
+	struct addrinfo *res;
+	struct epoll_event ev;
+	const char *host = pgstrom_gpuserv_remote_listen_address;
+	char		temp[32];
+	int			one = 1;
+	int			rv;
+
+	/* '*' means all the network interfaces */
+	if (host && (*host == '\0' || strcmp(host, "*") == 0))
+		host = NULL;
+	memset(&hints, 0, sizeof(struct addrinfo));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE;
+	snprintf(temp, sizeof(temp), "%d",
+			 pgstrom_gpuserv_remote_listen_port + gcontext->cuda_dindex);
+	rv = getaddrinfo(host, temp, &hints, &res);
+	if (rv != 0)
+		elog(ERROR, "failed on getaddrinfo('%s',%s): %s",
+			 host ? host : "*", temp, gai_strerror(rv));
+	gcontext->remote_fd = socket(res->ai_family,
+								 SOCK_STREAM | SOCK_NONBLOCK, 0);
+	if (gcontext->remote_fd < 0)
+	{
+		freeaddrinfo(res);
+		elog(ERROR, "failed on socket(2): %m");
+	}
+	setsockopt(gcontext->remote_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if (bind(gcontext->remote_fd, res->ai_addr, res->ai_addrlen) != 0)
+	{
+		freeaddrinfo(res);
+		elog(ERROR, "failed on bind(port=%s): %m", temp);
+	}
+	freeaddrinfo(res);
+	if (listen(gcontext->remote_fd, 32) != 0)
+		elog(ERROR, "failed on listen(2): %m");
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.ptr = gcontext;
+	if (epoll_ctl(gpuserv_epoll_fdesc,
+				  EPOLL_CTL_ADD,
+				  gcontext->remote_fd, &ev) != 0)
+		elog(ERROR, "failed on epoll_ctl(2): %m");
+	elog(LOG, "GPU%d: listen remote clients at port %s",
+		 gcontext->cuda_dindex, temp);
+}
+
 static gpuContext *
 gpuservSetupGpuContext(int cuda_dindex)
 {
@@ -3368,23 +9665,46 @@ gpuservSetupGpuContext(int cuda_dindex)
 	if (!gcontext)
 		elog(ERROR, "out of memory");
 	gcontext->serv_fd = -1;
+	gcontext->remote_fd = -1;
 	gcontext->cuda_dindex = cuda_dindex;
+	gcontext->stats = &gpuserv_shared_state->gpu_stats[cuda_dindex];
 	pthreadMutexInit(&gcontext->cuda_setlimit_lock);
-	gpuMemoryPoolInit(&gcontext->pool_raw,     false, dattrs->DEV_TOTAL_MEMSZ);
-	gpuMemoryPoolInit(&gcontext->pool_managed, true,  dattrs->DEV_TOTAL_MEMSZ);
+	gpuMemoryPoolInit(&gcontext->pool_raw,     false, dattrs->DEV_TOTAL_MEMSZ,
+					  gcontext->stats);
+	gpuMemoryPoolInit(&gcontext->pool_managed, true,  dattrs->DEV_TOTAL_MEMSZ,
+					  gcontext->stats);
 	pthreadMutexInit(&gcontext->client_lock);
 	dlist_init(&gcontext->client_list);
 	pthreadMutexInit(&gcontext->worker_lock);
 	dlist_init(&gcontext->worker_list);
 
+	pthreadMutexInit(&gcontext->admission_lock);
+	pthreadCondInit(&gcontext->admission_cond);
+	pthreadMutexInit(&gcontext->session_code_lock);
+	pthreadMutexInit(&gcontext->autotune_lock);
+	__gpuservAutoTuneLoadFile(gcontext);
+	gcontext->num_active_sessions = 0;
+	gcontext->reserved_mem_quota = 0;
 	pthreadCondInit(&gcontext->cond);
 	pthreadMutexInit(&gcontext->lock);
-	dlist_init(&gcontext->command_list);
+	pg_atomic_init_u32(&gcontext->num_queued_cmds, 0);
+	pg_atomic_init_u32(&gcontext->num_idle_workers, 0);
+	pg_atomic_init_u32(&gcontext->worker_seq, 0);
+	pg_atomic_init_u32(&gcontext->client_seq, 0);
+	__gpuContextSetupNumaCpuset(gcontext);
+	for (int i=0; i < GPUSERV_COMMAND_NQUEUES; i++)
+	{
+		gpuCommandQueue *cqueue = &gcontext->cmd_queues[i];
+
+		pthreadMutexInit(&cqueue->lock);
+		for (int lane=0; lane < GPUSERV_COMMAND_NLANES; lane++)
+			dlist_init(&cqueue->lanes[lane]);
+	}
 
 	PG_TRY();
 	{
 		/* Open the listen socket for this GPU */
-		gcontext->serv_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		gcontext->serv_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
 		if (gcontext->serv_fd < 0)
 			elog(ERROR, "failed on socket(2): %m");
 		snprintf(addr.sun_path, sizeof(addr.sun_path),
@@ -3401,6 +9721,9 @@ gpuservSetupGpuContext(int cuda_dindex)
 					  EPOLL_CTL_ADD,
 					  gcontext->serv_fd, &ev) != 0)
 			elog(ERROR, "failed on epoll_ctl(2): %m");
+		/* Open the listen socket for the remote clients, if any */
+		if (pgstrom_gpuserv_remote_listen_port > 0)
+			__gpuservSetupRemoteListenSocket(gcontext);
 
 		/* Setup raw CUDA context */
 		rc = cuDeviceGet(&gcontext->cuda_device, dattrs->DEV_ID);
@@ -3422,6 +9745,8 @@ gpuservSetupGpuContext(int cuda_dindex)
 			elog(ERROR, "failed on cuCtxSetCurrent: %s", cuStrError(rc));
 
 		gpuservSetupGpuModule(gcontext);
+		/* launch monitor threads of the clients */
+		__gpuservSetupMonitors(gcontext);
 		/* enable kernel profiling if captured */
 		if (getenv("NSYS_PROFILING_SESSION_ID") != NULL)
 		{
@@ -3438,6 +9763,8 @@ gpuservSetupGpuContext(int cuda_dindex)
 	{
 		if (gcontext->serv_fd >= 0)
 			close(gcontext->serv_fd);
+		if (gcontext->remote_fd >= 0)
+			close(gcontext->remote_fd);
 		free(gcontext);
 		PG_RE_THROW();
 	}
@@ -3454,6 +9781,15 @@ gpuservCleanupGpuContext(gpuContext *gcontext)
 	CUresult	rc;
 
 	__gpuContextTerminateWorkers(gcontext);
+	/* monitor threads exit within one second once going terminate */
+	for (int i=0; i < gcontext->num_monitors; i++)
+	{
+		gpuMonitor *gmon = &gcontext->monitors[i];
+
+		pthread_join(gmon->thread, NULL);
+		close(gmon->epoll_fd);
+	}
+	gcontext->num_monitors = 0;
 
 	while (!dlist_is_empty(&gcontext->client_list))
 	{
@@ -3465,6 +9801,20 @@ gpuservCleanupGpuContext(gpuContext *gcontext)
 	}
 	if (close(gcontext->serv_fd) != 0)
 		elog(LOG, "failed on close(serv_fd): %m");
+	if (gcontext->remote_fd >= 0 && close(gcontext->remote_fd) != 0)
+		elog(LOG, "failed on close(remote_fd): %m");
+	for (int i=0; i < GPU_SESSION_CODE_CACHE_NSLOTS; i++)
+	{
+		if (gcontext->session_code_cache[i])
+			free(gcontext->session_code_cache[i]);
+		gcontext->session_code_cache[i] = NULL;
+	}
+	for (int i=0; i < GPU_AUTOTUNE_NSLOTS; i++)
+	{
+		if (gcontext->autotune_cache[i])
+			free(gcontext->autotune_cache[i]);
+		gcontext->autotune_cache[i] = NULL;
+	}
 	if (gcontext->cuda_profiler_started)
 	{
 		rc = cuProfilerStop();
@@ -3519,6 +9869,77 @@ gpuservCleanupOnProcExit(int code, Datum arg)
 				elog(LOG, "failed on unlink('%s'): %m", path);
 		}
 	}
+	/* cleanup GpuJoin inner buffer cache */
+	__gpuservCleanupInnerCache();
+}
+
+/*
+ * gpuservRegisterSharedBuffers
+ *
+ * It registers the shared buffers as page-locked host memory, to load
+ * the cached heap pages to the device memory by DMA (see relscan.c).
+ * The backend process keeps the buffers pinned until the response.
+ */
+static void
+gpuservRegisterSharedBuffers(void)
+{
+	gpuContext *gcontext;
+	uintptr_t	head = TYPEALIGN_DOWN(PAGE_SIZE, (uintptr_t)BufferBlocks);
+	uintptr_t	tail = TYPEALIGN(PAGE_SIZE, (uintptr_t)BufferBlocks +
+								 (size_t)NBuffers * BLCKSZ);
+	CUresult	rc;
+
+	if (!pgstrom_gpu_shared_buffers_dma ||
+		dlist_is_empty(&gpuserv_gpucontext_list))
+		return;
+	gcontext = dlist_head_element(gpuContext, chain,
+								  &gpuserv_gpucontext_list);
+	rc = cuCtxSetCurrent(gcontext->cuda_context);
+	if (rc == CUDA_SUCCESS)
+		rc = cuMemHostRegister((void *)head, tail - head,
+							   CU_MEMHOSTREGISTER_PORTABLE);
+	if (rc != CUDA_SUCCESS)
+	{
+		elog(LOG, "failed on cuMemHostRegister for shared buffers (sz=%lu): %s",
+			 tail - head, cuStrError(rc));
+		return;
+	}
+	gpuserv_shared_state->shared_buffers_dma = true;
+}
+
+/*
+ * gpuservUnregisterSharedBuffers
+ */
+static void
+gpuservUnregisterSharedBuffers(void)
+{
+	gpuContext *gcontext;
+	uintptr_t	head = TYPEALIGN_DOWN(PAGE_SIZE, (uintptr_t)BufferBlocks);
+	CUresult	rc;
+
+	if (!gpuserv_shared_state->shared_buffers_dma)
+		return;
+	gpuserv_shared_state->shared_buffers_dma = false;
+	Assert(!dlist_is_empty(&gpuserv_gpucontext_list));
+	gcontext = dlist_head_element(gpuContext, chain,
+								  &gpuserv_gpucontext_list);
+	rc = cuCtxSetCurrent(gcontext->cuda_context);
+	if (rc == CUDA_SUCCESS)
+		rc = cuMemHostUnregister((void *)head);
+	if (rc != CUDA_SUCCESS)
+		elog(LOG, "failed on cuMemHostUnregister for shared buffers: %s",
+			 cuStrError(rc));
+}
+
+/*
+ * gpuServiceSharedBuffersDMA
+ */
+bool
+gpuServiceSharedBuffersDMA(void)
+{
+	return (gpuserv_shared_state &&
+			gpuserv_shared_state->gpuserv_ready_accept &&
+			gpuserv_shared_state->shared_buffers_dma);
 }
 
 /*
@@ -3539,6 +9960,8 @@ gpuservBgWorkerMain(Datum arg)
 	/* Registration of resource cleanup handler */
 	dlist_init(&gpuserv_gpucontext_list);
 	before_shmem_exit(gpuservCleanupOnProcExit, 0);
+	/* inner buffers cached by the previous GPU service are gone */
+	__gpuservCleanupInnerCache();
 
 	/* Open epoll descriptor */
 	gpuserv_epoll_fdesc = epoll_create(30);
@@ -3547,7 +9970,7 @@ gpuservBgWorkerMain(Datum arg)
 	/* Open logger pipe for worker threads */
 	gpuservLoggerOpen();
 
-	/* Build the fatbin binary image on demand */
+	/* Determine the fatbin binary image; built on demand */
 	gpuservSetupFatbin();
 
 	/* Init GPU Context for each devices */
@@ -3562,6 +9985,7 @@ gpuservBgWorkerMain(Datum arg)
 			gpuContext *gcontext = gpuservSetupGpuContext(dindex);
 			dlist_push_tail(&gpuserv_gpucontext_list, &gcontext->chain);
 		}
+		gpuservRegisterSharedBuffers();
 		/* ready to accept connection from the PostgreSQL backend */
 		gpuserv_shared_state->gpuserv_ready_accept = true;
 
@@ -3606,6 +10030,7 @@ gpuservBgWorkerMain(Datum arg)
 	{
 		gpuserv_shared_state->gpuserv_pid = 0;
 		gpuserv_shared_state->gpuserv_ready_accept = false;
+		gpuservUnregisterSharedBuffers();
 		while (!dlist_is_empty(&gpuserv_gpucontext_list))
 		{
 			dlist_node *dnode = dlist_pop_head_node(&gpuserv_gpucontext_list);
@@ -3620,6 +10045,7 @@ gpuservBgWorkerMain(Datum arg)
 	/* cleanup */
 	gpuserv_shared_state->gpuserv_pid = 0;
 	gpuserv_shared_state->gpuserv_ready_accept = false;
+	gpuservUnregisterSharedBuffers();
 	while (!dlist_is_empty(&gpuserv_gpucontext_list))
 	{
 		dlist_node *dnode = dlist_pop_head_node(&gpuserv_gpucontext_list);
@@ -3644,7 +10070,7 @@ pgstrom_request_executor(void)
 {
 	if (shmem_request_next)
 		(*shmem_request_next)();
-	RequestAddinShmemSpace(MAXALIGN(sizeof(gpuServSharedState)));
+	RequestAddinShmemSpace(GPUSERV_SHARED_STATE_LENGTH);
 }
 
 /*
@@ -3658,14 +10084,185 @@ pgstrom_startup_executor(void)
 	if (shmem_startup_next)
 		(*shmem_startup_next)();
 	gpuserv_shared_state = ShmemInitStruct("gpuServSharedState",
-										   MAXALIGN(sizeof(gpuServSharedState)),
+										   GPUSERV_SHARED_STATE_LENGTH,
 										   &found);
-	memset(gpuserv_shared_state, 0, sizeof(gpuServSharedState));
+	memset(gpuserv_shared_state, 0, GPUSERV_SHARED_STATE_LENGTH);
 	pg_atomic_init_u32(&gpuserv_shared_state->max_async_tasks_updated, 1);
 	pg_atomic_init_u32(&gpuserv_shared_state->max_async_tasks,
 					   __pgstrom_max_async_tasks_dummy);
 	pg_atomic_init_u32(&gpuserv_shared_state->gpuserv_debug_output,
 					   __gpuserv_debug_output_dummy);
+	pg_atomic_init_u64(&gpuserv_shared_state->gpu_module_cache_hits, 0);
+	pg_atomic_init_u64(&gpuserv_shared_state->gpu_module_cache_misses, 0);
+	for (int i=0; i < GPU_INNER_CACHE_NSLOTS; i++)
+	{
+		gpuInnerCacheSlot *slot = &gpuserv_shared_state->inner_cache[i];
+
+		pg_atomic_init_u64(&slot->fingerprint, 0);
+		pg_atomic_init_u64(&slot->last_used, 0);
+	}
+	for (int i=0; i < GPU_SESSION_INFO_NSLOTS; i++)
+	{
+		gpuSessionInfoSlot *sinfo = &gpuserv_shared_state->session_info[i];
+
+		pg_atomic_init_u32(&sinfo->backend_pid, 0);
+		pg_atomic_init_u64(&sinfo->mem_usage, 0);
+		pg_atomic_init_u64(&sinfo->mem_peak, 0);
+	}
+	for (int i=0; i < numGpuDevAttrs; i++)
+	{
+		gpuServiceStats *stats = &gpuserv_shared_state->gpu_stats[i];
+
+		pg_atomic_init_u32(&stats->num_clients, 0);
+		pg_atomic_init_u32(&stats->num_queued_cmds, 0);
+		for (int k=0; k < 2; k++)
+		{
+			pg_atomic_init_u32(&stats->pool_nsegments[k], 0);
+			pg_atomic_init_u64(&stats->pool_total_sz[k], 0);
+			pg_atomic_init_u64(&stats->pool_active_sz[k], 0);
+		}
+		pg_atomic_init_u64(&stats->alloc_failures, 0);
+		pg_atomic_init_u64(&stats->npages_direct_read, 0);
+		pg_atomic_init_u64(&stats->npages_vfs_read, 0);
+		pg_atomic_init_u64(&stats->num_tasks, 0);
+		pg_atomic_init_u64(&stats->num_fallbacks, 0);
+		pg_atomic_init_u64(&stats->kern_nlaunches, 0);
+		pg_atomic_init_u64(&stats->kern_total_usec, 0);
+		for (int k=0; k < GPUSERV_LATENCY_NBUCKETS; k++)
+			pg_atomic_init_u64(&stats->kern_latency_hist[k], 0);
+	}
+}
+
+/*
+ * pg_strom.gpuserv_remote_allowed_hosts
+ *
+ * Comma separated list of IP addresses, optionally with the network prefix
+ * length (e.g. 192.168.1.0/24, fd00::/8), of the hosts allowed to connect
+ * to GPU service over TCP.
+ */
+static bool
+check_gpuserv_remote_allowed_hosts(char **newval, void **extra, GucSource source)
+{
+	gpuServRemoteAllowedHosts *hosts;
+	char	   *config;
+	char	   *tok, *pos;
+	int			nitems = 0;
+
+	hosts = guc_malloc(LOG, offsetof(gpuServRemoteAllowedHosts,
+									 entries[GPUSERV_REMOTE_ALLOWED_MAX_NITEMS]));
+	if (!hosts)
+		return false;
+	if (*newval)
+	{
+		config = alloca(strlen(*newval) + 1);
+		strcpy(config, *newval);
+		for (tok = strtok_r(config, ",", &pos);
+			 tok != NULL;
+			 tok = strtok_r(NULL, ",", &pos))
+		{
+			gpuServRemoteAllowedHost *curr;
+			char	   *mask;
+			char	   *end;
+			long		masklen;
+			int			maxlen;
+
+			tok = __trim(tok);
+			if (*tok == '\0')
+				continue;
+			if (nitems >= GPUSERV_REMOTE_ALLOWED_MAX_NITEMS)
+			{
+				GUC_check_errdetail("too many hosts (up to %d)",
+									GPUSERV_REMOTE_ALLOWED_MAX_NITEMS);
+				free(hosts);
+				return false;
+			}
+			curr = &hosts->entries[nitems];
+			memset(curr, 0, sizeof(gpuServRemoteAllowedHost));
+			mask = strchr(tok, '/');
+			if (mask)
+				*mask++ = '\0';
+			if (inet_pton(AF_INET, tok, curr->addr) == 1)
+			{
+				curr->family = AF_INET;
+				maxlen = 32;
+			}
+			else if (inet_pton(AF_INET6, tok, curr->addr) == 1)
+			{
+				curr->family = AF_INET6;
+				maxlen = 128;
+			}
+			else
+			{
+				GUC_check_errdetail("\"%s\" is not a valid IP address", tok);
+				free(hosts);
+				return false;
+			}
+			if (!mask)
+				masklen = maxlen;
+			else
+			{
+				masklen = strtol(mask, &end, 10);
+				if (*mask == '\0' || *end != '\0' || masklen < 0 || masklen > maxlen)
+				{
+					GUC_check_errdetail("\"%s/%s\" has invalid prefix length", tok, mask);
+					free(hosts);
+					return false;
+				}
+			}
+			curr->masklen = masklen;
+			nitems++;
+		}
+	}
+	hosts->nitems = nitems;
+	*extra = hosts;
+	return true;
+}
+
+static void
+assign_gpuserv_remote_allowed_hosts(const char *newval, void *extra)
+{
+	gpuserv_remote_allowed_hosts = extra;
+}
+
+/*
+ * pg_strom.gpuserv_remote_arrow_dir
+ *
+ * It keeps the canonical pathname of the directory, to compare with the
+ * resolved pathname of the arrow files.
+ */
+static bool
+check_gpuserv_remote_arrow_dir(char **newval, void **extra, GucSource source)
+{
+	char	   *dir = NULL;
+
+	if (*newval && **newval != '\0')
+	{
+		char		resolved[PATH_MAX];
+		struct stat	stat_buf;
+
+		if (!realpath(*newval, resolved) ||
+			stat(resolved, &stat_buf) != 0)
+		{
+			GUC_check_errdetail("could not resolve \"%s\": %m", *newval);
+			return false;
+		}
+		if (!S_ISDIR(stat_buf.st_mode))
+		{
+			GUC_check_errdetail("\"%s\" is not a directory", *newval);
+			return false;
+		}
+		dir = guc_strdup(LOG, resolved);
+		if (!dir)
+			return false;
+	}
+	*extra = dir;
+	return true;
+}
+
+static void
+assign_gpuserv_remote_arrow_dir(const char *newval, void *extra)
+{
+	gpuserv_remote_arrow_dir = extra;
 }
 
 /*
@@ -3674,6 +10271,11 @@ pgstrom_startup_executor(void)
 void
 pgstrom_init_gpu_service(void)
 {
+	static struct config_enum_entry __gpu_query_buffer_mode_options[] = {
+		{"managed",	GQBUF_MODE__MANAGED,	false},
+		{"device",	GQBUF_MODE__DEVICE,		false},
+		{NULL, 0, false}
+	};
 	BackgroundWorker worker;
 
 	Assert(numGpuDevAttrs > 0);
@@ -3687,6 +10289,54 @@ pgstrom_init_gpu_service(void)
 							PGC_SIGHUP,
 							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB | GUC_NO_SHOW_ALL,
 							NULL, NULL, NULL);
+	DefineCustomBoolVariable("pg_strom.gpu_numa_binding",
+							 "Binds the GPU service threads to the NUMA node local to the GPU",
+							 NULL,
+							 &pgstrom_gpu_numa_binding,
+							 true,
+							 PGC_POSTMASTER,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomBoolVariable("pg_strom.gpu_shared_buffers_dma",
+							 "Loads the cached heap pages by DMA from the shared buffers registered to CUDA",
+							 NULL,
+							 &pgstrom_gpu_shared_buffers_dma,
+							 true,
+							 PGC_POSTMASTER,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomBoolVariable("pg_strom.gpu_kernel_autotune",
+							 "Enables autotuning of the GPU kernel launch configuration",
+							 NULL,
+							 &pgstrom_gpu_kernel_autotune,
+							 true,
+							 PGC_SIGHUP,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomBoolVariable("pg_strom.gpudirect_async_load",
+							 "Enables asynchronous GPU-Direct SQL read on the dedicated stream of GPU worker",
+							 NULL,
+							 &pgstrom_gpudirect_async_load,
+							 false,
+							 PGC_POSTMASTER,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomBoolVariable("pg_strom.gpu_task_graph_launch",
+							 "Launches the main kernel of GPU tasks using CUDA graph",
+							 NULL,
+							 &pgstrom_gpu_task_graph_launch,
+							 false,
+							 PGC_SIGHUP,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomBoolVariable("pg_strom.gpu_mempool_stream_ordered",
+							 "GPU memory pool: enables per-worker stream-ordered memory pool for the staged source buffer",
+							 NULL,
+							 &pgstrom_gpu_mempool_stream_ordered,
+							 false,
+							 PGC_POSTMASTER,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	DefineCustomRealVariable("pg_strom.gpu_mempool_max_ratio",
 							 "GPU memory pool: maximum usable ratio for memory pool (only mapped memory)",
 							 NULL,
@@ -3717,6 +10367,99 @@ pgstrom_init_gpu_service(void)
 							PGC_SIGHUP,
 							GUC_NOT_IN_SAMPLE | GUC_UNIT_MS | GUC_NO_SHOW_ALL,
 							NULL, NULL, NULL);
+	DefineCustomEnumVariable("pg_strom.gpu_query_buffer_mode",
+							 "Memory of GpuJoin inner buffer and GpuPreAgg final buffer",
+							 "managed: unified memory with prefetch, device: device memory with explicit copy",
+							 &pgstrom_gpu_query_buffer_mode,
+							 GQBUF_MODE__MANAGED,
+							 __gpu_query_buffer_mode_options,
+							 PGC_SIGHUP,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpu_query_buffer_zerocopy_threshold",
+							"GpuJoin inner buffer larger than this size is mapped to GPU as is, without copy",
+							"Zero-copy mapping is disabled, if 0",
+							&pgstrom_gpu_query_buffer_zerocopy_threshold_kb,
+							0,
+							0,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_KB,
+							NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpu_admission_max_sessions",
+							"Max number of concurrent sessions per GPU device (0 = unlimited)",
+							NULL,
+							&pgstrom_gpu_admission_max_sessions,
+							0,
+							0,
+							INT_MAX,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpuserv_monitor_threads",
+							"Number of threads per GPU device to receive commands from the clients",
+							NULL,
+							&pgstrom_gpuserv_monitor_threads,
+							4,
+							1,
+							256,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	DefineCustomStringVariable("pg_strom.gpuserv_remote_listen_address",
+							   "Listen address of GPU service for the remote clients",
+							   NULL,
+							   &pgstrom_gpuserv_remote_listen_address,
+							   "127.0.0.1",
+							   PGC_POSTMASTER,
+							   GUC_NOT_IN_SAMPLE,
+							   NULL, NULL, NULL);
+	DefineCustomIntVariable("pg_strom.gpuserv_remote_listen_port",
+							"Base TCP port number of GPU service for the remote clients (0 = disabled)",
+							NULL,
+							&pgstrom_gpuserv_remote_listen_port,
+							0,
+							0,
+							65535,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	DefineCustomStringVariable("pg_strom.gpuserv_remote_allowed_hosts",
+							   "IP addresses or networks of the remote clients allowed to connect GPU service",
+							   NULL,
+							   &pgstrom_gpuserv_remote_allowed_hosts,
+							   NULL,
+							   PGC_POSTMASTER,
+							   GUC_NOT_IN_SAMPLE,
+							   check_gpuserv_remote_allowed_hosts,
+							   assign_gpuserv_remote_allowed_hosts,
+							   NULL);
+	DefineCustomStringVariable("pg_strom.gpuserv_remote_arrow_dir",
+							   "Directory of the arrow files that remote clients can read",
+							   NULL,
+							   &pgstrom_gpuserv_remote_arrow_dir,
+							   NULL,
+							   PGC_POSTMASTER,
+							   GUC_NOT_IN_SAMPLE,
+							   check_gpuserv_remote_arrow_dir,
+							   assign_gpuserv_remote_arrow_dir,
+							   NULL);
+	DefineCustomStringVariable("pg_strom.gpuserv_remote_secret",
+							   "Shared secret to authenticate the remote clients of GPU service",
+							   NULL,
+							   &pgstrom_gpuserv_remote_secret,
+							   NULL,
+							   PGC_POSTMASTER,
+							   GUC_NOT_IN_SAMPLE | GUC_SUPERUSER_ONLY,
+							   NULL, NULL, NULL);
+	if (pgstrom_gpuserv_remote_listen_port > 0 &&
+		(!gpuserv_remote_allowed_hosts ||
+		 gpuserv_remote_allowed_hosts->nitems == 0))
+		elog(ERROR, "pg_strom.gpuserv_remote_allowed_hosts must be configured to accept the remote clients");
+	if (pgstrom_gpuserv_remote_listen_port > 0 &&
+		(!pgstrom_gpuserv_remote_secret ||
+		 *pgstrom_gpuserv_remote_secret == '\0'))
+		elog(ERROR, "pg_strom.gpuserv_remote_secret must be configured to accept the remote clients");
 	DefineCustomIntVariable("pg_strom.max_async_tasks",
 							"Limit of concurrent xPU task execution",
 							NULL,
@@ -3737,6 +10480,38 @@ pgstrom_init_gpu_service(void)
 							   PGC_POSTMASTER,
 							   GUC_NOT_IN_SAMPLE,
 							   NULL, NULL, NULL);
+	DefineCustomBoolVariable("pg_strom.jit_kernels",
+							 "Enables runtime-specialized GPU kernels for the device functions in use",
+							 NULL,
+							 &pgstrom_jit_kernels,
+							 false,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomBoolVariable("pg_strom.gpu_trace",
+							 "Records the execution trace of GPU tasks per session",
+							 NULL,
+							 &pgstrom_gpu_trace,
+							 false,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	DefineCustomStringVariable("pg_strom.gpu_trace_directory",
+							   "Directory to write out the GPU execution trace",
+							   NULL,
+							   &pgstrom_gpu_trace_directory,
+							   NULL,
+							   PGC_POSTMASTER,
+							   GUC_NOT_IN_SAMPLE,
+							   NULL, NULL, NULL);
+	DefineCustomBoolVariable("pg_strom.gpu_module_cache",
+							 "Enables the on-disk cache of GPU module linked for each device",
+							 NULL,
+							 &pgstrom_gpu_module_cache,
+							 true,
+							 PGC_POSTMASTER,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
 	DefineCustomIntVariable("pg_strom.cuda_stack_limit",
 							"Limit of adaptive cuda stack size per thread",
 							NULL,
@@ -0,0 +1,278 @@
+/*
+ * gpu_sort.c
+ *
+ * GPU top-k support for ORDER BY ... LIMIT pushdown
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include "pg_strom.h"
+#include "access/stratnum.h"
+
+static bool		pgstrom_enable_gpusort = true;		/* GUC */
+static int		pgstrom_gpusort_topk_max_rows = 100000;	/* GUC */
+static bool		pgstrom_enable_scan_limit = true;	/* GUC */
+
+/*
+ * __gpusort_key_kind
+ */
+static char
+__gpusort_key_kind(Oid type_oid)
+{
+	switch (type_oid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case DATEOID:
+		case TIMEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return GPUSORT_KIND__INT;
+		case FLOAT4OID:
+		case FLOAT8OID:
+			return GPUSORT_KIND__FLOAT;
+		default:
+			break;
+	}
+	return GPUSORT_KIND__NONE;
+}
+
+/*
+ * pgstrom_gpusort_sortop_kind
+ *
+ * It returns GPUSORT_KIND__* of the sort key, if 'sortop' is the default
+ * btree ordering of the device comparable type. Elsewhere, it returns
+ * GPUSORT_KIND__NONE.
+ */
+char
+pgstrom_gpusort_sortop_kind(Oid sortop, Oid sort_type, bool *p_desc)
+{
+	Oid			opfamily;
+	Oid			opcintype;
+	Oid			opclass;
+	int16		strategy;
+	char		kind;
+
+	kind = __gpusort_key_kind(sort_type);
+	if (kind == GPUSORT_KIND__NONE)
+		return GPUSORT_KIND__NONE;
+	if (!get_ordering_op_properties(sortop,
+									&opfamily,
+									&opcintype,
+									&strategy))
+		return GPUSORT_KIND__NONE;
+	opclass = GetDefaultOpClass(sort_type, BTREE_AM_OID);
+	if (!OidIsValid(opclass) ||
+		get_opclass_family(opclass) != opfamily ||
+		(strategy != BTLessStrategyNumber &&
+		 strategy != BTGreaterStrategyNumber))
+		return GPUSORT_KIND__NONE;
+	*p_desc = (strategy == BTGreaterStrategyNumber);
+	return kind;
+}
+
+/*
+ * __gpusort_groupby_limit_tuples
+ *
+ * It returns LIMIT + OFFSET of the query, if both are constant.
+ * Elsewhere, it returns -1.0.
+ */
+static double
+__gpusort_groupby_limit_tuples(Query *parse)
+{
+	Const	   *con;
+	double		limit_tuples;
+
+	if (parse->groupingSets != NIL ||
+		parse->havingQual != NULL ||
+		parse->hasWindowFuncs ||
+		parse->hasTargetSRFs ||
+		parse->distinctClause != NIL ||
+		parse->limitOption != LIMIT_OPTION_COUNT ||
+		!parse->limitCount ||
+		!IsA(parse->limitCount, Const))
+		return -1.0;
+	con = (Const *)parse->limitCount;
+	if (con->constisnull)
+		return -1.0;
+	limit_tuples = (double)DatumGetInt64(con->constvalue);
+	if (parse->limitOffset)
+	{
+		con = (Const *)parse->limitOffset;
+		if (!IsA(con, Const))
+			return -1.0;
+		if (!con->constisnull)
+			limit_tuples += (double)DatumGetInt64(con->constvalue);
+	}
+	return limit_tuples;
+}
+
+/*
+ * pgstrom_build_gpusort_topk
+ *
+ * When GpuScan/GpuJoin is the top-level scan/join of the query with
+ * ORDER BY ... LIMIT, its results are pruned on the GPU to the first
+ * N rows (and ties) of every result chunk. It is always a superset of
+ * the final top-N rows, so the Sort node on the host side can produce
+ * the same results with much smaller number of input rows.
+ * Only the first sort key is checked on the device; it must be a column
+ * of the device projection with fixed-length type of the default btree
+ * ordering.
+ * GpuPreAgg that finalizes the groups on the device also prunes its kds_final
+ * at XpuTaskFinal, if the sort key is a grouping key, so join, aggregation
+ * and top-k are processed in a single device pipeline.
+ */
+void
+pgstrom_build_gpusort_topk(PlannerInfo *root,
+						   RelOptInfo *rel,
+						   CustomScan *cscan,
+						   pgstromPlanInfo *pp_info)
+{
+	Query		   *parse = root->parse;
+	SortGroupClause *sgc;
+	Node		   *sort_expr;
+	bool			sort_desc;
+	char			kind;
+	double			limit_tuples;
+	ListCell	   *lc;
+
+	if (!pgstrom_enable_gpusort ||
+		(pp_info->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0)
+		return;
+	if ((pp_info->xpu_task_flags & DEVTASK__PREAGG) == 0)
+	{
+		/*
+		 * planner sets limit_tuples only if no aggregation, window-functions,
+		 * DISTINCT or target SRFs are between the scan/join and the LIMIT.
+		 */
+		limit_tuples = root->limit_tuples;
+	}
+	else if (pp_info->groupby_final_on_device)
+	{
+		/*
+		 * GpuPreAgg returns the unique groups at XpuTaskFinal without the
+		 * upper Agg node, so the top-k is applicable to the kds_final; only
+		 * a simple projection is between the GpuPreAgg and the Sort.
+		 */
+		limit_tuples = __gpusort_groupby_limit_tuples(parse);
+	}
+	else
+		return;
+	if (limit_tuples < 1.0 ||
+		limit_tuples > (double)pgstrom_gpusort_topk_max_rows ||
+		parse->sortClause == NIL ||
+		parse->rowMarks != NIL)
+		return;
+	/* all the relations must be scanned / joined by this node */
+	if (!bms_is_subset(root->all_baserels, rel->relids))
+		return;
+	/* host quals may remove rows after the top-k */
+	if (cscan->scan.plan.qual != NIL ||
+		pp_info->host_quals != NIL)
+		return;
+
+	sgc = linitial(parse->sortClause);
+	sort_expr = get_sortgroupclause_expr(sgc, parse->targetList);
+	/* kds_final keeps the partial results of aggregates, not final ones */
+	if ((pp_info->xpu_task_flags & DEVTASK__PREAGG) != 0 &&
+		contain_agg_clause(sort_expr))
+		return;
+	/* sort operator must be the default btree ordering */
+	kind = pgstrom_gpusort_sortop_kind(sgc->sortop,
+									   exprType(sort_expr),
+									   &sort_desc);
+	if (kind == GPUSORT_KIND__NONE)
+		return;
+
+	/* lookup the sort key column on the device projection */
+	foreach (lc, cscan->custom_scan_tlist)
+	{
+		TargetEntry *tle = lfirst(lc);
+
+		if (!tle->resjunk && equal(tle->expr, sort_expr))
+		{
+			pp_info->gpusort_limit = (int)limit_tuples;
+			pp_info->gpusort_resno = tle->resno;
+			pp_info->gpusort_kind  = kind;
+			pp_info->gpusort_desc  = sort_desc;
+			pp_info->gpusort_nulls_first = sgc->nulls_first;
+			break;
+		}
+	}
+}
+
+/*
+ * pgstrom_build_scan_limit
+ *
+ * When GpuScan/GpuJoin is the top-level scan/join of the query with LIMIT
+ * but no ORDER BY, the upper node never pulls more than the first N rows.
+ * So, the executor stops to issue the next chunks once N rows are returned,
+ * and cancels the tasks in-flight on the GPU service.
+ */
+void
+pgstrom_build_scan_limit(PlannerInfo *root,
+						 RelOptInfo *rel,
+						 pgstromPlanInfo *pp_info)
+{
+	Query	   *parse = root->parse;
+
+	if (!pgstrom_enable_scan_limit ||
+		(pp_info->xpu_task_flags & DEVKIND__NVIDIA_GPU) == 0 ||
+		(pp_info->xpu_task_flags & DEVTASK__PREAGG) != 0 ||
+		pp_info->gpuwin_desc != NULL)
+		return;
+	/*
+	 * planner sets limit_tuples only if no aggregation, window-functions,
+	 * DISTINCT or target SRFs are between the scan/join and the LIMIT.
+	 */
+	if (root->limit_tuples < 1.0 ||
+		root->limit_tuples > (double)INT_MAX ||
+		parse->sortClause != NIL ||
+		parse->rowMarks != NIL)
+		return;
+	/* all the relations must be scanned / joined by this node */
+	if (!bms_is_subset(root->all_baserels, rel->relids))
+		return;
+	pp_info->scan_limit = (int)root->limit_tuples;
+}
+
+/*
+ * pgstrom_init_gpu_sort
+ */
+void
+pgstrom_init_gpu_sort(void)
+{
+	/* pg_strom.enable_gpusort */
+	DefineCustomBoolVariable("pg_strom.enable_gpusort",
+							 "Enables GPU top-k for ORDER BY ... LIMIT",
+							 NULL,
+							 &pgstrom_enable_gpusort,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* pg_strom.gpusort_topk_max_rows */
+	DefineCustomIntVariable("pg_strom.gpusort_topk_max_rows",
+							"Max LIMIT to be pushed down to GPU top-k",
+							NULL,
+							&pgstrom_gpusort_topk_max_rows,
+							100000,
+							1,
+							INT_MAX,
+							PGC_USERSET,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	/* pg_strom.enable_scan_limit */
+	DefineCustomBoolVariable("pg_strom.enable_scan_limit",
+							 "Enables early termination of GPU scan on LIMIT",
+							 NULL,
+							 &pgstrom_enable_scan_limit,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+}
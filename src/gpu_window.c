@@ -0,0 +1,553 @@
+/*
+ * gpu_window.c
+ *
+ * Window functions with GPU acceleration
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include "pg_strom.h"
+
+/* static variables */
+static create_upper_paths_hook_type	create_upper_paths_next = NULL;
+static CustomPathMethods	gpuwindow_path_methods;
+static CustomScanMethods	gpuwindow_plan_methods;
+static CustomExecMethods	gpuwindow_exec_methods;
+static bool					pgstrom_enable_gpuwindow = true;	/* GUC */
+
+/* flags of pp_info->gpuwin_key_flags */
+#define GPUWIN_KEY__KIND_MASK		0x00ff
+#define GPUWIN_KEY__DESC			0x0100
+#define GPUWIN_KEY__NULLS_FIRST		0x0200
+
+/*
+ * List of supported window functions
+ */
+static struct {
+	Oid			winfnoid;
+	uint32_t	action;
+} gpuwindow_func_catalog[] = {
+	{F_ROW_NUMBER,		KWIN_ACTION__ROW_NUMBER},
+	{F_RANK_,			KWIN_ACTION__RANK},
+	{F_DENSE_RANK_,		KWIN_ACTION__DENSE_RANK},
+	{F_COUNT_,			KWIN_ACTION__NROWS_ANY},
+	{F_COUNT_ANY,		KWIN_ACTION__NROWS_COND},
+	{F_MIN_INT2,		KWIN_ACTION__PMIN_INT},
+	{F_MIN_INT4,		KWIN_ACTION__PMIN_INT},
+	{F_MIN_INT8,		KWIN_ACTION__PMIN_INT},
+	{F_MIN_FLOAT4,		KWIN_ACTION__PMIN_FP},
+	{F_MIN_FLOAT8,		KWIN_ACTION__PMIN_FP},
+	{F_MAX_INT2,		KWIN_ACTION__PMAX_INT},
+	{F_MAX_INT4,		KWIN_ACTION__PMAX_INT},
+	{F_MAX_INT8,		KWIN_ACTION__PMAX_INT},
+	{F_MAX_FLOAT4,		KWIN_ACTION__PMAX_FP},
+	{F_MAX_FLOAT8,		KWIN_ACTION__PMAX_FP},
+	{F_SUM_INT2,		KWIN_ACTION__PSUM_INT},
+	{F_SUM_INT4,		KWIN_ACTION__PSUM_INT},
+	{F_SUM_FLOAT4,		KWIN_ACTION__PSUM_FP},
+	{F_SUM_FLOAT8,		KWIN_ACTION__PSUM_FP},
+	{InvalidOid,		0},
+};
+
+static uint32_t
+__gpuwindow_func_action(WindowFunc *wfunc)
+{
+	for (int i=0; OidIsValid(gpuwindow_func_catalog[i].winfnoid); i++)
+	{
+		if (gpuwindow_func_catalog[i].winfnoid == wfunc->winfnoid)
+			return gpuwindow_func_catalog[i].action;
+	}
+	return 0;
+}
+
+static inline bool
+__gpuwindow_action_is_rank(uint32_t action)
+{
+	return (action == KWIN_ACTION__ROW_NUMBER ||
+			action == KWIN_ACTION__RANK ||
+			action == KWIN_ACTION__DENSE_RANK);
+}
+
+/*
+ * __tryAddGpuWindowPath
+ *
+ * GpuWindow replaces the WindowAgg + Sort on the GpuScan/GpuJoin. Right now,
+ * only a single window clause with the running aggregates (frame is from the
+ * beginning of the partition to the current row) is supported.
+ */
+static void
+__tryAddGpuWindowPath(PlannerInfo *root,
+					  RelOptInfo *input_rel,
+					  RelOptInfo *window_rel)
+{
+	Query	   *parse = root->parse;
+	PathTarget *target = root->upper_targets[UPPERREL_WINDOW];
+	pgstromOuterPathLeafInfo *op_leaf;
+	pgstromPlanInfo *pp_info;
+	CustomPath *cpath;
+	WindowClause *wclause = NULL;
+	List	   *inner_target_list = NIL;
+	List	   *wfuncs_list = NIL;
+	List	   *actions_list = NIL;
+	List	   *key_exprs = NIL;
+	List	   *key_flags = NIL;
+	bool		has_aggfuncs = false;
+	bool		rows_frame = false;
+	int			frame_options;
+	double		input_nrows;
+	Cost		startup_cost;
+	Cost		run_cost;
+	ListCell   *lc;
+
+	/* only non-parallel GpuScan/GpuJoin without parameters */
+	op_leaf = pgstrom_find_op_normal(root, input_rel, false);
+	if (!op_leaf || op_leaf->leaf_param)
+		return;
+	pp_info = op_leaf->pp_info;
+	if ((pp_info->xpu_task_flags & DEVKIND__ANY) != DEVKIND__NVIDIA_GPU ||
+		(pp_info->xpu_task_flags & DEVTASK__PREAGG) != 0 ||
+		pp_info->host_quals != NIL)
+		return;
+	for (int i=0; i < pp_info->num_rels; i++)
+	{
+		JoinType	join_type = pp_info->inners[i].join_type;
+
+		if (join_type == JOIN_RIGHT || join_type == JOIN_FULL)
+			return;
+	}
+	foreach (lc, op_leaf->inner_paths_list)
+	{
+		Path	   *i_path = lfirst(lc);
+
+		inner_target_list = lappend(inner_target_list, i_path->pathtarget);
+	}
+
+	/* check window functions */
+	foreach (lc, target->exprs)
+	{
+		Node	   *node = lfirst(lc);
+		WindowFunc *wfunc;
+		uint32_t	action;
+
+		if (!contain_window_function(node))
+			continue;
+		if (!IsA(node, WindowFunc))
+			return;
+		wfunc = (WindowFunc *)node;
+		if (!wclause)
+		{
+			ListCell   *cell;
+
+			foreach (cell, parse->windowClause)
+			{
+				WindowClause *wc = lfirst(cell);
+
+				if (wc->winref == wfunc->winref)
+				{
+					wclause = wc;
+					break;
+				}
+			}
+			if (!wclause)
+				return;
+		}
+		else if (wclause->winref != wfunc->winref)
+			return;		/* only single window clause */
+		if (wfunc->aggfilter != NULL)
+			return;
+		action = __gpuwindow_func_action(wfunc);
+		if (action == 0)
+			return;
+		if (action != KWIN_ACTION__NROWS_ANY && wfunc->args != NIL)
+		{
+			Expr   *arg = linitial(wfunc->args);
+
+			if (!IsA(arg, Var) &&
+				!pgstrom_xpu_expression(arg,
+										pp_info->xpu_task_flags,
+										pp_info->scan_relid,
+										inner_target_list,
+										NULL))
+				return;
+		}
+		if (!__gpuwindow_action_is_rank(action))
+			has_aggfuncs = true;
+		wfuncs_list = lappend(wfuncs_list, wfunc);
+		actions_list = lappend_int(actions_list, action);
+	}
+	if (!wclause ||
+		wclause->runCondition != NIL ||
+		list_length(wfuncs_list) > KWIN_MAX_FUNCS)
+		return;
+
+	/* check window frame */
+	frame_options = (wclause->frameOptions & ~(FRAMEOPTION_NONDEFAULT |
+											   FRAMEOPTION_BETWEEN));
+	if (frame_options == (FRAMEOPTION_ROWS |
+						  FRAMEOPTION_START_UNBOUNDED_PRECEDING |
+						  FRAMEOPTION_END_CURRENT_ROW))
+		rows_frame = true;
+	else if (frame_options != (FRAMEOPTION_RANGE |
+							   FRAMEOPTION_START_UNBOUNDED_PRECEDING |
+							   FRAMEOPTION_END_CURRENT_ROW) && has_aggfuncs)
+		return;
+
+	/* check PARTITION BY + ORDER BY keys */
+	if (list_length(wclause->partitionClause) +
+		list_length(wclause->orderClause) > KWIN_MAX_KEYS)
+		return;
+	foreach (lc, list_concat_copy(wclause->partitionClause,
+								  wclause->orderClause))
+	{
+		SortGroupClause *sgc = lfirst(lc);
+		Expr	   *expr;
+		bool		desc;
+		char		kind;
+		int			flags;
+
+		expr = (Expr *)get_sortgroupclause_expr(sgc, root->processed_tlist);
+		kind = pgstrom_gpusort_sortop_kind(sgc->sortop,
+										   exprType((Node *)expr),
+										   &desc);
+		if (kind == GPUSORT_KIND__NONE ||
+			!pgstrom_xpu_expression(expr,
+									pp_info->xpu_task_flags,
+									pp_info->scan_relid,
+									inner_target_list,
+									NULL))
+			return;
+		flags = kind;
+		if (desc)
+			flags |= GPUWIN_KEY__DESC;
+		if (sgc->nulls_first)
+			flags |= GPUWIN_KEY__NULLS_FIRST;
+		key_exprs = lappend(key_exprs, expr);
+		key_flags = lappend_int(key_flags, flags);
+	}
+
+	/* setup pgstromPlanInfo */
+	pp_info = copy_pgstrom_plan_info(op_leaf->pp_info);
+	pp_info->gpuwin_funcs = wfuncs_list;
+	pp_info->gpuwin_func_actions = actions_list;
+	pp_info->gpuwin_key_exprs = key_exprs;
+	pp_info->gpuwin_key_flags = key_flags;
+	pp_info->gpuwin_npart_keys = list_length(wclause->partitionClause);
+	pp_info->gpuwin_rows_frame = rows_frame;
+
+	/* No tuples shall be generated until child JOIN/SCAN path completion */
+	input_nrows = PP_INFO_NUM_ROWS(pp_info);
+	startup_cost = (pp_info->startup_cost +
+					pp_info->inner_cost +
+					pp_info->run_cost);
+	/* Cost estimation for bitonic sorting */
+	if (key_exprs != NIL && input_nrows > 1.0)
+	{
+		double	lg = log2(input_nrows);
+
+		startup_cost += (pgstrom_gpu_operator_cost *
+						 list_length(key_exprs) *
+						 input_nrows * lg * lg / 2.0);
+	}
+	/* Cost estimation for window functions */
+	startup_cost += (pgstrom_gpu_operator_cost *
+					 list_length(wfuncs_list) *
+					 input_nrows);
+	/* Cost estimation to fetch results */
+	run_cost = pgstrom_gpu_tuple_cost * input_nrows;
+
+	cpath = makeNode(CustomPath);
+	cpath->path.pathtype         = T_CustomScan;
+	cpath->path.parent           = input_rel;
+	cpath->path.pathtarget       = target;
+	cpath->path.param_info       = NULL;
+	cpath->path.parallel_aware   = false;
+	cpath->path.parallel_safe    = false;
+	cpath->path.parallel_workers = 0;
+	cpath->path.rows             = input_nrows;
+	cpath->path.startup_cost     = startup_cost;
+	cpath->path.total_cost       = startup_cost + run_cost;
+	cpath->path.pathkeys         = NIL;
+	cpath->custom_paths          = op_leaf->inner_paths_list;
+	cpath->custom_private        = list_make1(pp_info);
+	cpath->methods               = &gpuwindow_path_methods;
+
+	add_path(window_rel, &cpath->path);
+}
+
+/*
+ * GpuWindowAddCustomPath
+ */
+static void
+GpuWindowAddCustomPath(PlannerInfo *root,
+					   UpperRelationKind stage,
+					   RelOptInfo *input_rel,
+					   RelOptInfo *window_rel,
+					   void *extra)
+{
+	if (create_upper_paths_next)
+		create_upper_paths_next(root,
+								stage,
+								input_rel,
+								window_rel,
+								extra);
+	if (stage != UPPERREL_WINDOW)
+		return;
+	if (pgstrom_enabled() &&
+		pgstrom_enable_gpuwindow &&
+		gpuserv_ready_accept())
+		__tryAddGpuWindowPath(root, input_rel, window_rel);
+}
+
+/*
+ * __window_tlist_dev_member
+ */
+static int
+__window_tlist_dev_member(codegen_context *context, Expr *expr)
+{
+	TargetEntry *tle;
+	ListCell   *lc;
+
+	foreach (lc, context->tlist_dev)
+	{
+		tle = lfirst(lc);
+
+		if (!tle->resjunk && equal(tle->expr, expr))
+			return tle->resno;
+	}
+	tle = makeTargetEntry(expr,
+						  list_length(context->tlist_dev) + 1,
+						  NULL,
+						  false);
+	context->tlist_dev = lappend(context->tlist_dev, tle);
+	return tle->resno;
+}
+
+/*
+ * __window_arg_kind
+ */
+static char
+__window_arg_kind(Oid type_oid)
+{
+	switch (type_oid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+			return GPUSORT_KIND__INT;
+		case FLOAT4OID:
+		case FLOAT8OID:
+			return GPUSORT_KIND__FLOAT;
+		default:
+			break;
+	}
+	return GPUSORT_KIND__NONE;
+}
+
+/*
+ * pgstrom_build_window_tlist_dev
+ *
+ * It adds the sort keys and arguments of the window functions to the device
+ * projection, then a NULL column and the placeholders of the window functions
+ * at the tail; the NULL column ensures the null-bitmap of the result tuples,
+ * so the placeholders can be updated to NULL later.
+ */
+void
+pgstrom_build_window_tlist_dev(codegen_context *context,
+							   pgstromPlanInfo *pp_info)
+{
+	kern_window_desc *kwin_desc;
+	bytea	   *xpucode;
+	int			nfuncs = list_length(pp_info->gpuwin_funcs);
+	int			nkeys = list_length(pp_info->gpuwin_key_exprs);
+	size_t		sz = offsetof(kern_window_desc, funcs[nfuncs]);
+	int			k = 0;
+	ListCell   *lc1, *lc2;
+
+	Assert(nfuncs > 0 && nfuncs <= KWIN_MAX_FUNCS && nkeys <= KWIN_MAX_KEYS);
+	xpucode = palloc0(VARHDRSZ + sz);
+	SET_VARSIZE(xpucode, VARHDRSZ + sz);
+	kwin_desc = (kern_window_desc *)VARDATA(xpucode);
+	kwin_desc->nkeys = nkeys;
+	kwin_desc->npart_keys = pp_info->gpuwin_npart_keys;
+	kwin_desc->nfuncs = nfuncs;
+	kwin_desc->rows_frame = pp_info->gpuwin_rows_frame;
+
+	/* PARTITION BY + ORDER BY keys */
+	forboth (lc1, pp_info->gpuwin_key_exprs,
+			 lc2, pp_info->gpuwin_key_flags)
+	{
+		kern_window_key *wkey = &kwin_desc->keys[k++];
+		int			flags = lfirst_int(lc2);
+
+		wkey->resno = __window_tlist_dev_member(context, lfirst(lc1));
+		wkey->kind = (flags & GPUWIN_KEY__KIND_MASK);
+		wkey->desc = ((flags & GPUWIN_KEY__DESC) != 0);
+		wkey->nulls_first = ((flags & GPUWIN_KEY__NULLS_FIRST) != 0);
+	}
+	/* arguments of the window functions */
+	k = 0;
+	forboth (lc1, pp_info->gpuwin_funcs,
+			 lc2, pp_info->gpuwin_func_actions)
+	{
+		WindowFunc *wfunc = lfirst(lc1);
+		kern_window_func *wf = &kwin_desc->funcs[k++];
+
+		wf->action = lfirst_int(lc2);
+		if (wf->action != KWIN_ACTION__NROWS_ANY && wfunc->args != NIL)
+		{
+			Expr   *arg = linitial(wfunc->args);
+
+			wf->arg_resno = __window_tlist_dev_member(context, arg);
+			wf->arg_kind = __window_arg_kind(exprType((Node *)arg));
+		}
+	}
+	/* NULL column */
+	context->tlist_dev = lappend(context->tlist_dev,
+								 makeTargetEntry((Expr *)makeNullConst(INT4OID, -1,
+																	   InvalidOid),
+												 list_length(context->tlist_dev) + 1,
+												 NULL,
+												 false));
+	/* placeholders of the window functions */
+	k = 0;
+	foreach (lc1, pp_info->gpuwin_funcs)
+	{
+		WindowFunc *wfunc = lfirst(lc1);
+		kern_window_func *wf = &kwin_desc->funcs[k++];
+		TargetEntry *tle;
+		int16		typlen;
+		bool		typbyval;
+
+		get_typlenbyval(wfunc->wintype, &typlen, &typbyval);
+		tle = makeTargetEntry((Expr *)makeConst(wfunc->wintype,
+												-1,
+												InvalidOid,
+												typlen,
+												(Datum)0,
+												false,
+												typbyval),
+							  list_length(context->tlist_dev) + 1,
+							  NULL,
+							  false);
+		context->tlist_dev = lappend(context->tlist_dev, tle);
+		wf->resno = tle->resno;
+	}
+	pp_info->gpuwin_desc = xpucode;
+}
+
+/*
+ * pgstrom_fixup_window_tlist_dev
+ *
+ * Once device projection is built, placeholders are replaced by the original
+ * WindowFunc, so setrefs.c can reference them from the upper target-list.
+ */
+void
+pgstrom_fixup_window_tlist_dev(codegen_context *context,
+							   pgstromPlanInfo *pp_info)
+{
+	kern_window_desc *kwin_desc = (kern_window_desc *)
+		VARDATA(pp_info->gpuwin_desc);
+	int			k = 0;
+	ListCell   *lc;
+
+	foreach (lc, pp_info->gpuwin_funcs)
+	{
+		kern_window_func *wf = &kwin_desc->funcs[k++];
+		TargetEntry *tle = list_nth(context->tlist_dev, wf->resno - 1);
+
+		Assert(IsA(tle->expr, Const));
+		tle->expr = (Expr *)lfirst(lc);
+	}
+}
+
+/*
+ * PlanGpuWindowPath
+ */
+static Plan *
+PlanGpuWindowPath(PlannerInfo *root,
+				  RelOptInfo *joinrel,
+				  CustomPath *cpath,
+				  List *tlist,
+				  List *clauses,
+				  List *custom_plans)
+{
+	pgstromPlanInfo *pp_info = linitial(cpath->custom_private);
+	CustomScan	   *cscan;
+
+	cscan = PlanXpuJoinPathCommon(root,
+								  joinrel,
+								  cpath,
+								  tlist,
+								  custom_plans,
+								  pp_info,
+								  &gpuwindow_plan_methods);
+	form_pgstrom_plan_info(cscan, pp_info);
+	return &cscan->scan.plan;
+}
+
+/*
+ * CreateGpuWindowScanState
+ */
+static Node *
+CreateGpuWindowScanState(CustomScan *cscan)
+{
+	Assert(cscan->methods == &gpuwindow_plan_methods);
+	return pgstromCreateTaskState(cscan, &gpuwindow_exec_methods);
+}
+
+/*
+ * ExecFallbackCpuWindow
+ */
+bool
+ExecFallbackCpuWindow(pgstromTaskState *pts, HeapTuple tuple)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("CPU Fallback of GpuWindow is not implemented yet"),
+			 errhint("'pg_strom.enable_gpuwindow' configuration can turn off GpuWindow only")));
+	return false;
+}
+
+/*
+ * pgstrom_init_gpu_window
+ */
+void
+pgstrom_init_gpu_window(void)
+{
+	/* pg_strom.enable_gpuwindow */
+	DefineCustomBoolVariable("pg_strom.enable_gpuwindow",
+							 "Enables the use of GPU window functions",
+							 NULL,
+							 &pgstrom_enable_gpuwindow,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+
+	/* initialization of path method table */
+	memset(&gpuwindow_path_methods, 0, sizeof(CustomPathMethods));
+	gpuwindow_path_methods.CustomName          = "GpuWindow";
+	gpuwindow_path_methods.PlanCustomPath      = PlanGpuWindowPath;
+
+	/* initialization of plan method table */
+	memset(&gpuwindow_plan_methods, 0, sizeof(CustomScanMethods));
+	gpuwindow_plan_methods.CustomName          = "GpuWindow";
+	gpuwindow_plan_methods.CreateCustomScanState = CreateGpuWindowScanState;
+	RegisterCustomScanMethods(&gpuwindow_plan_methods);
+
+	/* initialization of exec method table */
+	memset(&gpuwindow_exec_methods, 0, sizeof(CustomExecMethods));
+	gpuwindow_exec_methods.CustomName          = "GpuWindow";
+	gpuwindow_exec_methods.BeginCustomScan     = pgstromExecInitTaskState;
+	gpuwindow_exec_methods.ExecCustomScan      = pgstromExecTaskState;
+	gpuwindow_exec_methods.EndCustomScan       = pgstromExecEndTaskState;
+	gpuwindow_exec_methods.ReScanCustomScan    = pgstromExecResetTaskState;
+	gpuwindow_exec_methods.ExplainCustomScan   = pgstromExplainTaskState;
+
+	/* hook registration */
+	create_upper_paths_next = create_upper_paths_hook;
+	create_upper_paths_hook = GpuWindowAddCustomPath;
+}
@@ -0,0 +1,869 @@
+/*
+ * gpudirect_bench.c
+ *
+ * I/O throughput benchmark of GPU Direct SQL. Unlike the generic tools
+ * (like gdsio), it replays the access patterns of PG-Strom; the heap-segment
+ * chunks of relscan.c (runs of BLCKSZ blocks, partially skipped if not
+ * all-visible) and the Arrow record-batch chunks of arrow_fdw.c (referenced
+ * column buffers only), through the same heterodb-extra entry points used
+ * by extra.c. It reports the throughput, the ratio of direct/VFS read pages,
+ * and the latency percentiles per chunk, so I/O tuning of NVMe RAID or GDS
+ * can be validated outside of the database ("make gpudirect_bench" at src/).
+ * --
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include <dlfcn.h>
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <cuda.h>
+#include "pg_config.h"		/* BLCKSZ, RELSEG_SIZE and PG_VERSION_NUM */
+#include "heterodb_extra.h"
+
+#define __Elog(fmt,...)								\
+	do {											\
+		fprintf(stderr, "[%s:%d] " fmt "\n",		\
+				__FILE__, __LINE__, ##__VA_ARGS__);	\
+		exit(1);									\
+	} while(0)
+#define Min(a,b)			((a) < (b) ? (a) : (b))
+#define Max(a,b)			((a) > (b) ? (a) : (b))
+#define PAGE_SIZE			4096
+#define PAGES_PER_BLOCK		(BLCKSZ / PAGE_SIZE)
+#define TYPEALIGN_DOWN(ALIGNVAL,LEN)	\
+	(((uintptr_t) (LEN)) & ~((uintptr_t) ((ALIGNVAL) - 1)))
+
+#define GPUDIRECT_DRIVER__CUFILE		'n'
+#define GPUDIRECT_DRIVER__NVME_STROM	'h'
+#define GPUDIRECT_DRIVER__VFS			'v'
+
+/*
+ * heterodb-extra entry points (see extra.c)
+ */
+static char *(*p_heterodb_extra_module_init)(unsigned int pg_version_num) = NULL;
+static int	(*p_heterodb_extra_get_error)(const char **p_filename,
+										  unsigned int *p_lineno,
+										  const char **p_funcname,
+										  char *buffer, size_t buffer_sz) = NULL;
+static void	(*p_gpudirect__driver_init_v2)(void) = NULL;
+static int	(*p_cufile__driver_open_v2)(void) = NULL;
+static int	(*p_cufile__driver_close_v2)(void) = NULL;
+static int	(*p_cufile__map_gpu_memory_v2)(CUdeviceptr m_segment,
+										   size_t segment_sz) = NULL;
+static int	(*p_cufile__unmap_gpu_memory_v2)(CUdeviceptr m_segment) = NULL;
+static int	(*p_cufile__register_stream_v3)(CUstream cuda_stream,
+											uint32_t flags) = NULL;
+static int	(*p_cufile__deregister_stream_v3)(CUstream cuda_stream) = NULL;
+static int	(*p_cufile__read_file_iov_v3)(
+	const char *pathname,
+	CUdeviceptr m_segment,
+	off_t m_offset,
+	const strom_io_vector *iovec,
+	uint32_t *p_npages_direct_read,
+	uint32_t *p_npages_vfs_read) = NULL;
+static int	(*p_cufile__read_file_async_iov_v3)(
+	const char *pathname,
+	CUdeviceptr m_segment,
+	off_t m_offset,
+	const strom_io_vector *iovec,
+	CUstream cuda_stream,
+	uint32_t *p_error_code_async,
+	uint32_t *p_npages_direct_read,
+	uint32_t *p_npages_vfs_read) = NULL;
+static int	(*p_nvme_strom__driver_open)(void) = NULL;
+static int	(*p_nvme_strom__driver_close)(void) = NULL;
+static int	(*p_nvme_strom__map_gpu_memory)(CUdeviceptr m_segment,
+											size_t m_segment_sz,
+											unsigned long *p_iomap_handle) = NULL;
+static int	(*p_nvme_strom__unmap_gpu_memory)(unsigned long iomap_handle) = NULL;
+static int	(*p_nvme_strom__read_file_iov)(
+	const char *pathname,
+	unsigned long iomap_handle,
+	off_t m_offset,
+	const strom_io_vector *iovec,
+	uint32_t *p_npages_direct_read,
+	uint32_t *p_npages_vfs_read) = NULL;
+static int	(*p_vfs_fallback__read_file_iov)(
+	const char *pathname,
+	CUdeviceptr m_segment,
+	off_t m_offset,
+	void *dma_buffer,
+	size_t dma_buffer_sz,
+	CUstream cuda_stream,
+	const strom_io_vector *iovec,
+	uint32_t *p_npages_direct_read,
+	uint32_t *p_npages_vfs_read) = NULL;
+
+/*
+ * command line options
+ */
+static const char  *bench_filename = NULL;
+static struct stat	bench_stat_buf;
+static int			bench_gpu_id = 0;
+static size_t		bench_chunk_sz = (64UL << 20);	/* -c, --chunk-size */
+static int			bench_queue_depth = 4;			/* -q, --queue-depth */
+static bool			bench_arrow_mode = false;		/* -m, --mode */
+static int			bench_skip_ratio = 0;			/* --skip (heap) */
+static int			bench_arrow_ncols = 16;			/* --columns (arrow) */
+static int			bench_arrow_nrefs = 4;
+static int			bench_duration = 0;				/* -t, --duration */
+static int			bench_driver_kind = 0;			/* --driver */
+static bool			bench_async = false;			/* --async */
+static unsigned int	bench_seed = 20240418;			/* -s, --seed */
+static bool			verbose = false;
+
+static CUcontext	bench_cuda_context = NULL;
+static uint64_t		bench_nchunks;					/* chunks per pass */
+static volatile uint64_t bench_next_chunk = 0;
+static struct timespec bench_tv_start;
+
+/*
+ * gpuDirectBenchWorker - per queue-slot state
+ */
+typedef struct
+{
+	pthread_t	thread;
+	int			index;
+	CUdeviceptr	m_segment;
+	unsigned long iomap_handle;
+	CUstream	cuda_stream;
+	void	   *dma_buffer;		/* VFS driver only */
+	size_t		dma_buffer_sz;
+	strom_io_vector *iovec;
+	unsigned int rand_seed;
+	/* statistics */
+	uint64_t	nchunks;
+	uint64_t	nbytes;
+	uint64_t	npages_direct;
+	uint64_t	npages_vfs;
+	uint64_t	nrooms;
+	double	   *latency;		/* [ms] per chunk */
+} gpuDirectBenchWorker;
+
+static double
+__elapsed_ms(const struct timespec *tv1, const struct timespec *tv2)
+{
+	return ((double)(tv2->tv_sec  - tv1->tv_sec) * 1000.0 +
+			(double)(tv2->tv_nsec - tv1->tv_nsec) / 1000000.0);
+}
+
+static void
+__extraElog(const char *label)
+{
+	const char *filename = "???";
+	unsigned int lineno = 0;
+	const char *funcname = "???";
+	char		buffer[2000];
+
+	if (p_heterodb_extra_get_error &&
+		p_heterodb_extra_get_error(&filename,
+								   &lineno,
+								   &funcname,
+								   buffer, sizeof(buffer)) != 0)
+		__Elog("%s: (%s:%u) %s [%s]", label, filename, lineno, buffer, funcname);
+	__Elog("%s: something failed", label);
+}
+
+static void
+__cudaElog(const char *label, CUresult rc)
+{
+	const char *errname = NULL;
+
+	cuGetErrorName(rc, &errname);
+	__Elog("failed on %s: %s", label, errname ? errname : "???");
+}
+
+/*
+ * setup the heterodb-extra module
+ */
+static void *
+__lookupExtraFunction(void *handle, const char *symbol, bool missing_ok)
+{
+	void   *fn_addr = dlsym(handle, symbol);
+
+	if (!fn_addr && !missing_ok)
+		__Elog("could not find extra symbol \"%s\" - %s", symbol, dlerror());
+	return fn_addr;
+}
+#define LOOKUP_EXTRA_FUNCTION(symbol,missing_ok)	\
+	p_##symbol = __lookupExtraFunction(handle, #symbol, missing_ok)
+
+static void
+setupHeteroDBExtraModule(void)
+{
+	void	   *handle;
+	const char *extra_module_info;
+	bool		has_cufile;
+	bool		has_nvme_strom;
+
+	handle = dlopen(HETERODB_EXTRA_FILENAME, RTLD_NOW | RTLD_LOCAL);
+	if (!handle)
+	{
+		handle = dlopen(HETERODB_EXTRA_PATHNAME, RTLD_NOW | RTLD_LOCAL);
+		if (!handle)
+			__Elog("HeteroDB Extra module is not available - %s", dlerror());
+	}
+	LOOKUP_EXTRA_FUNCTION(heterodb_extra_module_init, false);
+	LOOKUP_EXTRA_FUNCTION(heterodb_extra_get_error, false);
+	extra_module_info = p_heterodb_extra_module_init(PG_VERSION_NUM);
+	if (!extra_module_info)
+		__Elog("out of memory");
+	has_cufile = (strstr(extra_module_info, "cufile=on") != NULL);
+	has_nvme_strom = (strstr(extra_module_info, "nvme_strom=on") != NULL);
+	if (verbose)
+		fprintf(stderr, "HeteroDB Extra module loaded [%s]\n", extra_module_info);
+
+	LOOKUP_EXTRA_FUNCTION(gpudirect__driver_init_v2, false);
+	if (has_cufile)
+	{
+		LOOKUP_EXTRA_FUNCTION(cufile__driver_open_v2, false);
+		LOOKUP_EXTRA_FUNCTION(cufile__driver_close_v2, false);
+		LOOKUP_EXTRA_FUNCTION(cufile__map_gpu_memory_v2, false);
+		LOOKUP_EXTRA_FUNCTION(cufile__unmap_gpu_memory_v2, false);
+		LOOKUP_EXTRA_FUNCTION(cufile__register_stream_v3, false);
+		LOOKUP_EXTRA_FUNCTION(cufile__deregister_stream_v3, false);
+		LOOKUP_EXTRA_FUNCTION(cufile__read_file_iov_v3, false);
+		LOOKUP_EXTRA_FUNCTION(cufile__read_file_async_iov_v3, false);
+	}
+	if (has_nvme_strom)
+	{
+		LOOKUP_EXTRA_FUNCTION(nvme_strom__driver_open, false);
+		LOOKUP_EXTRA_FUNCTION(nvme_strom__driver_close, false);
+		LOOKUP_EXTRA_FUNCTION(nvme_strom__map_gpu_memory, false);
+		LOOKUP_EXTRA_FUNCTION(nvme_strom__unmap_gpu_memory, false);
+		LOOKUP_EXTRA_FUNCTION(nvme_strom__read_file_iov, false);
+	}
+	LOOKUP_EXTRA_FUNCTION(vfs_fallback__read_file_iov, false);
+	if (has_cufile || has_nvme_strom)
+		p_gpudirect__driver_init_v2();
+
+	/* choose the driver, if not given */
+	if (bench_driver_kind == 0)
+	{
+		if (has_cufile)
+			bench_driver_kind = GPUDIRECT_DRIVER__CUFILE;
+		else if (has_nvme_strom)
+			bench_driver_kind = GPUDIRECT_DRIVER__NVME_STROM;
+		else
+			bench_driver_kind = GPUDIRECT_DRIVER__VFS;
+	}
+	else if (bench_driver_kind == GPUDIRECT_DRIVER__CUFILE && !has_cufile)
+		__Elog("cuFile is not available");
+	else if (bench_driver_kind == GPUDIRECT_DRIVER__NVME_STROM && !has_nvme_strom)
+		__Elog("nvme_strom is not available");
+
+	if (bench_driver_kind == GPUDIRECT_DRIVER__CUFILE)
+	{
+		if (p_cufile__driver_open_v2() != 0)
+			__extraElog("cufile__driver_open_v2");
+	}
+	else if (bench_driver_kind == GPUDIRECT_DRIVER__NVME_STROM)
+	{
+		if (p_nvme_strom__driver_open() != 0)
+			__extraElog("nvme_strom__driver_open");
+	}
+}
+
+static void
+cleanupHeteroDBExtraModule(void)
+{
+	if (bench_driver_kind == GPUDIRECT_DRIVER__CUFILE)
+	{
+		if (p_cufile__driver_close_v2() != 0)
+			__extraElog("cufile__driver_close_v2");
+	}
+	else if (bench_driver_kind == GPUDIRECT_DRIVER__NVME_STROM)
+	{
+		if (p_nvme_strom__driver_close() != 0)
+			__extraElog("nvme_strom__driver_close");
+	}
+}
+
+/*
+ * __setupHeapChunkIOV
+ *
+ * It builds the i/o vector of the heap-segment chunk, as relscan.c doing;
+ * contiguous blocks are merged into one i/o chunk, and the chunk never
+ * crosses the boundary of the heap segment (RELSEG_SIZE). --skip emulates
+ * the blocks not loaded by GPU Direct SQL (not all-visible, or dirty).
+ */
+static size_t
+__setupHeapChunkIOV(gpuDirectBenchWorker *worker, uint64_t chunk_id)
+{
+	strom_io_vector *iovec = worker->iovec;
+	strom_io_chunk *ioc = NULL;
+	uint64_t	nblocks_per_chunk = bench_chunk_sz / BLCKSZ;
+	uint64_t	nchunks_per_seg = (RELSEG_SIZE + nblocks_per_chunk - 1) / nblocks_per_chunk;
+	uint64_t	file_nblocks = bench_stat_buf.st_size / BLCKSZ;
+	uint64_t	block_num;
+	uint64_t	block_end;
+	unsigned long m_offset = 0;
+
+	block_num = ((chunk_id / nchunks_per_seg) * RELSEG_SIZE +
+				 (chunk_id % nchunks_per_seg) * nblocks_per_chunk);
+	block_end = Min(block_num + nblocks_per_chunk,
+					(block_num / RELSEG_SIZE + 1) * RELSEG_SIZE);
+	block_end = Min(block_end, file_nblocks);
+
+	iovec->nr_chunks = 0;
+	for (; block_num < block_end; block_num++)
+	{
+		unsigned int	fchunk_id;
+
+		if (bench_skip_ratio > 0 &&
+			rand_r(&worker->rand_seed) % 100 < bench_skip_ratio)
+			continue;
+		fchunk_id = block_num * PAGES_PER_BLOCK;
+		if (ioc != NULL && (ioc->fchunk_id + ioc->nr_pages) == fchunk_id)
+		{
+			/* expand the iovec entry */
+			ioc->nr_pages += PAGES_PER_BLOCK;
+		}
+		else
+		{
+			/* add the next iovec entry */
+			ioc = &iovec->ioc[iovec->nr_chunks++];
+			ioc->m_offset  = m_offset;
+			ioc->fchunk_id = fchunk_id;
+			ioc->nr_pages  = PAGES_PER_BLOCK;
+		}
+		m_offset += BLCKSZ;
+	}
+	return m_offset;
+}
+
+/*
+ * __setupArrowChunkIOV
+ *
+ * It builds the i/o vector of the Arrow record-batch, as arrow_fdw.c doing;
+ * the record-batch consists of --columns=NCOLS buffers of the same length,
+ * and only NREFS buffers of them are referenced by the query.
+ */
+static size_t
+__setupArrowChunkIOV(gpuDirectBenchWorker *worker, uint64_t chunk_id)
+{
+	strom_io_vector *iovec = worker->iovec;
+	size_t		column_sz = TYPEALIGN_DOWN(PAGE_SIZE, bench_chunk_sz /
+										   bench_arrow_ncols);
+	off_t		rb_base = chunk_id * column_sz * bench_arrow_ncols;
+	unsigned long m_offset = 0;
+
+	iovec->nr_chunks = 0;
+	for (int j=0; j < bench_arrow_nrefs; j++)
+	{
+		int			cindex = (j * bench_arrow_ncols) / bench_arrow_nrefs;
+		off_t		f_pos = rb_base + cindex * column_sz;
+		strom_io_chunk *ioc;
+
+		if (f_pos >= bench_stat_buf.st_size)
+			break;
+		ioc = &iovec->ioc[iovec->nr_chunks++];
+		ioc->m_offset  = m_offset;
+		ioc->fchunk_id = f_pos / PAGE_SIZE;
+		ioc->nr_pages  = Min(column_sz, bench_stat_buf.st_size - f_pos) / PAGE_SIZE;
+		m_offset += ioc->nr_pages * PAGE_SIZE;
+	}
+	return m_offset;
+}
+
+/*
+ * __readChunk - a call of the heterodb-extra read routines
+ */
+static void
+__readChunk(gpuDirectBenchWorker *worker,
+			uint32_t *p_npages_direct,
+			uint32_t *p_npages_vfs)
+{
+	uint32_t	error_code_async = 0;
+	CUresult	rc;
+
+	switch (bench_driver_kind)
+	{
+		case GPUDIRECT_DRIVER__CUFILE:
+			if (!bench_async)
+			{
+				if (p_cufile__read_file_iov_v3(bench_filename,
+											   worker->m_segment,
+											   0,
+											   worker->iovec,
+											   p_npages_direct,
+											   p_npages_vfs) != 0)
+					__extraElog("cufile__read_file_iov_v3");
+				return;
+			}
+			if (p_cufile__read_file_async_iov_v3(bench_filename,
+												 worker->m_segment,
+												 0,
+												 worker->iovec,
+												 worker->cuda_stream,
+												 &error_code_async,
+												 p_npages_direct,
+												 p_npages_vfs) != 0)
+				__extraElog("cufile__read_file_async_iov_v3");
+			break;
+
+		case GPUDIRECT_DRIVER__NVME_STROM:
+			if (p_nvme_strom__read_file_iov(bench_filename,
+											worker->iomap_handle,
+											0,
+											worker->iovec,
+											p_npages_direct,
+											p_npages_vfs) != 0)
+				__extraElog("nvme_strom__read_file_iov");
+			return;
+
+		default:
+			if (p_vfs_fallback__read_file_iov(bench_filename,
+											  worker->m_segment,
+											  0,
+											  worker->dma_buffer,
+											  worker->dma_buffer_sz,
+											  worker->cuda_stream,
+											  worker->iovec,
+											  p_npages_direct,
+											  p_npages_vfs) != 0)
+				__extraElog("vfs_fallback__read_file_iov");
+			break;
+	}
+	rc = cuStreamSynchronize(worker->cuda_stream);
+	if (rc != CUDA_SUCCESS)
+		__cudaElog("cuStreamSynchronize", rc);
+	if (error_code_async != 0)
+		__Elog("async read of '%s' failed (error code: %u)",
+			   bench_filename, error_code_async);
+}
+
+/*
+ * gpuDirectBenchWorkerMain
+ */
+static void *
+gpuDirectBenchWorkerMain(void *__priv)
+{
+	gpuDirectBenchWorker *worker = __priv;
+	CUresult	rc;
+
+	rc = cuCtxSetCurrent(bench_cuda_context);
+	if (rc != CUDA_SUCCESS)
+		__cudaElog("cuCtxSetCurrent", rc);
+	for (;;)
+	{
+		uint64_t	chunk_id = __atomic_fetch_add(&bench_next_chunk, 1,
+												  __ATOMIC_SEQ_CST);
+		struct timespec tv1, tv2;
+		uint32_t	npages_direct = 0;
+		uint32_t	npages_vfs = 0;
+		size_t		nbytes;
+
+		if (bench_duration > 0)
+		{
+			clock_gettime(CLOCK_MONOTONIC, &tv1);
+			if (__elapsed_ms(&bench_tv_start, &tv1) >= 1000.0 * bench_duration)
+				break;
+			chunk_id %= bench_nchunks;
+		}
+		else if (chunk_id >= bench_nchunks)
+			break;
+
+		if (bench_arrow_mode)
+			nbytes = __setupArrowChunkIOV(worker, chunk_id);
+		else
+			nbytes = __setupHeapChunkIOV(worker, chunk_id);
+		if (worker->iovec->nr_chunks == 0)
+			continue;
+
+		clock_gettime(CLOCK_MONOTONIC, &tv1);
+		__readChunk(worker, &npages_direct, &npages_vfs);
+		clock_gettime(CLOCK_MONOTONIC, &tv2);
+
+		if (worker->nchunks >= worker->nrooms)
+		{
+			worker->nrooms = Max(2 * worker->nrooms, 1000);
+			worker->latency = realloc(worker->latency,
+									  sizeof(double) * worker->nrooms);
+			if (!worker->latency)
+				__Elog("out of memory");
+		}
+		worker->latency[worker->nchunks++] = __elapsed_ms(&tv1, &tv2);
+		worker->nbytes += nbytes;
+		worker->npages_direct += npages_direct;
+		worker->npages_vfs += npages_vfs;
+	}
+	return NULL;
+}
+
+/*
+ * setup/cleanup of the workers
+ */
+static void
+setupBenchWorker(gpuDirectBenchWorker *worker, int index)
+{
+	size_t		nrooms;
+	CUresult	rc;
+
+	memset(worker, 0, sizeof(gpuDirectBenchWorker));
+	worker->index = index;
+	worker->rand_seed = bench_seed + index;
+	nrooms = (bench_arrow_mode
+			  ? bench_arrow_nrefs
+			  : bench_chunk_sz / BLCKSZ);
+	worker->iovec = calloc(1, offsetof(strom_io_vector, ioc[nrooms]));
+	if (!worker->iovec)
+		__Elog("out of memory");
+
+	rc = cuMemAlloc(&worker->m_segment, bench_chunk_sz);
+	if (rc != CUDA_SUCCESS)
+		__cudaElog("cuMemAlloc", rc);
+	rc = cuStreamCreate(&worker->cuda_stream, CU_STREAM_NON_BLOCKING);
+	if (rc != CUDA_SUCCESS)
+		__cudaElog("cuStreamCreate", rc);
+	switch (bench_driver_kind)
+	{
+		case GPUDIRECT_DRIVER__CUFILE:
+			if (p_cufile__map_gpu_memory_v2(worker->m_segment,
+											bench_chunk_sz) != 0)
+				__extraElog("cufile__map_gpu_memory_v2");
+			/* see gpuDirectRegisterStream */
+			if (bench_async &&
+				p_cufile__register_stream_v3(worker->cuda_stream, 15) != 0)
+				__extraElog("cufile__register_stream_v3");
+			break;
+		case GPUDIRECT_DRIVER__NVME_STROM:
+			if (p_nvme_strom__map_gpu_memory(worker->m_segment,
+											 bench_chunk_sz,
+											 &worker->iomap_handle) != 0)
+				__extraElog("nvme_strom__map_gpu_memory");
+			break;
+		default:
+			worker->dma_buffer_sz = bench_chunk_sz + (8UL << 20);
+			rc = cuMemAllocHost(&worker->dma_buffer, worker->dma_buffer_sz);
+			if (rc != CUDA_SUCCESS)
+				__cudaElog("cuMemAllocHost", rc);
+			break;
+	}
+}
+
+static void
+cleanupBenchWorker(gpuDirectBenchWorker *worker)
+{
+	switch (bench_driver_kind)
+	{
+		case GPUDIRECT_DRIVER__CUFILE:
+			if (bench_async &&
+				p_cufile__deregister_stream_v3(worker->cuda_stream) != 0)
+				__extraElog("cufile__deregister_stream_v3");
+			if (p_cufile__unmap_gpu_memory_v2(worker->m_segment) != 0)
+				__extraElog("cufile__unmap_gpu_memory_v2");
+			break;
+		case GPUDIRECT_DRIVER__NVME_STROM:
+			if (p_nvme_strom__unmap_gpu_memory(worker->iomap_handle) != 0)
+				__extraElog("nvme_strom__unmap_gpu_memory");
+			break;
+		default:
+			cuMemFreeHost(worker->dma_buffer);
+			break;
+	}
+	cuStreamDestroy(worker->cuda_stream);
+	cuMemFree(worker->m_segment);
+	free(worker->iovec);
+}
+
+/*
+ * print the results
+ */
+static int
+__compare_latency(const void *__a, const void *__b)
+{
+	double	a = *((const double *)__a);
+	double	b = *((const double *)__b);
+
+	if (a < b)
+		return -1;
+	if (a > b)
+		return 1;
+	return 0;
+}
+
+static void
+printBenchResults(gpuDirectBenchWorker *workers, double elapsed_ms)
+{
+	uint64_t	nchunks = 0;
+	uint64_t	nbytes = 0;
+	uint64_t	npages_direct = 0;
+	uint64_t	npages_vfs = 0;
+	double	   *latency;
+	double		total = 0.0;
+	const char *driver_name;
+
+	for (int i=0; i < bench_queue_depth; i++)
+	{
+		nchunks += workers[i].nchunks;
+		nbytes += workers[i].nbytes;
+		npages_direct += workers[i].npages_direct;
+		npages_vfs += workers[i].npages_vfs;
+	}
+	latency = malloc(sizeof(double) * Max(nchunks, 1));
+	if (!latency)
+		__Elog("out of memory");
+	nchunks = 0;
+	for (int i=0; i < bench_queue_depth; i++)
+	{
+		memcpy(latency + nchunks, workers[i].latency,
+			   sizeof(double) * workers[i].nchunks);
+		nchunks += workers[i].nchunks;
+	}
+	qsort(latency, nchunks, sizeof(double), __compare_latency);
+	for (uint64_t k=0; k < nchunks; k++)
+		total += latency[k];
+
+	if (bench_driver_kind == GPUDIRECT_DRIVER__CUFILE)
+		driver_name = (bench_async ? "cufile (async)" : "cufile");
+	else if (bench_driver_kind == GPUDIRECT_DRIVER__NVME_STROM)
+		driver_name = "nvme_strom";
+	else
+		driver_name = "vfs";
+
+	printf("file:        %s (%.2fGB)\n",
+		   bench_filename, (double)bench_stat_buf.st_size / (double)(1UL<<30));
+	if (bench_arrow_mode)
+		printf("mode:        arrow (record-batch %zuMB, %d of %d columns)\n",
+			   bench_chunk_sz >> 20, bench_arrow_nrefs, bench_arrow_ncols);
+	else
+		printf("mode:        heap (chunk %zuMB, %d%% blocks skipped)\n",
+			   bench_chunk_sz >> 20, bench_skip_ratio);
+	printf("driver:      %s, GPU%d, queue-depth %d\n",
+		   driver_name, bench_gpu_id, bench_queue_depth);
+	printf("read:        %.2fGB in %lu chunks, %.2fs (direct %.1f%%, vfs %.1f%%)\n",
+		   (double)nbytes / (double)(1UL<<30),
+		   nchunks,
+		   elapsed_ms / 1000.0,
+		   100.0 * (double)npages_direct / (double)Max(npages_direct + npages_vfs, 1),
+		   100.0 * (double)npages_vfs / (double)Max(npages_direct + npages_vfs, 1));
+	printf("throughput:  %.2f GB/s\n",
+		   ((double)nbytes / (double)(1UL<<30)) / (elapsed_ms / 1000.0));
+	if (nchunks > 0)
+		printf("latency[ms]: avg %.2f, p50 %.2f, p90 %.2f, p99 %.2f, max %.2f\n",
+			   total / (double)nchunks,
+			   latency[(nchunks * 50) / 100],
+			   latency[(nchunks * 90) / 100],
+			   latency[(nchunks * 99) / 100],
+			   latency[nchunks - 1]);
+	free(latency);
+}
+
+static void
+usage(void)
+{
+	fputs("usage: gpudirect_bench [OPTIONS] -f FILE\n"
+		  "\n"
+		  "\t-f|--file=FILE           file to read (heap segment or Arrow file)\n"
+		  "\t-g|--gpu=GPU_ID          GPU device to be used (default: 0)\n"
+		  "\t-m|--mode=heap|arrow     access pattern (default: heap)\n"
+		  "\t-c|--chunk-size=MB       chunk / record-batch size (default: 64)\n"
+		  "\t-q|--queue-depth=N       number of concurrent chunks (default: 4)\n"
+		  "\t   --skip=PCT            ratio of skipped heap blocks (default: 0)\n"
+		  "\t   --columns=NCOLS:NREFS Arrow columns and referenced ones (default: 16:4)\n"
+		  "\t-t|--duration=SEC        run for the duration (default: one pass)\n"
+		  "\t   --driver=DRIVER       cufile, nvme_strom or vfs (default: auto)\n"
+		  "\t   --async               asynchronous read by cuFile\n"
+		  "\t-s|--seed=SEED           random seed of --skip\n"
+		  "\t-v|--verbose             verbose output\n"
+		  "\t-h|--help                shows this message\n",
+		  stderr);
+	exit(1);
+}
+
+static long
+__parse_long(const char *optarg, const char *label, long min, long max)
+{
+	char   *end;
+	long	val = strtol(optarg, &end, 10);
+
+	if (*optarg == '\0' || *end != '\0')
+		__Elog("%s [%s] is not valid", label, optarg);
+	if (val < min || val > max)
+		__Elog("%s [%ld] is out of range", label, val);
+	return val;
+}
+
+int
+main(int argc, char *argv[])
+{
+	static struct option command_options[] = {
+		{"file",        required_argument, 0,  'f'},
+		{"gpu",         required_argument, 0,  'g'},
+		{"mode",        required_argument, 0,  'm'},
+		{"chunk-size",  required_argument, 0,  'c'},
+		{"queue-depth", required_argument, 0,  'q'},
+		{"skip",        required_argument, 0, 1001},
+		{"columns",     required_argument, 0, 1002},
+		{"duration",    required_argument, 0,  't'},
+		{"driver",      required_argument, 0, 1003},
+		{"async",       no_argument,       0, 1004},
+		{"seed",        required_argument, 0,  's'},
+		{"verbose",     no_argument,       0,  'v'},
+		{"help",        no_argument,       0,  'h'},
+		{NULL, 0, 0, 0},
+	};
+	gpuDirectBenchWorker *workers;
+	struct timespec tv_end;
+	CUdevice	cuda_device;
+	CUresult	rc;
+
+	for (;;)
+	{
+		int		c = getopt_long(argc, argv, "f:g:m:c:q:t:s:vh",
+								command_options, NULL);
+		if (c < 0)
+			break;
+		switch (c)
+		{
+			case 'f':
+				bench_filename = optarg;
+				break;
+			case 'g':
+				bench_gpu_id = __parse_long(optarg, "GPU id", 0, INT_MAX);
+				break;
+			case 'm':
+				if (strcmp(optarg, "heap") == 0)
+					bench_arrow_mode = false;
+				else if (strcmp(optarg, "arrow") == 0)
+					bench_arrow_mode = true;
+				else
+					__Elog("unknown mode [%s]", optarg);
+				break;
+			case 'c':
+				bench_chunk_sz = __parse_long(optarg, "chunk size", 1, 4096) << 20;
+				break;
+			case 'q':
+				bench_queue_depth = __parse_long(optarg, "queue depth", 1, 1024);
+				break;
+			case 1001:
+				bench_skip_ratio = __parse_long(optarg, "skip ratio", 0, 99);
+				break;
+			case 1002:
+				if (sscanf(optarg, "%d:%d",
+						   &bench_arrow_ncols,
+						   &bench_arrow_nrefs) != 2 ||
+					bench_arrow_ncols < 1 ||
+					bench_arrow_nrefs < 1 ||
+					bench_arrow_nrefs > bench_arrow_ncols)
+					__Elog("--columns [%s] is not valid", optarg);
+				break;
+			case 't':
+				bench_duration = __parse_long(optarg, "duration", 1, INT_MAX);
+				break;
+			case 1003:
+				if (strcmp(optarg, "cufile") == 0)
+					bench_driver_kind = GPUDIRECT_DRIVER__CUFILE;
+				else if (strcmp(optarg, "nvme_strom") == 0)
+					bench_driver_kind = GPUDIRECT_DRIVER__NVME_STROM;
+				else if (strcmp(optarg, "vfs") == 0)
+					bench_driver_kind = GPUDIRECT_DRIVER__VFS;
+				else
+					__Elog("unknown driver [%s]", optarg);
+				break;
+			case 1004:
+				bench_async = true;
+				break;
+			case 's':
+				bench_seed = __parse_long(optarg, "seed", 0, UINT_MAX);
+				break;
+			case 'v':
+				verbose = true;
+				break;
+			default:
+				usage();
+				break;
+		}
+	}
+	if (!bench_filename || optind != argc)
+		usage();
+	if (stat(bench_filename, &bench_stat_buf) != 0)
+		__Elog("failed on stat('%s'): %m", bench_filename);
+	if (bench_chunk_sz < BLCKSZ ||
+		(bench_arrow_mode && bench_chunk_sz / bench_arrow_ncols < PAGE_SIZE))
+		__Elog("chunk size is too small");
+
+	if (bench_arrow_mode)
+	{
+		size_t	rb_length = (TYPEALIGN_DOWN(PAGE_SIZE, bench_chunk_sz /
+											bench_arrow_ncols) * bench_arrow_ncols);
+		bench_nchunks = (bench_stat_buf.st_size + rb_length - 1) / rb_length;
+	}
+	else
+	{
+		uint64_t	nblocks_per_chunk = bench_chunk_sz / BLCKSZ;
+		uint64_t	file_nblocks = bench_stat_buf.st_size / BLCKSZ;
+		uint64_t	nchunks_per_seg = ((RELSEG_SIZE + nblocks_per_chunk - 1) /
+									   nblocks_per_chunk);
+		uint64_t	nsegs = file_nblocks / RELSEG_SIZE;
+		uint64_t	tail = file_nblocks % RELSEG_SIZE;
+
+		bench_nchunks = (nsegs * nchunks_per_seg +
+						 (tail + nblocks_per_chunk - 1) / nblocks_per_chunk);
+	}
+	if (bench_nchunks == 0)
+		__Elog("file '%s' is too small", bench_filename);
+	if (bench_async && bench_driver_kind != 0 &&
+		bench_driver_kind != GPUDIRECT_DRIVER__CUFILE)
+		__Elog("--async is only supported by cufile driver");
+
+	/* init CUDA context */
+	rc = cuInit(0);
+	if (rc != CUDA_SUCCESS)
+		__cudaElog("cuInit", rc);
+	rc = cuDeviceGet(&cuda_device, bench_gpu_id);
+	if (rc != CUDA_SUCCESS)
+		__cudaElog("cuDeviceGet", rc);
+	rc = cuDevicePrimaryCtxRetain(&bench_cuda_context, cuda_device);
+	if (rc != CUDA_SUCCESS)
+		__cudaElog("cuDevicePrimaryCtxRetain", rc);
+	rc = cuCtxSetCurrent(bench_cuda_context);
+	if (rc != CUDA_SUCCESS)
+		__cudaElog("cuCtxSetCurrent", rc);
+
+	/* init heterodb-extra module */
+	setupHeteroDBExtraModule();
+	if (bench_async && bench_driver_kind != GPUDIRECT_DRIVER__CUFILE)
+		__Elog("--async is only supported by cufile driver");
+
+	/* launch the workers */
+	workers = calloc(bench_queue_depth, sizeof(gpuDirectBenchWorker));
+	if (!workers)
+		__Elog("out of memory");
+	for (int i=0; i < bench_queue_depth; i++)
+		setupBenchWorker(&workers[i], i);
+	clock_gettime(CLOCK_MONOTONIC, &bench_tv_start);
+	for (int i=0; i < bench_queue_depth; i++)
+	{
+		if ((errno = pthread_create(&workers[i].thread, NULL,
+									gpuDirectBenchWorkerMain,
+									&workers[i])) != 0)
+			__Elog("failed on pthread_create: %m");
+	}
+	for (int i=0; i < bench_queue_depth; i++)
+		pthread_join(workers[i].thread, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &tv_end);
+
+	printBenchResults(workers, __elapsed_ms(&bench_tv_start, &tv_end));
+
+	for (int i=0; i < bench_queue_depth; i++)
+		cleanupBenchWorker(&workers[i]);
+	cleanupHeteroDBExtraModule();
+	cuDevicePrimaryCtxRelease(cuda_device);
+	return 0;
+}
@@ -0,0 +1,611 @@
+/*
+ * hintbits.c
+ *
+ * Background worker to set hint bits of the heap tuples ahead of GPU-scan
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include "pg_strom.h"
+
+/*
+ * hintBitsEntry
+ *
+ * GPU-Direct SQL loads the heap pages that are all-visible, or whose
+ * tuples have hint bits enough to check MVCC visibility on the device
+ * (see pgstromRelScanDirectMVCCEnabled). The relations scanned by GPU-
+ * Direct SQL are registered here, then the background worker of the
+ * database walks the pages that are not all-visible, and sets the hint
+ * bits of the tuples within the I/O budget.
+ */
+typedef struct
+{
+	Oid			database_oid;
+	Oid			table_oid;
+} hintBitsKey;
+
+typedef struct
+{
+	hintBitsKey	key;
+	uint64		generation;		/* # of modification at the last sweep */
+	TimestampTz	last_scan;		/* last GPU-Direct scan on the relation */
+	TimestampTz	last_sweep;		/* last completion of the sweep */
+	BlockNumber	next_block;		/* current position of the sweep */
+	BlockNumber	nblocks;		/* # of blocks at the last sweep */
+	BlockNumber	nblocks_all_visible;	/* # of all-visible blocks */
+	BlockNumber	nblocks_hint_complete;	/* # of blocks with hint bits */
+	BlockNumber	__nblocks_all_visible;	/* counter of the current sweep */
+	BlockNumber	__nblocks_hint_complete;/* counter of the current sweep */
+} hintBitsEntry;
+
+#define HINTBITS_MAX_WORKERS		16
+
+typedef struct
+{
+	LWLock		lock;
+	HTAB	   *hash;
+	Oid			worker_databases[HINTBITS_MAX_WORKERS];
+} hintBitsSharedHead;
+
+static hintBitsSharedHead *hintbits_head = NULL;
+static int		pgstrom_hintbits_setter_max_entries;	/* GUC */
+static int		pgstrom_hintbits_setter_naptime;		/* GUC */
+static int		pgstrom_hintbits_setter_io_budget;		/* GUC */
+static shmem_request_hook_type shmem_request_next = NULL;
+static shmem_startup_hook_type shmem_startup_next = NULL;
+
+void	pgstromHintBitsSetterMain(Datum arg);
+
+/*
+ * __hintBitsRelationGeneration
+ */
+static uint64
+__hintBitsRelationGeneration(Oid table_oid)
+{
+	PgStat_StatTabEntry *tabentry;
+
+	tabentry = pgstat_fetch_stat_tabentry(table_oid);
+	if (!tabentry)
+		return 0;
+	return (tabentry->tuples_inserted +
+			tabentry->tuples_updated +
+			tabentry->tuples_deleted +
+			tabentry->vacuum_count);
+}
+
+/*
+ * __hintBitsLaunchWorker - caller must hold the lock exclusively
+ */
+static void
+__hintBitsLaunchWorker(Oid database_oid)
+{
+	BackgroundWorker worker;
+	int			index = -1;
+
+	for (int i=0; i < HINTBITS_MAX_WORKERS; i++)
+	{
+		Oid		__database_oid = hintbits_head->worker_databases[i];
+
+		if (__database_oid == database_oid)
+			return;		/* already running */
+		if (index < 0 && !OidIsValid(__database_oid))
+			index = i;
+	}
+	if (index < 0)
+		return;			/* no more workers */
+
+	memset(&worker, 0, sizeof(BackgroundWorker));
+	snprintf(worker.bgw_name, sizeof(worker.bgw_name),
+			 "PG-Strom Hint-Bits Setter (DB: %u)", database_oid);
+	snprintf(worker.bgw_type, sizeof(worker.bgw_type),
+			 "PG-Strom Hint-Bits Setter");
+	worker.bgw_flags = (BGWORKER_SHMEM_ACCESS |
+						BGWORKER_BACKEND_DATABASE_CONNECTION);
+	worker.bgw_start_time = BgWorkerStart_RecoveryFinished;
+	worker.bgw_restart_time = BGW_NEVER_RESTART;
+	snprintf(worker.bgw_library_name, BGW_MAXLEN,
+			 "$libdir/pg_strom");
+	snprintf(worker.bgw_function_name, BGW_MAXLEN,
+			 "pgstromHintBitsSetterMain");
+	worker.bgw_main_arg = ObjectIdGetDatum(database_oid);
+	if (RegisterDynamicBackgroundWorker(&worker, NULL))
+		hintbits_head->worker_databases[index] = database_oid;
+	else
+		elog(DEBUG1, "unable to launch the hint-bits setter (DB: %u)",
+			 database_oid);
+}
+
+/*
+ * pgstromHintBitsSetterRegister
+ *
+ * It registers the relation scanned by GPU-Direct SQL, then launches the
+ * background worker of the current database, if not running.
+ */
+void
+pgstromHintBitsSetterRegister(Relation relation)
+{
+	hintBitsKey	key;
+	hintBitsEntry *entry;
+	bool		found;
+
+	if (!hintbits_head || RecoveryInProgress())
+		return;
+	memset(&key, 0, sizeof(hintBitsKey));
+	key.database_oid = MyDatabaseId;
+	key.table_oid = RelationGetRelid(relation);
+
+	LWLockAcquire(&hintbits_head->lock, LW_EXCLUSIVE);
+	entry = hash_search(hintbits_head->hash,
+						&key,
+						HASH_ENTER_NULL,
+						&found);
+	if (entry)
+	{
+		if (!found)
+			memset(&entry->generation, 0,
+				   sizeof(hintBitsEntry) - offsetof(hintBitsEntry, generation));
+		entry->last_scan = GetCurrentTimestamp();
+		__hintBitsLaunchWorker(MyDatabaseId);
+	}
+	LWLockRelease(&hintbits_head->lock);
+}
+
+/*
+ * __hintBitsTupleIsComplete
+ *
+ * It checks whether the hint bits of the tuple are enough to check MVCC
+ * visibility on the device; it must be consistent to the device code.
+ */
+static bool
+__hintBitsTupleIsComplete(HeapTupleHeader htup)
+{
+	uint16		infomask = htup->t_infomask;
+
+	if ((infomask & HEAP_MOVED) != 0)
+		return false;
+	if ((infomask & (HEAP_XMIN_COMMITTED | HEAP_XMIN_INVALID)) == 0)
+		return false;
+	if ((infomask & HEAP_XMIN_COMMITTED) == 0)
+		return true;		/* aborted, so invisible */
+	if ((infomask & HEAP_XMAX_INVALID) != 0 ||
+		HEAP_XMAX_IS_LOCKED_ONLY(infomask))
+		return true;
+	return ((infomask & HEAP_XMAX_IS_MULTI) == 0 &&
+			(infomask & HEAP_XMAX_COMMITTED) != 0);
+}
+
+/*
+ * __hintBitsSweepOneRelation
+ *
+ * It walks the pages of the relation from the current position, then
+ * returns number of pages read; up to the 'budget'.
+ */
+static int
+__hintBitsSweepOneRelation(hintBitsEntry *entry, int budget)
+{
+	Relation	relation;
+	BufferAccessStrategy strategy;
+	Buffer		vm_buffer = InvalidBuffer;
+	TransactionId oldest_xmin;
+	BlockNumber	block_num;
+	BlockNumber	nblocks;
+	BlockNumber	nblocks_all_visible;
+	BlockNumber	nblocks_hint_complete;
+	int			nreads = 0;
+
+	relation = try_relation_open(entry->key.table_oid, AccessShareLock);
+	if (!relation)
+		return -1;
+	if (relation->rd_rel->relkind != RELKIND_RELATION &&
+		relation->rd_rel->relkind != RELKIND_MATVIEW)
+	{
+		relation_close(relation, AccessShareLock);
+		return -1;
+	}
+	nblocks = RelationGetNumberOfBlocks(relation);
+	oldest_xmin = GetOldestNonRemovableTransactionId(relation);
+	strategy = GetAccessStrategy(BAS_BULKREAD);
+
+	LWLockAcquire(&hintbits_head->lock, LW_SHARED);
+	block_num = entry->next_block;
+	nblocks_all_visible = entry->__nblocks_all_visible;
+	nblocks_hint_complete = entry->__nblocks_hint_complete;
+	LWLockRelease(&hintbits_head->lock);
+
+	for (; block_num < nblocks && nreads < budget; block_num++)
+	{
+		Buffer		buffer;
+		Page		page;
+		OffsetNumber off, maxoff;
+		bool		hint_complete = true;
+
+		CHECK_FOR_INTERRUPTS();
+		if (VM_ALL_VISIBLE(relation, block_num, &vm_buffer))
+		{
+			nblocks_all_visible++;
+			continue;
+		}
+		buffer = ReadBufferExtended(relation, MAIN_FORKNUM, block_num,
+									RBM_NORMAL, strategy);
+		LockBuffer(buffer, BUFFER_LOCK_SHARE);
+		page = BufferGetPage(buffer);
+		maxoff = PageGetMaxOffsetNumber(page);
+		for (off = FirstOffsetNumber; off <= maxoff; off = OffsetNumberNext(off))
+		{
+			ItemId		lpp = PageGetItemId(page, off);
+			HeapTupleData tuple;
+
+			if (!ItemIdIsNormal(lpp))
+				continue;
+			tuple.t_data = (HeapTupleHeader) PageGetItem(page, lpp);
+			tuple.t_len = ItemIdGetLength(lpp);
+			tuple.t_tableOid = RelationGetRelid(relation);
+			ItemPointerSet(&tuple.t_self, block_num, off);
+			/* it sets the hint bits, if xmin/xmax are already resolved */
+			HeapTupleSatisfiesVacuum(&tuple, oldest_xmin, buffer);
+			if (!__hintBitsTupleIsComplete(tuple.t_data))
+				hint_complete = false;
+		}
+		if (hint_complete)
+			nblocks_hint_complete++;
+		/*
+		 * GPU-Direct SQL reads the page from the storage, so write the
+		 * page with the new hint bits, if dirty.
+		 */
+		FlushOneBuffer(buffer);
+		UnlockReleaseBuffer(buffer);
+		nreads++;
+	}
+	if (vm_buffer != InvalidBuffer)
+		ReleaseBuffer(vm_buffer);
+	FreeAccessStrategy(strategy);
+	relation_close(relation, AccessShareLock);
+
+	LWLockAcquire(&hintbits_head->lock, LW_EXCLUSIVE);
+	if (block_num < nblocks)
+	{
+		entry->next_block = block_num;
+		entry->__nblocks_all_visible = nblocks_all_visible;
+		entry->__nblocks_hint_complete = nblocks_hint_complete;
+	}
+	else
+	{
+		entry->next_block = 0;
+		entry->nblocks = nblocks;
+		entry->nblocks_all_visible = nblocks_all_visible;
+		entry->nblocks_hint_complete = nblocks_hint_complete;
+		entry->__nblocks_all_visible = 0;
+		entry->__nblocks_hint_complete = 0;
+		entry->last_sweep = GetCurrentTimestamp();
+	}
+	LWLockRelease(&hintbits_head->lock);
+
+	return nreads;
+}
+
+/*
+ * __hintBitsSetterOneRound
+ *
+ * It sweeps the relations of the database that are modified since the
+ * last sweep, then returns true if any relations are pending.
+ */
+static bool
+__hintBitsSetterOneRound(void)
+{
+	HASH_SEQ_STATUS	hseq;
+	hintBitsEntry  *entry;
+	List	   *table_oids = NIL;
+	ListCell   *lc;
+	int			budget = pgstrom_hintbits_setter_io_budget;
+	bool		has_pending = false;
+
+	LWLockAcquire(&hintbits_head->lock, LW_SHARED);
+	hash_seq_init(&hseq, hintbits_head->hash);
+	while ((entry = hash_seq_search(&hseq)) != NULL)
+	{
+		if (entry->key.database_oid == MyDatabaseId)
+			table_oids = lappend_oid(table_oids, entry->key.table_oid);
+	}
+	LWLockRelease(&hintbits_head->lock);
+
+	StartTransactionCommand();
+	pgstat_clear_snapshot();
+	foreach (lc, table_oids)
+	{
+		hintBitsKey	key;
+		uint64		generation;
+		int			nreads;
+
+		memset(&key, 0, sizeof(hintBitsKey));
+		key.database_oid = MyDatabaseId;
+		key.table_oid = lfirst_oid(lc);
+		generation = __hintBitsRelationGeneration(key.table_oid);
+
+		LWLockAcquire(&hintbits_head->lock, LW_SHARED);
+		entry = hash_search(hintbits_head->hash,
+							&key,
+							HASH_FIND,
+							NULL);
+		if (entry && entry->next_block == 0 &&
+			entry->last_sweep != 0 &&
+			entry->generation == generation)
+			entry = NULL;		/* not modified since the last sweep */
+		LWLockRelease(&hintbits_head->lock);
+		if (!entry)
+			continue;
+		if (budget <= 0)
+		{
+			has_pending = true;
+			break;
+		}
+		/* the entry is never removed except for this worker */
+		LWLockAcquire(&hintbits_head->lock, LW_EXCLUSIVE);
+		if (entry->next_block == 0)
+			entry->generation = generation;
+		LWLockRelease(&hintbits_head->lock);
+		nreads = __hintBitsSweepOneRelation(entry, budget);
+		if (nreads < 0)
+		{
+			LWLockAcquire(&hintbits_head->lock, LW_EXCLUSIVE);
+			hash_search(hintbits_head->hash, &key, HASH_REMOVE, NULL);
+			LWLockRelease(&hintbits_head->lock);
+			continue;
+		}
+		budget -= nreads;
+		if (nreads > 0)
+			has_pending = true;
+	}
+	CommitTransactionCommand();
+
+	return has_pending;
+}
+
+/*
+ * pgstromHintBitsSetterMain
+ */
+void
+pgstromHintBitsSetterMain(Datum arg)
+{
+	Oid			database_oid = DatumGetObjectId(arg);
+	int			nloops_idle = 0;
+
+	pqsignal(SIGHUP, SignalHandlerForConfigReload);
+	BackgroundWorkerUnblockSignals();
+	BackgroundWorkerInitializeConnectionByOid(database_oid, InvalidOid, 0);
+
+	/*
+	 * The worker exits if no relations are modified for a while, then
+	 * the next GPU-Direct scan launches the worker again.
+	 */
+	while (nloops_idle < 10)
+	{
+		if (ConfigReloadPending)
+		{
+			ConfigReloadPending = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+		if (__hintBitsSetterOneRound())
+			nloops_idle = 0;
+		else
+			nloops_idle++;
+		(void) WaitLatch(MyLatch,
+						 WL_LATCH_SET |
+						 WL_TIMEOUT |
+						 WL_EXIT_ON_PM_DEATH,
+						 pgstrom_hintbits_setter_naptime,
+						 PG_WAIT_EXTENSION);
+		ResetLatch(MyLatch);
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	LWLockAcquire(&hintbits_head->lock, LW_EXCLUSIVE);
+	for (int i=0; i < HINTBITS_MAX_WORKERS; i++)
+	{
+		if (hintbits_head->worker_databases[i] == database_oid)
+			hintbits_head->worker_databases[i] = InvalidOid;
+	}
+	LWLockRelease(&hintbits_head->lock);
+	proc_exit(0);
+}
+
+/*
+ * pgstrom_gpudirect_eligibility_info
+ *
+ * It reports the fraction of GPU-Direct SQL eligible blocks of the
+ * relations at the last sweep.
+ */
+PG_FUNCTION_INFO_V1(pgstrom_gpudirect_eligibility_info);
+PUBLIC_FUNCTION(Datum)
+pgstrom_gpudirect_eligibility_info(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *fncxt;
+	List	   *info_list;
+	hintBitsEntry *entry;
+	Datum		values[9];
+	bool		isnull[9];
+	HeapTuple	tuple;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		TupleDesc	tupdesc;
+		MemoryContext oldcxt;
+		HASH_SEQ_STATUS hseq;
+
+		fncxt = SRF_FIRSTCALL_INIT();
+		oldcxt = MemoryContextSwitchTo(fncxt->multi_call_memory_ctx);
+		tupdesc = CreateTemplateTupleDesc(9);
+		TupleDescInitEntry(tupdesc, 1, "database_oid",
+						   OIDOID, -1, 0);
+		TupleDescInitEntry(tupdesc, 2, "table_oid",
+						   OIDOID, -1, 0);
+		TupleDescInitEntry(tupdesc, 3, "table_name",
+						   TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, 4, "nblocks",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 5, "nblocks_all_visible",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 6, "nblocks_hint_complete",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 7, "eligible_ratio",
+						   FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, 8, "last_scan",
+						   TIMESTAMPTZOID, -1, 0);
+		TupleDescInitEntry(tupdesc, 9, "last_sweep",
+						   TIMESTAMPTZOID, -1, 0);
+		fncxt->tuple_desc = BlessTupleDesc(tupdesc);
+
+		info_list = NIL;
+		if (hintbits_head)
+		{
+			LWLockAcquire(&hintbits_head->lock, LW_SHARED);
+			hash_seq_init(&hseq, hintbits_head->hash);
+			while ((entry = hash_seq_search(&hseq)) != NULL)
+				info_list = lappend(info_list,
+									pmemdup(entry, sizeof(hintBitsEntry)));
+			LWLockRelease(&hintbits_head->lock);
+		}
+		fncxt->user_fctx = info_list;
+
+		MemoryContextSwitchTo(oldcxt);
+	}
+	fncxt = SRF_PERCALL_SETUP();
+	info_list = (List *)fncxt->user_fctx;
+	if (info_list == NIL)
+		SRF_RETURN_DONE(fncxt);
+	entry = linitial(info_list);
+	fncxt->user_fctx = list_delete_first(info_list);
+
+	memset(isnull, 0, sizeof(isnull));
+	values[0] = ObjectIdGetDatum(entry->key.database_oid);
+	values[1] = ObjectIdGetDatum(entry->key.table_oid);
+	if (entry->key.database_oid == MyDatabaseId)
+	{
+		char   *relname = get_rel_name(entry->key.table_oid);
+
+		if (relname)
+			values[2] = CStringGetTextDatum(relname);
+		else
+			isnull[2] = true;
+	}
+	else
+		isnull[2] = true;
+	if (entry->last_sweep == 0)
+	{
+		isnull[3] = true;
+		isnull[4] = true;
+		isnull[5] = true;
+		isnull[6] = true;
+		isnull[8] = true;
+	}
+	else
+	{
+		values[3] = Int64GetDatum(entry->nblocks);
+		values[4] = Int64GetDatum(entry->nblocks_all_visible);
+		values[5] = Int64GetDatum(entry->nblocks_hint_complete);
+		if (entry->nblocks > 0)
+			values[6] = Float8GetDatum((double)(entry->nblocks_all_visible +
+												entry->nblocks_hint_complete) /
+									   (double)entry->nblocks);
+		else
+			isnull[6] = true;
+		values[8] = TimestampTzGetDatum(entry->last_sweep);
+	}
+	values[7] = TimestampTzGetDatum(entry->last_scan);
+
+	tuple = heap_form_tuple(fncxt->tuple_desc, values, isnull);
+
+	SRF_RETURN_NEXT(fncxt, HeapTupleGetDatum(tuple));
+}
+
+/*
+ * pgstrom_request_hintbits
+ */
+static void
+pgstrom_request_hintbits(void)
+{
+	if (shmem_request_next)
+		shmem_request_next();
+	RequestAddinShmemSpace(MAXALIGN(sizeof(hintBitsSharedHead)) +
+						   hash_estimate_size(pgstrom_hintbits_setter_max_entries,
+											  sizeof(hintBitsEntry)));
+}
+
+/*
+ * pgstrom_startup_hintbits
+ */
+static void
+pgstrom_startup_hintbits(void)
+{
+	HASHCTL		hctl;
+	bool		found;
+
+	if (shmem_startup_next)
+		(*shmem_startup_next)();
+
+	hintbits_head = ShmemInitStruct("pgstromHintBits(head)",
+									MAXALIGN(sizeof(hintBitsSharedHead)),
+									&found);
+	Assert(!found);
+	memset(hintbits_head, 0, sizeof(hintBitsSharedHead));
+	LWLockInitialize(&hintbits_head->lock, LWLockNewTrancheId());
+
+	memset(&hctl, 0, sizeof(HASHCTL));
+	hctl.keysize = sizeof(hintBitsKey);
+	hctl.entrysize = sizeof(hintBitsEntry);
+	hintbits_head->hash = ShmemInitHash("pgstromHintBits(hash)",
+										pgstrom_hintbits_setter_max_entries,
+										pgstrom_hintbits_setter_max_entries,
+										&hctl,
+										HASH_ELEM | HASH_BLOBS);
+}
+
+/*
+ * pgstrom_init_hintbits
+ */
+void
+pgstrom_init_hintbits(void)
+{
+	/* pg_strom.hintbits_setter_max_entries */
+	DefineCustomIntVariable("pg_strom.hintbits_setter_max_entries",
+							"Max number of relations tracked by the hint-bits setter",
+							"Hint-bits setter is disabled, if 0",
+							&pgstrom_hintbits_setter_max_entries,
+							0,
+							0,
+							INT_MAX / 2,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	/* pg_strom.hintbits_setter_naptime */
+	DefineCustomIntVariable("pg_strom.hintbits_setter_naptime",
+							"Sleep time of the hint-bits setter between rounds",
+							NULL,
+							&pgstrom_hintbits_setter_naptime,
+							10000,
+							100,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_NOT_IN_SAMPLE | GUC_UNIT_MS,
+							NULL, NULL, NULL);
+	/* pg_strom.hintbits_setter_io_budget */
+	DefineCustomIntVariable("pg_strom.hintbits_setter_io_budget",
+							"Max number of pages read by the hint-bits setter per round",
+							NULL,
+							&pgstrom_hintbits_setter_io_budget,
+							2048,
+							1,
+							INT_MAX,
+							PGC_SIGHUP,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	if (pgstrom_hintbits_setter_max_entries > 0)
+	{
+		shmem_request_next = shmem_request_hook;
+		shmem_request_hook = pgstrom_request_hintbits;
+		shmem_startup_next = shmem_startup_hook;
+		shmem_startup_hook = pgstrom_startup_hintbits;
+	}
+}
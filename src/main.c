@@ -596,9 +596,11 @@ pgstrom_post_planner(Query *parse,
 					 ParamListInfo boundParams)
 {
 	HTAB	   *saved_paths_htable = pgstrom_paths_htable;
+	HTAB	   *saved_xpu_exprs_htable;
 	PlannedStmt *pstmt;
 	ListCell   *lc;
 
+	saved_xpu_exprs_htable = pgstrom_begin_xpu_expression_cache();
 	PG_TRY();
 	{
 		pgstrom_paths_htable = NULL;
@@ -616,11 +618,13 @@ pgstrom_post_planner(Query *parse,
 	{
 		hash_destroy(pgstrom_paths_htable);
 		pgstrom_paths_htable = saved_paths_htable;
+		pgstrom_end_xpu_expression_cache(saved_xpu_exprs_htable);
 		PG_RE_THROW();
 	}
 	PG_END_TRY();
 	hash_destroy(pgstrom_paths_htable);
 	pgstrom_paths_htable = saved_paths_htable;
+	pgstrom_end_xpu_expression_cache(saved_xpu_exprs_htable);
 	return pstmt;
 }
 
@@ -665,6 +669,10 @@ _PG_init(void)
 	pgstrom_init_brin();
 	pgstrom_init_arrow_fdw();
 	pgstrom_init_executor();
+	pgstrom_init_cost_calib();
+	pgstrom_init_hintbits();
+	/* WAL replay of GpuCache is needed even if no GPUs */
+	pgstrom_init_gpu_cache_rmgr();
 	/* dump version number */
 	elog(LOG, "PG-Strom version %s built for PostgreSQL %s (githash: %s)",
 		 PGSTROM_VERSION,
@@ -677,6 +685,8 @@ _PG_init(void)
 		pgstrom_init_gpu_scan();
 		pgstrom_init_gpu_join();
 		pgstrom_init_gpu_preagg();
+		pgstrom_init_gpu_sort();
+		pgstrom_init_gpu_window();
 		pgstrom_init_gpu_cache();
 	}
 	/* init DPU related stuff */
@@ -112,6 +112,9 @@ form_pgstrom_plan_info(CustomScan *cscan, pgstromPlanInfo *pp_info)
 
 	privs = lappend(privs, makeInteger(pp_info->xpu_task_flags));
 	privs = lappend(privs, makeInteger(pp_info->gpu_cache_dindex));
+	privs = lappend(privs, pp_info->gpu_cache_vcols);
+	privs = lappend(privs, makeInteger(pp_info->gpu_cache_index_attnum));
+	exprs = lappend(exprs, pp_info->gpu_cache_index_key);
 	privs = lappend(privs, bms_to_pglist(pp_info->gpu_direct_devs));
 	endpoint_id = DpuStorageEntryGetEndpointId(pp_info->ds_entry);
 	privs = lappend(privs, makeInteger(endpoint_id));
@@ -133,13 +136,20 @@ form_pgstrom_plan_info(CustomScan *cscan, pgstromPlanInfo *pp_info)
 	privs = lappend(privs, makeInteger(pp_info->brin_index_oid));
 	privs = lappend(privs, pp_info->brin_index_conds);
 	privs = lappend(privs, pp_info->brin_index_quals);
+	/* tablesample support */
+	privs = lappend(privs, makeInteger(pp_info->tablesample_method));
+	privs = lappend(privs, makeBoolean(pp_info->tablesample_repeatable));
+	privs = lappend(privs, __makeFloat(pp_info->tablesample_percent));
+	privs = lappend(privs, __makeFloat(pp_info->tablesample_seed));
 	/* XPU code */
 	privs = lappend(privs, __makeByteaConst(pp_info->kexp_load_vars_packed));
 	privs = lappend(privs, __makeByteaConst(pp_info->kexp_move_vars_packed));
 	privs = lappend(privs, __makeByteaConst(pp_info->kexp_scan_quals));
 	privs = lappend(privs, __makeByteaConst(pp_info->kexp_join_quals_packed));
 	privs = lappend(privs, __makeByteaConst(pp_info->kexp_hash_keys_packed));
+	privs = lappend(privs, __makeByteaConst(pp_info->kexp_hash_inner_packed));
 	privs = lappend(privs, __makeByteaConst(pp_info->kexp_gist_evals_packed));
+	privs = lappend(privs, __makeByteaConst(pp_info->kexp_range_keys_packed));
 	privs = lappend(privs, __makeByteaConst(pp_info->kexp_projection));
 	privs = lappend(privs, __makeByteaConst(pp_info->kexp_groupby_keyhash));
 	privs = lappend(privs, __makeByteaConst(pp_info->kexp_groupby_keyload));
@@ -165,6 +175,20 @@ form_pgstrom_plan_info(CustomScan *cscan, pgstromPlanInfo *pp_info)
 	privs = lappend(privs, makeInteger(pp_info->cuda_stack_size));
 	privs = lappend(privs, pp_info->groupby_actions);
 	privs = lappend(privs, makeInteger(pp_info->groupby_prepfn_bufsz));
+	privs = lappend(privs, makeBoolean(pp_info->groupby_final_on_device));
+	privs = lappend(privs, makeInteger(pp_info->groupby_sibling_id));
+	privs = lappend(privs, makeInteger(pp_info->groupby_nsiblings));
+	privs = lappend(privs, makeBoolean(pp_info->groupby_streaming));
+	/* gpu top-k */
+	privs = lappend(privs, makeInteger(pp_info->gpusort_limit));
+	privs = lappend(privs, makeInteger(pp_info->gpusort_resno));
+	privs = lappend(privs, makeInteger(pp_info->gpusort_kind));
+	privs = lappend(privs, makeBoolean(pp_info->gpusort_desc));
+	privs = lappend(privs, makeBoolean(pp_info->gpusort_nulls_first));
+	/* LIMIT pushdown */
+	privs = lappend(privs, makeInteger(pp_info->scan_limit));
+	/* gpu window functions */
+	privs = lappend(privs, __makeByteaConst(pp_info->gpuwin_desc));
 	/* inner relations */
 	privs = lappend(privs, makeInteger(pp_info->sibling_param_id));
 	privs = lappend(privs, makeInteger(pp_info->num_rels));
@@ -189,6 +213,15 @@ form_pgstrom_plan_info(CustomScan *cscan, pgstromPlanInfo *pp_info)
 		__privs = lappend(__privs, __makeFloat(pp_inner->gist_selectivity));
 		__privs = lappend(__privs, __makeFloat(pp_inner->gist_npages));
 		__privs = lappend(__privs, makeInteger(pp_inner->gist_height));
+		__privs = lappend(__privs, makeInteger(pp_inner->gist_key_type));
+		__privs = lappend(__privs, makeInteger(pp_inner->gist_prep_resno));
+		__privs = lappend(__privs, makeBoolean(pp_inner->bloom_filter));
+		__privs = lappend(__privs, makeBoolean(pp_inner->hash_build_on_device));
+		__privs = lappend(__privs, makeInteger(pp_inner->dfilter_keynum));
+		__privs = lappend(__privs, makeInteger(pp_inner->dfilter_param_id));
+		__exprs = lappend(__exprs, pp_inner->range_inner_key);
+		__exprs = lappend(__exprs, pp_inner->range_outer_lower);
+		__exprs = lappend(__exprs, pp_inner->range_outer_upper);
 
 		exprs = lappend(exprs, __exprs);
 		privs = lappend(privs, __privs);
@@ -218,6 +251,9 @@ deform_pgstrom_plan_info(CustomScan *cscan)
 	/* device identifiers */
 	pp_data.xpu_task_flags = intVal(list_nth(privs, pindex++));
 	pp_data.gpu_cache_dindex = intVal(list_nth(privs, pindex++));
+	pp_data.gpu_cache_vcols = list_nth(privs, pindex++);
+	pp_data.gpu_cache_index_attnum = intVal(list_nth(privs, pindex++));
+	pp_data.gpu_cache_index_key = list_nth(exprs, eindex++);
 	pp_data.gpu_direct_devs = bms_from_pglist(list_nth(privs, pindex++));
 	endpoint_id = intVal(list_nth(privs, pindex++));
 	pp_data.ds_entry = DpuStorageEntryByEndpointId(endpoint_id);
@@ -239,13 +275,20 @@ deform_pgstrom_plan_info(CustomScan *cscan)
 	pp_data.brin_index_oid = intVal(list_nth(privs, pindex++));
 	pp_data.brin_index_conds = list_nth(privs, pindex++);
 	pp_data.brin_index_quals = list_nth(privs, pindex++);
+	/* tablesample support */
+	pp_data.tablesample_method = intVal(list_nth(privs, pindex++));
+	pp_data.tablesample_repeatable = boolVal(list_nth(privs, pindex++));
+	pp_data.tablesample_percent = floatVal(list_nth(privs, pindex++));
+	pp_data.tablesample_seed = floatVal(list_nth(privs, pindex++));
 	/* XPU code */
 	pp_data.kexp_load_vars_packed  = __getByteaConst(list_nth(privs, pindex++));
 	pp_data.kexp_move_vars_packed  = __getByteaConst(list_nth(privs, pindex++));
 	pp_data.kexp_scan_quals        = __getByteaConst(list_nth(privs, pindex++));
 	pp_data.kexp_join_quals_packed = __getByteaConst(list_nth(privs, pindex++));
 	pp_data.kexp_hash_keys_packed  = __getByteaConst(list_nth(privs, pindex++));
+	pp_data.kexp_hash_inner_packed = __getByteaConst(list_nth(privs, pindex++));
 	pp_data.kexp_gist_evals_packed = __getByteaConst(list_nth(privs, pindex++));
+	pp_data.kexp_range_keys_packed = __getByteaConst(list_nth(privs, pindex++));
 	pp_data.kexp_projection        = __getByteaConst(list_nth(privs, pindex++));
 	pp_data.kexp_groupby_keyhash   = __getByteaConst(list_nth(privs, pindex++));
 	pp_data.kexp_groupby_keyload   = __getByteaConst(list_nth(privs, pindex++));
@@ -270,6 +313,20 @@ deform_pgstrom_plan_info(CustomScan *cscan)
 	pp_data.cuda_stack_size = intVal(list_nth(privs, pindex++));
 	pp_data.groupby_actions = list_nth(privs, pindex++);
 	pp_data.groupby_prepfn_bufsz  = intVal(list_nth(privs, pindex++));
+	pp_data.groupby_final_on_device = boolVal(list_nth(privs, pindex++));
+	pp_data.groupby_sibling_id = intVal(list_nth(privs, pindex++));
+	pp_data.groupby_nsiblings = intVal(list_nth(privs, pindex++));
+	pp_data.groupby_streaming = boolVal(list_nth(privs, pindex++));
+	/* gpu top-k */
+	pp_data.gpusort_limit = intVal(list_nth(privs, pindex++));
+	pp_data.gpusort_resno = intVal(list_nth(privs, pindex++));
+	pp_data.gpusort_kind  = intVal(list_nth(privs, pindex++));
+	pp_data.gpusort_desc  = boolVal(list_nth(privs, pindex++));
+	pp_data.gpusort_nulls_first = boolVal(list_nth(privs, pindex++));
+	/* LIMIT pushdown */
+	pp_data.scan_limit = intVal(list_nth(privs, pindex++));
+	/* gpu window functions */
+	pp_data.gpuwin_desc = __getByteaConst(list_nth(privs, pindex++));
 	/* inner relations */
 	pp_data.sibling_param_id = intVal(list_nth(privs, pindex++));
 	pp_data.num_rels = intVal(list_nth(privs, pindex++));
@@ -298,6 +355,15 @@ deform_pgstrom_plan_info(CustomScan *cscan)
 		pp_inner->gist_selectivity = floatVal(list_nth(__privs, __pindex++));
 		pp_inner->gist_npages     = floatVal(list_nth(__privs, __pindex++));
 		pp_inner->gist_height     = intVal(list_nth(__privs, __pindex++));
+		pp_inner->gist_key_type   = intVal(list_nth(__privs, __pindex++));
+		pp_inner->gist_prep_resno = intVal(list_nth(__privs, __pindex++));
+		pp_inner->bloom_filter    = boolVal(list_nth(__privs, __pindex++));
+		pp_inner->hash_build_on_device = boolVal(list_nth(__privs, __pindex++));
+		pp_inner->dfilter_keynum  = intVal(list_nth(__privs, __pindex++));
+		pp_inner->dfilter_param_id = intVal(list_nth(__privs, __pindex++));
+		pp_inner->range_inner_key = list_nth(__exprs, __eindex++);
+		pp_inner->range_outer_lower = list_nth(__exprs, __eindex++);
+		pp_inner->range_outer_upper = list_nth(__exprs, __eindex++);
 	}
 	return pp_info;
 }
@@ -318,6 +384,8 @@ copy_pgstrom_plan_info(const pgstromPlanInfo *pp_orig)
 	pp_dest = palloc0(offsetof(pgstromPlanInfo, inners[pp_orig->num_rels+1]));
 	memcpy(pp_dest, pp_orig, offsetof(pgstromPlanInfo,
 									  inners[pp_orig->num_rels]));
+	pp_dest->gpu_cache_vcols  = copyObject(pp_dest->gpu_cache_vcols);
+	pp_dest->gpu_cache_index_key = copyObject(pp_dest->gpu_cache_index_key);
 	pp_dest->used_params      = list_copy(pp_dest->used_params);
 	pp_dest->host_quals       = copyObject(pp_dest->host_quals);
 	pp_dest->scan_quals       = copyObject(pp_dest->scan_quals);
@@ -343,6 +411,9 @@ copy_pgstrom_plan_info(const pgstromPlanInfo *pp_orig)
 		pp_inner->join_quals      = copyObject(pp_inner->join_quals);
 		pp_inner->other_quals     = copyObject(pp_inner->other_quals);
 		pp_inner->gist_clause     = copyObject(pp_inner->gist_clause);
+		pp_inner->range_inner_key = copyObject(pp_inner->range_inner_key);
+		pp_inner->range_outer_lower = copyObject(pp_inner->range_outer_lower);
+		pp_inner->range_outer_upper = copyObject(pp_inner->range_outer_upper);
 	}
 	return pp_dest;
 }
@@ -0,0 +1,1049 @@
+/*
+ * parquet_nodes.c
+ *
+ * Routines to read the footer of Apache Parquet files, and to map the row
+ * groups onto ArrowRecordBatch nodes; so arrow_fdw can scan them using the
+ * same executor framework.
+ * ----
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include "arrow_ipc.h"
+
+/*
+ * Right now, only the column chunks which are byte-compatible to the values
+ * buffer of Apache Arrow are supported; that is uncompressed, PLAIN encoded
+ * fixed-length values of REQUIRED columns in a single data page.
+ * These chunks are loaded onto KDS_FORMAT_ARROW buffers as is.
+ */
+#define PARQUET_FILE_SIGNATURE			"PAR1"
+#define PARQUET_FILE_SIGNATURE_SZ		(sizeof(PARQUET_FILE_SIGNATURE) - 1)
+
+/* parquet::Type */
+#define PARQUET_TYPE__BOOLEAN			0
+#define PARQUET_TYPE__INT32				1
+#define PARQUET_TYPE__INT64				2
+#define PARQUET_TYPE__INT96				3
+#define PARQUET_TYPE__FLOAT				4
+#define PARQUET_TYPE__DOUBLE			5
+#define PARQUET_TYPE__BYTE_ARRAY		6
+#define PARQUET_TYPE__FIXED_LEN_BYTE_ARRAY	7
+/* parquet::ConvertedType */
+#define PARQUET_CONVERTED__DATE			6
+#define PARQUET_CONVERTED__TIMESTAMP_MILLIS	9
+#define PARQUET_CONVERTED__TIMESTAMP_MICROS	10
+#define PARQUET_CONVERTED__UINT_8		11
+#define PARQUET_CONVERTED__UINT_16		12
+#define PARQUET_CONVERTED__UINT_32		13
+#define PARQUET_CONVERTED__UINT_64		14
+/* parquet::FieldRepetitionType */
+#define PARQUET_REPETITION__REQUIRED	0
+/* parquet::CompressionCodec */
+#define PARQUET_CODEC__UNCOMPRESSED		0
+/* parquet::PageType */
+#define PARQUET_PAGE__DATA_PAGE			0
+#define PARQUET_PAGE__DATA_PAGE_V2		3
+/* parquet::Encoding */
+#define PARQUET_ENCODING__PLAIN			0
+
+/* thrift compact protocol */
+#define THRIFT_CTYPE__STOP				0
+#define THRIFT_CTYPE__BOOLEAN_TRUE		1
+#define THRIFT_CTYPE__BOOLEAN_FALSE		2
+#define THRIFT_CTYPE__BYTE				3
+#define THRIFT_CTYPE__I16				4
+#define THRIFT_CTYPE__I32				5
+#define THRIFT_CTYPE__I64				6
+#define THRIFT_CTYPE__DOUBLE			7
+#define THRIFT_CTYPE__BINARY			8
+#define THRIFT_CTYPE__LIST				9
+#define THRIFT_CTYPE__SET				10
+#define THRIFT_CTYPE__MAP				11
+#define THRIFT_CTYPE__STRUCT			12
+
+typedef struct
+{
+	const unsigned char *pos;
+	const unsigned char *end;
+} thriftReader;
+
+typedef void (*thriftFieldCallback)(thriftReader *r, int fid, int ftype, void *arg);
+
+typedef struct
+{
+	int32_t		type;
+	int32_t		type_length;
+	int32_t		repetition_type;
+	int32_t		num_children;
+	int32_t		converted_type;
+	int32_t		timestamp_unit;		/* ArrowTimeUnit, or -1 */
+	bool		timestamp_utc;
+	bool		is_date;
+	char	   *name;
+} parquetSchemaElement;
+
+typedef struct
+{
+	int32_t		type;
+	int32_t		codec;
+	int64_t		num_values;
+	int64_t		total_compressed_size;
+	int64_t		data_page_offset;
+	int64_t		dictionary_page_offset;
+	bool		has_dictionary_page;
+	bool		has_statistics;
+	int64_t		stat_min;
+	int64_t		stat_max;
+} parquetColumnChunk;
+
+typedef struct
+{
+	int64_t		num_rows;
+	int			ncols;
+	int			nrooms;
+	parquetColumnChunk *columns;
+} parquetRowGroup;
+
+typedef struct
+{
+	int			nschemas;
+	parquetSchemaElement *schemas;
+	int			nrowgroups;
+	parquetRowGroup *rowgroups;
+} parquetFileMetaData;
+
+typedef struct
+{
+	int32_t		type;
+	int32_t		compressed_page_size;
+	int32_t		uncompressed_page_size;
+	int32_t		num_values;
+	int32_t		encoding;
+	int32_t		num_nulls;
+	int32_t		levels_byte_length;
+	bool		is_compressed;
+} parquetPageHeader;
+
+/*
+ * Thrift compact protocol decoder
+ */
+static uint64_t
+__thriftReadVarint(thriftReader *r)
+{
+	uint64_t	value = 0;
+	int			shift = 0;
+
+	for (;;)
+	{
+		unsigned char c;
+
+		if (r->pos >= r->end || shift >= 64)
+			Elog("parquet: thrift varint is out of range");
+		c = *r->pos++;
+		value |= ((uint64_t)(c & 0x7f)) << shift;
+		if ((c & 0x80) == 0)
+			break;
+		shift += 7;
+	}
+	return value;
+}
+
+static int64_t
+__thriftReadZigzag(thriftReader *r)
+{
+	uint64_t	value = __thriftReadVarint(r);
+
+	return (int64_t)((value >> 1) ^ (~(value & 1) + 1));
+}
+
+static const unsigned char *
+__thriftReadBinary(thriftReader *r, uint32_t *p_len)
+{
+	const unsigned char *data;
+	uint64_t	len = __thriftReadVarint(r);
+
+	if (len > (uint64_t)(r->end - r->pos))
+		Elog("parquet: thrift binary is out of range");
+	data = r->pos;
+	r->pos += len;
+	*p_len = len;
+	return data;
+}
+
+static char *
+__thriftReadString(thriftReader *r)
+{
+	const unsigned char *data;
+	uint32_t	len;
+	char	   *result;
+
+	data = __thriftReadBinary(r, &len);
+	result = palloc(len + 1);
+	memcpy(result, data, len);
+	result[len] = '\0';
+	return result;
+}
+
+static uint32_t
+__thriftReadListHeader(thriftReader *r, int *p_elem_type)
+{
+	unsigned char c;
+	uint32_t	nitems;
+
+	if (r->pos >= r->end)
+		Elog("parquet: thrift list header is out of range");
+	c = *r->pos++;
+	*p_elem_type = (c & 0x0f);
+	nitems = (c >> 4);
+	if (nitems == 15)
+		nitems = __thriftReadVarint(r);
+	return nitems;
+}
+
+static void		__thriftReadStruct(thriftReader *r,
+								   thriftFieldCallback callback, void *arg);
+
+static void
+__thriftSkipValue(thriftReader *r, int ftype)
+{
+	uint32_t	nitems;
+	uint32_t	len;
+	int			elem_type;
+
+	switch (ftype)
+	{
+		case THRIFT_CTYPE__BOOLEAN_TRUE:
+		case THRIFT_CTYPE__BOOLEAN_FALSE:
+			break;		/* value is embedded in the field header */
+		case THRIFT_CTYPE__BYTE:
+			if (r->pos >= r->end)
+				Elog("parquet: thrift byte is out of range");
+			r->pos++;
+			break;
+		case THRIFT_CTYPE__I16:
+		case THRIFT_CTYPE__I32:
+		case THRIFT_CTYPE__I64:
+			__thriftReadVarint(r);
+			break;
+		case THRIFT_CTYPE__DOUBLE:
+			if (r->end - r->pos < sizeof(double))
+				Elog("parquet: thrift double is out of range");
+			r->pos += sizeof(double);
+			break;
+		case THRIFT_CTYPE__BINARY:
+			__thriftReadBinary(r, &len);
+			break;
+		case THRIFT_CTYPE__LIST:
+		case THRIFT_CTYPE__SET:
+			nitems = __thriftReadListHeader(r, &elem_type);
+			for (uint32_t i=0; i < nitems; i++)
+			{
+				/* boolean elements in the list take one byte */
+				if (elem_type == THRIFT_CTYPE__BOOLEAN_TRUE ||
+					elem_type == THRIFT_CTYPE__BOOLEAN_FALSE)
+					__thriftSkipValue(r, THRIFT_CTYPE__BYTE);
+				else
+					__thriftSkipValue(r, elem_type);
+			}
+			break;
+		case THRIFT_CTYPE__MAP:
+			nitems = __thriftReadVarint(r);
+			if (nitems > 0)
+			{
+				unsigned char c;
+
+				if (r->pos >= r->end)
+					Elog("parquet: thrift map header is out of range");
+				c = *r->pos++;
+				for (uint32_t i=0; i < nitems; i++)
+				{
+					__thriftSkipValue(r, (c >> 4));
+					__thriftSkipValue(r, (c & 0x0f));
+				}
+			}
+			break;
+		case THRIFT_CTYPE__STRUCT:
+			__thriftReadStruct(r, NULL, NULL);
+			break;
+		default:
+			Elog("parquet: unknown thrift compact type (%d)", ftype);
+	}
+}
+
+/*
+ * __thriftReadStruct
+ *
+ * It walks on the fields of the struct, then calls the callback for each.
+ * Callback must consume the value, but it may call __thriftSkipValue()
+ * for the fields not interested in.
+ */
+static void
+__thriftReadStruct(thriftReader *r, thriftFieldCallback callback, void *arg)
+{
+	int			last_fid = 0;
+
+	for (;;)
+	{
+		unsigned char c;
+		int			ftype;
+		int			fid;
+
+		if (r->pos >= r->end)
+			Elog("parquet: thrift struct is out of range");
+		c = *r->pos++;
+		ftype = (c & 0x0f);
+		if (ftype == THRIFT_CTYPE__STOP)
+			break;
+		if ((c >> 4) != 0)
+			fid = last_fid + (c >> 4);
+		else
+			fid = (int16_t)__thriftReadZigzag(r);
+		last_fid = fid;
+
+		if (callback)
+			callback(r, fid, ftype, arg);
+		else
+			__thriftSkipValue(r, ftype);
+	}
+}
+
+static int64_t
+__thriftReadInteger(thriftReader *r, int ftype)
+{
+	if (ftype == THRIFT_CTYPE__I16 ||
+		ftype == THRIFT_CTYPE__I32 ||
+		ftype == THRIFT_CTYPE__I64)
+		return __thriftReadZigzag(r);
+	if (ftype == THRIFT_CTYPE__BYTE)
+	{
+		if (r->pos >= r->end)
+			Elog("parquet: thrift byte is out of range");
+		return (int8_t)(*r->pos++);
+	}
+	Elog("parquet: unexpected thrift type (%d) for integer", ftype);
+	return 0;
+}
+
+/*
+ * parquet::TimeUnit / TimestampType / LogicalType
+ */
+static void
+__parquetReadTimeUnitField(thriftReader *r, int fid, int ftype, void *arg)
+{
+	parquetSchemaElement *elem = arg;
+
+	if (ftype == THRIFT_CTYPE__STRUCT && fid == 1)
+		elem->timestamp_unit = ArrowTimeUnit__MilliSecond;
+	else if (ftype == THRIFT_CTYPE__STRUCT && fid == 2)
+		elem->timestamp_unit = ArrowTimeUnit__MicroSecond;
+	else if (ftype == THRIFT_CTYPE__STRUCT && fid == 3)
+		elem->timestamp_unit = ArrowTimeUnit__NanoSecond;
+	__thriftSkipValue(r, ftype);
+}
+
+static void
+__parquetReadTimestampTypeField(thriftReader *r, int fid, int ftype, void *arg)
+{
+	parquetSchemaElement *elem = arg;
+
+	if (fid == 1 && (ftype == THRIFT_CTYPE__BOOLEAN_TRUE ||
+					 ftype == THRIFT_CTYPE__BOOLEAN_FALSE))
+		elem->timestamp_utc = (ftype == THRIFT_CTYPE__BOOLEAN_TRUE);
+	else if (fid == 2 && ftype == THRIFT_CTYPE__STRUCT)
+		__thriftReadStruct(r, __parquetReadTimeUnitField, elem);
+	else
+		__thriftSkipValue(r, ftype);
+}
+
+static void
+__parquetReadLogicalTypeField(thriftReader *r, int fid, int ftype, void *arg)
+{
+	parquetSchemaElement *elem = arg;
+
+	if (fid == 6 && ftype == THRIFT_CTYPE__STRUCT)
+	{
+		elem->is_date = true;
+		__thriftSkipValue(r, ftype);
+	}
+	else if (fid == 8 && ftype == THRIFT_CTYPE__STRUCT)
+		__thriftReadStruct(r, __parquetReadTimestampTypeField, elem);
+	else
+		__thriftSkipValue(r, ftype);
+}
+
+/*
+ * parquet::SchemaElement
+ */
+static void
+__parquetReadSchemaElementField(thriftReader *r, int fid, int ftype, void *arg)
+{
+	parquetSchemaElement *elem = arg;
+
+	switch (fid)
+	{
+		case 1:		/* type */
+			elem->type = __thriftReadInteger(r, ftype);
+			break;
+		case 2:		/* type_length */
+			elem->type_length = __thriftReadInteger(r, ftype);
+			break;
+		case 3:		/* repetition_type */
+			elem->repetition_type = __thriftReadInteger(r, ftype);
+			break;
+		case 4:		/* name */
+			elem->name = __thriftReadString(r);
+			break;
+		case 5:		/* num_children */
+			elem->num_children = __thriftReadInteger(r, ftype);
+			break;
+		case 6:		/* converted_type */
+			elem->converted_type = __thriftReadInteger(r, ftype);
+			break;
+		case 10:	/* logicalType */
+			__thriftReadStruct(r, __parquetReadLogicalTypeField, elem);
+			break;
+		default:
+			__thriftSkipValue(r, ftype);
+			break;
+	}
+}
+
+/*
+ * parquet::Statistics
+ */
+typedef struct
+{
+	parquetColumnChunk *chunk;
+	const unsigned char *min_value;
+	const unsigned char *max_value;
+	uint32_t	min_len;
+	uint32_t	max_len;
+	bool		has_min_value;	/* min_value (5) overrides legacy min (2) */
+	bool		has_max_value;	/* max_value (6) overrides legacy max (1) */
+} parquetStatisticsContext;
+
+static void
+__parquetReadStatisticsField(thriftReader *r, int fid, int ftype, void *arg)
+{
+	parquetStatisticsContext *con = arg;
+
+	if (ftype != THRIFT_CTYPE__BINARY)
+		__thriftSkipValue(r, ftype);
+	else if (fid == 6 || (fid == 2 && !con->has_min_value))
+	{
+		con->min_value = __thriftReadBinary(r, &con->min_len);
+		con->has_min_value |= (fid == 6);
+	}
+	else if (fid == 5 || (fid == 1 && !con->has_max_value))
+	{
+		con->max_value = __thriftReadBinary(r, &con->max_len);
+		con->has_max_value |= (fid == 5);
+	}
+	else
+		__thriftSkipValue(r, ftype);
+}
+
+static void
+__parquetReadStatistics(thriftReader *r, parquetColumnChunk *chunk)
+{
+	parquetStatisticsContext con;
+	uint32_t	width;
+
+	memset(&con, 0, sizeof(parquetStatisticsContext));
+	con.chunk = chunk;
+	__thriftReadStruct(r, __parquetReadStatisticsField, &con);
+
+	/* only integer types are used for min/max statistics */
+	if (chunk->type == PARQUET_TYPE__INT32)
+		width = sizeof(int32_t);
+	else if (chunk->type == PARQUET_TYPE__INT64)
+		width = sizeof(int64_t);
+	else
+		return;
+	if (con.min_value && con.min_len == width &&
+		con.max_value && con.max_len == width)
+	{
+		if (width == sizeof(int32_t))
+		{
+			int32_t		ival;
+
+			memcpy(&ival, con.min_value, sizeof(int32_t));
+			chunk->stat_min = ival;
+			memcpy(&ival, con.max_value, sizeof(int32_t));
+			chunk->stat_max = ival;
+		}
+		else
+		{
+			memcpy(&chunk->stat_min, con.min_value, sizeof(int64_t));
+			memcpy(&chunk->stat_max, con.max_value, sizeof(int64_t));
+		}
+		chunk->has_statistics = true;
+	}
+}
+
+/*
+ * parquet::ColumnMetaData / ColumnChunk
+ */
+static void
+__parquetReadColumnMetaDataField(thriftReader *r, int fid, int ftype, void *arg)
+{
+	parquetColumnChunk *chunk = arg;
+
+	switch (fid)
+	{
+		case 1:		/* type */
+			chunk->type = __thriftReadInteger(r, ftype);
+			break;
+		case 4:		/* codec */
+			chunk->codec = __thriftReadInteger(r, ftype);
+			break;
+		case 5:		/* num_values */
+			chunk->num_values = __thriftReadInteger(r, ftype);
+			break;
+		case 7:		/* total_compressed_size */
+			chunk->total_compressed_size = __thriftReadInteger(r, ftype);
+			break;
+		case 9:		/* data_page_offset */
+			chunk->data_page_offset = __thriftReadInteger(r, ftype);
+			break;
+		case 11:	/* dictionary_page_offset */
+			chunk->dictionary_page_offset = __thriftReadInteger(r, ftype);
+			chunk->has_dictionary_page = true;
+			break;
+		case 12:	/* statistics */
+			__parquetReadStatistics(r, chunk);
+			break;
+		default:
+			__thriftSkipValue(r, ftype);
+			break;
+	}
+}
+
+static void
+__parquetReadColumnChunkField(thriftReader *r, int fid, int ftype, void *arg)
+{
+	parquetColumnChunk *chunk = arg;
+
+	if (fid == 1 && ftype == THRIFT_CTYPE__BINARY)
+		Elog("parquet: column chunk in the external file is not supported");
+	else if (fid == 3 && ftype == THRIFT_CTYPE__STRUCT)
+		__thriftReadStruct(r, __parquetReadColumnMetaDataField, chunk);
+	else
+		__thriftSkipValue(r, ftype);
+}
+
+/*
+ * parquet::RowGroup
+ */
+static void
+__parquetReadRowGroupField(thriftReader *r, int fid, int ftype, void *arg)
+{
+	parquetRowGroup *rgroup = arg;
+	uint32_t	nitems;
+	int			elem_type;
+
+	if (fid == 1 && ftype == THRIFT_CTYPE__LIST)
+	{
+		nitems = __thriftReadListHeader(r, &elem_type);
+		if (elem_type != THRIFT_CTYPE__STRUCT)
+			Elog("parquet: RowGroup.columns is corrupted");
+		rgroup->columns = palloc0(sizeof(parquetColumnChunk) * Max(nitems, 1));
+		rgroup->ncols = nitems;
+		for (uint32_t i=0; i < nitems; i++)
+			__thriftReadStruct(r, __parquetReadColumnChunkField,
+							   &rgroup->columns[i]);
+	}
+	else if (fid == 3)
+		rgroup->num_rows = __thriftReadInteger(r, ftype);
+	else
+		__thriftSkipValue(r, ftype);
+}
+
+/*
+ * parquet::FileMetaData
+ */
+static void
+__parquetReadFileMetaDataField(thriftReader *r, int fid, int ftype, void *arg)
+{
+	parquetFileMetaData *fmeta = arg;
+	uint32_t	nitems;
+	int			elem_type;
+
+	if (fid == 2 && ftype == THRIFT_CTYPE__LIST)
+	{
+		nitems = __thriftReadListHeader(r, &elem_type);
+		if (elem_type != THRIFT_CTYPE__STRUCT)
+			Elog("parquet: FileMetaData.schema is corrupted");
+		fmeta->schemas = palloc0(sizeof(parquetSchemaElement) * Max(nitems, 1));
+		fmeta->nschemas = nitems;
+		for (uint32_t i=0; i < nitems; i++)
+		{
+			parquetSchemaElement *elem = &fmeta->schemas[i];
+
+			elem->type = -1;
+			elem->repetition_type = PARQUET_REPETITION__REQUIRED;
+			elem->converted_type = -1;
+			elem->timestamp_unit = -1;
+			__thriftReadStruct(r, __parquetReadSchemaElementField, elem);
+		}
+	}
+	else if (fid == 4 && ftype == THRIFT_CTYPE__LIST)
+	{
+		nitems = __thriftReadListHeader(r, &elem_type);
+		if (elem_type != THRIFT_CTYPE__STRUCT)
+			Elog("parquet: FileMetaData.row_groups is corrupted");
+		fmeta->rowgroups = palloc0(sizeof(parquetRowGroup) * Max(nitems, 1));
+		fmeta->nrowgroups = nitems;
+		for (uint32_t i=0; i < nitems; i++)
+			__thriftReadStruct(r, __parquetReadRowGroupField,
+							   &fmeta->rowgroups[i]);
+	}
+	else
+		__thriftSkipValue(r, ftype);
+}
+
+/*
+ * parquet::PageHeader
+ */
+static void
+__parquetReadDataPageHeaderField(thriftReader *r, int fid, int ftype, void *arg)
+{
+	parquetPageHeader *phead = arg;
+
+	if (fid == 1)
+		phead->num_values = __thriftReadInteger(r, ftype);
+	else if (fid == 2)
+		phead->encoding = __thriftReadInteger(r, ftype);
+	else
+		__thriftSkipValue(r, ftype);
+}
+
+static void
+__parquetReadDataPageHeaderV2Field(thriftReader *r, int fid, int ftype, void *arg)
+{
+	parquetPageHeader *phead = arg;
+
+	switch (fid)
+	{
+		case 1:		/* num_values */
+			phead->num_values = __thriftReadInteger(r, ftype);
+			break;
+		case 2:		/* num_nulls */
+			phead->num_nulls = __thriftReadInteger(r, ftype);
+			break;
+		case 4:		/* encoding */
+			phead->encoding = __thriftReadInteger(r, ftype);
+			break;
+		case 5:		/* definition_levels_byte_length */
+		case 6:		/* repetition_levels_byte_length */
+			phead->levels_byte_length += __thriftReadInteger(r, ftype);
+			break;
+		case 7:		/* is_compressed */
+			phead->is_compressed = (ftype == THRIFT_CTYPE__BOOLEAN_TRUE);
+			break;
+		default:
+			__thriftSkipValue(r, ftype);
+			break;
+	}
+}
+
+static void
+__parquetReadPageHeaderField(thriftReader *r, int fid, int ftype, void *arg)
+{
+	parquetPageHeader *phead = arg;
+
+	switch (fid)
+	{
+		case 1:		/* type */
+			phead->type = __thriftReadInteger(r, ftype);
+			break;
+		case 2:		/* uncompressed_page_size */
+			phead->uncompressed_page_size = __thriftReadInteger(r, ftype);
+			break;
+		case 3:		/* compressed_page_size */
+			phead->compressed_page_size = __thriftReadInteger(r, ftype);
+			break;
+		case 5:		/* data_page_header */
+			__thriftReadStruct(r, __parquetReadDataPageHeaderField, phead);
+			break;
+		case 8:		/* data_page_header_v2 */
+			phead->is_compressed = true;	/* default of V2 */
+			__thriftReadStruct(r, __parquetReadDataPageHeaderV2Field, phead);
+			break;
+		default:
+			__thriftSkipValue(r, ftype);
+			break;
+	}
+}
+
+/*
+ * __parquetSetupArrowField
+ */
+static int
+__parquetSetupArrowField(ArrowField *field, parquetSchemaElement *elem)
+{
+	int		unitsz;
+
+	initArrowNode(field, Field);
+	field->name = pstrdup(elem->name ? elem->name : "");
+	field->_name_len = strlen(field->name);
+	field->nullable = false;
+
+	if (elem->num_children > 0)
+		Elog("parquet: nested column '%s' is not supported", field->name);
+	if (elem->repetition_type != PARQUET_REPETITION__REQUIRED)
+		Elog("parquet: nullable or repeated column '%s' is not supported",
+			 field->name);
+	switch (elem->type)
+	{
+		case PARQUET_TYPE__BOOLEAN:
+			initArrowNode(&field->type, Bool);
+			unitsz = 0;
+			break;
+		case PARQUET_TYPE__INT32:
+			if (elem->is_date || elem->converted_type == PARQUET_CONVERTED__DATE)
+			{
+				initArrowNode(&field->type, Date);
+				field->type.Date.unit = ArrowDateUnit__Day;
+			}
+			else
+			{
+				initArrowNode(&field->type, Int);
+				field->type.Int.bitWidth = 32;
+				field->type.Int.is_signed =
+					(elem->converted_type != PARQUET_CONVERTED__UINT_8 &&
+					 elem->converted_type != PARQUET_CONVERTED__UINT_16 &&
+					 elem->converted_type != PARQUET_CONVERTED__UINT_32);
+			}
+			unitsz = sizeof(int32_t);
+			break;
+		case PARQUET_TYPE__INT64:
+			if (elem->timestamp_unit < 0)
+			{
+				if (elem->converted_type == PARQUET_CONVERTED__TIMESTAMP_MILLIS)
+					elem->timestamp_unit = ArrowTimeUnit__MilliSecond;
+				else if (elem->converted_type == PARQUET_CONVERTED__TIMESTAMP_MICROS)
+					elem->timestamp_unit = ArrowTimeUnit__MicroSecond;
+				/* legacy converted types are always adjusted to UTC */
+				elem->timestamp_utc = true;
+			}
+			if (elem->timestamp_unit >= 0)
+			{
+				initArrowNode(&field->type, Timestamp);
+				field->type.Timestamp.unit = elem->timestamp_unit;
+				if (elem->timestamp_utc)
+				{
+					field->type.Timestamp.timezone = pstrdup("UTC");
+					field->type.Timestamp._timezone_len = 3;
+				}
+			}
+			else
+			{
+				initArrowNode(&field->type, Int);
+				field->type.Int.bitWidth = 64;
+				field->type.Int.is_signed =
+					(elem->converted_type != PARQUET_CONVERTED__UINT_64);
+			}
+			unitsz = sizeof(int64_t);
+			break;
+		case PARQUET_TYPE__FLOAT:
+			initArrowNode(&field->type, FloatingPoint);
+			field->type.FloatingPoint.precision = ArrowPrecision__Single;
+			unitsz = sizeof(float);
+			break;
+		case PARQUET_TYPE__DOUBLE:
+			initArrowNode(&field->type, FloatingPoint);
+			field->type.FloatingPoint.precision = ArrowPrecision__Double;
+			unitsz = sizeof(double);
+			break;
+		default:
+			Elog("parquet: physical type (%d) of column '%s' is not supported",
+				 elem->type, field->name);
+	}
+	return unitsz;
+}
+
+/*
+ * __parquetSetupValuesBuffer
+ *
+ * It looks at the page header of the column chunk, then points the values
+ * of the data page as if it is an Arrow buffer.
+ */
+static void
+__parquetSetupValuesBuffer(ArrowBuffer *buffer,
+						   const char *mmap_head, size_t file_sz,
+						   const char *colname,
+						   parquetColumnChunk *chunk,
+						   int64_t num_rows, int unitsz)
+{
+	parquetPageHeader phead;
+	thriftReader r;
+	size_t		head_sz;
+	size_t		values_sz;
+
+	if (chunk->codec != PARQUET_CODEC__UNCOMPRESSED)
+		Elog("parquet: compressed column '%s' (codec=%d) is not supported",
+			 colname, chunk->codec);
+	if (chunk->has_dictionary_page &&
+		chunk->dictionary_page_offset > 0)
+		Elog("parquet: dictionary encoded column '%s' is not supported", colname);
+	if (chunk->num_values != num_rows)
+		Elog("parquet: number of values in column '%s' mismatch", colname);
+	if (chunk->data_page_offset <= 0 ||
+		chunk->data_page_offset >= file_sz ||
+		chunk->total_compressed_size > file_sz - chunk->data_page_offset)
+		Elog("parquet: column chunk of '%s' is out of range", colname);
+
+	memset(&phead, 0, sizeof(parquetPageHeader));
+	r.pos = (const unsigned char *)mmap_head + chunk->data_page_offset;
+	r.end = r.pos + chunk->total_compressed_size;
+	__thriftReadStruct(&r, __parquetReadPageHeaderField, &phead);
+	head_sz = (const char *)r.pos - (mmap_head + chunk->data_page_offset);
+
+	if (phead.type != PARQUET_PAGE__DATA_PAGE &&
+		phead.type != PARQUET_PAGE__DATA_PAGE_V2)
+		Elog("parquet: unexpected page type (%d) at column '%s'",
+			 phead.type, colname);
+	if (phead.type == PARQUET_PAGE__DATA_PAGE_V2 &&
+		(phead.is_compressed || phead.num_nulls != 0 ||
+		 phead.levels_byte_length != 0))
+		Elog("parquet: data page of column '%s' is not supported", colname);
+	if (phead.encoding != PARQUET_ENCODING__PLAIN)
+		Elog("parquet: encoding (%d) of column '%s' is not supported",
+			 phead.encoding, colname);
+	if (phead.num_values != num_rows ||
+		head_sz + phead.compressed_page_size != chunk->total_compressed_size)
+		Elog("parquet: column '%s' must consist of a single data page", colname);
+	if (unitsz > 0)
+		values_sz = (size_t)unitsz * num_rows;
+	else
+		values_sz = (num_rows + 7) / 8;		/* bit-packed boolean */
+	if (phead.uncompressed_page_size < values_sz)
+		Elog("parquet: data page of column '%s' is too small", colname);
+
+	initArrowNode(buffer, Buffer);
+	buffer->offset = chunk->data_page_offset + head_sz;
+	buffer->length = values_sz;
+}
+
+/*
+ * __parquetSetupFieldStats
+ *
+ * It puts the row-group statistics on the custom-metadata of the field,
+ * as pg2arrow --stat doing; then arrow_fdw can use them for min/max hint.
+ */
+static void
+__parquetSetupFieldStats(ArrowField *field, parquetFileMetaData *fmeta, int col)
+{
+	StringInfoData min_buf;
+	StringInfoData max_buf;
+	bool		found = false;
+
+	if (!ArrowNodeIs(&field->type, Int) &&
+		!ArrowNodeIs(&field->type, Date) &&
+		!ArrowNodeIs(&field->type, Timestamp))
+		return;
+
+	initStringInfo(&min_buf);
+	initStringInfo(&max_buf);
+	for (int i=0; i < fmeta->nrowgroups; i++)
+	{
+		parquetColumnChunk *chunk = &fmeta->rowgroups[i].columns[col];
+
+		if (i > 0)
+		{
+			appendStringInfoChar(&min_buf, ',');
+			appendStringInfoChar(&max_buf, ',');
+		}
+		if (chunk->has_statistics)
+		{
+			appendStringInfo(&min_buf, "%ld", chunk->stat_min);
+			appendStringInfo(&max_buf, "%ld", chunk->stat_max);
+			found = true;
+		}
+		else
+		{
+			appendStringInfoString(&min_buf, "null");
+			appendStringInfoString(&max_buf, "null");
+		}
+	}
+	if (found)
+	{
+		field->custom_metadata = palloc0(sizeof(ArrowKeyValue) * 2);
+		field->_num_custom_metadata = 2;
+
+		initArrowNode(&field->custom_metadata[0], KeyValue);
+		field->custom_metadata[0].key = pstrdup("min_values");
+		field->custom_metadata[0]._key_len = 10;
+		field->custom_metadata[0].value = min_buf.data;
+		field->custom_metadata[0]._value_len = min_buf.len;
+
+		initArrowNode(&field->custom_metadata[1], KeyValue);
+		field->custom_metadata[1].key = pstrdup("max_values");
+		field->custom_metadata[1]._key_len = 10;
+		field->custom_metadata[1].value = max_buf.data;
+		field->custom_metadata[1]._value_len = max_buf.len;
+	}
+	else
+	{
+		pfree(min_buf.data);
+		pfree(max_buf.data);
+	}
+}
+
+/*
+ * __readParquetFileMetaData
+ */
+static void
+__readParquetFileMetaData(const char *mmap_head, size_t file_sz,
+						  ArrowFileInfo *af_info)
+{
+	parquetFileMetaData fmeta;
+	ArrowSchema *schema = &af_info->footer.schema;
+	thriftReader r;
+	uint32_t	meta_len;
+	int			nfields;
+	int		   *unitsz;
+
+	if (file_sz < 2 * PARQUET_FILE_SIGNATURE_SZ + sizeof(uint32_t))
+		Elog("parquet: file is too small");
+	memcpy(&meta_len, mmap_head + file_sz - PARQUET_FILE_SIGNATURE_SZ
+		   - sizeof(uint32_t), sizeof(uint32_t));
+	if (meta_len > file_sz - 2 * PARQUET_FILE_SIGNATURE_SZ - sizeof(uint32_t))
+		Elog("parquet: footer length (%u) is out of range", meta_len);
+
+	memset(&fmeta, 0, sizeof(parquetFileMetaData));
+	r.end = (const unsigned char *)mmap_head + file_sz
+		- PARQUET_FILE_SIGNATURE_SZ - sizeof(uint32_t);
+	r.pos = r.end - meta_len;
+	__thriftReadStruct(&r, __parquetReadFileMetaDataField, &fmeta);
+
+	/* the first schema element is the root */
+	if (fmeta.nschemas < 1 ||
+		fmeta.schemas[0].num_children != fmeta.nschemas - 1)
+		Elog("parquet: nested schema is not supported");
+	nfields = fmeta.nschemas - 1;
+
+	initArrowNode(&af_info->footer, Footer);
+	af_info->footer.version = ArrowMetadataVersion__V5;
+	initArrowNode(schema, Schema);
+	schema->endianness = ArrowEndianness__Little;
+	schema->fields = palloc0(sizeof(ArrowField) * Max(nfields, 1));
+	schema->_num_fields = nfields;
+	unitsz = palloc0(sizeof(int) * Max(nfields, 1));
+	for (int j=0; j < nfields; j++)
+		unitsz[j] = __parquetSetupArrowField(&schema->fields[j],
+											 &fmeta.schemas[j+1]);
+	if (fmeta.nrowgroups == 0)
+		return;
+
+	/*
+	 * Each row-group is mapped to a RecordBatch; the buffer offset is
+	 * relative to the head of the file (block->offset = 0).
+	 */
+	af_info->footer.recordBatches = palloc0(sizeof(ArrowBlock) * fmeta.nrowgroups);
+	af_info->footer._num_recordBatches = fmeta.nrowgroups;
+	af_info->recordBatches = palloc0(sizeof(ArrowMessage) * fmeta.nrowgroups);
+	for (int i=0; i < fmeta.nrowgroups; i++)
+	{
+		parquetRowGroup *rgroup = &fmeta.rowgroups[i];
+		ArrowBlock	   *block = &af_info->footer.recordBatches[i];
+		ArrowMessage   *message = &af_info->recordBatches[i];
+		ArrowRecordBatch *rbatch = &message->body.recordBatch;
+
+		if (rgroup->ncols != nfields)
+			Elog("parquet: RowGroup has %d columns, but %d expected",
+				 rgroup->ncols, nfields);
+		initArrowNode(block, Block);
+		block->offset = 0;
+		block->metaDataLength = 0;
+		block->bodyLength = 0;
+
+		initArrowNode(message, Message);
+		message->version = ArrowMetadataVersion__V5;
+		initArrowNode(rbatch, RecordBatch);
+		rbatch->length = rgroup->num_rows;
+		rbatch->nodes = palloc0(sizeof(ArrowFieldNode) * Max(nfields, 1));
+		rbatch->_num_nodes = nfields;
+		rbatch->buffers = palloc0(sizeof(ArrowBuffer) * Max(2 * nfields, 1));
+		rbatch->_num_buffers = 2 * nfields;
+		for (int j=0; j < nfields; j++)
+		{
+			ArrowFieldNode *fnode = &rbatch->nodes[j];
+
+			initArrowNode(fnode, FieldNode);
+			fnode->length = rgroup->num_rows;
+			fnode->null_count = 0;
+			/* no nullmap, because all the columns are REQUIRED */
+			initArrowNode(&rbatch->buffers[2*j], Buffer);
+			__parquetSetupValuesBuffer(&rbatch->buffers[2*j+1],
+									   mmap_head, file_sz,
+									   schema->fields[j].name,
+									   &rgroup->columns[j],
+									   rgroup->num_rows,
+									   unitsz[j]);
+			block->bodyLength += rgroup->columns[j].total_compressed_size;
+		}
+		message->bodyLength = block->bodyLength;
+	}
+	for (int j=0; j < nfields; j++)
+		__parquetSetupFieldStats(&schema->fields[j], &fmeta, j);
+}
+
+/*
+ * isParquetFileDesc - checks signature of Apache Parquet file
+ */
+bool
+isParquetFileDesc(int fdesc)
+{
+	char		signature[PARQUET_FILE_SIGNATURE_SZ];
+
+	if (pread(fdesc, signature, PARQUET_FILE_SIGNATURE_SZ, 0)
+		!= PARQUET_FILE_SIGNATURE_SZ)
+		return false;
+	return (memcmp(signature, PARQUET_FILE_SIGNATURE,
+				   PARQUET_FILE_SIGNATURE_SZ) == 0);
+}
+
+/*
+ * readParquetFileDesc - read the supplied apache parquet file
+ */
+void
+readParquetFileDesc(int fdesc, ArrowFileInfo *af_info)
+{
+	static long		__PAGE_SIZE = 0;
+	size_t			file_sz;
+	size_t			mmap_sz;
+	char		   *mmap_head;
+
+	memset(af_info, 0, sizeof(ArrowFileInfo));
+	if (fstat(fdesc, &af_info->stat_buf) != 0)
+		Elog("failed on fstat: %m");
+	file_sz = af_info->stat_buf.st_size;
+	if (__PAGE_SIZE == 0)
+		__PAGE_SIZE = sysconf(_SC_PAGESIZE);
+	mmap_sz = ((file_sz + __PAGE_SIZE - 1) & ~(__PAGE_SIZE - 1));
+	mmap_head = mmap(NULL, mmap_sz, PROT_READ, MAP_SHARED, fdesc, 0);
+	if (mmap_head == MAP_FAILED)
+		Elog("failed on mmap: %m");
+	PG_TRY();
+	{
+		if (file_sz < PARQUET_FILE_SIGNATURE_SZ ||
+			memcmp(mmap_head, PARQUET_FILE_SIGNATURE,
+				   PARQUET_FILE_SIGNATURE_SZ) != 0 ||
+			memcmp(mmap_head + file_sz - PARQUET_FILE_SIGNATURE_SZ,
+				   PARQUET_FILE_SIGNATURE,
+				   PARQUET_FILE_SIGNATURE_SZ) != 0)
+			Elog("Signature mismatch on Apache Parquet file");
+		__readParquetFileMetaData(mmap_head, file_sz, af_info);
+	}
+	PG_FINALLY();
+	{
+		munmap(mmap_head, mmap_sz);
+	}
+	PG_END_TRY();
+	af_info->is_parquet = true;
+}
@@ -22,6 +22,7 @@
 #include "access/brin.h"
 #include "access/heapam.h"
 #include "access/genam.h"
+#include "access/parallel.h"
 #include "access/reloptions.h"
 #include "access/relscan.h"
 #include "access/syncscan.h"
@@ -29,16 +30,24 @@
 #include "access/tableam.h"
 #include "access/visibilitymap.h"
 #include "access/xact.h"
+#include "access/xlog.h"
+#include "access/xlog_internal.h"
+#include "access/xloginsert.h"
+#include "access/xlogreader.h"
+#include "access/xlogrecovery.h"
 #include "catalog/binary_upgrade.h"
 #include "catalog/dependency.h"
 #include "catalog/heap.h"
 #include "catalog/indexing.h"
 #include "catalog/namespace.h"
 #include "catalog/objectaccess.h"
+#include "catalog/partition.h"
 #include "catalog/pg_aggregate.h"
 #include "catalog/pg_am.h"
 #include "catalog/pg_amop.h"
+#include "catalog/pg_authid.h"
 #include "catalog/pg_cast.h"
+#include "catalog/pg_collation.h"
 #include "catalog/pg_database.h"
 #include "catalog/pg_depend.h"
 #include "catalog/pg_foreign_table.h"
@@ -52,6 +61,7 @@
 #include "catalog/pg_tablespace_d.h"
 #include "catalog/pg_trigger.h"
 #include "catalog/pg_type.h"
+#include "commands/copy.h"
 #include "commands/dbcommands.h"
 #include "commands/defrem.h"
 #include "commands/event_trigger.h"
@@ -60,16 +70,23 @@
 #include "commands/tablespace.h"
 #include "commands/trigger.h"
 #include "commands/typecmds.h"
+#include "common/cryptohash.h"
+#include "common/file_perm.h"
 #include "common/hashfn.h"
+#include "common/hmac.h"
 #include "common/int.h"
 #include "common/md5.h"
+#include "common/pg_prng.h"
+#include "common/sha2.h"
 #include "executor/nodeSubplan.h"
+#include "executor/spi.h"
 #include "foreign/fdwapi.h"
 #include "foreign/foreign.h"
 #include "funcapi.h"
 #include "libpq/pqformat.h"
 #include "libpq/pqsignal.h"
 #include "lib/stringinfo.h"
+#include "mb/pg_wchar.h"
 #include "miscadmin.h"
 #include "nodes/extensible.h"
 #include "nodes/makefuncs.h"
@@ -86,9 +103,15 @@
 #include "optimizer/planmain.h"
 #include "optimizer/restrictinfo.h"
 #include "optimizer/tlist.h"
+#include "parser/parse_agg.h"
 #include "parser/parse_func.h"
+#include "partitioning/partbounds.h"
+#include "partitioning/partdesc.h"
+#include "pgstat.h"
 #include "postmaster/bgworker.h"
+#include "postmaster/interrupt.h"
 #include "postmaster/postmaster.h"
+#include "rewrite/rewriteManip.h"
 #include "storage/bufmgr.h"
 #include "storage/buf_internals.h"
 #include "storage/ipc.h"
@@ -98,6 +121,8 @@
 #include "storage/procarray.h"
 #include "storage/shmem.h"
 #include "storage/smgr.h"
+#include "tcop/tcopprot.h"
+#include "utils/acl.h"
 #include "utils/builtins.h"
 #include "utils/cash.h"
 #include "utils/catcache.h"
@@ -110,7 +135,9 @@
 #include "utils/inet.h"
 #include "utils/inval.h"
 #include "utils/jsonb.h"
+#include "utils/jsonpath.h"
 #include "utils/lsyscache.h"
+#include "utils/partcache.h"
 #include "utils/pg_locale.h"
 #include "utils/rangetypes.h"
 #include "utils/regproc.h"
@@ -118,6 +145,7 @@
 #include "utils/resowner.h"
 #include "utils/ruleutils.h"
 #include "utils/selfuncs.h"
+#include "utils/snapmgr.h"
 #include "utils/spccache.h"
 #include "utils/syscache.h"
 #include "utils/timestamp.h"
@@ -137,6 +165,7 @@
 #include <pthread.h>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
+#include <sys/file.h>
 #include <sys/mman.h>
 #include <sys/poll.h>
 #include <sys/socket.h>
@@ -234,11 +263,34 @@ typedef struct devfunc_info
 	struct devtype_info *func_argtypes[1];
 } devfunc_info;
 
+/*
+ * pgstromUserDevFunc - device function supplied by extensions
+ *
+ * An extension registers its device functions using
+ * pgstrom_register_device_function() at _PG_init() of the module
+ * loaded by shared_preload_libraries, next to the pg_strom.
+ */
+typedef struct pgstromUserDevFunc
+{
+	const char *func_extension;	/* extension that owns the SQL function */
+	const char *func_name;		/* name of the SQL function */
+	const char *func_args;		/* device type names, like "float8/float8" */
+	uint32_t	func_flags;		/* DEVKIND__* and DEVFUNC__* */
+	int			func_cost;
+	const char *cuda_source;	/* CUDA source (absolute path) to be linked */
+	const char *cuda_symbol;	/* __device__ variable of xpu_function_t */
+	/* set by pgstrom_register_device_function */
+	const char *func_signature;
+	FuncOpCode	func_code;
+} pgstromUserDevFunc;
+
 typedef struct XpuConnection	XpuConnection;
 typedef struct GpuCacheDesc		GpuCacheDesc;
 typedef struct DpuStorageEntry	DpuStorageEntry;
 typedef struct ArrowFdwState	ArrowFdwState;
+typedef struct FileFdwState		FileFdwState;
 typedef struct BrinIndexState	BrinIndexState;
+typedef struct ZoneMapState	ZoneMapState;
 
 /*
  * pgstromPlanInfo
@@ -261,14 +313,36 @@ typedef struct
 	Selectivity		gist_selectivity; /* GiST selectivity */
 	double			gist_npages;	/* number of disk pages */
 	int				gist_height;	/* index tree height, or -1 if unknown */
+	Oid				gist_key_type;	/* type of the index key */
+	int				gist_prep_resno;/* inner geometry to be prepared, or 0 */
+	bool			bloom_filter;	/* bloom filter is pushed down to the scan */
+	bool			hash_build_on_device; /* GPU builds the inner hash table */
+	/*
+	 * dynamic filter properties (min/max of the inner hash-key is pushed
+	 * down to the BRIN-index or arrow_fdw min/max statistics of the outer)
+	 */
+	int				dfilter_keynum;	/* 1-origin index of the hash-key, or 0 */
+	int				dfilter_param_id; /* PARAM_EXEC of min, and max (+1) */
+	/*
+	 * range-join properties (nested-loop on the sorted inner rows)
+	 * If range_inner_key is inet/cidr, it is inet-join; range_outer_lower
+	 * is the outer network to be contained by the inner key.
+	 */
+	Expr		   *range_inner_key; /* inner key to sort the inner rows */
+	Expr		   *range_outer_lower; /* outer expr of inner_key >= lower */
+	Expr		   *range_outer_upper; /* outer expr of inner_key <= upper */
 } pgstromPlanInnerInfo;
 
 typedef struct
 {
 	uint32_t	xpu_task_flags;		/* mask of device flags */
 	int			gpu_cache_dindex;	/* device for GpuCache, if any */
+	List	   *gpu_cache_vcols;	/* virtual columns of GpuCache, if any */
+	int			gpu_cache_index_attnum;	/* index key of GpuCache lookup */
+	Expr	   *gpu_cache_index_key;	/* key value (Const/Param) to lookup */
 	const Bitmapset *gpu_direct_devs;	/* device for GPU-Direct SQL, if any */
-	const DpuStorageEntry *ds_entry;	/* target DPU if DpuJoin */
+	const DpuStorageEntry *ds_entry;	/* target DPU if DpuJoin, or DPU to
+										 * share the hybrid GpuScan */
 	/* Plan information */
 	const Bitmapset *outer_refs;	/* referenced columns */
 	List	   *used_params;		/* param list in use */
@@ -287,13 +361,20 @@ typedef struct
 	Oid			brin_index_oid;		/* OID of BRIN-index, if any */
 	List	   *brin_index_conds;	/* BRIN-index key conditions */
 	List	   *brin_index_quals;	/* Original BRIN-index qualifier */
+	/* TABLESAMPLE support */
+	char		tablesample_method;	/* one of KERN_TABLESAMPLE__*, or '\0' */
+	bool		tablesample_repeatable;	/* REPEATABLE clause is given */
+	double		tablesample_percent;	/* sampling percentage */
+	double		tablesample_seed;	/* argument of REPEATABLE clause */
 	/* XPU code for JOIN */
 	bytea	   *kexp_load_vars_packed;	/* LoadVars[] */
 	bytea	   *kexp_move_vars_packed;	/* MoveVars[] */
 	bytea	   *kexp_scan_quals;
 	bytea	   *kexp_join_quals_packed;
 	bytea	   *kexp_hash_keys_packed;
+	bytea	   *kexp_hash_inner_packed;	/* inner hash-values (GPU hash build) */
 	bytea	   *kexp_gist_evals_packed;
+	bytea	   *kexp_range_keys_packed;
 	bytea	   *kexp_projection;
 	bytea	   *kexp_groupby_keyhash;
 	bytea	   *kexp_groupby_keyload;
@@ -307,6 +388,26 @@ typedef struct
 	/* group-by parameters */
 	List	   *groupby_actions;		/* list of KAGG_ACTION__* on the kds_final */
 	int			groupby_prepfn_bufsz;	/* buffer-size for GpuPreAgg shared memory */
+	bool		groupby_final_on_device;/* kds_final is returned w/o upper Agg */
+	int			groupby_sibling_id;		/* id of kds_final shared by siblings */
+	int			groupby_nsiblings;		/* number of siblings, or 0 if not shared */
+	bool		groupby_streaming;		/* groups are returned for each chunk */
+	/* GPU top-k for ORDER BY ... LIMIT */
+	int			gpusort_limit;			/* number of rows to keep, or 0 */
+	int			gpusort_resno;			/* sort key column of the projection */
+	int			gpusort_kind;			/* one of GPUSORT_KIND__* */
+	bool		gpusort_desc;			/* true, if descending order */
+	bool		gpusort_nulls_first;	/* true, if NULLS FIRST */
+	/* LIMIT pushdown */
+	int			scan_limit;				/* number of rows to return, or 0 */
+	/* GPU window functions */
+	List	   *gpuwin_funcs;			/* WindowFunc (only planner) */
+	List	   *gpuwin_func_actions;	/* KWIN_ACTION__* (only planner) */
+	List	   *gpuwin_key_exprs;		/* PARTITION BY + ORDER BY keys (only planner) */
+	List	   *gpuwin_key_flags;		/* GPUWIN_KEY__* (only planner) */
+	int			gpuwin_npart_keys;		/* number of PARTITION BY keys */
+	bool		gpuwin_rows_frame;		/* true, if ROWS frame */
+	bytea	   *gpuwin_desc;			/* kern_window_desc, or NULL */
 	/* inner relations */
 	int			sibling_param_id;
 	int			num_rels;
@@ -341,6 +442,10 @@ typedef struct
 	pg_atomic_uint64	inner_usage;
 	pg_atomic_uint64	stats_gist;			/* only GiST-index */
 	pg_atomic_uint64	stats_join;			/* # of tuples by this join */
+	/* dynamic filter; protected by preload_mutex */
+	uint64_t			dfilter_nitems;		/* # of valid inner keys */
+	int64_t				dfilter_min;		/* min value of the inner keys */
+	int64_t				dfilter_max;		/* max value of the inner keys */
 } pgstromSharedInnerState;
 
 typedef struct
@@ -359,6 +464,15 @@ typedef struct
 	pg_atomic_uint64	source_ntuples_raw;	/* # of raw tuples in the base relation */
 	pg_atomic_uint64	source_ntuples_in;	/* # of tuples survived from WHERE-quals */
 	pg_atomic_uint64	result_ntuples;		/* # of tuples returned from xPU */
+	/* device profiling counters */
+	pg_atomic_uint64	prof_ntasks;		/* # of tasks reported */
+	pg_atomic_uint64	prof_nkernels;		/* # of kernel launches */
+	pg_atomic_uint64	prof_nresumes;		/* # of suspend/resume cycles */
+	pg_atomic_uint64	prof_h2d_bytes;
+	pg_atomic_uint64	prof_d2h_bytes;
+	pg_atomic_uint64	prof_h2d_usec;
+	pg_atomic_uint64	prof_kern_usec;
+	pg_atomic_uint64	prof_occupancy;		/* sum of occupancy in permille */
 	/* for parallel-scan */
 	uint32_t			parallel_scan_desc_offset;
 	/* for arrow_fdw */
@@ -370,6 +484,12 @@ typedef struct
 	/* for brin-index */
 	pg_atomic_uint32	brin_index_fetched;
 	pg_atomic_uint32	brin_index_skipped;
+	/* for zone-map */
+	pg_atomic_uint64	zone_map_skipped;
+	/* for adaptive execution */
+	pg_atomic_uint32	adaptive_to_cpu;	/* # of switches GPU/DPU -> CPU */
+	pg_atomic_uint32	adaptive_to_xpu;	/* # of switches CPU -> GPU/DPU */
+	pg_atomic_uint64	adaptive_cpu_blocks; /* # of blocks processed by CPU */
 	/* for join-inner-preload */
 	ConditionVariable	preload_cond;		/* sync object */
 	slock_t				preload_mutex;		/* mutex for inner-preloading */
@@ -378,6 +498,7 @@ typedef struct
 	int					preload_nr_setup;	/* # of setup process */
 	uint32_t			preload_shmem_handle; /* host buffer handle */
 	uint64_t			preload_shmem_length; /* host buffer length */
+	uint64_t			preload_inner_digest; /* inner image on DPU, or 0 */
 	/* for join-inner relations */
 	uint32_t			num_rels;			/* if xPU-JOIN involved */
 	pgstromSharedInnerState inners[FLEXIBLE_ARRAY_MEMBER];
@@ -410,12 +531,26 @@ typedef struct
 	List		   *hash_inner_keys;    /* list of ExprState */
 	List		   *hash_outer_funcs;	/* list of devtype_hashfunc_f */
 	List		   *hash_inner_funcs;	/* list of devtype_hashfunc_f */
+	bool			hash_build_on_device; /* GPU builds the hash table */
+	ExprState	   *dfilter_inner_key;	/* inner key of the dynamic filter */
 	/*
 	 * join properties (gist-join)
 	 */
 	Relation		gist_irel;
 	ExprState	   *gist_clause;
 	AttrNumber		gist_ctid_resno;
+	bool			gist_rtree;			/* converted to kern_rtree_index */
+	AttrNumber		gist_prep_resno;	/* inner geometry to be prepared */
+	/*
+	 * join properties (range-join)
+	 */
+	ExprState	   *range_inner_key;	/* inner key to sort the inner rows */
+	/*
+	 * join properties (spatial-join without GiST index)
+	 */
+	ExprState	   *spatial_key;		/* inner geometry to be indexed */
+	FmgrInfo		spatial_box3d;		/* box3d(geometry) */
+	FmgrInfo		spatial_bound[4];	/* st_xmin/xmax/ymin/ymax(box3d) */
 	/*
 	 * CPU fallback (inner-loading)
 	 */
@@ -430,14 +565,66 @@ struct pgstromTaskState
 	const Bitmapset	   *optimal_gpus;	/* candidate GPUs to connect */
 	const DpuStorageEntry *ds_entry;	/* candidate DPUs to connect */
 	XpuConnection	   *conn;
+	XpuConnection	  **mgpu_conns;		/* sessions to the multiple GPUs */
+	int					num_mgpu_conns;	/* (pg_strom.gpu_scan_max_devices) */
+	uint64_t			mgpu_final_mask;	/* sessions already finalized */
 	pgstromSharedState *ps_state;		/* on the shared-memory segment */
 	pgstromPlanInfo	   *pp_info;
 	ArrowFdwState	   *arrow_state;
+	FileFdwState	   *file_state;
 	BrinIndexState	   *br_state;
+	ZoneMapState	   *zm_state;
+	char				tablesample_method;	/* KERN_TABLESAMPLE__*, or '\0' */
+	uint32_t			tablesample_seed;	/* hashed seed of the sampling */
+	uint64_t			tablesample_cutoff;	/* threshold of the hash values */
 	GpuCacheDesc	   *gcache_desc;
 	pg_atomic_uint32   *gcache_fetch_count;
 	kern_multirels	   *h_kmrels;		/* host inner buffer (if JOIN) */
+	/* hash-batched GpuJoin, if inner buffer is larger than the limit */
+	int					inner_batch_depth;	/* 0, if not batched */
+	uint32_t			inner_batch_id;		/* current batch to be joined */
+	uint32_t			inner_batch_loaded;	/* batch on the h_kmrels */
+	uint32_t			inner_nbatches;
+	uint64_t		   *inner_batch_nitems;	/* # of rows per batch */
+	uint64_t		   *inner_batch_usage;	/* usage of rows per batch */
+	MemoryContext		inner_batch_memcxt;	/* keeps the preloaded rows */
+	/* inner buffer kept by GPU service, for the following queries */
+	uint64_t			inner_cache_fingerprint; /* 0, if not cacheable */
+	uint8_t				inner_cache_digest[KERN_INNER_CACHE_DIGEST_LEN];
+	uint32_t			inner_cache_handle;	/* alias of the cached h_kmrels */
+	int					inner_cache_dindex;	/* GPU that keeps the buffer */
+	/* inner buffer kept by GPU service across rescans, if any */
+	bool				inner_rescan_keep;
+	uint32_t			inner_generation;	/* bumped when inner is rebuilt */
+	/* sibling that built the inner buffer, if partition-wise GpuJoin */
+	struct pgstromTaskState *inner_sibling;
 	const char		   *kds_pathname;	/* pathname to be used for KDS setup */
+	bool				gpu_direct_mvcc; /* GPU checks MVCC visibility of the
+										  * pages not all-visible */
+	/* pinned host staging ring shared with GPU service, if any */
+	xpuStagingRing	   *staging_ring;
+	uint32_t			staging_ring_handle;
+	/* per-scan prefetch control (see __fetchNextXpuCommand) */
+#define PGSTROM_PREFETCH_NSLOTS		64
+	int					prefetch_depth;		/* # of chunks to be in flight */
+	double				prefetch_build_usec;	/* avg time to build a chunk */
+	double				prefetch_device_usec;	/* avg turnaround of a chunk */
+	uint32_t			prefetch_head;
+	uint32_t			prefetch_tail;
+	TimestampTz			prefetch_send_ts[PGSTROM_PREFETCH_NSLOTS];
+	/* adaptive execution (see __updateAdaptiveExecStats) */
+	bool				adaptive_cpu_mode;	/* blocks are processed by CPU */
+	uint32_t			adaptive_nchunks;	/* # of chunks processed by xPU */
+	uint32_t			adaptive_nrounds;	/* # of CPU rounds since the probe */
+	double				adaptive_fallback_ratio; /* moving average */
+	bool				cpu_direct_scan;	/* tiny input is scanned by CPU,
+											 * without sessions */
+	uint32_t			chunk_nblocks;		/* # of blocks per chunk, or 0 for
+											 * the max (see __updateChunkSizeStats) */
+	/* runtime statistics for the cost calibration */
+	TimestampTz			calib_start_ts;		/* end of the session setup */
+	double				calib_setup_usec;	/* time to open the session */
+	int					calib_nsessions;	/* # of sessions opened */
 	/* current chunk (already processed by the device) */
 	XpuCommand		   *curr_resp;
 	HeapTupleData		curr_htup;
@@ -446,6 +633,8 @@ struct pgstromTaskState
 	int64_t				curr_index;
 	bool				scan_done;
 	bool				final_done;
+	int64_t				scan_limit;	/* LIMIT pushdown, or 0 */
+	int64_t				scan_nrows;	/* # of rows returned to the upper */
 	/*
 	 * control variables to fire the end-of-task event
 	 * for RIGHT OUTER JOIN and PRE-AGG
@@ -455,24 +644,32 @@ struct pgstromTaskState
 	/* base relation scan, if any */
 	TupleTableSlot	   *base_slot;
 	ExprState		   *base_quals;	/* equivalent to device quals */
-	/* CPU fallback support */
-	off_t			   *fallback_tuples;
-	size_t				fallback_index;
-	size_t				fallback_nitems;
-	size_t				fallback_nrooms;
-	size_t				fallback_usage;
-	size_t				fallback_bufsz;
-	char			   *fallback_buffer;
+	/* CPU fallback support (see relscan.c) */
+	struct pgstromFallbackChunk *fallback_head;	/* arena of fallback tuples */
+	struct pgstromFallbackChunk *fallback_curr;	/* chunk being written */
+	struct pgstromFallbackChunk *fallback_rchunk; /* chunk being read */
+	size_t				fallback_rpos;		/* read position on the rchunk */
+	int					fallback_nchunks;	/* # of chunks in the arena */
+	size_t				fallback_index;		/* # of tuples already fetched */
+	size_t				fallback_nitems;	/* # of tuples stored */
+	bool				fallback_spilled;	/* tuples go to the tuplestore */
+	Tuplestorestate	   *fallback_spill;		/* tuples over the arena limit */
+	TupleTableSlot	   *fallback_spill_slot;
 	TupleTableSlot	   *fallback_slot;	/* host-side kvars-slot */
+	TupleTableSlot	   *fallback_base_slot;	/* heap-tuple slot of base-rel */
 	List			   *fallback_proj;
 
 	List			   *fallback_load_src;	/* source resno of base-rel */
 	List			   *fallback_load_dst;	/* dest resno of fallback-slot */
+	int					fallback_load_natts;/* # of base-rel attrs to be deformed */
 	/* request command buffer (+ status for table scan) */
 	TBMIterateResult   *curr_tbm;
 	Buffer				curr_vm_buffer;		/* for visibility-map */
 	BlockNumber			curr_block_num;		/* for KDS_FORMAT_BLOCK */
 	BlockNumber			curr_block_tail;	/* for KDS_FORMAT_BLOCK */
+	dlist_head			shbuf_pins_list;	/* shared buffers pinned for DMA */
+	uint32_t			shbuf_npinned;		/* # of pinned shared buffers */
+	uint64_t			shbuf_last_tag;
 	StringInfoData		xcmd_buf;
 	/* callbacks */
 	TupleTableSlot	 *(*cb_next_tuple)(struct pgstromTaskState *pts);
@@ -501,6 +698,32 @@ extern long		PAGES_PER_BLOCK;	/* (BLCKSZ / PAGE_SIZE) */
 #define PAGE_ALIGN_DOWN(x)		TYPEALIGN_DOWN(PAGE_SIZE,(x))
 #define PGSTROM_CHUNK_SIZE		((size_t)(65534UL << 10))
 
+/*
+ * xpuStagingRing - pinned host buffers shared by the backend and GPU service
+ *
+ * The backend puts XpuTaskExec commands on the free slots, then sends only
+ * the slot number over the socket. GPU service releases the slot once the
+ * command is processed. In the same way, GPU service puts the responses on
+ * the free slots, and the backend releases them on xpuClientPutResponse().
+ * slot_busy[] is 0 (free), 1 (command) or 2 (response).
+ */
+typedef struct xpuStagingRing
+{
+	uint32_t		nslots;
+	size_t			slot_sz;
+	pg_atomic_uint32 slot_busy[FLEXIBLE_ARRAY_MEMBER];
+} xpuStagingRing;
+
+#define XPU_STAGING_RING_SLOTSZ		PAGE_ALIGN(PGSTROM_CHUNK_SIZE + (2UL << 20))
+#define XPU_STAGING_RING_HEADSZ(nslots)							\
+	PAGE_ALIGN(offsetof(xpuStagingRing, slot_busy[(nslots)]))
+#define XPU_STAGING_RING_LENGTH(nslots)							\
+	(XPU_STAGING_RING_HEADSZ(nslots) + (nslots) * XPU_STAGING_RING_SLOTSZ)
+#define XPU_STAGING_RING_SLOT(ring,slot_id)						\
+	((XpuCommand *)((char *)(ring) +							\
+					XPU_STAGING_RING_HEADSZ((ring)->nslots) +	\
+					(size_t)(slot_id) * (ring)->slot_sz))
+
 /*
  * extra.c
  */
@@ -580,6 +803,10 @@ typedef struct
 	int			kvecs_ndims;
 	uint32_t	kvecs_usage;
 	Index		scan_relid;		/* depth==0 */
+	List	   *gcache_vcols;	/* virtual columns of GpuCache, if any */
+	List	   *cse_items;		/* common sub-expressions, if any */
+	int			cse_level;		/* depth of conditional evaluation */
+	Expr	   *cse_parent;		/* parent expression on the walk */
 	int			num_rels;
 	struct {
 		PathTarget *inner_target;
@@ -596,6 +823,12 @@ extern devfunc_info *pgstrom_devfunc_lookup(Oid func_oid,
 
 extern devfunc_info *devtype_lookup_equal_func(devtype_info *dtype, Oid coll_id);
 extern devfunc_info *devtype_lookup_compare_func(devtype_info *dtype, Oid coll_id);
+extern PGDLLEXPORT FuncOpCode pgstrom_register_device_function(const pgstromUserDevFunc *ufunc);
+extern PGDLLEXPORT void	pgstrom_register_device_type_alias(const char *type_extension,
+														   const char *type_name,
+														   const char *base_extension,
+														   const char *base_name);
+extern const pgstromUserDevFunc *pgstrom_user_devfunc_catalog(int *p_nitems);
 
 extern codegen_context *create_codegen_context(PlannerInfo *root,
 											   CustomPath *cpath,
@@ -607,8 +840,13 @@ extern bytea   *codegen_build_packed_joinquals(codegen_context *context,
 											   List *stacked_other_quals);
 extern bytea   *codegen_build_packed_hashkeys(codegen_context *context,
 											  List *stacked_hash_values);
+extern bytea	   *codegen_build_packed_rangekeys(codegen_context *context,
+											   pgstromPlanInfo *pp_info);
 extern void		codegen_build_packed_gistevals(codegen_context *context,
 											   pgstromPlanInfo *pp_info);
+extern void		codegen_build_bloom_filters(codegen_context *context,
+											pgstromPlanInfo *pp_info,
+											List *bloom_depths);
 extern bytea   *codegen_build_projection(codegen_context *context);
 extern void		codegen_build_groupby_actions(codegen_context *context,
 											  pgstromPlanInfo *pp_info);
@@ -622,6 +860,8 @@ extern bool		pgstrom_xpu_expression(Expr *expr,
 									   Index scan_relid,
 									   List *inner_target_list,
 									   int *p_devcost);
+extern HTAB	   *pgstrom_begin_xpu_expression_cache(void);
+extern void		pgstrom_end_xpu_expression_cache(HTAB *saved_htable);
 extern uint32_t	estimate_cuda_stack_size(codegen_context *context);
 extern void		pgstrom_explain_kvars_slot(const CustomScanState *css,
 										   ExplainState *es,
@@ -645,6 +885,11 @@ extern IndexOptInfo *pgstromTryFindBrinIndex(PlannerInfo *root,
 											 List **p_indexConds,
 											 List **p_indexQuals,
 											 int64_t *p_indexNBlocks);
+extern bool		pgstromBrinIndexAddDynamicFilter(PlannerInfo *root,
+												 pgstromPlanInfo *pp_info,
+												 Var *var,
+												 Param *param_min,
+												 Param *param_max);
 extern Cost		cost_brin_bitmap_build(PlannerInfo *root,
 									   RelOptInfo *baserel,
 									   IndexOptInfo *indexOpt,
@@ -676,6 +921,18 @@ extern Path	   *pgstromTryFindGistIndex(PlannerInfo *root,
 										Index base_scan_relid,
 										List *inner_target_list,
 										pgstromPlanInnerInfo *pp_inner);
+extern bool		pgstromGistKeyIsBox2df(Oid type_oid);
+extern void		pgstromTryPrepareGeometry(PathTarget *inner_target,
+										  pgstromPlanInnerInfo *pp_inner);
+extern size_t	pgstromBuildPrepPolygon(const char *gs_addr,
+										char *buf, size_t bufsz);
+extern bool		pgstromTryBuildSpatialIndex(PlannerInfo *root,
+											Path *inner_path,
+											List *restrict_clauses,
+											uint32_t xpu_task_flags,
+											Index base_scan_relid,
+											List *inner_target_list,
+											pgstromPlanInnerInfo *pp_inner);
 /*
  * relscan.c
  */
@@ -691,11 +948,42 @@ extern size_t	setup_kern_data_store(kern_data_store *kds,
 extern XpuCommand *pgstromRelScanChunkDirect(pgstromTaskState *pts,
 											 struct iovec *xcmd_iov,
 											 int *xcmd_iovcnt);
+extern TupleTableSlot *pgstromRelScanCpuDirect(pgstromTaskState *pts);
+extern bool		pgstromRelScanDirectMVCCEnabled(pgstromTaskState *pts);
+extern void		pgstromRelScanReleaseSharedBuffers(pgstromTaskState *pts,
+												   uint64_t shbuf_tag);
 extern XpuCommand *pgstromRelScanChunkNormal(pgstromTaskState *pts,
 											 struct iovec *xcmd_iov,
 											 int *xcmd_iovcnt);
 extern void		pgstromStoreFallbackTuple(pgstromTaskState *pts, HeapTuple tuple);
+extern void		pgstromStoreFallbackSlot(pgstromTaskState *pts, TupleTableSlot *slot);
+extern TupleTableSlot *pgstromLoadFallbackBaseTuple(pgstromTaskState *pts,
+													HeapTuple tuple);
 extern TupleTableSlot *pgstromFetchFallbackTuple(pgstromTaskState *pts);
+extern void		pgstromResetFallbackBuffer(pgstromTaskState *pts);
+extern void		pgstromReleaseFallbackBuffer(pgstromTaskState *pts);
+extern void		pgstromZoneMapExecInit(pgstromTaskState *pts);
+extern void		pgstromZoneMapExplain(pgstromTaskState *pts,
+									  List *dcontext,
+									  ExplainState *es);
+extern void		pgstromTableSampleExecInit(pgstromTaskState *pts);
+extern bool		pgstromTableSampleBlock(pgstromTaskState *pts,
+										BlockNumber block_num);
+extern bool		pgstromTableSampleTuple(pgstromTaskState *pts,
+										BlockNumber block_num,
+										OffsetNumber lineoff);
+extern void		pgstromTableSampleExplain(pgstromTaskState *pts,
+										  ExplainState *es);
+extern bool		baseRelIsFileFdw(RelOptInfo *baserel);
+extern bool		RelationIsFileFdw(Relation frel);
+extern bool		pgstromFileFdwExecInit(pgstromTaskState *pts);
+extern XpuCommand *pgstromScanChunkFileFdw(pgstromTaskState *pts,
+										   struct iovec *xcmd_iov,
+										   int *xcmd_iovcnt);
+extern void		pgstromFileFdwExecReset(pgstromTaskState *pts);
+extern void		pgstromFileFdwExecEnd(pgstromTaskState *pts);
+extern void		pgstromFileFdwExplain(pgstromTaskState *pts,
+									  ExplainState *es);
 extern void		pgstrom_init_relscan(void);
 
 /*
@@ -714,6 +1002,7 @@ xpuConnectReceiveCommands(pgsocket sockfd,
 						  const char *error_label);
 extern void		xpuClientCloseSession(XpuConnection *conn);
 extern void		xpuClientSendCommand(XpuConnection *conn, const XpuCommand *xcmd);
+extern void		xpuClientCancelTasks(XpuConnection *conn);
 extern void		xpuClientPutResponse(XpuCommand *xcmd);
 extern const XpuCommand *pgstromBuildSessionInfo(pgstromTaskState *pts,
 												 uint32_t join_inner_handle,
@@ -724,6 +1013,9 @@ extern void		pgstromExecInitTaskState(CustomScanState *node,
 										  EState *estate,
 										 int eflags);
 extern TupleTableSlot *pgstromExecTaskState(CustomScanState *node);
+extern kern_data_store *pgstromExecTaskNextBatch(PlanState *ps,
+												 int64_t *p_index,
+												 int64_t *p_nitems);
 extern void		pgstromExecEndTaskState(CustomScanState *node);
 extern void		pgstromExecResetTaskState(CustomScanState *node);
 extern Size		pgstromSharedStateEstimateDSM(CustomScanState *node,
@@ -757,8 +1049,17 @@ extern const Bitmapset *GetOptimalGpuForFile(const char *pathname);
 extern const Bitmapset *GetOptimalGpuForRelation(Relation relation);
 extern const Bitmapset *GetOptimalGpuForBaseRel(PlannerInfo *root,
 												RelOptInfo *baserel);
+extern bool		gpuClientDeviceIsAllowed(int cuda_dindex);
+extern void		gpuClientOpenSessionOnDevice(pgstromTaskState *pts,
+											 const XpuCommand *session,
+											 int cuda_dindex);
 extern void		gpuClientOpenSession(pgstromTaskState *pts,
 									 const XpuCommand *session);
+extern uint32_t	gpuClientSetupStagingRing(pgstromTaskState *pts);
+extern void		gpuClientReleaseStagingRing(pgstromTaskState *pts);
+extern bool		gpuClientStageXpuCommand(pgstromTaskState *pts,
+										 struct iovec *xcmd_iov,
+										 int *xcmd_iovcnt);
 extern CUresult	gpuOptimalBlockSize(int *p_grid_sz,
 									int *p_block_sz,
 									CUfunction kern_function,
@@ -771,10 +1072,26 @@ extern bool		pgstrom_init_gpu_device(void);
 typedef struct gpuContext	gpuContext;
 typedef struct gpuClient	gpuClient;
 
+#define GPUSERV_REMOTE_AUTH_NONCE_LEN	32
+#define GPUSERV_REMOTE_AUTH_DIGEST_LEN	PG_SHA256_DIGEST_LENGTH
+#define GPUSERV_REMOTE_AUTH_TIMEOUT		5	/* sec */
+
+extern bool		pgstrom_jit_kernels;
+extern bool		pgstrom_gpu_trace;
+extern char	   *pgstrom_gpuserv_remote_secret;
 extern int		pgstrom_max_async_tasks(void);
 extern bool		gpuserv_ready_accept(void);
 extern const char *cuStrError(CUresult rc);
 extern bool		gpuServiceGoingTerminate(void);
+extern bool		gpuServiceSharedBuffersDMA(void);
+extern bool		gpuservLookupInnerCache(uint64_t fingerprint,
+										const uint8_t *digest,
+										const Bitmapset *gpuset,
+										int *p_cuda_dindex,
+										uint32_t *p_shmem_handle,
+										size_t *p_kmrels_sz);
+extern bool		gpuservRemoteAuthDigest(const uint8_t *nonce, uint8_t *digest);
+extern bool		gpuservRemoteKexpIsSupported(const kern_expression *kexp);
 extern void		gpuservBgWorkerMain(Datum arg);
 extern void		pgstrom_init_gpu_service(void);
 
@@ -782,11 +1099,27 @@ extern void		pgstrom_init_gpu_service(void);
  * gpu_cache.c
  */
 extern void		pgstrom_init_gpu_cache(void);
+extern void		pgstrom_init_gpu_cache_rmgr(void);
 extern int		baseRelHasGpuCache(PlannerInfo *root,
 								   RelOptInfo *baserel);
+extern List	   *baseRelGpuCacheVirtualColumns(PlannerInfo *root,
+											  RelOptInfo *baserel);
+extern bool		gpuCacheMatchVirtualColumns(const GpuCacheDesc *gc_desc,
+											List *vcols);
+extern Expr	   *baseRelGpuCacheIndexQual(PlannerInfo *root,
+										 RelOptInfo *baserel,
+										 List *dev_quals,
+										 int *p_index_attnum);
+extern bool		gpuCacheLookupIndexKey(const GpuCacheDesc *gc_desc,
+									   pgstromTaskState *pts,
+									   int64_t *p_index_value);
+extern void		gpuCacheSetupBitFilter(const GpuCacheDesc *gc_desc,
+									   pgstromTaskState *pts,
+									   kern_session_info *session);
 extern bool		RelationHasGpuCache(Relation rel);
 extern const GpuCacheIdent *getGpuCacheDescIdent(const GpuCacheDesc *gc_desc);
 extern GpuCacheDesc *pgstromGpuCacheExecInit(pgstromTaskState *pts);
+extern const Bitmapset *GetOptimalGpuForGpuCache(const GpuCacheDesc *gc_desc);
 extern XpuCommand *pgstromScanChunkGpuCache(pgstromTaskState *pts,
 											struct iovec *xcmd_iov,
 											int *xcmd_iovcnt);
@@ -806,10 +1139,11 @@ extern void		gpucacheManagerEventLoop(int cuda_dindex,
 extern void		gpucacheManagerWakeUp(int cuda_dindex);
 
 extern void	   *gpuCacheGetDeviceBuffer(const GpuCacheIdent *ident,
+										int cuda_dindex,
 										CUdeviceptr *p_gcache_main_devptr,
 										CUdeviceptr *p_gcache_extra_devptr,
 										char *errbuf, size_t errbuf_sz);
-extern void		gpuCachePutDeviceBuffer(void *gc_lmap);
+extern void		gpuCachePutDeviceBuffer(void *gc_dbuf);
 
 /*
  * gpu_scan.c
@@ -835,6 +1169,8 @@ extern void		pgstrom_init_dpu_scan(void);
 /*
  * gpu_join.c
  */
+extern bool		pgstrom_gpujoin_multi_gpu_inner;
+extern int		pgstrom_gpujoin_inner_cache_size;
 extern pgstromPlanInfo *try_fetch_xpujoin_planinfo(const Path *path);
 extern List	   *buildOuterJoinPlanInfo(PlannerInfo *root,
 									   RelOptInfo *outer_rel,
@@ -848,10 +1184,21 @@ extern CustomScan *PlanXpuJoinPathCommon(PlannerInfo *root,
 										 List *custom_plans,
 										 pgstromPlanInfo *pp_info,
 										 const CustomScanMethods *methods);
+extern uint64_t	GpuJoinInnerCacheFingerprint(pgstromTaskState *pts,
+											 int eflags);
+extern uint32_t	GpuJoinInnerCacheAttach(pgstromTaskState *pts);
+extern const DpuStorageEntry *GpuJoinInnerShmemEntry(pgstromTaskState *pts);
+extern uint64_t	GpuJoinInnerImageDigest(pgstromTaskState *pts);
 extern uint32_t	GpuJoinInnerPreload(pgstromTaskState *pts);
+extern List	   *GpuJoinDynamicFilterExecInit(pgstromTaskState *pts);
+extern bool		GpuJoinInnerRescanKeep(pgstromTaskState *pts, int eflags);
+extern void		GpuJoinInnerRescan(pgstromTaskState *pts);
+extern void		pgstromSetupSpatialIndexFuncs(pgstromTaskInnerState *istate,
+											  Oid geom_oid);
 extern bool		ExecFallbackCpuJoin(pgstromTaskState *pts,
 									HeapTuple tuple);
 extern void		ExecFallbackCpuJoinRightOuter(pgstromTaskState *pts);
+extern bool		GpuJoinRightOuterOnDevice(pgstromTaskState *pts);
 extern void		ExecFallbackCpuJoinOuterJoinMap(pgstromTaskState *pts,
 												XpuCommand *resp);
 extern void		pgstrom_init_gpu_join(void);
@@ -872,6 +1219,30 @@ extern bool		ExecFallbackCpuPreAgg(pgstromTaskState *pts,
 extern void		pgstrom_init_gpu_preagg(void);
 extern void		pgstrom_init_dpu_preagg(void);
 
+/*
+ * gpu_sort.c
+ */
+extern void		pgstrom_build_gpusort_topk(PlannerInfo *root,
+										   RelOptInfo *rel,
+										   CustomScan *cscan,
+										   pgstromPlanInfo *pp_info);
+extern void		pgstrom_build_scan_limit(PlannerInfo *root,
+										 RelOptInfo *rel,
+										 pgstromPlanInfo *pp_info);
+extern char		pgstrom_gpusort_sortop_kind(Oid sortop, Oid sort_type,
+											bool *p_desc);
+extern void		pgstrom_init_gpu_sort(void);
+
+/*
+ * gpu_window.c
+ */
+extern void		pgstrom_build_window_tlist_dev(codegen_context *context,
+											   pgstromPlanInfo *pp_info);
+extern void		pgstrom_fixup_window_tlist_dev(codegen_context *context,
+											   pgstromPlanInfo *pp_info);
+extern bool		ExecFallbackCpuWindow(pgstromTaskState *pts, HeapTuple tuple);
+extern void		pgstrom_init_gpu_window(void);
+
 /*
  * arrow_fdw.c and arrow_read.c
  */
@@ -912,6 +1283,7 @@ extern double	pgstrom_dpu_operator_cost;
 extern double	pgstrom_dpu_seq_page_cost;
 extern double	pgstrom_dpu_tuple_cost;
 extern bool		pgstrom_dpu_handle_cached_pages;
+extern bool		pgstrom_dpu_inner_cache;
 extern double	pgstrom_dpu_operator_ratio(void);
 
 extern const DpuStorageEntry *GetOptimalDpuForFile(const char *filename,
@@ -926,12 +1298,36 @@ extern bool		DpuStorageEntryIsEqual(const DpuStorageEntry *ds_entry1,
 extern int		DpuStorageEntryGetEndpointId(const DpuStorageEntry *ds_entry);
 extern const DpuStorageEntry *DpuStorageEntryByEndpointId(int endpoint_id);
 extern int		DpuStorageEntryCount(void);
+extern bool		DpuStorageEntryIsAvailable(const DpuStorageEntry *ds_entry);
 extern void		DpuClientOpenSession(pgstromTaskState *pts,
 									 const XpuCommand *session);
+extern void		DpuClientCloseSession(int endpoint_id);
+extern void		DpuInnerCachePublish(const DpuStorageEntry *ds_entry,
+									 uint64_t digest,
+									 const kern_multirels *h_kmrels);
 extern void		explainDpuStorageEntry(const DpuStorageEntry *ds_entry,
 									   ExplainState *es);
 extern bool		pgstrom_init_dpu_device(void);
 
+/*
+ * cost_calib.c
+ */
+extern void		pgstromCostCalibRecord(uint32_t devkind, Oid spcid,
+									   double setup_usec, double run_usec,
+									   double npages, double ntuples);
+extern void		pgstromCostCalibLookup(uint32_t devkind, Oid spcid,
+									   Cost *p_setup_cost,
+									   Cost *p_page_cost,
+									   Cost *p_tuple_cost);
+extern Oid		pgstromCostCalibSpcId(PlannerInfo *root, Index scan_relid);
+extern void		pgstrom_init_cost_calib(void);
+
+/*
+ * hintbits.c
+ */
+extern void		pgstromHintBitsSetterRegister(Relation relation);
+extern void		pgstrom_init_hintbits(void);
+
 /*
  * misc.c
  */
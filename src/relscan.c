@@ -354,79 +354,823 @@ estimate_kern_data_store(TupleDesc tupdesc)
 
 /*
  * Routines to store/fetch fallback tuples
+ *
+ * Fallback tuples are stored on the arena of fixed-length chunks, which
+ * are kept across the chunks of the scan and reused once all the tuples
+ * are fetched. The arena is up to work_mem, and the following tuples are
+ * written to the tuplestore (spilled to the temporary file) until all the
+ * tuples are fetched, to keep the order of the tuples.
  */
-void
-pgstromStoreFallbackTuple(pgstromTaskState *pts, HeapTuple htuple)
+typedef struct pgstromFallbackChunk
+{
+	struct pgstromFallbackChunk *next;
+	size_t		usage;
+	char		data[FLEXIBLE_ARRAY_MEMBER];
+} pgstromFallbackChunk;
+
+#define FALLBACK_CHUNK_SIZE		(256UL << 10)
+#define FALLBACK_CHUNK_DATASZ	\
+	(FALLBACK_CHUNK_SIZE - MAXALIGN(offsetof(pgstromFallbackChunk, data)))
+
+static kern_tupitem *
+__pgstromAllocFallbackTuple(pgstromTaskState *pts, size_t t_len)
 {
-	MemoryContext memcxt = pts->css.ss.ps.state->es_query_cxt;
+	pgstromFallbackChunk *chunk = pts->fallback_curr;
 	kern_tupitem *titem;
 	size_t		sz;
 
-	if (!pts->fallback_tuples)
+	/* once spilled, the following tuples also go to the tuplestore */
+	if (pts->fallback_spilled)
+		return NULL;
+	sz = MAXALIGN(offsetof(kern_tupitem, htup) + t_len);
+	if (sz > FALLBACK_CHUNK_DATASZ)
+		return NULL;
+	if (!chunk || chunk->usage + sz > FALLBACK_CHUNK_DATASZ)
 	{
-		pts->fallback_index = 0;
-		pts->fallback_nitems = 0;
-		pts->fallback_nrooms = 1000;
-		pts->fallback_tuples =
-			MemoryContextAlloc(memcxt, sizeof(off_t) * pts->fallback_nrooms);
+		pgstromFallbackChunk *next = (chunk ? chunk->next : pts->fallback_head);
+
+		if (!next)
+		{
+			/* expand the arena, if still less than work_mem */
+			if (pts->fallback_nchunks > 0 &&
+				(pts->fallback_nchunks + 1) * FALLBACK_CHUNK_SIZE > work_mem * 1024L)
+				return NULL;
+			next = MemoryContextAlloc(pts->css.ss.ps.state->es_query_cxt,
+									  FALLBACK_CHUNK_SIZE);
+			next->next = NULL;
+			if (chunk)
+				chunk->next = next;
+			else
+				pts->fallback_head = next;
+			pts->fallback_nchunks++;
+		}
+		next->usage = 0;
+		if (!pts->fallback_rchunk)
+		{
+			pts->fallback_rchunk = next;
+			pts->fallback_rpos = 0;
+		}
+		pts->fallback_curr = chunk = next;
 	}
-	if (!pts->fallback_buffer)
+	titem = (kern_tupitem *)(chunk->data + chunk->usage);
+	titem->t_len = t_len;
+	titem->rowid = pts->fallback_nitems++;
+	chunk->usage += sz;
+
+	return titem;
+}
+
+static Tuplestorestate *
+__pgstromSpillFallbackTuple(pgstromTaskState *pts)
+{
+	if (!pts->fallback_spill)
 	{
-		pts->fallback_usage = 0;
-		pts->fallback_bufsz = 8 * BLCKSZ;
-		pts->fallback_buffer =
-			MemoryContextAlloc(memcxt, pts->fallback_bufsz);
+		MemoryContext oldcxt;
+
+		oldcxt = MemoryContextSwitchTo(pts->css.ss.ps.state->es_query_cxt);
+		/* the arena already consumed work_mem, so spill soon */
+		pts->fallback_spill = tuplestore_begin_heap(false, false, 64);
+		MemoryContextSwitchTo(oldcxt);
 	}
-	sz = MAXALIGN(offsetof(kern_tupitem, htup) + htuple->t_len);
-	while (pts->fallback_usage + sz > pts->fallback_bufsz)
+	pts->fallback_spilled = true;
+	pts->fallback_nitems++;
+	return pts->fallback_spill;
+}
+
+void
+pgstromStoreFallbackTuple(pgstromTaskState *pts, HeapTuple htuple)
+{
+	kern_tupitem *titem = __pgstromAllocFallbackTuple(pts, htuple->t_len);
+
+	if (titem)
+		memcpy(&titem->htup, htuple->t_data, htuple->t_len);
+	else
+		tuplestore_puttuple(__pgstromSpillFallbackTuple(pts), htuple);
+}
+
+/*
+ * pgstromStoreFallbackSlot
+ *
+ * It forms the virtual tuple of the slot into the fallback buffer directly,
+ * like heap_form_tuple() doing, to avoid a temporary HeapTuple and memcpy
+ * for each fallback row.
+ */
+void
+pgstromStoreFallbackSlot(pgstromTaskState *pts, TupleTableSlot *slot)
+{
+	TupleDesc	tupdesc = slot->tts_tupleDescriptor;
+	Datum	   *values = slot->tts_values;
+	bool	   *isnull = slot->tts_isnull;
+	int			natts = tupdesc->natts;
+	bool		hasnull = false;
+	kern_tupitem *titem;
+	HeapTupleHeader td;
+	size_t		hoff;
+	size_t		data_len;
+
+	slot_getallattrs(slot);
+	for (int j=0; j < natts; j++)
 	{
-		pts->fallback_bufsz *= 2 + BLCKSZ;
-		pts->fallback_buffer = repalloc_huge(pts->fallback_buffer,
-											 pts->fallback_bufsz);
+		if (isnull[j])
+		{
+			hasnull = true;
+			break;
+		}
 	}
-	while (pts->fallback_nitems >= pts->fallback_nrooms)
+	hoff = offsetof(HeapTupleHeaderData, t_bits);
+	if (hasnull)
+		hoff += BITMAPLEN(natts);
+	hoff = MAXALIGN(hoff);
+	data_len = heap_compute_data_size(tupdesc, values, isnull);
+
+	titem = __pgstromAllocFallbackTuple(pts, hoff + data_len);
+	if (!titem)
 	{
-		pts->fallback_nrooms *= 2 + 100;
-		pts->fallback_tuples = repalloc_huge(pts->fallback_tuples,
-											 sizeof(off_t) * pts->fallback_nrooms);
+		tuplestore_puttupleslot(__pgstromSpillFallbackTuple(pts), slot);
+		return;
 	}
-	titem = (kern_tupitem *)(pts->fallback_buffer +
-							 pts->fallback_usage);
-	titem->t_len = htuple->t_len;
-	titem->rowid = pts->fallback_nitems++;
-	memcpy(&titem->htup, htuple->t_data, htuple->t_len);
+	td = &titem->htup;
+	memset(td, 0, hoff);
+	HeapTupleHeaderSetDatumLength(td, hoff + data_len);
+	HeapTupleHeaderSetTypeId(td, tupdesc->tdtypeid);
+	HeapTupleHeaderSetTypMod(td, tupdesc->tdtypmod);
+	ItemPointerSetInvalid(&td->t_ctid);
+	HeapTupleHeaderSetNatts(td, natts);
+	td->t_hoff = hoff;
+	heap_fill_tuple(tupdesc, values, isnull,
+					(char *)td + hoff, data_len,
+					&td->t_infomask,
+					(hasnull ? td->t_bits : NULL));
+}
 
-	pts->fallback_tuples[titem->rowid] = pts->fallback_usage;
-	pts->fallback_usage += sz;
+/*
+ * pgstromLoadFallbackBaseTuple
+ *
+ * It associates the base tuple with the heap-tuple slot without copy, then
+ * deforms only the attributes referenced by the CPU fallback.
+ */
+TupleTableSlot *
+pgstromLoadFallbackBaseTuple(pgstromTaskState *pts, HeapTuple tuple)
+{
+	TupleTableSlot *slot = pts->fallback_base_slot;
+
+	ExecStoreHeapTuple(tuple, slot, false);
+	if (pts->fallback_load_natts > 0)
+		slot_getsomeattrs(slot, pts->fallback_load_natts);
+	return slot;
 }
 
 TupleTableSlot *
 pgstromFetchFallbackTuple(pgstromTaskState *pts)
 {
-	if (pts->fallback_tuples &&
-		pts->fallback_buffer &&
-		pts->fallback_index < pts->fallback_nitems)
-	{
-		TupleTableSlot *slot = pts->css.ss.ss_ScanTupleSlot;
-		HeapTuple		htuple = palloc0(sizeof(HeapTupleData));
-		kern_tupitem   *titem;
-
-		titem = (kern_tupitem *)(pts->fallback_buffer +
-								 pts->fallback_tuples[pts->fallback_index++]);
-		htuple->t_len  = titem->t_len;
-		htuple->t_data = &titem->htup;
-		ExecForceStoreHeapTuple(htuple, slot, true);
-		/* reset the buffer if last one */
-		if (pts->fallback_index == pts->fallback_nitems)
+	TupleTableSlot *slot = pts->css.ss.ss_ScanTupleSlot;
+	pgstromFallbackChunk *chunk;
+
+	if (pts->fallback_index >= pts->fallback_nitems)
+		return NULL;
+	/* tuples on the arena first */
+	while ((chunk = pts->fallback_rchunk) != NULL)
+	{
+		if (pts->fallback_rpos < chunk->usage)
 		{
-			pts->fallback_index = 0;
-			pts->fallback_nitems = 0;
-			pts->fallback_usage = 0;
+			HeapTuple		htuple = palloc0(sizeof(HeapTupleData));
+			kern_tupitem   *titem;
+
+			titem = (kern_tupitem *)(chunk->data + pts->fallback_rpos);
+			pts->fallback_rpos += MAXALIGN(offsetof(kern_tupitem, htup) +
+										   titem->t_len);
+			htuple->t_len  = titem->t_len;
+			htuple->t_data = &titem->htup;
+			ExecForceStoreHeapTuple(htuple, slot, true);
+			goto found;
 		}
-		slot_getallattrs(slot);
-		return slot;
+		if (chunk == pts->fallback_curr)
+			break;
+		pts->fallback_rchunk = chunk->next;
+		pts->fallback_rpos = 0;
+	}
+	/* elsewhere, tuples spilled to the tuplestore */
+	if (!pts->fallback_spill_slot)
+		pts->fallback_spill_slot = MakeSingleTupleTableSlot(slot->tts_tupleDescriptor,
+															&TTSOpsMinimalTuple);
+	if (!pts->fallback_spilled ||
+		!tuplestore_gettupleslot(pts->fallback_spill, true, false,
+								 pts->fallback_spill_slot))
+		elog(ERROR, "Bug? CPU fallback tuples are missing");
+	ExecCopySlot(slot, pts->fallback_spill_slot);
+found:
+	/* reset the buffer if last one */
+	if (++pts->fallback_index == pts->fallback_nitems)
+		pgstromResetFallbackBuffer(pts);
+	slot_getallattrs(slot);
+	return slot;
+}
+
+/*
+ * pgstromResetFallbackBuffer
+ *
+ * It discards the fallback tuples, but keeps the arena to be reused.
+ */
+void
+pgstromResetFallbackBuffer(pgstromTaskState *pts)
+{
+	pts->fallback_curr = NULL;
+	pts->fallback_rchunk = NULL;
+	pts->fallback_rpos = 0;
+	pts->fallback_index = 0;
+	pts->fallback_nitems = 0;
+	if (pts->fallback_spilled)
+	{
+		tuplestore_clear(pts->fallback_spill);
+		pts->fallback_spilled = false;
+	}
+}
+
+/*
+ * pgstromReleaseFallbackBuffer
+ */
+void
+pgstromReleaseFallbackBuffer(pgstromTaskState *pts)
+{
+	pgstromFallbackChunk *chunk;
+
+	pgstromResetFallbackBuffer(pts);
+	while ((chunk = pts->fallback_head) != NULL)
+	{
+		pts->fallback_head = chunk->next;
+		pfree(chunk);
 	}
-	return NULL;
+	pts->fallback_nchunks = 0;
+	if (pts->fallback_spill)
+		tuplestore_end(pts->fallback_spill);
+	pts->fallback_spill = NULL;
+	if (pts->fallback_spill_slot)
+		ExecDropSingleTupleTableSlot(pts->fallback_spill_slot);
+	pts->fallback_spill_slot = NULL;
+}
+
+/* ----------------------------------------------------------------
+ *
+ * Routines to support zone-map of heap blocks
+ *
+ * Zone-map is a lazily built min/max summary of the heap blocks, kept
+ * on the shared memory. When GpuScan loads an all-visible heap block
+ * through the shared buffer, it also summarizes the min/max value of
+ * the zone-map column, then the following scans skip the blocks that
+ * never match the scan qualifiers like BRIN-index doing, unless the
+ * block is modified (it clears the visibility-map) or any modification
+ * is reported on the relation.
+ *
+ * ----------------------------------------------------------------
+ */
+#define ZONE_MAP_BLOCKS_PER_ZONE	32
+
+typedef struct
+{
+	Oid			database_oid;
+	Oid			table_oid;
+	Oid			relfilenode;
+	AttrNumber	attnum;
+	BlockNumber	zone_id;
+} zoneMapKey;
+
+typedef struct
+{
+	zoneMapKey	key;
+	uint64		generation;		/* # of modification on the relation */
+	uint32		summarized;		/* bitmap of the summarized blocks */
+	bool		has_values;		/* false, if all the values are NULL */
+	int64		min_value;
+	int64		max_value;
+} zoneMapEntry;
+
+typedef struct
+{
+	LWLock		lock;
+	HTAB	   *hash;
+} zoneMapSharedHead;
+
+struct ZoneMapState
+{
+	AttrNumber	attnum;			/* zone-map column */
+	Oid			atttypid;
+	int64		lower_bound;	/* inclusive */
+	int64		upper_bound;	/* inclusive */
+	uint64		generation;
+	zoneMapKey	curr_key;		/* copy of the current zone */
+	zoneMapEntry curr_zone;
+	bool		curr_valid;
+};
+
+static zoneMapSharedHead *zone_map_head = NULL;
+static int		pgstrom_zone_map_max_entries;	/* GUC */
+static bool		pgstrom_gpudirect_mvcc_check;	/* GUC */
+static shmem_request_hook_type shmem_request_next = NULL;
+static shmem_startup_hook_type shmem_startup_next = NULL;
+
+/*
+ * __zoneMapDatumGetInt64
+ */
+static bool
+__zoneMapDatumGetInt64(Oid type_oid, Datum datum, int64 *p_value)
+{
+	switch (type_oid)
+	{
+		case INT2OID:
+			*p_value = DatumGetInt16(datum);
+			return true;
+		case INT4OID:
+			*p_value = DatumGetInt32(datum);
+			return true;
+		case DATEOID:
+			*p_value = DatumGetDateADT(datum);
+			return true;
+		case INT8OID:
+			*p_value = DatumGetInt64(datum);
+			return true;
+		case TIMESTAMPOID:
+			*p_value = DatumGetTimestamp(datum);
+			return true;
+		case TIMESTAMPTZOID:
+			*p_value = DatumGetTimestampTz(datum);
+			return true;
+		default:
+			break;
+	}
+	return false;
+}
+
+/*
+ * __zoneMapCheckOneQual - pull out a range [lower, upper] from the qual
+ */
+static bool
+__zoneMapCheckOneQual(Expr *expr, AttrNumber *p_attnum, Oid *p_atttypid,
+					  int64 *p_lower, int64 *p_upper)
+{
+	OpExpr	   *op = (OpExpr *)expr;
+	Var		   *var;
+	Const	   *con;
+	Oid			opno;
+	Oid			opclass;
+	int			strategy;
+	int64		value;
+
+	if (!IsA(op, OpExpr) || list_length(op->args) != 2)
+		return false;
+	var = linitial(op->args);
+	con = lsecond(op->args);
+	opno = op->opno;
+	if (IsA(var, Const) && IsA(con, Var))
+	{
+		var = lsecond(op->args);
+		con = linitial(op->args);
+		opno = get_commutator(opno);
+		if (!OidIsValid(opno))
+			return false;
+	}
+	if (!IsA(var, Var) || var->varattno <= 0 || var->varlevelsup != 0 ||
+		!IsA(con, Const) || con->constisnull)
+		return false;
+	/* integer family can be compared across types */
+	if (var->vartype != con->consttype &&
+		!((var->vartype == INT2OID ||
+		   var->vartype == INT4OID ||
+		   var->vartype == INT8OID) &&
+		  (con->consttype == INT2OID ||
+		   con->consttype == INT4OID ||
+		   con->consttype == INT8OID)))
+		return false;
+	if (!__zoneMapDatumGetInt64(var->vartype, (Datum) 0, &value) ||
+		!__zoneMapDatumGetInt64(con->consttype, con->constvalue, &value))
+		return false;
+	opclass = GetDefaultOpClass(var->vartype, BTREE_AM_OID);
+	if (!OidIsValid(opclass))
+		return false;
+	strategy = get_op_opfamily_strategy(opno, get_opclass_family(opclass));
+	switch (strategy)
+	{
+		case BTLessStrategyNumber:
+			if (value == PG_INT64_MIN)
+				return false;
+			*p_lower = PG_INT64_MIN;
+			*p_upper = value - 1;
+			break;
+		case BTLessEqualStrategyNumber:
+			*p_lower = PG_INT64_MIN;
+			*p_upper = value;
+			break;
+		case BTEqualStrategyNumber:
+			*p_lower = value;
+			*p_upper = value;
+			break;
+		case BTGreaterEqualStrategyNumber:
+			*p_lower = value;
+			*p_upper = PG_INT64_MAX;
+			break;
+		case BTGreaterStrategyNumber:
+			if (value == PG_INT64_MAX)
+				return false;
+			*p_lower = value + 1;
+			*p_upper = PG_INT64_MAX;
+			break;
+		default:
+			return false;
+	}
+	*p_attnum = var->varattno;
+	*p_atttypid = var->vartype;
+	return true;
+}
+
+/*
+ * __zoneMapRelationGeneration
+ */
+static uint64
+__zoneMapRelationGeneration(Relation relation)
+{
+	PgStat_StatTabEntry *tabentry;
+
+	tabentry = pgstat_fetch_stat_tabentry(RelationGetRelid(relation));
+	if (!tabentry)
+		return 0;
+	return (tabentry->tuples_inserted +
+			tabentry->tuples_updated +
+			tabentry->tuples_deleted +
+			tabentry->vacuum_count);
+}
+
+/*
+ * pgstromZoneMapExecInit
+ */
+void
+pgstromZoneMapExecInit(pgstromTaskState *pts)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	Relation	relation = pts->css.ss.ss_currentRelation;
+	ZoneMapState *zm_state;
+	AttrNumber	attnum = InvalidAttrNumber;
+	Oid			atttypid = InvalidOid;
+	int64		lower = PG_INT64_MIN;
+	int64		upper = PG_INT64_MAX;
+	ListCell   *lc;
+
+	/* only GPU-Direct SQL (KDS_FORMAT_BLOCK) path can use zone-map */
+	if (!zone_map_head || !pgstat_track_counts ||
+		bms_is_empty(pts->optimal_gpus) ||
+		pts->gcache_desc != NULL ||
+		pts->ds_entry != NULL)
+		return;
+	foreach (lc, pp_info->scan_quals)
+	{
+		AttrNumber	__attnum;
+		Oid			__atttypid;
+		int64		__lower;
+		int64		__upper;
+
+		if (!__zoneMapCheckOneQual((Expr *)lfirst(lc),
+								   &__attnum, &__atttypid,
+								   &__lower, &__upper))
+			continue;
+		if (attnum == InvalidAttrNumber)
+		{
+			attnum = __attnum;
+			atttypid = __atttypid;
+		}
+		else if (attnum != __attnum)
+			continue;
+		lower = Max(lower, __lower);
+		upper = Min(upper, __upper);
+	}
+	if (attnum == InvalidAttrNumber)
+		return;
+
+	zm_state = palloc0(sizeof(ZoneMapState));
+	zm_state->attnum = attnum;
+	zm_state->atttypid = atttypid;
+	zm_state->lower_bound = lower;
+	zm_state->upper_bound = upper;
+	zm_state->generation = __zoneMapRelationGeneration(relation);
+	zm_state->curr_key.database_oid = MyDatabaseId;
+	zm_state->curr_key.table_oid = RelationGetRelid(relation);
+	zm_state->curr_key.relfilenode = RelationGetForm(relation)->relfilenode;
+	zm_state->curr_key.attnum = attnum;
+	zm_state->curr_key.zone_id = InvalidBlockNumber;
+	pts->zm_state = zm_state;
+}
+
+/*
+ * __zoneMapLoadCurrentZone
+ */
+static void
+__zoneMapLoadCurrentZone(ZoneMapState *zm_state, BlockNumber block_num)
+{
+	BlockNumber	zone_id = block_num / ZONE_MAP_BLOCKS_PER_ZONE;
+	zoneMapEntry *entry;
+
+	if (zm_state->curr_valid &&
+		zm_state->curr_key.zone_id == zone_id)
+		return;
+	zm_state->curr_key.zone_id = zone_id;
+	LWLockAcquire(&zone_map_head->lock, LW_SHARED);
+	entry = hash_search(zone_map_head->hash,
+						&zm_state->curr_key,
+						HASH_FIND, NULL);
+	if (entry && entry->generation == zm_state->generation)
+		memcpy(&zm_state->curr_zone, entry, sizeof(zoneMapEntry));
+	else
+		memset(&zm_state->curr_zone, 0, sizeof(zoneMapEntry));
+	LWLockRelease(&zone_map_head->lock);
+	zm_state->curr_valid = true;
+}
+
+/*
+ * __zoneMapBlockIsSkipped
+ *
+ * It checks whether the block summary never matches the scan qualifiers.
+ * Caller must still confirm the block is all-visible.
+ */
+static bool
+__zoneMapBlockIsSkipped(ZoneMapState *zm_state, BlockNumber block_num)
+{
+	zoneMapEntry *zone = &zm_state->curr_zone;
+	uint32		mask = (1U << (block_num % ZONE_MAP_BLOCKS_PER_ZONE));
+
+	__zoneMapLoadCurrentZone(zm_state, block_num);
+	if ((zone->summarized & mask) == 0)
+		return false;
+	/* all NULLs never match strict operators */
+	if (!zone->has_values)
+		return true;
+	return (zone->max_value < zm_state->lower_bound ||
+			zone->min_value > zm_state->upper_bound);
+}
+
+/*
+ * __zoneMapSummarizeBlock
+ *
+ * It updates the zone-map using the all-visible page; caller must hold
+ * the buffer lock.
+ */
+static void
+__zoneMapSummarizeBlock(pgstromTaskState *pts,
+						BlockNumber block_num, Page page)
+{
+	ZoneMapState *zm_state = pts->zm_state;
+	Relation	relation = pts->css.ss.ss_currentRelation;
+	TupleDesc	tupdesc = RelationGetDescr(relation);
+	uint32		mask = (1U << (block_num % ZONE_MAP_BLOCKS_PER_ZONE));
+	int			lines = PageGetMaxOffsetNumber(page);
+	OffsetNumber lineoff;
+	ItemId		lpp;
+	bool		has_values = false;
+	int64		min_value = PG_INT64_MAX;
+	int64		max_value = PG_INT64_MIN;
+	zoneMapEntry *entry;
+	bool		found;
+
+	__zoneMapLoadCurrentZone(zm_state, block_num);
+	if ((zm_state->curr_zone.summarized & mask) != 0)
+		return;		/* already summarized */
+
+	for (lineoff = FirstOffsetNumber, lpp = PageGetItemId(page, lineoff);
+		 lineoff <= lines;
+		 lineoff++, lpp++)
+	{
+		HeapTupleData htup;
+		Datum		datum;
+		bool		isnull;
+		int64		value;
+
+		if (!ItemIdIsNormal(lpp))
+			continue;
+		htup.t_tableOid = RelationGetRelid(relation);
+		htup.t_data = (HeapTupleHeader) PageGetItem(page, lpp);
+		htup.t_len = ItemIdGetLength(lpp);
+		ItemPointerSet(&htup.t_self, block_num, lineoff);
+
+		datum = heap_getattr(&htup, zm_state->attnum, tupdesc, &isnull);
+		if (isnull ||
+			!__zoneMapDatumGetInt64(zm_state->atttypid, datum, &value))
+			continue;
+		min_value = Min(min_value, value);
+		max_value = Max(max_value, value);
+		has_values = true;
+	}
+
+	LWLockAcquire(&zone_map_head->lock, LW_EXCLUSIVE);
+	entry = hash_search(zone_map_head->hash,
+						&zm_state->curr_key,
+						HASH_ENTER_NULL, &found);
+	if (entry)
+	{
+		if (!found || entry->generation != zm_state->generation)
+		{
+			entry->generation = zm_state->generation;
+			entry->summarized = 0;
+			entry->has_values = false;
+		}
+		if (has_values)
+		{
+			if (!entry->has_values)
+			{
+				entry->min_value = min_value;
+				entry->max_value = max_value;
+			}
+			else
+			{
+				entry->min_value = Min(entry->min_value, min_value);
+				entry->max_value = Max(entry->max_value, max_value);
+			}
+			entry->has_values = true;
+		}
+		entry->summarized |= mask;
+		memcpy(&zm_state->curr_zone, entry, sizeof(zoneMapEntry));
+	}
+	LWLockRelease(&zone_map_head->lock);
+}
+
+/*
+ * pgstromZoneMapExplain
+ */
+void
+pgstromZoneMapExplain(pgstromTaskState *pts,
+					  List *dcontext,
+					  ExplainState *es)
+{
+	pgstromSharedState *ps_state = pts->ps_state;
+	ZoneMapState *zm_state = pts->zm_state;
+	Relation	relation = pts->css.ss.ss_currentRelation;
+	const char *attname;
+
+	attname = get_attname(RelationGetRelid(relation),
+						  zm_state->attnum, false);
+	if (es->analyze && es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		char	buf[NAMEDATALEN + 80];
+
+		snprintf(buf, sizeof(buf), "%s [skipped: %lu]",
+				 quote_identifier(attname),
+				 pg_atomic_read_u64(&ps_state->zone_map_skipped));
+		ExplainPropertyText("Zone-Map", buf, es);
+	}
+	else
+	{
+		ExplainPropertyText("Zone-Map", quote_identifier(attname), es);
+		if (es->analyze)
+			ExplainPropertyInteger("Zone-Map Skipped", NULL,
+								   pg_atomic_read_u64(&ps_state->zone_map_skipped),
+								   es);
+	}
+}
+
+/*
+ * pgstrom_request_zone_map
+ */
+static void
+pgstrom_request_zone_map(void)
+{
+	if (shmem_request_next)
+		shmem_request_next();
+	RequestAddinShmemSpace(MAXALIGN(sizeof(zoneMapSharedHead)) +
+						   hash_estimate_size(pgstrom_zone_map_max_entries,
+											  sizeof(zoneMapEntry)));
+}
+
+/*
+ * pgstrom_startup_zone_map
+ */
+static void
+pgstrom_startup_zone_map(void)
+{
+	HASHCTL		hctl;
+	bool		found;
+
+	if (shmem_startup_next)
+		(*shmem_startup_next)();
+
+	zone_map_head = ShmemInitStruct("pgstromZoneMap(head)",
+									MAXALIGN(sizeof(zoneMapSharedHead)),
+									&found);
+	Assert(!found);
+	LWLockInitialize(&zone_map_head->lock, LWLockNewTrancheId());
+
+	memset(&hctl, 0, sizeof(HASHCTL));
+	hctl.keysize = sizeof(zoneMapKey);
+	hctl.entrysize = sizeof(zoneMapEntry);
+	zone_map_head->hash = ShmemInitHash("pgstromZoneMap(hash)",
+										pgstrom_zone_map_max_entries,
+										pgstrom_zone_map_max_entries,
+										&hctl,
+										HASH_ELEM | HASH_BLOBS);
+}
+
+/* ----------------------------------------------------------------
+ *
+ * Routines to support TABLESAMPLE
+ *
+ * The built-in SYSTEM and BERNOULLI methods pick up the blocks or rows
+ * according to the hash value of the block-number (and line-offset)
+ * with the seed (see system_nextsampleblock and bernoulli_nextsampletuple).
+ * We reproduce the same logic; SYSTEM method skips the blocks on the host
+ * side prior to the DMA, and BERNOULLI method samples the rows on the GPU
+ * device when it fetches the rows from the heap blocks. So, GpuScan returns
+ * exactly the same rows SampleScan returns with the REPEATABLE seed.
+ *
+ * ----------------------------------------------------------------
+ */
+void
+pgstromTableSampleExecInit(pgstromTaskState *pts)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	double		dcutoff;
+
+	if (pp_info->tablesample_method == '\0')
+		return;
+	/* see system_beginsamplescan and bernoulli_beginsamplescan */
+	if (pp_info->tablesample_percent < 0.0 ||
+		pp_info->tablesample_percent > 100.0 ||
+		isnan(pp_info->tablesample_percent))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_TABLESAMPLE_ARGUMENT),
+				 errmsg("sample percentage must be between 0 and 100")));
+	dcutoff = rint(((double) PG_UINT32_MAX + 1) *
+				   pp_info->tablesample_percent / 100.0);
+	pts->tablesample_method = pp_info->tablesample_method;
+	pts->tablesample_cutoff = (uint64_t) dcutoff;
+	/* see tablesample_init */
+	if (pp_info->tablesample_repeatable)
+		pts->tablesample_seed =
+			DatumGetUInt32(DirectFunctionCall1(hashfloat8,
+											   Float8GetDatum(pp_info->tablesample_seed)));
+	else
+		pts->tablesample_seed = pg_prng_uint32(&pg_global_prng_state);
+}
+
+/*
+ * pgstromTableSampleBlock
+ *
+ * It returns false, if TABLESAMPLE SYSTEM does not sample the block.
+ */
+bool
+pgstromTableSampleBlock(pgstromTaskState *pts, BlockNumber block_num)
+{
+	uint32_t	hashinput[2];
+	uint32_t	hash;
+
+	if (pts->tablesample_method != KERN_TABLESAMPLE__SYSTEM)
+		return true;
+	hashinput[0] = block_num;
+	hashinput[1] = pts->tablesample_seed;
+	hash = DatumGetUInt32(hash_any((const unsigned char *) hashinput,
+								   (int) sizeof(hashinput)));
+	return (hash < pts->tablesample_cutoff);
+}
+
+/*
+ * pgstromTableSampleTuple
+ *
+ * It returns false, if TABLESAMPLE does not sample the row.
+ */
+bool
+pgstromTableSampleTuple(pgstromTaskState *pts,
+						BlockNumber block_num,
+						OffsetNumber lineoff)
+{
+	uint32_t	hashinput[3];
+	uint32_t	hash;
+
+	if (pts->tablesample_method != KERN_TABLESAMPLE__BERNOULLI)
+		return pgstromTableSampleBlock(pts, block_num);
+	hashinput[0] = block_num;
+	hashinput[1] = lineoff;
+	hashinput[2] = pts->tablesample_seed;
+	hash = DatumGetUInt32(hash_any((const unsigned char *) hashinput,
+								   (int) sizeof(hashinput)));
+	return (hash < pts->tablesample_cutoff);
+}
+
+/*
+ * pgstromTableSampleExplain
+ */
+void
+pgstromTableSampleExplain(pgstromTaskState *pts, ExplainState *es)
+{
+	pgstromPlanInfo *pp_info = pts->pp_info;
+	StringInfoData buf;
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "%s (%g%%)",
+					 pp_info->tablesample_method == KERN_TABLESAMPLE__SYSTEM
+					 ? "system" : "bernoulli",
+					 pp_info->tablesample_percent);
+	if (pp_info->tablesample_repeatable)
+		appendStringInfo(&buf, " REPEATABLE (%g)",
+						 pp_info->tablesample_seed);
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+		appendStringInfo(&buf, " [%s]",
+						 pp_info->tablesample_method == KERN_TABLESAMPLE__SYSTEM
+						 ? "blocks by host" : "rows by GPU");
+	ExplainPropertyText("Sampling", buf.data, es);
+	pfree(buf.data);
 }
 
 /* ----------------------------------------------------------------
@@ -475,6 +1219,8 @@ __relScanDirectFallbackBlock(pgstromTaskState *pts,
 
 		if (!ItemIdIsNormal(lpp))
 			continue;
+		if (!pgstromTableSampleTuple(pts, block_num, lineoff))
+			continue;
 
 		htup.t_tableOid = RelationGetRelid(relation);
 		htup.t_data = (HeapTupleHeader) PageGetItem((Page)page, lpp);
@@ -491,39 +1237,35 @@ __relScanDirectFallbackBlock(pgstromTaskState *pts,
 	pg_atomic_fetch_add_u64(&ps_state->npages_buffer_read, PAGES_PER_BLOCK);
 }
 
-static void
-__relScanDirectCachedBlock(pgstromTaskState *pts, BlockNumber block_num)
+/*
+ * relScanSharedBufferPins
+ *
+ * The shared buffers pinned by the backend during the GPU service loads
+ * them by DMA. They are released on the response with the same tag.
+ */
+typedef struct
+{
+	dlist_node	chain;
+	uint64_t	tag;
+	uint32_t	nitems;
+	Buffer		buffers[FLEXIBLE_ARRAY_MEMBER];
+} relScanSharedBufferPins;
+
+/*
+ * __relScanDirectCheckTuples
+ *
+ * It checks visibility of the tuples in the source page (spage), then
+ * invalidates the invisible items on the duplicated page (dpage) that
+ * may have only the page head. The caller must hold the share lock.
+ */
+static bool
+__relScanDirectCheckTuples(pgstromTaskState *pts, BlockNumber block_num,
+						   Buffer buffer, Page spage, Page dpage)
 {
 	Relation	relation = pts->css.ss.ss_currentRelation;
-	HeapScanDesc h_scan = (HeapScanDesc)pts->css.ss.ss_currentScanDesc;
 	Snapshot	snapshot = pts->css.ss.ps.state->es_snapshot;
-	kern_data_store *kds;
-	Buffer		buffer;
-	Page		spage;
-	Page		dpage;
 	bool		has_valid_tuples = false;
 
-	/*
-	 * Load the source buffer with synchronous read
-	 */
-	buffer = ReadBufferExtended(relation,
-								MAIN_FORKNUM,
-								block_num,
-								RBM_NORMAL,
-								h_scan->rs_strategy);
-	/* prune the old items, if any */
-	heap_page_prune_opt(relation, buffer);
-	/* let's check tuples visibility for each */
-	LockBuffer(buffer, BUFFER_LOCK_SHARE);
-	spage = (Page) BufferGetPage(buffer);
-	appendBinaryStringInfo(&pts->xcmd_buf, (const char *)spage, BLCKSZ);
-
-	kds = __XCMD_GET_KDS_SRC(&pts->xcmd_buf);
-	dpage = (Page) KDS_BLOCK_PGPAGE(kds, kds->block_nloaded);
-	Assert(dpage >= pts->xcmd_buf.data &&
-		   dpage + BLCKSZ <= pts->xcmd_buf.data + pts->xcmd_buf.len);
-	KDS_BLOCK_BLCKNR(kds, kds->block_nloaded) = block_num;
-
 	/*
 	 * Logic is almost equivalent as heapgetpage() doing.
 	 * We have to invalidate tuples prior to GPU kernel
@@ -566,7 +1308,47 @@ __relScanDirectCachedBlock(pgstromTaskState *pts, BlockNumber block_num)
 	else
 	{
 		has_valid_tuples = true;
+		/* all-visible page can be summarized on the zone-map */
+		if (pts->zm_state)
+			__zoneMapSummarizeBlock(pts, block_num, spage);
 	}
+	return has_valid_tuples;
+}
+
+static void
+__relScanDirectCachedBlock(pgstromTaskState *pts, BlockNumber block_num)
+{
+	Relation	relation = pts->css.ss.ss_currentRelation;
+	HeapScanDesc h_scan = (HeapScanDesc)pts->css.ss.ss_currentScanDesc;
+	kern_data_store *kds;
+	Buffer		buffer;
+	Page		spage;
+	Page		dpage;
+	bool		has_valid_tuples;
+
+	/*
+	 * Load the source buffer with synchronous read
+	 */
+	buffer = ReadBufferExtended(relation,
+								MAIN_FORKNUM,
+								block_num,
+								RBM_NORMAL,
+								h_scan->rs_strategy);
+	/* prune the old items, if any */
+	heap_page_prune_opt(relation, buffer);
+	/* let's check tuples visibility for each */
+	LockBuffer(buffer, BUFFER_LOCK_SHARE);
+	spage = (Page) BufferGetPage(buffer);
+	appendBinaryStringInfo(&pts->xcmd_buf, (const char *)spage, BLCKSZ);
+
+	kds = __XCMD_GET_KDS_SRC(&pts->xcmd_buf);
+	dpage = (Page) KDS_BLOCK_PGPAGE(kds, kds->block_nloaded);
+	Assert(dpage >= pts->xcmd_buf.data &&
+		   dpage + BLCKSZ <= pts->xcmd_buf.data + pts->xcmd_buf.len);
+	KDS_BLOCK_BLCKNR(kds, kds->block_nloaded) = block_num;
+
+	has_valid_tuples = __relScanDirectCheckTuples(pts, block_num,
+												  buffer, spage, dpage);
 	UnlockReleaseBuffer(buffer);
 
 	/*
@@ -576,13 +1358,92 @@ __relScanDirectCachedBlock(pgstromTaskState *pts, BlockNumber block_num)
 	 */
 	if (!has_valid_tuples)
 	{
-		pts->xcmd_buf.len -= BLCKSZ;
+		pts->xcmd_buf.len -= BLCKSZ;
+		return;
+	}
+	/* dpage became all-visible also */
+	PageSetAllVisible(dpage);
+	kds->nitems++;
+	kds->block_nloaded++;
+}
+
+/*
+ * __relScanDirectSharedBlock
+ *
+ * It is equivalent to __relScanDirectCachedBlock, but the page is not
+ * copied to the command buffer. The GPU service loads the page from the
+ * shared buffer by DMA, then overwrites the page head captured here.
+ * The buffer is kept pinned, so nobody can prune or defragment the page
+ * (it requires the cleanup lock), thus the visible tuples are stable.
+ */
+static void
+__relScanDirectSharedBlock(pgstromTaskState *pts, BlockNumber block_num,
+						   relScanSharedBufferPins *shbuf_pins,
+						   char *shbuf_heads,
+						   BlockNumber *shbuf_blknums)
+{
+	Relation	relation = pts->css.ss.ss_currentRelation;
+	HeapScanDesc h_scan = (HeapScanDesc)pts->css.ss.ss_currentScanDesc;
+	kern_data_store *kds = __XCMD_GET_KDS_SRC(&pts->xcmd_buf);
+	Buffer		buffer;
+	Page		spage;
+	Page		dpage;
+	bool		has_valid_tuples;
+
+	buffer = ReadBufferExtended(relation,
+								MAIN_FORKNUM,
+								block_num,
+								RBM_NORMAL,
+								h_scan->rs_strategy);
+	/* prune the old items, if any */
+	heap_page_prune_opt(relation, buffer);
+	/* let's check tuples visibility for each */
+	LockBuffer(buffer, BUFFER_LOCK_SHARE);
+	spage = (Page) BufferGetPage(buffer);
+	dpage = (Page) (shbuf_heads + KDS_SHBUF_HEAD_SZ * shbuf_pins->nitems);
+	memcpy(dpage, spage, KDS_SHBUF_HEAD_SZ);
+	has_valid_tuples = __relScanDirectCheckTuples(pts, block_num,
+												  buffer, spage, dpage);
+	LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
+	if (!has_valid_tuples)
+	{
+		ReleaseBuffer(buffer);
 		return;
 	}
 	/* dpage became all-visible also */
 	PageSetAllVisible(dpage);
+	shbuf_blknums[shbuf_pins->nitems] = block_num;
+	shbuf_pins->buffers[shbuf_pins->nitems++] = buffer;
 	kds->nitems++;
-	kds->block_nloaded++;
+}
+
+/*
+ * pgstromRelScanReleaseSharedBuffers
+ *
+ * It releases the shared buffers pinned for the chunk with the tag, or
+ * all the pinned buffers if tag == 0.
+ */
+void
+pgstromRelScanReleaseSharedBuffers(pgstromTaskState *pts, uint64_t shbuf_tag)
+{
+	dlist_mutable_iter iter;
+
+	dlist_foreach_modify(iter, &pts->shbuf_pins_list)
+	{
+		relScanSharedBufferPins *shbuf_pins
+			= dlist_container(relScanSharedBufferPins, chain, iter.cur);
+
+		if (shbuf_tag != 0 && shbuf_pins->tag != shbuf_tag)
+			continue;
+		for (uint32_t i=0; i < shbuf_pins->nitems; i++)
+			ReleaseBuffer(shbuf_pins->buffers[i]);
+		Assert(pts->shbuf_npinned >= shbuf_pins->nitems);
+		pts->shbuf_npinned -= shbuf_pins->nitems;
+		dlist_delete(&shbuf_pins->chain);
+		pfree(shbuf_pins);
+		if (shbuf_tag != 0)
+			break;
+	}
 }
 
 static bool
@@ -632,11 +1493,19 @@ pgstromRelScanChunkDirect(pgstromTaskState *pts,
 	uint32_t		strom_nblocks = 0;
 	uint32_t		kds_src_pathname = 0;
 	uint32_t		kds_src_iovec = 0;
+	uint32_t		kds_src_shbufs = 0;
 	uint32_t		kds_nrooms;
+	uint32_t		nblocks_cpu = 0;
+	relScanSharedBufferPins *shbuf_pins = NULL;
+	char		   *shbuf_heads = NULL;
+	BlockNumber	   *shbuf_blknums;
+	uint32_t		shbuf_limit = 0;
 
 	kds = __XCMD_GET_KDS_SRC(&pts->xcmd_buf);
 	kds_nrooms = (PGSTROM_CHUNK_SIZE -
 				  KDS_HEAD_LENGTH(kds)) / (sizeof(BlockNumber) + BLCKSZ);
+	if (pts->chunk_nblocks > 0)
+		kds_nrooms = Min(kds_nrooms, pts->chunk_nblocks);
 	kds->nitems  = 0;
 	kds->usage   = 0;
 	kds->block_offset = (KDS_HEAD_LENGTH(kds) +
@@ -651,6 +1520,21 @@ pgstromRelScanChunkDirect(pgstromTaskState *pts,
 	strom_iovec->nr_chunks = 0;
 	strom_blknums = alloca(sizeof(BlockNumber) * kds_nrooms);
 	strom_nblocks = 0;
+	/*
+	 * The cached pages may be loaded by DMA from the shared buffers, if
+	 * GPU service registered them. The number of buffers pinned by a scan
+	 * is limited, not to starve the buffer replacement.
+	 */
+	shbuf_blknums = alloca(sizeof(BlockNumber) * kds_nrooms);
+	if (!pts->ds_entry &&
+		!RelationUsesLocalBuffers(relation) &&
+		gpuServiceSharedBuffersDMA())
+	{
+		uint32_t	limit = NBuffers / (4 * MaxBackends);
+
+		if (pts->shbuf_npinned < limit)
+			shbuf_limit = Min(limit - pts->shbuf_npinned, kds_nrooms);
+	}
 	while (!pts->scan_done)
 	{
 		while (pts->curr_block_num < pts->curr_block_tail &&
@@ -658,6 +1542,27 @@ pgstromRelScanChunkDirect(pgstromTaskState *pts,
 		{
 			BlockNumber		block_num
 				= (pts->curr_block_num + h_scan->rs_startblock) % h_scan->rs_nblocks;
+			/* TABLESAMPLE SYSTEM never loads the blocks not sampled */
+			if (!pgstromTableSampleBlock(pts, block_num))
+			{
+				pts->curr_block_num++;
+				continue;
+			}
+			/*
+			 * Adaptive execution: the blocks are processed by CPU, if most
+			 * of rows fell back by the device. A round is limited to the
+			 * length of chunk, to return the tuples to the caller.
+			 */
+			if (pts->adaptive_cpu_mode)
+			{
+				if (nblocks_cpu >= kds_nrooms)
+					goto out;
+				__relScanDirectFallbackBlock(pts, kds, block_num);
+				pg_atomic_fetch_add_u64(&ps_state->adaptive_cpu_blocks, 1);
+				nblocks_cpu++;
+				pts->curr_block_num++;
+				continue;
+			}
 			/*
 			 * MEMO: Usually, CPU is (much) more powerful than DPUs.
 			 * In case when the source cache is already on the shared-
@@ -687,17 +1592,31 @@ pgstromRelScanChunkDirect(pgstromTaskState *pts,
 				}
 				LWLockRelease(bufLock);
 			}
-			
+
+			/*
+			 * Skip the block if zone-map tells us it never matches the scan
+			 * qualifiers, as long as the block is not modified since then.
+			 */
+			if (pts->zm_state &&
+				__zoneMapBlockIsSkipped(pts->zm_state, block_num) &&
+				VM_ALL_VISIBLE(relation, block_num, &pts->curr_vm_buffer))
+			{
+				pg_atomic_fetch_add_u64(&ps_state->zone_map_skipped, 1);
+				pts->curr_block_num++;
+				continue;
+			}
+
 			/*
-			 * MEMO: right now, we allow GPU Direct SQL for the all-visible
-			 * pages only, due to the restrictions about MVCC checks.
-			 * However, it is too strict for the purpose. If we would have
-			 * a mechanism to perform MVCC checks without commit logs.
-			 * In other words, if all the tuples in a certain page have
-			 * HEAP_XMIN_* or HEAP_XMAX_* flags correctly, we can have MVCC
-			 * logic in the device code.
+			 * MEMO: GPU Direct SQL loads the all-visible pages, or any
+			 * pages if GPU checks MVCC visibility of the tuples using
+			 * the HEAP_XMIN_* / HEAP_XMAX_* hint bits and the snapshot
+			 * (see pgstromRelScanDirectMVCCEnabled). The tuples whose
+			 * visibility is not determined by the hint bits are handled
+			 * by the CPU fallback.
+			 * In both cases, the page on the storage must be up-to-date.
 			 */
-			if (VM_ALL_VISIBLE(relation, block_num, &pts->curr_vm_buffer) &&
+			if ((pts->gpu_direct_mvcc ||
+				 VM_ALL_VISIBLE(relation, block_num, &pts->curr_vm_buffer)) &&
 				__relScanDirectCheckBufferClean(smgr, block_num))
 			{
 				/*
@@ -741,6 +1660,22 @@ pgstromRelScanChunkDirect(pgstromTaskState *pts,
 				 */
 				__relScanDirectFallbackBlock(pts, kds, block_num);
 			}
+			else if (shbuf_limit > 0 &&
+					 (!shbuf_pins || shbuf_pins->nitems < shbuf_limit))
+			{
+				if (!shbuf_pins)
+				{
+					MemoryContext	memcxt = pts->css.ss.ps.state->es_query_cxt;
+
+					shbuf_pins = MemoryContextAllocZero(memcxt,
+						offsetof(relScanSharedBufferPins, buffers[shbuf_limit]));
+					shbuf_heads = palloc(KDS_SHBUF_HEAD_SZ * shbuf_limit);
+				}
+				__relScanDirectSharedBlock(pts, block_num,
+										   shbuf_pins,
+										   shbuf_heads,
+										   shbuf_blknums);
+			}
 			else
 			{
 				__relScanDirectCachedBlock(pts, block_num);
@@ -818,6 +1753,14 @@ pgstromRelScanChunkDirect(pgstromTaskState *pts,
 		}
 	}
 out:
+	/* pages on the shared buffers follow the pages on the command buffer */
+	if (shbuf_pins && shbuf_pins->nitems > 0)
+	{
+		memcpy(&KDS_BLOCK_BLCKNR(kds, kds->block_nloaded),
+			   shbuf_blknums,
+			   sizeof(BlockNumber) * shbuf_pins->nitems);
+		kds->block_nloaded += shbuf_pins->nitems;
+	}
 	Assert(kds->nitems == kds->block_nloaded + strom_nblocks);
 	pg_atomic_fetch_add_u64(&ps_state->npages_buffer_read,
 							kds->block_nloaded * PAGES_PER_BLOCK);
@@ -850,9 +1793,38 @@ out:
 	{
 		Assert(segment_id == InvalidBlockNumber);
 	}
+
+	if (shbuf_pins)
+	{
+		if (shbuf_pins->nitems > 0)
+		{
+			kern_shbuf_vector *shbufs;
+			uint32_t	nitems = shbuf_pins->nitems;
+
+			kds_src_shbufs = __appendZeroStringInfo(&pts->xcmd_buf,
+				MAXALIGN(offsetof(kern_shbuf_vector, buf_id[nitems])));
+			shbufs = (kern_shbuf_vector *)(pts->xcmd_buf.data + kds_src_shbufs);
+			shbuf_pins->tag = ++pts->shbuf_last_tag;
+			shbufs->tag = shbuf_pins->tag;
+			shbufs->nitems = nitems;
+			for (uint32_t i=0; i < nitems; i++)
+				shbufs->buf_id[i] = shbuf_pins->buffers[i] - 1;
+			appendBinaryStringInfo(&pts->xcmd_buf, shbuf_heads,
+								   KDS_SHBUF_HEAD_SZ * nitems);
+			/* pinned until the response */
+			dlist_push_tail(&pts->shbuf_pins_list, &shbuf_pins->chain);
+			pts->shbuf_npinned += nitems;
+		}
+		else
+		{
+			pfree(shbuf_pins);
+		}
+		pfree(shbuf_heads);
+	}
 	xcmd = (XpuCommand *)pts->xcmd_buf.data;
 	xcmd->u.task.kds_src_pathname = kds_src_pathname;
 	xcmd->u.task.kds_src_iovec = kds_src_iovec;
+	xcmd->u.task.kds_src_shbufs = kds_src_shbufs;
 	xcmd->length = pts->xcmd_buf.len;
 
 	xcmd_iov[0].iov_base = xcmd;
@@ -862,6 +1834,57 @@ out:
 	return xcmd;
 }
 
+/*
+ * pgstromRelScanDirectMVCCEnabled
+ *
+ * It checks whether GPU can check MVCC visibility of the heap pages that
+ * are not all-visible, to load them by GPU-Direct SQL.
+ * The snapshot must be a regular MVCC snapshot; not taken during the
+ * recovery, and no need to track read-write conflicts of SERIALIZABLE.
+ * DPU handles these pages by CPU fallback, as before.
+ */
+bool
+pgstromRelScanDirectMVCCEnabled(pgstromTaskState *pts)
+{
+	Snapshot	snapshot = pts->css.ss.ps.state->es_snapshot;
+
+	return (pgstrom_gpudirect_mvcc_check &&
+			!pts->ds_entry &&
+			!bms_is_empty(pts->optimal_gpus) &&
+			IsMVCCSnapshot(snapshot) &&
+			!snapshot->takenDuringRecovery &&
+			!IsolationIsSerializable());
+}
+
+/*
+ * pgstromRelScanCpuDirect
+ *
+ * It scans the heap blocks by CPU using the fallback expressions, without
+ * any GPU/DPU sessions, when the relation is tiny at the execution time
+ * (see pg_strom.cpu_direct_scan_threshold). Only single process scan.
+ */
+TupleTableSlot *
+pgstromRelScanCpuDirect(pgstromTaskState *pts)
+{
+	HeapScanDesc	h_scan = (HeapScanDesc)pts->css.ss.ss_currentScanDesc;
+	TupleTableSlot *slot;
+
+	Assert(!h_scan->rs_base.rs_parallel);
+	if (!h_scan->rs_inited)
+	{
+		h_scan->rs_cblock = 0;
+		h_scan->rs_inited = true;
+	}
+	for (;;)
+	{
+		slot = pgstromFetchFallbackTuple(pts);
+		if (slot || h_scan->rs_cblock >= h_scan->rs_nblocks)
+			return slot;
+		__relScanDirectFallbackBlock(pts, NULL, h_scan->rs_cblock++);
+		CHECK_FOR_INTERRUPTS();
+	}
+}
+
 static bool
 __kds_row_insert_tuple(kern_data_store *kds, TupleTableSlot *slot)
 {
@@ -893,6 +1916,55 @@ __kds_row_insert_tuple(kern_data_store *kds, TupleTableSlot *slot)
 	return true;
 }
 
+/*
+ * __relScanChunkRowSetupIOV
+ *
+ * It sets up iovec of the KDS_FORMAT_ROW chunk, that may skip the hole
+ * between row-index and tuples-buffer.
+ */
+static XpuCommand *
+__relScanChunkRowSetupIOV(pgstromTaskState *pts, kern_data_store *kds,
+						  struct iovec *xcmd_iov, int *xcmd_iovcnt)
+{
+	XpuCommand	   *xcmd;
+	size_t			sz1, sz2;
+
+	if (kds->nitems == 0)
+		return NULL;
+
+	sz1 = ((KDS_BODY_ADDR(kds) - pts->xcmd_buf.data) +
+		   MAXALIGN(sizeof(uint32_t) * kds->nitems));
+	sz2 = __kds_unpack(kds->usage);
+	Assert(sz1 + sz2 <= pts->xcmd_buf.len);
+	kds->length = (KDS_HEAD_LENGTH(kds) +
+				   MAXALIGN(sizeof(uint32_t) * kds->nitems) + sz2);
+	xcmd = (XpuCommand *)pts->xcmd_buf.data;
+	xcmd->length = sz1 + sz2;
+	xcmd_iov[0].iov_base = xcmd;
+	xcmd_iov[0].iov_len  = sz1;
+	xcmd_iov[1].iov_base = (pts->xcmd_buf.data + pts->xcmd_buf.len - sz2);
+	xcmd_iov[1].iov_len  = sz2;
+	*xcmd_iovcnt = 2;
+
+	return xcmd;
+}
+
+/*
+ * __relScanTableSampleSlot
+ *
+ * Normal heap scan samples the rows on the host side, before the rows
+ * are packed into KDS_FORMAT_ROW.
+ */
+static inline bool
+__relScanTableSampleSlot(pgstromTaskState *pts, TupleTableSlot *slot)
+{
+	if (pts->tablesample_method == '\0')
+		return true;
+	return pgstromTableSampleTuple(pts,
+								   ItemPointerGetBlockNumber(&slot->tts_tid),
+								   ItemPointerGetOffsetNumber(&slot->tts_tid));
+}
+
 XpuCommand *
 pgstromRelScanChunkNormal(pgstromTaskState *pts,
 						  struct iovec *xcmd_iov, int *xcmd_iovcnt)
@@ -901,8 +1973,6 @@ pgstromRelScanChunkNormal(pgstromTaskState *pts,
 	TableScanDesc	scan = pts->css.ss.ss_currentScanDesc;
 	TupleTableSlot *slot = pts->base_slot;
 	kern_data_store *kds;
-	XpuCommand	   *xcmd;
-	size_t			sz1, sz2;
 
 	pts->xcmd_buf.len = __XCMD_KDS_SRC_OFFSET(&pts->xcmd_buf) + PGSTROM_CHUNK_SIZE;
 	enlargeStringInfo(&pts->xcmd_buf, 0);
@@ -934,6 +2004,8 @@ pgstromRelScanChunkNormal(pgstromTaskState *pts,
 				break;
 			if (!table_scan_bitmap_next_tuple(scan, pts->curr_tbm, slot))
 				pts->curr_tbm = NULL;
+			else if (!__relScanTableSampleSlot(pts, slot))
+				ExecClearTuple(slot);
 			else if (!__kds_row_insert_tuple(kds, slot))
 				break;
 		}
@@ -951,34 +2023,317 @@ pgstromRelScanChunkNormal(pgstromTaskState *pts,
 				pts->scan_done = true;
 				break;
 			}
-			if (!__kds_row_insert_tuple(kds, slot))
+			if (!__relScanTableSampleSlot(pts, slot))
+				ExecClearTuple(slot);
+			else if (!__kds_row_insert_tuple(kds, slot))
 				break;
 		}
 	}
 
-	if (kds->nitems == 0)
-		return NULL;
+	return __relScanChunkRowSetupIOV(pts, kds, xcmd_iov, xcmd_iovcnt);
+}
 
-	/* setup iovec that may skip the hole between row-index and tuples-buffer */
-	sz1 = ((KDS_BODY_ADDR(kds) - pts->xcmd_buf.data) +
-		   MAXALIGN(sizeof(uint32_t) * kds->nitems));
-	sz2 = __kds_unpack(kds->usage);
-	Assert(sz1 + sz2 <= pts->xcmd_buf.len);
-	kds->length = (KDS_HEAD_LENGTH(kds) +
-				   MAXALIGN(sizeof(uint32_t) * kds->nitems) + sz2);
-	xcmd = (XpuCommand *)pts->xcmd_buf.data;
-	xcmd->length = sz1 + sz2;
-	xcmd_iov[0].iov_base = xcmd;
-	xcmd_iov[0].iov_len  = sz1;
-	xcmd_iov[1].iov_base = (pts->xcmd_buf.data + pts->xcmd_buf.len - sz2);
-	xcmd_iov[1].iov_len  = sz2;
-	*xcmd_iovcnt = 2;
+/* ----------------------------------------------------------------
+ *
+ * Routines to scan file_fdw foreign tables
+ *
+ * Rows of CSV/text files are parsed by the COPY FROM infrastructure on
+ * the host side, then packed into KDS_FORMAT_ROW chunks, so the scan
+ * qualifiers are evaluated by GPU and only matched rows are returned.
+ *
+ * ----------------------------------------------------------------
+ */
+struct FileFdwState
+{
+	char	   *filename;		/* filename or command */
+	bool		is_program;
+	List	   *options;		/* COPY options */
+	CopyFromState cstate;		/* NULL, if not opened yet */
+	MemoryContext tmpcxt;		/* per-row memory of NextCopyFrom */
+};
 
-	return xcmd;
+/*
+ * __foreignServerIsFileFdw
+ */
+static bool
+__foreignServerIsFileFdw(Oid serverid)
+{
+	ForeignServer *server = GetForeignServer(serverid);
+	ForeignDataWrapper *fdw = GetForeignDataWrapper(server->fdwid);
+	char	   *fname;
+
+	if (!OidIsValid(fdw->fdwhandler))
+		return false;
+	fname = get_func_name(fdw->fdwhandler);
+	return (fname != NULL && strcmp(fname, "file_fdw_handler") == 0);
+}
+
+/*
+ * baseRelIsFileFdw
+ */
+bool
+baseRelIsFileFdw(RelOptInfo *baserel)
+{
+	if ((baserel->reloptkind == RELOPT_BASEREL ||
+		 baserel->reloptkind == RELOPT_OTHER_MEMBER_REL) &&
+		baserel->rtekind == RTE_RELATION &&
+		OidIsValid(baserel->serverid))
+		return __foreignServerIsFileFdw(baserel->serverid);
+	return false;
+}
+
+/*
+ * RelationIsFileFdw
+ */
+bool
+RelationIsFileFdw(Relation frel)
+{
+	if (RelationGetForm(frel)->relkind == RELKIND_FOREIGN_TABLE)
+	{
+		Oid		serverid = GetForeignServerIdByRelId(RelationGetRelid(frel));
+
+		return __foreignServerIsFileFdw(serverid);
+	}
+	return false;
+}
+
+/*
+ * __fileFdwGetOptions
+ *
+ * It collects the COPY options in the same manner as file_fdw doing.
+ */
+static void
+__fileFdwGetOptions(Relation frel, FileFdwState *file_state)
+{
+	Oid			relid = RelationGetRelid(frel);
+	TupleDesc	tupdesc = RelationGetDescr(frel);
+	ForeignTable *table = GetForeignTable(relid);
+	ForeignServer *server = GetForeignServer(table->serverid);
+	ForeignDataWrapper *wrapper = GetForeignDataWrapper(server->fdwid);
+	List	   *options = NIL;
+	List	   *fnncolumns = NIL;
+	List	   *fncolumns = NIL;
+	ListCell   *lc;
+
+	options = list_concat(options, wrapper->options);
+	options = list_concat(options, server->options);
+	options = list_concat(options, table->options);
+	/* per-column options are converted to the COPY options */
+	for (int j=0; j < tupdesc->natts; j++)
+	{
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, j);
+
+		if (attr->attisdropped)
+			continue;
+		foreach (lc, GetForeignColumnOptions(relid, attr->attnum))
+		{
+			DefElem	   *def = lfirst(lc);
+			char	   *attname = pstrdup(NameStr(attr->attname));
+
+			if (strcmp(def->defname, "force_not_null") == 0)
+			{
+				if (defGetBoolean(def))
+					fnncolumns = lappend(fnncolumns, makeString(attname));
+			}
+			else if (strcmp(def->defname, "force_null") == 0)
+			{
+				if (defGetBoolean(def))
+					fncolumns = lappend(fncolumns, makeString(attname));
+			}
+		}
+	}
+	if (fnncolumns != NIL)
+		options = lappend(options, makeDefElem("force_not_null",
+											   (Node *)fnncolumns, -1));
+	if (fncolumns != NIL)
+		options = lappend(options, makeDefElem("force_null",
+											   (Node *)fncolumns, -1));
+	/* separate out the filename or program option */
+	foreach (lc, options)
+	{
+		DefElem	   *def = lfirst(lc);
+
+		if (strcmp(def->defname, "filename") == 0)
+		{
+			file_state->filename = defGetString(def);
+			options = foreach_delete_current(options, lc);
+		}
+		else if (strcmp(def->defname, "program") == 0)
+		{
+			file_state->filename = defGetString(def);
+			file_state->is_program = true;
+			options = foreach_delete_current(options, lc);
+		}
+	}
+	if (!file_state->filename)
+		elog(ERROR, "either filename or program is required for file_fdw foreign table '%s'",
+			 RelationGetRelationName(frel));
+	file_state->options = options;
+}
+
+/*
+ * pgstromFileFdwExecInit
+ */
+bool
+pgstromFileFdwExecInit(pgstromTaskState *pts)
+{
+	Relation	frel = pts->css.ss.ss_currentRelation;
+	FileFdwState *file_state;
+
+	if (!RelationIsFileFdw(frel))
+		return false;
+	file_state = palloc0(sizeof(FileFdwState));
+	__fileFdwGetOptions(frel, file_state);
+	file_state->tmpcxt = AllocSetContextCreate(CurrentMemoryContext,
+											   "file_fdw per-row context",
+											   ALLOCSET_DEFAULT_SIZES);
+	/* COPY FROM state shall be opened on the first chunk */
+	pts->file_state = file_state;
+	return true;
+}
+
+/*
+ * pgstromScanChunkFileFdw
+ */
+XpuCommand *
+pgstromScanChunkFileFdw(pgstromTaskState *pts,
+						struct iovec *xcmd_iov, int *xcmd_iovcnt)
+{
+	FileFdwState   *file_state = pts->file_state;
+	EState		   *estate = pts->css.ss.ps.state;
+	ExprContext	   *econtext = pts->css.ss.ps.ps_ExprContext;
+	TupleTableSlot *slot = pts->base_slot;
+	kern_data_store *kds;
+	MemoryContext	oldcxt;
+
+	if (!file_state->cstate)
+	{
+		oldcxt = MemoryContextSwitchTo(estate->es_query_cxt);
+		file_state->cstate = BeginCopyFrom(NULL,
+										   pts->css.ss.ss_currentRelation,
+										   NULL,
+										   file_state->filename,
+										   file_state->is_program,
+										   NULL,
+										   NIL,
+										   file_state->options);
+		MemoryContextSwitchTo(oldcxt);
+	}
+	pts->xcmd_buf.len = __XCMD_KDS_SRC_OFFSET(&pts->xcmd_buf) + PGSTROM_CHUNK_SIZE;
+	enlargeStringInfo(&pts->xcmd_buf, 0);
+	kds = __XCMD_GET_KDS_SRC(&pts->xcmd_buf);
+	kds->nitems = 0;
+	kds->usage  = 0;
+	kds->length = PGSTROM_CHUNK_SIZE;
+
+	while (!pts->scan_done)
+	{
+		bool	found;
+
+		/* the row that did not fit the previous chunk */
+		if (!TTS_EMPTY(slot) &&
+			!__kds_row_insert_tuple(kds, slot))
+			break;
+		MemoryContextReset(file_state->tmpcxt);
+		oldcxt = MemoryContextSwitchTo(file_state->tmpcxt);
+		found = NextCopyFrom(file_state->cstate, econtext,
+							 slot->tts_values,
+							 slot->tts_isnull);
+		MemoryContextSwitchTo(oldcxt);
+		if (!found)
+		{
+			pts->scan_done = true;
+			break;
+		}
+		ExecStoreVirtualTuple(slot);
+		if (!__kds_row_insert_tuple(kds, slot))
+			break;
+	}
+	return __relScanChunkRowSetupIOV(pts, kds, xcmd_iov, xcmd_iovcnt);
+}
+
+/*
+ * pgstromFileFdwExecReset
+ */
+void
+pgstromFileFdwExecReset(pgstromTaskState *pts)
+{
+	FileFdwState   *file_state = pts->file_state;
+
+	if (file_state->cstate)
+	{
+		EndCopyFrom(file_state->cstate);
+		file_state->cstate = NULL;
+	}
+	ExecClearTuple(pts->base_slot);
+	MemoryContextReset(file_state->tmpcxt);
+}
+
+/*
+ * pgstromFileFdwExecEnd
+ */
+void
+pgstromFileFdwExecEnd(pgstromTaskState *pts)
+{
+	FileFdwState   *file_state = pts->file_state;
+
+	if (file_state->cstate)
+		EndCopyFrom(file_state->cstate);
+	MemoryContextDelete(file_state->tmpcxt);
+}
+
+/*
+ * pgstromFileFdwExplain
+ */
+void
+pgstromFileFdwExplain(pgstromTaskState *pts, ExplainState *es)
+{
+	FileFdwState   *file_state = pts->file_state;
+
+	if (file_state->is_program)
+		ExplainPropertyText("Foreign Program", file_state->filename, es);
+	else
+	{
+		ExplainPropertyText("Foreign File", file_state->filename, es);
+		if (es->verbose)
+		{
+			struct stat	stat_buf;
+
+			if (stat(file_state->filename, &stat_buf) == 0)
+				ExplainPropertyInteger("Foreign File Size", "b",
+									   (int64) stat_buf.st_size, es);
+		}
+	}
 }
 
 void
 pgstrom_init_relscan(void)
 {
-	/* nothing to do */
+	/* pg_strom.gpudirect_mvcc_check */
+	DefineCustomBoolVariable("pg_strom.gpudirect_mvcc_check",
+							 "Enables GPU to check MVCC visibility of the pages loaded by GPU-Direct SQL",
+							 NULL,
+							 &pgstrom_gpudirect_mvcc_check,
+							 true,
+							 PGC_USERSET,
+							 GUC_NOT_IN_SAMPLE,
+							 NULL, NULL, NULL);
+	/* pg_strom.zone_map_max_entries */
+	DefineCustomIntVariable("pg_strom.zone_map_max_entries",
+							"Max number of zone-map entries on the shared memory",
+							"Zone-map is disabled, if 0",
+							&pgstrom_zone_map_max_entries,
+							0,
+							0,
+							INT_MAX / 2,
+							PGC_POSTMASTER,
+							GUC_NOT_IN_SAMPLE,
+							NULL, NULL, NULL);
+	if (pgstrom_zone_map_max_entries > 0)
+	{
+		shmem_request_next = shmem_request_hook;
+		shmem_request_hook = pgstrom_request_zone_map;
+		shmem_startup_next = shmem_startup_hook;
+		shmem_startup_hook = pgstrom_startup_zone_map;
+	}
 }
@@ -2,3 +2,284 @@
 --- PG-Strom v5.0 -> v5.1 (minor changes)
 ---
 ALTER FUNCTION pgstrom.abs(pg_catalog.int1) SET SCHEMA pg_catalog;
+
+-- Hit/Miss counter of the GPU module cache
+CREATE TYPE pgstrom.__gpu_module_cache_info AS (
+  cache_hits    int8,
+  cache_misses  int8
+);
+CREATE FUNCTION pgstrom.gpu_module_cache_info()
+  RETURNS pgstrom.__gpu_module_cache_info
+  AS 'MODULE_PATHNAME','pgstrom_gpu_module_cache_info'
+  LANGUAGE C STRICT;
+CREATE VIEW pgstrom.gpu_module_cache_info AS
+  SELECT * FROM pgstrom.gpu_module_cache_info();
+
+-- progress of GpuCache compaction
+DROP VIEW IF EXISTS pgstrom.gpucache_info;
+DROP FUNCTION IF EXISTS pgstrom.__pgstrom_gpucache_info();
+DROP TYPE IF EXISTS pgstrom.__pgstrom_gpucache_info_t;
+CREATE TYPE pgstrom.__pgstrom_gpucache_info_t AS (
+    database_oid        oid,
+    database_name       text,
+    table_oid           oid,
+    table_name          text,
+    signature           int8,
+    phase               text,
+    rowid_num_used      int8,
+    rowid_num_free      int8,
+    gpu_main_sz         int8,
+    gpu_main_nitems     int8,
+    gpu_extra_sz        int8,
+    gpu_extra_usage     int8,
+    gpu_extra_dead      int8,
+    redo_write_ts       timestamptz,
+    redo_write_nitems   int8,
+    redo_write_pos      int8,
+    redo_read_nitems    int8,
+    redo_read_pos       int8,
+    redo_sync_pos       int8,
+    config_options      text,
+    compaction_pos      int8,
+    compaction_nitems   int8,
+    compaction_count    int8
+);
+CREATE FUNCTION pgstrom.__pgstrom_gpucache_info()
+  RETURNS SETOF pgstrom.__pgstrom_gpucache_info_t
+  AS 'MODULE_PATHNAME','pgstrom_gpucache_info'
+  LANGUAGE C STRICT;
+CREATE VIEW pgstrom.gpucache_info AS
+  SELECT * FROM pgstrom.__pgstrom_gpucache_info();
+
+-- group states of the GpuCache summary ('summary_key' option)
+CREATE TYPE pgstrom.__gpucache_summary_t AS (
+  key                 int8,
+  nitems              int8,
+  nvalids             int8[],
+  sums                numeric[]
+);
+CREATE FUNCTION pgstrom.gpucache_summary(regclass)
+  RETURNS SETOF pgstrom.__gpucache_summary_t
+  AS 'MODULE_PATHNAME','pgstrom_gpucache_summary'
+  LANGUAGE C STRICT;
+
+-- device memory usage of the sessions on the GPU service
+CREATE TYPE pgstrom.__gpu_session_info AS (
+  pid             int4,
+  gpu_id          int4,
+  plan_node_id    int4,
+  mem_usage       int8,
+  mem_peak        int8,
+  mem_quota       int8,
+  admission_wait  float8
+);
+CREATE FUNCTION pgstrom.gpu_session_info()
+  RETURNS SETOF pgstrom.__gpu_session_info
+  AS 'MODULE_PATHNAME','pgstrom_gpu_session_info'
+  LANGUAGE C STRICT;
+CREATE VIEW pgstrom.gpu_session_info AS
+  SELECT * FROM pgstrom.gpu_session_info();
+
+-- statistics of the GPU service per device
+CREATE TYPE pgstrom.__gpu_service_stats AS (
+  gpu_id              int4,
+  active_clients      int4,
+  queued_commands     int4,
+  pool_segments       int4,
+  pool_total_sz       int8,
+  pool_used_sz        int8,
+  managed_segments    int4,
+  managed_total_sz    int8,
+  managed_used_sz     int8,
+  alloc_failures      int8,
+  direct_read_sz      int8,
+  vfs_read_sz         int8,
+  num_tasks           int8,
+  num_fallbacks       int8,
+  kernel_launches     int8,
+  kernel_total_time   float8,
+  kernel_avg_time     float8,
+  kernel_latency_hist int8[]
+);
+CREATE FUNCTION pgstrom.gpu_service_stats()
+  RETURNS SETOF pgstrom.__gpu_service_stats
+  AS 'MODULE_PATHNAME','pgstrom_gpu_service_stats'
+  LANGUAGE C STRICT;
+CREATE VIEW pgstrom.gpu_service_stats AS
+  SELECT * FROM pgstrom.gpu_service_stats();
+
+-- approximate percentile by the log-scale histogram sketch
+CREATE FUNCTION pgstrom.ppercentile(float8)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_partial_percentile'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.percentile_sketch_accum(bytea,float8)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_percentile_sketch_accum'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.percentile_sketch_trans(bytea,bytea)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_percentile_sketch_trans'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.percentile_approx(bytea,float8)
+  RETURNS float8
+  AS 'MODULE_PATHNAME','pgstrom_percentile_approx'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE AGGREGATE pgstrom.percentile_sketch(float8)
+(
+  sfunc = pgstrom.percentile_sketch_accum,
+  stype = bytea,
+  combinefunc = pgstrom.percentile_sketch_trans,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.percentile_sketch_merge(bytea)
+(
+  sfunc = pgstrom.percentile_sketch_trans,
+  stype = bytea,
+  combinefunc = pgstrom.percentile_sketch_trans,
+  parallel = safe
+);
+
+-- statistics of the shared metadata cache of arrow_fdw
+CREATE TYPE pgstrom.__arrow_metadata_cache_info AS (
+  cache_hits       int8,
+  cache_misses     int8,
+  cache_evictions  int8,
+  cache_failures   int8,
+  num_files        int8,
+  total_size       int8,
+  used_size        int8
+);
+CREATE FUNCTION pgstrom.arrow_metadata_cache_info()
+  RETURNS pgstrom.__arrow_metadata_cache_info
+  AS 'MODULE_PATHNAME','pgstrom_arrow_fdw_metadata_cache_info'
+  LANGUAGE C STRICT;
+CREATE VIEW pgstrom.arrow_metadata_cache_info AS
+  SELECT * FROM pgstrom.arrow_metadata_cache_info();
+
+-- load the metadata of arrow files onto the shared cache
+CREATE FUNCTION pgstrom.arrow_fdw_prewarm_metadata(regclass)
+  RETURNS int4
+  AS 'MODULE_PATHNAME','pgstrom_arrow_fdw_prewarm_metadata'
+  LANGUAGE C STRICT;
+
+-- write out the results of SELECT query to a new arrow file
+CREATE FUNCTION pgstrom.arrow_export(text, text)
+  RETURNS int8
+  AS 'MODULE_PATHNAME','pgstrom_arrow_export'
+  LANGUAGE C STRICT;
+
+-- SUM/AVG of numeric with typmod by the fixed-point sum
+CREATE FUNCTION pgstrom.psum(numeric)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_partial_sum_numeric'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.pavg(numeric)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_partial_sum_numeric'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+-- SUM/AVG of int8 by the 128bit accumulator (same state as above, scale=0)
+CREATE FUNCTION pgstrom.psum128(int8)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_partial_sum_int128'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.pavg128(int8)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_partial_sum_int128'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.fsum_trans_numeric(bytea, bytea)
+  RETURNS bytea
+  AS 'MODULE_PATHNAME','pgstrom_fsum_trans_numeric'
+  LANGUAGE C CALLED ON NULL INPUT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.fsum_final_numeric(bytea)
+  RETURNS numeric
+  AS 'MODULE_PATHNAME','pgstrom_fsum_final_numeric'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE FUNCTION pgstrom.favg_final_numeric(bytea)
+  RETURNS numeric
+  AS 'MODULE_PATHNAME','pgstrom_favg_final_numeric'
+  LANGUAGE C STRICT PARALLEL SAFE;
+
+CREATE AGGREGATE pgstrom.sum_numeric(bytea)
+(
+  sfunc = pgstrom.fsum_trans_numeric,
+  stype = bytea,
+  finalfunc = pgstrom.fsum_final_numeric,
+  parallel = safe
+);
+
+CREATE AGGREGATE pgstrom.avg_numeric(bytea)
+(
+  sfunc = pgstrom.fsum_trans_numeric,
+  stype = bytea,
+  finalfunc = pgstrom.favg_final_numeric,
+  parallel = safe
+);
+
+-- GPU offload advisor; reasons why the expressions were not pushed down
+CREATE TYPE pgstrom.__explain_offload AS (
+  devkind  text,
+  reason   text,
+  count    int4,
+  hint     text
+);
+CREATE FUNCTION pgstrom.explain_offload(text)
+  RETURNS SETOF pgstrom.__explain_offload
+  AS 'MODULE_PATHNAME','pgstrom_explain_offload'
+  LANGUAGE C STRICT;
+
+-- fraction of GPU-Direct SQL eligible blocks, reported by the hint-bits setter
+CREATE TYPE pgstrom.__gpudirect_eligibility_info AS (
+  database_oid          oid,
+  table_oid             oid,
+  table_name            text,
+  nblocks               int8,
+  nblocks_all_visible   int8,
+  nblocks_hint_complete int8,
+  eligible_ratio        float8,
+  last_scan             timestamptz,
+  last_sweep            timestamptz
+);
+CREATE FUNCTION pgstrom.gpudirect_eligibility_info()
+  RETURNS SETOF pgstrom.__gpudirect_eligibility_info
+  AS 'MODULE_PATHNAME','pgstrom_gpudirect_eligibility_info'
+  LANGUAGE C STRICT;
+CREATE VIEW pgstrom.gpudirect_eligibility_info AS
+  SELECT * FROM pgstrom.gpudirect_eligibility_info();
+
+-- dot product / cosine similarity of float2 arrays
+CREATE FUNCTION pgstrom.float2_dot_product(float2[], float2[])
+  RETURNS float8
+  AS 'MODULE_PATHNAME','pgstrom_float2_dot_product'
+  LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+CREATE FUNCTION pgstrom.float2_cosine_similarity(float2[], float2[])
+  RETURNS float8
+  AS 'MODULE_PATHNAME','pgstrom_float2_cosine_similarity'
+  LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+
+-- full-scan statistics of null_frac and n_distinct by GpuPreAgg
+CREATE FUNCTION pgstrom.gpu_analyze(regclass)
+  RETURNS void
+  AS 'MODULE_PATHNAME','pgstrom_gpu_analyze'
+  LANGUAGE C STRICT;
+
+-- BRIN-index summarization by GPU
+CREATE FUNCTION pgstrom.tid_block_number(tid)
+  RETURNS int8
+  AS 'MODULE_PATHNAME','pgstrom_tid_block_number'
+  LANGUAGE C STRICT IMMUTABLE PARALLEL SAFE;
+CREATE FUNCTION pgstrom.brin_summarize_gpu(regclass)
+  RETURNS int4
+  AS 'MODULE_PATHNAME','pgstrom_brin_summarize_gpu'
+  LANGUAGE C STRICT;
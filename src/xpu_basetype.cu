@@ -857,3 +857,215 @@ PG_BITWISE_OPERATOR_TEMPLATE(int1shl,int1,int1,int4,<<)
 PG_BITWISE_OPERATOR_TEMPLATE(int2shl,int2,int2,int4,<<)
 PG_BITWISE_OPERATOR_TEMPLATE(int4shl,int4,int4,int4,<<)
 PG_BITWISE_OPERATOR_TEMPLATE(int8shl,int8,int8,int4,<<)
+
+/*
+ * Dot product / cosine similarity of float2[]
+ *
+ * Elements are converted to fp32 and accumulated in fp32, as the host
+ * side implementation doing, to produce the same results.
+ */
+typedef struct
+{
+	const char *values;		/* array of float2_t, may be unaligned */
+	int32_t		nitems;
+} __float2_array_values;
+
+STATIC_FUNCTION(bool)
+__float2_array_values_setup(kern_context *kcxt,
+							const xpu_array_t *aval,
+							__float2_array_values *fav)
+{
+	if (aval->length < 0)
+	{
+		const char *addr = (const char *)aval->u.heap.value;
+		const __ArrayTypeData *ar;
+		int32_t		ndim;
+		int32_t		nitems = 0;
+
+		if (VARATT_IS_EXTERNAL(addr))
+		{
+			STROM_CPU_FALLBACK(kcxt, "float2 array is external");
+			return false;
+		}
+		else if (VARATT_IS_COMPRESSED(addr))
+		{
+			int		len;
+
+			ar = (const __ArrayTypeData *)
+				pg_decompress_inline_datum(kcxt, addr, &len);
+			if (!ar)
+			{
+				STROM_CPU_FALLBACK(kcxt, "float2 array is compressed");
+				return false;
+			}
+		}
+		else
+			ar = (const __ArrayTypeData *)VARDATA_ANY(addr);
+
+		if (__pg_array_hasnull(ar))
+		{
+			STROM_ELOG(kcxt, "float2 array must not contain NULLs");
+			return false;
+		}
+		ndim = __pg_array_ndim(ar);
+		if (ndim > 0)
+		{
+			nitems = __pg_array_dim(ar, 0);
+			for (int k=1; k < ndim; k++)
+				nitems *= __pg_array_dim(ar, k);
+		}
+		fav->values = __pg_array_dataptr(ar);
+		fav->nitems = nitems;
+	}
+	else
+	{
+		const kern_colmeta *cmeta = aval->u.arrow.cmeta;
+		const kern_data_store *kds = (const kern_data_store *)
+			((const char *)cmeta - cmeta->kds_offset);
+		const kern_colmeta *smeta = &kds->colmeta[cmeta->idx_subattrs];
+
+		if (smeta->attlen != sizeof(float2_t))
+		{
+			STROM_ELOG(kcxt, "Arrow::List is not an array of float2");
+			return false;
+		}
+		for (int k=0; k < aval->length; k++)
+		{
+			if (KDS_ARROW_CHECK_ISNULL(kds, smeta, aval->u.arrow.start + k))
+			{
+				STROM_ELOG(kcxt, "float2 array must not contain NULLs");
+				return false;
+			}
+		}
+		fav->values = NULL;
+		if (aval->length > 0)
+		{
+			fav->values = (const char *)
+				KDS_ARROW_REF_SIMPLE_DATUM(kds, smeta,
+										   aval->u.arrow.start +
+										   aval->length - 1,
+										   sizeof(float2_t));
+			if (!fav->values)
+			{
+				STROM_ELOG(kcxt, "Arrow::List is out of range");
+				return false;
+			}
+			fav->values -= sizeof(float2_t) * (aval->length - 1);
+		}
+		fav->nitems = aval->length;
+	}
+	return true;
+}
+
+INLINE_FUNCTION(float)
+__float2_array_elem(const __float2_array_values *fav, int index)
+{
+	uint16_t	ival = __Fetch((const uint16_t *)fav->values + index);
+
+	return fp16_to_fp32(__short_as_half__(ival));
+}
+
+/*
+ * nvcc contracts 'sum += x * y' into FMA by default, which rounds only once
+ * and makes the result differ from the CPU version; so we use the explicit
+ * round-to-nearest intrinsics that are never fused.
+ */
+#ifdef __CUDACC__
+#define __float2_array_mul_add(sum,x,y)		__fadd_rn((sum), __fmul_rn((x),(y)))
+#else
+#define __float2_array_mul_add(sum,x,y)		((sum) + (x) * (y))
+#endif
+
+STATIC_FUNCTION(bool)
+__float2_array_dot_sums(kern_context *kcxt,
+						const kern_expression *kexp,
+						xpu_float8_t *result,
+						float *p_dot,
+						float *p_norma,
+						float *p_normb)
+{
+	const kern_expression *karg = KEXP_FIRST_ARG(kexp);
+	xpu_array_t	aval1;
+	xpu_array_t	aval2;
+	__float2_array_values a;
+	__float2_array_values b;
+	float		dot = 0.0;
+	float		norma = 0.0;
+	float		normb = 0.0;
+
+	assert(kexp->exptype == TypeOpCode__float8 &&
+		   kexp->nr_args == 2);
+	assert(KEXP_IS_VALID(karg, array));
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, &aval1))
+		return false;
+	karg = KEXP_NEXT_ARG(karg);
+	assert(KEXP_IS_VALID(karg, array));
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, &aval2))
+		return false;
+	if (XPU_DATUM_ISNULL(&aval1) || XPU_DATUM_ISNULL(&aval2))
+	{
+		result->expr_ops = NULL;
+		return true;
+	}
+	if (!__float2_array_values_setup(kcxt, &aval1, &a) ||
+		!__float2_array_values_setup(kcxt, &aval2, &b))
+		return false;
+	if (a.nitems != b.nitems)
+	{
+		STROM_ELOG(kcxt, "different float2 array dimensions");
+		return false;
+	}
+	for (int i=0; i < a.nitems; i++)
+	{
+		float	ax = __float2_array_elem(&a, i);
+		float	bx = __float2_array_elem(&b, i);
+
+		dot = __float2_array_mul_add(dot, ax, bx);
+		if (p_norma)
+			norma = __float2_array_mul_add(norma, ax, ax);
+		if (p_normb)
+			normb = __float2_array_mul_add(normb, bx, bx);
+	}
+	*p_dot = dot;
+	if (p_norma)
+		*p_norma = norma;
+	if (p_normb)
+		*p_normb = normb;
+	result->expr_ops = &xpu_float8_ops;
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_float2_dot_product(XPU_PGFUNCTION_ARGS)
+{
+	xpu_float8_t   *result = (xpu_float8_t *)__result;
+	float			dot;
+
+	if (!__float2_array_dot_sums(kcxt, kexp, result, &dot, NULL, NULL))
+		return false;
+	if (!XPU_DATUM_ISNULL(result))
+		result->value = (double)dot;
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_float2_cosine_similarity(XPU_PGFUNCTION_ARGS)
+{
+	xpu_float8_t   *result = (xpu_float8_t *)__result;
+	float			dot, norma, normb;
+
+	if (!__float2_array_dot_sums(kcxt, kexp, result, &dot, &norma, &normb))
+		return false;
+	if (!XPU_DATUM_ISNULL(result))
+	{
+		double	similarity = ((double)dot /
+							  sqrt((double)norma * (double)normb));
+		/* keep in range; NaN (zero vector) is propagated as is */
+		if (similarity > 1.0)
+			similarity = 1.0;
+		else if (similarity < -1.0)
+			similarity = -1.0;
+		result->value = similarity;
+	}
+	return true;
+}
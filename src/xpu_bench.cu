@@ -0,0 +1,1328 @@
+/*
+ * xpu_bench.cu
+ *
+ * Micro-benchmark of the device functions (pgfn_*) on the kern_expression
+ * interpreter. The same source is built for GPU by nvcc ("make xpu_bench"
+ * at src/), and for DPU by gcc ("make xpu_bench" at src/dpu/; xpu_bench.cc
+ * is a symbolic link to this file), so both numbers are comparable.
+ *
+ * It generates synthetic columns in the PostgreSQL on-disk format, loads
+ * them onto the xpu_datum_t slots once, then runs a hand-built expression
+ * for each row and reports the throughput and the ratio of true/false/null/
+ * error results, and the divergence; the ratio of 32-rows groups (= warp)
+ * whose rows take different paths, that is the typical reason why a device
+ * function runs much slower than the arithmetic intensity.
+ * --
+ * Copyright 2011-2023 (C) KaiGai Kohei <kaigai@kaigai.gr.jp>
+ * Copyright 2014-2023 (C) PG-Strom Developers Team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the PostgreSQL License.
+ */
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __CUDACC__
+#include <cuda_runtime.h>
+#endif
+#include "xpu_common.h"
+
+/*
+ * xpuBenchColumn - a column of the synthetic values
+ */
+#define XPUBENCH_NULL_OFFSET		(~0UL)
+
+typedef struct
+{
+	TypeOpCode	type_code;
+	int			slot_id;		/* kvars slot; also the key of the cache */
+	uint32_t	unitsz;			/* length of xpu_datum_t in datums[] */
+	const char *heap;			/* values in the PostgreSQL datum format */
+	uint64_t   *offsets;		/* offset to heap, or XPUBENCH_NULL_OFFSET */
+	char	   *datums;			/* array of xpu_datum_t */
+} xpuBenchColumn;
+
+/*
+ * xpuBenchError - the first error/fallback reported by the device function
+ */
+typedef struct
+{
+	uint32_t	count;
+	uint32_t	errcode;
+	uint32_t	lineno;
+	char		message[200];
+} xpuBenchError;
+
+/* classification of the results */
+#define XPUBENCH_RES__FALSE			0
+#define XPUBENCH_RES__TRUE			1
+#define XPUBENCH_RES__VALUE			2
+#define XPUBENCH_RES__NULL			3
+#define XPUBENCH_RES__ERROR			4
+#define XPUBENCH_RES__NCLASSES		5
+
+#define XPUBENCH_GROUP_SZ			32		/* = warpSize */
+
+/*
+ * buffer to receive the result of the expression; large enough for
+ * any data types in the benchmark cases.
+ */
+typedef union
+{
+	xpu_datum_t		xdatum;
+	xpu_bool_t		bool_v;
+	xpu_int8_t		int8_v;
+	xpu_float8_t	float8_v;
+	xpu_numeric_t	numeric_v;
+	xpu_text_t		text_v;
+	xpu_timestamp_t	timestamp_v;
+	xpu_jsonb_t		jsonb_v;
+	xpu_geometry_t	geometry_v;
+} xpuBenchResult;
+
+/* ----------------------------------------------------------------
+ *
+ * Device (or DPU) code
+ *
+ * ----------------------------------------------------------------
+ */
+STATIC_FUNCTION(bool)
+__xpubench_resolve_kexp(kern_expression *kexp)
+{
+	kern_expression *karg;
+	int			i;
+
+	kexp->fn_dptr = NULL;
+	for (i=0; builtin_xpu_functions_catalog[i].func_opcode != FuncOpCode__Invalid; i++)
+	{
+		if (builtin_xpu_functions_catalog[i].func_opcode == kexp->opcode)
+		{
+			kexp->fn_dptr = builtin_xpu_functions_catalog[i].func_dptr;
+			break;
+		}
+	}
+	kexp->expr_ops = NULL;
+	for (i=0; builtin_xpu_types_catalog[i].type_opcode != TypeOpCode__Invalid; i++)
+	{
+		if (builtin_xpu_types_catalog[i].type_opcode == kexp->exptype)
+		{
+			kexp->expr_ops = builtin_xpu_types_catalog[i].type_ops;
+			break;
+		}
+	}
+	if (!kexp->fn_dptr || !kexp->expr_ops)
+		return false;
+	for (i=0, karg = KEXP_FIRST_ARG(kexp);
+		 i < kexp->nr_args;
+		 i++, karg = KEXP_NEXT_ARG(karg))
+	{
+		if (!__xpubench_resolve_kexp(karg))
+			return false;
+	}
+	return true;
+}
+
+/*
+ * __xpubench_setup - it sets up the function pointers of the session and
+ * the expression on the device side; returns 0 on success.
+ */
+STATIC_FUNCTION(int)
+__xpubench_setup(kern_session_info *session, kern_expression *kexp)
+{
+	kern_varslot_desc *vs_desc = SESSION_KVARS_SLOT_DESC(session);
+	xpu_encode_info *encode = SESSION_ENCODE(session);
+
+	for (int j=0; j < session->kcxt_kvars_nslots; j++)
+	{
+		vs_desc[j].vs_ops = NULL;
+		for (int i=0; builtin_xpu_types_catalog[i].type_opcode != TypeOpCode__Invalid; i++)
+		{
+			if (builtin_xpu_types_catalog[i].type_opcode == vs_desc[j].vs_type_code)
+			{
+				vs_desc[j].vs_ops = builtin_xpu_types_catalog[i].type_ops;
+				break;
+			}
+		}
+		if (!vs_desc[j].vs_ops)
+			return 1;
+	}
+	if (encode)
+	{
+		for (int i=0; (xpu_encode_catalog[i].enc_mblen &&
+					   xpu_encode_catalog[i].enc_maxlen > 0); i++)
+		{
+			if (__strcmp(encode->encname, xpu_encode_catalog[i].encname) == 0)
+			{
+				encode->enc_maxlen = xpu_encode_catalog[i].enc_maxlen;
+				encode->enc_mblen  = xpu_encode_catalog[i].enc_mblen;
+				break;
+			}
+		}
+		if (!encode->enc_mblen)
+			return 2;
+	}
+	if (!__xpubench_resolve_kexp(kexp))
+		return 3;
+	return 0;
+}
+
+/*
+ * __xpubench_load_rows - it loads the heap datum onto xpu_datum_t
+ */
+STATIC_FUNCTION(void)
+__xpubench_load_rows(kern_session_info *session,
+					 xpuBenchColumn *columns,
+					 uint64_t nrows,
+					 uint64_t row_base,
+					 uint64_t row_step)
+{
+	const kern_varslot_desc *vs_desc = SESSION_KVARS_SLOT_DESC(session);
+	kern_context *kcxt;
+
+	INIT_KERNEL_CONTEXT(kcxt, session);
+	for (uint64_t row = row_base; row < nrows; row += row_step)
+	{
+		for (int j=0; j < session->kcxt_kvars_nslots; j++)
+		{
+			xpuBenchColumn *column = &columns[j];
+			xpu_datum_t	   *xdatum = (xpu_datum_t *)
+				(column->datums + column->unitsz * row);
+			uint64_t		offset = column->offsets[row];
+
+			kcxt->vlpos = kcxt->vlbuf;
+			if (offset == XPUBENCH_NULL_OFFSET ||
+				!vs_desc[j].vs_ops->xpu_datum_heap_read(kcxt,
+														column->heap + offset,
+														xdatum))
+				xdatum->expr_ops = NULL;
+		}
+	}
+}
+
+/*
+ * __xpubench_exec_rows - it runs the expression for each row, then saves
+ * the classification of the results.
+ */
+STATIC_FUNCTION(void)
+__xpubench_exec_rows(kern_session_info *session,
+					 const kern_expression *kexp,
+					 xpuBenchColumn *columns,
+					 uint8_t *results,
+					 xpuBenchError *error,
+					 uint64_t nrows,
+					 uint64_t row_base,
+					 uint64_t row_step)
+{
+	kern_context   *kcxt;
+	xpuBenchResult	retval;
+	int				nslots = session->kcxt_kvars_nslots;
+
+	INIT_KERNEL_CONTEXT(kcxt, session);
+	for (uint64_t row = row_base; row < nrows; row += row_step)
+	{
+		uint8_t		res;
+
+		for (int j=0; j < nslots; j++)
+			kcxt->kvars_slot[j] = (xpu_datum_t *)
+				(columns[j].datums + columns[j].unitsz * row);
+		kcxt->vlpos = kcxt->vlbuf;
+		kcxt->errcode = ERRCODE_STROM_SUCCESS;
+		if (!EXEC_KERN_EXPRESSION(kcxt, kexp, &retval))
+		{
+			res = XPUBENCH_RES__ERROR;
+			if (__atomic_add_uint32(&error->count, 1) == 0)
+			{
+				const char *msg = kcxt->error_message;
+				int			i = 0;
+
+				error->errcode = kcxt->errcode;
+				error->lineno = kcxt->error_lineno;
+				if (msg)
+				{
+					while (msg[i] != '\0' && i < sizeof(error->message) - 1)
+					{
+						error->message[i] = msg[i];
+						i++;
+					}
+				}
+				error->message[i] = '\0';
+			}
+		}
+		else if (XPU_DATUM_ISNULL(&retval.xdatum))
+			res = XPUBENCH_RES__NULL;
+		else if (kexp->exptype != TypeOpCode__bool)
+			res = XPUBENCH_RES__VALUE;
+		else if (retval.bool_v.value)
+			res = XPUBENCH_RES__TRUE;
+		else
+			res = XPUBENCH_RES__FALSE;
+		results[row] = res;
+	}
+}
+
+#ifdef __CUDACC__
+KERNEL_FUNCTION(void)
+kern_xpubench_setup(kern_session_info *session,
+					kern_expression *kexp,
+					int *p_status)
+{
+	if (blockIdx.x == 0 && threadIdx.x == 0)
+		*p_status = __xpubench_setup(session, kexp);
+}
+
+KERNEL_FUNCTION(void)
+kern_xpubench_load(kern_session_info *session,
+				   xpuBenchColumn *columns,
+				   uint64_t nrows)
+{
+	__xpubench_load_rows(session, columns, nrows,
+						 blockIdx.x * blockDim.x + threadIdx.x,
+						 gridDim.x * blockDim.x);
+}
+
+KERNEL_FUNCTION(void)
+kern_xpubench_exec(kern_session_info *session,
+				   const kern_expression *kexp,
+				   xpuBenchColumn *columns,
+				   uint8_t *results,
+				   xpuBenchError *error,
+				   uint64_t nrows)
+{
+	__xpubench_exec_rows(session, kexp, columns, results, error, nrows,
+						 blockIdx.x * blockDim.x + threadIdx.x,
+						 gridDim.x * blockDim.x);
+}
+#endif	/* __CUDACC__ */
+
+/* ----------------------------------------------------------------
+ *
+ * Host code
+ *
+ * ----------------------------------------------------------------
+ */
+#define Elog(fmt,...)								\
+	do {											\
+		fprintf(stderr, "[%s @ %s:%d] " fmt "\n",	\
+				__FUNCTION__, __FILE__, __LINE__,	\
+				##__VA_ARGS__);						\
+		exit(1);									\
+	} while(0)
+
+#ifdef __CUDACC__
+#define __cudaCheck(rc,label)									\
+	do {														\
+		cudaError_t	__rc = (rc);								\
+		if (__rc != cudaSuccess)								\
+			Elog("failed on %s: %s", label, cudaGetErrorString(__rc)); \
+	} while(0)
+#endif
+
+/* command line options */
+static uint64_t		num_rows = 4000000;
+static int			num_loops = 5;
+static double		null_ratio = 0.0;
+static uint64_t		random_seed = 20231101;
+#ifdef __CUDACC__
+static int			cuda_dindex = 0;
+static int			cuda_num_sms = 0;
+#else
+static int			num_threads = -1;
+#endif
+
+/*
+ * xpuBenchBuffer - growable buffer on the host
+ */
+typedef struct
+{
+	char	   *data;
+	size_t		len;
+	size_t		size;
+} xpuBenchBuffer;
+
+static void
+xpubench_buffer_reserve(xpuBenchBuffer *buf, size_t sz)
+{
+	if (buf->len + sz > buf->size)
+	{
+		size_t	new_size = Max(buf->size, 8192);
+
+		while (buf->len + sz > new_size)
+			new_size *= 2;
+		buf->data = (char *)realloc(buf->data, new_size);
+		if (!buf->data)
+			Elog("out of memory");
+		buf->size = new_size;
+	}
+}
+
+static void
+xpubench_buffer_append(xpuBenchBuffer *buf, const void *data, size_t sz)
+{
+	xpubench_buffer_reserve(buf, sz);
+	if (data)
+		memcpy(buf->data + buf->len, data, sz);
+	else
+		memset(buf->data + buf->len, 0, sz);
+	buf->len += sz;
+}
+
+static void
+xpubench_buffer_align(xpuBenchBuffer *buf, size_t align)
+{
+	size_t	sz = TYPEALIGN(align, buf->len) - buf->len;
+
+	if (sz > 0)
+		xpubench_buffer_append(buf, NULL, sz);
+}
+
+/*
+ * memory allocation visible to both of host and device
+ */
+static void *
+xpubench_alloc(size_t sz)
+{
+	void   *ptr;
+
+#ifdef __CUDACC__
+	__cudaCheck(cudaMallocManaged(&ptr, Max(sz, 1), cudaMemAttachGlobal),
+				"cudaMallocManaged");
+#else
+	ptr = malloc(Max(sz, 1));
+	if (!ptr)
+		Elog("out of memory");
+#endif
+	return ptr;
+}
+
+static void
+xpubench_free(void *ptr)
+{
+#ifdef __CUDACC__
+	cudaFree(ptr);
+#else
+	free(ptr);
+#endif
+}
+
+static double
+xpubench_clock(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
+/*
+ * Random numbers; each value depends on the seed, the column and the row
+ * only, so the same data set is reproducible.
+ */
+static inline uint64_t
+xpubench_random(uint64_t key)
+{
+	/* splitmix64 */
+	uint64_t	z = key + 0x9e3779b97f4a7c15UL;
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9UL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebUL;
+	return z ^ (z >> 31);
+}
+
+/*
+ * Generators of the PostgreSQL datum; it appends a random value, or
+ * the constant value if 'cvalue' is given.
+ */
+static void
+__gen_varlena(xpuBenchBuffer *buf, const char *data, uint32_t len)
+{
+	uint32_t	hdr = ((len + VARHDRSZ) << 2);		/* = SET_VARSIZE_4B */
+
+	xpubench_buffer_append(buf, &hdr, sizeof(uint32_t));
+	xpubench_buffer_append(buf, data, len);
+}
+
+static void
+__gen_random_word(char *dst, uint64_t rand, int minlen, int maxlen)
+{
+	int		len = minlen + rand % (maxlen - minlen + 1);
+
+	for (int i=0; i < len; i++)
+	{
+		rand = xpubench_random(rand);
+		dst[i] = 'a' + rand % 26;
+	}
+	dst[len] = '\0';
+}
+
+static void
+xpubench_gen_int4(xpuBenchBuffer *buf, uint64_t rand, const char *cvalue)
+{
+	int32_t		ival;
+
+	if (cvalue)
+		ival = atoi(cvalue);
+	else
+		ival = (int32_t)(rand % 2000001) - 1000000;
+	xpubench_buffer_append(buf, &ival, sizeof(int32_t));
+}
+
+static void
+xpubench_gen_int8(xpuBenchBuffer *buf, uint64_t rand, const char *cvalue)
+{
+	int64_t		ival;
+
+	if (cvalue)
+		ival = atol(cvalue);
+	else
+		ival = (int64_t)(rand % 2000000001UL) - 1000000000L;
+	xpubench_buffer_append(buf, &ival, sizeof(int64_t));
+}
+
+static void
+xpubench_gen_float8(xpuBenchBuffer *buf, uint64_t rand, const char *cvalue)
+{
+	double		fval;
+
+	if (cvalue)
+		fval = atof(cvalue);
+	else
+		fval = ((double)(rand >> 11) / (double)(1UL << 53)) * 2.0e6 - 1.0e6;
+	xpubench_buffer_append(buf, &fval, sizeof(double));
+}
+
+static void
+xpubench_gen_numeric(xpuBenchBuffer *buf, uint64_t rand, const char *cvalue)
+{
+	/* in the NUMERIC_SHORT format with dscale=2 */
+	int64_t		cents;
+	int64_t		ipart;
+	uint16_t	n_head;
+	int16_t		digits[4];
+	int			ndigits = 0;
+	int			weight;
+	uint32_t	hdr;
+
+	if (cvalue)
+		cents = (int64_t)(atof(cvalue) * 100.0 + (cvalue[0] == '-' ? -0.5 : 0.5));
+	else
+		cents = (int64_t)(rand % 200000001UL) - 100000000L;
+	n_head = NUMERIC_SHORT | (2 << NUMERIC_SHORT_DSCALE_SHIFT);
+	if (cents < 0)
+	{
+		n_head |= NUMERIC_SHORT_SIGN_MASK;
+		cents = -cents;
+	}
+	ipart = cents / 100;
+	if (ipart >= 10000)
+	{
+		digits[ndigits++] = ipart / 10000;
+		digits[ndigits++] = ipart % 10000;
+		weight = 1;
+	}
+	else if (ipart > 0)
+	{
+		digits[ndigits++] = ipart;
+		weight = 0;
+	}
+	else
+		weight = -1;
+	if (cents % 100 != 0)
+		digits[ndigits++] = (cents % 100) * 100;
+	while (ndigits > 0 && digits[ndigits-1] == 0)
+		ndigits--;
+	if (ndigits == 0)
+		weight = 0;
+	n_head |= (weight & (NUMERIC_SHORT_WEIGHT_SIGN_MASK |
+						 NUMERIC_SHORT_WEIGHT_MASK));
+	hdr = ((VARHDRSZ + sizeof(uint16_t) + sizeof(int16_t) * ndigits) << 2);
+	xpubench_buffer_append(buf, &hdr, sizeof(uint32_t));
+	xpubench_buffer_append(buf, &n_head, sizeof(uint16_t));
+	xpubench_buffer_append(buf, digits, sizeof(int16_t) * ndigits);
+}
+
+static void
+xpubench_gen_text(xpuBenchBuffer *buf, uint64_t rand, const char *cvalue)
+{
+	char		temp[80];
+
+	if (!cvalue)
+	{
+		/* 1/4 of the values contain 'abc' */
+		__gen_random_word(temp, rand, 4, 40);
+		if ((rand >> 32) % 4 == 0)
+		{
+			size_t	len = strlen(temp);
+			size_t	pos = (rand >> 40) % (len - 2);
+
+			memcpy(temp + pos, "abc", 3);
+		}
+		cvalue = temp;
+	}
+	__gen_varlena(buf, cvalue, strlen(cvalue));
+}
+
+static void
+xpubench_gen_date(xpuBenchBuffer *buf, uint64_t rand, const char *cvalue)
+{
+	/* days since 2000-01-01, until 2054 */
+	int32_t		days = (cvalue ? atoi(cvalue) : rand % 20000);
+
+	xpubench_buffer_append(buf, &days, sizeof(int32_t));
+}
+
+static void
+xpubench_gen_timestamp(xpuBenchBuffer *buf, uint64_t rand, const char *cvalue)
+{
+	/* microseconds since 2000-01-01 00:00:00, until 2054 */
+	int64_t		ts = (cvalue ? atol(cvalue) : rand % (20000UL * 86400000000UL));
+
+	xpubench_buffer_append(buf, &ts, sizeof(int64_t));
+}
+
+static void
+xpubench_gen_jsonb(xpuBenchBuffer *buf, uint64_t rand, const char *cvalue)
+{
+	/*
+	 * flat object of the string values; keys are sorted by the length,
+	 * then memcmp(), as JsonbContainer expects.
+	 */
+	static const char *keys[] = { "a", "id", "name", "price" };
+	char		values[4][48];
+	uint32_t	jentries[8];
+	uint32_t	header = 4 | 0x20000000;	/* JB_FOBJECT */
+	uint32_t	hdr;
+	uint32_t	len = 0;
+
+	if (cvalue)
+		Elog("jsonb constant is not supported");
+	__gen_random_word(values[0], rand, 1, 8);
+	snprintf(values[1], sizeof(values[1]), "%lu", (rand >> 20) % 1000000);
+	__gen_random_word(values[2], xpubench_random(rand), 4, 24);
+	snprintf(values[3], sizeof(values[3]), "%lu.%02lu",
+			 (rand >> 12) % 10000, (rand >> 4) % 100);
+	for (int i=0; i < 8; i++)
+	{
+		const char *str = (i < 4 ? keys[i] : values[i-4]);
+
+		jentries[i] = strlen(str);
+		len += jentries[i];
+	}
+	jentries[0] |= 0x80000000;		/* JENTRY_HAS_OFF; end offset of [0] */
+	hdr = ((VARHDRSZ + sizeof(header) + sizeof(jentries) + len) << 2);
+	xpubench_buffer_append(buf, &hdr, sizeof(uint32_t));
+	xpubench_buffer_append(buf, &header, sizeof(uint32_t));
+	xpubench_buffer_append(buf, jentries, sizeof(jentries));
+	for (int i=0; i < 8; i++)
+	{
+		const char *str = (i < 4 ? keys[i] : values[i-4]);
+
+		xpubench_buffer_append(buf, str, strlen(str));
+	}
+}
+
+static void
+xpubench_gen_geometry(xpuBenchBuffer *buf, uint64_t rand, const char *cvalue)
+{
+	/* POINT in [0,1)x[0,1), GSERIALIZED v2 without bbox */
+	struct {
+		uint32_t	vl_len;
+		uint8_t		srid[3];
+		uint8_t		gflags;
+		uint32_t	type;
+		uint32_t	nitems;
+		double		x;
+		double		y;
+	} gs;
+
+	if (cvalue)
+		Elog("geometry constant is not supported");
+	memset(&gs, 0, sizeof(gs));
+	gs.vl_len = (sizeof(gs) << 2);
+	gs.gflags = G2FLAG_VER_0;
+	gs.type   = GEOM_POINTTYPE;
+	gs.nitems = 1;
+	gs.x = (double)(rand >> 32) / 4294967296.0;
+	gs.y = (double)(rand & 0xffffffffU) / 4294967296.0;
+	xpubench_buffer_append(buf, &gs, sizeof(gs));
+}
+
+typedef struct
+{
+	TypeOpCode	type_code;
+	const char *type_name;
+	size_t		xpu_sizeof;
+	void	  (*gen_datum)(xpuBenchBuffer *buf, uint64_t rand, const char *cvalue);
+} xpuBenchType;
+
+#define XPUBENCH_TYPE(NAME)									\
+	{ TypeOpCode__##NAME, #NAME, sizeof(xpu_##NAME##_t),	\
+	  xpubench_gen_##NAME }
+static xpuBenchType	xpubench_types[] = {
+	XPUBENCH_TYPE(int4),
+	XPUBENCH_TYPE(int8),
+	XPUBENCH_TYPE(float8),
+	XPUBENCH_TYPE(numeric),
+	XPUBENCH_TYPE(text),
+	XPUBENCH_TYPE(date),
+	XPUBENCH_TYPE(timestamp),
+	XPUBENCH_TYPE(jsonb),
+	XPUBENCH_TYPE(geometry),
+	{ TypeOpCode__Invalid, NULL, 0, NULL },
+};
+#undef XPUBENCH_TYPE
+
+static const xpuBenchType *
+xpubench_lookup_type(TypeOpCode type_code)
+{
+	for (int i=0; xpubench_types[i].type_name; i++)
+	{
+		if (xpubench_types[i].type_code == type_code)
+			return &xpubench_types[i];
+	}
+	Elog("unsupported type (code=%d)", (int)type_code);
+}
+
+/*
+ * Benchmark cases
+ */
+typedef struct
+{
+	TypeOpCode	type_code;
+	const char *cvalue;			/* constant, or NULL for the column */
+} xpuBenchArg;
+
+typedef struct
+{
+	const char *name;
+	FuncOpCode	opcode;
+	TypeOpCode	rettype;
+	int			nargs;
+	xpuBenchArg	args[3];
+} xpuBenchCase;
+
+#define __C(NAME)			{ TypeOpCode__##NAME, NULL }
+#define __K(NAME,VALUE)		{ TypeOpCode__##NAME, VALUE }
+#define __F(NAME,RET,NARGS,...)								\
+	{ #NAME, FuncOpCode__##NAME, TypeOpCode__##RET, NARGS, { __VA_ARGS__ } }
+static xpuBenchCase	xpubench_cases[] = {
+	/* baseline; cost of the interpreter and the variable reference */
+	{ "varref", FuncOpCode__VarExpr, TypeOpCode__int4, 1, { __C(int4) } },
+	/* basetype */
+	__F(int4eq,  bool, 2, __C(int4), __K(int4, "12345")),
+	__F(int4lt,  bool, 2, __C(int4), __C(int4)),
+	__F(int4pl,  int4, 2, __C(int4), __C(int4)),
+	__F(int8mul, int8, 2, __C(int8), __C(int8)),
+	__F(float8pl,  float8, 2, __C(float8), __C(float8)),
+	__F(float8mul, float8, 2, __C(float8), __C(float8)),
+	__F(float8div, float8, 2, __C(float8), __C(float8)),
+	__F(float8lt,  bool,   2, __C(float8), __K(float8, "0.0")),
+	__F(int4_to_float8, float8, 1, __C(int4)),
+	__F(float8_to_int4, int4,   1, __C(float8)),
+	/* numeric */
+	__F(numeric_add, numeric, 2, __C(numeric), __C(numeric)),
+	__F(numeric_sub, numeric, 2, __C(numeric), __C(numeric)),
+	__F(numeric_mul, numeric, 2, __C(numeric), __C(numeric)),
+	__F(numeric_div, numeric, 2, __C(numeric), __C(numeric)),
+	__F(numeric_lt,  bool,    2, __C(numeric), __K(numeric, "0.00")),
+	__F(numeric_to_float8, float8, 1, __C(numeric)),
+	__F(int4_to_numeric, numeric,  1, __C(int4)),
+	/* text */
+	__F(text_eq,    bool, 2, __C(text), __C(text)),
+	__F(textlen,    int4, 1, __C(text)),
+	__F(textlike,   bool, 2, __C(text), __K(text, "%abc%")),
+	__F(texticlike, bool, 2, __C(text), __K(text, "%ABC%")),
+	__F(substr,     text, 3, __C(text), __K(int4, "2"), __K(int4, "5")),
+	/* date and time */
+	__F(date_pli,     date, 2, __C(date), __K(int4, "30")),
+	__F(timestamp_lt, bool, 2, __C(timestamp), __C(timestamp)),
+	__F(extract_timestamp, numeric, 2, __K(text, "day"), __C(timestamp)),
+	/* jsonb */
+	__F(jsonb_object_field,      jsonb, 2, __C(jsonb), __K(text, "name")),
+	__F(jsonb_object_field_text, text,  2, __C(jsonb), __K(text, "price")),
+	/* postgis */
+	__F(st_distance, float8, 2, __C(geometry), __C(geometry)),
+	__F(st_dwithin,  bool,   3, __C(geometry), __C(geometry), __K(float8, "0.1")),
+	{ NULL },
+};
+#undef __C
+#undef __K
+#undef __F
+
+/*
+ * xpubench_build_column - it generates the synthetic values of the column
+ */
+static void
+xpubench_build_column(xpuBenchColumn *column, TypeOpCode type_code, int slot_id)
+{
+	const xpuBenchType *btype = xpubench_lookup_type(type_code);
+	xpuBenchBuffer	buf;
+	uint64_t		null_thresh = (uint64_t)(null_ratio * (double)UINT_MAX);
+	char		   *heap;
+
+	memset(&buf, 0, sizeof(buf));
+	column->type_code = type_code;
+	column->slot_id = slot_id;
+	column->unitsz = TYPEALIGN(16, btype->xpu_sizeof);
+	column->offsets = (uint64_t *)xpubench_alloc(sizeof(uint64_t) * num_rows);
+	column->datums = NULL;
+	for (uint64_t row=0; row < num_rows; row++)
+	{
+		uint64_t	rand = xpubench_random(random_seed ^
+										   ((uint64_t)type_code << 56) ^
+										   ((uint64_t)slot_id << 48) ^ row);
+		if ((xpubench_random(rand) & UINT_MAX) < null_thresh)
+			column->offsets[row] = XPUBENCH_NULL_OFFSET;
+		else
+		{
+			xpubench_buffer_align(&buf, MAXIMUM_ALIGNOF);
+			column->offsets[row] = buf.len;
+			btype->gen_datum(&buf, rand, NULL);
+		}
+	}
+	heap = (char *)xpubench_alloc(buf.len);
+	memcpy(heap, buf.data, buf.len);
+	column->heap = heap;
+	free(buf.data);
+}
+
+/*
+ * xpubench_build_kexp - it builds the kern_expression of the case
+ */
+static void
+__kexp_append_magic(xpuBenchBuffer *buf, size_t head)
+{
+	kern_expression *kexp;
+	uint32_t	magic;
+
+	xpubench_buffer_align(buf, sizeof(uint32_t));
+	kexp = (kern_expression *)(buf->data + head);
+	magic = (KERN_EXPRESSION_MAGIC
+			 ^ ((uint32_t)kexp->exptype << 6)
+			 ^ ((uint32_t)kexp->opcode << 14));
+	xpubench_buffer_append(buf, &magic, sizeof(uint32_t));
+	kexp = (kern_expression *)(buf->data + head);
+	kexp->len = buf->len - head;
+}
+
+static void
+__kexp_append_var(xpuBenchBuffer *buf, TypeOpCode type_code, int slot_id)
+{
+	size_t		head = buf->len;
+	kern_expression *kexp;
+
+	xpubench_buffer_append(buf, NULL, SizeOfKernExprVar);
+	kexp = (kern_expression *)(buf->data + head);
+	kexp->exptype = type_code;
+	kexp->opcode = FuncOpCode__VarExpr;
+	kexp->u.v.var_offset = -1;
+	kexp->u.v.var_slot_id = slot_id;
+	__kexp_append_magic(buf, head);
+}
+
+static void
+__kexp_append_const(xpuBenchBuffer *buf, TypeOpCode type_code, const char *cvalue)
+{
+	const xpuBenchType *btype = xpubench_lookup_type(type_code);
+	size_t		head = buf->len;
+	kern_expression *kexp;
+
+	xpubench_buffer_append(buf, NULL, offsetof(kern_expression,
+											   u.c.const_value));
+	kexp = (kern_expression *)(buf->data + head);
+	kexp->exptype = type_code;
+	kexp->opcode = FuncOpCode__ConstExpr;
+	kexp->u.c.const_isnull = false;
+	btype->gen_datum(buf, 0, cvalue);
+	__kexp_append_magic(buf, head);
+}
+
+static kern_expression *
+xpubench_build_kexp(const xpuBenchCase *bcase)
+{
+	xpuBenchBuffer	buf;
+	kern_expression *kexp;
+	int			slot_id = 0;
+
+	memset(&buf, 0, sizeof(buf));
+	if (bcase->opcode == FuncOpCode__VarExpr)
+		__kexp_append_var(&buf, bcase->args[0].type_code, 0);
+	else
+	{
+		xpubench_buffer_append(&buf, NULL, SizeOfKernExpr(0));
+		kexp = (kern_expression *)buf.data;
+		kexp->exptype = bcase->rettype;
+		kexp->opcode  = bcase->opcode;
+		kexp->nr_args = bcase->nargs;
+		kexp->args_offset = SizeOfKernExpr(0);
+		for (int i=0; i < bcase->nargs; i++)
+		{
+			const xpuBenchArg *barg = &bcase->args[i];
+
+			xpubench_buffer_align(&buf, MAXIMUM_ALIGNOF);
+			if (barg->cvalue)
+				__kexp_append_const(&buf, barg->type_code, barg->cvalue);
+			else
+				__kexp_append_var(&buf, barg->type_code, slot_id++);
+		}
+		__kexp_append_magic(&buf, 0);
+	}
+	kexp = (kern_expression *)xpubench_alloc(buf.len);
+	memcpy(kexp, buf.data, buf.len);
+	free(buf.data);
+	return kexp;
+}
+
+/*
+ * xpubench_build_session - session info with the kvars slots and encoding
+ */
+static kern_session_info *
+xpubench_build_session(xpuBenchColumn *columns, int ncols)
+{
+	kern_session_info *session;
+	kern_varslot_desc *vs_desc;
+	xpu_encode_info *encode;
+	size_t		off_defs = MAXALIGN(sizeof(kern_session_info));
+	size_t		off_encode = MAXALIGN(off_defs + sizeof(kern_varslot_desc) * ncols);
+	size_t		len = off_encode + MAXALIGN(sizeof(xpu_encode_info));
+
+	session = (kern_session_info *)xpubench_alloc(len);
+	memset(session, 0, len);
+	session->kcxt_kvars_nrooms = ncols;
+	session->kcxt_kvars_nslots = ncols;
+	session->kcxt_kvars_defs = (ncols > 0 ? off_defs : 0);
+	session->kcxt_extra_bufsz = 2048;
+	session->session_encode = off_encode;
+	vs_desc = (kern_varslot_desc *)((char *)session + off_defs);
+	for (int j=0; j < ncols; j++)
+		vs_desc[j].vs_type_code = columns[j].type_code;
+	encode = (xpu_encode_info *)((char *)session + off_encode);
+	strcpy(encode->encname, "UTF8");
+
+	return session;
+}
+
+/*
+ * xpubench_run_* - device specific portion of setup/load/exec
+ */
+#ifdef __CUDACC__
+static void
+xpubench_run_setup(kern_session_info *session, kern_expression *kexp)
+{
+	int	   *p_status = (int *)xpubench_alloc(sizeof(int));
+
+	*p_status = -1;
+	kern_xpubench_setup<<<1,1>>>(session, kexp, p_status);
+	__cudaCheck(cudaDeviceSynchronize(), "kern_xpubench_setup");
+	if (*p_status != 0)
+		Elog("failed on kern_xpubench_setup (status=%d)", *p_status);
+	xpubench_free(p_status);
+}
+
+static void
+__xpubench_grid_size(int *p_grid_sz, int *p_block_sz)
+{
+	uint64_t	nblocks = (num_rows + 255) / 256;
+
+	*p_block_sz = 256;
+	*p_grid_sz = Min(nblocks, (uint64_t)cuda_num_sms * 32);
+}
+
+static void
+xpubench_run_load(kern_session_info *session,
+				  xpuBenchColumn *columns)
+{
+	int		grid_sz, block_sz;
+
+	__xpubench_grid_size(&grid_sz, &block_sz);
+	kern_xpubench_load<<<grid_sz, block_sz>>>(session, columns, num_rows);
+	__cudaCheck(cudaDeviceSynchronize(), "kern_xpubench_load");
+}
+
+static double
+xpubench_run_exec(kern_session_info *session,
+				  const kern_expression *kexp,
+				  xpuBenchColumn *columns,
+				  uint8_t *results,
+				  xpuBenchError *error)
+{
+	cudaEvent_t	ev_start, ev_stop;
+	float		msec;
+	int			grid_sz, block_sz;
+
+	__xpubench_grid_size(&grid_sz, &block_sz);
+	__cudaCheck(cudaEventCreate(&ev_start), "cudaEventCreate");
+	__cudaCheck(cudaEventCreate(&ev_stop), "cudaEventCreate");
+	cudaEventRecord(ev_start);
+	kern_xpubench_exec<<<grid_sz, block_sz>>>(session, kexp, columns,
+											  results, error, num_rows);
+	cudaEventRecord(ev_stop);
+	__cudaCheck(cudaEventSynchronize(ev_stop), "kern_xpubench_exec");
+	__cudaCheck(cudaGetLastError(), "kern_xpubench_exec");
+	cudaEventElapsedTime(&msec, ev_start, ev_stop);
+	cudaEventDestroy(ev_start);
+	cudaEventDestroy(ev_stop);
+
+	return (double)msec / 1000.0;
+}
+#else	/* __CUDACC__ */
+typedef struct
+{
+	pthread_t	thread;
+	int			thread_id;
+	bool		exec_mode;
+	kern_session_info *session;
+	const kern_expression *kexp;
+	xpuBenchColumn *columns;
+	uint8_t	   *results;
+	xpuBenchError *error;
+} xpuBenchWorker;
+
+static void *
+xpubench_worker_main(void *__arg)
+{
+	xpuBenchWorker *w = (xpuBenchWorker *)__arg;
+
+	/*
+	 * rows are assigned to the workers by the groups, not interleaved,
+	 * to avoid false sharing of the results[] and the datums.
+	 */
+	uint64_t	unitsz = TYPEALIGN(XPUBENCH_GROUP_SZ,
+								   (num_rows + num_threads - 1) / num_threads);
+	uint64_t	row_base = unitsz * w->thread_id;
+	uint64_t	row_end = Min(row_base + unitsz, num_rows);
+
+	if (row_base >= row_end)
+		return NULL;
+	if (w->exec_mode)
+		__xpubench_exec_rows(w->session, w->kexp,
+							 w->columns, w->results, w->error,
+							 row_end, row_base, 1);
+	else
+		__xpubench_load_rows(w->session, w->columns,
+							 row_end, row_base, 1);
+	return NULL;
+}
+
+static void
+__xpubench_run_workers(xpuBenchWorker *wtemp)
+{
+	xpuBenchWorker *workers = (xpuBenchWorker *)
+		alloca(sizeof(xpuBenchWorker) * num_threads);
+
+	for (int i=0; i < num_threads; i++)
+	{
+		memcpy(&workers[i], wtemp, sizeof(xpuBenchWorker));
+		workers[i].thread_id = i;
+		if ((errno = pthread_create(&workers[i].thread, NULL,
+									xpubench_worker_main,
+									&workers[i])) != 0)
+			Elog("failed on pthread_create: %m");
+	}
+	for (int i=0; i < num_threads; i++)
+		pthread_join(workers[i].thread, NULL);
+}
+
+static void
+xpubench_run_setup(kern_session_info *session, kern_expression *kexp)
+{
+	int		status = __xpubench_setup(session, kexp);
+
+	if (status != 0)
+		Elog("failed on __xpubench_setup (status=%d)", status);
+}
+
+static void
+xpubench_run_load(kern_session_info *session,
+				  xpuBenchColumn *columns)
+{
+	xpuBenchWorker	wtemp;
+
+	memset(&wtemp, 0, sizeof(xpuBenchWorker));
+	wtemp.exec_mode = false;
+	wtemp.session = session;
+	wtemp.columns = columns;
+	__xpubench_run_workers(&wtemp);
+}
+
+static double
+xpubench_run_exec(kern_session_info *session,
+				  const kern_expression *kexp,
+				  xpuBenchColumn *columns,
+				  uint8_t *results,
+				  xpuBenchError *error)
+{
+	xpuBenchWorker	wtemp;
+	double		tv1, tv2;
+
+	memset(&wtemp, 0, sizeof(xpuBenchWorker));
+	wtemp.exec_mode = true;
+	wtemp.session = session;
+	wtemp.kexp = kexp;
+	wtemp.columns = columns;
+	wtemp.results = results;
+	wtemp.error = error;
+	tv1 = xpubench_clock();
+	__xpubench_run_workers(&wtemp);
+	tv2 = xpubench_clock();
+
+	return tv2 - tv1;
+}
+#endif	/* __CUDACC__ */
+
+/*
+ * xpubench_run_case
+ */
+static xpuBenchColumn *xpubench_column_cache = NULL;
+static int		xpubench_column_cache_nitems = 0;
+
+static void
+xpubench_lookup_column(xpuBenchColumn *column, TypeOpCode type_code, int slot_id)
+{
+	xpuBenchColumn *cached;
+
+	/* the generated heap is shared by the cases with the same slot/type */
+	for (int i=0; i < xpubench_column_cache_nitems; i++)
+	{
+		cached = &xpubench_column_cache[i];
+		if (cached->type_code == type_code &&
+			cached->slot_id == slot_id)
+		{
+			memcpy(column, cached, sizeof(xpuBenchColumn));
+			return;
+		}
+	}
+	xpubench_build_column(column, type_code, slot_id);
+	xpubench_column_cache = (xpuBenchColumn *)
+		realloc(xpubench_column_cache, sizeof(xpuBenchColumn) *
+				(xpubench_column_cache_nitems + 1));
+	if (!xpubench_column_cache)
+		Elog("out of memory");
+	cached = &xpubench_column_cache[xpubench_column_cache_nitems++];
+	memcpy(cached, column, sizeof(xpuBenchColumn));
+}
+
+static void
+xpubench_run_case(const xpuBenchCase *bcase)
+{
+	xpuBenchColumn *columns;
+	kern_session_info *session;
+	kern_expression *kexp;
+	xpuBenchError *error;
+	uint8_t	   *results;
+	uint64_t	counts[XPUBENCH_RES__NCLASSES];
+	uint64_t	ngroups = 0;
+	uint64_t	ndiverged = 0;
+	double		best = -1.0;
+	int			ncols = 0;
+
+	/* setup columns, kern_expression and session */
+	columns = (xpuBenchColumn *)xpubench_alloc(sizeof(xpuBenchColumn) * 3);
+	for (int i=0; i < bcase->nargs; i++)
+	{
+		if (!bcase->args[i].cvalue)
+		{
+			xpubench_lookup_column(&columns[ncols], bcase->args[i].type_code, ncols);
+			columns[ncols].datums = (char *)
+				xpubench_alloc((size_t)columns[ncols].unitsz * num_rows);
+			memset(columns[ncols].datums, 0,
+				   (size_t)columns[ncols].unitsz * num_rows);
+			ncols++;
+		}
+	}
+	kexp = xpubench_build_kexp(bcase);
+	session = xpubench_build_session(columns, ncols);
+	results = (uint8_t *)xpubench_alloc(num_rows);
+	error = (xpuBenchError *)xpubench_alloc(sizeof(xpuBenchError));
+
+	xpubench_run_setup(session, kexp);
+	xpubench_run_load(session, columns);
+	/* warm-up, then the best of the loops */
+	for (int loop=0; loop <= num_loops; loop++)
+	{
+		double	elapsed;
+
+		memset(error, 0, sizeof(xpuBenchError));
+		elapsed = xpubench_run_exec(session, kexp, columns, results, error);
+		if (loop > 0 && (best < 0.0 || elapsed < best))
+			best = elapsed;
+	}
+
+	/* summary of the results */
+	memset(counts, 0, sizeof(counts));
+	for (uint64_t base=0; base < num_rows; base += XPUBENCH_GROUP_SZ)
+	{
+		uint64_t	end = Min(base + XPUBENCH_GROUP_SZ, num_rows);
+		uint32_t	mask = 0;
+
+		for (uint64_t row=base; row < end; row++)
+		{
+			counts[results[row]]++;
+			mask |= (1U << results[row]);
+		}
+		if ((mask & (mask - 1)) != 0)
+			ndiverged++;
+		ngroups++;
+	}
+	printf("%-24s %12.0f %9.2f ",
+		   bcase->name,
+		   (double)num_rows / best,
+		   (best * 1.0e9) / (double)num_rows);
+	if (kexp->exptype == TypeOpCode__bool)
+		printf("%7.2f %7.2f ",
+			   100.0 * (double)counts[XPUBENCH_RES__TRUE] / (double)num_rows,
+			   100.0 * (double)counts[XPUBENCH_RES__FALSE] / (double)num_rows);
+	else
+		printf("%7s %7s ", "-", "-");
+	printf("%7.2f %7.2f %7.2f\n",
+		   100.0 * (double)counts[XPUBENCH_RES__NULL] / (double)num_rows,
+		   100.0 * (double)counts[XPUBENCH_RES__ERROR] / (double)num_rows,
+		   100.0 * (double)ndiverged / (double)ngroups);
+	if (error->count > 0)
+		printf("    (errcode=%u at line %u: %s)\n",
+			   error->errcode, error->lineno, error->message);
+	fflush(stdout);
+
+	for (int j=0; j < ncols; j++)
+		xpubench_free(columns[j].datums);
+	xpubench_free(columns);
+	xpubench_free(kexp);
+	xpubench_free(session);
+	xpubench_free(results);
+	xpubench_free(error);
+}
+
+static void
+usage(const char *argv0)
+{
+	fprintf(stderr,
+			"usage: %s [OPTIONS] [<case name pattern> ...]\n"
+			"\n"
+			"OPTIONS:\n"
+			"  -n, --nrows=NROWS         number of rows (default: 4000000)\n"
+			"  -l, --loops=NLOOPS        number of measurement loops (default: 5)\n"
+			"  -N, --null-ratio=RATIO    ratio of NULLs in [0.0, 1.0] (default: 0.0)\n"
+			"  -s, --seed=SEED           seed of the random values\n"
+#ifdef __CUDACC__
+			"  -d, --device=DINDEX       GPU device index (default: 0)\n"
+#else
+			"  -t, --threads=NTHREADS    number of worker threads (default: ncpus)\n"
+#endif
+			"  -L, --list                list of the benchmark cases\n"
+			"  -h, --help                shows this message\n",
+			argv0);
+	exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+	static struct option long_options[] = {
+		{"nrows",      required_argument, NULL, 'n'},
+		{"loops",      required_argument, NULL, 'l'},
+		{"null-ratio", required_argument, NULL, 'N'},
+		{"seed",       required_argument, NULL, 's'},
+		{"device",     required_argument, NULL, 'd'},
+		{"threads",    required_argument, NULL, 't'},
+		{"list",       no_argument,       NULL, 'L'},
+		{"help",       no_argument,       NULL, 'h'},
+		{NULL, 0, NULL, 0},
+	};
+	bool		list_only = false;
+	int			c;
+
+	while ((c = getopt_long(argc, argv, "n:l:N:s:d:t:Lh",
+							long_options, NULL)) >= 0)
+	{
+		switch (c)
+		{
+			case 'n':
+				num_rows = strtoul(optarg, NULL, 10);
+				if (num_rows == 0)
+					Elog("invalid -n|--nrows: %s", optarg);
+				break;
+			case 'l':
+				num_loops = atoi(optarg);
+				if (num_loops < 1)
+					Elog("invalid -l|--loops: %s", optarg);
+				break;
+			case 'N':
+				null_ratio = atof(optarg);
+				if (null_ratio < 0.0 || null_ratio > 1.0)
+					Elog("invalid -N|--null-ratio: %s", optarg);
+				break;
+			case 's':
+				random_seed = strtoul(optarg, NULL, 10);
+				break;
+#ifdef __CUDACC__
+			case 'd':
+				cuda_dindex = atoi(optarg);
+				break;
+#else
+			case 't':
+				num_threads = atoi(optarg);
+				if (num_threads < 1)
+					Elog("invalid -t|--threads: %s", optarg);
+				break;
+#endif
+			case 'L':
+				list_only = true;
+				break;
+			default:
+				usage(argv[0]);
+		}
+	}
+	if (list_only)
+	{
+		for (int k=0; xpubench_cases[k].name; k++)
+			printf("%s\n", xpubench_cases[k].name);
+		return 0;
+	}
+
+#ifdef __CUDACC__
+	{
+		cudaDeviceProp	prop;
+
+		__cudaCheck(cudaSetDevice(cuda_dindex), "cudaSetDevice");
+		__cudaCheck(cudaGetDeviceProperties(&prop, cuda_dindex),
+					"cudaGetDeviceProperties");
+		/* INIT_KERNEL_CONTEXT and PostGIS functions consume the stack */
+		__cudaCheck(cudaDeviceSetLimit(cudaLimitStackSize, 16384),
+					"cudaDeviceSetLimit");
+		cuda_num_sms = prop.multiProcessorCount;
+		printf("# device: GPU%d (%s, %d SMs)\n",
+			   cuda_dindex, prop.name, cuda_num_sms);
+	}
+#else
+	if (num_threads < 0)
+		num_threads = Max(sysconf(_SC_NPROCESSORS_ONLN), 1);
+	printf("# device: CPU (%d threads)\n", num_threads);
+#endif
+	printf("# nrows: %lu, loops: %d, null-ratio: %.2f\n",
+		   num_rows, num_loops, null_ratio);
+	printf("%-24s %12s %9s %7s %7s %7s %7s %7s\n",
+		   "case", "rows/s", "ns/row", "true%", "false%",
+		   "null%", "error%", "diverge%");
+	for (int k=0; xpubench_cases[k].name; k++)
+	{
+		const xpuBenchCase *bcase = &xpubench_cases[k];
+
+		if (optind < argc)
+		{
+			bool	matched = false;
+
+			for (int i=optind; i < argc && !matched; i++)
+			{
+				if (strstr(bcase->name, argv[i]) != NULL)
+					matched = true;
+			}
+			if (!matched)
+				continue;
+		}
+		xpubench_run_case(bcase);
+	}
+	return 0;
+}
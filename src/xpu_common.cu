@@ -933,6 +933,302 @@ pgfn_ScalarArrayOp(XPU_PGFUNCTION_ARGS)
 	return true;
 }
 
+/*
+ * ScalarArrayOpHash - 'SCALAR = ANY(constant array)' by the hash set
+ */
+STATIC_FUNCTION(bool)
+pgfn_ScalarArrayOpHash(XPU_PGFUNCTION_ARGS)
+{
+	xpu_bool_t	   *result = (xpu_bool_t *)__result;
+	const kern_saop_hashset *hset = (const kern_saop_hashset *)
+		((const char *)kexp + kexp->u.saop.hset_offset);
+	const kern_saop_hitem *hitems = (const kern_saop_hitem *)
+		((const char *)hset + hset->items_offset);
+	const kern_expression *karg;
+	const kern_expression *kcmp;
+	xpu_datum_t	   *datum;
+	uint32_t		hash;
+
+	assert(kexp->exptype == TypeOpCode__bool &&
+		   kexp->nr_args == 2 &&
+		   kexp->u.saop.elem_slot_id < kcxt->kvars_nslots &&
+		   kexp->u.saop.hset_offset > 0);
+	memset(result, 0, sizeof(xpu_bool_t));
+	/* fetch scalar value */
+	karg = KEXP_FIRST_ARG(kexp);
+	datum = (xpu_datum_t *)alloca(karg->expr_ops->xpu_type_sizeof);
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, datum))
+		return false;
+	/* comparator expression */
+	kcmp = KEXP_NEXT_ARG(karg);
+	assert(KEXP_IS_VALID(kcmp, bool));
+	if (hset->nitems == 0 && !hset->has_nulls)
+	{
+		/* nothing matches to the empty array, even if NULL */
+		result->expr_ops = &xpu_bool_ops;
+		result->value = false;
+		return true;
+	}
+	if (XPU_DATUM_ISNULL(datum))
+		return true;
+	if (!karg->expr_ops->xpu_datum_hash(kcxt, &hash, datum))
+		return false;
+	for (uint32_t index = hset->slots[hash % hset->nslots];
+		 index != 0;
+		 index = hitems[index-1].next)
+	{
+		const kern_saop_hitem *hitem = &hitems[index-1];
+		xpu_bool_t	status;
+
+		if (hitem->hash != hash)
+			continue;
+		/* load the array element, then call the comparator */
+		if (!__extract_heap_tuple_attr(kcxt, kexp->u.saop.elem_slot_id,
+									   (const char *)hset + hitem->offset))
+			return false;
+		if (!EXEC_KERN_EXPRESSION(kcxt, kcmp, &status))
+			return false;
+		if (!XPU_DATUM_ISNULL(&status) && status.value)
+		{
+			result->expr_ops = &xpu_bool_ops;
+			result->value = true;
+			return true;
+		}
+	}
+	/* no matched elements, NULL if array contains NULL */
+	if (!hset->has_nulls)
+	{
+		result->expr_ops = &xpu_bool_ops;
+		result->value = false;
+	}
+	return true;
+}
+
+/*
+ * FieldSelectExpr - reference to a sub-field of the composite value
+ *
+ * u.fsel.src_slot_id is a temporary kvar-slot of the composite type; it is
+ * never loaded, but its sub-field descriptors tell us the type of the
+ * attributes to walk on the heap tuple, and they are also used to extract
+ * the nested array/composite values from the Arrow::Struct.
+ */
+STATIC_FUNCTION(bool)
+__FieldSelectHeap(kern_context *kcxt,
+				  const kern_varslot_desc *vs_desc,
+				  int fieldnum,
+				  const varlena *value,
+				  xpu_datum_t *result)
+{
+	const HeapTupleHeaderData *htup = (const HeapTupleHeaderData *)value;
+	const kern_varslot_desc *vs_attr = &kcxt->kvars_desc[vs_desc->idx_subfield];
+	const char *addr = NULL;
+	uint32_t	offset;
+	int			ncols;
+	bool		heap_hasnull;
+
+	if (VARATT_IS_EXTENDED(value))
+	{
+		STROM_CPU_FALLBACK(kcxt, "composite datum is compressed or external");
+		return false;
+	}
+	ncols = (htup->t_infomask2 & HEAP_NATTS_MASK);
+	heap_hasnull = ((htup->t_infomask & HEAP_HASNULL) != 0);
+	offset = htup->t_hoff;
+	for (int j=0; j < fieldnum; j++, vs_attr++)
+	{
+		if (j >= ncols ||
+			(heap_hasnull && att_isnull(j, htup->t_bits)))
+		{
+			addr = NULL;
+			continue;
+		}
+		if (vs_attr->vs_typlen > 0)
+			offset = TYPEALIGN(vs_attr->vs_typalign, offset);
+		else if (!VARATT_NOT_PAD_BYTE((const char *)htup + offset))
+			offset = TYPEALIGN(vs_attr->vs_typalign, offset);
+		addr = ((const char *)htup + offset);
+
+		if (vs_attr->vs_typlen > 0)
+			offset += vs_attr->vs_typlen;
+		else if (vs_attr->vs_typlen == -1)
+			offset += VARSIZE_ANY(addr);
+		else
+		{
+			STROM_ELOG(kcxt, "not a supported attribute length");
+			return false;
+		}
+	}
+	vs_attr = &kcxt->kvars_desc[vs_desc->idx_subfield + fieldnum - 1];
+	if (!addr)
+		result->expr_ops = NULL;
+	else if (!vs_attr->vs_ops->xpu_datum_heap_read(kcxt, addr, result))
+		return false;
+	return true;
+}
+
+STATIC_FUNCTION(bool)
+pgfn_FieldSelectExpr(XPU_PGFUNCTION_ARGS)
+{
+	const kern_expression *karg = KEXP_FIRST_ARG(kexp);
+	const kern_varslot_desc *vs_desc;
+	int			fieldnum = kexp->u.fsel.fieldnum;
+	xpu_composite_t	cval;
+
+	assert(kexp->nr_args == 1 &&
+		   KEXP_IS_VALID(karg, composite) &&
+		   kexp->u.fsel.src_slot_id < kcxt->kvars_nslots);
+	vs_desc = &kcxt->kvars_desc[kexp->u.fsel.src_slot_id];
+	if (fieldnum < 1 || fieldnum > vs_desc->num_subfield)
+	{
+		STROM_ELOG(kcxt, "FieldSelect: attribute number is out of range");
+		return false;
+	}
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, &cval))
+		return false;
+	if (XPU_DATUM_ISNULL(&cval))
+		__result->expr_ops = NULL;
+	else if (!cval.cmeta)
+	{
+		if (!__FieldSelectHeap(kcxt, vs_desc, fieldnum,
+							   cval.u.heap.value, __result))
+			return false;
+	}
+	else
+	{
+		const kern_colmeta *cmeta = cval.cmeta;
+		const kern_data_store *kds = (const kern_data_store *)
+			((const char *)cmeta - cmeta->kds_offset);
+
+		if (fieldnum > cmeta->num_subattrs)
+			__result->expr_ops = NULL;
+		else if (!__kern_extract_arrow_field(kcxt, kds,
+											 &kds->colmeta[cmeta->idx_subattrs +
+														   fieldnum - 1],
+											 cval.u.arrow.rowidx,
+											 &kcxt->kvars_desc[vs_desc->idx_subfield +
+															   fieldnum - 1],
+											 __result))
+			return false;
+	}
+	return true;
+}
+
+/*
+ * ArraySubscriptExpr - fetch an element of the 1-dimensional array
+ *
+ * Like FieldSelectExpr, u.fsel.src_slot_id is a temporary kvar-slot of the
+ * array type, to describe the array element. Out of range subscript, or
+ * subscript on the multi-dimensional array, returns NULL as PostgreSQL
+ * doing.
+ */
+STATIC_FUNCTION(bool)
+__ArraySubscriptHeap(kern_context *kcxt,
+					 const kern_varslot_desc *vs_elem,
+					 const varlena *value,
+					 int32_t index,
+					 xpu_datum_t *result)
+{
+	const __ArrayTypeData *ar;
+	uint8_t	   *nullmap;
+	char	   *base;
+	uint32_t	offset = 0;
+
+	result->expr_ops = NULL;
+	if (VARATT_IS_EXTERNAL(value) || VARATT_IS_COMPRESSED(value))
+	{
+		STROM_CPU_FALLBACK(kcxt, "array datum is compressed or external");
+		return false;
+	}
+	ar = (const __ArrayTypeData *)VARDATA_ANY(value);
+	if (__pg_array_ndim(ar) != 1)
+		return true;
+	index -= (int32_t)__pg_array_dim(ar, 1);	/* lower bound */
+	if (index < 0 || index >= (int32_t)__pg_array_dim(ar, 0))
+		return true;
+	nullmap = __pg_array_nullmap(ar);
+	base = __pg_array_dataptr(ar);
+	if (nullmap && att_isnull(index, nullmap))
+		return true;
+	if (vs_elem->vs_typlen > 0 && !nullmap)
+	{
+		/* fixed-length elements without NULLs */
+		offset = TYPEALIGN(vs_elem->vs_typalign,
+						   vs_elem->vs_typlen) * index;
+	}
+	else
+	{
+		for (int32_t i=0; i <= index; i++)
+		{
+			if (nullmap && att_isnull(i, nullmap))
+				continue;
+			if (vs_elem->vs_typlen > 0)
+				offset = TYPEALIGN(vs_elem->vs_typalign, offset);
+			else if (!VARATT_NOT_PAD_BYTE(base + offset))
+				offset = TYPEALIGN(vs_elem->vs_typalign, offset);
+			if (i == index)
+				break;
+			if (vs_elem->vs_typlen > 0)
+				offset += vs_elem->vs_typlen;
+			else if (vs_elem->vs_typlen == -1)
+				offset += VARSIZE_ANY(base + offset);
+			else
+			{
+				STROM_ELOG(kcxt, "not a supported attribute length");
+				return false;
+			}
+		}
+	}
+	return vs_elem->vs_ops->xpu_datum_heap_read(kcxt, base + offset, result);
+}
+
+STATIC_FUNCTION(bool)
+pgfn_ArraySubscriptExpr(XPU_PGFUNCTION_ARGS)
+{
+	const kern_expression *karg;
+	const kern_varslot_desc *vs_desc;
+	const kern_varslot_desc *vs_elem;
+	xpu_array_t		aval;
+	xpu_int4_t		ival;
+
+	assert(kexp->nr_args == 2 &&
+		   kexp->u.fsel.src_slot_id < kcxt->kvars_nslots);
+	vs_desc = &kcxt->kvars_desc[kexp->u.fsel.src_slot_id];
+	assert(vs_desc->num_subfield == 1);
+	vs_elem = &kcxt->kvars_desc[vs_desc->idx_subfield];
+	/* fetch array value */
+	karg = KEXP_FIRST_ARG(kexp);
+	assert(KEXP_IS_VALID(karg, array));
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, &aval))
+		return false;
+	/* fetch subscript */
+	karg = KEXP_NEXT_ARG(karg);
+	assert(KEXP_IS_VALID(karg, int4));
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, &ival))
+		return false;
+
+	__result->expr_ops = NULL;
+	if (XPU_DATUM_ISNULL(&aval) || XPU_DATUM_ISNULL(&ival))
+		return true;
+	if (aval.length < 0)
+		return __ArraySubscriptHeap(kcxt, vs_elem,
+									aval.u.heap.value,
+									ival.value, __result);
+	/* Arrow::List; lower bound is always 1 */
+	if (ival.value >= 1 && ival.value <= aval.length)
+	{
+		const kern_colmeta *cmeta = aval.u.arrow.cmeta;
+		const kern_data_store *kds = (const kern_data_store *)
+			((const char *)cmeta - cmeta->kds_offset);
+
+		assert(cmeta->num_subattrs == 1);
+		return __kern_extract_arrow_field(kcxt, kds,
+										  &kds->colmeta[cmeta->idx_subattrs],
+										  aval.u.arrow.start + ival.value - 1,
+										  vs_elem, __result);
+	}
+	return true;
+}
+
 /* ----------------------------------------------------------------
  *
  * Routines to support Projection
@@ -1039,6 +1335,180 @@ kern_form_heaptuple(kern_context *kcxt,
 	return t_hoff;	
 }
 
+/*
+ * kern_estimate_columnar_row
+ *
+ * It returns the length of the varlena heap to be consumed by the projection
+ * result in KDS_FORMAT_COLUMN at most, or -1 on errors. Because the values
+ * may be shared by the dictionary, the actual usage is equal or less than.
+ */
+PUBLIC_FUNCTION(int)
+kern_estimate_columnar_row(kern_context *kcxt,
+						   const kern_expression *kexp_proj,
+						   const kern_data_store *kds_dst)
+{
+	int			nattrs = kexp_proj->u.proj.nattrs;
+	int			total_sz = 0;
+
+	assert(kds_dst->format == KDS_FORMAT_COLUMN);
+	if (kds_dst->ncols < nattrs)
+		nattrs = kds_dst->ncols;
+	for (int j=0; j < nattrs; j++)
+	{
+		const kern_colmeta *cmeta_dst = &kds_dst->colmeta[j];
+		uint16_t		slot_id = kexp_proj->u.proj.slot_id[j];
+		xpu_datum_t	   *xdatum;
+		int				sz;
+
+		if (cmeta_dst->attlen > 0)
+			continue;
+		assert(slot_id < kcxt->kvars_nslots && cmeta_dst->attlen == -1);
+		xdatum = kcxt->kvars_slot[slot_id];
+		if (XPU_DATUM_ISNULL(xdatum))
+			continue;
+		sz = xdatum->expr_ops->xpu_datum_write(kcxt, NULL, cmeta_dst, xdatum);
+		if (sz < 0)
+			return -1;
+		total_sz += MAXALIGN(sz);
+	}
+	return total_sz;
+}
+
+/*
+ * __kern_form_columnar_varlena
+ */
+STATIC_FUNCTION(bool)
+__kern_form_columnar_varlena(kern_context *kcxt,
+							 const kern_colmeta *cmeta_dst,
+							 kern_data_store *kds_dst,
+							 xpu_datum_t *xdatum,
+							 uint32_t rowid)
+{
+	uint32_t   *values = (uint32_t *)((char *)kds_dst +
+									  __kds_unpack(cmeta_dst->values_offset));
+	uint32_t   *dict_slot = NULL;
+	uint32_t	dist;
+	char	   *addr;
+	int			sz;
+	union {
+		uint64_t	__align;
+		char		data[KDS_COLUMN_DICT_MAXLEN];
+	} temp;
+
+	sz = xdatum->expr_ops->xpu_datum_write(kcxt, NULL, cmeta_dst, xdatum);
+	if (sz < 0)
+		return false;
+	if (sz <= KDS_COLUMN_DICT_MAXLEN && cmeta_dst->extra_length > 0)
+	{
+		uint32_t   *dict = (uint32_t *)((char *)kds_dst +
+										__kds_unpack(cmeta_dst->extra_offset));
+		uint32_t	nslots = __kds_unpack(cmeta_dst->extra_length) / sizeof(uint32_t);
+
+		if (xdatum->expr_ops->xpu_datum_write(kcxt,
+											  temp.data,
+											  cmeta_dst,
+											  xdatum) != sz)
+			return false;
+		dict_slot = dict + pg_hash_any(temp.data, sz) % nslots;
+		dist = __volatileRead(dict_slot);
+		if (dist != 0)
+		{
+			addr = (char *)kds_dst + kds_dst->length - __kds_unpack(dist);
+			if (VARSIZE_ANY(addr) == sz && __memcmp(addr, temp.data, sz) == 0)
+			{
+				/* found an identical value in the dictionary */
+				values[rowid] = dist;
+				return true;
+			}
+		}
+	}
+	/* allocation on the varlena heap; already reserved by the caller */
+	dist = __atomic_add_uint32(&kds_dst->column_vl_usage,
+							   __kds_packed(MAXALIGN(sz))) + __kds_packed(MAXALIGN(sz));
+	addr = (char *)kds_dst + kds_dst->length - __kds_unpack(dist);
+	if (dict_slot)
+	{
+		memcpy(addr, temp.data, sz);
+#ifdef __CUDACC__
+		__threadfence();
+#endif
+		/* the latest value replaces the older one, if hash collision */
+		__atomic_write_uint32(dict_slot, dist);
+	}
+	else if (xdatum->expr_ops->xpu_datum_write(kcxt,
+											   addr,
+											   cmeta_dst,
+											   xdatum) != sz)
+		return false;
+	values[rowid] = dist;
+	return true;
+}
+
+/*
+ * kern_form_columnar_row
+ *
+ * It writes out the projection result onto the @rowid of the destination
+ * buffer in KDS_FORMAT_COLUMN. Fixed-length values are written to the values
+ * array, and varlena values are written to the varlena heap at the tail (or
+ * shared with the identical value in the dictionary); the caller must have
+ * reserved the heap by kern_estimate_columnar_row() preliminary.
+ * As kern_form_heaptuple(), kcxt->kvars_slot[] must be filled-up by
+ * kern_estimate_heaptuple() preliminary.
+ */
+PUBLIC_FUNCTION(bool)
+kern_form_columnar_row(kern_context *kcxt,
+					   const kern_expression *kexp_proj,
+					   kern_data_store *kds_dst,
+					   uint32_t rowid)
+{
+	int			nattrs = kexp_proj->u.proj.nattrs;
+	uint32_t	mask = (1U << (rowid & 31));
+
+	assert(kds_dst->format == KDS_FORMAT_COLUMN &&
+		   rowid < kds_dst->column_nrooms);
+	if (kds_dst->ncols < nattrs)
+		nattrs = kds_dst->ncols;
+	for (int j=0; j < nattrs; j++)
+	{
+		const kern_colmeta *cmeta_dst = &kds_dst->colmeta[j];
+		uint16_t		slot_id = kexp_proj->u.proj.slot_id[j];
+		xpu_datum_t	   *xdatum;
+		uint32_t	   *nullmap;
+
+		assert(slot_id < kcxt->kvars_nslots && cmeta_dst->attlen != 0);
+		xdatum = kcxt->kvars_slot[slot_id];
+		nullmap = (uint32_t *)((char *)kds_dst +
+							   __kds_unpack(cmeta_dst->nullmap_offset)) + (rowid>>5);
+		if (XPU_DATUM_ISNULL(xdatum))
+			__atomic_and_uint32(nullmap, ~mask);
+		else if (cmeta_dst->attlen < 0)
+		{
+			if (!__kern_form_columnar_varlena(kcxt,
+											  cmeta_dst,
+											  kds_dst,
+											  xdatum,
+											  rowid))
+				return false;
+			__atomic_or_uint32(nullmap, mask);
+		}
+		else
+		{
+			uint32_t	unitsz = TYPEALIGN(cmeta_dst->attalign,
+										   cmeta_dst->attlen);
+			char	   *buffer = ((char *)kds_dst +
+								  __kds_unpack(cmeta_dst->values_offset) +
+								  unitsz * rowid);
+			if (xdatum->expr_ops->xpu_datum_write(kcxt,
+												  buffer,
+												  cmeta_dst,
+												  xdatum) < 0)
+				return false;
+			__atomic_or_uint32(nullmap, mask);
+		}
+	}
+	return true;
+}
+
 EXTERN_FUNCTION(int)
 kern_estimate_heaptuple(kern_context *kcxt,
                         const kern_expression *kexp_proj,
@@ -1198,6 +1668,55 @@ pgfn_GiSTEval(XPU_PGFUNCTION_ARGS)
 	return false;
 }
 
+STATIC_FUNCTION(bool)
+pgfn_RangeKeys(XPU_PGFUNCTION_ARGS)
+{
+	STROM_ELOG(kcxt, "pgfn_RangeKeys should not be called as a normal kernel expression");
+	return false;
+}
+
+/*
+ * pgfn_BloomFilter
+ *
+ * It checks the outer hash-value (evaluated at the depth-0) towards the bloom
+ * filter of the inner hash table. 'false' means no inner rows have the same
+ * hash-value, so the outer row never matches in the INNER/SEMI JOIN.
+ */
+STATIC_FUNCTION(bool)
+pgfn_BloomFilter(XPU_PGFUNCTION_ARGS)
+{
+	const kern_expression *karg = KEXP_FIRST_ARG(kexp);
+	xpu_bool_t	   *result = (xpu_bool_t *)__result;
+	kern_multirels *kmrels = kcxt->kmrels;
+	int				dindex = kexp->u.bloom.depth - 1;
+	uint32_t	   *bloom;
+	xpu_int4_t		hash;
+
+	assert(kexp->exptype == TypeOpCode__bool &&
+		   kexp->nr_args == 1 &&
+		   karg->opcode == FuncOpCode__HashValue);
+	result->expr_ops = &xpu_bool_ops;
+	result->value = true;
+	if (!kmrels || dindex < 0 || dindex >= kmrels->num_rels)
+		return true;
+	bloom = KERN_MULTIRELS_BLOOM_FILTER(kmrels, dindex);
+	if (bloom)
+	{
+		uint32_t	mask = kmrels->chunks[dindex].bloom_nbits - 1;
+		uint32_t	h1, h2;
+
+		if (!EXEC_KERN_EXPRESSION(kcxt, karg, &hash))
+			return false;
+		assert(!XPU_DATUM_ISNULL(&hash));
+		h1 = ((uint32_t)hash.value & mask);
+		h2 = (__bloom_filter_hash2((uint32_t)hash.value) & mask);
+		if ((bloom[h1 >> 5] & (1U << (h1 & 0x1f))) == 0 ||
+			(bloom[h2 >> 5] & (1U << (h2 & 0x1f))) == 0)
+			result->value = false;
+	}
+	return true;
+}
+
 STATIC_FUNCTION(bool)
 pgfn_Packed(XPU_PGFUNCTION_ARGS)
 {
@@ -1290,6 +1809,12 @@ kern_extract_gpucache_tuple(kern_context *kcxt,
 		const kern_colmeta *cmeta = &kds->colmeta[vl_desc->vl_resno-1];
 		const char *addr;
 		uint32_t	slot_id = vl_desc->vl_slot_id;
+		union {
+			bool		b;
+			int16_t		i16;
+			int32_t		i32;
+			int64_t		i64;
+		} temp;
 
 		assert(slot_id < kcxt->kvars_nslots);
 		if (!KDS_COLUMN_ITEM_ISNULL(kds, cmeta, kds_index))
@@ -1297,14 +1822,31 @@ kern_extract_gpucache_tuple(kern_context *kcxt,
 			/* base pointer */
 			addr = ((const char *)kds + __kds_unpack(cmeta->values_offset));
 
-			if (cmeta->attlen > 0)
+			if (cmeta->encode_width == KDS_COLUMN_ENCODE_BITMAP)
+			{
+				temp.b = KDS_COLUMN_DECODE_BITMAP(addr, kds_index);
+				addr = (const char *)&temp;
+			}
+			else if (cmeta->encode_width > 0)
+			{
+				int64_t		ival = KDS_COLUMN_DECODE_VALUE(cmeta, addr,
+														   kds_index);
+				if (cmeta->attlen == sizeof(int16_t))
+					temp.i16 = ival;
+				else if (cmeta->attlen == sizeof(int32_t))
+					temp.i32 = ival;
+				else
+					temp.i64 = ival;
+				addr = (const char *)&temp;
+			}
+			else if (cmeta->attlen > 0)
 			{
 				addr += cmeta->attlen * kds_index;
 			}
 			else
 			{
 				addr = ((char *)extra +
-						__kds_unpack(((uint32_t *)addr)[kds_index]));
+						KDS_COLUMN_EXTRA_OFFSETS(kds, cmeta)[kds_index]);
 			}
 		}
 		else
@@ -1338,17 +1880,29 @@ ExecLoadVarsHeapTuple(kern_context *kcxt,
 {
 	if (kexp)
 	{
+		int		nitems = kexp->u.load.nitems;
+		int		proj_nitems = kexp->u.load.proj_nitems;
+
 		assert(kexp->opcode == FuncOpCode__LoadVars &&
 			   kexp->exptype == TypeOpCode__int4 &&
 			   kexp->nr_args == 0 &&
-			   kexp->u.load.depth == depth);
+			   kexp->u.load.depth == depth &&
+			   proj_nitems >= 0 && proj_nitems <= nitems);
 		if (htup)
 		{
+			/* desc[] consists of two groups sorted by resno individually */
 			if (!kern_extract_heap_tuple(kcxt,
 										 kds,
 										 htup,
 										 kexp->u.load.desc,
-										 kexp->u.load.nitems))
+										 nitems - proj_nitems))
+				return false;
+			if (proj_nitems > 0 &&
+				!kern_extract_heap_tuple(kcxt,
+										 kds,
+										 htup,
+										 kexp->u.load.desc + (nitems - proj_nitems),
+										 proj_nitems))
 				return false;
 		}
 		else
@@ -1362,15 +1916,13 @@ ExecLoadVarsHeapTuple(kern_context *kcxt,
 	return true;
 }
 
-PUBLIC_FUNCTION(bool)
-ExecLoadVarsOuterRow(kern_context *kcxt,
-					 const kern_expression *kexp_load_vars,
-					 const kern_expression *kexp_scan_quals,
-					 const kern_data_store *kds,
-					 const HeapTupleHeaderData *htup)
+/*
+ * __ExecLoadVarsCheckScanQuals
+ */
+INLINE_FUNCTION(bool)
+__ExecLoadVarsCheckScanQuals(kern_context *kcxt,
+							 const kern_expression *kexp_scan_quals)
 {
-	/* load the one tuple */
-	ExecLoadVarsHeapTuple(kcxt, kexp_load_vars, 0, kds, htup);
 	/* check scan quals if given */
 	if (kexp_scan_quals)
 	{
@@ -1390,6 +1942,50 @@ ExecLoadVarsOuterRow(kern_context *kcxt,
 	return true;
 }
 
+/*
+ * ExecLoadVarsOuterXXXX
+ *
+ * The LoadVars at depth==0 puts the columns referenced by the scan quals
+ * at the head of desc[], and the last 'proj_nitems' columns are referenced
+ * only by the later steps. These columns are loaded only if the row passed
+ * the scan quals; no need to deform the rows to be filtered out.
+ */
+PUBLIC_FUNCTION(bool)
+ExecLoadVarsOuterRow(kern_context *kcxt,
+					 const kern_expression *kexp_load_vars,
+					 const kern_expression *kexp_scan_quals,
+					 const kern_data_store *kds,
+					 const HeapTupleHeaderData *htup)
+{
+	const kern_varload_desc *vl_desc = NULL;
+	int			nitems = 0;
+	int			proj_nitems = 0;
+
+	if (kexp_load_vars)
+	{
+		assert(kexp_load_vars->opcode == FuncOpCode__LoadVars &&
+			   kexp_load_vars->exptype == TypeOpCode__int4 &&
+			   kexp_load_vars->nr_args == 0 &&
+			   kexp_load_vars->u.load.depth == 0);
+		vl_desc = kexp_load_vars->u.load.desc;
+		nitems = kexp_load_vars->u.load.nitems;
+		proj_nitems = kexp_load_vars->u.load.proj_nitems;
+	}
+	/* load the columns referenced by the scan quals */
+	if (!kern_extract_heap_tuple(kcxt, kds, htup,
+								 vl_desc, nitems - proj_nitems))
+		return false;
+	if (!__ExecLoadVarsCheckScanQuals(kcxt, kexp_scan_quals))
+		return false;
+	/* load the rest columns for the survived row */
+	if (proj_nitems > 0 &&
+		!kern_extract_heap_tuple(kcxt, kds, htup,
+								 vl_desc + (nitems - proj_nitems),
+								 proj_nitems))
+		return false;
+	return true;
+}
+
 PUBLIC_FUNCTION(bool)
 ExecLoadVarsOuterArrow(kern_context *kcxt,
 					   const kern_expression *kexp_load_vars,
@@ -1397,35 +1993,35 @@ ExecLoadVarsOuterArrow(kern_context *kcxt,
 					   const kern_data_store *kds,
 					   uint32_t kds_index)
 {
+	const kern_varload_desc *vl_desc = NULL;
+	int			nitems = 0;
+	int			proj_nitems = 0;
+
 	if (kexp_load_vars)
 	{
 		assert(kexp_load_vars->opcode == FuncOpCode__LoadVars &&
 			   kexp_load_vars->exptype == TypeOpCode__int4 &&
 			   kexp_load_vars->nr_args == 0 &&
 			   kexp_load_vars->u.load.depth == 0);
+		vl_desc = kexp_load_vars->u.load.desc;
+		nitems = kexp_load_vars->u.load.nitems;
+		proj_nitems = kexp_load_vars->u.load.proj_nitems;
 		if (!kern_extract_arrow_tuple(kcxt,
 									  kds,
 									  kds_index,
-									  kexp_load_vars->u.load.desc,
-									  kexp_load_vars->u.load.nitems))
+									  vl_desc,
+									  nitems - proj_nitems))
 			return false;
 	}
-	/* check scan quals if given */
-	if (kexp_scan_quals)
-	{
-		xpu_bool_t	retval;
-
-		if (EXEC_KERN_EXPRESSION(kcxt, kexp_scan_quals, &retval))
-		{
-			if (!XPU_DATUM_ISNULL(&retval) && retval.value)
-				return true;
-		}
-		else
-		{
-			assert(kcxt->errcode != ERRCODE_STROM_SUCCESS);
-		}
+	if (!__ExecLoadVarsCheckScanQuals(kcxt, kexp_scan_quals))
+		return false;
+	if (proj_nitems > 0 &&
+		!kern_extract_arrow_tuple(kcxt,
+								  kds,
+								  kds_index,
+								  vl_desc + (nitems - proj_nitems),
+								  proj_nitems))
 		return false;
-	}
 	return true;
 }
 
@@ -1437,36 +2033,37 @@ ExecLoadVarsOuterColumn(kern_context *kcxt,
 						const kern_data_extra *extra,
 						uint32_t kds_index)
 {
+	const kern_varload_desc *vl_desc = NULL;
+	int			nitems = 0;
+	int			proj_nitems = 0;
+
 	if (kexp_load_vars)
 	{
 		assert(kexp_load_vars->opcode == FuncOpCode__LoadVars &&
 			   kexp_load_vars->exptype == TypeOpCode__int4 &&
 			   kexp_load_vars->nr_args == 0 &&
 			   kexp_load_vars->u.load.depth == 0);
+		vl_desc = kexp_load_vars->u.load.desc;
+		nitems = kexp_load_vars->u.load.nitems;
+		proj_nitems = kexp_load_vars->u.load.proj_nitems;
 		if (!kern_extract_gpucache_tuple(kcxt,
 										 kds,
 										 extra,
 										 kds_index,
-										 kexp_load_vars->u.load.desc,
-										 kexp_load_vars->u.load.nitems))
+										 vl_desc,
+										 nitems - proj_nitems))
 			return false;
 	}
-	/* check scan quals if given */
-	if (kexp_scan_quals)
-	{
-		xpu_bool_t	retval;
-
-		if (EXEC_KERN_EXPRESSION(kcxt, kexp_scan_quals, &retval))
-		{
-			if (!XPU_DATUM_ISNULL(&retval) && retval.value)
-				return true;
-		}
-		else
-		{
-			assert(kcxt->errcode != ERRCODE_STROM_SUCCESS);
-		}
+	if (!__ExecLoadVarsCheckScanQuals(kcxt, kexp_scan_quals))
+		return false;
+	if (proj_nitems > 0 &&
+		!kern_extract_gpucache_tuple(kcxt,
+									 kds,
+									 extra,
+									 kds_index,
+									 vl_desc + (nitems - proj_nitems),
+									 proj_nitems))
 		return false;
-	}
 	return true;
 }
 
@@ -1740,6 +2337,131 @@ restart:
 	return UINT_MAX;	/* no more chance for this outer */
 }
 
+/*
+ * __rtree_lookup_node - returns the node-id that contains the entry
+ */
+INLINE_FUNCTION(uint32_t)
+__rtree_lookup_node(const kern_rtree_index *rtree, uint32_t index)
+{
+	const uint32_t *node_head = (const uint32_t *)KERN_RTREE_ARRAY(rtree, head);
+	uint32_t	head = 0;
+	uint32_t	tail = rtree->nnodes - 1;
+
+	assert(index < rtree->nentries);
+	while (head < tail)
+	{
+		uint32_t	curr = (head + tail + 1) / 2;
+
+		if (node_head[curr] <= index)
+			head = curr;
+		else
+			tail = curr - 1;
+	}
+	return head;
+}
+
+PUBLIC_FUNCTION(uint32_t)
+ExecRTreeIndexGetNext(kern_context *kcxt,
+					  const kern_data_store *kds_hash,
+					  const kern_rtree_index *rtree,
+					  const kern_expression *kexp_gist,
+					  uint32_t l_state)
+{
+	const float	   *r_xmin = (const float *)KERN_RTREE_ARRAY(rtree, xmin);
+	const float	   *r_xmax = (const float *)KERN_RTREE_ARRAY(rtree, xmax);
+	const float	   *r_ymin = (const float *)KERN_RTREE_ARRAY(rtree, ymin);
+	const float	   *r_ymax = (const float *)KERN_RTREE_ARRAY(rtree, ymax);
+	const uint32_t *r_child = (const uint32_t *)KERN_RTREE_ARRAY(rtree, child);
+	const uint32_t *r_head = (const uint32_t *)KERN_RTREE_ARRAY(rtree, head);
+	const uint32_t *r_parent = (const uint32_t *)KERN_RTREE_ARRAY(rtree, parent);
+	const kern_expression *karg_gist;
+	const kern_varload_desc *vl_desc;
+	uint32_t	node;
+	uint32_t	index;
+
+	assert(kds_hash->format == KDS_FORMAT_HASH);
+	assert(kexp_gist->opcode == FuncOpCode__GiSTEval &&
+		   kexp_gist->exptype == TypeOpCode__bool);
+	vl_desc = &kexp_gist->u.gist.ivar_desc;
+	karg_gist = KEXP_FIRST_ARG(kexp_gist);
+	assert(karg_gist->exptype ==  TypeOpCode__bool);
+
+	if (rtree->nentries == 0)
+		return UINT_MAX;	/* empty inner relation */
+	if (l_state == 0)
+	{
+		node = 0;
+		index = r_head[0];
+	}
+	else
+	{
+		/* l_state is the next entry of the last matched leaf */
+		node = __rtree_lookup_node(rtree, l_state - 1);
+		index = l_state;
+	}
+restart:
+	for (; index < r_head[node+1]; index++)
+	{
+		float		bbox[4];
+		xpu_bool_t	status;
+
+		kcxt_reset(kcxt);
+		/* load the bounding-box in the same layout of box2df */
+		bbox[0] = r_xmin[index];
+		bbox[1] = r_xmax[index];
+		bbox[2] = r_ymin[index];
+		bbox[3] = r_ymax[index];
+		if (!__extract_heap_tuple_attr(kcxt, vl_desc->vl_slot_id, (char *)bbox))
+		{
+			assert(kcxt->errcode != ERRCODE_STROM_SUCCESS);
+			return UINT_MAX;
+		}
+		/* runs index-qualifier */
+		if (!EXEC_KERN_EXPRESSION(kcxt, karg_gist, &status))
+		{
+			assert(kcxt->errcode != ERRCODE_STROM_SUCCESS);
+			return UINT_MAX;
+		}
+		/* check result */
+		if (!XPU_DATUM_ISNULL(&status) && status.value)
+		{
+			if (index >= rtree->leaf_base)
+			{
+				const kern_varslot_desc *vs_desc;
+				uint32_t	slot_id = kexp_gist->u.gist.htup_slot_id;
+				const char *addr;
+
+				addr = (const char *)kds_hash + __kds_unpack(r_child[index]);
+				assert(slot_id < kcxt->kvars_nslots);
+				vs_desc = &kcxt->kvars_desc[slot_id];
+				assert(vs_desc->vs_ops == &xpu_internal_ops);
+				if (!vs_desc->vs_ops->xpu_datum_heap_read(kcxt, addr,
+														  kcxt->kvars_slot[slot_id]))
+				{
+					assert(kcxt->errcode != ERRCODE_STROM_SUCCESS);
+					return UINT_MAX;
+				}
+				/* returns the next entry of this leaf */
+				return index + 1;
+			}
+			node = r_child[index];
+			assert(node < rtree->nnodes);
+			index = r_head[node];
+			goto restart;
+		}
+	}
+
+	if (node != 0)
+	{
+		/* pop to the parent node if not found */
+		index = r_parent[node];
+		node = __rtree_lookup_node(rtree, index);
+		index++;
+		goto restart;
+	}
+	return UINT_MAX;	/* no more chance for this outer */
+}
+
 PUBLIC_FUNCTION(bool)
 ExecGiSTIndexPostQuals(kern_context *kcxt,
 					   int depth,
@@ -2199,8 +2921,8 @@ __xpu_composite_arrow_write(kern_context *kcxt,
 	if (htup)
 	{
 		memset(htup, 0, t_hoff);
-		htup->t_choice.t_datum.datum_typmod = cmeta_src->atttypid;
-		htup->t_choice.t_datum.datum_typeid = cmeta_src->atttypmod;
+		htup->t_choice.t_datum.datum_typmod = cmeta_src->atttypmod;
+		htup->t_choice.t_datum.datum_typeid = cmeta_src->atttypid;
 		htup->t_ctid.ip_blkid.bi_hi = 0xffff;	/* InvalidBlockNumber */
 		htup->t_ctid.ip_blkid.bi_lo = 0xffff;
 		htup->t_ctid.ip_posid = 0;				/* InvalidOffsetNumber */
@@ -2455,12 +3177,17 @@ PUBLIC_DATA xpu_function_catalog_entry builtin_xpu_functions_catalog[] = {
 	{FuncOpCode__CaseWhenExpr,				pgfn_CaseWhenExpr},
 	{FuncOpCode__ScalarArrayOpAny,			pgfn_ScalarArrayOp},
 	{FuncOpCode__ScalarArrayOpAll,			pgfn_ScalarArrayOp},
+	{FuncOpCode__ScalarArrayOpHash,			pgfn_ScalarArrayOpHash},
+	{FuncOpCode__FieldSelectExpr,			pgfn_FieldSelectExpr},
+	{FuncOpCode__ArraySubscriptExpr,		pgfn_ArraySubscriptExpr},
 #include "xpu_opcodes.h"
 	{FuncOpCode__Projection,                pgfn_Projection},
 	{FuncOpCode__LoadVars,                  pgfn_LoadVars},
 	{FuncOpCode__MoveVars,					pgfn_MoveVars},
 	{FuncOpCode__HashValue,                 pgfn_HashValue},
 	{FuncOpCode__GiSTEval,                  pgfn_GiSTEval},
+	{FuncOpCode__RangeKeys,                 pgfn_RangeKeys},
+	{FuncOpCode__BloomFilter,               pgfn_BloomFilter},
 	{FuncOpCode__SaveExpr,                  pgfn_SaveExpr},
 	{FuncOpCode__AggFuncs,                  pgfn_AggFuncs},
 	{FuncOpCode__JoinQuals,                 pgfn_JoinQuals},
@@ -2618,3 +3345,173 @@ pg_hash_any(const void *ptr, int sz)
 #undef rot
 #undef mix
 #undef final
+
+/*
+ * Device version of pglz_decompress() in PG host code
+ */
+STATIC_FUNCTION(int32_t)
+__pglz_decompress(const uint8_t *sp, int32_t slen,
+				  uint8_t *dp, int32_t rawsize)
+{
+	const uint8_t  *srcend = sp + slen;
+	uint8_t		   *dest = dp;
+	uint8_t		   *destend = dp + rawsize;
+
+	while (sp < srcend && dp < destend)
+	{
+		uint8_t		ctrl = *sp++;
+
+		for (int ctrlc = 0; ctrlc < 8 && sp < srcend && dp < destend; ctrlc++)
+		{
+			if (ctrl & 1)
+			{
+				int32_t		len;
+				int32_t		off;
+
+				if (sp + 2 > srcend)
+					return -1;
+				len = (sp[0] & 0x0f) + 3;
+				off = ((sp[0] & 0xf0) << 4) | sp[1];
+				sp += 2;
+				if (len == 18)
+				{
+					if (sp >= srcend)
+						return -1;
+					len += *sp++;
+				}
+				if (off == 0 || off > (dp - dest))
+					return -1;
+				len = Min(len, destend - dp);
+				/* source and destination may overlap */
+				for (int i=0; i < len; i++)
+					dp[i] = dp[i - off];
+				dp += len;
+			}
+			else
+			{
+				*dp++ = *sp++;
+			}
+			ctrl >>= 1;
+		}
+	}
+	if (dp != destend || sp != srcend)
+		return -1;
+	return rawsize;
+}
+
+/*
+ * Device version of LZ4_decompress_safe() in liblz4
+ */
+STATIC_FUNCTION(int32_t)
+__lz4_decompress(const uint8_t *ip, int32_t slen,
+				 uint8_t *op, int32_t rawsize)
+{
+	const uint8_t  *iend = ip + slen;
+	uint8_t		   *ostart = op;
+	uint8_t		   *oend = op + rawsize;
+
+	while (ip < iend)
+	{
+		uint8_t		token = *ip++;
+		int32_t		len = (token >> 4);
+		int32_t		off;
+		uint8_t		s;
+
+		/* literals */
+		if (len == 15)
+		{
+			do {
+				if (ip >= iend)
+					return -1;
+				s = *ip++;
+				len += s;
+			} while (s == 255);
+		}
+		if (len > iend - ip || len > oend - op)
+			return -1;
+		memcpy(op, ip, len);
+		ip += len;
+		op += len;
+		if (ip >= iend)
+			break;		/* the last sequence has no match */
+		/* match */
+		if (ip + 2 > iend)
+			return -1;
+		off = (int32_t)ip[0] | ((int32_t)ip[1] << 8);
+		ip += 2;
+		if (off == 0 || off > (op - ostart))
+			return -1;
+		len = (token & 0x0f);
+		if (len == 15)
+		{
+			do {
+				if (ip >= iend)
+					return -1;
+				s = *ip++;
+				len += s;
+			} while (s == 255);
+		}
+		len += 4;		/* MINMATCH */
+		if (len > oend - op)
+			return -1;
+		/* source and destination may overlap */
+		for (int i=0; i < len; i++)
+			op[i] = op[i - off];
+		op += len;
+	}
+	if (op != oend)
+		return -1;
+	return rawsize;
+}
+
+/*
+ * pg_decompress_inline_datum
+ *
+ * It decompresses the inline compressed varlena (pglz or lz4) on the
+ * kcxt->vlbuf, then returns the pointer to the raw data. It returns NULL
+ * if the datum is not inline compressed, or no space left on the vlbuf;
+ * the caller falls back to the CPU in this case.
+ */
+PUBLIC_FUNCTION(const char *)
+pg_decompress_inline_datum(kern_context *kcxt,
+						   const char *addr,
+						   int *p_length)
+{
+	uint32_t	tcinfo;
+	int32_t		rawsize;
+	int32_t		slen;
+	int32_t		nbytes;
+	char	   *buffer;
+
+	if (!VARATT_IS_COMPRESSED(addr))
+		return NULL;
+	memcpy(&tcinfo, addr + VARHDRSZ, sizeof(uint32_t));
+	rawsize = (tcinfo & VARLENA_EXTSIZE_MASK);
+	slen = VARSIZE_4B(addr) - TOAST_COMPRESS_HDRSZ;
+	if (slen < 0)
+		return NULL;
+	/* no space left; it is not an error, but CPU fallback */
+	if ((char *)MAXALIGN(kcxt->vlpos) + rawsize > kcxt->vlend)
+		return NULL;
+	buffer = (char *)kcxt_alloc(kcxt, rawsize);
+	if (!buffer)
+		return NULL;
+	switch (tcinfo >> VARLENA_EXTSIZE_BITS)
+	{
+		case TOAST_PGLZ_COMPRESSION_ID:
+			nbytes = __pglz_decompress((const uint8_t *)addr + TOAST_COMPRESS_HDRSZ,
+									   slen, (uint8_t *)buffer, rawsize);
+			break;
+		case TOAST_LZ4_COMPRESSION_ID:
+			nbytes = __lz4_decompress((const uint8_t *)addr + TOAST_COMPRESS_HDRSZ,
+									  slen, (uint8_t *)buffer, rawsize);
+			break;
+		default:
+			nbytes = -1;
+			break;
+	}
+	if (nbytes != rawsize)
+		return NULL;
+	*p_length = rawsize;
+	return buffer;
+}
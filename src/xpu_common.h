@@ -372,17 +372,23 @@ typedef enum {
 	FuncOpCode__CaseWhenExpr,
 	FuncOpCode__ScalarArrayOpAny,
 	FuncOpCode__ScalarArrayOpAll,
+	FuncOpCode__ScalarArrayOpHash,
+	FuncOpCode__FieldSelectExpr,
+	FuncOpCode__ArraySubscriptExpr,
 #include "xpu_opcodes.h"
 	FuncOpCode__LoadVars = 9999,
 	FuncOpCode__MoveVars,
 	FuncOpCode__JoinQuals,
 	FuncOpCode__HashValue,
 	FuncOpCode__GiSTEval,
+	FuncOpCode__RangeKeys,
+	FuncOpCode__BloomFilter,
 	FuncOpCode__SaveExpr,
 	FuncOpCode__AggFuncs,
 	FuncOpCode__Projection,
 	FuncOpCode__Packed,		/* place-holder for the stacked expressions */
 	FuncOpCode__BuiltInMax,
+	FuncOpCode__UserDefined = 0x40000000,	/* base of extension's functions */
 } FuncOpCode;
 
 /*
@@ -395,6 +401,7 @@ typedef enum {
 #define ERRCODE_RECURSION_TOO_DEEP			5
 #define ERRCODE_BUFFER_NO_SPACE				6
 #define ERRCODE_GPUDIRECT_READFILE_ASYNC	7
+#define ERRCODE_TASK_CANCELLED				8
 #define ERRCODE_DEVICE_INTERNAL				99
 #define ERRCODE_DEVICE_FATAL				999
 
@@ -446,6 +453,7 @@ typedef struct
 	const char	   *error_funcname;
 	const char	   *error_message;
 	struct kern_session_info *session;
+	struct kern_multirels *kmrels;		/* inner buffer, if xPU-Join */
 
 	/* the kernel variables slot */
 	struct xpu_datum_t **kvars_slot;
@@ -570,6 +578,11 @@ kcxt_reset(kern_context *kcxt)
 	kcxt->vlpos = kcxt->vlbuf;
 }
 
+EXTERN_FUNCTION(const char *)
+pg_decompress_inline_datum(kern_context *kcxt,
+						   const char *addr,
+						   int *p_length);
+
 INLINE_FUNCTION(void)
 __strncpy(char *d, const char *s, uint32_t n)
 {
@@ -655,9 +668,30 @@ struct kern_colmeta {
 	uint32_t		values_length;
 	uint32_t		extra_offset;
 	uint32_t		extra_length;
+	/*
+	 * (only arrow format)
+	 * If @dict_index_sz is non-zero, the column is dictionary-encoded.
+	 * values/extra buffers hold the dictionary entries, and the rows are
+	 * mapped to the entries by the index array of @dict_index_sz bytes.
+	 */
+	uint32_t		dict_index_offset;
+	uint32_t		dict_index_length;
+	int8_t			dict_index_sz;
+	/*
+	 * (only column format of GpuCache)
+	 * If @encode_width is positive, the integer value is stored as
+	 * an unsigned delta from @encode_base (frame-of-reference) using
+	 * @encode_width bytes, instead of the native @attlen bytes.
+	 * If KDS_COLUMN_ENCODE_BITMAP, boolean value is stored as a bit of
+	 * the 32bit words, like the nullmap.
+	 */
+	int64_t			encode_base;
+	int8_t			encode_width;
 };
 typedef struct kern_colmeta		kern_colmeta;
 
+#define KDS_COLUMN_ENCODE_BITMAP	(-1)
+
 #define KDS_FORMAT_ROW			'r'		/* normal heap-tuples */
 #define KDS_FORMAT_HASH			'h'		/* inner hash table for HashJoin */
 #define KDS_FORMAT_BLOCK		'b'		/* raw blocks for direct loading */
@@ -686,6 +720,16 @@ struct kern_data_store {
 	uint32_t		block_nloaded;	/* number of blocks already loaded by CPU */
 	/* only KDS_FORMAT_COLUMN */
 	uint32_t		column_nrooms;	/* = max_num_rows parameter */
+	uint32_t		column_index_attnum; /* attnum of the GpuCache index key,
+										  * or 0 if no index */
+	uint32_t		column_index_nslots; /* number of the index hash-slots */
+	uint32_t		column_index_offset; /* offset of the index (PACKED) */
+	uint32_t		column_summary_offset; /* offset of the summary (PACKED),
+											* or 0 if no summary */
+	/* only KDS_FORMAT_COLUMN of columnar projection results */
+	uint32_t		column_vl_offset;	/* head of the varlena heap (PACKED) */
+	uint32_t		column_vl_usage;	/* consumed length of the varlena heap
+										 * from the tail (PACKED) */
 	/* column definition */
 	uint32_t		nr_colmeta;	/* number of colmeta[] array elements;
 								 * maybe, >= ncols, if any composite types */
@@ -781,6 +825,8 @@ typedef struct kern_data_extra		kern_data_extra;
  * We have assumption here - any objects pointed by the offset value
  * is always aligned to MAXIMUM_ALIGNOF boundary (64bit).
  * It means we can use 32bit offset to represent up to 32GB range (35bit).
+ * Only the varlena values in the extra buffer of KDS_FORMAT_COLUMN are
+ * referenced by 64bit offset, thus, not restricted by this limit.
  */
 #define __KDS_LENGTH_LIMIT			(1UL<<35)
 
@@ -1328,6 +1374,43 @@ KDS_ARROW_CHECK_ISNULL(const kern_data_store *kds,
 	return false;
 }
 
+/*
+ * KDS_ARROW_DICT_INDEX - maps the row index to the dictionary entry
+ * for dictionary-encoded columns; UINT_MAX if out of range.
+ */
+INLINE_FUNCTION(uint32_t)
+KDS_ARROW_DICT_INDEX(const kern_data_store *kds,
+					 const kern_colmeta *cmeta,
+					 uint32_t index)
+{
+	const char *base = (const char *)kds + __kds_unpack(cmeta->dict_index_offset);
+	int64_t		dindex;
+
+	Assert(cmeta->dict_index_sz > 0);
+	if (cmeta->dict_index_sz * (index + 1) > __kds_unpack(cmeta->dict_index_length))
+		return UINT_MAX;
+	switch (cmeta->dict_index_sz)
+	{
+		case sizeof(int8_t):
+			dindex = ((const int8_t *)base)[index];
+			break;
+		case sizeof(int16_t):
+			dindex = ((const int16_t *)base)[index];
+			break;
+		case sizeof(int32_t):
+			dindex = ((const int32_t *)base)[index];
+			break;
+		case sizeof(int64_t):
+			dindex = ((const int64_t *)base)[index];
+			break;
+		default:
+			return UINT_MAX;
+	}
+	if (dindex < 0 || dindex >= UINT_MAX)
+		return UINT_MAX;
+	return (uint32_t)dindex;
+}
+
 INLINE_FUNCTION(const void *)
 KDS_ARROW_REF_SIMPLE_DATUM(const kern_data_store *kds,
 						   const kern_colmeta *cmeta,
@@ -1402,6 +1485,39 @@ KDS_ARROW_REF_VARLENA64_DATUM(const kern_data_store *kds,
 	return NULL;
 }
 
+/*
+ * KDS_COLUMN_DECODE_VALUE - fetch a frame-of-reference encoded value
+ */
+INLINE_FUNCTION(int64_t)
+KDS_COLUMN_DECODE_VALUE(const kern_colmeta *cmeta,
+						const char *values,
+						uint32_t rowid)
+{
+	switch (cmeta->encode_width)
+	{
+		case sizeof(uint8_t):
+			return cmeta->encode_base + ((const uint8_t *)values)[rowid];
+		case sizeof(uint16_t):
+			return cmeta->encode_base + ((const uint16_t *)values)[rowid];
+		case sizeof(uint32_t):
+			return cmeta->encode_base + ((const uint32_t *)values)[rowid];
+		default:
+			Assert(false);
+			return 0;
+	}
+}
+
+/*
+ * KDS_COLUMN_DECODE_BITMAP - fetch a bit-packed boolean value
+ */
+INLINE_FUNCTION(bool)
+KDS_COLUMN_DECODE_BITMAP(const char *values, uint32_t rowid)
+{
+	const uint32_t *bitmap = (const uint32_t *)values;
+
+	return (bitmap[rowid>>5] & (1U << (rowid & 31))) != 0;
+}
+
 INLINE_FUNCTION(bool)
 KDS_COLUMN_ITEM_ISNULL(const kern_data_store *kds,
 					   const kern_colmeta *cmeta,
@@ -1420,21 +1536,150 @@ KDS_COLUMN_ITEM_ISNULL(const kern_data_store *kds,
 	return (bitmap[idx] & mask) == 0;
 }
 
+/*
+ * Varlena values of KDS_FORMAT_COLUMN are kept in the kern_data_extra, and
+ * referenced by the array of 64bit offsets from the head of the extra buffer.
+ * Unlike the packed 32bit offset, it is not restricted by __KDS_LENGTH_LIMIT,
+ * so the extra buffer of GpuCache can grow up to the device memory.
+ */
+INLINE_FUNCTION(uint64_t *)
+KDS_COLUMN_EXTRA_OFFSETS(const kern_data_store *kds,
+						 const kern_colmeta *cmeta)
+{
+	Assert(kds->format == KDS_FORMAT_COLUMN && cmeta->attlen == -1);
+	return (uint64_t *)((char *)kds + __kds_unpack(cmeta->values_offset));
+}
+
+/*
+ * Varlena values of the columnar projection results are kept in the varlena
+ * heap at the tail of the KDS, and referenced by the array of 32bit packed
+ * distance from the tail; like the row-index of KDS_FORMAT_ROW, it is not
+ * affected by the compaction on write-back.
+ * During the GPU projection, the extra buffer of each varlena column is
+ * used to the dictionary of the recently written values (uint32 hash-slots
+ * of the distance; 0 means empty), then the identical values shorter than
+ * KDS_COLUMN_DICT_MAXLEN within a chunk share the same copy on the heap.
+ * The dictionary is never sent back to the host.
+ */
+#define KDS_COLUMN_DICT_NSLOTS		4096
+#define KDS_COLUMN_DICT_MAXLEN		256
+
+INLINE_FUNCTION(char *)
+KDS_COLUMN_VARLENA_ADDR(const kern_data_store *kds,
+						const kern_colmeta *cmeta,
+						uint32_t index)
+{
+	const uint32_t *values = (const uint32_t *)
+		((const char *)kds + __kds_unpack(cmeta->values_offset));
+	Assert(kds->format == KDS_FORMAT_COLUMN && cmeta->attlen == -1);
+	return (char *)kds + kds->length - __kds_unpack(values[index]);
+}
+
+/*
+ * GpuCache index
+ *
+ * In case when 'index_key' option is given, GpuCache keeps a hash index of
+ * the key column next to the system column; uint32 hash-slots[nslots] are
+ * followed by uint32 next-links[column_nrooms], and UINT_MAX terminates
+ * the chain. The key values are hashed as int64 after the decoding.
+ */
+#define KDS_COLUMN_INDEX_SLOTS(kds)									\
+	((uint32_t *)((char *)(kds) + __kds_unpack((kds)->column_index_offset)))
+#define KDS_COLUMN_INDEX_NEXTS(kds)									\
+	(KDS_COLUMN_INDEX_SLOTS(kds) + (kds)->column_index_nslots)
+
+INLINE_FUNCTION(uint32_t)
+KDS_COLUMN_INDEX_HASH(int64_t key)
+{
+	uint64_t	hval = (uint64_t)key;
+
+	/* 64bit finalizer of MurmurHash3 */
+	hval ^= (hval >> 33);
+	hval *= 0xff51afd7ed558ccdUL;
+	hval ^= (hval >> 33);
+	hval *= 0xc4ceb9fe1a85ec53UL;
+	hval ^= (hval >> 33);
+	return (uint32_t)hval;
+}
+
 /*
  * GpuCacheSysattr
  *
  * An internal system attribute of GPU cache
  */
+#define GCACHE_SYSATTR_FLAG__SUMMARIZED		0x0001	/* counted by the summary */
+
 struct GpuCacheSysattr
 {
 	uint32_t	xmin;
 	uint32_t	xmax;
 	uint32_t	owner;
 	ItemPointerData ctid;
-	uint16_t	__padding__;	//can be used for t_infomask?
+	uint16_t	flags;			/* one of GCACHE_SYSATTR_FLAG__* */
 };
 typedef struct GpuCacheSysattr	GpuCacheSysattr;
 
+/*
+ * GpuCache summary
+ *
+ * In case when 'summary_key' option is given, GpuCache keeps the group
+ * states of count(*) and sum/count of the 'summary_value' columns by the
+ * key next to the index. They are updated by the REDO-log apply when a row
+ * becomes visible (xmin is frozen) or invisible (xmax is frozen, or the
+ * rowid is overwritten by the later INSERT), so the summary reflects all
+ * the committed rows; GCACHE_SYSATTR_FLAG__SUMMARIZED tracks whether the
+ * row is already counted. The group-slots are open addressing, and never
+ * released even if nitems gets back to zero.
+ */
+#define GPUCACHE_SUMMARY_MAX_NVALUES	8
+
+#define GPUCACHE_SUMMARY_SLOT__EMPTY	0
+#define GPUCACHE_SUMMARY_SLOT__SETUP	1
+#define GPUCACHE_SUMMARY_SLOT__VALID	2
+
+typedef struct
+{
+	uint32_t	state;			/* one of GPUCACHE_SUMMARY_SLOT__* */
+	bool		key_isnull;
+	int64_t		key;			/* int64 form of the key, like the index */
+	int64_t		nitems;			/* count(*) of the group */
+	struct {
+		int64_t		nvalids;	/* count(value) of the group */
+		union {
+			int64_t		ival;	/* for 'i' kind */
+			float8_t	fval;	/* for 'f' kind */
+		} sum;
+	} values[1];
+} kern_gpucache_summary_slot;
+
+typedef struct
+{
+	uint32_t	nslots;			/* number of the group-slots */
+	uint32_t	ngroups;		/* number of the group-slots in use */
+	uint32_t	slot_sz;		/* length of a group-slot */
+	int16_t		key_attnum;
+	int16_t		nvalues;
+	int16_t		value_attnums[GPUCACHE_SUMMARY_MAX_NVALUES];
+	char		value_kinds[GPUCACHE_SUMMARY_MAX_NVALUES];	/* 'i' or 'f' */
+	uint64_t	slots[1];		/* MAXALIGN'ed head of the group-slots */
+} kern_gpucache_summary;
+
+#define GPUCACHE_SUMMARY_SLOT_SZ(nvalues)								\
+	MAXALIGN(offsetof(kern_gpucache_summary_slot, values[(nvalues)]))
+#define GPUCACHE_SUMMARY_LENGTH(nslots,nvalues)							\
+	MAXALIGN(offsetof(kern_gpucache_summary, slots) +					\
+			 (size_t)(nslots) * GPUCACHE_SUMMARY_SLOT_SZ(nvalues))
+#define KDS_COLUMN_SUMMARY(kds)											\
+	((kern_gpucache_summary *)((char *)(kds) +							\
+							   __kds_unpack((kds)->column_summary_offset)))
+
+INLINE_FUNCTION(kern_gpucache_summary_slot *)
+GPUCACHE_SUMMARY_SLOT(const kern_gpucache_summary *gsum, uint32_t index)
+{
+	return (kern_gpucache_summary_slot *)
+		((char *)gsum->slots + (size_t)gsum->slot_sz * index);
+}
+
 /* ----------------------------------------------------------------
  *
  * Definitions of Varlena datum and related (mostly in postgres.h and c.h)
@@ -1541,6 +1786,8 @@ typedef struct toast_compress_header
 	(((toast_compress_header *) (ptr))->tcinfo >> VARLENA_EXTSIZE_BITS)
 
 #define TOAST_COMPRESS_HDRSZ        ((uint32_t)sizeof(toast_compress_header))
+#define TOAST_PGLZ_COMPRESSION_ID	0
+#define TOAST_LZ4_COMPRESSION_ID	1
 #define TOAST_COMPRESS_RAWSIZE(ptr)             \
     (((toast_compress_header *) (ptr))->rawsize)
 #define TOAST_COMPRESS_RAWDATA(ptr)             \
@@ -1976,6 +2223,9 @@ typedef struct
 												 * no locale configuration */
 #define DEVKERN__SESSION_TIMEZONE	0x00000200U	/* Device function needs session
 												 * timezone */
+#define DEVFUNC__LOCALE_CTYPE		0x00000400U	/* Device function depends on
+												 * LC_CTYPE, thus, available only
+												 * if "C" or libc on UTF-8 */
 #define DEVTYPE__HAS_COMPARE		0x00000800U	/* Device type has compare handler */
 #define DEVTASK__SCAN				0x10000000U	/* xPU-Scan */
 #define DEVTASK__JOIN				0x20000000U	/* xPU-Join */
@@ -2104,10 +2354,17 @@ typedef bool  (*xpu_function_t)(XPU_PGFUNCTION_ARGS);
 #define KAGG_ACTION__PMAX_FP64		404		/* <int4>,<float8> - max value */
 #define KAGG_ACTION__PSUM_INT		501		/* <int8> - sum of values */
 #define KAGG_ACTION__PSUM_FP		503		/* <float8> - sum of values */
+#define KAGG_ACTION__PSUM_NUMERIC	504		/* <int4>x4,<int128> - sum of fixed-point
+											 * numeric values */
+#define KAGG_ACTION__PSUM_INT128	505		/* same as PSUM_NUMERIC (scale=0) */
 #define KAGG_ACTION__PAVG_INT		601		/* <int4>,<int8> - NROWS+PSUM */
 #define KAGG_ACTION__PAVG_FP		602		/* <int4>,<float8> - NROWS+PSUM */
+#define KAGG_ACTION__PAVG_NUMERIC	603		/* same as PSUM_NUMERIC */
+#define KAGG_ACTION__PAVG_INT128	604		/* same as PSUM_NUMERIC (scale=0) */
 #define KAGG_ACTION__STDDEV			701		/* <int4>,<float8>,<float8> - stddev */
 #define KAGG_ACTION__COVAR			801		/* <int4>,<float8>x5 - covariance */
+#define KAGG_ACTION__PCTILE_FP		901		/* <int4>,<float8>x2,<int4>x(1+N) -
+											 * log-scale histogram for percentile */
 
 typedef struct
 {
@@ -2137,6 +2394,41 @@ typedef struct
 	float8_t	sum;
 } kagg_state__psum_fp_packed;
 
+/*
+ * Sum of fixed-point numeric
+ *
+ * numeric values with typmod (like numeric(18,2)) are accumulated as 128bit
+ * integer scaled by 10^scale, so SUM/AVG are exact and run by integer atomic
+ * operations. The sum is kept as a pair of 64bit words, because 128bit
+ * atomic add is not available; carry of the lower word is propagated to the
+ * upper word. KAGG_NUMERIC_FIXED_MAX_PRECISION is chosen so that sum of the
+ * upper parts (value >> 32) within a thread-block never overflow int64.
+ */
+#define KAGG_NUMERIC_FIXED_MAX_PRECISION	25
+
+typedef struct
+{
+	int32_t		vl_len_;
+	uint32_t	nitems;
+	int32_t		scale;		/* scale of the fixed-point sum */
+	uint32_t	nnans;		/* number of NaN values */
+	uint64_t	sum_lo;
+	int64_t		sum_hi;
+} kagg_state__psum_numeric_packed;
+
+INLINE_FUNCTION(int128_t)
+__kagg_psum_numeric_get_sum(const kagg_state__psum_numeric_packed *r)
+{
+	return (((int128_t)r->sum_hi) << 64) | (int128_t)r->sum_lo;
+}
+
+INLINE_FUNCTION(void)
+__kagg_psum_numeric_set_sum(kagg_state__psum_numeric_packed *r, int128_t sum)
+{
+	r->sum_lo = (uint64_t)sum;
+	r->sum_hi = (int64_t)(sum >> 64);
+}
+
 typedef struct
 {
 	int32_t		vl_len_;
@@ -2156,11 +2448,86 @@ typedef struct
 	float8_t	sum_xy;
 } kagg_state__covar_packed;
 
+/*
+ * Approximate percentile sketch
+ *
+ * It is a log-scale histogram; every power of two between 2^KAGG_PCTILE_EXP_MIN
+ * and 2^(KAGG_PCTILE_EXP_MIN + KAGG_PCTILE_EXP_NUMS) is split into
+ * 2^KAGG_PCTILE_SUB_BITS buckets by the upper mantissa bits, so the relative
+ * error of the estimated value is less than 1/2^(KAGG_PCTILE_SUB_BITS+1).
+ * Smaller values are counted as zero, and larger values are counted on the
+ * last bucket. Min/Max values are exact, so the estimation is clamped by them.
+ * Its fixed length and bucket-wise counters make the sketch mergeable by
+ * atomic operations on the device.
+ */
+#define KAGG_PCTILE_EXP_MIN			(-24)
+#define KAGG_PCTILE_EXP_NUMS		64
+#define KAGG_PCTILE_SUB_BITS		3
+#define KAGG_PCTILE_NBUCKETS		(KAGG_PCTILE_EXP_NUMS << KAGG_PCTILE_SUB_BITS)
+
+typedef struct
+{
+	int32_t		vl_len_;
+	uint32_t	nitems;
+	float8_t	min_value;
+	float8_t	max_value;
+	uint32_t	nzeros;
+	uint32_t	__padding__;
+	uint32_t	negative[KAGG_PCTILE_NBUCKETS];
+	uint32_t	positive[KAGG_PCTILE_NBUCKETS];
+} kagg_state__pctile_packed;
+
+/*
+ * __kagg_pctile_bucket_index - returns the bucket index of abs(fval),
+ * or -1 if it should be considered as zero.
+ */
+INLINE_FUNCTION(int)
+__kagg_pctile_bucket_index(float8_t fval)
+{
+	union {
+		float8_t	fval;
+		uint64_t	ival;
+	} u;
+	int		exp;
+
+	u.fval = fval;
+	u.ival &= ~(1UL << 63);		/* clear sign bit */
+	exp = (int)((u.ival >> 52) & 0x7ffU) - 1023;
+	if (exp < KAGG_PCTILE_EXP_MIN)
+		return -1;
+	if (exp >= KAGG_PCTILE_EXP_MIN + KAGG_PCTILE_EXP_NUMS)
+		return KAGG_PCTILE_NBUCKETS - 1;
+	return (((exp - KAGG_PCTILE_EXP_MIN) << KAGG_PCTILE_SUB_BITS) |
+			(int)((u.ival >> (52 - KAGG_PCTILE_SUB_BITS)) &
+				  ((1U << KAGG_PCTILE_SUB_BITS) - 1)));
+}
+
+/*
+ * __kagg_pctile_bucket_value - returns the middle value of the bucket
+ */
+INLINE_FUNCTION(float8_t)
+__kagg_pctile_bucket_value(int index)
+{
+	union {
+		float8_t	fval;
+		uint64_t	ival;
+	} u;
+	uint64_t	exp = (index >> KAGG_PCTILE_SUB_BITS) + KAGG_PCTILE_EXP_MIN + 1023;
+	uint64_t	sub = (index & ((1U << KAGG_PCTILE_SUB_BITS) - 1));
+
+	/* 2^exp * (1.0 + (sub + 0.5) / 2^KAGG_PCTILE_SUB_BITS) */
+	u.ival = ((exp << 52) |
+			  (sub << (52 - KAGG_PCTILE_SUB_BITS)) |
+			  (1UL << (51 - KAGG_PCTILE_SUB_BITS)));
+	return u.fval;
+}
+
 typedef struct
 {
 	uint32_t	action;			/* any of KAGG_ACTION__* */
 	int32_t		arg0_slot_id;
 	int32_t		arg1_slot_id;
+	int32_t		arg_scale;		/* fixed scale, if PSUM/PAVG_NUMERIC */
 } kern_aggregate_desc;
 
 typedef struct
@@ -2191,6 +2558,27 @@ struct kern_varslot_desc
 	const struct xpu_datum_operators *vs_ops;
 };
 
+/*
+ * kern_saop_hashset - hash set of the constant array elements for
+ * FuncOpCode__ScalarArrayOpHash; probed by the hash of the scalar value,
+ * then the comparator checks the element images of the same hash.
+ */
+typedef struct
+{
+	uint32_t	hash;
+	uint32_t	next;			/* index+1 of the next item, or 0 */
+	uint32_t	offset;			/* offset of the element image */
+} kern_saop_hitem;
+
+typedef struct
+{
+	uint32_t	nslots;
+	uint32_t	nitems;
+	uint32_t	items_offset;	/* offset of kern_saop_hitem[] */
+	bool		has_nulls;		/* array contains NULL elements */
+	uint32_t	slots[1];		/* index+1 of the first item, or 0 */
+} kern_saop_hashset;
+
 #define KERN_EXPRESSION_MAGIC			(0x4b657870)	/* 'K' 'e' 'x' 'p' */
 
 #define KEXP_FLAG__IS_PUSHED_DOWN		0x0001U
@@ -2236,11 +2624,24 @@ struct kern_expression
 		} casewhen;	/* Case-When */
 		struct {
 			uint16_t	elem_slot_id;	/* slot-id of temporary array element */
+			uint32_t	hset_offset;	/* offset of kern_saop_hashset, if
+										 * ScalarArrayOpHash */
 			char		data[1]			__MAXALIGNED__;
 		} saop;		/* ScalarArrayOp */
+		struct {
+			uint16_t	src_slot_id;	/* slot-id of the temporary source
+										 * composite/array; its sub-field
+										 * descriptors are used to extract
+										 * the field or element */
+			int16_t		fieldnum;		/* attribute number, if FieldSelect */
+			char		data[1]			__MAXALIGNED__;
+		} fsel;		/* FieldSelect / ArraySubscript */
 		struct {
 			int			depth;
 			int			nitems;
+			int			proj_nitems;	/* number of the last items that are
+										 * loaded after the scan quals, if
+										 * depth==0 */
 			kern_varload_desc desc[1];
 		} load;		/* VarLoads */
 		struct {
@@ -2256,6 +2657,15 @@ struct kern_expression
 			kern_varload_desc ivar_desc; /* index-var load descriptor */
 			char		data[1]			__MAXALIGNED__;
 		} gist;		/* GiSTEval */
+		struct {
+			bool		has_lower;		/* 1st arg is the lower bound */
+			bool		has_upper;		/* next arg is the upper bound */
+			char		data[1]			__MAXALIGNED__;
+		} range;	/* RangeKeys */
+		struct {
+			int			depth;			/* depth of the inner hash table */
+			char		data[1]			__MAXALIGNED__;
+		} bloom;	/* BloomFilter */
 		struct {
 			uint16_t	sv_slot_id;
 			char		data[1]			__MAXALIGNED__;
@@ -2277,8 +2687,19 @@ struct kern_expression
 	} u;
 };
 
+#ifdef PGSTROM_JIT_KERNELS
+/*
+ * Runtime-specialized kernels (pg_strom.jit_kernels) are built with
+ * a dispatcher function that calls the device functions being used by
+ * the query directly, instead of the indirect call using fn_dptr.
+ */
+EXTERN_FUNCTION(bool)	__jit_exec_kern_expression(XPU_PGFUNCTION_ARGS);
+#define EXEC_KERN_EXPRESSION(__kcxt,__kexp,__retval)	\
+	__jit_exec_kern_expression((__kcxt),(__kexp),(xpu_datum_t *)__retval)
+#else
 #define EXEC_KERN_EXPRESSION(__kcxt,__kexp,__retval)	\
 	(__kexp)->fn_dptr((__kcxt),(__kexp),(xpu_datum_t *)__retval)
+#endif
 
 INLINE_FUNCTION(bool)
 __KEXP_IS_VALID(const kern_expression *kexp,
@@ -2328,6 +2749,36 @@ typedef struct {
 
 EXTERN_DATA xpu_function_catalog_entry	builtin_xpu_functions_catalog[];
 
+/*
+ * Device functions supplied by extensions
+ *
+ * FuncOpCode of the device functions registered by the extensions is
+ * derived from its signature string ("EXTENSION.NAME(ARGS)"), so the host,
+ * GPU-service and DPU-service can identify the same function without any
+ * negotiation. A shared library loaded by dpuserv --extension=LIBRARY
+ * exports xpu_user_functions_catalog[] terminated by NULL signature.
+ */
+#define FuncOpCode__UserDefinedMask		0x00ffffffU
+
+typedef struct {
+	const char	   *func_signature;
+	xpu_function_t	func_dptr;
+} xpu_user_function_catalog_entry;
+
+INLINE_FUNCTION(FuncOpCode)
+xpu_user_function_opcode(const char *func_signature)
+{
+	uint32_t	hash = 2166136261U;		/* FNV-1a */
+
+	for (const char *pos = func_signature; *pos != '\0'; pos++)
+	{
+		hash ^= (uint8_t)*pos;
+		hash *= 16777619U;
+	}
+	return (FuncOpCode)(FuncOpCode__UserDefined |
+						(hash & FuncOpCode__UserDefinedMask));
+}
+
 /* device function hash for xPU service */
 typedef struct xpu_func_hash_entry	xpu_func_hash_entry;
 struct xpu_func_hash_entry
@@ -2348,10 +2799,13 @@ typedef struct
 #define XpuCommandTag__Success				0
 #define XpuCommandTag__Error				1
 #define XpuCommandTag__CPUFallback			2
+#define XpuCommandTag__ResponseStaged		3
 #define XpuCommandTag__SuccessFinal			50
 #define XpuCommandTag__OpenSession			100
 #define XpuCommandTag__XpuTaskExec			110
 #define XpuCommandTag__XpuTaskExecGpuCache	111
+#define XpuCommandTag__XpuTaskExecStaged	112
+#define XpuCommandTag__XpuTaskCancel		118
 #define XpuCommandTag__XpuTaskFinal			119
 #define XpuCommandMagicNumber				0xdeadbeafU
 
@@ -2359,6 +2813,9 @@ typedef struct
  * kern_session_info - A set of immutable data during query execution
  * (like, transaction info, timezone, parameter buffer).
  */
+#define GPUCACHE_BITFILTER_MAX_NKEYS		8
+#define KERN_INNER_CACHE_DIGEST_LEN			32	/* SHA-256 */
+
 typedef struct kern_session_info
 {
 	uint64_t	query_plan_id;		/* unique-id to use per-query buffer */
@@ -2370,13 +2827,28 @@ typedef struct kern_session_info
 	uint32_t	kcxt_extra_bufsz;	/* length of vlbuf[] */
 	uint32_t	cuda_stack_size;	/* estimated stack size */
 	uint32_t	xpu_task_flags;		/* mask of device flags */
+	bool		jit_kernels;		/* prefers runtime-specialized kernels */
+	bool		gpucache_vcols;		/* GpuCache has the virtual columns */
+	uint32_t	gpucache_index_attnum;	/* attnum of the GpuCache index key to
+										 * lookup, or 0 for the full scan */
+	int64_t		gpucache_index_value;	/* key value of the index lookup */
+	/* boolean scan qualifiers evaluated on the bit-packed columns */
+	uint32_t	gpucache_bitfilter_nkeys;
+	int16_t		gpucache_bitfilter_attnums[GPUCACHE_BITFILTER_MAX_NKEYS];
+	bool		gpu_trace;			/* records the execution trace */
+	/* TABLESAMPLE of the source relation */
+	char		tablesample_method;	/* one of KERN_TABLESAMPLE__*, or '\0' */
+	uint32_t	tablesample_seed;	/* hashed seed of the sampling */
+	uint64_t	tablesample_cutoff;	/* hash values less than this are sampled */
 	/* xpucode for this session */
 	uint32_t	xpucode_load_vars_packed;
 	uint32_t	xpucode_move_vars_packed;
 	uint32_t	xpucode_scan_quals;
 	uint32_t	xpucode_join_quals_packed;
 	uint32_t	xpucode_hash_values_packed;
+	uint32_t	xpucode_hash_inner_packed;
 	uint32_t	xpucode_gist_evals_packed;
+	uint32_t	xpucode_range_keys_packed;
 	uint32_t	xpucode_projection;
 	uint32_t	xpucode_groupby_keyhash;
 	uint32_t	xpucode_groupby_keyload;
@@ -2387,36 +2859,159 @@ typedef struct kern_session_info
 	int64_t		hostEpochTimestamp;	/* = SetEpochTimestamp() */
 	uint64_t	xactStartTimestamp;	/* timestamp when transaction start */
 	uint32_t	session_xact_state;	/* offset to SerializedTransactionState */
+	uint32_t	session_snapshot;	/* offset to kern_snapshot_info, if GPU
+									 * checks MVCC visibility of the heap
+									 * pages loaded by GPU-Direct SQL */
 	uint32_t	session_timezone;	/* offset to pg_tz */
 	uint32_t	session_encode;		/* offset to xpu_encode_info;
 									 * !! function pointer must be set by server */
 	int32_t		session_currency_frac_digits;	/* copy of lconv::frac_digits */
+	uint32_t	pgsql_backend_pid;	/* = MyProcPid */
+	uint64_t	gpu_mem_quota;		/* device memory quota in bytes, or 0 */
 
 	/* join inner buffer */
 	uint32_t	pgsql_port_number;	/* = PostPortNumber */
 	uint32_t	pgsql_plan_node_id;	/* = Plan->plan_node_id */
 	uint32_t	join_inner_handle;	/* key of join inner buffer */
+	bool		join_inner_multi_gpu; /* inner buffer is split over GPUs */
+	uint64_t	join_inner_fingerprint; /* key of cached inner buffer, or 0;
+										 * content digest of the inner image
+										 * published for DPU (see below) */
+	uint8_t		join_inner_digest[KERN_INNER_CACHE_DIGEST_LEN];
+									/* SHA-256 of the whole fingerprint of
+									 * the cached inner buffer, to check
+									 * hash collision of the key above */
+	uint32_t	join_inner_generation; /* keep the inner buffer for rescan, or 0 */
+
+	/* pinned host staging ring of the chunks */
+	uint32_t	staging_ring_handle; /* shmem handle of the ring, or 0 */
+
+	/* GPU top-k for ORDER BY ... LIMIT */
+	uint32_t	gpusort_limit;		/* number of rows to keep, or 0 */
+	int16_t		gpusort_resno;		/* sort key column of kds_dst */
+	char		gpusort_kind;		/* one of GPUSORT_KIND__* */
+	bool		gpusort_desc;		/* true, if descending order */
+	bool		gpusort_nulls_first; /* true, if NULLS FIRST */
+
+	/* GPU window functions */
+	uint32_t	gpuwin_desc;		/* offset to kern_window_desc, or 0 */
 
 	/* group-by final buffer */
 	uint32_t	groupby_kds_final;	/* header portion of kds_final */
 	uint32_t	groupby_prepfn_bufsz; /* buffer size for preagg functions */
 	float4_t	groupby_ngroups_estimation; /* planne's estimation of ngroups */
+	uint32_t	groupby_nsiblings;	/* number of sibling sessions that share
+									 * the kds_final, or 0 */
+	bool		groupby_streaming;	/* kds_final per task, returned as results */
 	/* executor parameter buffer */
 	uint32_t	nparams;	/* number of parameters */
 	uint32_t	poffset[1];	/* offset of params */
 } kern_session_info;
 
+/*
+ * TABLESAMPLE methods; the sampling of SYSTEM method is run by the host
+ * on the block selection, and BERNOULLI method is run by the device when
+ * the rows are fetched from the heap blocks (KDS_FORMAT_BLOCK).
+ * Both of them reproduce the built-in methods of PostgreSQL.
+ */
+#define KERN_TABLESAMPLE__SYSTEM		's'
+#define KERN_TABLESAMPLE__BERNOULLI		'b'
+
+/*
+ * Kind of the sort key for GPU top-k; the key value is normalized to
+ * an unsigned 64bit integer that keeps the sort order (radix-ordered).
+ */
+#define GPUSORT_KIND__NONE		'\0'
+#define GPUSORT_KIND__INT		'i'		/* int1/2/4/8, date, time, timestamp */
+#define GPUSORT_KIND__FLOAT		'f'		/* float4/8 */
+
+/*
+ * GPU window functions; result chunks are kept in the per-query buffer
+ * until XpuTaskFinal, then they are sorted by the PARTITION BY + ORDER BY
+ * keys, and the window functions are written to the placeholder columns
+ * located at the tail of the tuples.
+ */
+#define KWIN_ACTION__ROW_NUMBER		101		/* <int8> - row_number() */
+#define KWIN_ACTION__RANK			102		/* <int8> - rank() */
+#define KWIN_ACTION__DENSE_RANK		103		/* <int8> - dense_rank() */
+#define KWIN_ACTION__NROWS_ANY		201		/* <int8> - count(*) */
+#define KWIN_ACTION__NROWS_COND		202		/* <int8> - count(X) */
+#define KWIN_ACTION__PMIN_INT		301		/* <int2/4/8> - min(X) */
+#define KWIN_ACTION__PMIN_FP		302		/* <float4/8> - min(X) */
+#define KWIN_ACTION__PMAX_INT		401		/* <int2/4/8> - max(X) */
+#define KWIN_ACTION__PMAX_FP		402		/* <float4/8> - max(X) */
+#define KWIN_ACTION__PSUM_INT		501		/* <int8> - sum(int2/int4) */
+#define KWIN_ACTION__PSUM_FP		502		/* <float4/8> - sum(float4/8) */
+
+#define KWIN_MAX_KEYS			8
+#define KWIN_MAX_FUNCS			32
+
+typedef struct {
+	int16_t		resno;			/* key column of kds_dst */
+	char		kind;			/* one of GPUSORT_KIND__* */
+	bool		desc;			/* true, if descending order */
+	bool		nulls_first;	/* true, if NULLS FIRST */
+} kern_window_key;
+
+typedef struct {
+	int16_t		resno;			/* placeholder column of kds_dst */
+	int16_t		arg_resno;		/* argument column of kds_dst, or 0 */
+	char		arg_kind;		/* one of GPUSORT_KIND__*, if any argument */
+	uint32_t	action;			/* one of KWIN_ACTION__* */
+} kern_window_func;
+
+typedef struct {
+	uint16_t	nkeys;			/* number of PARTITION BY + ORDER BY keys */
+	uint16_t	npart_keys;		/* number of PARTITION BY keys */
+	uint16_t	nfuncs;			/* number of window functions */
+	bool		rows_frame;		/* ROWS frame; elsewhere RANGE frame that
+								 * includes the peer rows of ORDER BY */
+	kern_window_key	keys[KWIN_MAX_KEYS];
+	kern_window_func funcs[1];	/* variable length */
+} kern_window_desc;
+
+/*
+ * kern_shbuf_vector
+ *
+ * List of the shared buffers to be loaded to KDS_FORMAT_BLOCK by DMA from
+ * the host memory registered by the GPU service, instead of the copy on
+ * the command buffer. The backend keeps the buffers pinned until the
+ * response with the same tag. The page heads (PageHeader and line pointers
+ * with invisible items already invalidated) follow the buf_id array, then
+ * they are written over the pages loaded from the shared buffer, because
+ * the line pointers may be modified after the visibility checks.
+ */
+typedef struct {
+	uint64_t	tag;				/* identifier of the pinned buffers */
+	uint32_t	nitems;				/* number of the shared buffers */
+	int32_t		buf_id[1];			/* variable length */
+} kern_shbuf_vector;
+
+#define KDS_SHBUF_HEAD_SZ											\
+	MAXALIGN(SizeOfPageHeaderData + sizeof(ItemIdData) * MaxHeapTuplesPerPage)
+#define KDS_SHBUF_HEADS(shbufs)										\
+	((char *)(shbufs) + MAXALIGN(offsetof(kern_shbuf_vector,			\
+										  buf_id[(shbufs)->nitems])))
+
 typedef struct {
 	uint32_t	kds_src_pathname;	/* offset to const char *pathname */
 	uint32_t	kds_src_iovec;		/* offset to strom_io_vector */
 	uint32_t	kds_src_offset;		/* offset to kds_src */
 	uint32_t	kds_dst_offset;		/* offset to kds_dst */
+	uint32_t	kds_src_shbufs;		/* offset to kern_shbuf_vector */
 	char		data[1]				__MAXALIGNED__;
 } kern_exec_task;
 
+typedef struct {
+	uint32_t	slot_id;			/* slot of the staging ring that keeps
+									 * the XpuTaskExec command, or the
+									 * response of the task */
+} kern_staged_task;
+
 typedef struct {
 	bool		final_plan_node;
 	bool		final_this_device;
+	bool		final_right_outer;	/* GPU may emit RIGHT OUTER JOIN rows */
 	char		data[1]				__MAXALIGNED__;
 } kern_final_task;
 
@@ -2425,15 +3020,28 @@ typedef struct {
 	uint32_t	chunks_nitems;		/* number of kds_dst items */
 	uint32_t	ojmap_offset;		/* offset of outer-join-map */
 	uint32_t	ojmap_length;		/* length of outer-join-map */
+	uint32_t	fallback_nitems;	/* # of rows to be re-executed by CPU;
+									 * KDS of these rows follows kds_dst array */
+	uint64_t	shbuf_tag;			/* tag of kern_shbuf_vector, if any */
 	kern_final_task kfin;			/* copy from XpuTaskFinal if any */
 	bool		final_plan_node;
 	bool		final_this_device;
+	bool		final_right_outer;	/* RIGHT OUTER JOIN rows are already
+									 * emitted by the GPU device */
 	/* statistics */
 	uint32_t	npages_direct_read;	/* # of pages read by GPU-Direct Storage */
 	uint32_t	npages_vfs_read;	/* # of pages read by VFS (fallback) */
 	uint32_t	nitems_raw;		/* # of visible rows kept in the relation */
 	uint32_t	nitems_in;		/* # of result rows in depth-0 after WHERE-clause */
 	uint32_t	nitems_out;		/* # of result rows in final depth before host quals */
+	/* device profiling counters */
+	uint32_t	prof_nkernels;		/* # of kernel launches */
+	uint32_t	prof_nresumes;		/* # of suspend/resume cycles */
+	uint64_t	prof_h2d_bytes;		/* bytes loaded to the device */
+	uint64_t	prof_d2h_bytes;		/* bytes written back from the device */
+	uint32_t	prof_h2d_usec;		/* time to load kds_src */
+	uint32_t	prof_kern_usec;		/* time of kernel execution */
+	float4_t	prof_occupancy;		/* theoretical occupancy (0.0 - 1.0) */
 	uint32_t	num_rels;
 	struct {
 		uint32_t	nitems_gist;/* # of results rows by GiST index (if any) */
@@ -2444,6 +3052,7 @@ typedef struct {
 typedef struct
 {
 	kern_errorbuf		error;		/* original error in kernel space */
+	uint64_t			shbuf_tag;	/* tag of kern_shbuf_vector, if any */
 	/* statistics */
 	uint32_t			npages_direct_read;
 	uint32_t			npages_vfs_read;
@@ -2473,6 +3082,7 @@ typedef struct
 		kern_errorbuf		error;
 		kern_session_info	session;
 		kern_exec_task		task;
+		kern_staged_task	staged;
 		kern_final_task		fin;
 		kern_exec_results	results;
 		kern_cpu_fallback	fallback;
@@ -2590,6 +3200,24 @@ SESSION_KEXP_HASH_VALUE(const kern_session_info *session, int depth)
 	return karg;
 }
 
+INLINE_FUNCTION(kern_expression *)
+SESSION_KEXP_HASH_INNER(const kern_session_info *session, int depth)
+{
+	kern_expression *kexp;
+	kern_expression *karg;
+
+	if (session->xpucode_hash_inner_packed == 0)
+		return NULL;
+	kexp = (kern_expression *)
+		((char *)session + session->xpucode_hash_inner_packed);
+	if (depth < 0)
+		return kexp;
+	karg = __PICKUP_PACKED_KEXP(kexp, depth);
+	assert(!karg || (karg->opcode == FuncOpCode__HashValue &&
+					 karg->exptype == TypeOpCode__int4));
+	return karg;
+}
+
 INLINE_FUNCTION(kern_expression *)
 SESSION_KEXP_GIST_EVALS(const kern_session_info *session, int depth)
 {
@@ -2607,6 +3235,23 @@ SESSION_KEXP_GIST_EVALS(const kern_session_info *session, int depth)
 	return karg;
 }
 
+INLINE_FUNCTION(kern_expression *)
+SESSION_KEXP_RANGE_KEYS(const kern_session_info *session, int depth)
+{
+	kern_expression *kexp;
+	kern_expression *karg;
+
+	if (session->xpucode_range_keys_packed == 0)
+		return NULL;
+	kexp = (kern_expression *)
+		((char *)session + session->xpucode_range_keys_packed);
+	if (depth < 0)
+		return kexp;
+	karg = __PICKUP_PACKED_KEXP(kexp, depth);
+	assert(!karg || karg->opcode == FuncOpCode__RangeKeys);
+	return karg;
+}
+
 INLINE_FUNCTION(kern_expression *)
 SESSION_KEXP_PROJECTION(const kern_session_info *session)
 {
@@ -2681,6 +3326,14 @@ SESSION_KEXP_GROUPBY_ACTIONS(const kern_session_info *session)
 	return kexp;
 }
 
+INLINE_FUNCTION(kern_window_desc *)
+SESSION_WINDOW_DESC(const kern_session_info *session)
+{
+	if (session->gpuwin_desc == 0)
+		return NULL;
+	return (kern_window_desc *)((char *)session + session->gpuwin_desc);
+}
+
 /* see access/transam/xact.c */
 typedef struct
 {
@@ -2701,6 +3354,26 @@ SESSION_XACT_STATE(kern_session_info *session)
 	return (SerializedTransactionState *)((char *)session + session->session_xact_state);
 }
 
+/*
+ * kern_snapshot_info - MVCC snapshot of the query
+ */
+typedef struct {
+	TransactionId	xmin;		/* all XID < xmin are visible to me */
+	TransactionId	xmax;		/* all XID >= xmax are invisible to me */
+	uint32_t		xcnt;		/* # of xact ids in xip[] */
+	uint32_t		subxcnt;	/* # of xact ids in xip[] after xcnt */
+	bool			suboverflowed;	/* subxip[] has overflowed */
+	TransactionId	xip[1];		/* in-progress xact ids, then sub-xact ids */
+} kern_snapshot_info;
+
+INLINE_FUNCTION(kern_snapshot_info *)
+SESSION_SNAPSHOT(kern_session_info *session)
+{
+	if (session->session_snapshot == 0)
+		return NULL;
+	return (kern_snapshot_info *)((char *)session + session->session_snapshot);
+}
+
 INLINE_FUNCTION(struct pg_tz *)
 SESSION_TIMEZONE(kern_session_info *session)
 {
@@ -2803,9 +3476,15 @@ SESSION_ENCODE(kern_session_info *session)
 					continue;											\
 				}														\
 				temp = (XpuCommand *)buffer;							\
+				if (temp->magic != XpuCommandMagicNumber ||				\
+					temp->length < offsetof(XpuCommand, u))				\
+				{														\
+					fprintf(stderr, "[%s] corrupted XpuCommand (magic=%08x, length=%lu)\n", \
+							error_label, temp->magic, temp->length);	\
+					return -1;											\
+				}														\
 				if (temp->length <= offset)								\
 				{														\
-					assert(temp->magic == XpuCommandMagicNumber);		\
 					xcmd = __XPU_PREFIX##AllocCommand(priv, temp->length); \
 					if (!xcmd)											\
 					{													\
@@ -2868,6 +3547,15 @@ EXTERN_FUNCTION(int)
 kern_estimate_heaptuple(kern_context *kcxt,
 						const kern_expression *kproj,
 						const kern_data_store *kds_dst);
+EXTERN_FUNCTION(int)
+kern_estimate_columnar_row(kern_context *kcxt,
+						   const kern_expression *kproj,
+						   const kern_data_store *kds_dst);
+EXTERN_FUNCTION(bool)
+kern_form_columnar_row(kern_context *kcxt,
+					   const kern_expression *kproj,
+					   kern_data_store *kds_dst,
+					   uint32_t rowid);
 EXTERN_FUNCTION(bool)
 ExecLoadVarsHeapTuple(kern_context *kcxt,
 					  const kern_expression *kexp_load_vars,
@@ -2898,12 +3586,47 @@ ExecMoveKernelVariables(kern_context *kcxt,
 						const kern_expression *kexp_move_vars,
                         char *dst_kvec_buffer,
                         int dst_kvec_id);
+
+/*
+ * kern_rtree_index - a compact R-tree for GiST-Index Join by bounding-box
+ *
+ * Nodes are laid out in breadth-first order, and the entries of a node are
+ * stored contiguously, so entries in [leaf_base, nentries) are leaf entries.
+ * Bounding-boxes are kept in separate (SoA) arrays of float, aligned to the
+ * 128-bytes boundary for coalesced loads. The child[] of an internal entry
+ * is the node-id of the child node, and the one of a leaf entry is the
+ * packed offset of the inner tuple (kern_hashitem) in the kds_hash.
+ */
+typedef struct
+{
+	uint64_t	length;
+	uint32_t	nnodes;
+	uint32_t	nentries;
+	uint32_t	leaf_base;		/* first entry-index of the leaf nodes */
+	uint64_t	xmin_offset;	/* float[nentries] */
+	uint64_t	xmax_offset;	/* float[nentries] */
+	uint64_t	ymin_offset;	/* float[nentries] */
+	uint64_t	ymax_offset;	/* float[nentries] */
+	uint64_t	child_offset;	/* uint32_t[nentries] */
+	uint64_t	head_offset;	/* uint32_t[nnodes+1]; first entry of node */
+	uint64_t	parent_offset;	/* uint32_t[nnodes]; parent entry of node */
+} kern_rtree_index;
+
+#define KERN_RTREE_ARRAY(rtree,field)					\
+	((void *)((char *)(rtree) + (rtree)->field##_offset))
+
 EXTERN_FUNCTION(uint32_t)
 ExecGiSTIndexGetNext(kern_context *kcxt,
 					 const kern_data_store *kds_hash,
 					 const kern_data_store *kds_gist,
 					 const kern_expression *kexp_gist,
 					 uint32_t l_state);
+EXTERN_FUNCTION(uint32_t)
+ExecRTreeIndexGetNext(kern_context *kcxt,
+					  const kern_data_store *kds_hash,
+					  const kern_rtree_index *rtree,
+					  const kern_expression *kexp_gist,
+					  uint32_t l_state);
 EXTERN_FUNCTION(bool)
 ExecGiSTIndexPostQuals(kern_context *kcxt,
 					   int depth,
@@ -2954,6 +3677,304 @@ pg_hash_merge(uint32_t hash_prev, uint32_t hash_next)
  *
  * ----------------------------------------------------------------
  */
+/*
+ * kern_hash_heavy - runs of the heavy-hitter keys on the inner hash table
+ *
+ * Inner rows of the heavy-hitter hash values are not linked to the hash
+ * slot chain, but stored as runs of consecutive rowids. The GPU kernel
+ * splits the runs over the threads of the block, instead of walking on
+ * the long hash chain by a single thread.
+ */
+#define KERN_HASH_HEAVY_NSLOTS		512
+#define KERN_HASH_HEAVY_NRUNS		256
+typedef struct
+{
+	uint32_t	nruns;
+	struct {
+		uint32_t	hash;
+		uint32_t	run_id;		/* 1-origin index of the first run, or 0 */
+	} slots[KERN_HASH_HEAVY_NSLOTS];
+	struct {
+		uint32_t	head;		/* first rowid of the run */
+		uint32_t	tail;		/* last rowid + 1 */
+		uint32_t	next;		/* 1-origin index of the next run, or 0 */
+	} runs[KERN_HASH_HEAVY_NRUNS];
+} kern_hash_heavy;
+
+/*
+ * KERN_HASH_HEAVY_LOOKUP - returns the first run of the hash, or 0
+ */
+INLINE_FUNCTION(uint32_t)
+KERN_HASH_HEAVY_LOOKUP(const kern_hash_heavy *heavy, uint32_t hash)
+{
+	uint32_t	index = hash % KERN_HASH_HEAVY_NSLOTS;
+
+	for (int loop=0; loop < KERN_HASH_HEAVY_NSLOTS; loop++)
+	{
+		if (heavy->slots[index].run_id == 0)
+			break;
+		if (heavy->slots[index].hash == hash)
+			return heavy->slots[index].run_id;
+		index = (index + 1) % KERN_HASH_HEAVY_NSLOTS;
+	}
+	return 0;
+}
+
+/*
+ * kern_hash_bucket - bucketized index of the inner hash table
+ *
+ * Hash values (tags) of the inner rows are stored contiguously for each
+ * hash-slot, and the offsets of kern_hashitem are stored in the separate
+ * array. A probe reads the tags of the bucket sequentially, and touches
+ * kern_hashitem only if the tag matches, instead of walking the hash chain
+ * by the dependent random loads.
+ * Hash chain is still kept for the CPU fallback and other consumers.
+ *
+ * +--------------------------+
+ * | start[nslots + 1]        |  index of the first tag of each hash-slot
+ * +--------------------------+
+ * | tags[nrooms]             |  hash value of the inner rows
+ * +--------------------------+
+ * | items[nrooms]            |  offset of kern_hashitem (same as hash-slot)
+ * +--------------------------+
+ */
+typedef struct
+{
+	uint32_t	nslots;		/* 0, if not built yet */
+	uint32_t	nrooms;
+	uint32_t	nitems;
+	uint32_t	start[1];	/* variable length */
+} kern_hash_bucket;
+
+#define KERN_HASH_BUCKET_LENGTH(nslots,nrooms)							MAXALIGN(offsetof(kern_hash_bucket, start[(nslots) + 1 + 2 * (nrooms)]))
+#define KERN_HASH_BUCKET_TAGS(bucket)									((bucket)->start + (bucket)->nslots + 1)
+#define KERN_HASH_BUCKET_ITEMS(bucket)									((bucket)->start + (bucket)->nslots + 1 + (bucket)->nrooms)
+
+INLINE_FUNCTION(kern_hashitem *)
+__KDS_HASH_BUCKET_SEARCH(const kern_data_store *kds,
+						 const kern_hash_bucket *bucket,
+						 uint32_t hash, uint32_t index)
+{
+	const uint32_t *tags = KERN_HASH_BUCKET_TAGS(bucket);
+	const uint32_t *items = KERN_HASH_BUCKET_ITEMS(bucket);
+	uint32_t	tail = bucket->start[hash % bucket->nslots + 1];
+
+	for (; index < tail; index++)
+	{
+		if (tags[index] == hash)
+			return (kern_hashitem *)((char *)kds
+									 + kds->length
+									 - __kds_unpack(items[index]));
+	}
+	return NULL;
+}
+
+INLINE_FUNCTION(kern_hashitem *)
+KDS_HASH_BUCKET_FIRST_ITEM(const kern_data_store *kds,
+						   const kern_hash_bucket *bucket,
+						   uint32_t hash)
+{
+	return __KDS_HASH_BUCKET_SEARCH(kds, bucket, hash,
+									bucket->start[hash % bucket->nslots]);
+}
+
+INLINE_FUNCTION(kern_hashitem *)
+KDS_HASH_BUCKET_NEXT_ITEM(const kern_data_store *kds,
+						  const kern_hash_bucket *bucket,
+						  const kern_hashitem *khitem)
+{
+	const uint32_t *items = KERN_HASH_BUCKET_ITEMS(bucket);
+	uint32_t	hash = khitem->hash;
+	uint32_t	index = bucket->start[hash % bucket->nslots];
+	uint32_t	tail = bucket->start[hash % bucket->nslots + 1];
+	uint32_t	self = __kds_packed((char *)kds + kds->length - (char *)khitem);
+
+	/* find the current position, then the next item with the same tag */
+	while (index < tail && items[index] != self)
+		index++;
+	return __KDS_HASH_BUCKET_SEARCH(kds, bucket, hash, index + 1);
+}
+
+/*
+ * kern_hash_direct - direct-mapped index of the inner hash table
+ *
+ * If the join key is a single integer column and the inner keys are unique
+ * and dense, items[key - min_value] points kern_hashitem of the key (same
+ * offset as the hash-slot, or 0 if no rows). GPU kernel probes it by the
+ * key value without the hash computation and chain walking.
+ */
+typedef struct
+{
+	int64_t		min_value;
+	uint32_t	nrooms;
+	uint32_t	nitems;		/* 0, if not built (keys are not dense) */
+	uint32_t	items[1];	/* variable length */
+} kern_hash_direct;
+
+#define KERN_HASH_DIRECT_LENGTH(nrooms)									MAXALIGN(offsetof(kern_hash_direct, items[(nrooms)]))
+
+/*
+ * kern_range_index - sorted keys of the inner rows for range-join
+ *
+ * The row-index of the inner KDS_FORMAT_ROW is sorted by the inner key of
+ * the range clauses (inner_key >= lower and/or inner_key <= upper), and
+ * keys[i] is the key of the i-th row; rows with NULL key follow the first
+ * nitems rows. So, GPU kernel picks up the inner rows between the binary-
+ * searched positions, instead of the entire inner rows in the nested-loop.
+ */
+typedef struct
+{
+	uint32_t	nrooms;
+	uint32_t	nitems;		/* number of non-NULL keys; 0, if not built */
+	int64_t		keys[1];	/* variable length */
+} kern_range_index;
+
+#define KERN_RANGE_INDEX_LENGTH(nrooms)									MAXALIGN(offsetof(kern_range_index, keys[(nrooms)]))
+
+INLINE_FUNCTION(bool)
+__rangejoin_fetch_xdatum_as_int64(int64_t *p_ival, const xpu_datum_t *xdatum)
+{
+	if (XPU_DATUM_ISNULL(xdatum))
+		return false;
+	if (xdatum->expr_ops == &xpu_int2_ops)
+		*p_ival = ((const xpu_int2_t *)xdatum)->value;
+	else if (xdatum->expr_ops == &xpu_int4_ops)
+		*p_ival = ((const xpu_int4_t *)xdatum)->value;
+	else if (xdatum->expr_ops == &xpu_int8_ops)
+		*p_ival = ((const xpu_int8_t *)xdatum)->value;
+	else if (xdatum->expr_ops == &xpu_date_ops)
+		*p_ival = ((const xpu_date_t *)xdatum)->value;
+	else if (xdatum->expr_ops == &xpu_timestamp_ops)
+		*p_ival = ((const xpu_timestamp_t *)xdatum)->value;
+	else if (xdatum->expr_ops == &xpu_timestamptz_ops)
+		*p_ival = ((const xpu_timestamptz_t *)xdatum)->value;
+	else
+		return false;
+	return true;
+}
+
+/*
+ * KERN_RANGE_INDEX_LOWER_BOUND - the first position with keys[] >= ival
+ */
+INLINE_FUNCTION(uint32_t)
+KERN_RANGE_INDEX_LOWER_BOUND(const kern_range_index *range, int64_t ival)
+{
+	uint32_t	head = 0;
+	uint32_t	tail = range->nitems;
+
+	while (head < tail)
+	{
+		uint32_t	curr = (head + tail) / 2;
+
+		if (range->keys[curr] < ival)
+			head = curr + 1;
+		else
+			tail = curr;
+	}
+	return head;
+}
+
+/*
+ * kern_inet_index - sorted network prefixes of the inner rows for inet-join
+ *
+ * The row-index of the inner KDS_FORMAT_ROW is sorted by the inner network
+ * key of the containment clauses (inner_key >>= outer, inner_key >> outer
+ * and commuted ones) in the order of (family, masked address, bits), and
+ * items[i] is the prefix of the i-th row; rows with NULL key follow the
+ * first nitems rows. The prefixes are laminar, so all the prefixes that
+ * contain an address are the last prefix with the address less than or
+ * equal to the address, or its ancestors. 'parent' is the index of the
+ * nearest previous prefix that contains the prefix, or UINT_MAX if none.
+ */
+typedef struct
+{
+	uint64_t	addr[2];	/* masked address in big-endian order */
+	uint32_t	parent;		/* nearest enclosing prefix, or UINT_MAX */
+	uint8_t		family;		/* PGSQL_AF_INET or PGSQL_AF_INET6 */
+	uint8_t		bits;		/* number of bits in netmask */
+} kern_inet_index_item;
+
+typedef struct
+{
+	uint32_t	nrooms;
+	uint32_t	nitems;		/* number of non-NULL keys; 0, if not built */
+	kern_inet_index_item items[1];	/* variable length */
+} kern_inet_index;
+
+#define KERN_INET_INDEX_LENGTH(nrooms)									\
+	MAXALIGN(offsetof(kern_inet_index, items[(nrooms)]))
+
+/*
+ * __inetjoin_fetch_address - loads the address of inet as 128bit integer,
+ * then clears the bits under the netmask
+ */
+INLINE_FUNCTION(void)
+__inetjoin_fetch_address(uint64_t addr[2], const inet_struct *inet)
+{
+	int		nbytes = (inet->family == PGSQL_AF_INET ? 4 : 16);
+	int		bits = inet->bits;
+
+	addr[0] = addr[1] = 0;
+	for (int i=0; i < nbytes; i++)
+		addr[i/8] |= ((uint64_t)inet->ipaddr[i] << (56 - 8 * (i % 8)));
+	if (bits < 64)
+	{
+		addr[0] &= (bits == 0 ? 0UL : ~0UL << (64 - bits));
+		addr[1] = 0;
+	}
+	else if (bits < 128)
+	{
+		addr[1] &= (bits == 64 ? 0UL : ~0UL << (128 - bits));
+	}
+}
+
+/*
+ * __inetjoin_item_contains - true, if the prefix contains the network
+ */
+INLINE_FUNCTION(bool)
+__inetjoin_item_contains(const kern_inet_index_item *item,
+						 const inet_struct *inet, const uint64_t addr[2])
+{
+	int		bits = item->bits;
+
+	if (item->family != inet->family || item->bits > inet->bits)
+		return false;
+	if (bits < 64)
+		return (bits == 0 ||
+				((addr[0] ^ item->addr[0]) >> (64 - bits)) == 0);
+	if (addr[0] != item->addr[0])
+		return false;
+	return (bits == 64 ||
+			((addr[1] ^ item->addr[1]) >> (128 - bits)) == 0);
+}
+
+/*
+ * KERN_INET_INDEX_UPPER_BOUND - the first position with the prefix
+ * greater than the supplied family and address
+ */
+INLINE_FUNCTION(uint32_t)
+KERN_INET_INDEX_UPPER_BOUND(const kern_inet_index *inet_index,
+							uint8_t family, const uint64_t addr[2])
+{
+	uint32_t	head = 0;
+	uint32_t	tail = inet_index->nitems;
+
+	while (head < tail)
+	{
+		uint32_t	curr = (head + tail) / 2;
+		const kern_inet_index_item *item = &inet_index->items[curr];
+
+		if (item->family < family ||
+			(item->family == family &&
+			 (item->addr[0] < addr[0] ||
+			  (item->addr[0] == addr[0] && item->addr[1] <= addr[1]))))
+			head = curr + 1;
+		else
+			tail = curr;
+	}
+	return head;
+}
+
 struct kern_multirels
 {
 	size_t		length;
@@ -2963,13 +3984,47 @@ struct kern_multirels
 		uint64_t	kds_offset;		/* offset to KDS */
 		uint64_t	ojmap_offset;	/* offset to outer-join map, if any */
 		uint64_t	gist_offset;	/* offset to GiST-index pages, if any */
+		bool		gist_rtree;		/* true, if gist_offset points to
+									 * the kern_rtree_index, instead of
+									 * the GiST-index pages */
+		uint64_t	bloom_offset;	/* offset to bloom filter bits, if any */
+		uint64_t	prep_geom_offset; /* offset to prepared geometries, if any */
+		uint64_t	heavy_offset;	/* offset to kern_hash_heavy, if any */
+		uint64_t	bucket_offset;	/* offset to kern_hash_bucket, if any */
+		uint64_t	direct_offset;	/* offset to kern_hash_direct, if any */
+		uint64_t	range_offset;	/* offset to kern_range_index, if any */
+		uint64_t	inet_offset;	/* offset to kern_inet_index, if any */
+		uint32_t	bloom_nbits;	/* number of bloom filter bits (2^N) */
 		bool		is_nestloop;	/* true, if NestLoop */
 		bool		left_outer;		/* true, if JOIN_LEFT or JOIN_FULL */
 		bool		right_outer;	/* true, if JOIN_RIGHT or JOIN_FULL */
+		bool		semi_join;		/* true, if JOIN_SEMI */
+		bool		anti_join;		/* true, if JOIN_ANTI */
+		bool		hash_build_on_device; /* true, if GPU builds hash table */
 	} chunks[1];
 };
 typedef struct kern_multirels	kern_multirels;
 
+/*
+ * kern_inner_image
+ *
+ * Header of the read-only inner buffer image published on the directory of
+ * DPU endpoint, named by the content digest. The kern_multirels follows,
+ * compressed by the codec if any. DPU service loads the image on the session
+ * open, then keeps the loaded buffer for the following sessions.
+ */
+#define KERN_INNER_IMAGE_MAGIC			0x524e4e49U		/* 'INNR' */
+#define KERN_INNER_IMAGE_CODEC__NONE	0
+#define KERN_INNER_IMAGE_CODEC__LZ4		1
+#define KERN_INNER_IMAGE_PREFIX			".pgstrom_inner_"
+typedef struct
+{
+	uint32_t	magic;			/* = KERN_INNER_IMAGE_MAGIC */
+	uint32_t	codec;			/* one of KERN_INNER_IMAGE_CODEC__* */
+	uint64_t	digest;			/* content digest of the inner buffer */
+	uint64_t	raw_length;		/* length of the kern_multirels */
+} kern_inner_image;
+
 INLINE_FUNCTION(kern_data_store *)
 KERN_MULTIRELS_INNER_KDS(kern_multirels *kmrels, int dindex)
 {
@@ -3000,6 +4055,92 @@ KERN_MULTIRELS_GIST_INDEX(kern_multirels *kmrels, int dindex)
 	return (kern_data_store *)(offset == 0 ? NULL : ((char *)kmrels + offset));
 }
 
+INLINE_FUNCTION(kern_rtree_index *)
+KERN_MULTIRELS_RTREE_INDEX(kern_multirels *kmrels, int dindex)
+{
+	uint64_t	offset;
+
+	assert(dindex >= 0 && dindex < kmrels->num_rels);
+	assert(kmrels->chunks[dindex].gist_rtree);
+	offset = kmrels->chunks[dindex].gist_offset;
+	return (kern_rtree_index *)(offset == 0 ? NULL : ((char *)kmrels + offset));
+}
+
+INLINE_FUNCTION(kern_hash_heavy *)
+KERN_MULTIRELS_HEAVY_HITTERS(kern_multirels *kmrels, int dindex)
+{
+	uint64_t	offset;
+
+	assert(dindex >= 0 && dindex < kmrels->num_rels);
+	offset = kmrels->chunks[dindex].heavy_offset;
+	return (kern_hash_heavy *)(offset == 0 ? NULL : ((char *)kmrels + offset));
+}
+
+INLINE_FUNCTION(kern_hash_bucket *)
+KERN_MULTIRELS_HASH_BUCKET(kern_multirels *kmrels, int dindex)
+{
+	uint64_t	offset;
+
+	assert(dindex >= 0 && dindex < kmrels->num_rels);
+	offset = kmrels->chunks[dindex].bucket_offset;
+	return (kern_hash_bucket *)(offset == 0 ? NULL : ((char *)kmrels + offset));
+}
+
+INLINE_FUNCTION(kern_hash_direct *)
+KERN_MULTIRELS_HASH_DIRECT(kern_multirels *kmrels, int dindex)
+{
+	uint64_t	offset;
+
+	assert(dindex >= 0 && dindex < kmrels->num_rels);
+	offset = kmrels->chunks[dindex].direct_offset;
+	return (kern_hash_direct *)(offset == 0 ? NULL : ((char *)kmrels + offset));
+}
+
+INLINE_FUNCTION(kern_range_index *)
+KERN_MULTIRELS_RANGE_INDEX(kern_multirels *kmrels, int dindex)
+{
+	uint64_t	offset;
+
+	assert(dindex >= 0 && dindex < kmrels->num_rels);
+	offset = kmrels->chunks[dindex].range_offset;
+	return (kern_range_index *)(offset == 0 ? NULL : ((char *)kmrels + offset));
+}
+
+INLINE_FUNCTION(kern_inet_index *)
+KERN_MULTIRELS_INET_INDEX(kern_multirels *kmrels, int dindex)
+{
+	uint64_t	offset;
+
+	assert(dindex >= 0 && dindex < kmrels->num_rels);
+	offset = kmrels->chunks[dindex].inet_offset;
+	return (kern_inet_index *)(offset == 0 ? NULL : ((char *)kmrels + offset));
+}
+
+INLINE_FUNCTION(uint32_t *)
+KERN_MULTIRELS_BLOOM_FILTER(kern_multirels *kmrels, int dindex)
+{
+	uint64_t	offset;
+
+	assert(dindex >= 0 && dindex < kmrels->num_rels);
+	offset = kmrels->chunks[dindex].bloom_offset;
+	return (uint32_t *)(offset == 0 ? NULL : ((char *)kmrels + offset));
+}
+
+/*
+ * Bloom filter of the inner hash-keys; k=2 bits are picked up from the
+ * hash value and its re-mixed one (the final mix of murmurhash3).
+ */
+INLINE_FUNCTION(uint32_t)
+__bloom_filter_hash2(uint32_t hash)
+{
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bU;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35U;
+	hash ^= hash >> 16;
+	return hash;
+}
+
 /* ----------------------------------------------------------------
  *
  * Atomic Operations
@@ -3330,6 +4471,86 @@ __preagg_fetch_xdatum_as_int64(int64_t *p_ival, const xpu_datum_t *xdatum)
 	return true;
 }
 
+/*
+ * __preagg_fetch_xdatum_as_fixed_numeric
+ *
+ * It fetches numeric datum as an integer scaled by 10^scale. It returns
+ * false if NULL or NaN (*p_isnan is set), or on errors.
+ * int8 datum is also accepted for PSUM/PAVG_INT128; it never overflows
+ * the 128bit accumulator unlike KAGG_ACTION__PSUM_INT.
+ */
+INLINE_FUNCTION(bool)
+__preagg_fetch_xdatum_as_fixed_numeric(kern_context *kcxt,
+									   int128_t *p_ival,
+									   bool *p_isnan,
+									   xpu_datum_t *__xdatum,
+									   int scale)
+{
+	xpu_numeric_t  *xdatum = (xpu_numeric_t *)__xdatum;
+	int128_t		ival;
+	int				weight;
+
+	*p_isnan = false;
+	if (XPU_DATUM_ISNULL(xdatum))
+		return false;
+	if (__xdatum->expr_ops == &xpu_int8_ops)
+	{
+		ival = ((const xpu_int8_t *)__xdatum)->value;
+		while (scale-- > 0)
+			ival *= 10;
+		*p_ival = ival;
+		return true;
+	}
+	assert(xdatum->expr_ops == &xpu_numeric_ops);
+	if (xdatum->kind == XPU_NUMERIC_KIND__VARLENA)
+	{
+		const char *errmsg = __xpu_numeric_from_varlena(xdatum,
+														xdatum->u.vl_addr);
+		if (errmsg)
+		{
+			STROM_ELOG(kcxt, errmsg);
+			return false;
+		}
+	}
+	if (xdatum->kind != XPU_NUMERIC_KIND__VALID)
+	{
+		/* typmod does not allow infinity, so it is NaN */
+		*p_isnan = true;
+		return false;
+	}
+	ival = xdatum->u.value;
+	weight = xdatum->weight;
+	if (weight > scale)
+	{
+		STROM_ELOG(kcxt, "numeric value has larger scale than its typmod");
+		return false;
+	}
+	while (weight < scale)
+	{
+		ival *= 10;
+		weight++;
+	}
+	*p_ival = ival;
+	return true;
+}
+
+/*
+ * __atomic_add_fixed_numeric - 128bit atomic add on a pair of 64bit words
+ */
+INLINE_FUNCTION(void)
+__atomic_add_fixed_numeric(kagg_state__psum_numeric_packed *r, int128_t ival)
+{
+	uint64_t	lo = (uint64_t)ival;
+	int64_t		hi = (int64_t)(ival >> 64);
+	uint64_t	oldval;
+
+	oldval = __atomic_add_uint64(&r->sum_lo, lo);
+	if (oldval + lo < oldval)
+		hi++;		/* carry */
+	if (hi != 0)
+		__atomic_add_int64(&r->sum_hi, hi);
+}
+
 INLINE_FUNCTION(bool)
 __preagg_fetch_xdatum_as_float64(float8_t *p_fval, const xpu_datum_t *xdatum)
 {
@@ -69,6 +69,17 @@ xpu_jsonb_is_valid(kern_context *kcxt, const xpu_jsonb_t *arg)
 {
 	if (arg->length < 0)
 	{
+		xpu_jsonb_t *__arg = (xpu_jsonb_t *)arg;
+		const char *data;
+		int			len;
+
+		data = pg_decompress_inline_datum(kcxt, arg->value, &len);
+		if (data)
+		{
+			__arg->value  = data;
+			__arg->length = len;
+			return true;
+		}
 		STROM_CPU_FALLBACK(kcxt, "jsonb datum is compressed or external");
 		return false;
 	}
@@ -1257,3 +1268,544 @@ JSONB_ARRAY_ELEMENT_AS_INT_TEMPLATE(int8, LONG_MIN, LONG_MAX)
 JSONB_ARRAY_ELEMENT_AS_FLOAT_TEMPLATE(float2, __to_fp16)
 JSONB_ARRAY_ELEMENT_AS_FLOAT_TEMPLATE(float4, __to_fp32)
 JSONB_ARRAY_ELEMENT_AS_FLOAT_TEMPLATE(float8, __to_fp64)
+
+/*
+ * Compiled JSONPath (lax mode) evaluation
+ *
+ * Accessor chain is evaluated in depth-first manner; each item is handed
+ * to the next step immediately, without any sequence buffer. The result
+ * of a chain is three-valued, and TRUE dominates UNKNOWN that dominates
+ * FALSE, like executePredicate() in lax mode.
+ */
+#define JSONPATH_RESULT__ERROR		(-1)
+#define JSONPATH_RESULT__FALSE		0
+#define JSONPATH_RESULT__UNKNOWN	1
+#define JSONPATH_RESULT__TRUE		2
+
+typedef struct {
+	uint32_t	type;		/* one of JENTRY_IS* */
+	uint32_t	length;		/* valid only if string */
+	const char *data;
+} xpu_jsonpath_item;
+
+typedef struct {
+	kern_context   *kcxt;
+	const kern_jsonpath_program *prog;
+	xpu_jsonpath_item root;
+} xpu_jsonpath_context;
+
+INLINE_FUNCTION(uint32_t)
+__jsonpathFetchChild(const JsonbContainer *jc,
+					 const char *base,
+					 uint32_t index,
+					 uint32_t offset,
+					 xpu_jsonpath_item *item)
+{
+	JEntry		entry = __Fetch(&jc->children[index]);
+	uint32_t	next_offset;
+
+	if (JBE_HAS_OFF(entry))
+		next_offset = JBE_OFFLENFLD(entry);
+	else
+		next_offset = offset + JBE_OFFLENFLD(entry);
+	item->type = (entry & JENTRY_TYPEMASK);
+	item->length = next_offset - offset;
+	if (JBE_ISNUMERIC(entry) || JBE_ISCONTAINER(entry))
+		item->data = base + INTALIGN(offset);
+	else
+		item->data = base + offset;
+	return next_offset;
+}
+
+INLINE_FUNCTION(bool)
+__jsonpathItemIsArray(const xpu_jsonpath_item *item)
+{
+	if (JBE_ISCONTAINER(item->type))
+	{
+		const JsonbContainer *jc = (const JsonbContainer *)item->data;
+
+		return JsonContainerIsArray(__Fetch(&jc->header));
+	}
+	return false;
+}
+
+INLINE_FUNCTION(bool)
+__jsonpathItemIsObject(const xpu_jsonpath_item *item)
+{
+	if (JBE_ISCONTAINER(item->type))
+	{
+		const JsonbContainer *jc = (const JsonbContainer *)item->data;
+
+		return JsonContainerIsObject(__Fetch(&jc->header));
+	}
+	return false;
+}
+
+STATIC_FUNCTION(int)
+__jsonpathExecChain(xpu_jsonpath_context *jcxt,
+					int32_t step_id,
+					const xpu_jsonpath_item *item);
+
+STATIC_FUNCTION(int)
+__jsonpathExecPredicate(xpu_jsonpath_context *jcxt,
+						int32_t step_id,
+						const xpu_jsonpath_item *item);
+
+INLINE_FUNCTION(const kern_jsonpath_step *)
+__jsonpathGetStep(xpu_jsonpath_context *jcxt, int32_t step_id)
+{
+	if (step_id < 0 || step_id >= jcxt->prog->nsteps)
+	{
+		STROM_ELOG(jcxt->kcxt, "corrupted jsonpath program");
+		return NULL;
+	}
+	return &jcxt->prog->steps[step_id];
+}
+
+/*
+ * __jsonpathCompareItem - compareItems() of jsonpath_exec.c
+ */
+STATIC_FUNCTION(int)
+__jsonpathCompareItem(xpu_jsonpath_context *jcxt,
+					  const kern_jsonpath_step *step,
+					  const xpu_jsonpath_item *item)
+{
+	const char *cval = KERN_JSONPATH_CONST_AREA(jcxt->prog) + step->const_offset;
+	int32_t		ctype = step->const_type;
+	int32_t		itype;
+	int			comp;
+
+	switch (item->type)
+	{
+		case JENTRY_ISNULL:
+			itype = KERN_JSONPATH_CONST__NULL;
+			break;
+		case JENTRY_ISSTRING:
+			itype = KERN_JSONPATH_CONST__STRING;
+			break;
+		case JENTRY_ISNUMERIC:
+			itype = KERN_JSONPATH_CONST__NUMERIC;
+			break;
+		case JENTRY_ISBOOL_TRUE:
+			itype = KERN_JSONPATH_CONST__BOOL_TRUE;
+			break;
+		case JENTRY_ISBOOL_FALSE:
+			itype = KERN_JSONPATH_CONST__BOOL_FALSE;
+			break;
+		default:
+			itype = 0;		/* container is never comparable */
+			break;
+	}
+	if (itype == KERN_JSONPATH_CONST__BOOL_TRUE ||
+		itype == KERN_JSONPATH_CONST__BOOL_FALSE)
+	{
+		if (ctype != KERN_JSONPATH_CONST__BOOL_TRUE &&
+			ctype != KERN_JSONPATH_CONST__BOOL_FALSE)
+			goto type_mismatch;
+		comp = (itype == ctype ? 0 : (itype == KERN_JSONPATH_CONST__BOOL_TRUE ? 1 : -1));
+	}
+	else if (itype != ctype)
+	{
+		goto type_mismatch;
+	}
+	else if (itype == KERN_JSONPATH_CONST__NULL)
+	{
+		comp = 0;
+	}
+	else if (itype == KERN_JSONPATH_CONST__STRING)
+	{
+		if (step->cmp_op == KERN_JSONPATH_CMP__EQ ||
+			step->cmp_op == KERN_JSONPATH_CMP__NE)
+			comp = (item->length == step->const_len &&
+					memcmp(item->data, cval, item->length) == 0 ? 0 : 1);
+		else
+		{
+			/* host code ensures UTF-8, so binary order is codepoint order */
+			comp = memcmp(item->data, cval, Min(item->length, step->const_len));
+			if (comp == 0)
+				comp = ((int)item->length - (int)step->const_len);
+		}
+	}
+	else
+	{
+		xpu_numeric_t	a, b;
+		const char	   *errmsg;
+
+		assert(itype == KERN_JSONPATH_CONST__NUMERIC);
+		a.expr_ops = &xpu_numeric_ops;
+		b.expr_ops = &xpu_numeric_ops;
+		errmsg = __xpu_numeric_from_varlena(&a, (const varlena *)item->data);
+		if (!errmsg)
+			errmsg = __xpu_numeric_from_varlena(&b, (const varlena *)cval);
+		if (errmsg)
+		{
+			STROM_CPU_FALLBACK(jcxt->kcxt, errmsg);
+			return JSONPATH_RESULT__ERROR;
+		}
+		if (!xpu_numeric_ops.xpu_datum_comp(jcxt->kcxt, &comp,
+											(xpu_datum_t *)&a,
+											(xpu_datum_t *)&b))
+			return JSONPATH_RESULT__ERROR;
+	}
+
+	switch (step->cmp_op)
+	{
+		case KERN_JSONPATH_CMP__EQ:
+			comp = (comp == 0);
+			break;
+		case KERN_JSONPATH_CMP__NE:
+			comp = (comp != 0);
+			break;
+		case KERN_JSONPATH_CMP__LT:
+			comp = (comp < 0);
+			break;
+		case KERN_JSONPATH_CMP__LE:
+			comp = (comp <= 0);
+			break;
+		case KERN_JSONPATH_CMP__GT:
+			comp = (comp > 0);
+			break;
+		case KERN_JSONPATH_CMP__GE:
+			comp = (comp >= 0);
+			break;
+		default:
+			STROM_ELOG(jcxt->kcxt, "corrupted jsonpath program");
+			return JSONPATH_RESULT__ERROR;
+	}
+	return (comp ? JSONPATH_RESULT__TRUE : JSONPATH_RESULT__FALSE);
+
+type_mismatch:
+	if (itype == KERN_JSONPATH_CONST__NULL ||
+		ctype == KERN_JSONPATH_CONST__NULL)
+		return (step->cmp_op == KERN_JSONPATH_CMP__NE
+				? JSONPATH_RESULT__TRUE
+				: JSONPATH_RESULT__FALSE);
+	return JSONPATH_RESULT__UNKNOWN;
+}
+
+/*
+ * __jsonpathExecAccessor - run the step on the item, without auto-unwrap
+ */
+STATIC_FUNCTION(int)
+__jsonpathExecAccessor(xpu_jsonpath_context *jcxt,
+					   const kern_jsonpath_step *step,
+					   const xpu_jsonpath_item *item)
+{
+	const JsonbContainer *jc = (const JsonbContainer *)item->data;
+	xpu_jsonpath_item child;
+	int			status = JSONPATH_RESULT__FALSE;
+	int			rv;
+
+	switch (step->op)
+	{
+		case KERN_JSONPATH_OP__KEY:
+			if (__jsonpathItemIsObject(item))
+			{
+				uint32_t	count = JsonContainerSize(__Fetch(&jc->header));
+				const char *base = (const char *)(jc->children + 2 * count);
+				int32_t		index;
+
+				index = findJsonbIndexFromObject((JsonbContainer *)jc,
+												 KERN_JSONPATH_CONST_AREA(jcxt->prog)
+												 + step->const_offset,
+												 step->const_len);
+				if (index >= 0 && index < count)
+				{
+					index += count;
+					__jsonpathFetchChild(jc, base, index,
+										 getJsonbOffset(jc, index), &child);
+					status = __jsonpathExecChain(jcxt, step->next, &child);
+				}
+			}
+			break;
+
+		case KERN_JSONPATH_OP__ANY_KEY:
+			if (__jsonpathItemIsObject(item))
+			{
+				uint32_t	count = JsonContainerSize(__Fetch(&jc->header));
+				const char *base = (const char *)(jc->children + 2 * count);
+				uint32_t	offset = getJsonbOffset(jc, count);
+
+				for (uint32_t i=count; i < 2 * count; i++)
+				{
+					offset = __jsonpathFetchChild(jc, base, i, offset, &child);
+					rv = __jsonpathExecChain(jcxt, step->next, &child);
+					if (rv < 0)
+						return rv;
+					status = Max(status, rv);
+					if (status == JSONPATH_RESULT__TRUE)
+						break;
+				}
+			}
+			break;
+
+		case KERN_JSONPATH_OP__FILTER:
+			rv = __jsonpathExecPredicate(jcxt, step->arg1, item);
+			if (rv < 0)
+				return rv;
+			if (rv == JSONPATH_RESULT__TRUE)
+				status = __jsonpathExecChain(jcxt, step->next, item);
+			break;
+
+		default:
+			STROM_ELOG(jcxt->kcxt, "corrupted jsonpath program");
+			return JSONPATH_RESULT__ERROR;
+	}
+	return status;
+}
+
+STATIC_FUNCTION(int)
+__jsonpathExecChain(xpu_jsonpath_context *jcxt,
+					int32_t step_id,
+					const xpu_jsonpath_item *item)
+{
+	const kern_jsonpath_step *step = __jsonpathGetStep(jcxt, step_id);
+	const JsonbContainer *jc = (const JsonbContainer *)item->data;
+	xpu_jsonpath_item child;
+	int			status = JSONPATH_RESULT__FALSE;
+	int			rv;
+
+	if (!step)
+		return JSONPATH_RESULT__ERROR;
+	switch (step->op)
+	{
+		case KERN_JSONPATH_OP__ROOT:
+			return __jsonpathExecChain(jcxt, step->next, &jcxt->root);
+
+		case KERN_JSONPATH_OP__CURRENT:
+			return __jsonpathExecChain(jcxt, step->next, item);
+
+		case KERN_JSONPATH_OP__KEY:
+		case KERN_JSONPATH_OP__ANY_KEY:
+		case KERN_JSONPATH_OP__FILTER:
+		case KERN_JSONPATH_OP__END_COMPARE:
+			if (__jsonpathItemIsArray(item))
+			{
+				/* lax mode automatically unwraps the array */
+				uint32_t	count = JsonContainerSize(__Fetch(&jc->header));
+				const char *base = (const char *)(jc->children + count);
+				uint32_t	offset = 0;
+
+				for (uint32_t i=0; i < count; i++)
+				{
+					offset = __jsonpathFetchChild(jc, base, i, offset, &child);
+					if (step->op == KERN_JSONPATH_OP__END_COMPARE)
+						rv = __jsonpathCompareItem(jcxt, step, &child);
+					else
+						rv = __jsonpathExecAccessor(jcxt, step, &child);
+					if (rv < 0)
+						return rv;
+					status = Max(status, rv);
+					if (status == JSONPATH_RESULT__TRUE)
+						break;
+				}
+				return status;
+			}
+			if (step->op == KERN_JSONPATH_OP__END_COMPARE)
+				return __jsonpathCompareItem(jcxt, step, item);
+			return __jsonpathExecAccessor(jcxt, step, item);
+
+		case KERN_JSONPATH_OP__ANY_ARRAY:
+			if (__jsonpathItemIsArray(item))
+			{
+				uint32_t	count = JsonContainerSize(__Fetch(&jc->header));
+				const char *base = (const char *)(jc->children + count);
+				uint32_t	offset = 0;
+
+				for (uint32_t i=0; i < count; i++)
+				{
+					offset = __jsonpathFetchChild(jc, base, i, offset, &child);
+					rv = __jsonpathExecChain(jcxt, step->next, &child);
+					if (rv < 0)
+						return rv;
+					status = Max(status, rv);
+					if (status == JSONPATH_RESULT__TRUE)
+						break;
+				}
+				return status;
+			}
+			/* lax mode automatically wraps the non-array item */
+			return __jsonpathExecChain(jcxt, step->next, item);
+
+		case KERN_JSONPATH_OP__INDEX_ARRAY:
+			if (__jsonpathItemIsArray(item))
+			{
+				uint32_t	count = JsonContainerSize(__Fetch(&jc->header));
+				const char *base = (const char *)(jc->children + count);
+
+				if (step->arg1 < 0 || step->arg1 >= count)
+					return JSONPATH_RESULT__FALSE;
+				__jsonpathFetchChild(jc, base, step->arg1,
+									 getJsonbOffset(jc, step->arg1), &child);
+				return __jsonpathExecChain(jcxt, step->next, &child);
+			}
+			if (step->arg1 != 0)
+				return JSONPATH_RESULT__FALSE;
+			return __jsonpathExecChain(jcxt, step->next, item);
+
+		case KERN_JSONPATH_OP__END_EXISTS:
+			return JSONPATH_RESULT__TRUE;
+
+		default:
+			STROM_ELOG(jcxt->kcxt, "corrupted jsonpath program");
+			break;
+	}
+	return JSONPATH_RESULT__ERROR;
+}
+
+STATIC_FUNCTION(int)
+__jsonpathExecPredicate(xpu_jsonpath_context *jcxt,
+						int32_t step_id,
+						const xpu_jsonpath_item *item)
+{
+	const kern_jsonpath_step *step = __jsonpathGetStep(jcxt, step_id);
+	int			lv, rv;
+
+	if (!step)
+		return JSONPATH_RESULT__ERROR;
+	switch (step->op)
+	{
+		case KERN_JSONPATH_OP__AND:
+			lv = __jsonpathExecPredicate(jcxt, step->arg1, item);
+			if (lv < 0 || lv == JSONPATH_RESULT__FALSE)
+				return lv;
+			rv = __jsonpathExecPredicate(jcxt, step->arg2, item);
+			if (rv < 0 || rv == JSONPATH_RESULT__FALSE)
+				return rv;
+			return Min(lv, rv);
+
+		case KERN_JSONPATH_OP__OR:
+			lv = __jsonpathExecPredicate(jcxt, step->arg1, item);
+			if (lv < 0 || lv == JSONPATH_RESULT__TRUE)
+				return lv;
+			rv = __jsonpathExecPredicate(jcxt, step->arg2, item);
+			if (rv < 0)
+				return rv;
+			return Max(lv, rv);
+
+		case KERN_JSONPATH_OP__NOT:
+			lv = __jsonpathExecPredicate(jcxt, step->arg1, item);
+			if (lv == JSONPATH_RESULT__TRUE)
+				return JSONPATH_RESULT__FALSE;
+			if (lv == JSONPATH_RESULT__FALSE)
+				return JSONPATH_RESULT__TRUE;
+			return lv;
+
+		case KERN_JSONPATH_OP__IS_UNKNOWN:
+			lv = __jsonpathExecPredicate(jcxt, step->arg1, item);
+			if (lv < 0)
+				return lv;
+			return (lv == JSONPATH_RESULT__UNKNOWN
+					? JSONPATH_RESULT__TRUE
+					: JSONPATH_RESULT__FALSE);
+
+		default:
+			/* exists() or comparison; chain terminated by END_* */
+			return __jsonpathExecChain(jcxt, step_id, item);
+	}
+}
+
+STATIC_FUNCTION(int)
+__jsonpathExecProgram(kern_context *kcxt,
+					  const xpu_jsonb_t *json,
+					  const xpu_bytea_t *program,
+					  bool is_predicate)
+{
+	const JsonbContainer *jc = (const JsonbContainer *)json->value;
+	xpu_jsonpath_context jcxt;
+
+	jcxt.kcxt = kcxt;
+	jcxt.prog = (const kern_jsonpath_program *)program->value;
+	if (program->length < offsetof(kern_jsonpath_program, steps) ||
+		program->length < (offsetof(kern_jsonpath_program, steps) +
+						   sizeof(kern_jsonpath_step) * jcxt.prog->nsteps))
+	{
+		STROM_ELOG(kcxt, "corrupted jsonpath program");
+		return JSONPATH_RESULT__ERROR;
+	}
+	/* scalar jsonb is extracted, like JsonbExtractScalar() */
+	if (JsonContainerIsScalar(__Fetch(&jc->header)))
+		__jsonpathFetchChild(jc, (const char *)(jc->children + 1),
+							 0, 0, &jcxt.root);
+	else
+	{
+		jcxt.root.type = JENTRY_ISCONTAINER;
+		jcxt.root.length = json->length;
+		jcxt.root.data = json->value;
+	}
+	if (is_predicate)
+		return __jsonpathExecPredicate(&jcxt, jcxt.prog->entry, &jcxt.root);
+	return __jsonpathExecChain(&jcxt, jcxt.prog->entry, &jcxt.root);
+}
+
+/*
+ * jsonb_vcol_field_text
+ *
+ * (jsonb->>KEY) that may be pre-computed on the virtual column of GpuCache.
+ * The 1st argument is the reference to the virtual column, and the 2nd one
+ * is the original expression for the other outer relations.
+ */
+PUBLIC_FUNCTION(bool)
+pgfn_jsonb_vcol_field_text(XPU_PGFUNCTION_ARGS)
+{
+	const kern_expression *karg = KEXP_FIRST_ARG(kexp);
+
+	assert(kexp->nr_args == 2);
+	if (!kcxt->session->gpucache_vcols)
+		karg = KEXP_NEXT_ARG(karg);
+	assert(KEXP_IS_VALID(karg, text));
+	return EXEC_KERN_EXPRESSION(kcxt, karg, __result);
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_jsonb_path_exists_prog(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS2(bool,
+					   jsonb, datum_a,		/* target */
+					   bytea, datum_b);		/* program */
+	if (XPU_DATUM_ISNULL(&datum_a) || XPU_DATUM_ISNULL(&datum_b))
+		result->expr_ops = NULL;
+	else
+	{
+		int		status;
+
+		if (!xpu_jsonb_is_valid(kcxt, &datum_a) ||
+			!xpu_bytea_is_valid(kcxt, &datum_b))
+			return false;
+		status = __jsonpathExecProgram(kcxt, &datum_a, &datum_b, false);
+		if (status < 0)
+			return false;
+		result->expr_ops = &xpu_bool_ops;
+		result->value = (status == JSONPATH_RESULT__TRUE);
+	}
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_jsonb_path_match_prog(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS2(bool,
+					   jsonb, datum_a,		/* target */
+					   bytea, datum_b);		/* program */
+	if (XPU_DATUM_ISNULL(&datum_a) || XPU_DATUM_ISNULL(&datum_b))
+		result->expr_ops = NULL;
+	else
+	{
+		int		status;
+
+		if (!xpu_jsonb_is_valid(kcxt, &datum_a) ||
+			!xpu_bytea_is_valid(kcxt, &datum_b))
+			return false;
+		status = __jsonpathExecProgram(kcxt, &datum_a, &datum_b, true);
+		if (status < 0)
+			return false;
+		if (status == JSONPATH_RESULT__UNKNOWN)
+			result->expr_ops = NULL;
+		else
+		{
+			result->expr_ops = &xpu_bool_ops;
+			result->value = (status == JSONPATH_RESULT__TRUE);
+		}
+	}
+	return true;
+}
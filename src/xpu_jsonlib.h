@@ -16,4 +16,62 @@
 
 PGSTROM_SQLTYPE_VARLENA_DECLARATION(jsonb);
 
+/*
+ * kern_jsonpath_program - JSONPath expression (lax mode) compiled by the
+ * host code (see codegen.c), for jsonb_path_exists / jsonb_path_match.
+ *
+ * Each step of an accessor chain points to the next step; the chain is
+ * terminated by END_EXISTS or END_COMPARE step. A comparison predicate
+ * is represented by a chain terminated by END_COMPARE, which compares
+ * the items with the constant value. All the fields are int32_t, and
+ * the constant area follows the steps[] array.
+ */
+typedef struct {
+	int32_t		op;				/* KERN_JSONPATH_OP__* */
+	int32_t		next;			/* next step of the chain */
+	int32_t		arg1;			/* 1st argument (predicate or index) */
+	int32_t		arg2;			/* 2nd argument (predicate) */
+	int32_t		cmp_op;			/* KERN_JSONPATH_CMP__* */
+	int32_t		const_type;		/* KERN_JSONPATH_CONST__* */
+	int32_t		const_offset;	/* offset from the constant area */
+	int32_t		const_len;		/* length of the constant */
+} kern_jsonpath_step;
+
+typedef struct {
+	int32_t		nsteps;			/* # of steps */
+	int32_t		entry;			/* entrypoint step */
+	kern_jsonpath_step steps[1];
+} kern_jsonpath_program;
+
+#define KERN_JSONPATH_OP__ROOT			1	/* $ */
+#define KERN_JSONPATH_OP__CURRENT		2	/* @ */
+#define KERN_JSONPATH_OP__KEY			3	/* .key */
+#define KERN_JSONPATH_OP__ANY_KEY		4	/* .* */
+#define KERN_JSONPATH_OP__ANY_ARRAY		5	/* [*] */
+#define KERN_JSONPATH_OP__INDEX_ARRAY	6	/* [N] */
+#define KERN_JSONPATH_OP__FILTER		7	/* ? (predicate) */
+#define KERN_JSONPATH_OP__END_EXISTS	8
+#define KERN_JSONPATH_OP__END_COMPARE	9
+#define KERN_JSONPATH_OP__AND			10
+#define KERN_JSONPATH_OP__OR			11
+#define KERN_JSONPATH_OP__NOT			12
+#define KERN_JSONPATH_OP__IS_UNKNOWN	13
+
+#define KERN_JSONPATH_CMP__EQ			1
+#define KERN_JSONPATH_CMP__NE			2
+#define KERN_JSONPATH_CMP__LT			3
+#define KERN_JSONPATH_CMP__LE			4
+#define KERN_JSONPATH_CMP__GT			5
+#define KERN_JSONPATH_CMP__GE			6
+
+#define KERN_JSONPATH_CONST__NULL		1
+#define KERN_JSONPATH_CONST__STRING		2
+#define KERN_JSONPATH_CONST__NUMERIC	3
+#define KERN_JSONPATH_CONST__BOOL_TRUE	4
+#define KERN_JSONPATH_CONST__BOOL_FALSE	5
+
+#define KERN_JSONPATH_MAX_STEPS			64
+#define KERN_JSONPATH_CONST_AREA(prog)				\
+	((const char *)&(prog)->steps[(prog)->nsteps])
+
 #endif	/* XPU_JSONLIB_H */
@@ -1083,6 +1083,150 @@ pgfn_macaddr_trunc(XPU_PGFUNCTION_ARGS)
 	return true;
 }
 
+/*
+ * Tid data type (xpu_tid_t), functions and operators
+ */
+STATIC_FUNCTION(bool)
+xpu_tid_datum_heap_read(kern_context *kcxt,
+						const void *addr,
+						xpu_datum_t *__result)
+{
+	xpu_tid_t  *result = (xpu_tid_t *)__result;
+
+	result->expr_ops = &xpu_tid_ops;
+	memcpy(&result->value, addr, sizeof(ItemPointerData));
+	return true;
+}
+
+STATIC_FUNCTION(bool)
+xpu_tid_datum_arrow_read(kern_context *kcxt,
+						 const kern_data_store *kds,
+						 const kern_colmeta *cmeta,
+						 uint32_t kds_index,
+						 xpu_datum_t *__result)
+{
+	STROM_ELOG(kcxt, "xpu_tid_t cannot be mapped on any Arrow type");
+	return false;
+}
+
+STATIC_FUNCTION(bool)
+xpu_tid_datum_kvec_load(kern_context *kcxt,
+						const kvec_datum_t *__kvecs,
+						uint32_t kvecs_id,
+						xpu_datum_t *__result)
+{
+	const kvec_tid_t *kvecs = (const kvec_tid_t *)__kvecs;
+	xpu_tid_t  *result = (xpu_tid_t *)__result;
+
+	result->expr_ops = &xpu_tid_ops;
+	memcpy(&result->value, &kvecs->values[kvecs_id], sizeof(ItemPointerData));
+	return true;
+}
+
+STATIC_FUNCTION(bool)
+xpu_tid_datum_kvec_save(kern_context *kcxt,
+						const xpu_datum_t *__xdatum,
+						kvec_datum_t *__kvecs,
+						uint32_t kvecs_id)
+{
+	const xpu_tid_t *xdatum = (const xpu_tid_t *)__xdatum;
+	kvec_tid_t *kvecs = (kvec_tid_t *)__kvecs;
+
+	memcpy(&kvecs->values[kvecs_id], &xdatum->value, sizeof(ItemPointerData));
+	return true;
+}
+
+STATIC_FUNCTION(bool)
+xpu_tid_datum_kvec_copy(kern_context *kcxt,
+						const kvec_datum_t *__kvecs_src,
+						uint32_t kvecs_src_id,
+						kvec_datum_t *__kvecs_dst,
+						uint32_t kvecs_dst_id)
+{
+	const kvec_tid_t *kvecs_src = (const kvec_tid_t *)__kvecs_src;
+	kvec_tid_t *kvecs_dst = (kvec_tid_t *)__kvecs_dst;
+
+	memcpy(&kvecs_dst->values[kvecs_dst_id],
+		   &kvecs_src->values[kvecs_src_id], sizeof(ItemPointerData));
+	return true;
+}
+
+STATIC_FUNCTION(int)
+xpu_tid_datum_write(kern_context *kcxt,
+					char *buffer,
+					const kern_colmeta *cmeta,
+					const xpu_datum_t *__arg)
+{
+	const xpu_tid_t *arg = (const xpu_tid_t *)__arg;
+
+	if (buffer)
+		memcpy(buffer, &arg->value, sizeof(ItemPointerData));
+	return sizeof(ItemPointerData);
+}
+
+STATIC_FUNCTION(bool)
+xpu_tid_datum_hash(kern_context *kcxt,
+				   uint32_t *p_hash,
+				   xpu_datum_t *__arg)
+{
+	xpu_tid_t  *arg = (xpu_tid_t *)__arg;
+
+	if (XPU_DATUM_ISNULL(arg))
+		*p_hash = 0;
+	else
+		*p_hash = pg_hash_any(&arg->value, sizeof(ItemPointerData));
+	return true;
+}
+
+INLINE_FUNCTION(uint32_t)
+__tid_block_number(const ItemPointerData *ip)
+{
+	return (((uint32_t)ip->ip_blkid.bi_hi << 16) |
+			((uint32_t)ip->ip_blkid.bi_lo));
+}
+
+STATIC_FUNCTION(bool)
+xpu_tid_datum_comp(kern_context *kcxt,
+				   int *p_comp,
+				   xpu_datum_t *__a,
+				   xpu_datum_t *__b)
+{
+	xpu_tid_t  *a = (xpu_tid_t *)__a;
+	xpu_tid_t  *b = (xpu_tid_t *)__b;
+	uint32_t	blkno_a = __tid_block_number(&a->value);
+	uint32_t	blkno_b = __tid_block_number(&b->value);
+
+	assert(!XPU_DATUM_ISNULL(a) && !XPU_DATUM_ISNULL(b));
+	if (blkno_a != blkno_b)
+		*p_comp = (blkno_a < blkno_b ? -1 : 1);
+	else if (a->value.ip_posid != b->value.ip_posid)
+		*p_comp = (a->value.ip_posid < b->value.ip_posid ? -1 : 1);
+	else
+		*p_comp = 0;
+	return true;
+}
+PGSTROM_SQLTYPE_OPERATORS(tid, false, 2, sizeof(ItemPointerData));
+
+PUBLIC_FUNCTION(bool)
+pgfn_tid_block_number(XPU_PGFUNCTION_ARGS)
+{
+	xpu_int8_t *result = (xpu_int8_t *)__result;
+	xpu_tid_t	datum;
+	const kern_expression *karg = KEXP_FIRST_ARG(kexp);
+
+	assert(kexp->nr_args == 1 && KEXP_IS_VALID(karg, tid));
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, &datum))
+		return false;
+	if (XPU_DATUM_ISNULL(&datum))
+		result->expr_ops = NULL;
+	else
+	{
+		result->expr_ops = &xpu_int8_ops;
+		result->value = __tid_block_number(&datum.value);
+	}
+	return true;
+}
+
 /*
  * Inet data type (xpu_iner_t), functions and operators
  */
@@ -1961,3 +2105,1010 @@ pgfn_cube_ll_coord(XPU_PGFUNCTION_ARGS)
 	}
 	return true;
 }
+
+/* ----------------------------------------------------------------
+ *
+ * vector (pgvector) data type and distance functions
+ *
+ * ----------------------------------------------------------------
+ */
+INLINE_FUNCTION(int)
+VECTOR_DIM(const __VECTOR *vec)
+{
+	int16_t		dim;
+
+	memcpy(&dim, (const char *)vec + offsetof(__VECTOR, dim), sizeof(int16_t));
+	return dim;
+}
+
+INLINE_FUNCTION(float)
+VECTOR_ELEM(const __VECTOR *vec, int i)
+{
+	return __Fetch(vec->x + i);
+}
+
+INLINE_FUNCTION(bool)
+xpu_vector_is_valid(kern_context *kcxt, const xpu_vector_t *arg)
+{
+	int		dim;
+
+	if (arg->length < 0)
+	{
+		STROM_CPU_FALLBACK(kcxt, "vector datum is compressed or external");
+		return false;
+	}
+	dim = VECTOR_DIM((const __VECTOR *)arg->value);
+	if (dim < 0 || arg->length < offsetof(__VECTOR, x) + sizeof(float) * dim)
+	{
+		STROM_ELOG(kcxt, "vector datum is corrupted");
+		return false;
+	}
+	return true;
+}
+
+STATIC_FUNCTION(bool)
+xpu_vector_datum_heap_read(kern_context *kcxt,
+						   const void *addr,
+						   xpu_datum_t *__result)
+{
+	xpu_vector_t *result = (xpu_vector_t *)__result;
+
+	if (VARATT_IS_EXTERNAL(addr) || VARATT_IS_COMPRESSED(addr))
+	{
+		result->value  = (const char *)addr;
+		result->length = -1;
+	}
+	else
+	{
+		result->value  = VARDATA_ANY(addr);
+		result->length = VARSIZE_ANY_EXHDR(addr);
+	}
+	result->expr_ops = &xpu_vector_ops;
+	return true;
+}
+
+STATIC_FUNCTION(bool)
+xpu_vector_datum_arrow_read(kern_context *kcxt,
+							const kern_data_store *kds,
+							const kern_colmeta *cmeta,
+							uint32_t kds_index,
+							xpu_datum_t *__result)
+{
+	xpu_vector_t *result = (xpu_vector_t *)__result;
+
+	if (cmeta->attopts.tag == ArrowType__Binary)
+	{
+		result->value = (const char *)
+			KDS_ARROW_REF_VARLENA32_DATUM(kds, cmeta, kds_index,
+										  &result->length);
+	}
+	else if (cmeta->attopts.tag == ArrowType__LargeBinary)
+	{
+		result->value = (const char *)
+			KDS_ARROW_REF_VARLENA64_DATUM(kds, cmeta, kds_index,
+										  &result->length);
+	}
+	else
+	{
+		STROM_ELOG(kcxt, "not a mappable Arrow data type for vector");
+		return false;
+	}
+	result->expr_ops = (result->value != NULL ? &xpu_vector_ops : NULL);
+	return true;
+}
+
+STATIC_FUNCTION(bool)
+xpu_vector_datum_kvec_load(kern_context *kcxt,
+						   const kvec_datum_t *__kvecs,
+						   uint32_t kvecs_id,
+						   xpu_datum_t *__result)
+{
+	const kvec_vector_t *kvecs = (const kvec_vector_t *)__kvecs;
+	xpu_vector_t *result = (xpu_vector_t *)__result;
+
+	result->expr_ops = &xpu_vector_ops;
+	result->length = kvecs->length[kvecs_id];
+	result->value  = kvecs->values[kvecs_id];
+	return true;
+}
+
+STATIC_FUNCTION(bool)
+xpu_vector_datum_kvec_save(kern_context *kcxt,
+						   const xpu_datum_t *__xdatum,
+						   kvec_datum_t *__kvecs,
+						   uint32_t kvecs_id)
+{
+	const xpu_vector_t *xdatum = (const xpu_vector_t *)__xdatum;
+	kvec_vector_t *kvecs = (kvec_vector_t *)__kvecs;
+
+	kvecs->length[kvecs_id] = xdatum->length;
+	kvecs->values[kvecs_id] = xdatum->value;
+	return true;
+}
+
+STATIC_FUNCTION(bool)
+xpu_vector_datum_kvec_copy(kern_context *kcxt,
+						   const kvec_datum_t *__kvecs_src,
+						   uint32_t kvecs_src_id,
+						   kvec_datum_t *__kvecs_dst,
+						   uint32_t kvecs_dst_id)
+{
+	const kvec_vector_t *kvecs_src = (const kvec_vector_t *)__kvecs_src;
+	kvec_vector_t *kvecs_dst = (kvec_vector_t *)__kvecs_dst;
+
+	kvecs_dst->length[kvecs_dst_id] = kvecs_src->length[kvecs_src_id];
+	kvecs_dst->values[kvecs_dst_id] = kvecs_src->values[kvecs_src_id];
+	return true;
+}
+
+STATIC_FUNCTION(int)
+xpu_vector_datum_write(kern_context *kcxt,
+					   char *buffer,
+					   const kern_colmeta *cmeta,
+					   const xpu_datum_t *__arg)
+{
+	const xpu_vector_t *arg = (const xpu_vector_t *)__arg;
+	int		nbytes;
+
+	if (arg->length < 0)
+	{
+		nbytes = VARSIZE_ANY(arg->value);
+		if (buffer)
+			memcpy(buffer, arg->value, nbytes);
+	}
+	else
+	{
+		nbytes = VARHDRSZ + arg->length;
+		if (buffer)
+		{
+			memcpy(buffer+VARHDRSZ, arg->value, arg->length);
+			SET_VARSIZE(buffer, nbytes);
+		}
+	}
+	return nbytes;
+}
+
+STATIC_FUNCTION(bool)
+xpu_vector_datum_hash(kern_context *kcxt,
+					  uint32_t *p_hash,
+					  xpu_datum_t *__arg)
+{
+	xpu_vector_t *arg = (xpu_vector_t *)__arg;
+
+	if (XPU_DATUM_ISNULL(arg))
+		*p_hash = 0;
+	else if (xpu_vector_is_valid(kcxt, arg))
+		*p_hash = pg_hash_any(arg->value, arg->length);
+	else
+		return false;
+	return true;
+}
+
+STATIC_FUNCTION(bool)
+xpu_vector_datum_comp(kern_context *kcxt,
+					  int *p_comp,
+					  xpu_datum_t *__a,
+					  xpu_datum_t *__b)
+{
+	const xpu_vector_t *a = (const xpu_vector_t *)__a;
+	const xpu_vector_t *b = (const xpu_vector_t *)__b;
+	const __VECTOR *va;
+	const __VECTOR *vb;
+	int			dim;
+
+	if (!xpu_vector_is_valid(kcxt, a) ||
+		!xpu_vector_is_valid(kcxt, b))
+		return false;
+	/* same logic as vector_cmp_internal() of pgvector */
+	va = (const __VECTOR *)a->value;
+	vb = (const __VECTOR *)b->value;
+	dim = Min(VECTOR_DIM(va), VECTOR_DIM(vb));
+	for (int i=0; i < dim; i++)
+	{
+		float	ax = VECTOR_ELEM(va, i);
+		float	bx = VECTOR_ELEM(vb, i);
+
+		if (ax < bx)
+		{
+			*p_comp = -1;
+			return true;
+		}
+		if (ax > bx)
+		{
+			*p_comp = 1;
+			return true;
+		}
+	}
+	if (VECTOR_DIM(va) < VECTOR_DIM(vb))
+		*p_comp = -1;
+	else if (VECTOR_DIM(va) > VECTOR_DIM(vb))
+		*p_comp = 1;
+	else
+		*p_comp = 0;
+	return true;
+}
+PGSTROM_SQLTYPE_OPERATORS(vector, false, 4, -1);
+
+PUBLIC_FUNCTION(bool)
+pgfn_vector_dims(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS1(int4, vector, vval);
+
+	if (XPU_DATUM_ISNULL(&vval))
+		result->expr_ops = NULL;
+	else if (!xpu_vector_is_valid(kcxt, &vval))
+		return false;
+	else
+	{
+		result->expr_ops = &xpu_int4_ops;
+		result->value = VECTOR_DIM((const __VECTOR *)vval.value);
+	}
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_vector_norm(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS1(float8, vector, vval);
+
+	if (XPU_DATUM_ISNULL(&vval))
+		result->expr_ops = NULL;
+	else if (!xpu_vector_is_valid(kcxt, &vval))
+		return false;
+	else
+	{
+		const __VECTOR *v = (const __VECTOR *)vval.value;
+		int			dim = VECTOR_DIM(v);
+		double		norm = 0.0;
+
+		for (int i=0; i < dim; i++)
+		{
+			double	x = (double)VECTOR_ELEM(v, i);
+
+			norm += x * x;
+		}
+		result->expr_ops = &xpu_float8_ops;
+		result->value = sqrt(norm);
+	}
+	return true;
+}
+
+/*
+ * Common distance kernel of the pgvector operators.
+ *
+ * All the operators walk on a pair of vectors at once, so we accumulate
+ * every partial sum in a single pass, then each function picks up what it
+ * needs. Accumulation is done in float, as pgvector doing on the host side,
+ * to produce the same results.
+ */
+typedef struct
+{
+	float		l2sq;		/* sum of (a-b)^2 */
+	float		dot;		/* sum of a*b */
+	float		norma;		/* sum of a*a */
+	float		normb;		/* sum of b*b */
+	float		l1;			/* sum of |a-b| */
+} __vector_dist_sums;
+
+#define VECTOR_DIST__L2		0x0001
+#define VECTOR_DIST__DOT	0x0002
+#define VECTOR_DIST__NORM	0x0004
+#define VECTOR_DIST__L1		0x0008
+
+STATIC_FUNCTION(bool)
+__vector_distance_sums(kern_context *kcxt,
+					   const kern_expression *kexp,
+					   xpu_float8_t *result,
+					   uint32_t flags,
+					   __vector_dist_sums *sums)
+{
+	const kern_expression *karg = KEXP_FIRST_ARG(kexp);
+	xpu_vector_t	vval1;
+	xpu_vector_t	vval2;
+	const __VECTOR *a;
+	const __VECTOR *b;
+	int				dim;
+
+	assert(kexp->exptype == TypeOpCode__float8 &&
+		   kexp->nr_args == 2 &&
+		   KEXP_IS_VALID(karg, vector));
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, &vval1))
+		return false;
+	karg = KEXP_NEXT_ARG(karg);
+	assert(KEXP_IS_VALID(karg, vector));
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, &vval2))
+		return false;
+	if (XPU_DATUM_ISNULL(&vval1) || XPU_DATUM_ISNULL(&vval2))
+	{
+		result->expr_ops = NULL;
+		return true;
+	}
+	if (!xpu_vector_is_valid(kcxt, &vval1) ||
+		!xpu_vector_is_valid(kcxt, &vval2))
+		return false;
+	a = (const __VECTOR *)vval1.value;
+	b = (const __VECTOR *)vval2.value;
+	dim = VECTOR_DIM(a);
+	if (dim != VECTOR_DIM(b))
+	{
+		STROM_ELOG(kcxt, "different vector dimensions");
+		return false;
+	}
+	memset(sums, 0, sizeof(__vector_dist_sums));
+	for (int i=0; i < dim; i++)
+	{
+		float	ax = VECTOR_ELEM(a, i);
+		float	bx = VECTOR_ELEM(b, i);
+		float	diff = ax - bx;
+
+		if ((flags & VECTOR_DIST__L2) != 0)
+			sums->l2sq += diff * diff;
+		if ((flags & VECTOR_DIST__DOT) != 0)
+			sums->dot += ax * bx;
+		if ((flags & VECTOR_DIST__NORM) != 0)
+		{
+			sums->norma += ax * ax;
+			sums->normb += bx * bx;
+		}
+		if ((flags & VECTOR_DIST__L1) != 0)
+			sums->l1 += fabsf(diff);
+	}
+	result->expr_ops = &xpu_float8_ops;
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_l2_distance(XPU_PGFUNCTION_ARGS)
+{
+	xpu_float8_t   *result = (xpu_float8_t *)__result;
+	__vector_dist_sums sums;
+
+	if (!__vector_distance_sums(kcxt, kexp, result,
+								VECTOR_DIST__L2, &sums))
+		return false;
+	if (!XPU_DATUM_ISNULL(result))
+		result->value = sqrt((double)sums.l2sq);
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_vector_l2_squared_distance(XPU_PGFUNCTION_ARGS)
+{
+	xpu_float8_t   *result = (xpu_float8_t *)__result;
+	__vector_dist_sums sums;
+
+	if (!__vector_distance_sums(kcxt, kexp, result,
+								VECTOR_DIST__L2, &sums))
+		return false;
+	if (!XPU_DATUM_ISNULL(result))
+		result->value = (double)sums.l2sq;
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_inner_product(XPU_PGFUNCTION_ARGS)
+{
+	xpu_float8_t   *result = (xpu_float8_t *)__result;
+	__vector_dist_sums sums;
+
+	if (!__vector_distance_sums(kcxt, kexp, result,
+								VECTOR_DIST__DOT, &sums))
+		return false;
+	if (!XPU_DATUM_ISNULL(result))
+		result->value = (double)sums.dot;
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_vector_negative_inner_product(XPU_PGFUNCTION_ARGS)
+{
+	xpu_float8_t   *result = (xpu_float8_t *)__result;
+	__vector_dist_sums sums;
+
+	if (!__vector_distance_sums(kcxt, kexp, result,
+								VECTOR_DIST__DOT, &sums))
+		return false;
+	if (!XPU_DATUM_ISNULL(result))
+		result->value = -((double)sums.dot);
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_cosine_distance(XPU_PGFUNCTION_ARGS)
+{
+	xpu_float8_t   *result = (xpu_float8_t *)__result;
+	__vector_dist_sums sums;
+
+	if (!__vector_distance_sums(kcxt, kexp, result,
+								VECTOR_DIST__DOT |
+								VECTOR_DIST__NORM, &sums))
+		return false;
+	if (!XPU_DATUM_ISNULL(result))
+	{
+		double	similarity = ((double)sums.dot /
+							  sqrt((double)sums.norma * (double)sums.normb));
+		/* keep in range; NaN (zero vector) is propagated as is */
+		if (similarity > 1.0)
+			similarity = 1.0;
+		else if (similarity < -1.0)
+			similarity = -1.0;
+		result->value = 1.0 - similarity;
+	}
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_l1_distance(XPU_PGFUNCTION_ARGS)
+{
+	xpu_float8_t   *result = (xpu_float8_t *)__result;
+	__vector_dist_sums sums;
+
+	if (!__vector_distance_sums(kcxt, kexp, result,
+								VECTOR_DIST__L1, &sums))
+		return false;
+	if (!XPU_DATUM_ISNULL(result))
+		result->value = (double)sums.l1;
+	return true;
+}
+
+/* ----------------------------------------------------------------
+ *
+ * Array functions and operators
+ *
+ * ---------------------------------------------------------------- */
+#ifndef PG_INT8OID
+#define PG_INT8OID			20
+#endif
+#ifndef PG_INT2OID
+#define PG_INT2OID			21
+#endif
+#ifndef PG_INT4OID
+#define PG_INT4OID			23
+#endif
+#ifndef PG_OIDOID
+#define PG_OIDOID			26
+#endif
+#ifndef PG_VARCHAROID
+#define PG_VARCHAROID		1043
+#endif
+#ifndef PG_DATEOID
+#define PG_DATEOID			1082
+#endif
+#ifndef PG_TIMESTAMPOID
+#define PG_TIMESTAMPOID		1114
+#endif
+#ifndef PG_TIMESTAMPTZOID
+#define PG_TIMESTAMPTZOID	1184
+#endif
+#ifndef PG_UUIDOID
+#define PG_UUIDOID			2950
+#endif
+
+/*
+ * __array_elems - accessor to the elements of heap/arrow arrays
+ *
+ * The containment/overlap operators compare the elements by their binary
+ * image, so only the element types whose equality is identical to the
+ * binary equality are supported. Elsewhere, CPU fallback.
+ */
+typedef struct
+{
+	Oid			elemtype;
+	int16_t		typlen;
+	int16_t		typalign;
+	bool		is_signed;		/* signed integer; sortable fast path */
+	int32_t		nitems;
+	/* heap array */
+	const char *base;
+	const uint8_t *nullmap;
+	/* arrow array */
+	const kern_data_store *kds;
+	const kern_colmeta *smeta;
+	uint32_t	start;
+	/* iterator */
+	int32_t		curr;
+	uint32_t	offset;
+} __array_elems;
+
+STATIC_FUNCTION(bool)
+__array_elemtype_setup(__array_elems *ae, Oid elemtype)
+{
+	ae->elemtype = elemtype;
+	ae->is_signed = false;
+	switch (elemtype)
+	{
+		case PG_INT2OID:
+			ae->typlen = ae->typalign = sizeof(int16_t);
+			ae->is_signed = true;
+			break;
+		case PG_INT4OID:
+		case PG_DATEOID:
+			ae->typlen = ae->typalign = sizeof(int32_t);
+			ae->is_signed = true;
+			break;
+		case PG_OIDOID:
+			ae->typlen = ae->typalign = sizeof(uint32_t);
+			break;
+		case PG_INT8OID:
+		case PG_TIMESTAMPOID:
+		case PG_TIMESTAMPTZOID:
+			ae->typlen = ae->typalign = sizeof(int64_t);
+			ae->is_signed = true;
+			break;
+		case PG_UUIDOID:
+			ae->typlen = 16;
+			ae->typalign = 1;
+			break;
+		case PG_TEXTOID:
+		case PG_VARCHAROID:
+		case PG_BYTEAOID:
+			ae->typlen = -1;
+			ae->typalign = sizeof(int32_t);
+			break;
+		default:
+			return false;
+	}
+	return true;
+}
+
+STATIC_FUNCTION(bool)
+__array_elems_setup(kern_context *kcxt,
+					const xpu_array_t *aval,
+					__array_elems *ae)
+{
+	memset(ae, 0, sizeof(__array_elems));
+	if (aval->length < 0)
+	{
+		const char *addr = (const char *)aval->u.heap.value;
+		const __ArrayTypeData *ar;
+		int32_t		ndim;
+
+		if (VARATT_IS_EXTERNAL(addr))
+		{
+			STROM_CPU_FALLBACK(kcxt, "array datum is external");
+			return false;
+		}
+		else if (VARATT_IS_COMPRESSED(addr))
+		{
+			int		len;
+
+			ar = (const __ArrayTypeData *)
+				pg_decompress_inline_datum(kcxt, addr, &len);
+			if (!ar)
+			{
+				STROM_CPU_FALLBACK(kcxt, "array datum is compressed");
+				return false;
+			}
+		}
+		else
+			ar = (const __ArrayTypeData *)VARDATA_ANY(addr);
+
+		if (!__array_elemtype_setup(ae, __Fetch(&ar->elemtype)))
+		{
+			STROM_CPU_FALLBACK(kcxt, "not a supported array element type");
+			return false;
+		}
+		ndim = __pg_array_ndim(ar);
+		if (ndim > 0)
+		{
+			ae->nitems = __pg_array_dim(ar, 0);
+			for (int k=1; k < ndim; k++)
+				ae->nitems *= __pg_array_dim(ar, k);
+		}
+		ae->base = __pg_array_dataptr(ar);
+		ae->nullmap = __pg_array_nullmap(ar);
+	}
+	else
+	{
+		const kern_colmeta *cmeta = aval->u.arrow.cmeta;
+
+		ae->kds = (const kern_data_store *)
+			((const char *)cmeta - cmeta->kds_offset);
+		ae->smeta = &ae->kds->colmeta[cmeta->idx_subattrs];
+		ae->start = aval->u.arrow.start;
+		ae->nitems = aval->length;
+		if (!__array_elemtype_setup(ae, ae->smeta->atttypid) ||
+			(ae->typlen > 0
+			 ? ae->smeta->attlen != ae->typlen
+			 : (ae->smeta->attopts.tag != ArrowType__Utf8 &&
+				ae->smeta->attopts.tag != ArrowType__Binary &&
+				ae->smeta->attopts.tag != ArrowType__LargeUtf8 &&
+				ae->smeta->attopts.tag != ArrowType__LargeBinary)))
+		{
+			STROM_CPU_FALLBACK(kcxt, "not a supported array element type");
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * __array_elems_next - it returns the next element; NULL elements are
+ * returned with *p_isnull = true. It returns false at the end.
+ */
+STATIC_FUNCTION(bool)
+__array_elems_next(kern_context *kcxt,
+				   __array_elems *ae,
+				   const char **p_addr,
+				   int *p_len,
+				   bool *p_isnull)
+{
+	uint32_t	index;
+
+	if (ae->curr >= ae->nitems)
+		return false;
+	index = ae->curr++;
+	*p_addr = NULL;
+	*p_len = 0;
+	*p_isnull = true;
+	if (!ae->kds)
+	{
+		const char *addr;
+
+		if (ae->nullmap && att_isnull(index, ae->nullmap))
+			return true;
+		if (ae->typlen > 0)
+		{
+			ae->offset = TYPEALIGN(ae->typalign, ae->offset);
+			addr = ae->base + ae->offset;
+			*p_len = ae->typlen;
+			ae->offset += ae->typlen;
+		}
+		else
+		{
+			if (!VARATT_NOT_PAD_BYTE(ae->base + ae->offset))
+				ae->offset = TYPEALIGN(ae->typalign, ae->offset);
+			addr = ae->base + ae->offset;
+			if (VARATT_IS_EXTENDED(addr) && !VARATT_IS_SHORT(addr))
+			{
+				STROM_CPU_FALLBACK(kcxt, "array element is compressed or external");
+				return false;
+			}
+			ae->offset += VARSIZE_ANY(addr);
+			*p_len = VARSIZE_ANY_EXHDR(addr);
+			addr = VARDATA_ANY(addr);
+		}
+		*p_addr = addr;
+	}
+	else
+	{
+		index += ae->start;
+		if (KDS_ARROW_CHECK_ISNULL(ae->kds, ae->smeta, index))
+			return true;
+		if (ae->typlen > 0)
+		{
+			*p_addr = (const char *)
+				KDS_ARROW_REF_SIMPLE_DATUM(ae->kds, ae->smeta,
+										   index, ae->typlen);
+			*p_len = ae->typlen;
+		}
+		else if (ae->smeta->attopts.tag == ArrowType__Utf8 ||
+				 ae->smeta->attopts.tag == ArrowType__Binary)
+		{
+			*p_addr = (const char *)
+				KDS_ARROW_REF_VARLENA32_DATUM(ae->kds, ae->smeta,
+											  index, p_len);
+		}
+		else
+		{
+			*p_addr = (const char *)
+				KDS_ARROW_REF_VARLENA64_DATUM(ae->kds, ae->smeta,
+											  index, p_len);
+		}
+		if (!*p_addr)
+		{
+			STROM_ELOG(kcxt, "Arrow::List element is out of range");
+			return false;
+		}
+	}
+	*p_isnull = false;
+	return true;
+}
+
+INLINE_FUNCTION(int64_t)
+__array_elem_as_int64(const char *addr, int typlen)
+{
+	switch (typlen)
+	{
+		case sizeof(int16_t):
+			return __Fetch((const int16_t *)addr);
+		case sizeof(int32_t):
+			return __Fetch((const int32_t *)addr);
+		default:
+			return __Fetch((const int64_t *)addr);
+	}
+}
+
+/*
+ * __array_contain_compare - same semantics of array_contain_compare()
+ *
+ * If @matchall, every non-NULL element of @a1 must be in @a2, and NULL
+ * element in @a1 makes the result false. Elsewhere, it returns true if
+ * any element of @a1 is in @a2.
+ */
+STATIC_FUNCTION(bool)
+__array_contain_compare(kern_context *kcxt,
+						const kern_expression *kexp,
+						xpu_bool_t *result,
+						bool swap_args,
+						bool matchall)
+{
+	const kern_expression *karg = KEXP_FIRST_ARG(kexp);
+	xpu_array_t	aval1;
+	xpu_array_t	aval2;
+	__array_elems ae1;
+	__array_elems ae2;
+	const char *addr1;
+	const char *addr2;
+	int			len1, len2;
+	bool		isnull1, isnull2;
+	bool		sorted = false;
+	bool		retval = matchall;
+
+	assert(kexp->exptype == TypeOpCode__bool &&
+		   kexp->nr_args == 2);
+	assert(KEXP_IS_VALID(karg, array));
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, (swap_args ? &aval2 : &aval1)))
+		return false;
+	karg = KEXP_NEXT_ARG(karg);
+	assert(KEXP_IS_VALID(karg, array));
+	if (!EXEC_KERN_EXPRESSION(kcxt, karg, (swap_args ? &aval1 : &aval2)))
+		return false;
+	if (XPU_DATUM_ISNULL(&aval1) || XPU_DATUM_ISNULL(&aval2))
+	{
+		result->expr_ops = NULL;
+		return true;
+	}
+	if (!__array_elems_setup(kcxt, &aval1, &ae1) ||
+		!__array_elems_setup(kcxt, &aval2, &ae2))
+		return false;
+	if (ae1.elemtype != ae2.elemtype)
+	{
+		STROM_ELOG(kcxt, "cannot compare arrays of different element types");
+		return false;
+	}
+
+	/*
+	 * Fast path: if @a2 is an integer array without NULLs sorted in
+	 * ascending order, we can look up the elements by binary search.
+	 */
+	if (ae2.is_signed && !ae2.nullmap && ae2.nitems > 8)
+	{
+		int64_t		prev = LLONG_MIN;
+
+		sorted = true;
+		while (__array_elems_next(kcxt, &ae2, &addr2, &len2, &isnull2))
+		{
+			int64_t	ival;
+
+			if (isnull2)
+			{
+				sorted = false;
+				break;
+			}
+			ival = __array_elem_as_int64(addr2, len2);
+			if (ival < prev)
+			{
+				sorted = false;
+				break;
+			}
+			prev = ival;
+		}
+		if (kcxt->errcode != 0)
+			return false;
+	}
+
+	while (__array_elems_next(kcxt, &ae1, &addr1, &len1, &isnull1))
+	{
+		bool	found = false;
+
+		if (isnull1)
+		{
+			if (matchall)
+			{
+				retval = false;
+				break;
+			}
+			continue;
+		}
+		if (sorted)
+		{
+			int64_t	key = __array_elem_as_int64(addr1, len1);
+			int		head = 0;
+			int		tail = ae2.nitems - 1;
+
+			while (head <= tail)
+			{
+				int		curr = (head + tail) / 2;
+				int64_t	ival;
+
+				/* heap array of integers has no padding between items */
+				if (ae2.kds)
+					addr2 = (const char *)
+						KDS_ARROW_REF_SIMPLE_DATUM(ae2.kds, ae2.smeta,
+												   ae2.start + curr,
+												   ae2.typlen);
+				else
+					addr2 = ae2.base + ae2.typlen * curr;
+				ival = __array_elem_as_int64(addr2, ae2.typlen);
+				if (key < ival)
+					tail = curr - 1;
+				else if (key > ival)
+					head = curr + 1;
+				else
+				{
+					found = true;
+					break;
+				}
+			}
+		}
+		else
+		{
+			/* rewind the iterator of @a2 */
+			ae2.curr = 0;
+			ae2.offset = 0;
+			while (__array_elems_next(kcxt, &ae2, &addr2, &len2, &isnull2))
+			{
+				if (!isnull2 && len1 == len2 &&
+					__memcmp(addr1, addr2, len1) == 0)
+				{
+					found = true;
+					break;
+				}
+			}
+			if (kcxt->errcode != 0)
+				return false;
+		}
+		if (found && !matchall)
+		{
+			retval = true;
+			break;
+		}
+		if (!found && matchall)
+		{
+			retval = false;
+			break;
+		}
+	}
+	if (kcxt->errcode != 0)
+		return false;
+	result->expr_ops = &xpu_bool_ops;
+	result->value = retval;
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_arraycontains(XPU_PGFUNCTION_ARGS)
+{
+	/* a @> b is array_contain_compare(b, a, true) */
+	return __array_contain_compare(kcxt, kexp, (xpu_bool_t *)__result,
+								   true, true);
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_arraycontained(XPU_PGFUNCTION_ARGS)
+{
+	/* a <@ b is array_contain_compare(a, b, true) */
+	return __array_contain_compare(kcxt, kexp, (xpu_bool_t *)__result,
+								   false, true);
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_arrayoverlap(XPU_PGFUNCTION_ARGS)
+{
+	return __array_contain_compare(kcxt, kexp, (xpu_bool_t *)__result,
+								   false, false);
+}
+
+/*
+ * array_ndims / array_length / cardinality
+ */
+STATIC_FUNCTION(bool)
+__array_dims_common(kern_context *kcxt,
+					const xpu_array_t *aval,
+					int32_t *p_ndim,
+					const __ArrayTypeData **p_ar)
+{
+	*p_ar = NULL;
+	if (aval->length >= 0)
+	{
+		/* Arrow::List is always 1-dimensional array */
+		*p_ndim = (aval->length > 0 ? 1 : 0);
+	}
+	else
+	{
+		const char *addr = (const char *)aval->u.heap.value;
+		const __ArrayTypeData *ar;
+
+		if (VARATT_IS_EXTERNAL(addr))
+		{
+			STROM_CPU_FALLBACK(kcxt, "array datum is external");
+			return false;
+		}
+		else if (VARATT_IS_COMPRESSED(addr))
+		{
+			int		len;
+
+			ar = (const __ArrayTypeData *)
+				pg_decompress_inline_datum(kcxt, addr, &len);
+			if (!ar)
+			{
+				STROM_CPU_FALLBACK(kcxt, "array datum is compressed");
+				return false;
+			}
+		}
+		else
+			ar = (const __ArrayTypeData *)VARDATA_ANY(addr);
+		*p_ndim = __pg_array_ndim(ar);
+		*p_ar = ar;
+	}
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_array_ndims(XPU_PGFUNCTION_ARGS)
+{
+	const __ArrayTypeData *ar;
+	int32_t		ndim;
+	KEXP_PROCESS_ARGS1(int4, array, aval);
+
+	if (XPU_DATUM_ISNULL(&aval))
+		result->expr_ops = NULL;
+	else if (!__array_dims_common(kcxt, &aval, &ndim, &ar))
+		return false;
+	else if (ndim <= 0)
+		result->expr_ops = NULL;
+	else
+	{
+		result->expr_ops = &xpu_int4_ops;
+		result->value = ndim;
+	}
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_array_length(XPU_PGFUNCTION_ARGS)
+{
+	const __ArrayTypeData *ar;
+	int32_t		ndim;
+	KEXP_PROCESS_ARGS2(int4, array, aval, int4, dim);
+
+	if (XPU_DATUM_ISNULL(&aval) || XPU_DATUM_ISNULL(&dim))
+		result->expr_ops = NULL;
+	else if (!__array_dims_common(kcxt, &aval, &ndim, &ar))
+		return false;
+	else if (ndim <= 0 || dim.value < 1 || dim.value > ndim)
+		result->expr_ops = NULL;
+	else
+	{
+		result->expr_ops = &xpu_int4_ops;
+		result->value = (ar ? __pg_array_dim(ar, dim.value - 1) : aval.length);
+	}
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_cardinality(XPU_PGFUNCTION_ARGS)
+{
+	const __ArrayTypeData *ar;
+	int32_t		ndim;
+	KEXP_PROCESS_ARGS1(int4, array, aval);
+
+	if (XPU_DATUM_ISNULL(&aval))
+		result->expr_ops = NULL;
+	else if (!__array_dims_common(kcxt, &aval, &ndim, &ar))
+		return false;
+	else
+	{
+		result->expr_ops = &xpu_int4_ops;
+		if (!ar)
+			result->value = aval.length;
+		else
+		{
+			result->value = (ndim > 0 ? 1 : 0);
+			for (int k=0; k < ndim; k++)
+				result->value *= __pg_array_dim(ar, k);
+		}
+	}
+	return true;
+}
@@ -67,6 +67,7 @@ typedef struct
 PGSTROM_SQLTYPE_SIMPLE_DECLARATION(money,   Cash);
 PGSTROM_SQLTYPE_SIMPLE_DECLARATION(uuid,    pg_uuid_t);
 PGSTROM_SQLTYPE_SIMPLE_DECLARATION(macaddr, macaddr);
+PGSTROM_SQLTYPE_SIMPLE_DECLARATION(tid,     ItemPointerData);
 
 typedef struct {
 	KVEC_DATUM_COMMON_FIELD;
@@ -110,4 +111,16 @@ typedef struct __NDBOX		__NDBOX;
 
 PGSTROM_SQLTYPE_VARLENA_DECLARATION(cube);
 
+/*
+ * vector (pgvector extension)
+ */
+struct __VECTOR {
+	int16_t		dim;		/* number of dimensions */
+	int16_t		unused;		/* reserved for future use, always zero */
+	float		x[1];		/* flexible length */
+}	__attribute__ ((packed));
+typedef struct __VECTOR		__VECTOR;
+
+PGSTROM_SQLTYPE_VARLENA_DECLARATION(vector);
+
 #endif	/* XPU_MISCLIB_H */
@@ -87,8 +87,8 @@ xpu_numeric_datum_arrow_read(kern_context *kcxt,
 														kds_index,
 														sizeof(int128_t));
 	if (addr)
-		set_normalized_numeric(result, *addr,
-							   cmeta->attopts.decimal.scale);
+		set_scaled_numeric(result, *addr,
+						   cmeta->attopts.decimal.scale);
 	else
 		result->expr_ops = NULL;
 	return true;
@@ -218,11 +218,33 @@ xpu_numeric_datum_hash(kern_context *kcxt,
 	else if (arg->kind != XPU_NUMERIC_KIND__VALID)
 		*p_hash = pg_hash_any(&arg->kind, sizeof(uint8_t));
 	else
-		*p_hash = (pg_hash_any(&arg->weight, sizeof(int16_t)) ^
-				   pg_hash_any(&arg->u.value, sizeof(int128_t)));
+	{
+		xpu_numeric_t	temp;
+
+		/* same value must have same hash, regardless of the scale */
+		set_normalized_numeric(&temp, arg->u.value, arg->weight);
+		*p_hash = (pg_hash_any(&temp.weight, sizeof(int16_t)) ^
+				   pg_hash_any(&temp.u.value, sizeof(int128_t)));
+	}
 	return true;
 }
 
+/*
+ * __numeric_scale_up - multiply 10^nshift, by 10^4 steps if possible
+ */
+INLINE_FUNCTION(int128_t)
+__numeric_scale_up(int128_t value, int nshift)
+{
+	while (nshift >= PG_DEC_DIGITS)
+	{
+		value *= PG_NBASE;
+		nshift -= PG_DEC_DIGITS;
+	}
+	while (nshift-- > 0)
+		value *= 10;
+	return value;
+}
+
 STATIC_FUNCTION(int)
 __numeric_compare(const xpu_numeric_t *a, const xpu_numeric_t *b);
 
@@ -589,16 +611,10 @@ __numeric_compare(const xpu_numeric_t *a, const xpu_numeric_t *b)
 	else if ((b_val > 0 && a_val <= 0) || (b_val == 0 && a_val < 0))
 		return -1;
 	/* Ok, both side are same sign with valid values */
-	while (a_weight > b_weight)
-	{
-		b_val *= 10;
-		b_weight++;
-	}
-	while (a_weight < b_weight)
-	{
-		a_val *= 10;
-		a_weight++;
-	}
+	if (a_weight > b_weight)
+		b_val = __numeric_scale_up(b_val, a_weight - b_weight);
+	else if (a_weight < b_weight)
+		a_val = __numeric_scale_up(a_val, b_weight - a_weight);
 	if (a_val > b_val)
 		return 1;
 	if (a_val < b_val)
@@ -679,19 +695,24 @@ pgfn_numeric_add(XPU_PGFUNCTION_ARGS)
 		}
 		else
 		{
-			while (datum_a.weight > datum_b.weight)
+			/* result keeps the larger scale, as PostgreSQL doing */
+			if (datum_a.weight > datum_b.weight)
 			{
-				datum_b.u.value *= 10;
-				datum_b.weight++;
+				datum_b.u.value = __numeric_scale_up(datum_b.u.value,
+													 datum_a.weight -
+													 datum_b.weight);
+				datum_b.weight = datum_a.weight;
 			}
-			while (datum_a.weight < datum_b.weight)
+			else if (datum_a.weight < datum_b.weight)
 			{
-				datum_a.u.value *= 10;
-				datum_a.weight++;
+				datum_a.u.value = __numeric_scale_up(datum_a.u.value,
+													 datum_b.weight -
+													 datum_a.weight);
+				datum_a.weight = datum_b.weight;
 			}
-			set_normalized_numeric(result,
-								   datum_a.u.value + datum_b.u.value,
-								   datum_a.weight);
+			set_scaled_numeric(result,
+							   datum_a.u.value + datum_b.u.value,
+							   datum_a.weight);
 		}
 	}
 	return true;
@@ -740,19 +761,24 @@ pgfn_numeric_sub(XPU_PGFUNCTION_ARGS)
 		}
 		else
 		{
-			while (datum_a.weight > datum_b.weight)
+			/* result keeps the larger scale, as PostgreSQL doing */
+			if (datum_a.weight > datum_b.weight)
 			{
-				datum_b.u.value *= 10;
-				datum_b.weight++;
+				datum_b.u.value = __numeric_scale_up(datum_b.u.value,
+													 datum_a.weight -
+													 datum_b.weight);
+				datum_b.weight = datum_a.weight;
 			}
-			while (datum_a.weight < datum_b.weight)
+			else if (datum_a.weight < datum_b.weight)
 			{
-				datum_a.u.value *= 10;
-				datum_a.weight++;
+				datum_a.u.value = __numeric_scale_up(datum_a.u.value,
+													 datum_b.weight -
+													 datum_a.weight);
+				datum_a.weight = datum_b.weight;
 			}
-			set_normalized_numeric(result,
-								   datum_a.u.value - datum_b.u.value,
-								   datum_a.weight);
+			set_scaled_numeric(result,
+							   datum_a.u.value - datum_b.u.value,
+							   datum_a.weight);
 		}
 	}
 	return true;
@@ -827,6 +853,17 @@ pgfn_numeric_mul(XPU_PGFUNCTION_ARGS)
 					result->kind = XPU_NUMERIC_KIND__NAN;
 			}
 		}
+		else if (datum_a.u.value >= LONG_MIN && datum_a.u.value <= LONG_MAX &&
+				 datum_b.u.value >= LONG_MIN && datum_b.u.value <= LONG_MAX)
+		{
+			/*
+			 * product of 64bit values never overflow, so result keeps the
+			 * sum of the scales, as PostgreSQL doing.
+			 */
+			set_scaled_numeric(result,
+							   datum_a.u.value * datum_b.u.value,
+							   datum_a.weight + datum_b.weight);
+		}
 		else
 		{
 			set_normalized_numeric(result,
@@ -167,6 +167,18 @@ set_normalized_numeric(xpu_numeric_t *result, int128_t value, int16_t weight)
 {
 	if (value == 0)
 		weight = 0;
+	else if (value >= LONG_MIN && value <= LONG_MAX)
+	{
+		/* fast path; 128bit division is much more expensive */
+		int64_t		ival = (int64_t)value;
+
+		while (ival % 10 == 0)
+		{
+			ival /= 10;
+			weight--;
+		}
+		value = ival;
+	}
 	else
 	{
 		while (value % 10 == 0)
@@ -181,6 +193,24 @@ set_normalized_numeric(xpu_numeric_t *result, int128_t value, int16_t weight)
 	result->u.value  = value;
 }
 
+/*
+ * set_scaled_numeric
+ *
+ * It sets the fixed-point value with the given scale as is. Arrow::Decimal
+ * values and the results of addition/subtraction keep their scale, like the
+ * display scale of PostgreSQL numeric, because the normalization needs 128bit
+ * divisions for each trailing zero. Note that the same value may have
+ * different weights, so hash calculation must normalize it.
+ */
+INLINE_FUNCTION(void)
+set_scaled_numeric(xpu_numeric_t *result, int128_t value, int16_t weight)
+{
+	result->expr_ops = &xpu_numeric_ops;
+	result->kind     = XPU_NUMERIC_KIND__VALID;
+	result->weight   = weight;
+	result->u.value  = value;
+}
+
 INLINE_FUNCTION(const char *)
 __xpu_numeric_from_varlena(xpu_numeric_t *result, const varlena *addr)
 {
@@ -213,8 +243,16 @@ __xpu_numeric_from_varlena(xpu_numeric_t *result, const varlena *addr)
 			int			weight  = NUMERIC_WEIGHT(nc, n_head) + 1;
 			int			i, ndigits = NUMERIC_NDIGITS(n_head, len);
 			int128_t	value = 0;
-
-			for (i=0; i < ndigits; i++)
+			int64_t		ival = 0;
+
+			/*
+			 * fast path; up to 4 digits of PG_NBASE (10^16) never overflow
+			 * int64, and it covers most of numeric(18,x) values.
+			 */
+			for (i=0; i < ndigits && i < 4; i++)
+				ival = ival * PG_NBASE + __Fetch(&digits[i]);
+			value = ival;
+			for (; i < ndigits; i++)
 			{
 				NumericDigit dig = __Fetch(&digits[i]);
 
@@ -38,10 +38,12 @@ TYPE_OPCODE(money, NULL, DEVTYPE__HAS_COMPARE)
 TYPE_OPCODE(uuid, NULL, DEVTYPE__HAS_COMPARE)
 TYPE_OPCODE(macaddr, NULL, DEVTYPE__HAS_COMPARE)
 TYPE_OPCODE(inet, NULL, DEVTYPE__HAS_COMPARE)
+TYPE_OPCODE(tid, NULL, 0)
 TYPE_OPCODE(jsonb, NULL, 0)
 TYPE_OPCODE(geometry, "postgis", 0)
 TYPE_OPCODE(box2df, "postgis", 0)
 TYPE_OPCODE(cube, "cube", 0)
+TYPE_OPCODE(vector, "vector", 0)
 
 #ifndef TYPE_ALIAS
 #define TYPE_ALIAS(NAME,EXTENSION,BASE,BASE_EXTENSION)
@@ -665,6 +667,17 @@ FUNC_OPCODE(extract, text/time,        DEVKIND__ANY, extract_time,        50, NU
 FUNC_OPCODE(extract, text/timetz,      DEVKIND__ANY, extract_timetz,      50, NULL)
 FUNC_OPCODE(extract, text/interval,    DEVKIND__ANY, extract_interval,    50, NULL)
 
+/* date_trunc / date_bin / time_bucket */
+FUNC_OPCODE(date_trunc, text/timestamp,   DEVKIND__ANY, timestamp_trunc,   50, NULL)
+FUNC_OPCODE(date_trunc, text/timestamptz, DEVKIND__ANY, timestamptz_trunc, 50, NULL)
+FUNC_OPCODE(date_trunc, text/timestamptz/text, DEVKIND__ANY, timestamptz_trunc_zone, 50, NULL)
+FUNC_OPCODE(date_bin, interval/timestamp/timestamp,     DEVKIND__ANY, timestamp_bin,   10, NULL)
+FUNC_OPCODE(date_bin, interval/timestamptz/timestamptz, DEVKIND__ANY, timestamptz_bin, 10, NULL)
+FUNC_OPCODE(time_bucket, interval/timestamp,   DEVKIND__ANY, time_bucket_timestamp,   10, "timescaledb")
+FUNC_OPCODE(time_bucket, interval/timestamptz, DEVKIND__ANY, time_bucket_timestamptz, 10, "timescaledb")
+FUNC_OPCODE(time_bucket, interval/timestamp/timestamp,     DEVKIND__ANY, time_bucket_timestamp_origin,   10, "timescaledb")
+FUNC_OPCODE(time_bucket, interval/timestamptz/timestamptz, DEVKIND__ANY, time_bucket_timestamptz_origin, 10, "timescaledb")
+
 /*
  * Text functions/operators
  */
@@ -695,12 +708,23 @@ __FUNC_OPCODE(texticlike, text/text, 800, NULL)
 __FUNC_OPCODE(bpchariclike, bpchar/text, 800, NULL)
 __FUNC_OPCODE(texticnlike, text/text, 800, NULL)
 __FUNC_OPCODE(bpcharicnlike, bpchar/text, 800, NULL)
+/* regular expression / LIKE by DFA (built on the host side) */
+DEVONLY_FUNC_OPCODE(bool, textregex_dfa, text/bytea, DEVKIND__ANY, 100)
+/* LIKE '%literal%' by substring search */
+DEVONLY_FUNC_OPCODE(bool, textlike_substr, text/bytea, DEVKIND__ANY, 100)
 
 /* String operations */
 FUNC_OPCODE(substr,    text/int4/int4, DEVKIND__ANY, substr,    20, NULL)
 FUNC_OPCODE(substring, text/int4/int4, DEVKIND__ANY, substring, 20, NULL)
 FUNC_OPCODE(substr,    text/int4,      DEVKIND__ANY, substr_nolen, 20, NULL)
 FUNC_OPCODE(substring, text/int4,      DEVKIND__ANY, substring_nolen, 20, NULL)
+FUNC_OPCODE(lower,     text,           DEVFUNC__LOCALE_CTYPE|DEVKIND__ANY, lower, 20, NULL)
+FUNC_OPCODE(upper,     text,           DEVFUNC__LOCALE_CTYPE|DEVKIND__ANY, upper, 20, NULL)
+FUNC_OPCODE(strpos,    text/text,      DEVKIND__ANY, strpos, 20, NULL)
+FUNC_ALIAS(position,   text/text,      DEVKIND__ANY, strpos, 20, NULL)
+/* lower/upper with Unicode case mapping (replaced on the host side) */
+DEVONLY_FUNC_OPCODE(text, lower_unicode, text, DEVKIND__ANY, 30)
+DEVONLY_FUNC_OPCODE(text, upper_unicode, text, DEVKIND__ANY, 30)
 //__FUNC_OPCODE(textcat, text/text, NULL)
 //__FUNC_OPCODE(concat, __text__, NULL)
 
@@ -738,6 +762,8 @@ __FUNC_OPCODE(network_subeq,   inet/inet, 10, NULL)
 __FUNC_OPCODE(network_sup,     inet/inet, 10, NULL)
 __FUNC_OPCODE(network_supeq,   inet/inet, 10, NULL)
 __FUNC_OPCODE(network_overlap, inet/inet, 10, NULL)
+/* tid functions */
+__FUNC_OPCODE(tid_block_number, tid, 1, "pg_strom")
 
 /* jsonb type support */
 __FUNC_OPCODE(jsonb_object_field, jsonb/text, 35, NULL)
@@ -754,6 +780,7 @@ DEVONLY_FUNC_OPCODE(int8,   jsonb_object_field_as_int8,   jsonb/text, DEVKIND__A
 DEVONLY_FUNC_OPCODE(float2, jsonb_object_field_as_float2, jsonb/text, DEVKIND__ANY, 10)
 DEVONLY_FUNC_OPCODE(float4, jsonb_object_field_as_float4, jsonb/text, DEVKIND__ANY, 10)
 DEVONLY_FUNC_OPCODE(float8, jsonb_object_field_as_float8, jsonb/text, DEVKIND__ANY, 10)
+DEVONLY_FUNC_OPCODE(text,   jsonb_vcol_field_text,        text/text,  DEVKIND__ANY, 1)
 
 DEVONLY_FUNC_OPCODE(numeric,jsonb_array_element_as_numeric, jsonb/text, DEVKIND__ANY, 10)
 DEVONLY_FUNC_OPCODE(int1,   jsonb_array_element_as_int1,    jsonb/text, DEVKIND__ANY, 10)
@@ -763,6 +790,9 @@ DEVONLY_FUNC_OPCODE(int8,   jsonb_array_element_as_int8,    jsonb/text, DEVKIND_
 DEVONLY_FUNC_OPCODE(float2, jsonb_array_element_as_float2,  jsonb/text, DEVKIND__ANY, 10)
 DEVONLY_FUNC_OPCODE(float4, jsonb_array_element_as_float4,  jsonb/text, DEVKIND__ANY, 10)
 DEVONLY_FUNC_OPCODE(float8, jsonb_array_element_as_float8,  jsonb/text, DEVKIND__ANY, 10)
+/* jsonb_path_exists / jsonb_path_match by compiled JSONPath */
+DEVONLY_FUNC_OPCODE(bool,   jsonb_path_exists_prog,         jsonb/bytea, DEVKIND__ANY, 100)
+DEVONLY_FUNC_OPCODE(bool,   jsonb_path_match_prog,          jsonb/bytea, DEVKIND__ANY, 100)
 
 /* PostGIS functions */
 FUNC_OPCODE(st_point,     float8/float8,               DEVKIND__ANY, st_point,      5, "postgis")
@@ -771,6 +801,7 @@ FUNC_OPCODE(st_makepoint, float8/float8/float8,        DEVKIND__ANY, st_makepoin
 FUNC_OPCODE(st_makepoint, float8/float8/float8/float8, DEVKIND__ANY, st_makepoint4, 5, "postgis")
 __FUNC_OPCODE(st_setsrid,        geometry/int4,             5, "postgis")
 __FUNC_OPCODE(st_distance,       geometry/geometry,        99, "postgis")
+__FUNC_OPCODE(geometry_distance_centroid, geometry/geometry, 99, "postgis")
 __FUNC_OPCODE(st_dwithin,        geometry/geometry/float8, 99, "postgis")
 __FUNC_OPCODE(st_linecrossingdirection, geometry/geometry, 99, "postgis")
 __FUNC_OPCODE(st_relate,         geometry/geometry,        99, "postgis")
@@ -801,6 +832,28 @@ __FUNC_OPCODE(cube_contains,  cube/cube, 10, "cube")
 __FUNC_OPCODE(cube_contained, cube/cube, 10, "cube")
 __FUNC_OPCODE(cube_ll_coord,  cube/int4, 10, "cube")
 
+/* array functions and operators */
+__FUNC_OPCODE(arraycontains, array/array, 50, NULL)
+__FUNC_OPCODE(arraycontained, array/array, 50, NULL)
+__FUNC_OPCODE(arrayoverlap, array/array, 50, NULL)
+__FUNC_OPCODE(array_ndims, array, 2, NULL)
+__FUNC_OPCODE(array_length, array/int4, 2, NULL)
+__FUNC_OPCODE(cardinality, array, 2, NULL)
+
+/* dot product / cosine similarity of float2[] */
+__FUNC_OPCODE(float2_dot_product,       array/array, 20, "pg_strom")
+__FUNC_OPCODE(float2_cosine_similarity, array/array, 20, "pg_strom")
+
+/* pgvector */
+__FUNC_OPCODE(vector_dims,                  vector,        5, "vector")
+__FUNC_OPCODE(vector_norm,                  vector,       10, "vector")
+__FUNC_OPCODE(l2_distance,                  vector/vector, 20, "vector")
+__FUNC_OPCODE(vector_l2_squared_distance,   vector/vector, 20, "vector")
+__FUNC_OPCODE(inner_product,                vector/vector, 20, "vector")
+__FUNC_OPCODE(vector_negative_inner_product, vector/vector, 20, "vector")
+__FUNC_OPCODE(cosine_distance,              vector/vector, 20, "vector")
+__FUNC_OPCODE(l1_distance,                  vector/vector, 20, "vector")
+
 #undef TYPE_OPCODE
 #undef TYPE_ALIAS
 #undef FUNC_OPCODE
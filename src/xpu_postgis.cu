@@ -3327,8 +3327,8 @@ geom_dist2d_recursive(const xpu_geometry_t *geom1,
 	return true;
 }
 
-PUBLIC_FUNCTION(bool)
-pgfn_st_distance(XPU_PGFUNCTION_ARGS)
+STATIC_FUNCTION(bool)
+__geometry_distance(XPU_PGFUNCTION_ARGS)
 {
 	xpu_float8_t   *result = (xpu_float8_t *)__result;
 	xpu_geometry_t	geom1;
@@ -3369,6 +3369,24 @@ pgfn_st_distance(XPU_PGFUNCTION_ARGS)
 	return true;
 }
 
+PUBLIC_FUNCTION(bool)
+pgfn_st_distance(XPU_PGFUNCTION_ARGS)
+{
+	return __geometry_distance(kcxt, kexp, __result);
+}
+
+/*
+ * geometry_distance_centroid - the function behind the '<->' operator.
+ * PostGIS (2.2 or later) returns the true minimum distance, same as
+ * st_distance(), so KNN queries ("ORDER BY geom <-> point LIMIT k") can
+ * compute the sort key on the device and prune by GPU top-k.
+ */
+PUBLIC_FUNCTION(bool)
+pgfn_geometry_distance_centroid(XPU_PGFUNCTION_ARGS)
+{
+	return __geometry_distance(kcxt, kexp, __result);
+}
+
 /*
  * St_Dwithin - Returns true if the geometries are within the specified
  *              distance of one another
@@ -3757,6 +3775,142 @@ __geom_point_in_multipolygon(const xpu_geometry_t *geom, const POINT2D *pt,
 	return retval;
 }
 
+/*
+ * __lookup_prep_polygon
+ *
+ * It looks up the prepared form of the polygon, built on the inner preloading,
+ * by the address of geometry datum on the inner buffer.
+ */
+STATIC_FUNCTION(const kern_prep_polygon *)
+__lookup_prep_polygon(kern_context *kcxt, const char *gs_addr)
+{
+	kern_multirels *kmrels = kcxt->kmrels;
+
+	if (!kmrels || !gs_addr)
+		return NULL;
+	for (int i=0; i < kmrels->num_rels; i++)
+	{
+		uint64_t	prep_offset = kmrels->chunks[i].prep_geom_offset;
+		const kern_data_store *kds;
+		const kern_prep_geometry *prep;
+		uint64_t	key;
+		uint32_t	index;
+
+		if (prep_offset == 0)
+			continue;
+		kds = KERN_MULTIRELS_INNER_KDS(kmrels, i);
+		if (gs_addr <= (const char *)kds ||
+			gs_addr >= (const char *)kds + kds->length)
+			continue;
+		prep = (const kern_prep_geometry *)((const char *)kmrels + prep_offset);
+		if (prep->nitems == 0)
+			break;
+		key = (gs_addr - (const char *)kds);
+		index = __kern_prep_geometry_hash(key) % prep->nslots;
+		for (uint32_t loop=0; loop < prep->nslots; loop++)
+		{
+			if (prep->slots[index].key == key)
+				return (const kern_prep_polygon *)
+					((const char *)prep + prep->slots[index].value);
+			if (prep->slots[index].key == 0)
+				break;
+			index = (index + 1) % prep->nslots;
+		}
+		break;
+	}
+	return NULL;
+}
+
+/*
+ * __geom_point_in_prep_polygon
+ *
+ * Same as __geom_point_in_multipolygon, but checks only the edges in the slab
+ * that covers the point. Rings that have no edges in the slab never contain
+ * the point.
+ */
+STATIC_FUNCTION(int32_t)
+__geom_point_in_prep_polygon(const kern_prep_polygon *prep, const POINT2D *pt)
+{
+	const uint32_t *ring_info = KERN_PREP_POLYGON_RING_INFO(prep);
+	const uint32_t *slab_head = KERN_PREP_POLYGON_SLAB_HEAD(prep);
+	const kern_prep_edge *edges = KERN_PREP_POLYGON_EDGES(prep);
+	double		slab;
+	uint32_t	s, k;
+	uint32_t	curr_ring = UINT_MAX;
+	uint32_t	curr_poly = UINT_MAX;
+	int			poly_state = 0;	/* 1: inside the exterior, 2: inside a hole */
+	int			wn = 0;
+	bool		on_boundary = false;
+
+	slab = floor((pt->y - prep->ymin) / prep->yunit);
+	if (slab < 0.0)
+		return PT_OUTSIDE;
+	s = (slab >= (double)prep->nslabs ? prep->nslabs - 1 : (uint32_t)slab);
+	for (k = slab_head[s]; ; k++)
+	{
+		const kern_prep_edge *edge;
+		POINT2D		seg1;
+		POINT2D		seg2;
+		double		side;
+
+		if (k == slab_head[s+1] || edges[k].ring_id != curr_ring)
+		{
+			/* status of the ring just finished */
+			if (curr_ring != UINT_MAX)
+			{
+				uint32_t	info = ring_info[curr_ring];
+				int32_t		status = (on_boundary ? PT_BOUNDARY :
+									  wn != 0 ? PT_INSIDE : PT_OUTSIDE);
+
+				if ((info >> 1) != curr_poly)
+				{
+					if (poly_state == 1)
+						return PT_INSIDE;
+					curr_poly = (info >> 1);
+					poly_state = 0;
+				}
+				if ((info & 1) == 0)
+				{
+					/* exterior ring */
+					if (status == PT_BOUNDARY)
+						return PT_BOUNDARY;
+					poly_state = (status == PT_INSIDE ? 1 : 0);
+				}
+				else if (poly_state == 1)
+				{
+					/* on the edge of a hole */
+					if (status == PT_BOUNDARY)
+						return PT_BOUNDARY;
+					/* inside a hole => outside the polygon */
+					if (status == PT_INSIDE)
+						poly_state = 2;
+				}
+			}
+			if (k == slab_head[s+1])
+				break;
+			curr_ring = edges[k].ring_id;
+			wn = 0;
+			on_boundary = false;
+		}
+		if (on_boundary)
+			continue;
+		/* see __geom_point_in_ring */
+		edge = &edges[k];
+		seg1.x = edge->x1;
+		seg1.y = edge->y1;
+		seg2.x = edge->x2;
+		seg2.y = edge->y2;
+		side = determineSide(&seg1, &seg2, pt);
+		if (side == 0.0 && isOnSegment(&seg1, &seg2, pt))
+			on_boundary = true;
+		else if (seg1.y <= pt->y && pt->y < seg2.y && side > 0.0)
+			wn++;
+		else if (seg2.y <= pt->y && pt->y < seg1.y && side < 0.0)
+			wn--;
+	}
+	return (poly_state == 1 ? PT_INSIDE : PT_OUTSIDE);
+}
+
 /* ================================================================
  *
  * Routines to generate intersection-matrix
@@ -6051,7 +6205,8 @@ pgfn_st_relate(XPU_PGFUNCTION_ARGS)
 STATIC_FUNCTION(int)
 fast_geom_contains_polygon_point(kern_context *kcxt,
 								 const xpu_geometry_t *geom1,
-								 const xpu_geometry_t *geom2)
+								 const xpu_geometry_t *geom2,
+								 const kern_prep_polygon *prep)
 {
 	POINT2D		pt;
 	int32_t		status = PT_ERROR;
@@ -6073,7 +6228,9 @@ fast_geom_contains_polygon_point(kern_context *kcxt,
 				pt.y < bbox.ymin || pt.y > bbox.ymax)
 				return 0;
 		}
-		if (geom1->type == GEOM_POLYGONTYPE)
+		if (prep)
+			status = __geom_point_in_prep_polygon(prep, &pt);
+		else if (geom1->type == GEOM_POLYGONTYPE)
 			status = __geom_point_in_polygon(geom1, &pt, kcxt);
 		else
 			status = __geom_point_in_multipolygon(geom1, &pt, kcxt);
@@ -6099,7 +6256,9 @@ fast_geom_contains_polygon_point(kern_context *kcxt,
 				status = PT_OUTSIDE;
 				break;
 			}
-			if (geom1->type == GEOM_POLYGONTYPE)
+			if (prep)
+				status = __geom_point_in_prep_polygon(prep, &pt);
+			else if (geom1->type == GEOM_POLYGONTYPE)
 				status = __geom_point_in_polygon(geom1, &pt, kcxt);
 			else
 				status = __geom_point_in_multipolygon(geom1, &pt, kcxt);
@@ -6121,6 +6280,9 @@ PUBLIC_FUNCTION(bool)
 pgfn_st_contains(XPU_PGFUNCTION_ARGS)
 {
 	KEXP_PROCESS_ARGS2(bool, geometry, geom1, geometry, geom2);
+	/* datum address on the inner buffer, if not parsed yet */
+	const char *gs_addr = (geom1.type == GEOM_INVALID_VARLENA
+						   ? geom1.rawdata : NULL);
 
 	if (XPU_DATUM_ISNULL(&geom1) || XPU_DATUM_ISNULL(&geom2))
 		result->expr_ops = NULL;
@@ -6145,7 +6307,8 @@ pgfn_st_contains(XPU_PGFUNCTION_ARGS)
 			(geom2.type == GEOM_POINTTYPE ||
 			 geom2.type == GEOM_MULTIPOINTTYPE))
 		{
-			status = fast_geom_contains_polygon_point(kcxt, &geom1, &geom2);
+			status = fast_geom_contains_polygon_point(kcxt, &geom1, &geom2,
+													  __lookup_prep_polygon(kcxt, gs_addr));
 			if (status >= 0)
 			{
 				result->expr_ops = &xpu_bool_ops;
@@ -198,4 +198,74 @@ typedef struct
 	double	x, y, z, m;
 } POINT4D;
 
+/*
+ * kern_prep_polygon - prepared form of (multi-)polygon
+ *
+ * Edges of the polygon are bucketed into the horizontal slabs of equal
+ * height, so point-in-polygon test needs to check only the edges of the
+ * slab that covers the Y-coordinate of the point, instead of all the edges.
+ * Edges in a slab are sorted by the ring-id, and ring_info[] tells the
+ * polygon index of the ring ('>> 1') and whether it is a hole ('& 1').
+ * Zero-length edges are not included.
+ */
+typedef struct
+{
+	double		x1, y1;
+	double		x2, y2;
+	uint32_t	ring_id;
+	uint32_t	__padding;
+} kern_prep_edge;
+
+typedef struct
+{
+	uint32_t	length;
+	uint32_t	nrings;
+	uint32_t	nslabs;
+	uint32_t	nedges;			/* number of edges in the slabs */
+	double		ymin;
+	double		yunit;			/* height of a slab */
+	/* uint32_t		ring_info[nrings]; */
+	/* uint32_t		slab_head[nslabs+1]; */
+	/* kern_prep_edge edges[nedges]; (MAXALIGN) */
+	char		data[1];
+} kern_prep_polygon;
+
+#define KERN_PREP_POLYGON_RING_INFO(prep)		\
+	((uint32_t *)(prep)->data)
+#define KERN_PREP_POLYGON_SLAB_HEAD(prep)		\
+	(KERN_PREP_POLYGON_RING_INFO(prep) + (prep)->nrings)
+#define KERN_PREP_POLYGON_EDGES(prep)			\
+	((kern_prep_edge *)((char *)(prep) +		\
+		MAXALIGN(offsetof(kern_prep_polygon, data) +	\
+				 sizeof(uint32_t) * ((prep)->nrings + (prep)->nslabs + 1))))
+
+/*
+ * kern_prep_geometry - hash table of the prepared inner geometries
+ *
+ * It is keyed by the offset of the geometry datum (varlena) from the head
+ * of the inner kds_hash, and the value is the offset of kern_prep_polygon
+ * from the head of this table.
+ */
+typedef struct
+{
+	uint64_t	length;
+	uint32_t	nslots;
+	uint32_t	nitems;
+	uint64_t	usage;			/* usage of the polygon pool */
+	uint64_t	pool_offset;	/* offset to the polygon pool */
+	struct {
+		uint64_t	key;		/* 0 means empty */
+		uint64_t	value;
+	} slots[1];
+} kern_prep_geometry;
+
+INLINE_FUNCTION(uint32_t)
+__kern_prep_geometry_hash(uint64_t key)
+{
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdUL;
+	key ^= key >> 33;
+	return (uint32_t)key;
+}
+
 #endif /* XPU_POSTGIS_H */
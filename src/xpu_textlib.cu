@@ -25,6 +25,16 @@ __xpu_varlena_datum_arrow_ref(kern_context *kcxt,
 {
 	uint32_t	unitsz;
 
+	if (cmeta->dict_index_sz > 0)
+	{
+		/* dictionary-encoded column; reference the entry as is */
+		kds_index = KDS_ARROW_DICT_INDEX(kds, cmeta, kds_index);
+		if (kds_index == UINT_MAX)
+		{
+			*p_value = NULL;
+			return true;
+		}
+	}
 	switch (cmeta->attopts.tag)
 	{
 		case ArrowType__FixedSizeBinary:
@@ -1155,6 +1165,125 @@ PG_BPCHARLIKE_TEMPLATE(bpcharnlike, GenericMatchText, !=)
 PG_BPCHARLIKE_TEMPLATE(bpchariclike, GenericCaseMatchText, ==)
 PG_BPCHARLIKE_TEMPLATE(bpcharicnlike, GenericCaseMatchText, !=)
 
+/*
+ * LIKE '%literal%' by substring search
+ *
+ * GPU uses Boyer-Moore-Horspool with the shift table built on the host
+ * side. DPU (and CPU) relies on memmem(3) of the system library; it is
+ * usually well optimized for the platform.
+ */
+INLINE_FUNCTION(bool)
+__textlike_substr_search(const char *str, int slen,
+						 const kern_like_needle *nd, int nlen)
+{
+#ifdef __CUDACC__
+	int			last = nlen - 1;
+	uint8_t		tail;
+
+	if (nlen == 0)
+		return true;
+	if (nlen > slen)
+		return false;
+	tail = (uint8_t)nd->needle[last];
+	for (int pos=0; pos <= slen - nlen; )
+	{
+		uint8_t		c = (uint8_t)str[pos + last];
+
+		if (c == tail && __memcmp(str + pos, nd->needle, last) == 0)
+			return true;
+		pos += nd->shift[c];
+	}
+	return false;
+#else
+	if (nlen == 0)
+		return true;
+	return (memmem(str, slen, nd->needle, nlen) != NULL);
+#endif
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_textlike_substr(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS2(bool,
+					   text,  datum_a,		/* string */
+					   bytea, datum_b);		/* needle */
+	if (XPU_DATUM_ISNULL(&datum_a) || XPU_DATUM_ISNULL(&datum_b))
+		result->expr_ops = NULL;
+	else
+	{
+		const kern_like_needle *nd = (const kern_like_needle *)datum_b.value;
+		int			nlen;
+
+		if (!xpu_text_is_valid(kcxt, &datum_a) ||
+			!xpu_bytea_is_valid(kcxt, &datum_b))
+			return false;
+		nlen = datum_b.length - (int)offsetof(kern_like_needle, needle);
+		if (nlen < 0)
+		{
+			STROM_ELOG(kcxt, "corrupted needle of LIKE pattern");
+			return false;
+		}
+		result->value = __textlike_substr_search(datum_a.value,
+												 datum_a.length,
+												 nd, nlen);
+		if ((nd->flags & KERN_LIKE_NEEDLE__NEGATE) != 0)
+			result->value = !result->value;
+		result->expr_ops = &xpu_bool_ops;
+	}
+	return true;
+}
+
+/*
+ * Regular expression / LIKE by DFA
+ *
+ * The DFA is built on the host side, so the matcher just walks on the
+ * transition table byte by byte, without backtrack or recursion.
+ */
+PUBLIC_FUNCTION(bool)
+pgfn_textregex_dfa(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS2(bool,
+					   text,  datum_a,		/* string */
+					   bytea, datum_b);		/* DFA */
+	if (XPU_DATUM_ISNULL(&datum_a) || XPU_DATUM_ISNULL(&datum_b))
+		result->expr_ops = NULL;
+	else
+	{
+		const kern_regex_dfa *dfa = (const kern_regex_dfa *)datum_b.value;
+		const uint8_t  *trans;
+		const uint8_t  *sflags;
+		uint32_t		nclasses;
+		uint32_t		state;
+
+		if (!xpu_text_is_valid(kcxt, &datum_a) ||
+			!xpu_bytea_is_valid(kcxt, &datum_b))
+			return false;
+		if (datum_b.length < offsetof(kern_regex_dfa, data) ||
+			datum_b.length < KERN_REGEX_DFA_LENGTH(dfa->nstates,
+												   dfa->nclasses))
+		{
+			STROM_ELOG(kcxt, "corrupted DFA of regular expression");
+			return false;
+		}
+		nclasses = dfa->nclasses;
+		trans = dfa->data;
+		sflags = dfa->data + dfa->nstates * nclasses;
+		state = dfa->start;
+		for (int i=0; i < datum_a.length; i++)
+		{
+			if ((sflags[state] & KERN_REGEX_DFA_STATE__FINAL) != 0)
+				break;
+			state = trans[state * nclasses +
+						  dfa->class_map[(uint8_t)datum_a.value[i]]];
+		}
+		result->value = ((sflags[state] & KERN_REGEX_DFA_STATE__ACCEPT) != 0);
+		if ((dfa->flags & KERN_REGEX_DFA__NEGATE) != 0)
+			result->value = !result->value;
+		result->expr_ops = &xpu_bool_ops;
+	}
+	return true;
+}
+
 /*
  * Sub-string
  */
@@ -1319,3 +1448,332 @@ pgfn_substr_nolen(XPU_PGFUNCTION_ARGS)
 {
 	return pgfn_substring_nolen(kcxt, kexp, __result);
 }
+
+/*
+ * lower / upper
+ *
+ * pgfn_lower/pgfn_upper are the C-locale version that maps only ASCII
+ * characters, like asc_tolower() of PostgreSQL. The _unicode version is
+ * used for the libc locales on the UTF-8 database, using the simple case
+ * mapping below. Characters out of the table are not known to have no
+ * case, so these rows are evaluated by CPU fallback.
+ */
+typedef struct
+{
+	uint32_t	lo;
+	uint32_t	hi;
+	int32_t		to_lower;		/* delta to the lower case */
+	int32_t		to_upper;		/* delta to the upper case */
+	int32_t		pairs;			/* 1: even is upper, 2: odd is upper */
+} unicode_casemap_entry;
+
+STATIC_DATA const unicode_casemap_entry unicode_casemap_table[] = {
+	{0x000000, 0x000040,      0,      0, 0},
+	{0x000041, 0x00005a,     32,      0, 0},	/* A-Z */
+	{0x00005b, 0x000060,      0,      0, 0},
+	{0x000061, 0x00007a,      0,    -32, 0},	/* a-z */
+	{0x00007b, 0x0000b4,      0,      0, 0},
+	{0x0000b5, 0x0000b5,      0,  0x2e7, 0},	/* micro sign */
+	{0x0000b6, 0x0000bf,      0,      0, 0},
+	{0x0000c0, 0x0000d6,     32,      0, 0},
+	{0x0000d7, 0x0000d7,      0,      0, 0},
+	{0x0000d8, 0x0000de,     32,      0, 0},
+	{0x0000df, 0x0000df,      0,      0, 0},	/* sharp s */
+	{0x0000e0, 0x0000f6,      0,    -32, 0},
+	{0x0000f7, 0x0000f7,      0,      0, 0},
+	{0x0000f8, 0x0000fe,      0,    -32, 0},
+	{0x0000ff, 0x0000ff,      0,   0x79, 0},
+	{0x000100, 0x00012f,      0,      0, 1},
+	{0x000130, 0x000130,  -0xc7,      0, 0},	/* dotted I */
+	{0x000131, 0x000131,      0,  -0xe8, 0},	/* dotless i */
+	{0x000132, 0x000137,      0,      0, 1},
+	{0x000138, 0x000138,      0,      0, 0},
+	{0x000139, 0x000148,      0,      0, 2},
+	{0x000149, 0x000149,      0,      0, 0},
+	{0x00014a, 0x000177,      0,      0, 1},
+	{0x000178, 0x000178,  -0x79,      0, 0},
+	{0x000179, 0x00017e,      0,      0, 2},
+	{0x00017f, 0x00017f,      0, -0x12c, 0},	/* long s */
+	{0x0002b0, 0x000344,      0,      0, 0},
+	{0x000346, 0x00036f,      0,      0, 0},
+	{0x000386, 0x000386,   0x26,      0, 0},	/* Greek */
+	{0x000387, 0x000387,      0,      0, 0},
+	{0x000388, 0x00038a,   0x25,      0, 0},
+	{0x00038b, 0x00038b,      0,      0, 0},
+	{0x00038c, 0x00038c,   0x40,      0, 0},
+	{0x00038d, 0x00038d,      0,      0, 0},
+	{0x00038e, 0x00038f,   0x3f,      0, 0},
+	{0x000390, 0x000390,      0,      0, 0},
+	{0x000391, 0x0003a1,     32,      0, 0},
+	{0x0003a2, 0x0003a2,      0,      0, 0},
+	{0x0003a3, 0x0003ab,     32,      0, 0},
+	{0x0003ac, 0x0003ac,      0,  -0x26, 0},
+	{0x0003ad, 0x0003af,      0,  -0x25, 0},
+	{0x0003b0, 0x0003b0,      0,      0, 0},
+	{0x0003b1, 0x0003c1,      0,    -32, 0},
+	{0x0003c2, 0x0003c2,      0,  -0x1f, 0},	/* final sigma */
+	{0x0003c3, 0x0003cb,      0,    -32, 0},
+	{0x0003cc, 0x0003cc,      0,  -0x40, 0},
+	{0x0003cd, 0x0003ce,      0,  -0x3f, 0},
+	{0x000400, 0x00040f,   0x50,      0, 0},	/* Cyrillic */
+	{0x000410, 0x00042f,     32,      0, 0},
+	{0x000430, 0x00044f,      0,    -32, 0},
+	{0x000450, 0x00045f,      0,  -0x50, 0},
+	{0x000460, 0x000481,      0,      0, 1},
+	{0x000482, 0x000489,      0,      0, 0},
+	{0x00048a, 0x0004bf,      0,      0, 1},
+	{0x0004c0, 0x0004c0,   0x0f,      0, 0},
+	{0x0004c1, 0x0004ce,      0,      0, 2},
+	{0x0004cf, 0x0004cf,      0,  -0x0f, 0},
+	{0x0004d0, 0x00052f,      0,      0, 1},
+	{0x000590, 0x00109f,      0,      0, 0},	/* Hebrew ... Myanmar */
+	{0x001100, 0x0011ff,      0,      0, 0},	/* Hangul Jamo */
+	{0x002000, 0x0020ff,      0,      0, 0},	/* Punctuation, Symbols */
+	{0x002190, 0x0024b5,      0,      0, 0},
+	{0x0024ea, 0x002bff,      0,      0, 0},
+	{0x002e00, 0x002fff,      0,      0, 0},
+	{0x003000, 0x00a63f,      0,      0, 0},	/* CJK, Kana, Yi */
+	{0x00ac00, 0x00d7ff,      0,      0, 0},	/* Hangul Syllables */
+	{0x00e000, 0x00ff20,      0,      0, 0},	/* PUA, CJK compat */
+	{0x00ff21, 0x00ff3a,     32,      0, 0},	/* Fullwidth A-Z */
+	{0x00ff3b, 0x00ff40,      0,      0, 0},
+	{0x00ff41, 0x00ff5a,      0,    -32, 0},	/* Fullwidth a-z */
+	{0x00ff5b, 0x00ffff,      0,      0, 0},
+	{0x01f000, 0x01faff,      0,      0, 0},	/* Emoji */
+	{0x020000, 0x03ffff,      0,      0, 0},	/* CJK Ext-B... */
+};
+
+STATIC_FUNCTION(bool)
+__unicode_casemap(uint32_t code, bool to_upper, uint32_t *p_code)
+{
+	const unicode_casemap_entry *entry;
+	int		head = 0;
+	int		tail = lengthof(unicode_casemap_table) - 1;
+
+	while (head <= tail)
+	{
+		int		curr = (head + tail) / 2;
+
+		entry = &unicode_casemap_table[curr];
+		if (code < entry->lo)
+			tail = curr - 1;
+		else if (code > entry->hi)
+			head = curr + 1;
+		else
+		{
+			if (entry->pairs != 0)
+			{
+				bool	is_upper = ((code & 1) == (entry->pairs == 1 ? 0 : 1));
+
+				if (is_upper && !to_upper)
+					code = code + 1;
+				else if (!is_upper && to_upper)
+					code = code - 1;
+			}
+			else
+				code += (to_upper ? entry->to_upper : entry->to_lower);
+			*p_code = code;
+			return true;
+		}
+	}
+	return false;	/* unknown */
+}
+
+STATIC_FUNCTION(bool)
+__text_casemap_ascii(kern_context *kcxt,
+					 xpu_text_t *result,
+					 const xpu_text_t *str,
+					 bool to_upper)
+{
+	const char *s = str->value;
+	char	   *buf;
+	int			i, len = str->length;
+
+	for (i=0; i < len; i++)
+	{
+		if (to_upper ? (s[i] >= 'a' && s[i] <= 'z')
+					 : (s[i] >= 'A' && s[i] <= 'Z'))
+			break;
+	}
+	result->expr_ops = &xpu_text_ops;
+	if (i == len)
+	{
+		/* nothing to be changed */
+		result->value  = str->value;
+		result->length = str->length;
+		return true;
+	}
+	if ((char *)MAXALIGN(kcxt->vlpos) + len > kcxt->vlend)
+	{
+		STROM_CPU_FALLBACK(kcxt, "out of kcxt memory for lower/upper");
+		return false;
+	}
+	buf = (char *)kcxt_alloc(kcxt, len);
+	memcpy(buf, s, i);
+	for (; i < len; i++)
+	{
+		char	c = s[i];
+
+		if (to_upper && c >= 'a' && c <= 'z')
+			c -= ('a' - 'A');
+		else if (!to_upper && c >= 'A' && c <= 'Z')
+			c += ('a' - 'A');
+		buf[i] = c;
+	}
+	result->value  = buf;
+	result->length = len;
+	return true;
+}
+
+STATIC_FUNCTION(bool)
+__text_casemap_unicode(kern_context *kcxt,
+					   xpu_text_t *result,
+					   const xpu_text_t *str,
+					   bool to_upper)
+{
+	const unsigned char *s = (const unsigned char *)str->value;
+	const unsigned char *end = s + str->length;
+	char	   *buf;
+	char	   *pos;
+
+	/*
+	 * Simple case mapping of UTF-8 never expands the byte length of
+	 * the characters in the table.
+	 */
+	if ((char *)MAXALIGN(kcxt->vlpos) + str->length > kcxt->vlend)
+	{
+		STROM_CPU_FALLBACK(kcxt, "out of kcxt memory for lower/upper");
+		return false;
+	}
+	buf = pos = (char *)kcxt_alloc(kcxt, str->length);
+	while (s < end)
+	{
+		uint32_t	code;
+		int			w;
+
+		if (s[0] < 0x80)
+		{
+			code = s[0];
+			w = 1;
+		}
+		else if ((s[0] & 0xe0) == 0xc0 && s + 1 < end)
+		{
+			code = ((s[0] & 0x1f) << 6) | (s[1] & 0x3f);
+			w = 2;
+		}
+		else if ((s[0] & 0xf0) == 0xe0 && s + 2 < end)
+		{
+			code = (((s[0] & 0x0f) << 12) |
+					((s[1] & 0x3f) <<  6) |
+					((s[2] & 0x3f)));
+			w = 3;
+		}
+		else if ((s[0] & 0xf8) == 0xf0 && s + 3 < end)
+		{
+			code = (((s[0] & 0x07) << 18) |
+					((s[1] & 0x3f) << 12) |
+					((s[2] & 0x3f) <<  6) |
+					((s[3] & 0x3f)));
+			w = 4;
+		}
+		else
+			goto fallback;
+		if (!__unicode_casemap(code, to_upper, &code))
+			goto fallback;
+		if (code < 0x80)
+			*pos++ = code;
+		else if (code < 0x800)
+		{
+			*pos++ = 0xc0 | (code >> 6);
+			*pos++ = 0x80 | (code & 0x3f);
+		}
+		else if (code < 0x10000)
+		{
+			*pos++ = 0xe0 | (code >> 12);
+			*pos++ = 0x80 | ((code >> 6) & 0x3f);
+			*pos++ = 0x80 | (code & 0x3f);
+		}
+		else
+		{
+			*pos++ = 0xf0 | (code >> 18);
+			*pos++ = 0x80 | ((code >> 12) & 0x3f);
+			*pos++ = 0x80 | ((code >> 6) & 0x3f);
+			*pos++ = 0x80 | (code & 0x3f);
+		}
+		s += w;
+	}
+	result->expr_ops = &xpu_text_ops;
+	result->value  = buf;
+	result->length = (pos - buf);
+	return true;
+
+fallback:
+	STROM_CPU_FALLBACK(kcxt, "lower/upper of unsupported characters");
+	return false;
+}
+
+#define PG_TEXT_CASEMAP_TEMPLATE(NAME,HANDLER,TO_UPPER)					\
+	PUBLIC_FUNCTION(bool)												\
+	pgfn_##NAME(XPU_PGFUNCTION_ARGS)									\
+	{																	\
+		KEXP_PROCESS_ARGS1(text, text, str);							\
+																		\
+		if (XPU_DATUM_ISNULL(&str))										\
+		{																\
+			result->expr_ops = NULL;									\
+			return true;												\
+		}																\
+		if (!xpu_text_is_valid(kcxt, &str))								\
+			return false;	/* compressed or external */				\
+		return HANDLER(kcxt, result, &str, TO_UPPER);					\
+	}
+PG_TEXT_CASEMAP_TEMPLATE(lower, __text_casemap_ascii, false)
+PG_TEXT_CASEMAP_TEMPLATE(upper, __text_casemap_ascii, true)
+PG_TEXT_CASEMAP_TEMPLATE(lower_unicode, __text_casemap_unicode, false)
+PG_TEXT_CASEMAP_TEMPLATE(upper_unicode, __text_casemap_unicode, true)
+
+/*
+ * strpos / position
+ */
+PUBLIC_FUNCTION(bool)
+pgfn_strpos(XPU_PGFUNCTION_ARGS)
+{
+	const xpu_encode_info *encode = SESSION_ENCODE(kcxt->session);
+	KEXP_PROCESS_ARGS2(int4, text, str, text, sub);
+
+	if (XPU_DATUM_ISNULL(&str) || XPU_DATUM_ISNULL(&sub))
+	{
+		result->expr_ops = NULL;
+		return true;
+	}
+	if (!xpu_text_is_valid(kcxt, &str) ||
+		!xpu_text_is_valid(kcxt, &sub))
+		return false;	/* compressed or external */
+	if (!encode)
+	{
+		STROM_ELOG(kcxt, "No encoding info was supplied");
+		return false;
+	}
+	result->expr_ops = &xpu_int4_ops;
+	result->value = 0;
+	if (sub.length == 0)
+		result->value = 1;
+	else
+	{
+		const char *pos = str.value;
+		const char *end = str.value + str.length - sub.length;
+
+		/* walk on the character boundary, to avoid false matches */
+		for (int i=1; pos <= end; i++)
+		{
+			if (*pos == *sub.value &&
+				__memcmp(pos, sub.value, sub.length) == 0)
+			{
+				result->value = i;
+				break;
+			}
+			pos += (encode->enc_maxlen == 1 ? 1 : encode->enc_mblen(pos));
+		}
+	}
+	return true;
+}
@@ -34,14 +34,67 @@ typedef struct xpu_encode_info	xpu_encode_info;
 
 EXTERN_DATA xpu_encode_info		xpu_encode_catalog[];
 
+/*
+ * kern_regex_dfa - DFA transition table of regular expression or LIKE
+ * pattern, built by the host code (see codegen.c). All the fields are
+ * uint8_t to avoid alignment issues on the varlena constant.
+ */
+typedef struct {
+	uint8_t		nstates;		/* # of states; state-0 is the dead state */
+	uint8_t		nclasses;		/* # of byte-classes */
+	uint8_t		start;			/* initial state */
+	uint8_t		flags;			/* KERN_REGEX_DFA__* */
+	uint8_t		class_map[256];	/* byte -> byte-class */
+	/*
+	 * uint8_t	transitions[nstates * nclasses];
+	 * uint8_t	state_flags[nstates];
+	 */
+	uint8_t		data[1];
+} kern_regex_dfa;
+
+#define KERN_REGEX_DFA__NEGATE			0x01
+#define KERN_REGEX_DFA_STATE__ACCEPT	0x01
+#define KERN_REGEX_DFA_STATE__FINAL		0x02	/* never moves to others */
+#define KERN_REGEX_DFA_LENGTH(nstates,nclasses)		\
+	(offsetof(kern_regex_dfa, data) + (nstates) * ((nclasses) + 1))
+
+/*
+ * kern_like_needle - needle of LIKE '%literal%' with the bad-character
+ * shift table of Boyer-Moore-Horspool, built by the host code.
+ */
+typedef struct {
+	uint8_t		flags;			/* KERN_LIKE_NEEDLE__* */
+	uint8_t		shift[256];
+	char		needle[1];		/* variable length */
+} kern_like_needle;
+
+#define KERN_LIKE_NEEDLE__NEGATE		0x01
+
 /*
  * validation checkers
+ *
+ * Inline compressed datum (pglz or lz4) is decompressed on the vlbuf, then
+ * the datum is updated to the raw data. External (TOAST) datum is not
+ * accessible from the xPU, so the row falls back to the CPU.
  */
 INLINE_FUNCTION(bool)
 xpu_bpchar_is_valid(kern_context *kcxt, const xpu_bpchar_t *arg)
 {
 	if (arg->length < 0)
 	{
+		xpu_bpchar_t *__arg = (xpu_bpchar_t *)arg;
+		const char *data;
+		int			len;
+
+		data = pg_decompress_inline_datum(kcxt, arg->value, &len);
+		if (data)
+		{
+			while (len > 0 && data[len-1] == ' ')
+				len--;
+			__arg->value  = data;
+			__arg->length = len;
+			return true;
+		}
 		STROM_CPU_FALLBACK(kcxt, "bpchar datum is compressed or external");
 		return false;
 	}
@@ -53,6 +106,17 @@ xpu_text_is_valid(kern_context *kcxt, const xpu_text_t *arg)
 {
 	if (arg->length < 0)
 	{
+		xpu_text_t *__arg = (xpu_text_t *)arg;
+		const char *data;
+		int			len;
+
+		data = pg_decompress_inline_datum(kcxt, arg->value, &len);
+		if (data)
+		{
+			__arg->value  = data;
+			__arg->length = len;
+			return true;
+		}
 		STROM_CPU_FALLBACK(kcxt, "text datum is compressed or external");
 		return false;
 	}
@@ -64,6 +128,17 @@ xpu_bytea_is_valid(kern_context *kcxt, const xpu_bytea_t *arg)
 {
 	if (arg->length < 0)
 	{
+		xpu_bytea_t *__arg = (xpu_bytea_t *)arg;
+		const char *data;
+		int			len;
+
+		data = pg_decompress_inline_datum(kcxt, arg->value, &len);
+		if (data)
+		{
+			__arg->value  = data;
+			__arg->length = len;
+			return true;
+		}
 		STROM_CPU_FALLBACK(kcxt, "bytea datum is compressed or external");
 		return false;
 	}
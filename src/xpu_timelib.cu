@@ -3949,3 +3949,610 @@ pgfn_extract_interval(XPU_PGFUNCTION_ARGS)
 	}
 	return true;
 }
+
+/*
+ * date_trunc
+ */
+STATIC_FUNCTION(int)
+isoweek2j(int year, int week)
+{
+	int		day0, day4;
+
+	/* fourth day of current year */
+	day4 = date2j(year, 1, 4);
+	/* day0 == offset to first day of week (Monday) */
+	day0 = j2day(day4 - 1);
+
+	return ((week - 1) * 7) + (day4 - day0);
+}
+
+STATIC_FUNCTION(bool)
+__pg_timestamp_trunc_common(kern_context *kcxt,
+							Timestamp *p_result,
+							const xpu_text_t *key,
+							Timestamp ts,
+							const pg_tz *tz_info)
+{
+	struct pg_tm tm;
+	fsec_t		fsec;
+	int			type, value;
+	int			tz;
+	bool		redotz = false;
+
+	if (!xpu_text_is_valid(kcxt, key) ||
+		!extract_decode_unit(kcxt, key, &type, &value))
+		return false;
+	if (type != UNITS)
+	{
+		STROM_ELOG(kcxt, "not a recognized unit for date_trunc");
+		return false;
+	}
+	if (TIMESTAMP_NOT_FINITE(ts))
+	{
+		*p_result = ts;
+		return true;
+	}
+	if (!timestamp2tm(ts, &tm, &fsec, tz_info))
+	{
+		STROM_ELOG(kcxt, "timestamp out of range");
+		return false;
+	}
+	tz = -tm.tm_gmtoff;
+
+	switch (value)
+	{
+		case DTK_WEEK:
+			{
+				int		woy = date2isoweek(tm.tm_year, tm.tm_mon, tm.tm_mday);
+
+				/*
+				 * If it is week 52/53 and the month is January, then the
+				 * week must belong to the previous year. Also, some
+				 * December dates belong to the next year.
+				 */
+				if (woy >= 52 && tm.tm_mon == 1)
+					--tm.tm_year;
+				if (woy <= 1 && tm.tm_mon == MONTHS_PER_YEAR)
+					++tm.tm_year;
+				j2date(isoweek2j(tm.tm_year, woy),
+					   &tm.tm_year, &tm.tm_mon, &tm.tm_mday);
+				tm.tm_hour = 0;
+				tm.tm_min = 0;
+				tm.tm_sec = 0;
+				fsec = 0;
+				redotz = true;
+			}
+			break;
+		case DTK_MILLENNIUM:
+			/* truncating to the millennium? what is this supposed to mean? */
+			if (tm.tm_year > 0)
+				tm.tm_year = ((tm.tm_year + 999) / 1000) * 1000 - 999;
+			else
+				tm.tm_year = -((999 - (tm.tm_year - 1)) / 1000) * 1000 + 1;
+			/* FALLTHROUGH */
+		case DTK_CENTURY:
+			/* truncating to the century? as above: -100, 1, 101... */
+			if (value != DTK_MILLENNIUM)
+			{
+				if (tm.tm_year > 0)
+					tm.tm_year = ((tm.tm_year + 99) / 100) * 100 - 99;
+				else
+					tm.tm_year = -((99 - (tm.tm_year - 1)) / 100) * 100 + 1;
+			}
+			/* FALLTHROUGH */
+		case DTK_DECADE:
+			/*
+			 * truncating to the decade? first year of the decade. must
+			 * not be applied if year was truncated before!
+			 */
+			if (value != DTK_MILLENNIUM && value != DTK_CENTURY)
+			{
+				if (tm.tm_year > 0)
+					tm.tm_year = (tm.tm_year / 10) * 10;
+				else
+					tm.tm_year = -((8 - (tm.tm_year - 1)) / 10) * 10;
+			}
+			/* FALLTHROUGH */
+		case DTK_YEAR:
+			tm.tm_mon = 1;
+			/* FALLTHROUGH */
+		case DTK_QUARTER:
+			tm.tm_mon = (3 * ((tm.tm_mon - 1) / 3)) + 1;
+			/* FALLTHROUGH */
+		case DTK_MONTH:
+			tm.tm_mday = 1;
+			/* FALLTHROUGH */
+		case DTK_DAY:
+			tm.tm_hour = 0;
+			redotz = true;		/* for all cases >= DAY */
+			/* FALLTHROUGH */
+		case DTK_HOUR:
+			tm.tm_min = 0;
+			/* FALLTHROUGH */
+		case DTK_MINUTE:
+			tm.tm_sec = 0;
+			/* FALLTHROUGH */
+		case DTK_SECOND:
+			fsec = 0;
+			break;
+		case DTK_MILLISEC:
+			fsec = (fsec / 1000) * 1000;
+			break;
+		case DTK_MICROSEC:
+			break;
+		default:
+			STROM_ELOG(kcxt, "not a supported unit for date_trunc");
+			return false;
+	}
+	if (redotz && tz_info)
+		tz = DetermineTimeZoneOffset(&tm, tz_info);
+	if (!tm2timestamp(p_result, &tm, fsec, tz_info ? &tz : NULL))
+	{
+		STROM_ELOG(kcxt, "timestamp out of range");
+		return false;
+	}
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_timestamp_trunc(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS2(timestamp, text, key, timestamp, tval);
+
+	if (XPU_DATUM_ISNULL(&key) || XPU_DATUM_ISNULL(&tval))
+		result->expr_ops = NULL;
+	else if (!__pg_timestamp_trunc_common(kcxt, &result->value,
+										  &key, tval.value, NULL))
+	{
+		assert(kcxt->errcode != 0);
+		return false;
+	}
+	else
+		result->expr_ops = &xpu_timestamp_ops;
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_timestamptz_trunc(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS2(timestamptz, text, key, timestamptz, tval);
+
+	if (XPU_DATUM_ISNULL(&key) || XPU_DATUM_ISNULL(&tval))
+		result->expr_ops = NULL;
+	else if (!__pg_timestamp_trunc_common(kcxt, &result->value,
+										  &key, tval.value,
+										  SESSION_TIMEZONE(kcxt->session)))
+	{
+		assert(kcxt->errcode != 0);
+		return false;
+	}
+	else
+		result->expr_ops = &xpu_timestamptz_ops;
+	return true;
+}
+
+/*
+ * __pg_lookup_timezone
+ *
+ * Only the timezone rules of the current session are shipped to the device,
+ * so the explicit zone name is resolved if it is UTC or the session timezone.
+ * Elsewhere, the row is evaluated by CPU fallback.
+ */
+INLINE_FUNCTION(bool)
+__tzname_equal(const char *s1, const char *s2, int len)
+{
+	for (int i=0; i < len; i++)
+	{
+		char	c1 = s1[i];
+		char	c2 = s2[i];
+
+		if (c1 >= 'A' && c1 <= 'Z')
+			c1 += ('a' - 'A');
+		if (c2 >= 'A' && c2 <= 'Z')
+			c2 += ('a' - 'A');
+		if (c1 != c2)
+			return false;
+	}
+	return true;
+}
+
+STATIC_FUNCTION(bool)
+__pg_lookup_timezone(kern_context *kcxt,
+					 const xpu_text_t *zone,
+					 const pg_tz **p_tz_info)
+{
+	const pg_tz *tz_info = SESSION_TIMEZONE(kcxt->session);
+	const char *name;
+	int			len;
+
+	if (!xpu_text_is_valid(kcxt, zone))
+		return false;
+	name = zone->value;
+	len = zone->length;
+	if ((len == 3 && (__tzname_equal(name, "UTC", 3) ||
+					  __tzname_equal(name, "GMT", 3))) ||
+		(len == 7 && __tzname_equal(name, "Etc/UTC", 7)))
+	{
+		*p_tz_info = NULL;
+		return true;
+	}
+	if (tz_info &&
+		len < sizeof(tz_info->TZname) &&
+		tz_info->TZname[len] == '\0' &&
+		__tzname_equal(name, tz_info->TZname, len))
+	{
+		*p_tz_info = tz_info;
+		return true;
+	}
+	STROM_CPU_FALLBACK(kcxt, "time zone is not the session timezone");
+	return false;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_timestamptz_trunc_zone(XPU_PGFUNCTION_ARGS)
+{
+	const pg_tz *tz_info;
+	KEXP_PROCESS_ARGS3(timestamptz,
+					   text, key,
+					   timestamptz, tval,
+					   text, zone);
+
+	if (XPU_DATUM_ISNULL(&key) ||
+		XPU_DATUM_ISNULL(&tval) ||
+		XPU_DATUM_ISNULL(&zone))
+		result->expr_ops = NULL;
+	else if (!__pg_lookup_timezone(kcxt, &zone, &tz_info) ||
+			 !__pg_timestamp_trunc_common(kcxt, &result->value,
+										  &key, tval.value, tz_info))
+	{
+		assert(kcxt->errcode != 0);
+		return false;
+	}
+	else
+		result->expr_ops = &xpu_timestamptz_ops;
+	return true;
+}
+
+/*
+ * date_bin / time_bucket
+ */
+INLINE_FUNCTION(bool)
+__pg_sub_s64_overflow(int64_t a, int64_t b, int64_t *p_result)
+{
+	int64_t		r = (int64_t)((uint64_t)a - (uint64_t)b);
+
+	if (((a ^ b) & (a ^ r)) < 0)
+		return true;
+	*p_result = r;
+	return false;
+}
+
+STATIC_FUNCTION(bool)
+__pg_interval_to_stride(kern_context *kcxt,
+						int64_t *p_stride,
+						const Interval *iv)
+{
+	int64_t		stride;
+
+	if (iv->day >  (LLONG_MAX / USECS_PER_DAY) - 1 ||
+		iv->day < -(LLONG_MAX / USECS_PER_DAY) + 1)
+	{
+		STROM_ELOG(kcxt, "interval out of range");
+		return false;
+	}
+	stride = (int64_t)iv->day * USECS_PER_DAY;
+	if ((iv->time > 0 && stride > LLONG_MAX - iv->time) ||
+		(iv->time < 0 && stride < LLONG_MIN - iv->time))
+	{
+		STROM_ELOG(kcxt, "interval out of range");
+		return false;
+	}
+	stride += iv->time;
+	if (stride <= 0)
+	{
+		STROM_ELOG(kcxt, "stride must be greater than zero");
+		return false;
+	}
+	*p_stride = stride;
+	return true;
+}
+
+STATIC_FUNCTION(bool)
+__pg_timestamp_bin_common(kern_context *kcxt,
+						  Timestamp *p_result,
+						  const Interval *stride,
+						  Timestamp ts,
+						  Timestamp origin)
+{
+	int64_t		stride_usecs;
+	int64_t		tm_diff;
+	int64_t		tm_modulo;
+	Timestamp	result;
+
+	if (TIMESTAMP_NOT_FINITE(ts))
+	{
+		*p_result = ts;
+		return true;
+	}
+	if (TIMESTAMP_NOT_FINITE(origin))
+	{
+		STROM_ELOG(kcxt, "origin out of range");
+		return false;
+	}
+	if (stride->month != 0)
+	{
+		STROM_ELOG(kcxt, "timestamps cannot be binned into intervals containing months or years");
+		return false;
+	}
+	if (!__pg_interval_to_stride(kcxt, &stride_usecs, stride))
+		return false;
+	if (__pg_sub_s64_overflow(ts, origin, &tm_diff))
+	{
+		STROM_ELOG(kcxt, "interval out of range");
+		return false;
+	}
+	/* these calculations cannot overflow */
+	tm_modulo = tm_diff % stride_usecs;
+	result = origin + (tm_diff - tm_modulo);
+	/* round towards -infinity, not 0, when tm_diff is negative */
+	if (tm_diff < 0 && tm_modulo != 0)
+	{
+		if (__pg_sub_s64_overflow(result, stride_usecs, &result))
+		{
+			STROM_ELOG(kcxt, "timestamp out of range");
+			return false;
+		}
+	}
+	if (!IS_VALID_TIMESTAMP(result))
+	{
+		STROM_ELOG(kcxt, "timestamp out of range");
+		return false;
+	}
+	*p_result = result;
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_timestamp_bin(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS3(timestamp,
+					   interval, stride,
+					   timestamp, tval,
+					   timestamp, origin);
+
+	if (XPU_DATUM_ISNULL(&stride) ||
+		XPU_DATUM_ISNULL(&tval) ||
+		XPU_DATUM_ISNULL(&origin))
+		result->expr_ops = NULL;
+	else if (!__pg_timestamp_bin_common(kcxt, &result->value,
+										&stride.value,
+										tval.value,
+										origin.value))
+	{
+		assert(kcxt->errcode != 0);
+		return false;
+	}
+	else
+		result->expr_ops = &xpu_timestamp_ops;
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_timestamptz_bin(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS3(timestamptz,
+					   interval, stride,
+					   timestamptz, tval,
+					   timestamptz, origin);
+
+	if (XPU_DATUM_ISNULL(&stride) ||
+		XPU_DATUM_ISNULL(&tval) ||
+		XPU_DATUM_ISNULL(&origin))
+		result->expr_ops = NULL;
+	else if (!__pg_timestamp_bin_common(kcxt, &result->value,
+										&stride.value,
+										tval.value,
+										origin.value))
+	{
+		assert(kcxt->errcode != 0);
+		return false;
+	}
+	else
+		result->expr_ops = &xpu_timestamptz_ops;
+	return true;
+}
+
+/*
+ * time_bucket of TimescaleDB
+ *
+ * The default origin is 2000-01-03 (Monday) for the stride without months,
+ * or 2000-01-01 for the stride of months. Timestamptz is bucketed in UTC.
+ */
+#define TIME_BUCKET_DEFAULT_ORIGIN		(2 * USECS_PER_DAY)	/* 2000-01-03 */
+
+STATIC_FUNCTION(bool)
+__pg_time_bucket_common(kern_context *kcxt,
+						Timestamp *p_result,
+						const Interval *stride,
+						Timestamp ts,
+						Timestamp origin,
+						bool has_origin)
+{
+	int64_t		period;
+	int64_t		offset;
+	Timestamp	result;
+
+	if (TIMESTAMP_NOT_FINITE(ts))
+	{
+		*p_result = ts;
+		return true;
+	}
+	if (stride->month != 0)
+	{
+		struct pg_tm tm;
+		fsec_t		fsec;
+		int32_t		months;
+		int32_t		__offset;
+		int32_t		__result;
+
+		if (stride->day != 0 || stride->time != 0)
+		{
+			STROM_ELOG(kcxt, "month intervals cannot have day or time component");
+			return false;
+		}
+		if (stride->month < 0)
+		{
+			STROM_ELOG(kcxt, "period must be greater than 0");
+			return false;
+		}
+		if (!timestamp2tm(ts, &tm, &fsec, NULL))
+		{
+			STROM_ELOG(kcxt, "timestamp out of range");
+			return false;
+		}
+		months = tm.tm_year * MONTHS_PER_YEAR + tm.tm_mon - 1;
+		if (!has_origin)
+			__offset = 2000 * MONTHS_PER_YEAR;
+		else if (!timestamp2tm(origin, &tm, &fsec, NULL))
+		{
+			STROM_ELOG(kcxt, "origin out of range");
+			return false;
+		}
+		else
+			__offset = tm.tm_year * MONTHS_PER_YEAR + tm.tm_mon - 1;
+		__offset %= stride->month;
+		months -= __offset;
+		__result = (months / stride->month) * stride->month;
+		if (months < 0 && months % stride->month != 0)
+			__result -= stride->month;
+		__result += __offset;
+
+		memset(&tm, 0, sizeof(struct pg_tm));
+		tm.tm_year = __result / MONTHS_PER_YEAR;
+		tm.tm_mon  = __result % MONTHS_PER_YEAR + 1;
+		tm.tm_mday = 1;
+		if (!tm2timestamp(p_result, &tm, 0, NULL))
+		{
+			STROM_ELOG(kcxt, "timestamp out of range");
+			return false;
+		}
+		return true;
+	}
+	if (!__pg_interval_to_stride(kcxt, &period, stride))
+		return false;
+	if (!has_origin)
+		origin = TIME_BUCKET_DEFAULT_ORIGIN;
+	else if (TIMESTAMP_NOT_FINITE(origin))
+	{
+		STROM_ELOG(kcxt, "origin out of range");
+		return false;
+	}
+	offset = origin % period;
+	if ((offset > 0 && ts < DT_NOBEGIN + offset) ||
+		(offset < 0 && ts > DT_NOEND + offset))
+	{
+		STROM_ELOG(kcxt, "timestamp out of range");
+		return false;
+	}
+	ts -= offset;
+	result = (ts / period) * period;
+	if (ts < 0 && ts % period != 0)
+	{
+		if (result < DT_NOBEGIN + period)
+		{
+			STROM_ELOG(kcxt, "timestamp out of range");
+			return false;
+		}
+		result -= period;
+	}
+	*p_result = result + offset;
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_time_bucket_timestamp(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS2(timestamp, interval, stride, timestamp, tval);
+
+	if (XPU_DATUM_ISNULL(&stride) || XPU_DATUM_ISNULL(&tval))
+		result->expr_ops = NULL;
+	else if (!__pg_time_bucket_common(kcxt, &result->value,
+									  &stride.value,
+									  tval.value, 0, false))
+	{
+		assert(kcxt->errcode != 0);
+		return false;
+	}
+	else
+		result->expr_ops = &xpu_timestamp_ops;
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_time_bucket_timestamptz(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS2(timestamptz, interval, stride, timestamptz, tval);
+
+	if (XPU_DATUM_ISNULL(&stride) || XPU_DATUM_ISNULL(&tval))
+		result->expr_ops = NULL;
+	else if (!__pg_time_bucket_common(kcxt, &result->value,
+									  &stride.value,
+									  tval.value, 0, false))
+	{
+		assert(kcxt->errcode != 0);
+		return false;
+	}
+	else
+		result->expr_ops = &xpu_timestamptz_ops;
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_time_bucket_timestamp_origin(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS3(timestamp,
+					   interval, stride,
+					   timestamp, tval,
+					   timestamp, origin);
+
+	if (XPU_DATUM_ISNULL(&stride) ||
+		XPU_DATUM_ISNULL(&tval) ||
+		XPU_DATUM_ISNULL(&origin))
+		result->expr_ops = NULL;
+	else if (!__pg_time_bucket_common(kcxt, &result->value,
+									  &stride.value,
+									  tval.value,
+									  origin.value, true))
+	{
+		assert(kcxt->errcode != 0);
+		return false;
+	}
+	else
+		result->expr_ops = &xpu_timestamp_ops;
+	return true;
+}
+
+PUBLIC_FUNCTION(bool)
+pgfn_time_bucket_timestamptz_origin(XPU_PGFUNCTION_ARGS)
+{
+	KEXP_PROCESS_ARGS3(timestamptz,
+					   interval, stride,
+					   timestamptz, tval,
+					   timestamptz, origin);
+
+	if (XPU_DATUM_ISNULL(&stride) ||
+		XPU_DATUM_ISNULL(&tval) ||
+		XPU_DATUM_ISNULL(&origin))
+		result->expr_ops = NULL;
+	else if (!__pg_time_bucket_common(kcxt, &result->value,
+									  &stride.value,
+									  tval.value,
+									  origin.value, true))
+	{
+		assert(kcxt->errcode != 0);
+		return false;
+	}
+	else
+		result->expr_ops = &xpu_timestamptz_ops;
+	return true;
+}
@@ -0,0 +1,74 @@
+--
+-- arrow_bloom - test for bloom filters embedded by pg2arrow --bloom
+--
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_arrow_bloom_temp CASCADE;
+CREATE SCHEMA regtest_arrow_bloom_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_arrow_bloom_temp,public;
+\getenv arrow_test_data_dir_path ARROW_TEST_DATA_DIR
+\set test_arrow_bloom_files :arrow_test_data_dir_path '/test_arrow_bloom_0.arrow,' :arrow_test_data_dir_path '/test_arrow_bloom_1.arrow,' :arrow_test_data_dir_path '/test_arrow_bloom_2.arrow,' :arrow_test_data_dir_path '/test_arrow_bloom_3.arrow'
+
+-- Stats-Hint line of EXPLAIN ANALYZE
+CREATE FUNCTION explain_stats_hint(query text)
+RETURNS SETOF text AS
+$$
+DECLARE
+  line text;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, SUMMARY OFF) ' || query
+  LOOP
+    IF line ~ 'Stats-Hint:' THEN
+      RETURN NEXT trim(line);
+    END IF;
+  END LOOP;
+END;
+$$ LANGUAGE 'plpgsql';
+
+-- 4 files with a record-batch for each; no min/max statistics
+CREATE TABLE tt_1 AS
+  SELECT i id,
+         (i * 7919) % 100003 k,
+         'key-' || ((i * 7919) % 100003) s
+    FROM generate_series(1,20000) i;
+\! $PG2ARROW_CMD -c 'SELECT * FROM regtest_arrow_bloom_temp.tt_1 WHERE id % 4 = 0' --bloom=k,s -o $ARROW_TEST_DATA_DIR/test_arrow_bloom_0.arrow
+\! $PG2ARROW_CMD -c 'SELECT * FROM regtest_arrow_bloom_temp.tt_1 WHERE id % 4 = 1' --bloom=k,s -o $ARROW_TEST_DATA_DIR/test_arrow_bloom_1.arrow
+\! $PG2ARROW_CMD -c 'SELECT * FROM regtest_arrow_bloom_temp.tt_1 WHERE id % 4 = 2' --bloom=k,s -o $ARROW_TEST_DATA_DIR/test_arrow_bloom_2.arrow
+\! $PG2ARROW_CMD -c 'SELECT * FROM regtest_arrow_bloom_temp.tt_1 WHERE id % 4 = 3' --bloom=k,s -o $ARROW_TEST_DATA_DIR/test_arrow_bloom_3.arrow
+CREATE FOREIGN TABLE ft_1 (
+  id    int,
+  k     int,
+  s     text
+) SERVER arrow_fdw
+  OPTIONS (files :'test_arrow_bloom_files');
+
+SET pg_strom.enabled = off;
+SET max_parallel_workers_per_gather = 0;
+SELECT count(*) FROM ft_1;
+SELECT * FROM tt_1 EXCEPT SELECT * FROM ft_1;
+
+-- equality lookup
+SELECT * FROM explain_stats_hint('SELECT * FROM ft_1 WHERE k = 71755');
+SELECT * FROM ft_1 WHERE k = 71755;
+SELECT * FROM explain_stats_hint('SELECT * FROM ft_1 WHERE s = ''key-34620''');
+SELECT * FROM ft_1 WHERE s = 'key-34620';
+
+-- IN-list lookup
+SELECT * FROM explain_stats_hint('SELECT * FROM ft_1 WHERE k IN (71755, 79708)');
+SELECT * FROM ft_1 WHERE k IN (71755, 79708) ORDER BY id;
+
+-- no record-batches contain the key
+SELECT * FROM explain_stats_hint('SELECT * FROM ft_1 WHERE k = 3');
+SELECT count(*) FROM ft_1 WHERE k = 3;
+
+-- disabled by arrow_fdw.stats_hint_enabled
+SET arrow_fdw.stats_hint_enabled = off;
+SELECT * FROM explain_stats_hint('SELECT * FROM ft_1 WHERE k = 71755');
+SELECT * FROM ft_1 WHERE k = 71755;
+RESET arrow_fdw.stats_hint_enabled;
+
+-- cleanup temporary resource
+SET client_min_messages = error;
+DROP SCHEMA regtest_arrow_bloom_temp CASCADE;
@@ -0,0 +1,61 @@
+--
+-- arrow_compress - test for the compressed record-batches
+--
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_arrow_compress_temp CASCADE;
+CREATE SCHEMA regtest_arrow_compress_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_arrow_compress_temp,public;
+\set test_arrow_plain_path `echo -n $ARROW_TEST_DATA_DIR/test_arrow_compress_plain.arrow`
+\set test_arrow_lz4_path   `echo -n $ARROW_TEST_DATA_DIR/test_arrow_compress_lz4.arrow`
+\set test_arrow_zstd_path  `echo -n $ARROW_TEST_DATA_DIR/test_arrow_compress_zstd.arrow`
+
+-- 'v' and 't' have NULLs only in the first record-batch,
+-- 'x' has NULLs in every record-batch, 'id' and 'a' have no NULLs.
+CREATE TABLE tt_1 AS
+  SELECT i id,
+         CASE WHEN i <= 1000 AND i % 3 = 0 THEN NULL ELSE i % 5000 END::int8 v,
+         CASE WHEN i % 11 = 0 THEN NULL ELSE i::float8 / 8.0 END x,
+         CASE WHEN i <= 1000 AND i % 7 = 0 THEN NULL ELSE 'row-' || (i % 200) END t,
+         ARRAY[i, i % 10, i % 100] a
+    FROM generate_series(1,200000) i;
+\! $PG2ARROW_CMD -c 'SELECT * FROM regtest_arrow_compress_temp.tt_1 ORDER BY id' -s 1MB -o $ARROW_TEST_DATA_DIR/test_arrow_compress_plain.arrow
+\! $PG2ARROW_CMD -c 'SELECT * FROM regtest_arrow_compress_temp.tt_1 ORDER BY id' -s 1MB --compress=lz4 -o $ARROW_TEST_DATA_DIR/test_arrow_compress_lz4.arrow
+\! $PG2ARROW_CMD -c 'SELECT * FROM regtest_arrow_compress_temp.tt_1 ORDER BY id' -s 1MB --compress=zstd:3 -o $ARROW_TEST_DATA_DIR/test_arrow_compress_zstd.arrow
+IMPORT FOREIGN SCHEMA ft_lz4
+  FROM SERVER arrow_fdw
+  INTO regtest_arrow_compress_temp
+OPTIONS (file :'test_arrow_lz4_path');
+IMPORT FOREIGN SCHEMA ft_zstd
+  FROM SERVER arrow_fdw
+  INTO regtest_arrow_compress_temp
+OPTIONS (file :'test_arrow_zstd_path');
+
+SELECT (SELECT size FROM pg_stat_file(:'test_arrow_lz4_path')) <
+       (SELECT size FROM pg_stat_file(:'test_arrow_plain_path')) AS lz4_compressed,
+       (SELECT size FROM pg_stat_file(:'test_arrow_zstd_path')) <
+       (SELECT size FROM pg_stat_file(:'test_arrow_plain_path')) AS zstd_compressed;
+
+-- decompression by CPU
+SET pg_strom.enabled = off;
+SELECT count(*) FROM ft_lz4;
+(SELECT * FROM tt_1 EXCEPT SELECT * FROM ft_lz4);
+(SELECT * FROM ft_lz4 EXCEPT SELECT * FROM tt_1);
+SELECT count(*) FROM ft_zstd;
+(SELECT * FROM tt_1 EXCEPT SELECT * FROM ft_zstd);
+(SELECT * FROM ft_zstd EXCEPT SELECT * FROM tt_1);
+
+-- decompression by GPU
+SET pg_strom.enabled = on;
+SELECT count(*) FROM ft_lz4;
+(SELECT * FROM tt_1 EXCEPT SELECT * FROM ft_lz4);
+(SELECT * FROM ft_lz4 EXCEPT SELECT * FROM tt_1);
+SELECT count(*) FROM ft_zstd;
+(SELECT * FROM tt_1 EXCEPT SELECT * FROM ft_zstd);
+(SELECT * FROM ft_zstd EXCEPT SELECT * FROM tt_1);
+
+-- cleanup temporary resource
+SET client_min_messages = error;
+DROP SCHEMA regtest_arrow_compress_temp CASCADE;
@@ -0,0 +1,84 @@
+--
+-- arrow_export - test for pgstrom.arrow_export()
+--
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_arrow_export_temp CASCADE;
+CREATE SCHEMA regtest_arrow_export_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_arrow_export_temp,public;
+\! rm -f $ARROW_TEST_DATA_DIR/test_arrow_export_*.arrow
+\set test_arrow_export_1_path `echo -n $ARROW_TEST_DATA_DIR/test_arrow_export_1.arrow`
+\set test_arrow_export_2_path `echo -n $ARROW_TEST_DATA_DIR/test_arrow_export_2.arrow`
+\set test_arrow_export_3_path `echo -n $ARROW_TEST_DATA_DIR/test_arrow_export_3.arrow`
+
+-- error message of arrow_export, without the file name
+CREATE FUNCTION arrow_export_error(query text, filename text)
+RETURNS text AS
+$$
+BEGIN
+  PERFORM pgstrom.arrow_export(query, filename);
+  RETURN 'no error';
+EXCEPTION WHEN OTHERS THEN
+  RETURN replace(SQLERRM, filename, 'FILENAME');
+END;
+$$ LANGUAGE 'plpgsql';
+
+CREATE TABLE tt_1 AS
+  SELECT i id,
+         i::float8 / 7 x,
+         CASE WHEN i % 11 = 0 THEN NULL ELSE md5(i::text) END t,
+         '2020-01-01'::date + i d
+    FROM generate_series(1,5000) i;
+
+-- CPU fallback; rows are written one by one
+SET pg_strom.enabled = off;
+SELECT pgstrom.arrow_export('SELECT * FROM regtest_arrow_export_temp.tt_1 WHERE id % 2 = 0',
+                             :'test_arrow_export_1_path');
+IMPORT FOREIGN SCHEMA ft_1
+  FROM SERVER arrow_fdw
+  INTO regtest_arrow_export_temp
+OPTIONS (file :'test_arrow_export_1_path');
+SELECT count(*) FROM ft_1;
+SELECT * FROM tt_1 WHERE id % 2 = 0 EXCEPT SELECT * FROM ft_1;
+SELECT * FROM ft_1 EXCEPT SELECT * FROM tt_1 WHERE id % 2 = 0;
+
+-- GPU projection results; column vectors are written as is
+SET pg_strom.enabled = on;
+SELECT pgstrom.arrow_export('SELECT id, x * 2 AS x2, t, d FROM regtest_arrow_export_temp.tt_1 WHERE id > 1000',
+                             :'test_arrow_export_2_path');
+IMPORT FOREIGN SCHEMA ft_2
+  FROM SERVER arrow_fdw
+  INTO regtest_arrow_export_temp
+OPTIONS (file :'test_arrow_export_2_path');
+SET pg_strom.enabled = off;
+SELECT id, x * 2 AS x2, t, d FROM tt_1 WHERE id > 1000 EXCEPT SELECT * FROM ft_2;
+SELECT * FROM ft_2 EXCEPT SELECT id, x * 2 AS x2, t, d FROM tt_1 WHERE id > 1000;
+
+-- ROLLBACK reverts the file to empty, then it can be exported again
+BEGIN;
+SELECT pgstrom.arrow_export('SELECT * FROM regtest_arrow_export_temp.tt_1',
+                             :'test_arrow_export_3_path');
+ROLLBACK;
+SELECT size FROM pg_stat_file(:'test_arrow_export_3_path');
+SELECT pgstrom.arrow_export('SELECT * FROM regtest_arrow_export_temp.tt_1 WHERE id <= 10',
+                             :'test_arrow_export_3_path');
+IMPORT FOREIGN SCHEMA ft_3
+  FROM SERVER arrow_fdw
+  INTO regtest_arrow_export_temp
+OPTIONS (file :'test_arrow_export_3_path');
+SELECT * FROM tt_1 WHERE id <= 10 EXCEPT SELECT * FROM ft_3;
+
+-- error cases
+SELECT arrow_export_error('SELECT * FROM regtest_arrow_export_temp.tt_1',
+                          :'test_arrow_export_1_path');
+SELECT arrow_export_error('SELECT 1', 'test_arrow_export_4.arrow');
+SELECT arrow_export_error('DELETE FROM regtest_arrow_export_temp.tt_1',
+                          :'test_arrow_export_3_path' || '.bad');
+SELECT arrow_export_error('SELECT 1; SELECT 2',
+                          :'test_arrow_export_3_path' || '.bad');
+
+-- cleanup temporary resource
+SET client_min_messages = error;
+DROP SCHEMA regtest_arrow_export_temp CASCADE;
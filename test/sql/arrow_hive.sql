@@ -0,0 +1,73 @@
+--
+-- arrow_hive - test for Hive-style partition directories
+--
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_arrow_hive_temp CASCADE;
+CREATE SCHEMA regtest_arrow_hive_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_arrow_hive_temp,public;
+\set test_arrow_hive_dir `echo -n $ARROW_TEST_DATA_DIR/test_arrow_hive`
+
+-- files listed in EXPLAIN
+CREATE FUNCTION explain_files(query text)
+RETURNS SETOF text AS
+$$
+DECLARE
+  line text;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN (COSTS OFF) ' || query
+  LOOP
+    IF line ~ '^\s*file\d+: ' THEN
+      RETURN NEXT regexp_replace(line, '^\s*file\d+: (\S+) .*$', '\1');
+    END IF;
+  END LOOP;
+END;
+$$ LANGUAGE 'plpgsql';
+
+CREATE TABLE tt_1 AS
+  SELECT CASE WHEN i <= 100 THEN 2023
+              WHEN i <= 200 THEN 2024
+              ELSE NULL END AS year,
+         i id,
+         md5(i::text) v
+    FROM generate_series(1,250) i;
+\! rm -rf $ARROW_TEST_DATA_DIR/test_arrow_hive
+\! mkdir -p $ARROW_TEST_DATA_DIR/test_arrow_hive/year=2023 $ARROW_TEST_DATA_DIR/test_arrow_hive/year=2024 $ARROW_TEST_DATA_DIR/test_arrow_hive/year=__HIVE_DEFAULT_PARTITION__
+\! $PG2ARROW_CMD -c 'SELECT * FROM regtest_arrow_hive_temp.tt_1 WHERE year = 2023' -o $ARROW_TEST_DATA_DIR/test_arrow_hive/year=2023/hive_2023.arrow
+\! $PG2ARROW_CMD -c 'SELECT * FROM regtest_arrow_hive_temp.tt_1 WHERE year = 2024' -o $ARROW_TEST_DATA_DIR/test_arrow_hive/year=2024/hive_2024.arrow
+\! $PG2ARROW_CMD -c 'SELECT * FROM regtest_arrow_hive_temp.tt_1 WHERE year IS NULL' -o $ARROW_TEST_DATA_DIR/test_arrow_hive/year=__HIVE_DEFAULT_PARTITION__/hive_null.arrow
+CREATE FOREIGN TABLE ft_1 (
+  year  int,
+  id    int,
+  v     text
+) SERVER arrow_fdw
+  OPTIONS (dir :'test_arrow_hive_dir');
+
+SET pg_strom.enabled = off;
+SELECT * FROM explain_files('SELECT * FROM ft_1') ORDER BY 1;
+SELECT * FROM tt_1 EXCEPT SELECT * FROM ft_1;
+SELECT * FROM ft_1 EXCEPT SELECT * FROM tt_1;
+
+-- equality on the partition key
+SELECT * FROM explain_files('SELECT * FROM ft_1 WHERE year = 2024') ORDER BY 1;
+SELECT count(*) FROM ft_1 WHERE year = 2024;
+
+-- __HIVE_DEFAULT_PARTITION__ is NULL, so never matches
+SELECT * FROM explain_files('SELECT * FROM ft_1 WHERE year >= 2023') ORDER BY 1;
+SELECT count(*) FROM ft_1 WHERE year >= 2023;
+
+-- no files are pruned by IS NULL or qualifiers on the other columns
+SELECT * FROM explain_files('SELECT * FROM ft_1 WHERE year IS NULL') ORDER BY 1;
+SELECT count(*) FROM ft_1 WHERE year IS NULL;
+SELECT * FROM explain_files('SELECT * FROM ft_1 WHERE id < 150') ORDER BY 1;
+SELECT count(*) FROM ft_1 WHERE id < 150;
+
+-- all the files are pruned
+SELECT * FROM explain_files('SELECT * FROM ft_1 WHERE year < 2000') ORDER BY 1;
+SELECT count(*) FROM ft_1 WHERE year < 2000;
+
+-- cleanup temporary resource
+SET client_min_messages = error;
+DROP SCHEMA regtest_arrow_hive_temp CASCADE;
@@ -0,0 +1,163 @@
+--
+-- arrow_parquet - test for Apache Parquet files on arrow_fdw
+--
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_arrow_parquet_temp CASCADE;
+CREATE SCHEMA regtest_arrow_parquet_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_arrow_parquet_temp,public;
+\set test_arrow_parquet_path `echo -n $ARROW_TEST_DATA_DIR/test_arrow_parquet.parquet`
+\set test_arrow_parquet_bad_path `echo -n $ARROW_TEST_DATA_DIR/test_arrow_parquet_bad.parquet`
+
+-- small Parquet writer; uncompressed PLAIN values in a single data page,
+-- and min/max statistics of the integer columns for each row group
+CREATE FUNCTION parquet_write(path text, nrows int, ngroups int, nullable bool)
+RETURNS int AS
+$$
+import struct
+def varint(n):
+    out = bytearray()
+    while True:
+        c = n & 0x7f
+        n >>= 7
+        if n == 0:
+            out.append(c)
+            return bytes(out)
+        out.append(c | 0x80)
+def zigzag(n):
+    return varint((n << 1) ^ (n >> 63))
+def tstruct(*fields):
+    out = bytearray()
+    last = 0
+    for fid, ftype, payload in fields:
+        if 0 < fid - last <= 15:
+            out.append(((fid - last) << 4) | ftype)
+        else:
+            out.append(ftype)
+            out += zigzag(fid)
+        out += payload
+        last = fid
+    out.append(0)
+    return bytes(out)
+def fint(fid, v, ftype=5):
+    return (fid, ftype, zigzag(v))
+def fbin(fid, v):
+    return (fid, 8, varint(len(v)) + v)
+def flist(fid, etype, items):
+    if len(items) < 15:
+        head = bytes([(len(items) << 4) | etype])
+    else:
+        head = bytes([0xf0 | etype]) + varint(len(items))
+    return (fid, 9, head + b''.join(items))
+# name, physical type, converted type, struct format, value
+columns = [('id', 1, None, '<i', lambda i: i),
+           ('v',  2, None, '<q', lambda i: i * i - 5000),
+           ('f',  4, None, '<f', lambda i: i / 4.0),
+           ('x',  5, None, '<d', lambda i: i / 7.0),
+           ('d',  1, 6,    '<i', lambda i: 18262 + i),
+           ('b',  0, None, None, lambda i: i % 3 == 0)]
+buf = bytearray(b'PAR1')
+row_groups = []
+for g in range(ngroups):
+    base = g * nrows + 1
+    chunks = []
+    total_sz = 0
+    for name, ptype, ctype, pfmt, func in columns:
+        values = [func(i) for i in range(base, base + nrows)]
+        if pfmt is None:
+            body = bytearray((nrows + 7) // 8)
+            for k, v in enumerate(values):
+                if v:
+                    body[k // 8] |= (1 << (k % 8))
+            body = bytes(body)
+        else:
+            body = b''.join(struct.pack(pfmt, v) for v in values)
+        page = tstruct(fint(1, 0), fint(2, len(body)), fint(3, len(body)),
+                       (5, 12, tstruct(fint(1, nrows), fint(2, 0),
+                                       fint(3, 3), fint(4, 3)))) + body
+        offset = len(buf)
+        buf += page
+        total_sz += len(page)
+        meta = [fint(1, ptype), flist(2, 5, [zigzag(0)]),
+                flist(3, 8, [varint(len(name)) + name.encode()]),
+                fint(4, 0), fint(5, nrows, 6),
+                fint(6, len(page), 6), fint(7, len(page), 6),
+                fint(9, offset, 6)]
+        if ptype in (1, 2):
+            meta.append((12, 12, tstruct(fbin(5, struct.pack(pfmt, max(values))),
+                                         fbin(6, struct.pack(pfmt, min(values))))))
+        chunks.append(tstruct(fint(2, offset, 6), (3, 12, tstruct(*meta))))
+    row_groups.append(tstruct(flist(1, 12, chunks),
+                              fint(2, total_sz, 6), fint(3, nrows, 6)))
+schema = [tstruct(fbin(4, b'schema'), fint(5, len(columns)))]
+for name, ptype, ctype, pfmt, func in columns:
+    fields = [fint(1, ptype),
+              fint(3, 1 if nullable and name == 'x' else 0),
+              fbin(4, name.encode())]
+    if ctype is not None:
+        fields.append(fint(6, ctype))
+    schema.append(tstruct(*fields))
+footer = tstruct(fint(1, 1), flist(2, 12, schema),
+                 fint(3, nrows * ngroups, 6), flist(4, 12, row_groups))
+buf += footer + struct.pack('<I', len(footer)) + b'PAR1'
+with open(path, 'wb') as fp:
+    fp.write(buf)
+return nrows * ngroups
+$$ LANGUAGE 'plpython3u';
+
+-- Stats-Hint line of EXPLAIN ANALYZE
+CREATE FUNCTION explain_stats_hint(query text)
+RETURNS SETOF text AS
+$$
+DECLARE
+  line text;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, SUMMARY OFF) ' || query
+  LOOP
+    IF line ~ 'Stats-Hint:' THEN
+      RETURN NEXT trim(line);
+    END IF;
+  END LOOP;
+END;
+$$ LANGUAGE 'plpgsql';
+
+CREATE TABLE tt_1 AS
+  SELECT i id,
+         (i * i - 5000)::bigint v,
+         (i / 4.0)::float4 f,
+         i::float8 / 7 x,
+         '2020-01-01'::date + i d,
+         i % 3 = 0 b
+    FROM generate_series(1,4000) i;
+SELECT parquet_write(:'test_arrow_parquet_path', 1000, 4, false);
+IMPORT FOREIGN SCHEMA ft_1
+  FROM SERVER arrow_fdw
+  INTO regtest_arrow_parquet_temp
+OPTIONS (file :'test_arrow_parquet_path');
+
+-- CPU reader
+SET pg_strom.enabled = off;
+SET max_parallel_workers_per_gather = 0;
+SELECT count(*) FROM ft_1;
+SELECT * FROM tt_1 EXCEPT SELECT * FROM ft_1;
+SELECT * FROM ft_1 EXCEPT SELECT * FROM tt_1;
+
+-- row-group statistics
+SELECT * FROM explain_stats_hint('SELECT * FROM ft_1 WHERE id BETWEEN 1500 AND 2200');
+(SELECT * FROM tt_1 WHERE id BETWEEN 1500 AND 2200)
+EXCEPT
+(SELECT * FROM ft_1 WHERE id BETWEEN 1500 AND 2200);
+SELECT * FROM explain_stats_hint('SELECT * FROM ft_1 WHERE v < 0');
+SELECT count(*) FROM ft_1 WHERE v < 0;
+
+-- nullable column is not supported
+SELECT parquet_write(:'test_arrow_parquet_bad_path', 100, 1, true);
+CREATE FOREIGN TABLE ft_2 (id int)
+  SERVER arrow_fdw
+  OPTIONS (file :'test_arrow_parquet_bad_path');
+
+-- cleanup temporary resource
+SET client_min_messages = error;
+DROP SCHEMA regtest_arrow_parquet_temp CASCADE;
@@ -0,0 +1,138 @@
+--
+-- arrow_write - test for INSERT / COPY FROM on writable arrow_fdw
+--
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_arrow_write_temp CASCADE;
+CREATE SCHEMA regtest_arrow_write_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_arrow_write_temp,public;
+\! rm -f $ARROW_TEST_DATA_DIR/test_arrow_write_*
+\set test_arrow_write_ft1_path `echo -n $ARROW_TEST_DATA_DIR/test_arrow_write_ft1.arrow`
+\set test_arrow_write_ft2_path `echo -n $ARROW_TEST_DATA_DIR/test_arrow_write_ft2.arrow`
+\set test_arrow_write_csv_path `echo -n $ARROW_TEST_DATA_DIR/test_arrow_write_ft1.csv`
+
+CREATE TABLE tt_1 (
+  id    int,
+  a     smallint,
+  b     float8,
+  c     numeric(12,4),
+  d     text,
+  e     date
+);
+INSERT INTO tt_1 (
+  SELECT x, (x % 2000) - 1000,
+         CASE WHEN x % 17 = 0 THEN NULL ELSE x::float8 / 7.0 END,
+         (x * 1.2345)::numeric(12,4),
+         CASE WHEN x % 13 = 0 THEN NULL ELSE md5(x::text) END,
+         '2024-01-01'::date + x
+    FROM generate_series(1,5000) x);
+
+CREATE FOREIGN TABLE ft_1 (
+  id    int,
+  a     smallint,
+  b     float8,
+  c     numeric(12,4),
+  d     text,
+  e     date
+) SERVER arrow_fdw
+  OPTIONS (file :'test_arrow_write_ft1_path', writable 'true');
+
+--
+-- INSERT then SELECT
+--
+INSERT INTO ft_1 (SELECT * FROM tt_1 WHERE id <= 2000);
+SELECT count(*) FROM ft_1;
+SELECT * FROM tt_1 WHERE id <= 2000 EXCEPT SELECT * FROM ft_1;
+SELECT * FROM ft_1 EXCEPT SELECT * FROM tt_1 WHERE id <= 2000;
+
+--
+-- ROLLBACK shall restore the original footer
+--
+SELECT size AS ft1_size FROM pg_stat_file(:'test_arrow_write_ft1_path') \gset
+BEGIN;
+INSERT INTO ft_1 (SELECT * FROM tt_1 WHERE id > 2000 AND id <= 3000);
+SELECT count(*) FROM ft_1;
+ROLLBACK;
+SELECT size = :ft1_size AS footer_restored
+  FROM pg_stat_file(:'test_arrow_write_ft1_path');
+SELECT count(*) FROM ft_1;
+SELECT * FROM tt_1 WHERE id <= 2000 EXCEPT SELECT * FROM ft_1;
+SELECT * FROM ft_1 EXCEPT SELECT * FROM tt_1 WHERE id <= 2000;
+
+--
+-- COPY FROM, and ROLLBACK TO SAVEPOINT
+--
+COPY (SELECT * FROM tt_1 WHERE id > 2000 AND id <= 3000)
+  TO :'test_arrow_write_csv_path' (FORMAT csv);
+BEGIN;
+COPY ft_1 FROM :'test_arrow_write_csv_path' (FORMAT csv);
+SAVEPOINT s1;
+INSERT INTO ft_1 (SELECT * FROM tt_1 WHERE id > 4000);
+SELECT count(*) FROM ft_1;
+ROLLBACK TO SAVEPOINT s1;
+SELECT count(*) FROM ft_1;
+COMMIT;
+SELECT * FROM tt_1 WHERE id <= 3000 EXCEPT SELECT * FROM ft_1;
+SELECT * FROM ft_1 EXCEPT SELECT * FROM tt_1 WHERE id <= 3000;
+
+--
+-- Concurrent writers; the second one is blocked by flock(2)
+--
+BEGIN;
+INSERT INTO ft_1 (SELECT * FROM tt_1 WHERE id > 3000 AND id <= 3500);
+\! PGAPPNAME=arrow_write_bg $PSQL_CMD -X -q -c 'INSERT INTO regtest_arrow_write_temp.ft_1 (SELECT * FROM regtest_arrow_write_temp.tt_1 WHERE id > 3500 AND id <= 4000)' > /dev/null 2>&1 &
+DO $$
+BEGIN
+  FOR i IN 1..300 LOOP
+    PERFORM pg_stat_clear_snapshot();
+    EXIT WHEN EXISTS (SELECT 1 FROM pg_stat_activity
+                       WHERE application_name = 'arrow_write_bg'
+                         AND state = 'active');
+    PERFORM pg_sleep(0.1);
+  END LOOP;
+END;
+$$;
+\! sleep 1
+SELECT count(*) FROM ft_1;
+COMMIT;
+DO $$
+BEGIN
+  FOR i IN 1..300 LOOP
+    PERFORM pg_stat_clear_snapshot();
+    EXIT WHEN NOT EXISTS (SELECT 1 FROM pg_stat_activity
+                           WHERE application_name = 'arrow_write_bg');
+    PERFORM pg_sleep(0.1);
+  END LOOP;
+END;
+$$;
+SELECT count(*) FROM ft_1;
+SELECT * FROM tt_1 WHERE id <= 4000 EXCEPT SELECT * FROM ft_1;
+SELECT * FROM ft_1 EXCEPT SELECT * FROM tt_1 WHERE id <= 4000;
+
+--
+-- Append to the existing file built by pg2arrow
+--
+\! $PG2ARROW_CMD -c 'SELECT * FROM regtest_arrow_write_temp.tt_1 WHERE id > 4000 AND id <= 4500' -o $ARROW_TEST_DATA_DIR/test_arrow_write_ft2.arrow
+CREATE FOREIGN TABLE ft_2 (
+  id    int,
+  a     smallint,
+  b     float8,
+  c     numeric(12,4),
+  d     text,
+  e     date
+) SERVER arrow_fdw
+  OPTIONS (file :'test_arrow_write_ft2_path', writable 'true');
+SELECT count(*) FROM ft_2;
+SELECT size AS ft2_size FROM pg_stat_file(:'test_arrow_write_ft2_path') \gset
+INSERT INTO ft_2 (SELECT * FROM tt_1 WHERE id > 4500);
+SELECT size > :ft2_size AS appended
+  FROM pg_stat_file(:'test_arrow_write_ft2_path');
+SELECT count(*) FROM ft_2;
+SELECT * FROM tt_1 WHERE id > 4000 EXCEPT SELECT * FROM ft_2;
+SELECT * FROM ft_2 EXCEPT SELECT * FROM tt_1 WHERE id > 4000;
+
+-- cleanup temporary resource
+SET client_min_messages = error;
+DROP SCHEMA regtest_arrow_write_temp CASCADE;
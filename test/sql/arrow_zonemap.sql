@@ -0,0 +1,68 @@
+--
+-- arrow_zonemap - test for zone-map statistics inside of record-batches
+--
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_arrow_zonemap_temp CASCADE;
+CREATE SCHEMA regtest_arrow_zonemap_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_arrow_zonemap_temp,public;
+\set test_arrow_zonemap_path `echo -n $ARROW_TEST_DATA_DIR/test_arrow_zonemap.arrow`
+
+-- Stats-Hint line of EXPLAIN ANALYZE
+CREATE FUNCTION explain_stats_hint(query text)
+RETURNS SETOF text AS
+$$
+DECLARE
+  line text;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, SUMMARY OFF) ' || query
+  LOOP
+    IF line ~ 'Stats-Hint:' THEN
+      RETURN NEXT trim(line);
+    END IF;
+  END LOOP;
+END;
+$$ LANGUAGE 'plpgsql';
+
+-- a record-batch with 5 zones (65536 rows for each)
+CREATE TABLE tt_1 AS
+  SELECT i id,
+         CASE WHEN i % 7 = 0 THEN NULL ELSE i % 1000 END v,
+         md5(i::text) t
+    FROM generate_series(1,300000) i;
+\! $PG2ARROW_CMD -c 'SELECT * FROM regtest_arrow_zonemap_temp.tt_1 ORDER BY id' --stat=id -o $ARROW_TEST_DATA_DIR/test_arrow_zonemap.arrow
+IMPORT FOREIGN SCHEMA ft_1
+  FROM SERVER arrow_fdw
+  INTO regtest_arrow_zonemap_temp
+OPTIONS (file :'test_arrow_zonemap_path');
+
+SET pg_strom.enabled = off;
+SET max_parallel_workers_per_gather = 0;
+-- a zone in the middle
+SELECT * FROM explain_stats_hint('SELECT * FROM ft_1 WHERE id BETWEEN 70000 AND 80000');
+SELECT count(*) FROM ft_1 WHERE id BETWEEN 70000 AND 80000;
+(SELECT * FROM tt_1 WHERE id BETWEEN 70000 AND 80000)
+EXCEPT
+(SELECT * FROM ft_1 WHERE id BETWEEN 70000 AND 80000);
+
+-- contiguous zones are merged into one row-range
+SELECT * FROM explain_stats_hint('SELECT * FROM ft_1 WHERE id BETWEEN 130000 AND 200000');
+SELECT count(*) FROM ft_1 WHERE id BETWEEN 130000 AND 200000;
+(SELECT * FROM tt_1 WHERE id BETWEEN 130000 AND 200000)
+EXCEPT
+(SELECT * FROM ft_1 WHERE id BETWEEN 130000 AND 200000);
+
+-- the last zone is shorter than others
+SELECT * FROM explain_stats_hint('SELECT * FROM ft_1 WHERE id > 290000');
+(SELECT * FROM tt_1 WHERE id > 290000)
+EXCEPT
+(SELECT * FROM ft_1 WHERE id > 290000);
+(SELECT * FROM ft_1 WHERE id > 290000)
+EXCEPT
+(SELECT * FROM tt_1 WHERE id > 290000);
+
+-- cleanup temporary resource
+SET client_min_messages = error;
+DROP SCHEMA regtest_arrow_zonemap_temp CASCADE;
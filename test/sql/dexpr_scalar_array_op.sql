@@ -86,6 +86,160 @@ SELECT id,z INTO test03p FROM regtest_data
 (SELECT * FROM test03g EXCEPT SELECT * FROM test03p);
 (SELECT * FROM test03p EXCEPT SELECT * FROM test03g);
 
+-- ScalarArrayOp with large constant array (hash set)
+SET pg_strom.enabled = on;
+VACUUM ANALYZE regtest_data;
+SELECT id,x INTO test04g FROM regtest_data
+ WHERE x[1] IN (0, 13, 26, 39, 52, 65, 78, 91, 104, 117, 130, 143, 156,
+                169, 182, 195, 208, 221, 234, 247, 260, 273, 286, 299,
+                312, 325, 338, 351, 364, 377, 390, 403, 416, 429, 442,
+                455, 468, 481, 494, 507, 520, 533, 546, 559, 572, 585,
+                598, 611, 624, 637, 650, 663, 676, 689, 702, 715, 728,
+                741, 754, 767, 780, 793, 806, 819, 832, 845, 858, 871,
+                884, 897, 910, 923, 936, 949, 962, 975, 988);
+SET pg_strom.enabled = off;
+SELECT id,x INTO test04p FROM regtest_data
+ WHERE x[1] IN (0, 13, 26, 39, 52, 65, 78, 91, 104, 117, 130, 143, 156,
+                169, 182, 195, 208, 221, 234, 247, 260, 273, 286, 299,
+                312, 325, 338, 351, 364, 377, 390, 403, 416, 429, 442,
+                455, 468, 481, 494, 507, 520, 533, 546, 559, 572, 585,
+                598, 611, 624, 637, 650, 663, 676, 689, 702, 715, 728,
+                741, 754, 767, 780, 793, 806, 819, 832, 845, 858, 871,
+                884, 897, 910, 923, 936, 949, 962, 975, 988);
+(SELECT * FROM test04g EXCEPT SELECT * FROM test04p);
+(SELECT * FROM test04p EXCEPT SELECT * FROM test04g);
+
+SET pg_strom.enabled = on;
+VACUUM ANALYZE regtest_data;
+SELECT id,z INTO test05g FROM regtest_data
+ WHERE z[2] IN ('kVOV', 'kBHS', 'kCO6', 'kDVM', 'kE3Z', 'kFDG', 'kGKT',
+                'kHRA', 'kIYN', 'kJ61', 'kKGH', 'kLNU', 'kMUB', 'kN2O',
+                'kOC2', 'kPJI', 'kQQV', 'kRXC', 'kS5P', 'kTF3', 'kUMJ',
+                'kVTW', 'kW1D', 'kXBQ', 'kYI4', 'kZPK', 'k1WX', 'k24E',
+                'k3ER', 'k4L5', 'k5SL', 'k6ZY', 'kABF', 'kBIS', 'kCP6',
+                'kDWM', 'kE4Z', 'kFEG', 'kGLT', 'kHSA', 'kIZN', 'kJA1',
+                'kKHH', 'kLOU', 'kMVB', 'kN3O', 'kOD2', 'kPKI', 'kQRV',
+                'kRYC', 'kS6P', 'kTG3', 'kUNJ', 'kVUW', 'kW2D', 'kXCQ',
+                'kYJ4', 'kZQK', 'k1XX', 'k25E', 'k3FR', 'k4M5', 'k5TL',
+                'k61Y', 'kACF', 'kBJS', 'kCQ6', 'kDXM', 'kE5Z', 'kFFG',
+                'kGMT', 'kHTA', 'kI1N', 'kJB1', 'kKIH', 'kLPU', 'kMWB',
+                'kN4O', 'kOE2', 'kPLI');
+SET pg_strom.enabled = off;
+SELECT id,z INTO test05p FROM regtest_data
+ WHERE z[2] IN ('kVOV', 'kBHS', 'kCO6', 'kDVM', 'kE3Z', 'kFDG', 'kGKT',
+                'kHRA', 'kIYN', 'kJ61', 'kKGH', 'kLNU', 'kMUB', 'kN2O',
+                'kOC2', 'kPJI', 'kQQV', 'kRXC', 'kS5P', 'kTF3', 'kUMJ',
+                'kVTW', 'kW1D', 'kXBQ', 'kYI4', 'kZPK', 'k1WX', 'k24E',
+                'k3ER', 'k4L5', 'k5SL', 'k6ZY', 'kABF', 'kBIS', 'kCP6',
+                'kDWM', 'kE4Z', 'kFEG', 'kGLT', 'kHSA', 'kIZN', 'kJA1',
+                'kKHH', 'kLOU', 'kMVB', 'kN3O', 'kOD2', 'kPKI', 'kQRV',
+                'kRYC', 'kS6P', 'kTG3', 'kUNJ', 'kVUW', 'kW2D', 'kXCQ',
+                'kYJ4', 'kZQK', 'k1XX', 'k25E', 'k3FR', 'k4M5', 'k5TL',
+                'k61Y', 'kACF', 'kBJS', 'kCQ6', 'kDXM', 'kE5Z', 'kFFG',
+                'kGMT', 'kHTA', 'kI1N', 'kJB1', 'kKIH', 'kLPU', 'kMWB',
+                'kN4O', 'kOE2', 'kPLI');
+(SELECT * FROM test05g EXCEPT SELECT * FROM test05p);
+(SELECT * FROM test05p EXCEPT SELECT * FROM test05g);
+
+SET pg_strom.enabled = on;
+VACUUM ANALYZE regtest_data;
+SELECT id, x[2] = ANY(ARRAY[0, 13, 26, 39, 52, 65, 78, 91, 104, 117, 130, 143, 156,
+                            169, 182, 195, 208, 221, 234, 247, 260, 273, 286, 299,
+                            312, 325, 338, 351, 364, 377, 390, 403, 416, 429, 442,
+                            455, 468, 481, 494, 507, 520, 533, 546, 559, 572, 585,
+                            598, 611, 624, 637, 650, 663, 676, 689, 702, 715, 728,
+                            741, 754, 767, 780, 793, 806, 819, 832, 845, 858, 871,
+                            884, 897, 910, 923, 936, 949, 962, 975, 988, NULL]) v
+  INTO test06g FROM regtest_data
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, x[2] = ANY(ARRAY[0, 13, 26, 39, 52, 65, 78, 91, 104, 117, 130, 143, 156,
+                            169, 182, 195, 208, 221, 234, 247, 260, 273, 286, 299,
+                            312, 325, 338, 351, 364, 377, 390, 403, 416, 429, 442,
+                            455, 468, 481, 494, 507, 520, 533, 546, 559, 572, 585,
+                            598, 611, 624, 637, 650, 663, 676, 689, 702, 715, 728,
+                            741, 754, 767, 780, 793, 806, 819, 832, 845, 858, 871,
+                            884, 897, 910, 923, 936, 949, 962, 975, 988, NULL]) v
+  INTO test06p FROM regtest_data
+ WHERE id > 0;
+(SELECT * FROM test06g EXCEPT SELECT * FROM test06p);
+(SELECT * FROM test06p EXCEPT SELECT * FROM test06g);
+
+-- array operators and functions
+SET pg_strom.enabled = on;
+VACUUM ANALYZE regtest_data;
+SELECT id, x @> ARRAY[72] v1,
+           x @> x v2,
+           x && ARRAY[1,2,3,4,5,6,7,8,9,10] v3,
+           x <@ ARRAY[0, 10, 20, 30, 40, 50, 60, 70, 80, 90, 100, 110, 120,
+                      130, 140, 150, 160, 170, 180, 190, 200, 210, 220, 230,
+                      240, 250, 260, 270, 280, 290, 300, 310, 320, 330, 340,
+                      350, 360, 370, 380, 390, 400, 410, 420, 430, 440, 450,
+                      460, 470, 480, 490, 500, 510, 520, 530, 540, 550, 560,
+                      570, 580, 590, 600, 610, 620, 630, 640, 650, 660, 670,
+                      680, 690, 700, 710, 720, 730, 740, 750, 760, 770, 780,
+                      790, 800, 810, 820, 830, 840, 850, 860, 870, 880, 890,
+                      900, 910, 920, 930, 940, 950, 960, 970, 980, 990] v4,
+           array_ndims(x) v5,
+           array_length(x, 1) v6,
+           cardinality(x) v7
+  INTO test07g FROM regtest_data
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, x @> ARRAY[72] v1,
+           x @> x v2,
+           x && ARRAY[1,2,3,4,5,6,7,8,9,10] v3,
+           x <@ ARRAY[0, 10, 20, 30, 40, 50, 60, 70, 80, 90, 100, 110, 120,
+                      130, 140, 150, 160, 170, 180, 190, 200, 210, 220, 230,
+                      240, 250, 260, 270, 280, 290, 300, 310, 320, 330, 340,
+                      350, 360, 370, 380, 390, 400, 410, 420, 430, 440, 450,
+                      460, 470, 480, 490, 500, 510, 520, 530, 540, 550, 560,
+                      570, 580, 590, 600, 610, 620, 630, 640, 650, 660, 670,
+                      680, 690, 700, 710, 720, 730, 740, 750, 760, 770, 780,
+                      790, 800, 810, 820, 830, 840, 850, 860, 870, 880, 890,
+                      900, 910, 920, 930, 940, 950, 960, 970, 980, 990] v4,
+           array_ndims(x) v5,
+           array_length(x, 1) v6,
+           cardinality(x) v7
+  INTO test07p FROM regtest_data
+ WHERE id > 0;
+(SELECT * FROM test07g EXCEPT SELECT * FROM test07p);
+(SELECT * FROM test07p EXCEPT SELECT * FROM test07g);
+
+SET pg_strom.enabled = on;
+VACUUM ANALYZE regtest_data;
+SELECT id, z @> ARRAY['kVOV'] v1,
+           z @> z v2,
+           z && ARRAY['kAAA','kBBB','kCCC','kDDD','kVOV'] v3,
+           z <@ ARRAY['kVOV','kAAA'] v4,
+           array_ndims(z) v5,
+           array_length(z, 1) v6,
+           cardinality(z) v7
+  INTO test08g FROM regtest_data
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, z @> ARRAY['kVOV'] v1,
+           z @> z v2,
+           z && ARRAY['kAAA','kBBB','kCCC','kDDD','kVOV'] v3,
+           z <@ ARRAY['kVOV','kAAA'] v4,
+           array_ndims(z) v5,
+           array_length(z, 1) v6,
+           cardinality(z) v7
+  INTO test08p FROM regtest_data
+ WHERE id > 0;
+(SELECT * FROM test08g EXCEPT SELECT * FROM test08p);
+(SELECT * FROM test08p EXCEPT SELECT * FROM test08g);
+
+SET pg_strom.enabled = on;
+VACUUM ANALYZE regtest_data;
+SELECT id,x INTO test09g FROM regtest_data
+ WHERE x && ARRAY[72,75,96] AND cardinality(x) > 3;
+SET pg_strom.enabled = off;
+SELECT id,x INTO test09p FROM regtest_data
+ WHERE x && ARRAY[72,75,96] AND cardinality(x) > 3;
+(SELECT * FROM test09g EXCEPT SELECT * FROM test09p);
+(SELECT * FROM test09p EXCEPT SELECT * FROM test09g);
+
 -- TODO: array operation on fdw_arrow
 
 -- should be empty result
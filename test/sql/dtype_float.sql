@@ -382,6 +382,68 @@ SELECT id, a<=b v1, a<=d v2, a<=f v3,
 (SELECT * FROM test25g EXCEPT ALL SELECT * FROM test25p) ORDER BY id;
 (SELECT * FROM test25p EXCEPT ALL SELECT * FROM test25g) ORDER BY id;
 
+-- dot product / cosine similarity of float2[]
+CREATE TABLE rt_float2_array AS
+  SELECT id, ARRAY[(a::float8 / 100.0)::float2,
+                   (b::float8 / 100.0)::float2,
+                   (c::float8 / 250000.0)::float2,
+                   (e::float8 / 2500000.0)::float2] u,
+             ARRAY[(b::float8 / 100.0)::float2,
+                   (a::float8 / 100.0)::float2,
+                   (d::float8 / 250000.0)::float2,
+                   (f::float8 / 2500000.0)::float2] w
+    FROM rt_float
+   WHERE a IS NOT NULL AND b IS NOT NULL AND c IS NOT NULL
+     AND d IS NOT NULL AND e IS NOT NULL AND f IS NOT NULL;
+VACUUM ANALYZE rt_float2_array;
+
+SET pg_strom.enabled = on;
+-- GPU path must be taken (the row estimation is not stable)
+CREATE FUNCTION explain_gpu_path(query text)
+RETURNS SETOF text AS
+$$
+DECLARE
+  line text;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN (COSTS OFF) ' || query
+  LOOP
+    IF line ~ '(Custom Scan|GPU Projection)' THEN
+      RETURN NEXT trim(line);
+    END IF;
+  END LOOP;
+END;
+$$ LANGUAGE 'plpgsql';
+SELECT * FROM explain_gpu_path($$
+SELECT id, pgstrom.float2_dot_product(u, w)       v1,
+           pgstrom.float2_dot_product(u, u)       v2,
+           pgstrom.float2_cosine_similarity(u, w) v3,
+           pgstrom.float2_cosine_similarity(w, u) v4
+  FROM rt_float2_array
+ WHERE id > 0
+$$);
+SELECT id, pgstrom.float2_dot_product(u, w)       v1,
+           pgstrom.float2_dot_product(u, u)       v2,
+           pgstrom.float2_cosine_similarity(u, w) v3,
+           pgstrom.float2_cosine_similarity(w, u) v4
+  INTO test30g
+  FROM rt_float2_array
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, pgstrom.float2_dot_product(u, w)       v1,
+           pgstrom.float2_dot_product(u, u)       v2,
+           pgstrom.float2_cosine_similarity(u, w) v3,
+           pgstrom.float2_cosine_similarity(w, u) v4
+  INTO test30p
+  FROM rt_float2_array
+ WHERE id > 0;
+
+SELECT * FROM test30g g, test30p p
+ WHERE g.id = p.id
+   AND (abs(g.v1 - p.v1) > 0.001
+    OR abs(g.v2 - p.v2) > 0.001
+    OR abs(g.v3 - p.v3) > 0.001
+    OR abs(g.v4 - p.v4) > 0.001);
+
 -- cleanup temporary resource
 SET client_min_messages = error;
 DROP SCHEMA regtest_dtype_float_temp CASCADE;
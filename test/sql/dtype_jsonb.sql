@@ -238,6 +238,84 @@ SELECT id, ((v)->>'num1')::numeric + ((v)->'comp'->>'ival')::numeric v1,
 (SELECT * FROM test06g EXCEPT SELECT * FROM test06p) ORDER BY id;
 (SELECT * FROM test06p EXCEPT SELECT * FROM test06g) ORDER BY id;
 
+-- jsonpath on array-jsonb
+VACUUM ANALYZE rt_jsonb_a;
+SET pg_strom.enabled = on;
+SELECT id, v @? '$[*] ? (@ == true)'               v1,
+           v @@ '$[0] > 100'                       v2,
+           v @? '$[4]'                             v3,
+           jsonb_path_exists(v, '$[*] ? (!(@ == null))') v4,
+           jsonb_path_match(v, '$[1] < 0 || $[2] == false') v5
+  INTO test07g
+  FROM rt_jsonb_a
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, v @? '$[*] ? (@ == true)'               v1,
+           v @@ '$[0] > 100'                       v2,
+           v @? '$[4]'                             v3,
+           jsonb_path_exists(v, '$[*] ? (!(@ == null))') v4,
+           jsonb_path_match(v, '$[1] < 0 || $[2] == false') v5
+  INTO test07p
+  FROM rt_jsonb_a
+ WHERE id > 0;
+
+(SELECT * FROM test07g EXCEPT SELECT * FROM test07p) ORDER BY id;
+(SELECT * FROM test07p EXCEPT SELECT * FROM test07g) ORDER BY id;
+
+-- jsonpath on key-value jsonb
+VACUUM ANALYZE rt_jsonb_o;
+SET pg_strom.enabled = on;
+SELECT id, jsonb_path_exists(v, '$.ival')          v1,
+           v @? '$.sval_1'                         v2,
+           v @? '$.ival ? (@ > 5000)'              v3,
+           v @@ '$.fval < 0'                       v4,
+           v @@ '$.bval == true'                   v5,
+           v @? '$ ? (@.ival > 0 && @.fval < 0)'   v6,
+           v @? '$.* ? (@ == null)'                v7,
+           v @@ '($.ival > 0) is unknown'          v8,
+           v @@ '$.sval_2 == "abc"'                v9
+  INTO test08g
+  FROM rt_jsonb_o
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, jsonb_path_exists(v, '$.ival')          v1,
+           v @? '$.sval_1'                         v2,
+           v @? '$.ival ? (@ > 5000)'              v3,
+           v @@ '$.fval < 0'                       v4,
+           v @@ '$.bval == true'                   v5,
+           v @? '$ ? (@.ival > 0 && @.fval < 0)'   v6,
+           v @? '$.* ? (@ == null)'                v7,
+           v @@ '($.ival > 0) is unknown'          v8,
+           v @@ '$.sval_2 == "abc"'                v9
+  INTO test08p
+  FROM rt_jsonb_o
+ WHERE id > 0;
+
+(SELECT * FROM test08g EXCEPT SELECT * FROM test08p) ORDER BY id;
+(SELECT * FROM test08p EXCEPT SELECT * FROM test08g) ORDER BY id;
+
+-- jsonpath on nested-jsonb
+VACUUM ANALYZE rt_jsonb_c;
+SET pg_strom.enabled = on;
+SELECT id, v @? '$.comp.ival ? (@ >= 0 || @ < -9000)' v1,
+           v @? '$.comp ? (exists(@.sval_1))'         v2,
+           v @@ '$.comp.fval > 0'                     v3,
+           jsonb_path_exists(v, '$.comp.*[0]')        v4
+  INTO test09g
+  FROM rt_jsonb_c
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, v @? '$.comp.ival ? (@ >= 0 || @ < -9000)' v1,
+           v @? '$.comp ? (exists(@.sval_1))'         v2,
+           v @@ '$.comp.fval > 0'                     v3,
+           jsonb_path_exists(v, '$.comp.*[0]')        v4
+  INTO test09p
+  FROM rt_jsonb_c
+ WHERE id > 0;
+
+(SELECT * FROM test09g EXCEPT SELECT * FROM test09p) ORDER BY id;
+(SELECT * FROM test09p EXCEPT SELECT * FROM test09g) ORDER BY id;
+
 -- cleanup temporary resource
 SET client_min_messages = error;
 DROP SCHEMA regtest_dtype_jsonb_temp CASCADE;
@@ -258,6 +258,125 @@ SELECT id, length(tc1) v1,
 (SELECT * FROM test32g EXCEPT SELECT * FROM test32p) ORDER BY id;
 (SELECT * FROM test32p EXCEPT SELECT * FROM test32g) ORDER BY id;
 
+-- lower / upper (ASCII only under COLLATE "C")
+SET pg_strom.enabled = on;
+SELECT id, lower(bc1) v1, upper(bc2) v2,
+           lower(vc1) v3, upper(vc2) v4,
+           lower(tc1) v5, upper(tc2) v6
+  INTO test33g
+  FROM rt_text
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, lower(bc1) v1, upper(bc2) v2,
+           lower(vc1) v3, upper(vc2) v4,
+           lower(tc1) v5, upper(tc2) v6
+  INTO test33p
+  FROM rt_text
+ WHERE id > 0;
+
+(SELECT * FROM test33g EXCEPT SELECT * FROM test33p) ORDER BY id;
+(SELECT * FROM test33p EXCEPT SELECT * FROM test33g) ORDER BY id;
+
+-- strpos / position
+SET pg_strom.enabled = on;
+SELECT id, strpos(bc1, 'ab') v1, position('Z' in bc2) v2,
+           strpos(vc1, 'x') v3, position('+/' in vc2) v4,
+           strpos(tc1, '-') v5, position(substring(tc2, 3, 2) in tc2) v6,
+           strpos(tc1, '') v7
+  INTO test34g
+  FROM rt_text
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, strpos(bc1, 'ab') v1, position('Z' in bc2) v2,
+           strpos(vc1, 'x') v3, position('+/' in vc2) v4,
+           strpos(tc1, '-') v5, position(substring(tc2, 3, 2) in tc2) v6,
+           strpos(tc1, '') v7
+  INTO test34p
+  FROM rt_text
+ WHERE id > 0;
+
+(SELECT * FROM test34g EXCEPT SELECT * FROM test34p) ORDER BY id;
+(SELECT * FROM test34p EXCEPT SELECT * FROM test34g) ORDER BY id;
+
+-- regular expression operators
+SET pg_strom.enabled = on;
+SELECT id, tc1 ~   '[a-c][0-9]'     v1,
+           tc2 !~  '^[A-Z]+[a-z]'   v2,
+           vc1 ~*  'ab|cd|ef'       v3,
+           vc2 !~* '(xy)+z?'        v4,
+           bc1 ~   'a.{2,3}b'       v5,
+           tc1 ~   '(?:[+/]9)*0$'   v6,
+           regexp_like(tc2, 'A[0-9]{2}')  v7,
+           regexp_like(vc1, 'q+r', 'i')   v8
+  INTO test35g
+  FROM rt_text
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, tc1 ~   '[a-c][0-9]'     v1,
+           tc2 !~  '^[A-Z]+[a-z]'   v2,
+           vc1 ~*  'ab|cd|ef'       v3,
+           vc2 !~* '(xy)+z?'        v4,
+           bc1 ~   'a.{2,3}b'       v5,
+           tc1 ~   '(?:[+/]9)*0$'   v6,
+           regexp_like(tc2, 'A[0-9]{2}')  v7,
+           regexp_like(vc1, 'q+r', 'i')   v8
+  INTO test35p
+  FROM rt_text
+ WHERE id > 0;
+
+(SELECT * FROM test35g EXCEPT SELECT * FROM test35p) ORDER BY id;
+(SELECT * FROM test35p EXCEPT SELECT * FROM test35g) ORDER BY id;
+
+-- LIKE & ILIKE with multiple '%'
+SET pg_strom.enabled = on;
+SELECT id, tc1 LIKE      '%a%b%c%'  v1,
+           tc2 NOT LIKE  '%x%y%'    v2,
+           vc1 LIKE      'A%b%'     v3,
+           vc2 ILIKE     '%q_%r%'   v4,
+           bc1 NOT ILIKE '%z%z%'    v5
+  INTO test36g
+  FROM rt_text
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, tc1 LIKE      '%a%b%c%'  v1,
+           tc2 NOT LIKE  '%x%y%'    v2,
+           vc1 LIKE      'A%b%'     v3,
+           vc2 ILIKE     '%q_%r%'   v4,
+           bc1 NOT ILIKE '%z%z%'    v5
+  INTO test36p
+  FROM rt_text
+ WHERE id > 0;
+
+(SELECT * FROM test36g EXCEPT SELECT * FROM test36p) ORDER BY id;
+(SELECT * FROM test36p EXCEPT SELECT * FROM test36g) ORDER BY id;
+
+-- LIKE with '%literal%' (substring search)
+SET pg_strom.enabled = on;
+SELECT id, tc1 LIKE     '%ab%'    v1,
+           tc2 NOT LIKE '%Zq9%'   v2,
+           vc1 LIKE     '%+/%'    v3,
+           vc2 NOT LIKE '%x%'     v4,
+           bc1 LIKE     '%a %'    v5,
+           tc1 LIKE     '%-%'     v6,
+           tc2 LIKE     '%%'      v7
+  INTO test37g
+  FROM rt_text
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, tc1 LIKE     '%ab%'    v1,
+           tc2 NOT LIKE '%Zq9%'   v2,
+           vc1 LIKE     '%+/%'    v3,
+           vc2 NOT LIKE '%x%'     v4,
+           bc1 LIKE     '%a %'    v5,
+           tc1 LIKE     '%-%'     v6,
+           tc2 LIKE     '%%'      v7
+  INTO test37p
+  FROM rt_text
+ WHERE id > 0;
+
+(SELECT * FROM test37g EXCEPT SELECT * FROM test37p) ORDER BY id;
+(SELECT * FROM test37p EXCEPT SELECT * FROM test37g) ORDER BY id;
+
 -- cleanup temporary resource
 SET client_min_messages = error;
 DROP SCHEMA regtest_dtype_text_temp CASCADE;
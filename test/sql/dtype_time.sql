@@ -920,6 +920,174 @@ SELECT * FROM test45g AS a, test45p AS b WHERE a.id=b.id AND
   OR ABS(a.v12 - b.v12) > 0.1
 ) LIMIT 5;
 
+-- date_trunc on timestamp
+SET pg_strom.enabled = on;
+SELECT id, date_trunc('microseconds', ts1) v1,
+           date_trunc('milliseconds', ts2) v2,
+           date_trunc('second', ts1)       v3,
+           date_trunc('minute', ts2)       v4,
+           date_trunc('hour', ts1)         v5,
+           date_trunc('day', ts2)          v6,
+           date_trunc('week', ts1)         v7,
+           date_trunc('month', ts2)        v8,
+           date_trunc('quarter', ts1)      v9,
+           date_trunc('year', ts2)         v10,
+           date_trunc('decade', ts1)       v11,
+           date_trunc('century', ts2)      v12,
+           date_trunc('millennium', ts1)   v13
+  INTO test50g
+  FROM rt_datetime
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, date_trunc('microseconds', ts1) v1,
+           date_trunc('milliseconds', ts2) v2,
+           date_trunc('second', ts1)       v3,
+           date_trunc('minute', ts2)       v4,
+           date_trunc('hour', ts1)         v5,
+           date_trunc('day', ts2)          v6,
+           date_trunc('week', ts1)         v7,
+           date_trunc('month', ts2)        v8,
+           date_trunc('quarter', ts1)      v9,
+           date_trunc('year', ts2)         v10,
+           date_trunc('decade', ts1)       v11,
+           date_trunc('century', ts2)      v12,
+           date_trunc('millennium', ts1)   v13
+  INTO test50p
+  FROM rt_datetime
+ WHERE id > 0;
+
+(SELECT * FROM test50g EXCEPT SELECT * FROM test50p) ORDER BY id;
+(SELECT * FROM test50p EXCEPT SELECT * FROM test50g) ORDER BY id;
+
+-- date_trunc on timestamptz
+SET timezone = 'Japan';
+SET pg_strom.enabled = on;
+SELECT id, date_trunc('microseconds', tsz1) v1,
+           date_trunc('milliseconds', tsz2) v2,
+           date_trunc('second', tsz1)       v3,
+           date_trunc('minute', tsz2)       v4,
+           date_trunc('hour', tsz1)         v5,
+           date_trunc('day', tsz2)          v6,
+           date_trunc('week', tsz1)         v7,
+           date_trunc('month', tsz2)        v8,
+           date_trunc('quarter', tsz1)      v9,
+           date_trunc('year', tsz2)         v10,
+           date_trunc('decade', tsz1)       v11,
+           date_trunc('century', tsz2)      v12,
+           date_trunc('millennium', tsz1)   v13
+  INTO test51g
+  FROM rt_datetime
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, date_trunc('microseconds', tsz1) v1,
+           date_trunc('milliseconds', tsz2) v2,
+           date_trunc('second', tsz1)       v3,
+           date_trunc('minute', tsz2)       v4,
+           date_trunc('hour', tsz1)         v5,
+           date_trunc('day', tsz2)          v6,
+           date_trunc('week', tsz1)         v7,
+           date_trunc('month', tsz2)        v8,
+           date_trunc('quarter', tsz1)      v9,
+           date_trunc('year', tsz2)         v10,
+           date_trunc('decade', tsz1)       v11,
+           date_trunc('century', tsz2)      v12,
+           date_trunc('millennium', tsz1)   v13
+  INTO test51p
+  FROM rt_datetime
+ WHERE id > 0;
+
+(SELECT * FROM test51g EXCEPT SELECT * FROM test51p) ORDER BY id;
+(SELECT * FROM test51p EXCEPT SELECT * FROM test51g) ORDER BY id;
+
+-- date_trunc on timestamptz (different timezone)
+SET timezone = 'CET';
+SET pg_strom.enabled = on;
+SELECT id, date_trunc('microseconds', tsz1) v1,
+           date_trunc('milliseconds', tsz2) v2,
+           date_trunc('second', tsz1)       v3,
+           date_trunc('minute', tsz2)       v4,
+           date_trunc('hour', tsz1)         v5,
+           date_trunc('day', tsz2)          v6,
+           date_trunc('week', tsz1)         v7,
+           date_trunc('month', tsz2)        v8,
+           date_trunc('quarter', tsz1)      v9,
+           date_trunc('year', tsz2)         v10,
+           date_trunc('decade', tsz1)       v11,
+           date_trunc('century', tsz2)      v12,
+           date_trunc('millennium', tsz1)   v13
+  INTO test52g
+  FROM rt_datetime
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, date_trunc('microseconds', tsz1) v1,
+           date_trunc('milliseconds', tsz2) v2,
+           date_trunc('second', tsz1)       v3,
+           date_trunc('minute', tsz2)       v4,
+           date_trunc('hour', tsz1)         v5,
+           date_trunc('day', tsz2)          v6,
+           date_trunc('week', tsz1)         v7,
+           date_trunc('month', tsz2)        v8,
+           date_trunc('quarter', tsz1)      v9,
+           date_trunc('year', tsz2)         v10,
+           date_trunc('decade', tsz1)       v11,
+           date_trunc('century', tsz2)      v12,
+           date_trunc('millennium', tsz1)   v13
+  INTO test52p
+  FROM rt_datetime
+ WHERE id > 0;
+
+(SELECT * FROM test52g EXCEPT SELECT * FROM test52p) ORDER BY id;
+(SELECT * FROM test52p EXCEPT SELECT * FROM test52g) ORDER BY id;
+
+-- date_bin
+SET pg_strom.enabled = on;
+SELECT id, date_bin('15 minutes', ts1, ts2) v1,
+           date_bin('1 day 3 hours', ts3, ts4) v2,
+           date_bin('90 seconds', ts1, '2001-01-01 00:00:00') v3,
+           date_bin('15 minutes', tsz1, tsz2) v4,
+           date_bin('1 day 3 hours', tsz3, tsz4) v5,
+           date_bin('90 seconds', tsz1, '2001-01-01 00:00:00+09') v6
+  INTO test53g
+  FROM rt_datetime
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, date_bin('15 minutes', ts1, ts2) v1,
+           date_bin('1 day 3 hours', ts3, ts4) v2,
+           date_bin('90 seconds', ts1, '2001-01-01 00:00:00') v3,
+           date_bin('15 minutes', tsz1, tsz2) v4,
+           date_bin('1 day 3 hours', tsz3, tsz4) v5,
+           date_bin('90 seconds', tsz1, '2001-01-01 00:00:00+09') v6
+  INTO test53p
+  FROM rt_datetime
+ WHERE id > 0;
+
+(SELECT * FROM test53g EXCEPT SELECT * FROM test53p) ORDER BY id;
+(SELECT * FROM test53p EXCEPT SELECT * FROM test53g) ORDER BY id;
+
+-- date_trunc on timestamptz with explicit timezone
+SET timezone = 'Japan';
+SET pg_strom.enabled = on;
+SELECT id, date_trunc('day',   tsz1, 'America/New_York') v1,
+           date_trunc('hour',  tsz2, 'Asia/Kolkata')     v2,
+           date_trunc('month', tsz3, 'UTC')              v3,
+           date_trunc('week',  tsz4, 'Europe/London')    v4,
+           date_trunc('year',  tsz1, 'Australia/Sydney') v5
+  INTO test54g
+  FROM rt_datetime
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, date_trunc('day',   tsz1, 'America/New_York') v1,
+           date_trunc('hour',  tsz2, 'Asia/Kolkata')     v2,
+           date_trunc('month', tsz3, 'UTC')              v3,
+           date_trunc('week',  tsz4, 'Europe/London')    v4,
+           date_trunc('year',  tsz1, 'Australia/Sydney') v5
+  INTO test54p
+  FROM rt_datetime
+ WHERE id > 0;
+
+(SELECT * FROM test54g EXCEPT SELECT * FROM test54p) ORDER BY id;
+(SELECT * FROM test54p EXCEPT SELECT * FROM test54g) ORDER BY id;
+
 -- cleanup temporary resource
 SET client_min_messages = error;
 DROP SCHEMA regtest_dtype_time_temp CASCADE;
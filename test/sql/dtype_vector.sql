@@ -0,0 +1,121 @@
+---
+--- Micro test cases for pgvector 'vector' type and distance functions
+---
+-- skip test if pgvector is not installed
+SELECT count(*) = 0 AS skip_test
+  FROM pg_available_extensions WHERE name = 'vector' \gset
+\if :skip_test
+\quit
+\endif
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+CREATE EXTENSION IF NOT EXISTS vector;
+DROP SCHEMA IF EXISTS regtest_dtype_vector_temp CASCADE;
+CREATE SCHEMA regtest_dtype_vector_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_dtype_vector_temp,public;
+CREATE TABLE rt_vector (
+  id    int,
+  v1    vector(8),
+  v2    vector(8)
+);
+SELECT pgstrom.random_setseed(20240425);
+INSERT INTO rt_vector (
+  SELECT x, (SELECT array_agg(pgstrom.random_float(0, -10.0, 10.0))
+               FROM generate_series(1,8) WHERE x > 0)::vector,
+            (SELECT array_agg(pgstrom.random_float(0, -10.0, 10.0))
+               FROM generate_series(1,8) WHERE x > 0)::vector
+    FROM generate_series(1,3000) x
+);
+UPDATE rt_vector SET v2 = NULL WHERE id % 100 = 37;
+VACUUM ANALYZE;
+
+-- force to use GpuScan, instead of SeqScan
+SET enable_seqscan = off;
+
+-- vector functions and distance operators
+SET pg_strom.enabled = on;
+SELECT id, vector_dims(v1)                      v1,
+           vector_norm(v2)                      v2,
+           l2_distance(v1, v2)                  v3,
+           v1 <-> v2                            v4,
+           vector_l2_squared_distance(v1, v2)   v5,
+           inner_product(v1, v2)                v6,
+           v1 <#> v2                            v7,
+           vector_negative_inner_product(v1, v2) v8,
+           cosine_distance(v1, v2)              v9,
+           v1 <=> v2                            v10,
+           l1_distance(v1, v2)                  v11
+  INTO test01g
+  FROM rt_vector
+ WHERE id > 0;
+SET pg_strom.enabled = off;
+SELECT id, vector_dims(v1)                      v1,
+           vector_norm(v2)                      v2,
+           l2_distance(v1, v2)                  v3,
+           v1 <-> v2                            v4,
+           vector_l2_squared_distance(v1, v2)   v5,
+           inner_product(v1, v2)                v6,
+           v1 <#> v2                            v7,
+           vector_negative_inner_product(v1, v2) v8,
+           cosine_distance(v1, v2)              v9,
+           v1 <=> v2                            v10,
+           l1_distance(v1, v2)                  v11
+  INTO test01p
+  FROM rt_vector
+ WHERE id > 0;
+
+SELECT * FROM test01g g, test01p p
+ WHERE g.id = p.id
+   AND (abs(g.v1 - p.v1) > 0.001
+    OR abs(g.v2 - p.v2) > 0.001
+    OR abs(g.v3 - p.v3) > 0.001
+    OR abs(g.v4 - p.v4) > 0.001
+    OR abs(g.v5 - p.v5) > 0.001
+    OR abs(g.v6 - p.v6) > 0.001
+    OR abs(g.v7 - p.v7) > 0.001
+    OR abs(g.v8 - p.v8) > 0.001
+    OR abs(g.v9 - p.v9) > 0.001
+    OR abs(g.v10 - p.v10) > 0.001
+    OR abs(g.v11 - p.v11) > 0.001);
+
+-- distance to a constant vector as scan qualifier
+SET pg_strom.enabled = on;
+SELECT id
+  INTO test02g
+  FROM rt_vector
+ WHERE v1 <-> '[1,2,3,4,-4,-3,-2,-1]' < 15.0
+    OR v2 <=> '[1,1,1,1,1,1,1,1]' < 0.5;
+SET pg_strom.enabled = off;
+SELECT id
+  INTO test02p
+  FROM rt_vector
+ WHERE v1 <-> '[1,2,3,4,-4,-3,-2,-1]' < 15.0
+    OR v2 <=> '[1,1,1,1,1,1,1,1]' < 0.5;
+
+(SELECT * FROM test02g EXCEPT SELECT * FROM test02p) ORDER BY id;
+(SELECT * FROM test02p EXCEPT SELECT * FROM test02g) ORDER BY id;
+
+-- k-nearest neighbor search
+SET pg_strom.enabled = on;
+SELECT id
+  INTO test03g
+  FROM rt_vector
+ WHERE id > 0
+ ORDER BY v1 <-> '[1,2,3,4,-4,-3,-2,-1]'
+ LIMIT 10;
+SET pg_strom.enabled = off;
+SELECT id
+  INTO test03p
+  FROM rt_vector
+ WHERE id > 0
+ ORDER BY v1 <-> '[1,2,3,4,-4,-3,-2,-1]'
+ LIMIT 10;
+
+(SELECT * FROM test03g EXCEPT SELECT * FROM test03p) ORDER BY id;
+(SELECT * FROM test03p EXCEPT SELECT * FROM test03g) ORDER BY id;
+
+-- cleanup temporary resource
+SET client_min_messages = error;
+DROP SCHEMA regtest_dtype_vector_temp CASCADE;
@@ -0,0 +1,87 @@
+---
+--- Test for the remote clients of GPU service; authentication and
+--- the validation of malformed commands
+---
+-- skip test if GPU service does not accept the remote clients
+SELECT current_setting('pg_strom.gpuserv_remote_listen_port')::int = 0 AS skip_test \gset
+\if :skip_test
+\quit
+\endif
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_gpuserv_remote_temp CASCADE;
+CREATE SCHEMA regtest_gpuserv_remote_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_gpuserv_remote_temp,public;
+-- connect GPU0 from the loopback address, then send the payload
+CREATE FUNCTION gpuserv_remote_send(secret text, payload bytea)
+RETURNS text AS
+$$
+import socket, hmac, hashlib, struct, re
+def recv_all(sock, length):
+    buf = b''
+    while len(buf) < length:
+        temp = sock.recv(length - len(buf))
+        if not temp:
+            return None
+        buf += temp
+    return buf
+port = int(plpy.execute("SELECT current_setting('pg_strom.gpuserv_remote_listen_port') v")[0]['v'])
+sock = socket.create_connection(('127.0.0.1', port), timeout=30)
+try:
+    nonce = recv_all(sock, 32)
+    if nonce is None:
+        return 'closed'
+    sock.sendall(hmac.new(secret.encode(), nonce, hashlib.sha256).digest())
+    if recv_all(sock, 1) != b'\x01':
+        return 'authentication failed'
+    if payload is None:
+        return 'authenticated'
+    sock.sendall(payload)
+    head = recv_all(sock, 40)
+    if head is None:
+        return 'closed'
+    magic, tag, length = struct.unpack('=IIQ', head[0:16])
+    body = recv_all(sock, length - 40)
+    if tag != 1:
+        return 'tag=%d' % tag
+    # kern_errorbuf::message
+    message = body[106:307].split(b'\0')[0].decode()
+    return re.sub(r'^GPU[0-9]+: ', '', message)
+finally:
+    sock.close()
+$$ LANGUAGE 'plpython3u';
+
+-- XpuCommand header (magic, tag, length, priv, chain)
+CREATE FUNCTION xpu_command(tag int, length int, body bytea)
+RETURNS bytea AS
+$$
+import struct
+return struct.pack('=IIQ', 0xdeadbeaf, tag, length) + bytes(24) + body
+$$ LANGUAGE 'plpython3u';
+
+-- wrong shared secret
+SELECT gpuserv_remote_send('wrong-' || current_setting('pg_strom.gpuserv_remote_secret'), NULL);
+SELECT gpuserv_remote_send(current_setting('pg_strom.gpuserv_remote_secret'), NULL);
+
+-- OpenSession is too short
+SELECT gpuserv_remote_send(current_setting('pg_strom.gpuserv_remote_secret'),
+                           xpu_command(100, 48, '\x0000000000000000'::bytea));
+
+-- OpenSession with kcxt_kvars_nslots (=1) larger than kcxt_kvars_nrooms (=0)
+SELECT gpuserv_remote_send(current_setting('pg_strom.gpuserv_remote_secret'),
+                           xpu_command(100, 40 + 4096,
+                                       '\x000000000000000000000000010000000000000000000000'::bytea ||
+                                       decode(repeat('00', 4096 - 24), 'hex')));
+
+-- XpuTaskExec of GpuCache
+SELECT gpuserv_remote_send(current_setting('pg_strom.gpuserv_remote_secret'),
+                           xpu_command(111, 40 + 64, decode(repeat('00', 64), 'hex')));
+
+-- unknown command
+SELECT gpuserv_remote_send(current_setting('pg_strom.gpuserv_remote_secret'),
+                           xpu_command(9999, 40 + 8, '\x0000000000000000'::bytea));
+
+-- cleanup temporary resource
+SET client_min_messages = error;
+DROP SCHEMA regtest_gpuserv_remote_temp CASCADE;
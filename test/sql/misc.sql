@@ -352,4 +352,44 @@ EXPLAIN(costs off, verbose)
 SELECT DISTINCT ON (t3.c0 + 1) t3.c0 FROM t3 FULL OUTER JOIN t2 ON (t2.c0) IN (t3.c0);
 SELECT DISTINCT ON (t3.c0 + 1) t3.c0 FROM t3 FULL OUTER JOIN t2 ON (t2.c0) IN (t3.c0);
 
+-- hash-batches of GpuJoin inner buffer
+DROP TABLE IF EXISTS t_outer;
+DROP TABLE IF EXISTS t_inner;
+
+CREATE TABLE t_outer(id int, aid int);
+CREATE TABLE t_inner(aid int, label text);
+INSERT INTO t_outer (SELECT x, x % 20000 FROM generate_series(1,100000) x);
+INSERT INTO t_inner (SELECT x, md5(x::text) FROM generate_series(1,20000) x);
+VACUUM ANALYZE t_outer, t_inner;
+CREATE FUNCTION gpujoin_hash_batches(query text)
+RETURNS int AS $$
+DECLARE
+  line  text;
+  nbatches int = 0;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN (analyze, costs off, timing off, summary off) ' || query
+  LOOP
+    IF line ~ 'Hash Batches' THEN
+      nbatches := substring(line from ':\s*(\d+)')::int;
+    END IF;
+  END LOOP;
+  RETURN nbatches;
+END;
+$$ LANGUAGE plpgsql;
+SET max_parallel_workers_per_gather = 0;
+SET pg_strom.enable_gpuhashjoin = on;
+SET pg_strom.gpujoin_inner_buffer_limit = '64kB';
+SET pg_strom.gpujoin_multi_gpu_inner = off;
+SELECT gpujoin_hash_batches('SELECT count(*), sum(length(label)) FROM t_outer NATURAL JOIN t_inner') > 1;
+SELECT count(*), sum(length(label)) FROM t_outer NATURAL JOIN t_inner;
+-- no hash-batches if the inner buffer is split over the GPUs
+SET pg_strom.gpujoin_inner_buffer_limit = 0;
+SET pg_strom.gpujoin_multi_gpu_inner = on;
+SELECT gpujoin_hash_batches('SELECT count(*), sum(length(label)) FROM t_outer NATURAL JOIN t_inner');
+SELECT count(*), sum(length(label)) FROM t_outer NATURAL JOIN t_inner;
+RESET pg_strom.gpujoin_multi_gpu_inner;
+RESET pg_strom.gpujoin_inner_buffer_limit;
+RESET pg_strom.enable_gpuhashjoin;
+RESET max_parallel_workers_per_gather;
+
 DROP SCHEMA regtest_miscs CASCADE;
\ No newline at end of file
@@ -0,0 +1,82 @@
+---
+--- Test for the approximate percentile sketch aggregate
+---
+SET pg_strom.regression_test_mode = on;
+SET client_min_messages = error;
+DROP SCHEMA IF EXISTS regtest_percentile_sketch_temp CASCADE;
+CREATE SCHEMA regtest_percentile_sketch_temp;
+RESET client_min_messages;
+
+SET search_path = regtest_percentile_sketch_temp,public;
+CREATE TABLE regtest_data AS
+  SELECT i id, i % 4 g,
+         CASE WHEN i % 101 = 0 THEN NULL
+              WHEN i % 97 = 0 THEN 0.0
+              ELSE (i - 3000)::float8 * 0.25
+          END x
+    FROM generate_series(1,20000) i;
+
+-- estimation on the CPU (bucket-mid value, but exact on the edges)
+SET pg_strom.enabled = off;
+SELECT pgstrom.percentile_approx(s, 0) p0,
+       pgstrom.percentile_approx(s, 0.25) p25,
+       pgstrom.percentile_approx(s, 0.5) p50,
+       pgstrom.percentile_approx(s, 0.9) p90,
+       pgstrom.percentile_approx(s, 0.99) p99,
+       pgstrom.percentile_approx(s, 1) p100
+  FROM (SELECT pgstrom.percentile_sketch(x) s FROM regtest_data) q;
+SELECT g, pgstrom.percentile_approx(s, 0) p0,
+       pgstrom.percentile_approx(s, 0.25) p25,
+       pgstrom.percentile_approx(s, 0.5) p50,
+       pgstrom.percentile_approx(s, 0.9) p90,
+       pgstrom.percentile_approx(s, 0.99) p99,
+       pgstrom.percentile_approx(s, 1) p100
+  FROM (SELECT g, pgstrom.percentile_sketch(x) s FROM regtest_data GROUP BY g) q
+ ORDER BY g;
+
+-- merge of the partial sketches
+SELECT pgstrom.percentile_approx(s, 0) p0,
+       pgstrom.percentile_approx(s, 0.25) p25,
+       pgstrom.percentile_approx(s, 0.5) p50,
+       pgstrom.percentile_approx(s, 0.9) p90,
+       pgstrom.percentile_approx(s, 0.99) p99,
+       pgstrom.percentile_approx(s, 1) p100
+  FROM (SELECT pgstrom.percentile_sketch_merge(s) s
+          FROM (SELECT g, pgstrom.percentile_sketch(x) s
+                  FROM regtest_data GROUP BY g) q1) q2;
+
+-- GpuPreAgg must produce the same estimation
+SET pg_strom.enabled = on;
+CREATE TABLE test01g AS
+SELECT g, pgstrom.percentile_approx(s, 0) p0,
+       pgstrom.percentile_approx(s, 0.25) p25,
+       pgstrom.percentile_approx(s, 0.5) p50,
+       pgstrom.percentile_approx(s, 0.9) p90,
+       pgstrom.percentile_approx(s, 0.99) p99,
+       pgstrom.percentile_approx(s, 1) p100
+  FROM (SELECT g, pgstrom.percentile_sketch(x) s FROM regtest_data GROUP BY g) q;
+SET pg_strom.enabled = off;
+CREATE TABLE test01p AS
+SELECT g, pgstrom.percentile_approx(s, 0) p0,
+       pgstrom.percentile_approx(s, 0.25) p25,
+       pgstrom.percentile_approx(s, 0.5) p50,
+       pgstrom.percentile_approx(s, 0.9) p90,
+       pgstrom.percentile_approx(s, 0.99) p99,
+       pgstrom.percentile_approx(s, 1) p100
+  FROM (SELECT g, pgstrom.percentile_sketch(x) s FROM regtest_data GROUP BY g) q;
+(SELECT * FROM test01g EXCEPT SELECT * FROM test01p);
+(SELECT * FROM test01p EXCEPT SELECT * FROM test01g);
+
+-- empty input or all-null input
+SELECT pgstrom.percentile_sketch(x) IS NULL AS is_null FROM regtest_data WHERE id < 0;
+SELECT pgstrom.percentile_approx(pgstrom.percentile_sketch(x), 0.5) IS NULL AS is_null
+  FROM regtest_data WHERE x IS NULL;
+
+-- out of range fraction, and corrupted sketch
+SELECT pgstrom.percentile_approx(pgstrom.percentile_sketch(x), 1.5) FROM regtest_data;
+SELECT pgstrom.percentile_approx(pgstrom.percentile_sketch(x), -0.1) FROM regtest_data;
+SELECT pgstrom.percentile_approx('\x0123456789'::bytea, 0.5);
+
+-- cleanup temporary resource
+SET client_min_messages = error;
+DROP SCHEMA regtest_percentile_sketch_temp CASCADE;
@@ -19,6 +19,7 @@ SHOW pg_strom.gpudirect_enabled;
 SHOW pg_strom.gpu_direct_seq_page_cost;
 SHOW arrow_fdw.enabled;
 SHOW arrow_fdw.stats_hint_enabled;
+SHOW arrow_fdw.late_materialization;
 SHOW arrow_fdw.metadata_cache_size;
 SHOW pg_strom.enable_gpucache;
 SHOW pg_strom.gpucache_auto_preload;
@@ -26,4 +27,71 @@ SHOW pg_strom.gpu_mempool_segment_sz;
 SHOW pg_strom.gpu_mempool_max_ratio;
 SHOW pg_strom.gpu_mempool_min_ratio;
 SHOW pg_strom.gpu_mempool_release_delay;
-SHOW pg_strom.gpuserv_debug_output;
\ No newline at end of file
+SHOW pg_strom.gpuserv_debug_output;
+SHOW pg_strom.jit_kernels;
+SHOW pg_strom.gpu_trace;
+SHOW pg_strom.gpu_trace_directory;
+SHOW pg_strom.gpu_module_cache;
+SHOW pg_strom.gpujoin_inner_buffer_limit;
+SHOW pg_strom.enable_gpusort;
+SHOW pg_strom.gpusort_topk_max_rows;
+SHOW pg_strom.enable_gpuwindow;
+SHOW pg_strom.gpujoin_inner_cache_size;
+SHOW pg_strom.enable_xpujoin_bloom_filter;
+SHOW pg_strom.gpujoin_device_hash_build_threshold;
+SHOW pg_strom.gpu_staging_ring_nslots;
+SHOW pg_strom.gpucache_snapshot_dir;
+SHOW pg_strom.gpucache_snapshot_interval;
+SHOW pg_strom.scan_prefetch_depth;
+SHOW pg_strom.enable_columnar_projection;
+SHOW pg_strom.gpu_mem_quota;
+SHOW pg_strom.gpu_admission_max_sessions;
+SHOW pg_strom.enable_gpupreagg_final;
+SHOW pg_strom.zone_map_max_entries;
+SHOW pg_strom.enable_gpuspatialjoin;
+SHOW arrow_fdw.record_batch_size;
+SHOW arrow_fdw.vectorized_filter;
+SHOW pg_strom.adaptive_fallback_threshold;
+SHOW pg_strom.enable_adaptive_exec;
+SHOW pg_strom.enable_adaptive_chunk_size;
+SHOW pg_strom.cpu_direct_scan_threshold;
+SHOW pg_strom.gpu_scan_max_devices;
+SHOW pg_strom.enable_columnar_dictionary;
+SHOW pg_strom.cost_calib_max_entries;
+SHOW pg_strom.cost_calib_unit_usec;
+SHOW pg_strom.enable_codegen_cse;
+SHOW pg_strom.scalar_array_op_hash_threshold;
+SHOW pg_strom.enable_gpujoin_direct_map;
+SHOW pg_strom.enable_gpujoin_hash_bucket;
+SHOW pg_strom.enable_gpujoin_inet_index;
+SHOW pg_strom.enable_gpujoin_range_index;
+SHOW pg_strom.enable_gpujoin_right_outer;
+SHOW pg_strom.enable_xpujoin_dynamic_filter;
+SHOW pg_strom.gpujoin_heavy_hitter_threshold;
+SHOW pg_strom.gpujoin_multi_gpu_inner;
+SHOW pg_strom.enable_gpupreagg_distinct;
+SHOW pg_strom.enable_gpupreagg_streaming;
+SHOW pg_strom.enable_hybrid_scan;
+SHOW pg_strom.enable_scan_limit;
+SHOW pg_strom.gpu_device_set;
+SHOW pg_strom.gpu_kernel_autotune;
+SHOW pg_strom.gpu_mempool_stream_ordered;
+SHOW pg_strom.gpu_numa_binding;
+SHOW pg_strom.gpu_query_buffer_mode;
+SHOW pg_strom.gpu_query_buffer_zerocopy_threshold;
+SHOW pg_strom.gpu_shared_buffers_dma;
+SHOW pg_strom.gpu_task_graph_launch;
+SHOW pg_strom.gpudirect_async_load;
+SHOW pg_strom.gpudirect_mvcc_check;
+SHOW pg_strom.gpucache_initial_load_workers;
+SHOW pg_strom.gpucache_wal_logging;
+SHOW pg_strom.gpucache_rmgr_id;
+SHOW pg_strom.hintbits_setter_max_entries;
+SHOW pg_strom.hintbits_setter_io_budget;
+SHOW pg_strom.hintbits_setter_naptime;
+SHOW pg_strom.gpuserv_monitor_threads;
+SHOW pg_strom.gpuserv_remote_listen_port;
+SHOW pg_strom.gpuserv_remote_listen_address;
+SHOW pg_strom.gpuserv_remote_allowed_hosts;
+SHOW pg_strom.gpuserv_remote_arrow_dir;
+SHOW pg_strom.gpu_endpoint_list;
@@ -0,0 +1,295 @@
+#!/bin/sh
+#
+# bench-ssbm.sh - SSBM benchmark with GPU-vs-CPU comparison report
+#
+# It builds the SSBM dataset at the scale factor, on the heap tables,
+# an arrow_fdw foreign table and a GPU cache'd table (lineorder only;
+# the dimension tables are shared), then runs the SSBM queries for each
+# combination of the dataset variants and the setting mixes. Results of
+# EXPLAIN (ANALYZE, BUFFERS, FORMAT JSON) are written to the report file
+# in the NDJSON format; one record per query run.
+#
+# Environment variables:
+#   BENCH_DBNAME    database name (default: ssbm_bench)
+#   BENCH_SCALE     SSBM scale factor (default: 10)
+#   BENCH_DATADIR   directory to store the arrow file (default: /tmp)
+#   BENCH_VARIANTS  dataset variants to run (default: "heap arrow gcache")
+#   BENCH_MIXES     setting mixes to run (default: "cpu gpu gpu_nopreagg gpu_scan")
+#   BENCH_NLOOPS    number of runs for each query (default: 3)
+#   BENCH_REPORT    report filename (default: ./ssbm-bench-YYYYMMDD.json)
+#   BENCH_DROP_CACHES  drop the page cache prior to each query, if 1
+#   PSQL, CREATEDB, PG2ARROW_CMD, DBGEN_SSBM_CMD  commands to be used
+#
+CWD=`dirname $0`
+YMD=`date +%Y%m%d`
+DBNAME="${BENCH_DBNAME:-ssbm_bench}"
+SCALE="${BENCH_SCALE:-10}"
+DATADIR="${BENCH_DATADIR:-/tmp}"
+VARIANTS="${BENCH_VARIANTS:-heap arrow gcache}"
+MIXES="${BENCH_MIXES:-cpu gpu gpu_nopreagg gpu_scan}"
+NLOOPS="${BENCH_NLOOPS:-3}"
+REPORT="${BENCH_REPORT:-./ssbm-bench-${YMD}.json}"
+PSQL="${PSQL:-psql}"
+CREATEDB="${CREATEDB:-createdb}"
+PG2ARROW_CMD="${PG2ARROW_CMD:-pg2arrow}"
+DBGEN_SSBM_CMD="${DBGEN_SSBM_CMD:-${CWD}/dbgen-ssbm}"
+QUERIES="${CWD}/bench-queries.sql"
+ARROW_FILE="${DATADIR}/ssbm_bench_lineorder_s${SCALE}.arrow"
+
+PSQL_OPTS="-X -q -At -v ON_ERROR_STOP=1"
+
+#
+# mix_settings - GUC settings of the setting mix
+#
+mix_settings()
+{
+  case "$1" in
+    cpu)
+      echo "SET pg_strom.enabled = off;"
+      ;;
+    gpu)
+      echo "SET pg_strom.enabled = on;"
+      ;;
+    gpu_nopreagg)
+      echo "SET pg_strom.enabled = on;"
+      echo "SET pg_strom.enable_gpupreagg = off;"
+      ;;
+    gpu_scan)
+      echo "SET pg_strom.enabled = on;"
+      echo "SET pg_strom.enable_gpupreagg = off;"
+      echo "SET pg_strom.enable_gpujoin = off;"
+      ;;
+    *)
+      echo "unknown setting mix: $1" >&2
+      exit 1
+      ;;
+  esac
+}
+
+#
+# variant_schema - search_path of the dataset variant
+#
+variant_schema()
+{
+  case "$1" in
+    heap)   echo "ssbm_heap" ;;
+    arrow)  echo "ssbm_arrow,ssbm_heap" ;;
+    gcache) echo "ssbm_gcache,ssbm_heap" ;;
+    *)
+      echo "unknown dataset variant: $1" >&2
+      exit 1
+      ;;
+  esac
+}
+
+#
+# setup_dataset - build the dataset, unless it exists at the same scale
+#
+setup_dataset()
+{
+  ${PSQL} ${PSQL_OPTS} -l | grep -q "^${DBNAME}|" || \
+    ${CREATEDB} -E UTF-8 -T template0 ${DBNAME} || exit 1
+
+  CURR_SCALE=`${PSQL} ${PSQL_OPTS} ${DBNAME} -c \
+    "SELECT scale FROM ssbm_heap.bench_meta" 2>/dev/null`
+  if [ "${CURR_SCALE}" != "${SCALE}" ]; then
+    echo "building SSBM dataset (scale=${SCALE}) ..." >&2
+    ${PSQL} ${PSQL_OPTS} ${DBNAME} <<__EOF__ || exit 1
+CREATE EXTENSION IF NOT EXISTS pg_strom;
+DROP SCHEMA IF EXISTS ssbm_heap CASCADE;
+DROP SCHEMA IF EXISTS ssbm_arrow CASCADE;
+DROP SCHEMA IF EXISTS ssbm_gcache CASCADE;
+CREATE SCHEMA ssbm_heap;
+CREATE SCHEMA ssbm_arrow;
+CREATE SCHEMA ssbm_gcache;
+SET search_path = ssbm_heap;
+CREATE TABLE customer (
+    c_custkey numeric NOT NULL,
+    c_name character varying(25),
+    c_address character varying(25),
+    c_city character(10),
+    c_nation character(15),
+    c_region character(12),
+    c_phone character(15),
+    c_mktsegment character(10)
+);
+CREATE TABLE date1 (
+    d_datekey integer NOT NULL,
+    d_date character(18),
+    d_dayofweek character(12),
+    d_month character(9),
+    d_year integer,
+    d_yearmonthnum numeric,
+    d_yearmonth character(7),
+    d_daynuminweek numeric,
+    d_daynuminmonth numeric,
+    d_daynuminyear numeric,
+    d_monthnuminyear numeric,
+    d_weeknuminyear numeric,
+    d_sellingseason character(12),
+    d_lastdayinweekfl character(1),
+    d_lastdayinmonthfl character(1),
+    d_holidayfl character(1),
+    d_weekdayfl character(1)
+);
+CREATE TABLE lineorder (
+    lo_orderkey numeric,
+    lo_linenumber integer,
+    lo_custkey numeric,
+    lo_partkey integer,
+    lo_suppkey numeric,
+    lo_orderdate integer,
+    lo_orderpriority character(15),
+    lo_shippriority character(1),
+    lo_quantity numeric,
+    lo_extendedprice numeric,
+    lo_ordertotalprice numeric,
+    lo_discount numeric,
+    lo_revenue numeric,
+    lo_supplycost numeric,
+    lo_tax numeric,
+    lo_commit_date character(8),
+    lo_shipmode character(10)
+);
+CREATE TABLE part (
+    p_partkey integer NOT NULL,
+    p_name character varying(22),
+    p_mfgr character(6),
+    p_category character(7),
+    p_brand1 character(9),
+    p_color character varying(11),
+    p_type character varying(25),
+    p_size numeric,
+    p_container character(10)
+);
+CREATE TABLE supplier (
+    s_suppkey numeric NOT NULL,
+    s_name character(25),
+    s_address character varying(25),
+    s_city character(10),
+    s_nation character(15),
+    s_region character(12),
+    s_phone character(15)
+);
+ALTER TABLE customer ADD PRIMARY KEY (c_custkey);
+ALTER TABLE date1 ADD PRIMARY KEY (d_datekey);
+ALTER TABLE part ADD PRIMARY KEY (p_partkey);
+ALTER TABLE supplier ADD PRIMARY KEY (s_suppkey);
+\copy customer  FROM PROGRAM '${DBGEN_SSBM_CMD} -q -s${SCALE} -X -Tc' DELIMITER '|';
+\copy date1     FROM PROGRAM '${DBGEN_SSBM_CMD} -q -s${SCALE} -X -Td' DELIMITER '|';
+\copy lineorder FROM PROGRAM '${DBGEN_SSBM_CMD} -q -s${SCALE} -X -Tl' DELIMITER '|';
+\copy part      FROM PROGRAM '${DBGEN_SSBM_CMD} -q -s${SCALE} -X -Tp' DELIMITER '|';
+\copy supplier  FROM PROGRAM '${DBGEN_SSBM_CMD} -q -s${SCALE} -X -Ts' DELIMITER '|';
+VACUUM ANALYZE;
+__EOF__
+    rm -f ${ARROW_FILE}
+    ${PG2ARROW_CMD} -d ${DBNAME} -c 'SELECT * FROM ssbm_heap.lineorder' \
+                    -o ${ARROW_FILE} || exit 1
+    ${PSQL} ${PSQL_OPTS} ${DBNAME} <<__EOF__ || exit 1
+IMPORT FOREIGN SCHEMA lineorder FROM SERVER arrow_fdw INTO ssbm_arrow
+  OPTIONS (file '${ARROW_FILE}');
+CREATE TABLE ssbm_gcache.lineorder (LIKE ssbm_heap.lineorder);
+CREATE TRIGGER row_sync AFTER INSERT OR UPDATE OR DELETE
+  ON ssbm_gcache.lineorder FOR ROW
+  EXECUTE FUNCTION pgstrom.gpucache_sync_trigger('max_num_rows=`expr ${SCALE} \* 7000000`');
+CREATE TRIGGER stmt_sync BEFORE TRUNCATE
+  ON ssbm_gcache.lineorder FOR STATEMENT
+  EXECUTE FUNCTION pgstrom.gpucache_sync_trigger();
+INSERT INTO ssbm_gcache.lineorder SELECT * FROM ssbm_heap.lineorder;
+VACUUM ANALYZE ssbm_gcache.lineorder;
+ANALYZE ssbm_arrow.lineorder;
+CREATE TABLE ssbm_heap.bench_meta AS SELECT ${SCALE}::int scale;
+__EOF__
+  fi
+  # helper function to run EXPLAIN ANALYZE
+  ${PSQL} ${PSQL_OPTS} ${DBNAME} <<'__EOF__' || exit 1
+CREATE OR REPLACE FUNCTION ssbm_heap.bench_explain(query text)
+RETURNS json AS $$
+DECLARE
+  result json;
+BEGIN
+  EXECUTE 'EXPLAIN (ANALYZE, BUFFERS, VERBOSE, FORMAT JSON) ' || query
+     INTO result;
+  RETURN result->0;
+END;
+$$ LANGUAGE plpgsql;
+__EOF__
+}
+
+#
+# print_env - the first record of the report
+#
+print_env()
+{
+  ${PSQL} ${PSQL_OPTS} ${DBNAME} <<__EOF__ || exit 1
+SELECT json_build_object('type', 'env',
+                         'date', now(),
+                         'scale', ${SCALE},
+                         'nloops', ${NLOOPS},
+                         'pg_version', version(),
+                         'pgstrom_githash', pgstrom.githash(),
+                         'gpus', (SELECT json_agg(x) FROM
+                                   (SELECT gpu_id,
+                                           json_object_agg(att_name, att_value) attrs
+                                      FROM pgstrom.gpu_device_info
+                                     WHERE att_name IN ('DEV_NAME','DEV_UUID',
+                                                        'DEV_TOTAL_MEMSZ')
+                                     GROUP BY gpu_id) x));
+__EOF__
+}
+
+#
+# run_query - run a query, then print the record of the report
+#
+run_query()
+{
+  VARIANT="$1"
+  MIX="$2"
+  QNAME="$3"
+  NLOOP="$4"
+  QUERY=`awk -v q="--${QNAME}" '$0 == q { f = 1; next } /^--Q/ { f = 0 } f' ${QUERIES} | sed 's/;[ \t]*$//'`
+
+  if [ "${BENCH_DROP_CACHES}" = "1" ]; then
+    sudo sysctl -q -w vm.drop_caches=1
+  fi
+  ${PSQL} ${PSQL_OPTS} -v query="${QUERY}" ${DBNAME} <<__EOF__
+SET search_path = `variant_schema ${VARIANT}`,public;
+`mix_settings ${MIX}`
+WITH r AS (SELECT ssbm_heap.bench_explain(:'query') x)
+SELECT json_build_object('type', 'query',
+                         'variant', '${VARIANT}',
+                         'mix', '${MIX}',
+                         'query', '${QNAME}',
+                         'loop', ${NLOOP},
+                         'planning_time', (x->>'Planning Time')::float,
+                         'execution_time', (x->>'Execution Time')::float,
+                         'shared_hit_blocks', (x->'Plan'->>'Shared Hit Blocks')::bigint,
+                         'shared_read_blocks', (x->'Plan'->>'Shared Read Blocks')::bigint,
+                         'pgstrom_nodes', (SELECT json_agg(n)
+                                             FROM jsonb_path_query(x::jsonb, 'strict $.**?(@."Custom Plan Provider" != null)') n),
+                         'plan', x->'Plan')
+  FROM r;
+__EOF__
+}
+
+setup_dataset
+print_env > ${REPORT} || exit 1
+QNAMES=`grep '^--Q' ${QUERIES} | sed 's/^--//'`
+for VARIANT in ${VARIANTS}
+do
+  for MIX in ${MIXES}
+  do
+    for QNAME in ${QNAMES}
+    do
+      i=1
+      while [ $i -le ${NLOOPS} ]
+      do
+        echo "${VARIANT} ${MIX} ${QNAME} #$i ..." >&2
+        run_query ${VARIANT} ${MIX} ${QNAME} $i >> ${REPORT} || \
+          echo "${VARIANT} ${MIX} ${QNAME} #$i failed" >&2
+        i=`expr $i + 1`
+      done
+    done
+  done
+done
+echo "report: ${REPORT}" >&2